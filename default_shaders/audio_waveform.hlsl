@@ -43,11 +43,11 @@ float4 main(PS_INPUT input) : SV_TARGET {
 
     float4 vid = ShowVideo ? videoTexture.Sample(videoSampler, uv) : float4(0,0,0,1);
 
-    // Per-column amplitude from the spectrum texture.
-    float mag = spectrumTexture.Sample(videoSampler, float2(uv.x, 0.5)).r;
+    // Per-column sample from the waveform texture (the latest heard audio).
+    float s = dot(waveformTexture.Sample(videoSampler, float2(uv.x, 0.5)).rg, 0.5);  // L/R mean
 
-    // Wave displaced around y=0.5 by spectrum amplitude.
-    float waveY = 0.5 + (mag - 0.5) * WaveHeight * 2.0;
+    // Wave displaced around y=0.5 by the sample.
+    float waveY = 0.5 - s * WaveHeight;
 
     float dist = abs(uv.y - waveY);
 
@@ -7,13 +7,16 @@
         {"NAME": "blendWeight",   "LABEL": "Blend",         "TYPE": "float", "MIN": 0.0,  "MAX": 1.0,  "DEFAULT": 0.85},
         {"NAME": "errorDiffusion","LABEL": "Error Diffusion","TYPE": "float","MIN": 0.0,  "MAX": 1.0,  "DEFAULT": 0.3},
         {"NAME": "glitchAmt",     "LABEL": "Glitch Amount", "TYPE": "float", "MIN": 0.0,  "MAX": 1.0,  "DEFAULT": 0.2}
-    ]
+    ],
+    "FRAME_HISTORY": {"FRAMES": 16, "SCALE": 0.5}
 }*/
 
 // Datamosh block drift.
 // Uses Perlin noise (noiseTexture R) as a proxy for P-frame motion vectors.
-// Blocks accumulate UV displacement over time; periodic noise spikes simulate
-// I-frame resets.  errorDiffusion spreads artefacts to neighbouring blocks.
+// Blocks accumulate UV displacement over time and keep showing the frame they
+// last refreshed on (from frameHistory), the way a missing I-frame smears stale
+// pixels; periodic noise spikes simulate I-frame resets.  errorDiffusion
+// spreads artefacts to neighbouring blocks.
 
 Texture2D videoTexture : register(t0);
 SamplerState videoSampler : register(s0);
@@ -71,12 +74,14 @@ float4 main(PS_INPUT input) : SV_TARGET {
     motionVec = lerp(motionVec, nbMV, errorDiffusion * 0.4);
 
     // Accumulate drift over time (integrate velocity)
-    float2 drift = motionVec * frac(time * 0.2 + blockSeed);
+    float  driftAge = frac(time * 0.2 + blockSeed);
+    float2 drift    = motionVec * driftAge;
 
-    // Displaced UV for the "P-frame" sample
+    // Displaced UV for the "P-frame" sample, from a frame that ages with the drift
     float2 driftUV = clamp(uv + drift * px * blockSz, 0.0, 1.0);
+    int    staleAge = int(driftAge * (historyFrames - 1));
 
-    float4 driftSample = videoTexture.Sample(videoSampler, driftUV);
+    float4 driftSample = frameHistory.SampleLevel(videoSampler, float3(driftUV, HistorySlice(staleAge)), 0);
     float4 cleanSample = videoTexture.Sample(videoSampler, uv);
 
     // On I-frame reset, show clean video; otherwise drifted
@@ -7,17 +7,19 @@
         {"NAME": "ageSaturation",  "LABEL": "Age Colour",     "TYPE": "float", "MIN": 0.0,  "MAX": 1.0,  "DEFAULT": 0.8},
         {"NAME": "wrapEdges",      "LABEL": "Wrap Edges",     "TYPE": "bool",  "DEFAULT": true},
         {"NAME": "CellTint",       "LABEL": "Cell Tint",      "TYPE": "color", "DEFAULT": [1.0,1.0,1.0,1.0]}
+    ],
+    "PASSES": [
+        {"TARGET": "cellState", "PERSISTENT": true, "FLOAT": true},
+        {}
     ]
 }*/
 
 // Conway Game of Life (B3/S23) with chromatic cell age.
-// A single-pass shader cannot maintain inter-frame state, so the solution
-// expands the GoL recurrence directly: for cell C at generation G, the state
-// is computed by unrolling 3 levels of the B3/S23 rule into a 7×7 hash-seeded
-// initial configuration.  Each generation uses floor(time*updateHz) as a seed,
-// so the initial grid changes every 1/updateHz seconds and the 3-step evolved
-// result is displayed.  Age = cells alive at each of the 4 sampled stages
-// (initial + 3 steps), encoded in hue: red → yellow → green → cyan → blue.
+// Pass 0 is the simulation: a persistent target holding, per pixel, the state
+// of the cell it lies in (r = alive, g = generations alive, b = generation,
+// a = 1 once seeded). It advances one generation whenever floor(time*updateHz)
+// moves on and reseeds from a hash when empty or when time runs backwards.
+// Pass 1 colours the cells by age: red → yellow → green → cyan → blue.
 
 Texture2D videoTexture : register(t0);
 SamplerState videoSampler : register(s0);
@@ -44,9 +46,9 @@ float3 hsv2rgb(float3 c) {
     return c.z * lerp(K.xxx, clamp(p - K.xxx, 0.0, 1.0), c.y);
 }
 
-// Hash-based initial cell state for infinite grid
-bool initCell(int cx, int cy, float seed, float dens) {
-    float2 p = float2(float(cx), float(cy));
+// Hash-based initial cell state
+bool initCell(int2 c, float seed, float dens) {
+    float2 p = float2(c);
     float  s = fmod(seed, 997.0);
     float  h = frac(sin(dot(p + float2(s * 13.7, s * 7.31), float2(127.1, 311.7))) * 43758.5453);
     return h < dens;
@@ -57,82 +59,50 @@ bool golRule(bool alive, int nb) {
     return alive ? (nb == 2 || nb == 3) : (nb == 3);
 }
 
-float4 main(PS_INPUT input) : SV_TARGET {
-    float2 uv   = input.uv;
-
-    // Map UV to cell coordinates
-    float2 cellPx   = resolution / max(cellSz, 1.0);
-    int2   cell     = int2(floor(uv * cellPx));
-    int    cx       = cell.x;
-    int    cy       = cell.y;
-    float  seed     = floor(time * updateHz);
-
-    // --- Fill 7×7 initial state centred on (cx, cy) ---
-    bool initG[49];
-    [unroll] for (int iy = 0; iy < 7; iy++) {
-        [unroll] for (int ix = 0; ix < 7; ix++) {
-            int nx = cx + ix - 3;
-            int ny = cy + iy - 3;
-            if (wrapEdges) {
-                nx = ((nx % (int)cellPx.x) + (int)cellPx.x) % (int)cellPx.x;
-                ny = ((ny % (int)cellPx.y) + (int)cellPx.y) % (int)cellPx.y;
-            }
-            initG[iy * 7 + ix] = initCell(nx, ny, seed, initialDensity);
-        }
+// Previous state of cell c (dead outside the grid when edges don't wrap)
+float4 loadCell(int2 c, int2 cells, float size) {
+    if (wrapEdges) {
+        c = (c % cells + cells) % cells;
+    } else if (any(c < 0) || any(c >= cells)) {
+        return float4(0.0, 0.0, 0.0, 1.0);
     }
+    int2 px = min(int2((float2(c) + 0.5) * size), int2(resolution) - 1);
+    return cellState.Load(int3(px, 0));
+}
 
-    // --- Step 1: 5×5 ---
-    bool s1[25];
-    [unroll] for (int y1 = 0; y1 < 5; y1++) {
-        [unroll] for (int x1 = 0; x1 < 5; x1++) {
-            bool al = initG[(y1 + 1) * 7 + (x1 + 1)];
-            int  nb = 0;
-            [unroll] for (int dy = -1; dy <= 1; dy++) {
-                [unroll] for (int dx = -1; dx <= 1; dx++) {
-                    nb += (!(dx == 0 && dy == 0)) ? (initG[(y1 + 1 + dy) * 7 + (x1 + 1 + dx)] ? 1 : 0) : 0;
-                }
-            }
-            s1[y1 * 5 + x1] = golRule(al, nb);
-        }
-    }
+float4 simulate(float2 pos) {
+    float  size  = max(cellSz, 1.0);
+    int2   cells = max(int2(resolution / size), int2(1, 1));
+    int2   cell  = min(int2(floor(pos / size)), cells - 1);
+    float  gen   = floor(time * updateHz);
+    float4 prev  = loadCell(cell, cells, size);
 
-    // --- Step 2: 3×3 ---
-    bool s2[9];
-    [unroll] for (int y2 = 0; y2 < 3; y2++) {
-        [unroll] for (int x2 = 0; x2 < 3; x2++) {
-            bool al = s1[(y2 + 1) * 5 + (x2 + 1)];
-            int  nb = 0;
-            [unroll] for (int dy = -1; dy <= 1; dy++) {
-                [unroll] for (int dx = -1; dx <= 1; dx++) {
-                    nb += (!(dx == 0 && dy == 0)) ? (s1[(y2 + 1 + dy) * 5 + (x2 + 1 + dx)] ? 1 : 0) : 0;
-                }
-            }
-            s2[y2 * 3 + x2] = golRule(al, nb);
-        }
-    }
+    if (prev.a == 0.0 || gen < prev.b)
+        return float4(initCell(cell, gen, initialDensity) ? 1.0 : 0.0, 0.0, gen, 1.0);
+    if (gen == prev.b)
+        return prev;
 
-    // --- Step 3: single centre cell ---
-    bool al3 = s2[4];
-    int  nb3 = 0;
+    int nb = 0;
     [unroll] for (int dy = -1; dy <= 1; dy++) {
         [unroll] for (int dx = -1; dx <= 1; dx++) {
-            nb3 += (!(dx == 0 && dy == 0)) ? (s2[(dy + 1) * 3 + (dx + 1)] ? 1 : 0) : 0;
+            if (dx != 0 || dy != 0)
+                nb += loadCell(cell + int2(dx, dy), cells, size).r > 0.5 ? 1 : 0;
         }
     }
-    bool alive = golRule(al3, nb3);
+    bool wasAlive = prev.r > 0.5;
+    bool alive    = golRule(wasAlive, nb);
+    float age     = alive ? (wasAlive ? min(prev.g + 1.0, 4.0) : 0.0) : 0.0;
+    return float4(alive ? 1.0 : 0.0, age, gen, 1.0);
+}
 
-    if (!alive) return float4(0.0, 0.0, 0.0, 1.0);
+float4 main(PS_INPUT input) : SV_TARGET {
+    if (PASSINDEX == 0) return simulate(input.pos.xy);
 
-    // Age: stages at which this cell was alive (0–4)
-    int age = (initG[3 * 7 + 3] ? 1 : 0)
-            + (s1[2 * 5 + 2]     ? 1 : 0)
-            + (s2[4]              ? 1 : 0)
-            + 1; // alive at final step (always true here)
+    float4 state = cellState.Load(int3(int2(input.pos.xy), 0));
+    if (state.r < 0.5) return float4(0.0, 0.0, 0.0, 1.0);
 
     // Hue: red (new) → yellow → green → cyan → blue (long-lived)
-    float hue = float(age - 1) / 4.0 * 0.65;  // 0=red, 0.65=blue
-    float sat = ageSaturation;
-    float3 col = hsv2rgb(float3(hue, sat, 0.95)) * CellTint.rgb;
-
+    float hue = state.g / 4.0 * 0.65;  // 0=red, 0.65=blue
+    float3 col = hsv2rgb(float3(hue, ageSaturation, 0.95)) * CellTint.rgb;
     return float4(saturate(col), 1.0);
 }
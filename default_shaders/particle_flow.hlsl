@@ -0,0 +1,119 @@
+/*{
+  "SHADER_TYPE": "compute",
+  "THREADS": [256, 1],
+  "BUFFERS": [ { "NAME": "particles", "STRIDE": 16, "COUNT": 262144 } ],
+  "DISPATCHES": [
+    { "GROUPS": [1024, 1] },
+    {}
+  ],
+  "DRAW": { "BUFFER": "particles", "SIZE": 2, "BLEND": "add" },
+  "INPUTS": [
+    { "NAME": "Speed",      "TYPE": "float", "MIN": 0.0, "MAX": 4.0,   "DEFAULT": 1.0,  "LABEL": "Speed" },
+    { "NAME": "Curl",       "TYPE": "float", "MIN": 0.0, "MAX": 4.0,   "DEFAULT": 1.5,  "LABEL": "Turbulence" },
+    { "NAME": "Lifetime",   "TYPE": "float", "MIN": 10.0,"MAX": 600.0, "DEFAULT": 180.0,"LABEL": "Lifetime (frames)" },
+    { "NAME": "Brightness", "TYPE": "float", "MIN": 0.0, "MAX": 2.0,   "DEFAULT": 0.35, "LABEL": "Brightness" },
+    { "NAME": "Backdrop",   "TYPE": "float", "MIN": 0.0, "MAX": 1.0,   "DEFAULT": 0.15, "LABEL": "Backdrop" }
+  ]
+}*/
+
+// Particle Flow
+// 262144 particles drift through a noise flow field, faster over bright video,
+// and are drawn as additive 2 px sprites tinted by the video beneath them.
+// Dispatch 0 moves the particles, dispatch 1 writes the dimmed backdrop, and
+// the DRAW stage draws one instance per particle, so the cost follows the
+// particle count rather than pixels x particles.
+// Speed: drift speed, scaled by the video's brightness
+// Turbulence: how tightly the flow field turns
+// Lifetime: frames before a particle respawns at a random spot
+// Brightness: sprite intensity (sprites add up where they bunch)
+// Backdrop: how much of the video shows behind the particles
+
+Texture2D videoTexture : register(t0);
+SamplerState videoSampler : register(s0);
+Texture2D noiseTexture : register(t1);
+SamplerState noiseSampler : register(s1);
+
+cbuffer Constants : register(b0) {
+    float time;
+    float padding1;
+    float2 resolution;
+    float2 videoResolution;
+    float2 padding2;
+    float4 custom[4];
+};
+
+#define PI 3.14159265358979
+
+struct Particle {
+    float2 pos;   // uv
+    float  age;   // Frames since spawn
+    float  seed;  // 0 until first spawned (buffers start zeroed)
+};
+
+float hash(float2 p) {
+    return frac(sin(dot(p, float2(127.1, 311.7))) * 43758.5453);
+}
+
+#ifndef DRAW_STAGE
+
+RWStructuredBuffer<Particle> particles : register(u1);
+
+[numthreads(THREADS_X, THREADS_Y, 1)]
+void main(uint3 id : SV_DispatchThreadID) {
+    if (PASSINDEX == 1) {
+        uint2 size;
+        outputTexture.GetDimensions(size.x, size.y);
+        if (id.x >= size.x || id.y >= size.y) return;
+        outputTexture[id.xy] = float4(videoTexture.Load(int3(id.xy, 0)).rgb * Backdrop, 1.0);
+        return;
+    }
+
+    if (id.x >= particles_COUNT) return;
+    Particle p = particles[id.x];
+
+    // Respawn at a fresh random position, staggering ages so they don't pulse together
+    if (p.seed == 0.0 || p.age >= Lifetime || any(p.pos < 0.0) || any(p.pos > 1.0)) {
+        p.seed = hash(float2(id.x * 0.001, time)) + 1e-3;
+        p.pos  = float2(hash(float2(p.seed, 1.7)), hash(float2(p.seed, 9.3)));
+        p.age  = hash(float2(p.seed, 4.1)) * Lifetime * 0.5;
+    }
+
+    float angle = noiseTexture.SampleLevel(noiseSampler, p.pos * Curl + time * 0.02, 0).r * 4.0 * PI;
+    float luma  = dot(videoTexture.SampleLevel(videoSampler, p.pos, 0).rgb, float3(0.2126, 0.7152, 0.0722));
+    float2 drift = float2(cos(angle), sin(angle)) * Speed * (0.2 + luma) * 0.0015;
+    drift.x *= resolution.y / resolution.x;  // Same speed in both directions on screen
+
+    p.pos += drift;
+    p.age += 1.0;
+    particles[id.x] = p;
+}
+
+#else
+
+StructuredBuffer<Particle> particles : register(t8);
+
+struct POINT_OUTPUT {
+    float4 pos    : SV_POSITION;
+    float2 uv     : TEXCOORD0;
+    float2 corner : TEXCOORD1;
+    float  fade   : TEXCOORD2;
+};
+
+POINT_OUTPUT pointVS(uint vertexId : SV_VertexID, uint instanceId : SV_InstanceID) {
+    Particle p = particles[instanceId];
+    POINT_OUTPUT o;
+    o.pos    = PointPosition(p.pos, vertexId, resolution);
+    o.uv     = p.pos;
+    o.corner = PointCorner(vertexId);
+    // Fade in and out over the lifetime; unspawned particles stay dark
+    o.fade   = p.seed > 0.0 ? sin(PI * saturate(p.age / Lifetime)) : 0.0;
+    return o;
+}
+
+float4 pointPS(POINT_OUTPUT input) : SV_TARGET {
+    float falloff = saturate(1.0 - dot(input.corner, input.corner));
+    float3 tint   = videoTexture.SampleLevel(videoSampler, input.uv, 0).rgb + 0.05;
+    return float4(tint * Brightness * input.fade * falloff, 1.0);
+}
+
+#endif
@@ -1,5 +1,10 @@
 /*{
-  "SHADER_TYPE": "video",
+  "SHADER_TYPE": "compute",
+  "THREADS": [1024, 1],
+  "DISPATCHES": [
+    { "GROUPS": [1, "$HEIGHT"] },
+    { "GROUPS": [1, "$WIDTH"] }
+  ],
   "INPUTS": [
     { "NAME": "SortAxis",     "TYPE": "long",  "MIN": 0,   "MAX": 1,   "DEFAULT": 0,  "LABEL": "Axis (0=Horizontal 1=Vertical)" },
     { "NAME": "ThresholdLow", "TYPE": "float", "MIN": 0.0, "MAX": 1.0, "DEFAULT": 0.25,"LABEL": "Threshold Low" },
@@ -9,12 +14,14 @@
   ]
 }*/
 
-// Threshold-based pixel sort approximation.
-// Pixels whose luminance falls within [ThresholdLow, ThresholdHigh] are
-// replaced by a sample taken from further along the sort axis, creating
-// the characteristic smeared / streaked glitch aesthetic.
-// A noise-modulated run length avoids uniform banding.
-// This is a single-pass approximation — not true per-run re-ordering.
+// Threshold-based pixel sort.
+// One thread group per row (dispatch 0) or column (dispatch 1; the dispatch for
+// the other axis exits at once). Pixels whose luminance falls within
+// [ThresholdLow, ThresholdHigh] form runs, broken at a noise-modulated length;
+// every other pixel is a run of its own. Each line is then bitonic-sorted in
+// groupshared memory by (run start, luminance), which keeps every run in place
+// and truly re-orders the pixels within it. Lines longer than LINE_CHUNK are
+// sorted chunk by chunk.
 
 Texture2D videoTexture : register(t0);
 SamplerState videoSampler : register(s0);
@@ -30,59 +37,103 @@ cbuffer Constants : register(b0) {
     float4 custom[4];
 };
 
-struct PS_INPUT {
-    float4 pos : SV_POSITION;
-    float2 uv  : TEXCOORD0;
-};
+#define LINE_CHUNK (THREADS_X * 2)   // Two pixels per thread
+#define PAD_KEY    0xFFFFFFFF        // Past the end of the line: sorts last
+
+groupshared uint gsKey[LINE_CHUNK];
+groupshared uint gsSrc[LINE_CHUNK];
 
 float luma(float3 c) { return dot(c, float3(0.299, 0.587, 0.114)); }
 
-float4 main(PS_INPUT input) : SV_TARGET {
-    float2 uv   = input.uv;
-    float4 orig = videoTexture.Sample(videoSampler, uv);
-    float  lOrig = luma(orig.rgb);
+bool inBand(float l) { return l >= ThresholdLow && l <= ThresholdHigh; }
 
-    // Only pixels within the threshold band are candidates for sorting.
-    bool inBand = (lOrig >= ThresholdLow && lOrig <= ThresholdHigh);
+[numthreads(THREADS_X, THREADS_Y, 1)]
+void main(uint3 group : SV_GroupID, uint tid : SV_GroupIndex) {
+    if (SortAxis != PASSINDEX) return;
 
-    if (!inBand) return orig;
+    uint2 size;
+    outputTexture.GetDimensions(size.x, size.y);
+    const uint lineLen   = (PASSINDEX == 0) ? size.x : size.y;
+    const uint lineCount = (PASSINDEX == 0) ? size.y : size.x;
+    const uint lineIndex = group.y;
+    if (lineIndex >= lineCount) return;
 
-    // Noise-modulated run length: each "run" has a locally variable length.
-    // This avoids the rigid banding that a fixed MaxRunLen would produce.
-    float noiseUV_x = (SortAxis == 0) ? uv.y : uv.x;
-    float runNoise  = noiseTexture.Sample(noiseSampler, float2(noiseUV_x * 2.7, time * 0.1)).r;
-    float runLen    = MaxRunLen * (0.3 + runNoise * 0.7);
+    // Noise-modulated run length per line avoids rigid banding
+    float runNoise = noiseTexture.SampleLevel(noiseSampler, float2(float(lineIndex) / lineCount * 2.7, time * 0.1), 0).r;
+    uint  runLen   = max(2u, uint(MaxRunLen * lineLen * (0.3 + runNoise * 0.7)));
+    uint  runPhase = uint(runNoise * 7919.0) % runLen;
 
-    // Walk along the sort axis and accumulate the sorted pixel.
-    // We approximate sorting by sampling the brightest pixel within the run
-    // window (sort key = luminance, ascending).  A single-pass forward scan
-    // can't produce a true sorted ordering, so we use a small sample set.
-    float2 axisDir = (SortAxis == 0) ? float2(1.0 / resolution.x, 0.0)
-                                      : float2(0.0, 1.0 / resolution.y);
-    float  axisSign = (SortDirection == 0) ? 1.0 : -1.0;
-    axisDir        *= axisSign;
+    for (uint chunk = 0; chunk < lineLen; chunk += LINE_CHUNK) {
+        // Keys: run start index (a pixel starts a run when it or its
+        // predecessor is out of band, or at a run-length break)
+        uint  idx[2] = { tid, tid + THREADS_X };
+        uint  lum[2];
+        [unroll] for (int e = 0; e < 2; ++e) {
+            uint i = idx[e];
+            uint x = chunk + i;
+            bool start = true;
+            lum[e] = 0;
+            if (x < lineLen) {
+                int2 p  = (PASSINDEX == 0) ? int2(x, lineIndex) : int2(lineIndex, x);
+                float l = luma(videoTexture.Load(int3(p, 0)).rgb);
+                lum[e]  = uint(saturate(l) * 65535.0);
+                if (i > 0 && inBand(l) && (x + runPhase) % runLen != 0) {
+                    int2 q = (PASSINDEX == 0) ? int2(x - 1, lineIndex) : int2(lineIndex, x - 1);
+                    start = !inBand(luma(videoTexture.Load(int3(q, 0)).rgb));
+                }
+            }
+            gsKey[i] = start ? i : 0;
+        }
+        GroupMemoryBarrierWithGroupSync();
 
-    // Sample N evenly spaced pixels within the run and pick the brightest.
-    const int SAMPLES = 8;
-    float4 bestPx    = orig;
-    float  bestLuma  = -1.0;
+        // Prefix max: every pixel learns where its run starts
+        for (uint off = 1; off < LINE_CHUNK; off <<= 1) {
+            uint v0 = gsKey[idx[0]];
+            uint v1 = gsKey[idx[1]];
+            if (idx[0] >= off) v0 = max(v0, gsKey[idx[0] - off]);
+            if (idx[1] >= off) v1 = max(v1, gsKey[idx[1] - off]);
+            GroupMemoryBarrierWithGroupSync();
+            gsKey[idx[0]] = v0;
+            gsKey[idx[1]] = v1;
+            GroupMemoryBarrierWithGroupSync();
+        }
 
-    [unroll]
-    for (int s = 0; s < SAMPLES; ++s) {
-        float  frac2    = (float(s) + 0.5) / float(SAMPLES);
-        float2 sampleUV = uv + axisDir * runLen * frac2;
-        sampleUV        = saturate(sampleUV);
-        float4 spx      = videoTexture.Sample(videoSampler, sampleUV);
-        float  sl       = luma(spx.rgb);
-        // Only consider pixels also in the threshold band.
-        if (sl >= ThresholdLow && sl <= ThresholdHigh && sl > bestLuma) {
-            bestLuma = sl;
-            bestPx   = spx;
+        [unroll] for (int k2 = 0; k2 < 2; ++k2) {
+            uint i = idx[k2];
+            uint sortLum = (SortDirection == 0) ? lum[k2] : 65535u - lum[k2];
+            gsKey[i] = (chunk + i < lineLen) ? ((gsKey[i] << 16) | sortLum) : PAD_KEY;
+            gsSrc[i] = i;
         }
-    }
+        GroupMemoryBarrierWithGroupSync();
 
-    // If no in-band pixel was found along the run, output original.
-    if (bestLuma < 0.0) return orig;
+        // Bitonic sort, one compare-exchange per thread per step
+        for (uint k = 2; k <= LINE_CHUNK; k <<= 1) {
+            for (uint j = k >> 1; j > 0; j >>= 1) {
+                uint a = 2 * j * (tid / j) + (tid % j);
+                uint b = a + j;
+                bool ascending = (a & k) == 0;
+                uint ka = gsKey[a];
+                uint kb = gsKey[b];
+                if ((ka > kb) == ascending) {
+                    uint sa = gsSrc[a];
+                    gsKey[a] = kb;  gsKey[b] = ka;
+                    gsSrc[a] = gsSrc[b];  gsSrc[b] = sa;
+                }
+                GroupMemoryBarrierWithGroupSync();
+            }
+        }
 
-    return bestPx;
+        // Padding sorted to the end, so the first lineLen - chunk slots are real
+        [unroll] for (int w = 0; w < 2; ++w) {
+            uint i = idx[w];
+            uint x = chunk + i;
+            if (x < lineLen) {
+                uint  src = chunk + gsSrc[i];
+                int2  dst  = (PASSINDEX == 0) ? int2(x, lineIndex)   : int2(lineIndex, x);
+                int2  from = (PASSINDEX == 0) ? int2(src, lineIndex) : int2(lineIndex, src);
+                outputTexture[dst] = float4(videoTexture.Load(int3(from, 0)).rgb, 1.0);
+            }
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
 }
@@ -1,4 +1,14 @@
 /*{
+    "SHADER_TYPE": "compute",
+    "THREADS": [16, 16],
+    "BUFFERS": [
+        {"NAME": "bins", "STRIDE": 4, "COUNT": 393216, "PERSISTENT": false}
+    ],
+    "DISPATCHES": [
+        {"GROUPS": [1536, 1]},
+        {"GROUPS": [32, 16]},
+        {}
+    ],
     "INPUTS": [
         {"NAME": "NumSamples", "LABEL": "Sample Rows", "TYPE": "float",
          "MIN": 32.0, "MAX": 256.0, "DEFAULT": 128.0, "STEP": 1.0},
@@ -15,6 +25,8 @@
 // Y-axis: 0–100 IRE (top = 100).  Graticule at every 10 IRE.
 // Channel waveforms are colour-coded (red / green / blue tint).
 // Useful for detecting colour cast, channel imbalance, and clipping.
+// Dispatch 0 clears the histogram, dispatch 1 scatters NumSamples rows × COLS
+// columns into it with InterlockedAdd, dispatch 2 draws the panels from it.
 // BlendVideo: 0 = pure parade on black, 1 = original video.
 
 Texture2D    videoTexture : register(t0);
@@ -29,39 +41,63 @@ cbuffer Constants : register(b0) {
     float4 custom[4];
 };
 
-struct PS_INPUT {
-    float4 pos : SV_POSITION;
-    float2 uv  : TEXCOORD0;
-};
+// Histogram: [channel (r, g, b)][level][column]
+RWStructuredBuffer<uint> bins : register(u1);
+
+#define COLS   512
+#define LEVELS 256
+
+static const float kSigma  = 0.009;
+static const float kInvS2  = 1.0 / (2.0 * kSigma * kSigma);
+static const int   kRadius = 7;   // Levels either side (~3 sigma)
+
+uint BinIndex(uint channel, uint level, uint col) {
+    return (channel * LEVELS + level) * COLS + col;
+}
+
+uint LevelOf(float v) { return uint(saturate(v) * (LEVELS - 1) + 0.5); }
 
-static const float kSigma = 0.009;
-static const float kInvS2 = 1.0 / (2.0 * kSigma * kSigma);
+[numthreads(THREADS_X, THREADS_Y, 1)]
+void main(uint3 id : SV_DispatchThreadID, uint3 group : SV_GroupID, uint index : SV_GroupIndex) {
+    if (PASSINDEX == 0) {
+        bins[group.x * THREADS_X * THREADS_Y + index] = 0;
+        return;
+    }
+
+    int nSamples = int(NumSamples);
+    if (PASSINDEX == 1) {
+        if (id.x >= COLS || id.y >= uint(nSamples)) return;
+        float2 uv  = (float2(id.xy) + 0.5) / float2(COLS, nSamples);
+        float3 rgb = videoTexture.SampleLevel(videoSampler, uv, 0).rgb;
+        InterlockedAdd(bins[BinIndex(0, LevelOf(rgb.r), id.x)], 1);
+        InterlockedAdd(bins[BinIndex(1, LevelOf(rgb.g), id.x)], 1);
+        InterlockedAdd(bins[BinIndex(2, LevelOf(rgb.b), id.x)], 1);
+        return;
+    }
+
+    uint2 size;
+    outputTexture.GetDimensions(size.x, size.y);
+    if (any(id.xy >= size)) return;
 
-float4 main(PS_INPUT input) : SV_TARGET {
     // Divide output horizontally into three equal panels (R | G | B).
     static const float kThird     = 0.33333333;
     static const float kTwoThirds = 0.66666667;
 
-    float  panelF     = input.uv.x * 3.0;
+    float2 uv         = (float2(id.xy) + 0.5) / float2(size);
+    float  panelF     = uv.x * 3.0;
     int    panel      = clamp(int(panelF), 0, 2);   // 0=R, 1=G, 2=B
     float  localU     = panelF - float(panel);       // 0..1 within panel
-    float  targetVal  = 1.0 - input.uv.y;            // top = 1.0 (100 IRE)
+    float  targetVal  = 1.0 - uv.y;                  // top = 1.0 (100 IRE)
+    uint   col        = min(uint(localU * COLS), COLS - 1);
 
-    int nSamples = int(NumSamples);
+    int   centre = int(LevelOf(targetVal));
     float accum  = 0.0;
-
-    [loop]
-    for (int i = 0; i < nSamples; i++) {
-        float  v   = (float(i) + 0.5) / float(nSamples);
-        float3 rgb = videoTexture.Sample(videoSampler, float2(localU, v)).rgb;
-
-        float chanVal;
-        if      (panel == 0) chanVal = rgb.r;
-        else if (panel == 1) chanVal = rgb.g;
-        else                 chanVal = rgb.b;
-
-        float d = chanVal - targetVal;
-        accum += exp(-d * d * kInvS2);
+    [unroll]
+    for (int d = -kRadius; d <= kRadius; d++) {
+        int level = centre + d;
+        if (level < 0 || level >= LEVELS) continue;
+        float dl = float(level) / (LEVELS - 1) - targetVal;
+        accum += float(bins[BinIndex(panel, level, col)]) * exp(-dl * dl * kInvS2);
     }
 
     float  k       = Brightness / float(nSamples);
@@ -75,22 +111,22 @@ float4 main(PS_INPUT input) : SV_TARGET {
 
     // --- Graticule: every 10 IRE ---
     float gridX     = frac(targetVal * 10.0 + 0.0001);
-    float tolerance = 5.0 / resolution.y;
+    float tolerance = 5.0 / size.y;
     bool  onGrid    = (gridX < tolerance || gridX > 1.0 - tolerance);
     if (onGrid) {
         float gr = 0.11;
-        if (targetVal < 2.0 / resolution.y || targetVal > 1.0 - 2.0 / resolution.y)
+        if (targetVal < 2.0 / size.y || targetVal > 1.0 - 2.0 / size.y)
             gr = 0.30;
         waveCol += gr;
     }
 
     // --- Panel divider lines ---
-    bool isDivider = abs(input.uv.x - kThird)     < 1.5 / resolution.x ||
-                     abs(input.uv.x - kTwoThirds) < 1.5 / resolution.x;
+    bool isDivider = abs(uv.x - kThird)     < 1.5 / size.x ||
+                     abs(uv.x - kTwoThirds) < 1.5 / size.x;
     if (isDivider) waveCol = float3(0.35, 0.35, 0.35);
 
     // --- Channel label bands: thin coloured strip at the very top ---
-    if (input.uv.y < 4.0 / resolution.y) {
+    if (uv.y < 4.0 / size.y) {
         if      (panel == 0) waveCol = float3(1.0, 0.2, 0.2);
         else if (panel == 1) waveCol = float3(0.2, 1.0, 0.2);
         else                 waveCol = float3(0.3, 0.5, 1.0);
@@ -98,6 +134,6 @@ float4 main(PS_INPUT input) : SV_TARGET {
 
     waveCol = saturate(waveCol);
 
-    float4 videoCol = videoTexture.Sample(videoSampler, input.uv);
-    return float4(lerp(waveCol, videoCol.rgb, BlendVideo), 1.0);
+    float4 videoCol = videoTexture.SampleLevel(videoSampler, uv, 0);
+    outputTexture[id.xy] = float4(lerp(waveCol, videoCol.rgb, BlendVideo), 1.0);
 }
@@ -4,18 +4,20 @@
         {"NAME": "sliceWidth",         "LABEL": "Slice Width",    "TYPE": "float", "MIN": 0.001, "MAX": 0.1,  "DEFAULT": 0.01},
         {"NAME": "slicePos",           "LABEL": "Slice Position", "TYPE": "float", "MIN": 0.0,  "MAX": 1.0,  "DEFAULT": 0.5},
         {"NAME": "scrollAxis",         "LABEL": "Scroll Axis",    "TYPE": "long",
-         "VALUES": [0, 1], "LABELS": ["Vertical", "Horizontal"], "DEFAULT": 0},
+         "VALUES": [0, 1], "LABELS": ["Vertical", "Horizontal"], "DEFAULT": 0, "SPECIALIZE": true},
         {"NAME": "temporalSpread",     "LABEL": "Temporal Spread","TYPE": "float", "MIN": 0.0,  "MAX": 2.0,  "DEFAULT": 0.8},
         {"NAME": "blendWeight",        "LABEL": "Blend",          "TYPE": "float", "MIN": 0.0,  "MAX": 1.0,  "DEFAULT": 1.0},
         {"NAME": "colourPalette",      "LABEL": "Colour Map",     "TYPE": "long",
-         "VALUES": [0, 1, 2], "LABELS": ["Original", "Heat", "Monochrome"], "DEFAULT": 0}
-    ]
+         "VALUES": [0, 1, 2], "LABELS": ["Original", "Heat", "Monochrome"], "DEFAULT": 0, "SPECIALIZE": true}
+    ],
+    "FRAME_HISTORY": {"FRAMES": 64, "SCALE": 0.5}
 }*/
 
-// Slit-scan temporal splice approximation.
-// Without frame history, each column/row encodes a different time phase via UV
-// displacement — replicating the streak-photo effect spatially.  The axis
-// perpendicular to the scan direction represents time; the scan axis is spatial.
+// Slit-scan temporal splice.
+// Each row/column shows the video as it was some frames ago: the further from
+// the slice, the older the frame, up to the 64 frames kept in frameHistory.
+// The axis perpendicular to the scan direction represents time; the scan axis
+// is spatial.
 
 Texture2D videoTexture : register(t0);
 SamplerState videoSampler : register(s0);
@@ -48,27 +50,19 @@ float3 heatmap(float t) {
 float4 main(PS_INPUT input) : SV_TARGET {
     float2 uv = input.uv;
 
-    // Phase encodes temporal offset: pixels far from the scan position have
-    // accumulated more "time" — sample the video at a shifted UV to fake history.
-    float axis   = (scrollAxis == 0) ? uv.x : uv.y;    // spatial axis
     float perp   = (scrollAxis == 0) ? uv.y : uv.x;    // temporal axis
 
-    // Distance from the slice centre gives the time offset magnitude
+    // Distance from the slice centre picks how many frames back to look;
+    // inside the slice it is the current frame
     float dist   = perp - slicePos;
-    float phase  = dist * temporalSpread;
+    float frames = max(abs(dist) - sliceWidth * 0.5, 0.0) * temporalSpread * historyFrames;
+    int   age    = int(frames);
 
-    // UV displacement: shift scan axis by phase * time, creating streak
-    float2 scanUV = uv;
-    float  scanOff = frac(phase + time * 0.05) - 0.5;
-    if (scrollAxis == 0)
-        scanUV.y = uv.y + scanOff * 0.5;
-    else
-        scanUV.x = uv.x + scanOff * 0.5;
-
-    // Active slice: show clean video where the slice currently is
-    bool inSlice = abs(dist) < sliceWidth * 0.5;
+    // Neighbouring frames blended so the time steps don't band
+    float4 older    = frameHistory.SampleLevel(videoSampler, float3(uv, HistorySlice(age + 1)), 0);
+    float4 newer    = frameHistory.SampleLevel(videoSampler, float3(uv, HistorySlice(age)), 0);
+    float4 scanCol  = lerp(newer, older, frac(frames));
     float4 sliceCol = videoTexture.Sample(videoSampler, uv);
-    float4 scanCol  = videoTexture.Sample(videoSampler, clamp(scanUV, 0.0, 1.0));
 
     // Blend scan vs clean based on distance from slice
     float fadeW = exp(-abs(dist) * 6.0);
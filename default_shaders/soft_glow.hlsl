@@ -0,0 +1,58 @@
+/*{
+    "INPUTS": [
+        {"NAME": "Threshold", "LABEL": "Threshold", "TYPE": "float",
+         "MIN": 0.0, "MAX": 1.0, "DEFAULT": 0.6},
+        {"NAME": "Radius",    "LABEL": "Radius",    "TYPE": "float",
+         "MIN": 1.0, "MAX": 8.0, "DEFAULT": 5.0},
+        {"NAME": "Amount",    "LABEL": "Amount",    "TYPE": "float",
+         "MIN": 0.0, "MAX": 2.0, "DEFAULT": 0.8},
+        {"NAME": "GlowTint",  "LABEL": "Tint",      "TYPE": "color",
+         "DEFAULT": [1.0, 0.95, 0.85, 1.0]}
+    ],
+    "VIDEO_MIPS": true
+}*/
+
+// Soft Glow
+// Wide bloom around bright areas, built from the video's coarse mip levels
+// instead of a large blur kernel: a handful of SampleLevel taps cover a
+// radius of hundreds of pixels.
+// Threshold: brightness where the glow starts
+// Radius: coarsest mip level blended in (each level doubles the spread)
+// Amount: glow strength
+// Tint: glow colour
+
+Texture2D videoTexture : register(t0);
+SamplerState videoSampler : register(s0);
+
+cbuffer Constants : register(b0) {
+    float time;
+    float padding1;
+    float2 resolution;
+    float2 videoResolution;
+    float2 padding2;
+    float4 custom[4];
+};
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float4 col = videoTexture.Sample(videoSampler, input.uv);
+
+    // Levels 1..Radius, finer ones weighted more; the last level is fractional
+    float3 glow = 0.0;
+    float weight = 0.0;
+    for (int level = 1; level <= 8; ++level) {
+        float w = saturate(Radius - level + 1.0) / level;
+        float3 c = videoTexture.SampleLevel(videoSampler, input.uv, level).rgb;
+        float luma = dot(c, float3(0.2126, 0.7152, 0.0722));
+        glow += c * smoothstep(Threshold, Threshold + 0.25, luma) * w;
+        weight += w;
+    }
+    glow /= max(weight, 1e-4);
+
+    col.rgb += glow * GlowTint.rgb * Amount;
+    return col;
+}
@@ -1,7 +1,21 @@
 /*{
+    "SHADER_TYPE": "compute",
+    "THREADS": [16, 16],
+    "BUFFERS": [
+        {"NAME": "hist",  "STRIDE": 4,  "COUNT": 262144, "PERSISTENT": false},
+        {"NAME": "blurH", "STRIDE": 16, "COUNT": 65536,  "PERSISTENT": false},
+        {"NAME": "blurV", "STRIDE": 16, "COUNT": 65536,  "PERSISTENT": false}
+    ],
+    "DISPATCHES": [
+        {"GROUPS": [1024, 1]},
+        {"GROUPS": [32, 32]},
+        {"GROUPS": [16, 16]},
+        {"GROUPS": [16, 16]},
+        {}
+    ],
     "INPUTS": [
         {"NAME": "GridSize",   "LABEL": "Sample Grid",  "TYPE": "float",
-         "MIN": 8.0, "MAX": 32.0, "DEFAULT": 16.0, "STEP": 1.0},
+         "MIN": 32.0, "MAX": 512.0, "DEFAULT": 256.0, "STEP": 1.0},
         {"NAME": "Brightness", "LABEL": "Brightness",   "TYPE": "float",
          "MIN": 1.0, "MAX": 30.0, "DEFAULT": 12.0},
         {"NAME": "BlendVideo", "LABEL": "Video Blend",  "TYPE": "float",
@@ -15,8 +29,11 @@
 // X-axis = Cb (blue–yellow),  Y-axis = Cr (red–cyan), both normalised −0.5..+0.5.
 // Centre = neutral grey.  Outer circle = maximum saturation boundary (radius 0.5).
 //
-// Samples a GridSize × GridSize grid across the video.  Increase GridSize for
-// greater accuracy at the cost of GPU throughput (16×16 = 256 samples per pixel).
+// Samples a GridSize × GridSize grid across the video, scattered once per frame
+// into a BINS × BINS CbCr histogram (count + RGB sums, InterlockedAdd). The
+// histogram is Gaussian-blurred by Spread in two separable dispatches, and the
+// display dispatch reads four bins per pixel, so the grid size no longer
+// multiplies the per-pixel cost.
 //
 // Colour of each plotted point is the weighted average RGB of video samples near
 // that CbCr position, making the scope self-annotating.
@@ -36,10 +53,13 @@ cbuffer Constants : register(b0) {
     float4 custom[4];
 };
 
-struct PS_INPUT {
-    float4 pos : SV_POSITION;
-    float2 uv  : TEXCOORD0;
-};
+// hist: [cr][cb] × (count, r, g, b sums in 0–255 units); blurH/blurV the same, blurred
+RWStructuredBuffer<uint>   hist  : register(u1);
+RWStructuredBuffer<float4> blurH : register(u2);
+RWStructuredBuffer<float4> blurV : register(u3);
+
+#define BINS 256
+static const int kMaxRadius = 32;   // Bins either side of the blur
 
 // BT.709 RGB → (Cb, Cr), range −0.5..+0.5
 float2 RGBtoCbCr(float3 rgb) {
@@ -69,33 +89,76 @@ float2 GetRefCbCr(int idx) {
     return              float2( 0.3854,  0.4542) * 0.75;   // Magenta
 }
 
-float4 main(PS_INPUT input) : SV_TARGET {
-    // Map UV to CbCr: centre (0.5, 0.5) = (Cb=0, Cr=0); Cr+ is up.
-    float cbTarget = input.uv.x - 0.5;
-    float crTarget = 0.5 - input.uv.y;
+// CbCr (−0.5..+0.5) → bin coordinate
+float2 BinCoord(float2 cbcr) { return (cbcr + 0.5) * BINS; }
 
-    int   gridN    = int(GridSize);
-    float invSig2  = 1.0 / (2.0 * Sigma * Sigma);
+// Separable Gaussian over the histogram (one axis per dispatch)
+float4 Blur(uint2 bin, int2 axis) {
+    float  sigBins = Sigma * BINS;
+    int    radius  = min(int(ceil(sigBins * 3.0)), kMaxRadius);
+    float  invS2   = 1.0 / (2.0 * sigBins * sigBins);
+    float4 acc     = float4(0.0, 0.0, 0.0, 0.0);
+    [loop]
+    for (int d = -radius; d <= radius; d++) {
+        int2 b = int2(bin) + axis * d;
+        if (any(b < 0) || any(b >= BINS)) continue;
+        uint   i = uint(b.y) * BINS + uint(b.x);
+        float4 v = (axis.x != 0)
+                 ? float4(hist[i * 4], hist[i * 4 + 1], hist[i * 4 + 2], hist[i * 4 + 3])
+                 : blurH[i];
+        acc += v * exp(-float(d * d) * invS2);
+    }
+    return acc;
+}
 
-    float  totalW   = 0.0;
-    float3 accumRGB = float3(0.0, 0.0, 0.0);
+[numthreads(THREADS_X, THREADS_Y, 1)]
+void main(uint3 id : SV_DispatchThreadID, uint3 group : SV_GroupID, uint index : SV_GroupIndex) {
+    if (PASSINDEX == 0) {
+        hist[group.x * THREADS_X * THREADS_Y + index] = 0;
+        return;
+    }
 
-    [loop]
-    for (int row = 0; row < gridN; row++) {
-        [loop]
-        for (int col = 0; col < gridN; col++) {
-            float2 sampleUV = (float2(col, row) + 0.5) / float(gridN);
-            float3 rgb      = videoTexture.Sample(videoSampler, sampleUV).rgb;
-            float2 cbcr     = RGBtoCbCr(rgb);
-
-            float dcb = cbcr.x - cbTarget;
-            float dcr = cbcr.y - crTarget;
-            float w   = exp(-(dcb * dcb + dcr * dcr) * invSig2);
-
-            totalW   += w;
-            accumRGB += rgb * w;
-        }
+    int gridN = int(GridSize);
+    if (PASSINDEX == 1) {
+        if (any(id.xy >= uint(gridN))) return;
+        float2 sampleUV = (float2(id.xy) + 0.5) / float(gridN);
+        float3 rgb      = videoTexture.SampleLevel(videoSampler, sampleUV, 0).rgb;
+        uint2  bin      = uint2(clamp(int2(BinCoord(RGBtoCbCr(rgb))), 0, BINS - 1));
+        uint   i        = (bin.y * BINS + bin.x) * 4;
+        uint3  rgb8     = uint3(saturate(rgb) * 255.0 + 0.5);
+        InterlockedAdd(hist[i],     1);
+        InterlockedAdd(hist[i + 1], rgb8.r);
+        InterlockedAdd(hist[i + 2], rgb8.g);
+        InterlockedAdd(hist[i + 3], rgb8.b);
+        return;
     }
+    if (PASSINDEX == 2) { blurH[id.y * BINS + id.x] = Blur(id.xy, int2(1, 0)); return; }
+    if (PASSINDEX == 3) { blurV[id.y * BINS + id.x] = Blur(id.xy, int2(0, 1)); return; }
+
+    uint2 size;
+    outputTexture.GetDimensions(size.x, size.y);
+    if (any(id.xy >= size)) return;
+    float2 uv = (float2(id.xy) + 0.5) / float2(size);
+
+    // Map UV to CbCr: centre (0.5, 0.5) = (Cb=0, Cr=0); Cr+ is up.
+    float cbTarget = uv.x - 0.5;
+    float crTarget = 0.5 - uv.y;
+
+    // Bilinear read of the blurred histogram
+    float2 f  = BinCoord(float2(cbTarget, crTarget)) - 0.5;
+    int2   b0 = int2(floor(f));
+    float2 tf = f - float2(b0);
+    float4 h  = float4(0.0, 0.0, 0.0, 0.0);
+    [unroll]
+    for (int k = 0; k < 4; k++) {
+        int2 b = b0 + int2(k & 1, k >> 1);
+        if (any(b < 0) || any(b >= BINS)) continue;
+        float w = ((k & 1) ? tf.x : 1.0 - tf.x) * ((k >> 1) ? tf.y : 1.0 - tf.y);
+        h += blurV[uint(b.y) * BINS + uint(b.x)] * w;
+    }
+
+    float  totalW   = h.x;
+    float3 accumRGB = h.yzw / 255.0;
 
     float invN2 = 1.0 / float(gridN * gridN);
     float3 scopeCol = float3(0.0, 0.0, 0.0);
@@ -109,7 +172,7 @@ float4 main(PS_INPUT input) : SV_TARGET {
     // --- Graticule ---
     float2 centre  = float2(cbTarget, crTarget);
     float  radDist = length(centre);
-    float  pxSize  = 1.0 / min(resolution.x, resolution.y);
+    float  pxSize  = 1.0 / min(size.x, size.y);
     float3 grat    = float3(0.0, 0.0, 0.0);
 
     // Outer boundary circle (max saturation, radius 0.5)
@@ -146,6 +209,6 @@ float4 main(PS_INPUT input) : SV_TARGET {
     float3 finalScope = saturate(scopeCol + grat);
 
     // Blend with original video
-    float4 videoCol = videoTexture.Sample(videoSampler, input.uv);
-    return float4(lerp(finalScope, videoCol.rgb, BlendVideo), 1.0);
+    float4 videoCol = videoTexture.SampleLevel(videoSampler, uv, 0);
+    outputTexture[id.xy] = float4(lerp(finalScope, videoCol.rgb, BlendVideo), 1.0);
 }
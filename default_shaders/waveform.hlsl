@@ -1,4 +1,14 @@
 /*{
+    "SHADER_TYPE": "compute",
+    "THREADS": [16, 16],
+    "BUFFERS": [
+        {"NAME": "bins", "STRIDE": 4, "COUNT": 524288, "PERSISTENT": false}
+    ],
+    "DISPATCHES": [
+        {"GROUPS": [2048, 1]},
+        {"GROUPS": [32, 16]},
+        {}
+    ],
     "INPUTS": [
         {"NAME": "NumSamples", "LABEL": "Sample Rows",  "TYPE": "float",
          "MIN": 32.0, "MAX": 256.0, "DEFAULT": 128.0, "STEP": 1.0},
@@ -13,7 +23,10 @@
 
 // Luma Waveform Monitor
 // X-axis: horizontal position in frame.  Y-axis: luminance 0–100 IRE (top = 100).
-// Samples NumSamples evenly-spaced rows per output column to reconstruct waveform density.
+// Dispatch 0 clears the histogram, dispatch 1 scatters NumSamples rows × COLS
+// columns of the video into it (InterlockedAdd per channel and level), and
+// dispatch 2 draws each output pixel from a few histogram bins, so the cost no
+// longer grows with the output height.
 // ShowRGB: overlays red, green, blue channel waveforms; luma waveform is shown in white
 //          when ShowRGB is off.
 // Graticule lines at every 10 IRE; 0 and 100 IRE lines are slightly brighter.
@@ -31,63 +44,87 @@ cbuffer Constants : register(b0) {
     float4 custom[4];
 };
 
-struct PS_INPUT {
-    float4 pos : SV_POSITION;
-    float2 uv  : TEXCOORD0;
-};
+// Histogram: [channel (luma, r, g, b)][level][column]
+RWStructuredBuffer<uint> bins : register(u1);
+
+#define COLS     512
+#define LEVELS   256
+#define CHANNELS 4
 
 // Gaussian half-width in luma units — gives a ~10-pixel-wide trace at 1080p.
 static const float kSigma    = 0.009;
 static const float kInvS2    = 1.0 / (2.0 * kSigma * kSigma);
+static const int   kRadius   = 7;   // Levels either side (~3 sigma)
 
-float4 main(PS_INPUT input) : SV_TARGET {
-    float  u          = input.uv.x;
-    float  targetLuma = 1.0 - input.uv.y;   // top of scope = 1.0 (100 IRE)
-    int    nSamples   = int(NumSamples);
-
-    float lumaAcc = 0.0;
-    float rAcc    = 0.0;
-    float gAcc    = 0.0;
-    float bAcc    = 0.0;
+uint BinIndex(uint channel, uint level, uint col) {
+    return (channel * LEVELS + level) * COLS + col;
+}
 
-    [loop]
-    for (int i = 0; i < nSamples; i++) {
-        float  v    = (float(i) + 0.5) / float(nSamples);
-        float3 rgb  = videoTexture.Sample(videoSampler, float2(u, v)).rgb;
-        float  luma = dot(rgb, float3(0.2126, 0.7152, 0.0722));
+uint LevelOf(float v) { return uint(saturate(v) * (LEVELS - 1) + 0.5); }
+
+// Trace density of one channel at `target` luma, from the column's bins
+float Density(uint channel, uint col, float target) {
+    int   centre = int(LevelOf(target));
+    float acc    = 0.0;
+    [unroll]
+    for (int d = -kRadius; d <= kRadius; d++) {
+        int level = centre + d;
+        if (level < 0 || level >= LEVELS) continue;
+        float dl = float(level) / (LEVELS - 1) - target;
+        acc += float(bins[BinIndex(channel, level, col)]) * exp(-dl * dl * kInvS2);
+    }
+    return acc;
+}
 
-        float dl = luma - targetLuma;
-        lumaAcc += exp(-dl * dl * kInvS2);
+[numthreads(THREADS_X, THREADS_Y, 1)]
+void main(uint3 id : SV_DispatchThreadID, uint3 group : SV_GroupID, uint index : SV_GroupIndex) {
+    if (PASSINDEX == 0) {
+        bins[group.x * THREADS_X * THREADS_Y + index] = 0;
+        return;
+    }
 
+    int nSamples = int(NumSamples);
+    if (PASSINDEX == 1) {
+        if (id.x >= COLS || id.y >= uint(nSamples)) return;
+        float2 uv   = (float2(id.xy) + 0.5) / float2(COLS, nSamples);
+        float3 rgb  = videoTexture.SampleLevel(videoSampler, uv, 0).rgb;
+        float  luma = dot(rgb, float3(0.2126, 0.7152, 0.0722));
+        InterlockedAdd(bins[BinIndex(0, LevelOf(luma), id.x)], 1);
         if (ShowRGB) {
-            float dr = rgb.r - targetLuma;
-            float dg = rgb.g - targetLuma;
-            float db = rgb.b - targetLuma;
-            rAcc += exp(-dr * dr * kInvS2);
-            gAcc += exp(-dg * dg * kInvS2);
-            bAcc += exp(-db * db * kInvS2);
+            InterlockedAdd(bins[BinIndex(1, LevelOf(rgb.r), id.x)], 1);
+            InterlockedAdd(bins[BinIndex(2, LevelOf(rgb.g), id.x)], 1);
+            InterlockedAdd(bins[BinIndex(3, LevelOf(rgb.b), id.x)], 1);
         }
+        return;
     }
 
+    uint2 size;
+    outputTexture.GetDimensions(size.x, size.y);
+    if (any(id.xy >= size)) return;
+    float2 uv         = (float2(id.xy) + 0.5) / float2(size);
+    float  targetLuma = 1.0 - uv.y;   // top of scope = 1.0 (100 IRE)
+    uint   col        = min(uint(uv.x * COLS), COLS - 1);
+
     float k = Brightness / float(nSamples);
 
     float3 waveCol;
     if (ShowRGB) {
-        waveCol = float3(rAcc, gAcc, bAcc) * k;
+        waveCol = float3(Density(1, col, targetLuma), Density(2, col, targetLuma), Density(3, col, targetLuma)) * k;
     } else {
+        float lumaAcc = Density(0, col, targetLuma);
         waveCol = float3(lumaAcc, lumaAcc, lumaAcc) * k;
     }
 
     // --- Graticule: lines at every 10 IRE ---
     // gridX wraps 0..1 ten times per 0-1 luma range.
     float gridX     = frac(targetLuma * 10.0 + 0.0001);
-    float threshold = 5.0 / resolution.y;   // ~half-pixel tolerance
+    float threshold = 5.0 / size.y;   // ~half-pixel tolerance
 
     bool onGrid = (gridX < threshold || gridX > 1.0 - threshold);
     if (onGrid) {
         float brightness = 0.12;
         // 0 and 100 IRE are reference black/white — draw them brighter
-        if (targetLuma < 2.0 / resolution.y || targetLuma > 1.0 - 2.0 / resolution.y)
+        if (targetLuma < 2.0 / size.y || targetLuma > 1.0 - 2.0 / size.y)
             brightness = 0.35;
         waveCol += brightness;
     }
@@ -95,6 +132,6 @@ float4 main(PS_INPUT input) : SV_TARGET {
     waveCol = saturate(waveCol);
 
     // Blend with original video
-    float4 videoCol = videoTexture.Sample(videoSampler, input.uv);
-    return float4(lerp(waveCol, videoCol.rgb, BlendVideo), 1.0);
+    float4 videoCol = videoTexture.SampleLevel(videoSampler, uv, 0);
+    outputTexture[id.xy] = float4(lerp(waveCol, videoCol.rgb, BlendVideo), 1.0);
 }
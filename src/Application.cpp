@@ -1,11 +1,160 @@
 #include "Application.h"
+#include "CaptureDevices.h"
+#include "PixelCopy.h"
+#include "ThreadPriority.h"
 #include <commdlg.h>
 #include <shellapi.h>
 #include <shobjidl.h>
 #include <fstream>
+#include <cmath>
+#include <cstdio>
+#include <thread>
 
 namespace SP {
 
+namespace {
+
+// Audio further than this from the video at a loop point is re-seeked
+constexpr double AUDIO_RESYNC_SECONDS = 0.1;
+
+// The next playlist entry is probed this long before the current clip ends
+constexpr double PLAYLIST_PREOPEN_SECONDS = 5.0;
+
+// FeedAudio keeps the player this far ahead: the cushion against main-thread
+// stalls. Low-latency output trades most of it for a queue that a stall longer
+// than this drains audibly.
+constexpr double AUDIO_FILL_SECONDS             = 2.0;
+constexpr double AUDIO_FILL_SECONDS_LOW_LATENCY = 0.15;
+
+// Audio-master sync. An audio clock further than SYNC_MAX_AUDIO_SKEW from the
+// wall clock is ignored (audio wrapped early, or a gap), so video never waits on it.
+constexpr double SYNC_MAX_AUDIO_SKEW = 1.0;
+// Network frame sync. A follower further than FRAME_SYNC_SEEK_SECONDS off the
+// master's clock seeks, FRAME_SYNC_SEEK_LEAD ahead so the decoder has time to
+// land before the clock gets there, and not again within FRAME_SYNC_SEEK_COOLDOWN.
+constexpr double FRAME_SYNC_SEEK_SECONDS  = 0.25;
+constexpr double FRAME_SYNC_SEEK_LEAD     = 0.1;
+constexpr double FRAME_SYNC_SEEK_COOLDOWN = 1.0;
+// Lagging more than this many frames turns on non-reference frame skipping,
+// which stays on until video is back within one frame.
+constexpr double CATCHUP_NONREF_FRAMES = 3.0;
+// Lagging more than this with an empty queue discards decoded frames unconverted
+// up to CATCHUP_DISCARD_LEAD past the clock.
+constexpr double CATCHUP_DISCARD_SECONDS = 0.5;
+constexpr double CATCHUP_DISCARD_LEAD    = 0.2;
+
+// Variable speed. From NONREF_RATE up the decoder skips non-reference frames,
+// from KEYFRAME_ONLY_RATE it decodes keyframes only: at those rates most frames
+// would be dropped at presentation anyway.
+constexpr double MIN_PLAYBACK_RATE  = 0.25;
+constexpr double MAX_PLAYBACK_RATE  = 8.0;
+constexpr double NONREF_RATE        = 2.0;
+constexpr double KEYFRAME_ONLY_RATE = 4.0;
+
+// Smoothed tick period used to select frames at the tick nearest their due time.
+// Clamped so a stall (dialog, seek) or a burst doesn't swing it.
+constexpr double MIN_TICK_SECONDS = 1.0 / 500.0;
+constexpr double MAX_TICK_SECONDS = 0.1;
+constexpr double TICK_SMOOTHING   = 0.05;
+// Running average weight of the cadence timing error
+constexpr double CADENCE_ERROR_SMOOTHING = 0.02;
+
+// Render-ahead: frames drawn per tick, stale redraws included. Above one so the
+// queue refills after a spike; the cap keeps a refill from becoming a spike.
+constexpr int RENDER_AHEAD_PER_TICK = 2;
+constexpr int MAX_RENDER_AHEAD_FRAMES = 8;
+
+// Timeline drags refine the keyframe preview to the exact frame once the mouse
+// has rested this long
+constexpr double SCRUB_REFINE_DELAY = 0.12;
+
+// Offline export draws the UI and presents (without vsync) this often
+constexpr double EXPORT_UI_INTERVAL = 0.25;
+
+// Monitor refresh rates are re-read this often (windows move between monitors)
+constexpr double REFRESH_QUERY_INTERVAL = 1.0;
+// The metrics endpoint's values are refreshed this often; scrapers poll slower
+constexpr double METRICS_PUBLISH_INTERVAL = 1.0;
+// With nothing visible, the loop wakes this often (or on any message) to feed
+// audio and pop frames while playing, and to watch shaders and probes otherwise
+constexpr DWORD HIDDEN_PLAYING_TICK_MS = 50;
+constexpr DWORD HIDDEN_IDLE_TICK_MS    = 250;
+// The cap sleeps on the timer until this close to the deadline, then yields
+constexpr double TICK_SPIN_SECONDS = 0.001;
+// A throttled UI redraws once this fraction of its interval has passed
+constexpr double UI_REFRESH_SLACK = 0.9;
+// Background GPU work (thumbnail loads and draws, prewarm, LUT bakes) stops
+// after this much CPU time a tick
+constexpr double BACKGROUND_CPU_BUDGET_MS = 2.0;
+// A tick this far over the refresh interval was a hitch: no background work after it
+constexpr double BACKGROUND_LATE_RATIO = 1.5;
+// SaveConfig writes this long after the last call, so a slider drag or a run
+// of toggles is one write
+constexpr double CONFIG_SAVE_DELAY = 0.5;
+
+// Ticks from inside modal loops. Window timers fire at most every
+// USER_TIMER_MINIMUM (10 ms), in practice at the system timer resolution.
+constexpr UINT_PTR MODAL_TICK_TIMER = 1;
+
+// Playback benchmark: a clip that hasn't opened (and its preset compiled) by
+// then is reported as failed
+constexpr double BENCH_OPEN_TIMEOUT = 30.0;
+
+// Session events: the parts of the preset JSON (ConfigManager) each one carries
+nlohmann::json SessionParams(const ShaderPreset& preset) {
+    const nlohmann::json state = preset;
+    return {{"paramValues", state.value("paramValues", nlohmann::json::object())},
+            {"blendMode", preset.blendMode}, {"blendAmount", preset.blendAmount}};
+}
+
+nlohmann::json SessionKeyframes(const ShaderPreset& preset) {
+    const nlohmann::json state = preset;
+    return {{"keyframes", state.value("keyframes", nlohmann::json::object())}};
+}
+
+nlohmann::json SessionAudio(const AppConfig& cfg) {
+    return {{"beatSensitivity", cfg.audio.beatSensitivity}, {"beatDecay", cfg.audio.beatDecay},
+            {"smoothing", cfg.audio.smoothing}, {"fftSize", cfg.audio.fftSize},
+            {"multiResolution", cfg.audio.multiResolution}, {"logSpectrum", cfg.audio.logSpectrum},
+            {"volume", cfg.audioVolume}, {"mute", cfg.muteAudio}};
+}
+
+// AppConfig::hwDecodePolicy as the decoder takes it
+std::unordered_map<std::string, HwDecodePolicy> HwDecodePolicies(const AppConfig& cfg) {
+    std::unordered_map<std::string, HwDecodePolicy> policies;
+    for (const auto& [codec, policy] : cfg.hwDecodePolicy) {
+        policies[codec] = static_cast<HwDecodePolicy>(std::clamp(policy, 0, 2));
+    }
+    return policies;
+}
+
+const char* SessionPlaybackState(PlaybackState state) {
+    switch (state) {
+    case PlaybackState::Playing: return "playing";
+    case PlaybackState::Paused:  return "paused";
+    default:                     return "stopped";
+    }
+}
+
+// Refresh rate of the monitor showing most of `hwnd`, 0 if unknown
+int MonitorRefreshHz(HWND hwnd) {
+    MONITORINFOEXW info = {};
+    info.cbSize = sizeof(info);
+    if (!hwnd || !GetMonitorInfoW(MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST), &info)) return 0;
+    DEVMODEW mode = {};
+    mode.dmSize = sizeof(mode);
+    if (!EnumDisplaySettingsW(info.szDevice, ENUM_CURRENT_SETTINGS, &mode)) return 0;
+    // 0 and 1 mean "hardware default"
+    return mode.dmDisplayFrequency > 1 ? static_cast<int>(mode.dmDisplayFrequency) : 0;
+}
+
+// FrameWatchdog's report, next to config.json
+std::string WatchdogLogPath() {
+    return std::filesystem::path(ConfigManager::GetDefaultConfigPath()).replace_filename("watchdog.log").string();
+}
+
+} // namespace
+
 Application::Application() = default;
 
 Application::~Application() {
@@ -15,6 +164,9 @@ Application::~Application() {
 bool Application::Initialize(HINSTANCE hInstance, int nCmdShow) {
     // Load configuration
     m_configManager.Load(ConfigManager::GetDefaultConfigPath());
+    // Before any thread starts: they read it once
+    ThreadPriority::SetEnabled(m_configManager.GetConfig().threadPriorities);
+    GetCpuFeatures();  // CPUID once, so PixelCopy's paths are chosen before any thread copies a frame
 
     // Create window
     if (!CreateMainWindow(hInstance, nCmdShow)) {
@@ -22,28 +174,82 @@ bool Application::Initialize(HINSTANCE hInstance, int nCmdShow) {
     }
 
     // Initialize D3D11 renderer
+    m_renderer.SetPreferredAdapter(m_configManager.GetConfig().gpuAdapter);
+    m_renderer.SetSharedShaderCache(m_configManager.GetConfig().sharedShaderCache);
     if (!m_renderer.Initialize(m_hwnd, m_windowWidth, m_windowHeight)) {
         MessageBoxA(nullptr, "Failed to initialize D3D11", "Error", MB_OK | MB_ICONERROR);
         return false;
     }
 
-    // Generate initial noise texture (bound globally as t1/s1 for all shaders)
-    {
-        const auto& cfg = m_configManager.GetConfig();
-        m_renderer.UpdateNoiseTexture(cfg.noise.scale, cfg.noise.textureSize);
-        m_renderer.SetGenerativeResolution(cfg.generativeWidth, cfg.generativeHeight);
+    // Share the renderer's device with the decoder for zero-copy D3D11VA decode,
+    // where the GPU's decoder takes the stream (or the codec's policy forces it)
+    m_hwDecodeCaps.Probe(m_renderer.GetDevice());
+    m_decoder.SetHardwareDecodeCaps(&m_hwDecodeCaps);
+    m_decoder.SetHardwareDecodePolicy(HwDecodePolicies(m_configManager.GetConfig()));
+    if (m_configManager.GetConfig().hardwareDecode) {
+        m_decoder.SetHardwareDevice(m_renderer.GetDevice());
     }
-
-    // Initialise Spout sender (non-fatal — Spout may not be installed on this machine)
-    if (m_spoutOutput.Initialize(m_renderer.GetDevice())) {
+    m_decoder.SetGpuYuvConversion(m_configManager.GetConfig().gpuYuvConversion);
+    m_renderer.SetVideoProcessorConversion(m_configManager.GetConfig().videoProcessorConversion);
+    m_renderer.SetHighBitDepth(m_configManager.GetConfig().highBitDepth);
+    m_encoder.SetHardwareDevice(m_renderer.GetDevice());
+    m_decoder.SetDecodeThreading(m_configManager.GetConfig().decodeThreadCount,
+                                 m_configManager.GetConfig().decodeThreadType);
+    m_decoder.SetProxyScale(m_configManager.GetConfig().proxyScale);
+    m_decoder.SetImageSequenceOptions(m_configManager.GetConfig().imageSequenceFps,
+                                      m_configManager.GetConfig().imageSequenceCacheMB);
+    m_renderer.GetScrubCache().SetBudgetMB(m_configManager.GetConfig().scrubCacheMB);
+    m_renderer.SetMaximumFrameLatency(m_configManager.GetConfig().lowLatencyPresent ? 1 : 2);
+    // The high-resolution flag needs Windows 10 1803; older timers tick at the scheduler's rate
+    m_tickTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!m_tickTimer) m_tickTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+
+    m_renderer.SetGenerativeResolution(m_configManager.GetConfig().generativeWidth,
+                                       m_configManager.GetConfig().generativeHeight);
+
+    // Audio device, Spout sender and noise kernels come up on workers while the
+    // first frames draw (FinishStartupTasks)
+    StartStartupTasks();
+    {
         const auto& cfg = m_configManager.GetConfig();
-        m_spoutOutput.SetSenderName(cfg.spoutSenderName);
-        m_spoutOutput.SetEnabled(cfg.spoutEnabled);
+        m_ndiOutput.SetOutputSize(cfg.ndiWidth, cfg.ndiHeight);
+        if (cfg.ndiEnabled) m_ndiOutput.Start(m_renderer.GetDevice(), m_renderer.GetContext(), cfg.ndiSenderName);
+        if (cfg.virtualCameraEnabled)
+            m_virtualCamera.Start(m_renderer.GetDevice(), m_renderer.GetContext(), cfg.virtualCameraName);
+        if (cfg.oscEnabled) m_controlInput.StartOsc(cfg.oscPort);
+        if (!cfg.midiDevice.empty()) m_controlInput.StartMidi(cfg.midiDevice);
+        if (cfg.metricsEnabled) m_metrics.Start(cfg.metricsPort);
+        if (cfg.frameSyncRole != FRAME_SYNC_OFF)
+            m_frameSync.Start(static_cast<FrameSync::Role>(cfg.frameSyncRole), cfg.frameSyncPort);
     }
+    if (const auto& cfg = m_configManager.GetConfig(); cfg.watchdogEnabled)
+        m_watchdog.Start({cfg.watchdogStallMs, cfg.watchdogGpuMs}, WatchdogLogPath(), m_cpuProfiler);
 
     // Create shader manager
     m_shaderManager = std::make_unique<ShaderManager>(m_renderer);
     m_shaderManager->EnableFileWatching(true);
+    m_thumbnails.Initialize(m_renderer);
+    m_backgroundWork.Initialize(m_renderer.GetDevice(), m_renderer.GetContext());
+    // A shortcut-bound or neighbouring shader's first draw
+    m_backgroundWork.AddTask("Prewarm", [this] { return m_shaderManager->PrewarmNext(); });
+    // Only rows the library showed in the last frames are drawn
+    m_backgroundWork.AddTask("Thumbnails", [this] {
+        return m_configManager.GetConfig().libraryThumbnails && m_thumbnails.Step(*m_shaderManager);
+    });
+    m_backgroundWork.AddTask("LUT bake", [this] {
+        if (m_pendingLutBakeSize == 0 || m_lutBake.size > 0) return false;
+        const int size = m_pendingLutBakeSize;
+        m_pendingLutBakeSize = 0;
+        const ShaderPreset* preset = m_shaderManager->GetActivePreset();
+        if (!preset || !m_renderer.BeginLutBake(size, m_lutBake)) {
+            m_uiManager->ShowNotification("LUT bake failed");
+            return false;
+        }
+        m_lutBakePath  = m_pendingLutBakePath;
+        m_lutBakeTitle = preset->name;
+        m_renderer.BeginFrame();  // The bake's draw changed the targets and viewport
+        return true;
+    });
 
     // Create UI manager
     m_uiManager = std::make_unique<UIManager>(*this);
@@ -52,34 +258,6 @@ bool Application::Initialize(HINSTANCE hInstance, int nCmdShow) {
         return false;
     }
 
-    // Load shader presets from config.
-    // LoadShaderMetadataFromFile reads+parses ISF without compiling; AddPreset compiles
-    // once. This avoids the double-compile that LoadShaderFromFile + AddPreset incurred.
-    for (auto& configPreset : m_configManager.GetConfig().shaderPresets) {
-        if (!configPreset.filepath.empty()) {
-            ShaderPreset loadedPreset;
-            if (m_shaderManager->LoadShaderMetadataFromFile(configPreset.filepath, loadedPreset)) {
-                loadedPreset.shortcutKey       = configPreset.shortcutKey;
-                loadedPreset.shortcutModifiers = configPreset.shortcutModifiers;
-                // Restore saved param values by name
-                for (auto& param : loadedPreset.params) {
-                    auto it = configPreset.savedParamValues.find(param.name);
-                    if (it != configPreset.savedParamValues.end()) {
-                        const auto& vals = it->second;
-                        for (int i = 0; i < 4 && i < static_cast<int>(vals.size()); ++i)
-                            param.values[i] = vals[i];
-                    }
-                    // Restore saved keyframe timeline
-                    auto kit = configPreset.savedKeyframes.find(param.name);
-                    if (kit != configPreset.savedKeyframes.end()) {
-                        param.timeline = kit->second;
-                    }
-                }
-                m_shaderManager->AddPreset(loadedPreset);
-            }
-        }
-    }
-
     // Resolve the shader directory: if the configured path doesn't exist, try the
     // directory next to the executable (works for dev builds run from build/Release/).
     {
@@ -94,8 +272,18 @@ bool Application::Initialize(HINSTANCE hInstance, int nCmdShow) {
         }
     }
 
-    // Scan shader directory
-    m_shaderManager->ScanDirectory(m_configManager.GetConfig().shaderDirectory);
+    // Before the first compile: #include lines look there too
+    m_shaderManager->SetIncludeDirectory(m_configManager.GetConfig().shaderDirectory);
+
+    // Load shader presets from config, then the rest of the shader directory.
+    // A worker reads and parses them (in parallel, unchanged files from the
+    // library index) while the first frames draw; ProcessFrame adds them once it
+    // is done, each queued for one background compile, or none until first use
+    // in library mode.
+    m_shaderManager->SetLazyCompile(m_configManager.GetConfig().lazyShaderCompile);
+    m_shaderManager->SetResidencyBudget(m_configManager.GetConfig().residentShaderBudget);
+    m_shaderManager->LoadLibraryAsync(m_configManager.GetConfig().shaderPresets,
+                                      m_configManager.GetConfig().shaderDirectory);
 
     // Create shaders directory if it doesn't exist
     std::filesystem::create_directories(m_configManager.GetConfig().shaderDirectory);
@@ -104,23 +292,38 @@ bool Application::Initialize(HINSTANCE hInstance, int nCmdShow) {
     m_workspaceManager = std::make_unique<WorkspaceManager>();
     m_workspaceManager->Initialize(m_configManager.GetConfig().layoutsDirectory);
 
+    // Apply audio DSP settings from config
+    m_audioAnalysis.UpdateSettings(m_configManager.GetConfig().audio);
+    m_audioAnalysis.Start();
+    ApplyAudioInput();
+
     // Open last video if available
     if (!m_configManager.GetConfig().lastOpenedVideo.empty()) {
         OpenVideo(m_configManager.GetConfig().lastOpenedVideo);
     }
 
-    // Apply audio DSP settings from config
-    m_audioAnalyzer.UpdateSettings(m_configManager.GetConfig().audio);
+    m_lastFrameTime = std::chrono::steady_clock::now();
 
-    // Initialise audio playback (non-fatal — continues without audio on headless systems)
-    if (m_audioPlayer.Initialize()) {
-        const auto& cfg = m_configManager.GetConfig();
-        m_audioPlayer.SetVolume(cfg.audioVolume);
-        m_audioPlayer.SetMute(cfg.muteAudio);
+    // Reopen the extra video inputs of the last session
+    {
+        const std::vector<std::string> inputs = m_configManager.GetConfig().videoInputs;
+        for (int i = 0; i < static_cast<int>(inputs.size()) && i < MAX_VIDEO_INPUTS; ++i) {
+            if (!inputs[i].empty()) OpenVideoInput(i, inputs[i]);
+        }
+        if (!m_configManager.GetConfig().deckVideo.empty()) CueDeck(m_configManager.GetConfig().deckVideo);
+        const std::vector<ChannelConfig> channels = m_configManager.GetConfig().channels;
+        for (size_t i = 0; i < channels.size(); ++i) m_channels.push_back(std::make_unique<PlaybackChannel>());
+        for (int i = 0; i < static_cast<int>(channels.size()); ++i) {
+            if (!channels[i].video.empty()) CueChannel(i, channels[i].video);  // Threads split over all of them
+            if (channels[i].output) OpenChannelOutput(i);
+        }
+        if (m_configManager.GetConfig().canvasEnabled) OpenCanvasOutputs();
+        const std::vector<std::string> luts = m_configManager.GetConfig().lutFiles;
+        for (int i = 0; i < static_cast<int>(luts.size()) && i < MAX_LUTS; ++i) {
+            if (!luts[i].empty()) OpenLut(i, luts[i]);
+        }
     }
 
-    m_lastFrameTime = std::chrono::steady_clock::now();
-
     // Upload initial param values to GPU if a preset is already active
     OnParamChanged();
 
@@ -128,16 +331,55 @@ bool Application::Initialize(HINSTANCE hInstance, int nCmdShow) {
 }
 
 void Application::Shutdown() {
-    StopRecording();
-    SaveConfig();
-
-    m_audioPlayer.Shutdown();
-    m_spoutOutput.Shutdown();
+    m_watchdog.Stop();  // Shutting down joins threads and flushes files: no stall reports
+    // A worker still opening the device or sender: its result is shut down below
+    FinishStartupTasks(true);
+    m_calibrationCancel = true;  // Ends within a frame; the result is dropped
+    if (m_encoderCalibration.valid()) m_encoderCalibration.wait();
+    if (m_encoder.IsRecording()) {
+        while (SubmitReadback(true)) {}
+    }
+    m_encoder.StopRecording();  // Not StopRecording(): that would reopen the file at proxy size
+    for (auto& encoder : m_extraEncoders) encoder->StopRecording();
+    WriteConfig();
+    m_configManager.WaitForSave();
+
+    m_audioPlayer->Shutdown();
+    m_audioCapture.Stop();  // Before the thread it pushes into
+    m_audioAnalysis.Stop();
+    m_spoutOutput->Shutdown();
+    m_spoutInput.Close();
+    m_ndiOutput.Stop();
+    m_virtualCamera.Stop();
+    m_controlInput.StopMidi();
+    m_controlInput.StopOsc();
+    m_metrics.Stop();
+    m_frameSync.Stop();
+    m_ndiInput.Close();
+    m_mfCapture.Close();
+    m_stillImage.Close();
+    for (auto& channel : m_channels) channel->Release(m_renderer);
+    m_channels.clear();           // Their windows join their present threads too
+    CloseCanvasOutputs();
+    m_videoOutputWindow.Close();  // Joins its present thread before the device goes
     m_uiManager.reset();
+    m_backgroundWork.Shutdown();
+    m_thumbnails.Shutdown();
+    m_mediaOverview.Reset();
+    m_mediaOverview.ReleaseTexture();
     m_shaderManager.reset();
+    m_mediaProbe.Cancel();
+    m_nextProbe.Cancel();
+    m_proxyTranscoder.Cancel();
+    m_decodeWorker.Stop();
+    for (auto& input : m_inputs) input.Close();
     m_renderer.Shutdown();
     m_decoder.Close();
 
+    if (m_tickTimer) {
+        CloseHandle(m_tickTimer);
+        m_tickTimer = nullptr;
+    }
     if (m_hwnd) {
         DestroyWindow(m_hwnd);
         m_hwnd = nullptr;
@@ -233,6 +475,23 @@ LRESULT Application::HandleMessage(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lP
         HandleDroppedFiles(reinterpret_cast<HDROP>(wParam));
         return 0;
 
+    case WM_ENTERSIZEMOVE:
+    case WM_ENTERMENULOOP:
+        BeginModalLoop();
+        return 0;
+
+    case WM_EXITSIZEMOVE:
+    case WM_EXITMENULOOP:
+        EndModalLoop();
+        return 0;
+
+    case WM_TIMER:
+        if (wParam == MODAL_TICK_TIMER) {
+            ModalTick();
+            return 0;
+        }
+        break;
+
     case WM_KEYDOWN: {
         // Bit 30 of lParam = previous key state: 1 means auto-repeat, ignore it.
         // Without this, holding Space fires TogglePlayback multiple times, leaving
@@ -277,15 +536,20 @@ void Application::HandleDroppedFiles(HDROP hDrop) {
         for (char& c : ext) c = static_cast<char>(std::tolower(c));
 
         if (ext == ".hlsl" || ext == ".fx" || ext == ".ps") {
-            // Load as shader
+            // Load as shader: parsed here, compiled once by AddPreset
             ShaderPreset preset;
-            if (m_shaderManager->LoadShaderFromFile(utf8Path, preset)) {
+            if (m_shaderManager->LoadShaderMetadataFromFile(utf8Path, preset)) {
                 int idx = m_shaderManager->AddPreset(preset);
-                m_shaderManager->SetActivePreset(idx);
-                m_uiManager->ResetKeyframeSelection();
-                OnParamChanged();
-                m_uiManager->SetEditorContent(preset.source);
-                m_uiManager->ShowNotification("Loaded shader: " + preset.name);
+                if (!m_shaderManager->GetPreset(idx)->isValid) {
+                    m_shaderManager->RemovePreset(idx);
+                    m_uiManager->ShowNotification("Shader failed to compile: " + preset.name);
+                } else {
+                    m_shaderManager->SetActivePreset(idx);
+                    m_uiManager->ResetKeyframeSelection();
+                    OnParamChanged();
+                    m_uiManager->SetEditorContent(preset.source);
+                    m_uiManager->ShowNotification("Loaded shader: " + preset.name);
+                }
             }
         } else {
             // Try to open as video
@@ -343,6 +607,9 @@ void Application::HandleKeyboardShortcuts(UINT vkCode) {
             StartRecording(settings);
         }
         return;
+    case VK_F11:
+        SaveReplay();
+        return;
     case 'O':
         if (ctrl) {
             OpenVideoDialog();
@@ -353,6 +620,18 @@ void Application::HandleKeyboardShortcuts(UINT vkCode) {
             SaveCurrentShader(m_uiManager->GetEditorContent());
         }
         return;
+    case 'T':
+        if (ctrl) {
+            SaveTrace();
+            return;
+        }
+        break;
+    case 'R':
+        if (ctrl) {
+            ToggleSessionRecording();
+            return;
+        }
+        break;
     }
 
     // Custom passthrough keybinding (Escape is always hardcoded; this is a secondary binding)
@@ -409,654 +688,4126 @@ void Application::HandleKeyboardShortcuts(UINT vkCode) {
 
 int Application::Run() {
     MSG msg = {};
+    TraceRecorder::SetThreadName("Main");
+    ThreadPriority::Apply(ThreadRole::Render);
 
     while (!m_exitRequested) {
-        while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
-            if (msg.message == WM_QUIT) {
-                m_exitRequested = true;
-                break;
+        m_renderPolicy = ChooseRenderPolicy();
+        m_cpuProfiler.BeginFrame();
+        m_frameArena.Reset();
+        {
+            // Wait for the swap chain before sampling input and audio, not inside
+            // Present after the frame is built from them
+            SP_CPU_SCOPE(m_cpuProfiler, LatencyWait);
+            if (m_renderPolicy == RenderPolicy::Hidden) {
+                WaitWhileHidden();
+            } else {
+                m_renderer.WaitForFrameLatency();
+                WaitForTickDeadline();
+            }
+        }
+        {
+            SP_CPU_SCOPE(m_cpuProfiler, Messages);
+            while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+                if (msg.message == WM_QUIT) {
+                    m_exitRequested = true;
+                    break;
+                }
+                TranslateMessage(&msg);
+                DispatchMessageW(&msg);
             }
-            TranslateMessage(&msg);
-            DispatchMessageW(&msg);
         }
 
         if (m_exitRequested) break;
 
         ProcessFrame();
-        RenderFrame();
+        if (m_renderPolicy != RenderPolicy::Hidden) RenderFrame();
+        if (m_benchmark) StepPlaybackBenchmark();
+        if (m_sessionRecording) CaptureSessionState();
+        if (m_sessionReplaying) StepSessionReplay();
     }
 
     return static_cast<int>(msg.wParam);
 }
 
-void Application::ProcessFrame() {
-    auto now = std::chrono::steady_clock::now();
-    double elapsed = std::chrono::duration<double>(now - m_lastFrameTime).count();
-
-    m_newVideoFrame = false;
-
-    // Check for shader file changes
-    m_shaderManager->CheckForChanges();
-
-    if (m_playbackState == PlaybackState::Playing) {
-        if (m_decoder.IsOpen()) {
-            if (m_decoder.IsLiveCapture()) {
-                // Live capture: non-blocking decode on every tick; advance wall-clock time.
-                // DecodeNextFrame returns false immediately (EAGAIN) when the device has no
-                // new frame yet — we just keep the last frame displayed until the next one.
-                const float dt = static_cast<float>(std::min(elapsed, 0.1));
-                m_generativeTime += dt;
-                m_playbackTime = m_generativeTime;
-                m_lastFrameTime = now;
+Application::RenderPolicy Application::ChooseRenderPolicy() {
+    // These drive the loop themselves and draw the UI on their own schedule
+    if (m_exporting || m_benchmark || m_sessionReplaying) return RenderPolicy::Full;
+
+    // A present that found the window covered stops the UI; ask DXGI again each
+    // tick, since nothing presents to find out when it shows again
+    const bool mainVisible = !IsIconic(m_hwnd) && !(m_renderer.IsOccluded() && m_renderer.TestOccluded());
+    if (mainVisible) return RenderPolicy::Full;
+
+    bool outputVisible = m_videoOutputWindow.IsOpen() && !IsIconic(m_videoOutputWindow.GetHwnd());
+    for (const auto& channel : m_channels)
+        outputVisible = outputVisible || (channel->GetOutput().IsOpen() && !IsIconic(channel->GetOutput().GetHwnd()));
+    for (const auto& window : m_canvasWindows)
+        outputVisible = outputVisible || (window->IsOpen() && !IsIconic(window->GetHwnd()));
+    bool recording = m_encoder.IsRecording();
+    for (const auto& encoder : m_extraEncoders) recording = recording || encoder->IsRecording();
+    if (outputVisible || m_spoutOutput->IsEnabled() || m_ndiOutput.IsRunning() || m_virtualCamera.IsRunning() ||
+        recording)
+        return RenderPolicy::OutputsOnly;
+    return RenderPolicy::Hidden;
+}
 
-                if (m_decoder.DecodeNextFrame(m_currentFrame))
-                    m_newVideoFrame = true;
-            } else {
-                // Video file mode: advance playback time from decoded frame timestamps
-                if (elapsed >= m_frameDuration) {
-                    if (m_decoder.DecodeNextFrame(m_currentFrame)) {
-                        m_newVideoFrame = true;
-                        m_playbackTime = static_cast<float>(m_currentFrame.timestamp);
-                    } else {
-                        // End of video, loop
-                        m_decoder.SeekToTime(0.0);
-                        m_audioAnalyzer.Reset();
-                        m_audioPlayer.Flush();
-                    }
-                    m_lastFrameTime = now;
-                }
+void Application::WaitWhileHidden() {
+    m_nextTickTime = {};  // The cap restarts from the first visible tick
+    const DWORD timeout = (m_playbackState == PlaybackState::Playing) ? HIDDEN_PLAYING_TICK_MS : HIDDEN_IDLE_TICK_MS;
+    MsgWaitForMultipleObjectsEx(0, nullptr, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+}
 
-                // Audio: fill the ring buffer to a 2-second target on every tick.
-                // ReadAudioAhead decodes audio eagerly and queues video packets for
-                // DecodeNextFrame. Submission is capped at the deficit so the ring
-                // buffer never fills beyond the target — avoiding the bug where
-                // draining at 60 fps submits audio 20x faster than real time,
-                // exhausting the ring buffer capacity in < 1 second.
-                if (m_decoder.HasAudio()) {
-                    const int rate        = m_decoder.GetAudioSampleRate();
-                    const int deviceRate  = m_audioPlayer.GetDeviceSampleRate();
-                    // 2-second target in device-rate samples (the unit GetBufferedSamples returns)
-                    const int targetFill  = (deviceRate > 0 ? deviceRate : rate) * 2;
-                    const int currentFill = m_audioPlayer.GetBufferedSamples();
-                    const int deficit     = targetFill - currentFill;
-
-                    constexpr int kAudioBuf = 16384;
-                    static float audioBuf[kAudioBuf];
-
-                    if (deficit > 0) {
-                        // Read ahead exactly what's needed to cover the deficit — no per-tick
-                        // cap. If the main loop was throttled (background, low fps), deficit
-                        // can be large. ReadAudioAhead returns quickly if m_audioPending
-                        // already has enough samples.
-                        m_decoder.ReadAudioAhead(deficit);
-
-                        // Drain and submit in chunks until the deficit is satisfied.
-                        // A single 16384-sample drain can't cover a large deficit on its own
-                        // (e.g., after a 1 fps background stall draining 48000 samples).
-                        int remaining = deficit;
-                        while (remaining > 0) {
-                            int got = m_decoder.DrainAudioSamples(
-                                          audioBuf, std::min(remaining, kAudioBuf));
-                            if (got <= 0) break;
-                            m_audioAnalyzer.FeedSamples(audioBuf, got, 1, rate);
-                            m_audioPlayer.Submit(audioBuf, got, rate);
-                            remaining -= got;
-                        }
-                    }
+double Application::GetTickInterval() {
+    const AppConfig& cfg = m_configManager.GetConfig();
+    if (m_exporting) return 0.0;  // As fast as the encoder allows
+    if (m_benchmark || m_sessionReplaying) return 0.0;
+    const auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - m_refreshQueryTime).count() >= REFRESH_QUERY_INTERVAL) {
+        m_refreshQueryTime = now;
+        m_outputRefreshHz  = MonitorRefreshHz(m_videoOutputWindow.IsOpen() ? m_videoOutputWindow.GetHwnd() : m_hwnd);
+        SYSTEM_POWER_STATUS power = {};
+        m_onBattery = GetSystemPowerStatus(&power) && power.ACLineStatus == 0;
+    }
 
-                    // ReadAudioAhead hit audio EOF before filling the target. Loop audio
-                    // immediately rather than waiting for video EOF (which is ~2 seconds
-                    // later due to the video packet queue). Without this, the ring buffer
-                    // drains silently for ~2 seconds before the video loop trigger fires.
-                    // SeekToTime resets both audio and video to position 0; we then
-                    // immediately refill the ring from position 0 WITHOUT flushing, so
-                    // any remaining audio in the ring plays through before new audio follows.
-                    if (m_decoder.AudioEOFReached()) {
-                        m_decoder.SeekToTime(0.0);   // clears m_audioEOFReached via FlushDecoder
-                        m_audioAnalyzer.Reset();
-                        int remaining = targetFill;
-                        m_decoder.ReadAudioAhead(remaining);
-                        while (remaining > 0) {
-                            int got = m_decoder.DrainAudioSamples(
-                                          audioBuf, std::min(remaining, kAudioBuf));
-                            if (got <= 0) break;
-                            m_audioAnalyzer.FeedSamples(audioBuf, got, 1, rate);
-                            m_audioPlayer.Submit(audioBuf, got, rate);
-                            remaining -= got;
-                        }
-                    }
-                }
-            }
-        } else {
-            // Generative mode: advance time by wall-clock delta; cap to avoid jumps after
-            // long pauses or window moves that stall the loop.
-            const float dt = static_cast<float>(std::min(elapsed, 0.1));
-            m_generativeTime += dt;
-            m_playbackTime = m_generativeTime;
-            m_newVideoFrame = true;
-            m_lastFrameTime = now;
-        }
+    double interval = 0.0;
+    if (cfg.frameRateCap > 0) {
+        interval = 1.0 / cfg.frameRateCap;
+    } else if ((cfg.uiRefreshHz > 0 || m_renderPolicy == RenderPolicy::OutputsOnly) && m_outputRefreshHz > 0) {
+        // The UI doesn't present every tick (throttled, or not drawn at all), so
+        // nothing would hold the loop back: pace it by the monitor the output is watched on
+        interval = 1.0 / m_outputRefreshHz;
     }
+    // On battery the cap only ever slows the loop further
+    if (m_onBattery && cfg.batteryFrameRateCap > 0) interval = std::max(interval, 1.0 / cfg.batteryFrameRateCap);
+    return interval;
 }
 
-/*static*/ void Application::PackParamValues(const ShaderPreset& preset, float out[16]) {
-    std::fill(out, out + 16, 0.0f);
-    for (const auto& p : preset.params) {
-        if (p.type == ShaderParamType::AudioBand) continue;  // Lives in b1, not custom[]
-        const int off = p.cbufferOffset;
-        switch (p.type) {
-        case ShaderParamType::Float:
-        case ShaderParamType::Bool:
-        case ShaderParamType::Long:
-        case ShaderParamType::Event:
-            if (off < 16)       out[off] = p.values[0];
-            break;
-        case ShaderParamType::Point2D:
-            if (off + 1 < 16) { out[off] = p.values[0]; out[off + 1] = p.values[1]; }
-            break;
-        case ShaderParamType::Color:
-            if (off + 3 < 16) {
-                out[off] = p.values[0]; out[off + 1] = p.values[1];
-                out[off + 2] = p.values[2]; out[off + 3] = p.values[3];
+void Application::WaitForTickDeadline() {
+    using Clock = std::chrono::steady_clock;
+    const double interval = GetTickInterval();
+    if (interval <= 0.0 || !m_tickTimer) {
+        m_nextTickTime = {};
+        return;
+    }
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+    Clock::time_point now = Clock::now();
+    if (m_nextTickTime > now) {
+        const double remaining = std::chrono::duration<double>(m_nextTickTime - now).count();
+        if (remaining > TICK_SPIN_SECONDS) {
+            LARGE_INTEGER due;
+            due.QuadPart = -static_cast<LONGLONG>((remaining - TICK_SPIN_SECONDS) * 1e7);  // Relative, 100 ns
+            if (SetWaitableTimer(m_tickTimer, &due, 0, nullptr, nullptr, FALSE)) {
+                WaitForSingleObject(m_tickTimer, INFINITE);
             }
-            break;
         }
+        while (Clock::now() < m_nextTickTime) std::this_thread::yield();
+        now = Clock::now();
     }
+    // On schedule: the next deadline is one period on, so sleep jitter doesn't
+    // accumulate. After a hitch (or a cap change) restart from now instead of
+    // bursting to catch up.
+    m_nextTickTime = (m_nextTickTime != Clock::time_point{} && now - m_nextTickTime < period)
+                         ? m_nextTickTime + period : now + period;
 }
 
-void Application::OnParamChanged() {
-    ShaderPreset* preset = m_shaderManager->GetActivePreset();
-    if (!preset) return;
+void Application::BeginModalLoop() {
+    if (m_modalLoopDepth++ == 0) SetTimer(m_hwnd, MODAL_TICK_TIMER, USER_TIMER_MINIMUM, nullptr);
+}
 
-    float packed[16] = {};
-    PackParamValues(*preset, packed);
-    m_renderer.SetCustomUniforms(packed, 16);
+void Application::EndModalLoop() {
+    if (m_modalLoopDepth == 0) return;
+    if (--m_modalLoopDepth == 0) KillTimer(m_hwnd, MODAL_TICK_TIMER);
+}
 
-    for (const auto& p : preset->params) {
-        if (p.type == ShaderParamType::Event && p.values[0] > 0.5f) {
-            m_eventResetPending = true;
-            break;
-        }
-    }
+void Application::ModalTick() {
+    // The loop's own timer messages can arrive while a tick is dispatching
+    if (m_inModalTick || m_exitRequested) return;
+    m_inModalTick = true;
+    ProcessFrame();
+    if (m_renderPolicy != RenderPolicy::Hidden) RenderFrame();
+    // A dialog opened from the UI returns into an ImGui frame that draws to the
+    // back buffer: put back the state the outputs changed
+    if (m_uiFrameOpen) m_renderer.BeginFrame();
+    m_inModalTick = false;
 }
 
-void Application::EvaluateKeyframes() {
-    ShaderPreset* preset = m_shaderManager->GetActivePreset();
-    if (!preset) return;
+bool Application::IsUiRefreshDue(std::chrono::steady_clock::time_point now) const {
+    double interval = 0.0;
+    if (m_exporting) {
+        interval = EXPORT_UI_INTERVAL;
+    } else if (m_configManager.GetConfig().uiRefreshHz > 0) {
+        interval = 1.0 / m_configManager.GetConfig().uiRefreshHz;
+    }
+    // Some slack, so tick jitter doesn't push a due redraw to the tick after
+    return std::chrono::duration<double>(now - m_uiPresentTime).count() >= interval * UI_REFRESH_SLACK;
+}
 
-    bool anyChanged = false;
-
-    for (auto& p : preset->params) {
-        if (!p.timeline || !p.timeline->enabled) continue;
-
-        int valueCount = 1;
-        if (p.type == ShaderParamType::Point2D) valueCount = 2;
-        else if (p.type == ShaderParamType::Color) valueCount = 4;
-
-        // For Bool/Long: step interpolation (snap to nearest keyframe, no lerp).
-        // Evaluate still returns lerped values; we snap afterwards.
-        float interpolated[4] = {};
-        if (p.timeline->Evaluate(m_playbackTime, interpolated, valueCount)) {
-            bool changed = false;
-            for (int i = 0; i < valueCount; ++i) {
-                float val = interpolated[i];
-                // Step types: snap to 0 or 1 (bool) or round to int (long)
-                if (p.type == ShaderParamType::Bool)
-                    val = (val >= 0.5f) ? 1.0f : 0.0f;
-                else if (p.type == ShaderParamType::Long)
-                    val = std::round(val);
-
-                if (p.values[i] != val) {
-                    p.values[i] = val;
-                    changed = true;
-                }
-            }
-            if (changed) anyChanged = true;
-        }
+void Application::ProcessFrame() {
+    if (m_watchdog.IsRunning()) {
+        m_watchdog.Beat(!m_exporting && !m_benchmark && !m_sessionReplaying);
+        ApplyWatchdog();
     }
 
-    if (anyChanged) OnParamChanged();
-}
+    auto now = PlaybackNow();
+    double elapsed = std::chrono::duration<double>(now - m_lastFrameTime).count();
 
-void Application::RenderFrame() {
-    // Upload current video frame
-    if (!m_currentFrame.data[0].empty()) {
-        m_renderer.UploadVideoFrame(m_currentFrame);
+    // Tick period, smoothed: half of it is how early a frame may be selected
+    if (m_prevTickTime != std::chrono::steady_clock::time_point{}) {
+        const double tick = std::chrono::duration<double>(now - m_prevTickTime).count();
+        m_tickSeconds += (std::clamp(tick, MIN_TICK_SECONDS, MAX_TICK_SECONDS) - m_tickSeconds) * TICK_SMOOTHING;
     }
+    m_prevTickTime = now;
 
-    // Set shader uniforms
-    m_renderer.SetShaderTime(m_playbackTime);
+    m_newVideoFrame = false;
 
-    // Evaluate keyframe animations at current playback time
-    EvaluateKeyframes();
+    // An async open finished probing: hand the file to the decoder
+    if (m_mediaProbe.IsDone()) {
+        SP_CPU_SCOPE(m_cpuProfiler, Decode);
+        FinishOpenVideo(m_mediaProbe);
+    }
 
-    // Push active preset's blend settings so the compositor shader has current values.
-    // Only meaningful when a generative shader is active and video is loaded; harmless otherwise.
-    {
-        const int activeIdx = m_shaderManager->GetActivePresetIndex();
-        if (activeIdx >= 0) {
-            const auto& preset = m_shaderManager->GetPresets()[activeIdx];
-            m_renderer.SetVideoBlend(preset.blendMode, preset.blendAmount);
-        } else {
-            m_renderer.SetVideoBlend(0, 0.0f);
+    // An edit proxy finished: switch the open file over at the next pause
+    if (m_proxyTranscoder.IsDone()) {
+        const std::string source = m_proxyTranscoder.GetSourcePath();
+        if (m_proxyTranscoder.Take()) {
+            m_uiManager->ShowNotification("Edit proxy ready: " + std::filesystem::path(source).filename().string());
+            m_editProxyReady = (source == m_videoPath);
         }
     }
-
-    // Push latest audio analysis to GPU (b1 cbuffer + t3 spectrum texture).
-    if (m_decoder.HasAudio()) {
-        m_audioAnalyzer.GetData(m_audioData);
-        m_renderer.SetAudioData(&m_audioData);
-    } else {
-        m_renderer.SetAudioData(nullptr);
+    if (m_editProxyReady && m_playbackState != PlaybackState::Playing && !m_mediaProbe.IsActive()) {
+        m_editProxyReady = false;
+        ApplyProxySettings();
     }
 
-    // Set up D3D11 pipeline and clear backbuffer to black
-    m_renderer.BeginFrame();
-    // Render video+shader to the display texture; ImGui::Image picks it up from there
-    m_renderer.RenderToDisplay();
-
-    // Blit processed output to the detached video window (if open)
-    if (m_videoOutputWindow.IsOpen())
-        m_videoOutputWindow.BlitAndPresent(m_renderer);
+    // Check for shader file changes. Not from inside a modal loop: the code that
+    // opened it may hold on to a preset a reload would replace.
+    if (!m_inModalTick) {
+        SP_CPU_SCOPE(m_cpuProfiler, ShaderWatch);
+        // The library read at startup; the active preset's values go up with it
+        if (m_shaderManager->FinishLibraryLoad(false)) OnParamChanged();
+        FinishStartupTasks(false);
+        m_shaderManager->PollCompiles();
+        CheckEditorCompile();
+        m_shaderManager->CheckForChanges();
+    }
 
-    // Share processed frame via Spout (GPU texture copy; does not block the pipeline)
-    m_spoutOutput.SendFrame(m_renderer.GetDisplayTexture());
+    // Debounced SaveConfig; not while the library is still loading, which the write would wait for
+    if (m_configSavePending && std::chrono::steady_clock::now() >= m_configSaveDue &&
+        !m_shaderManager->IsLoadingLibrary()) {
+        WriteConfig();
+    }
+    if (m_metrics.IsRunning()) PublishMetrics();
 
-    // Capture recording frame here, BEFORE ImGui renders. ImGui overwrites all D3D11
-    // pipeline state (VS, PS, CBs, SRVs), so RenderToTexture must run while the video
-    // pipeline state set by BeginFrame() is still active. Only capture on new video
-    // frames to match the encoder's configured framerate.
-    if (m_encoder.IsRecording() && m_newVideoFrame) {
-        if (m_renderer.RenderToTexture()) {
-            std::vector<uint8_t> frameData;
-            int width, height;
-            if (m_renderer.CopyRenderTargetToStaging(frameData, width, height)) {
-                m_encoder.SubmitFrame(frameData, width, height);
-            }
+    // Spout input: a GPU copy of the sender's newest frame, bound at t0
+    if (m_spoutInput.IsOpen() && m_spoutInput.Receive()) {
+        m_renderer.SetExternalVideo(m_spoutInput.GetSRV(), m_spoutInput.GetWidth(), m_spoutInput.GetHeight());
+        m_newVideoFrame = true;
+    }
+    // NDI input: the receive thread's newest frame, uploaded here
+    if (m_ndiInput.IsOpen() && m_ndiInput.Receive()) {
+        m_renderer.SetExternalVideo(m_ndiInput.GetSRV(), m_ndiInput.GetWidth(), m_ndiInput.GetHeight());
+        m_newVideoFrame = true;
+    }
+    // Media Foundation capture: a GPU copy of the reader's newest sample
+    if (m_mfCapture.IsOpen()) {
+        if (m_mfCapture.Receive()) {
+            m_renderer.SetExternalVideo(m_mfCapture.GetSRV(), m_mfCapture.GetWidth(), m_mfCapture.GetHeight());
+            m_newVideoFrame = true;
+        } else if (m_mfCapture.HasFailed()) {
+            m_uiManager->ShowNotification("Capture device lost: " + m_mfCapture.GetDeviceName());
+            CloseMfCapture();
         }
-        // RenderToTexture changes the active RT and viewport; restore before ImGui
-        m_renderer.BeginFrame();
+    }
+    // Still image: uploaded once when its decode finishes
+    PollStillImage();
+
+    // The decode thread dropped D3D11VA after a hardware error and carried on in software
+    if (const int fallbacks = m_decoder.GetHardwareFallbacks(); fallbacks != m_seenHwFallbacks) {
+        m_seenHwFallbacks = fallbacks;
+        char error[AV_ERROR_MAX_STRING_SIZE] = {};
+        av_make_error_string(error, sizeof(error), m_decoder.GetHardwareFallbackError());
+        m_uiManager->ShowNotification("Hardware decode failed (" + std::string(error) + "), continuing in software");
     }
 
-    // Render UI
-    m_uiManager->BeginFrame();
-    m_uiManager->Render();
-    m_uiManager->EndFrame();
+    // Timeline drag: the exact frame once the mouse rests
+    if (m_scrubRefineDue || m_scrubRefining) {
+        SP_CPU_SCOPE(m_cpuProfiler, Decode);
+        StepScrub();
+    }
 
-    // Reset event params after they have been visible for one frame
-    if (m_eventResetPending) {
-        m_eventResetPending = false;
-        ShaderPreset* preset = m_shaderManager->GetActivePreset();
-        if (preset) {
-            for (auto& p : preset->params) {
-                if (p.type == ShaderParamType::Event)
-                    p.values[0] = 0.0f;
+    if (m_frameSync.GetRole() == FrameSync::Role::Follower) UpdateFrameSync(now);
+
+    // Render-ahead runs while it applies; anything else hands the playhead back to the decoder
+    m_renderingAhead = RenderAheadApplies();
+    if (!m_renderingAhead) StopRenderAhead();
+
+    // Frames from the worker's ring; audio is topped up after, timed on its own
+    bool feedAudio = false;
+    {
+        SP_CPU_SCOPE(m_cpuProfiler, Decode);
+        if (m_exporting) {
+            StepExport();
+        } else if (m_playbackState == PlaybackState::Playing) {
+            if (m_decoder.IsOpen()) {
+                if (m_decoder.IsLiveCapture()) {
+                    // Live capture: the worker drains the source continuously; take the
+                    // newest frame if one arrived since the last tick, otherwise keep the
+                    // last one on screen. Time advances by wall clock.
+                    const float dt = static_cast<float>(std::min(elapsed, 0.1));
+                    m_generativeTime += dt;
+                    m_playbackTime = m_generativeTime;
+                    m_lastFrameTime = now;
+
+                    if (m_decodeWorker.PopFrame(m_currentFrame)) {
+                        m_newVideoFrame = true;
+                        m_liveLatencyPending = true;
+                    }
+                } else if (m_loopReplaying) {
+                    // Loop region from VRAM: no decoder work at all
+                    StepLoopReplay(now);
+                    feedAudio = true;
+                } else if (m_renderingAhead) {
+                    // Finished frames from the render-ahead queue; RenderFrame refills it
+                    StepRenderAhead(now);
+                    feedAudio = true;
+                } else {
+                    // Video file mode: advance playback time from decoded frame timestamps.
+                    // Frames come pre-decoded from the DecodeWorker ring; this thread only pops.
+                    // Audio-master sync pops whatever the clock says is due (dropping late
+                    // frames); frame-paced pops one frame per frame interval.
+                    // Both select the frame whose due time is nearest this tick
+                    // rather than the first tick past it. Frame-paced deadlines
+                    // advance by exactly one interval, so rounding to ticks never
+                    // accumulates into a rate below the source's.
+                    const bool synced = !m_playingBackward &&
+                                        (m_configManager.GetConfig().syncMode == SYNC_MODE_AUDIO_MASTER ||
+                                         m_frameSyncLocked);
+                    // The worker wraps ahead of the playhead, so a loop plays on without a restart
+                    m_decodeWorker.SetLooping(m_playDirection == PlaybackDirection::Forward && !PlaylistAdvances());
+                    const double interval = m_frameDuration / m_playbackRate;
+                    ++m_cadenceTicks;
+                    const double before = m_playbackTime;
+                    if (synced || elapsed + 0.5 * m_tickSeconds >= interval) {
+                        if (synced ? PopSyncedFrame(now) : m_decodeWorker.PopFrame(m_currentFrame)) {
+                            m_newVideoFrame = true;
+                            m_cacheCurrentFrame = true;
+                            m_playbackTime = static_cast<float>(m_currentFrame.timestamp);
+                            if (m_decodeWorker.PoppedLoopStart()) OnPlaybackLooped();
+                            if (PassedLoopOut(before)) WrapLoopRegion(now);
+                            if (synced) {
+                                m_lastFrameTime = now;
+                            } else {
+                                // On schedule: the deadline moves on by one interval. After
+                                // an underrun or a hitch restart from now instead of bursting.
+                                const double late = elapsed - interval;
+                                RecordCadence(late);
+                                m_lastFrameTime = (late < interval)
+                                    ? m_lastFrameTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                            std::chrono::duration<double>(interval))
+                                    : now;
+                            }
+                        } else if (m_decodeWorker.IsEndOfStream()) {
+                            if (m_playDirection == PlaybackDirection::PingPong) {
+                                // Bounce: continue from the frame on screen the other way
+                                RestartDecodeWorker(!m_playingBackward);
+                            } else if (m_playingBackward) {
+                                // Reverse reached the first frame: loop from the end
+                                m_decodeWorker.StartReverse(m_decoder.GetTotalFrames(), ReverseBudgetBytes());
+                                ResetAudioAnalysis();
+                            } else if (PlaylistAdvances()) {
+                                PlayPlaylistItem((m_playlistIndex + 1) %
+                                                 static_cast<int>(m_configManager.GetConfig().playlist.size()));
+                            } else {
+                                // End of video with the worker not looping (its wrap failed): loop here
+                                {
+                                    auto lock = m_decodeWorker.LockDecoder();
+                                    m_decoder.SeekToTime(0.0);
+                                    m_decodeWorker.DiscardQueued();
+                                }
+                                ResyncLoopedAudio(0.0);
+                            }
+                            m_lastFrameTime = now;
+                            ResetSync();
+                        }
+                        // Otherwise an underrun: keep the last frame and retry next tick
+                        // without resetting the frame clock.
+                    }
+
+                    // No audio while reversing — the worker flushed the player on entry
+                    feedAudio = !m_playingBackward;
+                }
+            } else {
+                // Generative mode: advance time by wall-clock delta; cap to avoid jumps after
+                // long pauses or window moves that stall the loop.
+                // A frame-sync follower runs on the master's time instead.
+                const float dt = static_cast<float>(std::min(elapsed, 0.1));
+                m_generativeTime = m_frameSyncLocked ? static_cast<float>(m_frameSyncClock) : m_generativeTime + dt;
+                m_playbackTime = m_generativeTime;
+                m_newVideoFrame = true;
+                m_lastFrameTime = now;
             }
-            float packed[16] = {};
-            PackParamValues(*preset, packed);
-            m_renderer.SetCustomUniforms(packed, 16);
         }
     }
+    if (m_frameSync.GetRole() == FrameSync::Role::Master && !m_exporting && !m_sessionReplaying) PublishFrameSync();
+    if (feedAudio) {
+        SP_CPU_SCOPE(m_cpuProfiler, Audio);
+        UpdateDecodeSkip();
+        FeedAudio();
+        AnalyzeHeardAudio();
+    }
 
-    // Present
-    m_renderer.Present(true);
-}
+    PreopenPlaylistNext();
 
-bool Application::OpenVideo(const std::string& filepath) {
-    // Reset prior state before opening — mirrors OpenCapture and prevents stale audio,
-    // playback time, and renderer video dimensions when replacing an already-open video.
-    m_playbackState  = PlaybackState::Stopped;
-    m_playbackTime   = 0.0f;
-    m_generativeTime = 0.0f;
-    m_currentFrame   = VideoFrame{};
-    m_audioAnalyzer.Reset();
-    m_audioPlayer.Flush();
-    m_renderer.ReleaseVideoTexture();
+    SP_CPU_SCOPE(m_cpuProfiler, Inputs);
+    SyncVideoInputs();
+}
 
-    if (!m_decoder.Open(filepath)) {
-        m_uiManager->ShowNotification("Failed to open video: " + filepath);
-        return false;
+void Application::OnPlaybackLooped() {
+    // The region's out point was the clip's end: the wrap lands on the in point
+    // instead, or replays from VRAM
+    if (HasLoopRegion() && (m_loopIn > 0.0 || m_renderer.GetLoopCache().IsComplete())) {
+        WrapLoopRegion(PlaybackNow());
+        return;
     }
+    ResyncLoopedAudio(0.0);
+    m_cadenceTicks = -1;  // The wrap isn't part of the cadence
+}
 
-    m_frameDuration = 1.0 / m_decoder.GetFPS();
-    m_configManager.GetConfig().lastOpenedVideo = filepath;
+void Application::SetLoopIn() {
+    if (!m_decoder.IsOpen() || m_decoder.IsLiveCapture()) return;
+    m_loopIn = m_decoder.SnapToFrameTime(m_playbackTime);
+    if (m_loopOut <= m_loopIn) m_loopOut = 0.0;  // Out before in: set it again
+    ArmLoopCache();
+}
 
-    // Decode first frame
-    m_decoder.DecodeNextFrame(m_currentFrame);
-    m_playbackState = PlaybackState::Paused;
+void Application::SetLoopOut() {
+    if (!m_decoder.IsOpen() || m_decoder.IsLiveCapture()) return;
+    const double out = m_decoder.SnapToFrameTime(m_playbackTime);
+    if (out <= m_loopIn) {
+        m_uiManager->ShowNotification("Loop out must be after loop in");
+        return;
+    }
+    m_loopOut = out;
+    ArmLoopCache();
+}
 
-    m_uiManager->ShowNotification("Opened: " + std::filesystem::path(filepath).filename().string());
-    return true;
+void Application::ClearLoopRegion() {
+    m_loopIn  = 0.0;
+    m_loopOut = 0.0;
+    ArmLoopCache();
 }
 
-void Application::CloseVideo() {
-    Stop();
-    m_audioPlayer.Flush();
-    m_decoder.Close();
-    m_currentFrame = VideoFrame{};
-    m_audioAnalyzer.Reset();
-    // Reset renderer video dimensions so RenderToTexture/RenderToDisplay fall back
-    // to generative resolution. Without this, the stale m_videoWidth/Height causes
-    // the render target to be sized at the old video resolution, producing a tiny
-    // squished image in the top-left of the recording frame with green fill elsewhere.
-    m_renderer.ReleaseVideoTexture();
+void Application::SetLoopCacheBudget(int megabytes) {
+    m_configManager.GetConfig().loopCacheMB = megabytes;
+    ArmLoopCache();
 }
 
-void Application::OpenVideoDialog() {
-    char filepath[MAX_PATH] = {};
+void Application::ArmLoopCache() {
+    StopLoopReplay();
+    m_audioReader.SetLoopRegion(m_loopIn, m_loopOut);
+    if (!HasLoopRegion() || !m_decoder.IsOpen()) {
+        m_renderer.GetLoopCache().Clear();
+        return;
+    }
+    // Frames [in, out): the out frame itself is where playback wraps
+    const int64_t first = FrameKey(m_loopIn);
+    // Under memory pressure a zero budget leaves the region uncached
+    const int budgetMB = m_memoryPressure ? 0 : m_configManager.GetConfig().loopCacheMB;
+    m_renderer.GetLoopCache().Reset(first, FrameKey(m_loopOut) - first, budgetMB);
+}
 
-    OPENFILENAMEA ofn = {};
-    ofn.lStructSize = sizeof(ofn);
-    ofn.hwndOwner = m_hwnd;
-    ofn.lpstrFilter = "Video Files\0*.mp4;*.mov;*.avi;*.mkv;*.webm;*.mxf\0All Files\0*.*\0";
-    ofn.lpstrFile = filepath;
-    ofn.nMaxFile = MAX_PATH;
-    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+bool Application::PassedLoopOut(double before) const {
+    const double out = m_loopOut - 0.5 * m_frameDuration;
+    return HasLoopRegion() && !m_playingBackward && before < out && m_currentFrame.timestamp >= out;
+}
 
-    if (GetOpenFileNameA(&ofn)) {
-        OpenVideo(filepath);
+void Application::WrapLoopRegion(std::chrono::steady_clock::time_point now) {
+    if (m_renderer.GetLoopCache().IsComplete()) {
+        StartLoopReplay(now);
+        return;
     }
+    // Not all cached yet: decode this pass too, caching what was missed. The
+    // audio reader wrapped at the out point itself.
+    ResyncLoopedAudio(m_loopIn);
+    SeekDecoder(m_loopIn, false);
+    m_playbackTime  = static_cast<float>(m_currentFrame.timestamp);
+    m_newVideoFrame = true;
 }
 
-bool Application::OpenCapture(const std::string& deviceOrUrl, bool isDshow) {
-    Stop();
-    m_generativeTime = 0.0f;
+void Application::StartLoopReplay(std::chrono::steady_clock::time_point now) {
+    // The worker stops by itself once its ring is full; the decoder stays where
+    // it is until StopLoopReplay seeks it to the playhead
+    m_loopReplaying  = true;
+    m_loopAnchorTime = m_loopIn;
+    m_loopAnchorWall = now;
+    m_loopReplayKey  = -1;
+    m_cadenceTicks   = -1;
+    ResyncLoopedAudio(m_loopIn);
+    StepLoopReplay(now);
+}
 
-    if (!m_decoder.OpenCapture(deviceOrUrl, isDshow)) {
-        m_uiManager->ShowNotification("Failed to open capture: " + deviceOrUrl);
-        return false;
+void Application::StepLoopReplay(std::chrono::steady_clock::time_point now) {
+    double t = m_loopAnchorTime + std::chrono::duration<double>(now - m_loopAnchorWall).count() * m_playbackRate;
+    if (t >= m_loopOut) {
+        // Around again on the replay clock, audio with it
+        t = m_loopIn + std::fmod(t - m_loopIn, m_loopOut - m_loopIn);
+        m_loopAnchorTime = t;
+        m_loopAnchorWall = now;
+        ResyncLoopedAudio(t);
     }
 
-    m_frameDuration = 1.0 / m_decoder.GetFPS();
-    m_playbackState = PlaybackState::Playing;
-    m_lastFrameTime = std::chrono::steady_clock::now();
-
-    m_uiManager->ShowNotification("Live: " + deviceOrUrl);
-    return true;
+    const double frameTime = m_decoder.SnapToFrameTime(t);
+    const int64_t key = FrameKey(frameTime);
+    if (key != m_loopReplayKey) {
+        if (!m_renderer.ShowCachedVideoFrame(key)) {
+            // The cache went (a size change): decode from here on
+            m_loopReplaying = false;
+            SeekDecoder(frameTime);
+            m_newVideoFrame = true;
+            return;
+        }
+        m_loopReplayKey = key;
+        m_newVideoFrame = true;
+    }
+    m_showingCachedFrame = true;
+    m_decoderSeekPending = true;
+    m_pendingSeekTime    = frameTime;
+    m_playbackTime       = static_cast<float>(t);
 }
 
-void Application::OpenCaptureDialog() {
-    m_uiManager->ShowCaptureDialog();
+void Application::StopLoopReplay() {
+    if (!m_loopReplaying) return;
+    m_loopReplaying = false;
+    FlushAudioOutput();
+    if (m_decoderSeekPending) SeekDecoder(m_pendingSeekTime);
 }
 
-void Application::Play() {
-    m_playbackState = PlaybackState::Playing;
-    m_lastFrameTime = std::chrono::steady_clock::now();
+void Application::SetRenderAheadFrames(int frames) {
+    StopRenderAhead();
+    m_configManager.GetConfig().renderAheadFrames = std::clamp(frames, 0, MAX_RENDER_AHEAD_FRAMES);
+    if (frames <= 0) m_renderer.GetRenderAhead().SetCapacity(0);  // Frees the textures
 }
 
-void Application::Pause() {
-    m_playbackState = PlaybackState::Paused;
-    m_audioPlayer.Flush();
+bool Application::RenderAheadApplies() const {
+    // Frames ahead are only known going forward through one file on the normal
+    // clock; a tapped pass would show the newest frame drawn, not the one on screen
+    return m_configManager.GetConfig().renderAheadFrames > 0 && m_playbackState == PlaybackState::Playing &&
+           m_decoder.IsOpen() && !m_decoder.IsLiveCapture() && m_playDirection == PlaybackDirection::Forward &&
+           !m_playingBackward && !HasLoopRegion() && !PlaylistAdvances() && !m_exporting && !m_benchmark &&
+           !m_tiledExport && !m_memoryPressure && !m_renderer.GetTapSRV() && !m_automation.IsRecording();
 }
 
-void Application::Stop() {
-    m_playbackState = PlaybackState::Stopped;
-    m_audioPlayer.Flush();
-    if (m_decoder.IsOpen()) {
-        m_decoder.SeekToTime(0.0);
-        m_decoder.DecodeNextFrame(m_currentFrame);
+void Application::StepRenderAhead(std::chrono::steady_clock::time_point now) {
+    RenderAheadQueue& queue = m_renderer.GetRenderAhead();
+    m_decodeWorker.SetLooping(true);
+    ++m_cadenceTicks;
+    if (queue.IsEmpty()) {
+        queue.SetCapacity(std::min(m_configManager.GetConfig().renderAheadFrames, MAX_RENDER_AHEAD_FRAMES));
+        // A scrub-cache seek left the decoder where it was: fill from the playhead
+        if (m_decoderSeekPending) SeekDecoder(m_pendingSeekTime);
+        return;  // FillRenderAhead shows the first frame it draws
     }
-    m_playbackTime = 0.0f;
-    m_generativeTime = 0.0f;
-}
 
-void Application::TogglePlayback() {
-    if (m_playbackState == PlaybackState::Playing) {
-        Pause();
+    // Just started or resynced: the clock runs from the frame on screen
+    if (!m_syncAnchored) {
+        m_syncAnchored   = true;
+        m_syncAnchorTime = queue.At(0).timestamp;
+        m_syncAnchorWall = now;
+        return;
+    }
+
+    // As PopSyncedFrame: the newest entry due by the middle of this tick, the
+    // ones before it dropped unseen. Frame paced runs on the wall clock alone and
+    // shows every entry.
+    const bool synced = m_configManager.GetConfig().syncMode == SYNC_MODE_AUDIO_MASTER || m_frameSyncLocked;
+    const double clock = synced ? SyncClock(now)
+                                : m_syncAnchorTime +
+                                      std::chrono::duration<double>(now - m_syncAnchorWall).count() * m_playbackRate;
+    const double due   = clock + 0.5 * m_tickSeconds * m_playbackRate;
+    bool presented = false;
+    bool looped    = false;
+    while (queue.GetSize() > 1) {
+        const RenderAheadQueue::Entry& next = queue.At(1);
+        if (next.loopStart) {
+            // The next pass follows the last frame of this one on its own schedule
+            if (presented || due < queue.At(0).timestamp + m_frameDuration) break;
+            queue.PopFront();
+            m_syncAnchorTime = queue.At(0).timestamp;
+            m_syncAnchorWall = now;
+            presented = looped = true;
+            break;
+        }
+        if (next.timestamp > due || (presented && !synced)) break;
+        if (presented) ++m_lateDrops;
+        queue.PopFront();
+        presented = true;
+    }
+    if (!presented) {
+        // A frame is due and none is ready: the queue ran dry
+        if (due >= queue.At(0).timestamp + m_frameDuration) ++m_renderAheadUnderruns;
+        return;
+    }
+    if (looped) {
+        OnPlaybackLooped();
     } else {
-        Play();
+        const double late = (clock - queue.At(0).timestamp) / m_playbackRate;
+        RecordCadence(late);
+        // Frame paced after a hitch: restart the schedule from now instead of bursting
+        if (!synced && late > m_frameDuration) {
+            m_syncAnchorTime = queue.At(0).timestamp;
+            m_syncAnchorWall = now;
+        }
     }
+    ShowRenderAheadFront();
+    m_lastFrameTime = now;
 }
 
-void Application::SeekTo(double seconds) {
-    if (m_decoder.IsOpen()) {
-        m_audioPlayer.Flush();
-        m_decoder.SeekToTime(seconds);
-        m_decoder.DecodeNextFrame(m_currentFrame);
-        m_playbackTime = static_cast<float>(seconds);
-        m_audioAnalyzer.Reset();
+void Application::ShowRenderAheadFront() {
+    const double shown = m_renderer.GetRenderAhead().At(0).timestamp;
+    m_playbackTime = static_cast<float>(shown);
+    // t0 and the display belong to the queue. The decoder is ahead of the
+    // playhead: Play() after a pause, or StopRenderAhead, seeks it back here.
+    m_showingCachedFrame = true;
+    m_decoderSeekPending = true;
+    m_pendingSeekTime    = shown;
+    m_newVideoFrame      = true;
+}
+
+void Application::PrepareFrameAt(double seconds) {
+    m_playbackTime = static_cast<float>(seconds);
+    m_renderer.SetShaderTime(m_playbackTime);
+    EvaluateKeyframes();
+    UpdateAudioData();
+    UpdateModulation();
+}
+
+void Application::FillRenderAhead() {
+    RenderAheadQueue& queue = m_renderer.GetRenderAhead();
+    const bool   wasEmpty  = queue.IsEmpty();
+    const double shownTime = m_playbackTime;
+    int renders = 0;
+
+    // Entries drawn before a param or shader change, in the order they are shown,
+    // again from their t0 copies
+    for (int i = 0; i < queue.GetSize() && renders < RENDER_AHEAD_PER_TICK; ++i) {
+        if (!queue.At(i).stale || !m_renderer.ShowRenderAheadSource(i)) continue;
+        PrepareFrameAt(queue.At(i).timestamp);
+        m_renderer.RenderToDisplay();
+        m_renderer.StoreRenderAhead(i);
+        ++renders;
+    }
+
+    // Then new frames from the decode worker, each at its own time. Under audio
+    // master one already past the clock is dropped undrawn (within a pass; a wrap
+    // restarts the times).
+    auto wraps = [&queue] {
+        for (int i = 0; i < queue.GetSize(); ++i) {
+            if (queue.At(i).loopStart) return true;
+        }
+        return false;
+    };
+    const bool synced = m_configManager.GetConfig().syncMode == SYNC_MODE_AUDIO_MASTER;
+    double next;
+    while (renders < RENDER_AHEAD_PER_TICK && !queue.IsFull() && m_decodeWorker.PeekNextTimestamp(next)) {
+        VideoFrame frame;
+        if (!m_decodeWorker.PopFrame(frame)) break;
+        const bool loopStart = m_decodeWorker.PoppedLoopStart();
+        if (synced && !queue.IsEmpty() && !loopStart && m_syncAnchored && !wraps() &&
+            frame.timestamp + m_frameDuration <= SyncClock(PlaybackNow())) {
+            ++m_lateDrops;
+            continue;
+        }
+        if (!m_renderer.UploadVideoFrame(frame)) continue;
+        m_renderer.CacheVideoFrame(FrameKey(frame.timestamp));
+        PrepareFrameAt(frame.timestamp);
+        m_renderer.RenderToDisplay();
+        ++renders;
+        if (!m_renderer.PushRenderAhead(frame.timestamp, loopStart)) {
+            // No VRAM for the queue: play on without it from the frame on screen
+            m_uiManager->ShowNotification("Render-ahead turned off: not enough video memory");
+            m_configManager.GetConfig().renderAheadFrames = 0;
+            m_playbackTime = static_cast<float>(shownTime);
+            StopRenderAhead();
+            m_renderer.GetRenderAhead().SetCapacity(0);
+            return;
+        }
+    }
+
+    // The first frame drawn goes on screen at once. The params, clock and audio
+    // data go back to the frame on screen for the UI and what follows.
+    if (wasEmpty && !queue.IsEmpty()) {
+        ShowRenderAheadFront();
+        PrepareFrameAt(m_playbackTime);
+    } else if (renders > 0) {
+        PrepareFrameAt(shownTime);
     }
+    // The display texture was drawn over, or the front changed
+    if (renders > 0 || m_newVideoFrame) m_renderer.PresentRenderAhead();
 }
 
-void Application::SetAudioVolume(float vol) {
-    m_configManager.GetConfig().audioVolume = vol;
-    m_audioPlayer.SetVolume(vol);
+void Application::StopRenderAhead() {
+    RenderAheadQueue& queue = m_renderer.GetRenderAhead();
+    if (queue.IsEmpty()) return;
+    // t0 goes back to the frame on screen. The decoder, ahead by what was queued,
+    // seeks back to it now while playing, or at Play() after a pause.
+    m_renderer.ShowRenderAheadSource(0);
+    queue.Clear();
+    if (m_playbackState == PlaybackState::Playing && m_decoderSeekPending) SeekDecoder(m_pendingSeekTime);
 }
 
-void Application::SetAudioMute(bool mute) {
-    m_configManager.GetConfig().muteAudio = mute;
-    m_audioPlayer.SetMute(mute);
+void Application::ResyncLoopedAudio(double target) {
+    // The audio reader wrapped on its own at audio EOF or the region's out point,
+    // so the looped audio is already queued and plays without a gap, and the
+    // live analyser goes on hearing one continuous stream. Resync only if the
+    // audible position has drifted from the target (or is unknown, -1). Within
+    // a region the distance is taken around the loop: just before the out point
+    // is just before the in point too.
+    if (!m_audioReader.IsOpen()) return;
+    const double audible = AudibleAudioTime();
+    double drift = audible - target;
+    if (HasLoopRegion() && audible >= 0.0) drift = std::remainder(drift, m_loopOut - m_loopIn);
+    if (audible < 0.0 || std::abs(drift) > AUDIO_RESYNC_SECONDS) {
+        FlushAudioOutput();
+        m_audioReader.Seek(target);
+        ResetAudioAnalysis();
+    }
 }
 
-bool Application::CompileCurrentShader(const std::string& source) {
-    int activeIndex = m_shaderManager->GetActivePresetIndex();
-    auto* preset = m_shaderManager->GetActivePreset();
-    if (preset) {
-        // Update source in the stored preset, then recompile via index so the
-        // compiled ID3D11PixelShader is reliably written into m_compiledShaders.
-        preset->source = source;
-        if (m_shaderManager->RecompilePreset(activeIndex)) {
-            m_shaderManager->SetActivePreset(activeIndex);
-            m_uiManager->ResetKeyframeSelection();
-            OnParamChanged();
-            m_uiManager->ShowNotification("Shader compiled successfully");
-            return true;
+void Application::UpdateLayers() {
+    std::vector<D3D11Renderer::Layer> layers;
+    for (const CompositeLayer& config : m_configManager.GetConfig().layers) {
+        if (!config.enabled) continue;
+        D3D11Renderer::Layer layer;
+        if (config.source == LAYER_SOURCE_PRESET) {
+            if (!m_shaderManager->GetLayer(config.preset, layer)) continue;  // Compiling, or not single-pass
         } else {
-            m_uiManager->ShowNotification("Shader compilation failed: " +
-                (preset->compileError.empty() ? "unknown error" : preset->compileError.substr(0, 80)));
-            return false;
+            layer.input = config.input;
         }
-    } else {
-        // No active preset — compile the editor content into a new preset.
-        ShaderPreset newPreset;
-        newPreset.name = "Untitled";
-        newPreset.source = source;
-        // AddPreset compiles and stores the shader; no double-compile needed.
-        int idx = m_shaderManager->AddPreset(newPreset);
-        auto* added = m_shaderManager->GetPreset(idx);
-        if (added && added->isValid) {
-            m_shaderManager->SetActivePreset(idx);
-            m_uiManager->ResetKeyframeSelection();
-            OnParamChanged();
-            m_uiManager->ShowNotification("Shader compiled successfully");
-            return true;
+        layer.blendMode = config.blendMode;
+        layer.opacity   = config.opacity;
+        layer.mask      = config.mask;
+        layers.push_back(std::move(layer));
+    }
+
+    // Deck B on top. At the A end it is left out, so it costs nothing, but its
+    // shader is drawn once and the compositor with it compiled ahead of the fade.
+    D3D11Renderer::Layer deck;
+    if (BuildDeckLayer(deck)) {
+        if (m_deckPrewarmed != deck.shader.Get()) {
+            m_renderer.PrewarmPixelShader(deck.shader.Get(), PassFormat::RGBA8);
+            m_deckPrewarmed = deck.shader.Get();
+        }
+        if (m_crossfader > 0.0f) {
+            layers.push_back(std::move(deck));
         } else {
-            m_shaderManager->RemovePreset(idx);
-            m_uiManager->ShowNotification("Shader compilation failed");
-            return false;
+            std::vector<D3D11Renderer::Layer> withDeck = layers;
+            withDeck.push_back(std::move(deck));
+            m_renderer.PrewarmLayers(std::move(withDeck));
         }
     }
+    m_renderer.SetLayers(std::move(layers));
 }
 
-bool Application::SaveCurrentShader(const std::string& source) {
-    auto* preset = m_shaderManager->GetActivePreset();
-    if (!preset) {
-        SaveShaderAsDialog(source);
-        return true;
+bool Application::BuildDeckLayer(D3D11Renderer::Layer& out) {
+    if (!m_deck.IsReady() || !m_renderer.GetDeckSRV()) return false;
+    const AppConfig& cfg = m_configManager.GetConfig();
+    if (cfg.deckPreset.empty()) {
+        out.shader      = m_renderer.GetPassthroughShader();
+        out.timeVarying = false;
+    } else if (!m_shaderManager->GetLayer(cfg.deckPreset, out)) {
+        return false;  // Compiling (queued by GetLayer if deferred), or not single-pass
     }
+    out.video       = m_renderer.GetDeckSRV();
+    out.videoWidth  = m_renderer.GetDeckWidth();
+    out.videoHeight = m_renderer.GetDeckHeight();
+    out.blendMode   = 1;  // Normal: the crossfader is the opacity
+    out.opacity     = m_crossfader;
+    out.transition  = cfg.deckTransition;
+    return true;
+}
 
-    preset->source = source;
+void Application::UpdateDeck() {
+    if (!m_deck.Poll()) {
+        m_uiManager->ShowNotification("Failed to cue deck B: " + m_deck.GetPath());
+        m_deck.Unload();
+        m_configManager.GetConfig().deckVideo.clear();
+        return;
+    }
+    if (!m_deck.IsReady()) return;
+    // Leaving the A end starts deck B from its cue point
+    if (m_crossfader > 0.0f && !m_deck.IsPlaying() && m_deck.GetTime() == 0.0) m_deck.SetPlaying(true);
+    m_deck.Update();
+    m_renderer.UploadDeckFrame(m_deck.GetFrame());  // No copy while the frame is unchanged
+}
 
-    if (!preset->filepath.empty()) {
-        std::ofstream file(preset->filepath);
-        if (file.is_open()) {
-            file << source;
-            m_uiManager->ShowNotification("Shader saved: " + preset->name);
-            return true;
+void Application::CueDeck(const std::string& filepath) {
+    // Split the cores like the extra inputs do
+    const AppConfig& cfg = m_configManager.GetConfig();
+    const int cores   = static_cast<int>(std::thread::hardware_concurrency());
+    const int threads = std::max(cores / (MAX_VIDEO_INPUTS + 1), 1);
+    m_deck.Cue(filepath, threads, cfg.proxyScale);
+    m_renderer.ReleaseDeckTexture();
+    m_configManager.GetConfig().deckVideo = filepath;
+}
+
+void Application::UnloadDeck() {
+    m_deck.Unload();
+    m_renderer.ReleaseDeckTexture();
+    m_configManager.GetConfig().deckVideo.clear();
+}
+
+void Application::UpdateChannels() {
+    auto& cfg = m_configManager.GetConfig();
+    const bool playing = m_playbackState == PlaybackState::Playing;
+    for (int i = 0; i < static_cast<int>(m_channels.size()); ++i) {
+        PlaybackChannel& channel = *m_channels[i];
+        ChannelConfig& config = cfg.channels[i];
+        if (!channel.Poll()) {
+            m_uiManager->ShowNotification("Failed to cue channel " + std::to_string(i + 2) + ": " + config.video);
+            channel.Unload();
+            config.video.clear();
+            SaveConfig();
+        }
+        channel.SetPlaying(playing);
+        // Closed with its own close button
+        if (config.output && !channel.GetOutput().IsOpen()) {
+            config.output = false;
+            SaveConfig();
         }
     }
+}
 
-    SaveShaderAsDialog(source);
-    return true;
+bool Application::OpenChannelOutput(int channel) {
+    // Channel 1 is the main player; the extras are numbered from 2
+    const std::wstring title = L"ShaderPlayer \u2014 Channel " + std::to_wstring(channel + 2);
+    return m_channels[channel]->OpenOutput(m_renderer.GetDevice(), m_renderer.GetContext(), title,
+                                           [this](bool entered) { if (entered) BeginModalLoop(); else EndModalLoop(); });
 }
 
-void Application::SaveShaderAsDialog(const std::string& source) {
+void Application::OpenCanvasOutputs() {
+    CloseCanvasOutputs();
+    const size_t count = m_configManager.GetConfig().canvasOutputs.size();
+    for (size_t i = 0; i < count; ++i) {
+        auto window = std::make_unique<VideoOutputWindow>();
+        window->SetModalLoopCallback([this](bool entered) { if (entered) BeginModalLoop(); else EndModalLoop(); });
+        if (window->Open(m_renderer.GetDevice(), m_renderer.GetContext())) {
+            const std::wstring title = L"ShaderPlayer \u2014 Canvas " + std::to_wstring(i + 1);
+            SetWindowTextW(window->GetHwnd(), title.c_str());
+        }
+        m_canvasWindows.push_back(std::move(window));
+    }
+}
+
+void Application::CloseCanvasOutputs() {
+    for (auto& window : m_canvasWindows) window->Close();
+    m_canvasWindows.clear();
+}
+
+void Application::UpdateCanvasOutputs() {
+    if (m_canvasWindows.empty()) return;
+    for (const auto& window : m_canvasWindows) {
+        if (window->IsOpen()) return;
+    }
+    m_canvasWindows.clear();
+    m_configManager.GetConfig().canvasEnabled = false;
+    SaveConfig();
+}
+
+void Application::SetCanvasEnabled(bool enabled) {
+    auto& cfg = m_configManager.GetConfig();
+    if (enabled && cfg.canvasOutputs.empty()) SetCanvasLayout(2, 0.0f);
+    cfg.canvasEnabled = enabled;
+    if (enabled) {
+        OpenCanvasOutputs();
+    } else {
+        CloseCanvasOutputs();
+    }
+    SaveConfig();
+}
+
+void Application::SetCanvasLayout(int count, float overlap) {
+    auto& cfg = m_configManager.GetConfig();
+    count   = std::clamp(count, 1, MAX_CANVAS_OUTPUTS);
+    overlap = std::clamp(overlap, 0.0f, 0.25f);
+    // `count` regions of one width, each starting `overlap` before the last ends,
+    // cover the canvas exactly; the overlaps are blended on both sides
+    const float width = (1.0f + static_cast<float>(count - 1) * overlap) / static_cast<float>(count);
+    std::vector<CanvasRegion> regions(count);
+    for (int i = 0; i < count; ++i) {
+        CanvasRegion& region = regions[i];
+        if (i < static_cast<int>(cfg.canvasOutputs.size())) {
+            // Warps and gamma are per projector: they stay
+            region.corners    = cfg.canvasOutputs[i].corners;
+            region.blendGamma = cfg.canvasOutputs[i].blendGamma;
+        }
+        region.x          = static_cast<float>(i) * (width - overlap);
+        region.width      = width;
+        region.blendLeft  = i > 0 ? overlap / width : 0.0f;
+        region.blendRight = i < count - 1 ? overlap / width : 0.0f;
+    }
+    const bool reopen = cfg.canvasEnabled && regions.size() != cfg.canvasOutputs.size();
+    cfg.canvasOutputs = std::move(regions);
+    if (reopen) OpenCanvasOutputs();
+    SaveConfig();
+}
+
+void Application::AddChannel() {
+    auto& cfg = m_configManager.GetConfig();
+    if (static_cast<int>(m_channels.size()) >= MAX_CHANNELS) return;
+    cfg.channels.emplace_back();
+    m_channels.push_back(std::make_unique<PlaybackChannel>());
+    if (!OpenChannelOutput(static_cast<int>(m_channels.size()) - 1)) cfg.channels.back().output = false;
+    SaveConfig();
+}
+
+void Application::RemoveChannel(int channel) {
+    auto& cfg = m_configManager.GetConfig();
+    if (channel < 0 || channel >= static_cast<int>(m_channels.size())) return;
+    m_channels[channel]->Release(m_renderer);
+    m_channels.erase(m_channels.begin() + channel);
+    cfg.channels.erase(cfg.channels.begin() + channel);
+    SaveConfig();
+}
+
+void Application::CueChannel(int channel, const std::string& filepath) {
+    if (channel < 0 || channel >= static_cast<int>(m_channels.size())) return;
+    // The cores are split between deck A and every channel; each clip also
+    // decodes on its own DecodeWorker thread
+    const AppConfig& cfg = m_configManager.GetConfig();
+    const int cores   = static_cast<int>(std::thread::hardware_concurrency());
+    const int threads = std::max(cores / (static_cast<int>(m_channels.size()) + 1), 1);
+    m_channels[channel]->Cue(filepath, threads, cfg.proxyScale);
+    m_configManager.GetConfig().channels[channel].video = filepath;
+}
+
+void Application::UnloadChannel(int channel) {
+    if (channel < 0 || channel >= static_cast<int>(m_channels.size())) return;
+    m_channels[channel]->Unload();
+    m_configManager.GetConfig().channels[channel].video.clear();
+}
+
+void Application::CueChannelDialog(int channel) {
     char filepath[MAX_PATH] = {};
-    
+
     OPENFILENAMEA ofn = {};
     ofn.lStructSize = sizeof(ofn);
     ofn.hwndOwner = m_hwnd;
-    ofn.lpstrFilter = "HLSL Shader\0*.hlsl\0All Files\0*.*\0";
+    ofn.lpstrFilter = "Video Files\0*.mp4;*.mov;*.avi;*.mkv;*.webm;*.mxf\0All Files\0*.*\0";
     ofn.lpstrFile = filepath;
     ofn.nMaxFile = MAX_PATH;
-    ofn.lpstrDefExt = "hlsl";
-    ofn.Flags = OFN_OVERWRITEPROMPT;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
 
-    if (GetSaveFileNameA(&ofn)) {
-        std::ofstream file(filepath);
-        if (file.is_open()) {
-            file << source;
-            
-            // Update or create preset
-            auto* preset = m_shaderManager->GetActivePreset();
-            if (preset) {
-                preset->filepath = filepath;
-                preset->name = std::filesystem::path(filepath).stem().string();
-            } else {
-                ShaderPreset newPreset;
-                newPreset.filepath = filepath;
-                newPreset.name = std::filesystem::path(filepath).stem().string();
-                newPreset.source = source;
-                m_shaderManager->CompilePreset(newPreset);
-                int idx = m_shaderManager->AddPreset(newPreset);
-                m_shaderManager->SetActivePreset(idx);
-                m_uiManager->ResetKeyframeSelection();
-                OnParamChanged();
-            }
+    BeginModalLoop();
+    const bool chosen = GetOpenFileNameA(&ofn);
+    EndModalLoop();
+    if (chosen) {
+        CueChannel(channel, filepath);
+        SaveConfig();
+    }
+}
 
-            m_uiManager->ShowNotification("Shader saved: " + std::string(filepath));
-        }
+void Application::SetChannelPreset(int channel, const std::string& preset) {
+    if (channel < 0 || channel >= static_cast<int>(m_channels.size())) return;
+    m_configManager.GetConfig().channels[channel].preset = preset;
+    SaveConfig();  // UpdatePostChains builds the stage next tick
+}
+
+void Application::SetChannelOutput(int channel, bool open) {
+    if (channel < 0 || channel >= static_cast<int>(m_channels.size())) return;
+    auto& config = m_configManager.GetConfig().channels[channel];
+    if (open) {
+        config.output = OpenChannelOutput(channel);
+    } else {
+        m_channels[channel]->CloseOutput();
+        config.output = false;
     }
+    SaveConfig();
 }
 
-void Application::ScanFolderDialog() {
-    IFileOpenDialog* pDialog = nullptr;
-    HRESULT hr = CoCreateInstance(CLSID_FileOpenDialog, nullptr, CLSCTX_INPROC_SERVER,
-        IID_PPV_ARGS(&pDialog));
-    if (FAILED(hr)) return;
+void Application::CueDeckDialog() {
+    char filepath[MAX_PATH] = {};
 
-    DWORD opts = 0;
-    pDialog->GetOptions(&opts);
-    pDialog->SetOptions(opts | FOS_PICKFOLDERS | FOS_PATHMUSTEXIST);
-    pDialog->SetTitle(L"Select Shader Folder");
+    OPENFILENAMEA ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = m_hwnd;
+    ofn.lpstrFilter = "Video Files\0*.mp4;*.mov;*.avi;*.mkv;*.webm;*.mxf\0All Files\0*.*\0";
+    ofn.lpstrFile = filepath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
 
-    hr = pDialog->Show(m_hwnd);
-    if (SUCCEEDED(hr)) {
-        IShellItem* pItem = nullptr;
-        hr = pDialog->GetResult(&pItem);
-        if (SUCCEEDED(hr)) {
-            PWSTR pszPath = nullptr;
-            if (SUCCEEDED(pItem->GetDisplayName(SIGDN_FILESYSPATH, &pszPath))) {
-                int len = WideCharToMultiByte(CP_UTF8, 0, pszPath, -1, nullptr, 0, nullptr, nullptr);
-                std::string path(len - 1, '\0');
-                WideCharToMultiByte(CP_UTF8, 0, pszPath, -1, path.data(), len, nullptr, nullptr);
+    BeginModalLoop();
+    const bool chosen = GetOpenFileNameA(&ofn);
+    EndModalLoop();
+    if (chosen) {
+        CueDeck(filepath);
+    }
+}
 
-                m_configManager.GetConfig().shaderDirectory = path;
-                m_shaderManager->ScanDirectory(path);
-                m_uiManager->ShowNotification("Scanned: " + std::filesystem::path(path).filename().string());
-                CoTaskMemFree(pszPath);
-            }
-            pItem->Release();
+void Application::SyncVideoInputs() {
+    // Paused or playing: a scrub moves the inputs with the main video
+    for (int i = 0; i < MAX_VIDEO_INPUTS; ++i) {
+        m_inputs[i].Sync(m_playbackTime);
+    }
+}
+
+void Application::FeedAudio() {
+    // Fill the player's ring to its target (AUDIO_FILL_SECONDS) on every tick. Submission is
+    // capped at the deficit so the ring never fills beyond the target — avoiding
+    // the bug where draining at 60 fps submits audio 20x faster than real time,
+    // exhausting the ring capacity in < 1 second. AudioReader decodes on its own
+    // thread and demuxer, so this never waits on the video decoder.
+    if (!AudioFollowsPlayback()) return;
+
+    const int rate        = m_audioReader.GetSampleRate();  // The device's, when there is one
+    const int deviceRate  = m_audioPlayer->GetDeviceSampleRate();
+    // Target in device-rate frames (the unit GetBufferedSamples returns)
+    const double fillSeconds = m_configManager.GetConfig().audioLowLatency ? AUDIO_FILL_SECONDS_LOW_LATENCY
+                                                                           : AUDIO_FILL_SECONDS;
+    const int targetFill  = static_cast<int>((deviceRate > 0 ? deviceRate : rate) * fillSeconds);
+    const int deficit     = targetFill - m_audioPlayer->GetBufferedSamples();
+    if (deficit <= 0) return;
+
+    constexpr int kAudioBuf = 8192;  // Frames
+    static float audioBuf[kAudioBuf * AUDIO_CHANNELS];
+
+    // Drain and submit in chunks until the deficit is satisfied. No per-tick cap:
+    // if the main loop was throttled (background, 1 fps) the deficit is large and
+    // must be recovered in one tick. Away from 1x the time stretcher turns `rate`
+    // times the source into each output sample.
+    const bool stretch = (m_playbackRate != 1.0);
+    if (stretch && m_timeStretch.GetSampleRate() != rate) {
+        m_timeStretch.Reset(rate);  // Flushed before the reader knew its rate
+    }
+    int remaining = deficit;
+    while (remaining > 0) {
+        const int want = std::clamp(static_cast<int>(std::ceil(remaining * m_playbackRate)), 1, kAudioBuf);
+        const int got  = m_audioReader.Drain(audioBuf, want);
+        if (got <= 0) break;
+
+        const float* samples = audioBuf;
+        int count = got;
+        if (stretch) {
+            m_stretchBuf.clear();
+            m_timeStretch.Process(audioBuf, got, m_stretchBuf);
+            samples = m_stretchBuf.data();
+            count   = static_cast<int>(m_stretchBuf.size() / AUDIO_CHANNELS);
         }
+        if (count > 0) {
+            m_analysisQueue.insert(m_analysisQueue.end(), samples, samples + static_cast<size_t>(count) * AUDIO_CHANNELS);
+            m_analysisSubmitted += count;
+            m_audioPlayer->Submit(samples, count);
+            // The recording's audio track gets exactly what is played
+            m_encoder.SubmitAudio(samples, count);
+            for (auto& encoder : m_extraEncoders) encoder->SubmitAudio(samples, count);
+        }
+        remaining -= count;
     }
-    pDialog->Release();
 }
 
-void Application::OpenRecordingOutputDialog(char* pathBuf, size_t bufSize) {
-    OPENFILENAMEA ofn = {};
-    ofn.lStructSize = sizeof(ofn);
-    ofn.hwndOwner = m_hwnd;
-    ofn.lpstrFilter = "MP4 Video\0*.mp4\0MOV Video\0*.mov\0All Files\0*.*\0";
-    ofn.lpstrFile = pathBuf;
-    ofn.nMaxFile = static_cast<DWORD>(bufSize);
-    ofn.lpstrDefExt = "mp4";
-    ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
-    GetSaveFileNameA(&ofn);
+void Application::AnalyzeHeardAudio() {
+    const int rate       = m_audioReader.GetSampleRate();
+    const int deviceRate = m_audioPlayer->GetDeviceSampleRate();
+    int64_t heard = m_analysisSubmitted;  // No device: analysed as submitted
+    if (deviceRate > 0 && rate > 0) {
+        // Still ahead of the speakers: the player's ring plus the device buffer
+        const int64_t ahead = static_cast<int64_t>(m_audioPlayer->GetBufferedSamples() +
+                                                   m_audioPlayer->GetDeviceLatencySamples()) * rate / deviceRate;
+        heard = m_analysisSubmitted - ahead;  // Negative right after a flush: stale ring
+    }
+    const size_t  queued = m_analysisQueue.size() / AUDIO_CHANNELS;
+    const int64_t count  = std::min<int64_t>(heard - m_analysisFed, static_cast<int64_t>(queued - m_analysisRead));
+    if (count <= 0) return;
+
+    // With the timeline ready the queue only keeps count, so a rebuild (new DSP
+    // settings) falls back to live analysis without a gap
+    const float* frames = m_analysisQueue.data() + m_analysisRead * AUDIO_CHANNELS;
+    if (!m_audioTimeline.IsReady() && !m_audioCapture.IsRunning()) {
+        m_audioAnalysis.Push(frames, static_cast<int>(count), rate);
+    }
+    // The waveform texture shows what was just heard, from either source
+    constexpr size_t WAVEFORM_FLOATS = AudioData::kWaveformSamples * AUDIO_CHANNELS;
+    const size_t keep = std::min<size_t>(static_cast<size_t>(count), AudioData::kWaveformSamples) * AUDIO_CHANNELS;
+    float* waveform = &m_heardWaveform[0][0];
+    std::copy(waveform + keep, waveform + WAVEFORM_FLOATS, waveform);
+    std::copy_n(frames + static_cast<size_t>(count) * AUDIO_CHANNELS - keep, keep, waveform + WAVEFORM_FLOATS - keep);
+    m_analysisRead += static_cast<size_t>(count);
+    m_analysisFed  += count;
+    // Drop the analysed head once it outweighs what is still queued
+    if (m_analysisRead * 2 > queued) {
+        m_analysisQueue.erase(m_analysisQueue.begin(),
+                              m_analysisQueue.begin() + static_cast<ptrdiff_t>(m_analysisRead * AUDIO_CHANNELS));
+        m_analysisRead = 0;
+    }
 }
 
-bool Application::StartRecording(const RecordingSettings& settings) {
-    int recW, recH;
-    double recFPS;
+void Application::FlushAudioOutput() {
+    m_audioPlayer->Flush();
+    m_timeStretch.Reset(m_audioReader.GetSampleRate());
+    m_analysisQueue.clear();
+    m_analysisRead      = 0;
+    m_analysisSubmitted = 0;
+    m_analysisFed       = 0;
+    std::fill_n(&m_heardWaveform[0][0], AudioData::kWaveformSamples * AUDIO_CHANNELS, 0.0f);
+}
 
-    if (m_decoder.IsOpen()) {
-        recW   = m_decoder.GetWidth();
-        recH   = m_decoder.GetHeight();
-        recFPS = m_decoder.GetFPS();
+bool Application::AudioFollowsPlayback() const {
+    return m_audioReader.IsOpen() &&
+           (m_playbackRate == 1.0 || m_configManager.GetConfig().stretchAudio);
+}
+
+void Application::UpdateDecodeSkip() {
+    m_decoder.SetKeyframesOnly(m_playbackRate >= KEYFRAME_ONLY_RATE);
+    m_decoder.SetSkipNonReference(m_catchUpSkip || m_playbackRate >= NONREF_RATE);
+}
+
+void Application::SetPlaybackRate(double rate) {
+    rate = std::clamp(rate, MIN_PLAYBACK_RATE, MAX_PLAYBACK_RATE);
+    if (rate == m_playbackRate) return;
+    RecordSessionEvent(SessionEventType::Rate, {{"rate", rate}});
+    StopLoopReplay();
+    const bool wasKeyframesOnly = m_playbackRate >= KEYFRAME_ONLY_RATE;
+    m_playbackRate = rate;
+    m_timeStretch.SetRate(rate);
+    ResetSync();
+
+    if (!m_decoder.IsOpen() || m_decoder.IsLiveCapture() || m_playingBackward) return;
+    if (wasKeyframesOnly && rate < KEYFRAME_ONLY_RATE) {
+        // The decoder would otherwise wait for the next keyframe; restart right
+        // after the frame on screen instead (this also re-seeks audio)
+        RestartDecodeWorker(false);
     } else {
-        // Generative mode: use configured generative resolution.
-        // If settings.fps is 0 ("match source"), default to 60 since there is no source.
-        recW   = m_renderer.GetGenerativeWidth();
-        recH   = m_renderer.GetGenerativeHeight();
-        recFPS = (settings.fps > 0) ? static_cast<double>(settings.fps) : 60.0;
+        // Audio queued at the old rate would play out late
+        FlushAudioOutput();
+        m_audioReader.Seek(m_currentFrame.timestamp);
+    }
+}
 
-        // Ensure the generative render loop is running
-        if (m_playbackState != PlaybackState::Playing)
-            Play();
+void Application::SetStretchAudio(bool enabled) {
+    m_configManager.GetConfig().stretchAudio = enabled;
+    SaveConfig();
+    if (m_playbackRate != 1.0 && enabled && m_decoder.IsOpen() && !m_playingBackward) {
+        // Muted until now: the reader stopped being drained, so start it over here
+        FlushAudioOutput();
+        m_audioReader.Seek(m_currentFrame.timestamp);
     }
+}
 
-    if (m_encoder.StartRecording(settings, recW, recH, recFPS)) {
-        m_uiManager->ShowNotification("Recording started: " + settings.outputPath);
+bool Application::PopSyncedFrame(std::chrono::steady_clock::time_point now) {
+    // Just started, seeked or looped: show the next frame and run the clock from it
+    if (!m_syncAnchored) {
+        if (!m_decodeWorker.PopFrame(m_currentFrame)) return false;
+        m_syncAnchored   = true;
+        m_syncAnchorTime = m_currentFrame.timestamp;
+        m_syncAnchorWall = now;
         return true;
-    } else {
-        m_uiManager->ShowNotification("Failed to start recording");
-        return false;
     }
-}
 
-void Application::StopRecording() {
-    if (m_encoder.IsRecording()) {
-        // Non-blocking: signals the encoder thread to drain its queue and exit.
-        // Flush, file close, and resource free all happen on that thread.
-        m_encoder.StopRecording();
-        m_uiManager->ShowNotification("Recording stopped");
+    // Show the newest frame that is due by the middle of this tick, so each lands
+    // on the tick nearest its time; older due frames are dropped unseen
+    const double clock = SyncClock(now);
+    const double due   = clock + 0.5 * m_tickSeconds * m_playbackRate;
+
+    // The worker looped: the first frame of the next pass follows the last one of
+    // this pass on its own schedule, and the clock restarts from it
+    if (m_decodeWorker.NextStartsLoop()) {
+        if (due < m_currentFrame.timestamp + m_frameDuration) return false;
+        m_decodeWorker.PopFrame(m_currentFrame);
+        m_syncAnchorTime = m_currentFrame.timestamp;
+        m_syncAnchorWall = now;
+        return true;
+    }
+
+    bool popped = false;
+    double next;
+    while (m_decodeWorker.PeekNextTimestamp(next) && next <= due) {
+        if (popped) ++m_lateDrops;
+        m_decodeWorker.PopFrame(m_currentFrame);
+        popped = true;
+    }
+    if (!popped && due >= m_currentFrame.timestamp + m_frameDuration) {
+        // A frame is due but the queue is empty: PopFrame records the underrun
+        popped = m_decodeWorker.PopFrame(m_currentFrame);
+    }
+    if (popped) RecordCadence((clock - m_currentFrame.timestamp) / m_playbackRate);
+
+    // Dropping at presentation only helps while the decoder keeps up on average.
+    // Lagging further, make the decoder itself cheaper: skip non-reference frames,
+    // then discard whole frames before conversion until it is ahead of the clock.
+    // Lag in wall time, so the thresholds mean the same at every playback rate.
+    const double lag = (clock - m_currentFrame.timestamp) / m_playbackRate;
+    if (lag > CATCHUP_NONREF_FRAMES * m_frameDuration) {
+        m_catchUpSkip = true;
+    } else if (lag < m_frameDuration) {
+        m_catchUpSkip = false;
     }
+    if (lag > CATCHUP_DISCARD_SECONDS && !m_decoder.IsCatchingUp() &&
+        m_decodeWorker.GetQueueDepth() == 0) {
+        auto lock = m_decodeWorker.TryLockDecoder();
+        if (lock.owns_lock()) m_decoder.DiscardUntil(clock + CATCHUP_DISCARD_LEAD);
+    }
+    return popped;
 }
 
-void Application::SaveConfig() {
-    // Update shader presets in config
-    auto& config = m_configManager.GetConfig();
-    config.shaderPresets.clear();
-    
-    for (int i = 0; i < m_shaderManager->GetPresetCount(); ++i) {
-        auto* preset = m_shaderManager->GetPreset(i);
-        if (preset && !preset->filepath.empty()) {
-            config.shaderPresets.push_back(*preset);
-        }
+double Application::SyncClock(std::chrono::steady_clock::time_point now) {
+    if (m_frameSyncLocked) {
+        // The wall's master keeps time; anchored here so losing it continues smoothly
+        m_syncAnchorTime = m_frameSyncClock;
+        m_syncAnchorWall = now;
+        return m_frameSyncClock;
     }
+    const double wall = m_syncAnchorTime +
+                        std::chrono::duration<double>(now - m_syncAnchorWall).count() * m_playbackRate;
+    const double audio = AudioFollowsPlayback() ? AudibleAudioTime() : -1.0;
+    if (audio >= 0.0 && std::abs(audio - wall) < SYNC_MAX_AUDIO_SKEW) {
+        // Follow the audio, re-anchoring so a gap in it continues from here
+        m_syncAnchorTime = audio;
+        m_syncAnchorWall = now;
+        return audio;
+    }
+    return wall;
+}
 
-    m_configManager.Save(ConfigManager::GetDefaultConfigPath());
+void Application::RecordCadence(double lateSeconds) {
+    // The previous frame's ticks on screen: 1 for every frame when the display
+    // matches the source, a 2:3 pattern for 24 fps at 60 Hz
+    if (m_cadenceTicks > 0) ++m_cadence.held[std::min(m_cadenceTicks, 4) - 1];
+    m_cadenceTicks = 0;
+    const double errorMs = std::abs(lateSeconds) * 1000.0;
+    m_cadence.meanErrorMs += (errorMs - m_cadence.meanErrorMs) * CADENCE_ERROR_SMOOTHING;
+    m_cadence.maxErrorMs   = std::max(m_cadence.maxErrorMs, errorMs);
 }
 
-void Application::ToggleVideoOutputWindow() {
-    if (m_videoOutputWindow.IsOpen())
-        m_videoOutputWindow.Close();
-    else
-        m_videoOutputWindow.Open(m_renderer.GetDevice(), m_renderer.GetContext());
+void Application::ResetSync() {
+    m_syncAnchored = false;
+    m_cadenceTicks = -1;  // The frame on screen across a discontinuity isn't part of the cadence
+    m_catchUpSkip  = false;
+    m_decoder.SetSkipNonReference(false);
+    m_decoder.SetKeyframesOnly(false);
 }
 
-void Application::SetSpoutEnabled(bool enabled) {
-    m_configManager.GetConfig().spoutEnabled = enabled;
-    m_spoutOutput.SetEnabled(enabled);
+void Application::SetSyncMode(int mode) {
+    m_configManager.GetConfig().syncMode = mode;
+    ResetSync();
     SaveConfig();
 }
 
-void Application::SetSpoutSenderName(const std::string& name) {
-    m_configManager.GetConfig().spoutSenderName = name;
-    m_spoutOutput.SetSenderName(name);
-    SaveConfig();
+double Application::AudibleAudioTime() const {
+    // Next sample the reader hands out, minus what the stretcher holds and what
+    // the player and the device still have queued (which plays `rate` times
+    // faster than realtime)
+    const double drainTime  = m_audioReader.GetDrainTime();
+    const int    deviceRate = m_audioPlayer->GetDeviceSampleRate();
+    const int    sourceRate = m_audioReader.GetSampleRate();
+    if (drainTime < 0.0 || deviceRate <= 0 || sourceRate <= 0) return -1.0;
+    const double stretching = (m_playbackRate != 1.0)
+        ? static_cast<double>(m_timeStretch.GetPendingInput()) / sourceRate : 0.0;
+    const int queued = m_audioPlayer->GetBufferedSamples() + m_audioPlayer->GetDeviceLatencySamples();
+    return drainTime - stretching - static_cast<double>(queued) / deviceRate * m_playbackRate;
 }
 
-void Application::UpdateAudioSettings() {
-    m_audioAnalyzer.UpdateSettings(m_configManager.GetConfig().audio);
-    SaveConfig();
+void Application::OnParamChanged() {
+    m_renderer.GetRenderAhead().Invalidate();  // Drawn with the old values
+    // Right after a preset switch the values go out with its Preset event instead,
+    // so a replay doesn't apply them to the previous preset
+    if (const ShaderPreset* preset = m_shaderManager->GetActivePreset(); preset && m_sessionRecording &&
+        (preset->filepath.empty() ? preset->name : preset->filepath) == m_sessionPreset) {
+        RecordSessionEvent(SessionEventType::Params, SessionParams(*preset));
+    }
+    ApplyParamValues();
+}
+
+void Application::ApplyParamValues() {
+    ShaderPreset* preset = m_shaderManager->GetActivePreset();
+    if (!preset) return;
+
+    float packed[16] = {};
+    ShaderManager::PackParamValues(*preset, packed);
+    m_renderer.SetCustomUniforms(packed, 16);
+    m_modulation.SetBase(packed);
+    float extended[MAX_EXTENDED_PARAM_FLOATS];
+    m_renderer.SetExtendedParams(extended, ShaderManager::PackExtendedParams(*preset, extended));
+    m_shaderManager->UpdateSpecialization();
+
+    for (const auto& p : preset->params) {
+        if (p.type == ShaderParamType::Event && p.values[0] > 0.5f) {
+            m_eventResetPending = true;
+            break;
+        }
+    }
+}
+
+void Application::EvaluateKeyframes() {
+    // The watchdog put the params back at their defaults: the keys would undo it
+    if (m_watchdogApplied >= WatchdogLevel::Defaults) return;
+    ShaderPreset* preset = m_shaderManager->GetActivePreset();
+    if (preset && ShaderManager::EvaluateKeyframes(*preset, m_playbackTime)) ApplyParamValues();
+}
+
+void Application::UpdateAudioData() {
+    // Push latest audio analysis to GPU (b1 cbuffer + t3 spectrum texture). A live
+    // input replaces the file's audio, waveform included. Otherwise the
+    // pre-analysed timeline is exact at any playback time; live analysis covers
+    // the file until it is ready. The file's waveform is always the heard samples.
+    if (m_audioCapture.IsRunning()) {
+        m_audioAnalysis.GetData(m_audioData);
+        m_renderer.SetAudioData(&m_audioData);
+    } else if (m_audioTimeline.IsReady()) {
+        m_audioTimeline.Lookup(m_playbackTime, m_audioData);
+        std::copy_n(&m_heardWaveform[0][0], AudioData::kWaveformSamples * AUDIO_CHANNELS, &m_audioData.waveform[0][0]);
+        m_renderer.SetAudioData(&m_audioData);
+    } else if (m_audioReader.IsOpen()) {
+        m_audioAnalysis.GetData(m_audioData);
+        std::copy_n(&m_heardWaveform[0][0], AudioData::kWaveformSamples * AUDIO_CHANNELS, &m_audioData.waveform[0][0]);
+        m_renderer.SetAudioData(&m_audioData);
+    } else {
+        m_renderer.SetAudioData(nullptr);
+    }
+}
+
+void Application::UpdateModulation() {
+    const ShaderPreset* preset = m_shaderManager->GetActivePreset();
+    if (!preset) return;
+    // Audio rows read silence without a source
+    static const AudioData silence{};
+    const bool audio = m_audioCapture.IsRunning() || m_audioTimeline.IsReady() || m_audioReader.IsOpen();
+    float modulated[16];
+    if (m_modulation.Apply(*preset, audio ? m_audioData : silence, m_playbackTime, modulated)) {
+        m_renderer.SetCustomUniforms(modulated, 16);
+    }
+}
+
+void Application::RenderFrame() {
+    // A tick from a dialog the UI opened runs inside this function's own frame: it
+    // renders the outputs but leaves the GPU profiler frame and the UI to the caller
+    const bool nested = m_uiFrameOpen;
+
+    // GPU timestamps of everything this tick submits, read back a few frames later
+    GpuProfiler& gpuProfiler = m_renderer.GetGpuProfiler();
+    if (!nested) gpuProfiler.BeginFrame();
+    UpdateRenderScale();
+    if (GpuFrameTiming latest; gpuProfiler.GetLatest(latest)) {
+        m_shaderManager->RecordGpuTime(latest);
+        m_watchdog.ReportGpu(latest);
+    }
+
+    // Upload current video frame — unless a scrub-cache hit already put it at t0,
+    // or its generation is the one already in the texture (display refresh above the
+    // frame rate, slow motion, pause, underrun)
+    const bool alreadyUploaded = m_currentFrame.generation != 0 &&
+                                 m_currentFrame.generation == m_renderer.GetVideoGeneration();
+    {
+        SP_CPU_SCOPE(m_cpuProfiler, Upload);
+        if (!m_showingCachedFrame && m_currentFrame.HasPixels() && !alreadyUploaded) {
+            if (m_renderer.UploadVideoFrame(m_currentFrame)) {
+                if (m_cacheCurrentFrame) m_renderer.CacheVideoFrame(FrameKey(m_currentFrame.timestamp));
+            }
+            m_cacheCurrentFrame = false;
+        }
+
+        for (int i = 0; i < MAX_VIDEO_INPUTS; ++i) {
+            if (m_inputs[i].GetFrame().HasPixels()) m_renderer.UploadInputFrame(i, m_inputs[i].GetFrame());
+        }
+    }
+
+    // Set shader uniforms
+    m_renderer.SetShaderTime(m_playbackTime);
+
+    // Controller moves, then keyframe animations at current playback time. An
+    // automation take sees the moves first, so it latches them before any replay.
+    DrainControlInput();
+    {
+        SP_CPU_SCOPE(m_cpuProfiler, Keyframes);
+        ShaderPreset* recorded = nullptr;
+        if (m_automation.IsRecording()) {
+            if (m_shaderManager->GetActivePresetIndex() != m_automation.GetPresetIndex()) StopAutomationRecording();
+            else recorded = m_shaderManager->GetActivePreset();
+        }
+        if (recorded) m_automation.Capture(*recorded, m_playbackTime);
+        EvaluateKeyframes();
+        if (recorded) m_automation.Settle(*recorded);
+    }
+
+    // Push active preset's blend settings so the compositor shader has current values.
+    // Only meaningful when a generative shader is active and video is loaded; harmless otherwise.
+    {
+        const int activeIdx = m_shaderManager->GetActivePresetIndex();
+        if (activeIdx >= 0) {
+            const auto& preset = m_shaderManager->GetPresets()[activeIdx];
+            m_renderer.SetVideoBlend(preset.blendMode, preset.blendAmount);
+        } else {
+            m_renderer.SetVideoBlend(0, 0.0f);
+        }
+    }
+    UpdateDeck();
+    UpdateChannels();
+    UpdateCanvasOutputs();
+    UpdateEncoderCalibration();
+    UpdateLayers();
+    UpdatePostChains();
+
+    UpdateAudioData();
+    UpdateModulation();
+
+    // Render: from here through the outputs and recording submit (several blocks, so timed by hand)
+    const auto renderStart = std::chrono::steady_clock::now();
+
+    // Set up D3D11 pipeline and clear backbuffer to black
+    m_renderer.BeginFrame();
+    // Render video+shader to the display texture; ImGui::Image picks it up from there.
+    // Rendering ahead, the queue's front entry is copied there instead.
+    if (m_renderingAhead) {
+        FillRenderAhead();
+    } else {
+        m_renderer.RenderToDisplay();
+    }
+
+    // The UI and main-window present only run every uiRefreshHz (offline export:
+    // EXPORT_UI_INTERVAL, never vsynced), and not at all while the main window
+    // can't be seen; the output window, Spout and recording still get every tick,
+    // except that export skips the output window with the UI
+    const auto now = std::chrono::steady_clock::now();
+    const bool drawUi = !nested && m_renderPolicy == RenderPolicy::Full && IsUiRefreshDue(now);
+
+    // Each output's post chain branches from the display texture at that
+    // output's size, and only for outputs that take a frame this tick
+    const AppConfig& cfg = m_configManager.GetConfig();
+    ID3D11ShaderResourceView* displaySRV = m_renderer.GetDisplaySRV();
+    const int displayW = m_renderer.GetDisplayWidth();
+    const int displayH = m_renderer.GetDisplayHeight();
+    if (drawUi) {
+        const ImVec2 viewport = m_uiManager->GetVideoViewportSize();
+        const bool sized = viewport.x >= 1.0f && viewport.y >= 1.0f;
+        RunPostChain(POST_OUTPUT_PREVIEW, displaySRV, sized ? static_cast<int>(viewport.x) : displayW,
+                     sized ? static_cast<int>(viewport.y) : displayH);
+    }
+
+    // Blit processed output to the detached video window (if open)
+    if (m_videoOutputWindow.IsOpen() && (drawUi || !m_exporting)) {
+        ID3D11ShaderResourceView* post = RunPostChain(POST_OUTPUT_WINDOW, displaySRV, m_videoOutputWindow.GetWidth(),
+                                                      m_videoOutputWindow.GetHeight());
+        GpuProfiler::Scope scope(gpuProfiler, GpuStage::OutputWindow);
+        m_videoOutputWindow.SubmitFrame(m_renderer, post);
+    }
+    // Canvas windows: the one display texture, a region of it each
+    if (!m_canvasWindows.empty() && (drawUi || !m_exporting)) {
+        GpuProfiler::Scope scope(gpuProfiler, GpuStage::OutputWindow);
+        for (size_t i = 0; i < m_canvasWindows.size() && i < cfg.canvasOutputs.size(); ++i) {
+            m_canvasWindows[i]->SetRegion(&cfg.canvasOutputs[i]);
+            m_canvasWindows[i]->SubmitFrame(m_renderer, displaySRV);
+        }
+    }
+    // Extra playback channels, each through its preset into its own window
+    if (!m_channels.empty() && !m_exporting) {
+        GpuProfiler::Scope scope(gpuProfiler, GpuStage::OutputWindow);
+        for (auto& channel : m_channels) channel->Render(m_renderer);
+    }
+
+    // Share processed frame via Spout (GPU texture copy; does not block the pipeline).
+    // Skipped while the display texture holds the frame already sent.
+    if (m_spoutOutput->IsEnabled()) {
+        // The chain goes on top of the tapped pass when there is one
+        ID3D11ShaderResourceView* source = m_renderer.GetTapSRV();
+        if (!source) source = displaySRV;
+        int width  = cfg.spoutWidth;
+        int height = cfg.spoutHeight;
+        if (width <= 0 || height <= 0) {
+            D3D11_TEXTURE2D_DESC desc = {};
+            ComPtr<ID3D11Resource> resource;
+            if (source) source->GetResource(&resource);
+            if (resource) static_cast<ID3D11Texture2D*>(resource.Get())->GetDesc(&desc);
+            width  = static_cast<int>(desc.Width);
+            height = static_cast<int>(desc.Height);
+        }
+        ID3D11ShaderResourceView* post = RunPostChain(POST_OUTPUT_SPOUT, source, width, height);
+        GpuProfiler::Scope scope(gpuProfiler, GpuStage::Spout);
+        m_spoutOutput->SendFrame(m_renderer, post, m_postChains[POST_OUTPUT_SPOUT].generation);
+    }
+
+    // NDI: UYVY conversion and an async readback; the send thread does the rest.
+    // The chain waits for a receiver (the last submit's count), as the conversion does.
+    if (m_ndiOutput.IsRunning()) {
+        const double fps = m_decoder.IsOpen() ? m_decoder.GetFPS() : 0.0;
+        const int frameRateN = fps > 0.0 ? static_cast<int>(std::lround(fps * 1000.0)) : 60000;
+        ID3D11ShaderResourceView* post = nullptr;
+        if (m_ndiOutput.GetConnections() > 0) {
+            const bool sized = cfg.ndiWidth > 0 && cfg.ndiHeight > 0;
+            post = RunPostChain(POST_OUTPUT_NDI, displaySRV, sized ? cfg.ndiWidth : displayW,
+                                sized ? cfg.ndiHeight : displayH);
+        }
+        if (m_ndiOutput.SubmitFrame(m_renderer, frameRateN, 1000, post, m_postChains[POST_OUTPUT_NDI].generation))
+            m_renderer.BeginFrame();  // Restore after the conversion draw
+    }
+
+    // Virtual camera: NV12 conversion at the size the camera client picked and an
+    // async readback into the shared frame slot. Nothing while no client streams.
+    if (m_virtualCamera.IsRunning()) {
+        ID3D11ShaderResourceView* post = nullptr;
+        if (m_virtualCamera.IsStreaming()) {
+            post = RunPostChain(POST_OUTPUT_VIRTUAL_CAMERA, displaySRV, m_virtualCamera.GetStreamWidth(),
+                                m_virtualCamera.GetStreamHeight());
+        }
+        if (m_virtualCamera.SubmitFrame(m_renderer, post, m_postChains[POST_OUTPUT_VIRTUAL_CAMERA].generation))
+            m_renderer.BeginFrame();  // Restore after the conversion draws
+    }
+
+    // Capture recording frame here, BEFORE ImGui renders: the recording reads the
+    // display texture RenderToDisplay just drew, so the shader runs once for preview,
+    // output window, Spout and recording. Only capture on new video frames to match
+    // the encoder's configured framerate.
+    if (m_encoder.IsRecording() && m_newVideoFrame) {
+        // The recording's chain at the display size; the readback and NV12
+        // conversions read it in place of the display texture
+        m_renderer.SetReadbackSource(RunPostChain(POST_OUTPUT_RECORDING, displaySRV, displayW, displayH));
+        bool restoreState = false;
+        auto submitHardware = [&](VideoEncoder& encoder) {
+            if (!encoder.IsHardwareEncoding() || !encoder.IsRecording()) return;
+            // Straight into the encoder's NV12 surface (drawn at its size, so a
+            // downscaled target scales on the GPU); nothing comes back to the CPU
+            encoder.SubmitHardwareFrame([this](ID3D11Texture2D* surface, int slice) {
+                return m_renderer.ConvertToNv12(surface, slice);
+            });
+            restoreState = true;
+        };
+        submitHardware(m_encoder);
+        for (auto& encoder : m_extraEncoders) submitHardware(*encoder);
+
+        if (m_readbackEncoder) {
+            // One readback for every software target.
+            // All slots in flight: the oldest has had the whole ring to finish
+            if (m_renderer.IsReadbackRingFull()) SubmitReadback(true);
+            m_renderer.QueueReadback();
+            if (m_renderer.GetReadbackLayout() != ReadbackLayout::RGBA8) restoreState = true;
+        }
+        m_renderer.SetReadbackSource(nullptr);
+        // The GPU YUV and NV12 passes change the pipeline state and viewport; restore before ImGui
+        if (restoreState) m_renderer.BeginFrame();
+    }
+    // Frames go to the encoder as their copies land, also on ticks without a new frame
+    if (m_encoder.IsRecording()) {
+        while (SubmitReadback(false)) {}
+    }
+    if (m_configManager.GetConfig().libraryThumbnails) m_thumbnails.Update();
+    // Filmstrip slots the overview worker finished since the last frame
+    if (m_configManager.GetConfig().timelineOverview) m_mediaOverview.Upload(m_renderer);
+    m_shaderManager->UpdateResidency();
+    UpdateMemoryBudget();
+    // A LUT bake drawn after an earlier Present, saved once its readback has landed
+    if (m_lutBake.size > 0) {
+        ColorLut lut;
+        const D3D11Renderer::LutBakeStatus status = m_renderer.PollLutBake(m_lutBake, lut);
+        if (status == D3D11Renderer::LutBakeStatus::Done) {
+            lut.title = m_lutBakeTitle;
+            std::string error;
+            if (SaveColorLut(m_lutBakePath, lut, error)) {
+                m_uiManager->ShowNotification("LUT baked: " + std::filesystem::path(m_lutBakePath).filename().string());
+            } else {
+                m_uiManager->ShowNotification("LUT bake failed: " + error);
+            }
+        } else if (status == D3D11Renderer::LutBakeStatus::Failed) {
+            m_uiManager->ShowNotification("LUT bake failed");
+        }
+    }
+    if (m_tiledExport) StepTiledExport();
+    m_cpuProfiler.AddStage(CpuStage::Render, renderStart, std::chrono::steady_clock::now());
+
+    // Render UI
+    if (drawUi) {
+        if (m_uiManager->NeedsRebuild(m_configManager.GetConfig().uiIdleRebuildHz)) {
+            SP_CPU_SCOPE(m_cpuProfiler, UiBuild);
+            m_uiManager->BeginFrame();
+            m_uiFrameOpen = true;
+            m_uiManager->Render();
+            m_uiFrameOpen = false;
+        }
+        SP_CPU_SCOPE(m_cpuProfiler, UiDraw);
+        GpuProfiler::Scope scope(gpuProfiler, GpuStage::ImGui);
+        m_uiManager->EndFrame();
+    }
+
+    // Reset event params after they have been visible for one frame
+    if (m_eventResetPending) {
+        m_eventResetPending = false;
+        ShaderPreset* preset = m_shaderManager->GetActivePreset();
+        if (preset) {
+            for (auto& p : preset->params) {
+                if (p.type == ShaderParamType::Event)
+                    p.values[0] = 0.0f;
+            }
+            float packed[16] = {};
+            ShaderManager::PackParamValues(*preset, packed);
+            m_renderer.SetCustomUniforms(packed, 16);
+            m_modulation.SetBase(packed);
+            float extended[MAX_EXTENDED_PARAM_FLOATS];
+            m_renderer.SetExtendedParams(extended, ShaderManager::PackExtendedParams(*preset, extended));
+        }
+    }
+
+    if (!nested) gpuProfiler.EndFrame();
+
+    // Present
+    if (drawUi) {
+        SP_CPU_SCOPE(m_cpuProfiler, Present);
+        m_renderer.Present(!m_exporting && !m_benchmark && !m_sessionReplaying && m_configManager.GetConfig().vsync);
+        m_uiPresentTime = now;
+    }
+    if (!nested) RunBackgroundWork();
+
+    // Live latency: from reading the frame's packet to this present returning.
+    // Averaged over roughly the last 30 frames, seeded by the first.
+    if (m_liveLatencyPending) {
+        m_liveLatencyPending = false;
+        const float ms = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - m_decodeWorker.GetPoppedPacketTime()).count();
+        m_liveLatencyMs = (m_liveLatencyMs == 0.0f) ? ms : m_liveLatencyMs + (ms - m_liveLatencyMs) / 30.0f;
+    }
+}
+
+void Application::RunBackgroundWork() {
+    const AppConfig& cfg = m_configManager.GetConfig();
+    // Slack: the last frames fitted the refresh interval on both processors, with
+    // room for the budget on the GPU. The benchmark measures playback alone.
+    const double intervalMs = 1000.0 / (m_outputRefreshHz > 0 ? m_outputRefreshHz : 60);
+    GpuProfiler& gpuProfiler = m_renderer.GetGpuProfiler();
+    GpuFrameTiming gpu;
+    CpuFrameTiming cpu;
+    const bool gpuBusy = gpuProfiler.IsEnabled() && gpuProfiler.GetLatest(gpu) &&
+                         gpu.totalMs + cfg.backgroundGpuBudgetMs > intervalMs;
+    const bool cpuLate = m_cpuProfiler.GetLatest(cpu) && cpu.frameMs > intervalMs * BACKGROUND_LATE_RATIO;
+    if (m_benchmark || gpuBusy || cpuLate) {
+        m_backgroundWork.Skip();
+        return;
+    }
+    SP_CPU_SCOPE(m_cpuProfiler, Background);
+    m_backgroundWork.Run(cfg.backgroundGpuBudgetMs, BACKGROUND_CPU_BUDGET_MS);
+}
+
+bool Application::OpenVideo(const std::string& filepath) {
+    RecordSessionEvent(SessionEventType::Open, {{"path", filepath}});
+    const std::vector<std::string>& playlist = m_configManager.GetConfig().playlist;
+    if (m_playlistIndex >= static_cast<int>(playlist.size()) ||
+        (m_playlistIndex >= 0 && playlist[m_playlistIndex] != filepath)) {
+        m_playlistIndex = -1;
+    }
+    CloseSpoutInput();
+    CloseNdiInput();
+    CloseMfCapture();
+    CloseStillImage();
+    // A new file drops the loop region; a reopen of this one keeps it (FinishOpenVideo)
+    if (filepath != m_videoPath) {
+        m_loopIn  = 0.0;
+        m_loopOut = 0.0;
+    }
+    m_loopReplaying = false;
+    // Reset prior state before opening — mirrors OpenCapture and prevents stale audio,
+    // playback time, and renderer video dimensions when replacing an already-open video.
+    m_playbackState  = PlaybackState::Stopped;
+    m_playbackTime   = 0.0f;
+    m_generativeTime = 0.0f;
+    m_currentFrame   = VideoFrame{};
+    m_showingCachedFrame = false;
+    m_decoderSeekPending = false;
+    m_playingBackward    = false;
+    ResetAudioAnalysis();
+    FlushAudioOutput();
+    m_renderer.ReleaseVideoTexture();  // Also clears the scrub cache
+    m_decodeWorker.Stop();
+    m_decoder.Close();
+    m_openResumeTime = 0.0;
+
+    if (StillImage::IsStillImage(filepath) && filepath != m_stillImageFallback &&
+        ImageSequence::FindFrames(filepath).empty()) {
+        return OpenStillImage(filepath);
+    }
+    StartVideoOpen(filepath);
+    return true;
+}
+
+void Application::StartVideoOpen(const std::string& filepath) {
+    // Probe off the UI thread; ProcessFrame calls FinishOpenVideo once it is done.
+    // Audio opens on its own reader thread meanwhile (non-fatal: many videos have none).
+    // The video half reads the edit proxy when there is one; audio always the source
+    const AppConfig& cfg = m_configManager.GetConfig();
+    const std::string playbackPath = PlaybackPathFor(filepath);
+    m_videoPath      = filepath;
+    m_usingEditProxy = (playbackPath != filepath);
+    m_editProxyReady = false;
+    // Probed ahead (the next playlist entry): open it now
+    const bool preopened = m_nextProbe.IsDone() && m_nextProbe.GetPath() == playbackPath;
+    if (!preopened) {
+        m_nextProbe.Cancel();
+        m_mediaProbe.Start(playbackPath, cfg.probeSizeKB, cfg.analyzeDurationMs, cfg.ioReadAheadMB);
+    }
+    m_audioReader.Open(filepath, m_audioPlayer->GetDeviceSampleRate());
+    RebuildAudioTimeline();
+    if (cfg.timelineOverview) m_mediaOverview.Build(filepath);
+    if (preopened) {
+        FinishOpenVideo(m_nextProbe);
+    } else {
+        m_uiManager->ShowNotification("Opening: " + std::filesystem::path(filepath).filename().string());
+    }
+}
+
+bool Application::OpenStillImage(const std::string& filepath) {
+    // Nothing to decode per frame: time runs by wall clock as for Spout input
+    m_mediaProbe.Cancel();
+    m_nextProbe.Cancel();
+    m_audioReader.Close();
+    m_audioTimeline.Reset();
+    m_mediaOverview.Reset();
+    m_videoPath      = filepath;
+    m_usingEditProxy = false;
+    m_editProxyReady = false;
+    m_stillImage.Load(filepath);
+    m_playbackState = PlaybackState::Playing;
+    m_lastFrameTime = PlaybackNow();
+    m_playOnOpen    = false;
+    return true;
+}
+
+void Application::PollStillImage() {
+    if (!m_stillImage.IsOpen()) return;
+    if (m_stillImage.Poll(m_renderer.GetDevice())) {
+        // Bound once; the texture never changes, so this is the only new frame
+        m_renderer.SetExternalVideo(m_stillImage.GetSRV(), m_stillImage.GetWidth(), m_stillImage.GetHeight());
+        m_newVideoFrame = true;
+        m_configManager.GetConfig().lastOpenedVideo = m_videoPath;
+        m_uiManager->ShowNotification("Opened: " + std::filesystem::path(m_videoPath).filename().string());
+    } else if (m_stillImage.HasFailed()) {
+        // Animated, or a format only FFmpeg reads: open it as a video instead
+        m_stillImageFallback = m_stillImage.GetPath();
+        CloseStillImage();
+        m_playbackState  = PlaybackState::Stopped;
+        m_generativeTime = 0.0f;
+        StartVideoOpen(m_stillImageFallback);
+    }
+}
+
+void Application::CloseStillImage() {
+    if (!m_stillImage.IsOpen()) return;
+    m_stillImage.Close();
+    m_renderer.ClearExternalVideo();
+}
+
+void Application::FinishOpenVideo(MediaProbe& probe) {
+    const std::string filepath = m_videoPath;
+    std::unique_ptr<MediaIO> io;
+    AVFormatContext* probed = probe.Take(io);
+    if (!probed || !m_decoder.Open(probe.GetPath(), probed, std::move(io))) {
+        m_audioReader.Close();
+        m_audioTimeline.Reset();
+        m_mediaOverview.Reset();
+        m_playOnOpen = false;
+        m_uiManager->ShowNotification("Failed to open video: " + filepath);
+        return;
+    }
+
+    m_frameDuration = 1.0 / m_decoder.GetFPS();
+    m_configManager.GetConfig().lastOpenedVideo = filepath;
+
+    // Decode first frame synchronously, then let the worker fill the queue behind it
+    m_decoder.DecodeNextFrame(m_currentFrame);
+    m_cacheCurrentFrame = true;
+    m_playbackState = PlaybackState::Paused;
+    m_decodeWorker.ResetStats();
+    m_renderer.GetScrubCache().ResetStats();
+    m_lateDrops = 0;
+    m_cadence   = CadenceStats{};
+    ResetSync();
+    m_decodeWorker.Start();
+
+    m_uiManager->ShowNotification("Opened: " + std::filesystem::path(filepath).filename().string() +
+                                  (m_usingEditProxy ? " (edit proxy)" : ""));
+    StartEditProxy();
+    ArmLoopCache();
+    if (m_openResumeTime > 0.0) {
+        SeekTo(m_openResumeTime);
+        m_openResumeTime = 0.0;
+    }
+    if (m_playOnOpen) {
+        m_playOnOpen = false;
+        Play();
+    }
+}
+
+bool Application::PlaylistAdvances() const {
+    return m_playlistIndex >= 0 && m_configManager.GetConfig().playlist.size() > 1;
+}
+
+void Application::PreopenPlaylistNext() {
+    if (!PlaylistAdvances() || m_playbackState != PlaybackState::Playing || m_playingBackward ||
+        m_nextProbe.IsActive() || m_mediaProbe.IsActive()) {
+        return;
+    }
+    if (m_decoder.GetDuration() - m_playbackTime > PLAYLIST_PREOPEN_SECONDS) return;
+
+    const AppConfig& cfg = m_configManager.GetConfig();
+    const std::string& next = cfg.playlist[(m_playlistIndex + 1) % cfg.playlist.size()];
+    m_nextProbe.Start(PlaybackPathFor(next), cfg.probeSizeKB, cfg.analyzeDurationMs, cfg.ioReadAheadMB);
+}
+
+void Application::PlayPlaylistItem(int index) {
+    const std::vector<std::string>& playlist = m_configManager.GetConfig().playlist;
+    if (index < 0 || index >= static_cast<int>(playlist.size())) return;
+    m_playlistIndex = index;
+    m_playOnOpen    = true;
+    OpenVideo(playlist[index]);
+}
+
+void Application::PlaylistEdited() {
+    if (m_playlistIndex < 0) return;
+    const std::vector<std::string>& playlist = m_configManager.GetConfig().playlist;
+    const auto it = std::find(playlist.begin(), playlist.end(), m_videoPath);
+    m_playlistIndex = (it != playlist.end()) ? static_cast<int>(it - playlist.begin()) : -1;
+}
+
+void Application::AddToPlaylistDialog() {
+    char filepath[MAX_PATH] = {};
+
+    OPENFILENAMEA ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = m_hwnd;
+    ofn.lpstrFilter = "Video Files\0*.mp4;*.mov;*.avi;*.mkv;*.webm;*.mxf\0All Files\0*.*\0";
+    ofn.lpstrFile = filepath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+
+    BeginModalLoop();
+    const bool chosen = GetOpenFileNameA(&ofn);
+    EndModalLoop();
+    if (chosen) {
+        m_configManager.GetConfig().playlist.push_back(filepath);
+        SaveConfig();
+    }
+}
+
+void Application::CloseVideo() {
+    CloseSpoutInput();
+    CloseNdiInput();
+    CloseMfCapture();
+    CloseStillImage();
+    m_mediaProbe.Cancel();
+    m_nextProbe.Cancel();
+    m_playlistIndex = -1;
+    m_playOnOpen    = false;
+    m_loopReplaying = false;
+    m_loopIn        = 0.0;
+    m_loopOut       = 0.0;
+    Stop();
+    FlushAudioOutput();
+    m_decodeWorker.Stop();
+    m_decoder.Close();
+    m_audioReader.Close();
+    m_audioTimeline.Reset();
+    m_mediaOverview.Reset();
+    m_currentFrame = VideoFrame{};
+    m_showingCachedFrame = false;
+    m_decoderSeekPending = false;
+    m_playingBackward    = false;
+    ResetAudioAnalysis();
+    // Reset renderer video dimensions so RenderToDisplay falls back
+    // to generative resolution. Without this, the stale m_videoWidth/Height causes
+    // the render target to be sized at the old video resolution, producing a tiny
+    // squished image in the top-left of the recording frame with green fill elsewhere.
+    m_renderer.ReleaseVideoTexture();
+    m_usingEditProxy = false;
+    m_editProxyReady = false;
+}
+
+void Application::OpenVideoDialog() {
+    char filepath[MAX_PATH] = {};
+
+    OPENFILENAMEA ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = m_hwnd;
+    ofn.lpstrFilter = "Video Files\0*.mp4;*.mov;*.avi;*.mkv;*.webm;*.mxf\0"
+                      "Image Sequences\0*.png;*.exr;*.tif;*.tiff;*.dpx;*.jpg;*.jpeg;*.bmp;*.tga;*.webp\0"
+                      "All Files\0*.*\0";
+    ofn.lpstrFile = filepath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+
+    BeginModalLoop();
+    const bool chosen = GetOpenFileNameA(&ofn);
+    EndModalLoop();
+    if (chosen) {
+        OpenVideo(filepath);
+    }
+}
+
+bool Application::OpenCapture(const std::string& deviceOrUrl, bool isDshow, const CaptureMode* mode) {
+    // Webcams open at their best mode unless the dialog picked one
+    std::vector<CaptureMode> modes;
+    if (isDshow && !mode) {
+        modes = CaptureDevices::EnumerateModes(deviceOrUrl);
+        mode  = CaptureDevices::PickBest(modes);
+    }
+    // Media Foundation first when enabled: its frames stay on the GPU
+    if (isDshow && m_configManager.GetConfig().mediaFoundationCapture) {
+        CloseVideo();
+        if (m_mfCapture.Open(m_renderer.GetDevice(), m_renderer.GetContext(), deviceOrUrl, mode)) {
+            m_generativeTime = 0.0f;
+            m_playbackState  = PlaybackState::Playing;
+            m_lastFrameTime  = PlaybackNow();
+            char format[64];
+            snprintf(format, sizeof(format), " (Media Foundation, %dx%d %.2f fps)", m_mfCapture.GetWidth(),
+                     m_mfCapture.GetHeight(), m_mfCapture.GetFps());
+            m_uiManager->ShowNotification("Live: " + deviceOrUrl + format);
+            return true;
+        }
+        m_uiManager->ShowNotification("Media Foundation can't open " + deviceOrUrl + ", trying DirectShow");
+    }
+
+    CloseSpoutInput();
+    CloseNdiInput();
+    CloseMfCapture();
+    CloseStillImage();
+    Stop();
+    m_generativeTime = 0.0f;
+    m_mediaProbe.Cancel();
+    m_nextProbe.Cancel();
+    m_playlistIndex = -1;
+    m_loopReplaying = false;
+    m_loopIn        = 0.0;
+    m_loopOut       = 0.0;
+    m_decodeWorker.Stop();
+    m_audioReader.Close();
+    m_audioTimeline.Reset();
+    m_mediaOverview.Reset();
+    m_playingBackward = false;
+    m_usingEditProxy  = false;
+    m_editProxyReady  = false;
+    m_renderer.GetScrubCache().Clear();  // Live frames are never cached
+
+    // URLs go through NetworkSource: connecting, buffering and reconnecting
+    // happen on its demux thread, never here
+    const AppConfig& cfg = m_configManager.GetConfig();
+    const bool opened = isDshow ? m_decoder.OpenCapture(deviceOrUrl, true, mode)
+                                : m_decoder.OpenNetwork(deviceOrUrl, cfg.networkJitterMs, cfg.networkTcp);
+    if (!opened) {
+        m_uiManager->ShowNotification("Failed to open capture: " + deviceOrUrl);
+        return false;
+    }
+
+    m_frameDuration = 1.0 / m_decoder.GetFPS();
+    m_playbackState = PlaybackState::Playing;
+    m_lastFrameTime = std::chrono::steady_clock::now();
+    m_liveLatencyMs = 0.0f;
+    m_liveLatencyPending = false;
+    m_decodeWorker.ResetStats();
+    m_decodeWorker.StartLive();
+
+    if (isDshow) {
+        // What the device actually delivers: the requested mode may have been refused
+        char format[96];
+        snprintf(format, sizeof(format), " (%dx%d %.2f fps %s)", m_decoder.GetWidth(), m_decoder.GetHeight(),
+                 m_decoder.GetFPS(), m_decoder.GetCodecName().c_str());
+        m_uiManager->ShowNotification("Live: " + deviceOrUrl + format);
+    } else {
+        m_uiManager->ShowNotification("Live: " + deviceOrUrl);
+    }
+    return true;
+}
+
+bool Application::OpenVideoInput(int index, const std::string& filepath) {
+    if (index < 0 || index >= MAX_VIDEO_INPUTS) return false;
+    CloseVideoInput(index);
+
+    // Split the cores with the main decoder and the other inputs
+    const AppConfig& cfg = m_configManager.GetConfig();
+    const int cores   = static_cast<int>(std::thread::hardware_concurrency());
+    const int threads = std::max(cores / (MAX_VIDEO_INPUTS + 1), 1);
+    if (!m_inputs[index].Open(filepath, threads, cfg.proxyScale)) {
+        m_uiManager->ShowNotification("Failed to open input: " + filepath);
+        return false;
+    }
+    m_inputs[index].Sync(m_playbackTime);
+
+    auto& paths = m_configManager.GetConfig().videoInputs;
+    if (static_cast<int>(paths.size()) <= index) paths.resize(index + 1);
+    paths[index] = filepath;
+    return true;
+}
+
+void Application::CloseVideoInput(int index) {
+    if (index < 0 || index >= MAX_VIDEO_INPUTS) return;
+    m_inputs[index].Close();
+    m_renderer.ReleaseInputTexture(index);
+    auto& paths = m_configManager.GetConfig().videoInputs;
+    if (index < static_cast<int>(paths.size())) paths[index].clear();
+}
+
+void Application::OpenVideoInputDialog(int index) {
+    char filepath[MAX_PATH] = {};
+
+    OPENFILENAMEA ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = m_hwnd;
+    ofn.lpstrFilter = "Video Files\0*.mp4;*.mov;*.avi;*.mkv;*.webm;*.mxf\0All Files\0*.*\0";
+    ofn.lpstrFile = filepath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+
+    BeginModalLoop();
+    const bool chosen = GetOpenFileNameA(&ofn);
+    EndModalLoop();
+    if (chosen) {
+        OpenVideoInput(index, filepath);
+    }
+}
+
+bool Application::OpenLut(int index, const std::string& filepath) {
+    if (index < 0 || index >= MAX_LUTS) return false;
+    ColorLut lut;
+    std::string error;
+    if (!LoadColorLut(filepath, lut, error)) {
+        m_uiManager->ShowNotification("Failed to load LUT: " + error);
+        return false;
+    }
+    if (!m_renderer.SetLut(index, &lut)) {
+        m_uiManager->ShowNotification("Failed to create LUT texture: " + filepath);
+        return false;
+    }
+    m_lutSizes[index] = lut.size;
+
+    auto& paths = m_configManager.GetConfig().lutFiles;
+    if (static_cast<int>(paths.size()) <= index) paths.resize(index + 1);
+    paths[index] = filepath;
+    return true;
+}
+
+void Application::CloseLut(int index) {
+    if (index < 0 || index >= MAX_LUTS) return;
+    m_renderer.SetLut(index, nullptr);
+    m_lutSizes[index] = 0;
+    auto& paths = m_configManager.GetConfig().lutFiles;
+    if (index < static_cast<int>(paths.size())) paths[index].clear();
+}
+
+void Application::OpenLutDialog(int index) {
+    char filepath[MAX_PATH] = {};
+
+    OPENFILENAMEA ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = m_hwnd;
+    ofn.lpstrFilter = "LUT Files\0*.cube;*.3dl\0All Files\0*.*\0";
+    ofn.lpstrFile = filepath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+
+    BeginModalLoop();
+    const bool chosen = GetOpenFileNameA(&ofn);
+    EndModalLoop();
+    if (chosen) {
+        OpenLut(index, filepath);
+    }
+}
+
+void Application::StartAutomationRecording() {
+    if (m_automation.IsRecording() || !m_shaderManager->GetActivePreset()) return;
+    m_automation.Start(m_shaderManager->GetActivePresetIndex());
+}
+
+void Application::StopAutomationRecording() {
+    if (!m_automation.IsRecording()) return;
+    ShaderPreset* preset = m_shaderManager->GetPreset(m_automation.GetPresetIndex());
+    if (!preset) {
+        m_automation.Cancel();
+        return;
+    }
+    const int params = m_automation.GetLatchedCount();
+    const int keys   = m_automation.Stop(*preset);
+    if (params > 0) {
+        m_uiManager->ShowNotification("Automation: " + std::to_string(keys) + " keys on " + std::to_string(params) +
+                                      (params == 1 ? " param" : " params"));
+    }
+}
+
+void Application::BakeLutDialog(int size) {
+    if (!m_shaderManager->GetActivePreset()) return;
+    char filepath[MAX_PATH] = {};
+
+    OPENFILENAMEA ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = m_hwnd;
+    ofn.lpstrFilter = "Cube LUT\0*.cube\0All Files\0*.*\0";
+    ofn.lpstrFile = filepath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.lpstrDefExt = "cube";
+    ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
+
+    BeginModalLoop();
+    const bool chosen = GetSaveFileNameA(&ofn);
+    EndModalLoop();
+    if (chosen) {
+        // Baked from RenderFrame, where the pipeline state is the frame's
+        m_pendingLutBakeSize = std::clamp(size, MIN_LUT_SIZE, MAX_LUT_SIZE);
+        m_pendingLutBakePath = filepath;
+    }
+}
+
+void Application::ExportTiledStillDialog(int width, int height, int tileSize) {
+    if (m_tiledExport || !m_shaderManager->GetActivePreset()) return;
+    width    = std::clamp(width,  1, D3D11Renderer::MAX_CANVAS_SIZE);
+    height   = std::clamp(height, 1, D3D11Renderer::MAX_CANVAS_SIZE);
+    tileSize = std::clamp(tileSize, D3D11Renderer::MIN_TILE_SIZE, D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION);
+    char filepath[MAX_PATH] = {};
+
+    OPENFILENAMEA ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = m_hwnd;
+    ofn.lpstrFilter = "PNG\0*.png\0TIFF\0*.tif;*.tiff\0OpenEXR\0*.exr\0";
+    ofn.lpstrFile = filepath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.lpstrDefExt = "png";
+    ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
+
+    BeginModalLoop();
+    const bool chosen = GetSaveFileNameA(&ofn);
+    EndModalLoop();
+    if (!chosen) return;
+
+    // Equal tiles, so the writer never scales one; the last column and row are
+    // shifted back inside the canvas and overlap their neighbours
+    auto tiled = std::make_unique<TiledExport>();
+    tiled->path       = filepath;
+    tiled->time       = m_playbackTime;
+    tiled->width      = width;
+    tiled->height     = height;
+    tiled->columns    = (width  + tileSize - 1) / tileSize;
+    tiled->rows       = (height + tileSize - 1) / tileSize;
+    tiled->tileWidth  = (width  + tiled->columns - 1) / tiled->columns;
+    tiled->tileHeight = (height + tiled->rows    - 1) / tiled->rows;
+    if (!tiled->writer.Start(tiled->path, tiled->tileWidth, tiled->tileHeight, true)) {
+        m_uiManager->ShowNotification("Tiled export failed: unsupported image format");
+        return;
+    }
+    m_tiledExport = std::move(tiled);
+}
+
+float Application::GetTiledExportProgress() const {
+    if (!m_tiledExport) return 0.0f;
+    const int total = m_tiledExport->columns * m_tiledExport->rows;
+    return static_cast<float>(m_tiledExport->writer.GetFramesWritten()) / static_cast<float>(total);
+}
+
+void Application::StepTiledExport() {
+    TiledExport& tiled = *m_tiledExport;
+    const int total = tiled.columns * tiled.rows;
+    if (tiled.next < total) {
+        const int x = std::min((tiled.next % tiled.columns) * tiled.tileWidth, tiled.width - tiled.tileWidth);
+        const int y = std::min((tiled.next / tiled.columns) * tiled.tileHeight, tiled.height - tiled.tileHeight);
+        FrameBuffer tile;
+        const bool drawn = m_renderer.RenderCanvasTile(tiled.width, tiled.height, x, y, tiled.tileWidth,
+                                                       tiled.tileHeight, tiled.time, tiled.pool, tile);
+        m_renderer.BeginFrame();  // The tile's draw changed the targets and viewport
+        if (!drawn || !tiled.writer.Submit(std::move(tile), tiled.tileWidth, tiled.tileHeight)) {
+            tiled.writer.Stop();
+            tiled.writer.Join();
+            m_tiledExport.reset();
+            m_uiManager->ShowNotification("Tiled export failed (render graphs and compute presets can't be tiled)");
+            return;
+        }
+        tiled.tiles.push_back({{"index", tiled.next}, {"x", x}, {"y", y}});
+        ++tiled.next;
+        return;
+    }
+
+    // All submitted: finish once the workers have written them
+    if (tiled.writer.GetFramesWritten() + tiled.writer.GetFramesFailed() < total) return;
+    tiled.writer.Stop();
+    tiled.writer.Join();
+    const std::filesystem::path path(tiled.path);
+    const std::filesystem::path manifestPath = path.parent_path() / (path.stem().string() + "_tiles.json");
+    const nlohmann::json manifest = {
+        {"width",      tiled.width},
+        {"height",     tiled.height},
+        {"tileWidth",  tiled.tileWidth},
+        {"tileHeight", tiled.tileHeight},
+        {"columns",    tiled.columns},
+        {"rows",       tiled.rows},
+        {"tiles",      tiled.tiles},
+    };
+    std::ofstream file(manifestPath);
+    file << manifest.dump(2);
+    if (tiled.writer.GetFramesFailed() > 0 || !file) {
+        m_uiManager->ShowNotification("Tiled export failed writing " + path.filename().string());
+    } else {
+        m_uiManager->ShowNotification("Tiled still exported: " + manifestPath.filename().string());
+    }
+    m_tiledExport.reset();
+}
+
+void Application::OpenCaptureDialog() {
+    m_uiManager->ShowCaptureDialog();
+}
+
+void Application::Play() {
+    // A scrub-cache hit left the decoder at the previous position; catch it up.
+    // Otherwise re-align audio: Pause flushed whatever the player had queued.
+    if (m_loopReplaying) {
+        // Still replaying the loop region from VRAM: restart its clock here
+        m_audioReader.Seek(m_playbackTime);
+        m_loopAnchorTime = m_playbackTime;
+        m_loopAnchorWall = PlaybackNow();
+    } else if (m_decoderSeekPending) {
+        SeekDecoder(m_pendingSeekTime);
+    } else {
+        m_audioReader.Seek(m_currentFrame.timestamp);
+    }
+    if (m_decoder.IsOpen() && !m_decoder.IsLiveCapture() &&
+        m_playDirection == PlaybackDirection::Reverse && !m_playingBackward) {
+        RestartDecodeWorker(true);
+    }
+    m_playbackState = PlaybackState::Playing;
+    m_lastFrameTime = PlaybackNow();
+    ResetSync();
+    RecordSessionEvent(SessionEventType::Playback, {{"state", "playing"}});
+}
+
+void Application::Pause() {
+    RecordSessionEvent(SessionEventType::Playback, {{"state", "paused"}});
+    m_playbackState = PlaybackState::Paused;
+    FlushAudioOutput();
+    ResetSync();
+}
+
+void Application::Stop() {
+    RecordSessionEvent(SessionEventType::Playback, {{"state", "stopped"}});
+    m_playbackState = PlaybackState::Stopped;
+    FlushAudioOutput();
+    ResetSync();
+    m_loopReplaying = false;  // The rewind below seeks the decoder anyway
+    m_renderer.GetRenderAhead().Clear();
+    m_scrubbing       = false;
+    m_scrubResumePlay = false;
+    m_scrubRefineDue  = false;
+    m_scrubRefining   = false;
+    m_scrubKeyframe   = -1;
+    // Rewinding always leaves the worker decoding forward; Play() re-enters reverse
+    const bool wasBackward = m_playingBackward;
+    if (wasBackward) {
+        m_decodeWorker.Stop();
+        m_playingBackward = false;
+    }
+    if (m_decoder.IsOpen()) {
+        {
+            auto lock = m_decodeWorker.LockDecoder();
+            m_decoder.SeekToTime(0.0);
+            m_decodeWorker.DiscardQueued();
+            m_decoder.DecodeNextFrame(m_currentFrame);
+        }
+        m_cacheCurrentFrame = true;
+        if (wasBackward) m_decodeWorker.Start();
+        m_audioReader.Seek(0.0);
+    }
+    m_showingCachedFrame = false;
+    m_decoderSeekPending = false;
+    m_playbackTime = 0.0f;
+    m_generativeTime = 0.0f;
+}
+
+void Application::TogglePlayback() {
+    if (m_playbackState == PlaybackState::Playing) {
+        Pause();
+    } else {
+        Play();
+    }
+}
+
+void Application::SeekTo(double seconds) {
+    RecordSessionEvent(SessionEventType::Seek, {{"time", seconds}});
+    if (m_decoder.IsOpen()) {
+        m_loopReplaying = false;  // The seek below replaces the replay's pending one
+        m_renderer.GetRenderAhead().Clear();
+        FlushAudioOutput();
+        const int64_t key = FrameKey(m_decoder.SnapToFrameTime(seconds));
+        if (!m_decoder.IsLiveCapture() && m_renderer.ShowCachedVideoFrame(key)) {
+            // Scrub-cache hit: no seek or decode now; Play() re-syncs the decoder
+            m_showingCachedFrame = true;
+            m_decoderSeekPending = true;
+            m_pendingSeekTime    = seconds;
+        } else {
+            SeekDecoder(seconds);
+        }
+        m_playbackTime = static_cast<float>(seconds);
+        ResetAudioAnalysis();
+    }
+}
+
+void Application::ScrubTo(double seconds) {
+    if (!m_decoder.IsOpen() || m_decoder.IsLiveCapture() || m_playingBackward) {
+        SeekTo(seconds);
+        return;
+    }
+    RecordSessionEvent(SessionEventType::Seek, {{"time", seconds}});
+    if (m_playbackState == PlaybackState::Playing) {
+        Pause();
+        m_scrubResumePlay = true;
+    }
+    m_scrubbing     = true;
+    m_loopReplaying = false;
+    m_renderer.GetRenderAhead().Clear();
+    FlushAudioOutput();
+    ResetAudioAnalysis();
+    m_playbackTime       = static_cast<float>(seconds);
+    m_decoderSeekPending = true;  // Until the refined frame is in, or Play() seeks
+    m_pendingSeekTime    = seconds;
+    m_scrubRefining      = false;
+
+    if (m_renderer.ShowCachedVideoFrame(FrameKey(m_decoder.SnapToFrameTime(seconds)))) {
+        m_showingCachedFrame = true;
+        m_scrubRefineDue     = false;
+        return;
+    }
+
+    // Preview: the keyframe at or before the target, one decode with nothing to
+    // discard. Within the GOP already on screen there is nothing newer to show.
+    const int64_t keyframe = m_decoder.GetKeyframeBefore(m_decoder.FrameNumberAt(seconds));
+    if (keyframe < 0 || keyframe != m_scrubKeyframe || m_showingCachedFrame) {
+        m_decoder.CancelSeek();  // A refine still discarding towards the last target
+        {
+            auto lock = m_decodeWorker.LockDecoder();
+            m_decoder.SeekToTime(seconds);
+            m_decodeWorker.DiscardQueued();
+            m_decoder.DecodeNextFrame(m_currentFrame);
+        }
+        m_cacheCurrentFrame  = true;
+        m_showingCachedFrame = false;
+        m_scrubKeyframe      = keyframe;
+    }
+    m_scrubRefineDue = true;
+    m_scrubRefineAt  = std::chrono::steady_clock::now() +
+                       std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                           std::chrono::duration<double>(SCRUB_REFINE_DELAY));
+}
+
+void Application::EndScrub() {
+    if (!m_scrubbing) return;
+    m_scrubbing = false;
+    if (m_scrubResumePlay) {
+        // Play() does the exact seek itself (m_decoderSeekPending)
+        m_scrubResumePlay = false;
+        m_scrubRefineDue  = false;
+        Play();
+    } else if (m_scrubRefineDue) {
+        RefineScrub();
+    }
+}
+
+void Application::RefineScrub() {
+    m_scrubRefineDue = false;
+    m_decoder.CancelSeek();
+    {
+        auto lock = m_decodeWorker.LockDecoder();
+        m_decoder.SeekToTimeExact(m_pendingSeekTime);
+        m_decodeWorker.DiscardQueued();
+    }
+    m_audioReader.Seek(m_pendingSeekTime);
+    m_scrubRefining = true;
+}
+
+void Application::StepScrub() {
+    if (m_scrubRefineDue && std::chrono::steady_clock::now() >= m_scrubRefineAt) RefineScrub();
+    double next;
+    if (!m_scrubRefining || !m_decodeWorker.PeekNextTimestamp(next) || !m_decodeWorker.PopFrame(m_currentFrame))
+        return;
+    // The worker's first frame after the exact seek is the target
+    m_scrubRefining      = false;
+    m_scrubKeyframe      = -1;
+    m_decoderSeekPending = false;
+    m_cacheCurrentFrame  = true;
+    m_showingCachedFrame = false;
+    m_newVideoFrame      = true;
+}
+
+void Application::SeekDecoder(double seconds, bool seekAudio) {
+    ResetSync();
+    m_renderer.GetRenderAhead().Clear();  // Frames from the old position
+    // A background refine or catch-up still discarding gives up the decoder lock
+    m_decoder.CancelSeek();
+    m_scrubRefineDue = false;
+    m_scrubRefining  = false;
+    m_scrubKeyframe  = -1;
+    // Reverse chunks can't be partially discarded — restart reverse from the target
+    if (m_playingBackward) m_decodeWorker.Stop();
+    {
+        auto lock = m_decodeWorker.LockDecoder();
+        m_decoder.SeekToTimeExact(seconds);
+        m_decodeWorker.DiscardQueued();
+        m_decoder.DecodeNextFrame(m_currentFrame);
+    }
+    if (seekAudio) m_audioReader.Seek(seconds);
+    m_cacheCurrentFrame  = true;
+    m_showingCachedFrame = false;
+    m_decoderSeekPending = false;
+    if (m_playingBackward) {
+        m_decodeWorker.StartReverse(m_decoder.FrameNumberAt(m_currentFrame.timestamp), ReverseBudgetBytes());
+    }
+}
+
+void Application::SetPlaybackDirection(PlaybackDirection direction) {
+    m_playDirection = direction;
+    if (direction != PlaybackDirection::Forward) StopLoopReplay();
+    if (!m_decoder.IsOpen() || m_decoder.IsLiveCapture()) return;
+
+    // Switch the worker now only if playing; Play() picks Reverse up otherwise.
+    // PingPong keeps the current leg and bounces at the next end.
+    const bool wantBackward = (direction == PlaybackDirection::Reverse) ||
+                              (direction == PlaybackDirection::PingPong && m_playingBackward);
+    if (wantBackward != m_playingBackward &&
+        (m_playbackState == PlaybackState::Playing || !wantBackward)) {
+        if (m_decoderSeekPending) SeekDecoder(m_pendingSeekTime);
+        RestartDecodeWorker(wantBackward);
+    }
+}
+
+void Application::RestartDecodeWorker(bool backward) {
+    const int64_t current = m_decoder.FrameNumberAt(m_currentFrame.timestamp);
+    m_decodeWorker.Stop();
+    ResetSync();
+    m_playingBackward = backward;
+    FlushAudioOutput();
+    ResetAudioAnalysis();
+
+    if (backward) {
+        m_decodeWorker.StartReverse(current, ReverseBudgetBytes());
+    } else {
+        // Reverse left the decoder somewhere inside an earlier GOP; resume after
+        // the frame on screen.
+        m_decoder.SeekToFrame(current + 1);
+        m_decodeWorker.Start();
+        m_audioReader.Seek(m_currentFrame.timestamp + m_frameDuration);
+    }
+}
+
+size_t Application::ReverseBudgetBytes() const {
+    return static_cast<size_t>(std::max(m_configManager.GetConfig().reverseCacheMB, 64)) * 1024 * 1024;
+}
+
+int64_t Application::FrameKey(double frameTime) const {
+    return static_cast<int64_t>(std::llround(frameTime * m_decoder.GetFPS()));
+}
+
+void Application::SetScrubCacheBudget(int megabytes) {
+    m_configManager.GetConfig().scrubCacheMB = megabytes;
+    m_renderer.GetScrubCache().SetBudgetMB(megabytes);
+}
+
+void Application::GetMemoryUsage(std::vector<MemoryUsage>& out) const {
+    m_renderer.GetMemoryUsage(out);
+    out.push_back({"Library thumbnails", 0, m_thumbnails.GetBytes()});
+    out.push_back({"Timeline overview", m_mediaOverview.GetCpuBytes(), m_mediaOverview.GetGpuBytes()});
+    if (m_stillImage.IsOpen()) out.push_back({"Still image", 0, m_stillImage.GetGpuBytes()});
+
+    // Decoded frames ahead of the playhead: RGBA, or native planes at about two
+    // bytes a pixel; hardware frames are decoder surfaces on the GPU
+    if (m_decoder.IsOpen()) {
+        const size_t pixels = static_cast<size_t>(m_decoder.GetWidth()) * m_decoder.GetHeight();
+        const size_t frame  = pixels * (m_decoder.IsGpuYuvFrame() ? 2 : 4);
+        const size_t queued = static_cast<size_t>(m_decodeWorker.GetQueueDepth()) * frame;
+        if (m_decoder.IsHardwareAccelerated()) out.push_back({"Decoded frame queue", 0, queued});
+        else                                   out.push_back({"Decoded frame queue", queued, 0});
+        if (const ImageSequence* sequence = m_decoder.GetImageSequence())
+            out.push_back({"Image sequence cache", static_cast<size_t>(sequence->GetResidentFrames()) * pixels * 4, 0});
+    }
+    out.push_back({"Audio decode queue",
+                   static_cast<size_t>(m_audioReader.GetBufferedSamples()) * AUDIO_CHANNELS * sizeof(float), 0});
+    out.push_back({"Audio output ring", m_audioPlayer->GetRingBytes(), 0});
+
+    // Every recording target, summed
+    MemoryUsage frames{"Encoder frame queue"}, audio{"Encoder audio pending"}, write{"Encoder write buffer"},
+                send{"Stream send queue"}, replay{"Replay buffer"};
+    auto add = [&](const VideoEncoder& encoder) {
+        frames.cpuBytes += encoder.GetFramePool().GetAllocatedBytes();
+        audio.cpuBytes  += encoder.GetPendingAudioBytes();
+        write.cpuBytes  += encoder.GetWriter().GetQueuedBytes();
+        send.cpuBytes   += encoder.GetSendQueuedBytes();
+        replay.cpuBytes += encoder.GetReplayBuffer().GetBufferedBytes();
+    };
+    add(m_encoder);
+    for (const auto& encoder : m_extraEncoders) add(*encoder);
+    out.insert(out.end(), {frames, audio, write, send, replay});
+}
+
+void Application::UpdateMemoryBudget() {
+    if (!m_renderer.TakeVideoMemoryBudgetChange()) return;
+    const VideoMemoryInfo info = m_renderer.QueryVideoMemory();
+    if (info.localBudget == 0) return;
+    const AppConfig& cfg = m_configManager.GetConfig();
+    if (info.localUsage > info.localBudget) {
+        const uint64_t over = info.localUsage - info.localBudget;
+        uint64_t freed = m_renderer.ShrinkCaches(over);
+        m_memoryPressure = true;
+        if (freed < over && m_renderer.GetLoopCache().GetUsedBytes() > 0) {
+            freed += m_renderer.GetLoopCache().GetUsedBytes();
+            ArmLoopCache();  // Uncached at a zero budget; playback decodes the region again
+        }
+        m_uiManager->ShowNotification("Video memory budget lowered: freed " + std::to_string(freed >> 20) +
+                                      " MB of caches");
+    } else if (m_memoryPressure) {
+        // Back once the configured caches fit in what is free again
+        const uint64_t wanted = (static_cast<uint64_t>(cfg.scrubCacheMB) + cfg.loopCacheMB) << 20;
+        if (info.localBudget - info.localUsage < wanted) return;
+        m_memoryPressure = false;
+        m_renderer.GetScrubCache().SetBudgetMB(cfg.scrubCacheMB);
+        ArmLoopCache();
+    }
+}
+
+void Application::SetHardwareDecode(bool enabled) {
+    m_configManager.GetConfig().hardwareDecode = enabled;
+    m_decoder.SetHardwareDevice(enabled ? m_renderer.GetDevice() : nullptr);
+    ReopenCurrentVideo();
+}
+
+void Application::SetHwDecodePolicy(const std::string& codec, HwDecodePolicy policy) {
+    auto& policies = m_configManager.GetConfig().hwDecodePolicy;
+    if (policy == HwDecodePolicy::Auto) policies.erase(codec);
+    else                                policies[codec] = static_cast<int>(policy);
+    m_decoder.SetHardwareDecodePolicy(HwDecodePolicies(m_configManager.GetConfig()));
+    ReopenCurrentVideo();
+}
+
+void Application::SetDecodeThreading(int threadCount, int threadType) {
+    m_configManager.GetConfig().decodeThreadCount = threadCount;
+    m_configManager.GetConfig().decodeThreadType  = threadType;
+    m_decoder.SetDecodeThreading(threadCount, threadType);
+    ReopenCurrentVideo();
+}
+
+void Application::SetProxyScale(int scale) {
+    m_configManager.GetConfig().proxyScale = scale;
+    ApplyProxySettings();
+}
+
+void Application::ApplyProxySettings() {
+    const int scale = m_encoder.IsRecording() ? 1 : m_configManager.GetConfig().proxyScale;
+    const bool fileOpen = m_decoder.IsOpen() && !m_decoder.IsLiveCapture();
+    const bool proxyChanged = fileOpen &&
+        (PlaybackPathFor(m_videoPath) != m_videoPath) != m_usingEditProxy;
+    if (scale == m_decoder.GetProxyScale() && !proxyChanged) return;
+    m_decoder.SetProxyScale(scale);
+    ReopenCurrentVideo();
+}
+
+void Application::SetEditProxies(bool enabled) {
+    m_configManager.GetConfig().editProxies = enabled;
+    if (enabled) {
+        StartEditProxy();
+    } else {
+        m_proxyTranscoder.Cancel();
+    }
+    ApplyProxySettings();
+}
+
+void Application::SetImageSequenceOptions(double fps, int cacheMB) {
+    m_configManager.GetConfig().imageSequenceFps     = fps;
+    m_configManager.GetConfig().imageSequenceCacheMB = cacheMB;
+    m_decoder.SetImageSequenceOptions(fps, cacheMB);
+    if (m_decoder.GetImageSequence()) ReopenCurrentVideo();
+}
+
+std::string Application::PlaybackPathFor(const std::string& source) const {
+    const AppConfig& cfg = m_configManager.GetConfig();
+    if (!cfg.editProxies || m_encoder.IsRecording()) return source;
+    const std::string proxy = ProxyTranscoder::FindProxy(source, cfg.proxyCacheDirectory);
+    return proxy.empty() ? source : proxy;
+}
+
+void Application::StartEditProxy() {
+    // Only long-GOP files gain anything; intra-only sources already seek in one decode
+    const AppConfig& cfg = m_configManager.GetConfig();
+    if (!cfg.editProxies || m_usingEditProxy || !m_decoder.IsOpen() ||
+        m_decoder.IsLiveCapture() || m_decoder.IsIntraOnly() || !MediaIO::IsLocalPath(m_videoPath)) {
+        return;
+    }
+    if (m_proxyTranscoder.IsRunning() && m_proxyTranscoder.GetSourcePath() == m_videoPath) return;
+    if (!ProxyTranscoder::FindProxy(m_videoPath, cfg.proxyCacheDirectory).empty()) return;
+    m_proxyTranscoder.Start(m_videoPath, cfg.proxyCacheDirectory);
+}
+
+void Application::ReopenCurrentVideo() {
+    // Decoder setup is chosen at open time — reopen the current file in place.
+    if (m_decoder.IsOpen() && !m_decoder.IsLiveCapture()) {
+        const std::string path = m_configManager.GetConfig().lastOpenedVideo;
+        const double resumeAt  = m_playbackTime;
+        if (OpenVideo(path)) {
+            m_openResumeTime = resumeAt;  // Applied by FinishOpenVideo
+        }
+    }
+}
+
+void Application::SetGpuYuvConversion(bool enabled) {
+    m_configManager.GetConfig().gpuYuvConversion = enabled;
+    m_decoder.SetGpuYuvConversion(enabled);
+}
+
+void Application::SetVideoProcessorConversion(bool enabled) {
+    m_configManager.GetConfig().videoProcessorConversion = enabled;
+    m_renderer.SetVideoProcessorConversion(enabled);
+}
+
+void Application::SetHighBitDepth(bool enabled) {
+    m_configManager.GetConfig().highBitDepth = enabled;
+    m_renderer.SetHighBitDepth(enabled);
+}
+
+void Application::SetAudioVolume(float vol) {
+    m_configManager.GetConfig().audioVolume = vol;
+    m_audioPlayer->SetVolume(vol);
+}
+
+void Application::SetAudioLowLatency(bool enabled) {
+    m_configManager.GetConfig().audioLowLatency = enabled;
+    InitAudioOutput();
+    SaveConfig();
+}
+
+void Application::InitAudioOutput() {
+    FinishStartupTasks(true);  // The startup player would replace this one
+    const int oldRate = m_audioPlayer->GetDeviceSampleRate();
+    FlushAudioOutput();
+    m_audioPlayer->Shutdown();
+    m_audioPlayer->Initialize(m_configManager.GetConfig().audioLowLatency);
+    OnAudioOutputOpened(oldRate);
+}
+
+void Application::OnAudioOutputOpened(int oldRate) {
+    const AppConfig& cfg = m_configManager.GetConfig();
+    if (m_audioPlayer->IsInitialized()) {
+        m_audioPlayer->SetVolume(cfg.audioVolume);
+        m_audioPlayer->SetMute(cfg.muteAudio);
+    }
+
+    // The flush dropped what the reader had handed out, so start it over at the
+    // frame on screen. An exclusive-mode device may run at another rate, which the
+    // reader resamples to at open.
+    const bool fileOpen = m_mediaProbe.IsActive() || (m_decoder.IsOpen() && !m_decoder.IsLiveCapture());
+    if (!fileOpen || m_videoPath.empty()) return;
+    if (m_audioPlayer->GetDeviceSampleRate() != oldRate) {
+        m_audioReader.Open(m_videoPath, m_audioPlayer->GetDeviceSampleRate());
+        m_audioReader.SetLoopRegion(m_loopIn, m_loopOut);
+    }
+    m_audioReader.Seek(m_decoder.IsOpen() ? m_currentFrame.timestamp : m_playbackTime);
+}
+
+void Application::StartStartupTasks() {
+    // Non-fatal, each: no audio device on a headless system, Spout not installed
+    const bool lowLatency = m_configManager.GetConfig().audioLowLatency;
+    m_audioStartup = std::async(std::launch::async, [lowLatency] {
+        TraceRecorder::SetThreadName("Startup audio");
+        auto player = std::make_unique<AudioPlayer>();
+        player->Initialize(lowLatency);
+        return player;
+    });
+    ID3D11Device* device = m_renderer.GetDevice();
+    m_spoutStartup = std::async(std::launch::async, [device] {
+        TraceRecorder::SetThreadName("Startup Spout");
+        auto spout = std::make_unique<SpoutOutput>();
+        if (!spout->Initialize(device)) spout.reset();
+        return spout;
+    });
+    // The kernels compile here; the dispatch needs the immediate context
+    m_noiseStartup = std::async(std::launch::async, [this] {
+        TraceRecorder::SetThreadName("Startup noise");
+        m_renderer.PrecompileNoiseShaders();
+    });
+}
+
+void Application::FinishStartupTasks(bool wait) {
+    auto ready = [wait](const auto& task) {
+        return task.valid() && (wait || task.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    };
+    if (ready(m_audioStartup)) {
+        // Opened before it: the reader decodes at the file's rate until reopened at the device's
+        const int oldRate = m_audioPlayer->GetDeviceSampleRate();
+        FlushAudioOutput();
+        m_audioPlayer = m_audioStartup.get();
+        OnAudioOutputOpened(oldRate);
+    }
+    if (ready(m_spoutStartup)) {
+        if (std::unique_ptr<SpoutOutput> spout = m_spoutStartup.get()) {
+            const AppConfig& cfg = m_configManager.GetConfig();
+            m_spoutOutput = std::move(spout);
+            m_spoutOutput->SetSenderName(cfg.spoutSenderName);
+            m_spoutOutput->SetOutputSize(cfg.spoutWidth, cfg.spoutHeight);
+            m_spoutOutput->SetEnabled(cfg.spoutEnabled);
+            ApplySpoutPass();
+        }
+    }
+    if (ready(m_noiseStartup)) {
+        m_noiseStartup.get();
+        // Bound globally as t1/s1 for all shaders
+        const AppConfig& cfg = m_configManager.GetConfig();
+        m_renderer.UpdateNoiseTexture(cfg.noise.scale, cfg.noise.textureSize, cfg.noise.volumeSize);
+    }
+}
+
+void Application::SetAudioMute(bool mute) {
+    m_configManager.GetConfig().muteAudio = mute;
+    m_audioPlayer->SetMute(mute);
+}
+
+bool Application::CompileCurrentShader(const std::string& source) {
+    // Compiles run on the ShaderManager pool so the output keeps playing; the
+    // current shader stays live until CheckEditorCompile sees the result land.
+    // Compiling again before then supersedes the pending compile.
+    int activeIndex = m_shaderManager->GetActivePresetIndex();
+    auto* preset = m_shaderManager->GetActivePreset();
+    if (preset) {
+        preset->source = source;
+        m_shaderManager->RecompilePresetAsync(activeIndex);
+        if (m_editorCompileIndex != activeIndex) m_editorCompileAdded = false;
+        m_editorCompileIndex = activeIndex;
+    } else {
+        // No active preset — compile the editor content into a new preset.
+        // It is active (passthrough) at once so further edits recompile it.
+        ShaderPreset newPreset;
+        newPreset.name = "Untitled";
+        newPreset.source = source;
+        int idx = m_shaderManager->AddPreset(newPreset, true);
+        m_shaderManager->SetActivePreset(idx);
+        m_editorCompileIndex = idx;
+        m_editorCompileAdded = true;
+    }
+    return true;
+}
+
+void Application::CheckEditorCompile() {
+    if (m_editorCompileIndex < 0) return;
+    // Switching or removing presets meanwhile abandons the report
+    if (m_shaderManager->GetActivePresetIndex() != m_editorCompileIndex) {
+        m_editorCompileIndex = -1;
+        return;
+    }
+    auto* preset = m_shaderManager->GetPreset(m_editorCompileIndex);
+    if (!preset || preset->isCompiling) return;
+
+    if (preset->isValid) {
+        // PollCompiles has already re-applied it to the renderer
+        m_uiManager->ResetKeyframeSelection();
+        OnParamChanged();
+        m_uiManager->ShowNotification("Shader compiled successfully");
+    } else {
+        m_uiManager->ShowNotification("Shader compilation failed: " +
+            (preset->compileError.empty() ? "unknown error" : preset->compileError.substr(0, 80)));
+        if (m_editorCompileAdded) m_shaderManager->RemovePreset(m_editorCompileIndex);
+    }
+    m_editorCompileIndex = -1;
+    m_editorCompileAdded = false;
+}
+
+bool Application::SaveCurrentShader(const std::string& source) {
+    auto* preset = m_shaderManager->GetActivePreset();
+    if (!preset) {
+        SaveShaderAsDialog(source);
+        return true;
+    }
+
+    preset->source = source;
+
+    if (!preset->filepath.empty()) {
+        std::ofstream file(preset->filepath);
+        if (file.is_open()) {
+            file << source;
+            m_uiManager->ShowNotification("Shader saved: " + preset->name);
+            return true;
+        }
+    }
+
+    SaveShaderAsDialog(source);
+    return true;
+}
+
+void Application::SaveShaderAsDialog(const std::string& source) {
+    char filepath[MAX_PATH] = {};
+    
+    OPENFILENAMEA ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = m_hwnd;
+    ofn.lpstrFilter = "HLSL Shader\0*.hlsl\0All Files\0*.*\0";
+    ofn.lpstrFile = filepath;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.lpstrDefExt = "hlsl";
+    ofn.Flags = OFN_OVERWRITEPROMPT;
+
+    BeginModalLoop();
+    const bool chosen = GetSaveFileNameA(&ofn);
+    EndModalLoop();
+    if (chosen) {
+        std::ofstream file(filepath);
+        if (file.is_open()) {
+            file << source;
+            
+            // Update or create preset
+            auto* preset = m_shaderManager->GetActivePreset();
+            if (preset) {
+                preset->filepath = filepath;
+                preset->name = std::filesystem::path(filepath).stem().string();
+            } else {
+                ShaderPreset newPreset;
+                newPreset.filepath = filepath;
+                newPreset.name = std::filesystem::path(filepath).stem().string();
+                newPreset.source = source;
+                int idx = m_shaderManager->AddPreset(newPreset);  // Parses and compiles
+                m_shaderManager->SetActivePreset(idx);
+                m_uiManager->ResetKeyframeSelection();
+                OnParamChanged();
+            }
+
+            m_uiManager->ShowNotification("Shader saved: " + std::string(filepath));
+        }
+    }
+}
+
+void Application::ScanFolderDialog() {
+    IFileOpenDialog* pDialog = nullptr;
+    HRESULT hr = CoCreateInstance(CLSID_FileOpenDialog, nullptr, CLSCTX_INPROC_SERVER,
+        IID_PPV_ARGS(&pDialog));
+    if (FAILED(hr)) return;
+
+    DWORD opts = 0;
+    pDialog->GetOptions(&opts);
+    pDialog->SetOptions(opts | FOS_PICKFOLDERS | FOS_PATHMUSTEXIST);
+    pDialog->SetTitle(L"Select Shader Folder");
+
+    BeginModalLoop();
+    hr = pDialog->Show(m_hwnd);
+    EndModalLoop();
+    if (SUCCEEDED(hr)) {
+        IShellItem* pItem = nullptr;
+        hr = pDialog->GetResult(&pItem);
+        if (SUCCEEDED(hr)) {
+            PWSTR pszPath = nullptr;
+            if (SUCCEEDED(pItem->GetDisplayName(SIGDN_FILESYSPATH, &pszPath))) {
+                int len = WideCharToMultiByte(CP_UTF8, 0, pszPath, -1, nullptr, 0, nullptr, nullptr);
+                std::string path(len - 1, '\0');
+                WideCharToMultiByte(CP_UTF8, 0, pszPath, -1, path.data(), len, nullptr, nullptr);
+
+                m_configManager.GetConfig().shaderDirectory = path;
+                m_shaderManager->SetIncludeDirectory(path);
+                m_shaderManager->ScanDirectory(path);
+                m_uiManager->ShowNotification("Scanned: " + std::filesystem::path(path).filename().string());
+                CoTaskMemFree(pszPath);
+            }
+            pItem->Release();
+        }
+    }
+    pDialog->Release();
+}
+
+void Application::OpenRecordingOutputDialog(char* pathBuf, size_t bufSize) {
+    OPENFILENAMEA ofn = {};
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = m_hwnd;
+    ofn.lpstrFilter = "MP4 Video\0*.mp4\0MOV Video\0*.mov\0MKV Video (lossless codecs)\0*.mkv\0"
+                      "PNG Sequence\0*.png\0TIFF Sequence\0*.tif\0EXR Sequence (linear float)\0*.exr\0All Files\0*.*\0";
+    ofn.lpstrFile = pathBuf;
+    ofn.nMaxFile = static_cast<DWORD>(bufSize);
+    ofn.lpstrDefExt = "mp4";
+    ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
+    BeginModalLoop();
+    GetSaveFileNameA(&ofn);
+    EndModalLoop();
+}
+
+void Application::GetRecordingSource(const RecordingSettings& settings, int& width, int& height, double& fps) const {
+    if (m_decoder.IsOpen()) {
+        // Full size even during proxy playback; the file reopens at it
+        width  = m_decoder.GetSourceWidth();
+        height = m_decoder.GetSourceHeight();
+        fps    = m_decoder.GetFPS();
+    } else {
+        // Generative mode: use configured generative resolution.
+        // If settings.fps is 0 ("match source"), default to 60 since there is no source.
+        width  = m_renderer.GetGenerativeWidth();
+        height = m_renderer.GetGenerativeHeight();
+        fps    = (settings.fps > 0) ? static_cast<double>(settings.fps) : 60.0;
+    }
+}
+
+bool Application::StartEncoderCalibration(const RecordingSettings& settings) {
+    if (m_encoderCalibration.valid() || m_encoder.IsRecording()) return false;
+    int width, height;
+    double fps;
+    GetRecordingSource(settings, width, height, fps);
+    // Sized as VideoEncoder::StartRecording sizes the take
+    const int downscale = std::max(settings.downscale, 1);
+    if (settings.width > 0)  width  = settings.width;  else width  /= downscale;
+    if (settings.height > 0) height = settings.height; else height /= downscale;
+    if (settings.fps > 0) fps = settings.fps;
+
+    m_calibrationCancel = false;
+    m_encoderCalibration = std::async(std::launch::async, [this, width, height, fps] {
+        TraceRecorder::SetThreadName("Encoder calibration");
+        ThreadPriority::Apply(ThreadRole::Background);
+        return VideoEncoder::CalibrateProfiles(width, height, fps, &m_calibrationCancel);
+    });
+    return true;
+}
+
+void Application::UpdateEncoderCalibration() {
+    if (!m_encoderCalibration.valid() ||
+        m_encoderCalibration.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    m_uiManager->OnEncoderCalibrated(m_encoderCalibration.get());
+}
+
+bool Application::StartRecording(const RecordingSettings& settings,
+                                 const std::vector<RecordingSettings>& extraTargets) {
+    int recW, recH;
+    double recFPS;
+    GetRecordingSource(settings, recW, recH, recFPS);
+
+    // Generative mode: ensure the render loop is running
+    if (!m_decoder.IsOpen() && m_playbackState != PlaybackState::Playing) Play();
+
+    m_renderer.DiscardReadbacks();
+    m_extraEncoders.clear();  // Joins the last take's targets if still finishing
+    m_readbackEncoder = nullptr;
+
+    // Audio track from the samples FeedAudio plays. Those the player already
+    // holds were read before the take; the first recorded sample plays after them.
+    int audioRate = 0;
+    double audioDelay = 0.0;
+    if (AudioFollowsPlayback() && m_audioPlayer->IsInitialized() && m_audioReader.GetSampleRate() > 0) {
+        audioRate  = m_audioReader.GetSampleRate();
+        audioDelay = static_cast<double>(m_audioPlayer->GetBufferedSamples()) / m_audioPlayer->GetDeviceSampleRate();
+    }
+    m_encoder.SetAudioInput(audioRate, audioDelay);
+    if (m_encoder.StartRecording(settings, recW, recH, recFPS)) {
+        m_recordingSettings = settings;
+        for (const RecordingSettings& target : extraTargets) {
+            auto encoder = std::make_unique<VideoEncoder>();
+            encoder->SetHardwareDevice(m_renderer.GetDevice());
+            encoder->SetAudioInput(audioRate, audioDelay);
+            RecordingSettings targetSettings = target;
+            targetSettings.dropWhenBehind = settings.dropWhenBehind;
+            targetSettings.replaySeconds  = 0;
+            if (!encoder->StartRecording(targetSettings, recW, recH, recFPS)) {
+                m_uiManager->ShowNotification("Failed to start extra target: " + target.outputPath);
+                continue;
+            }
+            m_extraEncoders.push_back(std::move(encoder));
+        }
+
+        // Readback in the first software target's pixel format and size, converted
+        // and scaled on the GPU; the others convert from it with swscale
+        if (!m_encoder.IsHardwareEncoding()) m_readbackEncoder = &m_encoder;
+        for (auto& encoder : m_extraEncoders) {
+            if (!m_readbackEncoder && !encoder->IsHardwareEncoding()) m_readbackEncoder = encoder.get();
+        }
+        if (m_readbackEncoder) {
+            m_renderer.SetReadbackLayout(m_readbackEncoder->GetInputLayout());
+            m_renderer.SetReadbackSize(m_readbackEncoder->GetWidth(), m_readbackEncoder->GetHeight());
+        }
+        m_uiManager->ShowNotification(m_encoder.IsReplayMode()
+            ? "Instant replay armed: last " + std::to_string(settings.replaySeconds) + " s (F11 saves)"
+            : "Recording started: " + settings.outputPath);
+        ApplyProxySettings();
+        return true;
+    } else {
+        m_uiManager->ShowNotification("Failed to start recording");
+        return false;
+    }
+}
+
+bool Application::SubmitReadback(bool wait) {
+    FrameBuffer frameData;
+    int width = 0, height = 0;
+    ReadbackLayout layout = ReadbackLayout::RGBA8;
+    if (!m_readbackEncoder) return false;
+    const auto start = std::chrono::steady_clock::now();
+    if (!m_renderer.CollectReadback(m_readbackEncoder->GetFramePool(), frameData, width, height, layout, wait)) return false;
+    const float readbackMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    // The other software targets share the block (read-only) until they encode it
+    auto submit = [&](VideoEncoder& encoder) {
+        if (&encoder != m_readbackEncoder && !encoder.IsHardwareEncoding()) {
+            encoder.SubmitFrame(frameData, width, height, layout, -1.0, readbackMs);
+        }
+    };
+    submit(m_encoder);
+    for (auto& encoder : m_extraEncoders) submit(*encoder);
+    m_readbackEncoder->SubmitFrame(std::move(frameData), width, height, layout, -1.0, readbackMs);
+    return true;
+}
+
+void Application::StopRecording() {
+    if (m_encoder.IsRecording()) {
+        // The frames still in the readback ring are the last recorded ones.
+        // Non-blocking otherwise: signals the encoder thread to drain its queue and
+        // exit. Flush, file close, and resource free all happen on that thread.
+        while (SubmitReadback(true)) {}
+        const double encodeFps = m_encoder.GetEncodingFPS();  // 0 once stopped
+        m_encoder.StopRecording();
+        for (auto& encoder : m_extraEncoders) encoder->StopRecording();
+        char stats[96];
+        std::snprintf(stats, sizeof(stats), "Recording stopped: %lld frames, encoded at %.1f fps",
+                      static_cast<long long>(m_encoder.GetFramesEncoded()), encodeFps);
+        m_uiManager->ShowNotification(stats);
+        m_uiManager->OnRecordingStopped(m_recordingSettings, m_encoder.GetFramesEncoded(), m_encoder.GetFramesDropped());
+        ApplyProxySettings();
+    }
+}
+
+bool Application::SaveReplay() {
+    if (!m_encoder.IsReplayMode()) return false;
+
+    // Next to the configured output: "clip.mp4" -> "clip_replay_20250101_120000.mp4"
+    SYSTEMTIME now;
+    GetLocalTime(&now);
+    char stamp[32];
+    std::snprintf(stamp, sizeof(stamp), "_replay_%04u%02u%02u_%02u%02u%02u", now.wYear, now.wMonth, now.wDay,
+                  now.wHour, now.wMinute, now.wSecond);
+    std::filesystem::path path = m_recordingSettings.outputPath.empty() ? "output.mp4" : m_recordingSettings.outputPath;
+    const std::string extension = path.has_extension() ? path.extension().string() : ".mp4";
+    path.replace_filename(path.stem().string() + stamp + extension);
+
+    if (!m_encoder.SaveReplay(path.string())) {
+        m_uiManager->ShowNotification(m_encoder.GetReplayBuffer().IsSaving() ? "Replay save already running"
+                                                                             : "Nothing buffered yet");
+        return false;
+    }
+    m_uiManager->ShowNotification("Saving replay: " + path.filename().string());
+    return true;
+}
+
+bool Application::SaveTrace() {
+    char exePath[MAX_PATH];
+    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+    const std::filesystem::path dir = std::filesystem::path(exePath).parent_path() / "traces";
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    SYSTEMTIME now;
+    GetLocalTime(&now);
+    char name[48];
+    std::snprintf(name, sizeof(name), "trace_%04u%02u%02u_%02u%02u%02u.json", now.wYear, now.wMonth, now.wDay,
+                  now.wHour, now.wMinute, now.wSecond);
+    const std::filesystem::path path = dir / name;
+
+    const int seconds = std::max(1, m_configManager.GetConfig().traceSeconds);
+    if (!TraceRecorder::Get().WriteChromeTrace(path.string(), seconds)) {
+        m_uiManager->ShowNotification("Failed to write trace: " + path.string());
+        return false;
+    }
+    m_uiManager->ShowNotification("Saved " + std::to_string(seconds) + " s trace: " + path.filename().string());
+    return true;
+}
+
+bool Application::StartExport(const RecordingSettings& settings, double durationSeconds,
+                              const std::vector<RecordingSettings>& extraTargets, int subframes, float shutter) {
+    if (m_exporting || m_encoder.IsRecording() || m_mediaProbe.IsActive()) return false;
+    if (m_decoder.IsLiveCapture()) {
+        m_uiManager->ShowNotification("Export needs a video file or a generative shader");
+        return false;
+    }
+    const bool video = m_decoder.IsOpen();
+    m_exportFps = video ? m_decoder.GetFPS() : ((settings.fps > 0) ? settings.fps : 60.0);
+    m_exportTotalFrames = video ? m_decoder.GetTotalFrames()
+                                : static_cast<int64_t>(std::llround(durationSeconds * m_exportFps));
+    if (m_exportTotalFrames <= 0 && !video) return false;
+
+    // Every source frame in order from the first: no speed-dependent skipping,
+    // no audio output, and the encoder blocks instead of dropping
+    m_decoder.SetKeyframesOnly(false);
+    m_decoder.SetSkipNonReference(false);
+    m_catchUpSkip = false;
+    if (m_playingBackward) RestartDecodeWorker(false);
+    m_decodeWorker.SetLooping(false);  // The export ends at the clip's end
+    Stop();
+
+    RecordingSettings exportSettings = settings;
+    exportSettings.dropWhenBehind = false;
+    exportSettings.replaySeconds  = 0;
+    exportSettings.recordAudio    = false;  // Nothing is played while exporting
+    if (!StartRecording(exportSettings, extraTargets)) return false;
+    m_playbackState = PlaybackState::Paused;  // Generative StartRecording pressed Play
+
+    m_renderer.SetTemporalSupersampling(subframes, std::clamp(shutter, 0.0f, 1.0f) / static_cast<float>(m_exportFps));
+    m_exporting       = true;
+    m_exportFrame     = 0;
+    m_exportStartTime = std::chrono::steady_clock::now();
+    m_uiPresentTime   = m_exportStartTime;
+    return true;
+}
+
+void Application::StepExport() {
+    // Recording stopped some other way (F9, the panel): the export ends with it
+    if (!m_encoder.IsRecording()) {
+        FinishExport(false);
+        return;
+    }
+
+    if (m_decoder.IsOpen() || m_mediaProbe.IsActive()) {
+        // StartRecording may have reopened the file at full size; wait for it, and
+        // for the audio timeline, so every export reacts to the same AudioData
+        if (m_mediaProbe.IsActive() || !m_decoder.IsOpen() || m_audioTimeline.IsBuilding()) return;
+        // The first frame is already on screen (Stop or the reopen decoded it)
+        if (m_exportFrame > 0 && !m_decodeWorker.PopFrame(m_currentFrame)) {
+            if (m_decodeWorker.IsEndOfStream()) FinishExport(true);
+            return;  // Otherwise decoding behind rendering: try again next tick
+        }
+        m_cacheCurrentFrame = true;
+        m_playbackTime = static_cast<float>(m_currentFrame.timestamp);
+    } else {
+        if (m_exportFrame >= m_exportTotalFrames) {
+            FinishExport(true);
+            return;
+        }
+        m_generativeTime = static_cast<float>(static_cast<double>(m_exportFrame) / m_exportFps);
+        m_playbackTime = m_generativeTime;
+    }
+
+    m_newVideoFrame = true;
+    ++m_exportFrame;
+    m_lastFrameTime = std::chrono::steady_clock::now();
+}
+
+void Application::CancelExport() {
+    if (m_exporting) FinishExport(false);
+}
+
+void Application::FinishExport(bool completed) {
+    m_exporting = false;
+    m_renderer.SetTemporalSupersampling(1, 0.0f);
+    StopRecording();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_exportStartTime).count();
+    char message[128];
+    std::snprintf(message, sizeof(message), "%s: %lld frames in %.1f s",
+                  completed ? "Export finished" : "Export cancelled",
+                  static_cast<long long>(m_exportFrame), seconds);
+    m_uiManager->ShowNotification(message, 5.0f);
+    Stop();
+}
+
+double Application::GetExportSpeed() const {
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_exportStartTime).count();
+    return (m_exporting && wall > 0.0 && m_exportFps > 0.0) ? (m_exportFrame / m_exportFps) / wall : 0.0;
+}
+
+double Application::GetExportEta() const {
+    const double speed = GetExportSpeed();
+    if (speed <= 0.0 || m_exportFrame == 0 || m_exportTotalFrames <= 0) return -1.0;
+    const int64_t remaining = std::max<int64_t>(m_exportTotalFrames - m_exportFrame, 0);
+    return (remaining / m_exportFps) / speed;
+}
+
+bool Application::StartPlaybackBenchmark(const std::string& path, std::string& error) {
+    auto benchmark = std::make_unique<PlaybackBenchmark>();
+    if (!benchmark->Load(path, error)) return false;
+    if (m_exporting || m_encoder.IsRecording()) {
+        error = "Can't benchmark while recording or exporting";
+        return false;
+    }
+
+    // The file's preset: the library's entry for it, else loaded for the run
+    m_shaderManager->FinishLibraryLoad(true);
+    m_benchPreset      = m_shaderManager->GetActivePresetIndex();
+    m_benchAddedPreset = false;
+    if (!benchmark->GetPresetPath().empty()) {
+        std::error_code ec;
+        m_benchPreset = -1;
+        for (int i = 0; i < m_shaderManager->GetPresetCount() && m_benchPreset < 0; ++i) {
+            if (std::filesystem::equivalent(m_shaderManager->GetPresets()[i].filepath, benchmark->GetPresetPath(), ec)) {
+                m_benchPreset = i;
+            }
+        }
+        if (m_benchPreset < 0) {
+            ShaderPreset preset;
+            if (!m_shaderManager->LoadShaderMetadataFromFile(benchmark->GetPresetPath(), preset)) {
+                error = "Failed to load preset " + benchmark->GetPresetPath();
+                return false;
+            }
+            m_benchPreset      = m_shaderManager->AddPreset(preset);
+            m_benchAddedPreset = true;
+        }
+    }
+
+    // Audio-master sync, so drops are counted the way playback shows them. Set
+    // directly: SetSyncMode would save it, and the whole config is restored after.
+    m_benchSavedConfig = m_configManager.GetConfig();
+    m_configManager.GetConfig().syncMode = SYNC_MODE_AUDIO_MASTER;
+
+    benchmark->SetAdapter(m_renderer.GetAdapterName());
+    m_benchmark = std::move(benchmark);
+    m_benchClip = 0;
+    OpenBenchmarkClip();
+    return true;
+}
+
+void Application::OpenBenchmarkClip() {
+    const auto& clips = m_benchmark->GetClips();
+    while (m_benchClip < clips.size()) {
+        Stop();
+        m_shaderManager->SetActivePreset(m_benchPreset);
+        if (OpenVideo(clips[m_benchClip])) {
+            m_benchPhase      = BenchPhase::Opening;
+            m_benchPhaseStart = std::chrono::steady_clock::now();
+            return;
+        }
+        m_benchmark->FailClip(clips[m_benchClip], "Failed to open");
+        ++m_benchClip;
+    }
+    FinishPlaybackBenchmark();
+}
+
+void Application::StepPlaybackBenchmark() {
+    PlaybackBenchmark& benchmark = *m_benchmark;
+    const std::string& clip = benchmark.GetClips()[m_benchClip];
+    const auto now = std::chrono::steady_clock::now();
+    const double phaseSeconds = std::chrono::duration<double>(now - m_benchPhaseStart).count();
+
+    switch (m_benchPhase) {
+    case BenchPhase::Opening: {
+        const ShaderPreset* preset = m_shaderManager->GetActivePreset();
+        if (m_mediaProbe.IsActive() || (preset && preset->isCompiling)) {
+            if (phaseSeconds < BENCH_OPEN_TIMEOUT) return;
+            benchmark.FailClip(clip, m_mediaProbe.IsActive() ? "Timed out opening" : "Timed out compiling the preset");
+        } else if (!m_decoder.IsOpen()) {
+            benchmark.FailClip(clip, "Failed to open");
+        } else if (preset && !preset->isValid) {
+            benchmark.FailClip(clip, "Preset failed to compile: " + preset->compileError);
+        } else {
+            Play();
+            // Started now, so the encoder's own start-up falls in the warm-up
+            if (!benchmark.GetRecordPath().empty()) {
+                RecordingSettings settings;
+                settings.outputPath  = benchmark.GetRecordPath();
+                settings.codec       = benchmark.GetRecordCodec();
+                settings.adaptToLoad = false;  // A fixed bitrate, so runs compare
+                if (!StartRecording(settings)) {
+                    benchmark.FailClip(clip, "Failed to start recording with " + settings.codec);
+                    ++m_benchClip;
+                    OpenBenchmarkClip();
+                    return;
+                }
+            }
+            m_benchPhase      = BenchPhase::Warmup;
+            m_benchPhaseStart = now;
+            return;
+        }
+        ++m_benchClip;
+        OpenBenchmarkClip();
+        return;
+    }
+
+    case BenchPhase::Warmup: {
+        if (phaseSeconds < benchmark.GetWarmup()) return;
+        benchmark.BeginClip(clip);
+        PlaybackBenchmark::ClipResult& result = benchmark.Current();
+        result.codec  = m_decoder.GetCodecName();
+        result.width  = m_decoder.GetWidth();
+        result.height = m_decoder.GetHeight();
+        result.fps    = m_decoder.GetFPS();
+
+        CpuFrameTiming cpu;
+        m_benchCpuFrame   = m_cpuProfiler.GetLatest(cpu) ? cpu.frame : 0;
+        m_benchGpuFrame   = m_renderer.GetGpuProfiler().GetFrameCount();
+        m_benchPrevUpload = m_newVideoFrame;
+        m_benchLateDrops  = m_lateDrops;
+        m_benchDiscarded  = m_decoder.GetDiscardedFrames();
+        m_benchUnderruns  = m_decodeWorker.GetUnderruns();
+        m_benchDecoded    = m_decodeWorker.GetFramesDecoded();
+        m_benchEncoded    = m_encoder.GetFramesEncoded();
+        m_benchRecDropped = m_encoder.GetFramesDropped();
+        m_benchPhase      = BenchPhase::Measuring;
+        m_benchPhaseStart = now;
+        return;
+    }
+
+    case BenchPhase::Measuring: {
+        // The newest completed tick is the previous one: the current tick's scopes
+        // close at the next BeginFrame
+        if (CpuFrameTiming cpu; m_cpuProfiler.GetLatest(cpu) && cpu.frame > m_benchCpuFrame) {
+            benchmark.AddTick(cpu.frameMs, m_benchPrevUpload, cpu.ms[static_cast<size_t>(CpuStage::Upload)]);
+            m_benchCpuFrame = cpu.frame;
+        }
+        m_benchPrevUpload = m_newVideoFrame;
+
+        // One sample per tick that decoded: the worker keeps only the last time
+        if (const int64_t decoded = m_decodeWorker.GetFramesDecoded(); decoded > m_benchDecoded) {
+            benchmark.AddDecode(m_decoder.GetLastDecodeMs());
+            m_benchDecoded = decoded;
+        }
+
+        std::vector<GpuFrameTiming> timings;
+        m_renderer.GetGpuProfiler().GetFramesSince(m_benchGpuFrame, timings);
+        for (const GpuFrameTiming& timing : timings) {
+            benchmark.AddGpu(timing.ms[static_cast<size_t>(GpuStage::Upload)], timing.ms[static_cast<size_t>(GpuStage::Shader)]);
+            m_benchGpuFrame = timing.frame + 1;
+        }
+        benchmark.AddMemory(QueryProcessMemory().privateBytes, m_renderer.QueryVideoMemory().localUsage);
+
+        if (phaseSeconds < benchmark.GetDuration()) return;
+        PlaybackBenchmark::ClipResult& result = benchmark.Current();
+        result.seconds   = phaseSeconds;
+        result.lateDrops = m_lateDrops - m_benchLateDrops;
+        result.discarded = m_decoder.GetDiscardedFrames() - m_benchDiscarded;
+        result.underruns = m_decodeWorker.GetUnderruns() - m_benchUnderruns;
+        if (m_encoder.IsRecording()) {
+            // Convert + encode per frame over the telemetry's window (its last HISTORY_SIZE frames)
+            const RecordingTelemetry::Snapshot telemetry = m_encoder.GetTelemetry().GetSnapshot();
+            result.recorded      = true;
+            result.framesEncoded = m_encoder.GetFramesEncoded() - m_benchEncoded;
+            result.recordDropped = m_encoder.GetFramesDropped() - m_benchRecDropped;
+            result.encodeFps     = result.framesEncoded / phaseSeconds;
+            result.avgEncodeMs   = telemetry.stages[static_cast<size_t>(RecordingStage::Convert)].avgMs +
+                                   telemetry.stages[static_cast<size_t>(RecordingStage::Encode)].avgMs;
+            StopRecording();
+        }
+        benchmark.EndClip();
+        ++m_benchClip;
+        OpenBenchmarkClip();
+        return;
+    }
+    }
+}
+
+void Application::FinishPlaybackBenchmark() {
+    StopRecording();  // A clip that failed mid-take
+    std::string error;
+    const bool written = m_benchmark->WriteReport(error);
+    if (!written) std::fprintf(stderr, "Playback benchmark: %s\n", error.c_str());
+    const bool passed = written && m_benchmark->AllSucceeded();
+    m_benchmark.reset();
+
+    Stop();
+    if (m_benchAddedPreset) m_shaderManager->RemovePreset(m_benchPreset);
+    m_configManager.GetConfig() = m_benchSavedConfig;
+    PostQuitMessage(passed ? 0 : 1);
+}
+
+void Application::ToggleSessionRecording() {
+    if (m_sessionReplaying) return;
+    const auto now = std::chrono::steady_clock::now();
+
+    if (!m_sessionRecording) {
+        m_sessionLog.Clear();
+        m_sessionRecording = true;
+        m_sessionStart     = now;
+        m_sessionTicks     = 0;
+        // The state to start from; preset, keyframes and audio follow from the
+        // first CaptureSessionState
+        if (m_decoder.IsOpen() && !m_decoder.IsLiveCapture()) {
+            RecordSessionEvent(SessionEventType::Open, {{"path", m_videoPath}});
+            RecordSessionEvent(SessionEventType::Seek, {{"time", m_playbackTime}});
+        }
+        RecordSessionEvent(SessionEventType::Rate, {{"rate", m_playbackRate}});
+        RecordSessionEvent(SessionEventType::Playback, {{"state", SessionPlaybackState(m_playbackState)}});
+        m_sessionPreset    = "\n";  // Never a path or name
+        m_sessionKeyframes = nullptr;
+        m_sessionAudio     = nullptr;
+        CaptureSessionState();
+        m_uiManager->ShowNotification("Recording session (Ctrl+R to stop)");
+        return;
+    }
+
+    m_sessionRecording = false;
+    m_sessionLog.Finish(std::chrono::duration<double>(now - m_sessionStart).count(), m_sessionTicks);
+
+    char exePath[MAX_PATH];
+    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+    const std::filesystem::path dir = std::filesystem::path(exePath).parent_path() / "sessions";
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+    char name[48];
+    std::snprintf(name, sizeof(name), "session_%04u%02u%02u_%02u%02u%02u.json", time.wYear, time.wMonth, time.wDay,
+                  time.wHour, time.wMinute, time.wSecond);
+    const std::filesystem::path path = dir / name;
+
+    std::string error;
+    if (!m_sessionLog.Save(path.string(), error)) {
+        m_uiManager->ShowNotification(error);
+        return;
+    }
+    m_uiManager->ShowNotification("Saved session (" + std::to_string(m_sessionLog.GetEvents().size()) +
+                                  " events): " + path.filename().string());
+}
+
+void Application::RecordSessionEvent(SessionEventType type, nlohmann::json data) {
+    if (!m_sessionRecording) return;
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_sessionStart).count();
+    m_sessionLog.Add(time, type, std::move(data));
+}
+
+void Application::CaptureSessionState() {
+    ++m_sessionTicks;
+
+    // Preset switches come from the library, shortcuts, workspaces and the
+    // editor, so they are diffed rather than hooked
+    const ShaderPreset* preset = m_shaderManager->GetActivePreset();
+    const std::string key = preset ? (preset->filepath.empty() ? preset->name : preset->filepath) : std::string();
+    if (key != m_sessionPreset) {
+        m_sessionPreset = key;
+        RecordSessionEvent(SessionEventType::Preset, {{"filepath", preset ? preset->filepath : std::string()},
+                                                      {"name", preset ? preset->name : std::string()}});
+        if (preset) RecordSessionEvent(SessionEventType::Params, SessionParams(*preset));
+        m_sessionKeyframes = nullptr;
+    }
+
+    // Keyframe edits touch the timelines directly
+    if (preset) {
+        nlohmann::json keyframes = SessionKeyframes(*preset);
+        if (keyframes != m_sessionKeyframes) {
+            RecordSessionEvent(SessionEventType::Keyframes, keyframes);
+            m_sessionKeyframes = std::move(keyframes);
+        }
+    }
+
+    nlohmann::json audio = SessionAudio(m_configManager.GetConfig());
+    if (audio != m_sessionAudio) {
+        RecordSessionEvent(SessionEventType::Audio, audio);
+        m_sessionAudio = std::move(audio);
+    }
+}
+
+bool Application::StartSessionReplay(const std::string& path, std::string& error) {
+    if (m_sessionRecording || m_exporting || m_encoder.IsRecording() || m_benchmark) {
+        error = "Can't replay while recording, exporting or benchmarking";
+        return false;
+    }
+    if (!m_sessionLog.Load(path, error)) return false;
+    m_shaderManager->FinishLibraryLoad(true);  // Events name presets of the whole library
+
+    // Frame-paced: the fixed clock decides when frames are due, not the audio device
+    m_configManager.GetConfig().syncMode = SYNC_MODE_FRAME_PACED;
+
+    m_sessionReplaying = true;
+    m_sessionReplayed  = true;
+    m_sessionOpening   = false;
+    m_sessionPath      = path;
+    m_sessionStart     = std::chrono::steady_clock::now();
+    m_sessionTime      = 0.0;
+    m_sessionNext      = 0;
+    m_sessionFailed    = 0;
+    CpuFrameTiming cpu;
+    m_sessionCpuFrame  = m_cpuProfiler.GetLatest(cpu) ? cpu.frame : 0;
+    m_sessionGpuFrame  = m_renderer.GetGpuProfiler().GetFrameCount();
+    return true;
+}
+
+std::chrono::steady_clock::time_point Application::PlaybackNow() const {
+    if (!m_sessionReplaying) return std::chrono::steady_clock::now();
+    return m_sessionStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(m_sessionTime));
+}
+
+void Application::StepSessionReplay() {
+    // Opens, compiles and audio pre-analysis take their own time: the fixed clock
+    // waits for them, and the ticks spent waiting aren't measured
+    const ShaderPreset* preset = m_shaderManager->GetActivePreset();
+    const bool waiting = m_mediaProbe.IsActive() || (preset && preset->isCompiling) ||
+                         m_audioTimeline.IsBuilding();
+
+    if (CpuFrameTiming cpu; m_cpuProfiler.GetLatest(cpu) && cpu.frame > m_sessionCpuFrame) {
+        if (!waiting) m_sessionLog.AddCpu(cpu);
+        m_sessionCpuFrame = cpu.frame;
+    }
+    std::vector<GpuFrameTiming> timings;
+    m_renderer.GetGpuProfiler().GetFramesSince(m_sessionGpuFrame, timings);
+    for (const GpuFrameTiming& timing : timings) {
+        if (!waiting) m_sessionLog.AddGpu(timing);
+        m_sessionGpuFrame = timing.frame + 1;
+    }
+    if (waiting) return;
+
+    if (m_sessionOpening) {
+        m_sessionOpening = false;
+        if (!m_decoder.IsOpen()) ++m_sessionFailed;
+    }
+
+    const auto& events = m_sessionLog.GetEvents();
+    while (m_sessionNext < events.size() && events[m_sessionNext].time <= m_sessionTime) {
+        if (!ApplySessionEvent(events[m_sessionNext++])) ++m_sessionFailed;
+        if (m_sessionOpening) return;  // Later events wait for the probe
+    }
+    if (m_sessionNext >= events.size() && m_sessionTime >= m_sessionLog.GetDuration()) {
+        FinishSessionReplay();
+        return;
+    }
+    m_sessionTime += 1.0 / m_sessionLog.GetTickRate();
+}
+
+bool Application::ApplySessionEvent(const SessionEvent& event) {
+    const nlohmann::json& data = event.data;
+    ShaderPreset* active = m_shaderManager->GetActivePreset();
+    try {
+        switch (event.type) {
+        case SessionEventType::Open:
+            m_sessionOpening = OpenVideo(data.at("path").get<std::string>());
+            return m_sessionOpening;
+
+        case SessionEventType::Preset: {
+            const std::string filepath = data.value("filepath", std::string());
+            const std::string name     = data.value("name", std::string());
+            if (filepath.empty() && name.empty()) {
+                m_shaderManager->SetPassthrough();
+                return true;
+            }
+            int index = -1;
+            for (int i = 0; i < m_shaderManager->GetPresetCount() && index < 0; ++i) {
+                const ShaderPreset& preset = m_shaderManager->GetPresets()[i];
+                if (filepath.empty() ? preset.name == name : preset.filepath == filepath) index = i;
+            }
+            if (index < 0 && !filepath.empty()) {
+                ShaderPreset preset;
+                if (!m_shaderManager->LoadShaderMetadataFromFile(filepath, preset)) return false;
+                index = m_shaderManager->AddPreset(preset);
+            }
+            if (index < 0) return false;
+            m_shaderManager->SetActivePreset(index);
+            ApplyParamValues();
+            return true;
+        }
+
+        case SessionEventType::Params:
+        case SessionEventType::Keyframes: {
+            if (!active) return false;
+            ShaderPreset saved;
+            saved.blendMode   = active->blendMode;
+            saved.blendAmount = active->blendAmount;
+            from_json(data, saved);
+            if (event.type == SessionEventType::Keyframes) {
+                for (auto& param : active->params) param.timeline.reset();
+            }
+            ShaderManager::RestoreSavedValues(*active, saved);
+            active->blendMode   = saved.blendMode;
+            active->blendAmount = saved.blendAmount;
+            ApplyParamValues();
+            return true;
+        }
+
+        case SessionEventType::Seek:
+            SeekTo(data.at("time").get<double>());
+            return true;
+
+        case SessionEventType::Playback: {
+            const std::string state = data.at("state").get<std::string>();
+            if (state == "playing")     Play();
+            else if (state == "paused") Pause();
+            else                        Stop();
+            return true;
+        }
+
+        case SessionEventType::Rate:
+            SetPlaybackRate(data.at("rate").get<double>());
+            return true;
+
+        case SessionEventType::Audio: {
+            AppConfig& cfg = m_configManager.GetConfig();
+            cfg.audio.beatSensitivity = data.value("beatSensitivity", cfg.audio.beatSensitivity);
+            cfg.audio.beatDecay       = data.value("beatDecay", cfg.audio.beatDecay);
+            cfg.audio.smoothing       = data.value("smoothing", cfg.audio.smoothing);
+            cfg.audio.fftSize         = data.value("fftSize", cfg.audio.fftSize);
+            cfg.audio.multiResolution = data.value("multiResolution", cfg.audio.multiResolution);
+            cfg.audio.logSpectrum     = data.value("logSpectrum", cfg.audio.logSpectrum);
+            UpdateAudioSettings();  // SaveConfig is a no-op while replaying
+            SetAudioVolume(data.value("volume", cfg.audioVolume));
+            SetAudioMute(data.value("mute", cfg.muteAudio));
+            return true;
+        }
+
+        default:
+            return false;
+        }
+    } catch (const std::exception&) {
+        return false;  // A malformed event
+    }
+}
+
+void Application::FinishSessionReplay() {
+    m_sessionReplaying = false;
+    const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_sessionStart).count();
+
+    const std::filesystem::path session(m_sessionPath);
+    const std::string base = (session.parent_path() / session.stem()).string();
+    std::string error;
+    bool ok = m_sessionLog.WriteReport(base + ".replay.json", wallSeconds, m_sessionFailed, error);
+    if (!ok) std::fprintf(stderr, "Session replay: %s\n", error.c_str());
+    const int traceSeconds = std::max(1, static_cast<int>(std::ceil(wallSeconds)));
+    if (!TraceRecorder::Get().WriteChromeTrace(base + ".trace.json", traceSeconds)) {
+        std::fprintf(stderr, "Session replay: failed to write %s.trace.json\n", base.c_str());
+        ok = false;
+    }
+    PostQuitMessage(ok && m_sessionFailed == 0 ? 0 : 1);
+}
+
+void Application::SaveConfig() {
+    if (m_sessionReplaying || m_sessionReplayed) return;  // Replayed values aren't the user's
+    m_configSavePending = true;
+    m_configSaveDue = std::chrono::steady_clock::now() +
+                      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                          std::chrono::duration<double>(CONFIG_SAVE_DELAY));
+}
+
+void Application::WriteConfig() {
+    m_configSavePending = false;
+    if (m_sessionReplaying || m_sessionReplayed) return;
+
+    // Update shader presets in config, from the whole library
+    m_shaderManager->FinishLibraryLoad(true);
+    auto& config = m_configManager.GetConfig();
+    config.shaderPresets.clear();
+    
+    for (int i = 0; i < m_shaderManager->GetPresetCount(); ++i) {
+        auto* preset = m_shaderManager->GetPreset(i);
+        if (preset && !preset->filepath.empty()) {
+            // config.json doesn't store the source, the bulk of a preset: keep it out of the copy
+            std::string source = std::move(preset->source);
+            config.shaderPresets.push_back(*preset);
+            preset->source = std::move(source);
+        }
+    }
+
+    m_configManager.SaveAsync(ConfigManager::GetDefaultConfigPath());
+}
+
+void Application::ToggleVideoOutputWindow() {
+    if (m_videoOutputWindow.IsOpen()) {
+        m_videoOutputWindow.Close();
+    } else {
+        m_videoOutputWindow.SetModalLoopCallback([this](bool entered) {
+            if (entered) BeginModalLoop(); else EndModalLoop();
+        });
+        m_videoOutputWindow.Open(m_renderer.GetDevice(), m_renderer.GetContext());
+    }
+}
+
+void Application::SetSpoutEnabled(bool enabled) {
+    m_configManager.GetConfig().spoutEnabled = enabled;
+    m_spoutOutput->SetEnabled(enabled);
+    ApplySpoutPass();
+    SaveConfig();
+}
+
+void Application::SetSpoutSenderName(const std::string& name) {
+    m_configManager.GetConfig().spoutSenderName = name;
+    m_spoutOutput->SetSenderName(name);
+    SaveConfig();
+}
+
+void Application::SetSpoutOutputSize(int width, int height) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.spoutWidth  = (width > 0 && height > 0) ? width : 0;
+    cfg.spoutHeight = (width > 0 && height > 0) ? height : 0;
+    m_spoutOutput->SetOutputSize(cfg.spoutWidth, cfg.spoutHeight);
+    SaveConfig();
+}
+
+void Application::SetSpoutPass(int pass) {
+    m_configManager.GetConfig().spoutPass = std::max(pass, -1);
+    ApplySpoutPass();
+    SaveConfig();
+}
+
+void Application::UpdatePostChains() {
+    const AppConfig& cfg = m_configManager.GetConfig();
+    ShaderBindings bindings = { 0u, 0u };
+    for (int output = 0; output < POST_OUTPUT_COUNT; ++output) {
+        std::vector<D3D11Renderer::PostStage>& stages = m_postStages[output];
+        stages.clear();
+        for (const std::string& name : cfg.postChains[output]) {
+            D3D11Renderer::PostStage stage;
+            if (!m_shaderManager->GetPostStage(name, stage)) continue;  // Compiling, or multi-pass
+            bindings |= stage.bindings;
+            stages.push_back(std::move(stage));
+        }
+    }
+    // A channel's preset is a one-stage chain over its clip
+    for (int i = 0; i < static_cast<int>(m_channels.size()); ++i) {
+        std::vector<D3D11Renderer::PostStage> stages;
+        D3D11Renderer::PostStage stage;
+        const std::string& preset = cfg.channels[i].preset;
+        if (!preset.empty() && m_shaderManager->GetPostStage(preset, stage)) {
+            bindings |= stage.bindings;
+            stages.push_back(std::move(stage));
+        }
+        m_channels[i]->SetStages(std::move(stages));
+    }
+    m_renderer.SetPostBindings(bindings);
+}
+
+ID3D11ShaderResourceView* Application::RunPostChain(int output, ID3D11ShaderResourceView* source,
+                                                    int width, int height) {
+    D3D11Renderer::PostChain& chain = m_postChains[output];
+    if (m_postStages[output].empty() && !chain.result) return nullptr;
+    GpuProfiler::Scope scope(m_renderer.GetGpuProfiler(), GpuStage::Post);
+    ID3D11ShaderResourceView* result = m_renderer.RunPostChain(chain, m_postStages[output], source, width, height);
+    return result != source ? result : nullptr;
+}
+
+ID3D11ShaderResourceView* Application::GetPreviewSRV() const {
+    ID3D11ShaderResourceView* post = m_postChains[POST_OUTPUT_PREVIEW].result;
+    return post ? post : m_renderer.GetDisplaySRV();
+}
+
+void Application::ApplySpoutPass() {
+    // The tap costs a draw per frame, so only while something sends it
+    const auto& cfg = m_configManager.GetConfig();
+    const int pass = m_spoutOutput->IsEnabled() ? cfg.spoutPass : -1;
+    m_renderer.SetTapPass(pass);
+    m_spoutOutput->SetSendTap(pass >= 0);
+}
+
+bool Application::OpenSpoutInput(const std::string& senderName) {
+    CloseVideo();
+    if (!m_spoutInput.Open(m_renderer.GetDevice(), senderName)) {
+        m_uiManager->ShowNotification("Spout receiver unavailable");
+        return false;
+    }
+    m_generativeTime = 0.0f;
+    m_playbackState  = PlaybackState::Playing;
+    m_lastFrameTime  = PlaybackNow();
+    m_uiManager->ShowNotification("Receiving Spout: " + (senderName.empty() ? std::string("active sender") : senderName));
+    return true;
+}
+
+void Application::CloseSpoutInput() {
+    if (!m_spoutInput.IsOpen()) return;
+    m_spoutInput.Close();
+    m_renderer.ClearExternalVideo();
+}
+
+void Application::SetNdiEnabled(bool enabled) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.ndiEnabled = enabled;
+    if (!enabled) {
+        m_ndiOutput.Stop();
+    } else if (!m_ndiOutput.IsRunning() &&
+               !m_ndiOutput.Start(m_renderer.GetDevice(), m_renderer.GetContext(), cfg.ndiSenderName)) {
+        cfg.ndiEnabled = false;
+        m_uiManager->ShowNotification("NDI unavailable (runtime not installed?)");
+    }
+    SaveConfig();
+}
+
+void Application::SetNdiSenderName(const std::string& name) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.ndiSenderName = name;
+    // NDI names a sender at creation: a new name is a new sender
+    if (m_ndiOutput.IsRunning()) m_ndiOutput.Start(m_renderer.GetDevice(), m_renderer.GetContext(), name);
+    SaveConfig();
+}
+
+void Application::SetNdiOutputSize(int width, int height) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.ndiWidth  = (width > 0 && height > 0) ? width : 0;
+    cfg.ndiHeight = (width > 0 && height > 0) ? height : 0;
+    m_ndiOutput.SetOutputSize(cfg.ndiWidth, cfg.ndiHeight);
+    SaveConfig();
+}
+
+void Application::SetVirtualCameraEnabled(bool enabled) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.virtualCameraEnabled = enabled;
+    if (!enabled) {
+        m_virtualCamera.Stop();
+    } else if (!m_virtualCamera.IsRunning() &&
+               !m_virtualCamera.Start(m_renderer.GetDevice(), m_renderer.GetContext(), cfg.virtualCameraName)) {
+        cfg.virtualCameraEnabled = false;
+        m_uiManager->ShowNotification("Virtual camera unavailable (Windows 11 and a registered ShaderPlayerVCam.dll)");
+    }
+    SaveConfig();
+}
+
+void Application::SetVirtualCameraName(const std::string& name) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.virtualCameraName = name;
+    // The friendly name is fixed at creation: a new name is a new camera
+    if (m_virtualCamera.IsRunning()) m_virtualCamera.Start(m_renderer.GetDevice(), m_renderer.GetContext(), name);
+    SaveConfig();
+}
+
+void Application::SetOscInput(bool enabled, int port) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.oscPort    = std::clamp(port, 1, 65535);
+    cfg.oscEnabled = enabled;
+    if (!enabled) {
+        m_controlInput.StopOsc();
+    } else if (!m_controlInput.StartOsc(cfg.oscPort)) {
+        cfg.oscEnabled = false;
+        m_uiManager->ShowNotification(m_controlInput.GetError());
+    }
+    SaveConfig();
+}
+
+void Application::SetFrameSync(int role, int port) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.frameSyncPort = std::clamp(port, 1, 65535);
+    cfg.frameSyncRole = std::clamp(role, FRAME_SYNC_OFF, FRAME_SYNC_FOLLOWER);
+    m_frameSyncLocked = false;
+    if (!m_frameSync.Start(static_cast<FrameSync::Role>(cfg.frameSyncRole), cfg.frameSyncPort)) {
+        cfg.frameSyncRole = FRAME_SYNC_OFF;
+        m_uiManager->ShowNotification(m_frameSync.GetError());
+    }
+    SaveConfig();
+}
+
+void Application::UpdateFrameSync(std::chrono::steady_clock::time_point now) {
+    m_frameSyncLocked = false;
+    if (m_exporting || m_benchmark || m_sessionReplaying || m_playingBackward) return;
+    FrameSync::Target target;
+    if (!m_frameSync.GetTarget(now, target)) return;  // Free-running until the master is heard
+
+    if (target.rate != m_playbackRate) SetPlaybackRate(target.rate);
+    const bool playing = m_playbackState == PlaybackState::Playing;
+    if (target.playing && !playing) Play();
+    if (!target.playing && playing) Pause();
+
+    if (!m_decoder.IsOpen()) {
+        // Generative: the shader's time is the master's (the playing branch takes it)
+        m_frameSyncLocked = true;
+        m_frameSyncClock  = target.mediaTime;
+        if (!target.playing) m_generativeTime = m_playbackTime = static_cast<float>(target.mediaTime);
+        return;
+    }
+    if (m_decoder.IsLiveCapture()) return;
+
+    // The error on this clip's timeline; across the loop point the short way round
+    const double duration = m_decoder.GetDuration();
+    double error = target.mediaTime - m_playbackTime;
+    if (duration > 0.0) error = std::remainder(error, duration);
+    const double limit = target.playing ? FRAME_SYNC_SEEK_SECONDS : 0.5 * m_frameDuration;
+    if (std::abs(error) > limit) {
+        // Joined late, or fell too far behind to catch up by dropping: seek, and
+        // wait for that seek to land before judging again
+        if (std::chrono::duration<double>(now - m_frameSyncSeekAt).count() < FRAME_SYNC_SEEK_COOLDOWN) return;
+        m_frameSyncSeekAt = now;
+        double seek = target.mediaTime + (target.playing ? FRAME_SYNC_SEEK_LEAD * target.rate : 0.0);
+        if (duration > 0.0) seek = std::fmod(std::fmod(seek, duration) + duration, duration);
+        SeekTo(seek);
+        return;
+    }
+    m_frameSyncLocked = true;
+    m_frameSyncClock  = m_playbackTime + error;
+}
+
+void Application::PublishFrameSync() {
+    // The clock frames are selected by where one runs (audio master, render-ahead),
+    // else the frame on screen and its deadline
+    const bool    anchored = m_syncAnchored && m_decoder.IsOpen();
+    const double  duration = m_decoder.IsOpen() ? m_decoder.GetDuration() : 0.0;
+    const int64_t frame    = m_frameDuration > 0.0 ? std::llround(m_playbackTime / m_frameDuration) : 0;
+    m_frameSync.Publish(anchored ? m_syncAnchorWall : m_lastFrameTime, anchored ? m_syncAnchorTime : m_playbackTime,
+                        m_playbackRate, duration, frame, m_playbackState == PlaybackState::Playing);
+}
+
+void Application::SetMetricsServer(bool enabled, int port) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.metricsPort    = std::clamp(port, 1, 65535);
+    cfg.metricsEnabled = enabled;
+    if (!enabled) {
+        m_metrics.Stop();
+    } else if (!m_metrics.Start(cfg.metricsPort)) {
+        cfg.metricsEnabled = false;
+        m_uiManager->ShowNotification(m_metrics.GetError());
+    }
+    SaveConfig();
+}
+
+void Application::SetWatchdog(bool enabled) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.watchdogEnabled = enabled;
+    if (enabled && !m_watchdog.IsRunning()) {
+        m_watchdog.Start({cfg.watchdogStallMs, cfg.watchdogGpuMs}, WatchdogLogPath(), m_cpuProfiler);
+    } else if (!enabled) {
+        m_watchdog.Stop();
+        ResetWatchdog();
+    }
+    SaveConfig();
+}
+
+void Application::ApplyWatchdogSettings() {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.watchdogStallMs = std::max(cfg.watchdogStallMs, FrameWatchdog::MIN_STALL_MS);
+    cfg.watchdogGpuMs   = std::max(cfg.watchdogGpuMs, 1.0f);
+    m_watchdog.SetSettings({cfg.watchdogStallMs, cfg.watchdogGpuMs});
+    SaveConfig();
+}
+
+void Application::ResetWatchdog() {
+    m_watchdog.Reset();
+    m_watchdogApplied = WatchdogLevel::Normal;
+    m_watchdogPreset  = -1;
+}
+
+void Application::ApplyWatchdog() {
+    // Another preset picked since a step (by hand, OSC, a cue): it starts clean
+    if (m_watchdogApplied != WatchdogLevel::Normal &&
+        m_shaderManager->GetActivePresetIndex() != m_watchdogPreset) {
+        ResetWatchdog();
+    }
+
+    const WatchdogLevel level = m_watchdog.GetLevel();
+    if (level <= m_watchdogApplied) return;
+    m_watchdogApplied = level;
+    // LowResolution is UpdateRenderScale's cap; Defaults keeps it and holds the keyframes
+    if (level == WatchdogLevel::Defaults) {
+        if (ShaderPreset* preset = m_shaderManager->GetActivePreset()) {
+            for (ShaderParam& param : preset->params)
+                std::copy(param.defaultValues, param.defaultValues + 4, param.values);
+            OnParamChanged();
+        }
+    } else if (level == WatchdogLevel::Passthrough) {
+        m_shaderManager->SetPassthrough();
+    }
+    m_watchdogPreset = m_shaderManager->GetActivePresetIndex();
+    if (m_uiManager)
+        m_uiManager->ShowNotification(std::string("Frame stall: stepped down to ") + FrameWatchdog::LevelName(level));
+}
+
+void Application::PublishMetrics() {
+    const auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - m_metricsPublished).count() < METRICS_PUBLISH_INTERVAL) return;
+    m_metricsPublished = now;
+    using Gauge   = MetricsServer::Gauge;
+    using Counter = MetricsServer::Counter;
+
+    m_cpuProfiler.GetSnapshot(m_metricsCpu, &m_frameArena);
+    const CpuProfiler::Snapshot& cpu = m_metricsCpu;
+    m_metrics.Set(Gauge::FrameP50Ms, cpu.p50Ms);
+    m_metrics.Set(Gauge::FrameP99Ms, cpu.p99Ms);
+    m_metrics.Set(Gauge::FrameMaxMs, cpu.maxMs);
+    m_metrics.Set(Counter::Frames, cpu.frames);
+
+    GpuFrameTiming gpu;
+    if (m_renderer.GetGpuProfiler().GetLatest(gpu)) m_metrics.Set(Gauge::GpuMs, gpu.totalMs);
+    m_metrics.Set(Gauge::DecodeMs, m_decoder.IsOpen() ? m_decoder.GetAverageDecodeMs() : 0.0);
+
+    int queueDepth = 0;
+    if (m_encoder.IsRecording()) {
+        m_encoder.GetTelemetry().GetSnapshot(m_metricsTelemetry, &m_frameArena);
+        if (!m_metricsTelemetry.queueDepth.empty()) queueDepth = static_cast<int>(m_metricsTelemetry.queueDepth.back());
+    }
+    m_metrics.Set(Gauge::EncoderQueueDepth, queueDepth);
+    int64_t encoderDrops = m_encoder.GetFramesDropped();
+    for (const auto& encoder : m_extraEncoders) encoderDrops += encoder->GetFramesDropped();
+    m_metrics.Set(Counter::EncoderDrops, encoderDrops);
+
+    const VideoMemoryInfo vram = m_renderer.QueryVideoMemory();
+    m_metrics.Set(Gauge::VramUsageBytes, static_cast<double>(vram.localUsage));
+    m_metrics.Set(Gauge::VramBudgetBytes, static_cast<double>(vram.localBudget));
+    m_metrics.Set(Gauge::Playing, m_playbackState == PlaybackState::Playing ? 1.0 : 0.0);
+    m_metrics.Set(Gauge::WatchdogLevel, static_cast<double>(m_watchdogApplied));
+
+    m_metrics.Set(Counter::LateDrops, m_lateDrops);
+    m_metrics.Set(Counter::RenderAheadUnderruns, m_renderAheadUnderruns);
+    m_metrics.Set(Counter::AudioUnderruns, m_audioPlayer->GetUnderruns());
+    m_metrics.Set(Counter::WatchdogStalls, m_watchdog.GetStalls());
+}
+
+void Application::SetMidiInput(const std::string& device) {
+    auto& cfg = m_configManager.GetConfig();
+    cfg.midiDevice = device;
+    if (device.empty()) {
+        m_controlInput.StopMidi();
+    } else if (!m_controlInput.StartMidi(device)) {
+        cfg.midiDevice.clear();
+        m_uiManager->ShowNotification(m_controlInput.GetError());
+    }
+    SaveConfig();
+}
+
+void Application::LearnControl(const std::string& param, int component) {
+    const ShaderPreset* preset = m_shaderManager->GetActivePreset();
+    if (!preset) return;
+    m_controlLearn = ControlLearn{preset->name, param, component};
+}
+
+void Application::DrainControlInput() {
+    auto& cfg = m_configManager.GetConfig();
+    ShaderPreset* active = m_shaderManager->GetActivePreset();
+    bool activeChanged = false;
+    ControlEvent event;
+    while (m_controlInput.Pop(event)) {
+        m_lastControlAddress = event.address;
+
+        if (m_controlLearn) {
+            const ShaderPreset* preset = nullptr;
+            for (const ShaderPreset& p : m_shaderManager->GetPresets()) {
+                if (p.name == m_controlLearn->preset) preset = &p;
+            }
+            const ShaderParam* param = nullptr;
+            if (preset) {
+                for (const ShaderParam& p : preset->params) {
+                    if (p.name == m_controlLearn->param) param = &p;
+                }
+            }
+            if (param) {
+                // One binding per target: relearning replaces it
+                std::erase_if(cfg.controlMappings, [&](const ControlMapping& m) {
+                    return m.preset == preset->name && m.param == param->name && m.component == m_controlLearn->component;
+                });
+                ControlMapping mapping;
+                mapping.address   = event.address;
+                mapping.preset    = preset->name;
+                mapping.param     = param->name;
+                mapping.component = m_controlLearn->component;
+                const bool unitRange = param->type == ShaderParamType::Color || param->type == ShaderParamType::Bool ||
+                                       param->type == ShaderParamType::Event;
+                mapping.min = unitRange ? 0.0f : param->min;
+                mapping.max = unitRange ? 1.0f : param->max;
+                cfg.controlMappings.push_back(std::move(mapping));
+                m_uiManager->ShowNotification(std::string(event.address) + " -> " + param->name);
+                SaveConfig();
+            }
+            m_controlLearn.reset();
+        }
+
+        for (const ControlMapping& mapping : cfg.controlMappings) {
+            if (mapping.address != event.address) continue;
+            ShaderPreset* preset = nullptr;
+            if (mapping.preset.empty()) {
+                preset = active;
+            } else {
+                const auto& presets = m_shaderManager->GetPresets();
+                for (int i = 0; i < static_cast<int>(presets.size()); ++i) {
+                    if (presets[i].name == mapping.preset) preset = m_shaderManager->GetPreset(i);
+                }
+            }
+            if (!preset) continue;
+            for (ShaderParam& param : preset->params) {
+                if (param.name != mapping.param) continue;
+                const float value = mapping.min + std::clamp(event.value, 0.0f, 1.0f) * (mapping.max - mapping.min);
+                param.values[std::clamp(mapping.component, 0, 3)] = value;
+                if (preset == active) activeChanged = true;
+            }
+        }
+    }
+    // Once for the whole batch: a fader sweep queues many moves per frame
+    if (activeChanged) OnParamChanged();
+}
+
+bool Application::OpenNdiInput(const std::string& sourceName) {
+    CloseVideo();
+    if (!m_ndiInput.Open(m_renderer.GetDevice(), m_renderer.GetContext(), sourceName)) {
+        m_uiManager->ShowNotification("NDI receiver unavailable");
+        return false;
+    }
+    m_generativeTime = 0.0f;
+    m_playbackState  = PlaybackState::Playing;
+    m_lastFrameTime  = PlaybackNow();
+    m_uiManager->ShowNotification("Receiving NDI: " + sourceName);
+    return true;
+}
+
+void Application::CloseMfCapture() {
+    if (!m_mfCapture.IsOpen()) return;
+    m_mfCapture.Close();
+    m_renderer.ClearExternalVideo();
+}
+
+void Application::CloseNdiInput() {
+    if (!m_ndiInput.IsOpen()) return;
+    m_ndiInput.Close();
+    m_renderer.ClearExternalVideo();
+}
+
+void Application::UpdateAudioSettings() {
+    m_audioAnalysis.UpdateSettings(m_configManager.GetConfig().audio);
+    // The settings are baked into the timeline: build (or load) the matching one
+    if (m_audioTimeline.IsReady() || m_audioTimeline.IsBuilding()) RebuildAudioTimeline();
+    SaveConfig();
+}
+
+void Application::SetAudioPreAnalysis(bool enabled) {
+    m_configManager.GetConfig().audioPreAnalysis = enabled;
+    RebuildAudioTimeline();
+    SaveConfig();
+}
+
+void Application::SetTimelineOverview(bool enabled) {
+    m_configManager.GetConfig().timelineOverview = enabled;
+    const bool fileOpen = m_mediaProbe.IsActive() || (m_decoder.IsOpen() && !m_decoder.IsLiveCapture());
+    if (enabled && fileOpen && !m_videoPath.empty()) {
+        m_mediaOverview.Build(m_videoPath);
+    } else {
+        m_mediaOverview.Reset();
+    }
+    SaveConfig();
+}
+
+void Application::SetAudioInput(int source, const std::string& deviceName) {
+    AppConfig& cfg = m_configManager.GetConfig();
+    cfg.audioInput       = source;
+    cfg.audioInputDevice = deviceName;
+    ApplyAudioInput();
+    SaveConfig();
+}
+
+void Application::ApplyAudioInput() {
+    const AppConfig& cfg = m_configManager.GetConfig();
+    // Stop joins the capture callback, so the main thread is the ring's only
+    // producer again before anything is reset or pushed
+    m_audioCapture.Stop();
+    m_audioAnalysis.Reset();
+    if (cfg.audioInput != AUDIO_INPUT_FILE) {
+        m_audioCapture.Start(cfg.audioInput, cfg.audioInputDevice, &m_audioAnalysis);  // GetError() for the UI
+    }
+}
+
+void Application::ResetAudioAnalysis() {
+    if (!m_audioCapture.IsRunning()) m_audioAnalysis.Reset();
+}
+
+void Application::RebuildAudioTimeline() {
+    const AppConfig& cfg = m_configManager.GetConfig();
+    const bool fileOpen = m_mediaProbe.IsActive() || (m_decoder.IsOpen() && !m_decoder.IsLiveCapture());
+    if (cfg.audioPreAnalysis && fileOpen && !m_videoPath.empty()) {
+        m_audioTimeline.Build(m_videoPath, cfg.audio);  // Audio always comes from the source
+    } else {
+        m_audioTimeline.Reset();
+    }
 }
 
 void Application::RegenerateNoise() {
     const auto& n = m_configManager.GetConfig().noise;
-    m_renderer.UpdateNoiseTexture(n.scale, n.textureSize);
+    m_renderer.UpdateNoiseTexture(n.scale, n.textureSize, n.volumeSize);
     SaveConfig();
 }
 
+void Application::UpdateRenderScale() {
+    const AppConfig& cfg = m_configManager.GetConfig();
+    DynamicResolution::Settings settings;
+    settings.enabled  = cfg.dynamicResolution && !m_encoder.IsRecording() && !m_exporting;
+    settings.targetMs = cfg.dynamicResolutionTargetMs;
+    settings.minScale = cfg.dynamicResolutionMinScale;
+
+    // Nothing resolved yet (or the profiler is off): an empty timing holds the scale
+    const GpuProfiler& profiler = m_renderer.GetGpuProfiler();
+    GpuFrameTiming latest;
+    profiler.GetLatest(latest);
+    float scale = m_dynamicResolution.Update(settings, latest, profiler.GetFrameCount());
+    if (m_watchdogApplied >= WatchdogLevel::LowResolution && !m_exporting && !m_benchmark)
+        scale = std::min(scale, DynamicResolution::MIN_SCALE);
+
+    // Only the preview looks at the display texture: no need for more pixels
+    // than the viewport shows. Rounded up to the controller's step, so resizing
+    // the panel doesn't rebuild the scaled target every pixel.
+    const bool fullSizeConsumer = m_encoder.IsRecording() || m_exporting || m_benchmark ||
+                                  m_videoOutputWindow.IsOpen() || m_spoutOutput->IsEnabled() || m_ndiOutput.IsRunning() ||
+                                  m_virtualCamera.IsRunning();
+    const ImVec2 viewport = m_uiManager ? m_uiManager->GetVideoViewportSize() : ImVec2(0.0f, 0.0f);
+    const int displayW = m_renderer.GetDisplayWidth();
+    const int displayH = m_renderer.GetDisplayHeight();
+    if (cfg.previewAtViewportSize && !fullSizeConsumer && viewport.x > 0.0f && displayW > 0 && displayH > 0) {
+        const float fit = std::max(viewport.x / displayW, viewport.y / displayH);
+        scale = std::min(scale, std::ceil(fit / DynamicResolution::STEP) * DynamicResolution::STEP);
+    }
+    m_renderer.SetRenderScale(scale);
+    m_renderer.SetUpscaler(cfg.upscaleFilter, cfg.upscaleSharpness);
+
+    // Recording, export and the benchmark take every frame whole: no sweep across ticks
+    const bool everyFrame = m_encoder.IsRecording() || m_exporting || m_benchmark;
+    m_renderer.SetTiling(cfg.renderTileSize, everyFrame ? 0 : cfg.renderTilesPerFrame);
+}
+
 void Application::ApplyGenerativeResolution() {
     const auto& cfg = m_configManager.GetConfig();
     m_renderer.SetGenerativeResolution(cfg.generativeWidth, cfg.generativeHeight);
@@ -1116,6 +4867,7 @@ std::string Application::FindBindingConflict(int vkCode, int modifiers,
         case VK_F7:     return "reserved for Video Output Window (F7)";
         case VK_F8:     return "reserved for Spout Output panel (F8)";
         case VK_F9:     return "reserved for Start/Stop Recording (F9)";
+        case VK_F11:    return "reserved for Save Replay (F11)";
         }
     }
     // Hardcoded Ctrl combos
@@ -1123,6 +4875,8 @@ std::string Application::FindBindingConflict(int vkCode, int modifiers,
         if (vkCode == 'O') return "reserved for Open Video (Ctrl+O)";
         if (vkCode == 'S') return "reserved for Save Shader (Ctrl+S)";
         if (vkCode == 'N') return "reserved for New Shader (Ctrl+N)";
+        if (vkCode == 'T') return "reserved for Save Trace (Ctrl+T)";
+        if (vkCode == 'R') return "reserved for Record Session (Ctrl+R)";
     }
 
     // Passthrough keybinding
@@ -1,17 +1,49 @@
 #pragma once
 
 #include "Common.h"
-#include "AudioAnalyzer.h"
+#include "CpuProfiler.h"
+#include "FrameArena.h"
+#include "DynamicResolution.h"
+#include "AudioAnalysisThread.h"
+#include "AudioCapture.h"
 #include "AudioPlayer.h"
+#include "AudioReader.h"
+#include "AudioTimeline.h"
 #include "VideoDecoder.h"
+#include "MediaProbe.h"
+#include "MediaOverview.h"
+#include "ProxyTranscoder.h"
+#include "TimeStretch.h"
+#include "DecodeWorker.h"
+#include "VideoInput.h"
+#include "Deck.h"
+#include "PlaybackChannel.h"
 #include "D3D11Renderer.h"
+#include "BackgroundGpuWork.h"
 #include "ShaderManager.h"
+#include "ModulationMatrix.h"
+#include "AutomationRecorder.h"
+#include "ThumbnailAtlas.h"
 #include "VideoEncoder.h"
 #include "UIManager.h"
 #include "ConfigManager.h"
 #include "WorkspaceManager.h"
 #include "VideoOutputWindow.h"
 #include "SpoutOutput.h"
+#include "SpoutInput.h"
+#include "NdiOutput.h"
+#include "MfCaptureInput.h"
+#include "NdiInput.h"
+#include "StillImage.h"
+#include "VirtualCamera.h"
+#include "ControlInput.h"
+#include "MetricsServer.h"
+#include "FrameWatchdog.h"
+#include "FrameSync.h"
+#include "PlaybackBenchmark.h"
+#include "SessionLog.h"
+#include <array>
+#include <future>
 
 namespace SP {
 
@@ -32,13 +64,94 @@ public:
     int Run();
     void RequestExit() { m_exitRequested = true; }
 
-    // Video operations
+    // Video operations. OpenVideo returns once probing has started on a worker; the
+    // first frame appears (or a failure notification) a few ticks later.
     bool OpenVideo(const std::string& filepath);
+    bool IsOpeningVideo() const { return m_mediaProbe.IsActive(); }
+    const std::string& GetOpeningPath() const { return m_videoPath; }
     void CloseVideo();
     void OpenVideoDialog();
 
+    // Playlist (AppConfig::playlist): playing an entry makes the clip's end open
+    // and play the next one instead of looping. The next file is probed ahead of
+    // the end, so the switch only opens its codec. Any other open leaves the playlist.
+    void PlayPlaylistItem(int index);
+    void AddToPlaylistDialog();
+    void PlaylistEdited();  // After reordering or removing entries: find the clip playing again
+    int  GetPlaylistIndex() const { return m_playlistIndex; }  // -1 = not playing from it
+
+    // Extra video inputs for compositing shaders (ISF "image" INPUTS at t4..t7),
+    // kept in sync with the playback clock. Persisted in AppConfig::videoInputs.
+    bool OpenVideoInput(int index, const std::string& filepath);
+    void CloseVideoInput(int index);
+    void OpenVideoInputDialog(int index);
+    const VideoInput& GetVideoInput(int index) const { return m_inputs[index]; }
+
+    // Colour LUTs (.cube/.3dl) for ISF "lut" INPUTS at t20..t23. Persisted in
+    // AppConfig::lutFiles; GetLutSize is 0 for an empty slot.
+    bool OpenLut(int index, const std::string& filepath);
+    void CloseLut(int index);
+    void OpenLutDialog(int index);
+    int GetLutSize(int index) const { return m_lutSizes[index]; }
+    // Bake the active shader's colour transform to a `size`³ .cube (asks where)
+    void BakeLutDialog(int size);
+    // Automation recording (AutomationRecorder): params moved while it runs are
+    // written into the active preset's timelines, fitted to few keys, at Stop
+    void StartAutomationRecording();
+    void StopAutomationRecording();
+    bool IsAutomationRecording() const { return m_automation.IsRecording(); }
+    int  GetAutomationLatchedCount() const { return m_automation.GetLatchedCount(); }
+    // Still of the active shader at a size past the texture limit (LED walls,
+    // up to D3D11Renderer::MAX_CANVAS_SIZE): equal tiles of at most the tile
+    // size, one drawn per tick, written like an image sequence in row-major
+    // order next to "<stem>_tiles.json" with each tile's canvas position. Asks
+    // where; single-pass presets only.
+    void ExportTiledStillDialog(int width, int height, int tileSize);
+    bool IsExportingTiles() const { return m_tiledExport != nullptr; }
+    float GetTiledExportProgress() const;  // 0..1
+
+    // A/B decks: deck A is the main player and active preset; deck B is a clip
+    // cued in the background with its own preset (AppConfig::deckVideo/deckPreset),
+    // brought in over A by the crossfader (0 = A, 1 = B). Deck B starts playing
+    // from its cue point when the fader leaves A.
+    void CueDeck(const std::string& filepath);
+    void CueDeckDialog();
+    void UnloadDeck();
+    Deck& GetDeck() { return m_deck; }
+    void  SetCrossfader(float position) { m_crossfader = std::clamp(position, 0.0f, 1.0f); }
+    float GetCrossfader() const { return m_crossfader; }
+
+    // Extra playback channels (AppConfig::channels) for multi-projector installs:
+    // each has its own clip, clock, preset and output window, and shares this
+    // process's device, shader cache, target pool and cores with deck A. They
+    // play and pause with the main transport and loop their clips.
+    void AddChannel();
+    void RemoveChannel(int channel);
+    void CueChannel(int channel, const std::string& filepath);
+    void CueChannelDialog(int channel);
+    void UnloadChannel(int channel);
+    void SetChannelPreset(int channel, const std::string& preset);  // Empty = the clip as is
+    void SetChannelOutput(int channel, bool open);
+    int  GetChannelCount() const { return static_cast<int>(m_channels.size()); }
+    const PlaybackChannel& GetChannel(int channel) const { return *m_channels[channel]; }
+
+    // Canvas spanning several output windows (AppConfig::canvasOutputs): the frame
+    // is rendered once and each window shows its region of the display texture,
+    // edge-blended and warped in its own blit. Regions are edited in the config
+    // (then SaveConfig); SetCanvasLayout lays `count` of them side by side with
+    // `overlap` of the canvas width blended between neighbours.
+    void SetCanvasEnabled(bool enabled);
+    void SetCanvasLayout(int count, float overlap);
+    bool IsCanvasOutputOpen(int output) const {
+        return output < static_cast<int>(m_canvasWindows.size()) && m_canvasWindows[output]->IsOpen();
+    }
+
     // Live capture (webcam / RTSP stream)
-    bool OpenCapture(const std::string& deviceOrUrl, bool isDshow = true);
+    // `mode` null = CaptureDevices::PickBest for dshow devices. With
+    // AppConfig::mediaFoundationCapture, devices open in MfCaptureInput first.
+    bool OpenCapture(const std::string& deviceOrUrl, bool isDshow = true, const CaptureMode* mode = nullptr);
+    void CloseMfCapture();
+    const MfCaptureInput& GetMfCapture() const { return m_mfCapture; }
     void OpenCaptureDialog();
 
     // Playback control
@@ -47,21 +160,116 @@ public:
     void Stop();
     void TogglePlayback();
     void SeekTo(double seconds);
+    // Timeline drags. ScrubTo shows a cached frame or the keyframe at or before
+    // `seconds` at once (nothing discarded; nothing at all within the GOP already
+    // shown), pausing playback until EndScrub. Once the mouse rests
+    // SCRUB_REFINE_DELAY, or on EndScrub, the decode worker seeks to the exact
+    // frame in the background; a newer ScrubTo cancels that seek mid-decode.
+    void ScrubTo(double seconds);
+    void EndScrub();
     PlaybackState GetPlaybackState() const { return m_playbackState; }
     float GetPlaybackTime() const { return m_playbackTime; }
+    // Live capture: packet read to present, averaged over ~30 frames (0 until measured)
+    float GetLiveLatencyMs() const { return m_liveLatencyMs; }
+    // Variable speed, 0.25x-8x (file playback). Fast rates decode non-reference
+    // frames / keyframes only; audio is time-stretched, or muted when
+    // AppConfig::stretchAudio is off.
+    void SetPlaybackRate(double rate);
+    double GetPlaybackRate() const { return m_playbackRate; }
+    void SetStretchAudio(bool enabled);
+    // File playback sync (AppConfig::syncMode). Late drops = frames that were due
+    // together with a newer one and never shown.
+    void SetSyncMode(int mode);
+    int64_t GetLateDrops() const { return m_lateDrops; }
+    // A/B loop region (file playback, runtime): forward playback crossing the out
+    // point jumps back to the in point. Once a whole pass has been shown and fits
+    // AppConfig::loopCacheMB, the region replays from VRAM (LoopCache) with no
+    // seek or decode until it is cleared, sought out of or paused and changed.
+    void SetLoopIn();   // At the playhead
+    void SetLoopOut();
+    void ClearLoopRegion();
+    bool   HasLoopRegion() const { return m_loopOut > m_loopIn; }
+    double GetLoopIn() const { return m_loopIn; }
+    double GetLoopOut() const { return m_loopOut; }
+    bool   IsLoopReplaying() const { return m_loopReplaying; }
+    // Render-ahead (AppConfig::renderAheadFrames, 0 = off): forward file playback
+    // draws frames ahead of the playhead into a RenderAheadQueue and shows each at
+    // its time, so a slow frame or a compile eats into the queue instead of
+    // dropping. Off for live sources, reverse, loop regions, playlists, exports
+    // and a tapped Spout pass.
+    void SetRenderAheadFrames(int frames);
+    bool IsRenderingAhead() const { return m_renderingAhead; }
+    int64_t GetRenderAheadUnderruns() const { return m_renderAheadUnderruns; }  // Ticks due with none ready
+    // File playback cadence since the file was opened
+    struct CadenceStats {
+        int64_t held[4] = {};       // Frames on screen for 1, 2, 3 and 4+ ticks
+        double  meanErrorMs = 0.0;  // |selected - due|, running average
+        double  maxErrorMs  = 0.0;
+    };
+    const CadenceStats& GetCadenceStats() const { return m_cadence; }
+    // File playback direction; Reverse/PingPong decode GOP chunks on the worker
+    void SetPlaybackDirection(PlaybackDirection direction);
+    PlaybackDirection GetPlaybackDirection() const { return m_playDirection; }
+    bool IsPlayingBackward() const { return m_playingBackward; }
 
     // Shader operations
+    // Queues a background compile of the active preset; the result is notified when it lands
     bool CompileCurrentShader(const std::string& source);
     bool SaveCurrentShader(const std::string& source);
     void SaveShaderAsDialog(const std::string& source);
     void ScanFolderDialog();
 
     // Recording
-    bool StartRecording(const RecordingSettings& settings);
+    // `extraTargets` are recorded alongside from the same frames: one readback, or
+    // one GPU conversion per hardware encoder, and a thread per target
+    bool StartRecording(const RecordingSettings& settings, const std::vector<RecordingSettings>& extraTargets = {});
     void StopRecording();
+    // Instant replay: writes the encoder's ring to <outputPath>_replay_<time>
+    bool SaveReplay();
+    // Dumps the last traceSeconds of CPU/GPU scopes to traces/trace_<time>.json next to the exe
+    bool SaveTrace();
     void OpenRecordingOutputDialog(char* pathBuf, size_t bufSize);
+    // Measures the libx264 profiles (VideoEncoder::CalibrateProfiles) at the size
+    // and rate a take with `settings` would have, on a worker; the UI gets the
+    // result (UIManager::OnEncoderCalibrated). False while recording or running.
+    bool StartEncoderCalibration(const RecordingSettings& settings);
+    bool IsCalibratingEncoder() const { return m_encoderCalibration.valid(); }
+
+    // Offline export: records from the start without drops, stepping time by
+    // exactly 1/fps as fast as the GPU and encoder allow (no vsync, UI refreshed
+    // a few times a second). A video exports each source frame to its end;
+    // generative shaders export `durationSeconds`. With `subframes` > 1 each
+    // frame is temporally supersampled (D3D11Renderer::SetTemporalSupersampling)
+    // over `shutter` of the frame interval.
+    bool StartExport(const RecordingSettings& settings, double durationSeconds,
+                     const std::vector<RecordingSettings>& extraTargets = {}, int subframes = 1,
+                     float shutter = 0.5f);
+    void CancelExport();
+    bool    IsExporting() const { return m_exporting; }
+    int64_t GetExportFrame() const { return m_exportFrame; }
+    int64_t GetExportTotalFrames() const { return m_exportTotalFrames; }
+    double  GetExportSpeed() const;  // Media seconds per wall second
+    double  GetExportEta() const;    // Seconds, -1 = unknown yet
 
-    // Configuration
+    // Playback benchmark (--playback-bench, PlaybackBenchmark.h): plays each clip
+    // through the file's preset with vsync and pacing off, writes the report and
+    // quits with 0, or 1 if a clip failed. False with `error` set if it can't start.
+    bool StartPlaybackBenchmark(const std::string& path, std::string& error);
+    bool IsBenchmarking() const { return m_benchmark != nullptr; }
+
+    // Session recording (Ctrl+R, SessionLog.h): opens, preset switches, param
+    // values, keyframe edits, seeks, transport and audio settings, timestamped;
+    // saved to sessions/session_<time>.json next to the exe when stopped
+    void ToggleSessionRecording();
+    bool IsRecordingSession() const { return m_sessionRecording; }
+    // --replay: drives the app from a recorded session on a fixed clock, uncapped,
+    // then writes <name>.replay.json (CPU/GPU stage timings) and <name>.trace.json
+    // beside the file and quits (0, or 1 if an event failed). config.json is left alone.
+    bool StartSessionReplay(const std::string& path, std::string& error);
+    bool IsReplayingSession() const { return m_sessionReplaying; }
+
+    // Configuration. SaveConfig is cheap: the write happens CONFIG_SAVE_DELAY
+    // after the last call, serialised on the ConfigManager writer thread.
     void SaveConfig();
 
     // Video output window — separate OS window for screen-sharing
@@ -70,10 +278,88 @@ public:
 
     // Spout output — GPU texture sharing with Spout-aware receivers
     void SetSpoutEnabled(bool enabled);
-    bool IsSpoutEnabled()  const { return m_spoutOutput.IsEnabled(); }
-    bool IsSpoutActive()   const { return m_spoutOutput.IsActive(); }
-    std::string GetSpoutActiveSenderName() const { return m_spoutOutput.GetActiveSenderName(); }
+    bool IsSpoutEnabled()  const { return m_spoutOutput->IsEnabled(); }
+    bool IsSpoutActive()   const { return m_spoutOutput->IsActive(); }
+    std::string GetSpoutActiveSenderName() const { return m_spoutOutput->GetActiveSenderName(); }
     void SetSpoutSenderName(const std::string& name);
+    // 0x0 = the render size. `pass` names a render-graph pass of the active
+    // preset to send instead of the output (-1); presets without it send the output.
+    void SetSpoutOutputSize(int width, int height);
+    void SetSpoutPass(int pass);
+    const SpoutSendStats& GetSpoutStats() const { return m_spoutOutput->GetStats(); }
+
+    // Spout input — another application's shared texture as the video source
+    // (t0) instead of a file or capture device; opening either closes it. Time
+    // runs by wall clock as for a generative shader. Empty name = active sender.
+    bool OpenSpoutInput(const std::string& senderName);
+    void CloseSpoutInput();
+    const SpoutInput& GetSpoutInput() const { return m_spoutInput; }
+
+    // NDI output and input (SHADERPLAYER_NDI builds with the NDI runtime
+    // installed). The sender works like Spout over the network; the receiver
+    // replaces the video like the Spout input.
+    bool IsNdiAvailable() const { return NdiOutput::IsAvailable(); }
+    void SetNdiEnabled(bool enabled);
+    bool IsNdiRunning() const { return m_ndiOutput.IsRunning(); }
+    void SetNdiSenderName(const std::string& name);
+    void SetNdiOutputSize(int width, int height);  // 0x0 = the render size
+    NdiSendStats GetNdiStats() const { return m_ndiOutput.GetStats(); }
+    std::vector<std::string> ListNdiSources() { return m_ndiInput.ListSources(); }
+    bool OpenNdiInput(const std::string& sourceName);
+    void CloseNdiInput();
+    const NdiInput& GetNdiInput() const { return m_ndiInput; }
+
+    // A single still opened with OpenVideo: decoded once off the UI thread and
+    // bound at t0 as an immutable texture, time running as for Spout input.
+    // Animated or WIC-unreadable images fall back to the decoder.
+    const StillImage& GetStillImage() const { return m_stillImage; }
+
+    // Virtual camera (Windows 11, ShaderPlayerVCam.dll registered)
+    bool IsVirtualCameraAvailable() const { return VirtualCamera::IsAvailable(); }
+    void SetVirtualCameraEnabled(bool enabled);
+    bool IsVirtualCameraRunning() const { return m_virtualCamera.IsRunning(); }
+    void SetVirtualCameraName(const std::string& name);
+    VirtualCameraStats GetVirtualCameraStats() const { return m_virtualCamera.GetStats(); }
+
+    // Controller input (OSC and MIDI). Moves are drained at the top of each
+    // RenderFrame through AppConfig::controlMappings. Learn arms one component of
+    // an active-preset param; the next address that arrives is bound to it.
+    void SetOscInput(bool enabled, int port);
+    void SetMidiInput(const std::string& device);  // Empty = none
+    const ControlInput& GetControlInput() const { return m_controlInput; }
+    void LearnControl(const std::string& param, int component);
+    void CancelControlLearn() { m_controlLearn.reset(); }
+    bool IsLearningControl(const std::string& param, int component) const {
+        return m_controlLearn && m_controlLearn->param == param && m_controlLearn->component == component;
+    }
+    const std::string& GetLastControlAddress() const { return m_lastControlAddress; }
+
+    // Prometheus endpoint for unattended installs (AppConfig::metricsEnabled).
+    // PublishMetrics copies the counters in about once a second.
+    void SetMetricsServer(bool enabled, int port);
+    const MetricsServer& GetMetricsServer() const { return m_metrics; }
+
+    // Frame-stall watchdog (AppConfig::watchdogEnabled): steps the active shader
+    // down through WatchdogLevel when the loop or the GPU stalls. SetWatchdog and
+    // ApplyWatchdogSettings read the config; ResetWatchdog restores Normal (the
+    // reduced scale lifts, reset params and passthrough stay as they are).
+    void SetWatchdog(bool enabled);
+    void ApplyWatchdogSettings();
+    void ResetWatchdog();
+    const FrameWatchdog& GetWatchdog() const { return m_watchdog; }
+    WatchdogLevel GetWatchdogLevel() const { return m_watchdogApplied; }
+
+    // Network frame sync for video walls (AppConfig::frameSyncRole, FRAME_SYNC_*):
+    // the master broadcasts its playback clock; a follower takes the master's
+    // play state and rate, and selects frames by the master's clock once locked.
+    void SetFrameSync(int role, int port);
+    const FrameSync& GetFrameSync() const { return m_frameSync; }
+    bool IsFrameSyncLocked() const { return m_frameSyncLocked; }
+
+    // Per-output post chains (AppConfig::postChains): edit the config, then
+    // call SaveConfig; the stages are rebuilt every tick. The Video viewport
+    // shows GetPreviewSRV: its chain's result, else the display texture.
+    ID3D11ShaderResourceView* GetPreviewSRV() const;
 
     // Noise generator — regenerates the global t1 noise texture from current config
     void RegenerateNoise();
@@ -81,10 +367,54 @@ public:
     // Audio analysis settings (beat sensitivity, smoothing, etc.)
     void UpdateAudioSettings();
     const AudioData& GetAudioData() const { return m_audioData; }
+    // Whole-track pre-analysis of the open file — persisted; AudioData is looked
+    // up from the timeline by playback time once it is ready
+    void SetAudioPreAnalysis(bool enabled);
+    const AudioTimeline& GetAudioTimeline() const { return m_audioTimeline; }
+    // Filmstrip and waveform over the transport bar, built on open — persisted
+    void SetTimelineOverview(bool enabled);
+    const MediaOverview& GetMediaOverview() const { return m_mediaOverview; }
+    // Analyse the file (AUDIO_INPUT_FILE) or a live input device — persisted
+    void SetAudioInput(int source, const std::string& deviceName);
+    AudioCapture& GetAudioCapture() { return m_audioCapture; }  // Device lists, state
+
+    // Hardware (D3D11VA) decode toggle — persisted; reopens the current file
+    void SetHardwareDecode(bool enabled);
+    // Per-codec choice (codec = FFmpeg name) — persisted; reopens the current file
+    void SetHwDecodePolicy(const std::string& codec, HwDecodePolicy policy);
+    const HardwareDecodeCaps& GetHardwareDecodeCaps() const { return m_hwDecodeCaps; }
+    // Software-decode YUV→RGB on the GPU instead of sws_scale — applies immediately
+    void SetGpuYuvConversion(bool enabled);
+    // Hardware frames through the fixed-function video processor — applies from the next frame
+    void SetVideoProcessorConversion(bool enabled);
+    // 10/12-bit sources through a 16-bit video texture and working format — from the next frame
+    void SetHighBitDepth(bool enabled);
+    // Decoder thread count (0 = auto) and type (0 = auto, 1 = frame, 2 = slice) —
+    // persisted; reopens the current file
+    void SetDecodeThreading(int threadCount, int threadType);
+    // Proxy playback at 1/scale (1 = off, 2, 4) — persisted; reopens the current
+    // file. Suspended while recording, which always renders at full size.
+    void SetProxyScale(int scale);
+    // Edit proxies (AppConfig::editProxies) — persisted; builds the current file's
+    // proxy in the background and switches to it when ready
+    void SetEditProxies(bool enabled);
+    // Image sequence fps and RAM-cache budget — persisted; reopens a sequence
+    // that is playing
+    void SetImageSequenceOptions(double fps, int cacheMB);
+    bool IsUsingEditProxy() const { return m_usingEditProxy; }
+    const ProxyTranscoder& GetProxyTranscoder() const { return m_proxyTranscoder; }
+    // GPU scrub cache VRAM budget in MB (0 = off) — persisted; applies immediately
+    void SetScrubCacheBudget(int megabytes);
+    // Loop region cache VRAM budget in MB (0 = off) — persisted; the region recaches
+    void SetLoopCacheBudget(int megabytes);
 
     // Audio playback volume / mute — persisted to config.json
     void SetAudioVolume(float vol);
     void SetAudioMute(bool mute);
+    // Exclusive-mode, small-period output with a short fill target — persisted;
+    // reopens the device
+    void SetAudioLowLatency(bool enabled);
+    const AudioPlayer& GetAudioPlayer() const { return *m_audioPlayer; }
 
     // Generative resolution — applies config.generativeWidth/Height to the renderer
     void ApplyGenerativeResolution();
@@ -93,11 +423,26 @@ public:
 
     // Component access
     VideoDecoder& GetDecoder() { return m_decoder; }
+    const AudioReader& GetAudioReader() const { return m_audioReader; }
+    const DecodeWorker& GetDecodeWorker() const { return m_decodeWorker; }
     D3D11Renderer& GetRenderer() { return m_renderer; }
     ShaderManager& GetShaderManager() { return *m_shaderManager; }
+    ThumbnailAtlas& GetThumbnails() { return m_thumbnails; }
+    const BackgroundGpuWork& GetBackgroundWork() const { return m_backgroundWork; }
     VideoEncoder& GetEncoder() { return m_encoder; }
+    const std::vector<std::unique_ptr<VideoEncoder>>& GetExtraEncoders() const { return m_extraEncoders; }
     UIManager& GetUI() { return *m_uiManager; }
     WorkspaceManager& GetWorkspaceManager() { return *m_workspaceManager; }
+    // Main-loop stage timings (the GPU side is m_renderer.GetGpuProfiler())
+    CpuProfiler& GetCpuProfiler() { return m_cpuProfiler; }
+    FrameArena& GetFrameArena() { return m_frameArena; }  // Main thread, this tick's scratch
+    const DynamicResolution& GetDynamicResolution() const { return m_dynamicResolution; }
+    // Every subsystem's current footprint (the renderer's pools and caches, the
+    // decode, audio and encode queues), for the memory panel and the benchmarks
+    void GetMemoryUsage(std::vector<MemoryUsage>& out) const;
+    // The OS lowered the video memory budget below what the process uses: caches
+    // were shrunk and stay small until the budget recovers
+    bool IsUnderMemoryPressure() const { return m_memoryPressure; }
 
     // Key name helper
     std::string GetKeyName(int vkCode) const;
@@ -118,6 +463,7 @@ public:
 
     // Called by UIManager after any shader parameter widget changes value.
     void OnParamChanged();
+    void CheckEditorCompile();  // After PollCompiles: notify / apply the editor's compile
 
 private:
     // Window handling
@@ -126,12 +472,127 @@ private:
     bool CreateMainWindow(HINSTANCE hInstance, int nCmdShow);
     void HandleDroppedFiles(HDROP hDrop);
     void HandleKeyboardShortcuts(UINT vkCode);
-    static void PackParamValues(const ShaderPreset& preset, float out[16]);
     void EvaluateKeyframes();
+    void DrainControlInput();  // Controller moves queued since the last tick, applied before the keyframes
+    void UpdateAudioData();   // Audio cbuffer and spectrum for m_playbackTime
+    void UpdateModulation();  // LFO and audio rows over the packed params, after the audio update
+    void PrepareFrameAt(double seconds);  // Clock, keyframes, audio and modulation of a frame at `seconds`
+    // On a video memory budget change: over budget, frees cached VRAM (recycled
+    // targets, scrub cache, loop cache); with room again, restores the configured budgets
+    void UpdateMemoryBudget();
 
     // Frame processing
     void ProcessFrame();
+    void WriteConfig();  // SaveConfig's deferred write: snapshot now, serialise on the writer thread
     void RenderFrame();
+    // After Present: the background GPU work, when the last frames left slack
+    void RunBackgroundWork();
+    // Dynamic resolution step from the newest GPU timings; full size while recording or exporting
+    void UpdateRenderScale();
+    // What this tick renders, from who can see it: everything; the outputs without
+    // the UI (main window minimized or occluded, an output window, Spout or a
+    // recording still consuming); or nothing, waiting on messages between ticks
+    enum class RenderPolicy { Full, OutputsOnly, Hidden };
+    RenderPolicy ChooseRenderPolicy();
+    void WaitWhileHidden();  // Hidden: until a message arrives or the next tick is due
+    // Frame pacing: sleeps until the next tick under frameRateCap (or, with the UI
+    // throttled and no cap, the output window's monitor refresh); no-op when uncapped
+    void WaitForTickDeadline();
+    double GetTickInterval();       // Seconds, 0 = uncapped
+    bool IsUiRefreshDue(std::chrono::steady_clock::time_point now) const;
+    // Window drags, the system menu and file dialogs run their own message loop on
+    // this thread; while one is open a timer ticks playback and the outputs from it
+    void BeginModalLoop();
+    void EndModalLoop();
+    void ModalTick();
+    bool SubmitReadback(bool wait);  // Oldest recording readback to the encoder, false if none
+    void StepExport();                 // ProcessFrame while exporting
+    void FinishExport(bool completed);
+    void StepPlaybackBenchmark();      // After RenderFrame while benchmarking
+    void OpenBenchmarkClip();          // m_benchClip, or finish after the last one
+    void FinishPlaybackBenchmark();
+    void RecordSessionEvent(SessionEventType type, nlohmann::json data);  // No-op unless recording
+    void CaptureSessionState();        // After RenderFrame while recording: preset, keyframe and audio changes
+    void StepSessionReplay();          // After RenderFrame while replaying
+    bool ApplySessionEvent(const SessionEvent& event);
+    void FinishSessionReplay();
+    // Playback clock: wall time, or the fixed session clock while replaying
+    std::chrono::steady_clock::time_point PlaybackNow() const;
+    void ApplyParamValues();  // OnParamChanged without recording it (keyframes, replay)
+    void ReopenCurrentVideo();  // After a decoder setting that only applies on open
+    void ApplyProxySettings();  // Proxy scale + edit proxy, or the full-size source while recording
+    std::string PlaybackPathFor(const std::string& source) const;  // Its edit proxy when in use
+    void StartEditProxy();      // Transcode m_videoPath if it needs and lacks a proxy
+    void FinishOpenVideo(MediaProbe& probe);  // Render thread, once the probe is done
+    void StartVideoOpen(const std::string& filepath);  // OpenVideo's probe and audio open
+    bool OpenStillImage(const std::string& filepath);   // OpenVideo for a single WIC still
+    void PollStillImage();                               // ProcessFrame: upload once, or fall back
+    void CloseStillImage();
+    bool PlaylistAdvances() const;  // The clip's end opens the next entry rather than looping
+    void PreopenPlaylistNext();     // Near the clip's end: probe the next entry
+    void OnPlaybackLooped();        // The frame just popped starts the clip's next pass
+    void ArmLoopCache();            // Stop any replay; size the LoopCache to the region
+    bool PassedLoopOut(double before) const;  // The frame just popped crossed the out point
+    void WrapLoopRegion(std::chrono::steady_clock::time_point now);  // Back to the in point
+    void StartLoopReplay(std::chrono::steady_clock::time_point now);
+    void StepLoopReplay(std::chrono::steady_clock::time_point now);  // Playing, replaying: show what is due
+    void StopLoopReplay();          // Seek the decoder back to the playhead
+    bool RenderAheadApplies() const;
+    void StepRenderAhead(std::chrono::steady_clock::time_point now);  // ProcessFrame: show what is due
+    void ShowRenderAheadFront();    // The queue's front is on screen: playhead and pending seek to it
+    void FillRenderAhead();         // RenderFrame: redraw stale entries, draw new ones, present the front
+    void StopRenderAhead();         // Drop the queue; seek the decoder back to the playhead
+    void ResyncLoopedAudio(double target);  // Re-seek audio that did not wrap with the video
+    void SyncVideoInputs();  // Extra inputs to m_playbackTime
+    void UpdateLayers();     // AppConfig::layers, then deck B, to the renderer's compositor stack
+    void UpdateDeck();       // Adopt a finished cue, run deck B's clock, upload its frame
+    void UpdateChannels();   // Adopt finished cues, follow the transport, notice closed windows
+    void OpenCanvasOutputs();
+    void CloseCanvasOutputs();
+    void UpdateCanvasOutputs();  // Every window closed by hand: the canvas is off
+    bool OpenChannelOutput(int channel);
+    void ApplySpoutPass();   // Renderer tap for AppConfig::spoutPass while Spout is on
+    void UpdatePostChains(); // AppConfig::postChains to stages, and their bindings to the renderer
+    // Output `output`'s chain over `source` at its size; null when it has no
+    // stages (the output takes its usual frame)
+    ID3D11ShaderResourceView* RunPostChain(int output, ID3D11ShaderResourceView* source, int width, int height);
+    bool BuildDeckLayer(D3D11Renderer::Layer& out);  // False until deck B and its preset are ready
+    void SeekDecoder(double seconds, bool seekAudio = true);  // Exact seek + decode into m_currentFrame
+    void RefineScrub();                // Exact seek to m_pendingSeekTime, decoded by the worker
+    void StepScrub();                  // ProcessFrame: refine when due, take the refined frame
+    void RestartDecodeWorker(bool backward);  // Continue from m_currentFrame in that direction
+    void FeedAudio();  // Top the player up from m_audioReader
+    void AnalyzeHeardAudio();  // Feed the analyzer what has reached the speakers since last tick
+    void RebuildAudioTimeline();  // For the open file and current AudioSettings, or reset
+    void ApplyAudioInput();  // Start or stop m_audioCapture for AppConfig::audioInput
+    void ResetAudioAnalysis();  // File audio went stale; a no-op while a live input feeds the analysis
+    double AudibleAudioTime() const;  // Media time now leaving the speakers, -1 if unknown
+    bool PopSyncedFrame(std::chrono::steady_clock::time_point now);  // Audio-master: pop what is due
+    double SyncClock(std::chrono::steady_clock::time_point now);     // Audio time, else wall clock
+    void ResetSync();  // After any discontinuity: re-anchor on the next frame, stop skipping
+    void RecordCadence(double lateSeconds);  // A frame was selected this late (wall seconds, < 0 = early)
+    void UpdateDecodeSkip();  // Decoder skip flags for the current rate and catch-up state
+    void FlushAudioOutput();  // Player + time stretcher; wherever queued audio goes stale
+    void InitAudioOutput();  // (Re)open the player per AppConfig::audioLowLatency
+    void OnAudioOutputOpened(int oldRate);  // Volume, mute and the reader for a new player
+
+    // Startup work with no dependency on the window or each other: the audio
+    // device, the Spout sender and the noise kernels' compile run on workers
+    // while the first frames draw. FinishStartupTasks takes each result on the
+    // main thread once ready, or after waiting for it; until then the placeholder
+    // player and sender are silent and closed, and t1 has no noise.
+    void StartStartupTasks();
+    void FinishStartupTasks(bool wait);
+    std::future<std::unique_ptr<AudioPlayer>> m_audioStartup;
+    std::future<std::unique_ptr<SpoutOutput>> m_spoutStartup;  // Null when Spout is missing
+    std::future<void> m_noiseStartup;
+    void PublishMetrics();  // Every METRICS_PUBLISH_INTERVAL while the server runs
+    void ApplyWatchdog();   // Top of ProcessFrame: acts on a level the watchdog raised
+    void UpdateFrameSync(std::chrono::steady_clock::time_point now);  // Follower: play state, seeks, m_frameSyncClock
+    void PublishFrameSync();  // Master: the clock this tick ran on
+    bool AudioFollowsPlayback() const;  // Audio open and audible at the current rate
+    size_t ReverseBudgetBytes() const;
+    int64_t FrameKey(double frameTime) const;  // Scrub cache key for a frame timestamp
 
     // Window
     HWND m_hwnd = nullptr;
@@ -139,31 +600,234 @@ private:
     int m_windowHeight = 720;
 
     // Components
-    AudioAnalyzer m_audioAnalyzer;
-    AudioPlayer   m_audioPlayer;
+    AudioAnalysisThread m_audioAnalysis;  // Live AudioAnalyzer, off the main thread
+    AudioCapture  m_audioCapture;  // Live input pushed into m_audioAnalysis instead of the file's audio
+    // Replaced whole by the one StartStartupTasks opened: nothing else writes it
+    std::unique_ptr<AudioPlayer> m_audioPlayer = std::make_unique<AudioPlayer>();
+    AudioReader   m_audioReader;  // File audio on its own demuxer + thread
+    AudioTimeline m_audioTimeline;  // The same file pre-analysed; replaces m_audioAnalysis once ready
+    MediaOverview m_mediaOverview;  // Filmstrip + waveform of the open file for the transport bar
+    TimeStretch   m_timeStretch;  // Reader -> player away from 1x
+    std::vector<float> m_stretchBuf;
+    // Frames submitted to the player wait here (interleaved) until they are heard,
+    // so AudioData describes the audio playing now rather than the ring's ~2 s lead.
+    // Counts are in frames since the last FlushAudioOutput, at the reader's rate.
+    std::vector<float> m_analysisQueue;
+    size_t  m_analysisRead      = 0;  // First queued frame not analysed yet
+    int64_t m_analysisSubmitted = 0;
+    int64_t m_analysisFed       = 0;
+    float   m_heardWaveform[AudioData::kWaveformSamples][AUDIO_CHANNELS] = {};  // Newest heard frames, oldest first
+    MediaProbe    m_mediaProbe;   // Async open in flight
+    double        m_openResumeTime = 0.0;  // Seek here once the open finishes (reopen)
+    bool          m_playOnOpen = false;    // Play once the open finishes (playlist)
+    double        m_loopIn  = 0.0;         // A/B loop region; none while out <= in
+    double        m_loopOut = 0.0;
+    bool          m_loopReplaying = false; // Showing the region from the LoopCache
+    double        m_loopAnchorTime = 0.0;  // Replay clock: media time at m_loopAnchorWall
+    std::chrono::steady_clock::time_point m_loopAnchorWall{};
+    int64_t       m_loopReplayKey = -1;    // Frame on screen while replaying
+    bool          m_renderingAhead = false;  // This tick shows frames from the RenderAheadQueue
+    int64_t       m_renderAheadUnderruns = 0;
+    MediaProbe    m_nextProbe;             // Next playlist entry, probed ahead
+    int           m_playlistIndex = -1;
+    std::string   m_videoPath;    // Source file; the decoder may be reading its edit proxy
+    bool          m_usingEditProxy = false;
+    bool          m_editProxyReady = false;  // Switch to the new proxy once paused
+    ProxyTranscoder m_proxyTranscoder;  // Edit proxy of m_videoPath being built
     AudioData     m_audioData;
+    HardwareDecodeCaps m_hwDecodeCaps;  // Probed once the renderer's device exists
     VideoDecoder  m_decoder;
+    int           m_seenHwFallbacks = 0;  // VideoDecoder::GetHardwareFallbacks already notified
+    DecodeWorker  m_decodeWorker{m_decoder};  // Must follow m_decoder (init + destroy order)
+    std::array<VideoInput, MAX_VIDEO_INPUTS> m_inputs;
+    std::array<int, MAX_LUTS> m_lutSizes = {};
+    Deck  m_deck;
+    std::vector<std::unique_ptr<PlaybackChannel>> m_channels;  // One per AppConfig::channels entry
+    std::vector<std::unique_ptr<VideoOutputWindow>> m_canvasWindows;  // One per AppConfig::canvasOutputs entry
+    float m_crossfader = 0.0f;
+    ID3D11PixelShader* m_deckPrewarmed = nullptr;  // Deck B's shader, once drawn off screen
+    std::array<D3D11Renderer::PostChain, POST_OUTPUT_COUNT>              m_postChains;
+    std::array<std::vector<D3D11Renderer::PostStage>, POST_OUTPUT_COUNT> m_postStages;
+    int         m_pendingLutBakeSize = 0;  // Drawn by the "LUT bake" background task
+    std::string m_pendingLutBakePath;
+    D3D11Renderer::LutBake m_lutBake;      // In flight: read back and saved once its copy lands
+    std::string m_lutBakePath;
+    std::string m_lutBakeTitle;
+    // ExportTiledStillDialog: a tile after each tick's render
+    struct TiledExport {
+        ImageSequenceWriter writer;
+        FramePool      pool;
+        std::string    path;
+        nlohmann::json tiles = nlohmann::json::array();
+        float time       = 0.0f;  // Every tile sees the clock of the start
+        int   width      = 0;
+        int   height     = 0;
+        int   tileWidth  = 0;
+        int   tileHeight = 0;
+        int   columns    = 0;
+        int   rows       = 0;
+        int   next       = 0;
+    };
+    std::unique_ptr<TiledExport> m_tiledExport;
+    void StepTiledExport();
     D3D11Renderer m_renderer;
     std::unique_ptr<ShaderManager> m_shaderManager;
+    ThumbnailAtlas m_thumbnails;
+    BackgroundGpuWork m_backgroundWork;  // Thumbnails, prewarm and LUT bakes, after Present
+    ModulationMatrix m_modulation;  // The active preset's rows
+    AutomationRecorder m_automation;
     VideoEncoder m_encoder;
+    RecordingSettings m_recordingSettings;  // Of the current/last recording
+    std::atomic<bool> m_calibrationCancel{false};
+    std::future<EncoderCalibration> m_encoderCalibration;  // Reads m_calibrationCancel
+    void UpdateEncoderCalibration();  // Hands a finished calibration to the UI
+    // Size and rate StartRecording records at before RecordingSettings' own
+    void GetRecordingSource(const RecordingSettings& settings, int& width, int& height, double& fps) const;
+    std::vector<std::unique_ptr<VideoEncoder>> m_extraEncoders;  // Further targets of the current/last take
+    VideoEncoder* m_readbackEncoder = nullptr;  // First software target: its pool and layout take the readback
+    bool m_memoryPressure = false;  // UpdateMemoryBudget shrank the caches
     std::unique_ptr<UIManager> m_uiManager;
     ConfigManager m_configManager;
+    bool m_configSavePending = false;  // SaveConfig called since the last write
+    std::chrono::steady_clock::time_point m_configSaveDue{};
     std::unique_ptr<WorkspaceManager> m_workspaceManager;
     VideoOutputWindow m_videoOutputWindow;
-    SpoutOutput m_spoutOutput;
+    std::unique_ptr<SpoutOutput> m_spoutOutput = std::make_unique<SpoutOutput>();  // As m_audioPlayer
+    SpoutInput  m_spoutInput;
+    NdiOutput   m_ndiOutput;
+    NdiInput    m_ndiInput;
+    MfCaptureInput m_mfCapture;
+    StillImage  m_stillImage;
+    std::string m_stillImageFallback;  // WIC failed on it: OpenVideo decodes it instead
+    VirtualCamera m_virtualCamera;
+    ControlInput  m_controlInput;
+    MetricsServer m_metrics;
+    FrameWatchdog m_watchdog;
+    WatchdogLevel m_watchdogApplied = WatchdogLevel::Normal;  // Main thread's copy of the level
+    int           m_watchdogPreset  = -1;  // Active preset when it was applied
+    FrameSync     m_frameSync;
+    bool          m_frameSyncLocked = false;  // Follower: this tick's frames are selected by m_frameSyncClock
+    double        m_frameSyncClock  = 0.0;    // The master's media time now, on this clip's timeline
+    std::chrono::steady_clock::time_point m_frameSyncSeekAt{};
+    std::chrono::steady_clock::time_point m_metricsPublished{};
+    CpuProfiler::Snapshot        m_metricsCpu;        // Kept so publishing reuses their storage
+    RecordingTelemetry::Snapshot m_metricsTelemetry;
+    struct ControlLearn {
+        std::string preset;
+        std::string param;
+        int         component = 0;
+    };
+    std::optional<ControlLearn> m_controlLearn;
+    std::string m_lastControlAddress;  // Shown by the UI, to check what a desk sends
 
     // State
     PlaybackState m_playbackState = PlaybackState::Stopped;
+    PlaybackDirection m_playDirection = PlaybackDirection::Forward;
+    bool m_playingBackward = false;  // Current leg: the worker is in reverse mode
     bool m_exitRequested = false;
     VideoFrame m_currentFrame;
+    int  m_editorCompileIndex = -1;     // Preset of the editor compile in flight, reported when it lands
+    bool m_editorCompileAdded = false;  // Created for that compile: removed again if it fails
     
     // Timing
+    CpuProfiler m_cpuProfiler;
+    FrameArena  m_frameArena;  // Reset at the start of each tick
+    DynamicResolution m_dynamicResolution;
+    HANDLE m_tickTimer = nullptr;  // Waitable timer for WaitForTickDeadline (high resolution where available)
+    std::chrono::steady_clock::time_point m_nextTickTime{};
+    std::chrono::steady_clock::time_point m_uiPresentTime{};  // Last UI draw + present
+    int  m_modalLoopDepth = 0;
+    bool m_inModalTick    = false;
+    bool m_uiFrameOpen    = false;  // Inside UIManager::Render: a dialog's ticks leave the UI alone
+    int m_outputRefreshHz = 0;     // Monitor of the output window (main window when closed), 0 = unknown
+    bool m_onBattery = false;      // Re-read with the refresh rate
+    RenderPolicy m_renderPolicy = RenderPolicy::Full;
+    std::chrono::steady_clock::time_point m_refreshQueryTime{};
     std::chrono::steady_clock::time_point m_lastFrameTime;
     double m_frameDuration = 1.0 / 30.0;
     float m_playbackTime = 0.0f;
     float m_generativeTime = 0.0f;  // Accumulated wall-clock time for generative shaders
+    float m_liveLatencyMs = 0.0f;     // Live capture: packet read -> present, averaged
+    bool  m_liveLatencyPending = false;  // A new live frame is being presented this tick
+
+    // Audio-master sync: media time m_syncAnchorTime was on screen at m_syncAnchorWall
+    bool    m_syncAnchored   = false;
+    double  m_syncAnchorTime = 0.0;
+    std::chrono::steady_clock::time_point m_syncAnchorWall{};
+    int64_t m_lateDrops      = 0;
+    CadenceStats m_cadence;
+    int     m_cadenceTicks   = -1;  // Ticks the frame on screen has been shown for; -1 after a discontinuity
+    double  m_tickSeconds    = 1.0 / 60.0;  // Smoothed tick period
+    std::chrono::steady_clock::time_point m_prevTickTime{};
+    bool    m_catchUpSkip    = false;  // Lagging: skip non-reference frames
+    double  m_playbackRate   = 1.0;
+
     bool m_eventResetPending = false;
     bool m_newVideoFrame = false;
+
+    // Offline export (StartExport)
+    bool    m_exporting         = false;
+    int64_t m_exportFrame       = 0;  // Frames handed to the recording so far
+    int64_t m_exportTotalFrames = 0;
+    double  m_exportFps         = 0.0;
+    std::chrono::steady_clock::time_point m_exportStartTime{};
+
+    // Playback benchmark (StartPlaybackBenchmark). Counters are baselined when
+    // measuring starts; m_benchSavedConfig is restored so the run isn't persisted.
+    enum class BenchPhase { Opening, Warmup, Measuring };
+    std::unique_ptr<PlaybackBenchmark> m_benchmark;
+    BenchPhase m_benchPhase = BenchPhase::Opening;
+    size_t     m_benchClip  = 0;
+    std::chrono::steady_clock::time_point m_benchPhaseStart{};
+    int64_t m_benchLateDrops  = 0;
+    int64_t m_benchDiscarded  = 0;
+    int64_t m_benchUnderruns  = 0;
+    int64_t m_benchDecoded    = 0;
+    int64_t m_benchEncoded    = 0;  // With "record": encoder counters at the start of measuring
+    int64_t m_benchRecDropped = 0;
+    int64_t m_benchCpuFrame   = 0;  // Last CPU tick sampled
+    int64_t m_benchGpuFrame   = 0;  // First GPU frame not sampled yet
+    bool    m_benchPrevUpload = false;  // The last sampled tick showed a new frame
+    int     m_benchPreset      = -1;    // Index of the preset benchmarked
+    bool    m_benchAddedPreset = false; // Loaded for the run, removed after it
+
+    // Session recording and replay. m_sessionStart is the recording's wall start,
+    // or the replay's fixed-clock origin; m_sessionTime the replay's clock.
+    SessionLog m_sessionLog;
+    bool    m_sessionRecording = false;
+    bool    m_sessionReplaying = false;
+    bool    m_sessionOpening   = false;  // Replay: an Open event is probing
+    std::chrono::steady_clock::time_point m_sessionStart{};
+    double  m_sessionTime      = 0.0;
+    int64_t m_sessionTicks     = 0;
+    size_t  m_sessionNext      = 0;      // Replay: next event
+    int     m_sessionFailed    = 0;      // Replay: events that couldn't be applied
+    int64_t m_sessionCpuFrame  = 0;      // Replay: last CPU tick sampled
+    int64_t m_sessionGpuFrame  = 0;      // Replay: first GPU frame not sampled yet
+    std::string m_sessionPath;
+    // Recording: the state last logged, diffed every tick
+    std::string    m_sessionPreset;
+    nlohmann::json m_sessionKeyframes;
+    nlohmann::json m_sessionAudio;
+    bool    m_sessionReplayed  = false;  // config.json is not written again after a replay
+    AppConfig m_benchSavedConfig;
+
+    // Scrub cache. m_cacheCurrentFrame: copy m_currentFrame into the cache after its
+    // next upload. On a cache hit the cached texture is shown instead and the decoder
+    // seek is deferred until playback resumes (m_decoderSeekPending).
+    bool   m_cacheCurrentFrame  = false;
+    bool   m_showingCachedFrame = false;
+    bool   m_decoderSeekPending = false;
+    double m_pendingSeekTime    = 0.0;
+
+    // Timeline scrub (ScrubTo): m_scrubKeyframe is the keyframe in m_currentFrame
+    // (-1 = none or unknown); the refine is due at m_scrubRefineAt, then in flight
+    bool    m_scrubbing        = false;
+    bool    m_scrubResumePlay  = false;  // Playing when the drag started
+    int64_t m_scrubKeyframe    = -1;
+    bool    m_scrubRefineDue   = false;
+    bool    m_scrubRefining    = false;
+    std::chrono::steady_clock::time_point m_scrubRefineAt{};
 };
 
 } // namespace SP
@@ -0,0 +1,153 @@
+#include "AudioAnalysisThread.h"
+#include "TraceRecorder.h"
+#include "ThreadPriority.h"
+#include <algorithm>
+
+namespace SP {
+
+namespace {
+
+// Upper bound on a wait that missed its wake; Push and Reset set the event
+constexpr DWORD WAKE_TIMEOUT_MS = 50;
+
+static_assert(AudioAnalyzer::kHopSize >= AudioData::kWaveformSamples, "Waveform is taken from one hop");
+
+} // namespace
+
+void AudioAnalysisThread::Start() {
+    if (m_thread.joinable()) return;
+    if (!m_wakeEvent) m_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    m_stop   = false;
+    m_thread = std::thread(&AudioAnalysisThread::AnalysisThread, this);
+}
+
+void AudioAnalysisThread::Stop() {
+    if (m_thread.joinable()) {
+        m_stop = true;
+        SetEvent(m_wakeEvent);
+        m_thread.join();
+    }
+    if (m_wakeEvent) CloseHandle(m_wakeEvent);
+    m_wakeEvent = nullptr;
+}
+
+bool AudioAnalysisThread::Push(const float* frames, int count, int sampleRate) {
+    if (count <= 0 || sampleRate <= 0) return true;
+    const uint64_t write = m_write.load(std::memory_order_relaxed);
+    const size_t   space = RING_SIZE - static_cast<size_t>(write - m_read.load(std::memory_order_acquire));
+    const size_t   n     = std::min(space, static_cast<size_t>(count));
+
+    // At most two spans (before and after the wrap)
+    const size_t start = static_cast<size_t>(write) & (RING_SIZE - 1);
+    const size_t first = std::min(n, RING_SIZE - start);
+    std::copy_n(frames, first * AUDIO_CHANNELS, m_ring.data() + start * AUDIO_CHANNELS);
+    std::copy_n(frames + first * AUDIO_CHANNELS, (n - first) * AUDIO_CHANNELS, m_ring.data());
+
+    m_sampleRate.store(sampleRate, std::memory_order_relaxed);
+    m_write.store(write + n, std::memory_order_release);
+    if (m_wakeEvent) SetEvent(m_wakeEvent);
+    return n == static_cast<size_t>(count);
+}
+
+void AudioAnalysisThread::Reset() {
+    m_resetAt.store(m_write.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_resetSeq.fetch_add(1, std::memory_order_release);
+    if (m_wakeEvent) SetEvent(m_wakeEvent);
+}
+
+void AudioAnalysisThread::UpdateSettings(const AudioSettings& settings) {
+    {
+        std::lock_guard<std::mutex> lock(m_settingsMutex);
+        m_settings = settings;
+    }
+    m_settingsDirty.store(true, std::memory_order_release);
+}
+
+void AudioAnalysisThread::GetData(AudioData& out) {
+    if (m_middle.load(std::memory_order_relaxed) & SLOT_FRESH) {
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & SLOT_MASK;
+        m_takenHops.store(m_slotHops[m_front], std::memory_order_release);
+    }
+    out = m_slots[m_front];
+    // Between hops the phases would hold still for ~20 ms; move them on at the tempo
+    const std::chrono::duration<double> age = std::chrono::steady_clock::now() - m_slotTimes[m_front];
+    AudioAnalyzer::AdvancePhases(out, age.count());
+}
+
+void AudioAnalysisThread::Publish(const AudioData& data) {
+    m_slots[m_back]     = data;
+    m_slotTimes[m_back] = std::chrono::steady_clock::now();
+    m_slotHops[m_back]  = m_hopCount;
+    m_back = m_middle.exchange(static_cast<uint8_t>(m_back | SLOT_FRESH), std::memory_order_acq_rel) & SLOT_MASK;
+}
+
+void AudioAnalysisThread::PublishHops() {
+    // Hops after the one GetData took last, after the last reset, and still in the ring
+    uint64_t first = std::max(m_takenHops.load(std::memory_order_acquire), m_resetHops);
+    if (m_hopCount - first > HOP_HISTORY) first = m_hopCount - HOP_HISTORY;
+
+    AudioData& data = m_slots[m_back];
+    int count = 0;
+    for (uint64_t n = first + 1; n <= m_hopCount; ++n)
+        AudioAnalyzer::AggregateHop(data, m_hops[(n - 1) % HOP_HISTORY], count++);
+    std::copy_n(m_hop + (AudioAnalyzer::kHopSize - AudioData::kWaveformSamples) * AUDIO_CHANNELS,
+                AudioData::kWaveformSamples * AUDIO_CHANNELS, &data.waveform[0][0]);
+    m_slotTimes[m_back] = std::chrono::steady_clock::now();
+    m_slotHops[m_back]  = m_hopCount;
+    m_back = m_middle.exchange(static_cast<uint8_t>(m_back | SLOT_FRESH), std::memory_order_acq_rel) & SLOT_MASK;
+}
+
+void AudioAnalysisThread::AnalysisThread() {
+    TraceRecorder::SetThreadName("Audio analysis");
+    ThreadPriority::Apply(ThreadRole::Playback);
+
+    while (!m_stop.load()) {
+        WaitForSingleObject(m_wakeEvent, WAKE_TIMEOUT_MS);
+
+        if (m_settingsDirty.exchange(false, std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(m_settingsMutex);
+            m_analyzer.UpdateSettings(m_settings);
+        }
+
+        uint64_t read = m_read.load(std::memory_order_relaxed);
+        while (!m_stop.load()) {
+            // A reset drops what was pushed before it, including a partial hop
+            const uint32_t resetSeq = m_resetSeq.load(std::memory_order_acquire);
+            if (resetSeq != m_seenReset) {
+                m_seenReset = resetSeq;
+                read = std::max(read, m_resetAt.load(std::memory_order_relaxed));
+                m_read.store(read, std::memory_order_release);
+                m_hopFill   = 0;
+                m_resetHops = m_hopCount;
+                m_analyzer.Reset();
+                Publish(AudioData{});
+            }
+
+            const uint64_t write = m_write.load(std::memory_order_acquire);
+            if (read == write) break;
+
+            const size_t n     = std::min(static_cast<size_t>(write - read),
+                                          static_cast<size_t>(AudioAnalyzer::kHopSize - m_hopFill));
+            const size_t start = static_cast<size_t>(read) & (RING_SIZE - 1);
+            const size_t first = std::min(n, RING_SIZE - start);
+            float* hop = m_hop + static_cast<size_t>(m_hopFill) * AUDIO_CHANNELS;
+            std::copy_n(m_ring.data() + start * AUDIO_CHANNELS, first * AUDIO_CHANNELS, hop);
+            std::copy_n(m_ring.data(), (n - first) * AUDIO_CHANNELS, hop + first * AUDIO_CHANNELS);
+            m_hopFill += static_cast<int>(n);
+            read += n;
+            m_read.store(read, std::memory_order_release);
+
+            // One hop is one FFT once the analyzer's window has filled
+            if (m_hopFill == AudioAnalyzer::kHopSize) {
+                m_analyzer.FeedSamples(m_hop, m_hopFill * AUDIO_CHANNELS, AUDIO_CHANNELS,
+                                       m_sampleRate.load(std::memory_order_relaxed));
+                m_hopFill = 0;
+                m_analyzer.GetData(m_hops[m_hopCount % HOP_HISTORY]);
+                ++m_hopCount;
+                PublishHops();
+            }
+        }
+    }
+}
+
+} // namespace SP
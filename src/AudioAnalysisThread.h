@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Common.h"
+#include "AudioAnalyzer.h"
+#include <chrono>
+
+namespace SP {
+
+// Runs the live AudioAnalyzer on its own thread. One producer pushes stereo
+// frames into a single-producer/single-consumer ring: the main thread with the
+// file's heard audio, or AudioCapture's callback with a live input, never both
+// at once. The worker feeds them to
+// the analyzer one hop at a time, so a large push after a stall analyses every
+// hop instead of only the newest window, and the FFTs never cost a tick.
+//
+// Each result is published through a triple buffer: the worker fills its own
+// slot and swaps it into the middle, GetData swaps the middle out when it is
+// newer. Neither side waits on the other, and GetData never sees a half-written
+// AudioData. Published data carries the newest hop's last frames as its
+// waveform. Reset, UpdateSettings and GetData are main-thread calls.
+//
+// At 48 kHz a hop is ~21 ms, so a 60 fps frame spans one or two hops and a
+// slower one several. The worker keeps the last HOP_HISTORY hops in a ring and
+// publishes, every hop, all of them since the hop GetData last took folded
+// together (AudioAnalyzer::AggregateHop): an onset or band peak in a hop that
+// was never the newest at a GetData still reaches the frame.
+class AudioAnalysisThread {
+public:
+    AudioAnalysisThread() = default;
+    ~AudioAnalysisThread() { Stop(); }
+
+    // Non-copyable
+    AudioAnalysisThread(const AudioAnalysisThread&) = delete;
+    AudioAnalysisThread& operator=(const AudioAnalysisThread&) = delete;
+
+    void Start();
+    void Stop();
+
+    // `count` interleaved AUDIO_CHANNELS frames at `sampleRate`. Never blocks;
+    // false when the ring was full and the tail of `frames` was dropped.
+    bool Push(const float* frames, int count, int sampleRate);
+    // Discard everything pushed so far and zero the output (seek, loop, close).
+    void Reset();
+    void UpdateSettings(const AudioSettings& settings);
+
+    // Latest published analysis, its beat and bar phases advanced to now. Not
+    // const: it takes the newest slot.
+    void GetData(AudioData& out);
+
+private:
+    // ~1.4 s at 48 kHz: the worker drains it within a hop, so it only fills if
+    // the worker is starved of CPU for that long
+    static constexpr size_t RING_SIZE = size_t(1) << 16;
+    static constexpr uint8_t SLOT_MASK = 0x3;
+    static constexpr uint8_t SLOT_FRESH = 0x4;  // Middle slot not taken by GetData yet
+    // Hops one published result may fold; ~170 ms at 48 kHz, more than a hitch
+    // the transients matter across
+    static constexpr int HOP_HISTORY = 8;
+
+    void AnalysisThread();
+    void Publish(const AudioData& data);
+    void PublishHops();  // Folds the hops GetData has not taken into the back slot, and publishes it
+
+    std::thread m_thread;
+    HANDLE m_wakeEvent = nullptr;  // Samples pushed, a reset, or Stop
+    std::atomic<bool> m_stop{false};
+
+    // SPSC ring of frames. Indices increase monotonically; Push owns m_write, the worker m_read.
+    std::vector<float> m_ring = std::vector<float>(RING_SIZE * AUDIO_CHANNELS);
+    std::atomic<uint64_t> m_write{0};
+    std::atomic<uint64_t> m_read{0};
+    std::atomic<int> m_sampleRate{0};
+
+    // Reset: the worker skips to m_resetAt whenever m_resetSeq moves
+    std::atomic<uint64_t> m_resetAt{0};
+    std::atomic<uint32_t> m_resetSeq{0};
+
+    std::mutex m_settingsMutex;  // Held only to copy m_settings
+    AudioSettings m_settings;
+    std::atomic<bool> m_settingsDirty{false};
+
+    // Triple buffer: the worker owns m_back, GetData m_front, m_middle is traded
+    AudioData m_slots[3];
+    std::chrono::steady_clock::time_point m_slotTimes[3];  // When each slot was published
+    uint64_t  m_slotHops[3] = {};  // Hop count each slot was published at
+    uint8_t m_back  = 0;
+    uint8_t m_front = 2;
+    std::atomic<uint8_t> m_middle{1};
+    std::atomic<uint64_t> m_takenHops{0};  // m_slotHops of the slot GetData took last
+
+    // Worker only
+    AudioAnalyzer m_analyzer;
+    float    m_hop[AudioAnalyzer::kHopSize * AUDIO_CHANNELS] = {};
+    int      m_hopFill  = 0;
+    uint32_t m_seenReset = 0;
+    AudioData m_hops[HOP_HISTORY];  // Hop n (1-based) at [(n - 1) % HOP_HISTORY]
+    uint64_t  m_hopCount = 0;       // Analysed since Start; never rewinds
+    uint64_t  m_resetHops = 0;      // m_hopCount at the last reset: earlier hops are dropped
+};
+
+} // namespace SP
@@ -1,122 +1,442 @@
 #include "AudioAnalyzer.h"
 
-// KissFFT — real-input transform (header is in the kissfft root, found via include path)
-#include <kiss_fftr.h>
+// KissFFT — complex transform (header is in the kissfft root, found via include path)
+#include <kiss_fft.h>
 
 #include <cmath>
 #include <algorithm>
+#include <cstring>
 #include <numeric>
 
+// SSE2 is the x64 baseline and NEON the ARM64 one, so neither needs a runtime check
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SP_AUDIO_SSE2 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define SP_AUDIO_NEON 1
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 namespace SP {
 
-AudioAnalyzer::AudioAnalyzer() = default;
+namespace {
+
+static_assert(sizeof(kiss_fft_cpx) == 2 * sizeof(float), "Kernels read KissFFT output as float pairs");
+
+// Mid/high band split; with multi-resolution, the short window takes over here
+constexpr float CROSSOVER_HZ = 4000.0f;
+
+// Tempo tracker. The range and a log-normal prior around 120 BPM keep the
+// autocorrelation from picking half or double time; a new period has to beat
+// the current one by TEMPO_SWITCH to take over.
+constexpr float MIN_BPM             = 60.0f;
+constexpr float MAX_BPM             = 180.0f;
+constexpr float TEMPO_PRIOR_BPM     = 120.0f;
+constexpr float TEMPO_PRIOR_OCTAVES = 1.0f;
+constexpr float TEMPO_SWITCH        = 1.15f;
+constexpr float TEMPO_CONFIDENCE    = 0.1f;   // Peak / lag-0 autocorrelation to report a tempo
+constexpr float ACF_SECONDS         = 8.0f;   // Autocorrelation memory
+constexpr float PHASE_SECONDS       = 4.0f;   // Beat-phase histogram memory
+constexpr float BAR_BEATS_DECAY     = 0.9f;   // Per beat, for the downbeat histogram
+constexpr float FLUX_MEAN_SECONDS   = 0.5f;   // Onset = flux above its recent mean
+constexpr float FLUX_GAIN           = 100.0f; // log1p(gain * magnitude) compresses the bins
+
+#if SP_AUDIO_SSE2
+float HorizontalSum(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+#endif
+
+// left/right = the first two of `channels` interleaved channels, `frames` long.
+// Mono goes to both; wider input is mixed to mono first.
+void Deinterleave(const float* src, int channels, float* left, float* right, int frames) {
+    int f = 0;
+    if (channels == 1) {
+        std::memcpy(left, src, static_cast<size_t>(frames) * sizeof(float));
+        std::memcpy(right, src, static_cast<size_t>(frames) * sizeof(float));
+        return;
+    }
+    if (channels == 2) {
+#if SP_AUDIO_SSE2
+        for (; f + 4 <= frames; f += 4) {
+            const __m128 a = _mm_loadu_ps(src + f * 2);      // L0 R0 L1 R1
+            const __m128 b = _mm_loadu_ps(src + f * 2 + 4);  // L2 R2 L3 R3
+            _mm_storeu_ps(left + f,  _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+#elif SP_AUDIO_NEON
+        for (; f + 4 <= frames; f += 4) {
+            const float32x4x2_t lr = vld2q_f32(src + f * 2);
+            vst1q_f32(left + f, lr.val[0]);
+            vst1q_f32(right + f, lr.val[1]);
+        }
+#endif
+        for (; f < frames; ++f) {
+            left[f]  = src[f * 2];
+            right[f] = src[f * 2 + 1];
+        }
+        return;
+    }
+    for (; f < frames; ++f) {
+        float mono = 0.0f;
+        for (int ch = 0; ch < channels; ++ch) mono += src[f * channels + ch];
+        left[f] = right[f] = mono / channels;
+    }
+}
+
+// dst = complex (left * window, right * window); adds the sums of squares of
+// both and their cross term to `sums` (left, right, cross)
+void WindowPair(const float* left, const float* right, const float* window, float* dst, int n, float sums[3]) {
+    int i = 0;
+    float ll = 0.0f, rr = 0.0f, lr = 0.0f;
+#if SP_AUDIO_SSE2
+    __m128 accL = _mm_setzero_ps(), accR = _mm_setzero_ps(), accX = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        const __m128 w = _mm_loadu_ps(window + i);
+        const __m128 l = _mm_mul_ps(_mm_loadu_ps(left + i), w);
+        const __m128 r = _mm_mul_ps(_mm_loadu_ps(right + i), w);
+        _mm_storeu_ps(dst + i * 2,     _mm_unpacklo_ps(l, r));  // l0 r0 l1 r1
+        _mm_storeu_ps(dst + i * 2 + 4, _mm_unpackhi_ps(l, r));  // l2 r2 l3 r3
+        accL = _mm_add_ps(accL, _mm_mul_ps(l, l));
+        accR = _mm_add_ps(accR, _mm_mul_ps(r, r));
+        accX = _mm_add_ps(accX, _mm_mul_ps(l, r));
+    }
+    ll = HorizontalSum(accL);
+    rr = HorizontalSum(accR);
+    lr = HorizontalSum(accX);
+#elif SP_AUDIO_NEON
+    float32x4_t accL = vdupq_n_f32(0.0f), accR = vdupq_n_f32(0.0f), accX = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t w = vld1q_f32(window + i);
+        float32x4x2_t lr4;
+        lr4.val[0] = vmulq_f32(vld1q_f32(left + i), w);
+        lr4.val[1] = vmulq_f32(vld1q_f32(right + i), w);
+        vst2q_f32(dst + i * 2, lr4);
+        accL = vmlaq_f32(accL, lr4.val[0], lr4.val[0]);
+        accR = vmlaq_f32(accR, lr4.val[1], lr4.val[1]);
+        accX = vmlaq_f32(accX, lr4.val[0], lr4.val[1]);
+    }
+    ll = vaddvq_f32(accL);
+    rr = vaddvq_f32(accR);
+    lr = vaddvq_f32(accX);
+#endif
+    for (; i < n; ++i) {
+        const float l = left[i] * window[i], r = right[i] * window[i];
+        dst[i * 2]     = l;
+        dst[i * 2 + 1] = r;
+        ll += l * l;
+        rr += r * r;
+        lr += l * r;
+    }
+    sums[0] += ll;
+    sums[1] += rr;
+    sums[2] += lr;
+}
+
+// Separates the first n bins of a size-point FFT of (left + i right). With Z = z[k]
+// and C = conj(z[size - k]), left = (Z + C) / 2 and right = (Z - C) / 2i, so
+// mid = (left + right) / 2 goes to `mid` (complex) and the scaled power of the
+// left, right and side (left - right) / 2 spectra to the power arrays.
+void SplitStereo(const kiss_fft_cpx* z, int size, float scale, float* mid,
+                 float* powerL, float* powerR, float* powerS, int n) {
+    const float* c = reinterpret_cast<const float*>(z);
+    const float scale2 = scale * scale;
+    for (int k = 0; k < n; ++k) {
+        const int   m  = (size - k) & (size - 1);
+        const float a  = c[k * 2], b = c[k * 2 + 1];
+        const float cr = c[m * 2], ci = c[m * 2 + 1];
+        // left = ((a + cr) + i(b - ci)) / 2, right = ((b + ci) + i(cr - a)) / 2
+        const float lRe = 0.5f * (a + cr), lIm = 0.5f * (b - ci);
+        const float rRe = 0.5f * (b + ci), rIm = 0.5f * (cr - a);
+        const float sRe = 0.5f * (lRe - rRe), sIm = 0.5f * (lIm - rIm);
+        mid[k * 2]     = 0.5f * (lRe + rRe);
+        mid[k * 2 + 1] = 0.5f * (lIm + rIm);
+        powerL[k] = (lRe * lRe + lIm * lIm) * scale2;
+        powerR[k] = (rRe * rRe + rIm * rIm) * scale2;
+        powerS[k] = (sRe * sRe + sIm * sIm) * scale2;
+    }
+}
+
+// power = |bin|^2 * scale^2 and mag = |bin| * scale, for n bins
+void Magnitudes(const kiss_fft_cpx* bins, float scale, float* power, float* mag, int n) {
+    const float* c = reinterpret_cast<const float*>(bins);
+    const float scale2 = scale * scale;
+    int i = 0;
+#if SP_AUDIO_SSE2
+    const __m128 vscale2 = _mm_set1_ps(scale2);
+    for (; i + 4 <= n; i += 4) {
+        const __m128 a = _mm_loadu_ps(c + i * 2);      // r0 i0 r1 i1
+        const __m128 b = _mm_loadu_ps(c + i * 2 + 4);  // r2 i2 r3 i3
+        const __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 p  = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)), vscale2);
+        _mm_storeu_ps(power + i, p);
+        _mm_storeu_ps(mag + i, _mm_sqrt_ps(p));
+    }
+#elif SP_AUDIO_NEON
+    for (; i + 4 <= n; i += 4) {
+        const float32x4x2_t ri = vld2q_f32(c + i * 2);
+        const float32x4_t p = vmulq_n_f32(vmlaq_f32(vmulq_f32(ri.val[0], ri.val[0]), ri.val[1], ri.val[1]), scale2);
+        vst1q_f32(power + i, p);
+        vst1q_f32(mag + i, vsqrtq_f32(p));
+    }
+#endif
+    for (; i < n; ++i) {
+        power[i] = (c[i * 2] * c[i * 2] + c[i * 2 + 1] * c[i * 2 + 1]) * scale2;
+        mag[i]   = std::sqrt(power[i]);
+    }
+}
+
+} // namespace
+
+AudioAnalyzer::AudioAnalyzer()
+    : m_fftOut(static_cast<size_t>(kMaxFFTSize) * 2),
+      m_stereoPower(static_cast<size_t>(kMaxBins) * 3),
+      m_channelCum(static_cast<size_t>(AUDIO_CHANNELS) * 2 * (kMaxBins + 1)) {}
 
 AudioAnalyzer::~AudioAnalyzer() {
-    if (m_fftCfg) {
-        kiss_fftr_free(m_fftCfg);
-        m_fftCfg = nullptr;
+    for (kiss_fft_state*& plan : m_plans) {
+        if (plan) kiss_fft_free(plan);
+        plan = nullptr;
     }
 }
 
 void AudioAnalyzer::Reset() {
-    std::fill(m_ring, m_ring + kFFTSize, 0.0f);
+    for (float* ring : m_ring) std::fill(ring, ring + kMaxFFTSize, 0.0f);
     m_ringWrite = 0;
     m_ringFill  = 0;
+    m_sinceFFT  = 0;
     std::fill(m_bassHistory, m_bassHistory + kBeatHistory, 0.0f);
     m_bassHistIdx  = 0;
     m_beatDecaying = 0.0f;
+    std::fill(m_fluxPrev, m_fluxPrev + kOutputBins, 0.0f);
+    std::fill(m_onsets, m_onsets + kOnsetHistory, 0.0f);
+    std::fill(m_acf, m_acf + kOnsetHistory, 0.0f);
+    std::fill(m_phaseHist, m_phaseHist + kPhaseBins, 0.0f);
+    std::fill(m_barHist, m_barHist + 4, 0.0f);
+    m_fluxMean   = 0.0f;
+    m_onsetWrite = 0;
+    m_acfZero    = 0.0f;
+    m_period     = 0.0f;
+    m_beatClock  = 0.0;
+    m_beatIndex  = 0;
+    m_lastBeatPhase = 0.0f;
+    m_lastBass   = 0.0f;
     m_data = AudioData{};
 }
 
+int AudioAnalyzer::LongSize() const {
+    int size = kMinFFTSize * 2;
+    while (size < m_settings.fftSize && size < kMaxFFTSize) size <<= 1;
+    return size;
+}
+
 void AudioAnalyzer::FeedSamples(const float* data, int count, int channels, int sampleRate) {
-    // Rebuild the Hann window if the sample rate changed.
-    if (sampleRate != m_sampleRate) {
-        m_sampleRate = sampleRate;
-        for (int i = 0; i < kFFTSize; ++i)
-            m_hannWindow[i] = 0.5f * (1.0f - std::cos(2.0f * (float)M_PI * i / (kFFTSize - 1)));
+    m_sampleRate = sampleRate;
+
+    // Split into the left and right rings, in at most two spans (before and after
+    // the wrap). Only the newest kMaxFFTSize frames can still be in a window.
+    const int frames = count / channels;
+    const int skip   = std::max(0, frames - kMaxFFTSize);
+    for (int done = skip; done < frames;) {
+        const int n = std::min(frames - done, kMaxFFTSize - m_ringWrite);
+        Deinterleave(data + static_cast<size_t>(done) * channels, channels,
+                     m_ring[0] + m_ringWrite, m_ring[1] + m_ringWrite, n);
+        m_ringWrite = (m_ringWrite + n) % kMaxFFTSize;
+        done += n;
     }
+    m_ringFill = std::min(kMaxFFTSize, m_ringFill + frames);
+    m_sinceFFT += frames;
 
-    // Mix to mono and write into the ring buffer.
-    int frames = count / channels;
-    for (int f = 0; f < frames; ++f) {
-        float mono = 0.0f;
-        for (int ch = 0; ch < channels; ++ch)
-            mono += data[f * channels + ch];
-        mono /= channels;
+    // Run FFT once the long window is full and a hop of new samples has arrived.
+    if (m_ringFill >= LongSize() && m_sinceFFT >= kHopSize)
+        RunFFT();
+}
 
-        m_ring[m_ringWrite] = mono;
-        m_ringWrite = (m_ringWrite + 1) % kFFTSize;
-        if (m_ringFill < kFFTSize) ++m_ringFill;
+AudioAnalyzer::WindowEnergy AudioAnalyzer::Transform(int size, int resolution) {
+    // Lazy-init the KissFFT plan and Hann window for this size.
+    int slot = 0;
+    while ((kMinFFTSize << slot) < size) ++slot;
+    if (!m_plans[slot])
+        m_plans[slot] = kiss_fft_alloc(size, 0, nullptr, nullptr);
+    std::vector<float>& window = m_windows[slot];
+    if (window.empty()) {
+        window.resize(static_cast<size_t>(size));
+        for (int i = 0; i < size; ++i)
+            window[i] = 0.5f * (1.0f - std::cos(2.0f * (float)M_PI * i / (size - 1)));
     }
 
-    // Run FFT whenever we have a full window of samples.
-    if (m_ringFill >= kFFTSize)
-        RunFFT();
+    // Window the newest `size` frames into one complex array (oldest → newest),
+    // left as the real part and right as the imaginary: at most two spans of the
+    // ring, no per-sample modulo. The windowed energies are summed on the way
+    // for the RMS values.
+    const int start = (m_ringWrite - size + kMaxFFTSize) % kMaxFFTSize;
+    const int first = std::min(size, kMaxFFTSize - start);
+    float sums[3] = {};
+    WindowPair(m_ring[0] + start, m_ring[1] + start, window.data(), m_windowed, first, sums);
+    WindowPair(m_ring[0], m_ring[1], window.data() + first, m_windowed + first * 2, size - first, sums);
+
+    // One forward FFT for both channels; the first size/2+1 bins separate into
+    // the mid spectrum and the channel and side powers, then the mid's magnitude
+    // and power in one pass.
+    auto* out = reinterpret_cast<kiss_fft_cpx*>(m_fftOut.data());
+    kiss_fft(m_plans[slot], reinterpret_cast<const kiss_fft_cpx*>(m_windowed), out);
+    const int halfN = size / 2 + 1;
+    const float scale = 2.0f / size;
+    float* powerL = m_stereoPower.data();
+    float* powerR = powerL + kMaxBins;
+    float* powerS = powerR + kMaxBins;
+    SplitStereo(out, size, scale, m_midBins, powerL, powerR, powerS, halfN);
+    Magnitudes(reinterpret_cast<const kiss_fft_cpx*>(m_midBins), scale, m_power[resolution], m_mag[resolution], halfN);
+
+    double* cum   = m_cumPower[resolution];
+    double* cumL  = ChannelCum(0, resolution);
+    double* cumR  = ChannelCum(1, resolution);
+    double  side  = 0.0;
+    cum[0] = cumL[0] = cumR[0] = 0.0;
+    for (int i = 0; i < halfN; ++i) {
+        cum[i + 1]  = cum[i] + m_power[resolution][i];
+        cumL[i + 1] = cumL[i] + powerL[i];
+        cumR[i + 1] = cumR[i] + powerR[i];
+        if (i > 0) side += powerS[i];
+    }
+    m_sidePower[resolution] = side;
+    return {sums[0], sums[1], sums[2]};
+}
+
+void AudioAnalyzer::BuildTaps(int longSize, int shortSize) {
+    constexpr float MIN_HZ = 20.0f, MAX_HZ = 20000.0f;
+    const bool  logScale = m_settings.logSpectrum;
+    const float rate     = static_cast<float>(m_sampleRate);
+    const float topHz    = std::min(MAX_HZ, rate * 0.5f);
+    auto sizeOf = [&](int resolution) { return resolution == kShort ? shortSize : longSize; };
+    // Lows stay on the long window; with a short one, bins centred at or above
+    // the mid/high split come from it
+    auto resolutionFor = [&](float hz) { return (shortSize > 0 && hz >= CROSSOVER_HZ) ? kShort : kLong; };
+    auto addTap = [&](int resolution, int bin, float weight) {
+        m_taps.push_back({static_cast<uint16_t>(resolution), static_cast<uint16_t>(bin), weight});
+    };
+
+    m_taps.clear();
+    const int   longHalf  = longSize / 2 + 1;
+    const float groupSize = static_cast<float>(longHalf - 1) / kOutputBins;
+    for (int k = 0; k < kOutputBins; ++k) {
+        m_tapStart[k] = static_cast<int>(m_taps.size());
+        float loHz, hiHz;
+        if (logScale) {
+            loHz = MIN_HZ * std::pow(topHz / MIN_HZ, static_cast<float>(k) / kOutputBins);
+            hiHz = MIN_HZ * std::pow(topHz / MIN_HZ, static_cast<float>(k + 1) / kOutputBins);
+        } else {
+            // Long-window bins → kOutputBins via max-pooling within each group
+            const int lo = 1 + static_cast<int>(k * groupSize);
+            const int hi = std::min(1 + static_cast<int>((k + 1) * groupSize), longHalf - 1);
+            loHz = lo * rate / longSize;
+            hiHz = hi * rate / longSize;
+            if (resolutionFor(std::sqrt(loHz * hiHz)) == kLong) {
+                for (int i = lo; i <= hi; ++i) addTap(kLong, i, 1.0f);
+                continue;
+            }
+        }
+
+        const int   resolution = resolutionFor(std::sqrt(loHz * hiHz));
+        const float binHz      = rate / sizeOf(resolution);
+        const int   lastBin    = sizeOf(resolution) / 2;
+        const int   lo = std::clamp(static_cast<int>(std::floor(loHz / binHz + 0.5f)), 1, lastBin);
+        const int   hi = std::clamp(static_cast<int>(std::floor(hiHz / binHz + 0.5f)), lo, lastBin);
+        if (!logScale) {
+            for (int i = lo; i <= hi; ++i) addTap(resolution, i, 1.0f);
+            continue;
+        }
+        // Log: average of the FFT bins, each weighted by its overlap with the
+        // band. Below the FFT's resolution neighbouring bands share one bin.
+        const size_t first = m_taps.size();
+        float total = 0.0f;
+        for (int i = lo; i <= hi; ++i) {
+            const float overlap = std::min(hiHz, (i + 0.5f) * binHz) - std::max(loHz, (i - 0.5f) * binHz);
+            if (overlap <= 0.0f) continue;
+            addTap(resolution, i, overlap);
+            total += overlap;
+        }
+        if (total <= 0.0f) {
+            addTap(resolution, lo, 1.0f);
+            continue;
+        }
+        for (size_t t = first; t < m_taps.size(); ++t) m_taps[t].weight /= total;
+    }
+    m_tapStart[kOutputBins] = static_cast<int>(m_taps.size());
+
+    m_tapsRate  = m_sampleRate;
+    m_tapsLong  = longSize;
+    m_tapsShort = shortSize;
+    m_tapsLog   = logScale;
 }
 
 void AudioAnalyzer::RunFFT() {
-    // Lazy-init the KissFFT plan.
-    if (!m_fftCfg)
-        m_fftCfg = kiss_fftr_alloc(kFFTSize, 0, nullptr, nullptr);
-
-    // Copy ring buffer into a contiguous windowed array (oldest → newest).
-    float windowed[kFFTSize];
-    const int readStart = (m_ringWrite - kFFTSize + kFFTSize) % kFFTSize;
-    for (int i = 0; i < kFFTSize; ++i) {
-        int idx = (readStart + i) % kFFTSize;
-        windowed[i] = m_ring[idx] * m_hannWindow[i];
-    }
-
-    // Forward FFT — output is kFFTSize/2+1 complex bins.
-    kiss_fft_cpx out[kFFTSize / 2 + 1];
-    kiss_fftr(m_fftCfg, windowed, out);
-
-    // Magnitude spectrum (kFFTSize/2+1 bins).
-    const int halfN = kFFTSize / 2 + 1;
-    const float normFactor = 2.0f / kFFTSize;
-    float mag[kFFTSize / 2 + 1];
-    for (int i = 0; i < halfN; ++i) {
-        float re = out[i].r, im = out[i].i;
-        mag[i] = std::sqrt(re * re + im * im) * normFactor;
+    const int hopFrames = m_sinceFFT > 0 ? m_sinceFFT : kHopSize;
+    m_sinceFFT = 0;
+    const int longSize  = LongSize();
+    const int shortSize = m_settings.multiResolution ? std::max(kMinFFTSize, longSize / 4) : 0;
+    if (m_tapsRate != m_sampleRate || m_tapsLong != longSize || m_tapsShort != shortSize ||
+        m_tapsLog != m_settings.logSpectrum) {
+        BuildTaps(longSize, shortSize);
     }
 
-    // Frequency per bin: binHz = sampleRate / kFFTSize
-    const float binHz = static_cast<float>(m_sampleRate) / kFFTSize;
+    const WindowEnergy energy = Transform(longSize, kLong);
+    if (shortSize > 0) Transform(shortSize, kShort);
 
-    // Band bin limits (skip DC bin 0).
-    auto freqToBin = [&](float hz) {
-        return std::max(1, std::min(halfN - 1, static_cast<int>(std::round(hz / binHz))));
-    };
-    const int bassLo = freqToBin(20.0f),   bassHi = freqToBin(250.0f);
-    const int midLo  = freqToBin(250.0f),  midHi  = freqToBin(4000.0f);
-    const int highLo = freqToBin(4000.0f), highHi = freqToBin(20000.0f);
-
-    auto bandRMS = [&](int lo, int hi) {
-        float sum = 0.0f;
-        for (int i = lo; i <= hi; ++i) sum += mag[i] * mag[i];
-        return std::sqrt(sum / std::max(1, hi - lo + 1));
+    // Band energies (skip DC bin 0) from running power sums of the mid, or of
+    // one channel. Highs use the short window when there is one.
+    auto bandRMS = [&](int resolution, float loHz, float hiHz, int channel = -1) {
+        const int size  = (resolution == kShort) ? shortSize : longSize;
+        const int halfN = size / 2 + 1;
+        // Frequency per bin: binHz = sampleRate / size
+        const float binHz = static_cast<float>(m_sampleRate) / size;
+        auto freqToBin = [&](float hz) {
+            return std::max(1, std::min(halfN - 1, static_cast<int>(std::round(hz / binHz))));
+        };
+        const int lo = freqToBin(loHz), hi = freqToBin(hiHz);
+        const double* cum = channel < 0 ? m_cumPower[resolution] : ChannelCum(channel, resolution);
+        const double sum = std::max(0.0, cum[hi + 1] - cum[lo]);
+        return static_cast<float>(std::sqrt(sum / std::max(1, hi - lo + 1)));
     };
 
     // Raw band energies.
-    const float rawBass = std::min(1.0f, bandRMS(bassLo, bassHi));
-    const float rawMid  = std::min(1.0f, bandRMS(midLo,  midHi));
-    const float rawHigh = std::min(1.0f, bandRMS(highLo, highHi));
+    const int   highRes = shortSize > 0 ? kShort : kLong;
+    const float rawBass = std::min(1.0f, bandRMS(kLong, 20.0f, 250.0f));
+    const float rawMid  = std::min(1.0f, bandRMS(kLong, 250.0f, CROSSOVER_HZ));
+    const float rawHigh = std::min(1.0f, bandRMS(highRes, CROSSOVER_HZ, 20000.0f));
 
-    // Overall RMS.
-    float sumSq = 0.0f;
-    for (int i = 0; i < kFFTSize; ++i) sumSq += windowed[i] * windowed[i];
-    const float rawRms = std::min(1.0f, std::sqrt(sumSq / kFFTSize));
+    // Overall RMS: of the mid (l + r) / 2, from the channel sums.
+    const float midSumSq = 0.25f * (energy.left + energy.right + 2.0f * energy.cross);
+    const float rawRms   = std::min(1.0f, std::sqrt(std::max(0.0f, midSumSq) / longSize));
 
     // EMA smoothing (s=0 means no smoothing, s=1 means frozen).
     const float s = std::clamp(m_settings.smoothing, 0.0f, 0.999f);
-    m_data.bass = rawBass + s * (m_data.bass - rawBass);
-    m_data.mid  = rawMid  + s * (m_data.mid  - rawMid);
-    m_data.high = rawHigh + s * (m_data.high - rawHigh);
-    m_data.rms  = rawRms  + s * (m_data.rms  - rawRms);
+    auto smooth = [s](float& value, float raw) { value = raw + s * (value - raw); };
+    smooth(m_data.bass, rawBass);
+    smooth(m_data.mid,  rawMid);
+    smooth(m_data.high, rawHigh);
+    smooth(m_data.rms,  rawRms);
+
+    // The same per channel, and the stereo width: side energy as a share of
+    // mid + side over the long window
+    const float channelSumSq[AUDIO_CHANNELS] = { energy.left, energy.right };
+    for (int ch = 0; ch < AUDIO_CHANNELS; ++ch) {
+        smooth(m_data.channelBass[ch], std::min(1.0f, bandRMS(kLong, 20.0f, 250.0f, ch)));
+        smooth(m_data.channelMid[ch],  std::min(1.0f, bandRMS(kLong, 250.0f, CROSSOVER_HZ, ch)));
+        smooth(m_data.channelHigh[ch], std::min(1.0f, bandRMS(highRes, CROSSOVER_HZ, 20000.0f, ch)));
+        smooth(m_data.channelRms[ch],  std::min(1.0f, std::sqrt(channelSumSq[ch] / longSize)));
+    }
+    const double midPower = m_cumPower[kLong][longSize / 2 + 1] - m_cumPower[kLong][1];
+    const double total    = midPower + m_sidePower[kLong];
+    smooth(m_data.stereoWidth, total > 1e-12 ? static_cast<float>(m_sidePower[kLong] / total) : 0.0f);
 
     // Beat detection: compare current bass energy against rolling average.
     float bassEnergy = rawBass * rawBass;
@@ -131,7 +451,9 @@ void AudioAnalyzer::RunFFT() {
         m_beatDecaying *= m_settings.beatDecay;
     m_data.beat = m_beatDecaying;
 
-    // Spectral centroid (normalised).
+    // Spectral centroid (normalised) of the long window.
+    const int halfN = longSize / 2 + 1;
+    const float* mag = m_mag[kLong];
     float weightedSum = 0.0f, totalMag = 0.0f;
     for (int i = 1; i < halfN; ++i) {
         weightedSum += i * mag[i];
@@ -141,23 +463,148 @@ void AudioAnalyzer::RunFFT() {
         ? std::min(1.0f, (weightedSum / totalMag) / (halfN - 1))
         : 0.0f;
 
-    // Downsample kFFTSize/2 bins → kOutputBins via max-pooling within each group.
-    const float groupSize = static_cast<float>(halfN - 1) / kOutputBins;
+    // Output bins from the precomputed taps: peak (linear) or weighted mean (log).
+    // Their rise since the last FFT, before smoothing, is the onset flux.
+    const bool weighted = m_tapsLog;
+    float flux = 0.0f;
     for (int k = 0; k < kOutputBins; ++k) {
-        int lo = 1 + static_cast<int>(k * groupSize);
-        int hi = 1 + static_cast<int>((k + 1) * groupSize);
-        hi = std::min(hi, halfN - 1);
-        float peak = 0.0f;
-        for (int i = lo; i <= hi; ++i) peak = std::max(peak, mag[i]);
+        float value = 0.0f;
+        for (int t = m_tapStart[k]; t < m_tapStart[k + 1]; ++t) {
+            const SpectrumTap& tap = m_taps[t];
+            const float v = m_mag[tap.resolution][tap.bin] * tap.weight;
+            value = weighted ? value + v : std::max(value, v);
+        }
         // EMA on spectrum bins too, same smoothing coefficient.
-        float raw = std::min(1.0f, peak);
+        float raw = std::min(1.0f, value);
         m_data.spectrum[k] = raw + s * (m_data.spectrum[k] - raw);
+        const float logMag = std::log1p(FLUX_GAIN * raw);
+        flux += std::max(0.0f, logMag - m_fluxPrev[k]);
+        m_fluxPrev[k] = logMag;
     }
 
-    // Consume the window; allow overlap (advance by half FFT size so bass transients
-    // don't skip an analysis frame).
-    m_ringFill -= kFFTSize / 2;
-    if (m_ringFill < 0) m_ringFill = 0;
+    TrackTempo(flux / kOutputBins, rawBass, static_cast<float>(hopFrames) / m_sampleRate);
+}
+
+void AudioAnalyzer::TrackTempo(float flux, float bass, float hopSeconds) {
+    // Onset strength: flux above its recent mean
+    m_fluxMean += (flux - m_fluxMean) * (1.0f - std::exp(-hopSeconds / FLUX_MEAN_SECONDS));
+    const float onset = std::max(0.0f, flux - m_fluxMean);
+    m_onsets[m_onsetWrite] = onset;
+
+    // Decaying autocorrelation over the tempo range: one multiply-add per lag
+    const int minLag = std::max(1, static_cast<int>(60.0f / (MAX_BPM * hopSeconds)));
+    const int maxLag = std::min(kOnsetHistory - 2, static_cast<int>(std::ceil(60.0f / (MIN_BPM * hopSeconds))));
+    const float acfDecay = std::exp(-hopSeconds / ACF_SECONDS);
+    m_acfZero = m_acfZero * acfDecay + onset * onset;
+    for (int lag = std::max(1, minLag - 1); lag <= maxLag + 1; ++lag) {
+        m_acf[lag] = m_acf[lag] * acfDecay + onset * m_onsets[(m_onsetWrite - lag) & (kOnsetHistory - 1)];
+    }
+    m_onsetWrite = (m_onsetWrite + 1) & (kOnsetHistory - 1);
+
+    // Best lag under the tempo prior; the current period keeps it unless beaten clearly
+    auto score = [&](int lag) {
+        const float octaves = std::log2(60.0f / (lag * hopSeconds) / TEMPO_PRIOR_BPM) / TEMPO_PRIOR_OCTAVES;
+        return m_acf[lag] * std::exp(-0.5f * octaves * octaves);
+    };
+    int best = minLag;
+    for (int lag = minLag + 1; lag <= maxLag; ++lag) {
+        if (score(lag) > score(best)) best = lag;
+    }
+    const int current = static_cast<int>(std::lround(m_period));
+    if (current >= minLag && current <= maxLag && score(best) < score(current) * TEMPO_SWITCH) best = current;
+
+    const bool confident = m_acfZero > 1e-9f && m_acf[best] > TEMPO_CONFIDENCE * m_acfZero;
+    if (!confident) {
+        m_period = 0.0f;
+        m_data.bpm = m_data.beatPhase = m_data.barPhase = 0.0f;
+        return;
+    }
+    // Sub-FFT period from a parabola through the peak, eased toward while the lag holds
+    float period = static_cast<float>(best);
+    const float a = m_acf[best - 1], b = m_acf[best], c = m_acf[best + 1];
+    const float curve = a - 2.0f * b + c;
+    if (curve < 0.0f) period += std::clamp(0.5f * (a - c) / curve, -0.5f, 0.5f);
+    m_period = (current == best) ? m_period + 0.1f * (period - m_period) : period;
+
+    // Beat phase: bass rises binned by the phase of a clock running at the
+    // period; their circular mean is where the beats fall
+    m_beatClock += 1.0 / m_period;
+    const double clockPhase = m_beatClock - std::floor(m_beatClock);
+    const float  phaseDecay = std::exp(-hopSeconds / PHASE_SECONDS);
+    float sumSin = 0.0f, sumCos = 0.0f;
+    for (int i = 0; i < kPhaseBins; ++i) {
+        m_phaseHist[i] *= phaseDecay;
+    }
+    const float bassRise = std::max(0.0f, bass - m_lastBass);
+    m_lastBass = bass;
+    m_phaseHist[std::min(kPhaseBins - 1, static_cast<int>(clockPhase * kPhaseBins))] += bassRise;
+    for (int i = 0; i < kPhaseBins; ++i) {
+        const float angle = 2.0f * static_cast<float>(M_PI) * (i + 0.5f) / kPhaseBins;
+        sumSin += m_phaseHist[i] * std::sin(angle);
+        sumCos += m_phaseHist[i] * std::cos(angle);
+    }
+    const float beatOffset = std::atan2(sumSin, sumCos) / (2.0f * static_cast<float>(M_PI));
+    float beatPhase = static_cast<float>(clockPhase) - beatOffset;
+    beatPhase -= std::floor(beatPhase);
+
+    // A wrap is a beat: its bass votes for its place in the bar
+    if (beatPhase < m_lastBeatPhase - 0.5f) {
+        m_beatIndex = (m_beatIndex + 1) & 3;
+        m_barHist[m_beatIndex] = m_barHist[m_beatIndex] * BAR_BEATS_DECAY + bass;
+    }
+    m_lastBeatPhase = beatPhase;
+    const int downbeat = static_cast<int>(std::max_element(m_barHist, m_barHist + 4) - m_barHist);
+
+    m_data.bpm       = 60.0f / (m_period * hopSeconds);
+    m_data.beatPhase = beatPhase;
+    m_data.barPhase  = (((m_beatIndex - downbeat) & 3) + beatPhase) / 4.0f;
+}
+
+void AudioAnalyzer::AdvancePhases(AudioData& data, double seconds) {
+    if (data.bpm <= 0.0f || seconds <= 0.0) return;
+    const double beats = seconds * data.bpm / 60.0;
+    const double beat  = data.beatPhase + beats;
+    const double bar   = data.barPhase + beats / 4.0;
+    data.beatPhase = static_cast<float>(beat - std::floor(beat));
+    data.barPhase  = static_cast<float>(bar - std::floor(bar));
+}
+
+void AudioAnalyzer::AggregateHop(AudioData& into, const AudioData& hop, int count) {
+    if (count <= 0) {
+        std::copy_n(hop.spectrum, AudioData::kSpectrumBins, into.spectrum);
+        into.rms  = hop.rms;
+        into.bass = hop.bass;
+        into.mid  = hop.mid;
+        into.high = hop.high;
+        into.beat = hop.beat;
+        into.spectralCentroid = hop.spectralCentroid;
+        into.stereoWidth      = hop.stereoWidth;
+        std::copy_n(hop.channelRms, AUDIO_CHANNELS, into.channelRms);
+        std::copy_n(hop.channelBass, AUDIO_CHANNELS, into.channelBass);
+        std::copy_n(hop.channelMid, AUDIO_CHANNELS, into.channelMid);
+        std::copy_n(hop.channelHigh, AUDIO_CHANNELS, into.channelHigh);
+    } else {
+        into.rms  = std::max(into.rms, hop.rms);
+        into.bass = std::max(into.bass, hop.bass);
+        into.mid  = std::max(into.mid, hop.mid);
+        into.high = std::max(into.high, hop.high);
+        into.beat = std::max(into.beat, hop.beat);
+        for (int ch = 0; ch < AUDIO_CHANNELS; ++ch) {
+            into.channelRms[ch]  = std::max(into.channelRms[ch], hop.channelRms[ch]);
+            into.channelBass[ch] = std::max(into.channelBass[ch], hop.channelBass[ch]);
+            into.channelMid[ch]  = std::max(into.channelMid[ch], hop.channelMid[ch]);
+            into.channelHigh[ch] = std::max(into.channelHigh[ch], hop.channelHigh[ch]);
+        }
+        // Running means: the new hop weighs 1 / (count + 1)
+        const float weight = 1.0f / static_cast<float>(count + 1);
+        for (int i = 0; i < AudioData::kSpectrumBins; ++i)
+            into.spectrum[i] += (hop.spectrum[i] - into.spectrum[i]) * weight;
+        into.spectralCentroid += (hop.spectralCentroid - into.spectralCentroid) * weight;
+        into.stereoWidth      += (hop.stereoWidth - into.stereoWidth) * weight;
+    }
+    into.bpm       = hop.bpm;
+    into.beatPhase = hop.beatPhase;
+    into.barPhase  = hop.barPhase;
 }
 
 } // namespace SP
@@ -2,27 +2,48 @@
 
 #include "Common.h"
 
-// Forward-declare KissFFT real-FFT state type (avoids including kiss_fftr.h everywhere).
-struct kiss_fftr_state;
+// Forward-declare KissFFT complex-FFT state type (avoids including kiss_fft.h everywhere).
+struct kiss_fft_state;
 
 namespace SP {
 
-// Pure DSP class: accumulates mono float PCM samples decoded from the video
-// stream by VideoDecoder, runs a real-input FFT when enough samples are
-// available, and computes band energies / beat detection.
+// Pure DSP class: accumulates stereo float PCM, runs an FFT when enough samples
+// are available, and computes band energies / beat detection.
 //
-// Not thread-safe — all methods are called from the main thread.
+// Left and right share one complex FFT (left as the real part, right as the
+// imaginary): the two real spectra separate from its conjugate symmetry, and mid
+// (L+R)/2 and side (L-R)/2 are their half-sum and half-difference. The mid
+// spectrum drives everything the mono analyzer did; the channels add per-side
+// bands and the side a stereo width.
+//
+// The FFT size is a setting (AudioSettings::fftSize). With multiResolution the
+// highs (above 4 kHz) come from a second FFT a quarter as long over the newest
+// samples, so bass gets frequency resolution and highs time resolution. The
+// 256 output bins are linear (max-pooled) or log-spaced 20 Hz..20 kHz.
+//
+// Tempo is tracked incrementally, one step per FFT: spectral flux of the output
+// bins gives an onset strength, a decaying autocorrelation of it over the
+// 60-180 BPM lags picks the beat period, and a histogram of bass rises over
+// the beat's phase places the beats (on the kick, not the off-beat hats). Downbeats are the strongest bass of every
+// fourth beat. Phases are as of the last FFT; AdvancePhases moves them on.
+//
+// Not thread-safe — each instance stays on one thread (AudioAnalysisThread's
+// worker for live audio, AudioTimeline's for the whole track).
 class AudioAnalyzer {
 public:
+    // Window advance: FFTs overlap by half, so fed one hop at a time the
+    // analyzer runs exactly one FFT per hop once its window has filled
+    static constexpr int kHopSize = 1024;
+
     AudioAnalyzer();
     ~AudioAnalyzer();
 
     AudioAnalyzer(const AudioAnalyzer&) = delete;
     AudioAnalyzer& operator=(const AudioAnalyzer&) = delete;
 
-    // Feed interleaved PCM samples (already converted to float by VideoDecoder).
+    // Feed interleaved float PCM; count is in samples (frames × channels).
     // channels: number of interleaved channels in data (1=mono, 2=stereo).
-    // Samples are mixed to mono internally.
+    // Mono feeds both sides; more than two channels are mixed to mono first.
     void FeedSamples(const float* data, int count, int channels, int sampleRate);
 
     // Copy latest analysis result.
@@ -33,23 +54,86 @@ public:
 
     void UpdateSettings(const AudioSettings& s) { m_settings = s; }
 
+    // Move data's beat and bar phases `seconds` on at its tempo, for reads
+    // between hops. No-op without a tempo.
+    static void AdvancePhases(AudioData& data, double seconds);
+
+    // Folds a later hop into `into`, which already holds `count` hops (0 copies
+    // it), so a render frame sees every hop since the last one: the peak of the
+    // beat pulse and of each band and channel level (a transient between two
+    // frames still lands), the mean spectrum, centroid and stereo width, and
+    // the newest tempo and phases. The waveform is left alone.
+    static void AggregateHop(AudioData& into, const AudioData& hop, int count);
+
+    friend struct MicroBenchAccess;  // ShaderPlayerMicroBench times the private hot paths
+
 private:
-    void RunFFT();
+    // Windowed sums of squares of one transform: left, right and their cross term
+    struct WindowEnergy {
+        float left = 0.0f, right = 0.0f, cross = 0.0f;
+    };
 
-    static constexpr int kFFTSize     = 2048;  // Must be power of 2
+    void RunFFT();
+    // Windows the newest `size` frames, transforms them and fills that
+    // resolution's mid power and magnitude and the channel and side power sums
+    WindowEnergy Transform(int size, int resolution);
+    // Spectrum taps and band layout for the current rate, sizes and scale
+    void BuildTaps(int longSize, int shortSize);
+    int  LongSize() const;  // AudioSettings::fftSize, rounded to a supported power of 2
+    // One tempo step: spectral `flux` and raw `bass` of an FFT `hopSeconds` after the last
+    void TrackTempo(float flux, float bass, float hopSeconds);
+
+    static constexpr int kMinFFTSize  = 512;   // Shortest high-band window
+    static constexpr int kMaxFFTSize  = 8192;  // Longest low-band window; sizes the ring
+    static constexpr int kPlanCount   = 5;     // 512 .. 8192
     static constexpr int kOutputBins  = AudioData::kSpectrumBins;
+    static constexpr int kMaxBins     = kMaxFFTSize / 2 + 1;
 
-    // KissFFT plan — allocated once in RunFFT on first call or after Reset.
-    kiss_fftr_state* m_fftCfg = nullptr;
+    // Resolutions: the long window (lows, and everything unless multi-resolution)
+    // and the short one for the highs
+    static constexpr int kLong  = 0;
+    static constexpr int kShort = 1;
 
-    // Ring buffer for mono input samples.
-    float m_ring[kFFTSize] = {};
-    int   m_ringWrite = 0;
-    int   m_ringFill  = 0;   // samples available (capped at kFFTSize)
+    // KissFFT plans and Hann windows per size, made on first use
+    kiss_fft_state*    m_plans[kPlanCount] = {};
+    std::vector<float> m_windows[kPlanCount];
 
-    // Last sample rate seen — triggers Hann window recompute if it changes.
+    // Ring buffers for the left and right input samples.
+    float m_ring[AUDIO_CHANNELS][kMaxFFTSize] = {};
+    int   m_ringWrite = 0;
+    int   m_ringFill  = 0;   // frames available (capped at kMaxFFTSize)
+    int   m_sinceFFT  = 0;   // frames fed since the last FFT
     int   m_sampleRate = 0;
-    float m_hannWindow[kFFTSize] = {};
+
+    // Per-FFT scratch, per resolution. Mid power and magnitude; running power
+    // sums (a band is a difference) for the mid and, in m_channelCum, each
+    // channel; total side power.
+    float  m_windowed[kMaxFFTSize * 2] = {};  // Complex input: left real, right imaginary
+    float  m_midBins[kMaxBins * 2] = {};
+    float  m_power[2][kMaxBins] = {};
+    float  m_mag[2][kMaxBins] = {};
+    double m_cumPower[2][kMaxBins + 1] = {};
+    double m_sidePower[2] = {};
+    // Larger scratch on the heap, off the owner's (and the worker's) stack
+    std::vector<float>  m_fftOut;      // kMaxFFTSize complex bins
+    std::vector<float>  m_stereoPower; // Left, right and side power, kMaxBins each
+    std::vector<double> m_channelCum;  // [channel][resolution][kMaxBins + 1]
+    double* ChannelCum(int channel, int resolution) {
+        return m_channelCum.data() + (static_cast<size_t>(channel) * 2 + resolution) * (kMaxBins + 1);
+    }
+
+    // Output bin k is reduced from m_taps[m_tapStart[k] .. m_tapStart[k + 1]):
+    // max of magnitudes (linear) or their weighted sum (log). Rebuilt when the
+    // layout key changes, so a frame costs one pass over the taps.
+    struct SpectrumTap {
+        uint16_t resolution;
+        uint16_t bin;
+        float    weight;
+    };
+    std::vector<SpectrumTap> m_taps;
+    int  m_tapStart[kOutputBins + 1] = {};
+    int  m_tapsRate = 0, m_tapsLong = 0, m_tapsShort = 0;
+    bool m_tapsLog = false;
 
     // Beat detection rolling history (~1 second at typical decode rates).
     static constexpr int kBeatHistory = 43;
@@ -57,6 +141,24 @@ private:
     int   m_bassHistIdx  = 0;
     float m_beatDecaying = 0.0f;
 
+    // Tempo tracking. Onsets are kept for the longest lag; m_acf[lag] decays
+    // (~8 s) so the tempo follows the music. Beat and bar clocks count in beats.
+    static constexpr int kOnsetHistory = 256;  // Power of 2; caps the lag at high rates
+    static constexpr int kPhaseBins    = 32;
+    float  m_fluxPrev[kOutputBins] = {};  // Log magnitudes of the last FFT
+    float  m_fluxMean = 0.0f;
+    float  m_onsets[kOnsetHistory] = {};
+    int    m_onsetWrite = 0;
+    float  m_acf[kOnsetHistory] = {};
+    float  m_acfZero = 0.0f;     // Lag 0: the onsets' energy
+    float  m_period  = 0.0f;     // Beat period in FFTs, 0 = none yet
+    double m_beatClock = 0.0;
+    float  m_phaseHist[kPhaseBins] = {};
+    float  m_barHist[4] = {};    // Bass at each beat of the bar
+    int    m_beatIndex = 0;
+    float  m_lastBeatPhase = 0.0f;
+    float  m_lastBass = 0.0f;       // Raw bass of the last FFT
+
     AudioData     m_data;
     AudioSettings m_settings;
 };
@@ -0,0 +1,134 @@
+// miniaudio.h before Common.h for the same WASAPI COM ordering as AudioPlayer.cpp,
+// which owns MINIAUDIO_IMPLEMENTATION.
+#include "miniaudio.h"
+
+#include "AudioCapture.h"
+#include "AudioAnalysisThread.h"
+#include "TraceRecorder.h"
+#include "ThreadPriority.h"
+
+namespace SP {
+
+namespace {
+
+// Requested device period. WASAPI shared mode may round it up to the engine's,
+// but the default profile would ask for several times this.
+constexpr ma_uint32 CAPTURE_PERIOD_MS = 10;
+
+} // namespace
+
+AudioCapture::~AudioCapture() {
+    Stop();
+    if (m_context) {
+        ma_context_uninit(m_context);
+        delete m_context;
+        m_context = nullptr;
+    }
+}
+
+bool AudioCapture::InitContext() {
+    if (m_context) return true;
+    m_context = new ma_context();
+    if (ma_context_init(nullptr, 0, nullptr, m_context) != MA_SUCCESS) {
+        delete m_context;
+        m_context = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void AudioCapture::RefreshDevices() {
+    m_captureDevices.clear();
+    m_playbackDevices.clear();
+    if (!InitContext()) return;
+
+    ma_device_info* playback = nullptr;
+    ma_device_info* capture  = nullptr;
+    ma_uint32 playbackCount = 0, captureCount = 0;
+    if (ma_context_get_devices(m_context, &playback, &playbackCount, &capture, &captureCount) != MA_SUCCESS) return;
+    for (ma_uint32 i = 0; i < captureCount; ++i) m_captureDevices.emplace_back(capture[i].name);
+    for (ma_uint32 i = 0; i < playbackCount; ++i) m_playbackDevices.emplace_back(playback[i].name);
+}
+
+const std::vector<std::string>& AudioCapture::GetDevices(int source) const {
+    return source == AUDIO_INPUT_LOOPBACK ? m_playbackDevices : m_captureDevices;
+}
+
+bool AudioCapture::Start(int source, const std::string& deviceName, AudioAnalysisThread* sink) {
+    Stop();
+    m_error.clear();
+    if (!sink || (source != AUDIO_INPUT_CAPTURE && source != AUDIO_INPUT_LOOPBACK)) return false;
+    if (!InitContext()) {
+        m_error = "No audio backend";
+        return false;
+    }
+
+    // Loopback records an output device, so its id comes from the playback list
+    const bool loopback = (source == AUDIO_INPUT_LOOPBACK);
+    ma_device_id id{};
+    bool found = false;
+    if (!deviceName.empty()) {
+        ma_device_info* playback = nullptr;
+        ma_device_info* capture  = nullptr;
+        ma_uint32 playbackCount = 0, captureCount = 0;
+        if (ma_context_get_devices(m_context, &playback, &playbackCount, &capture, &captureCount) == MA_SUCCESS) {
+            const ma_device_info* infos = loopback ? playback : capture;
+            const ma_uint32       count = loopback ? playbackCount : captureCount;
+            for (ma_uint32 i = 0; i < count && !found; ++i) {
+                if (deviceName == infos[i].name) {
+                    id    = infos[i].id;
+                    found = true;
+                }
+            }
+        }
+    }
+
+    ma_device_config config     = ma_device_config_init(loopback ? ma_device_type_loopback : ma_device_type_capture);
+    config.capture.pDeviceID    = found ? &id : nullptr;  // nullptr → system default
+    config.capture.format       = ma_format_f32;
+    config.capture.channels     = AUDIO_CHANNELS;  // miniaudio up/downmixes the device's layout
+    config.sampleRate           = 0;               // The device's own rate: no resampling
+    config.periodSizeInMilliseconds = CAPTURE_PERIOD_MS;
+    config.performanceProfile   = ma_performance_profile_low_latency;
+    config.pUserData            = this;
+    if (ThreadPriority::IsEnabled()) config.wasapi.usage = ma_wasapi_usage_pro_audio;
+
+    config.dataCallback = [](ma_device* dev, void* out, const void* in, ma_uint32 fc) {
+        (void)out;
+        auto* self = static_cast<AudioCapture*>(dev->pUserData);
+        TraceRecorder::SetThreadName("Audio capture");  // No-op after the first call
+        SP_TRACE_SCOPE("Audio capture");
+        if (in) self->m_sink->Push(static_cast<const float*>(in), static_cast<int>(fc),
+                                   static_cast<int>(dev->sampleRate));
+    };
+
+    m_sink   = sink;
+    m_device = new ma_device();
+    if (ma_device_init(m_context, &config, m_device) != MA_SUCCESS) {
+        m_error = loopback ? "Could not open the output device for loopback" : "Could not open the capture device";
+        delete m_device;
+        m_device = nullptr;
+        m_sink   = nullptr;
+        return false;
+    }
+    m_sampleRate = static_cast<int>(m_device->sampleRate);
+
+    if (ma_device_start(m_device) != MA_SUCCESS) {
+        m_error = "Could not start the audio input";
+        Stop();
+        return false;
+    }
+    return true;
+}
+
+void AudioCapture::Stop() {
+    if (m_device) {
+        ma_device_uninit(m_device);  // Stops the callback thread before we let go of the sink
+        delete m_device;
+        m_device = nullptr;
+    }
+    m_sink       = nullptr;
+    m_sampleRate = 0;
+}
+
+} // namespace SP
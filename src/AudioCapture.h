@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Common.h"
+
+// ma_context / ma_device are defined in miniaudio.h — forward-declare to keep it
+// out of this header (see AudioPlayer.h).
+struct ma_context;
+struct ma_device;
+
+namespace SP {
+
+class AudioAnalysisThread;
+
+// Live audio input for analysis only: a capture device (line-in, microphone,
+// an interface fed by the DJ mixer) or WASAPI loopback of an output device.
+// The miniaudio capture callback pushes its frames straight into an
+// AudioAnalysisThread's lock-free ring, so input never waits on the main thread
+// and its latency is one device period plus one analysis hop. Nothing is played.
+// Start, Stop and RefreshDevices are main-thread calls.
+class AudioCapture {
+public:
+    AudioCapture() = default;
+    ~AudioCapture();
+
+    // Non-copyable
+    AudioCapture(const AudioCapture&) = delete;
+    AudioCapture& operator=(const AudioCapture&) = delete;
+
+    // Open `deviceName` for `source` (AUDIO_INPUT_CAPTURE or AUDIO_INPUT_LOOPBACK;
+    // empty or no longer present = the system default) and push into `sink`.
+    // While running nothing else may Push into `sink`, and it must outlive Stop.
+    // False with GetError() set when the device could not be opened.
+    bool Start(int source, const std::string& deviceName, AudioAnalysisThread* sink);
+    // Stops the device; the callback has returned for good when this does.
+    void Stop();
+
+    bool IsRunning() const { return m_device != nullptr; }
+    int  GetSampleRate() const { return m_sampleRate; }
+    const std::string& GetError() const { return m_error; }
+
+    // Re-enumerate devices. GetDevices lists capture devices for
+    // AUDIO_INPUT_CAPTURE and output devices for AUDIO_INPUT_LOOPBACK.
+    void RefreshDevices();
+    const std::vector<std::string>& GetDevices(int source) const;
+
+private:
+    bool InitContext();
+
+    ma_context* m_context = nullptr;  // Made on first use, kept for enumeration
+    ma_device*  m_device  = nullptr;
+    AudioAnalysisThread* m_sink = nullptr;
+    int m_sampleRate = 0;
+    std::string m_error;
+
+    std::vector<std::string> m_captureDevices;
+    std::vector<std::string> m_playbackDevices;
+};
+
+} // namespace SP
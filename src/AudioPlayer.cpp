@@ -8,29 +8,34 @@
 #include "miniaudio.h"
 
 #include "AudioPlayer.h"
-
-extern "C" {
-#include <libswresample/swresample.h>
-#include <libavutil/channel_layout.h>
-#include <libavutil/samplefmt.h>
-}
+#include "TraceRecorder.h"
+#include "ThreadPriority.h"
 
 #include <algorithm>
 #include <cstring>
 
 namespace SP {
 
+namespace {
+
+// Initialize(true): exclusive-mode period and count. The device may round the
+// period to what it supports; GetDeviceLatencySamples reports the result.
+constexpr ma_uint32 LOW_LATENCY_PERIOD_MS = 3;
+constexpr ma_uint32 LOW_LATENCY_PERIODS   = 2;
+
+} // namespace
+
 AudioPlayer::AudioPlayer() = default;
 
 AudioPlayer::~AudioPlayer() {
     Shutdown();
 }
 
-bool AudioPlayer::Initialize() {
+bool AudioPlayer::Initialize(bool lowLatency) {
     if (m_initialized) return true;
 
-    m_ring = std::make_unique<float[]>(kRingCap);
-    std::memset(m_ring.get(), 0, kRingCap * sizeof(float));
+    m_ring = std::make_unique<float[]>(static_cast<size_t>(kRingCap) * AUDIO_CHANNELS);
+    std::memset(m_ring.get(), 0, static_cast<size_t>(kRingCap) * AUDIO_CHANNELS * sizeof(float));
     m_wPos.store(0);
     m_rPos.store(0);
     m_flush.store(false);
@@ -39,22 +44,27 @@ bool AudioPlayer::Initialize() {
 
     ma_device_config config     = ma_device_config_init(ma_device_type_playback);
     config.playback.format      = ma_format_f32;
-    config.playback.channels    = 1;      // mono; miniaudio upmixes to device channels
+    config.playback.channels    = AUDIO_CHANNELS;  // stereo; miniaudio maps to device channels
     config.sampleRate           = 0;      // 0 → MA_DEFAULT_SAMPLE_RATE (48000)
     config.pUserData            = this;
+    // miniaudio joins its callback thread to MMCSS "Pro Audio" itself
+    if (ThreadPriority::IsEnabled()) config.wasapi.usage = ma_wasapi_usage_pro_audio;
 
     // Use a capturing lambda to adapt unsigned int to ma_uint32 without exposing
     // miniaudio types through the header.
     config.dataCallback = [](ma_device* dev, void* out, const void* in, ma_uint32 fc) {
         (void)in;
         auto* self = static_cast<AudioPlayer*>(dev->pUserData);
+        TraceRecorder::SetThreadName("Audio callback");  // No-op after the first call
+        SP_TRACE_SCOPE("Audio callback");
 
         // Flush request: consumer resets rPos to wPos (SPSC — consumer owns rPos).
         if (self->m_flush.load(std::memory_order_acquire)) {
             self->m_rPos.store(self->m_wPos.load(std::memory_order_relaxed),
                                std::memory_order_release);
             self->m_flush.store(false, std::memory_order_release);
-            std::memset(out, 0, fc * sizeof(float));
+            self->m_fed = false;
+            std::memset(out, 0, static_cast<size_t>(fc) * AUDIO_CHANNELS * sizeof(float));
             return;
         }
 
@@ -69,15 +79,39 @@ bool AudioPlayer::Initialize() {
             std::min(static_cast<uint64_t>(fc), available));
 
         for (uint32_t i = 0; i < toRead; ++i) {
-            pOut[i] = self->m_ring[(rPos + i) & kRingMask] * vol;
+            const float* frame = &self->m_ring[((rPos + i) & kRingMask) * AUDIO_CHANNELS];
+            for (int ch = 0; ch < AUDIO_CHANNELS; ++ch) pOut[i * AUDIO_CHANNELS + ch] = frame[ch] * vol;
         }
         if (toRead < fc) {
-            std::memset(pOut + toRead, 0, (fc - toRead) * sizeof(float));
+            // Ran dry after playing: the main thread fell behind (or the file's
+            // audio ended, which counts once). Silence before the first frames is not one.
+            if (self->m_fed) self->m_underruns.fetch_add(1, std::memory_order_relaxed);
+            std::memset(pOut + static_cast<size_t>(toRead) * AUDIO_CHANNELS, 0,
+                        static_cast<size_t>(fc - toRead) * AUDIO_CHANNELS * sizeof(float));
         }
+        self->m_fed = toRead == fc;
         self->m_rPos.store(rPos + toRead, std::memory_order_release);
     };
 
-    if (ma_device_init(nullptr, &config, m_device) != MA_SUCCESS) {
+    ma_result result = MA_ERROR;
+    if (lowLatency) {
+        config.performanceProfile       = ma_performance_profile_low_latency;
+        config.periodSizeInMilliseconds = LOW_LATENCY_PERIOD_MS;
+        config.periods                  = LOW_LATENCY_PERIODS;
+        config.playback.shareMode       = ma_share_mode_exclusive;
+        result = ma_device_init(nullptr, &config, m_device);
+        m_exclusive = (result == MA_SUCCESS);
+        if (result != MA_SUCCESS) {
+            // In use by another exclusive client, or no matching format: shared
+            // mode still takes the small periods the engine allows
+            config.playback.shareMode = ma_share_mode_shared;
+            result = ma_device_init(nullptr, &config, m_device);
+        }
+    } else {
+        result = ma_device_init(nullptr, &config, m_device);
+    }
+    if (result != MA_SUCCESS) {
+        m_exclusive = false;
         delete m_device;
         m_device = nullptr;
         m_ring.reset();
@@ -85,12 +119,18 @@ bool AudioPlayer::Initialize() {
     }
 
     m_deviceRate = static_cast<int>(m_device->sampleRate);
+    // The device's periods, converted from its internal rate
+    const uint64_t internalFrames = static_cast<uint64_t>(m_device->playback.internalPeriodSizeInFrames) *
+                                    m_device->playback.internalPeriods;
+    m_deviceLatency = m_device->playback.internalSampleRate > 0
+        ? static_cast<int>(internalFrames * m_deviceRate / m_device->playback.internalSampleRate) : 0;
 
     if (ma_device_start(m_device) != MA_SUCCESS) {
         ma_device_uninit(m_device);
         delete m_device;
         m_device = nullptr;
         m_ring.reset();
+        m_exclusive = false;
         return false;
     }
 
@@ -104,79 +144,30 @@ void AudioPlayer::Shutdown() {
         delete m_device;
         m_device = nullptr;
     }
-    if (m_swrCtx) {
-        swr_free(&m_swrCtx);
-        m_swrCtx = nullptr;
-    }
     m_ring.reset();
-    m_srcRate    = 0;
     m_deviceRate = 0;
+    m_deviceLatency = 0;
     m_initialized = false;
+    m_exclusive   = false;
 }
 
-void AudioPlayer::InitResampler(int sourceRate) {
-    if (m_swrCtx) {
-        swr_free(&m_swrCtx);
-        m_swrCtx = nullptr;
-    }
-    m_srcRate = 0;
-
-    AVChannelLayout monoLayout = AV_CHANNEL_LAYOUT_MONO;
-    if (swr_alloc_set_opts2(&m_swrCtx,
-            &monoLayout, AV_SAMPLE_FMT_FLTP, m_deviceRate,   // output: device rate, mono float
-            &monoLayout, AV_SAMPLE_FMT_FLTP, sourceRate,     // input:  source rate, mono float
-            0, nullptr) < 0 || !m_swrCtx || swr_init(m_swrCtx) < 0) {
-        if (m_swrCtx) { swr_free(&m_swrCtx); m_swrCtx = nullptr; }
-        return;
-    }
-    m_srcRate = sourceRate;
-}
+void AudioPlayer::Submit(const float* frames, int count) {
+    if (!m_initialized || count <= 0 || !frames) return;
 
-void AudioPlayer::PushToRing(const float* data, int count) {
-    uint64_t wPos      = m_wPos.load(std::memory_order_relaxed);
-    uint64_t rPos      = m_rPos.load(std::memory_order_acquire);
-    uint64_t space     = static_cast<uint64_t>(kRingCap) - (wPos - rPos);
-    int      toCopy    = static_cast<int>(std::min(static_cast<uint64_t>(count), space));
+    uint64_t wPos   = m_wPos.load(std::memory_order_relaxed);
+    uint64_t rPos   = m_rPos.load(std::memory_order_acquire);
+    uint64_t space  = static_cast<uint64_t>(kRingCap) - (wPos - rPos);
+    int      toCopy = static_cast<int>(std::min(static_cast<uint64_t>(count), space));
 
-    for (int i = 0; i < toCopy; ++i) {
-        m_ring[(wPos + i) & kRingMask] = data[i];
-    }
+    // At most two spans (before and after the wrap)
+    const size_t start = static_cast<size_t>(wPos & kRingMask);
+    const size_t first = std::min(static_cast<size_t>(toCopy), static_cast<size_t>(kRingCap) - start);
+    std::memcpy(m_ring.get() + start * AUDIO_CHANNELS, frames, first * AUDIO_CHANNELS * sizeof(float));
+    std::memcpy(m_ring.get(), frames + first * AUDIO_CHANNELS,
+                (static_cast<size_t>(toCopy) - first) * AUDIO_CHANNELS * sizeof(float));
     m_wPos.store(wPos + toCopy, std::memory_order_release);
 }
 
-void AudioPlayer::Submit(const float* mono, int count, int sampleRate) {
-    if (!m_initialized || count <= 0 || !mono) return;
-
-    if (sampleRate == m_deviceRate) {
-        // No resampling required — common case (48 kHz source on 48 kHz device).
-        PushToRing(mono, count);
-        return;
-    }
-
-    // Lazy-init or reconfigure the resampler when the source rate changes.
-    if (sampleRate != m_srcRate || !m_swrCtx) {
-        InitResampler(sampleRate);
-        if (!m_swrCtx) {
-            // Resampler init failed — push raw and accept the pitch distortion
-            // rather than silencing audio entirely.
-            PushToRing(mono, count);
-            return;
-        }
-    }
-
-    int outFrames = swr_get_out_samples(m_swrCtx, count);
-    if (outFrames <= 0) return;
-    m_resampleBuf.resize(outFrames);
-
-    uint8_t*       outBuf = reinterpret_cast<uint8_t*>(m_resampleBuf.data());
-    const uint8_t* inBuf  = reinterpret_cast<const uint8_t*>(mono);
-    int converted = swr_convert(m_swrCtx, &outBuf, outFrames, &inBuf, count);
-
-    if (converted > 0) {
-        PushToRing(m_resampleBuf.data(), converted);
-    }
-}
-
 void AudioPlayer::Flush() {
     // Signal the callback thread to discard the ring buffer contents.
     // The callback resets rPos to wPos on the next invocation, then outputs silence
@@ -1,21 +1,19 @@
 #pragma once
 
-#include <atomic>
-#include <cstdint>
-#include <memory>
-#include <vector>
+#include "Common.h"
 
-// ma_device and SwrContext are defined in AudioPlayer.cpp only — forward-declare to
-// keep miniaudio.h and FFmpeg headers out of this header and everything that includes it.
+// ma_device is defined in AudioPlayer.cpp only — forward-declare to keep
+// miniaudio.h out of this header and everything that includes it.
 struct ma_device;
-struct SwrContext;
 
 namespace SP {
 
-// Mono float audio player backed by miniaudio (WASAPI on Windows).
-// Submit() feeds decoded samples from the main thread; miniaudio's callback thread
+// Stereo float audio player backed by miniaudio (WASAPI on Windows).
+// Submit() feeds decoded frames from the main thread; miniaudio's callback thread
 // drains them independently, so main-thread stalls (GPU, ImGui, file I/O) never
 // cause audio underruns as long as the ring buffer holds enough cushion.
+// Frames arrive at the device rate (AudioReader resamples on its own thread), so
+// Submit is a copy.
 class AudioPlayer {
 public:
     AudioPlayer();
@@ -26,14 +24,15 @@ public:
 
     // Initialise WASAPI device and start audio thread. Non-fatal (returns false when
     // no audio output device is present). Safe to call multiple times after Shutdown().
-    bool Initialize();
+    // lowLatency asks for exclusive mode with small periods, and falls back to shared
+    // mode with the low-latency profile when the device refuses exclusive access.
+    bool Initialize(bool lowLatency = false);
     void Shutdown();
 
-    // Push decoded mono float samples. Always call from the main thread.
-    // sampleRate: source sample rate reported by VideoDecoder::GetAudioSampleRate().
-    // Resamples to device rate on the fly if needed; drops samples silently when the
-    // ring buffer is full (≈10 s at 48 kHz) rather than blocking.
-    void Submit(const float* mono, int count, int sampleRate);
+    // Push `count` interleaved AUDIO_CHANNELS frames at GetDeviceSampleRate().
+    // Always call from the main thread. Drops frames silently when the ring
+    // buffer is full (≈10 s at 48 kHz) rather than blocking.
+    void Submit(const float* frames, int count);
 
     // Discard all buffered samples immediately. Call on seek, pause, stop, or close.
     // The callback outputs silence until new samples arrive.
@@ -43,9 +42,20 @@ public:
     void SetMute(bool mute);
 
     bool  IsInitialized()       const { return m_initialized; }
+    bool  IsExclusive()         const { return m_exclusive; }
     int   GetDeviceSampleRate() const { return m_deviceRate; }
 
-    // Approximate number of samples currently in the ring buffer (thread-safe estimate).
+    // Frames the device holds after the callback took them (its internal buffer as
+    // negotiated, not as requested), at device rate: consumed from the ring but not
+    // heard yet
+    int   GetDeviceLatencySamples() const { return m_deviceLatency; }
+
+    // The ring's allocation (it is allocated whole by Initialize)
+    size_t GetRingBytes() const {
+        return m_ring ? static_cast<size_t>(kRingCap) * AUDIO_CHANNELS * sizeof(float) : 0;
+    }
+
+    // Approximate number of frames currently in the ring buffer (thread-safe estimate).
     int GetBufferedSamples() const {
         if (!m_initialized) return 0;
         return static_cast<int>(
@@ -53,29 +63,30 @@ public:
             m_rPos.load(std::memory_order_relaxed));
     }
 
-private:
-    void InitResampler(int sourceRate);
-    void PushToRing(const float* data, int count);
+    // Callbacks that found the ring short after a full one: the device played
+    // silence where audio was due. Counts from construction, never reset.
+    int64_t GetUnderruns() const { return m_underruns.load(std::memory_order_relaxed); }
 
+private:
     // ── Ring buffer ──────────────────────────────────────────────────────────
     // SPSC lock-free.  Producer = main thread (Submit).  Consumer = audio thread (callback).
-    // Stores mono f32 samples at device sample rate.
-    static constexpr int kRingCap  = 1 << 19;  // 524 288 samples ≈ 10.9 s at 48 kHz
+    // Stores interleaved stereo f32 frames at device sample rate; positions are in frames.
+    static constexpr int kRingCap  = 1 << 19;  // 524 288 frames ≈ 10.9 s at 48 kHz
     static constexpr int kRingMask = kRingCap - 1;
     std::unique_ptr<float[]> m_ring;
     std::atomic<uint64_t>    m_wPos{0};
     std::atomic<uint64_t>    m_rPos{0};
     std::atomic<bool>        m_flush{false};
+    std::atomic<int64_t>     m_underruns{0};
+    bool                     m_fed = false;  // Callback thread only: the last callback was filled
 
-    // ── Resampler (main thread only) ─────────────────────────────────────────
-    SwrContext*        m_swrCtx      = nullptr;
-    int                m_srcRate     = 0;   // source rate currently configured in SWR
-    int                m_deviceRate  = 0;   // device sample rate (set after Initialize)
-    std::vector<float> m_resampleBuf;       // scratch buffer for converted output
+    int m_deviceRate    = 0;  // device sample rate (set after Initialize)
+    int m_deviceLatency = 0;  // device buffer in device-rate frames
 
     // ── miniaudio device ────────────────────────────────────────────────────
     ma_device* m_device      = nullptr;
     bool       m_initialized = false;
+    bool       m_exclusive   = false;  // Exclusive-mode WASAPI (Initialize(true) succeeded at it)
 
     // ── Volume (atomic — read by callback, written by main thread) ──────────
     std::atomic<float> m_volume{1.0f};
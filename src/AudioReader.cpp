@@ -0,0 +1,381 @@
+#include "AudioReader.h"
+#include "TraceRecorder.h"
+#include "ThreadPriority.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswresample/swresample.h>
+}
+
+namespace SP {
+
+AudioReader::~AudioReader() {
+    Close();
+}
+
+void AudioReader::Open(const std::string& path, int outputRate) {
+    Close();
+    m_stopRequested = false;
+    m_thread = std::thread(&AudioReader::ReaderThread, this, path, outputRate);
+}
+
+bool AudioReader::OpenStreams(const std::string& path, int outputRate) {
+    // Opened on the reader thread so a slow share or a long probe never blocks the
+    // UI; Close interrupts it through the callback.
+    m_formatCtx = avformat_alloc_context();
+    if (!m_formatCtx) return false;
+    m_formatCtx->interrupt_callback.callback = [](void* opaque) -> int {
+        return static_cast<const std::atomic<bool>*>(opaque)->load() ? 1 : 0;
+    };
+    m_formatCtx->interrupt_callback.opaque = &m_stopRequested;
+
+    if (avformat_open_input(&m_formatCtx, path.c_str(), nullptr, nullptr) < 0) {
+        return false;  // avformat_open_input freed the context
+    }
+    if (avformat_find_stream_info(m_formatCtx, nullptr) < 0) {
+        return false;
+    }
+
+    m_streamIdx = av_find_best_stream(m_formatCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (m_streamIdx < 0) {
+        return false;  // No audio stream — silent video
+    }
+    // Only the audio stream is demuxed; video bytes are skipped, not read
+    for (unsigned i = 0; i < m_formatCtx->nb_streams; ++i) {
+        if (static_cast<int>(i) != m_streamIdx)
+            m_formatCtx->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    AVStream* stream = m_formatCtx->streams[m_streamIdx];
+    const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec) {
+        return false;
+    }
+    m_codecCtx = avcodec_alloc_context3(codec);
+    if (!m_codecCtx ||
+        avcodec_parameters_to_context(m_codecCtx, stream->codecpar) < 0 ||
+        avcodec_open2(m_codecCtx, codec, nullptr) < 0) {
+        return false;
+    }
+
+    m_sourceRate = m_codecCtx->sample_rate;
+    m_sampleRate = outputRate > 0 ? outputRate : m_sourceRate;
+    m_channels   = m_codecCtx->ch_layout.nb_channels;
+    m_timeBase   = av_q2d(stream->time_base);
+
+    // Set up swresample: decode native format/layout and rate → interleaved
+    // stereo float at the output rate. Mono is duplicated to both channels and
+    // wider layouts (5.1, etc.) are downmixed.
+    AVChannelLayout stereoLayout = AV_CHANNEL_LAYOUT_STEREO;
+    if (swr_alloc_set_opts2(&m_swrCtx,
+            &stereoLayout,          AV_SAMPLE_FMT_FLT,      m_sampleRate,
+            &m_codecCtx->ch_layout, m_codecCtx->sample_fmt, m_sourceRate,
+            0, nullptr) < 0 || !m_swrCtx || swr_init(m_swrCtx) < 0) {
+        return false;
+    }
+
+    m_frame  = av_frame_alloc();
+    m_packet = av_packet_alloc();
+    if (!m_frame || !m_packet) {
+        return false;
+    }
+
+    size_t capacity = 1;
+    while (capacity < static_cast<size_t>(std::max(m_sampleRate, 8000)) * RING_SECONDS) capacity <<= 1;
+    m_trimBefore       = -1.0;
+    m_startSegment     = true;
+    m_writtenSinceWrap = 0;
+    m_pastLoopOut      = false;
+    m_tailFill = m_fadeFrames = m_fadeDone = 0;
+    m_fadeTail.assign(static_cast<size_t>(m_sampleRate * LOOP_CROSSFADE_SECONDS) * AUDIO_CHANNELS, 0.0f);
+
+    // A Seek that arrived while opening stays pending and is handled first
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ring.assign(capacity * AUDIO_CHANNELS, 0.0f);
+    m_capacity = capacity;
+    m_read = m_write = 0;
+    m_segments.clear();
+    return true;
+}
+
+void AudioReader::Close() {
+    if (m_thread.joinable()) {
+        m_stopRequested = true;
+        m_wakeCv.notify_one();
+        m_thread.join();
+    }
+    m_ready = false;
+
+    if (m_swrCtx)    swr_free(&m_swrCtx);
+    if (m_codecCtx)  avcodec_free_context(&m_codecCtx);
+    if (m_formatCtx) avformat_close_input(&m_formatCtx);
+    av_frame_free(&m_frame);
+    av_packet_free(&m_packet);
+
+    m_streamIdx  = -1;
+    m_sourceRate = 0;
+    m_sampleRate = 0;
+    m_channels   = 0;
+    m_timeBase   = 0.0;
+    m_ring.clear();
+    m_ring.shrink_to_fit();
+    m_capacity = 0;
+    m_read = m_write = 0;
+    m_segments.clear();
+    m_generation  = 0;
+    m_seekPending = false;
+    m_loopIn  = 0.0;
+    m_loopOut = 0.0;
+}
+
+void AudioReader::Seek(double seconds) {
+    if (!m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_generation;
+        m_seekPending = true;
+        m_seekTarget  = std::max(seconds, 0.0);
+        m_read = m_write;
+        m_segments.clear();
+    }
+    m_wakeCv.notify_one();
+}
+
+void AudioReader::SetLoopRegion(double in, double out) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_loopIn  = out > in ? std::max(in, 0.0) : 0.0;
+    m_loopOut = out > in ? out : 0.0;
+}
+
+int AudioReader::Drain(float* buf, int maxFrames) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t toCopy = std::min(Pending(), static_cast<size_t>(std::max(maxFrames, 0)));
+    if (toCopy == 0) return 0;
+
+    // At most two spans (before and after the wrap); the drain itself is an index bump
+    const size_t mask  = m_capacity - 1;
+    const size_t start = static_cast<size_t>(m_read) & mask;
+    const size_t first = std::min(toCopy, m_capacity - start);
+    std::copy_n(m_ring.data() + start * AUDIO_CHANNELS, first * AUDIO_CHANNELS, buf);
+    std::copy_n(m_ring.data(), (toCopy - first) * AUDIO_CHANNELS, buf + first * AUDIO_CHANNELS);
+    m_read += toCopy;
+
+    while (m_segments.size() > 1 && m_segments[1].index <= m_read) {
+        m_segments.pop_front();
+    }
+    m_wakeCv.notify_one();
+    return static_cast<int>(toCopy);
+}
+
+double AudioReader::GetDrainTime() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (Pending() == 0 || m_segments.empty() || m_sampleRate <= 0) return -1.0;
+    const Segment& seg = m_segments.front();
+    return seg.time + static_cast<double>(m_read - seg.index) / m_sampleRate;
+}
+
+int AudioReader::GetBufferedSamples() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(Pending());
+}
+
+void AudioReader::ReaderThread(std::string path, int outputRate) {
+    TraceRecorder::SetThreadName("Audio reader");
+    ThreadPriority::Apply(ThreadRole::Playback);
+    if (!OpenStreams(path, outputRate)) return;  // Close frees whatever was set up
+    m_ready.store(true, std::memory_order_release);
+
+    while (!m_stopRequested.load()) {
+        uint64_t generation;
+        bool     seek;
+        double   target;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const size_t lowWater = m_capacity / 2;
+            m_wakeCv.wait_for(lock, std::chrono::milliseconds(20), [&] {
+                return m_stopRequested.load() || m_seekPending || Pending() < lowWater;
+            });
+            if (m_stopRequested.load()) break;
+            if (!m_seekPending && Pending() >= lowWater) continue;
+
+            generation    = m_generation;
+            seek          = m_seekPending;
+            target        = m_seekTarget;
+            m_seekPending = false;
+        }
+
+        if (seek) {
+            PerformSeek(target);
+            continue;
+        }
+
+        const int ret = av_read_frame(m_formatCtx, m_packet);
+        if (ret == AVERROR(EAGAIN)) continue;
+        if (ret < 0) {
+            // End of stream (or an unrecoverable read error): flush the decoder's
+            // tail into the ring and wrap to the start without clearing it.
+            DecodePacket(nullptr, generation);
+            if (m_pastLoopOut) {
+                WrapLoop();  // The tail ran into the end: a shorter crossfade
+                continue;
+            }
+            if (m_writtenSinceWrap == 0) {
+                // Nothing decodable — idle until a seek instead of spinning
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeCv.wait(lock, [&] { return m_stopRequested.load() || m_seekPending; });
+                continue;
+            }
+            double wrapTo;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                wrapTo = m_loopOut > 0.0 ? m_loopIn : 0.0;  // An out point past the end
+            }
+            PerformSeek(wrapTo);
+            if (wrapTo <= 0.0) m_trimBefore = -1.0;  // Keep the stream's own first samples
+            continue;
+        }
+
+        if (m_packet->stream_index == m_streamIdx) {
+            DecodePacket(m_packet, generation);
+            if (m_pastLoopOut && m_tailFill * AUDIO_CHANNELS == m_fadeTail.size()) WrapLoop();
+        } else {
+            av_packet_unref(m_packet);
+        }
+    }
+}
+
+bool AudioReader::PerformSeek(double seconds) {
+    const int64_t timestamp = static_cast<int64_t>(seconds / m_timeBase);
+    const int ret = av_seek_frame(m_formatCtx, m_streamIdx, timestamp, AVSEEK_FLAG_BACKWARD);
+    avcodec_flush_buffers(m_codecCtx);
+    // Drop samples swr still holds from before the seek
+    swr_close(m_swrCtx);
+    swr_init(m_swrCtx);
+
+    m_trimBefore       = seconds;
+    m_startSegment     = true;
+    m_writtenSinceWrap = 0;
+    m_pastLoopOut      = false;
+    m_tailFill = m_fadeFrames = m_fadeDone = 0;
+    return ret >= 0;
+}
+
+void AudioReader::WrapLoop() {
+    const size_t tail = m_tailFill;
+    PerformSeek(m_wrapTo);
+    m_fadeFrames = tail;
+}
+
+void AudioReader::CaptureTail(const uint8_t** in, int inCount) {
+    const size_t room = m_fadeTail.size() / AUDIO_CHANNELS - m_tailFill;
+    if (room == 0) return;
+    uint8_t* out = reinterpret_cast<uint8_t*>(m_fadeTail.data() + m_tailFill * AUDIO_CHANNELS);
+    const int converted = swr_convert(m_swrCtx, &out, static_cast<int>(room), in, inCount);
+    if (converted > 0) m_tailFill += static_cast<size_t>(converted);
+}
+
+void AudioReader::BlendTail(float* frames, int count) {
+    // Linear: the two sides are the same recording a loop apart, mostly correlated
+    const size_t n = std::min(static_cast<size_t>(count), m_fadeFrames - m_fadeDone);
+    const float* tail = m_fadeTail.data() + m_fadeDone * AUDIO_CHANNELS;
+    for (size_t i = 0; i < n; ++i) {
+        const float in = (static_cast<float>(m_fadeDone + i) + 0.5f) / static_cast<float>(m_fadeFrames);
+        for (int c = 0; c < AUDIO_CHANNELS; ++c) {
+            float& sample = frames[i * AUDIO_CHANNELS + c];
+            sample = sample * in + tail[i * AUDIO_CHANNELS + c] * (1.0f - in);
+        }
+    }
+    m_fadeDone += n;
+}
+
+void AudioReader::DecodePacket(AVPacket* packet, uint64_t generation) {
+    const int ret = avcodec_send_packet(m_codecCtx, packet);
+    if (packet) av_packet_unref(packet);
+    if (ret < 0 && ret != AVERROR_EOF) return;
+
+    while (avcodec_receive_frame(m_codecCtx, m_frame) == 0) {
+        WriteFrame(m_frame, generation);
+        av_frame_unref(m_frame);
+    }
+}
+
+void AudioReader::WriteFrame(AVFrame* frame, uint64_t generation) {
+    if (frame->nb_samples <= 0) return;
+
+    // Trim by timestamp after a seek: the backward seek lands on or before the
+    // target, so skip the samples that precede it.
+    const int64_t pts   = frame->best_effort_timestamp;
+    const double  start = (pts != AV_NOPTS_VALUE) ? static_cast<double>(pts) * m_timeBase : -1.0;
+    int skip = 0;
+    if (m_trimBefore >= 0.0 && start >= 0.0) {
+        skip = static_cast<int>(std::llround((m_trimBefore - start) * m_sourceRate));
+        if (skip >= frame->nb_samples) return;  // Entirely before the target
+        skip = std::max(skip, 0);
+    }
+    const double firstTime = (start >= 0.0) ? start + static_cast<double>(skip) / m_sourceRate
+                                            : std::max(m_trimBefore, 0.0);
+    m_trimBefore = -1.0;
+
+    // Input pointers advanced past the trimmed samples
+    const AVSampleFormat format = static_cast<AVSampleFormat>(frame->format);
+    const bool planar     = av_sample_fmt_is_planar(format) != 0;
+    const int  planes     = planar ? frame->ch_layout.nb_channels : 1;
+    const int  skipBytes  = skip * av_get_bytes_per_sample(format) * (planar ? 1 : frame->ch_layout.nb_channels);
+    m_inPlanes.resize(static_cast<size_t>(planes));
+    for (int p = 0; p < planes; ++p) {
+        m_inPlanes[p] = frame->extended_data[p] + skipBytes;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (generation != m_generation) return;  // A seek arrived while decoding
+    if (m_startSegment) {
+        m_segments.push_back({m_write, firstTime});
+        m_startSegment = false;
+        m_runStart     = firstTime;
+    }
+    if (m_pastLoopOut) {
+        CaptureTail(m_inPlanes.data(), frame->nb_samples - skip);
+        return;
+    }
+    // Frames left before the region's out point, when the run started ahead of it
+    int64_t untilOut = std::numeric_limits<int64_t>::max();
+    if (m_loopOut > 0.0 && m_runStart < m_loopOut) {
+        untilOut = std::llround((m_loopOut - m_runStart) * m_sampleRate) - static_cast<int64_t>(m_writtenSinceWrap);
+    }
+
+    // Convert straight into the ring. Output is interleaved float, so each span
+    // is one contiguous run; output beyond the first span stays buffered in swr
+    // and the second call (zero input) pulls it into the span after the wrap.
+    const size_t capacity = m_capacity;
+    const size_t mask     = capacity - 1;
+    const uint8_t** in = m_inPlanes.data();
+    int inCount = frame->nb_samples - skip;
+    for (int span = 0; span < 2; ++span) {
+        const size_t space = capacity - Pending();
+        const size_t pos   = static_cast<size_t>(m_write) & mask;
+        const int room     = static_cast<int>(std::min<int64_t>(std::min(space, capacity - pos), untilOut));
+        if (room <= 0) break;  // Ring full (swr keeps the rest until the next frame), or at the out point
+
+        uint8_t* out = reinterpret_cast<uint8_t*>(m_ring.data() + pos * AUDIO_CHANNELS);
+        const int converted = swr_convert(m_swrCtx, &out, room, in, inCount);
+        if (converted <= 0) break;
+        if (m_fadeDone < m_fadeFrames) BlendTail(reinterpret_cast<float*>(out), converted);
+        m_write += static_cast<uint64_t>(converted);
+        m_writtenSinceWrap += static_cast<uint64_t>(converted);
+        untilOut -= converted;
+        inCount = 0;
+        if (converted < room) break;  // Everything fit
+    }
+    if (untilOut <= 0) {
+        // The rest of this frame, and the next ones until the tail is full, go to the crossfade
+        m_pastLoopOut = true;
+        m_wrapTo      = m_loopIn;
+        CaptureTail(in, inCount);
+    }
+}
+
+} // namespace SP
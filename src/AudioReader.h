@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Common.h"
+#include <condition_variable>
+#include <deque>
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+struct SwrContext;
+
+namespace SP {
+
+// Audio half of file playback. Owns its own AVFormatContext on the same file as
+// VideoDecoder (which discards audio), its own decoder, and a reader thread that
+// keeps a ring of interleaved stereo float (AUDIO_CHANNELS) filled a few seconds
+// ahead. swresample on that thread also converts to the output rate, so the
+// player takes the samples as they are. Audio I/O therefore never waits on a
+// video frame and video decode never waits on audio read-ahead.
+//
+// The two halves are kept together by timestamp: Application seeks both to the
+// same time, and GetDrainTime reports the media time of the next sample Drain
+// returns. At end of stream the reader wraps to the start without clearing the
+// ring, so looped playback is gapless.
+//
+// An A/B loop region (SetLoopRegion) is looped the same way: the reader stops
+// writing at the out point and goes on from the in point, seconds ahead of the
+// playhead, so the wrap needs no flush or seek on the render thread. The first
+// LOOP_CROSSFADE_SECONDS from the in point are crossfaded with the audio that
+// follows the out point, so a cut mid-waveform does not click. At end of stream
+// inside a region it wraps to the in point.
+//
+// Open/Close/Seek/Drain are render-thread calls; the ring is shared with the
+// reader thread under m_mutex. The file itself is opened on the reader thread.
+class AudioReader {
+public:
+    AudioReader() = default;
+    ~AudioReader();
+
+    // Non-copyable
+    AudioReader(const AudioReader&) = delete;
+    AudioReader& operator=(const AudioReader&) = delete;
+
+    // Starts the reader thread, which opens the file's best audio stream and reads
+    // from 0 (or from a Seek issued meanwhile). IsOpen turns true once audio is
+    // decodable and stays false for files without audio. `outputRate` is the rate
+    // Drain returns, normally the device's; 0 keeps the source rate.
+    void Open(const std::string& path, int outputRate = 0);
+    void Close();
+    bool IsOpen() const { return m_ready.load(std::memory_order_acquire); }
+
+    int GetSampleRate() const { return m_sampleRate; }  // Of the output
+    int GetChannels() const { return m_channels; }  // Source channels; output is always AUDIO_CHANNELS
+
+    // Discard buffered audio and continue from `seconds`. Samples before the
+    // target are trimmed by timestamp, so the first one drained is on time.
+    void Seek(double seconds);
+
+    // Loop [in, out) from the next out point the reader writes; out <= in clears
+    // it. Audio already buffered past the out point stays, so the first wrap
+    // after a change may still need a Seek. Close clears the region.
+    void SetLoopRegion(double in, double out);
+
+    // Copies up to maxFrames interleaved frames; returns the count (0 when the
+    // reader has not caught up yet).
+    int Drain(float* buf, int maxFrames);
+
+    // Media time of the next sample Drain will return (-1 when none is buffered).
+    double GetDrainTime() const;
+    int    GetBufferedSamples() const;  // In frames
+
+private:
+    // ~8 s of source-rate audio, rounded up to a power of two. The thread refills
+    // whenever it falls below half, so a burst of output never overflows it.
+    static constexpr int RING_SECONDS = 8;
+    static constexpr double LOOP_CROSSFADE_SECONDS = 0.01;
+
+    // Start of a continuous run in the ring (after open, a seek, or a loop)
+    struct Segment {
+        uint64_t index;   // Ring write index of the run's first sample
+        double   time;    // Its media time in seconds
+    };
+
+    void ReaderThread(std::string path, int outputRate);
+    bool OpenStreams(const std::string& path, int outputRate);  // Reader thread; false = no usable audio
+    bool PerformSeek(double seconds);          // Reader thread; arms the timestamp trim
+    void WrapLoop();                           // Reader thread; out point reached, on from the in point
+    void CaptureTail(const uint8_t** in, int inCount);  // Past the out point: into m_fadeTail
+    void BlendTail(float* frames, int count);  // The run after a wrap: crossfade from m_fadeTail
+    void DecodePacket(AVPacket* packet, uint64_t generation);  // nullptr = drain at EOF
+    void WriteFrame(AVFrame* frame, uint64_t generation);
+    size_t Pending() const { return static_cast<size_t>(m_write - m_read); }
+
+    AVFormatContext* m_formatCtx = nullptr;
+    AVCodecContext*  m_codecCtx  = nullptr;
+    SwrContext*      m_swrCtx    = nullptr;
+    AVFrame*         m_frame     = nullptr;
+    AVPacket*        m_packet    = nullptr;
+    int    m_streamIdx  = -1;
+    int    m_sourceRate = 0;
+    int    m_sampleRate = 0;  // Output
+    int    m_channels   = 0;
+    double m_timeBase   = 0.0;
+
+    std::thread m_thread;
+    std::atomic<bool> m_stopRequested{false};  // Also interrupts blocking FFmpeg I/O
+    std::atomic<bool> m_ready{false};
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeCv;  // Drain freed space, or a seek is pending
+
+    // Guarded by m_mutex. Indices are in frames and increase monotonically;
+    // count = write - read. m_ring holds m_capacity interleaved frames.
+    std::vector<float> m_ring;
+    size_t   m_capacity = 0;
+    uint64_t m_read  = 0;
+    uint64_t m_write = 0;
+    std::deque<Segment> m_segments;
+    uint64_t m_generation  = 0;      // Bumped by Seek; stale decodes are dropped
+    bool     m_seekPending = false;
+    double   m_seekTarget  = 0.0;
+    double   m_loopIn  = 0.0;
+    double   m_loopOut = 0.0;  // 0 = no region
+
+    // Reader thread only
+    double   m_trimBefore       = -1.0;  // Drop samples before this time (after a seek)
+    bool     m_startSegment     = true;  // Next write begins a new Segment
+    uint64_t m_writtenSinceWrap = 0;     // Zero at EOF = nothing decodable, stop looping
+    double   m_runStart         = 0.0;   // Media time of the run's first sample
+    bool     m_pastLoopOut      = false; // Run reached the out point; filling m_fadeTail
+    double   m_wrapTo           = 0.0;   // In point the wrap goes to
+    std::vector<float> m_fadeTail;       // What follows the out point, LOOP_CROSSFADE_SECONDS
+    size_t   m_tailFill   = 0;           // Frames in m_fadeTail
+    size_t   m_fadeFrames = 0;           // Crossfade length after the last wrap
+    size_t   m_fadeDone   = 0;           // Of those, written
+    std::vector<const uint8_t*> m_inPlanes;  // swr input pointers past the trimmed samples
+};
+
+} // namespace SP
@@ -0,0 +1,353 @@
+#include "AudioTimeline.h"
+#include "AudioAnalyzer.h"
+#include "TraceRecorder.h"
+#include "ThreadPriority.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswresample/swresample.h>
+}
+
+namespace SP {
+
+namespace {
+
+constexpr uint32_t CACHE_MAGIC   = 0x54415053;  // "SPAT"
+constexpr uint32_t CACHE_VERSION = 3;  // 2: per-channel bands and stereo width, 3: tempo
+
+// One FFT per hop, so smoothing and beat decay step at a fixed rate
+constexpr int HOP_SAMPLES = AudioAnalyzer::kHopSize;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t  sampleRate;
+    int32_t  hopSamples;
+    uint64_t entryCount;
+};
+
+// Returns (and lazily creates) the audio_cache/ dir next to the exe.
+std::filesystem::path GetAudioCacheDir() {
+    char exePath[MAX_PATH];
+    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+    auto dir = std::filesystem::path(exePath).parent_path() / "audio_cache";
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    return dir;
+}
+
+uint16_t Quantize16(float v) {
+    return static_cast<uint16_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f));
+}
+
+uint8_t Quantize8(float v) {
+    return static_cast<uint8_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+}
+
+} // namespace
+
+AudioTimeline::~AudioTimeline() {
+    Reset();
+}
+
+void AudioTimeline::Build(const std::string& path, const AudioSettings& settings) {
+    Reset();
+    m_building = true;
+    m_thread = std::thread(&AudioTimeline::BuildThread, this, path, settings);
+}
+
+void AudioTimeline::Reset() {
+    if (m_thread.joinable()) {
+        m_cancel = true;
+        m_thread.join();
+    }
+    m_cancel    = false;
+    m_ready     = false;
+    m_building  = false;
+    m_fromCache = false;
+    m_progress  = 0.0f;
+    Unmap();
+    m_sampleRate = 0;
+    m_entries    = nullptr;
+    m_entryCount = 0;
+    m_built.clear();
+    m_built.shrink_to_fit();
+}
+
+void AudioTimeline::Lookup(double seconds, AudioData& out) const {
+    // Hop k holds the analysis after samples [0, (k+1) * HOP_SAMPLES) were fed
+    const double  hops = seconds * m_sampleRate / HOP_SAMPLES;
+    const int64_t hop  = static_cast<int64_t>(std::floor(hops)) - 1;
+    if (m_entryCount == 0 || hop < 0) {
+        out = AudioData{};
+        return;
+    }
+    const Entry& e = m_entries[std::min<size_t>(static_cast<size_t>(hop), m_entryCount - 1)];
+    out.rms              = e.rms / 65535.0f;
+    out.bass             = e.bass / 65535.0f;
+    out.mid              = e.mid / 65535.0f;
+    out.high             = e.high / 65535.0f;
+    out.beat             = e.beat / 65535.0f;
+    out.spectralCentroid = e.spectralCentroid / 65535.0f;
+    for (int ch = 0; ch < AUDIO_CHANNELS; ++ch) {
+        out.channelRms[ch]  = e.channel[ch][0] / 65535.0f;
+        out.channelBass[ch] = e.channel[ch][1] / 65535.0f;
+        out.channelMid[ch]  = e.channel[ch][2] / 65535.0f;
+        out.channelHigh[ch] = e.channel[ch][3] / 65535.0f;
+    }
+    out.stereoWidth = e.stereoWidth / 65535.0f;
+    out.bpm         = e.bpm / 100.0f;
+    out.beatPhase   = e.beatPhase / 65535.0f;
+    out.barPhase    = e.barPhase / 65535.0f;
+    for (int i = 0; i < AudioData::kSpectrumBins; ++i) out.spectrum[i] = e.spectrum[i] / 255.0f;
+    // The phases are as of the hop's end; move them on to `seconds`
+    if (static_cast<size_t>(hop) < m_entryCount) {
+        AudioAnalyzer::AdvancePhases(out, (hops - std::floor(hops)) * HOP_SAMPLES / m_sampleRate);
+    }
+}
+
+double AudioTimeline::GetDuration() const {
+    return m_sampleRate > 0 ? static_cast<double>(m_entryCount) * HOP_SAMPLES / m_sampleRate : 0.0;
+}
+
+void AudioTimeline::BuildThread(std::string path, AudioSettings settings) {
+    TraceRecorder::SetThreadName("Audio timeline");
+    ThreadPriority::Apply(ThreadRole::Background);
+    const std::filesystem::path cachePath = GetCachePath(path, settings);
+
+    if (!cachePath.empty() && MapCache(cachePath)) {
+        m_fromCache = true;
+    } else if (AnalyzeFile(path, settings)) {
+        // Serve lookups from the mapped file like a cache hit; keep the build in
+        // memory only when it could not be written
+        if (!cachePath.empty() && SaveCache(cachePath) && MapCache(cachePath)) {
+            m_built.clear();
+            m_built.shrink_to_fit();
+        } else {
+            m_entries    = m_built.data();
+            m_entryCount = m_built.size();
+        }
+    } else {
+        m_built.clear();
+        m_building = false;
+        return;
+    }
+
+    m_progress = 1.0f;
+    m_ready.store(true, std::memory_order_release);
+    m_building = false;
+}
+
+bool AudioTimeline::AnalyzeFile(const std::string& path, const AudioSettings& settings) {
+    AVFormatContext* fmt = avformat_alloc_context();
+    if (!fmt) return false;
+    fmt->interrupt_callback.callback = [](void* opaque) -> int {
+        return static_cast<const std::atomic<bool>*>(opaque)->load() ? 1 : 0;
+    };
+    fmt->interrupt_callback.opaque = &m_cancel;
+    if (avformat_open_input(&fmt, path.c_str(), nullptr, nullptr) < 0) return false;  // Freed fmt
+
+    AVCodecContext* codecCtx = nullptr;
+    SwrContext*     swr      = nullptr;
+    AVFrame*        frame    = nullptr;
+    AVPacket*       pkt      = nullptr;
+    auto cleanup = [&] {
+        swr_free(&swr);
+        avcodec_free_context(&codecCtx);
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        avformat_close_input(&fmt);
+    };
+
+    const int streamIdx = (avformat_find_stream_info(fmt, nullptr) >= 0)
+        ? av_find_best_stream(fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0) : -1;
+    if (streamIdx < 0) {
+        cleanup();
+        return false;  // No audio stream: nothing to analyse
+    }
+    // Only the audio stream's packets are read
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        if (static_cast<int>(i) != streamIdx) fmt->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    const AVCodec* codec = avcodec_find_decoder(fmt->streams[streamIdx]->codecpar->codec_id);
+    codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!codecCtx ||
+        avcodec_parameters_to_context(codecCtx, fmt->streams[streamIdx]->codecpar) < 0 ||
+        avcodec_open2(codecCtx, codec, nullptr) < 0 || codecCtx->sample_rate <= 0) {
+        cleanup();
+        return false;
+    }
+
+    // Interleaved stereo float at the source rate, the layout AudioReader hands AudioPlayer
+    AVChannelLayout stereoLayout = AV_CHANNEL_LAYOUT_STEREO;
+    if (swr_alloc_set_opts2(&swr,
+            &stereoLayout,        AV_SAMPLE_FMT_FLT,     codecCtx->sample_rate,
+            &codecCtx->ch_layout, codecCtx->sample_fmt, codecCtx->sample_rate,
+            0, nullptr) < 0 || !swr || swr_init(swr) < 0) {
+        cleanup();
+        return false;
+    }
+    frame = av_frame_alloc();
+    pkt   = av_packet_alloc();
+    if (!frame || !pkt) {
+        cleanup();
+        return false;
+    }
+
+    m_sampleRate = codecCtx->sample_rate;
+    const int64_t fileSize = fmt->pb ? avio_size(fmt->pb) : 0;
+    const double duration  = (fmt->duration > 0) ? static_cast<double>(fmt->duration) / AV_TIME_BASE : 0.0;
+    m_built.clear();
+    m_built.reserve(static_cast<size_t>(duration * m_sampleRate / HOP_SAMPLES) + 1);
+
+    auto analyzer = std::make_unique<AudioAnalyzer>();  // Large rings: off the stack
+    analyzer->UpdateSettings(settings);
+    std::vector<float> pending;  // Converted frames (interleaved) not yet fed as a full hop
+    std::vector<float> converted;
+
+    constexpr size_t HOP_FLOATS = static_cast<size_t>(HOP_SAMPLES) * AUDIO_CHANNELS;
+    auto feedHops = [&] {
+        size_t used = 0;
+        for (; pending.size() - used >= HOP_FLOATS; used += HOP_FLOATS) {
+            analyzer->FeedSamples(pending.data() + used, static_cast<int>(HOP_FLOATS), AUDIO_CHANNELS, m_sampleRate);
+            AudioData data;
+            analyzer->GetData(data);
+            Entry& e = m_built.emplace_back();
+            e.rms              = Quantize16(data.rms);
+            e.bass             = Quantize16(data.bass);
+            e.mid              = Quantize16(data.mid);
+            e.high             = Quantize16(data.high);
+            e.beat             = Quantize16(data.beat);
+            e.spectralCentroid = Quantize16(data.spectralCentroid);
+            for (int ch = 0; ch < AUDIO_CHANNELS; ++ch) {
+                e.channel[ch][0] = Quantize16(data.channelRms[ch]);
+                e.channel[ch][1] = Quantize16(data.channelBass[ch]);
+                e.channel[ch][2] = Quantize16(data.channelMid[ch]);
+                e.channel[ch][3] = Quantize16(data.channelHigh[ch]);
+            }
+            e.stereoWidth = Quantize16(data.stereoWidth);
+            e.bpm         = static_cast<uint16_t>(std::lround(std::clamp(data.bpm, 0.0f, 655.0f) * 100.0f));
+            e.beatPhase   = Quantize16(data.beatPhase);
+            e.barPhase    = Quantize16(data.barPhase);
+            for (int i = 0; i < AudioData::kSpectrumBins; ++i) e.spectrum[i] = Quantize8(data.spectrum[i]);
+        }
+        pending.erase(pending.begin(), pending.begin() + static_cast<ptrdiff_t>(used));
+    };
+    // Drains decoded frames into `pending`; a null `packet` flushes the decoder
+    auto decode = [&](const AVPacket* packet) {
+        if (avcodec_send_packet(codecCtx, packet) < 0 && packet) return;
+        while (avcodec_receive_frame(codecCtx, frame) == 0) {
+            const int room = swr_get_out_samples(swr, frame->nb_samples);
+            converted.resize(static_cast<size_t>(std::max(room, 0)) * AUDIO_CHANNELS);
+            uint8_t* out = reinterpret_cast<uint8_t*>(converted.data());
+            const int got = swr_convert(swr, &out, room,
+                                        const_cast<const uint8_t**>(frame->extended_data), frame->nb_samples);
+            if (got > 0) pending.insert(pending.end(), converted.begin(), converted.begin() + got * AUDIO_CHANNELS);
+            av_frame_unref(frame);
+        }
+        feedHops();
+    };
+
+    bool ok = true;
+    while (!m_cancel.load()) {
+        const int ret = av_read_frame(fmt, pkt);
+        if (ret == AVERROR_EOF) break;
+        if (ret < 0) { ok = false; break; }
+
+        if (pkt->stream_index == streamIdx) {
+            decode(pkt);
+            if (fileSize > 0 && pkt->pos >= 0) {
+                m_progress = static_cast<float>(static_cast<double>(pkt->pos) / fileSize);
+            } else if (duration > 0.0) {
+                m_progress = static_cast<float>(std::min(1.0, m_built.size() * HOP_SAMPLES / (duration * m_sampleRate)));
+            }
+        }
+        av_packet_unref(pkt);
+    }
+    if (ok && !m_cancel.load()) decode(nullptr);
+
+    cleanup();
+    return ok && !m_cancel.load() && !m_built.empty();
+}
+
+std::filesystem::path AudioTimeline::GetCachePath(const std::string& path, const AudioSettings& settings) {
+    // The DSP settings shape every value, so each combination is its own table
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) return {};
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return {};
+
+    const int64_t stamp[2] = {
+        static_cast<int64_t>(size),
+        static_cast<int64_t>(mtime.time_since_epoch().count())
+    };
+    const float dsp[3] = { settings.beatSensitivity, settings.beatDecay, settings.smoothing };
+    const int32_t layout[3] = { settings.fftSize, settings.multiResolution, settings.logSpectrum };
+    uint64_t hash = Fnv1a64(path.c_str(), path.size());
+    hash = Fnv1a64(reinterpret_cast<const char*>(stamp), sizeof(stamp), hash);
+    hash = Fnv1a64(reinterpret_cast<const char*>(dsp), sizeof(dsp), hash);
+    hash = Fnv1a64(reinterpret_cast<const char*>(layout), sizeof(layout), hash);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.atl", static_cast<unsigned long long>(hash));
+    return GetAudioCacheDir() / name;
+}
+
+bool AudioTimeline::MapCache(const std::filesystem::path& cachePath) {
+    m_file = CreateFileW(cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize = {};
+    if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &fileSize) ||
+        fileSize.QuadPart < static_cast<LONGLONG>(sizeof(CacheHeader))) {
+        Unmap();
+        return false;
+    }
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping) m_view = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_view) {
+        Unmap();
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, m_view, sizeof(header));
+    const uint64_t available = (static_cast<uint64_t>(fileSize.QuadPart) - sizeof(CacheHeader)) / sizeof(Entry);
+    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.sampleRate <= 0 ||
+        header.hopSamples != HOP_SAMPLES || header.entryCount == 0 || header.entryCount > available) {
+        Unmap();
+        return false;
+    }
+    m_sampleRate = header.sampleRate;
+    m_entries    = reinterpret_cast<const Entry*>(m_view + sizeof(CacheHeader));
+    m_entryCount = static_cast<size_t>(header.entryCount);
+    return true;
+}
+
+bool AudioTimeline::SaveCache(const std::filesystem::path& cachePath) const {
+    std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    const CacheHeader header = { CACHE_MAGIC, CACHE_VERSION, m_sampleRate, HOP_SAMPLES, m_built.size() };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(m_built.data()),
+              static_cast<std::streamsize>(m_built.size() * sizeof(Entry)));
+    return static_cast<bool>(out);
+}
+
+void AudioTimeline::Unmap() {
+    if (m_view) UnmapViewOfFile(m_view);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+    m_view    = nullptr;
+    m_mapping = nullptr;
+    m_file    = INVALID_HANDLE_VALUE;
+}
+
+} // namespace SP
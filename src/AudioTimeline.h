@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Audio features of a whole file, analysed ahead of playback. A worker thread
+// decodes the file's best audio stream with its own AVFormatContext (so it never
+// contends with AudioReader or VideoDecoder) and runs AudioAnalyzer over it at a
+// fixed hop, storing one quantized AudioData per hop. The result is written to
+// audio_cache/ next to the exe, keyed by path + size + mtime + AudioSettings, and
+// read back memory-mapped, so reopening a file costs no decode at all.
+//
+// Lookup is an index computation: the features at any media time are available
+// the moment a seek lands, and an export sees the same values on every run.
+// The table is published with m_ready; Lookup is lock-free once IsReady().
+class AudioTimeline {
+public:
+    AudioTimeline() = default;
+    ~AudioTimeline();
+
+    // Non-copyable
+    AudioTimeline(const AudioTimeline&) = delete;
+    AudioTimeline& operator=(const AudioTimeline&) = delete;
+
+    // Load from cache or start analysing `path` with `settings` baked in.
+    // Cancels any build in progress.
+    void Build(const std::string& path, const AudioSettings& settings);
+    // Cancel, join, and clear.
+    void Reset();
+
+    bool  IsReady() const { return m_ready.load(std::memory_order_acquire); }
+    bool  IsBuilding() const { return m_building.load(); }
+    bool  IsFromCache() const { return m_fromCache.load(); }
+    float GetProgress() const { return m_progress.load(); }  // [0,1] while building
+
+    // Features heard at `seconds` of media time; zeros before the first full
+    // FFT window, the last hop past the end. Valid only when IsReady().
+    void Lookup(double seconds, AudioData& out) const;
+    double GetDuration() const;
+
+private:
+    // One hop: scalars as 16-bit and spectrum bins as 8-bit fractions of 1
+    struct Entry {
+        uint16_t rms, bass, mid, high, beat, spectralCentroid;
+        uint16_t channel[AUDIO_CHANNELS][4];  // rms, bass, mid, high per channel
+        uint16_t stereoWidth;
+        uint16_t bpm;                  // In 1/100 BPM
+        uint16_t beatPhase, barPhase;
+        uint8_t  spectrum[AudioData::kSpectrumBins];
+    };
+
+    void BuildThread(std::string path, AudioSettings settings);
+    bool AnalyzeFile(const std::string& path, const AudioSettings& settings);
+    static std::filesystem::path GetCachePath(const std::string& path, const AudioSettings& settings);
+    bool MapCache(const std::filesystem::path& cachePath);
+    bool SaveCache(const std::filesystem::path& cachePath) const;
+    void Unmap();
+
+    std::thread m_thread;
+    std::atomic<bool>  m_cancel{false};  // Also interrupts blocking FFmpeg I/O
+    std::atomic<bool>  m_ready{false};
+    std::atomic<bool>  m_building{false};
+    std::atomic<bool>  m_fromCache{false};
+    std::atomic<float> m_progress{0.0f};
+
+    // Written by the worker before m_ready. m_entries points into the mapped
+    // cache, or into m_built when the cache could not be written.
+    int m_sampleRate = 0;
+    const Entry* m_entries = nullptr;
+    size_t m_entryCount = 0;
+    std::vector<Entry> m_built;
+
+    HANDLE      m_file    = INVALID_HANDLE_VALUE;
+    HANDLE      m_mapping = nullptr;
+    const char* m_view    = nullptr;
+};
+
+} // namespace SP
@@ -0,0 +1,279 @@
+#include "AutomationRecorder.h"
+#include <algorithm>
+#include <cmath>
+
+namespace SP {
+
+namespace {
+
+// Bezier handle heights the fit may pick: overshoot, but not wild
+constexpr float MIN_HANDLE_Y = -1.0f;
+constexpr float MAX_HANDLE_Y = 2.0f;
+
+// Values within this of each other count as one: slider float noise is no move
+constexpr float MOVE_EPSILON = 1e-6f;
+
+// Keys of the old timeline this close to the recorded span are replaced too
+constexpr float SPAN_EPSILON = 1e-4f;
+
+bool Recordable(const ShaderParam& param) {
+    switch (param.type) {
+    case ShaderParamType::Float:
+    case ShaderParamType::Bool:
+    case ShaderParamType::Long:
+    case ShaderParamType::Color:
+    case ShaderParamType::Point2D:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int ValueCount(const ShaderParam& param) {
+    if (param.type == ShaderParamType::Point2D) return 2;
+    if (param.type == ShaderParamType::Color)   return 4;
+    return 1;
+}
+
+// With the x handles at 1/3 and 2/3 the curve's x is its parameter, so y(x) is
+// the cubic below and EvalCubicBezier reproduces it exactly
+float BezierY(float y1, float y2, float x) {
+    const float u = 1.0f - x;
+    return 3.0f * u * u * x * y1 + 3.0f * u * x * x * y2 + x * x * x;
+}
+
+} // namespace
+
+void AutomationRecorder::Start(int presetIndex) {
+    m_presetIndex = presetIndex;
+    m_lastTime    = -1.0f;
+    m_keysWritten = 0;
+    m_tracks.clear();
+}
+
+AutomationRecorder::Track* AutomationRecorder::FindTrack(const std::string& param) {
+    auto it = std::find_if(m_tracks.begin(), m_tracks.end(), [&](const Track& track) { return track.param == param; });
+    return it == m_tracks.end() ? nullptr : &*it;
+}
+
+void AutomationRecorder::Capture(ShaderPreset& preset, double time) {
+    if (!IsRecording()) return;
+    const float now = static_cast<float>(time);
+
+    // Looped or sought back: this pass is done, the next one records over it
+    if (m_lastTime >= 0.0f && now < m_lastTime) {
+        for (Track& track : m_tracks) {
+            if (track.latched) Flush(preset, track);
+        }
+    }
+    m_lastTime = now;
+
+    for (ShaderParam& param : preset.params) {
+        if (!Recordable(param)) continue;
+        Track* track = FindTrack(param.name);
+        if (!track) {
+            // First seen: what it holds now is the baseline, not a move
+            Track added;
+            added.param      = param.name;
+            added.valueCount = ValueCount(param);
+            const float range = param.max - param.min;
+            const bool  unit  = param.type == ShaderParamType::Color || param.type == ShaderParamType::Bool;
+            for (float& scale : added.scale) scale = unit || range <= 0.0f ? 1.0f : range;
+            std::copy_n(param.values, 4, added.settled);
+            m_tracks.push_back(std::move(added));
+            continue;
+        }
+
+        if (!track->latched) {
+            bool moved = false;
+            for (int i = 0; i < track->valueCount; ++i)
+                moved = moved || std::abs(param.values[i] - track->settled[i]) > MOVE_EPSILON;
+            if (!moved) continue;
+            // Latched: its old keys stop fighting the hand until Stop
+            track->latched = true;
+            track->samples.reserve(MAX_SAMPLES);
+            if (!param.timeline) param.timeline.emplace();
+            param.timeline->enabled = false;
+        }
+
+        Sample sample;
+        sample.time = now;
+        std::copy_n(param.values, 4, sample.values);
+        // Paused: the latest value at this time is the one that counts
+        if (!track->samples.empty() && track->samples.back().time >= now) track->samples.back() = sample;
+        else                                                              track->samples.push_back(sample);
+        if (track->samples.size() >= MAX_SAMPLES) Flush(preset, *track);
+    }
+}
+
+void AutomationRecorder::Settle(const ShaderPreset& preset) {
+    if (!IsRecording()) return;
+    for (const ShaderParam& param : preset.params) {
+        if (Track* track = FindTrack(param.name)) std::copy_n(param.values, 4, track->settled);
+    }
+}
+
+int AutomationRecorder::Flush(ShaderPreset& preset, Track& track) {
+    auto param = std::find_if(preset.params.begin(), preset.params.end(),
+                              [&](const ShaderParam& p) { return p.name == track.param; });
+    if (track.samples.empty() || param == preset.params.end()) {
+        track.samples.clear();
+        return 0;
+    }
+    std::vector<Keyframe> keys = Fit(track.samples, track.valueCount, track.scale, TOLERANCE);
+    const float first = track.samples.front().time;
+    const float last  = track.samples.back().time;
+    track.samples.clear();
+
+    if (!param->timeline) param->timeline.emplace();
+    std::vector<Keyframe>& existing = param->timeline->keyframes;
+    existing.erase(std::remove_if(existing.begin(), existing.end(), [&](const Keyframe& key) {
+        return key.time >= first - SPAN_EPSILON && key.time <= last + SPAN_EPSILON;
+    }), existing.end());
+    for (const Keyframe& key : keys) param->timeline->AddKeyframe(key);
+    m_keysWritten += static_cast<int>(keys.size());
+    return static_cast<int>(keys.size());
+}
+
+int AutomationRecorder::Stop(ShaderPreset& preset) {
+    for (Track& track : m_tracks) {
+        if (!track.latched) continue;
+        Flush(preset, track);
+        for (ShaderParam& param : preset.params) {
+            if (param.name == track.param && param.timeline && !param.timeline->keyframes.empty())
+                param.timeline->enabled = true;
+        }
+    }
+    const int written = m_keysWritten;
+    Cancel();
+    return written;
+}
+
+void AutomationRecorder::Cancel() {
+    m_presetIndex = -1;
+    m_lastTime    = -1.0f;
+    m_tracks.clear();
+}
+
+int AutomationRecorder::GetLatchedCount() const {
+    return static_cast<int>(std::count_if(m_tracks.begin(), m_tracks.end(),
+                                          [](const Track& track) { return track.latched; }));
+}
+
+/*static*/ std::vector<Keyframe> AutomationRecorder::Fit(const std::vector<Sample>& samples, int valueCount,
+                                                         const float scale[4], float tolerance) {
+    std::vector<Keyframe> keys;
+    if (samples.empty()) return keys;
+    auto keyAt = [&](size_t index) {
+        Keyframe key;
+        key.time = samples[index].time;
+        std::copy_n(samples[index].values, 4, key.values);
+        return key;
+    };
+    if (samples.size() == 1) {
+        keys.push_back(keyAt(0));
+        return keys;
+    }
+
+    // Worst miss, in fractions of the range, of the segment first..last remapped by `curve`
+    auto worst = [&](size_t first, size_t last, auto&& curve, size_t& at) {
+        const Sample& a = samples[first];
+        const Sample& b = samples[last];
+        const float length = b.time - a.time;
+        float error = 0.0f;
+        for (size_t k = first + 1; k < last; ++k) {
+            const float f = curve((samples[k].time - a.time) / length);
+            for (int c = 0; c < valueCount; ++c) {
+                const float miss = std::abs(a.values[c] + (b.values[c] - a.values[c]) * f - samples[k].values[c]) / scale[c];
+                if (miss > error) {
+                    error = miss;
+                    at    = k;
+                }
+            }
+        }
+        return error;
+    };
+
+    struct Segment {
+        size_t first, last;
+        InterpolationMode mode = InterpolationMode::Linear;
+        BezierHandles handles;
+    };
+    std::vector<Segment> fitted;
+    std::vector<std::pair<size_t, size_t>> pending = {{0, samples.size() - 1}};
+    while (!pending.empty()) {
+        const auto [first, last] = pending.back();
+        pending.pop_back();
+        Segment segment{first, last};
+        if (last - first < 2) {
+            fitted.push_back(segment);
+            continue;
+        }
+
+        size_t split = (first + last) / 2;
+        if (worst(first, last, [](float x) { return x; }, split) <= tolerance) {
+            fitted.push_back(segment);
+            continue;
+        }
+
+        // One easing curve moves every component from a to b: fit it to each
+        // sample's progress along that move, in range-scaled units
+        const Sample& a = samples[first];
+        const Sample& b = samples[last];
+        float direction[4] = {};
+        float lengthSq = 0.0f;
+        for (int c = 0; c < valueCount; ++c) {
+            direction[c] = (b.values[c] - a.values[c]) / scale[c];
+            lengthSq += direction[c] * direction[c];
+        }
+        if (lengthSq > tolerance * tolerance) {
+            // Least squares for the two handle heights: y(x) - x^3 is linear in them
+            double s11 = 0.0, s12 = 0.0, s22 = 0.0, r1 = 0.0, r2 = 0.0;
+            const float length = b.time - a.time;
+            for (size_t k = first + 1; k < last; ++k) {
+                const float x = (samples[k].time - a.time) / length;
+                float progress = 0.0f;
+                for (int c = 0; c < valueCount; ++c)
+                    progress += (samples[k].values[c] - a.values[c]) / scale[c] * direction[c];
+                progress /= lengthSq;
+                const double u  = 1.0 - x;
+                const double b1 = 3.0 * u * u * x;
+                const double b2 = 3.0 * u * x * x;
+                const double r  = progress - static_cast<double>(x) * x * x;
+                s11 += b1 * b1;
+                s12 += b1 * b2;
+                s22 += b2 * b2;
+                r1  += b1 * r;
+                r2  += b2 * r;
+            }
+            const double det = s11 * s22 - s12 * s12;
+            if (std::abs(det) > 1e-12) {
+                const float y1 = std::clamp(static_cast<float>((r1 * s22 - r2 * s12) / det), MIN_HANDLE_Y, MAX_HANDLE_Y);
+                const float y2 = std::clamp(static_cast<float>((r2 * s11 - r1 * s12) / det), MIN_HANDLE_Y, MAX_HANDLE_Y);
+                size_t bezierSplit = split;
+                if (worst(first, last, [&](float x) { return BezierY(y1, y2, x); }, bezierSplit) <= tolerance) {
+                    segment.mode    = InterpolationMode::CubicBezier;
+                    segment.handles = {1.0f / 3.0f, y1, 2.0f / 3.0f, y2};
+                    fitted.push_back(segment);
+                    continue;
+                }
+                split = bezierSplit;
+            }
+        }
+        pending.push_back({split, last});
+        pending.push_back({first, split});
+    }
+
+    std::sort(fitted.begin(), fitted.end(), [](const Segment& l, const Segment& r) { return l.first < r.first; });
+    keys.reserve(fitted.size() + 1);
+    for (const Segment& segment : fitted) {
+        Keyframe key  = keyAt(segment.first);
+        key.mode      = segment.mode;
+        key.handles   = segment.handles;
+        keys.push_back(key);
+    }
+    keys.push_back(keyAt(samples.size() - 1));
+    return keys;
+}
+
+} // namespace SP
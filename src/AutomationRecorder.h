@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Records live param moves (sliders, MIDI, OSC) into the keyframe timelines of
+// the preset that was active at Start. A param latches the first frame its value
+// differs from what the previous frame left it at: its timeline stops replaying
+// and each frame's value goes into a bounded buffer for that param. When
+// recording stops, playback time runs backward (loop, seek) or a buffer fills,
+// the samples are fitted to the fewest keys that keep every sample within
+// TOLERANCE of the param's range, and those keys replace the timeline's keys
+// over the recorded span. One key per frame would bloat config.keys and slow
+// Evaluate; a slow knob turn fits in a handful of bezier segments.
+//
+// Main thread only. Capture and Settle bracket ShaderManager::EvaluateKeyframes
+// each frame so a replayed value is never mistaken for a move.
+class AutomationRecorder {
+public:
+    struct Sample {
+        float time = 0.0f;
+        float values[4] = {};
+    };
+
+    // Fraction of a param's range a fitted curve may miss a recorded sample by
+    static constexpr float TOLERANCE = 0.01f;
+    // Samples a param buffers before they are fitted: about 4.5 minutes at 60 fps
+    static constexpr size_t MAX_SAMPLES = 16384;
+
+    void Start(int presetIndex);
+    // Before EvaluateKeyframes: latches params moved since the last Settle and
+    // records every latched one at `time`
+    void Capture(ShaderPreset& preset, double time);
+    // After EvaluateKeyframes: the values the next Capture compares against
+    void Settle(const ShaderPreset& preset);
+    // Fits what is buffered and turns the latched timelines back on. Returns the
+    // keys written since Start.
+    int Stop(ShaderPreset& preset);
+    // Drops the buffers without writing (the preset went away)
+    void Cancel();
+
+    bool IsRecording() const { return m_presetIndex >= 0; }
+    int  GetPresetIndex() const { return m_presetIndex; }
+    int  GetLatchedCount() const;
+
+    // The fewest keys through `samples` (sorted by time, at least one) that keep
+    // every component c of every sample within tolerance * scale[c] of the
+    // timeline they evaluate to. Each segment is linear where that fits, else a
+    // least-squares cubic bezier, else split at its worst sample.
+    static std::vector<Keyframe> Fit(const std::vector<Sample>& samples, int valueCount,
+                                     const float scale[4], float tolerance);
+
+private:
+    struct Track {
+        std::string param;  // ShaderParam::name: survives a re-parse
+        int   valueCount = 1;
+        float scale[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        float settled[4] = {};
+        bool  latched = false;
+        std::vector<Sample> samples;
+    };
+
+    Track* FindTrack(const std::string& param);
+    int Flush(ShaderPreset& preset, Track& track);
+
+    int   m_presetIndex = -1;
+    float m_lastTime = -1.0f;
+    int   m_keysWritten = 0;
+    std::vector<Track> m_tracks;
+};
+
+} // namespace SP
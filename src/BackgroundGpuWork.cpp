@@ -0,0 +1,131 @@
+#include "BackgroundGpuWork.h"
+#include "TraceRecorder.h"
+
+namespace SP {
+
+bool BackgroundGpuWork::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+    Shutdown();
+    if (!device || !context) return false;
+    m_device  = device;
+    m_context = context;
+
+    D3D11_QUERY_DESC disjointDesc = {};
+    disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+    for (FrameQueries& queries : m_frames) {
+        if (FAILED(m_device->CreateQuery(&disjointDesc, &queries.disjoint))) {
+            Shutdown();
+            return false;
+        }
+    }
+    return true;
+}
+
+void BackgroundGpuWork::Shutdown() {
+    for (FrameQueries& queries : m_frames) queries = FrameQueries{};
+    m_device  = nullptr;
+    m_context = nullptr;
+    m_current = 0;
+}
+
+void BackgroundGpuWork::AddTask(const char* name, Step step) {
+    m_steps.push_back(std::move(step));
+    TaskStats stats;
+    stats.name = name;
+    m_stats.push_back(stats);
+}
+
+bool BackgroundGpuWork::CreateTimestamp(ComPtr<ID3D11Query>& query) {
+    if (query) return true;
+    D3D11_QUERY_DESC desc = {};
+    desc.Query = D3D11_QUERY_TIMESTAMP;
+    return SUCCEEDED(m_device->CreateQuery(&desc, &query));
+}
+
+void BackgroundGpuWork::ResolveFinished() {
+    // Oldest first, so a task's average takes its steps in order
+    for (int i = 1; i <= QUERY_LATENCY; ++i) {
+        FrameQueries& queries = m_frames[(m_current + i) % QUERY_LATENCY];
+        if (queries.pending && !Resolve(queries)) break;
+    }
+}
+
+bool BackgroundGpuWork::Resolve(FrameQueries& queries) {
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint = {};
+    if (m_context->GetData(queries.disjoint.Get(), &disjoint, sizeof(disjoint),
+                           D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+        return false;
+    }
+    queries.pending = false;
+    if (disjoint.Disjoint || disjoint.Frequency == 0) return true;  // Clock changed: no measurement
+
+    auto read = [&](ID3D11Query* query, UINT64& out) {
+        return m_context->GetData(query, &out, sizeof(out), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+    };
+    float frameMs = 0.0f;
+    for (int i = 0; i < queries.used; ++i) {
+        UINT64 begin = 0, end = 0;
+        if (!read(queries.steps[i].begin.Get(), begin) || !read(queries.steps[i].end.Get(), end)) return true;
+        const float ms = end > begin
+            ? static_cast<float>(static_cast<double>(end - begin) * 1000.0 / static_cast<double>(disjoint.Frequency))
+            : 0.0f;
+        TaskStats& stats = m_stats[queries.steps[i].task];
+        stats.lastGpuMs = ms;
+        stats.avgGpuMs  = stats.avgGpuMs == 0.0f ? ms : stats.avgGpuMs + (ms - stats.avgGpuMs) * COST_SMOOTHING;
+        frameMs += ms;
+    }
+    m_lastFrameMs = frameMs;
+    return true;
+}
+
+int BackgroundGpuWork::Run(double gpuBudgetMs, double cpuBudgetMs) {
+    if (!m_context || m_steps.empty()) return 0;
+    ResolveFinished();
+
+    FrameQueries& queries = m_frames[m_current];
+    if (queries.pending) return 0;  // The GPU is QUERY_LATENCY frames behind: that is no slack either
+    SP_TRACE_SCOPE("Background GPU work");
+    queries.used = 0;
+    m_context->Begin(queries.disjoint.Get());
+
+    const auto start = std::chrono::steady_clock::now();
+    const int taskCount = static_cast<int>(m_steps.size());
+    double predictedMs = 0.0;
+    int idle = 0;  // Tasks in a row with nothing to do
+    while (queries.used < MAX_STEPS && idle < taskCount) {
+        const int task = m_nextTask;
+        const TaskStats& stats = m_stats[task];
+        const double costMs = stats.avgGpuMs > 0.0f ? stats.avgGpuMs : gpuBudgetMs;
+        if (queries.used > 0 && predictedMs + costMs > gpuBudgetMs) break;
+        if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= cpuBudgetMs)
+            break;
+
+        StepQueries& step = queries.steps[queries.used];
+        if (!CreateTimestamp(step.begin) || !CreateTimestamp(step.end)) break;
+        m_context->End(step.begin.Get());
+        const bool submitted = m_steps[task]();
+        m_context->End(step.end.Get());
+        m_nextTask = (m_nextTask + 1) % taskCount;
+        if (!submitted) {
+            ++idle;
+            continue;  // Its timestamps are reused by the next step
+        }
+        idle = 0;
+        step.task = task;
+        ++queries.used;
+        ++m_stats[task].steps;
+        predictedMs += costMs;
+    }
+
+    m_context->End(queries.disjoint.Get());
+    queries.pending = queries.used > 0;
+    if (queries.pending) m_current = (m_current + 1) % QUERY_LATENCY;
+    return queries.used;
+}
+
+void BackgroundGpuWork::Skip() {
+    if (!m_context) return;
+    ResolveFinished();
+    ++m_deferred;
+}
+
+} // namespace SP
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Common.h"
+#include <array>
+#include <chrono>
+
+namespace SP {
+
+// GPU work nobody is waiting on this frame: library thumbnails, shader
+// prewarm, LUT bakes. Application runs it after Present, in the slack before
+// the next frame, so it is queued behind the live frame instead of in front of
+// it, and only while the last frames left room (see Application::RunBackgroundWork).
+//
+// Each task is a step function that does one bounded piece of work on the
+// immediate context. Run calls the tasks' steps round-robin, starting after the
+// last one it served, while the predicted GPU cost fits the frame's budget.
+// The prediction is a moving average of the task's measured step cost: every
+// step is bracketed by timestamp queries, read back QUERY_LATENCY frames later
+// without stalling. A task not measured yet is assumed to take the whole budget.
+// The first step of a frame always runs, so a task costlier than the budget
+// still gets one step a frame. Deferred contexts would not help here: D3D11
+// plays their command lists back on the immediate context anyway, and most
+// drivers emulate them.
+//
+// Render thread only.
+class BackgroundGpuWork {
+public:
+    static constexpr int   QUERY_LATENCY  = 4;  // Frames in flight
+    static constexpr int   MAX_STEPS      = 8;  // Per frame
+    static constexpr float COST_SMOOTHING = 0.2f;
+
+    // One piece of a task. False when the task had nothing to submit (it is
+    // then not timed and the next task gets the turn).
+    using Step = std::function<bool()>;
+
+    struct TaskStats {
+        const char* name  = "";
+        int64_t     steps = 0;
+        float       avgGpuMs  = 0.0f;  // Per step; 0 until measured
+        float       lastGpuMs = 0.0f;  // Last measured step
+    };
+
+    BackgroundGpuWork() = default;
+    ~BackgroundGpuWork() { Shutdown(); }
+
+    // Non-copyable
+    BackgroundGpuWork(const BackgroundGpuWork&) = delete;
+    BackgroundGpuWork& operator=(const BackgroundGpuWork&) = delete;
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+    void Shutdown();
+
+    void AddTask(const char* name, Step step);
+
+    // Once per tick, after Present. Resolves earlier frames' timings, then
+    // steps the tasks within `gpuBudgetMs` of predicted GPU time and
+    // `cpuBudgetMs` of wall time. Returns the steps that submitted work.
+    int Run(double gpuBudgetMs, double cpuBudgetMs);
+    // A tick without slack: only resolves timings, and counts it as deferred
+    void Skip();
+
+    const std::vector<TaskStats>& GetTasks() const { return m_stats; }
+    float   GetLastFrameGpuMs() const { return m_lastFrameMs; }  // All steps of the newest measured frame
+    int64_t GetDeferredFrames() const { return m_deferred; }
+
+private:
+    struct StepQueries {
+        ComPtr<ID3D11Query> begin;
+        ComPtr<ID3D11Query> end;
+        int task = -1;
+    };
+    struct FrameQueries {
+        ComPtr<ID3D11Query> disjoint;
+        std::array<StepQueries, MAX_STEPS> steps;
+        int  used    = 0;
+        bool pending = false;
+    };
+    bool CreateTimestamp(ComPtr<ID3D11Query>& query);
+    void ResolveFinished();
+    bool Resolve(FrameQueries& queries);  // False while the GPU is still on it
+
+    ID3D11Device*        m_device  = nullptr;
+    ID3D11DeviceContext* m_context = nullptr;
+    std::array<FrameQueries, QUERY_LATENCY> m_frames;
+    int m_current = 0;
+
+    std::vector<Step>      m_steps;
+    std::vector<TaskStats> m_stats;
+    int     m_nextTask    = 0;
+    float   m_lastFrameMs = 0.0f;
+    int64_t m_deferred    = 0;
+};
+
+} // namespace SP
@@ -0,0 +1,538 @@
+#include "BatchRenderer.h"
+#include "ConfigManager.h"
+#include "D3D11Renderer.h"
+#include "DecodeWorker.h"
+#include "ImageSequenceWriter.h"
+#include "ModulationMatrix.h"
+#include "ShaderManager.h"
+#include "VideoDecoder.h"
+#include "VideoEncoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace SP {
+
+namespace {
+
+// BeginFrame's offscreen stand-in for the back buffer; nothing is drawn to it
+constexpr int HEADLESS_TARGET_SIZE = 64;
+// A job reports its progress this often
+constexpr double PROGRESS_INTERVAL = 5.0;
+// Decoding behind rendering: wait this long before polling the ring again
+constexpr auto POP_RETRY_INTERVAL = std::chrono::milliseconds(1);
+// Waiting for a seek index to be demuxed
+constexpr auto INDEX_POLL_INTERVAL = std::chrono::milliseconds(20);
+
+std::string ResolvePath(const std::filesystem::path& base, const std::string& path) {
+    if (path.empty() || std::filesystem::path(path).is_absolute()) return path;
+    return (base / path).lexically_normal().string();
+}
+
+// Frame N depends on frame N-1, so the job can't start mid-way
+bool CarriesState(const ShaderPreset& preset) {
+    const bool persistentPass = std::any_of(preset.passes.begin(), preset.passes.end(),
+                                            [](const RenderPassDesc& pass) { return pass.persistent; });
+    const bool persistentBuffer = std::any_of(preset.compute.buffers.begin(), preset.compute.buffers.end(),
+                                              [](const ComputeBufferDesc& buffer) { return buffer.persistent; });
+    return persistentPass || persistentBuffer || preset.frameHistory.frames > 0;
+}
+
+} // namespace
+
+bool BatchRenderer::LoadJobs(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "Failed to open job file: " + path;
+        return false;
+    }
+
+    m_jobs.clear();
+    try {
+        const nlohmann::json j = nlohmann::json::parse(file);
+        const std::filesystem::path base = std::filesystem::absolute(path).parent_path();
+        m_concurrency = j.value("concurrency", 0);
+        if (m_sharedShaderCache.empty()) {
+            m_sharedShaderCache = ResolvePath(base, j.value("sharedShaderCache", std::string()));
+        }
+
+        if (!j.contains("jobs") || !j["jobs"].is_array()) {
+            error = "Job file has no \"jobs\" array";
+            return false;
+        }
+        for (const auto& jobJson : j["jobs"]) {
+            BatchJob job;
+            job.input = ResolvePath(base, jobJson.value("input", std::string()));
+            if (jobJson.contains("preset"))  jobJson.at("preset").get_to(job.preset);
+            if (jobJson.contains("output"))  jobJson.at("output").get_to(job.output);
+            job.duration = jobJson.value("duration", job.duration);
+            job.width    = jobJson.value("width", job.width);
+            job.height   = jobJson.value("height", job.height);
+            job.chunks   = jobJson.value("chunks", job.chunks);
+            job.preset.filepath    = ResolvePath(base, job.preset.filepath);
+            job.output.outputPath  = ResolvePath(base, job.output.outputPath);
+
+            if (job.preset.filepath.empty() || job.output.outputPath.empty()) {
+                error = "Job " + std::to_string(m_jobs.size() + 1) + " needs preset.filepath and output.outputPath";
+                return false;
+            }
+            m_jobs.push_back(std::move(job));
+        }
+    } catch (const std::exception& e) {
+        error = std::string("Invalid job file: ") + e.what();
+        return false;
+    }
+    return true;
+}
+
+int BatchRenderer::Run(int concurrency, int chunk, bool joinOnly) {
+    // Chunked jobs are split first; their segments then share the workers with
+    // every other job. On a node (`chunk`), jobs that aren't split render on the
+    // node given chunk 1.
+    std::vector<std::vector<Task>> plans(m_jobs.size());
+    std::vector<Task> tasks;
+    for (size_t i = 0; i < m_jobs.size(); ++i) {
+        plans[i] = PlanJob(i);
+        const bool split = plans[i].front().segment >= 0;
+        for (const Task& task : plans[i]) {
+            if (joinOnly) continue;
+            if (chunk > 0 && (split ? task.segment + 1 != chunk : chunk != 1)) continue;
+            tasks.push_back(task);
+        }
+    }
+
+    std::atomic<int> failed{0};
+    auto join = [&](size_t index) {
+        std::vector<std::string> parts;
+        for (const Task& task : plans[index]) parts.push_back(task.outputPath);
+        std::string error;
+        if (!JoinSegments(parts, m_jobs[index].output.outputPath, error)) {
+            Log(index, "join FAILED: " + error);
+            ++failed;
+            return;
+        }
+        for (const std::string& part : parts) {
+            std::error_code ec;
+            std::filesystem::remove(part, ec);
+        }
+        Log(index, "joined " + std::to_string(parts.size()) + " segments -> " + m_jobs[index].output.outputPath);
+    };
+
+    // The worker finishing a job's last segment joins them, unless one failed
+    std::vector<std::atomic<int>>  segmentsLeft(m_jobs.size());
+    std::vector<std::atomic<bool>> segmentFailed(m_jobs.size());
+    for (size_t i = 0; i < m_jobs.size(); ++i) segmentsLeft[i] = static_cast<int>(plans[i].size());
+    const bool joinAfter = (chunk <= 0 && !joinOnly);
+
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t t = next++; t < tasks.size(); t = next++) {
+            const Task& task = tasks[t];
+            const std::string label = (task.segment >= 0)
+                ? "segment " + std::to_string(task.segment + 1) + "/" + std::to_string(plans[task.job].size()) + " "
+                : std::string();
+            std::string error;
+            const auto start = std::chrono::steady_clock::now();
+            const bool ok = RunTask(task, error);
+            if (ok) {
+                char message[64];
+                std::snprintf(message, sizeof(message), "done in %.1f s",
+                              std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                Log(task.job, label + message);
+            } else {
+                Log(task.job, label + "FAILED: " + error);
+                ++failed;
+            }
+            if (task.segment < 0) continue;
+            if (!ok) segmentFailed[task.job] = true;
+            if (--segmentsLeft[task.job] == 0 && joinAfter && !segmentFailed[task.job]) join(task.job);
+        }
+    };
+
+    concurrency = std::clamp<int>(concurrency, 1, static_cast<int>(std::max<size_t>(tasks.size(), 1)));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < concurrency; ++i) threads.emplace_back(worker);
+    for (auto& thread : threads) thread.join();
+
+    if (joinOnly) {
+        for (size_t i = 0; i < m_jobs.size(); ++i) {
+            if (plans[i].front().segment >= 0) join(i);
+        }
+    }
+    return failed.load();
+}
+
+std::vector<BatchRenderer::Task> BatchRenderer::PlanJob(size_t index) {
+    const BatchJob& job = m_jobs[index];
+    Task whole;
+    whole.job        = index;
+    whole.outputPath = job.output.outputPath;
+    if (job.chunks <= 1) return {whole};
+    if (ImageSequenceWriter::IsImageSequencePath(job.output.outputPath)) {
+        Log(index, "image sequence output can't be joined; rendering it whole");
+        return {whole};
+    }
+
+    // A file that won't load fails in RunTask with its error
+    ShaderPreset preset;
+    if (!ShaderManager::LoadShaderMetadataFromFile(job.preset.filepath, preset)) return {whole};
+    if (CarriesState(preset)) {
+        Log(index, "preset carries state from frame to frame; rendering it whole");
+        return {whole};
+    }
+
+    // First frame of each segment: keyframes for video, so no segment decodes
+    // frames before its own
+    std::vector<int64_t> starts = {0};
+    int64_t total = 0;
+    if (job.input.empty()) {
+        const double fps = (job.output.fps > 0) ? job.output.fps : 60.0;
+        total = static_cast<int64_t>(std::llround(job.duration * fps));
+        for (int k = 1; k < job.chunks; ++k) {
+            const int64_t start = total * k / job.chunks;
+            if (start > starts.back()) starts.push_back(start);
+        }
+    } else {
+        // Software decoder: only the seek index is needed, which is demuxed on
+        // its own thread and cached in seek_cache/ for the segments' decoders
+        VideoDecoder decoder;
+        if (!decoder.Open(job.input)) return {whole};
+        const SeekIndex& seekIndex = decoder.GetSeekIndex();
+        while (!seekIndex.IsReady() && seekIndex.IsBuilding()) std::this_thread::sleep_for(INDEX_POLL_INTERVAL);
+        if (!seekIndex.IsReady() && !decoder.IsIntraOnly()) {
+            Log(index, "no keyframe index for the input; rendering it whole");
+            return {whole};
+        }
+        total = decoder.GetTotalFrames();
+        for (int k = 1; k < job.chunks; ++k) {
+            const int64_t start = decoder.GetKeyframeBefore(total * k / job.chunks);
+            if (start > starts.back()) starts.push_back(start);
+        }
+    }
+    if (starts.size() < 2) {
+        Log(index, "too short or too few keyframes to split; rendering it whole");
+        return {whole};
+    }
+
+    const std::filesystem::path output(job.output.outputPath);
+    std::vector<Task> tasks;
+    for (size_t k = 0; k < starts.size(); ++k) {
+        Task task;
+        task.job        = index;
+        task.segment    = static_cast<int>(k);
+        task.firstFrame = starts[k];
+        task.frameCount = (k + 1 < starts.size()) ? starts[k + 1] - starts[k] : -1;
+        std::filesystem::path part = output;
+        part.replace_filename(output.stem().string() + ".part" + std::to_string(k + 1) + output.extension().string());
+        task.outputPath = part.string();
+        tasks.push_back(std::move(task));
+    }
+    Log(index, "split into " + std::to_string(tasks.size()) + " segments of " + std::to_string(total) + " frames");
+    return tasks;
+}
+
+bool BatchRenderer::RunTask(const Task& task, std::string& error) {
+    const size_t index = task.job;
+    const BatchJob& job = m_jobs[index];
+    std::string range;
+    if (task.segment >= 0) {
+        range = " [frame " + std::to_string(task.firstFrame) +
+                (task.frameCount >= 0 ? ", " + std::to_string(task.frameCount) + " frames]" : ", to the end]");
+    }
+    Log(index, (job.input.empty() ? std::string("generative") : job.input) + range + " x " +
+               job.preset.filepath + " -> " + task.outputPath);
+
+    D3D11Renderer renderer;
+    renderer.SetSharedShaderCache(m_sharedShaderCache);
+    if (!renderer.Initialize(nullptr, HEADLESS_TARGET_SIZE, HEADLESS_TARGET_SIZE)) {
+        error = "Failed to create a D3D11 device";
+        return false;
+    }
+    const NoiseSettings noise;
+    renderer.UpdateNoiseTexture(noise.scale, noise.textureSize, noise.volumeSize);
+    renderer.SetGenerativeResolution(job.width, job.height);
+
+    // Shader with the job's values and keyframes, compiled once
+    ShaderManager shaders(renderer);
+    ShaderPreset loaded;
+    if (!shaders.LoadShaderMetadataFromFile(job.preset.filepath, loaded)) {
+        error = loaded.compileError;
+        return false;
+    }
+    ShaderManager::RestoreSavedValues(loaded, job.preset);
+    loaded.blendMode   = job.preset.blendMode;
+    loaded.blendAmount = job.preset.blendAmount;
+    const int presetIndex = shaders.AddPreset(loaded);
+    shaders.SetActivePreset(presetIndex);
+    ShaderPreset& preset = *shaders.GetActivePreset();
+    if (!preset.isValid) {
+        error = "Shader failed to compile: " + preset.compileError;
+        return false;
+    }
+
+    const bool video = !job.input.empty();
+    VideoDecoder decoder;
+    DecodeWorker worker{decoder};  // Must follow decoder (init + destroy order)
+    int width = job.width, height = job.height;
+    double fps = (job.output.fps > 0) ? job.output.fps : 60.0;
+    if (video) {
+        decoder.SetHardwareDevice(renderer.GetDevice());
+        decoder.SetGpuYuvConversion(true);
+        if (!decoder.Open(job.input)) {
+            error = "Failed to open " + job.input;
+            return false;
+        }
+        width  = decoder.GetSourceWidth();
+        height = decoder.GetSourceHeight();
+        fps    = decoder.GetFPS();
+        if (task.firstFrame > 0) {
+            // A keyframe, so the seek decodes nothing before it; the index was
+            // cached by PlanJob
+            while (!decoder.GetSeekIndex().IsReady() && decoder.GetSeekIndex().IsBuilding())
+                std::this_thread::sleep_for(INDEX_POLL_INTERVAL);
+            if (!decoder.SeekToFrame(task.firstFrame)) {
+                error = "Failed to seek to frame " + std::to_string(task.firstFrame);
+                return false;
+            }
+        }
+    }
+
+    VideoEncoder encoder;
+    encoder.SetHardwareDevice(renderer.GetDevice());
+    RecordingSettings settings = job.output;
+    settings.outputPath     = task.outputPath;
+    settings.dropWhenBehind = false;
+    settings.replaySeconds  = 0;
+    if (!encoder.StartRecording(settings, width, height, fps)) {
+        error = "Failed to start the encoder (" + settings.codec + ")";
+        return false;
+    }
+    renderer.SetReadbackLayout(encoder.GetInputLayout());
+    renderer.SetReadbackSize(encoder.GetWidth(), encoder.GetHeight());
+
+    auto submitReadback = [&](bool wait) {
+        FrameBuffer data;
+        int w = 0, h = 0;
+        ReadbackLayout layout = ReadbackLayout::RGBA8;
+        if (!renderer.CollectReadback(encoder.GetFramePool(), data, w, h, layout, wait)) return false;
+        encoder.SubmitFrame(std::move(data), w, h, layout);
+        return true;
+    };
+
+    VideoFrame frame;
+    if (video) {
+        decoder.DecodeNextFrame(frame);
+        worker.Start();
+    }
+    int64_t total = video ? decoder.GetTotalFrames() : static_cast<int64_t>(std::llround(job.duration * fps));
+    total = (task.frameCount >= 0) ? task.frameCount : total - task.firstFrame;
+
+    auto lastReport = std::chrono::steady_clock::now();
+    float packed[16] = {};
+    ModulationMatrix modulation;  // LFO rows; audio rows see silence, as the job has no audio
+    const AudioData silence{};
+    for (int64_t n = 0;; ++n) {
+        double time = 0.0;
+        if (n >= total && task.frameCount >= 0) break;
+        if (video) {
+            // Every frame in order: wait for the worker rather than skip
+            bool popped = (n == 0);
+            while (!popped && !worker.IsEndOfStream()) {
+                popped = worker.PopFrame(frame);
+                if (!popped) std::this_thread::sleep_for(POP_RETRY_INTERVAL);
+            }
+            if (!popped || !frame.HasPixels()) break;
+            renderer.UploadVideoFrame(frame);
+            time = frame.timestamp;
+        } else {
+            if (n >= total) break;
+            time = static_cast<double>(task.firstFrame + n) / fps;
+        }
+
+        renderer.SetShaderTime(static_cast<float>(time));
+        ShaderManager::EvaluateKeyframes(preset, time);
+        ShaderManager::PackParamValues(preset, packed);
+        modulation.SetBase(packed);
+        modulation.Apply(preset, silence, time, packed);
+        renderer.SetCustomUniforms(packed, 16);
+        float extended[MAX_EXTENDED_PARAM_FLOATS];
+        renderer.SetExtendedParams(extended, ShaderManager::PackExtendedParams(preset, extended));
+        renderer.SetVideoBlend(preset.blendMode, preset.blendAmount);
+        renderer.SetAudioData(nullptr);
+
+        renderer.BeginFrame();
+        renderer.RenderToDisplay();
+        if (encoder.IsHardwareEncoding()) {
+            encoder.SubmitHardwareFrame([&](ID3D11Texture2D* surface, int slice) {
+                return renderer.ConvertToNv12(surface, slice);
+            });
+        } else {
+            if (renderer.IsReadbackRingFull()) submitReadback(true);
+            renderer.QueueReadback();
+        }
+        while (submitReadback(false)) {}
+
+        const auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - lastReport).count() >= PROGRESS_INTERVAL) {
+            lastReport = now;
+            char message[96];
+            std::snprintf(message, sizeof(message), "frame %lld / %lld, encoding %.1f fps",
+                          static_cast<long long>(n + 1), static_cast<long long>(total), encoder.GetEncodingFPS());
+            Log(index, message);
+        }
+    }
+
+    while (submitReadback(true)) {}
+    encoder.StopRecording();
+    encoder.WaitUntilFinished();
+    worker.Stop();
+
+    if (encoder.GetFramesDropped() > 0) {
+        error = std::to_string(encoder.GetFramesDropped()) + " frames dropped (no free encoder surface)";
+        return false;
+    }
+    return true;
+}
+
+/*static*/ int BatchRenderer::Precompile(const std::string& shaderDirectory) {
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(shaderDirectory, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".hlsl") files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+
+    // The pack is written when the renderer shuts down, after `shaders`
+    D3D11Renderer renderer;
+    if (!renderer.Initialize(nullptr, HEADLESS_TARGET_SIZE, HEADLESS_TARGET_SIZE)) {
+        std::printf("No D3D11 device; shaders not precompiled\n");
+        return 0;
+    }
+    ShaderManager shaders(renderer);
+    shaders.SetIncludeDirectory(shaderDirectory);
+
+    int failed = 0;
+    for (const std::string& file : files) {
+        ShaderPreset preset;
+        if (!ShaderManager::LoadShaderMetadataFromFile(file, preset)) continue;
+        const int index = shaders.AddPreset(preset);  // Compiled here, synchronously
+        if (!shaders.GetPreset(index)->isValid) {
+            std::fprintf(stderr, "%s: %s\n", file.c_str(), shaders.GetPreset(index)->compileError.c_str());
+            ++failed;
+            continue;
+        }
+        // The variant the app compiles for the default values when the preset goes live
+        shaders.SetActivePreset(index);
+        shaders.UpdateSpecialization();
+        while (shaders.GetPendingCompileCount() > 0) {
+            shaders.PollCompiles();
+            std::this_thread::sleep_for(POP_RETRY_INTERVAL);
+        }
+    }
+    std::printf("%zu shader(s) precompiled, %d failed\n", files.size() - failed, failed);
+    return failed;
+}
+
+/*static*/ bool BatchRenderer::JoinSegments(const std::vector<std::string>& parts, const std::string& output,
+                                            std::string& error) {
+    AVFormatContext* outCtx = nullptr;
+    if (avformat_alloc_output_context2(&outCtx, nullptr, nullptr, output.c_str()) < 0 || !outCtx) {
+        error = "Unsupported output container: " + output;
+        return false;
+    }
+
+    // Each part starts at 0: it is shifted to where the previous one ended.
+    // Encoders with B-frames start at a negative DTS, which can overlap the
+    // previous part's last packets; those are nudged past it, as ffmpeg does.
+    std::vector<int64_t> lastDts;
+    int64_t offset = 0;  // AV_TIME_BASE units
+    bool ok = true, opened = false;
+    for (size_t p = 0; p < parts.size() && ok; ++p) {
+        AVFormatContext* inCtx = nullptr;
+        if (avformat_open_input(&inCtx, parts[p].c_str(), nullptr, nullptr) < 0 ||
+            avformat_find_stream_info(inCtx, nullptr) < 0) {
+            error = "Failed to open " + parts[p];
+            avformat_close_input(&inCtx);
+            ok = false;
+            break;
+        }
+
+        if (p == 0) {
+            for (unsigned i = 0; i < inCtx->nb_streams && ok; ++i) {
+                AVStream* stream = avformat_new_stream(outCtx, nullptr);
+                ok = stream && avcodec_parameters_copy(stream->codecpar, inCtx->streams[i]->codecpar) >= 0;
+                if (ok) {
+                    stream->codecpar->codec_tag = 0;  // Let the muxer pick its own tag
+                    stream->time_base = inCtx->streams[i]->time_base;
+                }
+            }
+            lastDts.assign(outCtx->nb_streams, AV_NOPTS_VALUE);
+            ok = ok && ((outCtx->oformat->flags & AVFMT_NOFILE) ||
+                        avio_open(&outCtx->pb, output.c_str(), AVIO_FLAG_WRITE) >= 0);
+            opened = ok && !(outCtx->oformat->flags & AVFMT_NOFILE);
+            ok = ok && avformat_write_header(outCtx, nullptr) >= 0;
+            if (!ok) error = "Failed to write " + output;
+        } else if (inCtx->nb_streams != outCtx->nb_streams) {
+            error = parts[p] + " has different streams from " + parts[0];
+            ok = false;
+        } else {
+            for (unsigned i = 0; i < inCtx->nb_streams && ok; ++i) {
+                const AVCodecParameters* a = inCtx->streams[i]->codecpar;
+                const AVCodecParameters* b = outCtx->streams[i]->codecpar;
+                if (a->codec_id != b->codec_id || a->width != b->width || a->height != b->height) {
+                    error = parts[p] + " was encoded differently from " + parts[0];
+                    ok = false;
+                }
+            }
+        }
+
+        int64_t end = offset;
+        AVPacket* packet = av_packet_alloc();
+        while (ok && av_read_frame(inCtx, packet) >= 0) {
+            const AVRational inBase = inCtx->streams[packet->stream_index]->time_base;
+            AVStream* outStream = outCtx->streams[packet->stream_index];
+            const int64_t shift = av_rescale_q(offset, AV_TIME_BASE_Q, inBase);
+            if (packet->pts != AV_NOPTS_VALUE) {
+                packet->pts += shift;
+                end = std::max(end, av_rescale_q(packet->pts + packet->duration, inBase, AV_TIME_BASE_Q));
+            }
+            if (packet->dts != AV_NOPTS_VALUE) packet->dts += shift;
+            av_packet_rescale_ts(packet, inBase, outStream->time_base);
+
+            int64_t& last = lastDts[packet->stream_index];
+            if (packet->dts != AV_NOPTS_VALUE && last != AV_NOPTS_VALUE && packet->dts <= last) {
+                packet->dts = last + 1;
+                if (packet->pts != AV_NOPTS_VALUE && packet->pts < packet->dts) packet->pts = packet->dts;
+            }
+            if (packet->dts != AV_NOPTS_VALUE) last = packet->dts;
+
+            packet->pos = -1;
+            if (av_interleaved_write_frame(outCtx, packet) < 0) {
+                error = "Failed to write " + output;
+                ok = false;
+            }
+            av_packet_unref(packet);
+        }
+        av_packet_free(&packet);
+        avformat_close_input(&inCtx);
+        offset = end;
+    }
+
+    if (ok && av_write_trailer(outCtx) < 0) {
+        error = "Failed to finish " + output;
+        ok = false;
+    }
+    if (opened) avio_closep(&outCtx->pb);
+    avformat_free_context(outCtx);
+    return ok;
+}
+
+void BatchRenderer::Log(size_t index, const std::string& message) {
+    std::lock_guard<std::mutex> lock(m_logMutex);
+    std::printf("[job %zu/%zu] %s\n", index + 1, m_jobs.size(), message.c_str());
+    std::fflush(stdout);
+}
+
+} // namespace SP
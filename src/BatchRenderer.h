@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// One clip x shader render of a batch job file
+struct BatchJob {
+    std::string       input;   // Video file; empty = render the shader as generative
+    ShaderPreset      preset;  // filepath, paramValues, keyframes, blend (config.json format)
+    RecordingSettings output;  // outputPath, codec, bitrate, ... (config.json format)
+    double duration = 10.0;    // Generative only: seconds rendered
+    int    width    = 1920;    // Generative only
+    int    height   = 1080;
+    int    chunks   = 0;       // > 1: rendered as this many segments at once, then joined
+};
+
+// Headless renderer behind ShaderPlayerCLI. Each job runs on its own thread with
+// its own D3D11 device (no window or swap chain), ShaderManager, VideoDecoder and
+// VideoEncoder, exactly like an offline export: every source frame in order, or
+// exact 1/fps steps for generative jobs, and an encoder that blocks instead of
+// dropping. Jobs share nothing, so several of them keep the GPU and the
+// encoders busy at once.
+//
+// A job with "chunks" is split over time into segments that are rendered like
+// separate jobs into <output>.partN<ext>, then joined into the output by stream
+// copy. Video segments start on keyframes (from the seek index), so each worker
+// seeks straight to its first frame. Presets that carry state from frame to
+// frame (persistent passes or compute buffers, frame history) can't be split
+// and render whole. On a farm, each node renders one segment (`chunk`) into
+// shared storage and a last run joins them (`joinOnly`); the split depends only
+// on the files, so every node computes the same one.
+class BatchRenderer {
+public:
+    BatchRenderer() = default;
+
+    // Non-copyable
+    BatchRenderer(const BatchRenderer&) = delete;
+    BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+    // {"jobs": [{...}, ...], "concurrency": N}. Relative paths in a job are
+    // relative to the job file. False with `error` set on a malformed file.
+    bool LoadJobs(const std::string& path, std::string& error);
+    size_t GetJobCount() const { return m_jobs.size(); }
+    int    GetConcurrency() const { return m_concurrency; }  // From the file; 0 = unset
+    // Shared bytecode cache directory: the file's "sharedShaderCache", which
+    // SetSharedShaderCache (--shared-cache) overrides
+    void SetSharedShaderCache(const std::string& directory) { m_sharedShaderCache = directory; }
+
+    // Runs every job, `concurrency` at a time, logging to stdout. Returns the
+    // number that failed. `chunk` > 0 renders only that segment (1-based) of
+    // each chunked job; `joinOnly` only joins the segments already rendered.
+    int Run(int concurrency, int chunk = 0, bool joinOnly = false);
+
+    // Build step: compiles every .hlsl in `shaderDirectory`, with the variant
+    // for its default SPECIALIZE values, into shader_cache/shaders.pack next to
+    // the exe, under the keys the app looks up. Returns the number that failed
+    // to compile; no D3D11 device is reported and skipped, not failed.
+    static int Precompile(const std::string& shaderDirectory);
+
+private:
+    // A frame range of a job, rendered into its own file
+    struct Task {
+        size_t  job        = 0;
+        int     segment    = -1;  // -1: the whole job
+        int64_t firstFrame = 0;
+        int64_t frameCount = -1;  // -1: to the end of the input
+        std::string outputPath;
+    };
+
+    // The job as segments, or one whole-job task when it can't be split
+    std::vector<Task> PlanJob(size_t index);
+    bool RunTask(const Task& task, std::string& error);
+    // Stream-copies `parts` one after another into `output`
+    static bool JoinSegments(const std::vector<std::string>& parts, const std::string& output, std::string& error);
+    void Log(size_t index, const std::string& message);
+
+    std::vector<BatchJob> m_jobs;
+    int m_concurrency = 0;
+    std::string m_sharedShaderCache;
+    std::mutex m_logMutex;
+};
+
+} // namespace SP
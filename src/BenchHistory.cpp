@@ -0,0 +1,280 @@
+#include "BenchHistory.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#ifndef SHADERPLAYER_VERSION
+#define SHADERPLAYER_VERSION "unknown"
+#endif
+#ifndef SHADERPLAYER_COMMIT
+#define SHADERPLAYER_COMMIT "unknown"
+#endif
+
+namespace SP {
+
+namespace {
+
+// Noise floors: a change smaller than this is never flagged, whatever its percentage
+constexpr double GPU_MS_FLOOR   = 0.02;
+constexpr double FRAME_MS_FLOOR = 0.1;
+constexpr double FPS_FLOOR      = 1.0;
+constexpr double COUNT_FLOOR    = 1.0;
+
+struct Metric {
+    std::string key;
+    double value  = 0.0;
+    bool   higher = false;  // Higher is better
+    double floor  = 0.0;
+};
+
+std::string Narrow(const wchar_t* text) {
+    const int size = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    if (size <= 1) return {};
+    std::string out(static_cast<size_t>(size - 1), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, out.data(), size, nullptr, nullptr);
+    return out;
+}
+
+void Cpuid(int out[4], int leaf) {
+#if defined(_MSC_VER)
+    __cpuid(out, leaf);
+#else
+    unsigned a = 0, b = 0, c = 0, d = 0;
+    __cpuid(leaf, a, b, c, d);
+    out[0] = static_cast<int>(a); out[1] = static_cast<int>(b);
+    out[2] = static_cast<int>(c); out[3] = static_cast<int>(d);
+#endif
+}
+
+std::string CpuName() {
+    int regs[4] = {};
+    Cpuid(regs, static_cast<int>(0x80000000));
+    if (static_cast<unsigned>(regs[0]) < 0x80000004) return {};
+    char brand[49] = {};
+    for (int i = 0; i < 3; ++i) {
+        Cpuid(regs, static_cast<int>(0x80000002 + i));
+        std::memcpy(brand + i * 16, regs, 16);
+    }
+    std::string name(brand);
+    name.erase(0, name.find_first_not_of(' '));
+    return name;
+}
+
+// "Windows 23H2 (build 22631.4317)": the registry, since GetVersionEx reports
+// whatever the manifest claims
+std::string OsName() {
+    constexpr const wchar_t* KEY = L"SOFTWARE\\Microsoft\\Windows NT\\CurrentVersion";
+    wchar_t text[64] = {};
+    DWORD size = sizeof(text);
+    std::string build = RegGetValueW(HKEY_LOCAL_MACHINE, KEY, L"CurrentBuildNumber", RRF_RT_REG_SZ, nullptr, text,
+                                     &size) == ERROR_SUCCESS ? Narrow(text) : std::string("?");
+    DWORD ubr = 0;
+    size = sizeof(ubr);
+    if (RegGetValueW(HKEY_LOCAL_MACHINE, KEY, L"UBR", RRF_RT_REG_DWORD, nullptr, &ubr, &size) == ERROR_SUCCESS)
+        build += "." + std::to_string(ubr);
+    size = sizeof(text);
+    const std::string release = RegGetValueW(HKEY_LOCAL_MACHINE, KEY, L"DisplayVersion", RRF_RT_REG_SZ, nullptr, text,
+                                             &size) == ERROR_SUCCESS ? Narrow(text) + " " : std::string();
+    return "Windows " + release + "(build " + build + ")";
+}
+
+// The named adapter (else the first) and its user-mode driver version
+void DescribeAdapter(const std::string& wanted, std::string& outName, std::string& outDriver) {
+    ComPtr<IDXGIFactory1> factory;
+    if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory)))) return;
+    ComPtr<IDXGIAdapter1> adapter;
+    for (UINT i = 0; factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; ++i) {
+        DXGI_ADAPTER_DESC1 desc = {};
+        adapter->GetDesc1(&desc);
+        const std::string name = Narrow(desc.Description);
+        if (!wanted.empty() && name != wanted) continue;
+        outName = name;
+        LARGE_INTEGER umd = {};
+        if (SUCCEEDED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umd))) {
+            char version[32];
+            std::snprintf(version, sizeof(version), "%u.%u.%u.%u",
+                          HIWORD(umd.HighPart), LOWORD(umd.HighPart), HIWORD(umd.LowPart), LOWORD(umd.LowPart));
+            outDriver = version;
+        }
+        return;
+    }
+    if (!wanted.empty()) outName = wanted;  // Not enumerable (WARP, removed): keep the run's own name
+}
+
+double Number(const nlohmann::json& j, const char* key) {
+    return j.contains(key) && j.at(key).is_number() ? j.at(key).get<double>() : 0.0;
+}
+
+// The comparable numbers of a run, by kind
+std::vector<Metric> Metrics(const BenchHistory::Run& run) {
+    std::vector<Metric> out;
+    if (run.kind == "shader" && run.report.contains("results")) {
+        for (const auto& r : run.report.at("results")) {
+            if (!r.value("ok", false)) continue;
+            const std::string item = r.value("shader", std::string()) + " " + r.value("resolution", std::string());
+            out.push_back({item + ": GPU mean ms", Number(r, "meanMs"), false, GPU_MS_FLOOR});
+            out.push_back({item + ": GPU p99 ms", Number(r, "p99Ms"), false, GPU_MS_FLOOR});
+        }
+    } else if (run.kind == "playback" && run.report.contains("clips")) {
+        for (const auto& c : run.report.at("clips")) {
+            if (!c.value("ok", false)) continue;
+            const std::string item = std::filesystem::path(c.value("clip", std::string())).filename().string();
+            out.push_back({item + ": frame p50 ms", Number(c, "p50FrameMs"), false, FRAME_MS_FLOOR});
+            out.push_back({item + ": frame p95 ms", Number(c, "p95FrameMs"), false, FRAME_MS_FLOOR});
+            out.push_back({item + ": frame p99 ms", Number(c, "p99FrameMs"), false, FRAME_MS_FLOOR});
+            out.push_back({item + ": dropped frames", Number(c, "droppedFrames"), false, COUNT_FLOOR});
+            out.push_back({item + ": shader GPU ms", Number(c, "avgShaderGpuMs"), false, GPU_MS_FLOOR});
+            // Throughput of one decode thread, from the time per frame
+            if (const double decodeMs = Number(c, "avgDecodeMs"); decodeMs > 0.0)
+                out.push_back({item + ": decode fps", 1000.0 / decodeMs, true, FPS_FLOOR});
+            if (c.contains("encodeFps"))
+                out.push_back({item + ": encode fps", Number(c, "encodeFps"), true, FPS_FLOOR});
+        }
+    }
+    return out;
+}
+
+bool IsIndex(const std::string& text) {
+    const size_t digits = (!text.empty() && text[0] == '-') ? 1 : 0;
+    return text.size() > digits && std::all_of(text.begin() + digits, text.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+} // namespace
+
+nlohmann::json BenchHistory::DescribeBuild() {
+#if defined(__clang__)
+    const std::string compiler = "clang " __clang_version__;
+#elif defined(_MSC_VER)
+    const std::string compiler = "MSVC " + std::to_string(_MSC_FULL_VER);
+#else
+    const std::string compiler = "unknown";
+#endif
+#ifdef NDEBUG
+    const char* config = "Release";
+#else
+    const char* config = "Debug";
+#endif
+    return {{"version", SHADERPLAYER_VERSION}, {"commit", SHADERPLAYER_COMMIT}, {"compiler", compiler},
+            {"config", config}};
+}
+
+nlohmann::json BenchHistory::DescribeMachine(const std::string& gpu) {
+    wchar_t computer[MAX_COMPUTERNAME_LENGTH + 1] = {};
+    DWORD computerLength = MAX_COMPUTERNAME_LENGTH + 1;
+    GetComputerNameW(computer, &computerLength);
+    MEMORYSTATUSEX memory = {};
+    memory.dwLength = sizeof(memory);
+    GlobalMemoryStatusEx(&memory);
+    std::string adapter, driver;
+    DescribeAdapter(gpu, adapter, driver);
+    return {{"computer", Narrow(computer)}, {"cpu", CpuName()}, {"cores", std::thread::hardware_concurrency()},
+            {"memoryMB", memory.ullTotalPhys >> 20}, {"os", OsName()}, {"gpu", adapter}, {"driver", driver}};
+}
+
+bool BenchHistory::Append(const std::string& path, const std::string& kind, const std::string& label,
+                          const nlohmann::json& machine, const nlohmann::json& report, std::string& error) {
+    const std::time_t now = std::time(nullptr);
+    std::tm utc = {};
+    gmtime_s(&utc, &now);
+    char time[32];
+    std::strftime(time, sizeof(time), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+    const nlohmann::json run = {{"kind", kind}, {"time", time}, {"label", label}, {"build", DescribeBuild()},
+                                {"machine", machine}, {"report", report}};
+    // One write of the whole line, so concurrent runs never interleave within one
+    const std::string line = run.dump() + "\n";
+    std::ofstream file(path, std::ios::app | std::ios::binary);
+    file.write(line.data(), static_cast<std::streamsize>(line.size()));
+    if (!file) {
+        error = "Failed to append to " + path;
+        return false;
+    }
+    return true;
+}
+
+bool BenchHistory::Load(const std::string& path, std::string& error) {
+    m_runs.clear();
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "Failed to open " + path;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        const nlohmann::json j = nlohmann::json::parse(line, nullptr, false);
+        if (j.is_discarded() || !j.is_object() || !j.contains("report")) continue;
+        Run run;
+        run.kind    = j.value("kind", std::string());
+        run.time    = j.value("time", std::string());
+        run.label   = j.value("label", std::string());
+        run.build   = j.value("build", nlohmann::json::object());
+        run.machine = j.value("machine", nlohmann::json::object());
+        run.report  = j.at("report");
+        m_runs.push_back(std::move(run));
+    }
+    return true;
+}
+
+int BenchHistory::Find(const std::string& selector) const {
+    const int count = static_cast<int>(m_runs.size());
+    if (IsIndex(selector)) {
+        const int index = std::atoi(selector.c_str());
+        const int resolved = index < 0 ? count + index : index;
+        return resolved >= 0 && resolved < count ? resolved : -1;
+    }
+    for (int i = count - 1; i >= 0; --i) {
+        if (m_runs[i].label == selector) return i;
+    }
+    return -1;
+}
+
+int BenchHistory::FindBaseline(int run) const {
+    if (run < 0 || run >= static_cast<int>(m_runs.size())) return -1;
+    const Run& current = m_runs[run];
+    auto machineKey = [](const Run& r) {
+        return r.machine.value("computer", std::string()) + "|" + r.machine.value("gpu", std::string());
+    };
+    int anywhere = -1;
+    for (int i = run - 1; i >= 0; --i) {
+        if (m_runs[i].kind != current.kind) continue;
+        if (machineKey(m_runs[i]) == machineKey(current)) return i;
+        if (anywhere < 0) anywhere = i;
+    }
+    return anywhere;
+}
+
+std::vector<BenchHistory::Delta> BenchHistory::Compare(const Run& baseline, const Run& current,
+                                                       double thresholdPercent) {
+    std::unordered_map<std::string, double> before;
+    for (const Metric& metric : Metrics(baseline)) before[metric.key] = metric.value;
+
+    std::vector<Delta> out;
+    for (const Metric& metric : Metrics(current)) {
+        const auto it = before.find(metric.key);
+        if (it == before.end()) continue;
+        Delta delta;
+        delta.key      = metric.key;
+        delta.baseline = it->second;
+        delta.current  = metric.value;
+        const double worse = metric.higher ? delta.baseline - delta.current : delta.current - delta.baseline;
+        delta.percent = delta.baseline > 0.0 ? worse / delta.baseline * 100.0 : 0.0;
+        // From zero (dropped frames) any change past the floor counts
+        const bool beyond = delta.baseline > 0.0 ? std::abs(delta.percent) > thresholdPercent : true;
+        delta.regression  = worse > metric.floor && beyond;
+        delta.improvement = -worse > metric.floor && beyond;
+        out.push_back(std::move(delta));
+    }
+    return out;
+}
+
+} // namespace SP
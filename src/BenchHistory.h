@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Common.h"
+#include <nlohmann/json.hpp>
+
+namespace SP {
+
+// Results store for ShaderPlayerBench (--history) and the playback benchmark
+// ("history" in its file): a JSON Lines file every run appends one line to,
+// holding the run's own report plus when, which build and which machine.
+// ShaderPlayerBenchReport reads it back and compares a run with a baseline, so
+// the effect of a change (or a driver update) shows up as per-shader GPU ms,
+// decode and encode throughput and frame time percentiles, with regressions
+// over a threshold flagged.
+//
+//   {"kind": "shader", "time": "2026-01-01T12:00:00Z", "label": "...",
+//    "build": {"version", "commit", "compiler", "config"},
+//    "machine": {"computer", "cpu", "cores", "memoryMB", "os", "gpu", "driver"},
+//    "report": {...}}
+//
+// Lines that fail to parse are skipped on load, so a run killed mid-write costs
+// only itself.
+class BenchHistory {
+public:
+    struct Run {
+        std::string kind;   // "shader" or "playback"
+        std::string time;   // UTC, ISO 8601
+        std::string label;  // --label / "label": free text naming the change under test
+        nlohmann::json build;
+        nlohmann::json machine;
+        nlohmann::json report;
+    };
+
+    // One compared number. Keys are "<item>: <metric>", e.g. "plasma.hlsl 4K: mean ms".
+    struct Delta {
+        std::string key;
+        double baseline = 0.0;
+        double current  = 0.0;
+        double percent  = 0.0;  // Signed change; positive = worse
+        bool   regression  = false;
+        bool   improvement = false;
+    };
+
+    // This build and the machine it runs on. `gpu` names the adapter the run
+    // used (its driver version is looked up); empty = the first DXGI adapter.
+    static nlohmann::json DescribeBuild();
+    static nlohmann::json DescribeMachine(const std::string& gpu = {});
+
+    // Appends one run. False with `error` set when the file can't be written.
+    static bool Append(const std::string& path, const std::string& kind, const std::string& label,
+                       const nlohmann::json& machine, const nlohmann::json& report, std::string& error);
+
+    bool Load(const std::string& path, std::string& error);
+    const std::vector<Run>& GetRuns() const { return m_runs; }
+
+    // Index of a run: a non-negative index, a negative one counting from the
+    // end (-1 = newest) or the newest run with that label. -1 when none.
+    int Find(const std::string& selector) const;
+    // The newest run of the same kind before `run` on the same computer and
+    // GPU, else of the same kind anywhere; -1 when none
+    int FindBaseline(int run) const;
+
+    // Every metric both runs have. Worse by more than `thresholdPercent` (and
+    // by more than the metric's noise floor) is a regression.
+    static std::vector<Delta> Compare(const Run& baseline, const Run& current, double thresholdPercent);
+
+private:
+    std::vector<Run> m_runs;  // File order: oldest first
+};
+
+} // namespace SP
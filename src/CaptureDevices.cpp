@@ -0,0 +1,198 @@
+#include "CaptureDevices.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <dshow.h>
+#include <dvdmedia.h>  // VIDEOINFOHEADER2
+#pragma comment(lib, "strmiids.lib")
+
+namespace SP {
+
+namespace {
+
+// Slower modes are only chosen when a device has nothing faster
+constexpr double MIN_PLAYABLE_FPS = 24.0;
+
+// FOURCC subtypes share the {XXXXXXXX-0000-0010-8000-00AA00389B71} form, so
+// Data1 names the format without needing every MEDIASUBTYPE_ in the SDK
+struct SubtypeFormat {
+    DWORD       fourcc;
+    const char* pixelFormat;  // dshow pixel_format, or null for vcodec
+    const char* codec;
+    const char* name;
+    int         rank;         // Lower = preferred at equal size and rate
+};
+
+constexpr SubtypeFormat SUBTYPE_FORMATS[] = {
+    { MAKEFOURCC('N', 'V', '1', '2'), "nv12",    nullptr, "NV12",  0 },
+    { MAKEFOURCC('Y', 'U', 'Y', '2'), "yuyv422", nullptr, "YUY2",  1 },
+    { MAKEFOURCC('U', 'Y', 'V', 'Y'), "uyvy422", nullptr, "UYVY",  1 },
+    { MAKEFOURCC('I', '4', '2', '0'), "yuv420p", nullptr, "I420",  2 },
+    { MAKEFOURCC('M', 'J', 'P', 'G'), nullptr,   "mjpeg", "MJPEG", 3 },
+};
+
+const SubtypeFormat* FindSubtype(const GUID& subtype) {
+    for (const SubtypeFormat& format : SUBTYPE_FORMATS) {
+        if (subtype.Data1 == format.fourcc) return &format;
+    }
+    return nullptr;
+}
+
+int RankOf(const CaptureMode& mode) {
+    for (const SubtypeFormat& format : SUBTYPE_FORMATS) {
+        if (format.pixelFormat ? mode.pixelFormat == format.pixelFormat : mode.codec == format.codec)
+            return format.rank;
+    }
+    return 4;
+}
+
+std::string ToUtf8(const wchar_t* text) {
+    const int len = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    if (len <= 0) return {};
+    std::string out(len - 1, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, out.data(), len, nullptr, nullptr);
+    return out;
+}
+
+std::string FriendlyName(IMoniker* moniker) {
+    std::string name;
+    ComPtr<IPropertyBag> propBag;
+    if (SUCCEEDED(moniker->BindToStorage(nullptr, nullptr, IID_PPV_ARGS(&propBag)))) {
+        VARIANT var;
+        VariantInit(&var);
+        if (SUCCEEDED(propBag->Read(L"FriendlyName", &var, nullptr)) && var.vt == VT_BSTR)
+            name = ToUtf8(var.bstrVal);
+        VariantClear(&var);
+    }
+    return name;
+}
+
+ComPtr<IEnumMoniker> EnumerateVideoInputs() {
+    ComPtr<ICreateDevEnum> devEnum;
+    ComPtr<IEnumMoniker> enumMon;
+    if (FAILED(CoCreateInstance(CLSID_SystemDeviceEnum, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&devEnum))) ||
+        devEnum->CreateClassEnumerator(CLSID_VideoInputDeviceCategory, &enumMon, 0) != S_OK) {
+        return nullptr;
+    }
+    return enumMon;
+}
+
+// The output pin in PIN_CATEGORY_CAPTURE (a preview pin offers the same modes
+// on some drivers and fewer on others)
+ComPtr<IAMStreamConfig> FindCaptureConfig(IBaseFilter* filter) {
+    ComPtr<IEnumPins> pins;
+    if (FAILED(filter->EnumPins(&pins))) return nullptr;
+    ComPtr<IPin> pin;
+    while (pins->Next(1, &pin, nullptr) == S_OK) {
+        PIN_DIRECTION direction;
+        ComPtr<IKsPropertySet> props;
+        GUID category = GUID_NULL;
+        DWORD returned = 0;
+        if (SUCCEEDED(pin->QueryDirection(&direction)) && direction == PINDIR_OUTPUT &&
+            SUCCEEDED(pin.As(&props)) &&
+            SUCCEEDED(props->Get(AMPROPSETID_Pin, AMPROPERTY_PIN_CATEGORY, nullptr, 0,
+                                 &category, sizeof(category), &returned)) &&
+            category == PIN_CATEGORY_CAPTURE) {
+            ComPtr<IAMStreamConfig> config;
+            if (SUCCEEDED(pin.As(&config))) return config;
+        }
+        pin.Reset();
+    }
+    return nullptr;
+}
+
+void FreeMediaType(AM_MEDIA_TYPE* type) {
+    if (!type) return;
+    if (type->cbFormat != 0) CoTaskMemFree(type->pbFormat);
+    if (type->pUnk) type->pUnk->Release();
+    CoTaskMemFree(type);
+}
+
+} // namespace
+
+std::vector<std::string> CaptureDevices::Enumerate() {
+    std::vector<std::string> devices;
+    ComPtr<IEnumMoniker> enumMon = EnumerateVideoInputs();
+    if (!enumMon) return devices;
+
+    ComPtr<IMoniker> moniker;
+    while (enumMon->Next(1, &moniker, nullptr) == S_OK) {
+        std::string name = FriendlyName(moniker.Get());
+        if (!name.empty()) devices.push_back(std::move(name));
+        moniker.Reset();
+    }
+    return devices;
+}
+
+std::vector<CaptureMode> CaptureDevices::EnumerateModes(const std::string& deviceName) {
+    std::vector<CaptureMode> modes;
+    ComPtr<IEnumMoniker> enumMon = EnumerateVideoInputs();
+    if (!enumMon) return modes;
+
+    ComPtr<IBaseFilter> filter;
+    ComPtr<IMoniker> moniker;
+    while (!filter && enumMon->Next(1, &moniker, nullptr) == S_OK) {
+        if (FriendlyName(moniker.Get()) == deviceName)
+            moniker->BindToObject(nullptr, nullptr, IID_PPV_ARGS(&filter));
+        moniker.Reset();
+    }
+    ComPtr<IAMStreamConfig> config = filter ? FindCaptureConfig(filter.Get()) : nullptr;
+    int count = 0, size = 0;
+    if (!config || FAILED(config->GetNumberOfCapabilities(&count, &size)) ||
+        size != sizeof(VIDEO_STREAM_CONFIG_CAPS)) {
+        return modes;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        AM_MEDIA_TYPE* type = nullptr;
+        VIDEO_STREAM_CONFIG_CAPS caps = {};
+        if (FAILED(config->GetStreamCaps(i, &type, reinterpret_cast<BYTE*>(&caps))) || !type) continue;
+
+        const SubtypeFormat* format = FindSubtype(type->subtype);
+        const BITMAPINFOHEADER* header = nullptr;
+        if (type->formattype == FORMAT_VideoInfo && type->cbFormat >= sizeof(VIDEOINFOHEADER))
+            header = &reinterpret_cast<const VIDEOINFOHEADER*>(type->pbFormat)->bmiHeader;
+        else if (type->formattype == FORMAT_VideoInfo2 && type->cbFormat >= sizeof(VIDEOINFOHEADER2))
+            header = &reinterpret_cast<const VIDEOINFOHEADER2*>(type->pbFormat)->bmiHeader;
+
+        if (format && header && header->biWidth > 0 && caps.MinFrameInterval > 0) {
+            CaptureMode mode;
+            mode.width   = static_cast<int>(header->biWidth);
+            mode.height  = std::abs(static_cast<int>(header->biHeight));
+            mode.rateNum = 10'000'000;
+            mode.rateDen = static_cast<int>(caps.MinFrameInterval);
+            if (format->pixelFormat) mode.pixelFormat = format->pixelFormat;
+            if (format->codec)       mode.codec       = format->codec;
+            mode.fourcc  = format->fourcc;
+            char label[64];
+            snprintf(label, sizeof(label), "%dx%d %.2f fps %s", mode.width, mode.height, mode.GetFps(), format->name);
+            mode.label = label;
+            // Drivers list a mode once per frame-interval range; keep one
+            const bool duplicate = std::any_of(modes.begin(), modes.end(), [&](const CaptureMode& m) {
+                return m.width == mode.width && m.height == mode.height && m.pixelFormat == mode.pixelFormat &&
+                       m.codec == mode.codec && m.rateDen == mode.rateDen;
+            });
+            if (!duplicate) modes.push_back(std::move(mode));
+        }
+        FreeMediaType(type);
+    }
+
+    std::stable_sort(modes.begin(), modes.end(), [](const CaptureMode& a, const CaptureMode& b) {
+        const int64_t pixelsA = static_cast<int64_t>(a.width) * a.height;
+        const int64_t pixelsB = static_cast<int64_t>(b.width) * b.height;
+        if (pixelsA != pixelsB) return pixelsA > pixelsB;
+        if (a.GetFps() != b.GetFps()) return a.GetFps() > b.GetFps();
+        return RankOf(a) < RankOf(b);
+    });
+    return modes;
+}
+
+const CaptureMode* CaptureDevices::PickBest(const std::vector<CaptureMode>& modes) {
+    // Sorted by EnumerateModes: the first playable mode is the best one
+    for (const CaptureMode& mode : modes) {
+        if (mode.GetFps() >= MIN_PLAYABLE_FPS - 0.5) return &mode;
+    }
+    return modes.empty() ? nullptr : &modes.front();
+}
+
+} // namespace SP
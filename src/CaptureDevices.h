@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// DirectShow video capture devices (webcams, capture cards, virtual cameras)
+// and the modes each one offers. The modes come from IAMStreamConfig on the
+// device's capture pin, so opening a 4K60 card can ask dshow for exactly that
+// instead of a fixed 1280x720@30 and whatever format the driver defaults to.
+// Only formats the renderer converts on the GPU are listed: NV12, YUY2, UYVY,
+// I420 and MJPEG. RGB modes are skipped (sws_scale on every frame).
+// COM must be initialised on the calling thread (WinMain does).
+class CaptureDevices {
+public:
+    // Friendly names, in enumeration order
+    static std::vector<std::string> Enumerate();
+
+    // Modes of the device with this friendly name, largest first. Empty when the
+    // device is gone or exposes no IAMStreamConfig (dshow then picks).
+    static std::vector<CaptureMode> EnumerateModes(const std::string& deviceName);
+
+    // The mode to open with by default: the most pixels among modes of at least
+    // 24 fps (all modes if none is), then the highest rate, then uncompressed
+    // before MJPEG (NV12, YUY2/UYVY, I420). Null for an empty list.
+    static const CaptureMode* PickBest(const std::vector<CaptureMode>& modes);
+};
+
+} // namespace SP
@@ -0,0 +1,168 @@
+#include "ColorLut.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace SP {
+
+namespace {
+
+// Output depths a .3dl's largest value is rounded up to
+constexpr int LUT_3DL_DEPTHS[] = { 1023, 4095, 65535 };
+
+bool LoadCube(std::istream& in, ColorLut& out, std::string& error) {
+    std::string line;
+    int size = 0;
+    while (std::getline(in, line)) {
+        std::istringstream tokens(line);
+        std::string first;
+        if (!(tokens >> first) || first[0] == '#') continue;
+
+        if (first == "TITLE") {
+            const size_t open = line.find('"'), close = line.rfind('"');
+            if (open != std::string::npos && close > open) out.title = line.substr(open + 1, close - open - 1);
+        } else if (first == "LUT_3D_SIZE") {
+            tokens >> size;
+            if (size < MIN_LUT_SIZE || size > MAX_LUT_SIZE) {
+                error = "LUT_3D_SIZE out of range";
+                return false;
+            }
+            out.rgb.reserve(static_cast<size_t>(size) * size * size * 3);
+        } else if (first == "LUT_1D_SIZE") {
+            error = "1D LUTs are not supported";
+            return false;
+        } else if (first == "DOMAIN_MIN" || first == "DOMAIN_MAX" || first == "LUT_3D_INPUT_RANGE") {
+            const float expected = (first == "DOMAIN_MAX") ? 1.0f : 0.0f;
+            float v = 0.0f;
+            for (int i = 0; i < (first == "LUT_3D_INPUT_RANGE" ? 2 : 3) && (tokens >> v); ++i) {
+                const float want = (first == "LUT_3D_INPUT_RANGE") ? static_cast<float>(i) : expected;
+                if (std::abs(v - want) > 1e-4f) {
+                    error = "Only a 0..1 input domain is supported";
+                    return false;
+                }
+            }
+        } else if (std::isdigit(static_cast<unsigned char>(first[0])) || first[0] == '-' || first[0] == '.') {
+            float r = 0.0f, g = 0.0f, b = 0.0f;
+            std::istringstream red(first);
+            if (size == 0 || !(red >> r) || !(tokens >> g >> b)) {
+                error = "Data before LUT_3D_SIZE or a malformed row";
+                return false;
+            }
+            out.rgb.push_back(r);
+            out.rgb.push_back(g);
+            out.rgb.push_back(b);
+        }
+        // Other keywords (LUT_IN_VIDEO_RANGE, ...) are ignored
+    }
+    out.size = size;
+    if (!out.IsValid()) {
+        error = "Expected " + std::to_string(size) + "^3 entries";
+        return false;
+    }
+    return true;
+}
+
+bool Load3dl(std::istream& in, ColorLut& out, std::string& error) {
+    std::string line;
+    int size = 0;  // From the shaper line, when there is one
+    std::vector<int> values;
+    while (std::getline(in, line)) {
+        std::istringstream tokens(line);
+        std::vector<int> row;
+        std::string token;
+        bool numeric = true;
+        while (tokens >> token) {
+            if (token[0] == '#') break;
+            try {
+                row.push_back(std::stoi(token));
+            } catch (...) {
+                numeric = false;  // "3DMESH", "Mesh 4 12", ...
+                break;
+            }
+        }
+        if (!numeric || row.empty()) continue;
+        if (row.size() == 3) {
+            values.insert(values.end(), row.begin(), row.end());
+        } else if (row.size() > 3 && size == 0 && values.empty()) {
+            size = static_cast<int>(row.size());  // Input shaper: one entry per lattice point
+        }
+    }
+
+    const size_t entries = values.size() / 3;
+    if (size == 0) size = static_cast<int>(std::lround(std::cbrt(static_cast<double>(entries))));
+    if (size < MIN_LUT_SIZE || size > MAX_LUT_SIZE || entries != static_cast<size_t>(size) * size * size) {
+        error = "Expected a cubic number of rows";
+        return false;
+    }
+
+    int maxValue = *std::max_element(values.begin(), values.end());
+    int depth = maxValue;
+    for (int d : LUT_3DL_DEPTHS) {
+        if (maxValue <= d) {
+            depth = d;
+            break;
+        }
+    }
+    const float scale = 1.0f / static_cast<float>(std::max(depth, 1));
+
+    // Blue varies fastest in the file; reorder to red fastest
+    out.size = size;
+    out.rgb.assign(entries * 3, 0.0f);
+    size_t src = 0;
+    for (int r = 0; r < size; ++r) {
+        for (int g = 0; g < size; ++g) {
+            for (int b = 0; b < size; ++b, src += 3) {
+                const size_t dst = ((static_cast<size_t>(b) * size + g) * size + r) * 3;
+                for (int c = 0; c < 3; ++c) out.rgb[dst + c] = static_cast<float>(values[src + c]) * scale;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool LoadColorLut(const std::string& path, ColorLut& out, std::string& error) {
+    out = ColorLut{};
+    std::ifstream in(path);
+    if (!in) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    const bool ok = (ext == ".3dl") ? Load3dl(in, out, error) : LoadCube(in, out, error);
+    if (!ok) out = ColorLut{};
+    if (ok && out.title.empty()) out.title = std::filesystem::path(path).stem().string();
+    return ok;
+}
+
+bool SaveColorLut(const std::string& path, const ColorLut& lut, std::string& error) {
+    if (!lut.IsValid()) {
+        error = "Empty LUT";
+        return false;
+    }
+    std::ofstream out(path);
+    if (!out) {
+        error = "Cannot write " + path;
+        return false;
+    }
+    if (!lut.title.empty()) out << "TITLE \"" << lut.title << "\"\n";
+    out << "LUT_3D_SIZE " << lut.size << "\n";
+    char row[64];
+    for (size_t i = 0; i < lut.rgb.size(); i += 3) {
+        std::snprintf(row, sizeof(row), "%.6f %.6f %.6f\n", lut.rgb[i], lut.rgb[i + 1], lut.rgb[i + 2]);
+        out << row;
+    }
+    if (!out) {
+        error = "Write failed: " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace SP
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// A 3D colour lookup table: `size`³ RGB entries with red varying fastest, then
+// green, then blue — the .cube order, and the order of a Texture3D's rows and
+// slices, so the data uploads as is. The input domain is always [0,1].
+struct ColorLut {
+    int size = 0;
+    std::vector<float> rgb;  // size³ × 3
+    std::string title;
+
+    bool IsValid() const { return size >= 2 && rgb.size() == static_cast<size_t>(size) * size * size * 3; }
+};
+
+constexpr int MIN_LUT_SIZE = 2;
+constexpr int MAX_LUT_SIZE = 256;
+
+// Adobe/Resolve .cube (3D only; a 1D shaper or a non-unit DOMAIN is rejected) or
+// Autodesk/Lustre .3dl (integer output at the depth its largest value implies,
+// blue varying fastest). False with `error` set on failure.
+bool LoadColorLut(const std::string& path, ColorLut& out, std::string& error);
+// Writes a .cube
+bool SaveColorLut(const std::string& path, const ColorLut& lut, std::string& error);
+
+} // namespace SP
@@ -15,6 +15,7 @@
 
 #include <string>
 #include <vector>
+#include <array>
 #include <memory>
 #include <functional>
 #include <unordered_map>
@@ -56,6 +57,10 @@ struct Keyframe {
 struct KeyframeTimeline {
     bool enabled = false;
     std::vector<Keyframe> keyframes; // sorted by time
+    // Segment of the last Evaluate: playback finds it or the next one without a
+    // search. Only a hint, checked against the keyframes on every use, so
+    // editing them in place needs no invalidation.
+    mutable int cursor = 0;
 
     // Evaluate interpolated value at given time. Writes to out[0..valueCount-1].
     // Returns true if a value was written (timeline enabled and non-empty).
@@ -68,7 +73,29 @@ struct KeyframeTimeline {
     void RemoveKeyframe(int index);
 };
 
-enum class ShaderParamType { Float, Bool, Long, Color, Point2D, Event, AudioBand };
+// Modulation matrix row (ModulationMatrix.h): a source driving one component of
+// a param around the value it has from the UI or its keyframes
+enum class ModulationSource {
+    Sine, Triangle, Saw, Square, Random,                    // LFOs, over playback time
+    Rms, Bass, Mid, High, Beat, Centroid, BeatPhase, BarPhase,  // AudioData
+    Count
+};
+
+struct Modulation {
+    std::string param;              // ShaderParam::name of a Float, Point2D or Color param
+    int   component = 0;            // Into its values: x/y, r/g/b/a
+    ModulationSource source = ModulationSource::Sine;
+    float rate    = 1.0f;           // LFOs: cycles per second
+    float phase   = 0.0f;           // LFOs: offset in cycles
+    float curve   = 1.0f;           // Exponent on the source's [0,1] value: > 1 favours the low end
+    float min     = 0.0f;           // Added to the param at source 0...
+    float max     = 1.0f;           // ...and at source 1
+    float attack  = 0.0f;           // Envelope follower: seconds to rise...
+    float release = 0.0f;           // ...and to fall (0 = follows at once)
+    bool  enabled = true;
+};
+
+enum class ShaderParamType { Float, Bool, Long, Color, Point2D, Event, AudioBand, Image, Lut };
 
 struct ShaderParam {
     std::string name;               // HLSL identifier; used for #define alias
@@ -82,42 +109,245 @@ struct ShaderParam {
     float step = 0.01f;
     std::vector<std::string> longLabels; // Dropdown labels for type=Long
     std::vector<int>         longValues; // Selectable int values for type=Long (parallel to longLabels)
-    int cbufferOffset = 0;          // Float index into custom[16]; set at parse time; -1 for AudioBand
+    int cbufferOffset = 0;          // Float index into custom[16], then spParams[] from 16 (b5); set at
+                                    //   parse time; -1 for AudioBand/Image/Lut
     std::string audioBand;          // For AudioBand: "bass"|"mid"|"high"|"rms"|"beat"|"centroid"
+    int inputIndex = -1;            // For Image: extra video input, bound at t(FIRST_INPUT_SLOT + index);
+                                    //   for Lut: colour LUT, bound at t(FIRST_LUT_SLOT + index)
+    bool specialize = false;        // Bool/Long with ISF "SPECIALIZE": true — compiled into shader variants
     std::optional<KeyframeTimeline> timeline;  // nullopt until user enables keyframing
 };
 
+// Pixel format of a render pass target (ISF "FLOAT": true = RGBA32F). RG11B10F
+// is HDR colour at RGBA8's bandwidth, without alpha; R32F one full-precision
+// channel for masks, depth-like fields and single-channel simulations.
+enum class PassFormat { RGBA8, RGBA16F, RGBA32F, RG11B10F, R32F };
+constexpr int PASS_FORMAT_COUNT = 5;
+
+// One entry of an ISF `PASSES` array. The preset's shader is compiled once per
+// pass with PASSINDEX defined; a pass with a TARGET draws into a pooled
+// intermediate texture that later passes sample under that name. The last pass
+// draws to the display. A PERSISTENT pass keeps its target across frames instead:
+// it is double-buffered by the renderer, and the pass samples its own previous
+// output under its TARGET name (zero until the first frame), which is what
+// stateful simulations need.
+struct RenderPassDesc {
+    std::string target;       // HLSL identifier; empty = not sampled by any pass
+    float widthScale  = 1.0f;  // Of the render size ("$WIDTH/2" = 0.5)
+    float heightScale = 1.0f;
+    int   width  = 0;          // Fixed size in pixels when > 0
+    int   height = 0;
+    PassFormat format = PassFormat::RGBA8;
+    bool persistent = false;   // Needs a TARGET
+    int  steps = 1;            // Persistent only: draws per frame, [1, MAX_PASS_STEPS]
+};
+
+// ISF "FRAME_HISTORY": the renderer keeps the last `frames` video frames in a
+// Texture2DArray ring at t(FRAME_HISTORY_SLOT), optionally at a fraction of the
+// video size. 0 frames = no history.
+struct FrameHistoryDesc {
+    int   frames = 0;     // [0, MAX_HISTORY_FRAMES]
+    float scale  = 1.0f;  // Of the video size; 1 copies frames as they are
+};
+
+// ISF SHADER_TYPE "compute": the preset's `main` is a cs_5_0 kernel writing the
+// frame into `outputTexture` (u0), dispatched once per DISPATCHES entry with
+// PASSINDEX defined. BUFFERS are structured buffers at u1.. that keep their
+// contents across frames (particles, histograms); the shader declares them.
+struct ComputeBufferDesc {
+    std::string name;
+    int stride = 4;   // Bytes per element, multiple of 4
+    int count  = 1;
+    bool persistent = true;  // false: scratch the kernels rebuild every frame (scopes)
+};
+struct ComputeDispatch {
+    // Thread groups per axis. 0 = enough groups to cover the output; with a
+    // size axis (0 = render width, 1 = height) groups = ceil(size * scale).
+    int   groups[2]    = { 0, 0 };
+    int   sizeAxis[2]  = { -1, -1 };
+    float sizeScale[2] = { 1.0f, 1.0f };
+};
+// ISF compute "DRAW": after the kernels, one DrawInstancedIndirect draws every
+// element of a BUFFERS entry into outputTexture as a point (SIZE 1) or a
+// SIZE-pixel quad, so the cost follows the point count instead of pixels x
+// points. The preset's `pointVS` / `pointPS` draw them and read the buffers as
+// StructuredBuffers at t(FIRST_DRAW_BUFFER_SLOT + index); a kernel may store a
+// smaller instance count into drawArgs at u(DRAW_ARGS_UAV).
+struct ComputeDrawDesc {
+    int   buffer   = -1;    // Index into ComputeDesc::buffers; -1 = no draw
+    float size     = 1.0f;  // Pixels; 1 or less draws a point list
+    bool  additive = true;  // false: source-alpha blending
+};
+struct ComputeDesc {
+    bool enabled  = false;
+    int  threadsX = 8;      // [numthreads(THREADS_X, THREADS_Y, 1)]
+    int  threadsY = 8;
+    bool clearOutput = true;  // Zero outputTexture before the first dispatch
+    PassFormat format = PassFormat::RGBA8;
+    std::vector<ComputeBufferDesc> buffers;    // Up to MAX_COMPUTE_BUFFERS
+    std::vector<ComputeDispatch>   dispatches; // Empty = one covering the output
+    ComputeDrawDesc                draw;
+};
+
+// YUV→RGB matrix for frames the renderer converts on the GPU
+enum class ColorMatrix { BT601, BT709, BT2020 };
+
+// Pixel layout of VideoFrame::data[]. The packed layouts (RGBA8, BGRA8, BGRX8 =
+// BGR0 with undefined alpha, RGBA16) are uploaded as-is into a texture of the
+// matching DXGI format; the YUV layouts are native decoder planes converted on
+// the GPU (10/12-bit in 16-bit words: P010 MSB-aligned, the planar ones
+// LSB-aligned as FFmpeg's *LE formats). NV12, P010 and the 420 layouts are
+// 4:2:0; 422 halves chroma horizontally; 444 is full size. YUYV422/UYVY422 are
+// unpacked by their own shader.
+enum class FrameLayout {
+    RGBA8, NV12, P010, YUV420P, YUV420P10,
+    YUV422P10, YUV444P10, YUV420P12, YUV422P12, YUV444P12,
+    BGRA8, BGRX8, RGBA16,
+    YUV422P, YUV444P,   // 8-bit planar, e.g. MJPEG capture (yuvj422p)
+    YUYV422, UYVY422    // 8-bit packed 4:2:2 (YUY2/UYVY capture): one plane, 2 bytes/pixel
+};
+
+inline bool IsPackedLayout(FrameLayout layout) {
+    return layout == FrameLayout::RGBA8 || layout == FrameLayout::BGRA8 ||
+           layout == FrameLayout::BGRX8 || layout == FrameLayout::RGBA16;
+}
+
+// Pixel layout of recording readback blocks. RGBA8, or the encoder's planar YUV
+// converted on the GPU (BT.709 limited range; planes back to back, tightly packed,
+// 10-bit LSB-aligned in 16-bit words as in AV_PIX_FMT_YUV422P10LE).
+enum class ReadbackLayout { RGBA8, YUV420P, YUV422P10 };
+
+// A DirectShow capture mode (CaptureDevices::EnumerateModes) as the dshow
+// demuxer's options: size, the fastest frame rate the mode allows, and either a
+// raw pixel_format ("nv12", "yuyv422", "uyvy422", "yuv420p") or vcodec "mjpeg".
+struct CaptureMode {
+    int width   = 0;
+    int height  = 0;
+    int rateNum = 0;  // Frame rate as a fraction (10000000 / frame interval)
+    int rateDen = 1;
+    std::string pixelFormat;
+    std::string codec;
+    std::string label;  // "3840x2160 59.94 fps NV12"
+    uint32_t fourcc = 0;  // Subtype FOURCC: the same mode as a Media Foundation native type
+
+    double GetFps() const { return rateDen > 0 ? static_cast<double>(rateNum) / rateDen : 0.0; }
+};
+
+// Per-codec hardware decode choice (AppConfig::hwDecodePolicy). Auto = D3D11VA
+// where the startup probe (HardwareDecodeCaps) found the profile and frame size.
+enum class HwDecodePolicy { Auto, Hardware, Software };
+
 // Frame data structure
 struct VideoFrame {
-    std::vector<uint8_t> data[4];  // Plane data (Y, U, V, or RGB)
-    int linesize[4];
+    uint8_t* data[4] = {};  // Plane pointers (Y, U, V, or RGBA) into `buffer`
+    int linesize[4] = {};
     int width;
     int height;
     int format;  // AVPixelFormat
     int64_t pts;
     double timestamp;  // In seconds
+    FrameLayout layout = FrameLayout::RGBA8;
+
+    // Owner of the pixels: a FramePool block (sws_scale'd RGBA) or an AVFrame
+    // reference (native planes, hardware surfaces). Copying a VideoFrame shares
+    // it; the pixels are never duplicated on the CPU.
+    std::shared_ptr<void> buffer;
+
+    // D3D11VA hardware frame: the decoder's NV12/P010 texture array + slice index.
+    // data[] is null in this case; `buffer` holds the AVFrame so the decoder
+    // cannot recycle the surface while the renderer still samples it.
+    ID3D11Texture2D*      hwTexture    = nullptr;
+    int                   hwArraySlice = 0;
+
+    // Colour metadata for GPU YUV conversion (taken from the AVFrame)
+    ColorMatrix colorMatrix = ColorMatrix::BT709;
+    bool        fullRange   = false;
+
+    // Proxy mode: size of the video texture the GPU conversion pass writes
+    // (0 = width/height). Hardware surfaces and native planes are downscaled
+    // there instead of on the CPU.
+    int outputWidth  = 0;
+    int outputHeight = 0;
+
+    // Unique per decoded frame across all decoders (0 = unknown). The renderer
+    // skips uploading a frame whose generation is already in its texture.
+    uint64_t generation = 0;
+
+    bool HasPixels() const { return hwTexture != nullptr || data[0] != nullptr; }
 };
 
 // Shader preset structure
+// Registers a compiled shader reads, from reflection (D3DReflect): bit N of
+// `textures` is tN (any SRV), of `cbuffers` bN. The renderer neither uploads
+// nor binds shared resources the active shader doesn't read. The default reads
+// everything, for bytecode that can't be reflected.
+struct ShaderBindings {
+    uint32_t textures = ~0u;
+    uint32_t cbuffers = ~0u;
+
+    bool ReadsTexture(int slot) const { return (textures >> slot) & 1u; }
+    bool ReadsCBuffer(int slot) const { return (cbuffers >> slot) & 1u; }
+    ShaderBindings& operator|=(const ShaderBindings& other) {
+        textures |= other.textures;
+        cbuffers |= other.cbuffers;
+        return *this;
+    }
+};
+
+// Static cost of compiled bytecode, from reflection (per pixel or per thread).
+// Counts are of the DXBC, so a loop the compiler kept counts its body once:
+// flowControl says how much of the cost that hides. Summed over passes and
+// kernels; tempRegisters is the largest.
+struct ShaderCost {
+    uint32_t instructions   = 0;
+    uint32_t textureSamples = 0;  // Sample, load, compare, bias and gradient instructions
+    uint32_t flowControl    = 0;  // Dynamic branches and loops
+    uint32_t tempRegisters  = 0;
+
+    ShaderCost& operator+=(const ShaderCost& other) {
+        instructions   += other.instructions;
+        textureSamples += other.textureSamples;
+        flowControl    += other.flowControl;
+        tempRegisters   = std::max(tempRegisters, other.tempRegisters);
+        return *this;
+    }
+};
+
 struct ShaderPreset {
     std::string name;
     std::string filepath;
+    std::string folder;   // Subfolder under the scanned shader directory ("a/b"); "" = top level. Not saved
     std::string source;
     int shortcutKey = 0;  // Virtual key code
     int shortcutModifiers = 0;  // MOD_CONTROL, MOD_SHIFT, etc.
     bool isValid = false;
+    bool isCompiling = false;   // Queued on ShaderManager's background compile pool
+    bool isDeferred = false;    // Library mode: not compiled until first activated
     bool isGenerative = false;  // True if SHADER_TYPE = "generative" in ISF block
     bool isAudio = false;       // True if SHADER_TYPE = "audio" in ISF block
+    bool isTimeVarying = true;  // Reads time or audio (from reflection); false = redrawn only on change
+    ShaderBindings bindings;    // All passes or kernels together (from reflection)
+    std::vector<std::string> includes;  // Files the source #includes (resolved), as of the last compile
+    ShaderCost cost;            // Static estimate of the last good compile
+    float measuredGpuMs = 0.0f; // Shader stage while active (ShaderManager::RecordGpuTime); 0 = not yet
     int   blendMode   = 0;      // 0=Off, 1=Normal, 2=Add, 3=Multiply, 4=Screen,
                                 //   5=Overlay, 6=Soft Light, 7=Difference,
                                 //   8=Exclusion, 9=Darken, 10=Lighten
     float blendAmount = 1.0f;   // Blend strength [0,1]
     std::string compileError;
     std::vector<ShaderParam> params;
+    std::vector<RenderPassDesc> passes;  // ISF PASSES; empty = one pass to the display
+    FrameHistoryDesc frameHistory;
+    bool videoMips = false;  // ISF VIDEO_MIPS: t0 carries a full mip chain
+    ComputeDesc compute;  // enabled for SHADER_TYPE "compute"
     // Persistence bridge: saved values keyed by param name, restored after re-parse.
     // Format: { "PixelSize": [8.0], "Tint": [1.0, 0.8, 0.6, 1.0] }
     std::unordered_map<std::string, std::vector<float>> savedParamValues;
     std::unordered_map<std::string, KeyframeTimeline> savedKeyframes;
+    // Modulation matrix rows, by param name so they survive re-parses. Bump the
+    // revision on every edit: the matrix rebuilds its flat arrays from it.
+    std::vector<Modulation> modulations;
+    int modulationRevision = 0;
 };
 
 struct WorkspacePreset {
@@ -133,19 +363,53 @@ struct WorkspacePreset {
 };
 
 // Recording settings
+// libx264 tuning of a recording (RecordingSettings::encoderProfile). Custom is
+// RecordingSettings::preset with tune=film and no B-frames.
+constexpr int ENCODER_PROFILE_CUSTOM   = 0;
+constexpr int ENCODER_PROFILE_REALTIME = 1;  // faster, zerolatency, sliced threads: no frame delay
+constexpr int ENCODER_PROFILE_QUALITY  = 2;  // medium, rc-lookahead and B-frames
+constexpr int ENCODER_PROFILE_ARCHIVE  = 3;  // slow, longer lookahead and GOP
+constexpr int ENCODER_PROFILE_COUNT    = 4;
+
+// What each libx264 profile sustained at a size (VideoEncoder::CalibrateProfiles)
+struct EncoderCalibration {
+    int    width  = 0;
+    int    height = 0;
+    double fps[ENCODER_PROFILE_COUNT] = {};  // Custom, and profiles that failed to open: 0
+    int    recommended = ENCODER_PROFILE_REALTIME;
+};
+
 struct RecordingSettings {
     std::string outputPath;
     int width = 0;   // 0 = source resolution
     int height = 0;
     int bitrate = 20000000;  // 20 Mbps
     int fps = 0;  // 0 = source fps
-    std::string codec = "libx264";  // or "prores_ks"
+    std::string codec = "libx264";  // or "prores_ks", or a hardware encoder (VideoEncoder::IsHardwareCodec)
     std::string preset = "medium";
+    int encoderProfile = ENCODER_PROFILE_CUSTOM;  // libx264 only; the others use preset as given
     int proresProfile = 2;  // 0=proxy, 1=LT, 2=422, 3=HQ
+    bool dropWhenBehind = true;  // false = SubmitFrame waits for queue space (offline transcodes)
+    bool adaptToLoad = true;  // Realtime: lower the bitrate mid-take while the encoder falls behind (VideoEncoder::CanAdaptToLoad)
+    int replaySeconds = 0;    // > 0 = instant replay: keep the last N seconds in memory, no file
+    int replayBudgetMB = 512;  // Memory cap of the replay ring
+    int downscale = 1;  // Divides the source size when width/height are 0 (review copies)
+    bool recordAudio = true;  // Audio track from the playback samples, when the source has audio
+    int writeBufferMB = 128;  // Write-behind queue between muxer and disk; 0 = synchronous writes
+    bool writeThrough = false;  // Bypass the OS write cache (FILE_FLAG_WRITE_THROUGH)
+    bool fragmented = false;  // Fragmented MP4/MOV: playable after a crash, flat memory, instant stop
+    int segmentSeconds = 0;   // > 0 = rolling files <name>_000.<ext>, ..., cut on keyframes
+    bool telemetryCsv = false;  // Per-frame stage timings to <name>_telemetry.csv
 };
 
+// Played audio is interleaved stereo float from AudioReader through the player,
+// the time stretcher, analysis and recording. Mono sources play as L = R and
+// anything wider is downmixed by AudioReader.
+constexpr int AUDIO_CHANNELS = 2;
+
 // Live audio analysis output — written by AudioAnalyzer after each FFT pass,
-// read by Application each render frame.
+// read by Application each render frame. The unprefixed values are of the mid
+// (L+R)/2 signal; mono sources report the same left and right.
 struct AudioData {
     float rms             = 0.0f;  // Overall RMS [0,1]
     float bass            = 0.0f;  // 20-250 Hz [0,1]
@@ -153,8 +417,21 @@ struct AudioData {
     float high            = 0.0f;  // 4000-20000 Hz [0,1]
     float beat            = 0.0f;  // Decaying pulse on onset [0,1]
     float spectralCentroid = 0.0f; // Normalised centre of mass [0,1]
+    // Per channel, [0] left and [1] right: rms, bass, mid, high as above
+    float channelRms[AUDIO_CHANNELS]  = {};
+    float channelBass[AUDIO_CHANNELS] = {};
+    float channelMid[AUDIO_CHANNELS]  = {};
+    float channelHigh[AUDIO_CHANNELS] = {};
+    float stereoWidth = 0.0f;      // Side (L-R) share of the energy [0,1]: 0 = mono
+    // Tempo tracker: 0 until a tempo is found. Phases rise from 0 at each beat
+    // (each downbeat of a 4/4 bar) to 1 at the next.
+    float bpm       = 0.0f;
+    float beatPhase = 0.0f;
+    float barPhase  = 0.0f;
     static constexpr int kSpectrumBins = 256;
     float spectrum[kSpectrumBins] = {};  // Normalised per-bin magnitudes [0,1]
+    static constexpr int kWaveformSamples = 512;
+    float waveform[kWaveformSamples][AUDIO_CHANNELS] = {};  // Latest heard frames, oldest first [-1,1]
 };
 
 // DSP tuning — stored in config.json, editable from the Audio Monitor panel.
@@ -162,14 +439,112 @@ struct AudioSettings {
     float beatSensitivity = 1.5f;  // Threshold = sensitivity * rolling-average bass energy
     float beatDecay       = 0.92f; // Multiplicative per-frame decay of beat pulse
     float smoothing       = 0.3f;  // EMA coefficient: 0 = no smoothing, 1 = frozen
+    int   fftSize         = 2048;  // Long window: 1024, 2048, 4096 or 8192 samples
+    bool  multiResolution = false; // Highs (> 4 kHz) from a window a quarter as long
+    bool  logSpectrum     = false; // Spectrum bins log-spaced 20 Hz-20 kHz (false = linear)
 };
 
 // Noise texture settings — controls the globally-bound t1 noise texture
 struct NoiseSettings {
     float scale       = 4.0f;   // frequency multiplier (higher = more repetitions)
     int   textureSize = 512;    // texture dimensions (power of 2)
+    int   volumeSize  = 64;     // 3D noise texels per side, 0 = off
 };
 
+// AppConfig::syncMode values (stored as int in config.json)
+constexpr int SYNC_MODE_FRAME_PACED  = 0;
+constexpr int SYNC_MODE_AUDIO_MASTER = 1;
+
+// AppConfig::frameSyncRole values (stored as int in config.json; FrameSync::Role order)
+constexpr int FRAME_SYNC_OFF      = 0;
+constexpr int FRAME_SYNC_MASTER   = 1;
+constexpr int FRAME_SYNC_FOLLOWER = 2;
+
+// AppConfig::upscaleFilter values (stored as int in config.json)
+constexpr int UPSCALE_BICUBIC       = 0;  // Catmull-Rom, 9 bilinear taps
+constexpr int UPSCALE_LANCZOS       = 1;  // Lanczos-2, 16 taps, clamped against ringing
+constexpr int UPSCALE_EDGE_ADAPTIVE = 2;  // FSR1-style: EASU along edges, then RCAS sharpening
+
+// AppConfig::audioInput values (stored as int in config.json)
+constexpr int AUDIO_INPUT_FILE     = 0;  // The open file's audio, as heard
+constexpr int AUDIO_INPUT_CAPTURE  = 1;  // A capture device: line-in, microphone
+constexpr int AUDIO_INPUT_LOOPBACK = 2;  // What an output device plays (WASAPI loopback)
+
+// CompositeLayer::source values (stored as int in config.json)
+constexpr int LAYER_SOURCE_PRESET = 0;  // A single-pass pixel preset, with its current values
+constexpr int LAYER_SOURCE_INPUT  = 1;  // An extra video input (AppConfig::videoInputs)
+
+// One layer of the compositor stack, drawn over the active shader's result in
+// list order (last on top)
+struct CompositeLayer {
+    bool        enabled   = true;
+    int         source    = LAYER_SOURCE_PRESET;
+    std::string preset;              // Preset name, for LAYER_SOURCE_PRESET
+    int         input     = 0;       // Extra video input index, for LAYER_SOURCE_INPUT
+    int         blendMode = 1;       // As ShaderPreset::blendMode, 1..MAX_BLEND_MODE
+    float       opacity   = 1.0f;
+    int         mask      = -1;      // Extra video input whose luma scales the opacity; -1 = none
+};
+
+// A learned controller binding (AppConfig::controlMappings): an OSC address, or
+// a MIDI message spelled as one (ControlInput), driving one component of a
+// preset's param. Incoming values are taken as 0..1 and scaled to min..max.
+struct ControlMapping {
+    std::string address;
+    std::string preset;          // Preset name; empty = whichever preset is active
+    std::string param;
+    int         component = 0;   // 0..3, for Point2D and Color params
+    float       min = 0.0f;
+    float       max = 1.0f;
+};
+
+// A hardware GPU as D3D11Renderer::ListAdapters reports it (AppConfig::gpuAdapter)
+struct AdapterInfo {
+    std::string name;             // DXGI_ADAPTER_DESC1::Description, UTF-8
+    uint64_t dedicatedBytes = 0;  // Dedicated video memory
+};
+
+// A/B deck transitions (AppConfig::deckTransition): how deck B comes in as the
+// crossfader moves from 0 (deck A) to 1 (deck B)
+constexpr int DECK_TRANSITION_FADE = 0;  // Crossfade
+constexpr int DECK_TRANSITION_WIPE = 1;  // Soft-edged wipe from the left
+
+// Per-output post chains (AppConfig::postChains, indexed by these): presets
+// drawn over the finished frame for one output only, up to MAX_POST_STAGES each
+constexpr int POST_OUTPUT_PREVIEW   = 0;  // The Video viewport (the operator's monitor)
+constexpr int POST_OUTPUT_WINDOW    = 1;  // VideoOutputWindow (the projector)
+constexpr int POST_OUTPUT_SPOUT     = 2;
+constexpr int POST_OUTPUT_NDI       = 3;
+constexpr int POST_OUTPUT_RECORDING = 4;
+constexpr int POST_OUTPUT_VIRTUAL_CAMERA = 5;  // Appended: saved chains are indexed by these
+constexpr int POST_OUTPUT_COUNT     = 6;
+constexpr int MAX_POST_STAGES       = 4;
+
+// An extra playback channel (AppConfig::channels, PlaybackChannel): its own clip
+// and clock, one preset drawn over it, and its own output window, for
+// multi-projector installs run from one process
+struct ChannelConfig {
+    std::string video;
+    std::string preset;         // Single-pass pixel or compute preset; empty = the clip as is
+    bool        output = true;  // Its output window open
+};
+constexpr int MAX_CHANNELS = 4;
+
+// One window of a canvas spread over several displays (AppConfig::canvasOutputs):
+// the part of the display texture it shows, its edge blends and its warp
+struct CanvasRegion {
+    // Sub-rectangle of the canvas, fractions of its size
+    float x = 0.0f, y = 0.0f, width = 1.0f, height = 1.0f;
+    // Edge blend widths, fractions of this region; each ramps down to black where
+    // it overlaps a neighbour, shaped by `blendGamma` so the light sums evenly
+    float blendLeft = 0.0f, blendRight = 0.0f, blendTop = 0.0f, blendBottom = 0.0f;
+    float blendGamma = 2.2f;
+    // Keystone warp: where the region's top-left, top-right, bottom-left and
+    // bottom-right corners land in the window, as x, y pairs (0..1)
+    std::array<float, 8> corners = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+};
+constexpr int MAX_CANVAS_OUTPUTS = 4;
+
 // Application configuration
 struct AppConfig {
     std::vector<ShaderPreset> shaderPresets;
@@ -178,12 +553,110 @@ struct AppConfig {
     int autoCompileDelayMs = 500;
     std::string lastOpenedVideo;
     std::string shaderDirectory = "shaders";
+    // Library mode: presets are compiled on first activation (or at once in the
+    // background when they have a shortcut key) instead of all at startup
+    bool lazyShaderCompile = false;
+    // Shader objects kept alive across the library before the least recently
+    // used presets drop back to bytecode-only (ShaderManager::SetResidencyBudget); 0 = no limit
+    int residentShaderBudget = 256;
+    // Still thumbnails in the library list (ThumbnailAtlas), drawn in the background
+    bool libraryThumbnails = true;
     std::string layoutsDirectory = "layouts";
     bool timeDisplayFrames = false;  // true = show frame numbers; false = show seconds
+    // Filmstrip and waveform above the transport seek bar (MediaOverview), built
+    // in the background on open and cached in overview_cache/ next to the exe
+    bool timelineOverview = true;
 
     // Noise generator
     NoiseSettings noise;
 
+    // Video decoding — D3D11VA on the renderer's device; falls back to software
+    // automatically when the codec or GPU can't decode the stream.
+    bool hardwareDecode = true;
+    // Per codec (FFmpeg name: h264, hevc, vp9, av1, ...), an HwDecodePolicy as int;
+    // codecs not listed are Auto. Hardware skips the capability check.
+    std::unordered_map<std::string, int> hwDecodePolicy;
+    // Software decode: upload native YUV planes and convert in a shader pass instead
+    // of sws_scale to RGBA on the CPU. Unsupported pixel formats still use sws_scale.
+    bool gpuYuvConversion = true;
+    // Hardware decode: convert and scale NV12/P010 surfaces on the GPU's fixed-function
+    // video processor instead of the YUV shader pass (falls back per frame)
+    bool videoProcessorConversion = false;
+    // 10/12-bit sources convert into a 16-bit video texture, and the display and
+    // working targets follow while one plays, so gradients don't band and 10-bit
+    // recordings keep their precision. Off = RGBA8 throughout (half the bandwidth).
+    bool highBitDepth = true;
+    // libavcodec threading for the video decoder. Count 0 = auto (one per core);
+    // type 0 = auto (frame + slice), 1 = frame only, 2 = slice only. Applied on open.
+    int decodeThreadCount = 0;
+    int decodeThreadType  = 0;
+    // Proxy playback: decode and run the shader at 1/N size (1 = off, 2 = half,
+    // 4 = quarter). Recording always renders at full size. Applied on open.
+    int proxyScale = 1;
+    // VRAM budget for the GPU scrub cache of recently shown frames (0 = off)
+    int scrubCacheMB = 1024;
+    // VRAM for every frame of the A/B loop region (0 = off); a larger region is
+    // re-decoded each pass
+    int loopCacheMB = 2048;
+    // Forward file playback: finished frames rendered ahead of the playhead and
+    // shown on the clock (0 = off), so one slow frame or a shader compile does not
+    // drop. VRAM per frame: the video plus the display texture.
+    int renderAheadFrames = 0;
+    // System memory for reverse playback's decoded GOPs (current + next-earlier)
+    int reverseCacheMB = 1024;
+    // Container probing budget for opening files (smaller = faster first frame).
+    // MediaProbe retries with more if the video stream is still unknown.
+    int probeSizeKB       = 1024;
+    int analyzeDurationMs = 1000;
+    // Network streams (Open Stream URL): playout delay that absorbs arrival jitter,
+    // in ms (0 = show packets as they arrive), and RTSP over TCP instead of UDP
+    int  networkJitterMs = 200;
+    bool networkTcp      = false;
+    // Webcams through Media Foundation (MfCaptureInput: D3D11 frames, GPU
+    // conversion) instead of dshow + FFmpeg; dshow is still the fallback
+    bool mediaFoundationCapture = false;
+    // File playback sync: SYNC_MODE_AUDIO_MASTER follows the audio clock (wall clock
+    // without audio), dropping late frames and making decode cheaper when behind.
+    // SYNC_MODE_FRAME_PACED shows every frame, one per frame interval.
+    int syncMode = SYNC_MODE_AUDIO_MASTER;
+    // Variable speed: time-stretch audio (pitch kept); false mutes it away from 1x
+    bool stretchAudio = true;
+    // Read-ahead window for files on network/removable volumes (local disks are
+    // memory-mapped instead). 0 = read synchronously in the demuxer's own chunks.
+    int ioReadAheadMB = 32;
+    // Edit proxies: transcode long-GOP files to intra-only ProRes Proxy at half
+    // size in the background, then play and scrub those instead (audio still comes
+    // from the source). Empty directory = proxy_cache/ next to the exe.
+    bool editProxies = false;
+    std::string proxyCacheDirectory;
+    // Image sequences (numbered stills): playback rate, and the RAM budget under
+    // which the whole sequence is kept decoded for looping (0 = stream only).
+    // Applied on open.
+    double imageSequenceFps     = 24.0;
+    int    imageSequenceCacheMB = 4096;
+    // Extra video inputs (ISF "image" INPUTS), one path per input; empty = unbound.
+    // Reopened on startup.
+    std::vector<std::string> videoInputs;
+    // Colour LUT files (ISF "lut" INPUTS, .cube/.3dl), one per LUT slot; empty =
+    // unbound. Reloaded on startup.
+    std::vector<std::string> lutFiles;
+    // Compositor stack over the active shader, bottom first (up to MAX_LAYERS)
+    std::vector<CompositeLayer> layers;
+    // Deck B of A/B mixing: its clip and preset (empty = passthrough), recued on startup
+    std::string deckVideo;
+    std::string deckPreset;
+    int         deckTransition = DECK_TRANSITION_FADE;
+    // Extra playback channels (up to MAX_CHANNELS), recued on startup
+    std::vector<ChannelConfig> channels;
+    // Canvas spanning several output windows: one render, one region per window
+    bool canvasEnabled = false;
+    std::vector<CanvasRegion> canvasOutputs;
+    // Files played one after another, wrapping at the end
+    std::vector<std::string> playlist;
+    // Post chains by POST_OUTPUT_*: preset names drawn in order over that
+    // output's frame (single-pass pixel or compute presets, with their current values)
+    std::vector<std::vector<std::string>> postChains = std::vector<std::vector<std::string>>(POST_OUTPUT_COUNT);
+
     // Generative shader output resolution (used when no video is loaded)
     int generativeWidth  = 1920;
     int generativeHeight = 1080;
@@ -191,10 +664,21 @@ struct AppConfig {
 
     // Audio analysis DSP settings
     AudioSettings audio;
+    // Analyse a file's whole audio track in the background on open (cached in
+    // audio_cache/ next to the exe) and look AudioData up by playback time
+    bool audioPreAnalysis = true;
+    // What the analysis listens to: the file, or a live input (AudioCapture) that
+    // feeds audio-reactive shaders with or without a video. Device by name; empty
+    // = the system default.
+    int         audioInput = AUDIO_INPUT_FILE;
+    std::string audioInputDevice;
 
     // Audio playback
     float audioVolume = 1.0f;
     bool  muteAudio   = false;
+    // Exclusive-mode WASAPI with small periods (shared mode when refused) and a
+    // 150 ms queue instead of 2 s, for live work played from here
+    bool  audioLowLatency = false;
 
     // Passthrough keybinding (secondary; Escape is always hardcoded)
     int passthroughKey       = 0;
@@ -203,6 +687,91 @@ struct AppConfig {
     // Spout output
     bool        spoutEnabled    = false;
     std::string spoutSenderName = "ShaderPlayer";
+    int         spoutWidth      = 0;   // 0x0 = the render size; otherwise scaled on the GPU
+    int         spoutHeight     = 0;
+    int         spoutPass       = -1;  // Render-graph pass to send instead of the output; -1 = output
+
+    // NDI output (needs an NDI build and runtime)
+    bool        ndiEnabled    = false;
+    std::string ndiSenderName = "ShaderPlayer";
+    int         ndiWidth      = 0;   // 0x0 = the render size
+    int         ndiHeight     = 0;
+
+    // Virtual camera (Windows 11, ShaderPlayerVCam.dll registered). The size is
+    // the one the camera client picks, so there is none here.
+    bool        virtualCameraEnabled = false;
+    std::string virtualCameraName    = "ShaderPlayer";
+
+    // Controller input (ControlInput): OSC on a UDP port and one MIDI input by
+    // name (empty = none), and the learned address-to-param bindings
+    bool        oscEnabled = false;
+    int         oscPort    = 9000;
+    std::string midiDevice;
+    std::vector<ControlMapping> controlMappings;
+
+    // Prometheus metrics endpoint (MetricsServer): http://<host>:<port>/metrics
+    bool        metricsEnabled = false;
+    int         metricsPort    = 9464;
+
+    // Frame-stall watchdog (FrameWatchdog): steps the active shader down when the
+    // main loop or the GPU stalls, and reports to watchdog.log next to the exe
+    bool  watchdogEnabled = false;
+    int   watchdogStallMs = 1000;
+    float watchdogGpuMs   = 200.0f;
+
+    // Network frame sync (FrameSync) for video walls: one master per wall, every
+    // other node a follower, all on the same UDP port
+    int frameSyncRole = FRAME_SYNC_OFF;
+    int frameSyncPort = 9471;
+
+    // Dynamic resolution: render the active shader smaller to keep its GPU time
+    // under the target (never while recording or exporting)
+    bool  dynamicResolution         = false;
+    float dynamicResolutionTargetMs = 12.0f;
+    float dynamicResolutionMinScale = 0.5f;
+    // Upscaler (D3D11Renderer::SetUpscaler) of those reduced-size renders, the
+    // viewport preview, recordings larger than the render and output windows
+    // larger than it (proxy playback); sharpness is the RCAS pass, 0 = none
+    int   upscaleFilter             = UPSCALE_EDGE_ADAPTIVE;
+    float upscaleSharpness          = 0.25f;
+    // GPU time a tick may give the background work after Present (thumbnails,
+    // prewarm, LUT bakes), as BackgroundGpuWork predicts it
+    float backgroundGpuBudgetMs     = 1.0f;
+    // Tiled rendering (D3D11Renderer::SetTiling): tile edge in pixels, 0 = off;
+    // tiles drawn per tick, 0 = the whole frame each tick
+    int   renderTileSize            = 0;
+    int   renderTilesPerFrame       = 0;
+    // With no full-size consumer (recording, export, output window, Spout), render
+    // the active shader at the size the Video viewport shows it
+    bool  previewAtViewportSize     = true;
+    // GPU for the whole pipeline (D3D11Renderer::SetPreferredAdapter): an adapter
+    // name from ListAdapters, or empty for the high-performance GPU. Read at startup.
+    std::string gpuAdapter;
+    // Shader bytecode shared between machines (D3D11Renderer::SetSharedShaderCache):
+    // a UNC directory read behind shader_cache/ and published to. Empty = local
+    // only. Read at startup.
+    std::string sharedShaderCache;
+
+    // Frame pacing: at most one frame queued for the main window (else two)
+    bool lowLatencyPresent = true;
+    // Off: present as soon as a frame is done, tearing where supported (VRR displays)
+    bool vsync = true;
+    // Main loop ticks per second (0 = uncapped: vsync, or the output window's
+    // monitor while the UI is throttled, sets the pace)
+    int  frameRateCap = 0;
+    // UI redraws per second; the output path still renders every tick (0 = every tick)
+    int  uiRefreshHz = 0;
+    // Without input or animation, UI rebuilds per second; redraws in between reuse
+    // the last build (0 = rebuild on every redraw)
+    int  uiIdleRebuildHz = 15;
+    // Tick cap while running on battery, on top of frameRateCap (0 = none)
+    int  batteryFrameRateCap = 0;
+    // MMCSS tasks for the audio, render and decode threads, below-normal priority for
+    // encoders and compiles (ThreadPriority). Takes effect as threads (re)start.
+    bool threadPriorities = true;
+
+    // Profiling: Ctrl+T dumps this many seconds of the frame pipeline as a Chrome trace
+    int traceSeconds = 10;
 
     // UI layout
     float editorPanelWidth = 500.0f;
@@ -219,6 +788,13 @@ enum class PlaybackState {
     Paused
 };
 
+// File playback direction. PingPong reverses at either end instead of looping.
+enum class PlaybackDirection {
+    Forward,
+    Reverse,
+    PingPong
+};
+
 // Callback types
 using FrameCallback = std::function<void(const VideoFrame&)>;
 using CompileCallback = std::function<void(bool success, const std::string& error)>;
@@ -226,5 +802,65 @@ using CompileCallback = std::function<void(bool success, const std::string& erro
 // Constants
 constexpr int MAX_FRAME_QUEUE_SIZE = 8;
 constexpr int ENCODER_QUEUE_SIZE = 16;
+// Extra video inputs for compositing, bound after the global t0-t3 textures
+constexpr int MAX_VIDEO_INPUTS = 4;
+constexpr int FIRST_INPUT_SLOT = 4;
+// Multi-pass presets: pass N's target is bound at t(FIRST_PASS_SLOT + N)
+constexpr int MAX_RENDER_PASSES = 8;
+constexpr int FIRST_PASS_SLOT = 8;
+constexpr int MAX_PASS_STEPS = 32;
+
+// Frame history ring (Texture2DArray) and its cbuffer
+constexpr int FRAME_HISTORY_SLOT = 16;
+constexpr int FRAME_HISTORY_CBUFFER = 2;
+// Spectrogram ring: one spectrum row per analysis frame, newest row and count in
+// the audio cbuffer (b1)
+constexpr int SPECTROGRAM_SLOT = 17;
+constexpr int SPECTROGRAM_ROWS = 256;
+// Latest heard samples, AudioData::kWaveformSamples×1
+constexpr int WAVEFORM_SLOT = 18;
+// Tiling 3D noise (Perlin in R, its fBm in G), sampled with the wrap sampler s1
+constexpr int NOISE_VOLUME_SLOT = 19;
+// Colour LUTs (ISF "lut" INPUTS): Texture3D at t(FIRST_LUT_SLOT + index)
+constexpr int MAX_LUTS = 4;
+constexpr int FIRST_LUT_SLOT = 20;
+// Video blend fused into a preset's own pass: the video again at
+// t(FUSED_BLEND_SLOT) with the clamp sampler at s(FUSED_BLEND_SLOT), amount in
+// cbuffer b(FUSED_BLEND_CBUFFER). Modes as ShaderPreset::blendMode, 1..MAX_BLEND_MODE.
+constexpr int FUSED_BLEND_SLOT = 2;
+constexpr int FUSED_BLEND_CBUFFER = 3;
+constexpr int MAX_BLEND_MODE = 10;
+// Compositor stack (AppConfig::layers): preset layers render into slices of a
+// Texture2DArray at t(LAYER_ARRAY_SLOT); per-layer opacity in b(LAYER_CBUFFER).
+// Both are the layer compositor's own, never a preset's.
+constexpr int MAX_LAYERS = 8;
+constexpr int LAYER_ARRAY_SLOT = 24;
+constexpr int LAYER_CBUFFER = 4;
+// Params past the 16 custom[] floats of b0 (presets with many INPUTS): float4
+// spParams[] in cbuffer b(PARAM_CBUFFER), packed on with the same alignment.
+// Uploaded by changed float4 range only (D3D11Renderer::SetExtendedParams).
+constexpr int CUSTOM_PARAM_FLOATS = 16;
+constexpr int MAX_EXTENDED_PARAM_FLOATS = 256;
+constexpr int PARAM_CBUFFER = 5;
+constexpr int MAX_HISTORY_FRAMES = 64;
+
+// Compute presets: outputTexture at u0, structured buffers from u1
+constexpr int MAX_COMPUTE_BUFFERS = 4;
+constexpr int MAX_COMPUTE_DISPATCHES = 8;
+constexpr size_t MAX_COMPUTE_BUFFER_BYTES = 256u * 1024 * 1024;
+// Point draws (ComputeDrawDesc): the buffers as SRVs for pointVS (compute
+// presets have no PASSES, so the pass slots are free) and the indirect args
+constexpr int FIRST_DRAW_BUFFER_SLOT = FIRST_PASS_SLOT;
+constexpr int DRAW_ARGS_UAV = 1 + MAX_COMPUTE_BUFFERS;
+constexpr float MAX_POINT_SIZE = 64.0f;
+
+// FNV-1a 64-bit hash — used to key the on-disk caches (shader bytecode, seek index).
+inline uint64_t Fnv1a64(const char* data, size_t len, uint64_t h = 14695981039346656037ULL) {
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
 
 } // namespace SP
@@ -1,9 +1,31 @@
 #include "ConfigManager.h"
+#include "KeyframeStore.h"
+#include "ModulationMatrix.h"
+#include "ThreadPriority.h"
+#include "TraceRecorder.h"
 #include <algorithm>
 #include <fstream>
 
 namespace SP {
 
+namespace {
+
+// Written aside, next to the target so the rename stays on one volume, then
+// swapped in: a crash mid-write leaves the previous file
+bool WriteFileAtomically(const std::filesystem::path& path, const char* data, size_t size) {
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(data, static_cast<std::streamsize>(size));
+        if (!file) return false;
+    }
+    return MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+} // namespace
+
 // JSON serialization implementations
 void to_json(nlohmann::json& j, const ShaderPreset& p) {
     j = nlohmann::json{
@@ -18,7 +40,8 @@ void to_json(nlohmann::json& j, const ShaderPreset& p) {
     if (!p.params.empty()) {
         nlohmann::json paramVals = nlohmann::json::object();
         for (const auto& param : p.params) {
-            if (param.type == ShaderParamType::AudioBand) continue;  // live data, not persisted
+            if (param.type == ShaderParamType::AudioBand || param.type == ShaderParamType::Image ||
+                param.type == ShaderParamType::Lut) continue;  // Live data / bound input, not values
             nlohmann::json vals = nlohmann::json::array();
             int count = 1;
             if (param.type == ShaderParamType::Point2D) count = 2;
@@ -31,7 +54,8 @@ void to_json(nlohmann::json& j, const ShaderPreset& p) {
     // Save keyframe timelines keyed by param name
     nlohmann::json kfObj = nlohmann::json::object();
     for (const auto& param : p.params) {
-        if (param.type == ShaderParamType::AudioBand) continue;
+        if (param.type == ShaderParamType::AudioBand || param.type == ShaderParamType::Image ||
+            param.type == ShaderParamType::Lut) continue;
         if (!param.timeline || param.timeline->keyframes.empty()) continue;
         const auto& tl = *param.timeline;
         nlohmann::json tlJson;
@@ -62,6 +86,25 @@ void to_json(nlohmann::json& j, const ShaderPreset& p) {
     if (!kfObj.empty()) {
         j["keyframes"] = kfObj;
     }
+    if (!p.modulations.empty()) {
+        nlohmann::json rows = nlohmann::json::array();
+        for (const auto& m : p.modulations) {
+            rows.push_back(nlohmann::json{
+                {"param",     m.param},
+                {"component", m.component},
+                {"source",    ModulationMatrix::GetSourceName(m.source)},
+                {"rate",      m.rate},
+                {"phase",     m.phase},
+                {"curve",     m.curve},
+                {"min",       m.min},
+                {"max",       m.max},
+                {"attack",    m.attack},
+                {"release",   m.release},
+                {"enabled",   m.enabled}
+            });
+        }
+        j["modulations"] = rows;
+    }
 }
 
 void from_json(const nlohmann::json& j, ShaderPreset& p) {
@@ -114,6 +157,23 @@ void from_json(const nlohmann::json& j, ShaderPreset& p) {
             p.savedKeyframes[name] = std::move(tl);
         }
     }
+    if (j.contains("modulations") && j["modulations"].is_array()) {
+        for (const auto& row : j["modulations"]) {
+            Modulation m;
+            m.param     = row.value("param", std::string());
+            m.component = row.value("component", 0);
+            m.source    = ModulationMatrix::ParseSourceName(row.value("source", std::string("sine")));
+            m.rate      = row.value("rate", 1.0f);
+            m.phase     = row.value("phase", 0.0f);
+            m.curve     = row.value("curve", 1.0f);
+            m.min       = row.value("min", 0.0f);
+            m.max       = row.value("max", 1.0f);
+            m.attack    = row.value("attack", 0.0f);
+            m.release   = row.value("release", 0.0f);
+            m.enabled   = row.value("enabled", true);
+            p.modulations.push_back(std::move(m));
+        }
+    }
 }
 
 void to_json(nlohmann::json& j, const RecordingSettings& r) {
@@ -125,7 +185,18 @@ void to_json(nlohmann::json& j, const RecordingSettings& r) {
         {"fps", r.fps},
         {"codec", r.codec},
         {"preset", r.preset},
-        {"proresProfile", r.proresProfile}
+        {"encoderProfile", r.encoderProfile},
+        {"proresProfile", r.proresProfile},
+        {"adaptToLoad", r.adaptToLoad},
+        {"replaySeconds", r.replaySeconds},
+        {"replayBudgetMB", r.replayBudgetMB},
+        {"downscale", r.downscale},
+        {"recordAudio", r.recordAudio},
+        {"writeBufferMB", r.writeBufferMB},
+        {"writeThrough", r.writeThrough},
+        {"fragmented", r.fragmented},
+        {"segmentSeconds", r.segmentSeconds},
+        {"telemetryCsv", r.telemetryCsv}
     };
 }
 
@@ -137,7 +208,102 @@ void from_json(const nlohmann::json& j, RecordingSettings& r) {
     if (j.contains("fps")) j.at("fps").get_to(r.fps);
     if (j.contains("codec")) j.at("codec").get_to(r.codec);
     if (j.contains("preset")) j.at("preset").get_to(r.preset);
+    if (j.contains("encoderProfile")) j.at("encoderProfile").get_to(r.encoderProfile);
     if (j.contains("proresProfile")) j.at("proresProfile").get_to(r.proresProfile);
+    if (j.contains("adaptToLoad")) j.at("adaptToLoad").get_to(r.adaptToLoad);
+    if (j.contains("replaySeconds")) j.at("replaySeconds").get_to(r.replaySeconds);
+    if (j.contains("replayBudgetMB")) j.at("replayBudgetMB").get_to(r.replayBudgetMB);
+    if (j.contains("downscale")) j.at("downscale").get_to(r.downscale);
+    if (j.contains("recordAudio")) j.at("recordAudio").get_to(r.recordAudio);
+    if (j.contains("writeBufferMB")) j.at("writeBufferMB").get_to(r.writeBufferMB);
+    if (j.contains("writeThrough")) j.at("writeThrough").get_to(r.writeThrough);
+    if (j.contains("fragmented")) j.at("fragmented").get_to(r.fragmented);
+    if (j.contains("segmentSeconds")) j.at("segmentSeconds").get_to(r.segmentSeconds);
+    if (j.contains("telemetryCsv")) j.at("telemetryCsv").get_to(r.telemetryCsv);
+}
+
+void to_json(nlohmann::json& j, const CompositeLayer& l) {
+    j = nlohmann::json{
+        {"enabled", l.enabled},
+        {"source", l.source},
+        {"preset", l.preset},
+        {"input", l.input},
+        {"blendMode", l.blendMode},
+        {"opacity", l.opacity},
+        {"mask", l.mask}
+    };
+}
+
+void from_json(const nlohmann::json& j, CompositeLayer& l) {
+    if (j.contains("enabled")) j.at("enabled").get_to(l.enabled);
+    if (j.contains("source")) j.at("source").get_to(l.source);
+    if (j.contains("preset")) j.at("preset").get_to(l.preset);
+    if (j.contains("input")) j.at("input").get_to(l.input);
+    if (j.contains("blendMode")) j.at("blendMode").get_to(l.blendMode);
+    if (j.contains("opacity")) j.at("opacity").get_to(l.opacity);
+    if (j.contains("mask")) j.at("mask").get_to(l.mask);
+}
+
+void to_json(nlohmann::json& j, const ControlMapping& m) {
+    j = nlohmann::json{
+        {"address", m.address},
+        {"preset", m.preset},
+        {"param", m.param},
+        {"component", m.component},
+        {"min", m.min},
+        {"max", m.max}
+    };
+}
+
+void from_json(const nlohmann::json& j, ControlMapping& m) {
+    if (j.contains("address")) j.at("address").get_to(m.address);
+    if (j.contains("preset")) j.at("preset").get_to(m.preset);
+    if (j.contains("param")) j.at("param").get_to(m.param);
+    if (j.contains("component")) j.at("component").get_to(m.component);
+    if (j.contains("min")) j.at("min").get_to(m.min);
+    if (j.contains("max")) j.at("max").get_to(m.max);
+}
+
+void to_json(nlohmann::json& j, const ChannelConfig& ch) {
+    j = nlohmann::json{
+        {"video", ch.video},
+        {"preset", ch.preset},
+        {"output", ch.output}
+    };
+}
+
+void from_json(const nlohmann::json& j, ChannelConfig& ch) {
+    if (j.contains("video")) j.at("video").get_to(ch.video);
+    if (j.contains("preset")) j.at("preset").get_to(ch.preset);
+    if (j.contains("output")) j.at("output").get_to(ch.output);
+}
+
+void to_json(nlohmann::json& j, const CanvasRegion& r) {
+    j = nlohmann::json{
+        {"x", r.x},
+        {"y", r.y},
+        {"width", r.width},
+        {"height", r.height},
+        {"blendLeft", r.blendLeft},
+        {"blendRight", r.blendRight},
+        {"blendTop", r.blendTop},
+        {"blendBottom", r.blendBottom},
+        {"blendGamma", r.blendGamma},
+        {"corners", r.corners}
+    };
+}
+
+void from_json(const nlohmann::json& j, CanvasRegion& r) {
+    if (j.contains("x")) j.at("x").get_to(r.x);
+    if (j.contains("y")) j.at("y").get_to(r.y);
+    if (j.contains("width")) j.at("width").get_to(r.width);
+    if (j.contains("height")) j.at("height").get_to(r.height);
+    if (j.contains("blendLeft")) j.at("blendLeft").get_to(r.blendLeft);
+    if (j.contains("blendRight")) j.at("blendRight").get_to(r.blendRight);
+    if (j.contains("blendTop")) j.at("blendTop").get_to(r.blendTop);
+    if (j.contains("blendBottom")) j.at("blendBottom").get_to(r.blendBottom);
+    if (j.contains("blendGamma")) j.at("blendGamma").get_to(r.blendGamma);
+    if (j.contains("corners")) j.at("corners").get_to(r.corners);
 }
 
 void to_json(nlohmann::json& j, const AppConfig& c) {
@@ -148,6 +314,9 @@ void to_json(nlohmann::json& j, const AppConfig& c) {
         {"autoCompileDelayMs", c.autoCompileDelayMs},
         {"lastOpenedVideo", c.lastOpenedVideo},
         {"shaderDirectory", c.shaderDirectory},
+        {"lazyShaderCompile", c.lazyShaderCompile},
+        {"residentShaderBudget", c.residentShaderBudget},
+        {"libraryThumbnails",    c.libraryThumbnails},
         {"layoutsDirectory", c.layoutsDirectory},
         {"editorPanelWidth", c.editorPanelWidth},
         {"libraryPanelHeight", c.libraryPanelHeight},
@@ -155,17 +324,100 @@ void to_json(nlohmann::json& j, const AppConfig& c) {
         {"showLibrary", c.showLibrary},
         {"showTransport", c.showTransport},
         {"timeDisplayFrames", c.timeDisplayFrames},
+        {"timelineOverview",  c.timelineOverview},
         {"noiseScale", c.noise.scale},
         {"noiseTextureSize", c.noise.textureSize},
+        {"noiseVolumeSize", c.noise.volumeSize},
+        {"hardwareDecode",    c.hardwareDecode},
+        {"hwDecodePolicy",    c.hwDecodePolicy},
+        {"gpuYuvConversion",  c.gpuYuvConversion},
+        {"videoProcessorConversion", c.videoProcessorConversion},
+        {"highBitDepth", c.highBitDepth},
+        {"decodeThreadCount", c.decodeThreadCount},
+        {"decodeThreadType",  c.decodeThreadType},
+        {"proxyScale",        c.proxyScale},
+        {"scrubCacheMB",      c.scrubCacheMB},
+        {"loopCacheMB",       c.loopCacheMB},
+        {"renderAheadFrames", c.renderAheadFrames},
+        {"reverseCacheMB",    c.reverseCacheMB},
+        {"probeSizeKB",       c.probeSizeKB},
+        {"analyzeDurationMs", c.analyzeDurationMs},
+        {"networkJitterMs",   c.networkJitterMs},
+        {"networkTcp",        c.networkTcp},
+        {"mediaFoundationCapture", c.mediaFoundationCapture},
+        {"ioReadAheadMB",     c.ioReadAheadMB},
+        {"editProxies",       c.editProxies},
+        {"proxyCacheDirectory", c.proxyCacheDirectory},
+        {"imageSequenceFps",  c.imageSequenceFps},
+        {"imageSequenceCacheMB", c.imageSequenceCacheMB},
+        {"videoInputs",       c.videoInputs},
+        {"lutFiles",          c.lutFiles},
+        {"layers",            c.layers},
+        {"deckVideo",         c.deckVideo},
+        {"deckPreset",        c.deckPreset},
+        {"deckTransition",    c.deckTransition},
+        {"channels",          c.channels},
+        {"canvasEnabled",     c.canvasEnabled},
+        {"canvasOutputs",     c.canvasOutputs},
+        {"playlist",          c.playlist},
+        {"postChains",        c.postChains},
+        {"syncMode",          c.syncMode},
+        {"stretchAudio",      c.stretchAudio},
         {"generativeWidth",   c.generativeWidth},
         {"generativeHeight",  c.generativeHeight},
         {"spoutEnabled",         c.spoutEnabled},
         {"spoutSenderName",      c.spoutSenderName},
+        {"spoutWidth",           c.spoutWidth},
+        {"spoutHeight",          c.spoutHeight},
+        {"spoutPass",            c.spoutPass},
+        {"ndiEnabled",           c.ndiEnabled},
+        {"ndiSenderName",        c.ndiSenderName},
+        {"ndiWidth",             c.ndiWidth},
+        {"ndiHeight",            c.ndiHeight},
+        {"virtualCameraEnabled", c.virtualCameraEnabled},
+        {"virtualCameraName",    c.virtualCameraName},
+        {"oscEnabled",           c.oscEnabled},
+        {"oscPort",              c.oscPort},
+        {"midiDevice",           c.midiDevice},
+        {"controlMappings",      c.controlMappings},
+        {"metricsEnabled",       c.metricsEnabled},
+        {"metricsPort",          c.metricsPort},
+        {"watchdogEnabled",      c.watchdogEnabled},
+        {"watchdogStallMs",      c.watchdogStallMs},
+        {"watchdogGpuMs",        c.watchdogGpuMs},
+        {"frameSyncRole",        c.frameSyncRole},
+        {"frameSyncPort",        c.frameSyncPort},
+        {"dynamicResolution",         c.dynamicResolution},
+        {"dynamicResolutionTargetMs", c.dynamicResolutionTargetMs},
+        {"dynamicResolutionMinScale", c.dynamicResolutionMinScale},
+        {"upscaleFilter",             c.upscaleFilter},
+        {"upscaleSharpness",          c.upscaleSharpness},
+        {"backgroundGpuBudgetMs",     c.backgroundGpuBudgetMs},
+        {"renderTileSize",            c.renderTileSize},
+        {"renderTilesPerFrame",       c.renderTilesPerFrame},
+        {"previewAtViewportSize",     c.previewAtViewportSize},
+        {"gpuAdapter",                c.gpuAdapter},
+        {"sharedShaderCache",         c.sharedShaderCache},
+        {"lowLatencyPresent",    c.lowLatencyPresent},
+        {"vsync",                c.vsync},
+        {"frameRateCap",         c.frameRateCap},
+        {"batteryFrameRateCap",  c.batteryFrameRateCap},
+        {"uiRefreshHz",          c.uiRefreshHz},
+        {"uiIdleRebuildHz",      c.uiIdleRebuildHz},
+        {"threadPriorities",     c.threadPriorities},
+        {"traceSeconds",         c.traceSeconds},
         {"audioBeatSensitivity", c.audio.beatSensitivity},
         {"audioBeatDecay",       c.audio.beatDecay},
         {"audioSmoothing",       c.audio.smoothing},
+        {"audioFftSize",         c.audio.fftSize},
+        {"audioMultiResolution", c.audio.multiResolution},
+        {"audioLogSpectrum",     c.audio.logSpectrum},
+        {"audioPreAnalysis",     c.audioPreAnalysis},
+        {"audioInput",           c.audioInput},
+        {"audioInputDevice",     c.audioInputDevice},
         {"audioVolume",          c.audioVolume},
         {"muteAudio",            c.muteAudio},
+        {"audioLowLatency",      c.audioLowLatency},
         {"passthroughKey",       c.passthroughKey},
         {"passthroughModifiers", c.passthroughModifiers}
     };
@@ -178,6 +430,9 @@ void from_json(const nlohmann::json& j, AppConfig& c) {
     if (j.contains("autoCompileDelayMs")) j.at("autoCompileDelayMs").get_to(c.autoCompileDelayMs);
     if (j.contains("lastOpenedVideo")) j.at("lastOpenedVideo").get_to(c.lastOpenedVideo);
     if (j.contains("shaderDirectory")) j.at("shaderDirectory").get_to(c.shaderDirectory);
+    if (j.contains("lazyShaderCompile")) j.at("lazyShaderCompile").get_to(c.lazyShaderCompile);
+    if (j.contains("residentShaderBudget")) j.at("residentShaderBudget").get_to(c.residentShaderBudget);
+    if (j.contains("libraryThumbnails"))    j.at("libraryThumbnails").get_to(c.libraryThumbnails);
     if (j.contains("layoutsDirectory")) j.at("layoutsDirectory").get_to(c.layoutsDirectory);
     if (j.contains("editorPanelWidth")) j.at("editorPanelWidth").get_to(c.editorPanelWidth);
     if (j.contains("libraryPanelHeight")) j.at("libraryPanelHeight").get_to(c.libraryPanelHeight);
@@ -185,23 +440,124 @@ void from_json(const nlohmann::json& j, AppConfig& c) {
     if (j.contains("showLibrary")) j.at("showLibrary").get_to(c.showLibrary);
     if (j.contains("showTransport")) j.at("showTransport").get_to(c.showTransport);
     if (j.contains("timeDisplayFrames")) j.at("timeDisplayFrames").get_to(c.timeDisplayFrames);
+    if (j.contains("timelineOverview"))  j.at("timelineOverview").get_to(c.timelineOverview);
     if (j.contains("noiseScale"))       j.at("noiseScale").get_to(c.noise.scale);
     if (j.contains("noiseTextureSize")) j.at("noiseTextureSize").get_to(c.noise.textureSize);
+    if (j.contains("noiseVolumeSize"))  j.at("noiseVolumeSize").get_to(c.noise.volumeSize);
+    if (j.contains("hardwareDecode"))   j.at("hardwareDecode").get_to(c.hardwareDecode);
+    if (j.contains("hwDecodePolicy"))   j.at("hwDecodePolicy").get_to(c.hwDecodePolicy);
+    if (j.contains("gpuYuvConversion")) j.at("gpuYuvConversion").get_to(c.gpuYuvConversion);
+    if (j.contains("videoProcessorConversion")) j.at("videoProcessorConversion").get_to(c.videoProcessorConversion);
+    if (j.contains("highBitDepth")) j.at("highBitDepth").get_to(c.highBitDepth);
+    if (j.contains("decodeThreadCount")) j.at("decodeThreadCount").get_to(c.decodeThreadCount);
+    if (j.contains("decodeThreadType"))  j.at("decodeThreadType").get_to(c.decodeThreadType);
+    if (j.contains("proxyScale"))        j.at("proxyScale").get_to(c.proxyScale);
+    if (j.contains("scrubCacheMB"))      j.at("scrubCacheMB").get_to(c.scrubCacheMB);
+    if (j.contains("loopCacheMB"))       j.at("loopCacheMB").get_to(c.loopCacheMB);
+    if (j.contains("renderAheadFrames")) j.at("renderAheadFrames").get_to(c.renderAheadFrames);
+    if (j.contains("reverseCacheMB"))    j.at("reverseCacheMB").get_to(c.reverseCacheMB);
+    if (j.contains("probeSizeKB"))       j.at("probeSizeKB").get_to(c.probeSizeKB);
+    if (j.contains("analyzeDurationMs")) j.at("analyzeDurationMs").get_to(c.analyzeDurationMs);
+    if (j.contains("networkJitterMs"))   j.at("networkJitterMs").get_to(c.networkJitterMs);
+    if (j.contains("networkTcp"))        j.at("networkTcp").get_to(c.networkTcp);
+    if (j.contains("mediaFoundationCapture")) j.at("mediaFoundationCapture").get_to(c.mediaFoundationCapture);
+    if (j.contains("ioReadAheadMB"))     j.at("ioReadAheadMB").get_to(c.ioReadAheadMB);
+    if (j.contains("editProxies"))       j.at("editProxies").get_to(c.editProxies);
+    if (j.contains("proxyCacheDirectory")) j.at("proxyCacheDirectory").get_to(c.proxyCacheDirectory);
+    if (j.contains("imageSequenceFps"))  j.at("imageSequenceFps").get_to(c.imageSequenceFps);
+    if (j.contains("imageSequenceCacheMB")) j.at("imageSequenceCacheMB").get_to(c.imageSequenceCacheMB);
+    if (j.contains("videoInputs"))       j.at("videoInputs").get_to(c.videoInputs);
+    if (j.contains("lutFiles"))          j.at("lutFiles").get_to(c.lutFiles);
+    if (j.contains("layers"))            j.at("layers").get_to(c.layers);
+    if (c.layers.size() > static_cast<size_t>(MAX_LAYERS)) c.layers.resize(MAX_LAYERS);
+    if (j.contains("deckVideo"))         j.at("deckVideo").get_to(c.deckVideo);
+    if (j.contains("deckPreset"))        j.at("deckPreset").get_to(c.deckPreset);
+    if (j.contains("deckTransition"))    j.at("deckTransition").get_to(c.deckTransition);
+    if (j.contains("channels"))          j.at("channels").get_to(c.channels);
+    if (c.channels.size() > static_cast<size_t>(MAX_CHANNELS)) c.channels.resize(MAX_CHANNELS);
+    if (j.contains("canvasEnabled"))     j.at("canvasEnabled").get_to(c.canvasEnabled);
+    if (j.contains("canvasOutputs"))     j.at("canvasOutputs").get_to(c.canvasOutputs);
+    if (c.canvasOutputs.size() > static_cast<size_t>(MAX_CANVAS_OUTPUTS)) c.canvasOutputs.resize(MAX_CANVAS_OUTPUTS);
+    if (j.contains("playlist"))          j.at("playlist").get_to(c.playlist);
+    if (j.contains("postChains"))        j.at("postChains").get_to(c.postChains);
+    c.postChains.resize(POST_OUTPUT_COUNT);
+    for (auto& chain : c.postChains) {
+        if (chain.size() > static_cast<size_t>(MAX_POST_STAGES)) chain.resize(MAX_POST_STAGES);
+    }
+    if (j.contains("syncMode"))          j.at("syncMode").get_to(c.syncMode);
+    if (j.contains("stretchAudio"))      j.at("stretchAudio").get_to(c.stretchAudio);
     if (j.contains("generativeWidth"))  j.at("generativeWidth").get_to(c.generativeWidth);
     if (j.contains("generativeHeight")) j.at("generativeHeight").get_to(c.generativeHeight);
     if (j.contains("spoutEnabled"))         j.at("spoutEnabled").get_to(c.spoutEnabled);
     if (j.contains("spoutSenderName"))      j.at("spoutSenderName").get_to(c.spoutSenderName);
+    if (j.contains("spoutWidth"))           j.at("spoutWidth").get_to(c.spoutWidth);
+    if (j.contains("spoutHeight"))          j.at("spoutHeight").get_to(c.spoutHeight);
+    if (j.contains("spoutPass"))            j.at("spoutPass").get_to(c.spoutPass);
+    if (j.contains("ndiEnabled"))           j.at("ndiEnabled").get_to(c.ndiEnabled);
+    if (j.contains("ndiSenderName"))        j.at("ndiSenderName").get_to(c.ndiSenderName);
+    if (j.contains("ndiWidth"))             j.at("ndiWidth").get_to(c.ndiWidth);
+    if (j.contains("ndiHeight"))            j.at("ndiHeight").get_to(c.ndiHeight);
+    if (j.contains("virtualCameraEnabled")) j.at("virtualCameraEnabled").get_to(c.virtualCameraEnabled);
+    if (j.contains("virtualCameraName"))    j.at("virtualCameraName").get_to(c.virtualCameraName);
+    if (j.contains("oscEnabled"))           j.at("oscEnabled").get_to(c.oscEnabled);
+    if (j.contains("oscPort"))              j.at("oscPort").get_to(c.oscPort);
+    if (j.contains("midiDevice"))           j.at("midiDevice").get_to(c.midiDevice);
+    if (j.contains("controlMappings"))      j.at("controlMappings").get_to(c.controlMappings);
+    if (j.contains("metricsEnabled"))       j.at("metricsEnabled").get_to(c.metricsEnabled);
+    if (j.contains("metricsPort"))          j.at("metricsPort").get_to(c.metricsPort);
+    if (j.contains("watchdogEnabled"))      j.at("watchdogEnabled").get_to(c.watchdogEnabled);
+    if (j.contains("watchdogStallMs"))      j.at("watchdogStallMs").get_to(c.watchdogStallMs);
+    if (j.contains("watchdogGpuMs"))        j.at("watchdogGpuMs").get_to(c.watchdogGpuMs);
+    if (j.contains("frameSyncRole"))        j.at("frameSyncRole").get_to(c.frameSyncRole);
+    if (j.contains("frameSyncPort"))        j.at("frameSyncPort").get_to(c.frameSyncPort);
+    if (j.contains("dynamicResolution"))    j.at("dynamicResolution").get_to(c.dynamicResolution);
+    if (j.contains("dynamicResolutionTargetMs")) j.at("dynamicResolutionTargetMs").get_to(c.dynamicResolutionTargetMs);
+    if (j.contains("dynamicResolutionMinScale")) j.at("dynamicResolutionMinScale").get_to(c.dynamicResolutionMinScale);
+    if (j.contains("upscaleFilter"))        j.at("upscaleFilter").get_to(c.upscaleFilter);
+    if (j.contains("upscaleSharpness"))     j.at("upscaleSharpness").get_to(c.upscaleSharpness);
+    if (j.contains("backgroundGpuBudgetMs")) j.at("backgroundGpuBudgetMs").get_to(c.backgroundGpuBudgetMs);
+    if (j.contains("renderTileSize"))       j.at("renderTileSize").get_to(c.renderTileSize);
+    if (j.contains("renderTilesPerFrame"))  j.at("renderTilesPerFrame").get_to(c.renderTilesPerFrame);
+    if (j.contains("previewAtViewportSize")) j.at("previewAtViewportSize").get_to(c.previewAtViewportSize);
+    if (j.contains("gpuAdapter"))           j.at("gpuAdapter").get_to(c.gpuAdapter);
+    if (j.contains("sharedShaderCache"))    j.at("sharedShaderCache").get_to(c.sharedShaderCache);
+    if (j.contains("lowLatencyPresent"))    j.at("lowLatencyPresent").get_to(c.lowLatencyPresent);
+    if (j.contains("vsync"))                j.at("vsync").get_to(c.vsync);
+    if (j.contains("frameRateCap"))         j.at("frameRateCap").get_to(c.frameRateCap);
+    if (j.contains("batteryFrameRateCap"))  j.at("batteryFrameRateCap").get_to(c.batteryFrameRateCap);
+    if (j.contains("uiRefreshHz"))          j.at("uiRefreshHz").get_to(c.uiRefreshHz);
+    if (j.contains("uiIdleRebuildHz"))      j.at("uiIdleRebuildHz").get_to(c.uiIdleRebuildHz);
+    if (j.contains("threadPriorities"))     j.at("threadPriorities").get_to(c.threadPriorities);
+    if (j.contains("traceSeconds"))         j.at("traceSeconds").get_to(c.traceSeconds);
     if (j.contains("audioBeatSensitivity")) j.at("audioBeatSensitivity").get_to(c.audio.beatSensitivity);
     if (j.contains("audioBeatDecay"))       j.at("audioBeatDecay").get_to(c.audio.beatDecay);
     if (j.contains("audioSmoothing"))       j.at("audioSmoothing").get_to(c.audio.smoothing);
+    if (j.contains("audioFftSize"))         j.at("audioFftSize").get_to(c.audio.fftSize);
+    if (j.contains("audioMultiResolution")) j.at("audioMultiResolution").get_to(c.audio.multiResolution);
+    if (j.contains("audioLogSpectrum"))     j.at("audioLogSpectrum").get_to(c.audio.logSpectrum);
+    if (j.contains("audioPreAnalysis"))     j.at("audioPreAnalysis").get_to(c.audioPreAnalysis);
+    if (j.contains("audioInput"))           j.at("audioInput").get_to(c.audioInput);
+    if (j.contains("audioInputDevice"))     j.at("audioInputDevice").get_to(c.audioInputDevice);
     if (j.contains("audioVolume"))          j.at("audioVolume").get_to(c.audioVolume);
     if (j.contains("muteAudio"))            j.at("muteAudio").get_to(c.muteAudio);
+    if (j.contains("audioLowLatency"))      j.at("audioLowLatency").get_to(c.audioLowLatency);
     if (j.contains("passthroughKey"))       j.at("passthroughKey").get_to(c.passthroughKey);
     if (j.contains("passthroughModifiers")) j.at("passthroughModifiers").get_to(c.passthroughModifiers);
 }
 
 ConfigManager::ConfigManager() = default;
 
+ConfigManager::~ConfigManager() {
+    if (m_writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_writerMutex);
+            m_stopWriter = true;
+        }
+        m_writerCv.notify_all();
+        m_writer.join();
+    }
+}
+
 bool ConfigManager::Load(const std::string& filepath) {
     std::ifstream file(filepath);
     if (!file.is_open()) {
@@ -212,25 +568,73 @@ bool ConfigManager::Load(const std::string& filepath) {
         nlohmann::json j;
         file >> j;
         m_config = j.get<AppConfig>();
-        return true;
     } catch (const std::exception&) {
         return false;
     }
+    // Keyframes from before the store are in config.json; the store wins
+    KeyframeStore::Read(GetKeyframesPath(filepath), m_config.shaderPresets);
+    return true;
 }
 
 bool ConfigManager::Save(const std::string& filepath) const {
-    std::ofstream file(filepath);
-    if (!file.is_open()) {
-        return false;
+    AppConfig snapshot = m_config;
+    return WriteFiles(filepath, snapshot);
+}
+
+void ConfigManager::SaveAsync(const std::string& filepath) {
+    auto snapshot = std::make_unique<AppConfig>(m_config);
+    {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        m_pending     = std::move(snapshot);
+        m_pendingPath = filepath;
+        if (!m_writer.joinable()) m_writer = std::thread(&ConfigManager::WriterThread, this);
+    }
+    m_writerCv.notify_all();
+}
+
+void ConfigManager::WaitForSave() {
+    std::unique_lock<std::mutex> lock(m_writerMutex);
+    m_writerCv.wait(lock, [this] { return !m_pending && !m_writing; });
+}
+
+void ConfigManager::WriterThread() {
+    TraceRecorder::SetThreadName("Config writer");
+    ThreadPriority::Apply(ThreadRole::Background);
+    std::unique_lock<std::mutex> lock(m_writerMutex);
+    for (;;) {
+        m_writerCv.wait(lock, [this] { return m_pending || m_stopWriter; });
+        if (!m_pending) return;  // Stopping with nothing left to write
+        std::unique_ptr<AppConfig> snapshot = std::move(m_pending);
+        const std::string filepath = m_pendingPath;
+        m_writing = true;
+        lock.unlock();
+        WriteFiles(filepath, *snapshot);
+        snapshot.reset();
+        lock.lock();
+        m_writing = false;
+        m_writerCv.notify_all();  // WaitForSave
     }
+}
 
+bool ConfigManager::WriteFiles(const std::string& filepath, AppConfig& config) {
+    // Timelines go to the store; config.json then only carries the settings
+    const std::vector<char> keys = KeyframeStore::Serialize(config.shaderPresets);
+    if (!WriteFileAtomically(GetKeyframesPath(filepath), keys.data(), keys.size())) return false;
+    for (ShaderPreset& preset : config.shaderPresets) {
+        for (ShaderParam& param : preset.params) param.timeline.reset();
+    }
+
+    std::string text;
     try {
-        nlohmann::json j = m_config;
-        file << j.dump(2);
-        return true;
+        text = nlohmann::json(config).dump(2);
     } catch (const std::exception&) {
         return false;
     }
+    return WriteFileAtomically(filepath, text.data(), text.size());
+}
+
+std::filesystem::path ConfigManager::GetKeyframesPath(const std::string& configPath) {
+    return std::filesystem::path(configPath).replace_extension(".keys");
 }
 
 std::string ConfigManager::GetDefaultConfigPath() {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common.h"
+#include <condition_variable>
 #include <nlohmann/json.hpp>
 
 namespace SP {
@@ -8,21 +9,48 @@ namespace SP {
 class ConfigManager {
 public:
     ConfigManager();
-    ~ConfigManager() = default;
+    ~ConfigManager();  // Writes a pending SaveAsync snapshot first
 
-    // Load/Save
+    // Non-copyable
+    ConfigManager(const ConfigManager&) = delete;
+    ConfigManager& operator=(const ConfigManager&) = delete;
+
+    // Load/Save. Keyframe timelines live in a binary store beside the config
+    // (KeyframeStore, GetKeyframesPath); config.json keeps the settings. Saves
+    // replace each file atomically (temp file + rename), so a crash mid-write
+    // leaves the previous one.
     bool Load(const std::string& filepath);
     bool Save(const std::string& filepath) const;
-    
+    // Copies the config now and serialises + writes the copy on a writer
+    // thread. A snapshot not yet written is replaced by the newer one.
+    void SaveAsync(const std::string& filepath);
+    // Blocks until every SaveAsync snapshot is on disk
+    void WaitForSave();
+
     // Access
     AppConfig& GetConfig() { return m_config; }
     const AppConfig& GetConfig() const { return m_config; }
 
     // Default config path
     static std::string GetDefaultConfigPath();
+    // config.keys for config.json
+    static std::filesystem::path GetKeyframesPath(const std::string& configPath);
 
 private:
+    // config.json and its keyframe store; takes the timelines out of `config`
+    static bool WriteFiles(const std::string& filepath, AppConfig& config);
+    void WriterThread();
+
     AppConfig m_config;
+
+    // SaveAsync writer, started on the first call
+    std::thread             m_writer;
+    std::mutex              m_writerMutex;
+    std::condition_variable m_writerCv;
+    std::unique_ptr<AppConfig> m_pending;  // Next snapshot to write
+    std::string m_pendingPath;
+    bool m_writing    = false;
+    bool m_stopWriter = false;
 };
 
 // JSON serialization
@@ -30,6 +58,14 @@ void to_json(nlohmann::json& j, const ShaderPreset& p);
 void from_json(const nlohmann::json& j, ShaderPreset& p);
 void to_json(nlohmann::json& j, const RecordingSettings& r);
 void from_json(const nlohmann::json& j, RecordingSettings& r);
+void to_json(nlohmann::json& j, const CompositeLayer& l);
+void from_json(const nlohmann::json& j, CompositeLayer& l);
+void to_json(nlohmann::json& j, const ControlMapping& m);
+void from_json(const nlohmann::json& j, ControlMapping& m);
+void to_json(nlohmann::json& j, const ChannelConfig& ch);
+void from_json(const nlohmann::json& j, ChannelConfig& ch);
+void to_json(nlohmann::json& j, const CanvasRegion& r);
+void from_json(const nlohmann::json& j, CanvasRegion& r);
 void to_json(nlohmann::json& j, const AppConfig& c);
 void from_json(const nlohmann::json& j, AppConfig& c);
 
@@ -0,0 +1,287 @@
+#include "ControlInput.h"
+#include "ThreadPriority.h"
+#include <winsock2.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace SP {
+
+namespace {
+
+constexpr size_t OSC_MAX_PACKET  = 65536;  // Largest UDP payload
+constexpr int    OSC_MAX_NESTING = 4;      // Bundles inside bundles
+
+std::string WideToUtf8(const wchar_t* text) {
+    const int size = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    if (size <= 1) return {};
+    std::string out(static_cast<size_t>(size - 1), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, out.data(), size, nullptr, nullptr);
+    return out;
+}
+
+uint32_t ReadBigEndian32(const char* p) {
+    const auto* b = reinterpret_cast<const unsigned char*>(p);
+    return (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) | uint32_t(b[3]);
+}
+
+uint64_t ReadBigEndian64(const char* p) {
+    return (uint64_t(ReadBigEndian32(p)) << 32) | ReadBigEndian32(p + 4);
+}
+
+// OSC strings are NUL-terminated and padded to four bytes. Length without the
+// NUL, or -1 when it runs past `size`.
+int OscStringLength(const char* data, size_t size) {
+    const void* end = std::memchr(data, '\0', size);
+    return end ? static_cast<int>(static_cast<const char*>(end) - data) : -1;
+}
+
+size_t OscPadded(size_t length) { return (length + 4) & ~size_t(3); }
+
+} // namespace
+
+ControlInput::ControlInput() : m_slots(std::make_unique<Slot[]>(QUEUE_SIZE)) {
+    static_assert((QUEUE_SIZE & (QUEUE_SIZE - 1)) == 0, "QUEUE_SIZE must be a power of two");
+    for (uint64_t i = 0; i < QUEUE_SIZE; ++i) m_slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+ControlInput::~ControlInput() {
+    StopMidi();
+    StopOsc();
+}
+
+void ControlInput::Push(const char* address, size_t length, float value) {
+    uint64_t pos = m_tail.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = m_slots[pos & (QUEUE_SIZE - 1)];
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence == pos) {
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                length = std::min(length, sizeof(slot.event.address) - 1);
+                std::memcpy(slot.event.address, address, length);
+                slot.event.address[length] = '\0';
+                slot.event.value = value;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return;
+            }
+            // Another producer took it; pos now holds the new tail
+        } else if (sequence < pos) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);  // Full: the consumer is a lap behind
+            return;
+        } else {
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool ControlInput::Pop(ControlEvent& event) {
+    Slot& slot = m_slots[m_head & (QUEUE_SIZE - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != m_head + 1) return false;
+    event = slot.event;
+    slot.sequence.store(m_head + QUEUE_SIZE, std::memory_order_release);
+    ++m_head;
+    return true;
+}
+
+// --- OSC ---
+
+bool ControlInput::StartOsc(int port) {
+    StopOsc();
+    m_error.clear();
+    if (!m_wsaStarted) {
+        WSADATA wsa{};
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+            m_error = "Winsock unavailable";
+            return false;
+        }
+        m_wsaStarted = true;
+    }
+
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) {
+        m_error = "Could not create a UDP socket";
+        return false;
+    }
+    // Room for a burst of moves while the thread is descheduled
+    const int receiveBuffer = 1 << 20;
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receiveBuffer), sizeof(receiveBuffer));
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port        = htons(static_cast<u_short>(port));
+    if (bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR) {
+        closesocket(s);
+        m_error = "UDP port " + std::to_string(port) + " is in use";
+        return false;
+    }
+
+    m_socket = static_cast<uintptr_t>(s);
+    m_oscStop.store(false, std::memory_order_relaxed);
+    m_oscThread = std::thread(&ControlInput::OscThread, this);
+    return true;
+}
+
+void ControlInput::StopOsc() {
+    if (m_oscThread.joinable()) {
+        m_oscStop.store(true, std::memory_order_relaxed);
+        closesocket(static_cast<SOCKET>(m_socket));  // Wakes the blocked recv
+        m_oscThread.join();
+        m_socket = static_cast<uintptr_t>(INVALID_SOCKET);
+    }
+    if (m_wsaStarted) {
+        WSACleanup();
+        m_wsaStarted = false;
+    }
+}
+
+void ControlInput::OscThread() {
+    ThreadPriority::Apply(ThreadRole::Playback);
+    std::vector<char> packet(OSC_MAX_PACKET);
+    const SOCKET s = static_cast<SOCKET>(m_socket);
+    while (!m_oscStop.load(std::memory_order_relaxed)) {
+        const int received = recv(s, packet.data(), static_cast<int>(packet.size()), 0);
+        if (received == SOCKET_ERROR) {
+            if (WSAGetLastError() == WSAEMSGSIZE) continue;  // Oversized datagram: skip it
+            break;  // Closed by StopOsc
+        }
+        if (received > 0) ParseOsc(packet.data(), static_cast<size_t>(received), 0);
+    }
+}
+
+void ControlInput::ParseOsc(const char* data, size_t size, int depth) {
+    if (size < 4) return;
+
+    // Bundle: "#bundle", a time tag (ignored: moves apply on arrival), then
+    // size-prefixed elements, each a message or another bundle
+    if (size >= 16 && std::memcmp(data, "#bundle", 8) == 0) {
+        if (depth >= OSC_MAX_NESTING) return;
+        size_t offset = 16;
+        while (offset + 4 <= size) {
+            const size_t element = ReadBigEndian32(data + offset);
+            offset += 4;
+            if (element > size - offset) return;
+            ParseOsc(data + offset, element, depth + 1);
+            offset += element;
+        }
+        return;
+    }
+
+    if (data[0] != '/') return;
+    const int addressLength = OscStringLength(data, size);
+    if (addressLength < 0) return;
+    size_t offset = OscPadded(static_cast<size_t>(addressLength));
+
+    // No type tag or no arguments: a trigger
+    float value = 1.0f;
+    if (offset < size && data[offset] == ',') {
+        const int tagLength = OscStringLength(data + offset, size - offset);
+        if (tagLength < 0) return;
+        const char tag = tagLength > 1 ? data[offset + 1] : '\0';
+        const size_t args = offset + OscPadded(static_cast<size_t>(tagLength));
+        switch (tag) {
+        case 'f':
+            if (args + 4 > size) return;
+            {
+                const uint32_t bits = ReadBigEndian32(data + args);
+                std::memcpy(&value, &bits, sizeof(value));
+            }
+            break;
+        case 'd':
+            if (args + 8 > size) return;
+            {
+                const uint64_t bits = ReadBigEndian64(data + args);
+                double d;
+                std::memcpy(&d, &bits, sizeof(d));
+                value = static_cast<float>(d);
+            }
+            break;
+        case 'i':
+            if (args + 4 > size) return;
+            value = static_cast<float>(static_cast<int32_t>(ReadBigEndian32(data + args)));
+            break;
+        case 'h':
+            if (args + 8 > size) return;
+            value = static_cast<float>(static_cast<int64_t>(ReadBigEndian64(data + args)));
+            break;
+        case 'T': value = 1.0f; break;
+        case 'F': value = 0.0f; break;
+        case '\0': break;
+        default: return;  // Strings, blobs: nothing to map
+        }
+    }
+    Push(data, static_cast<size_t>(addressLength), value);
+}
+
+// --- MIDI ---
+
+std::vector<std::string> ControlInput::ListMidiDevices() {
+    std::vector<std::string> devices;
+    const UINT count = midiInGetNumDevs();
+    for (UINT i = 0; i < count; ++i) {
+        MIDIINCAPSW caps{};
+        if (midiInGetDevCapsW(i, &caps, sizeof(caps)) == MMSYSERR_NOERROR) devices.push_back(WideToUtf8(caps.szPname));
+    }
+    return devices;
+}
+
+bool ControlInput::StartMidi(const std::string& device) {
+    StopMidi();
+    m_error.clear();
+    const std::vector<std::string> devices = ListMidiDevices();
+    auto it = std::find(devices.begin(), devices.end(), device);
+    if (it == devices.end()) {
+        m_error = "MIDI device not found: " + device;
+        return false;
+    }
+    const UINT id = static_cast<UINT>(it - devices.begin());
+    if (midiInOpen(&m_midi, id, reinterpret_cast<DWORD_PTR>(&MidiCallback), reinterpret_cast<DWORD_PTR>(this),
+                   CALLBACK_FUNCTION) != MMSYSERR_NOERROR) {
+        m_midi  = nullptr;
+        m_error = "Could not open MIDI device (in use by another program?)";
+        return false;
+    }
+    midiInStart(m_midi);
+    return true;
+}
+
+void ControlInput::StopMidi() {
+    if (!m_midi) return;
+    midiInStop(m_midi);
+    midiInReset(m_midi);
+    midiInClose(m_midi);
+    m_midi = nullptr;
+}
+
+void CALLBACK ControlInput::MidiCallback(HMIDIIN, UINT message, DWORD_PTR instance, DWORD_PTR param1, DWORD_PTR) {
+    if (message != MIM_DATA) return;
+    auto* self = reinterpret_cast<ControlInput*>(instance);
+    const int status  = static_cast<int>(param1 & 0xFF);
+    const int data1   = static_cast<int>((param1 >> 8) & 0x7F);
+    const int data2   = static_cast<int>((param1 >> 16) & 0x7F);
+    const int channel = (status & 0x0F) + 1;
+
+    // Runs on winmm's thread: format into a stack buffer, no allocation
+    char address[32];
+    int length;
+    float value;
+    switch (status & 0xF0) {
+    case 0xB0:  // Control change
+        length = snprintf(address, sizeof(address), "/midi/%d/cc/%d", channel, data1);
+        value  = data2 / 127.0f;
+        break;
+    case 0x90:  // Note on; velocity 0 is a note off
+    case 0x80:
+        length = snprintf(address, sizeof(address), "/midi/%d/note/%d", channel, data1);
+        value  = (status & 0xF0) == 0x90 ? data2 / 127.0f : 0.0f;
+        break;
+    case 0xE0:  // Pitch bend, 14 bits
+        length = snprintf(address, sizeof(address), "/midi/%d/bend", channel);
+        value  = static_cast<float>((data2 << 7) | data1) / 16383.0f;
+        break;
+    default:
+        return;
+    }
+    if (length > 0) self->Push(address, static_cast<size_t>(length), value);
+}
+
+} // namespace SP
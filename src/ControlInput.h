@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Common.h"
+#include <mmsystem.h>
+
+namespace SP {
+
+// A controller move as the listeners queue it: the address and its first value.
+// OSC senders send normalised values; MIDI arrives as 0..127 and is divided down.
+struct ControlEvent {
+    char  address[64];  // Truncated, NUL-terminated
+    float value;
+};
+
+// OSC (UDP) and MIDI controller input for lighting desks and control surfaces.
+// The OSC listener has its own thread and MIDI arrives on winmm's callback
+// thread; both push into a bounded lock-free MPSC ring, so neither ever waits
+// on the main thread or on each other. The main thread pops everything at the
+// top of RenderFrame, so a move lands in the next rendered frame however busy
+// the UI is. MIDI messages are spelled as addresses ("/midi/<channel>/cc/<n>",
+// "/midi/<channel>/note/<n>", "/midi/<channel>/bend"), so mappings treat both
+// alike. Start and Stop are main-thread calls.
+class ControlInput {
+public:
+    static constexpr int QUEUE_SIZE = 1024;  // Power of two
+
+    ControlInput();
+    ~ControlInput();
+
+    ControlInput(const ControlInput&) = delete;
+    ControlInput& operator=(const ControlInput&) = delete;
+
+    // Listen for OSC messages and bundles on UDP `port` (all interfaces).
+    // False with GetError() set when the port could not be bound.
+    bool StartOsc(int port);
+    void StopOsc();
+    bool IsOscRunning() const { return m_oscThread.joinable(); }
+
+    // Open the MIDI input named `device` (see ListMidiDevices)
+    bool StartMidi(const std::string& device);
+    void StopMidi();  // The callback has returned for good when this does
+    bool IsMidiRunning() const { return m_midi != nullptr; }
+    static std::vector<std::string> ListMidiDevices();
+
+    const std::string& GetError() const { return m_error; }
+
+    // Main thread: the oldest queued event, false when the queue is empty
+    bool Pop(ControlEvent& event);
+    // Events lost to a full queue (the main thread stalled for QUEUE_SIZE moves)
+    int64_t GetDroppedEvents() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    // Any thread. Claims a slot with a CAS on m_tail and publishes it through the
+    // slot's sequence, so producers never block each other or the consumer.
+    void Push(const char* address, size_t length, float value);
+    void OscThread();
+    void ParseOsc(const char* data, size_t size, int depth);
+    static void CALLBACK MidiCallback(HMIDIIN handle, UINT message, DWORD_PTR instance,
+                                      DWORD_PTR param1, DWORD_PTR param2);
+
+    // Bounded MPSC ring: slot i is free for the push at position p when its
+    // sequence equals p, and ready for the pop at p when it equals p + 1
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        ControlEvent event{};
+    };
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(64) std::atomic<uint64_t> m_tail{0};  // Next push position
+    alignas(64) uint64_t m_head = 0;              // Next pop position (main thread only)
+    std::atomic<int64_t> m_dropped{0};
+
+    uintptr_t         m_socket = ~static_cast<uintptr_t>(0);  // SOCKET; INVALID_SOCKET when closed
+    bool              m_wsaStarted = false;
+    std::thread       m_oscThread;
+    std::atomic<bool> m_oscStop{false};
+
+    HMIDIIN     m_midi = nullptr;
+    std::string m_error;
+};
+
+} // namespace SP
@@ -0,0 +1,152 @@
+#include "CpuProfiler.h"
+#include <algorithm>
+
+namespace SP {
+
+namespace {
+
+constexpr const char* STAGE_NAMES[CPU_STAGE_COUNT] = {
+    "Latency wait", "Messages", "Shader watch", "Decode", "Audio", "Inputs", "Upload",
+    "Keyframes", "Render", "UI build", "UI draw", "Present", "Background",
+};
+
+// A hitch is at least twice the baseline and HITCH_MIN_MS over it, once the
+// baseline has settled for BASELINE_WARMUP ticks
+constexpr float   HITCH_RATIO     = 2.0f;
+constexpr float   HITCH_MIN_MS    = 4.0f;
+constexpr int64_t BASELINE_WARMUP = 30;
+constexpr float   BASELINE_ALPHA  = 1.0f / 30.0f;
+
+} // namespace
+
+CpuProfiler::CpuProfiler() : m_startTime(Clock::now()) {}
+
+const char* CpuProfiler::StageName(CpuStage stage) {
+    return STAGE_NAMES[static_cast<int>(stage)];
+}
+
+void CpuProfiler::BeginFrame() {
+    const Clock::time_point now = Clock::now();
+    const HeapCounters heap = GetThreadHeapCounters();
+    TraceRecorder::Get().MarkFrame();
+    if (m_started) {
+        m_current.frameMs        = std::chrono::duration<float, std::milli>(now - m_frameStart).count();
+        m_current.frame          = m_frameCount++;
+        m_current.allocations    = heap.allocations - m_heapAtStart.allocations;
+        m_current.allocatedBytes = heap.bytes - m_heapAtStart.bytes;
+        Publish(m_current, std::chrono::duration<double>(m_frameStart - m_startTime).count());
+    }
+    m_current     = CpuFrameTiming{};
+    m_frameStart  = now;
+    m_heapAtStart = heap;
+    m_started     = true;
+}
+
+void CpuProfiler::Publish(const CpuFrameTiming& timing, double time) {
+    // Hitch check against the baseline before this tick; a hitch only nudges it
+    const bool warm = timing.frame >= BASELINE_WARMUP;
+    const bool hitch = warm && timing.frameMs > m_baselineMs * HITCH_RATIO &&
+                       timing.frameMs - m_baselineMs > HITCH_MIN_MS;
+    const float baselineMs = m_baselineMs;
+    const float sample = warm ? std::min(timing.frameMs, m_baselineMs * HITCH_RATIO) : timing.frameMs;
+    m_baselineMs = (timing.frame == 0) ? sample : m_baselineMs + (sample - m_baselineMs) * BASELINE_ALPHA;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_history[m_next] = timing;
+    m_next = (m_next + 1) % HISTORY_SIZE;
+    ++m_recorded;
+
+    if (hitch) {
+        CpuHitch& entry = m_hitches[m_nextHitch];
+        entry = CpuHitch{};
+        entry.frame      = timing.frame;
+        entry.time       = time;
+        entry.frameMs    = timing.frameMs;
+        entry.baselineMs = baselineMs;
+        const auto worst = std::max_element(timing.ms.begin(), timing.ms.end());
+        entry.worstStage = static_cast<CpuStage>(worst - timing.ms.begin());
+        entry.worstMs    = *worst;
+        m_nextHitch  = (m_nextHitch + 1) % MAX_HITCHES;
+        m_hitchCount = std::min(m_hitchCount + 1, MAX_HITCHES);
+    }
+}
+
+void CpuProfiler::Reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_next       = 0;
+    m_recorded   = 0;
+    m_nextHitch  = 0;
+    m_hitchCount = 0;
+}
+
+bool CpuProfiler::GetLatest(CpuFrameTiming& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_recorded == 0) return false;
+    out = m_history[(m_next - 1 + HISTORY_SIZE) % HISTORY_SIZE];
+    return true;
+}
+
+CpuProfiler::Snapshot CpuProfiler::GetSnapshot() const {
+    Snapshot snapshot;
+    GetSnapshot(snapshot);
+    return snapshot;
+}
+
+void CpuProfiler::GetSnapshot(Snapshot& out, std::pmr::memory_resource* scratch) const {
+    // Cleared, not reassigned, so the vectors keep their capacity
+    out.stages      = {};
+    out.histogram   = {};
+    out.p50Ms       = 0.0f;
+    out.p99Ms       = 0.0f;
+    out.maxMs       = 0.0f;
+    out.allocations = AllocationStats{};
+    out.frameMs.clear();
+    out.hitches.clear();
+    std::pmr::vector<CpuFrameTiming> frames(scratch);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out.frames = m_recorded;
+        const int size = static_cast<int>(std::min<int64_t>(m_recorded, HISTORY_SIZE));
+        frames.reserve(size);
+        for (int i = 0; i < size; ++i) {
+            frames.push_back(m_history[(m_next - size + i + HISTORY_SIZE) % HISTORY_SIZE]);
+        }
+        out.hitches.reserve(m_hitchCount);
+        for (int i = 1; i <= m_hitchCount; ++i) {
+            out.hitches.push_back(m_hitches[(m_nextHitch - i + MAX_HITCHES) % MAX_HITCHES]);
+        }
+    }
+    if (frames.empty()) return;
+
+    out.frameMs.reserve(frames.size());
+    int64_t allocations = 0;
+    for (const CpuFrameTiming& frame : frames) {
+        out.frameMs.push_back(frame.frameMs);
+        const int bin = std::clamp(static_cast<int>(frame.frameMs), 0, HISTOGRAM_BINS - 1);
+        out.histogram[bin] += 1.0f;
+        allocations += frame.allocations;
+        out.allocations.max = std::max(out.allocations.max, frame.allocations);
+    }
+    out.allocations.last      = frames.back().allocations;
+    out.allocations.lastBytes = frames.back().allocatedBytes;
+    out.allocations.avg       = static_cast<float>(static_cast<double>(allocations) / frames.size());
+
+    std::pmr::vector<float> sorted(out.frameMs.begin(), out.frameMs.end(), scratch);
+    std::sort(sorted.begin(), sorted.end());
+    out.p50Ms = sorted[(sorted.size() - 1) * 50 / 100];
+    out.p99Ms = sorted[(sorted.size() - 1) * 99 / 100];
+    out.maxMs = sorted.back();
+
+    for (int s = 0; s < CPU_STAGE_COUNT; ++s) {
+        StageStats& stats = out.stages[s];
+        double sum = 0.0;
+        for (const CpuFrameTiming& frame : frames) {
+            sum += frame.ms[s];
+            stats.maxMs = std::max(stats.maxMs, frame.ms[s]);
+        }
+        stats.lastMs = frames.back().ms[s];
+        stats.avgMs  = static_cast<float>(sum / frames.size());
+    }
+}
+
+} // namespace SP
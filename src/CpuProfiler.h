@@ -0,0 +1,165 @@
+#pragma once
+
+#include "Common.h"
+#include "TraceRecorder.h"
+#include "HeapStats.h"
+#include <array>
+#include <chrono>
+#include <memory_resource>
+
+namespace SP {
+
+// Main-loop work of one tick, in order. LatencyWait is the swap chain's frame-
+// latency wait plus the frame-rate cap (idle time while the GPU/display catch
+// up, not work). Decode is the main thread's side (popping
+// the worker's ring, export steps, loop seeks): demux, decode and ConvertFrame run
+// on the DecodeWorker thread and are timed by VideoDecoder::GetAverageDecodeMs.
+// Render is BeginFrame/RenderToDisplay plus the outputs and recording submit;
+// UiBuild the ImGui panels and UiDraw the draw-data submission. Background is
+// the BackgroundGpuWork run after Present.
+enum class CpuStage {
+    LatencyWait, Messages, ShaderWatch, Decode, Audio, Inputs, Upload, Keyframes, Render, UiBuild, UiDraw, Present,
+    Background, Count
+};
+constexpr int CPU_STAGE_COUNT = static_cast<int>(CpuStage::Count);
+
+// One tick. A stage entered several times is summed; frameMs is the wall time
+// from this tick's start to the next one's, so it includes anything untimed.
+// The allocation counts are the main thread's operator new calls over the same
+// span (HeapStats); steady-state playback should make none.
+struct CpuFrameTiming {
+    std::array<float, CPU_STAGE_COUNT> ms{};
+    float   frameMs = 0.0f;
+    int64_t frame   = 0;
+    int64_t allocations    = 0;
+    int64_t allocatedBytes = 0;
+};
+
+// A tick well over the recent frame time, with the stage that took longest
+struct CpuHitch {
+    int64_t  frame      = 0;
+    double   time       = 0.0;  // Seconds since the profiler started
+    float    frameMs    = 0.0f;
+    float    baselineMs = 0.0f;  // Typical frame time at that point
+    CpuStage worstStage = CpuStage::LatencyWait;
+    float    worstMs    = 0.0f;
+};
+
+// Wall-clock timings of the main loop per CpuStage. Scopes write into the tick's
+// record with no locking (render thread only); EndFrame publishes the record into
+// the history under the mutex once per tick, so readers (the HUD, a benchmark
+// harness) never see a half-written frame.
+class CpuProfiler {
+public:
+    static constexpr int HISTORY_SIZE   = 600;  // ~10 s at 60 fps
+    static constexpr int HISTOGRAM_BINS = 50;   // 1 ms each; the last is >= 49 ms
+    static constexpr int MAX_HITCHES    = 32;
+
+    struct StageStats {
+        float lastMs = 0.0f;
+        float avgMs  = 0.0f;
+        float maxMs  = 0.0f;
+    };
+    struct AllocationStats {  // Main-thread operator new calls per tick
+        int64_t last      = 0;
+        float   avg       = 0.0f;
+        int64_t max       = 0;
+        int64_t lastBytes = 0;
+    };
+    struct Snapshot {
+        std::array<StageStats, CPU_STAGE_COUNT> stages{};
+        std::vector<float> frameMs;  // Oldest first
+        std::array<float, HISTOGRAM_BINS> histogram{};  // Frame counts
+        float p50Ms = 0.0f;
+        float p99Ms = 0.0f;
+        float maxMs = 0.0f;
+        std::vector<CpuHitch> hitches;  // Newest first
+        AllocationStats allocations;
+        int64_t frames = 0;             // Recorded since Reset
+    };
+
+    CpuProfiler();
+
+    // Non-copyable
+    CpuProfiler(const CpuProfiler&) = delete;
+    CpuProfiler& operator=(const CpuProfiler&) = delete;
+
+    static const char* StageName(CpuStage stage);
+
+    // One call per tick, at its start: closes the previous tick (its frame time
+    // runs up to now) and opens the next
+    void BeginFrame();
+
+    // Adds [begin, end) to the stage and puts it on the main thread's trace track
+    // (Chrome trace only: a Tracy zone has to be opened when the stage starts)
+    void AddStage(CpuStage stage, std::chrono::steady_clock::time_point begin,
+                  std::chrono::steady_clock::time_point end) {
+        AddMs(stage, std::chrono::duration<float, std::milli>(end - begin).count());
+        TraceRecorder::Get().Record(StageName(stage), begin, end);
+    }
+
+    // Times a stage for the lifetime of the scope, and traces it; use SP_CPU_SCOPE
+    class Scope {
+    public:
+        Scope(CpuProfiler& profiler, CpuStage stage)
+            : m_profiler(profiler), m_stage(stage), m_trace(StageName(stage)),
+              m_outer(profiler.m_activeStage.exchange(static_cast<int>(stage), std::memory_order_relaxed)) {}
+        ~Scope() {
+            m_profiler.m_activeStage.store(m_outer, std::memory_order_relaxed);
+            m_profiler.AddMs(m_stage, m_trace.ElapsedMs());
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        CpuProfiler&         m_profiler;
+        CpuStage             m_stage;
+        TraceRecorder::Scope m_trace;
+        int                  m_outer;  // Stage this one is nested in; -1 = none
+    };
+
+    // The innermost stage the main thread is in right now (any thread; FrameWatchdog
+    // names it in a stall report). False between stages.
+    bool GetActiveStage(CpuStage& out) const {
+        const int stage = m_activeStage.load(std::memory_order_relaxed);
+        if (stage < 0) return false;
+        out = static_cast<CpuStage>(stage);
+        return true;
+    }
+
+    void Reset();
+    Snapshot GetSnapshot() const;
+    // Fills `out` reusing its vectors' storage; `scratch` backs the temporaries
+    // (the main thread passes its FrameArena)
+    void GetSnapshot(Snapshot& out, std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) const;
+    bool GetLatest(CpuFrameTiming& out) const;  // False until a tick has completed
+
+private:
+    void AddMs(CpuStage stage, float ms) { m_current.ms[static_cast<int>(stage)] += ms; }
+    void Publish(const CpuFrameTiming& timing, double time);
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point m_startTime;
+    Clock::time_point m_frameStart;
+    HeapCounters      m_heapAtStart;  // Main thread's, at m_frameStart
+    bool    m_started    = false;
+    int64_t m_frameCount = 0;
+    CpuFrameTiming m_current;
+    float   m_baselineMs = 0.0f;  // Moving average of frame time, for hitch detection
+    std::atomic<int> m_activeStage{-1};
+
+    mutable std::mutex m_mutex;  // Guards everything below
+    std::array<CpuFrameTiming, HISTORY_SIZE> m_history{};
+    int     m_next     = 0;
+    int64_t m_recorded = 0;
+    std::array<CpuHitch, MAX_HITCHES> m_hitches{};
+    int     m_nextHitch  = 0;
+    int     m_hitchCount = 0;
+};
+
+#define SP_CPU_SCOPE_CONCAT_(a, b) a##b
+#define SP_CPU_SCOPE_NAME_(line) SP_CPU_SCOPE_CONCAT_(cpuScope_, line)
+// Times the rest of the enclosing block as `stage` of `profiler`
+#define SP_CPU_SCOPE(profiler, stage) \
+    ::SP::CpuProfiler::Scope SP_CPU_SCOPE_NAME_(__LINE__)((profiler), ::SP::CpuStage::stage)
+
+} // namespace SP
@@ -1,6 +1,9 @@
 #include "D3D11Renderer.h"
+#include <d3d11shader.h>
+#include <algorithm>
+#include <cmath>
+#include <regex>
 #include <stdexcept>
-#include <fstream>
 
 namespace SP {
 
@@ -24,13 +27,44 @@ VS_OUTPUT main(VS_INPUT input) {
 }
 )";
 
+// Blend of a preset's output `g` over the video `v` for ShaderPreset::blendMode,
+// chosen at compile time: every compositor variant and fused epilogue defines
+// BLEND_MODE as a literal, so no per-pixel branch on the mode remains.
+static const char* g_blendFunctionSource = R"(
+float3 SPBlend(float3 v, float3 g) {
+#if BLEND_MODE == 2
+    return saturate(v + g);                                     // Add
+#elif BLEND_MODE == 3
+    return v * g;                                               // Multiply
+#elif BLEND_MODE == 4
+    return 1.0 - (1.0 - v) * (1.0 - g);                         // Screen
+#elif BLEND_MODE == 5
+    return lerp(2.0 * v * g,                                    // Overlay
+                1.0 - 2.0 * (1.0 - v) * (1.0 - g),
+                step(0.5, v));
+#elif BLEND_MODE == 6
+    return lerp(2.0 * v * g + v * v * (1.0 - 2.0 * g),          // Soft Light
+                sqrt(v) * (2.0 * g - 1.0) + 2.0 * v * (1.0 - g),
+                step(0.5, g));
+#elif BLEND_MODE == 7
+    return abs(v - g);                                          // Difference
+#elif BLEND_MODE == 8
+    return v + g - 2.0 * v * g;                                 // Exclusion
+#elif BLEND_MODE == 9
+    return min(v, g);                                           // Darken
+#elif BLEND_MODE == 10
+    return max(v, g);                                           // Lighten
+#else
+    return g;                                                   // Normal (1)
+#endif
+}
+)";
+
 // Compositor pixel shader — blends video (t0) with generative output (t2).
-// Blend mode is in padding2.x (cast to int), blend amount in padding1.
+// Blend amount in padding1; the mode is the variant's BLEND_MODE.
 static const char* g_compositorShaderSource = R"(
 Texture2D videoTexture      : register(t0);
 SamplerState videoSampler   : register(s0);
-Texture2D noiseTexture      : register(t1);
-SamplerState noiseSampler   : register(s1);
 Texture2D generativeTexture : register(t2);
 
 cbuffer Constants : register(b0) {
@@ -38,7 +72,7 @@ cbuffer Constants : register(b0) {
     float blendAmount;      // padding1
     float2 resolution;
     float2 videoResolution;
-    float2 blendParams;     // blendParams.x = blendMode (as float int)
+    float2 blendParams;
     float4 custom[4];
 };
 
@@ -50,51 +84,67 @@ struct PS_INPUT {
 float4 main(PS_INPUT input) : SV_TARGET {
     float4 v = videoTexture.Sample(videoSampler, input.uv);
     float4 g = generativeTexture.Sample(videoSampler, input.uv);
-    int mode = int(blendParams.x);
-
-    float3 r;
-    if (mode == 2) {
-        // Add
-        r = saturate(v.rgb + g.rgb);
-    } else if (mode == 3) {
-        // Multiply
-        r = v.rgb * g.rgb;
-    } else if (mode == 4) {
-        // Screen
-        r = 1.0 - (1.0 - v.rgb) * (1.0 - g.rgb);
-    } else if (mode == 5) {
-        // Overlay
-        r = lerp(2.0 * v.rgb * g.rgb,
-                 1.0 - 2.0 * (1.0 - v.rgb) * (1.0 - g.rgb),
-                 step(0.5, v.rgb));
-    } else if (mode == 6) {
-        // Soft Light
-        r = lerp(2.0 * v.rgb * g.rgb + v.rgb * v.rgb * (1.0 - 2.0 * g.rgb),
-                 sqrt(v.rgb) * (2.0 * g.rgb - 1.0) + 2.0 * v.rgb * (1.0 - g.rgb),
-                 step(0.5, g.rgb));
-    } else if (mode == 7) {
-        // Difference
-        r = abs(v.rgb - g.rgb);
-    } else if (mode == 8) {
-        // Exclusion
-        r = v.rgb + g.rgb - 2.0 * v.rgb * g.rgb;
-    } else if (mode == 9) {
-        // Darken
-        r = min(v.rgb, g.rgb);
-    } else if (mode == 10) {
-        // Lighten
-        r = max(v.rgb, g.rgb);
-    } else {
-        // Normal (mode == 1) or fallback
-        r = g.rgb;
-    }
 
     // Blend: lerp video toward blended result by blendAmount
-    float3 out_rgb = lerp(v.rgb, r, blendAmount);
+    float3 out_rgb = lerp(v.rgb, SPBlend(v.rgb, g.rgb), blendAmount);
     return float4(out_rgb, 1.0);
 }
 )";
 
+// Appended to a preset whose `main` was renamed SPUserMain: the same blend as the
+// compositor, done in the preset's own pass. Own names and slots throughout, as
+// the preset has already declared t0/s0/b0 under names of its choosing.
+static const char* g_fusedBlendEpilogueSource = R"(
+Texture2D    spBlendVideo   : register(t2);
+SamplerState spBlendSampler : register(s2);
+cbuffer SPBlendConstants : register(b3) {
+    float spBlendAmount;
+    float spBlendEnabled;   // 0 = draw the preset alone (no video, compositor pass instead)
+    float2 spBlendPad;
+};
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float4 g = SPUserMain(input);
+    [branch] if (spBlendEnabled < 0.5) return g;
+    float4 v = spBlendVideo.Sample(spBlendSampler, input.uv);
+    return float4(lerp(v.rgb, SPBlend(v.rgb, g.rgb), spBlendAmount), 1.0);
+}
+)";
+
+// Layer compositor declarations; GetLayerCompositorShader appends one SPBlend
+// per layer and a main unrolled over the stack. The video (t0) is blended with
+// the active shader (t2) as the compositor above does, then each layer — a
+// slice of spLayers or an extra input — over the result, in order.
+static const char* g_layerCompositorSource = R"(
+Texture2D      videoTexture  : register(t0);
+SamplerState   clampSampler  : register(s0);
+Texture2D      activeTexture : register(t2);
+Texture2D      spInput0      : register(t4);
+Texture2D      spInput1      : register(t5);
+Texture2D      spInput2      : register(t6);
+Texture2D      spInput3      : register(t7);
+Texture2DArray spLayers      : register(t24);
+
+cbuffer SPLayerConstants : register(b4) {
+    float4 spBase;      // x = video blend amount
+    float4 spLayer[8];  // x = opacity
+};
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float SPLuma(float3 c) { return dot(c, float3(0.2126, 0.7152, 0.0722)); }
+
+// Deck wipe: 0 at t = 0 and 1 at t = 1 across the whole frame, soft edge between
+float SPWipe(float x, float t) {
+    const float edge = 0.02;
+    float p = t * (1.0 + 2.0 * edge) - edge;
+    return 1.0 - smoothstep(p - edge, p + edge, x);
+}
+)";
+
 // Passthrough pixel shader
 static const char* g_passthroughShaderSource = R"(
 Texture2D videoTexture : register(t0);
@@ -119,6 +169,603 @@ float4 main(PS_INPUT input) : SV_TARGET {
 }
 )";
 
+// Upscale of a reduced-resolution shader pass (UPSCALE_BICUBIC): Catmull-Rom
+// bicubic from t0, folded into 9 bilinear taps. Sharper than bilinear, which
+// visibly softens a 0.5-0.7x render.
+static const char* g_upscaleShaderSource = R"(
+Texture2D    sourceTexture : register(t0);
+SamplerState sourceSampler : register(s0);
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float2 size;
+    sourceTexture.GetDimensions(size.x, size.y);
+    float2 texel = 1.0 / size;
+
+    float2 samplePos = input.uv * size;
+    float2 center = floor(samplePos - 0.5) + 0.5;
+    float2 f = samplePos - center;
+
+    // Catmull-Rom weights of the 4x4 neighbourhood, per axis
+    float2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    float2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    float2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    float2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    // The middle two taps share one bilinear fetch
+    float2 w12 = w1 + w2;
+    float2 offset12 = w2 / w12;
+
+    float2 uv0  = (center - 1.0) * texel;
+    float2 uv3  = (center + 2.0) * texel;
+    float2 uv12 = (center + offset12) * texel;
+
+    float4 result = 0.0;
+    result += sourceTexture.SampleLevel(sourceSampler, float2(uv0.x,  uv0.y),  0) * w0.x  * w0.y;
+    result += sourceTexture.SampleLevel(sourceSampler, float2(uv12.x, uv0.y),  0) * w12.x * w0.y;
+    result += sourceTexture.SampleLevel(sourceSampler, float2(uv3.x,  uv0.y),  0) * w3.x  * w0.y;
+    result += sourceTexture.SampleLevel(sourceSampler, float2(uv0.x,  uv12.y), 0) * w0.x  * w12.y;
+    result += sourceTexture.SampleLevel(sourceSampler, float2(uv12.x, uv12.y), 0) * w12.x * w12.y;
+    result += sourceTexture.SampleLevel(sourceSampler, float2(uv3.x,  uv12.y), 0) * w3.x  * w12.y;
+    result += sourceTexture.SampleLevel(sourceSampler, float2(uv0.x,  uv3.y),  0) * w0.x  * w3.y;
+    result += sourceTexture.SampleLevel(sourceSampler, float2(uv12.x, uv3.y),  0) * w12.x * w3.y;
+    result += sourceTexture.SampleLevel(sourceSampler, float2(uv3.x,  uv3.y),  0) * w3.x  * w3.y;
+    return float4(saturate(result.rgb), 1.0);
+}
+)";
+
+// Lanczos-2 upscale (UPSCALE_LANCZOS): the 4x4 neighbourhood, separable sinc
+// weights normalised to one, then clamped to the inner 2x2's range so the
+// negative lobes can't ring past hard edges.
+static const char* g_lanczosShaderSource = R"(
+Texture2D sourceTexture : register(t0);
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+static const float PI = 3.14159265;
+
+float4 Lanczos2(float4 x) {
+    x = max(abs(x), 1e-5);
+    return (2.0 * sin(PI * x) * sin(PI * x * 0.5)) / (PI * PI * x * x) * (x < 2.0);
+}
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float2 size;
+    sourceTexture.GetDimensions(size.x, size.y);
+    int2   maxTexel = int2(size) - 1;
+
+    float2 samplePos = input.uv * size - 0.5;
+    int2   base = int2(floor(samplePos));
+    float2 f = samplePos - base;
+
+    float4 wx = Lanczos2(float4(1.0 + f.x, f.x, 1.0 - f.x, 2.0 - f.x));
+    float4 wy = Lanczos2(float4(1.0 + f.y, f.y, 1.0 - f.y, 2.0 - f.y));
+    wx /= dot(wx, 1.0);
+    wy /= dot(wy, 1.0);
+
+    float3 result = 0.0;
+    float3 lo = 1e9;
+    float3 hi = -1e9;
+    [unroll] for (int y = 0; y < 4; ++y) {
+        float3 row = 0.0;
+        [unroll] for (int x = 0; x < 4; ++x) {
+            float3 c = sourceTexture.Load(int3(clamp(base + int2(x - 1, y - 1), 0, maxTexel), 0)).rgb;
+            row += c * wx[x];
+            if (x == 1 || x == 2) {
+                if (y == 1 || y == 2) {
+                    lo = min(lo, c);
+                    hi = max(hi, c);
+                }
+            }
+        }
+        result += row * wy[y];
+    }
+    return float4(saturate(clamp(result, lo, hi)), 1.0);
+}
+)";
+
+// Edge-adaptive upscale (UPSCALE_EDGE_ADAPTIVE, first pass), after FSR1's EASU.
+// Twelve texels around the output pixel give a local gradient direction and an
+// edge strength; each tap is weighted by an approximate Lanczos-2 kernel that
+// is stretched along the edge and narrowed across it, so edges stay crisp
+// where bicubic would blur them. Clamped to the nearest 2x2 against ringing.
+//
+//       b c
+//     e f g h
+//     i j k l
+//       n o
+static const char* g_easuShaderSource = R"(
+Texture2D sourceTexture : register(t0);
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float Luma(float3 c) {
+    return dot(c, float3(0.5, 1.0, 0.5));  // As FSR1: green-weighted, unnormalised
+}
+
+// Direction and edge length from one texel's cross (a up, b left, c centre, d right, e down),
+// weighted by its bilinear share w
+void AccumulateEdge(inout float2 dir, inout float len, float w,
+                    float lA, float lB, float lC, float lD, float lE) {
+    float dc = lD - lC;
+    float cb = lC - lB;
+    float lenX = saturate(abs(lD - lB) / max(max(abs(dc), abs(cb)), 1e-5));
+    float dirX = lD - lB;
+    float ec = lE - lC;
+    float ca = lC - lA;
+    float lenY = saturate(abs(lE - lA) / max(max(abs(ec), abs(ca)), 1e-5));
+    float dirY = lE - lA;
+    dir += float2(dirX, dirY) * w;
+    len += (lenX * lenX + lenY * lenY) * w;
+}
+
+void AccumulateTap(inout float3 sum, inout float weight, float2 offset, float2 dir,
+                   float2 len2, float lob, float clp, float3 c) {
+    float2 v = float2(offset.x * dir.x + offset.y * dir.y, offset.x * -dir.y + offset.y * dir.x) * len2;
+    float d2 = min(dot(v, v), clp);
+    // Lanczos-2 approximation: (25/16 (2/5 x^2 - 1)^2 - 9/16) * (lob x^2 - 1)^2
+    float wB = 0.4 * d2 - 1.0;
+    float wA = lob * d2 - 1.0;
+    float w = (wB * wB * 1.5625 - 0.5625) * (wA * wA);
+    sum += c * w;
+    weight += w;
+}
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float2 size;
+    sourceTexture.GetDimensions(size.x, size.y);
+    int2   maxTexel = int2(size) - 1;
+
+    float2 samplePos = input.uv * size - 0.5;
+    int2   fp = int2(floor(samplePos));
+    float2 pp = samplePos - fp;
+
+#define TAP(x, y) sourceTexture.Load(int3(clamp(fp + int2(x, y), 0, maxTexel), 0)).rgb
+    float3 b = TAP(0, -1), c = TAP(1, -1);
+    float3 e = TAP(-1, 0), f = TAP(0, 0), g = TAP(1, 0), h = TAP(2, 0);
+    float3 i = TAP(-1, 1), j = TAP(0, 1), k = TAP(1, 1), l = TAP(2, 1);
+    float3 n = TAP(0, 2), o = TAP(1, 2);
+#undef TAP
+
+    float lb = Luma(b), lc = Luma(c);
+    float le = Luma(e), lf = Luma(f), lg = Luma(g), lh = Luma(h);
+    float li = Luma(i), lj = Luma(j), lk = Luma(k), ll = Luma(l);
+    float ln = Luma(n), lo = Luma(o);
+
+    // Edge direction and strength, bilinearly from the inner 2x2 f g j k
+    float2 dir = 0.0;
+    float  len = 0.0;
+    AccumulateEdge(dir, len, (1.0 - pp.x) * (1.0 - pp.y), lb, le, lf, lg, lj);
+    AccumulateEdge(dir, len, pp.x * (1.0 - pp.y),         lc, lf, lg, lh, lk);
+    AccumulateEdge(dir, len, (1.0 - pp.x) * pp.y,         lf, li, lj, lk, ln);
+    AccumulateEdge(dir, len, pp.x * pp.y,                 lg, lj, lk, ll, lo);
+
+    float dirLen2 = dot(dir, dir);
+    dir = dirLen2 < 1.0 / 32768.0 ? float2(1.0, 0.0) : dir * rsqrt(dirLen2);
+    len = len * 0.5;
+    len *= len;
+    // Stretch along the edge (up to sqrt 2 on diagonals), narrow across it
+    float stretch = dot(dir, dir) / max(dir.x * dir.x, dir.y * dir.y);
+    float2 len2 = float2(1.0 + (stretch - 1.0) * len, 1.0 - 0.5 * len);
+    float lob = 0.5 + ((1.0 / 4.0 - 0.04) - 0.5) * len;
+    float clp = 1.0 / lob;
+
+    float3 sum = 0.0;
+    float  weight = 0.0;
+    AccumulateTap(sum, weight, float2( 0.0, -1.0) - pp, dir, len2, lob, clp, b);
+    AccumulateTap(sum, weight, float2( 1.0, -1.0) - pp, dir, len2, lob, clp, c);
+    AccumulateTap(sum, weight, float2(-1.0,  1.0) - pp, dir, len2, lob, clp, i);
+    AccumulateTap(sum, weight, float2( 0.0,  1.0) - pp, dir, len2, lob, clp, j);
+    AccumulateTap(sum, weight, float2( 0.0,  0.0) - pp, dir, len2, lob, clp, f);
+    AccumulateTap(sum, weight, float2(-1.0,  0.0) - pp, dir, len2, lob, clp, e);
+    AccumulateTap(sum, weight, float2( 1.0,  1.0) - pp, dir, len2, lob, clp, k);
+    AccumulateTap(sum, weight, float2( 2.0,  1.0) - pp, dir, len2, lob, clp, l);
+    AccumulateTap(sum, weight, float2( 2.0,  0.0) - pp, dir, len2, lob, clp, h);
+    AccumulateTap(sum, weight, float2( 1.0,  0.0) - pp, dir, len2, lob, clp, g);
+    AccumulateTap(sum, weight, float2( 1.0,  2.0) - pp, dir, len2, lob, clp, o);
+    AccumulateTap(sum, weight, float2( 0.0,  2.0) - pp, dir, len2, lob, clp, n);
+
+    float3 lo3 = min(min(f, g), min(j, k));
+    float3 hi3 = max(max(f, g), max(j, k));
+    return float4(saturate(clamp(sum / max(weight, 1e-5), lo3, hi3)), 1.0);
+}
+)";
+
+// Sharpening after the edge-adaptive upscale (second pass), after FSR1's RCAS:
+// a cross-shaped negative lobe sized per pixel so the result can't leave the
+// neighbourhood's range, i.e. sharpening without halos. `sharpness` 0 keeps
+// the input.
+static const char* g_rcasShaderSource = R"(
+Texture2D sourceTexture : register(t0);
+
+cbuffer RcasConstants : register(b0) {
+    float  sharpness;
+    float3 padding;
+};
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float2 size;
+    sourceTexture.GetDimensions(size.x, size.y);
+    int2 maxTexel = int2(size) - 1;
+    int2 p = int2(input.pos.xy);
+
+    float3 b = sourceTexture.Load(int3(clamp(p + int2( 0, -1), 0, maxTexel), 0)).rgb;
+    float3 d = sourceTexture.Load(int3(clamp(p + int2(-1,  0), 0, maxTexel), 0)).rgb;
+    float3 e = sourceTexture.Load(int3(p, 0)).rgb;
+    float3 f = sourceTexture.Load(int3(clamp(p + int2( 1,  0), 0, maxTexel), 0)).rgb;
+    float3 h = sourceTexture.Load(int3(clamp(p + int2( 0,  1), 0, maxTexel), 0)).rgb;
+
+    float3 mn4 = min(min(b, d), min(f, h));
+    float3 mx4 = max(max(b, d), max(f, h));
+    // The largest lobe that keeps the result within [0, 1] of the neighbourhood
+    float3 hitMin = min(mn4, e) / max(4.0 * mx4, 1e-5);
+    float3 hitMax = (1.0 - max(mx4, e)) / min(4.0 * mn4 - 4.0, -1e-5);
+    float3 lobeRGB = max(-hitMin, hitMax);
+    float  lobe = max(-0.1875, min(max(lobeRGB.r, max(lobeRGB.g, lobeRGB.b)), 0.0)) * sharpness;
+
+    float3 result = (lobe * (b + d + f + h) + e) / (4.0 * lobe + 1.0);
+    return float4(saturate(result), 1.0);
+}
+)";
+
+// Downscale for recording at a smaller size: a box (area) filter over the
+// output pixel's footprint in the source, averaged from bilinear taps spaced
+// two texels apart (up to 8x8 taps, i.e. 16x). ddx/ddy of the fullscreen
+// triangle's UV give the footprint, so no constants are needed. Bilinear alone
+// would skip source texels past 2x and alias fine detail.
+static const char* g_downscaleShaderSource = R"(
+Texture2D    sourceTexture : register(t0);
+SamplerState sourceSampler : register(s0);
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float2 size;
+    sourceTexture.GetDimensions(size.x, size.y);
+    float2 footprint = float2(ddx(input.uv.x), ddy(input.uv.y)) * size;  // Source texels per output pixel
+    int2   taps      = clamp(int2(ceil(footprint * 0.5)), 1, 8);
+    float2 stride    = footprint / float2(taps) / size;
+    float2 origin    = input.uv - 0.5 * footprint / size + 0.5 * stride;
+
+    float4 sum = 0.0;
+    [loop] for (int y = 0; y < taps.y; ++y) {
+        [loop] for (int x = 0; x < taps.x; ++x)
+            sum += sourceTexture.SampleLevel(sourceSampler, origin + float2(x, y) * stride, 0);
+    }
+    return float4(saturate(sum.rgb / (taps.x * taps.y)), 1.0);
+}
+)";
+
+// One window of a canvas spanning several displays (BlitRegionTo). The window
+// pixel is taken back through the keystone warp (inverse bilinear of the quad
+// the region's corners land on), then into the region's part of the canvas.
+// Edge blends ramp with a smoothstep, whose overlapping halves sum to one, and
+// are raised to 1/gamma so they sum in light rather than in signal.
+static const char* g_canvasRegionShaderSource = R"(
+Texture2D    sourceTexture : register(t0);
+SamplerState sourceSampler : register(s0);
+
+cbuffer CanvasRegion : register(b0) {
+    float4 region;     // x, y, width, height in the canvas
+    float4 blend;      // left, right, top, bottom widths in the region
+    float4 cornersTop; // top-left, top-right in the window
+    float4 cornersBottom; // bottom-left, bottom-right
+    float  gamma;
+    float3 padding;
+};
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float Cross2(float2 a, float2 b) { return a.x * b.y - a.y * b.x; }
+
+// Where p lies in the quad a (0,0), b (1,0), c (1,1), d (0,1); outside 0..1 when it doesn't
+float2 InverseBilinear(float2 p, float2 a, float2 b, float2 c, float2 d) {
+    float2 e = b - a, f = d - a, g = a - b + c - d, h = p - a;
+    float k2 = Cross2(g, f);
+    float k1 = Cross2(e, f) + Cross2(h, g);
+    float k0 = Cross2(h, e);
+    if (abs(k2) < 1e-5)  // Opposite sides parallel: the equation is linear
+        return float2((h.x * k1 + f.x * k0) / (e.x * k1 - g.x * k0), -k0 / k1);
+    float w = k1 * k1 - 4.0 * k0 * k2;
+    if (w < 0.0) return float2(-1.0, -1.0);
+    w = sqrt(w);
+    float v = (-k1 - w) * 0.5 / k2;
+    float u = (h.x - f.x * v) / (e.x + g.x * v);
+    if (u < 0.0 || u > 1.0 || v < 0.0 || v > 1.0) {
+        v = (-k1 + w) * 0.5 / k2;
+        u = (h.x - f.x * v) / (e.x + g.x * v);
+    }
+    return float2(u, v);
+}
+
+float Ramp(float distance, float width) {
+    return width > 0.0 ? smoothstep(0.0, 1.0, saturate(distance / width)) : 1.0;
+}
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float2 q = InverseBilinear(input.uv, cornersTop.xy, cornersTop.zw, cornersBottom.zw, cornersBottom.xy);
+    if (any(q < 0.0) || any(q > 1.0)) return float4(0.0, 0.0, 0.0, 1.0);
+    float3 color = sourceTexture.SampleLevel(sourceSampler, region.xy + q * region.zw, 0).rgb;
+    float weight = Ramp(q.x, blend.x) * Ramp(1.0 - q.x, blend.y) * Ramp(q.y, blend.z) * Ramp(1.0 - q.y, blend.w);
+    return float4(color * pow(weight, 1.0 / gamma), 1.0);
+}
+)";
+
+// YUV→RGB conversion pass, shared by hardware frames (decoder surface slices) and
+// CPU-decoded planes. Luma is t0; chroma is either interleaved CbCr at t1
+// (NV12/P010) or separate Cb/Cr planes at t1/t2 (planar 4:2:0). The affine matrix
+// rows are built on the CPU from the frame's colour metadata.
+static const char* g_yuvShaderSource = R"(
+Texture2DArray<float>  lumaPlane   : register(t0);
+Texture2DArray<float2> chromaPlane : register(t1);
+Texture2DArray<float>  crPlane     : register(t2);
+SamplerState planeSampler          : register(s0);
+
+cbuffer YuvConstants : register(b0) {
+    float4 rowR;        // xyz = Y/Cb/Cr weights, w = offset
+    float4 rowG;
+    float4 rowB;
+    float2 uvScale;     // frame size / surface size
+    float  planarChroma;
+    float  uyvy;
+};
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float3 uv = float3(input.uv * uvScale, 0.0);
+    float2 chroma = chromaPlane.Sample(planeSampler, uv);
+    if (planarChroma > 0.5)
+        chroma.y = crPlane.Sample(planeSampler, uv);
+    float4 yuv = float4(lumaPlane.Sample(planeSampler, uv), chroma, 1.0);
+    return float4(saturate(float3(dot(rowR, yuv), dot(rowG, yuv), dot(rowB, yuv))), 1.0);
+}
+)";
+
+// Packed 4:2:2 (YUY2/UYVY capture): the plane is uploaded as RGBA8 at half
+// width, one texel per pair of pixels (Y0 Cb Y1 Cr, or Cb Y0 Cr Y1 when uyvy is
+// set). Luma is fetched per pixel; chroma is sampled bilinearly between pairs.
+// Same constants as the planar pass.
+static const char* g_packedYuvShaderSource = R"(
+Texture2DArray<float4> packedPlane : register(t0);
+SamplerState planeSampler          : register(s0);
+
+cbuffer YuvConstants : register(b0) {
+    float4 rowR;        // xyz = Y/Cb/Cr weights, w = offset
+    float4 rowG;
+    float4 rowB;
+    float2 uvScale;     // frame size / (2 x texture width): crops an odd width's last half pair
+    float  planarChroma;
+    float  uyvy;
+};
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    uint width, height, elements;
+    packedPlane.GetDimensions(width, height, elements);
+    float2 uv = input.uv * uvScale;
+    uint x = min(uint(uv.x * width * 2), width * 2 - 1);
+    uint y = min(uint(uv.y * height), height - 1);
+
+    float4 pair  = packedPlane.Load(int4(x >> 1, y, 0, 0));
+    float4 cbcr  = packedPlane.Sample(planeSampler, float3(uv, 0.0));
+    if (uyvy > 0.5) {
+        pair = pair.garb;
+        cbcr = cbcr.garb;
+    }
+    float4 yuv = float4((x & 1) ? pair.b : pair.r, cbcr.g, cbcr.a, 1.0);
+    return float4(saturate(float3(dot(rowR, yuv), dot(rowG, yuv), dot(rowB, yuv))), 1.0);
+}
+)";
+
+// RGB→YUV pass for recording: one draw per output plane, each with its own matrix
+// rows (two for NV12's interleaved CbCr plane, one otherwise). Chroma planes are
+// drawn at chroma size, so the bilinear sample at a chroma texel centre averages
+// the 2x2 (4:2:0) or 2x1 (4:2:2) luma texels.
+static const char* g_rgbToYuvShaderSource = R"(
+Texture2D    sourceTexture : register(t0);
+SamplerState sourceSampler : register(s0);
+
+cbuffer RgbToYuvConstants : register(b0) {
+    float4 row0;  // xyz = R/G/B weights, w = offset, pre-scaled to the plane's UNORM
+    float4 row1;  // Second channel (Cr of NV12), zero for single-channel planes
+};
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float4 rgb = float4(sourceTexture.Sample(sourceSampler, input.uv).rgb, 1.0);
+    return float4(dot(row0, rgb), dot(row1, rgb), 0.0, 1.0);
+}
+)";
+
+// RGB→UYVY for network output: each RGBA8 target texel packs two horizontal
+// pixels as U, Y0, V, Y1 (its bytes in memory order), chroma from their average.
+static const char* g_rgbToUyvyShaderSource = R"(
+Texture2D    sourceTexture : register(t0);
+SamplerState sourceSampler : register(s0);
+
+cbuffer UyvyConstants : register(b0) {
+    float4 rowY;   // As RgbToYuvConstants, 8-bit limited range
+    float4 rowCb;
+    float4 rowCr;
+    float4 pixel;  // x = half an output pixel in UV
+};
+
+struct PS_INPUT {
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+};
+
+float4 main(PS_INPUT input) : SV_TARGET {
+    float4 left  = float4(sourceTexture.Sample(sourceSampler, input.uv - float2(pixel.x, 0.0)).rgb, 1.0);
+    float4 right = float4(sourceTexture.Sample(sourceSampler, input.uv + float2(pixel.x, 0.0)).rgb, 1.0);
+    float4 both  = (left + right) * 0.5;
+    return float4(dot(rowCb, both), dot(rowY, left), dot(rowCr, both), dot(rowY, right));
+}
+)";
+
+// Global noise set. Hashing and the fade curve are shared by the 2D texture and the
+// 3D volume; lattice cells wrap at `noisePeriod` (doubled per octave) so both
+// tile. The 2D hashes match the CPU fallback in UpdateNoiseTexture bit for bit.
+static const char* g_noiseCommonSource = R"(
+cbuffer NoiseConstants : register(b0) {
+    uint noiseSize;     // Texels per side
+    uint noisePeriod;   // Lattice cells per side at the first octave
+    uint noiseOctaves;  // fBm octaves
+    uint noisePad;
+};
+
+uint hashCell(int3 c, uint seed) {
+    uint h = uint(c.x) * 1619u + uint(c.y) * 31337u + uint(c.z) * 1013u + seed * 6271u;
+    h ^= h >> 13;
+    h *= 0xbf58476du;
+    h ^= h >> 31;
+    return h;
+}
+
+int3 wrapCell(int3 c, int period) {
+    return ((c % period) + period) % period;
+}
+
+float3 quintic(float3 t) {
+    return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+}
+)";
+
+static const char* g_noiseShaderSource = R"(
+RWTexture2D<unorm float4> noiseOut : register(u0);
+
+float gradDot(int2 c, int period, float2 f) {
+    uint g = hashCell(int3(wrapCell(int3(c, 0), period).xy, 0), 0u) & 3u;
+    return ((g & 1u) ? -f.x : f.x) + ((g & 2u) ? -f.y : f.y);
+}
+
+float perlinNoise(float2 p, int period) {
+    int2   i = int2(floor(p));
+    float2 f = p - float2(i);
+    float2 u = quintic(float3(f, 0.0)).xy;
+    float n00 = gradDot(i,              period, f);
+    float n10 = gradDot(i + int2(1, 0), period, f - float2(1.0, 0.0));
+    float n01 = gradDot(i + int2(0, 1), period, f - float2(0.0, 1.0));
+    float n11 = gradDot(i + int2(1, 1), period, f - float2(1.0, 1.0));
+    return lerp(lerp(n00, n10, u.x), lerp(n01, n11, u.x), u.y) * 0.5 + 0.5;
+}
+
+float voronoiNoise(float2 p, int period) {
+    int2  i = int2(floor(p));
+    float minDist = 1e10;
+    [unroll] for (int dy = -1; dy <= 1; ++dy) {
+        [unroll] for (int dx = -1; dx <= 1; ++dx) {
+            int2   c = i + int2(dx, dy);
+            int3   w = int3(wrapCell(int3(c, 0), period).xy, 0);
+            float2 feature = float2(c) + float2(hashCell(w, 0u) & 0xFFFFu, hashCell(w, 1u) & 0xFFFFu) / 65535.0;
+            minDist = min(minDist, distance(p, feature));
+        }
+    }
+    return min(minDist, 1.0);
+}
+
+[numthreads(8, 8, 1)]
+void ComputeShader(uint3 id : SV_DispatchThreadID) {
+    if (id.x >= noiseSize || id.y >= noiseSize) return;
+    float2 uv = (float2(id.xy) + 0.5) / float(noiseSize);
+
+    // R/G: one octave. B/A: fBm of each, amplitude halved per octave
+    float4 result = 0.0;
+    float amp = 1.0, norm = 0.0;
+    for (uint o = 0; o < noiseOctaves; ++o) {
+        int   period = int(noisePeriod << o);
+        float perlin  = perlinNoise(uv * period, period);
+        float voronoi = 1.0 - voronoiNoise(uv * period, period);
+        if (o == 0) result.rg = float2(perlin, voronoi);
+        result.ba += amp * float2(perlin, voronoi);
+        norm += amp;
+        amp *= 0.5;
+    }
+    result.ba /= norm;
+    noiseOut[id.xy] = saturate(result);
+}
+)";
+
+static const char* g_noiseVolumeShaderSource = R"(
+RWTexture3D<unorm float4> volumeOut : register(u0);
+
+// Ken Perlin's 12 edge gradients (16 with 4 repeated)
+float gradDot3(int3 c, int period, float3 f) {
+    uint  h = hashCell(wrapCell(c, period), 0u) & 15u;
+    float u = h < 8u ? f.x : f.y;
+    float v = h < 4u ? f.y : ((h == 12u || h == 14u) ? f.x : f.z);
+    return ((h & 1u) ? -u : u) + ((h & 2u) ? -v : v);
+}
+
+float perlinNoise3(float3 p, int period) {
+    int3   i = int3(floor(p));
+    float3 f = p - float3(i);
+    float3 u = quintic(f);
+    float x00 = lerp(gradDot3(i + int3(0, 0, 0), period, f - float3(0, 0, 0)),
+                     gradDot3(i + int3(1, 0, 0), period, f - float3(1, 0, 0)), u.x);
+    float x10 = lerp(gradDot3(i + int3(0, 1, 0), period, f - float3(0, 1, 0)),
+                     gradDot3(i + int3(1, 1, 0), period, f - float3(1, 1, 0)), u.x);
+    float x01 = lerp(gradDot3(i + int3(0, 0, 1), period, f - float3(0, 0, 1)),
+                     gradDot3(i + int3(1, 0, 1), period, f - float3(1, 0, 1)), u.x);
+    float x11 = lerp(gradDot3(i + int3(0, 1, 1), period, f - float3(0, 1, 1)),
+                     gradDot3(i + int3(1, 1, 1), period, f - float3(1, 1, 1)), u.x);
+    return lerp(lerp(x00, x10, u.y), lerp(x01, x11, u.y), u.z) * 0.5 + 0.5;
+}
+
+[numthreads(4, 4, 4)]
+void ComputeShader(uint3 id : SV_DispatchThreadID) {
+    if (any(id >= noiseSize)) return;
+    float3 uvw = (float3(id) + 0.5) / float(noiseSize);
+
+    // R: one octave. G: fBm
+    float2 result = 0.0;
+    float amp = 1.0, norm = 0.0;
+    for (uint o = 0; o < noiseOctaves; ++o) {
+        int   period = int(noisePeriod << o);
+        float perlin = perlinNoise3(uvw * period, period);
+        if (o == 0) result.r = perlin;
+        result.g += amp * perlin;
+        norm += amp;
+        amp *= 0.5;
+    }
+    result.g /= norm;
+    volumeOut[id] = float4(saturate(result), 0.0, 1.0);
+}
+)";
+
 D3D11Renderer::D3D11Renderer() = default;
 
 D3D11Renderer::~D3D11Renderer() {
@@ -133,6 +780,8 @@ bool D3D11Renderer::Initialize(HWND hwnd, int width, int height) {
     if (!CreateDeviceAndSwapChain(hwnd, width, height)) {
         return false;
     }
+    m_pipelineState.SetContext(m_context.Get());
+    m_shaderCache.Open(GetShaderCachePath(), std::filesystem::path(m_sharedShaderCache));
 
     if (!CreateRenderTarget()) {
         return false;
@@ -146,10 +795,27 @@ bool D3D11Renderer::Initialize(HWND hwnd, int width, int height) {
         return false;
     }
 
-    if (!CreateCompositorShader()) {
+    // Non-fatal: without it the shader always renders at full resolution
+    {
+        std::string error;
+        CompilePixelShader(g_upscaleShaderSource, m_upscalePS, error);
+        // Non-fatal too: recordings at another size are resampled bilinearly
+        CompilePixelShader(g_downscaleShaderSource, m_downscalePS, error);
+    }
+
+    if (!CreateYuvShader()) {
+        return false;
+    }
+
+    if (!CreateRgbToYuvShader()) {
         return false;
     }
 
+    // Non-fatal: without timestamp queries the profiler just records nothing
+    m_gpuProfiler.Initialize(m_device.Get(), m_context.Get());
+    // Non-fatal: hardware frames then always take the YUV shader pass
+    m_videoProcessor.Initialize(m_device.Get(), m_context.Get());
+
     m_activePS = m_passthroughPS;
     return true;
 }
@@ -159,24 +825,119 @@ void D3D11Renderer::Shutdown() {
         m_context->ClearState();
         m_context->Flush();
     }
+    m_pipelineState.SetContext(nullptr);
+    m_constantsUploaded = false;
 
     ReleaseRenderTarget();
 
+    if (m_budgetEvent) {
+        m_adapter3->UnregisterVideoMemoryBudgetChangeNotification(m_budgetCookie);
+        CloseHandle(m_budgetEvent);
+        m_budgetEvent = nullptr;
+    }
+    m_adapter3.Reset();
+
+    if (m_frameLatencyWaitable) {
+        CloseHandle(m_frameLatencyWaitable);
+        m_frameLatencyWaitable = nullptr;
+    }
+    m_gpuProfiler.Shutdown();
+    m_videoProcessor.Shutdown();
+    m_shaderCache.Close();
     m_videoTexture.Reset();
     m_videoSRV.Reset();
-    m_renderTexture.Reset();
-    m_renderTextureRTV.Reset();
-    m_stagingTexture.Reset();
+    m_videoRTV.Reset();
+    m_videoUpload.Reset();
+    for (auto& upload : m_planeUploads) upload.Reset();
+    m_yuvPS.Reset();
+    m_packedYuvPS.Reset();
+    m_yuvConstantBuffer.Reset();
+    m_hwSourceTexture.Reset();
+    m_hwSliceViews.clear();
+    for (auto& plane : m_yuvPlanes) plane = PlaneTexture{};
+    for (auto& input : m_inputTextures) input = InputTexture{};
+    m_deckTexture = InputTexture{};
+    for (auto& lut : m_lutSRVs) lut.Reset();
+    m_cachedFrameSRV.Reset();
+    m_externalVideoSRV.Reset();
+    m_scrubCache.Clear();
+    m_loopCache.Clear();
+    m_renderAhead.SetCapacity(0);
+    m_historyTexture.Reset();
+    m_historySRV.Reset();
+    m_historyRTVs.clear();
+    m_historyConstantBuffer.Reset();
+    m_historyDesc = FrameHistoryDesc{};
+    m_videoMipTexture.Reset();
+    m_videoMipSRV.Reset();
+    m_videoMips = false;
+    DiscardReadbacks();
+    for (auto& slot : m_readbackSlots) slot = ReadbackSlot{};
+    for (auto& plane : m_readbackPlanes) plane = ReadbackPlane{};
+    for (auto& row : m_rgbToYuvRows) row.Reset();
+    for (auto& row : m_nv12Rows) row.Reset();
+    m_rgbToUyvyPS.Reset();
+    m_uyvyConstants.Reset();
+    m_uyvyWidth = 0;
+    m_canvasRegionPS.Reset();
+    m_canvasRegionConstants.Reset();
+    m_encodeTargetTexture.Reset();
+    m_encodeSliceViews.clear();
+    m_rgbToYuvPS.Reset();
     m_displayTexture.Reset();
     m_displayRTV.Reset();
     m_displaySRV.Reset();
+    m_readbackSource.Reset();
     m_noiseTexture.Reset();
     m_noiseSRV.Reset();
+    m_noiseUAV.Reset();
+    m_noiseCS.Reset();
+    m_noiseConstantBuffer.Reset();
+    m_noiseSize = 0;
+    m_noiseVolume.Reset();
+    m_noiseVolumeSRV.Reset();
+    m_noiseVolumeUAV.Reset();
+    m_noiseVolumeCS.Reset();
+    m_noiseVolumeSize = 0;
     m_wrapSampler.Reset();
-    m_compositorPS.Reset();
+    for (auto& shader : m_compositorPS) shader.Reset();
+    m_blendConstantBuffer.Reset();
+    m_layers.clear();
+    m_layerCompositorPS.clear();
+    m_layerConstantBuffer.Reset();
+    m_layerArray.Reset();
+    m_paramBuffer.Reset();
+    m_context1.Reset();
+    for (auto& rtv : m_layerRTVs) rtv.Reset();
+    m_layerSRV.Reset();
+    m_layerSlices = {};
+    m_layerArraySlices = 0;
+    m_upscalePS.Reset();
+    m_lanczosPS.Reset();
+    m_easuPS.Reset();
+    m_rcasPS.Reset();
+    m_rcasConstants.Reset();
+    m_upscaleShadersCompiled = false;
+    m_downscalePS.Reset();
+    m_readbackTarget = RenderTargetPool::Target{};
+    m_scaledTarget = RenderTargetPool::Target{};
+    m_upscaleTarget = RenderTargetPool::Target{};
+    m_sweepTarget  = RenderTargetPool::Target{};
+    m_accumTarget  = RenderTargetPool::Target{};
+    m_sweeping     = false;
     m_compositorSrcTexture.Reset();
     m_compositorSrcRTV.Reset();
     m_compositorSrcSRV.Reset();
+    m_graphPasses.clear();
+    m_graphTargets.clear();
+    m_persistentTargets.clear();
+    m_tapTarget = RenderTargetPool::Target{};
+    m_tapDrawn  = false;
+    m_targetPool.Clear();
+    m_targetPool.ClearRecycled();
+    m_graphPlanned = false;
+    ClearCompute();
+    for (auto& target : m_prewarmTargets) target = PrewarmTarget{};
     m_vertexShader.Reset();
     m_passthroughPS.Reset();
     m_activePS.Reset();
@@ -185,12 +946,58 @@ void D3D11Renderer::Shutdown() {
     m_constantBuffer.Reset();
     m_sampler.Reset();
     m_blendState.Reset();
+    m_accumBlendState.Reset();
+    m_additiveBlendState.Reset();
+    m_alphaBlendState.Reset();
     m_rasterizerState.Reset();
+    m_scissorRasterizerState.Reset();
     m_swapChain.Reset();
     m_context.Reset();
     m_device.Reset();
 }
 
+namespace {
+
+std::string AdapterName(const DXGI_ADAPTER_DESC1& desc) {
+    const int size = WideCharToMultiByte(CP_UTF8, 0, desc.Description, -1, nullptr, 0, nullptr, nullptr);
+    if (size <= 1) return {};
+    std::string out(static_cast<size_t>(size - 1), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, desc.Description, -1, out.data(), size, nullptr, nullptr);
+    return out;
+}
+
+// Hardware adapters, high-performance first when the factory can order them
+std::vector<ComPtr<IDXGIAdapter1>> EnumerateAdapters() {
+    std::vector<ComPtr<IDXGIAdapter1>> adapters;
+    ComPtr<IDXGIFactory1> factory;
+    if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory)))) return adapters;
+    ComPtr<IDXGIFactory6> factory6;
+    factory.As(&factory6);  // Null before Windows 10 1803: enumeration order
+    for (UINT i = 0;; ++i) {
+        ComPtr<IDXGIAdapter1> adapter;
+        const HRESULT hr = factory6
+            ? factory6->EnumAdapterByGpuPreference(i, DXGI_GPU_PREFERENCE_HIGH_PERFORMANCE, IID_PPV_ARGS(&adapter))
+            : factory->EnumAdapters1(i, &adapter);
+        if (FAILED(hr)) break;  // DXGI_ERROR_NOT_FOUND past the last one
+        DXGI_ADAPTER_DESC1 desc = {};
+        if (FAILED(adapter->GetDesc1(&desc)) || (desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE)) continue;
+        adapters.push_back(std::move(adapter));
+    }
+    return adapters;
+}
+
+} // namespace
+
+std::vector<AdapterInfo> D3D11Renderer::ListAdapters() {
+    std::vector<AdapterInfo> out;
+    for (const auto& adapter : EnumerateAdapters()) {
+        DXGI_ADAPTER_DESC1 desc = {};
+        adapter->GetDesc1(&desc);
+        out.push_back({AdapterName(desc), desc.DedicatedVideoMemory});
+    }
+    return out;
+}
+
 bool D3D11Renderer::CreateDeviceAndSwapChain(HWND hwnd, int width, int height) {
     UINT createDeviceFlags = 0;
 #ifdef _DEBUG
@@ -204,29 +1011,27 @@ bool D3D11Renderer::CreateDeviceAndSwapChain(HWND hwnd, int width, int height) {
 
     D3D_FEATURE_LEVEL featureLevel;
 
-    HRESULT hr = D3D11CreateDevice(
-        nullptr,
-        D3D_DRIVER_TYPE_HARDWARE,
-        nullptr,
-        createDeviceFlags,
-        featureLevels,
-        _countof(featureLevels),
-        D3D11_SDK_VERSION,
-        &m_device,
-        &featureLevel,
-        &m_context
-    );
+    // The named adapter, else the first (highest-performance) one; null when
+    // enumeration failed, which leaves the choice to the OS
+    const std::vector<ComPtr<IDXGIAdapter1>> adapters = EnumerateAdapters();
+    ComPtr<IDXGIAdapter1> adapter;
+    if (!adapters.empty()) adapter = adapters.front();
+    for (const auto& candidate : adapters) {
+        DXGI_ADAPTER_DESC1 desc = {};
+        if (!m_preferredAdapter.empty() && SUCCEEDED(candidate->GetDesc1(&desc)) &&
+            AdapterName(desc) == m_preferredAdapter) {
+            adapter = candidate;
+            break;
+        }
+    }
 
-#ifdef _DEBUG
-    // D3D11 debug layer requires "Graphics Tools" Windows optional feature.
-    // Retry without it if that's the cause of failure.
-    if (FAILED(hr) && (createDeviceFlags & D3D11_CREATE_DEVICE_DEBUG)) {
-        createDeviceFlags &= ~D3D11_CREATE_DEVICE_DEBUG;
-        hr = D3D11CreateDevice(
-            nullptr,
-            D3D_DRIVER_TYPE_HARDWARE,
+    // An explicit adapter takes D3D_DRIVER_TYPE_UNKNOWN
+    auto createDevice = [&](IDXGIAdapter* on, UINT flags) {
+        return D3D11CreateDevice(
+            on,
+            on ? D3D_DRIVER_TYPE_UNKNOWN : D3D_DRIVER_TYPE_HARDWARE,
             nullptr,
-            createDeviceFlags,
+            flags,
             featureLevels,
             _countof(featureLevels),
             D3D11_SDK_VERSION,
@@ -234,12 +1039,36 @@ bool D3D11Renderer::CreateDeviceAndSwapChain(HWND hwnd, int width, int height) {
             &featureLevel,
             &m_context
         );
+    };
+
+    HRESULT hr = createDevice(adapter.Get(), createDeviceFlags);
+
+#ifdef _DEBUG
+    // D3D11 debug layer requires "Graphics Tools" Windows optional feature.
+    // Retry without it if that's the cause of failure.
+    if (FAILED(hr) && (createDeviceFlags & D3D11_CREATE_DEVICE_DEBUG)) {
+        createDeviceFlags &= ~D3D11_CREATE_DEVICE_DEBUG;
+        hr = createDevice(adapter.Get(), createDeviceFlags);
     }
 #endif
 
+    // A chosen adapter that can't do feature level 11: the OS default
+    if (FAILED(hr) && adapter) {
+        adapter.Reset();
+        hr = createDevice(nullptr, createDeviceFlags);
+    }
+
     if (FAILED(hr)) {
         return false;
     }
+    if (DXGI_ADAPTER_DESC1 desc = {}; adapter && SUCCEEDED(adapter->GetDesc1(&desc))) {
+        m_adapterName = AdapterName(desc);
+    } else {
+        m_adapterName.clear();  // The OS default
+    }
+    OpenVideoMemoryBudget();
+
+    if (!hwnd) return true;  // Headless
 
     // Get DXGI factory
     ComPtr<IDXGIDevice> dxgiDevice;
@@ -264,7 +1093,18 @@ bool D3D11Renderer::CreateDeviceAndSwapChain(HWND hwnd, int width, int height) {
     swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
     swapChainDesc.BufferCount = 2;
     swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+    swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH | DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+
+    // Tearing presents (VRR displays, vsync off) need the flag on the chain and a
+    // DXGI 1.5 factory that reports support (Windows 10 1511+, driver permitting)
+    ComPtr<IDXGIFactory5> dxgiFactory5;
+    BOOL allowTearing = FALSE;
+    if (SUCCEEDED(dxgiFactory.As(&dxgiFactory5)) &&
+        SUCCEEDED(dxgiFactory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING,
+                                                    &allowTearing, sizeof(allowTearing))) &&
+        allowTearing) {
+        swapChainDesc.Flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+    }
 
     hr = dxgiFactory->CreateSwapChainForHwnd(
         m_device.Get(),
@@ -274,13 +1114,57 @@ bool D3D11Renderer::CreateDeviceAndSwapChain(HWND hwnd, int width, int height) {
         nullptr,
         &m_swapChain
     );
+    if (FAILED(hr)) {
+        // DXGI before 1.3 rejects the waitable flag: Present blocks as before
+        swapChainDesc.Flags &= ~static_cast<UINT>(DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT);
+        hr = dxgiFactory->CreateSwapChainForHwnd(m_device.Get(), hwnd, &swapChainDesc, nullptr, nullptr, &m_swapChain);
+        if (FAILED(hr)) return false;
+    }
+    m_swapChainFlags = swapChainDesc.Flags;
+    m_tearingSupported = (m_swapChainFlags & DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING) != 0;
+
+    ComPtr<IDXGISwapChain2> swapChain2;
+    if ((m_swapChainFlags & DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT) &&
+        SUCCEEDED(m_swapChain.As(&swapChain2))) {
+        swapChain2->SetMaximumFrameLatency(static_cast<UINT>(m_maxFrameLatency));
+        m_frameLatencyWaitable = swapChain2->GetFrameLatencyWaitableObject();
+    }
+    return true;
+}
 
-    return SUCCEEDED(hr);
+void D3D11Renderer::SetMaximumFrameLatency(int frames) {
+    m_maxFrameLatency = std::clamp(frames, 1, 16);
+    ComPtr<IDXGISwapChain2> swapChain2;
+    if (m_frameLatencyWaitable && SUCCEEDED(m_swapChain.As(&swapChain2))) {
+        swapChain2->SetMaximumFrameLatency(static_cast<UINT>(m_maxFrameLatency));
+    }
+}
+
+bool D3D11Renderer::WaitForFrameLatency(DWORD timeoutMs) {
+    if (!m_frameLatencyWaitable || !m_presentedSinceWait) return true;
+    m_presentedSinceWait = false;
+    // Minimized or occluded windows may not release frames: the timeout keeps the loop going
+    return WaitForSingleObjectEx(m_frameLatencyWaitable, timeoutMs, TRUE) == WAIT_OBJECT_0;
 }
 
 bool D3D11Renderer::CreateRenderTarget() {
     ComPtr<ID3D11Texture2D> backBuffer;
-    HRESULT hr = m_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer));
+    HRESULT hr;
+    if (m_swapChain) {
+        hr = m_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer));
+    } else {
+        // Headless: stands in for the back buffer; the RTV keeps it alive
+        D3D11_TEXTURE2D_DESC desc = {};
+        desc.Width            = static_cast<UINT>(m_width);
+        desc.Height           = static_cast<UINT>(m_height);
+        desc.MipLevels        = 1;
+        desc.ArraySize        = 1;
+        desc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.Usage            = D3D11_USAGE_DEFAULT;
+        desc.BindFlags        = D3D11_BIND_RENDER_TARGET;
+        hr = m_device->CreateTexture2D(&desc, nullptr, &backBuffer);
+    }
     if (FAILED(hr)) return false;
 
     hr = m_device->CreateRenderTargetView(backBuffer.Get(), nullptr, &m_renderTargetView);
@@ -302,8 +1186,10 @@ bool D3D11Renderer::Resize(int width, int height) {
 
     ReleaseRenderTarget();
 
-    HRESULT hr = m_swapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, 0);
-    if (FAILED(hr)) return false;
+    if (m_swapChain) {
+        HRESULT hr = m_swapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, m_swapChainFlags);
+        if (FAILED(hr)) return false;
+    }
 
     return CreateRenderTarget();
 }
@@ -419,6 +1305,30 @@ bool D3D11Renderer::CreateShaderResources() {
     hr = m_device->CreateBlendState(&blendDesc, &m_blendState);
     if (FAILED(hr)) return false;
 
+    // Temporal supersampling: each sub-frame added at the blend factor's weight
+    blendDesc.RenderTarget[0].BlendEnable    = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend       = D3D11_BLEND_BLEND_FACTOR;
+    blendDesc.RenderTarget[0].DestBlend      = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].BlendOp        = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha  = D3D11_BLEND_BLEND_FACTOR;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].BlendOpAlpha   = D3D11_BLEND_OP_ADD;
+    hr = m_device->CreateBlendState(&blendDesc, &m_accumBlendState);
+    if (FAILED(hr)) return false;
+
+    // Compute point draws: added up, or source-alpha over what the kernels wrote
+    blendDesc.RenderTarget[0].SrcBlend       = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlend      = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].SrcBlendAlpha  = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+    hr = m_device->CreateBlendState(&blendDesc, &m_additiveBlendState);
+    if (FAILED(hr)) return false;
+    blendDesc.RenderTarget[0].SrcBlend       = D3D11_BLEND_SRC_ALPHA;
+    blendDesc.RenderTarget[0].DestBlend      = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+    hr = m_device->CreateBlendState(&blendDesc, &m_alphaBlendState);
+    if (FAILED(hr)) return false;
+
     // Create rasterizer state
     D3D11_RASTERIZER_DESC rasterDesc = {};
     rasterDesc.FillMode = D3D11_FILL_SOLID;
@@ -426,8 +1336,11 @@ bool D3D11Renderer::CreateShaderResources() {
 
     hr = m_device->CreateRasterizerState(&rasterDesc, &m_rasterizerState);
     if (FAILED(hr)) return false;
+    rasterDesc.ScissorEnable = TRUE;
+    hr = m_device->CreateRasterizerState(&rasterDesc, &m_scissorRasterizerState);
+    if (FAILED(hr)) return false;
 
-    // Audio cbuffer (b1) — always bound, zeroed when no audio.
+    // Audio cbuffer (b1) — zeroed when no audio; bound for shaders that read it.
     D3D11_BUFFER_DESC audioCBDesc = {};
     audioCBDesc.ByteWidth      = sizeof(AudioConstants);
     audioCBDesc.Usage          = D3D11_USAGE_DYNAMIC;
@@ -436,14 +1349,49 @@ bool D3D11Renderer::CreateShaderResources() {
     hr = m_device->CreateBuffer(&audioCBDesc, nullptr, &m_audioConstantBuffer);
     if (FAILED(hr)) return false;
 
-    // Spectrum texture (t3): 1×256 R32_FLOAT DYNAMIC — updated each frame.
-    D3D11_TEXTURE2D_DESC specDesc = {};
-    specDesc.Width     = AudioData::kSpectrumBins;
-    specDesc.Height    = 1;
-    specDesc.MipLevels = 1;
-    specDesc.ArraySize = 1;
-    specDesc.Format    = DXGI_FORMAT_R32_FLOAT;
-    specDesc.SampleDesc.Count  = 1;
+    // Frame history cbuffer (b2) — bound like b1
+    D3D11_BUFFER_DESC historyCBDesc = audioCBDesc;
+    historyCBDesc.ByteWidth = sizeof(HistoryConstants);
+    hr = m_device->CreateBuffer(&historyCBDesc, nullptr, &m_historyConstantBuffer);
+    if (FAILED(hr)) return false;
+
+    // Fused blend cbuffer (b3): amount and on/off for presets compiled with the epilogue
+    D3D11_BUFFER_DESC blendCBDesc = audioCBDesc;
+    blendCBDesc.ByteWidth = sizeof(BlendConstants);
+    hr = m_device->CreateBuffer(&blendCBDesc, nullptr, &m_blendConstantBuffer);
+    if (FAILED(hr)) return false;
+
+    // Layer compositor cbuffer (b4): the video blend amount and each layer's opacity
+    D3D11_BUFFER_DESC layerCBDesc = audioCBDesc;
+    layerCBDesc.ByteWidth = sizeof(LayerConstants);
+    hr = m_device->CreateBuffer(&layerCBDesc, nullptr, &m_layerConstantBuffer);
+    if (FAILED(hr)) return false;
+
+    // Extended param cbuffer (b5): DEFAULT usage so a change can be written by
+    // range; drivers without partial constant buffer updates take the whole buffer
+    D3D11_BUFFER_DESC paramCBDesc = {};
+    paramCBDesc.ByteWidth = MAX_EXTENDED_PARAM_FLOATS * sizeof(float);
+    paramCBDesc.Usage     = D3D11_USAGE_DEFAULT;
+    paramCBDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    hr = m_device->CreateBuffer(&paramCBDesc, nullptr, &m_paramBuffer);
+    if (FAILED(hr)) return false;
+    std::fill(std::begin(m_uploadedParams), std::end(m_uploadedParams), 0.0f);
+    m_partialConstantUpdates = false;
+    if (SUCCEEDED(m_context.As(&m_context1))) {
+        D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+        if (SUCCEEDED(m_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))) {
+            m_partialConstantUpdates = options.ConstantBufferPartialUpdate != FALSE;
+        }
+    }
+
+    // Spectrum texture (t3): 1×256 R32_FLOAT DYNAMIC — updated when it changes.
+    D3D11_TEXTURE2D_DESC specDesc = {};
+    specDesc.Width     = AudioData::kSpectrumBins;
+    specDesc.Height    = 1;
+    specDesc.MipLevels = 1;
+    specDesc.ArraySize = 1;
+    specDesc.Format    = DXGI_FORMAT_R32_FLOAT;
+    specDesc.SampleDesc.Count  = 1;
     specDesc.Usage             = D3D11_USAGE_DYNAMIC;
     specDesc.BindFlags         = D3D11_BIND_SHADER_RESOURCE;
     specDesc.CPUAccessFlags    = D3D11_CPU_ACCESS_WRITE;
@@ -455,177 +1403,387 @@ bool D3D11Renderer::CreateShaderResources() {
     specSRVDesc.ViewDimension       = D3D11_SRV_DIMENSION_TEXTURE2D;
     specSRVDesc.Texture2D.MipLevels = 1;
     hr = m_device->CreateShaderResourceView(m_spectrumTexture.Get(), &specSRVDesc, &m_spectrumSRV);
+    if (FAILED(hr)) return false;
+
+    // Spectrogram ring (t17): DEFAULT, written a row at a time with UpdateSubresource.
+    // Starts silent so rows not yet written read as zero.
+    D3D11_TEXTURE2D_DESC gramDesc = specDesc;
+    gramDesc.Height         = SPECTROGRAM_ROWS;
+    gramDesc.Usage          = D3D11_USAGE_DEFAULT;
+    gramDesc.CPUAccessFlags = 0;
+    const std::vector<float> silence(static_cast<size_t>(AudioData::kSpectrumBins) * SPECTROGRAM_ROWS, 0.0f);
+    D3D11_SUBRESOURCE_DATA gramData = {};
+    gramData.pSysMem     = silence.data();
+    gramData.SysMemPitch = AudioData::kSpectrumBins * sizeof(float);
+    hr = m_device->CreateTexture2D(&gramDesc, &gramData, &m_spectrogramTexture);
+    if (FAILED(hr)) return false;
+    hr = m_device->CreateShaderResourceView(m_spectrogramTexture.Get(), &specSRVDesc, &m_spectrogramSRV);
+    if (FAILED(hr)) return false;
+
+    // Waveform texture (t18): like the spectrum, AudioData::kWaveformSamples
+    // wide, left in red and right in green
+    D3D11_TEXTURE2D_DESC waveDesc = specDesc;
+    waveDesc.Width  = AudioData::kWaveformSamples;
+    waveDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
+    hr = m_device->CreateTexture2D(&waveDesc, nullptr, &m_waveformTexture);
+    if (FAILED(hr)) return false;
+    D3D11_SHADER_RESOURCE_VIEW_DESC waveSRVDesc = specSRVDesc;
+    waveSRVDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
+    hr = m_device->CreateShaderResourceView(m_waveformTexture.Get(), &waveSRVDesc, &m_waveformSRV);
     return SUCCEEDED(hr);
 }
 
 bool D3D11Renderer::CreatePassthroughShader() {
     std::string error;
-    return CompilePixelShader(g_passthroughShaderSource, m_passthroughPS, error);
+    return CompilePixelShader(g_passthroughShaderSource, m_passthroughPS, error, nullptr, &m_passthroughBindings);
+}
+
+ID3D11PixelShader* D3D11Renderer::GetCompositorShader(int mode) {
+    if (mode < 1 || mode > MAX_BLEND_MODE) return nullptr;
+    ComPtr<ID3D11PixelShader>& shader = m_compositorPS[mode];
+    if (!shader) {
+        // Compiled on first use of the mode; the bytecode cache makes that free after the first run
+        std::string error;
+        const std::string source = "#define BLEND_MODE " + std::to_string(mode) + "\n" +
+                                   g_blendFunctionSource + g_compositorShaderSource;
+        CompilePixelShader(source, shader, error);
+    }
+    return shader.Get();
 }
 
-bool D3D11Renderer::CreateCompositorShader() {
+ID3D11PixelShader* D3D11Renderer::GetLayerCompositorShader(int baseMode) {
+    std::string key = std::to_string(baseMode);
+    for (const Layer& layer : m_layers) {
+        key += '|' + (layer.shader ? std::string("p") : "i" + std::to_string(layer.input)) + ':' +
+               std::to_string(layer.blendMode) + ':' + std::to_string(layer.mask) + ':' +
+               std::to_string(layer.transition);
+    }
+    auto found = m_layerCompositorPS.find(key);
+    if (found != m_layerCompositorPS.end()) return found->second.Get();
+
+    // One SPBlend per mode in use, renamed so several can coexist
+    auto blendFunction = [](const std::string& name, int mode) {
+        return "#define SPBlend " + name + "\n#define BLEND_MODE " + std::to_string(mode) + "\n" +
+               g_blendFunctionSource + "#undef BLEND_MODE\n#undef SPBlend\n";
+    };
+    std::string source = g_layerCompositorSource;
+    if (baseMode > 0) source += blendFunction("SPBlendBase", baseMode);
+    for (size_t i = 0; i < m_layers.size(); ++i)
+        source += blendFunction("SPBlendLayer" + std::to_string(i), m_layers[i].blendMode);
+
+    source += "float4 main(PS_INPUT input) : SV_TARGET {\n"
+              "    float2 uv = input.uv;\n"
+              "    float3 g = activeTexture.Sample(clampSampler, uv).rgb;\n";
+    if (baseMode > 0) {
+        source += "    float3 v = videoTexture.Sample(clampSampler, uv).rgb;\n"
+                  "    float3 c = lerp(v, SPBlendBase(v, g), spBase.x);\n";
+    } else {
+        source += "    float3 c = g;\n";
+    }
+    int slice = 0;
+    for (size_t i = 0; i < m_layers.size(); ++i) {
+        const Layer& layer = m_layers[i];
+        const std::string index = std::to_string(i);
+        const std::string sample = layer.shader
+            ? "spLayers.Sample(clampSampler, float3(uv, " + std::to_string(slice++) + "))"
+            : "spInput" + std::to_string(layer.input) + ".Sample(clampSampler, uv)";
+        std::string weight = "spLayer[" + index + "].x";
+        if (layer.transition == DECK_TRANSITION_WIPE) weight = "SPWipe(uv.x, " + weight + ")";
+        if (layer.mask >= 0) weight += " * SPLuma(spInput" + std::to_string(layer.mask) + ".Sample(clampSampler, uv).rgb)";
+        source += "    c = lerp(c, SPBlendLayer" + index + "(c, " + sample + ".rgb), " + weight + ");\n";
+    }
+    source += "    return float4(c, 1.0);\n}\n";
+
+    // Compiled once per layout; the bytecode cache makes that free after the first run.
+    // A failure is kept too, so the stack falls back to the active shader alone.
+    ComPtr<ID3D11PixelShader>& shader = m_layerCompositorPS[key];
     std::string error;
-    return CompilePixelShader(g_compositorShaderSource, m_compositorPS, error);
+    CompilePixelShader(source, shader, error);
+    return shader.Get();
 }
 
-bool D3D11Renderer::CreateCompositorSrcTexture(int width, int height) {
-    if (m_compositorSrcWidth == width && m_compositorSrcHeight == height && m_compositorSrcTexture)
-        return true;
+bool D3D11Renderer::CanFuseBlend(const std::string& source) {
+    static const std::regex entryPoint(R"(float4\s+main\s*\(\s*PS_INPUT\s+\w+\s*\))");
+    return std::regex_search(source, entryPoint);
+}
 
-    m_compositorSrcTexture.Reset();
-    m_compositorSrcRTV.Reset();
-    m_compositorSrcSRV.Reset();
+std::string D3D11Renderer::BuildFusedBlendSource(const std::string& source, int mode) {
+    if (mode < 1 || mode > MAX_BLEND_MODE || !CanFuseBlend(source)) return {};
+    return "#define main SPUserMain\n" + source + "\n#undef main\n"
+           "#define BLEND_MODE " + std::to_string(mode) + "\n" +
+           g_blendFunctionSource + g_fusedBlendEpilogueSource;
+}
 
-    D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width     = static_cast<UINT>(width);
-    texDesc.Height    = static_cast<UINT>(height);
-    texDesc.MipLevels = 1;
-    texDesc.ArraySize = 1;
-    texDesc.Format    = DXGI_FORMAT_R8G8B8A8_UNORM;
-    texDesc.SampleDesc.Count = 1;
-    texDesc.Usage     = D3D11_USAGE_DEFAULT;
-    texDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-
-    HRESULT hr = m_device->CreateTexture2D(&texDesc, nullptr, &m_compositorSrcTexture);
-    if (FAILED(hr)) return false;
+bool D3D11Renderer::CreateYuvShader() {
+    std::string error;
+    if (!CompilePixelShader(g_yuvShaderSource, m_yuvPS, error)) return false;
+    if (!CompilePixelShader(g_packedYuvShaderSource, m_packedYuvPS, error)) return false;
 
-    hr = m_device->CreateRenderTargetView(m_compositorSrcTexture.Get(), nullptr, &m_compositorSrcRTV);
-    if (FAILED(hr)) return false;
+    D3D11_BUFFER_DESC cbDesc = {};
+    cbDesc.ByteWidth      = sizeof(YuvConstants);
+    cbDesc.Usage          = D3D11_USAGE_DYNAMIC;
+    cbDesc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+    cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    HRESULT hr = m_device->CreateBuffer(&cbDesc, nullptr, &m_yuvConstantBuffer);
+    return SUCCEEDED(hr);
+}
 
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format        = texDesc.Format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = 1;
+bool D3D11Renderer::CreateRgbToYuvShader() {
+    std::string error;
+    return CompilePixelShader(g_rgbToYuvShaderSource, m_rgbToYuvPS, error);
+}
 
-    hr = m_device->CreateShaderResourceView(m_compositorSrcTexture.Get(), &srvDesc, &m_compositorSrcSRV);
-    if (FAILED(hr)) return false;
+void D3D11Renderer::RecycleTexture(ComPtr<ID3D11Texture2D>& texture, ComPtr<ID3D11RenderTargetView>& rtv,
+                                   ComPtr<ID3D11ShaderResourceView>& srv, int width, int height,
+                                   DXGI_FORMAT format, UINT bindFlags, D3D11_USAGE usage) {
+    if (texture && width > 0 && height > 0) {
+        RenderTargetPool::Target target;
+        target.texture   = std::move(texture);
+        target.rtv       = std::move(rtv);
+        target.srv       = std::move(srv);
+        target.width     = width;
+        target.height    = height;
+        target.format    = format;
+        target.bindFlags = bindFlags;
+        target.usage     = usage;
+        m_targetPool.Recycle(std::move(target));
+    }
+    texture.Reset();
+    rtv.Reset();
+    srv.Reset();
+}
 
-    m_compositorSrcWidth  = width;
-    m_compositorSrcHeight = height;
+bool D3D11Renderer::TakeTexture(ComPtr<ID3D11Texture2D>& texture, ComPtr<ID3D11RenderTargetView>& rtv,
+                                ComPtr<ID3D11ShaderResourceView>& srv, int width, int height,
+                                DXGI_FORMAT format, UINT bindFlags, D3D11_USAGE usage) {
+    RenderTargetPool::Target target;
+    if (!m_targetPool.Take(m_device.Get(), width, height, format, bindFlags, usage, target))
+        return false;
+    texture = std::move(target.texture);
+    rtv     = std::move(target.rtv);
+    srv     = std::move(target.srv);
     return true;
 }
 
-bool D3D11Renderer::CreateVideoTexture(int width, int height) {
-    if (m_videoWidth == width && m_videoHeight == height && m_videoTexture) {
-        return true;  // Already the right size
+void D3D11Renderer::OpenVideoMemoryBudget() {
+    ComPtr<IDXGIDevice> dxgiDevice;
+    ComPtr<IDXGIAdapter> adapter;
+    if (FAILED(m_device.As(&dxgiDevice)) || FAILED(dxgiDevice->GetAdapter(&adapter)) ||
+        FAILED(adapter.As(&m_adapter3))) {
+        return;  // Pre-WDDM 2.0: no budgets
+    }
+    m_budgetEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (m_budgetEvent &&
+        FAILED(m_adapter3->RegisterVideoMemoryBudgetChangeNotificationEvent(m_budgetEvent, &m_budgetCookie))) {
+        CloseHandle(m_budgetEvent);
+        m_budgetEvent = nullptr;
     }
 
-    m_videoTexture.Reset();
-    m_videoSRV.Reset();
+    // An eighth of the local VRAM budget, capped: small GPUs keep fewer spares
+    const VideoMemoryInfo info = QueryVideoMemory();
+    if (info.localBudget > 0) {
+        m_targetPool.SetRecycleBudget(static_cast<size_t>(
+            (std::min)(static_cast<uint64_t>(RenderTargetPool::DEFAULT_RECYCLE_BUDGET), info.localBudget / 8)));
+    }
+}
 
-    D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width = width;
-    texDesc.Height = height;
-    texDesc.MipLevels = 1;
-    texDesc.ArraySize = 1;
-    texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    texDesc.SampleDesc.Count = 1;
-    texDesc.Usage = D3D11_USAGE_DYNAMIC;
-    texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-    texDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-
-    HRESULT hr = m_device->CreateTexture2D(&texDesc, nullptr, &m_videoTexture);
-    if (FAILED(hr)) return false;
+VideoMemoryInfo D3D11Renderer::QueryVideoMemory() const {
+    VideoMemoryInfo out;
+    if (!m_adapter3) return out;
+    DXGI_QUERY_VIDEO_MEMORY_INFO info = {};
+    if (SUCCEEDED(m_adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info))) {
+        out.localBudget = info.Budget;
+        out.localUsage  = info.CurrentUsage;
+    }
+    if (SUCCEEDED(m_adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &info))) {
+        out.nonLocalBudget = info.Budget;
+        out.nonLocalUsage  = info.CurrentUsage;
+    }
+    return out;
+}
 
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format = texDesc.Format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = 1;
+bool D3D11Renderer::TakeVideoMemoryBudgetChange() {
+    return m_budgetEvent && WaitForSingleObject(m_budgetEvent, 0) == WAIT_OBJECT_0;  // Auto-reset
+}
 
-    hr = m_device->CreateShaderResourceView(m_videoTexture.Get(), &srvDesc, &m_videoSRV);
-    if (FAILED(hr)) return false;
+uint64_t D3D11Renderer::ShrinkCaches(uint64_t bytes) {
+    // Cheapest to lose first: spare targets are only a reallocation away, scrub
+    // cache entries a seek each
+    uint64_t freed = m_targetPool.GetRecycledBytes();
+    m_targetPool.ClearRecycled();
+    if (freed < bytes) {
+        const size_t before = m_scrubCache.GetUsedBytes();
+        const uint64_t keep = before > bytes - freed ? before - (bytes - freed) : 0;
+        m_scrubCache.SetBudgetMB(static_cast<int>(keep >> 20));
+        freed += before - m_scrubCache.GetUsedBytes();
+    }
+    return freed;
+}
 
-    m_videoWidth = width;
-    m_videoHeight = height;
+void D3D11Renderer::GetMemoryUsage(std::vector<MemoryUsage>& out) const {
+    out.push_back({"Render targets", 0, m_targetPool.GetUsedBytes()});
+    out.push_back({"Recycled targets", 0, m_targetPool.GetRecycledBytes()});
+    out.push_back({"Scrub cache", 0, m_scrubCache.GetUsedBytes()});
+    out.push_back({"Loop cache", 0, m_loopCache.GetUsedBytes()});
+    out.push_back({"Render-ahead", 0, m_renderAhead.GetUsedBytes()});
+    if (m_videoMipTexture) {
+        D3D11_TEXTURE2D_DESC desc;
+        m_videoMipTexture->GetDesc(&desc);
+        const size_t pixelBytes = (desc.Format == DXGI_FORMAT_R16G16B16A16_UNORM ||
+                                   desc.Format == DXGI_FORMAT_R16G16B16A16_FLOAT) ? 8 : 4;
+        // The chain adds a third to the top level
+        out.push_back({"Video mips", 0, static_cast<size_t>(desc.Width) * desc.Height * pixelBytes * 4 / 3});
+    }
+    out.push_back({"Shader bytecode cache", m_shaderCache.GetBytes(), 0});
+}
 
-    // Update constants
-    m_constants.videoResolution[0] = static_cast<float>(width);
-    m_constants.videoResolution[1] = static_cast<float>(height);
+bool D3D11Renderer::CreateCompositorSrcTexture(int width, int height) {
+    const DXGI_FORMAT format = WorkingFormat();
+    if (m_compositorSrcWidth == width && m_compositorSrcHeight == height && m_compositorSrcTexture &&
+        m_compositorSrcFormat == format) {
+        return true;
+    }
+
+    constexpr UINT bind = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    RecycleTexture(m_compositorSrcTexture, m_compositorSrcRTV, m_compositorSrcSRV,
+                   m_compositorSrcWidth, m_compositorSrcHeight, m_compositorSrcFormat, bind, D3D11_USAGE_DEFAULT);
+    m_compositorSrcWidth  = 0;
+    m_compositorSrcHeight = 0;
+    if (!TakeTexture(m_compositorSrcTexture, m_compositorSrcRTV, m_compositorSrcSRV,
+                     width, height, format, bind, D3D11_USAGE_DEFAULT)) {
+        return false;
+    }
 
+    m_compositorSrcWidth  = width;
+    m_compositorSrcHeight = height;
+    m_compositorSrcFormat = format;
     return true;
 }
 
-bool D3D11Renderer::CreateRenderToTexture(int width, int height) {
-    m_renderTexture.Reset();
-    m_renderTextureRTV.Reset();
-    m_stagingTexture.Reset();
-    m_renderTextureWidth  = 0;
-    m_renderTextureHeight = 0;
-
-    // Render target texture
-    D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width = width;
-    texDesc.Height = height;
-    texDesc.MipLevels = 1;
-    texDesc.ArraySize = 1;
-    texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    texDesc.SampleDesc.Count = 1;
-    texDesc.Usage = D3D11_USAGE_DEFAULT;
-    texDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
-
-    HRESULT hr = m_device->CreateTexture2D(&texDesc, nullptr, &m_renderTexture);
-    if (FAILED(hr)) return false;
+bool D3D11Renderer::CreateVideoTexture(int width, int height, bool renderTarget, DXGI_FORMAT format) {
+    if (m_videoWidth == width && m_videoHeight == height && m_videoTexture &&
+        m_videoIsRenderTarget == renderTarget && m_videoFormat == format) {
+        return true;  // Already the right size, usage and format
+    }
 
-    hr = m_device->CreateRenderTargetView(m_renderTexture.Get(), nullptr, &m_renderTextureRTV);
-    if (FAILED(hr)) return false;
+    RecycleVideoTexture();
+    m_videoWidth  = 0;
+    m_videoHeight = 0;
+    // Written on the GPU by the YUV conversion pass, or copied from m_videoUpload
+    if (!TakeTexture(m_videoTexture, m_videoRTV, m_videoSRV, width, height, format,
+                     renderTarget ? (D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET) : D3D11_BIND_SHADER_RESOURCE,
+                     D3D11_USAGE_DEFAULT)) {
+        return false;
+    }
 
-    // Staging texture for CPU readback
-    texDesc.Usage = D3D11_USAGE_STAGING;
-    texDesc.BindFlags = 0;
-    texDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    m_videoWidth = width;
+    m_videoHeight = height;
+    m_videoIsRenderTarget = renderTarget;
+    m_videoFormat = format;
+
+    // Update constants
+    m_constants.videoResolution[0] = static_cast<float>(width);
+    m_constants.videoResolution[1] = static_cast<float>(height);
 
-    hr = m_device->CreateTexture2D(&texDesc, nullptr, &m_stagingTexture);
-    if (FAILED(hr)) return false;
-    m_renderTextureWidth  = width;
-    m_renderTextureHeight = height;
     return true;
 }
 
 bool D3D11Renderer::CreateDisplayTexture(int width, int height) {
-    if (m_displayWidth == width && m_displayHeight == height && m_displayTexture)
+    const DXGI_FORMAT format = WorkingFormat();
+    if (m_displayWidth == width && m_displayHeight == height && m_displayTexture && m_displayFormat == format)
         return true;
 
-    m_displayTexture.Reset();
-    m_displayRTV.Reset();
-    m_displaySRV.Reset();
-
-    D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width = width;
-    texDesc.Height = height;
-    texDesc.MipLevels = 1;
-    texDesc.ArraySize = 1;
-    texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    texDesc.SampleDesc.Count = 1;
-    texDesc.Usage = D3D11_USAGE_DEFAULT;
     // Must be both RTV (rendered into) and SRV (sampled by ImGui)
-    texDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-
-    HRESULT hr = m_device->CreateTexture2D(&texDesc, nullptr, &m_displayTexture);
-    if (FAILED(hr)) return false;
-
-    hr = m_device->CreateRenderTargetView(m_displayTexture.Get(), nullptr, &m_displayRTV);
-    if (FAILED(hr)) return false;
-
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format = texDesc.Format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = 1;
-
-    hr = m_device->CreateShaderResourceView(m_displayTexture.Get(), &srvDesc, &m_displaySRV);
-    if (FAILED(hr)) return false;
+    constexpr UINT bind = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    RecycleTexture(m_displayTexture, m_displayRTV, m_displaySRV, m_displayWidth, m_displayHeight,
+                   m_displayFormat, bind, D3D11_USAGE_DEFAULT);
+    m_displayWidth  = 0;
+    m_displayHeight = 0;
+    if (!TakeTexture(m_displayTexture, m_displayRTV, m_displaySRV, width, height, format, bind, D3D11_USAGE_DEFAULT))
+        return false;
 
     m_displayWidth = width;
     m_displayHeight = height;
+    m_displayFormat = format;
+    m_displayDirty = true;
+    m_renderAhead.Invalidate();  // Queued frames have the old size or format
     return true;
 }
 
+namespace {
+
+// Low-discrepancy sample in [0, 1): index's digits in `base` mirrored about the point
+float Halton(int index, int base) {
+    float result = 0.0f;
+    float scale  = 1.0f;
+    while (index > 0) {
+        scale  /= static_cast<float>(base);
+        result += scale * static_cast<float>(index % base);
+        index  /= base;
+    }
+    return result;
+}
+
+} // namespace
+
 void D3D11Renderer::RenderToDisplay() {
     const int renderW = (m_videoWidth  > 0) ? m_videoWidth  : m_generativeWidth;
     const int renderH = (m_videoHeight > 0) ? m_videoHeight : m_generativeHeight;
     if (renderW <= 0 || renderH <= 0) return;
+    m_targetPool.Trim();
     if (!CreateDisplayTexture(renderW, renderH)) return;
+    {
+        GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Shader);
+        PushVideoMips();  // First: the history copies t0's top mip
+        PushFrameHistory();
+    }
+
+    // Idle elision: a shader that ignores time and audio renders the same image
+    // until an input, the shader or a uniform changes, so keep the last one. The
+    // clock is left out of the comparison; time-varying shaders always draw.
+    // BeginFrame has already restored the backbuffer RT and viewport.
+    // A tile sweep in progress finishes first (SetTiling): the display texture
+    // keeps the last complete image meanwhile.
+    const bool blendVideo = (m_videoBlendMode > 0) && (m_videoWidth > 0);
+    const bool stack      = !m_layers.empty();
+    const bool sweep = m_tilesPerFrame > 0 && GetTileCount() > m_tilesPerFrame && !blendVideo && !stack &&
+                       m_graphPasses.empty() && m_computeKernels.empty() && m_renderScale >= 1.0f;
+    if (!sweep) m_sweeping = false;
+    if (!m_sweeping) {
+        ShaderConstants inputs = m_constants;
+        inputs.time = 0.0f;
+        const bool unchanged = !m_displayDirty && memcmp(&inputs, &m_displayConstants, sizeof(inputs)) == 0 &&
+                               memcmp(m_extendedParams, m_displayParams, sizeof(m_extendedParams)) == 0;
+        if (!m_activeTimeVarying && !m_layersTimeVarying && unchanged) {
+            ++m_skippedRedraws;
+            return;
+        }
+        m_displayConstants = inputs;
+        std::copy_n(m_extendedParams, MAX_EXTENDED_PARAM_FLOATS, m_displayParams);
+    }
+    const bool inputsChanged = m_displayDirty;
+    m_displayDirty = false;
+    if (sweep) {
+        GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Shader);
+        if (DrawTileSweep(renderW, renderH)) ++m_displayGeneration;
+        m_context->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
+        D3D11_VIEWPORT mainVP = {};
+        mainVP.Width    = static_cast<float>(m_width);
+        mainVP.Height   = static_cast<float>(m_height);
+        mainVP.MaxDepth = 1.0f;
+        m_context->RSSetViewports(1, &mainVP);
+        return;
+    }
+    ++m_displayGeneration;
 
-    const bool doComposite = (m_videoBlendMode > 0) && (m_videoWidth > 0) && m_compositorPS;
+    // The active shader blends in its own pass when it was compiled with this
+    // mode's epilogue; at a reduced render scale the blend would be upscaled too.
+    // A stack's compositor does the video blend along with the layers.
+    const bool fused = blendVideo && !stack && m_fusedBlendMode == m_videoBlendMode && m_renderScale >= 1.0f;
+    ID3D11PixelShader* compositor = stack ? GetLayerCompositorShader(blendVideo ? m_videoBlendMode : 0)
+                                  : (blendVideo && !fused) ? GetCompositorShader(m_videoBlendMode) : nullptr;
+    const bool doComposite = compositor != nullptr;
+    if (m_fusedBlendMode > 0) UpdateBlendConstants(fused);
 
     auto setViewport = [&](int w, int h) {
         D3D11_VIEWPORT vp = {};
@@ -635,37 +1793,103 @@ void D3D11Renderer::RenderToDisplay() {
         m_context->RSSetViewports(1, &vp);
     };
 
-    if (doComposite) {
-        // Pass 1 — run the active (generative) shader into the compositor src texture.
-        if (!CreateCompositorSrcTexture(renderW, renderH)) return;
+    // One frame into the display texture; false when the compositor source can't be created
+    auto drawFrame = [&](bool layersChanged) {
+        if (doComposite) {
+            // Pass 1 — run the active (generative) shader into the compositor src texture.
+            if (!CreateCompositorSrcTexture(renderW, renderH)) return false;
+
+            float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            {
+                GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Shader);
+                m_context->ClearRenderTargetView(m_compositorSrcRTV.Get(), clearColor);
+                DrawActiveShaderScaled(m_compositorSrcRTV.Get(), renderW, renderH);
+                // Preset layers that changed into their slices
+                if (stack) DrawLayers(renderW, renderH, layersChanged);
+            }
 
-        float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
-        m_context->ClearRenderTargetView(m_compositorSrcRTV.Get(), clearColor);
-        m_context->OMSetRenderTargets(1, m_compositorSrcRTV.GetAddressOf(), nullptr);
-        setViewport(renderW, renderH);
-        m_context->PSSetShader(m_activePS.Get(), nullptr, 0);
-        m_context->Draw(3, 0);
+            // Pass 2 — compositor reads video (t0) + generative result (t2), and the
+            // stack's layers (t24, t4..t7), blends to display.
+            GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Compositor);
+            m_context->ClearRenderTargetView(m_displayRTV.Get(), clearColor);
+            m_context->OMSetRenderTargets(1, m_displayRTV.GetAddressOf(), nullptr);
+            setViewport(renderW, renderH);
+            m_pipelineState.SetPixelShader(compositor);
+            m_context->PSSetShaderResources(2, 1, m_compositorSrcSRV.GetAddressOf());
+            if (stack) {
+                UpdateLayerConstants();
+                m_context->PSSetShaderResources(LAYER_ARRAY_SLOT, 1, m_layerSRV.GetAddressOf());
+                m_pipelineState.SetPSConstantBuffer(LAYER_CBUFFER, m_layerConstantBuffer.Get());
+            }
+            m_context->Draw(3, 0);
 
-        // Pass 2 — compositor reads video (t0) + generative result (t2), blends to display.
-        m_context->ClearRenderTargetView(m_displayRTV.Get(), clearColor);
-        m_context->OMSetRenderTargets(1, m_displayRTV.GetAddressOf(), nullptr);
-        setViewport(renderW, renderH);
-        m_context->PSSetShader(m_compositorPS.Get(), nullptr, 0);
-        m_context->PSSetShaderResources(2, 1, m_compositorSrcSRV.GetAddressOf());
-        m_context->Draw(3, 0);
+            // Unbind t2 and t24 to avoid D3D hazard (RTVs on next frame's pass 1 and layers)
+            ID3D11ShaderResourceView* nullSRV = nullptr;
+            m_context->PSSetShaderResources(2, 1, &nullSRV);
+            if (stack) m_context->PSSetShaderResources(LAYER_ARRAY_SLOT, 1, &nullSRV);
 
-        // Unbind t2 to avoid D3D hazard (it's an RTV on next frame's pass 1)
-        ID3D11ShaderResourceView* nullSRV = nullptr;
-        m_context->PSSetShaderResources(2, 1, &nullSRV);
+            // Restore active shader for subsequent calls
+            m_pipelineState.SetPixelShader(m_activePS.Get());
+        } else {
+            GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Shader);
+            float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            m_context->ClearRenderTargetView(m_displayRTV.Get(), clearColor);
+            if (fused) {
+                // The epilogue samples the video at t2 (clamp sampler at s2)
+                ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV();
+                m_context->PSSetShaderResources(FUSED_BLEND_SLOT, 1, &videoSRV);
+                m_pipelineState.SetPSSampler(FUSED_BLEND_SLOT, m_sampler.Get());
+            }
+            DrawActiveShaderScaled(m_displayRTV.Get(), renderW, renderH);
+            if (fused) {
+                ID3D11ShaderResourceView* nullSRV = nullptr;
+                m_context->PSSetShaderResources(FUSED_BLEND_SLOT, 1, &nullSRV);
+            }
+        }
+        return true;
+    };
 
-        // Restore active shader for subsequent calls
-        m_context->PSSetShader(m_activePS.Get(), nullptr, 0);
+    // Temporal supersampling: sub-frames over the shutter, jittered, summed and resolved
+    const bool stateful = !m_computeKernels.empty() ||
+                          std::any_of(m_graphPasses.begin(), m_graphPasses.end(),
+                                      [](const RenderGraphPass& pass) { return pass.desc.persistent; });
+    bool supersample = m_temporalSamples > 1 && !stateful;
+    if (supersample && (m_accumTarget.width != renderW || m_accumTarget.height != renderH)) {
+        m_targetPool.Recycle(std::move(m_accumTarget));
+        supersample = m_targetPool.Take(m_device.Get(), renderW, renderH, DXGI_FORMAT_R16G16B16A16_FLOAT,
+                                        D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DEFAULT,
+                                        m_accumTarget);
+    }
+    if (!supersample) {
+        if (!drawFrame(inputsChanged)) return;
     } else {
-        float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
-        m_context->ClearRenderTargetView(m_displayRTV.Get(), clearColor);
+        const float zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        m_context->ClearRenderTargetView(m_accumTarget.rtv.Get(), zero);
+        const float frameTime = m_constants.time;
+        const float weight = 1.0f / static_cast<float>(m_temporalSamples);
+        for (int sample = 0; sample < m_temporalSamples; ++sample) {
+            const float offset = (static_cast<float>(sample) + 0.5f) * weight - 0.5f;  // Centred on the frame
+            m_constants.time = (std::max)(0.0f, frameTime + offset * m_shutterSeconds);
+            m_jitter[0] = Halton(sample + 1, 2) - 0.5f;
+            m_jitter[1] = Halton(sample + 1, 3) - 0.5f;
+            UploadConstants(m_constants);
+            if (!drawFrame(inputsChanged && sample == 0)) break;
+            AccumulateDisplay(renderW, renderH, weight);
+        }
+        m_constants.time = frameTime;
+        m_jitter[0] = m_jitter[1] = 0.0f;
+        UploadConstants(m_constants);
+
+        // Resolve: the weights already sum to one
+        GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Shader);
         m_context->OMSetRenderTargets(1, m_displayRTV.GetAddressOf(), nullptr);
         setViewport(renderW, renderH);
+        m_pipelineState.SetPixelShader(m_passthroughPS.Get());
+        m_context->PSSetShaderResources(0, 1, m_accumTarget.srv.GetAddressOf());
         m_context->Draw(3, 0);
+        ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV();
+        m_context->PSSetShaderResources(0, 1, &videoSRV);
+        m_pipelineState.SetPixelShader(m_activePS.Get());
     }
 
     // Restore backbuffer as RT so ImGui can render into it
@@ -677,12 +1901,110 @@ void D3D11Renderer::RenderToDisplay() {
     m_context->RSSetViewports(1, &mainVP);
 }
 
-void D3D11Renderer::BlitDisplayTo(ID3D11RenderTargetView* rtv, int width, int height) {
-    if (!m_displaySRV || !rtv) return;
+void D3D11Renderer::SanitizeLayers(std::vector<Layer>& layers) {
+    // Every layer must name something the generated compositor can declare
+    layers.erase(std::remove_if(layers.begin(), layers.end(), [](const Layer& layer) {
+        return !layer.shader && (layer.input < 0 || layer.input >= MAX_VIDEO_INPUTS);
+    }), layers.end());
+    if (layers.size() > static_cast<size_t>(MAX_LAYERS)) layers.resize(MAX_LAYERS);
+    for (Layer& layer : layers) {
+        layer.blendMode = std::clamp(layer.blendMode, 1, MAX_BLEND_MODE);
+        if (layer.mask < 0 || layer.mask >= MAX_VIDEO_INPUTS) layer.mask = -1;
+        if (layer.transition != DECK_TRANSITION_WIPE) layer.transition = DECK_TRANSITION_FADE;
+    }
+}
 
-    float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
-    m_context->ClearRenderTargetView(rtv, clearColor);
-    m_context->OMSetRenderTargets(1, &rtv, nullptr);
+void D3D11Renderer::PrewarmLayers(std::vector<Layer> layers) {
+    SanitizeLayers(layers);
+    if (layers.empty()) return;
+    const bool blendVideo = (m_videoBlendMode > 0) && (m_videoWidth > 0);
+    std::swap(m_layers, layers);
+    GetLayerCompositorShader(blendVideo ? m_videoBlendMode : 0);  // A map lookup once compiled
+    std::swap(m_layers, layers);
+}
+
+void D3D11Renderer::SetLayers(std::vector<Layer> layers) {
+    SanitizeLayers(layers);
+    auto same = [](const Layer& a, const Layer& b) {
+        return a.shader == b.shader && a.input == b.input && a.blendMode == b.blendMode &&
+               a.opacity == b.opacity && a.mask == b.mask && a.video == b.video &&
+               a.videoWidth == b.videoWidth && a.videoHeight == b.videoHeight && a.transition == b.transition &&
+               memcmp(a.custom, b.custom, sizeof(a.custom)) == 0 && a.params == b.params;
+    };
+    if (layers.size() == m_layers.size() && std::equal(layers.begin(), layers.end(), m_layers.begin(), same)) {
+        // Same stack; a hot-reloaded shader's time-variance or bindings may still differ
+        for (size_t i = 0; i < layers.size(); ++i) {
+            m_layers[i].timeVarying = layers[i].timeVarying;
+            m_layers[i].bindings    = layers[i].bindings;
+        }
+    } else {
+        m_layers       = std::move(layers);
+        m_displayDirty = true;
+        m_layerConstantsDirty = true;
+    }
+
+    m_layerBindings     = { 0u, 0u };
+    m_layersTimeVarying = false;
+    for (const Layer& layer : m_layers) {
+        if (layer.shader) {
+            m_layerBindings |= layer.bindings;
+            m_layersTimeVarying |= layer.timeVarying;
+        } else {
+            m_layerBindings.textures |= 1u << (FIRST_INPUT_SLOT + layer.input);
+        }
+        if (layer.mask >= 0) m_layerBindings.textures |= 1u << (FIRST_INPUT_SLOT + layer.mask);
+    }
+}
+
+bool D3D11Renderer::CreateLayerArray(int width, int height, int slices) {
+    if (m_layerArray && m_layerArrayWidth == width && m_layerArrayHeight == height && m_layerArraySlices >= slices)
+        return true;
+
+    m_layerArray.Reset();
+    m_layerSRV.Reset();
+    for (auto& rtv : m_layerRTVs) rtv.Reset();
+    m_layerSlices      = {};
+    m_layerArraySlices = 0;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = static_cast<UINT>(width);
+    desc.Height           = static_cast<UINT>(height);
+    desc.MipLevels        = 1;
+    desc.ArraySize        = static_cast<UINT>(slices);
+    desc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &m_layerArray)) ||
+        FAILED(m_device->CreateShaderResourceView(m_layerArray.Get(), nullptr, &m_layerSRV))) {
+        m_layerArray.Reset();
+        m_layerSRV.Reset();
+        return false;
+    }
+
+    D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+    rtvDesc.Format                         = desc.Format;
+    rtvDesc.ViewDimension                  = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+    rtvDesc.Texture2DArray.ArraySize       = 1;
+    for (int i = 0; i < slices; ++i) {
+        rtvDesc.Texture2DArray.FirstArraySlice = static_cast<UINT>(i);
+        if (FAILED(m_device->CreateRenderTargetView(m_layerArray.Get(), &rtvDesc, &m_layerRTVs[i]))) {
+            m_layerArray.Reset();
+            m_layerSRV.Reset();
+            for (auto& rtv : m_layerRTVs) rtv.Reset();
+            return false;
+        }
+    }
+    m_layerArrayWidth  = width;
+    m_layerArrayHeight = height;
+    m_layerArraySlices = slices;
+    return true;
+}
+
+void D3D11Renderer::DrawLayers(int width, int height, bool inputsChanged) {
+    const int slices = static_cast<int>(std::count_if(m_layers.begin(), m_layers.end(),
+                                                      [](const Layer& layer) { return layer.shader != nullptr; }));
+    if (slices == 0 || !CreateLayerArray(width, height, slices)) return;
 
     D3D11_VIEWPORT vp = {};
     vp.Width    = static_cast<float>(width);
@@ -690,145 +2012,1959 @@ void D3D11Renderer::BlitDisplayTo(ID3D11RenderTargetView* rtv, int width, int he
     vp.MaxDepth = 1.0f;
     m_context->RSSetViewports(1, &vp);
 
-    // Passthrough — display texture is already shader-processed
-    m_context->PSSetShader(m_passthroughPS.Get(), nullptr, 0);
-    m_context->PSSetShaderResources(0, 1, m_displaySRV.GetAddressOf());
+    int slice = 0;
+    for (const Layer& layer : m_layers) {
+        if (!layer.shader) continue;
+        LayerSlice& cached = m_layerSlices[slice];
+        ID3D11RenderTargetView* rtv = m_layerRTVs[slice].Get();
+        ++slice;
+        if (layer.opacity <= 0.0f) continue;  // Not visible: the slice keeps whatever it had
+
+        // The frame's uniforms with the layer's own values; the video blend
+        // fields belong to the active shader
+        ShaderConstants constants = m_constants;
+        memcpy(constants.custom, layer.custom, sizeof(constants.custom));
+        constants.padding1    = 0.0f;
+        constants.padding2[0] = 0.0f;
+        if (layer.video) {
+            constants.videoResolution[0] = static_cast<float>(layer.videoWidth);
+            constants.videoResolution[1] = static_cast<float>(layer.videoHeight);
+        }
+        ShaderConstants drawn = constants;
+        drawn.time = 0.0f;
+        const bool reuse = cached.shader == layer.shader && !layer.timeVarying &&
+                           !(inputsChanged && layer.bindings.textures != 0) &&
+                           memcmp(&drawn, &cached.drawn, sizeof(drawn)) == 0 && cached.params == layer.params;
+        if (reuse) {
+            ++m_layerCacheHits;
+            continue;
+        }
+
+        UploadConstants(constants);
+        UploadParams(layer.params.data(), layer.params.size());
+        m_context->OMSetRenderTargets(1, &rtv, nullptr);
+        m_pipelineState.SetPixelShader(layer.shader.Get());
+        if (layer.video) m_context->PSSetShaderResources(0, 1, layer.video.GetAddressOf());
+        m_context->Draw(3, 0);
+        if (layer.video) {
+            ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV();
+            m_context->PSSetShaderResources(0, 1, &videoSRV);
+        }
+        cached.shader = layer.shader;
+        cached.drawn  = drawn;
+        cached.params = layer.params;
+        ++m_layerRedraws;
+    }
+    UploadConstants(m_constants);
+    UploadParams(m_extendedParams, MAX_EXTENDED_PARAM_FLOATS);
+    m_pipelineState.SetPixelShader(m_activePS.Get());
+}
+
+void D3D11Renderer::DrawThumbnail(const Layer& layer, float time, ID3D11RenderTargetView* rtv,
+                                  int width, int height) {
+    if (!layer.shader || !rtv) return;
+
+    ShaderConstants constants = m_constants;
+    memcpy(constants.custom, layer.custom, sizeof(constants.custom));
+    constants.time          = time;
+    constants.resolution[0] = static_cast<float>(width);
+    constants.resolution[1] = static_cast<float>(height);
+    constants.padding1      = 0.0f;
+    constants.padding2[0]   = 0.0f;
+    UploadConstants(constants);
+    UploadParams(layer.params.data(), layer.params.size());
+
+    // The frame bound only what its own shaders read; extra binds are harmless
+    // to them, so these stay
+    const ShaderBindings& used = layer.bindings;
+    if (m_audioConstantBuffer && used.ReadsCBuffer(1))
+        m_pipelineState.SetPSConstantBuffer(1, m_audioConstantBuffer.Get());
+    if (m_paramBuffer && used.ReadsCBuffer(PARAM_CBUFFER))
+        m_pipelineState.SetPSConstantBuffer(PARAM_CBUFFER, m_paramBuffer.Get());
+    ID3D11ShaderResourceView* srvs[FIRST_INPUT_SLOT + MAX_VIDEO_INPUTS] = {};
+    srvs[0] = GetActiveVideoSRV();
+    srvs[1] = m_noiseSRV.Get();
+    srvs[3] = m_spectrumSRV.Get();
+    for (int i = 0; i < MAX_VIDEO_INPUTS; ++i) srvs[FIRST_INPUT_SLOT + i] = m_inputTextures[i].srv.Get();
+    m_context->PSSetShaderResources(0, FIRST_INPUT_SLOT + MAX_VIDEO_INPUTS, srvs);
+
+    m_context->OMSetRenderTargets(1, &rtv, nullptr);
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = static_cast<float>(width);
+    vp.Height   = static_cast<float>(height);
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
+    m_pipelineState.SetPixelShader(layer.shader.Get());
     m_context->Draw(3, 0);
 
-    // Restore main backbuffer RT, viewport, active PS, and video SRV
     m_context->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
     D3D11_VIEWPORT mainVP = {};
     mainVP.Width    = static_cast<float>(m_width);
     mainVP.Height   = static_cast<float>(m_height);
     mainVP.MaxDepth = 1.0f;
     m_context->RSSetViewports(1, &mainVP);
-    m_context->PSSetShader(m_activePS.Get(), nullptr, 0);
-    if (m_videoSRV)
-        m_context->PSSetShaderResources(0, 1, m_videoSRV.GetAddressOf());
+    UploadConstants(m_constants);
+    UploadParams(m_extendedParams, MAX_EXTENDED_PARAM_FLOATS);
+    m_pipelineState.SetPixelShader(m_activePS.Get());
 }
 
-bool D3D11Renderer::UploadVideoFrame(const VideoFrame& frame) {
-    if (!CreateVideoTexture(frame.width, frame.height)) {
-        return false;
+void D3D11Renderer::UpdateLayerConstants() {
+    LayerConstants constants = {};
+    constants.base[0] = m_videoBlendFactor;
+    for (size_t i = 0; i < m_layers.size(); ++i) constants.layers[i][0] = std::clamp(m_layers[i].opacity, 0.0f, 1.0f);
+    if (!m_layerConstantBuffer ||
+        (!m_layerConstantsDirty && memcmp(&constants, &m_layerConstants, sizeof(constants)) == 0)) return;
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (SUCCEEDED(m_context->Map(m_layerConstantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        memcpy(mapped.pData, &constants, sizeof(constants));
+        m_context->Unmap(m_layerConstantBuffer.Get(), 0);
+        m_layerConstants      = constants;
+        m_layerConstantsDirty = false;
     }
+}
 
+void D3D11Renderer::UpdateBlendConstants(bool enabled) {
+    const BlendConstants constants{ m_videoBlendFactor, enabled ? 1.0f : 0.0f, 0.0f, 0.0f };
+    if (!m_blendConstantBuffer || memcmp(&constants, &m_blendConstants, sizeof(constants)) == 0) return;
     D3D11_MAPPED_SUBRESOURCE mapped;
-    HRESULT hr = m_context->Map(m_videoTexture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-    if (FAILED(hr)) return false;
-
-    // Copy row by row (handle pitch mismatch)
-    const uint8_t* src = frame.data[0].data();
-    uint8_t* dst = static_cast<uint8_t*>(mapped.pData);
-    int srcPitch = frame.linesize[0];
-    int dstPitch = static_cast<int>(mapped.RowPitch);
-    int rowBytes = frame.width * 4;  // RGBA
+    if (SUCCEEDED(m_context->Map(m_blendConstantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        memcpy(mapped.pData, &constants, sizeof(constants));
+        m_context->Unmap(m_blendConstantBuffer.Get(), 0);
+        m_blendConstants = constants;
+    }
+}
 
-    for (int y = 0; y < frame.height; ++y) {
-        memcpy(dst + y * dstPitch, src + y * srcPitch, rowBytes);
+void D3D11Renderer::DrawActiveShaderScaled(ID3D11RenderTargetView* rtv, int width, int height) {
+    const int scaledW = (std::max)(1, static_cast<int>(std::lround(width  * m_renderScale)));
+    const int scaledH = (std::max)(1, static_cast<int>(std::lround(height * m_renderScale)));
+    if (!m_upscalePS || (scaledW == width && scaledH == height)) {
+        DrawActiveShader(rtv, width, height);
+        return;
+    }
+    const DXGI_FORMAT format = WorkingFormat();
+    if (m_scaledTarget.width != scaledW || m_scaledTarget.height != scaledH || m_scaledTarget.format != format) {
+        // The viewport preview and dynamic resolution step through a few sizes: keep them
+        m_targetPool.Recycle(std::move(m_scaledTarget));
+        if (!m_targetPool.Take(m_device.Get(), scaledW, scaledH, format,
+                               D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DEFAULT,
+                               m_scaledTarget)) {
+            DrawActiveShader(rtv, width, height);
+            return;
+        }
     }
 
-    m_context->Unmap(m_videoTexture.Get(), 0);
-    return true;
+    float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    m_context->ClearRenderTargetView(m_scaledTarget.rtv.Get(), clearColor);
+    DrawActiveShader(m_scaledTarget.rtv.Get(), scaledW, scaledH);
+
+    // Back up to the caller's size
+    DrawUpscaled(m_scaledTarget.srv.Get(), rtv, width, height);
+
+    // Unbind the scaled target (drawn into again next frame) and restore t0 and the active PS
+    ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV();
+    m_context->PSSetShaderResources(0, 1, &videoSRV);
+    m_pipelineState.SetPixelShader(m_activePS.Get());
 }
 
-// FNV-1a 64-bit hash — used to key the shader bytecode cache.
-static uint64_t Fnv1a64(const char* data, size_t len) {
-    uint64_t h = 14695981039346656037ULL;
-    for (size_t i = 0; i < len; ++i) {
-        h ^= static_cast<uint8_t>(data[i]);
-        h *= 1099511628211ULL;
-    }
-    return h;
+void D3D11Renderer::SetRenderScale(float scale) {
+    scale = std::clamp(scale, 0.1f, 1.0f);
+    if (scale == m_renderScale) return;
+    m_renderScale  = scale;
+    m_displayDirty = true;  // A time-invariant shader redraws at the new size
 }
 
-// Returns (and lazily creates) the shader_cache/ dir next to the exe.
-static std::filesystem::path GetShaderCacheDir() {
-    char exePath[MAX_PATH];
-    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
-    auto dir = std::filesystem::path(exePath).parent_path() / "shader_cache";
-    std::filesystem::create_directories(dir);
-    return dir;
+void D3D11Renderer::SetUpscaler(int filter, float sharpness) {
+    filter    = std::clamp(filter, UPSCALE_BICUBIC, UPSCALE_EDGE_ADAPTIVE);
+    sharpness = std::clamp(sharpness, 0.0f, 1.0f);
+    if (filter == m_upscaleFilter && sharpness == m_upscaleSharpness) return;
+    m_upscaleFilter    = filter;
+    m_upscaleSharpness = sharpness;
+    if (m_renderScale < 1.0f) m_displayDirty = true;  // A time-invariant shader redraws through the new filter
 }
 
-bool D3D11Renderer::CompilePixelShader(const std::string& hlslSource, ComPtr<ID3D11PixelShader>& outShader, std::string& outError) {
-    // --- Bytecode cache check ---
-    // Key = FNV-1a hash of the full source (includes preamble defines).
-    // Cache files are DXBC blobs: portable across GPUs (driver JIT-compiles them).
-    const uint64_t hash = Fnv1a64(hlslSource.c_str(), hlslSource.size());
-    char hashStr[17];
-    snprintf(hashStr, sizeof(hashStr), "%016llx", static_cast<unsigned long long>(hash));
-    const auto cachePath = GetShaderCacheDir() / (std::string(hashStr) + ".blob");
-
-    if (std::filesystem::exists(cachePath)) {
-        std::ifstream cacheFile(cachePath, std::ios::binary | std::ios::ate);
-        if (cacheFile) {
-            const auto blobSize = static_cast<size_t>(cacheFile.tellg());
-            cacheFile.seekg(0);
-            std::vector<char> blobData(blobSize);
-            cacheFile.read(blobData.data(), static_cast<std::streamsize>(blobSize));
-            if (cacheFile) {
-                HRESULT hr = m_device->CreatePixelShader(blobData.data(), blobSize, nullptr, &outShader);
-                if (SUCCEEDED(hr)) return true;
-                // Blob corrupt or stale — fall through to full recompile.
-            }
+void D3D11Renderer::DrawUpscaled(ID3D11ShaderResourceView* srv, ID3D11RenderTargetView* rtv, int width, int height) {
+    if (m_upscaleFilter != UPSCALE_BICUBIC && !m_upscaleShadersCompiled) {
+        // Non-fatal: a filter that didn't compile falls back to bicubic
+        m_upscaleShadersCompiled = true;
+        std::string error;
+        CompilePixelShader(g_lanczosShaderSource, m_lanczosPS, error);
+        if (CompilePixelShader(g_easuShaderSource, m_easuPS, error) &&
+            CompilePixelShader(g_rcasShaderSource, m_rcasPS, error)) {
+            D3D11_BUFFER_DESC cbDesc = {};
+            cbDesc.ByteWidth      = sizeof(float) * 4;
+            cbDesc.Usage          = D3D11_USAGE_DYNAMIC;
+            cbDesc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+            cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            if (FAILED(m_device->CreateBuffer(&cbDesc, nullptr, &m_rcasConstants))) m_rcasPS.Reset();
         }
     }
 
-    // --- Full compile ---
-    ComPtr<ID3DBlob> psBlob;
-    ComPtr<ID3DBlob> errorBlob;
-
-    HRESULT hr = D3DCompile(
-        hlslSource.c_str(),
-        hlslSource.size(),
-        "PixelShader",
-        nullptr,
-        nullptr,
-        "main",
-        "ps_5_0",
-        D3DCOMPILE_OPTIMIZATION_LEVEL3,
-        0,
-        &psBlob,
-        &errorBlob
-    );
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = static_cast<float>(width);
+    vp.Height   = static_cast<float>(height);
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
 
-    if (FAILED(hr)) {
-        if (errorBlob) {
-            outError = std::string(
-                static_cast<const char*>(errorBlob->GetBufferPointer()),
-                errorBlob->GetBufferSize()
-            );
-        } else {
-            outError = "Unknown compilation error";
+    ID3D11PixelShader* shader = m_upscalePS ? m_upscalePS.Get() : m_passthroughPS.Get();
+    if (m_upscaleFilter == UPSCALE_LANCZOS && m_lanczosPS) shader = m_lanczosPS.Get();
+    if (m_upscaleFilter == UPSCALE_EDGE_ADAPTIVE && m_easuPS) {
+        shader = m_easuPS.Get();
+        // Sharpened: EASU into an intermediate at the output size, RCAS from it into `rtv`
+        const DXGI_FORMAT format = WorkingFormat();
+        bool sharpen = m_upscaleSharpness > 0.0f && m_rcasPS;
+        if (sharpen && (m_upscaleTarget.width != width || m_upscaleTarget.height != height ||
+                        m_upscaleTarget.format != format)) {
+            m_targetPool.Recycle(std::move(m_upscaleTarget));
+            sharpen = m_targetPool.Take(m_device.Get(), width, height, format,
+                                        D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DEFAULT,
+                                        m_upscaleTarget);
+        }
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (sharpen && SUCCEEDED(m_context->Map(m_rcasConstants.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+            const float constants[4] = { m_upscaleSharpness, 0.0f, 0.0f, 0.0f };
+            memcpy(mapped.pData, constants, sizeof(constants));
+            m_context->Unmap(m_rcasConstants.Get(), 0);
+
+            m_context->OMSetRenderTargets(1, m_upscaleTarget.rtv.GetAddressOf(), nullptr);
+            m_pipelineState.SetPixelShader(m_easuPS.Get());
+            m_context->PSSetShaderResources(0, 1, &srv);
+            m_context->Draw(3, 0);
+
+            m_context->OMSetRenderTargets(1, &rtv, nullptr);  // Unbinds the intermediate as a target first
+            m_pipelineState.SetPixelShader(m_rcasPS.Get());
+            m_pipelineState.SetPSConstantBuffer(0, m_rcasConstants.Get());
+            m_context->PSSetShaderResources(0, 1, m_upscaleTarget.srv.GetAddressOf());
+            m_context->Draw(3, 0);
+            m_pipelineState.SetPSConstantBuffer(0, m_constantBuffer.Get());
+            return;
         }
-        return false;
     }
+    m_context->OMSetRenderTargets(1, &rtv, nullptr);
+    m_pipelineState.SetPixelShader(shader);
+    m_context->PSSetShaderResources(0, 1, &srv);
+    m_context->Draw(3, 0);
+}
 
-    hr = m_device->CreatePixelShader(
-        psBlob->GetBufferPointer(),
-        psBlob->GetBufferSize(),
-        nullptr,
-        &outShader
-    );
+void D3D11Renderer::SetTiling(int tileSize, int tilesPerFrame) {
+    tileSize      = tileSize > 0 ? std::clamp(tileSize, MIN_TILE_SIZE, D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION) : 0;
+    tilesPerFrame = tileSize > 0 ? (std::max)(tilesPerFrame, 0) : 0;
+    if (tileSize == m_tileSize && tilesPerFrame == m_tilesPerFrame) return;
+    m_tileSize      = tileSize;
+    m_tilesPerFrame = tilesPerFrame;
+    m_sweeping      = false;
+    if (m_tilesPerFrame == 0) m_targetPool.Recycle(std::move(m_sweepTarget));
+    m_displayDirty = true;
+}
 
-    if (FAILED(hr)) {
-        outError = "Failed to create pixel shader object";
-        return false;
-    }
+int D3D11Renderer::GetTileCount() const {
+    if (m_tileSize <= 0) return 1;
+    const int renderW = (m_videoWidth  > 0) ? m_videoWidth  : m_generativeWidth;
+    const int renderH = (m_videoHeight > 0) ? m_videoHeight : m_generativeHeight;
+    return ((renderW + m_tileSize - 1) / m_tileSize) * ((renderH + m_tileSize - 1) / m_tileSize);
+}
 
-    // Write blob to cache so subsequent startups skip D3DCompile.
-    {
-        std::ofstream cacheOut(cachePath, std::ios::binary);
-        cacheOut.write(static_cast<const char*>(psBlob->GetBufferPointer()),
-                       static_cast<std::streamsize>(psBlob->GetBufferSize()));
+void D3D11Renderer::DrawTiled(int width, int height) {
+    if (m_tileSize <= 0 || (width <= m_tileSize && height <= m_tileSize)) {
+        m_context->Draw(3, 0);
+        return;
+    }
+    // Each tile is flushed on its own: the scheduler can preempt between them,
+    // and the watchdog times each submission, not the frame
+    m_pipelineState.SetRasterizerState(m_scissorRasterizerState.Get());
+    for (int y = 0; y < height; y += m_tileSize) {
+        for (int x = 0; x < width; x += m_tileSize) {
+            const D3D11_RECT rect = { x, y, (std::min)(x + m_tileSize, width), (std::min)(y + m_tileSize, height) };
+            m_context->RSSetScissorRects(1, &rect);
+            m_context->Draw(3, 0);
+            m_context->Flush();
+        }
+    }
+    m_pipelineState.SetRasterizerState(m_rasterizerState.Get());
+}
+
+bool D3D11Renderer::DrawTileSweep(int width, int height) {
+    const int columns = (width  + m_tileSize - 1) / m_tileSize;
+    const int rows    = (height + m_tileSize - 1) / m_tileSize;
+    if (!m_sweeping) {
+        // Same format as the display texture: the finished sweep is copied into it
+        if (m_sweepTarget.width != width || m_sweepTarget.height != height ||
+            m_sweepTarget.format != m_displayFormat) {
+            m_targetPool.Recycle(std::move(m_sweepTarget));
+            if (!m_targetPool.Take(m_device.Get(), width, height, m_displayFormat,
+                                   D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DEFAULT,
+                                   m_sweepTarget)) {
+                return false;
+            }
+        }
+        // Every tile of the sweep sees the clock and uniforms of its first tick
+        m_sweepConstants = m_constants;
+        m_sweepNext      = 0;
+        m_sweeping       = true;
+    }
+
+    UploadConstants(m_sweepConstants);
+    m_context->OMSetRenderTargets(1, m_sweepTarget.rtv.GetAddressOf(), nullptr);
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = static_cast<float>(width);
+    vp.Height   = static_cast<float>(height);
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
+    m_pipelineState.SetPixelShader(m_activePS.Get());
+    m_pipelineState.SetRasterizerState(m_scissorRasterizerState.Get());
+    const int end = (std::min)(columns * rows, m_sweepNext + m_tilesPerFrame);
+    for (int tile = m_sweepNext; tile < end; ++tile) {
+        const int x = (tile % columns) * m_tileSize;
+        const int y = (tile / columns) * m_tileSize;
+        const D3D11_RECT rect = { x, y, (std::min)(x + m_tileSize, width), (std::min)(y + m_tileSize, height) };
+        m_context->RSSetScissorRects(1, &rect);
+        m_context->Draw(3, 0);
+        m_context->Flush();
+    }
+    m_pipelineState.SetRasterizerState(m_rasterizerState.Get());
+    m_context->OMSetRenderTargets(0, nullptr, nullptr);
+    UploadConstants(m_constants);
+    m_sweepNext = end;
+    if (end < columns * rows) return false;
+
+    m_context->CopyResource(m_displayTexture.Get(), m_sweepTarget.texture.Get());
+    m_sweeping = false;
+    return true;
+}
+
+void D3D11Renderer::SetTemporalSupersampling(int samples, float shutterSeconds) {
+    samples        = std::clamp(samples, 1, MAX_TEMPORAL_SAMPLES);
+    shutterSeconds = (std::max)(shutterSeconds, 0.0f);
+    if (samples == m_temporalSamples && shutterSeconds == m_shutterSeconds) return;
+    m_temporalSamples = samples;
+    m_shutterSeconds  = shutterSeconds;
+    if (m_temporalSamples == 1) m_targetPool.Recycle(std::move(m_accumTarget));
+    m_displayDirty = true;
+}
+
+void D3D11Renderer::AccumulateDisplay(int width, int height, float weight) {
+    m_context->OMSetRenderTargets(1, m_accumTarget.rtv.GetAddressOf(), nullptr);
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = static_cast<float>(width);
+    vp.Height   = static_cast<float>(height);
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
+    m_pipelineState.SetPixelShader(m_passthroughPS.Get());
+    m_pipelineState.SetBlendState(m_accumBlendState.Get(), weight);
+    m_context->PSSetShaderResources(0, 1, m_displaySRV.GetAddressOf());
+    m_context->Draw(3, 0);
+    m_pipelineState.SetBlendState(m_blendState.Get());
+
+    // The next sub-frame draws into the display texture, and may sample the video
+    m_context->OMSetRenderTargets(0, nullptr, nullptr);
+    ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV();
+    m_context->PSSetShaderResources(0, 1, &videoSRV);
+}
+
+bool D3D11Renderer::RenderCanvasTile(int canvasWidth, int canvasHeight, int x, int y, int width, int height,
+                                     float time, FramePool& pool, FrameBuffer& out) {
+    if (!m_device || !m_activePS || !m_graphPasses.empty() || !m_computeKernels.empty()) return false;
+    if (canvasWidth <= 0 || canvasHeight <= 0 || canvasWidth > MAX_CANVAS_SIZE || canvasHeight > MAX_CANVAS_SIZE ||
+        width <= 0 || height <= 0 || width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+        height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION) {
+        return false;
+    }
+
+    RenderTargetPool::Target target;
+    if (!RenderTargetPool::Create(m_device.Get(), width, height, DXGI_FORMAT_R8G8B8A8_UNORM, target)) return false;
+    D3D11_TEXTURE2D_DESC desc = {};
+    target.texture->GetDesc(&desc);
+    desc.Usage          = D3D11_USAGE_STAGING;
+    desc.BindFlags      = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    desc.MiscFlags      = 0;
+    ComPtr<ID3D11Texture2D> staging;
+    if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &staging))) return false;
+
+    const ShaderConstants savedConstants = m_constants;
+    BeginFrame();
+    m_constants.resolution[0] = static_cast<float>(canvasWidth);
+    m_constants.resolution[1] = static_cast<float>(canvasHeight);
+    m_constants.time          = time;
+    UploadConstants(m_constants);
+    const float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    m_context->ClearRenderTargetView(target.rtv.Get(), black);
+    m_context->OMSetRenderTargets(1, target.rtv.GetAddressOf(), nullptr);
+    D3D11_VIEWPORT vp = {};
+    vp.TopLeftX = static_cast<float>(-x);
+    vp.TopLeftY = static_cast<float>(-y);
+    vp.Width    = static_cast<float>(canvasWidth);
+    vp.Height   = static_cast<float>(canvasHeight);
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
+    m_pipelineState.SetPixelShader(m_activePS.Get());
+    m_context->Draw(3, 0);
+    m_context->OMSetRenderTargets(0, nullptr, nullptr);
+    m_context->CopyResource(staging.Get(), target.texture.Get());
+    m_constants    = savedConstants;
+    m_displayDirty = true;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(m_context->Map(staging.Get(), 0, D3D11_MAP_READ, 0, &mapped))) return false;
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    out = pool.Acquire(rowBytes * height);
+    if (out) CopyRows(out.get(), rowBytes, static_cast<const uint8_t*>(mapped.pData), mapped.RowPitch, rowBytes, height);
+    m_context->Unmap(staging.Get(), 0);
+    return out != nullptr;
+}
+
+void D3D11Renderer::BlitDisplayTo(ID3D11RenderTargetView* rtv, int width, int height) {
+    UpscaleTo(m_displaySRV.Get(), rtv, width, height);
+}
+
+void D3D11Renderer::UpscaleTo(ID3D11ShaderResourceView* srv, ID3D11RenderTargetView* rtv, int width, int height) {
+    if (!srv || !rtv) return;
+    ComPtr<ID3D11Resource> resource;
+    srv->GetResource(&resource);
+    ComPtr<ID3D11Texture2D> texture;
+    D3D11_TEXTURE2D_DESC desc = {};
+    if (FAILED(resource.As(&texture))) {
+        BlitTo(srv, rtv, width, height);
+        return;
+    }
+    texture->GetDesc(&desc);
+    // Same size or smaller: bilinear is exact or (downscaling) as good as these get
+    if (static_cast<UINT>(width) <= desc.Width && static_cast<UINT>(height) <= desc.Height) {
+        BlitTo(srv, rtv, width, height);
+        return;
+    }
+
+    float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    m_context->ClearRenderTargetView(rtv, clearColor);
+    DrawUpscaled(srv, rtv, width, height);
+    RestoreAfterBlit();
+}
+
+void D3D11Renderer::BlitTo(ID3D11ShaderResourceView* srv, ID3D11RenderTargetView* rtv, int width, int height,
+                           ID3D11PixelShader* shader) {
+    if (!srv || !rtv) return;
+
+    float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    m_context->ClearRenderTargetView(rtv, clearColor);
+    m_context->OMSetRenderTargets(1, &rtv, nullptr);
+
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = static_cast<float>(width);
+    vp.Height   = static_cast<float>(height);
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
+
+    // Passthrough — display texture is already shader-processed
+    m_pipelineState.SetPixelShader(shader ? shader : m_passthroughPS.Get());
+    m_context->PSSetShaderResources(0, 1, &srv);
+    m_context->Draw(3, 0);
+
+    RestoreAfterBlit();
+}
+
+void D3D11Renderer::RestoreAfterBlit() {
+    // Restore main backbuffer RT, viewport, active PS, and video SRV
+    m_context->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
+    D3D11_VIEWPORT mainVP = {};
+    mainVP.Width    = static_cast<float>(m_width);
+    mainVP.Height   = static_cast<float>(m_height);
+    mainVP.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &mainVP);
+    m_pipelineState.SetPixelShader(m_activePS.Get());
+    if (ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV())
+        m_context->PSSetShaderResources(0, 1, &videoSRV);
+}
+
+void D3D11Renderer::BlitRegionTo(ID3D11ShaderResourceView* srv, ID3D11RenderTargetView* rtv, int width, int height,
+                                 const CanvasRegion& region) {
+    if (!srv || !rtv || width <= 0 || height <= 0) return;
+    if (!m_canvasRegionPS) {
+        std::string error;
+        if (!CompilePixelShader(g_canvasRegionShaderSource, m_canvasRegionPS, error)) return;
     }
+    if (!m_canvasRegionConstants) {
+        D3D11_BUFFER_DESC cbDesc = {};
+        cbDesc.ByteWidth      = sizeof(float) * 20;
+        cbDesc.Usage          = D3D11_USAGE_DYNAMIC;
+        cbDesc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+        cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        if (FAILED(m_device->CreateBuffer(&cbDesc, nullptr, &m_canvasRegionConstants))) return;
+    }
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(m_context->Map(m_canvasRegionConstants.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return;
+    float* constants = static_cast<float*>(mapped.pData);
+    const float values[20] = {
+        region.x, region.y, region.width, region.height,
+        region.blendLeft, region.blendRight, region.blendTop, region.blendBottom,
+        region.corners[0], region.corners[1], region.corners[2], region.corners[3],
+        region.corners[4], region.corners[5], region.corners[6], region.corners[7],
+        std::max(region.blendGamma, 0.1f), 0.0f, 0.0f, 0.0f,
+    };
+    std::copy(values, values + 20, constants);
+    m_context->Unmap(m_canvasRegionConstants.Get(), 0);
+
+    m_pipelineState.SetPSConstantBuffer(0, m_canvasRegionConstants.Get());
+    BlitTo(srv, rtv, width, height, m_canvasRegionPS.Get());
+    m_pipelineState.SetPSConstantBuffer(0, m_constantBuffer.Get());
+}
+
+ID3D11ShaderResourceView* D3D11Renderer::RunPostChain(PostChain& chain, const std::vector<PostStage>& stages,
+                                                      ID3D11ShaderResourceView* source, int width, int height,
+                                                      uint64_t sourceGeneration) {
+    if (stages.empty() || !source || width <= 0 || height <= 0) {
+        ReleasePostChain(chain);
+        return source;
+    }
+
+    // Same input, size, stages and values, and none reads time: the last result stands
+    const uint64_t generation = sourceGeneration ? sourceGeneration : m_displayGeneration;
+    bool reuse = chain.result && chain.source == source && chain.sourceGeneration == generation &&
+                 chain.targets[0].width == width && chain.targets[0].height == height &&
+                 chain.drawn.size() == stages.size();
+    for (size_t i = 0; reuse && i < stages.size(); ++i) {
+        const PostStage& stage = stages[i];
+        const PostChain::Drawn& drawn = chain.drawn[i];
+        reuse = !stage.timeVarying && drawn.shader == stage.shader.Get() &&
+                drawn.kernel == (stage.kernels.empty() ? nullptr : stage.kernels[0].shader.Get()) &&
+                memcmp(drawn.custom, stage.custom, sizeof(drawn.custom)) == 0 && drawn.params == stage.params;
+    }
+    if (reuse) return chain.result;
+
+    // Ping-pong targets at the output's size and working format; a single stage needs one
+    const int targetCount = stages.size() > 1 ? 2 : 1;
+    const DXGI_FORMAT format = WorkingFormat();
+    for (int i = 0; i < 2; ++i) {
+        RenderTargetPool::Target& target = chain.targets[i];
+        if (target.texture && (i >= targetCount || target.width != width || target.height != height ||
+                               target.format != format))
+            m_targetPool.Recycle(std::move(target));
+        if (i < targetCount && !target.texture &&
+            !m_targetPool.Take(m_device.Get(), width, height, format,
+                               D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_DEFAULT, target)) {
+            ReleasePostChain(chain);
+            return source;
+        }
+    }
+    chain.compute.resize(stages.size());
+    chain.drawn.resize(stages.size());
+
+    D3D11_TEXTURE2D_DESC sourceDesc = {};
+    ComPtr<ID3D11Resource> sourceResource;
+    source->GetResource(&sourceResource);
+    static_cast<ID3D11Texture2D*>(sourceResource.Get())->GetDesc(&sourceDesc);
+
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = static_cast<float>(width);
+    vp.Height   = static_cast<float>(height);
+    vp.MaxDepth = 1.0f;
+    ID3D11ShaderResourceView* input = source;
+    bool ok = true;
+    for (size_t i = 0; i < stages.size() && ok; ++i) {
+        const PostStage& stage = stages[i];
+        PostChain::Drawn& drawn = chain.drawn[i];
+        const RenderTargetPool::Target& target = chain.targets[i % 2];
+
+        // The frame's uniforms with the stage's own values, at the output's size;
+        // the video blend fields belong to the active shader
+        ShaderConstants constants = m_constants;
+        memcpy(constants.custom, stage.custom, sizeof(constants.custom));
+        constants.padding1    = 0.0f;
+        constants.padding2[0] = 0.0f;
+        constants.resolution[0]      = static_cast<float>(width);
+        constants.resolution[1]      = static_cast<float>(height);
+        constants.videoResolution[0] = i == 0 ? static_cast<float>(sourceDesc.Width)  : static_cast<float>(width);
+        constants.videoResolution[1] = i == 0 ? static_cast<float>(sourceDesc.Height) : static_cast<float>(height);
+        UploadConstants(constants);
+        UploadParams(stage.params.data(), stage.params.size());
+
+        ID3D11ShaderResourceView* drawnSRV = input;
+        ID3D11PixelShader* shader = stage.shader.Get();
+        if (!stage.kernels.empty()) {
+            ComputeState& state = chain.compute[i];
+            ID3D11ComputeShader* kernel = stage.kernels[0].shader.Get();
+            if (drawn.kernel != kernel && !CreateComputeBuffers(stage.compute, state)) {
+                ok = false;
+                break;
+            }
+            ok = DispatchKernels(stage.kernels, stage.points, stage.compute, state, stage.bindings, input, width, height);
+            drawnSRV = state.outputSRV.Get();
+            shader   = m_passthroughPS.Get();
+        } else {
+            chain.compute[i] = ComputeState{};
+        }
+        if (!ok || !shader) {
+            ok = false;
+            break;
+        }
+
+        m_context->OMSetRenderTargets(1, target.rtv.GetAddressOf(), nullptr);
+        m_context->RSSetViewports(1, &vp);
+        m_pipelineState.SetPixelShader(shader);
+        m_context->PSSetShaderResources(0, 1, &drawnSRV);
+        m_context->Draw(3, 0);
+        // Unbound before the next stage draws into the target this one sampled
+        ID3D11ShaderResourceView* nullSRV = nullptr;
+        m_context->PSSetShaderResources(0, 1, &nullSRV);
+
+        drawn.shader = stage.shader.Get();
+        drawn.kernel = stage.kernels.empty() ? nullptr : stage.kernels[0].shader.Get();
+        memcpy(drawn.custom, stage.custom, sizeof(drawn.custom));
+        drawn.params = stage.params;
+        input = target.srv.Get();
+    }
+
+    // Restore main backbuffer RT, viewport, active PS, video SRV and uniforms
+    m_context->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
+    D3D11_VIEWPORT mainVP = {};
+    mainVP.Width    = static_cast<float>(m_width);
+    mainVP.Height   = static_cast<float>(m_height);
+    mainVP.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &mainVP);
+    m_pipelineState.SetPixelShader(m_activePS.Get());
+    if (ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV())
+        m_context->PSSetShaderResources(0, 1, &videoSRV);
+    UploadConstants(m_constants);
+    UploadParams(m_extendedParams, MAX_EXTENDED_PARAM_FLOATS);
+
+    if (!ok) {
+        ReleasePostChain(chain);
+        return source;
+    }
+    chain.result           = input;
+    chain.generation       = (uint64_t{1} << 63) | ++m_postGeneration;  // Apart from display generations
+    chain.source           = source;
+    chain.sourceGeneration = generation;
+    return chain.result;
+}
+
+void D3D11Renderer::ReleasePostChain(PostChain& chain) {
+    for (RenderTargetPool::Target& target : chain.targets) m_targetPool.Recycle(std::move(target));
+    chain.compute.clear();
+    chain.drawn.clear();
+    chain.result = nullptr;
+    chain.source = nullptr;
+}
+
+bool D3D11Renderer::UploadVideoFrame(const VideoFrame& frame) {
+    GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Upload);
+    m_cachedFrameSRV.Reset();  // A fresh upload replaces any scrub-cache frame at t0
+    const bool uploaded = frame.hwTexture                  ? ConvertHardwareFrame(frame)
+                        : !IsPackedLayout(frame.layout) ? UploadYuvPlanes(frame)
+                                                           : UploadRgbaFrame(frame);
+    m_videoGeneration = uploaded ? frame.generation : 0;
+    if (uploaded) ++m_videoFrameSerial;
+    m_displayDirty = true;
+    return uploaded;
+}
+
+bool D3D11Renderer::UploadRgbaFrame(const VideoFrame& frame) {
+    // The texture takes the frame's byte order, so BGRA and 16-bit frames need no
+    // swizzle or conversion; BGRX samples with alpha = 1
+    DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    int pixelBytes = 4;
+    switch (frame.layout) {
+    case FrameLayout::BGRA8:  format = DXGI_FORMAT_B8G8R8A8_UNORM; break;
+    case FrameLayout::BGRX8:  format = DXGI_FORMAT_B8G8R8X8_UNORM; break;
+    case FrameLayout::RGBA16: format = DXGI_FORMAT_R16G16B16A16_UNORM; pixelBytes = 8; break;
+    default: break;
+    }
+    if (!CreateVideoTexture(frame.width, frame.height, false, format)) {
+        return false;
+    }
+
+    const uint8_t* src = frame.data[0];
+    if (!src || frame.linesize[0] < frame.width * pixelBytes) return false;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (!m_videoUpload.Map(m_device.Get(), m_context.Get(), frame.width, frame.height, format, mapped)) {
+        return false;
+    }
+    CopyRows(static_cast<uint8_t*>(mapped.pData), mapped.RowPitch, src, static_cast<size_t>(frame.linesize[0]),
+             static_cast<size_t>(frame.width) * pixelBytes, frame.height);
+    m_videoUpload.Commit(m_context.Get(), m_videoTexture.Get());
+    return true;
+}
+
+bool D3D11Renderer::UploadInputFrame(int index, const VideoFrame& frame) {
+    if (index < 0 || index >= MAX_VIDEO_INPUTS) return false;
+    if (frame.layout != FrameLayout::RGBA8 || frame.hwTexture || !frame.data[0]) return false;
+
+    InputTexture& input = m_inputTextures[index];
+    if (frame.generation != 0 && frame.generation == input.generation) return true;  // Already there
+    // Not sampled by the active shader or a layer: uploaded on the first frame one does
+    if (!m_activeBindings.ReadsTexture(FIRST_INPUT_SLOT + index) &&
+        !m_layerBindings.ReadsTexture(FIRST_INPUT_SLOT + index)) return true;
+    GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Upload);
+    if (!UploadRgbaTexture(input, frame)) return false;
+    m_displayDirty = true;
+    return true;
+}
+
+bool D3D11Renderer::UploadDeckFrame(const VideoFrame& frame) {
+    if (frame.layout != FrameLayout::RGBA8 || frame.hwTexture || !frame.data[0]) return false;
+    if (frame.generation != 0 && frame.generation == m_deckTexture.generation) return true;  // Already there
+    GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Upload);
+    if (!UploadRgbaTexture(m_deckTexture, frame)) return false;
+    m_displayDirty = true;
+    return true;
+}
+
+bool D3D11Renderer::UploadFrameTexture(InputTexture& target, const VideoFrame& frame) {
+    if (frame.layout != FrameLayout::RGBA8 || frame.hwTexture || !frame.data[0]) return false;
+    if (frame.generation != 0 && frame.generation == target.generation) return true;  // Already there
+    GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Upload);
+    return UploadRgbaTexture(target, frame);
+}
+
+void D3D11Renderer::ReleaseDeckTexture() {
+    m_deckTexture  = InputTexture{};
+    m_displayDirty = true;
+}
+
+bool D3D11Renderer::UploadRgbaTexture(InputTexture& input, const VideoFrame& frame) {
+    if (!input.texture || input.width != frame.width || input.height != frame.height) {
+        input = InputTexture{};
+
+        D3D11_TEXTURE2D_DESC texDesc = {};
+        texDesc.Width            = static_cast<UINT>(frame.width);
+        texDesc.Height           = static_cast<UINT>(frame.height);
+        texDesc.MipLevels        = 1;
+        texDesc.ArraySize        = 1;
+        texDesc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+        texDesc.SampleDesc.Count = 1;
+        texDesc.Usage            = D3D11_USAGE_DYNAMIC;
+        texDesc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+        texDesc.CPUAccessFlags   = D3D11_CPU_ACCESS_WRITE;
+
+        HRESULT hr = m_device->CreateTexture2D(&texDesc, nullptr, &input.texture);
+        if (FAILED(hr)) return false;
+        hr = m_device->CreateShaderResourceView(input.texture.Get(), nullptr, &input.srv);
+        if (FAILED(hr)) {
+            input = InputTexture{};
+            return false;
+        }
+        input.width  = frame.width;
+        input.height = frame.height;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(m_context->Map(input.texture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        return false;
+    }
+    CopyRows(static_cast<uint8_t*>(mapped.pData), mapped.RowPitch, frame.data[0],
+             static_cast<size_t>(frame.linesize[0]), static_cast<size_t>(frame.width) * 4, frame.height);
+    m_context->Unmap(input.texture.Get(), 0);
+    input.generation = frame.generation;
+    return true;
+}
+
+bool D3D11Renderer::SetLut(int index, const ColorLut* lut) {
+    if (index < 0 || index >= MAX_LUTS || !m_device) return false;
+    m_lutSRVs[index].Reset();
+    m_displayDirty = true;
+    if (!lut || !lut->IsValid()) return lut == nullptr;
+
+    // RGB → RGBA32F: filterable everywhere from FL 11, and no precision lost
+    const size_t entries = static_cast<size_t>(lut->size) * lut->size * lut->size;
+    std::vector<float> texels(entries * 4);
+    for (size_t i = 0; i < entries; ++i) {
+        texels[i * 4 + 0] = lut->rgb[i * 3 + 0];
+        texels[i * 4 + 1] = lut->rgb[i * 3 + 1];
+        texels[i * 4 + 2] = lut->rgb[i * 3 + 2];
+        texels[i * 4 + 3] = 1.0f;
+    }
+
+    D3D11_TEXTURE3D_DESC desc = {};
+    desc.Width     = static_cast<UINT>(lut->size);
+    desc.Height    = static_cast<UINT>(lut->size);
+    desc.Depth     = static_cast<UINT>(lut->size);
+    desc.MipLevels = 1;
+    desc.Format    = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    desc.Usage     = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA init = {};
+    init.pSysMem          = texels.data();
+    init.SysMemPitch      = static_cast<UINT>(lut->size * 4 * sizeof(float));
+    init.SysMemSlicePitch = init.SysMemPitch * static_cast<UINT>(lut->size);
+
+    ComPtr<ID3D11Texture3D> texture;
+    if (FAILED(m_device->CreateTexture3D(&desc, &init, &texture))) return false;
+    return SUCCEEDED(m_device->CreateShaderResourceView(texture.Get(), nullptr, &m_lutSRVs[index]));
+}
+
+bool D3D11Renderer::BeginLutBake(int size, LutBake& bake) {
+    bake = LutBake{};
+    if (!m_device || size < MIN_LUT_SIZE || size > MAX_LUT_SIZE) return false;
+    const int width  = size * size;  // Blue slices side by side
+    const int height = size;
+
+    // Identity lattice: texel (r + b * size, g) holds (r, g, b) / (size - 1).
+    // 16-bit UNORM carries every lattice value to within 1e-5.
+    std::vector<uint16_t> lattice(static_cast<size_t>(width) * height * 4);
+    const float step = 65535.0f / static_cast<float>(size - 1);
+    for (int g = 0; g < size; ++g) {
+        for (int b = 0; b < size; ++b) {
+            for (int r = 0; r < size; ++r) {
+                uint16_t* texel = &lattice[(static_cast<size_t>(g) * width + b * size + r) * 4];
+                texel[0] = static_cast<uint16_t>(std::lround(r * step));
+                texel[1] = static_cast<uint16_t>(std::lround(g * step));
+                texel[2] = static_cast<uint16_t>(std::lround(b * step));
+                texel[3] = 65535;
+            }
+        }
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = static_cast<UINT>(width);
+    desc.Height           = static_cast<UINT>(height);
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = DXGI_FORMAT_R16G16B16A16_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+    D3D11_SUBRESOURCE_DATA init = {};
+    init.pSysMem     = lattice.data();
+    init.SysMemPitch = static_cast<UINT>(width * 4 * sizeof(uint16_t));
+
+    ComPtr<ID3D11Texture2D> latticeTexture;
+    ComPtr<ID3D11ShaderResourceView> latticeSRV;
+    RenderTargetPool::Target target;
+    if (FAILED(m_device->CreateTexture2D(&desc, &init, &latticeTexture)) ||
+        FAILED(m_device->CreateShaderResourceView(latticeTexture.Get(), nullptr, &latticeSRV)) ||
+        !RenderTargetPool::Create(m_device.Get(), width, height, DXGI_FORMAT_R32G32B32A32_FLOAT, target)) {
+        return false;
+    }
+
+    desc.Format         = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    desc.Usage          = D3D11_USAGE_STAGING;
+    desc.BindFlags      = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    ComPtr<ID3D11Texture2D> staging;
+    if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &staging))) return false;
+
+    // The lattice stands in for the video at t0, the way a scrub-cache frame does
+    const ComPtr<ID3D11ShaderResourceView> savedFrame = m_cachedFrameSRV;
+    const ShaderConstants savedConstants = m_constants;
+    m_cachedFrameSRV = latticeSRV;
+    m_constants.videoResolution[0] = static_cast<float>(width);
+    m_constants.videoResolution[1] = static_cast<float>(height);
+    BeginFrame();
+    const float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    m_context->ClearRenderTargetView(target.rtv.Get(), black);
+    DrawActiveShader(target.rtv.Get(), width, height);
+    m_context->OMSetRenderTargets(0, nullptr, nullptr);
+    m_context->CopyResource(staging.Get(), target.texture.Get());
+    m_cachedFrameSRV = savedFrame;
+    m_constants      = savedConstants;
+    m_displayDirty   = true;
+    bake.staging = std::move(staging);
+    bake.size    = size;
+    return true;
+}
+
+D3D11Renderer::LutBakeStatus D3D11Renderer::PollLutBake(LutBake& bake, ColorLut& out) {
+    if (!bake.staging || !m_context) {
+        bake = LutBake{};
+        return LutBakeStatus::Failed;
+    }
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    const HRESULT hr = m_context->Map(bake.staging.Get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+    if (hr == DXGI_ERROR_WAS_STILL_DRAWING) return LutBakeStatus::Pending;
+    if (FAILED(hr)) {
+        bake = LutBake{};
+        return LutBakeStatus::Failed;
+    }
+    const int size = bake.size;
+    out = ColorLut{};
+    out.size = size;
+    out.rgb.resize(static_cast<size_t>(size) * size * size * 3);
+    for (int b = 0; b < size; ++b) {
+        for (int g = 0; g < size; ++g) {
+            const float* row = reinterpret_cast<const float*>(static_cast<const uint8_t*>(mapped.pData) +
+                                                              static_cast<size_t>(g) * mapped.RowPitch);
+            for (int r = 0; r < size; ++r) {
+                const float* texel = row + (b * size + r) * 4;
+                float* entry = &out.rgb[((static_cast<size_t>(b) * size + g) * size + r) * 3];
+                entry[0] = texel[0];
+                entry[1] = texel[1];
+                entry[2] = texel[2];
+            }
+        }
+    }
+    m_context->Unmap(bake.staging.Get(), 0);
+    bake = LutBake{};
+    return LutBakeStatus::Done;
+}
+
+void D3D11Renderer::ReleaseInputTexture(int index) {
+    if (index < 0 || index >= MAX_VIDEO_INPUTS) return;
+    m_inputTextures[index] = InputTexture{};
+    m_displayDirty = true;
+    if (m_context) {
+        ID3D11ShaderResourceView* nullSRV = nullptr;
+        m_context->PSSetShaderResources(FIRST_INPUT_SLOT + index, 1, &nullSRV);
+    }
+}
+
+// Affine YUV→RGB rows for the conversion shader. Samples arrive as UNORM values of
+// the texture's channel width; containerScale maps them to normalised bitDepth-bit
+// code values (1 for 8-bit, 65535/(64*1023) for MSB-aligned P010, 65535/1023 for
+// LSB-aligned yuv420p10), and is folded into the matrix here.
+static void BuildYuvMatrix(ColorMatrix matrix, bool fullRange, int bitDepth, float containerScale,
+                           float rowR[4], float rowG[4], float rowB[4]) {
+    float kr = 0.2126f, kb = 0.0722f;  // BT.709
+    if (matrix == ColorMatrix::BT601)  { kr = 0.299f;  kb = 0.114f;  }
+    if (matrix == ColorMatrix::BT2020) { kr = 0.2627f; kb = 0.0593f; }
+    const float kg = 1.0f - kr - kb;
+
+    const float maxCode  = static_cast<float>((1 << bitDepth) - 1);
+    const float codeStep = static_cast<float>(1 << (bitDepth - 8));  // one 8-bit step
+
+    // Limited range: Y in [16,235], C in [16,240] (scaled for higher bit depths)
+    const float yOff   = fullRange ? 0.0f : 16.0f * codeStep / maxCode;
+    const float yScale = fullRange ? 1.0f : maxCode / (219.0f * codeStep);
+    const float cOff   = 128.0f * codeStep / maxCode;
+    const float cScale = fullRange ? 1.0f : maxCode / (224.0f * codeStep);
+
+    const float crR =  2.0f * (1.0f - kr);
+    const float cbG = -2.0f * kb * (1.0f - kb) / kg;
+    const float crG = -2.0f * kr * (1.0f - kr) / kg;
+    const float cbB =  2.0f * (1.0f - kb);
+
+    const float y     = yScale * containerScale;
+    const float c     = cScale * containerScale;
+    const float yBias = -yScale * yOff;
+    const float cBias = -cScale * cOff;
+
+    rowR[0] = y; rowR[1] = 0.0f;    rowR[2] = c * crR; rowR[3] = yBias + cBias * crR;
+    rowG[0] = y; rowG[1] = c * cbG; rowG[2] = c * crG; rowG[3] = yBias + cBias * (cbG + crG);
+    rowB[0] = y; rowB[1] = c * cbB; rowB[2] = 0.0f;    rowB[3] = yBias + cBias * cbB;
+}
+
+// Sample bit depth and chroma subsampling (log2) of a GPU-converted layout
+struct YuvLayoutInfo { int bitDepth, chromaShiftX, chromaShiftY; };
+static YuvLayoutInfo GetYuvLayoutInfo(FrameLayout layout) {
+    switch (layout) {
+    case FrameLayout::P010:
+    case FrameLayout::YUV420P10: return { 10, 1, 1 };
+    case FrameLayout::YUV422P10: return { 10, 1, 0 };
+    case FrameLayout::YUV444P10: return { 10, 0, 0 };
+    case FrameLayout::YUV420P12: return { 12, 1, 1 };
+    case FrameLayout::YUV422P12: return { 12, 1, 0 };
+    case FrameLayout::YUV444P12: return { 12, 0, 0 };
+    case FrameLayout::YUV422P:
+    case FrameLayout::YUYV422:
+    case FrameLayout::UYVY422:   return { 8, 1, 0 };
+    case FrameLayout::YUV444P:   return { 8, 0, 0 };
+    default:                     return { 8, 1, 1 };  // NV12, YUV420P
+    }
+}
+
+// Video texture size for a GPU-converted frame. Proxy frames are drawn smaller;
+// the linear plane sampler does the downscale.
+static int OutputWidth(const VideoFrame& frame)  { return frame.outputWidth  > 0 ? frame.outputWidth  : frame.width; }
+static int OutputHeight(const VideoFrame& frame) { return frame.outputHeight > 0 ? frame.outputHeight : frame.height; }
+
+bool D3D11Renderer::ConvertHardwareFrame(const VideoFrame& frame) {
+    D3D11_TEXTURE2D_DESC srcDesc = {};
+    frame.hwTexture->GetDesc(&srcDesc);
+
+    // Fixed-function path: the video engine converts and scales straight into the
+    // video texture (a render target, as the shader pass leaves it). Its output is
+    // RGBA8, so P010 surfaces take the shader pass when high bit depth is on.
+    const bool highBit = m_highBitDepth && srcDesc.Format == DXGI_FORMAT_P010;
+    m_videoProcessorActive = !highBit && m_useVideoProcessor && m_videoProcessor.IsAvailable() &&
+        CreateVideoTexture(OutputWidth(frame), OutputHeight(frame), true) &&
+        m_videoProcessor.Convert(frame.hwTexture, frame.hwArraySlice, frame.width, frame.height,
+                                 frame.colorMatrix, frame.fullRange, m_videoTexture.Get());
+    if (m_videoProcessorActive) return true;
+
+    DXGI_FORMAT lumaFormat, chromaFormat;
+    YuvConstants yuv = {};
+    switch (srcDesc.Format) {
+    case DXGI_FORMAT_NV12:
+        lumaFormat = DXGI_FORMAT_R8_UNORM;  chromaFormat = DXGI_FORMAT_R8G8_UNORM;
+        BuildYuvMatrix(frame.colorMatrix, frame.fullRange, 8, 1.0f, yuv.rowR, yuv.rowG, yuv.rowB);
+        break;
+    case DXGI_FORMAT_P010:
+        lumaFormat = DXGI_FORMAT_R16_UNORM; chromaFormat = DXGI_FORMAT_R16G16_UNORM;
+        BuildYuvMatrix(frame.colorMatrix, frame.fullRange, 10, 65535.0f / (64.0f * 1023.0f),
+                       yuv.rowR, yuv.rowG, yuv.rowB);
+        break;
+    default:
+        return false;
+    }
+
+    // The decoder allocates one texture array per surface pool; views are cached
+    // per slice and dropped when a new pool appears (seek across a resolution change).
+    if (m_hwSourceTexture.Get() != frame.hwTexture) {
+        m_hwSourceTexture = frame.hwTexture;
+        m_hwSliceViews.clear();
+        m_hwSliceViews.resize(srcDesc.ArraySize);
+    }
+    if (frame.hwArraySlice < 0 || frame.hwArraySlice >= static_cast<int>(m_hwSliceViews.size())) {
+        return false;
+    }
+
+    HwPlaneViews& views = m_hwSliceViews[frame.hwArraySlice];
+    if (!views.luma || !views.chroma) {
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.ViewDimension                  = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        srvDesc.Texture2DArray.MipLevels       = 1;
+        srvDesc.Texture2DArray.FirstArraySlice = static_cast<UINT>(frame.hwArraySlice);
+        srvDesc.Texture2DArray.ArraySize       = 1;
+
+        srvDesc.Format = lumaFormat;
+        HRESULT hr = m_device->CreateShaderResourceView(frame.hwTexture, &srvDesc, &views.luma);
+        if (FAILED(hr)) return false;
+
+        srvDesc.Format = chromaFormat;
+        hr = m_device->CreateShaderResourceView(frame.hwTexture, &srvDesc, &views.chroma);
+        if (FAILED(hr)) return false;
+    }
+
+    // Surfaces are padded to the codec's alignment (e.g. 1088 rows) — crop via uvScale.
+    yuv.uvScale[0] = static_cast<float>(frame.width)  / static_cast<float>(srcDesc.Width);
+    yuv.uvScale[1] = static_cast<float>(frame.height) / static_cast<float>(srcDesc.Height);
+
+    ID3D11ShaderResourceView* planes[3] = { views.luma.Get(), views.chroma.Get(), nullptr };
+    return RunYuvPass(planes, OutputWidth(frame), OutputHeight(frame), yuv,
+                      highBit ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM);
+}
+
+bool D3D11Renderer::EnsurePlaneTexture(PlaneTexture& plane, int width, int height, DXGI_FORMAT format) {
+    if (plane.texture && plane.width == width && plane.height == height && plane.format == format)
+        return true;
+
+    plane = PlaneTexture{};
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = static_cast<UINT>(width);
+    desc.Height           = static_cast<UINT>(height);
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;  // Filled by CopyResource from an upload ring
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+
+    HRESULT hr = m_device->CreateTexture2D(&desc, nullptr, &plane.texture);
+    if (FAILED(hr)) return false;
+
+    // Array view over a single slice so the same Texture2DArray shader serves both
+    // hardware surfaces and CPU planes.
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format                   = format;
+    srvDesc.ViewDimension            = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    srvDesc.Texture2DArray.MipLevels = 1;
+    srvDesc.Texture2DArray.ArraySize = 1;
+
+    hr = m_device->CreateShaderResourceView(plane.texture.Get(), &srvDesc, &plane.srv);
+    if (FAILED(hr)) {
+        plane = PlaneTexture{};
+        return false;
+    }
+
+    plane.width  = width;
+    plane.height = height;
+    plane.format = format;
+    return true;
+}
 
+bool D3D11Renderer::UploadYuvPlanes(const VideoFrame& frame) {
+    if (frame.layout == FrameLayout::YUYV422 || frame.layout == FrameLayout::UYVY422)
+        return UploadPackedYuv(frame);
+
+    const YuvLayoutInfo info = GetYuvLayoutInfo(frame.layout);
+    const bool highBit    = info.bitDepth > 8;
+    const bool interleave = (frame.layout == FrameLayout::NV12 || frame.layout == FrameLayout::P010);
+    const int  bytesPerSample = highBit ? 2 : 1;
+    const int  chromaW = (frame.width  + (1 << info.chromaShiftX) - 1) >> info.chromaShiftX;
+    const int  chromaH = (frame.height + (1 << info.chromaShiftY) - 1) >> info.chromaShiftY;
+
+    const DXGI_FORMAT single = highBit ? DXGI_FORMAT_R16_UNORM   : DXGI_FORMAT_R8_UNORM;
+    const DXGI_FORMAT pair   = highBit ? DXGI_FORMAT_R16G16_UNORM : DXGI_FORMAT_R8G8_UNORM;
+
+    struct PlaneDesc { int width, height, rowBytes; DXGI_FORMAT format; };
+    PlaneDesc planes[3] = {
+        { frame.width, frame.height, frame.width * bytesPerSample, single },
+        { chromaW, chromaH, chromaW * bytesPerSample * (interleave ? 2 : 1), interleave ? pair : single },
+        { chromaW, chromaH, chromaW * bytesPerSample, single },
+    };
+    const int planeCount = interleave ? 2 : 3;
+
+    for (int i = 0; i < planeCount; ++i) {
+        const PlaneDesc& pd = planes[i];
+        if (!frame.data[i] || frame.linesize[i] < pd.rowBytes) return false;
+        if (!EnsurePlaneTexture(m_yuvPlanes[i], pd.width, pd.height, pd.format)) return false;
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (!m_planeUploads[i].Map(m_device.Get(), m_context.Get(), pd.width, pd.height, pd.format, mapped))
+            return false;
+        CopyRows(static_cast<uint8_t*>(mapped.pData), mapped.RowPitch, frame.data[i],
+                 static_cast<size_t>(frame.linesize[i]), static_cast<size_t>(pd.rowBytes), pd.height);
+        m_planeUploads[i].Commit(m_context.Get(), m_yuvPlanes[i].texture.Get());
+    }
+
+    // P010 is MSB-aligned in its 16-bit words; FFmpeg's planar formats are LSB-aligned
+    const float maxCode = static_cast<float>((1 << info.bitDepth) - 1);
+    const float containerScale = !highBit ? 1.0f
+                               : (frame.layout == FrameLayout::P010) ? 65535.0f / (64.0f * maxCode)
+                                                                      : 65535.0f / maxCode;
+    YuvConstants yuv = {};
+    BuildYuvMatrix(frame.colorMatrix, frame.fullRange, info.bitDepth, containerScale, yuv.rowR, yuv.rowG, yuv.rowB);
+    yuv.uvScale[0]   = 1.0f;
+    yuv.uvScale[1]   = 1.0f;
+    yuv.planarChroma = interleave ? 0.0f : 1.0f;
+
+    ID3D11ShaderResourceView* srvs[3] = {
+        m_yuvPlanes[0].srv.Get(), m_yuvPlanes[1].srv.Get(),
+        interleave ? nullptr : m_yuvPlanes[2].srv.Get()
+    };
+    return RunYuvPass(srvs, OutputWidth(frame), OutputHeight(frame), yuv,
+                      (highBit && m_highBitDepth) ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM);
+}
+
+bool D3D11Renderer::UploadPackedYuv(const VideoFrame& frame) {
+    // Two pixels per RGBA8 texel: the copy is the frame's own 2 bytes/pixel
+    const int pairs    = (frame.width + 1) / 2;
+    const int rowBytes = pairs * 4;
+    if (!frame.data[0] || frame.linesize[0] < rowBytes) return false;
+    if (!EnsurePlaneTexture(m_yuvPlanes[0], pairs, frame.height, DXGI_FORMAT_R8G8B8A8_UNORM)) return false;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (!m_planeUploads[0].Map(m_device.Get(), m_context.Get(), pairs, frame.height,
+                               DXGI_FORMAT_R8G8B8A8_UNORM, mapped)) {
+        return false;
+    }
+    CopyRows(static_cast<uint8_t*>(mapped.pData), mapped.RowPitch, frame.data[0],
+             static_cast<size_t>(frame.linesize[0]), static_cast<size_t>(rowBytes), frame.height);
+    m_planeUploads[0].Commit(m_context.Get(), m_yuvPlanes[0].texture.Get());
+
+    YuvConstants yuv = {};
+    BuildYuvMatrix(frame.colorMatrix, frame.fullRange, 8, 1.0f, yuv.rowR, yuv.rowG, yuv.rowB);
+    yuv.uvScale[0] = static_cast<float>(frame.width) / static_cast<float>(pairs * 2);
+    yuv.uvScale[1] = 1.0f;
+    yuv.uyvy       = (frame.layout == FrameLayout::UYVY422) ? 1.0f : 0.0f;
+
+    ID3D11ShaderResourceView* srvs[3] = { m_yuvPlanes[0].srv.Get(), nullptr, nullptr };
+    return RunYuvPass(srvs, OutputWidth(frame), OutputHeight(frame), yuv, DXGI_FORMAT_R8G8B8A8_UNORM,
+                      m_packedYuvPS.Get());
+}
+
+bool D3D11Renderer::RunYuvPass(ID3D11ShaderResourceView* const planes[3], int width, int height,
+                               const YuvConstants& yuv, DXGI_FORMAT format, ID3D11PixelShader* shader) {
+    if (!shader) shader = m_yuvPS.Get();
+    if (!shader || !m_yuvConstantBuffer) return false;
+    if (!CreateVideoTexture(width, height, true, format)) return false;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(m_context->Map(m_yuvConstantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        return false;
+    }
+    memcpy(mapped.pData, &yuv, sizeof(yuv));
+    m_context->Unmap(m_yuvConstantBuffer.Get(), 0);
+
+    // Full pipeline setup — this runs before BeginFrame, which rebinds everything.
+    m_context->OMSetRenderTargets(1, m_videoRTV.GetAddressOf(), nullptr);
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = static_cast<float>(width);
+    vp.Height   = static_cast<float>(height);
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
+
+    m_pipelineState.SetInputAssembler(m_inputLayout.Get(), m_vertexBuffer.Get(), sizeof(float) * 4);
+    m_pipelineState.SetVertexShader(m_vertexShader.Get());
+    m_pipelineState.SetPixelShader(shader);
+    m_pipelineState.SetPSConstantBuffer(0, m_yuvConstantBuffer.Get());
+    m_context->PSSetShaderResources(0, 3, planes);
+    m_pipelineState.SetPSSampler(0, m_sampler.Get());
+    m_pipelineState.SetRasterizerState(m_rasterizerState.Get());
+    m_pipelineState.SetBlendState(m_blendState.Get());
+    m_context->Draw(3, 0);
+
+    // Unbind the planes and the video RTV — BeginFrame samples m_videoSRV at t0 next.
+    ID3D11ShaderResourceView* nullSRVs[3] = {};
+    m_context->PSSetShaderResources(0, 3, nullSRVs);
+    m_context->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
+    return true;
+}
+
+// Render target format of a pass or compute output
+static DXGI_FORMAT PassDxgiFormat(PassFormat format) {
+    switch (format) {
+    case PassFormat::RGBA32F:  return DXGI_FORMAT_R32G32B32A32_FLOAT;
+    case PassFormat::RGBA16F:  return DXGI_FORMAT_R16G16B16A16_FLOAT;
+    case PassFormat::RG11B10F: return DXGI_FORMAT_R11G11B10_FLOAT;
+    case PassFormat::R32F:     return DXGI_FORMAT_R32_FLOAT;
+    default:                   return DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+// Pack file of the bytecode cache, in shader_cache/ next to the exe
+static std::filesystem::path GetShaderCachePath() {
+    char exePath[MAX_PATH];
+    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+    return std::filesystem::path(exePath).parent_path() / "shader_cache" / "shaders.pack";
+}
+
+// The t and b registers the bytecode reads (unused ones are compiled out)
+static ShaderBindings ReflectBindings(const void* bytecode, size_t size) {
+    ComPtr<ID3D11ShaderReflection> reflection;
+    D3D11_SHADER_DESC shaderDesc = {};
+    if (FAILED(D3DReflect(bytecode, size, IID_PPV_ARGS(&reflection))) || FAILED(reflection->GetDesc(&shaderDesc))) {
+        return ShaderBindings{};
+    }
+    ShaderBindings used{0, 0};
+    for (UINT i = 0; i < shaderDesc.BoundResources; ++i) {
+        D3D11_SHADER_INPUT_BIND_DESC bind = {};
+        if (FAILED(reflection->GetResourceBindingDesc(i, &bind))) return ShaderBindings{};
+        uint32_t* mask = bind.Type == D3D_SIT_CBUFFER ? &used.cbuffers
+                       : (bind.Type == D3D_SIT_TEXTURE || bind.Type == D3D_SIT_TBUFFER ||
+                          bind.Type == D3D_SIT_STRUCTURED || bind.Type == D3D_SIT_BYTEADDRESS) ? &used.textures
+                       : nullptr;
+        if (!mask) continue;  // Samplers and UAVs
+        for (UINT slot = bind.BindPoint; slot < bind.BindPoint + bind.BindCount && slot < 32; ++slot) {
+            *mask |= 1u << slot;
+        }
+    }
+    return used;
+}
+
+static ShaderCost ReflectCost(const void* bytecode, size_t size) {
+    ComPtr<ID3D11ShaderReflection> reflection;
+    D3D11_SHADER_DESC desc = {};
+    if (FAILED(D3DReflect(bytecode, size, IID_PPV_ARGS(&reflection))) || FAILED(reflection->GetDesc(&desc))) {
+        return ShaderCost{};
+    }
+    ShaderCost cost;
+    cost.instructions   = desc.InstructionCount;
+    cost.textureSamples = desc.TextureNormalInstructions + desc.TextureLoadInstructions +
+                          desc.TextureCompInstructions + desc.TextureBiasInstructions +
+                          desc.TextureGradientInstructions;
+    cost.flowControl    = desc.DynamicFlowControlCount;
+    cost.tempRegisters  = desc.TempRegisterCount;
+    return cost;
+}
+
+// Whether the output can change with nothing but the clock: the shader reads
+// `time` (b0 offset 0), the audio cbuffer (b1), the spectrum texture (t3), the
+// spectrogram (t17) or the waveform (t18). Anything unreadable counts as time-varying.
+static bool IsTimeVaryingBytecode(const void* bytecode, size_t size) {
+    ComPtr<ID3D11ShaderReflection> reflection;
+    if (FAILED(D3DReflect(bytecode, size, IID_PPV_ARGS(&reflection)))) return true;
+
+    D3D11_SHADER_DESC shaderDesc = {};
+    if (FAILED(reflection->GetDesc(&shaderDesc))) return true;
+
+    for (UINT i = 0; i < shaderDesc.BoundResources; ++i) {
+        D3D11_SHADER_INPUT_BIND_DESC bind = {};
+        if (FAILED(reflection->GetResourceBindingDesc(i, &bind))) return true;
+
+        if (bind.Type == D3D_SIT_TEXTURE) {
+            for (int slot : { 3, SPECTROGRAM_SLOT, WAVEFORM_SLOT }) {
+                if (bind.BindPoint <= static_cast<UINT>(slot) && bind.BindPoint + bind.BindCount > static_cast<UINT>(slot))
+                    return true;
+            }
+        }
+        if (bind.Type != D3D_SIT_CBUFFER) continue;
+        if (bind.BindPoint == 1) return true;
+        if (bind.BindPoint != 0) continue;
+
+        ID3D11ShaderReflectionConstantBuffer* cbuffer = reflection->GetConstantBufferByName(bind.Name);
+        D3D11_SHADER_BUFFER_DESC bufferDesc = {};
+        if (!cbuffer || FAILED(cbuffer->GetDesc(&bufferDesc))) return true;
+        for (UINT v = 0; v < bufferDesc.Variables; ++v) {
+            D3D11_SHADER_VARIABLE_DESC varDesc = {};
+            if (FAILED(cbuffer->GetVariableByIndex(v)->GetDesc(&varDesc))) return true;
+            if (varDesc.StartOffset == 0 && (varDesc.uFlags & D3D_SVF_USED)) return true;
+        }
+    }
+    return false;
+}
+
+// Part of every bytecode cache key: a flag change must not load old blobs
+static constexpr UINT SHADER_COMPILE_FLAGS = D3DCOMPILE_OPTIMIZATION_LEVEL3;
+
+// `includes` null: #include lines fail to compile. outCacheable is false when the
+// handler had to read a file the snapshot (and so the cache key) doesn't cover.
+static bool CompileBytecode(const std::string& hlslSource, const char* sourceName, const char* target,
+                            const ShaderIncludes* includes, std::vector<char>& outBytecode,
+                            std::string& outError, bool& outCacheable, const char* entryPoint = "main") {
+    ComPtr<ID3DBlob> blob;
+    ComPtr<ID3DBlob> errorBlob;
+    std::optional<ShaderIncludeHandler> handler;
+    if (includes) handler.emplace(*includes);
+
+    HRESULT hr = D3DCompile(
+        hlslSource.c_str(),
+        hlslSource.size(),
+        sourceName,
+        nullptr,
+        handler ? &*handler : nullptr,
+        entryPoint,
+        target,
+        SHADER_COMPILE_FLAGS,
+        0,
+        &blob,
+        &errorBlob
+    );
+
+    if (FAILED(hr)) {
+        if (errorBlob) {
+            outError = std::string(
+                static_cast<const char*>(errorBlob->GetBufferPointer()),
+                errorBlob->GetBufferSize()
+            );
+        } else {
+            outError = "Unknown compilation error";
+        }
+        return false;
+    }
+
+    const auto* data = static_cast<const char*>(blob->GetBufferPointer());
+    outBytecode.assign(data, data + blob->GetBufferSize());
+    outCacheable = !handler || !handler->ReadUntracked();
+    return true;
+}
+
+bool D3D11Renderer::CompilePixelShader(const std::string& hlslSource, ComPtr<ID3D11PixelShader>& outShader,
+                                       std::string& outError, bool* outTimeVarying, ShaderBindings* outBindings,
+                                       ShaderCost* outCost, const ShaderIncludes* includes) {
+    // --- Bytecode cache check ---
+    // Cached blobs are DXBC: portable across GPUs (the driver JIT-compiles them)
+    const uint64_t cacheKey = m_shaderCache.MakeKey(hlslSource, "ps_5_0", SHADER_COMPILE_FLAGS,
+                                                    includes ? includes->Hash() : 0);
+    std::vector<char> bytecode;
+    const bool cached = m_shaderCache.Load(cacheKey, bytecode) &&
+                        SUCCEEDED(m_device->CreatePixelShader(bytecode.data(), bytecode.size(), nullptr, &outShader));
+
+    // --- Full compile --- (also when the cached blob is corrupt or stale)
+    if (!cached) {
+        bool cacheable = true;
+        if (!CompileBytecode(hlslSource, "PixelShader", "ps_5_0", includes, bytecode, outError, cacheable)) return false;
+        if (FAILED(m_device->CreatePixelShader(bytecode.data(), bytecode.size(), nullptr, &outShader))) {
+            outError = "Failed to create pixel shader object";
+            return false;
+        }
+        if (cacheable) m_shaderCache.Store(cacheKey, bytecode);
+    }
+
+    if (outTimeVarying) *outTimeVarying = IsTimeVaryingBytecode(bytecode.data(), bytecode.size());
+    if (outBindings) *outBindings = ReflectBindings(bytecode.data(), bytecode.size());
+    if (outCost) *outCost = ReflectCost(bytecode.data(), bytecode.size());
+    outError.clear();
+    return true;
+}
+
+bool D3D11Renderer::CompileComputeShader(const std::string& hlslSource, ComPtr<ID3D11ComputeShader>& outShader,
+                                         std::string& outError, bool* outTimeVarying, ShaderBindings* outBindings,
+                                         ShaderCost* outCost, const ShaderIncludes* includes) {
+    const uint64_t cacheKey = m_shaderCache.MakeKey(hlslSource, "cs_5_0", SHADER_COMPILE_FLAGS,
+                                                    includes ? includes->Hash() : 0);
+    std::vector<char> bytecode;
+    const bool cached = m_shaderCache.Load(cacheKey, bytecode) &&
+                        SUCCEEDED(m_device->CreateComputeShader(bytecode.data(), bytecode.size(), nullptr, &outShader));
+    if (!cached) {
+        bool cacheable = true;
+        if (!CompileBytecode(hlslSource, "ComputeShader", "cs_5_0", includes, bytecode, outError, cacheable)) return false;
+        if (FAILED(m_device->CreateComputeShader(bytecode.data(), bytecode.size(), nullptr, &outShader))) {
+            outError = "Failed to create compute shader object";
+            return false;
+        }
+        if (cacheable) m_shaderCache.Store(cacheKey, bytecode);
+    }
+
+    if (outTimeVarying) *outTimeVarying = IsTimeVaryingBytecode(bytecode.data(), bytecode.size());
+    if (outBindings) *outBindings = ReflectBindings(bytecode.data(), bytecode.size());
+    if (outCost) *outCost = ReflectCost(bytecode.data(), bytecode.size());
+    outError.clear();
+    return true;
+}
+
+bool D3D11Renderer::CompilePointDraw(const std::string& hlslSource, PointDraw& out, std::string& outError,
+                                     ShaderBindings* outBindings, ShaderCost* outCost, const ShaderIncludes* includes) {
+    out = PointDraw{};
+    ShaderBindings bindings{0, 0};
+    ShaderCost cost;
+    // The entry point is part of the cache key's target: the source is the kernels' too
+    for (const char* stage : { "vs_5_0", "ps_5_0" }) {
+        const bool vertex = stage[0] == 'v';
+        const char* entryPoint = vertex ? "pointVS" : "pointPS";
+        const uint64_t cacheKey = m_shaderCache.MakeKey(hlslSource, vertex ? "vs_5_0:pointVS" : "ps_5_0:pointPS",
+                                                        SHADER_COMPILE_FLAGS, includes ? includes->Hash() : 0);
+        auto create = [&](const std::vector<char>& bytecode) {
+            return vertex ? m_device->CreateVertexShader(bytecode.data(), bytecode.size(), nullptr, &out.vertexShader)
+                          : m_device->CreatePixelShader(bytecode.data(), bytecode.size(), nullptr, &out.pixelShader);
+        };
+        std::vector<char> bytecode;
+        if (!m_shaderCache.Load(cacheKey, bytecode) || FAILED(create(bytecode))) {
+            bool cacheable = true;
+            if (!CompileBytecode(hlslSource, vertex ? "PointVertexShader" : "PointPixelShader", stage, includes,
+                                 bytecode, outError, cacheable, entryPoint)) {
+                out = PointDraw{};
+                return false;
+            }
+            if (FAILED(create(bytecode))) {
+                outError = vertex ? "Failed to create point vertex shader object" : "Failed to create point pixel shader object";
+                out = PointDraw{};
+                return false;
+            }
+            if (cacheable) m_shaderCache.Store(cacheKey, bytecode);
+        }
+        bindings |= ReflectBindings(bytecode.data(), bytecode.size());
+        cost += ReflectCost(bytecode.data(), bytecode.size());
+    }
+
+    if (outBindings) *outBindings = bindings;
+    if (outCost) *outCost = cost;
     outError.clear();
     return true;
 }
 
-void D3D11Renderer::SetActivePixelShader(ID3D11PixelShader* shader) {
-    m_activePS = shader ? shader : m_passthroughPS.Get();
+void D3D11Renderer::SetActivePixelShader(ID3D11PixelShader* shader, bool timeVarying) {
+    ID3D11PixelShader* active = shader ? shader : m_passthroughPS.Get();
+    if (active != m_activePS.Get() || !m_graphPasses.empty() || !m_computeKernels.empty()) m_displayDirty = true;
+    m_activePS = active;
+    m_activeTimeVarying = shader ? timeVarying : false;  // Passthrough only samples t0
+    m_renderAhead.Invalidate();
+    m_fusedBlendMode = 0;  // Set again by SetFusedBlendMode for a fused variant
+    m_activeBindings = shader ? ShaderBindings{} : m_passthroughBindings;  // Narrowed by SetActiveBindings
+
+    m_graphPasses.clear();
+    m_graphTargets.clear();
+    m_persistentTargets.clear();
+    m_targetPool.Clear();
+    m_graphPlanned = false;
+    ClearCompute();
+}
+
+void D3D11Renderer::SetActiveRenderGraph(std::vector<RenderGraphPass> passes, bool timeVarying) {
+    if (passes.empty() || static_cast<int>(passes.size()) > MAX_RENDER_PASSES) {
+        SetActivePixelShader(nullptr);
+        return;
+    }
+    ClearCompute();
+    m_fusedBlendMode = 0;
+    m_activeBindings = ShaderBindings{};
+    // The last pass stands in for the whole graph wherever one shader is expected
+    m_activePS = passes.back().shader;
+    m_activeTimeVarying = timeVarying;
+    m_graphPasses  = std::move(passes);
+    m_persistentTargets.clear();  // A new graph starts its simulations over
+    m_graphPlanned = false;
+    m_displayDirty = true;
+    m_renderAhead.Invalidate();
+}
+
+bool D3D11Renderer::SwapRenderGraphShaders(const std::vector<RenderGraphPass>& passes, bool timeVarying) {
+    if (passes.empty() || passes.size() != m_graphPasses.size()) return false;
+    for (size_t i = 0; i < passes.size(); ++i) {
+        m_graphPasses[i].shader = passes[i].shader;
+        m_graphPasses[i].reads  = passes[i].reads;
+    }
+    m_activePS = passes.back().shader;
+    m_activeTimeVarying = timeVarying;
+    m_graphPlanned = false;  // Reads may differ; the replan keeps same-size persistent targets
+    m_displayDirty = true;
+    m_renderAhead.Invalidate();
+    return true;
+}
+
+void D3D11Renderer::SetTapPass(int pass) {
+    if (pass == m_tapPass) return;
+    m_tapPass  = pass;
+    m_tapDrawn = false;
+    if (pass < 0) m_tapTarget = RenderTargetPool::Target{};
+    m_displayDirty = true;  // An idle time-invariant graph draws once to fill it
+}
+
+void D3D11Renderer::ResetPersistentTargets() {
+    const float zero[4] = {};
+    for (PersistentTarget& persistent : m_persistentTargets) {
+        for (const RenderTargetPool::Target& buffer : persistent.buffers) {
+            if (buffer.rtv) m_context->ClearRenderTargetView(buffer.rtv.Get(), zero);
+        }
+    }
+    m_displayDirty = true;
+}
+
+void D3D11Renderer::SetActiveCompute(std::vector<ComputeKernel> kernels, PointDraw points, const ComputeDesc& desc,
+                                     bool timeVarying) {
+    SetActivePixelShader(nullptr);  // The passthrough draws the output; drops any graph
+    if (kernels.empty()) return;
+    m_computeKernels = std::move(kernels);
+    m_computePoints  = std::move(points);
+    m_computeDesc    = desc;
+    m_activeTimeVarying = timeVarying;
+    m_activeBindings = ShaderBindings{};
+    if (!CreateComputeBuffers(desc, m_compute)) {
+        ClearCompute();  // Falls back to the passthrough
+        return;
+    }
+    m_displayDirty = true;
+}
+
+bool D3D11Renderer::CreateComputeBuffers(const ComputeDesc& desc, ComputeState& state) {
+    state.buffers.clear();
+    for (const ComputeBufferDesc& bufferDesc : desc.buffers) {
+        D3D11_BUFFER_DESC bd = {};
+        bd.ByteWidth           = static_cast<UINT>(bufferDesc.stride) * static_cast<UINT>(bufferDesc.count);
+        bd.Usage               = D3D11_USAGE_DEFAULT;
+        bd.BindFlags           = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+        bd.MiscFlags           = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+        bd.StructureByteStride = static_cast<UINT>(bufferDesc.stride);
+
+        D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format             = DXGI_FORMAT_UNKNOWN;
+        uavDesc.ViewDimension      = D3D11_UAV_DIMENSION_BUFFER;
+        uavDesc.Buffer.NumElements = static_cast<UINT>(bufferDesc.count);
+
+        ComputeState::Buffer buffer;
+        if (FAILED(m_device->CreateBuffer(&bd, nullptr, &buffer.buffer)) ||
+            FAILED(m_device->CreateUnorderedAccessView(buffer.buffer.Get(), &uavDesc, &buffer.uav))) {
+            state.buffers.clear();
+            return false;
+        }
+        const UINT zero[4] = {};
+        m_context->ClearUnorderedAccessViewUint(buffer.uav.Get(), zero);
+        state.buffers.push_back(std::move(buffer));
+    }
+
+    // The point draw reads its buffer as an SRV and takes its counts from drawArgs
+    state.drawArgs.Reset();
+    state.drawArgsUAV.Reset();
+    if (desc.draw.buffer >= 0 && desc.draw.buffer < static_cast<int>(state.buffers.size())) {
+        ComputeState::Buffer& drawn = state.buffers[desc.draw.buffer];
+        D3D11_BUFFER_DESC argsDesc = {};
+        argsDesc.ByteWidth = 4 * sizeof(UINT);
+        argsDesc.Usage     = D3D11_USAGE_DEFAULT;
+        argsDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+        argsDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+        D3D11_UNORDERED_ACCESS_VIEW_DESC argsUAVDesc = {};
+        argsUAVDesc.Format             = DXGI_FORMAT_R32_TYPELESS;
+        argsUAVDesc.ViewDimension      = D3D11_UAV_DIMENSION_BUFFER;
+        argsUAVDesc.Buffer.NumElements = 4;
+        argsUAVDesc.Buffer.Flags       = D3D11_BUFFER_UAV_FLAG_RAW;
+        if (FAILED(m_device->CreateShaderResourceView(drawn.buffer.Get(), nullptr, &drawn.srv)) ||
+            FAILED(m_device->CreateBuffer(&argsDesc, nullptr, &state.drawArgs)) ||
+            FAILED(m_device->CreateUnorderedAccessView(state.drawArgs.Get(), &argsUAVDesc, &state.drawArgsUAV))) {
+            state.buffers.clear();
+            state.drawArgs.Reset();
+            state.drawArgsUAV.Reset();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool D3D11Renderer::SwapComputeKernels(const std::vector<ComputeKernel>& kernels, const PointDraw& points,
+                                       bool timeVarying) {
+    if (kernels.empty() || kernels.size() != m_computeKernels.size()) return false;
+    m_computeKernels    = kernels;
+    m_computePoints     = points;
+    m_activeTimeVarying = timeVarying;
+    m_displayDirty = true;
+    return true;
+}
+
+void D3D11Renderer::ClearCompute() {
+    m_computeKernels.clear();
+    m_computePoints = PointDraw{};
+    m_computeDesc = ComputeDesc{};
+    m_compute     = ComputeState{};
+}
+
+D3D11Renderer::PrewarmTarget* D3D11Renderer::GetPrewarmTarget(PassFormat format) {
+    PrewarmTarget& target = m_prewarmTargets[static_cast<int>(format)];
+    if (target.texture) return &target;
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = 1;
+    desc.Height           = 1;
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = PassDxgiFormat(format);
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_RENDER_TARGET | D3D11_BIND_UNORDERED_ACCESS;
+    if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &target.texture)) ||
+        FAILED(m_device->CreateRenderTargetView(target.texture.Get(), nullptr, &target.rtv)) ||
+        FAILED(m_device->CreateUnorderedAccessView(target.texture.Get(), nullptr, &target.uav))) {
+        target = {};
+        return nullptr;
+    }
+    return &target;
+}
+
+void D3D11Renderer::PrewarmPixelShader(ID3D11PixelShader* shader, PassFormat format) {
+    PrewarmTarget* target = shader ? GetPrewarmTarget(format) : nullptr;
+    if (!target) return;
+
+    // Whatever is bound is read for the one pixel; only the output is ours
+    m_context->OMSetRenderTargets(1, target->rtv.GetAddressOf(), nullptr);
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = 1.0f;
+    vp.Height   = 1.0f;
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
+    m_pipelineState.SetPixelShader(shader);
+    m_context->Draw(3, 0);
+
+    m_context->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
+    D3D11_VIEWPORT mainVP = {};
+    mainVP.Width    = static_cast<float>(m_width);
+    mainVP.Height   = static_cast<float>(m_height);
+    mainVP.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &mainVP);
+    m_pipelineState.SetPixelShader(m_activePS.Get());
+}
+
+void D3D11Renderer::PrewarmComputeShader(ID3D11ComputeShader* shader, PassFormat format) {
+    PrewarmTarget* target = shader ? GetPrewarmTarget(format) : nullptr;
+    if (!target) return;
+
+    // u1.. stay unbound: the kernel's buffer writes are dropped, its reads are zero
+    m_context->CSSetUnorderedAccessViews(0, 1, target->uav.GetAddressOf(), nullptr);
+    m_context->CSSetShader(shader, nullptr, 0);
+    m_context->Dispatch(1, 1, 1);
+    ID3D11UnorderedAccessView* nullUAV = nullptr;
+    m_context->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+    m_context->CSSetShader(nullptr, nullptr, 0);
+}
+
+bool D3D11Renderer::RunCompute(ID3D11RenderTargetView* rtv, int width, int height) {
+    if (m_computeKernels.empty() ||
+        !DispatchKernels(m_computeKernels, m_computePoints, m_computeDesc, m_compute, m_activeBindings,
+                         GetActiveVideoSRV(), width, height))
+        return false;
+
+    // The frame goes to the caller's target like a pixel shader's would
+    m_context->OMSetRenderTargets(1, &rtv, nullptr);
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = static_cast<float>(width);
+    vp.Height   = static_cast<float>(height);
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
+    m_pipelineState.SetPixelShader(m_passthroughPS.Get());
+    m_context->PSSetShaderResources(0, 1, m_compute.outputSRV.GetAddressOf());
+    m_context->Draw(3, 0);
+    ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV();
+    m_context->PSSetShaderResources(0, 1, &videoSRV);
+    return true;
+}
+
+bool D3D11Renderer::DispatchKernels(const std::vector<ComputeKernel>& kernels, const PointDraw& points,
+                                    const ComputeDesc& desc, ComputeState& state, const ShaderBindings& used,
+                                    ID3D11ShaderResourceView* video, int width, int height) {
+    // Output texture at the render size; a render target too when points are drawn into it
+    const DXGI_FORMAT format = PassDxgiFormat(desc.format);
+    const bool drawPoints = points.vertexShader && points.pixelShader && state.drawArgs;
+    D3D11_TEXTURE2D_DESC outDesc = {};
+    if (state.output) state.output->GetDesc(&outDesc);
+    if (!state.output || outDesc.Width != static_cast<UINT>(width) || outDesc.Height != static_cast<UINT>(height) ||
+        outDesc.Format != format || drawPoints != (state.outputRTV != nullptr)) {
+        state.output.Reset();
+        state.outputUAV.Reset();
+        state.outputSRV.Reset();
+        state.outputRTV.Reset();
+        outDesc = {};
+        outDesc.Width            = static_cast<UINT>(width);
+        outDesc.Height           = static_cast<UINT>(height);
+        outDesc.MipLevels        = 1;
+        outDesc.ArraySize        = 1;
+        outDesc.Format           = format;
+        outDesc.SampleDesc.Count = 1;
+        outDesc.Usage            = D3D11_USAGE_DEFAULT;
+        outDesc.BindFlags        = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE |
+                                   (drawPoints ? D3D11_BIND_RENDER_TARGET : 0);
+        if (FAILED(m_device->CreateTexture2D(&outDesc, nullptr, &state.output)) ||
+            FAILED(m_device->CreateUnorderedAccessView(state.output.Get(), nullptr, &state.outputUAV)) ||
+            FAILED(m_device->CreateShaderResourceView(state.output.Get(), nullptr, &state.outputSRV)) ||
+            (drawPoints && FAILED(m_device->CreateRenderTargetView(state.output.Get(), nullptr, &state.outputRTV)))) {
+            state.output.Reset();
+            state.outputUAV.Reset();
+            state.outputSRV.Reset();
+            state.outputRTV.Reset();
+            return false;
+        }
+    }
+
+    // Every element of the draw buffer unless a kernel stores a smaller count
+    if (drawPoints) {
+        const UINT args[4] = { desc.draw.size > 1.0f ? 6u : 1u,
+                               static_cast<UINT>(desc.buffers[desc.draw.buffer].count), 0, 0 };
+        m_context->UpdateSubresource(state.drawArgs.Get(), 0, nullptr, args, 0, 0);
+    }
+
+    // Everything the pixel shaders see that the kernels read, on the compute stage
+    ID3D11ShaderResourceView* srvs[FIRST_LUT_SLOT + MAX_LUTS] = {};
+    srvs[0] = video;
+    if (used.ReadsTexture(1)) srvs[1] = m_noiseSRV.Get();
+    if (used.ReadsTexture(3)) srvs[3] = m_spectrumSRV.Get();
+    for (int i = 0; i < MAX_VIDEO_INPUTS; ++i) {
+        if (used.ReadsTexture(FIRST_INPUT_SLOT + i)) srvs[FIRST_INPUT_SLOT + i] = m_inputTextures[i].srv.Get();
+    }
+    if (used.ReadsTexture(FRAME_HISTORY_SLOT)) srvs[FRAME_HISTORY_SLOT] = m_historySRV.Get();
+    if (used.ReadsTexture(SPECTROGRAM_SLOT)) srvs[SPECTROGRAM_SLOT] = m_spectrogramSRV.Get();
+    if (used.ReadsTexture(WAVEFORM_SLOT)) srvs[WAVEFORM_SLOT] = m_waveformSRV.Get();
+    if (used.ReadsTexture(NOISE_VOLUME_SLOT)) srvs[NOISE_VOLUME_SLOT] = m_noiseVolumeSRV.Get();
+    for (int i = 0; i < MAX_LUTS; ++i) {
+        if (used.ReadsTexture(FIRST_LUT_SLOT + i)) srvs[FIRST_LUT_SLOT + i] = m_lutSRVs[i].Get();
+    }
+    m_context->CSSetShaderResources(0, FIRST_LUT_SLOT + MAX_LUTS, srvs);
+    ID3D11SamplerState* samplers[2] = { m_sampler.Get(), m_wrapSampler.Get() };
+    m_context->CSSetSamplers(0, 2, samplers);
+    ID3D11Buffer* cbuffers[FRAME_HISTORY_CBUFFER + 1] = {
+        m_constantBuffer.Get(),
+        used.ReadsCBuffer(1) ? m_audioConstantBuffer.Get() : nullptr,
+        used.ReadsCBuffer(FRAME_HISTORY_CBUFFER) ? m_historyConstantBuffer.Get() : nullptr };
+    m_context->CSSetConstantBuffers(0, FRAME_HISTORY_CBUFFER + 1, cbuffers);
+    if (used.ReadsCBuffer(PARAM_CBUFFER)) m_context->CSSetConstantBuffers(PARAM_CBUFFER, 1, m_paramBuffer.GetAddressOf());
+
+    // The output's SRV must not be bound anywhere while it is a UAV
+    m_context->OMSetRenderTargets(0, nullptr, nullptr);
+    ID3D11UnorderedAccessView* uavs[DRAW_ARGS_UAV + 1] = { state.outputUAV.Get() };
+    for (size_t i = 0; i < state.buffers.size(); ++i) uavs[1 + i] = state.buffers[i].uav.Get();
+    if (drawPoints) uavs[DRAW_ARGS_UAV] = state.drawArgsUAV.Get();
+    const UINT uavCount = drawPoints ? DRAW_ARGS_UAV + 1 : 1 + static_cast<UINT>(state.buffers.size());
+    m_context->CSSetUnorderedAccessViews(0, uavCount, uavs, nullptr);
+    if (desc.clearOutput) {
+        const float zero[4] = {};
+        m_context->ClearUnorderedAccessViewFloat(state.outputUAV.Get(), zero);
+    }
+
+    const int threads[2] = { desc.threadsX, desc.threadsY };
+    const int size[2]    = { width, height };
+    for (const ComputeKernel& kernel : kernels) {
+        UINT groups[2];
+        for (int a = 0; a < 2; ++a) {
+            const ComputeDispatch& d = kernel.dispatch;
+            const int count = d.sizeAxis[a] >= 0 ? static_cast<int>(std::ceil(size[d.sizeAxis[a]] * d.sizeScale[a]))
+                            : d.groups[a] > 0    ? d.groups[a]
+                                                 : (size[a] + threads[a] - 1) / threads[a];
+            groups[a] = static_cast<UINT>(std::clamp(count, 1, D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION));
+        }
+        m_context->CSSetShader(kernel.shader.Get(), nullptr, 0);
+        m_context->Dispatch(groups[0], groups[1], 1);
+    }
+
+    ID3D11UnorderedAccessView* nullUAVs[DRAW_ARGS_UAV + 1] = {};
+    m_context->CSSetUnorderedAccessViews(0, uavCount, nullUAVs, nullptr);
+    ID3D11ShaderResourceView* nullSRVs[FIRST_LUT_SLOT + MAX_LUTS] = {};
+    m_context->CSSetShaderResources(0, FIRST_LUT_SLOT + MAX_LUTS, nullSRVs);
+    m_context->CSSetShader(nullptr, nullptr, 0);
+    if (drawPoints) DrawComputePoints(points, desc, state, used, width, height);
+    return true;
+}
+
+void D3D11Renderer::DrawComputePoints(const PointDraw& points, const ComputeDesc& desc, ComputeState& state,
+                                      const ShaderBindings& used, int width, int height) {
+    m_context->OMSetRenderTargets(1, state.outputRTV.GetAddressOf(), nullptr);
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = static_cast<float>(width);
+    vp.Height   = static_cast<float>(height);
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
+
+    // No vertex buffer: pointVS builds each vertex from its instance and vertex IDs
+    m_context->IASetInputLayout(nullptr);
+    m_context->IASetPrimitiveTopology(desc.draw.size > 1.0f ? D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST
+                                                             : D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+    m_context->VSSetShader(points.vertexShader.Get(), nullptr, 0);
+    ID3D11Buffer* cbuffers[2] = { m_constantBuffer.Get(), used.ReadsCBuffer(1) ? m_audioConstantBuffer.Get() : nullptr };
+    m_context->VSSetConstantBuffers(0, 2, cbuffers);
+    if (used.ReadsCBuffer(PARAM_CBUFFER)) m_context->VSSetConstantBuffers(PARAM_CBUFFER, 1, m_paramBuffer.GetAddressOf());
+    ID3D11ShaderResourceView* bufferSRVs[MAX_COMPUTE_BUFFERS] = {};
+    for (size_t i = 0; i < state.buffers.size(); ++i) bufferSRVs[i] = state.buffers[i].srv.Get();
+    m_context->VSSetShaderResources(FIRST_DRAW_BUFFER_SLOT, MAX_COMPUTE_BUFFERS, bufferSRVs);
+    // pointPS sees what a preset's pixel shader would (BeginFrame's bindings)
+    m_context->PSSetShader(points.pixelShader.Get(), nullptr, 0);
+    const float blendFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    m_context->OMSetBlendState(desc.draw.additive ? m_additiveBlendState.Get() : m_alphaBlendState.Get(),
+                               blendFactor, 0xFFFFFFFF);
+
+    m_context->DrawInstancedIndirect(state.drawArgs.Get(), 0);
+
+    ID3D11ShaderResourceView* nullSRVs[MAX_COMPUTE_BUFFERS] = {};
+    m_context->VSSetShaderResources(FIRST_DRAW_BUFFER_SLOT, MAX_COMPUTE_BUFFERS, nullSRVs);
+    m_context->OMSetRenderTargets(0, nullptr, nullptr);  // The output is sampled next
+    // IA, VS, PS and blend were bound behind the cache's back: back to the
+    // fullscreen draw state (cbuffers and samplers are untouched, only forgotten)
+    m_pipelineState.Invalidate();
+    m_pipelineState.SetInputAssembler(m_inputLayout.Get(), m_vertexBuffer.Get(), sizeof(float) * 4);
+    m_pipelineState.SetVertexShader(m_vertexShader.Get());
+    m_pipelineState.SetPixelShader(m_activePS.Get());
+    m_pipelineState.SetBlendState(m_blendState.Get());
+}
+
+bool D3D11Renderer::PlanRenderGraph(int width, int height) {
+    if (m_graphPlanned && m_graphWidth == width && m_graphHeight == height) return true;
+
+    // A target lives from its pass to the last pass that samples it
+    const int passCount = static_cast<int>(m_graphPasses.size());
+    int lastUse[MAX_RENDER_PASSES];
+    for (int i = 0; i < passCount; ++i) {
+        lastUse[i] = i;
+        if (m_graphPasses[i].desc.persistent) continue;  // Not pooled
+        for (int p = i + 1; p < passCount; ++p) {
+            if (m_graphPasses[p].reads & (1u << i)) lastUse[i] = p;
+        }
+    }
+
+    // Acquire before releasing, so a pass never draws into a target it samples
+    m_targetPool.BeginPlan();
+    m_graphTargets.assign(passCount, {});
+    m_persistentTargets.resize(passCount);
+    const RenderTargetPool::Target* acquired[MAX_RENDER_PASSES] = {};
+    bool ok = true;
+    for (int p = 0; p < passCount && ok; ++p) {
+        const RenderPassDesc& desc = m_graphPasses[p].desc;
+        const int w = desc.width  > 0 ? desc.width  : std::max(1, static_cast<int>(std::lround(width  * desc.widthScale)));
+        const int h = desc.height > 0 ? desc.height : std::max(1, static_cast<int>(std::lround(height * desc.heightScale)));
+        const DXGI_FORMAT format = PassDxgiFormat(desc.format);
+
+        // Persistent passes own their two buffers; they survive replans at the
+        // same size and start from zero otherwise
+        PersistentTarget& persistent = m_persistentTargets[p];
+        if (desc.persistent) {
+            const RenderTargetPool::Target& current = persistent.buffers[0];
+            if (!current.rtv || current.width != w || current.height != h || current.format != format) {
+                const float zero[4] = {};
+                persistent = PersistentTarget{};
+                for (RenderTargetPool::Target& buffer : persistent.buffers) {
+                    ok = ok && RenderTargetPool::Create(m_device.Get(), w, h, format, buffer);
+                    if (ok) m_context->ClearRenderTargetView(buffer.rtv.Get(), zero);
+                }
+            }
+            continue;
+        }
+        persistent = PersistentTarget{};
+        if (p == passCount - 1) break;  // Draws to the caller's RTV
+
+        acquired[p] = m_targetPool.Acquire(m_device.Get(), w, h, format);
+        if (!acquired[p]) {
+            ok = false;
+            break;
+        }
+        m_graphTargets[p] = *acquired[p];
+        for (int i = 0; i <= p; ++i) {
+            if (acquired[i] && lastUse[i] == p) {
+                m_targetPool.Release(acquired[i]);
+                acquired[i] = nullptr;
+            }
+        }
+    }
+    m_targetPool.EndPlan();
+
+    m_graphPlanned = ok;
+    m_graphWidth   = width;
+    m_graphHeight  = height;
+    if (!ok) {
+        m_graphTargets.clear();
+        m_persistentTargets.clear();
+    }
+    return ok;
+}
+
+void D3D11Renderer::DrawActiveShader(ID3D11RenderTargetView* rtv, int width, int height) {
+    // Only the draw into `rtv` is jittered: a pass sampling a jittered
+    // intermediate through a jittered viewport would be shifted twice
+    auto setViewport = [&](int w, int h, bool jittered = false) {
+        D3D11_VIEWPORT vp = {};
+        vp.TopLeftX = jittered ? m_jitter[0] : 0.0f;
+        vp.TopLeftY = jittered ? m_jitter[1] : 0.0f;
+        vp.Width    = static_cast<float>(w);
+        vp.Height   = static_cast<float>(h);
+        vp.MaxDepth = 1.0f;
+        m_context->RSSetViewports(1, &vp);
+    };
+
+    m_tapDrawn = false;  // Until the tapped pass draws below
+    if (RunCompute(rtv, width, height)) return;
+
+    // One shader, or a graph whose targets could not be created: the last pass alone
+    if (m_graphPasses.empty() || !PlanRenderGraph(width, height)) {
+        m_context->OMSetRenderTargets(1, &rtv, nullptr);
+        setViewport(width, height, true);
+        m_pipelineState.SetPixelShader(m_activePS.Get());
+        DrawTiled(width, height);
+        return;
+    }
+
+    const int passCount = static_cast<int>(m_graphPasses.size());
+    bool videoSlotReplaced = false;
+    for (int p = 0; p < passCount; ++p) {
+        const RenderGraphPass& pass = m_graphPasses[p];
+        PersistentTarget& persistent = m_persistentTargets[p];
+        const bool last = (p == passCount - 1);
+        const int steps = pass.desc.persistent ? pass.desc.steps : 1;
+        m_pipelineState.SetPixelShader(pass.shader.Get());
+
+        for (int step = 0; step < steps; ++step) {
+            // Unbind the previous draw's target first: a view still bound as output
+            // would be dropped from the inputs below. Pooled targets are read from
+            // earlier passes only; persistent ones from any pass, newest buffer
+            // first, so a pass sees its own output of the previous step or frame.
+            m_context->OMSetRenderTargets(0, nullptr, nullptr);
+            ID3D11ShaderResourceView* srvs[MAX_RENDER_PASSES] = {};
+            for (int i = 0; i < passCount; ++i) {
+                if (!(pass.reads & (1u << i))) continue;
+                if (m_graphPasses[i].desc.persistent) {
+                    srvs[i] = m_persistentTargets[i].buffers[m_persistentTargets[i].latest].srv.Get();
+                } else if (i < p) {
+                    srvs[i] = m_graphTargets[i].srv.Get();
+                }
+            }
+            m_context->PSSetShaderResources(FIRST_PASS_SLOT, MAX_RENDER_PASSES, srvs);
+
+            const RenderTargetPool::Target* own = pass.desc.persistent ? &persistent.buffers[1 - persistent.latest]
+                                                : last                 ? nullptr
+                                                                       : &m_graphTargets[p];
+            ID3D11RenderTargetView* target = own ? own->rtv.Get() : rtv;
+            m_context->OMSetRenderTargets(1, &target, nullptr);
+            setViewport(own ? own->width : width, own ? own->height : height, !own);
+            DrawTiled(own ? own->width : width, own ? own->height : height);
+            if (pass.desc.persistent) persistent.latest = 1 - persistent.latest;
+        }
+
+        // SetTapPass: copy this pass out before its pooled target is reused
+        if (p == m_tapPass && !last) {
+            const RenderTargetPool::Target& own = pass.desc.persistent ? persistent.buffers[persistent.latest]
+                                                                       : m_graphTargets[p];
+            if ((m_tapTarget.width == own.width && m_tapTarget.height == own.height) ||
+                RenderTargetPool::Create(m_device.Get(), own.width, own.height, DXGI_FORMAT_R8G8B8A8_UNORM, m_tapTarget)) {
+                m_context->OMSetRenderTargets(1, m_tapTarget.rtv.GetAddressOf(), nullptr);
+                setViewport(own.width, own.height);
+                m_pipelineState.SetPixelShader(m_passthroughPS.Get());
+                m_context->PSSetShaderResources(0, 1, own.srv.GetAddressOf());
+                m_context->Draw(3, 0);
+                // Later passes may sample the video, and may draw into this pooled target
+                ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV();
+                m_context->PSSetShaderResources(0, 1, &videoSRV);
+                m_tapDrawn = true;
+            }
+        }
+
+        // A persistent last pass drew into its own buffer: copy it out
+        if (last && pass.desc.persistent) {
+            m_context->OMSetRenderTargets(1, &rtv, nullptr);
+            setViewport(width, height);
+            m_pipelineState.SetPixelShader(m_passthroughPS.Get());
+            m_context->PSSetShaderResources(0, 1, persistent.buffers[persistent.latest].srv.GetAddressOf());
+            m_context->Draw(3, 0);
+            videoSlotReplaced = true;
+        }
+    }
+
+    // Next frame's passes draw into these again
+    ID3D11ShaderResourceView* nullSRVs[MAX_RENDER_PASSES] = {};
+    m_context->PSSetShaderResources(FIRST_PASS_SLOT, MAX_RENDER_PASSES, nullSRVs);
+    if (videoSlotReplaced) {
+        ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV();
+        m_context->PSSetShaderResources(0, 1, &videoSRV);
+    }
+    m_pipelineState.SetPixelShader(m_activePS.Get());
 }
 
 void D3D11Renderer::BeginFrame() {
@@ -843,16 +3979,16 @@ void D3D11Renderer::BeginFrame() {
         m_constants.videoResolution[1] = static_cast<float>(m_generativeHeight);
     }
 
-    // Pass blend params through the padding fields so the compositor shader can read them.
-    // These don't affect regular pixel shaders (padding fields are unused by convention).
+    // Pass blend params through the padding fields: the compositor reads the amount,
+    // and a mode change alone must also defeat idle elision. These don't affect
+    // regular pixel shaders (padding fields are unused by convention).
     m_constants.padding1    = m_videoBlendFactor;
     m_constants.padding2[0] = static_cast<float>(m_videoBlendMode);
 
-    D3D11_MAPPED_SUBRESOURCE mapped;
-    if (SUCCEEDED(m_context->Map(m_constantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
-        memcpy(mapped.pData, &m_constants, sizeof(m_constants));
-        m_context->Unmap(m_constantBuffer.Get(), 0);
-    }
+    // Twice a frame while recording, and every frame while paused, nothing has
+    // changed since the last upload: the buffer still holds it
+    UploadConstants(m_constants);
+    UploadParams(m_extendedParams, MAX_EXTENDED_PARAM_FLOATS);
 
     // Clear render target
     float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
@@ -868,139 +4004,546 @@ void D3D11Renderer::BeginFrame() {
     viewport.MaxDepth = 1.0f;
     m_context->RSSetViewports(1, &viewport);
 
-    // Set pipeline state
-    m_context->IASetInputLayout(m_inputLayout.Get());
-    m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    
-    UINT stride = sizeof(float) * 4;
-    UINT offset = 0;
-    m_context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
-
-    m_context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
-    m_context->PSSetShader(m_activePS.Get(), nullptr, 0);
-    m_context->PSSetConstantBuffers(0, 1, m_constantBuffer.GetAddressOf());
-    m_context->PSSetShaderResources(0, 1, m_videoSRV.GetAddressOf());
-    m_context->PSSetSamplers(0, 1, m_sampler.GetAddressOf());
-
-    // Bind noise texture + wrap sampler globally (shaders that use them declare t1/s1)
-    if (m_noiseSRV)
-        m_context->PSSetShaderResources(1, 1, m_noiseSRV.GetAddressOf());
+    // Set pipeline state; the cache drops whatever is already bound
+    m_pipelineState.SetInputAssembler(m_inputLayout.Get(), m_vertexBuffer.Get(), sizeof(float) * 4);
+    m_pipelineState.SetVertexShader(m_vertexShader.Get());
+    m_pipelineState.SetPixelShader(m_activePS.Get());
+    m_pipelineState.SetPSConstantBuffer(0, m_constantBuffer.Get());
+    m_pipelineState.SetPSSampler(0, m_sampler.Get());
+
+    // Wrap sampler (s1) globally; the audio (b1), frame history (b2) and fused
+    // blend (b3) cbuffers only for a shader that reads them
     if (m_wrapSampler)
-        m_context->PSSetSamplers(1, 1, m_wrapSampler.GetAddressOf());
+        m_pipelineState.SetPSSampler(1, m_wrapSampler.Get());
+    UploadAudioData();
+    ShaderBindings used = m_activeBindings;
+    used |= m_layerBindings;  // Preset layers and post stages draw with the same binds
+    used |= m_postBindings;
+    if (m_audioConstantBuffer && used.ReadsCBuffer(1))
+        m_pipelineState.SetPSConstantBuffer(1, m_audioConstantBuffer.Get());
+    if (m_historyConstantBuffer && used.ReadsCBuffer(FRAME_HISTORY_CBUFFER))
+        m_pipelineState.SetPSConstantBuffer(FRAME_HISTORY_CBUFFER, m_historyConstantBuffer.Get());
+    if (m_blendConstantBuffer && used.ReadsCBuffer(FUSED_BLEND_CBUFFER))
+        m_pipelineState.SetPSConstantBuffer(FUSED_BLEND_CBUFFER, m_blendConstantBuffer.Get());
+    if (m_paramBuffer && used.ReadsCBuffer(PARAM_CBUFFER))
+        m_pipelineState.SetPSConstantBuffer(PARAM_CBUFFER, m_paramBuffer.Get());
+
+    // Shader resources are rebound every time (outputs unbind them behind the
+    // cache's back), but as one range: video (t0), noise (t1), the compositor
+    // source slot (t2, null outside the compositor), spectrum (t3) and the
+    // extra video inputs (t4..t7, unbound slots sample as black). Slots the
+    // shader doesn't read stay null.
+    ID3D11ShaderResourceView* srvs[FIRST_INPUT_SLOT + MAX_VIDEO_INPUTS] = {};
+    srvs[0] = GetActiveVideoSRV();
+    if (used.ReadsTexture(1)) srvs[1] = m_noiseSRV.Get();
+    if (used.ReadsTexture(3)) srvs[3] = m_spectrumSRV.Get();
+    for (int i = 0; i < MAX_VIDEO_INPUTS; ++i) {
+        if (used.ReadsTexture(FIRST_INPUT_SLOT + i)) srvs[FIRST_INPUT_SLOT + i] = m_inputTextures[i].srv.Get();
+    }
+    m_context->PSSetShaderResources(0, FIRST_INPUT_SLOT + MAX_VIDEO_INPUTS, srvs);
+    // Frame history ring (t16), null when off, then the spectrogram (t17),
+    ID3D11ShaderResourceView* historySRV = used.ReadsTexture(FRAME_HISTORY_SLOT) ? m_historySRV.Get() : nullptr;
+    m_context->PSSetShaderResources(FRAME_HISTORY_SLOT, 1, &historySRV);
+    // waveform (t18), noise volume (t19) and LUTs (t20..t23) as one range
+    ID3D11ShaderResourceView* upperSRVs[FIRST_LUT_SLOT + MAX_LUTS - SPECTROGRAM_SLOT] = {
+        used.ReadsTexture(SPECTROGRAM_SLOT) ? m_spectrogramSRV.Get() : nullptr,
+        used.ReadsTexture(WAVEFORM_SLOT) ? m_waveformSRV.Get() : nullptr,
+        used.ReadsTexture(NOISE_VOLUME_SLOT) ? m_noiseVolumeSRV.Get() : nullptr };
+    for (int i = 0; i < MAX_LUTS; ++i) {
+        if (used.ReadsTexture(FIRST_LUT_SLOT + i)) upperSRVs[FIRST_LUT_SLOT - SPECTROGRAM_SLOT + i] = m_lutSRVs[i].Get();
+    }
+    m_context->PSSetShaderResources(SPECTROGRAM_SLOT, FIRST_LUT_SLOT + MAX_LUTS - SPECTROGRAM_SLOT, upperSRVs);
+
+    m_pipelineState.SetRasterizerState(m_rasterizerState.Get());
+    m_pipelineState.SetBlendState(m_blendState.Get());
+}
+
+void D3D11Renderer::UploadConstants(const ShaderConstants& constants) {
+    if (m_constantsUploaded && memcmp(&m_uploadedConstants, &constants, sizeof(constants)) == 0) return;
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (SUCCEEDED(m_context->Map(m_constantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        memcpy(mapped.pData, &constants, sizeof(constants));
+        m_context->Unmap(m_constantBuffer.Get(), 0);
+        m_uploadedConstants = constants;
+        m_constantsUploaded = true;
+    }
+}
 
-    // Bind audio cbuffer (b1) and spectrum texture (t3) globally.
-    // Always bound — shaders that don't use them simply ignore these slots.
-    if (m_audioConstantBuffer)
-        m_context->PSSetConstantBuffers(1, 1, m_audioConstantBuffer.GetAddressOf());
-    if (m_spectrumSRV)
-        m_context->PSSetShaderResources(3, 1, m_spectrumSRV.GetAddressOf());
+void D3D11Renderer::UploadParams(const float* values, size_t floatCount) {
+    if (!m_paramBuffer) return;
+    // Slots past floatCount read as zero, the same as a fresh buffer
+    float next[MAX_EXTENDED_PARAM_FLOATS] = {};
+    std::copy_n(values, std::min(floatCount, size_t(MAX_EXTENDED_PARAM_FLOATS)), next);
+
+    constexpr int VECTORS = MAX_EXTENDED_PARAM_FLOATS / 4;
+    int first = VECTORS, last = -1;
+    for (int v = 0; v < VECTORS; ++v) {
+        if (memcmp(&next[v * 4], &m_uploadedParams[v * 4], 4 * sizeof(float)) == 0) continue;
+        first = std::min(first, v);
+        last  = v;
+    }
+    if (last < 0) return;
 
-    m_context->RSSetState(m_rasterizerState.Get());
-    m_context->OMSetBlendState(m_blendState.Get(), nullptr, 0xFFFFFFFF);
+    if (m_partialConstantUpdates && m_context1) {
+        const D3D11_BOX box = { UINT(first * 16), 0, 0, UINT((last + 1) * 16), 1, 1 };
+        m_context1->UpdateSubresource1(m_paramBuffer.Get(), 0, &box, &next[first * 4], 0, 0, 0);
+        m_paramBytesUploaded += (last + 1 - first) * 16;
+    } else {
+        m_context->UpdateSubresource(m_paramBuffer.Get(), 0, nullptr, next, 0, 0);
+        m_paramBytesUploaded += sizeof(next);
+    }
+    std::copy_n(next, MAX_EXTENDED_PARAM_FLOATS, m_uploadedParams);
 }
 
 void D3D11Renderer::EndFrame() {
     // Draw fullscreen triangle
+    GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Display);
     m_context->Draw(3, 0);
 }
 
 void D3D11Renderer::Present(bool vsync) {
-    m_swapChain->Present(vsync ? 1 : 0, 0);
+    if (!m_swapChain) return;
+    // Without vsync, tear rather than wait for the compositor: on a VRR display
+    // the refresh then follows the present rate
+    const UINT flags = (!vsync && m_tearingSupported) ? DXGI_PRESENT_ALLOW_TEARING : 0;
+    m_occluded = (m_swapChain->Present(vsync ? 1 : 0, flags) == DXGI_STATUS_OCCLUDED);
+    m_presentedSinceWait = true;
+}
+
+bool D3D11Renderer::TestOccluded() {
+    if (!m_swapChain) return false;
+    m_occluded = (m_swapChain->Present(0, DXGI_PRESENT_TEST) == DXGI_STATUS_OCCLUDED);
+    return m_occluded;
+}
+
+// Size and texel format of one readback plane; chroma sizes round up like FFmpeg's
+struct ReadbackPlaneDesc {
+    int width;
+    int height;
+    int bytesPerTexel;
+    DXGI_FORMAT format;
+};
+
+static ReadbackPlaneDesc GetReadbackPlane(ReadbackLayout layout, int plane, int width, int height) {
+    switch (layout) {
+    case ReadbackLayout::YUV420P:
+        return plane == 0 ? ReadbackPlaneDesc{ width, height, 1, DXGI_FORMAT_R8_UNORM }
+                          : ReadbackPlaneDesc{ (width + 1) / 2, (height + 1) / 2, 1, DXGI_FORMAT_R8_UNORM };
+    case ReadbackLayout::YUV422P10:
+        return plane == 0 ? ReadbackPlaneDesc{ width, height, 2, DXGI_FORMAT_R16_UNORM }
+                          : ReadbackPlaneDesc{ (width + 1) / 2, height, 2, DXGI_FORMAT_R16_UNORM };
+    default:
+        return { width, height, 4, DXGI_FORMAT_R8G8B8A8_UNORM };
+    }
+}
+
+static int ReadbackPlaneCount(ReadbackLayout layout) {
+    return layout == ReadbackLayout::RGBA8 ? 1 : 3;
+}
+
+// BT.709 limited-range RGB→Y/Cb/Cr rows in bitDepth-bit code values, scaled to
+// the plane's UNORM container (containerMax = 255 for R8, 65535 for R16).
+static void BuildRgbToYuvRows(int bitDepth, float containerMax, float rows[3][4]) {
+    const float kr = 0.2126f, kb = 0.0722f, kg = 1.0f - kr - kb;
+    const float unit    = static_cast<float>(1 << (bitDepth - 8)) / containerMax;  // One 8-bit step
+    const float yScale  = 219.0f * unit, yOffset = 16.0f * unit;
+    const float cScale  = 224.0f * unit, cOffset = 128.0f * unit;
+
+    const float y[4]  = { yScale * kr, yScale * kg, yScale * kb, yOffset };
+    const float cb[4] = { -cScale * kr / (2.0f * (1.0f - kb)), -cScale * kg / (2.0f * (1.0f - kb)),
+                          cScale * 0.5f, cOffset };
+    const float cr[4] = { cScale * 0.5f, -cScale * kg / (2.0f * (1.0f - kr)),
+                          -cScale * kb / (2.0f * (1.0f - kr)), cOffset };
+    for (int i = 0; i < 4; ++i) {
+        rows[0][i] = y[i];
+        rows[1][i] = cb[i];
+        rows[2][i] = cr[i];
+    }
+}
+
+void D3D11Renderer::SetReadbackLayout(ReadbackLayout layout) {
+    if (!m_device) return;
+    for (auto& row : m_rgbToYuvRows) row.Reset();
+    m_readbackLayout = ReadbackLayout::RGBA8;
+    if (layout == ReadbackLayout::RGBA8 || !m_rgbToYuvPS) return;
+
+    float rows[3][4];
+    if (layout == ReadbackLayout::YUV422P10) BuildRgbToYuvRows(10, 65535.0f, rows);
+    else                                     BuildRgbToYuvRows(8, 255.0f, rows);
+
+    for (int i = 0; i < 3; ++i) {
+        if (!CreateRowBuffer(rows[i], nullptr, m_rgbToYuvRows[i])) {
+            for (auto& row : m_rgbToYuvRows) row.Reset();
+            return;  // Stays RGBA8; the encoder converts on the CPU
+        }
+    }
+    m_readbackLayout = layout;
+}
+
+void D3D11Renderer::SetReadbackSize(int width, int height) {
+    const bool valid = width > 0 && height > 0;
+    m_readbackWidth  = valid ? width  : 0;
+    m_readbackHeight = valid ? height : 0;
+}
+
+bool D3D11Renderer::CreateRowBuffer(const float row0[4], const float row1[4], ComPtr<ID3D11Buffer>& outBuffer) {
+    float rows[8] = {};
+    std::copy(row0, row0 + 4, rows);
+    if (row1) std::copy(row1, row1 + 4, rows + 4);
+
+    D3D11_BUFFER_DESC cbDesc = {};
+    cbDesc.ByteWidth = sizeof(rows);
+    cbDesc.Usage     = D3D11_USAGE_IMMUTABLE;
+    cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem = rows;
+    return SUCCEEDED(m_device->CreateBuffer(&cbDesc, &initData, &outBuffer));
 }
 
-bool D3D11Renderer::RenderToTexture() {
-    const int w = (m_videoWidth  > 0) ? m_videoWidth  : m_generativeWidth;
-    const int h = (m_videoHeight > 0) ? m_videoHeight : m_generativeHeight;
+bool D3D11Renderer::ConvertToNv12(ID3D11Texture2D* target, int slice) {
+    ID3D11ShaderResourceView* source = GetReadbackSRV();
+    if (!target || !source || !m_rgbToYuvPS) return false;
 
-    if (!m_renderTexture || !m_renderTextureRTV ||
-        m_renderTextureWidth != w || m_renderTextureHeight != h) {
-        if (!CreateRenderToTexture(w, h)) {
+    D3D11_TEXTURE2D_DESC desc;
+    target->GetDesc(&desc);
+    if (desc.Format != DXGI_FORMAT_NV12 || slice < 0 || static_cast<UINT>(slice) >= desc.ArraySize) return false;
+    GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Readback);
+
+    // Per-slice plane RTVs (R8 = luma, R8G8 = CbCr), rebuilt when the encoder
+    // allocates a new surface pool
+    if (m_encodeTargetTexture.Get() != target) {
+        m_encodeTargetTexture = target;
+        m_encodeSliceViews.assign(desc.ArraySize, EncodeSliceViews{});
+    }
+    EncodeSliceViews& views = m_encodeSliceViews[slice];
+    if (!views.luma) {
+        D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+        rtvDesc.ViewDimension                  = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+        rtvDesc.Texture2DArray.FirstArraySlice = static_cast<UINT>(slice);
+        rtvDesc.Texture2DArray.ArraySize       = 1;
+        rtvDesc.Format = DXGI_FORMAT_R8_UNORM;
+        if (FAILED(m_device->CreateRenderTargetView(target, &rtvDesc, &views.luma))) return false;
+        rtvDesc.Format = DXGI_FORMAT_R8G8_UNORM;
+        if (FAILED(m_device->CreateRenderTargetView(target, &rtvDesc, &views.chroma))) {
+            views = EncodeSliceViews{};
+            return false;
+        }
+    }
+
+    if (!DrawNv12(source, views.luma.Get(), views.chroma.Get(), desc.Width, desc.Height)) return false;
+    // The encoder reads the surface from its own thread: submit the draws now
+    // rather than at Present
+    m_context->Flush();
+    return true;
+}
+
+bool D3D11Renderer::ConvertToNv12(ID3D11ShaderResourceView* source, ID3D11RenderTargetView* luma,
+                                  ID3D11RenderTargetView* chroma, int width, int height) {
+    if (!source) source = m_displaySRV.Get();
+    if (!source || !luma || !chroma || !m_rgbToYuvPS || width < 2 || height < 2) return false;
+    GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::VirtualCamera);
+    return DrawNv12(source, luma, chroma, static_cast<UINT>(width), static_cast<UINT>(height));
+}
+
+bool D3D11Renderer::DrawNv12(ID3D11ShaderResourceView* source, ID3D11RenderTargetView* luma,
+                             ID3D11RenderTargetView* chroma, UINT width, UINT height) {
+    if (!m_nv12Rows[0]) {
+        float rows[3][4];
+        BuildRgbToYuvRows(8, 255.0f, rows);
+        if (!CreateRowBuffer(rows[0], nullptr, m_nv12Rows[0]) ||
+            !CreateRowBuffer(rows[1], rows[2], m_nv12Rows[1])) {
+            m_nv12Rows[0].Reset();
             return false;
         }
     }
 
-    const bool doComposite = (m_videoBlendMode > 0) && (m_videoWidth > 0) && m_compositorPS;
+    // Full pipeline setup, as in RunYuvPass — BeginFrame rebinds everything after.
+    // The viewport is the target's size, so a display texture of another size
+    // (proxy frames before the source reopens) is scaled by the sampler.
+    struct PlanePass {
+        ID3D11RenderTargetView* rtv;
+        ID3D11Buffer*           rows;
+        UINT                    width;
+        UINT                    height;
+    };
+    const PlanePass passes[2] = {
+        { luma,   m_nv12Rows[0].Get(), width,           height },
+        { chroma, m_nv12Rows[1].Get(), (width + 1) / 2, (height + 1) / 2 },
+    };
 
-    auto setViewport = [&](int vw, int vh) {
+    m_context->OMSetRenderTargets(1, &passes[0].rtv, nullptr);
+    m_pipelineState.SetInputAssembler(m_inputLayout.Get(), m_vertexBuffer.Get(), sizeof(float) * 4);
+    m_pipelineState.SetVertexShader(m_vertexShader.Get());
+    m_pipelineState.SetPixelShader(m_rgbToYuvPS.Get());
+    m_context->PSSetShaderResources(0, 1, &source);
+    m_pipelineState.SetPSSampler(0, m_sampler.Get());
+    m_pipelineState.SetRasterizerState(m_rasterizerState.Get());
+    m_pipelineState.SetBlendState(m_blendState.Get());
+
+    for (const PlanePass& pass : passes) {
+        m_context->OMSetRenderTargets(1, &pass.rtv, nullptr);
         D3D11_VIEWPORT vp = {};
-        vp.Width    = static_cast<float>(vw);
-        vp.Height   = static_cast<float>(vh);
+        vp.Width    = static_cast<float>(pass.width);
+        vp.Height   = static_cast<float>(pass.height);
         vp.MaxDepth = 1.0f;
         m_context->RSSetViewports(1, &vp);
-    };
+        m_pipelineState.SetPSConstantBuffer(0, pass.rows);
+        m_context->Draw(3, 0);
+    }
 
-    float clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    m_context->PSSetShaderResources(0, 1, &nullSRV);
+    m_context->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
+    return true;
+}
 
-    if (doComposite) {
-        // Pass 1 — active (generative) shader into compositor src texture
-        if (!CreateCompositorSrcTexture(w, h)) return false;
-        m_context->ClearRenderTargetView(m_compositorSrcRTV.Get(), clearColor);
-        m_context->OMSetRenderTargets(1, m_compositorSrcRTV.GetAddressOf(), nullptr);
-        setViewport(w, h);
-        m_context->PSSetShader(m_activePS.Get(), nullptr, 0);
-        m_context->Draw(3, 0);
+bool D3D11Renderer::ConvertToUyvy(ID3D11ShaderResourceView* source, ID3D11RenderTargetView* target,
+                                  int width, int height) {
+    if (!source) source = m_displaySRV.Get();
+    if (!target || !source || width < 2 || height < 1) return false;
+    if (!m_rgbToUyvyPS) {
+        std::string error;
+        if (!CompilePixelShader(g_rgbToUyvyShaderSource, m_rgbToUyvyPS, error)) return false;
+    }
+    if (m_uyvyWidth != width) {
+        float rows[3][4];
+        BuildRgbToYuvRows(8, 255.0f, rows);
+        float constants[16] = {};
+        for (int i = 0; i < 3; ++i) std::copy(rows[i], rows[i] + 4, constants + i * 4);
+        constants[12] = 0.5f / static_cast<float>(width);
+
+        D3D11_BUFFER_DESC cbDesc = {};
+        cbDesc.ByteWidth = sizeof(constants);
+        cbDesc.Usage     = D3D11_USAGE_IMMUTABLE;
+        cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        D3D11_SUBRESOURCE_DATA initData = {};
+        initData.pSysMem = constants;
+        m_uyvyConstants.Reset();
+        if (FAILED(m_device->CreateBuffer(&cbDesc, &initData, &m_uyvyConstants))) return false;
+        m_uyvyWidth = width;
+    }
+    GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Ndi);
 
-        // Pass 2 — compositor to render texture
-        m_context->ClearRenderTargetView(m_renderTextureRTV.Get(), clearColor);
-        m_context->OMSetRenderTargets(1, m_renderTextureRTV.GetAddressOf(), nullptr);
-        setViewport(w, h);
-        m_context->PSSetShader(m_compositorPS.Get(), nullptr, 0);
-        m_context->PSSetShaderResources(2, 1, m_compositorSrcSRV.GetAddressOf());
-        m_context->Draw(3, 0);
+    // Full pipeline setup, as in RunYuvPass — BeginFrame rebinds everything after.
+    // A display texture of another size is scaled by the sampler.
+    m_context->OMSetRenderTargets(1, &target, nullptr);
+    D3D11_VIEWPORT vp = {};
+    vp.Width    = static_cast<float>(width / 2);
+    vp.Height   = static_cast<float>(height);
+    vp.MaxDepth = 1.0f;
+    m_context->RSSetViewports(1, &vp);
+    m_pipelineState.SetInputAssembler(m_inputLayout.Get(), m_vertexBuffer.Get(), sizeof(float) * 4);
+    m_pipelineState.SetVertexShader(m_vertexShader.Get());
+    m_pipelineState.SetPixelShader(m_rgbToUyvyPS.Get());
+    m_context->PSSetShaderResources(0, 1, &source);
+    m_pipelineState.SetPSSampler(0, m_sampler.Get());
+    m_pipelineState.SetPSConstantBuffer(0, m_uyvyConstants.Get());
+    m_pipelineState.SetRasterizerState(m_rasterizerState.Get());
+    m_pipelineState.SetBlendState(m_blendState.Get());
+    m_context->Draw(3, 0);
 
-        ID3D11ShaderResourceView* nullSRV = nullptr;
-        m_context->PSSetShaderResources(2, 1, &nullSRV);
-        m_context->PSSetShader(m_activePS.Get(), nullptr, 0);
-    } else {
-        m_context->ClearRenderTargetView(m_renderTextureRTV.Get(), clearColor);
-        m_context->OMSetRenderTargets(1, m_renderTextureRTV.GetAddressOf(), nullptr);
-        setViewport(w, h);
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    m_context->PSSetShaderResources(0, 1, &nullSRV);
+    m_context->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
+    return true;
+}
+
+bool D3D11Renderer::RunRgbToYuvPass(ID3D11ShaderResourceView* source, int width, int height) {
+    for (int i = 0; i < 3; ++i) {
+        const ReadbackPlaneDesc desc = GetReadbackPlane(m_readbackLayout, i, width, height);
+        ReadbackPlane& plane = m_readbackPlanes[i];
+        if (plane.texture && plane.width == desc.width && plane.height == desc.height && plane.format == desc.format) {
+            continue;
+        }
+        plane = ReadbackPlane{};
+
+        D3D11_TEXTURE2D_DESC texDesc = {};
+        texDesc.Width            = static_cast<UINT>(desc.width);
+        texDesc.Height           = static_cast<UINT>(desc.height);
+        texDesc.MipLevels        = 1;
+        texDesc.ArraySize        = 1;
+        texDesc.Format           = desc.format;
+        texDesc.SampleDesc.Count = 1;
+        texDesc.Usage            = D3D11_USAGE_DEFAULT;
+        texDesc.BindFlags        = D3D11_BIND_RENDER_TARGET;
+        if (FAILED(m_device->CreateTexture2D(&texDesc, nullptr, &plane.texture)) ||
+            FAILED(m_device->CreateRenderTargetView(plane.texture.Get(), nullptr, &plane.rtv))) {
+            plane = ReadbackPlane{};
+            return false;
+        }
+        plane.width  = desc.width;
+        plane.height = desc.height;
+        plane.format = desc.format;
+    }
+
+    // Full pipeline setup, as in RunYuvPass — BeginFrame rebinds everything after
+    m_context->OMSetRenderTargets(1, m_readbackPlanes[0].rtv.GetAddressOf(), nullptr);
+    m_pipelineState.SetInputAssembler(m_inputLayout.Get(), m_vertexBuffer.Get(), sizeof(float) * 4);
+    m_pipelineState.SetVertexShader(m_vertexShader.Get());
+    m_pipelineState.SetPixelShader(m_rgbToYuvPS.Get());
+    m_context->PSSetShaderResources(0, 1, &source);
+    m_pipelineState.SetPSSampler(0, m_sampler.Get());
+    m_pipelineState.SetRasterizerState(m_rasterizerState.Get());
+    m_pipelineState.SetBlendState(m_blendState.Get());
+
+    for (int i = 0; i < 3; ++i) {
+        const ReadbackPlane& plane = m_readbackPlanes[i];
+        m_context->OMSetRenderTargets(1, plane.rtv.GetAddressOf(), nullptr);
+        D3D11_VIEWPORT vp = {};
+        vp.Width    = static_cast<float>(plane.width);
+        vp.Height   = static_cast<float>(plane.height);
+        vp.MaxDepth = 1.0f;
+        m_context->RSSetViewports(1, &vp);
+        m_pipelineState.SetPSConstantBuffer(0, m_rgbToYuvRows[i].Get());
         m_context->Draw(3, 0);
     }
 
+    // Unbind the source (the display texture is an RTV again next frame) and the plane targets
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    m_context->PSSetShaderResources(0, 1, &nullSRV);
+    m_context->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
     return true;
 }
 
-bool D3D11Renderer::CopyRenderTargetToStaging(std::vector<uint8_t>& outData, int& outWidth, int& outHeight) {
-    if (!m_renderTexture || !m_stagingTexture) {
+bool D3D11Renderer::EnsureReadbackSlot(ReadbackSlot& slot, int width, int height, ReadbackLayout layout) {
+    if (slot.query && slot.width == width && slot.height == height && slot.layout == layout) return true;
+    slot = ReadbackSlot{};
+
+    for (int i = 0; i < ReadbackPlaneCount(layout); ++i) {
+        const ReadbackPlaneDesc desc = GetReadbackPlane(layout, i, width, height);
+        D3D11_TEXTURE2D_DESC texDesc = {};
+        texDesc.Width            = static_cast<UINT>(desc.width);
+        texDesc.Height           = static_cast<UINT>(desc.height);
+        texDesc.MipLevels        = 1;
+        texDesc.ArraySize        = 1;
+        texDesc.Format           = desc.format;
+        texDesc.SampleDesc.Count = 1;
+        texDesc.Usage            = D3D11_USAGE_STAGING;
+        texDesc.CPUAccessFlags   = D3D11_CPU_ACCESS_READ;
+        if (FAILED(m_device->CreateTexture2D(&texDesc, nullptr, &slot.planes[i]))) {
+            slot = ReadbackSlot{};
+            return false;
+        }
+    }
+
+    D3D11_QUERY_DESC queryDesc = {};
+    queryDesc.Query = D3D11_QUERY_EVENT;
+    if (FAILED(m_device->CreateQuery(&queryDesc, &slot.query))) {
+        slot = ReadbackSlot{};
         return false;
     }
+    slot.width  = width;
+    slot.height = height;
+    slot.layout = layout;
+    return true;
+}
 
-    // Copy to staging texture
-    m_context->CopyResource(m_stagingTexture.Get(), m_renderTexture.Get());
+bool D3D11Renderer::QueueReadback() {
+    ID3D11ShaderResourceView* source = GetReadbackSRV();
+    if (!source || IsReadbackRingFull()) return false;
+
+    ReadbackSlot& slot = m_readbackSlots[(m_readbackHead + m_readbackCount) % READBACK_SLOTS];
+    // The texture's own size, not m_videoWidth/m_generativeWidth, which can
+    // change before the next RenderToDisplay recreates the display texture
+    ComPtr<ID3D11Resource> texture;
+    source->GetResource(&texture);
+    D3D11_TEXTURE2D_DESC desc = {};
+    static_cast<ID3D11Texture2D*>(texture.Get())->GetDesc(&desc);
+    const int sourceWidth  = static_cast<int>(desc.Width);
+    const int sourceHeight = static_cast<int>(desc.Height);
+    const int width  = m_readbackWidth  > 0 ? m_readbackWidth  : sourceWidth;
+    const int height = m_readbackHeight > 0 ? m_readbackHeight : sourceHeight;
+    if (!EnsureReadbackSlot(slot, width, height, m_readbackLayout)) return false;
+
+    GpuProfiler::Scope scope(m_gpuProfiler, GpuStage::Readback);
+    // Through m_readbackTarget when resizing, or quantising a 16-bit working
+    // format for the RGBA8 copy (the YUV pass reads any format)
+    const bool resize = width != sourceWidth || height != sourceHeight;
+    const DXGI_FORMAT format = m_readbackLayout == ReadbackLayout::RGBA8 ? DXGI_FORMAT_R8G8B8A8_UNORM : desc.Format;
+    if (resize || format != desc.Format) {
+        if ((m_readbackTarget.width != width || m_readbackTarget.height != height ||
+             m_readbackTarget.format != format) &&
+            !RenderTargetPool::Create(m_device.Get(), width, height, format, m_readbackTarget)) {
+            return false;
+        }
+        if (resize && width >= sourceWidth && height >= sourceHeight) {
+            UpscaleTo(source, m_readbackTarget.rtv.Get(), width, height);
+        } else {
+            BlitTo(source, m_readbackTarget.rtv.Get(), width, height, resize ? m_downscalePS.Get() : nullptr);
+        }
+        source  = m_readbackTarget.srv.Get();
+        texture = m_readbackTarget.texture;
+    }
 
-    // Use the tracked render texture dimensions — these always match the staging
-    // texture allocation, unlike recomputing from m_videoWidth/m_generativeWidth
-    // which can diverge if the texture was created at a different resolution.
-    const int renderW = m_renderTextureWidth;
-    const int renderH = m_renderTextureHeight;
+    if (m_readbackLayout == ReadbackLayout::RGBA8) {
+        m_context->CopyResource(slot.planes[0].Get(), texture.Get());
+    } else {
+        if (!RunRgbToYuvPass(source, width, height)) return false;
+        for (int i = 0; i < 3; ++i) {
+            m_context->CopyResource(slot.planes[i].Get(), m_readbackPlanes[i].texture.Get());
+        }
+    }
+    m_context->End(slot.query.Get());  // Signals once the copies have executed
+    slot.serial = ++m_readbackSerial;
+    ++m_readbackCount;
+    return true;
+}
 
-    // Map and copy data
-    D3D11_MAPPED_SUBRESOURCE mapped;
-    HRESULT hr = m_context->Map(m_stagingTexture.Get(), 0, D3D11_MAP_READ, 0, &mapped);
-    if (FAILED(hr)) return false;
+bool D3D11Renderer::CollectReadback(FramePool& pool, FrameBuffer& outData, int& outWidth, int& outHeight,
+                                    ReadbackLayout& outLayout, bool wait) {
+    if (m_readbackCount == 0) return false;
+    ReadbackSlot& slot = m_readbackSlots[m_readbackHead];
 
-    outWidth  = renderW;
-    outHeight = renderH;
-    const int rowBytes = renderW * 4;
+    // DONOTFLUSH: polling must not push the frame still being recorded to the GPU early
+    if (!wait && m_context->GetData(slot.query.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+        return false;
+    }
+    m_readbackHead = (m_readbackHead + 1) % READBACK_SLOTS;
+    --m_readbackCount;
+
+    const int planeCount = ReadbackPlaneCount(slot.layout);
+    size_t totalBytes = 0;
+    for (int i = 0; i < planeCount; ++i) {
+        const ReadbackPlaneDesc desc = GetReadbackPlane(slot.layout, i, slot.width, slot.height);
+        totalBytes += static_cast<size_t>(desc.width) * desc.bytesPerTexel * desc.height;
+    }
     // swscale's 4:2:0 chroma path reads source rows in pairs, so it can read one
     // row past the last valid row. For dimensions where width*height*4 is exactly
     // divisible by 4096 (e.g. 1920×1080), the allocation lands page-aligned with
     // zero slack and that extra-row read hits an unmapped page → access violation.
     // Two rows of tail padding guarantees the read lands in committed memory.
-    outData.resize(static_cast<size_t>(renderW) * renderH * 4 + rowBytes * 2, 0);
-
-    const uint8_t* src = static_cast<const uint8_t*>(mapped.pData);
-    uint8_t* dst = outData.data();
-
-    for (int y = 0; y < renderH; ++y) {
-        memcpy(dst + y * rowBytes, src + y * mapped.RowPitch, rowBytes);
+    // The block goes to the encoder by reference, so this readback is the only copy.
+    outData = pool.Acquire(totalBytes + static_cast<size_t>(slot.width) * 4 * 2);
+
+    // Planes back to back, tightly packed (the layout av_image_fill_arrays expects
+    // with align 1). Map blocks only when waiting; a signalled query means done.
+    uint8_t* dst = outData.get();
+    for (int i = 0; i < planeCount; ++i) {
+        const ReadbackPlaneDesc desc = GetReadbackPlane(slot.layout, i, slot.width, slot.height);
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (FAILED(m_context->Map(slot.planes[i].Get(), 0, D3D11_MAP_READ, 0, &mapped))) {
+            outData.reset();
+            return false;
+        }
+        const size_t rowBytes = static_cast<size_t>(desc.width) * desc.bytesPerTexel;
+        CopyRows(dst, rowBytes, static_cast<const uint8_t*>(mapped.pData), mapped.RowPitch, rowBytes, desc.height);
+        dst += rowBytes * desc.height;
+        m_context->Unmap(slot.planes[i].Get(), 0);
     }
 
-    m_context->Unmap(m_stagingTexture.Get(), 0);
+    outWidth  = slot.width;
+    outHeight = slot.height;
+    outLayout = slot.layout;
+    m_readbackLatency = static_cast<int>(m_readbackSerial - slot.serial);
     return true;
 }
 
+void D3D11Renderer::DiscardReadbacks() {
+    m_readbackHead    = 0;
+    m_readbackCount   = 0;
+    m_readbackLatency = 0;
+}
+
 void D3D11Renderer::SetShaderTime(float time) {
     m_constants.time = time;
 }
@@ -1015,33 +4558,48 @@ void D3D11Renderer::SetCustomUniforms(const float* data, size_t floatCount) {
     memcpy(m_constants.custom, data, copyCount * sizeof(float));
 }
 
+void D3D11Renderer::SetExtendedParams(const float* data, size_t floatCount) {
+    const size_t copyCount = std::min(floatCount, size_t(MAX_EXTENDED_PARAM_FLOATS));
+    std::copy_n(data, copyCount, m_extendedParams);
+    std::fill(m_extendedParams + copyCount, std::end(m_extendedParams), 0.0f);
+    m_extendedParamCount = static_cast<int>(copyCount);
+}
+
 // ---------------------------------------------------------------------------
-// Noise texture generation (CPU-side Perlin + Voronoi, stored in R+G channels)
+// Noise texture generation: CPU fallback of g_noiseShaderSource (Perlin in R, Voronoi in G)
 // ---------------------------------------------------------------------------
 
 namespace {
 
+// fBm octaves in the texture's B/A and the volume's G; lattice cells per side of the volume
+constexpr int NOISE_FBM_OCTAVES   = 4;
+constexpr int NOISE_VOLUME_PERIOD = 4;
+
 // Improved smoothstep (Ken Perlin's quintic)
 static float quintic(float t) {
     return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
 }
 
-// Pseudo-random gradient dot product for Perlin noise
-static float gradDot(int ix, int iy, float fx, float fy) {
-    uint32_t h = static_cast<uint32_t>(ix) * 1619u + static_cast<uint32_t>(iy) * 31337u;
+// Lattice coordinate wrapped into [0, period) so the texture tiles
+static uint32_t wrapCell(int c, int period) {
+    return static_cast<uint32_t>(((c % period) + period) % period);
+}
+
+static uint32_t hashCell(uint32_t ix, uint32_t iy, uint32_t seed) {
+    uint32_t h = ix * 1619u + iy * 31337u + seed * 6271u;
     h ^= h >> 13;
     h *= 0xbf58476du;
     h ^= h >> 31;
-    switch (h & 3) {
-        case 0: return  fx + fy;
-        case 1: return -fx + fy;
-        case 2: return  fx - fy;
-        case 3: return -fx - fy;
-    }
-    return 0.0f;
+    return h;
+}
+
+// Pseudo-random gradient dot product for Perlin noise
+static float gradDot(int ix, int iy, int period, float fx, float fy) {
+    const uint32_t h = hashCell(wrapCell(ix, period), wrapCell(iy, period), 0u);
+    return ((h & 1u) ? -fx : fx) + ((h & 2u) ? -fy : fy);
 }
 
-static float perlinNoise(float x, float y) {
+static float perlinNoise(float x, float y, int period) {
     int xi = static_cast<int>(floorf(x));
     int yi = static_cast<int>(floorf(y));
     float xf = x - static_cast<float>(xi);
@@ -1049,26 +4607,17 @@ static float perlinNoise(float x, float y) {
     float u  = quintic(xf);
     float v  = quintic(yf);
 
-    float n00 = gradDot(xi,     yi,     xf,     yf    );
-    float n10 = gradDot(xi + 1, yi,     xf - 1, yf    );
-    float n01 = gradDot(xi,     yi + 1, xf,     yf - 1);
-    float n11 = gradDot(xi + 1, yi + 1, xf - 1, yf - 1);
+    float n00 = gradDot(xi,     yi,     period, xf,     yf    );
+    float n10 = gradDot(xi + 1, yi,     period, xf - 1, yf    );
+    float n01 = gradDot(xi,     yi + 1, period, xf,     yf - 1);
+    float n11 = gradDot(xi + 1, yi + 1, period, xf - 1, yf - 1);
 
     float lx0 = n00 + u * (n10 - n00);
     float lx1 = n01 + u * (n11 - n01);
     return (lx0 + v * (lx1 - lx0)) * 0.5f + 0.5f;  // map [-1,1] → [0,1]
 }
 
-// Hash giving a float in [0,1] for a cell feature point coordinate
-static float cellHash(uint32_t ix, uint32_t iy, uint32_t seed) {
-    uint32_t h = ix * 1619u + iy * 31337u + seed * 6271u;
-    h ^= h >> 13;
-    h *= 0xbf58476du;
-    h ^= h >> 31;
-    return static_cast<float>(h & 0xFFFFu) / 65535.0f;
-}
-
-static float voronoiNoise(float x, float y) {
+static float voronoiNoise(float x, float y, int period) {
     int xi = static_cast<int>(floorf(x));
     int yi = static_cast<int>(floorf(y));
     float minDist = 1e10f;
@@ -1076,8 +4625,10 @@ static float voronoiNoise(float x, float y) {
         for (int dx = -1; dx <= 1; ++dx) {
             int cx = xi + dx;
             int cy = yi + dy;
-            float px = static_cast<float>(cx) + cellHash(static_cast<uint32_t>(cx), static_cast<uint32_t>(cy), 0u);
-            float py = static_cast<float>(cy) + cellHash(static_cast<uint32_t>(cx), static_cast<uint32_t>(cy), 1u);
+            // Feature point hashed from the wrapped cell, placed in the unwrapped one
+            const uint32_t wx = wrapCell(cx, period), wy = wrapCell(cy, period);
+            float px = static_cast<float>(cx) + static_cast<float>(hashCell(wx, wy, 0u) & 0xFFFFu) / 65535.0f;
+            float py = static_cast<float>(cy) + static_cast<float>(hashCell(wx, wy, 1u) & 0xFFFFu) / 65535.0f;
             float d  = sqrtf((x - px) * (x - px) + (y - py) * (y - py));
             if (d < minDist) minDist = d;
         }
@@ -1085,13 +4636,40 @@ static float voronoiNoise(float x, float y) {
     return (std::min)(minDist, 1.0f);
 }
 
+static uint8_t toUnorm8(float v) {
+    return static_cast<uint8_t>((std::max)(0.0f, (std::min)(1.0f, v)) * 255.0f + 0.5f);
+}
+
 } // anonymous namespace
 
+void D3D11Renderer::RecycleVideoTexture() {
+    RecycleTexture(m_videoTexture, m_videoRTV, m_videoSRV, m_videoWidth, m_videoHeight, m_videoFormat,
+                   m_videoIsRenderTarget ? (D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET) : D3D11_BIND_SHADER_RESOURCE,
+                   D3D11_USAGE_DEFAULT);
+}
+
 void D3D11Renderer::ReleaseVideoTexture() {
-    m_videoTexture.Reset();
-    m_videoSRV.Reset();
+    // The next clip is often the same size: it takes this texture back
+    RecycleVideoTexture();
+    // Drop the decoder surface pool reference too — it belongs to the closed stream.
+    m_hwSourceTexture.Reset();
+    m_hwSliceViews.clear();
+    for (auto& plane : m_yuvPlanes) plane = PlaneTexture{};
+    m_videoUpload.Reset();
+    for (auto& upload : m_planeUploads) upload.Reset();
+    m_cachedFrameSRV.Reset();
+    m_externalVideoSRV.Reset();
+    m_scrubCache.Clear();
+    m_loopCache.Clear();
+    m_renderAhead.Clear();
     m_videoWidth  = 0;
     m_videoHeight = 0;
+    m_videoFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+    m_videoGeneration = 0;
+    m_historyConstants.count = 0;  // The next video starts a fresh history
+    UpdateHistoryConstants();
+    m_videoMipSerial = 0;  // Holds the closed video's frame
+    m_displayDirty = true;
     // Unbind from pipeline immediately so the next BeginFrame doesn't hold a stale SRV.
     if (m_context) {
         ID3D11ShaderResourceView* nullSRV = nullptr;
@@ -1099,97 +4677,542 @@ void D3D11Renderer::ReleaseVideoTexture() {
     }
 }
 
-void D3D11Renderer::SetGenerativeResolution(int width, int height) {
-    m_generativeWidth  = (std::max)(width,  1);
-    m_generativeHeight = (std::max)(height, 1);
-    // Force display texture recreation on next RenderToDisplay call
-    m_displayWidth  = 0;
-    m_displayHeight = 0;
+void D3D11Renderer::SetExternalVideo(ID3D11ShaderResourceView* srv, int width, int height) {
+    if (!srv || width <= 0 || height <= 0) return;
+    m_externalVideoSRV = srv;
+    m_videoWidth       = width;
+    m_videoHeight      = height;
+    m_videoGeneration  = 0;
+    ++m_videoFrameSerial;
+    m_displayDirty = true;
 }
 
-bool D3D11Renderer::UpdateNoiseTexture(float scale, int texSize) {
-    if (!m_device) return false;
-    texSize = (std::max)(texSize, 64);
+void D3D11Renderer::ClearExternalVideo() {
+    if (!m_externalVideoSRV) return;
+    ReleaseVideoTexture();
+}
 
-    // Generate Perlin in R, Voronoi in G (inverted so cells are bright centers)
-    std::vector<uint8_t> pixels(static_cast<size_t>(texSize) * texSize * 4);
+void D3D11Renderer::CacheVideoFrame(int64_t key) {
+    if (m_cachedFrameSRV || !m_videoTexture) return;  // t0 is not a freshly uploaded frame
+    m_scrubCache.Store(m_device.Get(), m_context.Get(), key, m_videoTexture.Get(),
+                       m_videoWidth, m_videoHeight, m_videoFormat);
+    m_loopCache.Store(m_device.Get(), m_context.Get(), key, m_videoTexture.Get(),
+                      m_videoWidth, m_videoHeight, m_videoFormat);
+}
 
-    for (int y = 0; y < texSize; ++y) {
-        for (int x = 0; x < texSize; ++x) {
-            float nx = (x + 0.5f) / static_cast<float>(texSize) * scale;
-            float ny = (y + 0.5f) / static_cast<float>(texSize) * scale;
+bool D3D11Renderer::ShowCachedVideoFrame(int64_t key) {
+    // Cached frames always match the current video size — Store clears on resize
+    ID3D11ShaderResourceView* srv = m_loopCache.Find(key);
+    if (!srv) srv = m_scrubCache.Find(key);
+    if (!srv || m_videoWidth == 0) return false;
+    m_cachedFrameSRV  = srv;
+    m_videoGeneration = 0;  // t0 no longer shows the last uploaded frame
+    ++m_videoFrameSerial;
+    m_displayDirty = true;
+    return true;
+}
 
-            float p = perlinNoise(nx, ny);
-            float v = 1.0f - voronoiNoise(nx, ny);  // invert: bright centres
+bool D3D11Renderer::PushRenderAhead(double timestamp, bool loopStart) {
+    if (m_cachedFrameSRV || m_externalVideoSRV || !m_videoTexture) return false;  // t0 is not a fresh upload
+    return m_renderAhead.Push(m_device.Get(), m_context.Get(), timestamp, loopStart, m_videoTexture.Get(),
+                              m_videoWidth, m_videoHeight, m_videoFormat, m_displayTexture.Get(),
+                              m_displayWidth, m_displayHeight, m_displayFormat);
+}
 
-            p = (std::max)(0.0f, (std::min)(1.0f, p));
-            v = (std::max)(0.0f, (std::min)(1.0f, v));
+bool D3D11Renderer::ShowRenderAheadSource(int index) {
+    ID3D11ShaderResourceView* srv = m_renderAhead.GetSourceSRV(index);
+    if (!srv || m_videoWidth == 0) return false;
+    m_cachedFrameSRV  = srv;
+    m_videoGeneration = 0;  // t0 no longer shows the last uploaded frame
+    ++m_videoFrameSerial;
+    m_displayDirty = true;
+    return true;
+}
 
-            uint8_t* px       = &pixels[(static_cast<size_t>(y) * texSize + x) * 4];
-            px[0] = static_cast<uint8_t>(p * 255.0f);  // R = Perlin
-            px[1] = static_cast<uint8_t>(v * 255.0f);  // G = Voronoi
-            px[2] = 0;
-            px[3] = 255;
-        }
-    }
+bool D3D11Renderer::StoreRenderAhead(int index) {
+    return m_displayTexture && m_renderAhead.Store(m_device.Get(), m_context.Get(), index, m_displayTexture.Get(),
+                                                   m_displayWidth, m_displayHeight, m_displayFormat);
+}
+
+bool D3D11Renderer::PresentRenderAhead() {
+    if (m_renderAhead.IsEmpty() || m_renderAhead.At(0).stale || !m_displayTexture) return false;
+    ID3D11Texture2D* output = m_renderAhead.GetOutput(0, m_displayWidth, m_displayHeight, m_displayFormat);
+    if (!output) return false;
+    m_context->CopyResource(m_displayTexture.Get(), output);
+    // The outputs and post chains see a new frame; the next RenderToDisplay draws
+    // over it whatever its inputs
+    ++m_displayGeneration;
+    m_displayDirty = true;
+    return true;
+}
+
+void D3D11Renderer::SetGenerativeResolution(int width, int height) {
+    // Past the texture limit only RenderCanvasTile can draw it
+    m_generativeWidth  = std::clamp(width,  1, D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION);
+    m_generativeHeight = std::clamp(height, 1, D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION);
+    // RenderToDisplay resizes the display texture if this changed its size
+    m_displayDirty = true;
+}
+
+bool D3D11Renderer::CreateNoiseTexture(int texSize) {
+    if (m_noiseTexture && m_noiseSize == texSize) return true;
 
     m_noiseTexture.Reset();
     m_noiseSRV.Reset();
+    m_noiseUAV.Reset();
+    m_noiseSize = 0;
 
+    // Full mip chain, filled by GenerateMips from mip 0; the UAV lets the compute
+    // pass write mip 0 directly. Without typed UAV stores it is left off.
     D3D11_TEXTURE2D_DESC desc = {};
     desc.Width            = static_cast<UINT>(texSize);
     desc.Height           = static_cast<UINT>(texSize);
-    desc.MipLevels        = 1;
+    desc.MipLevels        = 0;
     desc.ArraySize        = 1;
     desc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
     desc.SampleDesc.Count = 1;
-    desc.Usage            = D3D11_USAGE_IMMUTABLE;
-    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET | D3D11_BIND_UNORDERED_ACCESS;
+    desc.MiscFlags        = D3D11_RESOURCE_MISC_GENERATE_MIPS;
 
-    D3D11_SUBRESOURCE_DATA initData = {};
-    initData.pSysMem     = pixels.data();
-    initData.SysMemPitch = static_cast<UINT>(texSize * 4);
+    HRESULT hr = m_device->CreateTexture2D(&desc, nullptr, &m_noiseTexture);
+    if (FAILED(hr)) {
+        desc.BindFlags &= ~D3D11_BIND_UNORDERED_ACCESS;
+        hr = m_device->CreateTexture2D(&desc, nullptr, &m_noiseTexture);
+        if (FAILED(hr)) return false;
+    }
 
-    HRESULT hr = m_device->CreateTexture2D(&desc, &initData, &m_noiseTexture);
-    if (FAILED(hr)) return false;
+    hr = m_device->CreateShaderResourceView(m_noiseTexture.Get(), nullptr, &m_noiseSRV);
+    if (FAILED(hr)) {
+        m_noiseTexture.Reset();
+        return false;
+    }
+    if (desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS) {
+        D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format             = desc.Format;
+        uavDesc.ViewDimension      = D3D11_UAV_DIMENSION_TEXTURE2D;
+        uavDesc.Texture2D.MipSlice = 0;
+        if (FAILED(m_device->CreateUnorderedAccessView(m_noiseTexture.Get(), &uavDesc, &m_noiseUAV)))
+            m_noiseUAV.Reset();
+    }
+    m_noiseSize = texSize;
+    return true;
+}
 
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format                    = desc.Format;
-    srvDesc.ViewDimension             = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels       = 1;
+bool D3D11Renderer::CreateNoiseVolume(int volumeSize) {
+    if (volumeSize <= 0) {
+        m_noiseVolume.Reset();
+        m_noiseVolumeSRV.Reset();
+        m_noiseVolumeUAV.Reset();
+        m_noiseVolumeSize = 0;
+        return true;
+    }
+    if (m_noiseVolume && m_noiseVolumeSize == volumeSize) return true;
+
+    m_noiseVolume.Reset();
+    m_noiseVolumeSRV.Reset();
+    m_noiseVolumeUAV.Reset();
+    m_noiseVolumeSize = 0;
+
+    D3D11_TEXTURE3D_DESC desc = {};
+    desc.Width     = static_cast<UINT>(volumeSize);
+    desc.Height    = static_cast<UINT>(volumeSize);
+    desc.Depth     = static_cast<UINT>(volumeSize);
+    desc.MipLevels = 0;
+    desc.Format    = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.Usage     = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET | D3D11_BIND_UNORDERED_ACCESS;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+    if (FAILED(m_device->CreateTexture3D(&desc, nullptr, &m_noiseVolume))) return false;
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format                = desc.Format;
+    uavDesc.ViewDimension         = D3D11_UAV_DIMENSION_TEXTURE3D;
+    uavDesc.Texture3D.MipSlice    = 0;
+    uavDesc.Texture3D.FirstWSlice = 0;
+    uavDesc.Texture3D.WSize       = static_cast<UINT>(volumeSize);
+    if (FAILED(m_device->CreateShaderResourceView(m_noiseVolume.Get(), nullptr, &m_noiseVolumeSRV)) ||
+        FAILED(m_device->CreateUnorderedAccessView(m_noiseVolume.Get(), &uavDesc, &m_noiseVolumeUAV))) {
+        m_noiseVolume.Reset();
+        m_noiseVolumeSRV.Reset();
+        m_noiseVolumeUAV.Reset();
+        return false;
+    }
+    m_noiseVolumeSize = volumeSize;
+    return true;
+}
 
-    hr = m_device->CreateShaderResourceView(m_noiseTexture.Get(), &srvDesc, &m_noiseSRV);
-    return SUCCEEDED(hr);
+bool D3D11Renderer::DispatchNoise(ComPtr<ID3D11ComputeShader>& shader, const char* source,
+                                  ID3D11UnorderedAccessView* uav, int size, int period, UINT groups, UINT groupsZ) {
+    if (!uav) return false;
+    if (!shader) {
+        std::string error;
+        if (!CompileComputeShader(std::string(g_noiseCommonSource) + source, shader, error)) return false;
+    }
+    if (!m_noiseConstantBuffer) {
+        D3D11_BUFFER_DESC cbDesc = {};
+        cbDesc.ByteWidth = 16;
+        cbDesc.Usage     = D3D11_USAGE_DEFAULT;
+        cbDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        if (FAILED(m_device->CreateBuffer(&cbDesc, nullptr, &m_noiseConstantBuffer))) return false;
+    }
+
+    const uint32_t constants[4] = { static_cast<uint32_t>(size), static_cast<uint32_t>(period),
+                                    static_cast<uint32_t>(NOISE_FBM_OCTAVES), 0 };
+    m_context->UpdateSubresource(m_noiseConstantBuffer.Get(), 0, nullptr, constants, 0, 0);
+
+    // t1 / t(NOISE_VOLUME_SLOT) are bound to the pixel stage; BeginFrame binds them again
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    m_context->PSSetShaderResources(1, 1, &nullSRV);
+    m_context->PSSetShaderResources(NOISE_VOLUME_SLOT, 1, &nullSRV);
+    m_context->CSSetShader(shader.Get(), nullptr, 0);
+    m_context->CSSetConstantBuffers(0, 1, m_noiseConstantBuffer.GetAddressOf());
+    m_context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+    m_context->Dispatch(groups, groups, groupsZ);
+
+    ID3D11UnorderedAccessView* nullUAV = nullptr;
+    ID3D11Buffer* nullCB = nullptr;
+    m_context->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+    m_context->CSSetConstantBuffers(0, 1, &nullCB);
+    m_context->CSSetShader(nullptr, nullptr, 0);
+    return true;
+}
+
+void D3D11Renderer::PrecompileNoiseShaders() {
+    for (const char* source : { g_noiseShaderSource, g_noiseVolumeShaderSource }) {
+        ComPtr<ID3D11ComputeShader> shader;
+        std::string error;
+        CompileComputeShader(std::string(g_noiseCommonSource) + source, shader, error);
+    }
+}
+
+bool D3D11Renderer::UpdateNoiseTexture(float scale, int texSize, int volumeSize) {
+    if (!m_device) return false;
+    texSize = (std::max)(texSize, 64);
+    // Whole lattice cells per side, so the texture tiles under the WRAP sampler
+    const int period = (std::max)(static_cast<int>(std::lround(scale)), 1);
+
+    // The textures are kept across calls of the same size; only their contents change
+    if (!CreateNoiseTexture(texSize)) return false;
+
+    // 8x8x1 threads per group
+    const UINT groups = static_cast<UINT>((texSize + 7) / 8);
+    if (!DispatchNoise(m_noiseCS, g_noiseShaderSource, m_noiseUAV.Get(), texSize, period, groups, 1)) {
+        // CPU fallback: Perlin in R, Voronoi in G (inverted so cells are bright
+        // centres), fBm of each in B/A
+        std::vector<uint8_t> pixels(static_cast<size_t>(texSize) * texSize * 4);
+
+        for (int y = 0; y < texSize; ++y) {
+            for (int x = 0; x < texSize; ++x) {
+                const float u = (x + 0.5f) / static_cast<float>(texSize);
+                const float v = (y + 0.5f) / static_cast<float>(texSize);
+
+                float perlin = 0.0f, voronoi = 0.0f, fbmPerlin = 0.0f, fbmVoronoi = 0.0f;
+                float amp = 1.0f, norm = 0.0f;
+                for (int o = 0; o < NOISE_FBM_OCTAVES; ++o) {
+                    const int   p  = period << o;
+                    const float po = perlinNoise(u * p, v * p, p);
+                    const float vo = 1.0f - voronoiNoise(u * p, v * p, p);  // invert: bright centres
+                    if (o == 0) {
+                        perlin  = po;
+                        voronoi = vo;
+                    }
+                    fbmPerlin  += amp * po;
+                    fbmVoronoi += amp * vo;
+                    norm += amp;
+                    amp  *= 0.5f;
+                }
+
+                uint8_t* px = &pixels[(static_cast<size_t>(y) * texSize + x) * 4];
+                px[0] = toUnorm8(perlin);              // R = Perlin
+                px[1] = toUnorm8(voronoi);             // G = Voronoi
+                px[2] = toUnorm8(fbmPerlin / norm);    // B = Perlin fBm
+                px[3] = toUnorm8(fbmVoronoi / norm);   // A = Voronoi fBm
+            }
+        }
+        m_context->UpdateSubresource(m_noiseTexture.Get(), 0, nullptr, pixels.data(),
+                                     static_cast<UINT>(texSize * 4), 0);
+    }
+    m_context->GenerateMips(m_noiseSRV.Get());
+
+    // The volume needs the compute path; without it t(NOISE_VOLUME_SLOT) samples as zero
+    // 4x4x4 threads per group
+    const UINT volumeGroups = static_cast<UINT>((volumeSize + 3) / 4);
+    if (CreateNoiseVolume(volumeSize) && m_noiseVolume &&
+        DispatchNoise(m_noiseVolumeCS, g_noiseVolumeShaderSource, m_noiseVolumeUAV.Get(), volumeSize,
+                      NOISE_VOLUME_PERIOD, volumeGroups, volumeGroups)) {
+        m_context->GenerateMips(m_noiseVolumeSRV.Get());
+    }
+
+    m_displayDirty = true;
+    return true;
 }
 
 void D3D11Renderer::SetAudioData(const AudioData* data) {
+    AudioConstants constants = {};
     if (data) {
-        m_audioConstants.rms              = data->rms;
-        m_audioConstants.bass             = data->bass;
-        m_audioConstants.mid              = data->mid;
-        m_audioConstants.high             = data->high;
-        m_audioConstants.beat             = data->beat;
-        m_audioConstants.spectralCentroid = data->spectralCentroid;
-    } else {
-        m_audioConstants = {};
+        constants.rms              = data->rms;
+        constants.bass             = data->bass;
+        constants.mid              = data->mid;
+        constants.high             = data->high;
+        constants.beat             = data->beat;
+        constants.spectralCentroid = data->spectralCentroid;
+        for (int ch = 0; ch < AUDIO_CHANNELS; ++ch) {
+            float* band = ch == 0 ? constants.left : constants.right;
+            band[0] = data->channelRms[ch];
+            band[1] = data->channelBass[ch];
+            band[2] = data->channelMid[ch];
+            band[3] = data->channelHigh[ch];
+        }
+        constants.stereoWidth = data->stereoWidth;
+        constants.bpm         = data->bpm;
+        constants.beatPhase   = data->beatPhase;
+        constants.barPhase    = data->barPhase;
+    }
+    constants.spectrogramNewest = m_audioConstants.spectrogramNewest;
+    constants.spectrogramCount  = m_audioConstants.spectrogramCount;
+    // Silence stays silence: no upload while nothing changes
+    if (memcmp(&constants, &m_audioConstants, sizeof(constants)) != 0) {
+        m_audioConstants      = constants;
+        m_audioConstantsDirty = true;
     }
+    static const float silence[AudioData::kSpectrumBins] = {};
+    const float* spectrum = data ? data->spectrum : silence;
+    if (memcmp(spectrum, m_spectrum, sizeof(m_spectrum)) != 0) {
+        memcpy(m_spectrum, spectrum, sizeof(m_spectrum));
+        m_spectrumDirty      = true;
+        m_spectrogramPending = true;
+    }
+    static const float flat[AudioData::kWaveformSamples][AUDIO_CHANNELS] = {};
+    const void* waveform = data ? data->waveform : flat;
+    if (memcmp(waveform, m_waveform, sizeof(m_waveform)) != 0) {
+        memcpy(m_waveform, waveform, sizeof(m_waveform));
+        m_waveformDirty = true;
+    }
+}
 
+// Skipped uploads stay dirty, so switching to a shader that reads audio
+// uploads the latest values before its first draw. The spectrogram only gets
+// the latest spectrum: rows that changed while no shader read it are dropped.
+void D3D11Renderer::UploadAudioData() {
+    ShaderBindings used = m_activeBindings;
+    used |= m_layerBindings;
+    used |= m_postBindings;
+    if (m_spectrogramPending && used.ReadsTexture(SPECTROGRAM_SLOT) && m_spectrogramTexture) {
+        const int row = (m_audioConstants.spectrogramNewest + 1) % SPECTROGRAM_ROWS;
+        const D3D11_BOX box = { 0, static_cast<UINT>(row), 0,
+                                AudioData::kSpectrumBins, static_cast<UINT>(row) + 1, 1 };
+        m_context->UpdateSubresource(m_spectrogramTexture.Get(), 0, &box, m_spectrum, sizeof(m_spectrum), 0);
+        m_audioConstants.spectrogramNewest = row;
+        m_audioConstants.spectrogramCount  = std::min(m_audioConstants.spectrogramCount + 1, SPECTROGRAM_ROWS);
+        m_audioConstantsDirty = true;
+        m_spectrogramPending  = false;
+    }
     D3D11_MAPPED_SUBRESOURCE mapped;
-    if (m_audioConstantBuffer &&
+    if (m_audioConstantsDirty && used.ReadsCBuffer(1) && m_audioConstantBuffer &&
         SUCCEEDED(m_context->Map(m_audioConstantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
         memcpy(mapped.pData, &m_audioConstants, sizeof(m_audioConstants));
         m_context->Unmap(m_audioConstantBuffer.Get(), 0);
+        m_audioConstantsDirty = false;
     }
-
-    if (m_spectrumTexture &&
+    if (m_spectrumDirty && used.ReadsTexture(3) && m_spectrumTexture &&
         SUCCEEDED(m_context->Map(m_spectrumTexture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
-        if (data) {
-            memcpy(mapped.pData, data->spectrum, AudioData::kSpectrumBins * sizeof(float));
-        } else {
-            memset(mapped.pData, 0, AudioData::kSpectrumBins * sizeof(float));
-        }
+        memcpy(mapped.pData, m_spectrum, sizeof(m_spectrum));
         m_context->Unmap(m_spectrumTexture.Get(), 0);
+        m_spectrumDirty = false;
+    }
+    if (m_waveformDirty && used.ReadsTexture(WAVEFORM_SLOT) && m_waveformTexture &&
+        SUCCEEDED(m_context->Map(m_waveformTexture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        memcpy(mapped.pData, m_waveform, sizeof(m_waveform));
+        m_context->Unmap(m_waveformTexture.Get(), 0);
+        m_waveformDirty = false;
+    }
+}
+
+void D3D11Renderer::SetFrameHistory(const FrameHistoryDesc& desc) {
+    if (desc.frames == m_historyDesc.frames && desc.scale == m_historyDesc.scale) return;
+    m_historyDesc = desc;
+    m_historyTexture.Reset();
+    m_historySRV.Reset();
+    m_historyRTVs.clear();
+    m_historyConstants = {};
+    m_historyConstants.frames = desc.frames;
+    m_historySerial = 0;  // Push the frame on screen at the next render
+    UpdateHistoryConstants();
+    if (m_context) {
+        ID3D11ShaderResourceView* nullSRV = nullptr;
+        m_context->PSSetShaderResources(FRAME_HISTORY_SLOT, 1, &nullSRV);
+    }
+    m_displayDirty = true;
+}
+
+void D3D11Renderer::SetVideoMips(bool enabled) {
+    if (enabled == m_videoMips) return;
+    m_videoMips = enabled;
+    if (!enabled) {
+        m_videoMipTexture.Reset();
+        m_videoMipSRV.Reset();
     }
+    m_videoMipSerial = 0;  // Build from the frame on screen at the next render
+    m_displayDirty = true;
+}
+
+void D3D11Renderer::UpdateHistoryConstants() {
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (m_historyConstantBuffer &&
+        SUCCEEDED(m_context->Map(m_historyConstantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        memcpy(mapped.pData, &m_historyConstants, sizeof(m_historyConstants));
+        m_context->Unmap(m_historyConstantBuffer.Get(), 0);
+    }
+}
+
+bool D3D11Renderer::PushFrameHistory() {
+    if (m_historyDesc.frames <= 0 || m_videoWidth <= 0 || m_historySerial == m_videoFrameSerial) return false;
+    ID3D11ShaderResourceView* videoSRV = GetActiveVideoSRV();
+    if (!videoSRV) return false;
+
+    ComPtr<ID3D11Resource> source;
+    videoSRV->GetResource(&source);
+    ComPtr<ID3D11Texture2D> sourceTexture;
+    if (FAILED(source.As(&sourceTexture))) return false;
+    D3D11_TEXTURE2D_DESC sourceDesc;
+    sourceTexture->GetDesc(&sourceDesc);
+
+    // Full size copies straight from t0; a downscaled ring is drawn into
+    const bool scaled = m_historyDesc.scale < 1.0f;
+    const int width  = scaled ? std::max(1, static_cast<int>(std::lround(m_videoWidth  * m_historyDesc.scale))) : m_videoWidth;
+    const int height = scaled ? std::max(1, static_cast<int>(std::lround(m_videoHeight * m_historyDesc.scale))) : m_videoHeight;
+    const DXGI_FORMAT format = scaled ? DXGI_FORMAT_R8G8B8A8_UNORM : sourceDesc.Format;
+
+    D3D11_TEXTURE2D_DESC ringDesc = {};
+    if (m_historyTexture) m_historyTexture->GetDesc(&ringDesc);
+    if (!m_historyTexture || ringDesc.Width != static_cast<UINT>(width) ||
+        ringDesc.Height != static_cast<UINT>(height) || ringDesc.Format != format) {
+        // (Re)create for this video size; the history starts over
+        ID3D11ShaderResourceView* nullSRV = nullptr;
+        m_context->PSSetShaderResources(FRAME_HISTORY_SLOT, 1, &nullSRV);
+        m_historyTexture.Reset();
+        m_historySRV.Reset();
+        m_historyRTVs.clear();
+        m_historyConstants.count = 0;
+
+        ringDesc = {};
+        ringDesc.Width            = static_cast<UINT>(width);
+        ringDesc.Height           = static_cast<UINT>(height);
+        ringDesc.MipLevels        = 1;
+        ringDesc.ArraySize        = static_cast<UINT>(m_historyDesc.frames);
+        ringDesc.Format           = format;
+        ringDesc.SampleDesc.Count = 1;
+        ringDesc.Usage            = D3D11_USAGE_DEFAULT;
+        ringDesc.BindFlags        = D3D11_BIND_SHADER_RESOURCE | (scaled ? D3D11_BIND_RENDER_TARGET : 0);
+        if (FAILED(m_device->CreateTexture2D(&ringDesc, nullptr, &m_historyTexture))) return false;
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format                         = format;
+        srvDesc.ViewDimension                  = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        srvDesc.Texture2DArray.MipLevels       = 1;
+        srvDesc.Texture2DArray.ArraySize       = ringDesc.ArraySize;
+        if (FAILED(m_device->CreateShaderResourceView(m_historyTexture.Get(), &srvDesc, &m_historySRV))) {
+            m_historyTexture.Reset();
+            return false;
+        }
+        for (int i = 0; scaled && i < m_historyDesc.frames; ++i) {
+            D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+            rtvDesc.Format                         = format;
+            rtvDesc.ViewDimension                  = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+            rtvDesc.Texture2DArray.FirstArraySlice = static_cast<UINT>(i);
+            rtvDesc.Texture2DArray.ArraySize       = 1;
+            ComPtr<ID3D11RenderTargetView> rtv;
+            if (FAILED(m_device->CreateRenderTargetView(m_historyTexture.Get(), &rtvDesc, &rtv))) {
+                m_historyTexture.Reset();
+                m_historySRV.Reset();
+                m_historyRTVs.clear();
+                return false;
+            }
+            m_historyRTVs.push_back(std::move(rtv));
+        }
+    }
+
+    const int slice = m_historyConstants.count > 0 ? (m_historyConstants.newest + 1) % m_historyDesc.frames : 0;
+    if (scaled) {
+        // The ring is bound at t16 while its slice is the target otherwise
+        ID3D11ShaderResourceView* nullSRV = nullptr;
+        m_context->PSSetShaderResources(FRAME_HISTORY_SLOT, 1, &nullSRV);
+        m_context->OMSetRenderTargets(1, m_historyRTVs[slice].GetAddressOf(), nullptr);
+        D3D11_VIEWPORT vp = {};
+        vp.Width    = static_cast<float>(width);
+        vp.Height   = static_cast<float>(height);
+        vp.MaxDepth = 1.0f;
+        m_context->RSSetViewports(1, &vp);
+        m_pipelineState.SetPixelShader(m_passthroughPS.Get());
+        m_context->PSSetShaderResources(0, 1, &videoSRV);
+        m_context->Draw(3, 0);
+        m_context->OMSetRenderTargets(0, nullptr, nullptr);
+        m_pipelineState.SetPixelShader(m_activePS.Get());
+    } else {
+        const D3D11_BOX box = { 0, 0, 0, std::min(static_cast<UINT>(width), sourceDesc.Width),
+                                std::min(static_cast<UINT>(height), sourceDesc.Height), 1 };
+        m_context->CopySubresourceRegion(m_historyTexture.Get(), D3D11CalcSubresource(0, static_cast<UINT>(slice), 1),
+                                         0, 0, 0, sourceTexture.Get(), 0, &box);
+    }
+    m_context->PSSetShaderResources(FRAME_HISTORY_SLOT, 1, m_historySRV.GetAddressOf());
+
+    m_historyConstants.newest = slice;
+    m_historyConstants.count  = std::min(m_historyConstants.count + 1, m_historyDesc.frames);
+    m_historyConstants.frames = m_historyDesc.frames;
+    m_historySerial = m_videoFrameSerial;
+    UpdateHistoryConstants();
+    return true;
+}
+
+bool D3D11Renderer::PushVideoMips() {
+    if (!m_videoMips || m_videoWidth <= 0 || m_videoMipSerial == m_videoFrameSerial) return false;
+    ID3D11ShaderResourceView* videoSRV = GetSourceVideoSRV();
+    if (!videoSRV) return false;
+
+    ComPtr<ID3D11Resource> source;
+    videoSRV->GetResource(&source);
+    ComPtr<ID3D11Texture2D> sourceTexture;
+    if (FAILED(source.As(&sourceTexture))) return false;
+    D3D11_TEXTURE2D_DESC sourceDesc;
+    sourceTexture->GetDesc(&sourceDesc);
+
+    D3D11_TEXTURE2D_DESC mipDesc = {};
+    if (m_videoMipTexture) m_videoMipTexture->GetDesc(&mipDesc);
+    if (!m_videoMipTexture || mipDesc.Width != sourceDesc.Width || mipDesc.Height != sourceDesc.Height ||
+        mipDesc.Format != sourceDesc.Format) {
+        m_videoMipTexture.Reset();
+        m_videoMipSRV.Reset();
+        // Typeless and some packed sources can't generate mips: t0 stays as it is
+        UINT support = 0;
+        if (FAILED(m_device->CheckFormatSupport(sourceDesc.Format, &support)) ||
+            !(support & D3D11_FORMAT_SUPPORT_MIP_AUTOGEN)) {
+            return false;
+        }
+        mipDesc = {};
+        mipDesc.Width            = sourceDesc.Width;
+        mipDesc.Height           = sourceDesc.Height;
+        mipDesc.MipLevels        = 0;  // Full chain down to 1x1
+        mipDesc.ArraySize        = 1;
+        mipDesc.Format           = sourceDesc.Format;
+        mipDesc.SampleDesc.Count = 1;
+        mipDesc.Usage            = D3D11_USAGE_DEFAULT;
+        mipDesc.BindFlags        = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;  // GenerateMips needs both
+        mipDesc.MiscFlags        = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+        if (FAILED(m_device->CreateTexture2D(&mipDesc, nullptr, &m_videoMipTexture))) return false;
+        if (FAILED(m_device->CreateShaderResourceView(m_videoMipTexture.Get(), nullptr, &m_videoMipSRV))) {
+            m_videoMipTexture.Reset();
+            return false;
+        }
+    }
+
+    // Top level from t0, then the rest of the chain from it on the GPU
+    m_context->CopySubresourceRegion(m_videoMipTexture.Get(), 0, 0, 0, 0, sourceTexture.Get(), 0, nullptr);
+    m_context->GenerateMips(m_videoMipSRV.Get());
+    // BeginFrame bound the source at t0
+    m_context->PSSetShaderResources(0, 1, m_videoMipSRV.GetAddressOf());
+    m_videoMipSerial = m_videoFrameSerial;
+    return true;
 }
 
 } // namespace SP
@@ -1,6 +1,21 @@
 #pragma once
 
 #include "Common.h"
+#include "ColorLut.h"
+#include "FramePool.h"
+#include "PipelineStateCache.h"
+#include <d3d11_1.h>
+#include <dxgi1_6.h>
+#include "GpuProfiler.h"
+#include "RenderTargetPool.h"
+#include "ScrubCache.h"
+#include "LoopCache.h"
+#include "RenderAheadQueue.h"
+#include "MemoryUsage.h"
+#include "ShaderCache.h"
+#include "ShaderIncludes.h"
+#include "TextureUploadRing.h"
+#include "VideoProcessorConverter.h"
 
 namespace SP {
 
@@ -13,30 +28,261 @@ public:
     D3D11Renderer(const D3D11Renderer&) = delete;
     D3D11Renderer& operator=(const D3D11Renderer&) = delete;
 
-    // Initialization
+    // Initialization. A null hwnd is headless (batch rendering): no swap chain,
+    // BeginFrame targets an offscreen texture of width x height and Present does
+    // nothing; everything else, display texture and readback included, is the same.
     bool Initialize(HWND hwnd, int width, int height);
     void Shutdown();
     bool IsInitialized() const { return m_device != nullptr; }
 
+    // GPU choice, before Initialize. Empty picks the high-performance adapter
+    // (IDXGIFactory6::EnumAdapterByGpuPreference: the discrete GPU of a hybrid
+    // laptop); a name from ListAdapters picks that one, falling back to high
+    // performance when it is missing or fails to create a device. Decode,
+    // shading and encode all share the device, so frames never cross adapters;
+    // DXGI copies to the iGPU-driven display itself. ListAdapters skips software
+    // adapters and is high-performance first where DXGI 1.6 is available.
+    void SetPreferredAdapter(const std::string& name) { m_preferredAdapter = name; }
+    static std::vector<AdapterInfo> ListAdapters();
+    const std::string& GetAdapterName() const { return m_adapterName; }  // The device's, after Initialize
+    // Shared bytecode cache directory behind shader_cache/ (ShaderBytecodeCache),
+    // before Initialize. Empty = local cache only.
+    void SetSharedShaderCache(const std::string& directory) { m_sharedShaderCache = directory; }
+
     // Resize handling
     bool Resize(int width, int height);
 
     // Frame operations
     void BeginFrame();
     void EndFrame();
+    // vsync false presents immediately; with IsTearingSupported it also tears
+    // (DXGI_PRESENT_ALLOW_TEARING), which drives G-Sync/FreeSync displays at the
+    // present rate instead of waiting for the compositor's next refresh
     void Present(bool vsync = true);
+    bool IsTearingSupported() const { return m_tearingSupported; }
+    // DXGI reported the window as not visible on the last Present. TestOccluded
+    // asks again without presenting, for ticks that skip Present.
+    bool IsOccluded() const { return m_occluded; }
+    bool TestOccluded();
+
+    // Frame pacing. The swap chain is created with a frame-latency waitable object;
+    // WaitForFrameLatency blocks until it can queue another frame, so whatever the
+    // loop samples after the wait (input, audio, uniforms) is at most `frames`
+    // presents from the screen. 1 = low latency, 2 = one frame of slack for
+    // uneven frame times. No-op headless, or when nothing was presented since the
+    // last wait (export ticks); false on timeout.
+    void SetMaximumFrameLatency(int frames);
+    int  GetMaximumFrameLatency() const { return m_maxFrameLatency; }
+    bool WaitForFrameLatency(DWORD timeoutMs = 100);
 
-    // Video frame upload
+    // Video frame upload. Hardware frames (frame.hwTexture set) and native YUV
+    // planes (frame.layout != RGBA8) are converted into the t0 video texture on
+    // the GPU; RGBA8 frames are copied straight in.
     bool UploadVideoFrame(const VideoFrame& frame);
+    // Generation of the frame in the t0 texture (0 = none, or a scrub-cache frame).
+    // A frame with this generation is already uploaded.
+    uint64_t GetVideoGeneration() const { return m_videoGeneration; }
+
+    // Extra video inputs (RGBA8 frames only), bound at t(FIRST_INPUT_SLOT + index)
+    // for every shader that samples them. Release unbinds the slot.
+    // Skips the copy when the frame's generation is already in the texture, or
+    // when the active shader doesn't sample the input.
+    bool UploadInputFrame(int index, const VideoFrame& frame);
+    void ReleaseInputTexture(int index);
+
+    // Colour LUTs (ISF "lut" INPUTS) as Texture3D at t(FIRST_LUT_SLOT + index);
+    // null releases the slot.
+    bool SetLut(int index, const ColorLut* lut);
+    // LUT bakes, in two steps so neither waits on the GPU. BeginLutBake runs the
+    // active shader over an identity lattice in place of t0 and queues the
+    // result's copy to staging; PollLutBake reads it back as a `size`³ LUT once
+    // the copy has landed. Only meaningful for presets that map each pixel's
+    // colour alone. BeginLutBake leaves the pipeline for BeginFrame to restore.
+    struct LutBake {
+        ComPtr<ID3D11Texture2D> staging;
+        int size = 0;  // 0 = none in flight
+    };
+    enum class LutBakeStatus { Pending, Done, Failed };
+    bool BeginLutBake(int size, LutBake& bake);
+    LutBakeStatus PollLutBake(LutBake& bake, ColorLut& out);  // Done or Failed clear `bake`
+
+    // Scrub and loop caches. CacheVideoFrame copies the just-uploaded video texture
+    // into both; ShowCachedVideoFrame binds a cached frame at t0 instead (until the
+    // next UploadVideoFrame), trying the loop cache first, and returns false on a miss.
+    void CacheVideoFrame(int64_t key);
+    bool ShowCachedVideoFrame(int64_t key);
+    ScrubCache&       GetScrubCache() { return m_scrubCache; }
+    const ScrubCache& GetScrubCache() const { return m_scrubCache; }
+    LoopCache&        GetLoopCache() { return m_loopCache; }
+    const LoopCache&  GetLoopCache() const { return m_loopCache; }
+
+    // Render-ahead (Application::FillRenderAhead). PushRenderAhead copies the
+    // just-uploaded video texture and the display texture RenderToDisplay drew
+    // from it into the queue. ShowRenderAheadSource binds an entry's t0 copy
+    // instead (until the next upload) so it can be drawn again, and
+    // StoreRenderAhead keeps that drawing. PresentRenderAhead copies the front
+    // entry into the display texture for the outputs; false (display left as
+    // is) when it is stale or the display size or format changed. Shader changes
+    // and a display reallocation mark the queue stale.
+    bool PushRenderAhead(double timestamp, bool loopStart);
+    bool ShowRenderAheadSource(int index);
+    bool StoreRenderAhead(int index);
+    bool PresentRenderAhead();
+    RenderAheadQueue&       GetRenderAhead() { return m_renderAhead; }
+    const RenderAheadQueue& GetRenderAhead() const { return m_renderAhead; }
     
     // Shader management
-    bool CompilePixelShader(const std::string& hlslSource, ComPtr<ID3D11PixelShader>& outShader, std::string& outError);
-    void SetActivePixelShader(ID3D11PixelShader* shader);
+    // outTimeVarying (optional) is set from shader reflection: true when the shader
+    // reads `time`, the audio cbuffer or the spectrum texture. outBindings
+    // (optional) gets the t and b registers the shader reads, outCost (optional)
+    // its static cost. `includes` serves the source's #include lines and is part
+    // of the cache key; without it they fail.
+    bool CompilePixelShader(const std::string& hlslSource, ComPtr<ID3D11PixelShader>& outShader,
+                            std::string& outError, bool* outTimeVarying = nullptr,
+                            ShaderBindings* outBindings = nullptr, ShaderCost* outCost = nullptr,
+                            const ShaderIncludes* includes = nullptr);
+    bool CompileComputeShader(const std::string& hlslSource, ComPtr<ID3D11ComputeShader>& outShader,
+                              std::string& outError, bool* outTimeVarying = nullptr,
+                              ShaderBindings* outBindings = nullptr, ShaderCost* outCost = nullptr,
+                              const ShaderIncludes* includes = nullptr);
+    // A time-invariant shader is only redrawn by RenderToDisplay when its inputs
+    // (textures, uniforms, display size) change.
+    void SetActivePixelShader(ID3D11PixelShader* shader, bool timeVarying = true);
     ID3D11PixelShader* GetPassthroughShader() const { return m_passthroughPS.Get(); }
+    // What the active shader (every pass or kernel) reads: audio, spectrum, noise,
+    // history and extra inputs nobody reads are neither uploaded nor bound. Each
+    // SetActive* call resets it to everything (the passthrough's own for null).
+    void SetActiveBindings(const ShaderBindings& bindings) { m_activeBindings = bindings; }
+
+    // Multi-pass presets (ISF PASSES): the preset's shader compiled once per pass.
+    // `reads` has bit N set when the pass samples pass N's target, so each target
+    // lives from its pass to its last reader and then goes back to the pool for
+    // later passes. The last pass draws where a single shader would. Replaces the
+    // active shader; SetActivePixelShader drops the graph. Persistent passes
+    // (RenderPassDesc::persistent) keep their own ping-pong buffers instead of
+    // pooled targets; ResetPersistentTargets clears them back to zero.
+    struct RenderGraphPass {
+        ComPtr<ID3D11PixelShader> shader;
+        RenderPassDesc desc;
+        uint32_t reads = 0;
+    };
+    void SetActiveRenderGraph(std::vector<RenderGraphPass> passes, bool timeVarying);
+    void ResetPersistentTargets();
+    const RenderTargetPool& GetTargetPool() const { return m_targetPool; }
 
-    // Render to texture (for recording)
-    bool RenderToTexture();
-    bool CopyRenderTargetToStaging(std::vector<uint8_t>& outData, int& outWidth, int& outHeight);
+    // Memory accounting. QueryVideoMemory reads the adapter's budgets (zeros before
+    // WDDM 2.0); TakeVideoMemoryBudgetChange is true once per OS budget-change
+    // notification since the last call. ShrinkCaches frees up to `bytes` of VRAM
+    // held as caches, recycled targets first, then scrub cache entries, and
+    // returns what it freed; the scrub cache keeps the smaller budget until
+    // SetBudgetMB is called again. The loop cache is the caller's (Application
+    // re-arms it). GetMemoryUsage appends the renderer's pools and caches.
+    VideoMemoryInfo QueryVideoMemory() const;
+    bool TakeVideoMemoryBudgetChange();
+    uint64_t ShrinkCaches(uint64_t bytes);
+    void GetMemoryUsage(std::vector<MemoryUsage>& out) const;
+    int GetRenderGraphPassCount() const { return static_cast<int>(m_graphPasses.size()); }
+    const RenderPassDesc& GetRenderGraphPass(int pass) const { return m_graphPasses[pass].desc; }
+    // Keeps a copy of pass `pass`'s output (not the last; -1 = none) in an RGBA8
+    // texture at the pass's size each time the graph draws, for outputs that
+    // send an intermediate node. GetTapSRV is null while the active graph has no
+    // such pass or has not drawn since.
+    void SetTapPass(int pass);
+    ID3D11ShaderResourceView* GetTapSRV() const { return m_tapDrawn ? m_tapTarget.srv.Get() : nullptr; }
+
+    // Compute presets (ComputeDesc): the kernels run in order into a UAV output
+    // texture at the render size, which is then drawn where a pixel shader would
+    // draw. Structured buffers are created zeroed here and kept until the next
+    // SetActive* call. The pixel shader paths drop the kernels.
+    struct ComputeKernel {
+        ComPtr<ID3D11ComputeShader> shader;
+        ComputeDispatch dispatch;
+    };
+    // ComputeDrawDesc's shaders. After the kernels the draw buffer's elements are
+    // drawn instanced (one instance per element, 1 or 6 vertices) into the
+    // output, with no input layout: pointVS reads SV_InstanceID and SV_VertexID.
+    struct PointDraw {
+        ComPtr<ID3D11VertexShader> vertexShader;
+        ComPtr<ID3D11PixelShader>  pixelShader;
+    };
+    // Compiles `pointVS` (vs_5_0) and `pointPS` (ps_5_0) from a compute preset's
+    // source; bindings and cost are both shaders' together
+    bool CompilePointDraw(const std::string& hlslSource, PointDraw& out, std::string& outError,
+                          ShaderBindings* outBindings = nullptr, ShaderCost* outCost = nullptr,
+                          const ShaderIncludes* includes = nullptr);
+    // A compute preset's u1.. buffers and the texture its kernels write (u0),
+    // sized on dispatch. The active preset has one; so does each compute stage
+    // of a post chain.
+    struct ComputeState {
+        struct Buffer {
+            ComPtr<ID3D11Buffer>              buffer;
+            ComPtr<ID3D11UnorderedAccessView> uav;
+            ComPtr<ID3D11ShaderResourceView>  srv;  // Point draws only
+        };
+        std::vector<Buffer>               buffers;
+        ComPtr<ID3D11Texture2D>           output;
+        ComPtr<ID3D11UnorderedAccessView> outputUAV;
+        ComPtr<ID3D11ShaderResourceView>  outputSRV;
+        ComPtr<ID3D11RenderTargetView>    outputRTV;    // Point draws only
+        ComPtr<ID3D11Buffer>              drawArgs;     // DrawInstancedIndirect args, reset each frame
+        ComPtr<ID3D11UnorderedAccessView> drawArgsUAV;  // Raw, at u(DRAW_ARGS_UAV)
+    };
+    void SetActiveCompute(std::vector<ComputeKernel> kernels, PointDraw points, const ComputeDesc& desc,
+                          bool timeVarying);
+    // Other shaders for the active graph or kernels (a SPECIALIZE variant of the
+    // same preset): persistent targets and compute buffers are kept. False, with
+    // nothing changed, when the pass or kernel count differs.
+    bool SwapRenderGraphShaders(const std::vector<RenderGraphPass>& passes, bool timeVarying);
+    bool SwapComputeKernels(const std::vector<ComputeKernel>& kernels, const PointDraw& points, bool timeVarying);
+
+    // Prewarm. Drivers finish translating a shader for the GPU on its first draw,
+    // a hitch on the frame it goes live. These draw a shader once into a 1x1
+    // target of the format it will draw into (a kernel: one thread group into a
+    // 1x1 UAV), so that happens on a frame of the caller's choosing. After
+    // BeginFrame; the backbuffer target, viewport and active shader are restored.
+    void PrewarmPixelShader(ID3D11PixelShader* shader, PassFormat format);
+    void PrewarmComputeShader(ID3D11ComputeShader* shader, PassFormat format);
+
+    // Recording readback, pipelined over a ring of staging textures so the CPU
+    // maps a frame the GPU finished copying a couple of frames ago instead of
+    // stalling on the one it just drew. QueueReadback copies the display texture
+    // (call after RenderToDisplay: the shader runs once for preview and recording)
+    // into the next free slot (false when all slots are in flight); SetReadbackSource
+    // replaces the display texture here and in ConvertToNv12. CollectReadback
+    // returns the oldest queued frame once its copy has completed, or blocks for
+    // it when `wait` is set; frames come out in queue order.
+    // With a YUV layout the display texture is converted on the GPU first, so the
+    // block is the encoder's planar format (1.5-2 bytes/pixel instead of 4).
+    void SetReadbackLayout(ReadbackLayout layout);  // Falls back to RGBA8 on failure
+    ReadbackLayout GetReadbackLayout() const { return m_readbackLayout; }
+    // Size of the frames QueueReadback produces: the recording size, 0x0 = the
+    // source's. Another size is resampled on the GPU before the copy (an area
+    // filter when shrinking, Catmull-Rom when enlarging), so a smaller recording
+    // reads back proportionally fewer bytes and the encoder never runs swscale
+    // to resize.
+    void SetReadbackSize(int width, int height);
+    bool QueueReadback();
+    bool CollectReadback(FramePool& pool, FrameBuffer& outData, int& outWidth, int& outHeight,
+                         ReadbackLayout& outLayout, bool wait);
+    void DiscardReadbacks();  // Forget queued frames (new recording)
+    // Hardware encoding: converts the display texture to BT.709 NV12 straight into
+    // slice `slice` of an encoder surface array (render-target NV12), scaled to
+    // its size. No readback; the draws are flushed for the encoder thread.
+    bool ConvertToNv12(ID3D11Texture2D* target, int slice);
+    // Virtual camera: `source` (null = the display texture) as BT.709 NV12 into
+    // the plane views of an NV12 render target (R8 luma, R8G8 CbCr) of
+    // `width` x `height`, scaled by the sampler. Not flushed.
+    bool ConvertToNv12(ID3D11ShaderResourceView* source, ID3D11RenderTargetView* luma,
+                       ID3D11RenderTargetView* chroma, int width, int height);
+    // Network output: `source` (null = the display texture) as BT.709 UYVY 4:2:2
+    // at `width` x `height` (even width), drawn into an R8G8B8A8_UNORM target of
+    // width/2 texels whose bytes are the packed U Y0 V Y1 stream, so a readback
+    // is half the RGBA size.
+    bool ConvertToUyvy(ID3D11ShaderResourceView* source, ID3D11RenderTargetView* target, int width, int height);
+    bool IsReadbackRingFull() const { return m_readbackCount == READBACK_SLOTS; }
+    int  GetPendingReadbacks() const { return m_readbackCount; }
+    // Frames recorded after the last collected one before it was mapped (0 = synchronous)
+    int  GetReadbackLatency() const { return m_readbackLatency; }
 
     // Render to display texture (for ImGui::Image preview)
     void RenderToDisplay();
@@ -44,41 +290,280 @@ public:
     ID3D11Texture2D*          GetDisplayTexture() const { return m_displayTexture.Get(); }
     int GetDisplayWidth()  const { return m_displayWidth; }
     int GetDisplayHeight() const { return m_displayHeight; }
+    DXGI_FORMAT GetDisplayFormat() const { return m_displayFormat; }  // RGBA8, or RGBA16 (SetHighBitDepth)
+    int64_t GetSkippedRedraws() const { return m_skippedRedraws; }  // Frames the display texture was reused
+    // The next RenderToDisplay draws even if nothing changed (benchmarks time every frame)
+    void InvalidateDisplay() { m_displayDirty = true; }
+    // Bumped each time RenderToDisplay draws; unchanged while it reuses the texture
+    uint64_t GetDisplayGeneration() const { return m_displayGeneration; }
 
     // Blit the already-processed display texture into an external RTV (e.g. a second
-    // swap chain window).  Restores the main backbuffer RT and active PS afterwards.
+    // swap chain window), through the upscaler when the RTV is larger. Restores the main
+    // backbuffer RT and active PS afterwards.
     void BlitDisplayTo(ID3D11RenderTargetView* rtv, int width, int height);
+    // A bilinear blit of any texture (GetTapSRV, ...), scaled to the RTV's size.
+    // `shader` replaces the bilinear passthrough (a resampling filter).
+    void BlitTo(ID3D11ShaderResourceView* srv, ID3D11RenderTargetView* rtv, int width, int height,
+                ID3D11PixelShader* shader = nullptr);
+    // BlitTo through the upscaler (SetUpscaler) when the RTV is larger than `srv`
+    void UpscaleTo(ID3D11ShaderResourceView* srv, ID3D11RenderTargetView* rtv, int width, int height);
+    // One window's share of a canvas: `region` of the texture, edge-blended and
+    // keystone-warped into the RTV. Black outside the warped quad.
+    void BlitRegionTo(ID3D11ShaderResourceView* srv, ID3D11RenderTargetView* rtv, int width, int height,
+                      const CanvasRegion& region);
+
+    // Per-output post chains: presets drawn over a finished frame (the display
+    // texture, a tapped pass) for one output only, so scopes and guides reach
+    // the operator's monitor without reaching the projector or the recording,
+    // and run at that output's size. Each stage samples the previous result at
+    // t0 with videoResolution its size; a compute stage dispatches into its own
+    // output and buffers. The chain redraws only when the display did, the
+    // source, size, stages or their values changed, or a stage reads time.
+    // Call after RenderToDisplay; the backbuffer target, viewport, active shader,
+    // t0 and b0 are restored. The caller keeps one PostChain per output.
+    struct PostStage {
+        ComPtr<ID3D11PixelShader>  shader;   // Single-pass preset, or
+        std::vector<ComputeKernel> kernels;  // a compute preset's kernels
+        PointDraw                  points;   // and its point draw
+        ComputeDesc    compute;
+        ShaderBindings bindings;
+        bool  timeVarying = true;
+        float custom[16]  = {};              // The preset's b0 custom[] values
+        std::vector<float> params;           // Its spParams[] (b5); empty for most presets
+    };
+    struct PostChain {
+        // The last draw; valid until the next RunPostChain or ReleasePostChain
+        ID3D11ShaderResourceView* result = nullptr;
+        uint64_t generation = 0;  // Changes each time the chain draws (never equals a display generation)
+
+        struct Drawn {
+            ID3D11PixelShader*   shader = nullptr;
+            ID3D11ComputeShader* kernel = nullptr;  // The first
+            float custom[16] = {};
+            std::vector<float> params;
+        };
+        RenderTargetPool::Target  targets[2];  // Ping-pong: stage N draws into targets[N % 2]
+        std::vector<ComputeState> compute;     // Per stage
+        std::vector<Drawn>        drawn;
+        ID3D11ShaderResourceView* source = nullptr;
+        uint64_t sourceGeneration = 0;
+    };
+    // The chain's result, or `source` itself when `stages` is empty (the chain
+    // is released) or a stage failed. `sourceGeneration` tells a new source frame
+    // from the last one; 0 = the display's generation (the source is derived from it).
+    ID3D11ShaderResourceView* RunPostChain(PostChain& chain, const std::vector<PostStage>& stages,
+                                           ID3D11ShaderResourceView* source, int width, int height,
+                                           uint64_t sourceGeneration = 0);
+    void ReleasePostChain(PostChain& chain);  // Targets back to the pool
+    // What every chain's stages read besides t0, bound by BeginFrame with the
+    // active shader's (as for layers)
+    void SetPostBindings(const ShaderBindings& bindings) { m_postBindings = bindings; }
+    // Recording reads this instead of the display texture while set (the
+    // recording output's chain result, at the display size); null = the display
+    void SetReadbackSource(ID3D11ShaderResourceView* srv) { m_readbackSource = srv; }
+
+    // GPU timestamps per stage. The renderer brackets upload, shader, compositor,
+    // display and readback itself; the caller brackets the frame and its outputs.
+    GpuProfiler&       GetGpuProfiler() { return m_gpuProfiler; }
+    const GpuProfiler& GetGpuProfiler() const { return m_gpuProfiler; }
 
     // Shader uniforms
     void SetShaderTime(float time);
     void SetShaderResolution(float width, float height);
     void SetCustomUniforms(const float* data, size_t floatCount);
+    // The active preset's params past custom[16] (ShaderManager::PackExtendedParams),
+    // bound at b(PARAM_CBUFFER) for shaders that read it. Each draw uploads only
+    // the float4 range that differs from what the buffer holds.
+    void SetExtendedParams(const float* data, size_t floatCount);
+    int64_t GetParamBytesUploaded() const { return m_paramBytesUploaded; }
 
-    // Noise texture — generates Perlin (R) + Voronoi (G) into a tiling texture
-    // bound globally as t1 / s1 for all pixel shaders.
-    bool UpdateNoiseTexture(float scale, int texSize);
+    // Noise set — Perlin (R), Voronoi (G) and their fBm (B/A) in a tiling, mip-mapped
+    // texture bound globally as t1 / s1, and an optional tiling 3D volume of
+    // Perlin (R) and its fBm (G) at t(NOISE_VOLUME_SLOT), `volumeSize` texels per
+    // side (0 = none). A compute pass writes them when the device has typed UAV
+    // stores; otherwise the CPU fills the texture and there is no volume.
+    bool UpdateNoiseTexture(float scale, int texSize, int volumeSize = 0);
+    // Any thread: compiles the noise kernels into the bytecode cache, so the
+    // first UpdateNoiseTexture after it only creates them
+    void PrecompileNoiseShaders();
     ID3D11ShaderResourceView* GetNoiseSRV() const { return m_noiseSRV.Get(); }
 
-    // Audio data — cbuffer b1 + spectrum texture t3 (1×256 R32_FLOAT).
-    // Pass nullptr to zero both (used when no audio is available).
+    // Audio data — cbuffer b1, spectrum texture t3 (1×256 R32_FLOAT), the
+    // spectrogram ring t17 and the waveform t18 (512×1 R32G32_FLOAT, L/R).
+    // Pass nullptr to zero both (used when no audio is available). Uploaded by
+    // BeginFrame, and only while the active shader reads them.
     void SetAudioData(const AudioData* data);
 
+    // Frame history (ISF FRAME_HISTORY): the last N video frames in a
+    // Texture2DArray ring at t(FRAME_HISTORY_SLOT), with the newest slice and the
+    // fill count in cbuffer b(FRAME_HISTORY_CBUFFER). Each new frame costs one
+    // CopySubresourceRegion, or one passthrough draw into its slice when the
+    // ring is downscaled. Frames 0 frees the ring; the same desc keeps it.
+    void SetFrameHistory(const FrameHistoryDesc& desc);
+
+    // ISF VIDEO_MIPS: t0 becomes a copy of the video with a full mip chain,
+    // rebuilt with GenerateMips once per new frame, so wide-radius effects can
+    // SampleLevel a coarse mip instead of taking hundreds of taps. False frees it.
+    void SetVideoMips(bool enabled);
+
     // Release video texture and reset video dimensions to zero.
-    // Must be called when a video is closed so RenderToTexture/RenderToDisplay
-    // fall back to generative resolution rather than stale video dimensions.
+    // Must be called when a video is closed so RenderToDisplay
+    // falls back to generative resolution rather than stale video dimensions.
     void ReleaseVideoTexture();
 
+    // A texture from outside the decoder (SpoutInput) as t0, at its own size and
+    // format, bound as is. Call again for each new frame in it; ReleaseVideoTexture
+    // or ClearExternalVideo drops it.
+    void SetExternalVideo(ID3D11ShaderResourceView* srv, int width, int height);
+    void ClearExternalVideo();
+
+    // Hardware frames: convert and scale NV12/P010 surfaces on the fixed-function
+    // video processor instead of the YUV shader pass. Falls back to the shader
+    // pass per frame when the driver can't (IsVideoProcessorAvailable false, BT.2020
+    // before Windows 10, unsupported sizes).
+    void SetVideoProcessorConversion(bool enabled) { m_useVideoProcessor = enabled; }
+    bool IsVideoProcessorAvailable() const { return m_videoProcessor.IsAvailable(); }
+    bool IsVideoProcessorActive() const { return m_videoProcessorActive; }  // Last hardware frame used it
+
     // Generative resolution — used as the render target size when no video is loaded.
     void SetGenerativeResolution(int width, int height);
     int GetGenerativeWidth()  const { return m_generativeWidth; }
     int GetGenerativeHeight() const { return m_generativeHeight; }
 
+    // Dynamic resolution: the active shader (every pass) draws at this fraction
+    // of the render size and is upscaled (SetUpscaler) into the display texture.
+    // The compositor, readback and outputs still run at full size. 1 = off.
+    void  SetRenderScale(float scale);
+    float GetRenderScale() const { return m_renderScale; }
+    // Filter of every upscale: the reduced-size pass above, readbacks larger than
+    // the display texture and UpscaleTo. UPSCALE_*; `sharpness` [0, 1] is the RCAS
+    // pass after edge-adaptive upscaling (0 = none). A filter that failed to
+    // compile falls back to bicubic.
+    void SetUpscaler(int filter, float sharpness);
+    int  GetUpscaleFilter() const { return m_upscaleFilter; }
+
+    // High bit depth: 10/12-bit frames (P010 surfaces, planar 4:2:0/4:2:2/4:4:4
+    // from ProRes, HEVC, DNxHR) convert into an R16G16B16A16_UNORM video texture,
+    // and while one is at t0 the display texture and the targets feeding it use
+    // the same format, so a YUV422P10 recording keeps its 10 bits. Off = every
+    // source lands in RGBA8 as before. Applies from the next uploaded frame.
+    void SetHighBitDepth(bool enabled) { m_highBitDepth = enabled; }
+    bool IsHighBitDepth() const { return m_highBitDepth; }
+
+    // Tiled rendering for canvases too heavy to draw in one go (LED walls). With
+    // a tile size, each draw of the active shader or a graph pass over a larger
+    // target is split into scissor rectangles of at most tileSize², each its own
+    // submission, so the GPU can preempt between them and no single one trips
+    // the TDR watchdog. The viewport stays the whole target: uv and `resolution`
+    // are the full canvas's. tilesPerFrame > 0 spreads a single-pass shader's
+    // tiles over ticks instead; they collect in a separate target with the
+    // constants of the sweep's first tick, and the display texture (and its
+    // generation) changes only when the last tile is in. Compute kernels are not
+    // tiled. 0 = off.
+    static constexpr int MIN_TILE_SIZE = 256;
+    void SetTiling(int tileSize, int tilesPerFrame);
+    int  GetTileCount() const;  // Of the current render size; 1 when untiled
+    int  GetSweepProgress() const { return m_sweeping ? m_sweepNext : 0; }  // Tiles of the pending sweep drawn
+
+    // Temporal supersampling, for exports: each display draw becomes `samples`
+    // sub-frames spread over `shutterSeconds` of shader time centred on the
+    // frame's, each at a Halton(2, 3) sub-pixel offset of the final draw,
+    // added with weight 1/samples into one R16G16B16A16_FLOAT target and
+    // resolved into the display texture once. Motion blur and anti-aliasing
+    // without rendering at a multiple of the size. Not applied to presets with
+    // persistent passes or compute kernels, whose state would step per
+    // sub-frame. 1 = off.
+    static constexpr int MAX_TEMPORAL_SAMPLES = 64;
+    void SetTemporalSupersampling(int samples, float shutterSeconds);
+    int  GetTemporalSamples() const { return m_temporalSamples; }
+
+    // One tile of a canvas larger than a texture may be (up to MAX_CANVAS_SIZE,
+    // the viewport bound): the active shader drawn through a viewport of the
+    // whole canvas shifted so (x, y) lands at the tile's origin, at `time`
+    // seconds (the same for every tile of a still) and with `resolution` set
+    // to the canvas, read back as tightly packed RGBA.
+    // SV_POSITION is tile-local; shaders that use uv are unaffected. Fails for
+    // render graphs and compute presets, whose intermediates would have to be
+    // canvas-sized. Leaves the pipeline for BeginFrame to restore.
+    static constexpr int MAX_CANVAS_SIZE = D3D11_VIEWPORT_BOUNDS_MAX;
+    bool RenderCanvasTile(int canvasWidth, int canvasHeight, int x, int y, int width, int height, float time,
+                          FramePool& pool, FrameBuffer& out);
+
     // Video blend — only active when blendMode > 0 and video is also loaded.
+    // Normally a compositor pass (one variant per mode) over the shader's output;
+    // a pixel shader built with BuildFusedBlendSource blends in its own pass
+    // instead. SetFusedBlendMode tells the renderer the active shader's mode, and
+    // it is reset by every SetActive* call.
     void SetVideoBlend(int mode, float amount) { m_videoBlendMode = mode; m_videoBlendFactor = amount; }
+    void SetFusedBlendMode(int mode) { m_fusedBlendMode = mode; m_displayDirty = true; }
+    // `source` (preamble included) with its main renamed and followed by the blend
+    // epilogue; empty when CanFuseBlend is false (the epilogue calls the shader's
+    // main with its own PS_INPUT, so the entry point must be the template's)
+    static bool CanFuseBlend(const std::string& source);
+    static std::string BuildFusedBlendSource(const std::string& source, int mode);
+
+    // Compositor stack: layers blended over the active shader's result, bottom
+    // first. Preset layers draw into slices of one Texture2DArray and keep their
+    // slice while the shader, its values and (when it samples any) its textures
+    // are unchanged and it doesn't read time or audio. A single compositor pass,
+    // generated and compiled per layout (modes, sources, masks), then blends the
+    // video, the active shader and every layer; opacity is a uniform, so moving
+    // it compiles nothing. Empty = the single video blend above.
+    struct Layer {
+        ComPtr<ID3D11PixelShader> shader;  // Single-pass preset; null = extra video input `input`
+        ShaderBindings bindings;
+        bool  timeVarying = true;
+        float custom[16]  = {};            // The preset's b0 custom[] values
+        std::vector<float> params;         // Its spParams[] (b5); empty for most presets
+        int   input       = -1;
+        int   blendMode   = 1;             // 1..MAX_BLEND_MODE
+        float opacity     = 1.0f;
+        int   mask        = -1;            // Extra video input whose luma scales opacity; -1 = none
+        // Deck B (Deck): the preset's t0 and its size instead of the main video,
+        // and how opacity brings it in (DECK_TRANSITION_*)
+        ComPtr<ID3D11ShaderResourceView> video;
+        int   videoWidth  = 0;
+        int   videoHeight = 0;
+        int   transition  = DECK_TRANSITION_FADE;
+    };
+    void SetLayers(std::vector<Layer> layers);
+    // Compiles the compositor `layers` would need without drawing them, so a
+    // layer about to be added (a crossfade starting) doesn't compile mid-show
+    void PrewarmLayers(std::vector<Layer> layers);
+    // Deck B's frame (software RGBA), for Layer::video; dirties the display
+    bool UploadDeckFrame(const VideoFrame& frame);
+    void ReleaseDeckTexture();
+    ID3D11ShaderResourceView* GetDeckSRV() const { return m_deckTexture.srv.Get(); }
+    int GetDeckWidth()  const { return m_deckTexture.width; }
+    int GetDeckHeight() const { return m_deckTexture.height; }
+
+    // A software RGBA frame in a texture the caller owns (PlaybackChannel): created
+    // or resized as needed, skipped while the frame's generation is the one in it.
+    // Unlike the inputs and deck B it is not part of the display, so nothing is dirtied.
+    struct InputTexture {
+        ComPtr<ID3D11Texture2D>          texture;
+        ComPtr<ID3D11ShaderResourceView> srv;
+        int width  = 0;
+        int height = 0;
+        uint64_t generation = 0;
+    };
+    bool UploadFrameTexture(InputTexture& target, const VideoFrame& frame);
+
+    // A single-pass preset, as a Layer, drawn once into `rtv` (width x height) at
+    // shader time `time` over the current video and audio, with the inputs it
+    // reads bound; for library thumbnails (ThumbnailAtlas). After BeginFrame;
+    // restores the backbuffer target, viewport, uniforms and active shader.
+    void DrawThumbnail(const Layer& layer, float time, ID3D11RenderTargetView* rtv, int width, int height);
+    size_t  GetLayerCount()     const { return m_layers.size(); }
+    int64_t GetLayerRedraws()   const { return m_layerRedraws; }
+    int64_t GetLayerCacheHits() const { return m_layerCacheHits; }  // Slices reused instead of redrawn
 
     // Accessors
     ID3D11Device* GetDevice() const { return m_device.Get(); }
     ID3D11DeviceContext* GetContext() const { return m_context.Get(); }
+    // Binds are cached (PipelineStateCache): code that sets pipeline state on
+    // GetContext() without restoring it must call this afterwards
+    void InvalidatePipelineState() { m_pipelineState.Invalidate(); }
     ID3D11RenderTargetView* GetRenderTargetView() const { return m_renderTargetView.Get(); }
     int GetWidth() const { return m_width; }
     int GetHeight() const { return m_height; }
@@ -86,33 +571,234 @@ public:
 private:
     bool CreateDeviceAndSwapChain(HWND hwnd, int width, int height);
     bool CreateRenderTarget();
-    bool CreateVideoTexture(int width, int height);
-    bool CreateRenderToTexture(int width, int height);
+    bool CreateVideoTexture(int width, int height, bool renderTarget = false,
+                            DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM);
+    bool UploadRgbaFrame(const VideoFrame& frame);
+    bool ConvertHardwareFrame(const VideoFrame& frame);
+    bool UploadYuvPlanes(const VideoFrame& frame);
+    bool UploadPackedYuv(const VideoFrame& frame);  // YUYV422 / UYVY422
+    bool CreateYuvShader();
     bool CreateDisplayTexture(int width, int height);
     bool CreateCompositorSrcTexture(int width, int height);
+    // Standalone textures go through m_targetPool's recycle bin so a size
+    // change back to a recent size reuses the old texture instead of allocating
+    void RecycleTexture(ComPtr<ID3D11Texture2D>& texture, ComPtr<ID3D11RenderTargetView>& rtv,
+                        ComPtr<ID3D11ShaderResourceView>& srv, int width, int height,
+                        DXGI_FORMAT format, UINT bindFlags, D3D11_USAGE usage);
+    bool TakeTexture(ComPtr<ID3D11Texture2D>& texture, ComPtr<ID3D11RenderTargetView>& rtv,
+                     ComPtr<ID3D11ShaderResourceView>& srv, int width, int height,
+                     DXGI_FORMAT format, UINT bindFlags, D3D11_USAGE usage);
+    // Display, compositor and post targets: the video texture's precision while a
+    // high-bit-depth frame is at t0
+    DXGI_FORMAT WorkingFormat() const {
+        return (m_highBitDepth && m_videoTexture && m_videoFormat == DXGI_FORMAT_R16G16B16A16_UNORM)
+            ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+    void RecycleVideoTexture();
+    // m_adapter3 and the budget-change event; sizes the target pool's recycle budget
+    void OpenVideoMemoryBudget();
+    // The active shader, or every pass of the active graph, into `rtv`
+    void DrawActiveShader(ID3D11RenderTargetView* rtv, int width, int height);
+    // DrawActiveShader at m_renderScale into m_scaledTarget, then upscaled into `rtv`
+    void DrawActiveShaderScaled(ID3D11RenderTargetView* rtv, int width, int height);
+    // The upscaler's passes from `srv` into `rtv` at width x height. Leaves the
+    // render target, t0, pixel shader and viewport changed; callers restore them.
+    void DrawUpscaled(ID3D11ShaderResourceView* srv, ID3D11RenderTargetView* rtv, int width, int height);
+    void RestoreAfterBlit();  // Backbuffer RT and viewport, active PS, video SRV at t0
+    // Draw(3, 0) into a width x height target, as scissored tiles when SetTiling applies
+    void DrawTiled(int width, int height);
+    // One tick of a tilesPerFrame sweep into m_sweepTarget; true once it completed into the display texture
+    bool DrawTileSweep(int width, int height);
+    // The display texture added into m_accumTarget at `weight` (SetTemporalSupersampling)
+    void AccumulateDisplay(int width, int height, float weight);
+    bool PlanRenderGraph(int width, int height);  // Pass targets from m_targetPool, persistent buffers
+    bool RunCompute(ID3D11RenderTargetView* rtv, int width, int height);
+    void ClearCompute();
+    bool CreateComputeBuffers(const ComputeDesc& desc, ComputeState& state);  // Zeroed
+    // `kernels` over `video` (t0) and whatever else `used` reads, into
+    // state.output at width x height, then `points` when the desc draws. Reads b0 as uploaded.
+    bool DispatchKernels(const std::vector<ComputeKernel>& kernels, const PointDraw& points, const ComputeDesc& desc,
+                         ComputeState& state, const ShaderBindings& used, ID3D11ShaderResourceView* video,
+                         int width, int height);
+    // The instanced draw into state.outputRTV; restores the fullscreen pipeline state
+    void DrawComputePoints(const PointDraw& points, const ComputeDesc& desc, ComputeState& state,
+                           const ShaderBindings& used, int width, int height);
+    ID3D11ShaderResourceView* GetReadbackSRV() const {
+        return m_readbackSource ? m_readbackSource.Get() : m_displaySRV.Get();
+    }
     bool CreateShaderResources();
     bool CreatePassthroughShader();
-    bool CreateCompositorShader();
+    ID3D11PixelShader* GetCompositorShader(int mode);  // Variant for the mode, compiled on first use
+    // Compositor of m_layers over the video blended in `baseMode` (0 = the active
+    // shader alone), compiled on first use of the layout
+    ID3D11PixelShader* GetLayerCompositorShader(int baseMode);
+    bool CreateLayerArray(int width, int height, int slices);
+    // Preset layers into their slices; `inputsChanged` = a texture may have changed
+    void DrawLayers(int width, int height, bool inputsChanged);
+    void UpdateLayerConstants();
+    static void SanitizeLayers(std::vector<Layer>& layers);  // Drops or clamps what the compositor can't declare
+    void UpdateBlendConstants(bool enabled);
+    bool CreateRgbToYuvShader();
+    bool RunRgbToYuvPass(ID3D11ShaderResourceView* source, int width, int height);  // → m_readbackPlanes
+    // Immutable RgbToYuvConstants; row1 nullptr = zero
+    bool CreateRowBuffer(const float row0[4], const float row1[4], ComPtr<ID3D11Buffer>& outBuffer);
+    // Both ConvertToNv12: the luma and CbCr draws, full pipeline setup
+    bool DrawNv12(ID3D11ShaderResourceView* source, ID3D11RenderTargetView* luma, ID3D11RenderTargetView* chroma,
+                  UINT width, UINT height);
     void ReleaseRenderTarget();
 
     // Device and swap chain
     ComPtr<ID3D11Device> m_device;
     ComPtr<ID3D11DeviceContext> m_context;
     ComPtr<IDXGISwapChain1> m_swapChain;
+    UINT   m_swapChainFlags       = 0;        // ResizeBuffers must pass the creation flags again
+    HANDLE m_frameLatencyWaitable = nullptr;  // Null without IDXGISwapChain2 (pre-8.1) or headless
+    ComPtr<IDXGIAdapter3> m_adapter3;         // Null before WDDM 2.0
+    std::string m_preferredAdapter;           // Empty = high performance
+    std::string m_adapterName;
+    std::string m_sharedShaderCache;          // Empty = none
+    HANDLE m_budgetEvent  = nullptr;          // Auto-reset; signalled on a video memory budget change
+    DWORD  m_budgetCookie = 0;
+    int    m_maxFrameLatency      = 1;
+    bool   m_presentedSinceWait   = true;     // The object starts signalled for the first frame
+    bool   m_tearingSupported     = false;    // Chain has DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING
+    bool   m_occluded             = false;    // Last Present returned DXGI_STATUS_OCCLUDED
     ComPtr<ID3D11RenderTargetView> m_renderTargetView;
 
     // Video texture
     ComPtr<ID3D11Texture2D> m_videoTexture;
     ComPtr<ID3D11ShaderResourceView> m_videoSRV;
+    ComPtr<ID3D11RenderTargetView> m_videoRTV;  // Only when filled by the YUV pass
     int m_videoWidth = 0;
     int m_videoHeight = 0;
+    bool m_videoIsRenderTarget = false;
+    DXGI_FORMAT m_videoFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+    bool m_highBitDepth = false;
+    uint64_t m_videoGeneration = 0;
+
+    // Extra input textures (DYNAMIC RGBA, written with Map)
+    InputTexture m_inputTextures[MAX_VIDEO_INPUTS];
+    InputTexture m_deckTexture;  // Deck B's frame
+    bool UploadRgbaTexture(InputTexture& target, const VideoFrame& frame);  // Creates or resizes, then maps
+    ComPtr<ID3D11ShaderResourceView> m_lutSRVs[MAX_LUTS];  // Texture3D RGBA32F
 
-    // Render-to-texture for recording
-    ComPtr<ID3D11Texture2D> m_renderTexture;
-    ComPtr<ID3D11RenderTargetView> m_renderTextureRTV;
-    ComPtr<ID3D11Texture2D> m_stagingTexture;
-    int m_renderTextureWidth  = 0;
-    int m_renderTextureHeight = 0;
+    // GPU frame cache for scrubbing; m_cachedFrameSRV overrides m_videoSRV at t0
+    ScrubCache m_scrubCache;
+    LoopCache  m_loopCache;
+    RenderAheadQueue m_renderAhead;
+    ComPtr<ID3D11ShaderResourceView> m_cachedFrameSRV;
+    ComPtr<ID3D11ShaderResourceView> m_externalVideoSRV;  // Overrides both (SetExternalVideo)
+    ID3D11ShaderResourceView* GetSourceVideoSRV() const {
+        if (m_externalVideoSRV) return m_externalVideoSRV.Get();
+        return m_cachedFrameSRV ? m_cachedFrameSRV.Get() : m_videoSRV.Get();
+    }
+    // The mipped copy instead once it holds the frame on screen (SetVideoMips)
+    ID3D11ShaderResourceView* GetActiveVideoSRV() const {
+        if (m_videoMipSRV && m_videoMipSerial == m_videoFrameSerial) return m_videoMipSRV.Get();
+        return GetSourceVideoSRV();
+    }
+
+    // YUV→RGB conversion pass. Luma/chroma planes (decoder surface slices or CPU
+    // planes) are bound as t0..t2 and written into m_videoTexture, so user shaders
+    // keep sampling RGBA at t0 regardless of decode path.
+    struct alignas(16) YuvConstants {
+        float rowR[4];      // xyz = Y/Cb/Cr weights, w = offset
+        float rowG[4];
+        float rowB[4];
+        float uvScale[2];   // frame size / surface size (surfaces are padded)
+        float planarChroma; // 1 = separate Cb (t1) / Cr (t2) planes
+        float uyvy;         // Packed pass: 1 = UYVY byte order, 0 = YUY2
+    };
+    // Into the video texture, created in `format` (RGBA8, or RGBA16 for high bit depth).
+    // `shader` null = the planar/semi-planar pass (m_yuvPS).
+    bool RunYuvPass(ID3D11ShaderResourceView* const planes[3], int width, int height,
+                    const YuvConstants& yuv, DXGI_FORMAT format, ID3D11PixelShader* shader = nullptr);
+    ComPtr<ID3D11PixelShader> m_yuvPS;
+    ComPtr<ID3D11PixelShader> m_packedYuvPS;  // YUY2/UYVY, one RGBA8 texel per pixel pair
+    ComPtr<ID3D11Buffer>      m_yuvConstantBuffer;
+
+    // DYNAMIC plane textures for CPU-decoded YUV (Y, Cb or CbCr, Cr)
+    struct PlaneTexture {
+        ComPtr<ID3D11Texture2D>          texture;
+        ComPtr<ID3D11ShaderResourceView> srv;
+        int width  = 0;
+        int height = 0;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    };
+    bool EnsurePlaneTexture(PlaneTexture& plane, int width, int height, DXGI_FORMAT format);
+    PlaneTexture m_yuvPlanes[3];
+    // Software frames reach m_videoTexture / m_yuvPlanes through these
+    TextureUploadRing m_videoUpload;
+    TextureUploadRing m_planeUploads[3];
+
+    // Per-slice plane SRVs for the decoder's texture array, rebuilt when the
+    // decoder allocates a new surface pool.
+    struct HwPlaneViews {
+        ComPtr<ID3D11ShaderResourceView> luma;
+        ComPtr<ID3D11ShaderResourceView> chroma;
+    };
+    ComPtr<ID3D11Texture2D>   m_hwSourceTexture;
+    std::vector<HwPlaneViews> m_hwSliceViews;
+    VideoProcessorConverter   m_videoProcessor;
+    ShaderBytecodeCache       m_shaderCache;  // Open between Initialize and Shutdown; compile threads share it
+    bool m_useVideoProcessor    = false;
+    bool m_videoProcessorActive = false;
+
+    // Readback ring (STAGING copies of m_displayTexture + an event query each).
+    // Three slots: frame N-2 is mapped while N is drawn.
+    static constexpr int READBACK_SLOTS = 3;
+    struct ReadbackSlot {
+        ComPtr<ID3D11Texture2D> planes[3];  // RGBA8 uses planes[0] only
+        ComPtr<ID3D11Query>     query;
+        int width  = 0;  // Frame size; chroma planes are smaller
+        int height = 0;
+        ReadbackLayout layout = ReadbackLayout::RGBA8;
+        int64_t serial = 0;  // QueueReadback count when this frame was queued
+    };
+    bool EnsureReadbackSlot(ReadbackSlot& slot, int width, int height, ReadbackLayout layout);
+    ReadbackSlot m_readbackSlots[READBACK_SLOTS];
+    int     m_readbackHead    = 0;  // Oldest queued slot
+    int     m_readbackCount   = 0;
+    int64_t m_readbackSerial  = 0;
+    int     m_readbackLatency = 0;
+
+    // RGB→YUV for readback: R8/R16 plane targets and one immutable matrix row each
+    struct ReadbackPlane {
+        ComPtr<ID3D11Texture2D>        texture;
+        ComPtr<ID3D11RenderTargetView> rtv;
+        int width  = 0;
+        int height = 0;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    };
+    ReadbackLayout            m_readbackLayout = ReadbackLayout::RGBA8;
+    ReadbackPlane             m_readbackPlanes[3];
+    ComPtr<ID3D11PixelShader> m_rgbToYuvPS;
+    ComPtr<ID3D11Buffer>      m_rgbToYuvRows[3];
+    // Readback-size copy of the source: resampled to m_readbackWidth/Height, and/or
+    // RGBA8 for the RGBA8 layout when the working format is 16-bit
+    RenderTargetPool::Target  m_readbackTarget;
+    int                       m_readbackWidth  = 0;  // 0 = the source's size
+    int                       m_readbackHeight = 0;
+    ComPtr<ID3D11PixelShader> m_downscalePS;
+
+    // NV12 encoder surfaces: luma + CbCr rows, and per-slice RTVs of the pool array
+    struct EncodeSliceViews {
+        ComPtr<ID3D11RenderTargetView> luma;
+        ComPtr<ID3D11RenderTargetView> chroma;
+    };
+    ComPtr<ID3D11Buffer>          m_nv12Rows[2];
+    ComPtr<ID3D11Texture2D>       m_encodeTargetTexture;
+    std::vector<EncodeSliceViews> m_encodeSliceViews;
+
+    // ConvertToUyvy: shader and rows (with the half-pixel offset of its width),
+    // created on first use
+    ComPtr<ID3D11PixelShader> m_rgbToUyvyPS;
+    ComPtr<ID3D11Buffer>      m_uyvyConstants;
+    int                       m_uyvyWidth = 0;
+
+    // BlitRegionTo: shader and its per-draw constants, created on first use
+    ComPtr<ID3D11PixelShader> m_canvasRegionPS;
+    ComPtr<ID3D11Buffer>      m_canvasRegionConstants;
 
     // Display texture (shader-processed frame for ImGui::Image preview)
     ComPtr<ID3D11Texture2D> m_displayTexture;
@@ -120,35 +806,150 @@ private:
     ComPtr<ID3D11ShaderResourceView> m_displaySRV;
     int m_displayWidth = 0;
     int m_displayHeight = 0;
+    DXGI_FORMAT m_displayFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+    bool    m_displayDirty   = true;   // A texture the active shader samples changed
+    int64_t m_skippedRedraws = 0;
+    uint64_t m_displayGeneration = 0;
+
+    // SetTapPass: the tapped pass's copy, drawn with the passthrough shader
+    int  m_tapPass  = -1;
+    bool m_tapDrawn = false;
+    RenderTargetPool::Target m_tapTarget;
 
-    // Blend compositor shader and its intermediate source texture
-    ComPtr<ID3D11PixelShader>          m_compositorPS;
+    // Blend compositor shaders (by mode) and their intermediate source texture
+    std::array<ComPtr<ID3D11PixelShader>, MAX_BLEND_MODE + 1> m_compositorPS;
     ComPtr<ID3D11Texture2D>            m_compositorSrcTexture;
     ComPtr<ID3D11RenderTargetView>     m_compositorSrcRTV;
     ComPtr<ID3D11ShaderResourceView>   m_compositorSrcSRV;
     int m_compositorSrcWidth  = 0;
     int m_compositorSrcHeight = 0;
+    DXGI_FORMAT m_compositorSrcFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+    // Dynamic resolution: reduced-size target of the active shader and its upscale
+    float                     m_renderScale = 1.0f;
+    RenderTargetPool::Target  m_scaledTarget;
+    ComPtr<ID3D11PixelShader> m_upscalePS;  // Bicubic; also the fallback of the others
+    // Upscaler (SetUpscaler): the Lanczos, EASU and RCAS shaders compile on first
+    // use; m_upscaleTarget holds EASU's output ahead of RCAS
+    int                       m_upscaleFilter    = UPSCALE_EDGE_ADAPTIVE;
+    float                     m_upscaleSharpness = 0.25f;
+    bool                      m_upscaleShadersCompiled = false;  // Tried, whether or not they compiled
+    ComPtr<ID3D11PixelShader> m_lanczosPS;
+    ComPtr<ID3D11PixelShader> m_easuPS;
+    ComPtr<ID3D11PixelShader> m_rcasPS;
+    ComPtr<ID3D11Buffer>      m_rcasConstants;
+    RenderTargetPool::Target  m_upscaleTarget;
+
+    // Tiled rendering (SetTiling); a sweep resumes at tile m_sweepNext, row-major,
+    // drawing with m_sweepConstants
+    int  m_tileSize      = 0;
+    int  m_tilesPerFrame = 0;
+    bool m_sweeping      = false;
+    int  m_sweepNext     = 0;
+    RenderTargetPool::Target m_sweepTarget;
+
+    // Temporal supersampling: the sum of the sub-frames, and the sub-pixel
+    // offset of the current one's final draw
+    int   m_temporalSamples = 1;
+    float m_shutterSeconds  = 0.0f;
+    float m_jitter[2]       = {};
+    RenderTargetPool::Target m_accumTarget;
+    ComPtr<ID3D11BlendState> m_accumBlendState;  // ONE * factor + ONE
+
+    // Active render graph and its plan for the current render size: pass N draws
+    // into m_graphTargets[N] (unset for the last pass, which draws to the caller's RTV)
+    std::vector<RenderGraphPass>    m_graphPasses;
+    std::vector<RenderTargetPool::Target> m_graphTargets;
+    RenderTargetPool m_targetPool;
+    // Per pass, set for persistent ones: the pass draws into the buffer that is
+    // not `latest` and then flips it, so its previous output stays readable
+    struct PersistentTarget {
+        RenderTargetPool::Target buffers[2];
+        int latest = 0;
+    };
+    std::vector<PersistentTarget> m_persistentTargets;
+
+    // Active compute preset: its kernels, output texture and u1.. buffers
+    std::vector<ComputeKernel> m_computeKernels;
+    PointDraw                  m_computePoints;
+    ComputeDesc                m_computeDesc;
+    ComputeState               m_compute;
+
+    // Post chains (RunPostChain)
+    ShaderBindings m_postBindings = { 0u, 0u };
+    uint64_t       m_postGeneration = 0;
+    ComPtr<ID3D11ShaderResourceView> m_readbackSource;
+    bool m_graphPlanned = false;
+    int  m_graphWidth   = 0;
+    int  m_graphHeight  = 0;
+
+    // 1x1 prewarm targets, per PassFormat, created on first use
+    struct PrewarmTarget {
+        ComPtr<ID3D11Texture2D>           texture;
+        ComPtr<ID3D11RenderTargetView>    rtv;
+        ComPtr<ID3D11UnorderedAccessView> uav;
+    };
+    PrewarmTarget* GetPrewarmTarget(PassFormat format);
+    PrewarmTarget m_prewarmTargets[PASS_FORMAT_COUNT];
 
     // Shaders and pipeline state
     ComPtr<ID3D11VertexShader> m_vertexShader;
     ComPtr<ID3D11PixelShader> m_passthroughPS;
     ComPtr<ID3D11PixelShader> m_activePS;
+    bool m_activeTimeVarying = false;
+    ShaderBindings m_activeBindings;
+    ShaderBindings m_passthroughBindings;
     ComPtr<ID3D11InputLayout> m_inputLayout;
     ComPtr<ID3D11Buffer> m_vertexBuffer;
     ComPtr<ID3D11Buffer> m_constantBuffer;
     ComPtr<ID3D11SamplerState> m_sampler;
     ComPtr<ID3D11BlendState> m_blendState;  // opaque
+    ComPtr<ID3D11BlendState> m_additiveBlendState;  // Point draws: ONE + ONE
+    ComPtr<ID3D11BlendState> m_alphaBlendState;     // Point draws: SRC_ALPHA over
     ComPtr<ID3D11RasterizerState> m_rasterizerState;
+    ComPtr<ID3D11RasterizerState> m_scissorRasterizerState;  // Tiled draws
+    PipelineStateCache m_pipelineState;  // Every IA/VS/PS/cbuffer/sampler/RS/OM bind goes through it
 
     // Noise texture (t1) + wrap sampler (s1)
     ComPtr<ID3D11Texture2D>          m_noiseTexture;
     ComPtr<ID3D11ShaderResourceView> m_noiseSRV;
+    ComPtr<ID3D11UnorderedAccessView> m_noiseUAV;  // Mip 0, for the compute pass
+    ComPtr<ID3D11ComputeShader>      m_noiseCS;   // Compiled on first use
+    ComPtr<ID3D11Buffer>             m_noiseConstantBuffer;
+    int m_noiseSize = 0;
+    ComPtr<ID3D11Texture3D>          m_noiseVolume;  // t(NOISE_VOLUME_SLOT)
+    ComPtr<ID3D11ShaderResourceView> m_noiseVolumeSRV;
+    ComPtr<ID3D11UnorderedAccessView> m_noiseVolumeUAV;
+    ComPtr<ID3D11ComputeShader>      m_noiseVolumeCS;
+    int m_noiseVolumeSize = 0;
+    bool CreateNoiseTexture(int texSize);
+    bool CreateNoiseVolume(int volumeSize);  // 0 releases it
+    // One noise compute pass into `uav` (mip 0); compiles `shader` from `source` on first use
+    bool DispatchNoise(ComPtr<ID3D11ComputeShader>& shader, const char* source, ID3D11UnorderedAccessView* uav,
+                       int size, int period, UINT groups, UINT groupsZ);
     ComPtr<ID3D11SamplerState>       m_wrapSampler;
 
+    // Fused blend cbuffer (b(FUSED_BLEND_CBUFFER)), mirrors m_blendConstants
+    struct BlendConstants {
+        float amount;
+        float enabled;
+        float pad[2];
+    };
+    ComPtr<ID3D11Buffer>             m_blendConstantBuffer;
+    BlendConstants                   m_blendConstants = {};
+    int                              m_fusedBlendMode = 0;  // Compiled into m_activePS; 0 = none
+
     // Audio cbuffer (b1) + spectrum texture (t3, 1×256 R32_FLOAT DYNAMIC)
     ComPtr<ID3D11Buffer>             m_audioConstantBuffer;
     ComPtr<ID3D11Texture2D>          m_spectrumTexture;
     ComPtr<ID3D11ShaderResourceView> m_spectrumSRV;
+    // Spectrogram ring (t17, 256×SPECTROGRAM_ROWS R32_FLOAT DEFAULT): one row
+    // written per new spectrum, never the whole history
+    ComPtr<ID3D11Texture2D>          m_spectrogramTexture;
+    ComPtr<ID3D11ShaderResourceView> m_spectrogramSRV;
+    // Waveform (t18, 512×1 R32G32_FLOAT DYNAMIC): the newest heard frames, L/R
+    ComPtr<ID3D11Texture2D>          m_waveformTexture;
+    ComPtr<ID3D11ShaderResourceView> m_waveformSRV;
 
     struct alignas(16) AudioConstants {
         float rms;
@@ -157,9 +958,49 @@ private:
         float high;
         float beat;
         float spectralCentroid;
-        float padding[2];
+        int   spectrogramNewest;  // Row of the latest spectrum
+        int   spectrogramCount;   // Rows written since creation, up to SPECTROGRAM_ROWS
+        float left[4];            // rms, bass, mid, high of each channel
+        float right[4];
+        float stereoWidth;
+        float bpm;                // 0 = no tempo found
+        float beatPhase;          // [0,1) from each beat
+        float barPhase;           // [0,1) from each downbeat
     };
+    // SetAudioData only stores; BeginFrame uploads what changed once a shader reads it
+    void UploadAudioData();
     AudioConstants m_audioConstants = {};
+    float          m_spectrum[AudioData::kSpectrumBins] = {};
+    bool           m_audioConstantsDirty = true;
+    bool           m_spectrumDirty       = true;
+    float          m_waveform[AudioData::kWaveformSamples][AUDIO_CHANNELS] = {};
+    bool           m_waveformDirty       = true;
+    bool           m_spectrogramPending  = false;  // m_spectrum not in the ring yet
+
+    // Frame history ring; RTVs per slice exist only for downscaled rings
+    bool PushFrameHistory();
+    void UpdateHistoryConstants();
+    struct alignas(16) HistoryConstants {
+        int newest;  // Slice of the current frame
+        int count;   // Slices filled since the ring was (re)created
+        int frames;
+        int padding;
+    };
+    FrameHistoryDesc                 m_historyDesc;
+    HistoryConstants                 m_historyConstants = {};
+    ComPtr<ID3D11Buffer>             m_historyConstantBuffer;
+    ComPtr<ID3D11Texture2D>          m_historyTexture;
+    ComPtr<ID3D11ShaderResourceView> m_historySRV;
+    std::vector<ComPtr<ID3D11RenderTargetView>> m_historyRTVs;
+    uint64_t m_videoFrameSerial = 0;  // Bumped whenever t0 shows another frame
+    uint64_t m_historySerial    = 0;  // m_videoFrameSerial of the newest slice
+
+    // Mipped copy of t0 (SetVideoMips)
+    bool PushVideoMips();
+    bool                             m_videoMips = false;
+    ComPtr<ID3D11Texture2D>          m_videoMipTexture;
+    ComPtr<ID3D11ShaderResourceView> m_videoMipSRV;
+    uint64_t m_videoMipSerial = 0;  // m_videoFrameSerial it was built from
 
     // Constant buffer data
     struct alignas(16) ShaderConstants {
@@ -171,6 +1012,54 @@ private:
         float custom[16];  // Custom uniforms
     };
     ShaderConstants m_constants = {};
+    ShaderConstants m_displayConstants = {};  // Uniforms of the last display draw, time zeroed
+    ShaderConstants m_uploadedConstants = {};  // What m_constantBuffer holds, when m_constantsUploaded
+    ShaderConstants m_sweepConstants = {};     // Of the pending tile sweep's first tick
+    bool m_constantsUploaded = false;
+    void UploadConstants(const ShaderConstants& constants);  // Into b0, unless it already holds them
+
+    // b(PARAM_CBUFFER): the active preset's values, and a shadow of what the
+    // buffer holds. UploadParams writes the changed float4 range with a boxed
+    // UpdateSubresource1 where the driver supports partial constant buffer
+    // updates, else the whole buffer.
+    ComPtr<ID3D11Buffer> m_paramBuffer;
+    ComPtr<ID3D11DeviceContext1> m_context1;
+    bool  m_partialConstantUpdates = false;
+    float m_extendedParams[MAX_EXTENDED_PARAM_FLOATS] = {};
+    int   m_extendedParamCount = 0;
+    float m_displayParams[MAX_EXTENDED_PARAM_FLOATS]  = {};  // Of the last display draw, for idle elision
+    float m_uploadedParams[MAX_EXTENDED_PARAM_FLOATS] = {};
+    int64_t m_paramBytesUploaded = 0;
+    void UploadParams(const float* values, size_t floatCount);
+
+    // Compositor stack (SetLayers): slice N of m_layerArray is the Nth preset layer
+    std::vector<Layer> m_layers;
+    ShaderBindings     m_layerBindings = { 0u, 0u };  // Everything the layers and their compositor read
+    bool               m_layersTimeVarying = false;
+    struct LayerSlice {
+        ComPtr<ID3D11PixelShader> shader;      // What the slice holds (kept alive); null = nothing yet
+        ShaderConstants           drawn = {};  // Its uniforms, time zeroed
+        std::vector<float>        params;      // Its spParams[]
+    };
+    std::array<LayerSlice, MAX_LAYERS>                           m_layerSlices;
+    ComPtr<ID3D11Texture2D>                                      m_layerArray;
+    std::array<ComPtr<ID3D11RenderTargetView>, MAX_LAYERS>       m_layerRTVs;
+    ComPtr<ID3D11ShaderResourceView>                             m_layerSRV;
+    int m_layerArrayWidth  = 0;
+    int m_layerArrayHeight = 0;
+    int m_layerArraySlices = 0;
+    std::unordered_map<std::string, ComPtr<ID3D11PixelShader>> m_layerCompositorPS;  // By layout; null = failed
+    struct LayerConstants {  // b(LAYER_CBUFFER)
+        float base[4];                // x = video blend amount
+        float layers[MAX_LAYERS][4];  // x = opacity
+    };
+    ComPtr<ID3D11Buffer> m_layerConstantBuffer;
+    LayerConstants       m_layerConstants = {};
+    bool                 m_layerConstantsDirty = true;
+    int64_t m_layerRedraws   = 0;
+    int64_t m_layerCacheHits = 0;
+
+    GpuProfiler m_gpuProfiler;
 
     int m_width = 0;
     int m_height = 0;
@@ -0,0 +1,70 @@
+#include "Deck.h"
+
+namespace SP {
+
+namespace {
+
+const VideoFrame EMPTY_FRAME;
+
+} // namespace
+
+Deck::~Deck() {
+    Unload();
+}
+
+void Deck::Cue(const std::string& path, int threadCount, int proxyScale) {
+    Unload();
+    m_path   = path;
+    m_loaded = false;
+    m_loader = std::thread(&Deck::LoadThread, this, path, threadCount, proxyScale);
+}
+
+void Deck::LoadThread(std::string path, int threadCount, int proxyScale) {
+    auto input = std::make_unique<VideoInput>();
+    if (input->Open(path, threadCount, proxyScale)) m_loading = std::move(input);
+    m_loaded.store(true, std::memory_order_release);
+}
+
+void Deck::Unload() {
+    if (m_loader.joinable()) m_loader.join();  // An open can't be interrupted; the deck waits for it
+    m_loading.reset();
+    m_input.reset();
+    m_path.clear();
+    m_playing = false;
+    m_time    = 0.0;
+}
+
+bool Deck::Poll() {
+    if (!m_loader.joinable() || !m_loaded.load(std::memory_order_acquire)) return true;
+    m_loader.join();
+    m_input   = std::move(m_loading);
+    m_time    = 0.0;
+    m_playing = false;
+    return m_input != nullptr;  // On failure GetPath still names the clip
+}
+
+void Deck::SetPlaying(bool playing) {
+    if (playing && !m_playing) m_lastUpdate = std::chrono::steady_clock::now();
+    m_playing = playing && IsReady();
+}
+
+void Deck::Rewind() {
+    m_time = 0.0;
+    if (m_input) m_input->Sync(0.0);
+}
+
+bool Deck::Update() {
+    if (!m_input) return false;
+    if (m_playing) {
+        const auto now = std::chrono::steady_clock::now();
+        m_time += std::chrono::duration<double>(now - m_lastUpdate).count();
+        m_lastUpdate = now;
+    }
+    return m_input->Sync(m_time);
+}
+
+const VideoFrame& Deck::GetFrame() const {
+    return m_input ? m_input->GetFrame() : EMPTY_FRAME;
+}
+
+} // namespace SP
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Common.h"
+#include "VideoInput.h"
+#include <chrono>
+
+namespace SP {
+
+// Deck B of A/B mixing: a second video source with its own clock, crossfaded
+// over the main player (deck A) as the top compositor layer. Cue opens the file
+// and decodes its first frame on a worker thread, so loading the next clip while
+// deck A plays never stalls the render thread; Poll adopts it once it lands.
+// The clock starts at the cue point and runs only while playing, looping the
+// clip. Render thread only, apart from the loader.
+class Deck {
+public:
+    Deck() = default;
+    ~Deck();
+
+    // Non-copyable
+    Deck(const Deck&) = delete;
+    Deck& operator=(const Deck&) = delete;
+
+    // Replaces the deck's clip; `threadCount` and `proxyScale` as VideoInput::Open
+    void Cue(const std::string& path, int threadCount, int proxyScale);
+    void Unload();
+    // Adopts a finished load. False when the last Cue failed (once; GetPath
+    // still names the clip).
+    bool Poll();
+
+    bool IsLoading() const { return m_loader.joinable(); }
+    bool IsReady()   const { return m_input != nullptr; }
+    const std::string& GetPath() const { return m_path; }
+
+    void   SetPlaying(bool playing);
+    bool   IsPlaying() const { return m_playing; }
+    void   Rewind();  // Back to the cue point (the first frame)
+    double GetTime() const { return m_time; }
+
+    // Advances the clock by the wall time since the last call (while playing)
+    // and brings the frame up to it. True when the frame changed.
+    bool Update();
+    const VideoFrame& GetFrame() const;
+
+private:
+    void LoadThread(std::string path, int threadCount, int proxyScale);
+
+    std::unique_ptr<VideoInput> m_input;    // Ready deck; render thread
+    std::unique_ptr<VideoInput> m_loading;  // Loader's; published by m_loaded
+    std::thread       m_loader;
+    std::atomic<bool> m_loaded{false};
+    std::string       m_path;
+    bool   m_playing = false;
+    double m_time    = 0.0;
+    std::chrono::steady_clock::time_point m_lastUpdate;
+};
+
+} // namespace SP
@@ -0,0 +1,359 @@
+#include "DecodeWorker.h"
+#include "VideoDecoder.h"
+#include "TraceRecorder.h"
+#include "ThreadPriority.h"
+#include <algorithm>
+#include <limits>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace SP {
+
+DecodeWorker::DecodeWorker(VideoDecoder& decoder)
+    : m_decoder(decoder) {
+}
+
+DecodeWorker::~DecodeWorker() {
+    Stop();
+}
+
+namespace {
+
+// Decoded chunks held ahead of the one being presented in reverse
+constexpr size_t REVERSE_CHUNKS_AHEAD = 1;
+
+// Live mode: how long to wait before polling the non-blocking demuxer again.
+// Bounds the added latency per frame while keeping the thread mostly idle.
+constexpr auto LIVE_POLL_INTERVAL = std::chrono::milliseconds(1);
+
+} // namespace
+
+void DecodeWorker::Start() {
+    Stop();
+    m_reverse       = false;
+    m_live          = false;
+    m_stopRequested = false;
+    m_decoderEOF    = false;
+    m_decoder.SetDownloadHardwareFrames(false);
+    m_thread = std::thread(&DecodeWorker::WorkerThread, this);
+}
+
+void DecodeWorker::StartReverse(int64_t endFrame, size_t budgetBytes) {
+    Stop();
+
+    // Budget covers the chunk on screen plus the ones decoding ahead. Size frames
+    // as RGBA, or 16-bit 4:4:4 for high-bit-depth sources — an upper bound for
+    // every layout the decoder emits.
+    const AVPixFmtDescriptor* pixDesc = av_pix_fmt_desc_get(m_decoder.GetPixelFormat());
+    const size_t pixelBytes = (pixDesc && pixDesc->comp[0].depth > 8) ? 6 : 4;
+    const size_t frameBytes = std::max<size_t>(
+        static_cast<size_t>(m_decoder.GetWidth()) * m_decoder.GetHeight() * pixelBytes, 1);
+    const size_t chunks = REVERSE_CHUNKS_AHEAD + 1;
+    m_chunkFrames = std::clamp<size_t>(budgetBytes / chunks / frameBytes, 4, 600);
+
+    m_reverse        = true;
+    m_live           = false;
+    m_reverseEnd     = std::max<int64_t>(endFrame, 0);
+    m_reverseEndTime = std::numeric_limits<double>::max();
+    m_stopRequested  = false;
+    m_decoderEOF     = false;
+    m_decoder.SetDownloadHardwareFrames(true);
+    m_thread = std::thread(&DecodeWorker::ReverseThread, this);
+}
+
+void DecodeWorker::StartLive() {
+    Stop();
+    m_reverse       = false;
+    m_live          = true;
+    m_stopRequested = false;
+    m_decoderEOF    = false;
+    m_decoder.SetDownloadHardwareFrames(false);
+    m_thread = std::thread(&DecodeWorker::LiveThread, this);
+}
+
+void DecodeWorker::Stop() {
+    if (m_thread.joinable()) {
+        m_stopRequested = true;
+        m_wakeCv.notify_one();
+        m_thread.join();
+    }
+
+    // Release every slot so hardware frames return their surfaces before the
+    // decoder (and its frame pool) is closed.
+    for (auto& slot : m_slots) {
+        slot = VideoFrame{};
+    }
+    m_readyChunks.clear();
+    m_currentChunk.clear();
+    m_mailbox     = VideoFrame{};
+    m_mailboxFull = false;
+    m_slotLoopStart.fill(false);
+    m_writeIndex = 0;
+    m_readIndex  = 0;
+    m_decoderEOF = false;
+    m_wrapped    = false;
+    m_poppedLoopStart = false;
+}
+
+bool DecodeWorker::PopFrame(VideoFrame& ioFrame) {
+    if (m_reverse) return PopReverseFrame(ioFrame);
+    if (m_live) return PopLiveFrame(ioFrame);
+
+    const uint64_t read = m_readIndex.load(std::memory_order_relaxed);
+    if (read == m_writeIndex.load(std::memory_order_acquire)) {
+        if (m_thread.joinable() && !m_decoderEOF.load()) {
+            ++m_underruns;
+        }
+        return false;
+    }
+
+    std::swap(ioFrame, m_slots[read % MAX_FRAME_QUEUE_SIZE]);
+    m_poppedLoopStart = m_slotLoopStart[read % MAX_FRAME_QUEUE_SIZE];
+    m_readIndex.store(read + 1, std::memory_order_release);
+    m_wakeCv.notify_one();
+    return true;
+}
+
+bool DecodeWorker::PeekNextTimestamp(double& timestamp) const {
+    if (m_reverse || m_live) return false;
+    const uint64_t read = m_readIndex.load(std::memory_order_relaxed);
+    if (read == m_writeIndex.load(std::memory_order_acquire)) return false;
+    // Published and not yet popped, so the worker won't touch this slot
+    timestamp = m_slots[read % MAX_FRAME_QUEUE_SIZE].timestamp;
+    return true;
+}
+
+bool DecodeWorker::NextStartsLoop() const {
+    if (m_reverse || m_live) return false;
+    const uint64_t read = m_readIndex.load(std::memory_order_relaxed);
+    if (read == m_writeIndex.load(std::memory_order_acquire)) return false;
+    return m_slotLoopStart[read % MAX_FRAME_QUEUE_SIZE];
+}
+
+bool DecodeWorker::PopReverseFrame(VideoFrame& ioFrame) {
+    if (m_currentChunk.empty()) {
+        std::lock_guard<std::mutex> lock(m_chunkMutex);
+        if (m_readyChunks.empty()) {
+            if (m_thread.joinable() && !m_decoderEOF.load()) {
+                ++m_underruns;
+            }
+            return false;
+        }
+        m_currentChunk = std::move(m_readyChunks.front());
+        m_readyChunks.pop_front();
+        m_wakeCv.notify_one();
+    }
+
+    ioFrame = std::move(m_currentChunk.back());
+    m_currentChunk.pop_back();
+    return true;
+}
+
+bool DecodeWorker::PopLiveFrame(VideoFrame& ioFrame) {
+    // No new frame since the last pop is normal (render rate above the source
+    // rate), not an underrun.
+    std::lock_guard<std::mutex> lock(m_mailboxMutex);
+    if (!m_mailboxFull) return false;
+    std::swap(ioFrame, m_mailbox);
+    m_mailboxFull      = false;
+    m_poppedPacketTime = m_mailboxPacketTime;
+    return true;
+}
+
+bool DecodeWorker::IsEndOfStream() const {
+    if (m_live) {
+        if (!m_decoderEOF.load()) return false;
+        std::lock_guard<std::mutex> lock(m_mailboxMutex);
+        return !m_mailboxFull;
+    }
+    if (m_reverse) {
+        if (!m_decoderEOF.load() || !m_currentChunk.empty()) return false;
+        std::lock_guard<std::mutex> lock(m_chunkMutex);
+        return m_readyChunks.empty();
+    }
+    return m_decoderEOF.load() &&
+           m_readIndex.load(std::memory_order_acquire) == m_writeIndex.load(std::memory_order_acquire);
+}
+
+void DecodeWorker::DiscardQueued() {
+    // Caller holds m_decoderMutex, so the worker is not mid-write.
+    m_readIndex.store(m_writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+    m_decoderEOF = false;
+    m_wrapped    = false;  // The seek replaced any wrap the worker made
+    m_wakeCv.notify_one();
+}
+
+int DecodeWorker::GetQueueDepth() const {
+    if (m_live) {
+        std::lock_guard<std::mutex> lock(m_mailboxMutex);
+        return m_mailboxFull ? 1 : 0;
+    }
+    if (m_reverse) {
+        std::lock_guard<std::mutex> lock(m_chunkMutex);
+        size_t depth = m_currentChunk.size();
+        for (const auto& chunk : m_readyChunks) depth += chunk.size();
+        return static_cast<int>(depth);
+    }
+    const uint64_t write = m_writeIndex.load(std::memory_order_acquire);
+    const uint64_t read  = m_readIndex.load(std::memory_order_acquire);
+    return static_cast<int>(write - read);
+}
+
+int DecodeWorker::GetQueueCapacity() const {
+    if (m_live) return 1;
+    return m_reverse ? static_cast<int>(m_chunkFrames * (REVERSE_CHUNKS_AHEAD + 1))
+                     : MAX_FRAME_QUEUE_SIZE;
+}
+
+void DecodeWorker::ResetStats() {
+    m_underruns     = 0;
+    m_framesDecoded = 0;
+    m_liveDrops     = 0;
+}
+
+void DecodeWorker::WorkerThread() {
+    TraceRecorder::SetThreadName("Decode");
+    ThreadPriority::Apply(ThreadRole::Playback);
+    while (!m_stopRequested.load()) {
+        const uint64_t write = m_writeIndex.load(std::memory_order_relaxed);
+        const bool full = (write - m_readIndex.load(std::memory_order_acquire)) >= MAX_FRAME_QUEUE_SIZE;
+
+        // Nothing to do until the render thread frees a slot or a seek clears EOF.
+        // The timeout bounds a missed notification to a few milliseconds.
+        if (full || m_decoderEOF.load()) {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wakeCv.wait_for(lock, std::chrono::milliseconds(5));
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(m_decoderMutex);
+        // Pops and discards only ever free slots, so the free slot found above is
+        // still free; a discard may have cleared EOF, which is fine to decode into.
+        VideoFrame& slot = m_slots[write % MAX_FRAME_QUEUE_SIZE];
+        SP_TRACE_SCOPE("Decode frame");
+        if (m_decoder.DecodeNextFrame(slot)) {
+            m_slotLoopStart[write % MAX_FRAME_QUEUE_SIZE] = m_wrapped;
+            m_wrapped = false;
+            m_writeIndex.store(write + 1, std::memory_order_release);
+            ++m_framesDecoded;
+        } else if (m_decoder.WasSeekCancelled()) {
+            // A newer seek is waiting for the decoder lock; it discards the queue anyway
+        } else if (m_looping.load(std::memory_order_relaxed) && !m_wrapped && m_decoder.SeekToTime(0.0)) {
+            // Wrap ahead of the playhead. A wrap that decodes nothing ends the stream
+            // rather than seeking forever.
+            m_wrapped = true;
+        } else {
+            m_wrapped    = false;
+            m_decoderEOF = true;
+        }
+    }
+}
+
+void DecodeWorker::ReverseThread() {
+    TraceRecorder::SetThreadName("Decode");
+    ThreadPriority::Apply(ThreadRole::Playback);
+    while (!m_stopRequested.load()) {
+        bool full;
+        {
+            std::lock_guard<std::mutex> lock(m_chunkMutex);
+            full = m_readyChunks.size() >= REVERSE_CHUNKS_AHEAD;
+        }
+        if (full || m_decoderEOF.load()) {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wakeCv.wait_for(lock, std::chrono::milliseconds(5));
+            continue;
+        }
+
+        const int64_t end = m_reverseEnd;
+        if (end <= 0) {
+            m_decoderEOF = true;
+            continue;
+        }
+
+        // Start the chunk at the GOP's keyframe so the seek lands on it with nothing
+        // to discard; a GOP longer than the budget is cut into slices that each
+        // decode forward from the same keyframe. Intra-only streams can start anywhere.
+        int64_t start = std::max<int64_t>(end - static_cast<int64_t>(m_chunkFrames), 0);
+        if (!m_decoder.IsIntraOnly()) {
+            const int64_t keyframe = m_decoder.GetKeyframeBefore(end - 1);
+            if (keyframe > start) start = keyframe;
+        }
+
+        std::vector<VideoFrame> chunk;
+        chunk.reserve(static_cast<size_t>(end - start));
+        {
+            SP_TRACE_SCOPE("Decode chunk");
+            std::lock_guard<std::mutex> lock(m_decoderMutex);
+            if (m_decoder.SeekToFrame(start)) {
+                while (chunk.size() < static_cast<size_t>(end - start) && !m_stopRequested.load()) {
+                    VideoFrame frame;
+                    if (!m_decoder.DecodeNextFrame(frame)) break;
+                    // Without an exact index the frame grid is nominal: stop at the
+                    // first frame the previous chunk already covers.
+                    if (frame.timestamp >= m_reverseEndTime) break;
+                    chunk.push_back(std::move(frame));
+                }
+            }
+        }
+        if (m_stopRequested.load()) break;
+
+        m_reverseEnd = start;
+        if (chunk.empty()) {
+            // Nothing decodable before this point — end rather than spin on it
+            m_decoderEOF = true;
+            continue;
+        }
+        m_reverseEndTime = chunk.front().timestamp;
+        m_framesDecoded += static_cast<int64_t>(chunk.size());
+
+        std::lock_guard<std::mutex> lock(m_chunkMutex);
+        m_readyChunks.push_back(std::move(chunk));
+    }
+}
+
+void DecodeWorker::LiveThread() {
+    // Decode into a private frame, then publish it by swapping it into the mailbox.
+    // The swap hands back the frame the mailbox held (the previous pop's, or an
+    // unseen one that is being dropped), so its buffers are reused.
+    TraceRecorder::SetThreadName("Decode (live)");
+    ThreadPriority::Apply(ThreadRole::Playback);
+    VideoFrame frame;
+    while (!m_stopRequested.load()) {
+        bool decoded;
+        bool ended = false;
+        std::chrono::steady_clock::time_point packetTime;
+        {
+            SP_TRACE_SCOPE("Decode frame");
+            std::lock_guard<std::mutex> lock(m_decoderMutex);
+            decoded = m_decoder.DecodeNextFrame(frame);
+            if (decoded) {
+                packetTime = m_decoder.GetLastPacketTime();
+            } else {
+                ended = !m_decoder.WouldBlock();
+            }
+        }
+
+        if (!decoded) {
+            if (ended) {
+                // Device unplugged or stream closed: keep the last frame on screen
+                m_decoderEOF = true;
+                break;
+            }
+            // Nothing from the source yet; Stop() cuts the wait short
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wakeCv.wait_for(lock, LIVE_POLL_INTERVAL);
+            continue;
+        }
+        ++m_framesDecoded;
+
+        std::lock_guard<std::mutex> lock(m_mailboxMutex);
+        if (m_mailboxFull) ++m_liveDrops;
+        std::swap(frame, m_mailbox);
+        m_mailboxFull       = true;
+        m_mailboxPacketTime = packetTime;
+    }
+}
+
+} // namespace SP
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Common.h"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+
+namespace SP {
+
+class VideoDecoder;
+
+// Background video decode for file playback. The worker thread runs
+// VideoDecoder::DecodeNextFrame ahead of the playhead into a single-producer /
+// single-consumer ring of MAX_FRAME_QUEUE_SIZE frames; the render thread only pops.
+//
+// Reverse mode decodes whole chunks instead: one GOP (or a budget-sized slice of a
+// long GOP) forward from its keyframe into a vector, which the render thread then
+// presents back to front while the worker decodes the next-earlier chunk.
+//
+// Looping (SetLooping) makes the forward worker seek back to the start itself on
+// reaching end of stream and keep filling the ring, so the first frames of the
+// next pass are decoded before the last ones of this pass are shown. The first
+// frame after each wrap is flagged (NextStartsLoop, PoppedLoopStart).
+//
+// Live mode (capture devices, streams) drains the source as fast as it delivers
+// and publishes only the newest frame through a single-slot mailbox, so a slow
+// render tick drops stale frames instead of letting them queue up as latency.
+//
+// VideoDecoder itself is not thread-safe. While the worker is running, every other
+// decoder call that touches the demuxer or codecs (seek, synchronous
+// DecodeNextFrame) must hold LockDecoder() or TryLockDecoder(). Audio has its own
+// demuxer (AudioReader) and never takes this lock.
+class DecodeWorker {
+public:
+    explicit DecodeWorker(VideoDecoder& decoder);
+    ~DecodeWorker();
+
+    // Non-copyable
+    DecodeWorker(const DecodeWorker&) = delete;
+    DecodeWorker& operator=(const DecodeWorker&) = delete;
+
+    // Start after the decoder is open; Stop before it is closed or reopened.
+    void Start();
+    void Stop();
+    bool IsRunning() const { return m_thread.joinable(); }
+
+    // Reverse playback: PopFrame returns frames endFrame-1, endFrame-2, ... 0, then
+    // reports end of stream. budgetBytes bounds the two chunks held in memory.
+    // Hardware frames are downloaded to system memory while reversing.
+    void StartReverse(int64_t endFrame, size_t budgetBytes);
+    bool IsReverse() const { return m_reverse; }
+
+    // Live capture: PopFrame returns the newest decoded frame, once. Frames that
+    // were replaced before being popped count as live drops.
+    void StartLive();
+    bool IsLive() const { return m_live; }
+    // Render thread: when the packet of the frame PopFrame last returned was read
+    std::chrono::steady_clock::time_point GetPoppedPacketTime() const { return m_poppedPacketTime; }
+
+    // Render thread only. Swaps the oldest ready frame into ioFrame; the frame that
+    // ioFrame held goes back into the ring so its buffers are reused by the worker.
+    // Returns false when nothing is ready (counted as an underrun unless at EOS).
+    bool PopFrame(VideoFrame& ioFrame);
+
+    // Render thread, forward mode: timestamp of the frame PopFrame would return next,
+    // without popping it. False when nothing is ready (not counted as an underrun).
+    bool PeekNextTimestamp(double& timestamp) const;
+
+    // True once the decoder reached end of stream and every decoded frame was popped.
+    // Never, while looping, unless the seek back to the start fails.
+    bool IsEndOfStream() const;
+
+    // Forward mode: wrap to the start at end of stream instead of stopping. Takes
+    // effect at the next end of stream; frames already wrapped stay queued.
+    void SetLooping(bool looping) { m_looping.store(looping, std::memory_order_relaxed); }
+    // Render thread: the frame PopFrame would return next / last returned is the
+    // first of a new pass. Its timestamp goes back to the start of the clip.
+    bool NextStartsLoop() const;
+    bool PoppedLoopStart() const { return m_poppedLoopStart; }
+
+    // Exclusive decoder access. LockDecoder blocks until the worker finishes the
+    // frame it is decoding; TryLockDecoder is for per-tick work that can be skipped.
+    std::unique_lock<std::mutex> LockDecoder() { return std::unique_lock<std::mutex>(m_decoderMutex); }
+    std::unique_lock<std::mutex> TryLockDecoder() {
+        return std::unique_lock<std::mutex>(m_decoderMutex, std::try_to_lock);
+    }
+
+    // Drop all queued frames and clear end-of-stream — call after a seek, while
+    // holding LockDecoder(), from the render thread. Forward mode only; reverse
+    // playback is restarted with StartReverse instead.
+    void DiscardQueued();
+
+    // Stats
+    int     GetQueueDepth() const;
+    int     GetQueueCapacity() const;
+    int64_t GetUnderruns() const { return m_underruns.load(); }
+    int64_t GetFramesDecoded() const { return m_framesDecoded.load(); }
+    int64_t GetLiveDrops() const { return m_liveDrops.load(); }
+    void    ResetStats();
+
+private:
+    void WorkerThread();
+    void ReverseThread();
+    void LiveThread();
+    bool PopReverseFrame(VideoFrame& ioFrame);
+    bool PopLiveFrame(VideoFrame& ioFrame);
+
+    VideoDecoder& m_decoder;
+    std::thread m_thread;
+    std::atomic<bool> m_stopRequested{false};
+
+    std::mutex m_decoderMutex;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCv;  // Signalled when a slot frees up
+
+    // Ring slots. The worker writes slot [write % N] while holding m_decoderMutex
+    // and publishes with a release store; the render thread swaps out slot
+    // [read % N] lock-free. Indices increase monotonically; depth = write - read.
+    std::array<VideoFrame, MAX_FRAME_QUEUE_SIZE> m_slots{};
+    std::array<bool, MAX_FRAME_QUEUE_SIZE>       m_slotLoopStart{};  // Published with the slot
+    std::atomic<uint64_t> m_writeIndex{0};
+    std::atomic<uint64_t> m_readIndex{0};
+    std::atomic<bool>     m_decoderEOF{false};
+    std::atomic<bool>     m_looping{false};
+    bool m_wrapped = false;          // Worker, under m_decoderMutex: the next frame starts a pass
+    bool m_poppedLoopStart = false;  // Render thread
+
+    // Reverse mode. m_reverse and m_chunkFrames change only while stopped; the
+    // worker owns m_reverseEnd/m_reverseEndTime, the render thread m_currentChunk.
+    bool    m_reverse = false;
+    size_t  m_chunkFrames = 0;
+    int64_t m_reverseEnd = 0;          // Next chunk ends before this frame number
+    double  m_reverseEndTime = 0.0;    // Timestamp of the earliest frame queued so far
+    mutable std::mutex m_chunkMutex;
+    std::deque<std::vector<VideoFrame>> m_readyChunks;  // Presentation order within each
+    std::vector<VideoFrame> m_currentChunk;              // Popped from the back
+
+    // Live mode. The worker swaps each new frame into m_mailbox; the render thread
+    // swaps it out, handing back the previous frame's buffers.
+    bool m_live = false;
+    mutable std::mutex m_mailboxMutex;
+    VideoFrame m_mailbox;
+    bool       m_mailboxFull = false;
+    std::chrono::steady_clock::time_point m_mailboxPacketTime{};
+    std::chrono::steady_clock::time_point m_poppedPacketTime{};
+
+    std::atomic<int64_t> m_underruns{0};
+    std::atomic<int64_t> m_framesDecoded{0};
+    std::atomic<int64_t> m_liveDrops{0};
+};
+
+} // namespace SP
@@ -0,0 +1,65 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+namespace SP {
+
+namespace {
+
+constexpr float AVERAGE_ALPHA = 0.25f;
+
+float Quantize(float scale, float minScale) {
+    const float stepped = std::floor(scale / DynamicResolution::STEP + 1e-4f) * DynamicResolution::STEP;
+    return std::clamp(stepped, minScale, 1.0f);
+}
+
+} // namespace
+
+void DynamicResolution::Reset() {
+    m_scale     = 1.0f;
+    m_averageMs = 0.0f;
+    m_samples   = 0;
+    m_lastFrame = -1;
+    m_changeFrame = 0;
+}
+
+float DynamicResolution::Update(const Settings& settings, const GpuFrameTiming& latest, int64_t currentFrame) {
+    if (!settings.enabled || settings.targetMs <= 0.0f) {
+        if (m_scale != 1.0f) Reset();
+        return m_scale;
+    }
+    const float minScale = std::clamp(settings.minScale, MIN_SCALE, 1.0f);
+    if (m_scale < minScale) {
+        // The floor was raised
+        m_scale   = minScale;
+        m_samples = 0;
+        m_changeFrame = currentFrame;
+        return m_scale;
+    }
+
+    // One sample per resolved frame, drawn at the current scale. Idle-elided
+    // frames (no shader draw) say nothing about its cost.
+    const float shaderMs = latest.ms[static_cast<int>(GpuStage::Shader)];
+    if (latest.frame <= m_lastFrame || latest.frame < m_changeFrame || shaderMs <= 0.0f) return m_scale;
+    m_lastFrame = latest.frame;
+    m_averageMs = (m_samples == 0) ? shaderMs : m_averageMs + (shaderMs - m_averageMs) * AVERAGE_ALPHA;
+    if (++m_samples < SETTLE_FRAMES) return m_scale;
+
+    const bool over  = m_averageMs > settings.targetMs;
+    const bool under = m_averageMs < settings.targetMs * GROW_HEADROOM && m_scale < 1.0f;
+    if (!over && !under) return m_scale;
+
+    // Largest scale whose predicted cost fits the target
+    const float fullMs = m_averageMs / (m_scale * m_scale);
+    float next = Quantize(std::sqrt(settings.targetMs / fullMs), minScale);
+    if (under) next = std::max(next, m_scale);  // Rounding must not shrink on the way up
+    if (over && next >= m_scale) next = std::max(minScale, m_scale - STEP);
+    if (next == m_scale) return m_scale;
+
+    m_scale       = next;
+    m_samples     = 0;
+    m_changeFrame = currentFrame;
+    return m_scale;
+}
+
+} // namespace SP
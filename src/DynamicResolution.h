@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Common.h"
+#include "GpuProfiler.h"
+
+namespace SP {
+
+// Picks the render scale of the user shader from its measured GPU time, so a
+// heavy generator holds a frame-time budget by drawing fewer pixels. The shader's
+// cost is taken to grow with its pixel count (scale squared): the controller
+// predicts the full-resolution cost from the current one and picks the largest
+// scale that fits the target. Changes are quantized to STEP and held for a few
+// resolved frames, so the intermediate target and multi-pass plans are not
+// rebuilt every frame. Render thread only.
+class DynamicResolution {
+public:
+    static constexpr float STEP          = 0.05f;
+    static constexpr float MIN_SCALE     = 0.25f;
+    static constexpr int   SETTLE_FRAMES = 8;      // Resolved frames at a scale before the next change
+    static constexpr float GROW_HEADROOM = 0.85f;  // Scale up only while under this fraction of the target
+
+    struct Settings {
+        bool  enabled  = false;
+        float targetMs = 12.0f;  // GPU time of the Shader stage to aim for
+        float minScale = 0.5f;
+    };
+
+    // Full resolution, history dropped
+    void Reset();
+
+    // Feeds the newest resolved GPU frame; `currentFrame` is the GpuProfiler frame
+    // about to be recorded. Returns the scale to render it at (1 when disabled).
+    float Update(const Settings& settings, const GpuFrameTiming& latest, int64_t currentFrame);
+
+    float GetScale() const { return m_scale; }
+    float GetAverageMs() const { return m_averageMs; }  // Shader stage at the current scale
+
+private:
+    float   m_scale       = 1.0f;
+    float   m_averageMs   = 0.0f;
+    int     m_samples     = 0;   // Accepted since the last change
+    int64_t m_lastFrame   = -1;  // Newest GPU frame already fed
+    int64_t m_changeFrame = 0;   // First GPU frame rendered at m_scale
+};
+
+} // namespace SP
@@ -0,0 +1,64 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace SP {
+
+namespace {
+
+constexpr size_t BLOCK_ALIGNMENT = 64;
+
+} // namespace
+
+FrameArena::~FrameArena() {
+    FreeBlocks();
+}
+
+void FrameArena::Reset() {
+    m_highWater = std::max(m_highWater, GetUsedBytes());
+    if (m_blocks.size() > 1) {
+        // Last tick overflowed: one block big enough for all of it from now on
+        const size_t capacity = m_capacity;
+        FreeBlocks();
+        AddBlock(capacity);
+    }
+    m_offset = 0;
+    m_used   = 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    if (!m_blocks.empty()) {
+        const Block& block = m_blocks.back();
+        const uintptr_t base  = reinterpret_cast<uintptr_t>(block.data);
+        const size_t    start = ((base + m_offset + alignment - 1) & ~(alignment - 1)) - base;
+        if (start + bytes <= block.size) {
+            m_offset = start + bytes;
+            return block.data + start;
+        }
+        m_used += m_offset;
+    }
+    // Blocks are BLOCK_ALIGNMENT-aligned; anything stricter gets padding room
+    AddBlock(bytes + (alignment > BLOCK_ALIGNMENT ? alignment : 0));
+    return do_allocate(bytes, alignment);
+}
+
+void FrameArena::AddBlock(size_t minimum) {
+    const size_t previous = m_blocks.empty() ? INITIAL_BLOCK_SIZE / 2 : m_blocks.back().size;
+    const size_t size = std::max(previous * 2, minimum);
+    m_blocks.reserve(m_blocks.size() + 1);
+    Block block;
+    block.data = static_cast<std::byte*>(::operator new(size, std::align_val_t{BLOCK_ALIGNMENT}));
+    block.size = size;
+    m_blocks.push_back(block);
+    m_offset    = 0;
+    m_capacity += size;
+}
+
+void FrameArena::FreeBlocks() {
+    for (const Block& block : m_blocks) ::operator delete(block.data, std::align_val_t{BLOCK_ALIGNMENT});
+    m_blocks.clear();
+    m_capacity = 0;
+}
+
+} // namespace SP
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace SP {
+
+// Bump allocator for scratch that lives no longer than one main-loop tick:
+// sort buffers and copies the profiler snapshots make, and the like. Hand it to
+// std::pmr containers. Deallocation is a no-op; Reset (once per tick, at its
+// start) rewinds to the first block. Blocks are kept across ticks, so once the
+// biggest tick has been seen the arena stops touching the heap; a request that
+// outgrows the current block chains another one (double the size) and the
+// blocks are merged into one of the total size at the next Reset.
+//
+// Single-threaded: the main thread's, owned by Application. Nothing allocated
+// from it may outlive the tick.
+class FrameArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t INITIAL_BLOCK_SIZE = 64 * 1024;
+
+    FrameArena() = default;
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void Reset();
+
+    size_t GetUsedBytes() const { return m_used + m_offset; }  // This tick so far
+    size_t GetHighWaterBytes() const { return m_highWater; }   // Largest tick
+    size_t GetCapacityBytes() const { return m_capacity; }
+
+private:
+    struct Block {
+        std::byte* data = nullptr;
+        size_t     size = 0;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void  do_deallocate(void*, size_t, size_t) override {}
+    bool  do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void AddBlock(size_t minimum);
+    void FreeBlocks();
+
+    std::vector<Block> m_blocks;  // m_blocks.back() is the one being filled
+    size_t m_offset    = 0;       // Into m_blocks.back()
+    size_t m_used      = 0;       // Bytes in the blocks before it
+    size_t m_capacity  = 0;
+    size_t m_highWater = 0;
+};
+
+} // namespace SP
@@ -0,0 +1,105 @@
+#include "FramePool.h"
+#include <memory_resource>
+#include <new>
+
+namespace SP {
+
+namespace {
+
+// Idle blocks kept beyond this are freed on release. Sized for the deepest
+// consumer queue (the encoder's) plus the frames in flight around it.
+constexpr size_t MAX_IDLE_BLOCKS = ENCODER_QUEUE_SIZE + 4;
+
+uint8_t* AllocateBlock(size_t bytes) {
+    return static_cast<uint8_t*>(::operator new(bytes, std::align_val_t{FramePool::ALIGNMENT}));
+}
+
+void FreeBlock(uint8_t* block) {
+    ::operator delete(block, std::align_val_t{FramePool::ALIGNMENT});
+}
+
+// The FrameBuffers' shared_ptr control blocks, recycled like the pixels so a
+// pooled Acquire does not go to the heap. Shared by every pool (the blocks are
+// all one size) and never destroyed, as a FrameBuffer may be released during
+// static destruction.
+std::pmr::memory_resource* ControlBlocks() {
+    static auto* resource = new std::pmr::synchronized_pool_resource();
+    return resource;
+}
+
+} // namespace
+
+struct FramePool::State {
+    std::mutex mutex;
+    std::vector<uint8_t*> idle;
+    size_t blockSize = 0;
+    int    allocated = 0;
+    size_t allocatedBytes = 0;
+
+    ~State() { FreeIdle(); }
+
+    void FreeIdle() {
+        for (uint8_t* block : idle) FreeBlock(block);
+        allocated -= static_cast<int>(idle.size());
+        allocatedBytes -= idle.size() * blockSize;  // Idle blocks are all of the current size
+        idle.clear();
+    }
+};
+
+FramePool::FramePool()
+    : m_state(std::make_shared<State>()) {
+}
+
+FramePool::~FramePool() {
+    Trim();
+}
+
+FrameBuffer FramePool::Acquire(size_t bytes) {
+    uint8_t* block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (bytes != m_state->blockSize) {
+            m_state->FreeIdle();
+            m_state->blockSize = bytes;
+        }
+        if (!m_state->idle.empty()) {
+            block = m_state->idle.back();
+            m_state->idle.pop_back();
+        }
+    }
+    if (!block) {
+        block = AllocateBlock(bytes);
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        ++m_state->allocated;
+        m_state->allocatedBytes += bytes;
+    }
+
+    // The deleter keeps the state alive, so late releases after ~FramePool are safe.
+    return FrameBuffer(block, [state = m_state, bytes](uint8_t* p) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (bytes == state->blockSize && state->idle.size() < MAX_IDLE_BLOCKS) {
+            state->idle.push_back(p);
+        } else {
+            FreeBlock(p);
+            --state->allocated;
+            state->allocatedBytes -= bytes;
+        }
+    }, std::pmr::polymorphic_allocator<uint8_t>(ControlBlocks()));
+}
+
+void FramePool::Trim() {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->FreeIdle();
+}
+
+int FramePool::GetAllocatedCount() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->allocated;
+}
+
+size_t FramePool::GetAllocatedBytes() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->allocatedBytes;
+}
+
+} // namespace SP
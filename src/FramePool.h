@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Refcounted handle to a FramePool block. Copies share the pixels; the block goes
+// back to its pool when the last reference is dropped.
+using FrameBuffer = std::shared_ptr<uint8_t>;
+
+// Recycles large, 64-byte-aligned pixel buffers so per-frame pixel data is never
+// reallocated (or copied into a fresh std::vector) on the decode, upload and
+// encode paths. Acquire and release are thread-safe: blocks are typically
+// acquired on a worker thread and released on the render thread.
+//
+// Blocks hold a reference to the pool's shared state, so a FrameBuffer may
+// safely outlive the FramePool that produced it (it is then simply freed).
+class FramePool {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    FramePool();
+    ~FramePool();
+
+    // Non-copyable
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Returns a block of at least `bytes`. Callers include any tail padding their
+    // consumers need (e.g. sws_scale SIMD overshoot). Requesting a different size
+    // drops idle blocks of the old size, so a resolution change does not leak.
+    FrameBuffer Acquire(size_t bytes);
+
+    // Free all idle blocks (outstanding ones are freed when released).
+    void Trim();
+
+    // Blocks currently allocated by this pool, idle or in flight.
+    int GetAllocatedCount() const;
+    size_t GetAllocatedBytes() const;
+
+private:
+    struct State;
+    std::shared_ptr<State> m_state;
+};
+
+} // namespace SP
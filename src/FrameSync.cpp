@@ -0,0 +1,300 @@
+#include "FrameSync.h"
+#include "ThreadPriority.h"
+#include "TraceRecorder.h"
+#include <winsock2.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace SP {
+
+namespace {
+
+constexpr uint32_t PACKET_MAGIC   = 0x53465053;  // "SPFS"
+constexpr uint8_t  PACKET_VERSION = 1;
+
+int64_t ToNs(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+int64_t NowNs() {
+    return ToNs(std::chrono::steady_clock::now());
+}
+
+} // namespace
+
+FrameSync::~FrameSync() {
+    Stop();
+}
+
+bool FrameSync::Start(Role role, int port) {
+    Stop();
+    m_error.clear();
+    if (role == Role::Off) return true;
+    if (!m_wsaStarted) {
+        WSADATA wsa{};
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+            m_error = "Winsock unavailable";
+            return false;
+        }
+        m_wsaStarted = true;
+    }
+
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) {
+        m_error = "Could not create a UDP socket";
+        return false;
+    }
+    const BOOL broadcast = TRUE;
+    setsockopt(s, SOL_SOCKET, SO_BROADCAST, reinterpret_cast<const char*>(&broadcast), sizeof(broadcast));
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port        = htons(static_cast<u_short>(port));
+    if (bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR) {
+        closesocket(s);
+        m_error = "UDP port " + std::to_string(port) + " is in use";
+        return false;
+    }
+
+    m_role    = role;
+    m_port    = port;
+    m_session = static_cast<uint32_t>(NowNs() ^ GetCurrentProcessId()) | 1u;  // Never 0
+    m_socket  = static_cast<uintptr_t>(s);
+    m_stop.store(false, std::memory_order_relaxed);
+    m_thread = std::thread(&FrameSync::NetworkThread, this);
+    return true;
+}
+
+void FrameSync::Stop() {
+    if (m_thread.joinable()) {
+        m_stop.store(true, std::memory_order_relaxed);
+        closesocket(static_cast<SOCKET>(m_socket));  // Wakes the blocked select
+        m_thread.join();
+        m_socket = static_cast<uintptr_t>(INVALID_SOCKET);
+    }
+    if (m_wsaStarted) {
+        WSACleanup();
+        m_wsaStarted = false;
+    }
+    m_role = Role::Off;
+    m_seen.clear();
+    m_followers.store(0, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_hasPublished  = false;
+    m_stateReceived = 0;
+    m_masterIp      = 0;
+    m_sampleCount   = 0;
+    m_servoAt       = 0;
+    m_lastBest      = 0;
+}
+
+void FrameSync::Publish(std::chrono::steady_clock::time_point shownAt, double mediaTime, double rate,
+                        double duration, int64_t frame, bool playing) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_published.type      = PacketType::State;
+    m_published.session   = m_session;
+    m_published.playing   = playing ? 1 : 0;
+    m_published.shownNs   = ToNs(shownAt);
+    m_published.mediaTime = mediaTime;
+    m_published.rate      = rate;
+    m_published.duration  = duration;
+    m_published.frame     = frame;
+    m_hasPublished = true;
+}
+
+bool FrameSync::GetTarget(std::chrono::steady_clock::time_point now, Target& target) const {
+    const int64_t local = ToNs(now);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stateReceived == 0 || local - m_stateReceived > TIMEOUT_MS * 1'000'000LL) return false;
+    if (m_sampleCount < MIN_SAMPLES || m_servoAt == 0) return false;
+    const double since = static_cast<double>(MasterNs(local) - m_state.shownNs) / 1e9;
+    target.mediaTime = m_state.mediaTime + (m_state.playing ? since * m_state.rate : 0.0);
+    target.rate      = m_state.rate;
+    target.duration  = m_state.duration;
+    target.frame     = m_state.frame;
+    target.playing   = m_state.playing != 0;
+    return true;
+}
+
+double FrameSync::GetOffsetMs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_servoAt ? m_servoOffset / 1e6 : 0.0;
+}
+
+double FrameSync::GetDelayMs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sampleCount ? static_cast<double>(m_bestDelay) / 1e6 : 0.0;
+}
+
+double FrameSync::GetDriftPpm() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_servoDrift * 1e6;
+}
+
+int64_t FrameSync::MasterNs(int64_t localNs) const {
+    return localNs + std::llround(m_servoOffset + m_servoDrift * static_cast<double>(localNs - m_servoAt));
+}
+
+void FrameSync::NetworkThread() {
+    TraceRecorder::SetThreadName("Frame sync");
+    // Receive times are taken here: time spent descheduled would read as network delay
+    ThreadPriority::Apply(ThreadRole::Render);
+    const SOCKET s = static_cast<SOCKET>(m_socket);
+    const bool master = m_role == Role::Master;
+    const int64_t interval = (master ? STATE_INTERVAL_MS : PING_INTERVAL_MS) * 1'000'000LL;
+    int64_t nextSend = 0;
+    char buffer[256];
+
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        int64_t now = NowNs();
+        if (now >= nextSend) {
+            nextSend = now + interval;
+            Packet packet;
+            uint32_t ip = 0;
+            uint16_t port = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (master && m_hasPublished) {
+                    packet = m_published;
+                    ip     = htonl(INADDR_BROADCAST);
+                    port   = htons(static_cast<u_short>(m_port));
+                } else if (!master && m_masterIp) {
+                    packet.type    = PacketType::Ping;
+                    packet.session = m_state.session;
+                    ip   = m_masterIp;
+                    port = m_masterPort;
+                }
+            }
+            if (ip) Send(packet, ip, port);
+            if (master) {
+                // Followers that stopped pinging are gone
+                std::erase_if(m_seen, [now](const auto& seen) { return now - seen.second > TIMEOUT_MS * 1'000'000LL; });
+                m_followers.store(static_cast<int>(m_seen.size()), std::memory_order_relaxed);
+            }
+            now = NowNs();
+        }
+
+        // Wait for a packet until the next send is due
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(s, &readable);
+        const int64_t waitUs = std::max<int64_t>((nextSend - now) / 1000, 0);
+        timeval timeout{static_cast<long>(waitUs / 1'000'000), static_cast<long>(waitUs % 1'000'000)};
+        const int ready = select(0, &readable, nullptr, nullptr, &timeout);
+        if (ready == SOCKET_ERROR) break;  // Closed by Stop
+        if (ready == 0) continue;
+
+        sockaddr_in from{};
+        int fromLength = sizeof(from);
+        const int received = recvfrom(s, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &fromLength);
+        const int64_t receivedNs = NowNs();
+        if (received == SOCKET_ERROR) {
+            const int error = WSAGetLastError();
+            // Oversized datagram, or an ICMP port-unreachable from a ping whose master is gone
+            if (error == WSAEMSGSIZE || error == WSAECONNRESET) continue;
+            break;
+        }
+        if (received != static_cast<int>(sizeof(Packet))) continue;
+        Packet packet;
+        std::memcpy(&packet, buffer, sizeof(packet));
+        if (packet.magic != PACKET_MAGIC || packet.version != PACKET_VERSION) continue;
+        m_packets.fetch_add(1, std::memory_order_relaxed);
+        Receive(packet, from.sin_addr.s_addr, from.sin_port, receivedNs);
+    }
+}
+
+void FrameSync::Receive(const Packet& packet, uint32_t fromIp, uint16_t fromPort, int64_t receivedNs) {
+    if (m_role == Role::Master) {
+        if (packet.type != PacketType::Ping) return;  // Its own broadcasts come back too
+        Packet pong = packet;
+        pong.type    = PacketType::Pong;
+        pong.session = m_session;
+        pong.t2      = receivedNs;
+        Send(pong, fromIp, fromPort);
+
+        const uint64_t key = (static_cast<uint64_t>(fromIp) << 16) | fromPort;
+        auto seen = std::find_if(m_seen.begin(), m_seen.end(), [key](const auto& entry) { return entry.first == key; });
+        if (seen != m_seen.end()) {
+            seen->second = receivedNs;
+        } else if (static_cast<int>(m_seen.size()) < MAX_FOLLOWERS) {
+            m_seen.emplace_back(key, receivedNs);
+        }
+        return;
+    }
+
+    if (packet.type == PacketType::State) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (packet.session != m_state.session || m_stateReceived == 0) {
+            // A new master, or the old one restarted: its clock is measured afresh
+            m_sampleCount = 0;
+            m_servoAt     = 0;
+            m_lastBest    = 0;
+        }
+        m_state         = packet;
+        m_stateReceived = receivedNs;
+        m_masterIp      = fromIp;
+        m_masterPort    = fromPort;
+    } else if (packet.type == PacketType::Pong) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stateReceived == 0 || packet.session != m_state.session) return;
+        }
+        AddSample(packet.t1, packet.t2, packet.t3, receivedNs);
+    }
+}
+
+void FrameSync::Send(Packet& packet, uint32_t ip, uint16_t port) {
+    packet.magic    = PACKET_MAGIC;
+    packet.version  = PACKET_VERSION;
+    packet.sequence = ++m_sequence;
+    // The timestamp goes as late as it can, so the master's turnaround isn't counted as path delay
+    if (packet.type == PacketType::Ping) packet.t1 = NowNs();
+    if (packet.type == PacketType::Pong) packet.t3 = NowNs();
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = ip;
+    addr.sin_port        = port;
+    sendto(static_cast<SOCKET>(m_socket), reinterpret_cast<const char*>(&packet), sizeof(packet), 0,
+           reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+}
+
+void FrameSync::AddSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+    // t1 and t4 on this clock, t2 and t3 on the master's
+    const int64_t delay  = (t4 - t1) - (t3 - t2);
+    const int64_t offset = ((t2 - t1) + (t3 - t4)) / 2;
+    if (delay < 0) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_samples[m_sampleCount++ % SAMPLE_WINDOW] = {t4, offset, delay};
+    const int count = std::min(m_sampleCount, SAMPLE_WINDOW);
+    const Sample* best = &m_samples[0];
+    for (int i = 1; i < count; ++i) {
+        if (m_samples[i].delay < best->delay) best = &m_samples[i];
+    }
+    m_bestDelay = best->delay;
+    // Still the best one: nothing new was learned. Older than the last update:
+    // the better ones have left the window, and it says nothing about now.
+    if (best->local == m_lastBest || best->local <= m_servoAt) return;
+    m_lastBest = best->local;
+
+    if (m_servoAt == 0) {
+        m_servoOffset = static_cast<double>(best->offset);
+        m_servoDrift  = 0.0;
+        m_servoAt     = best->local;
+        return;
+    }
+    const double elapsed   = static_cast<double>(best->local - m_servoAt);
+    const double predicted = m_servoOffset + m_servoDrift * elapsed;
+    const double error     = static_cast<double>(best->offset) - predicted;
+    if (std::abs(error) > STEP_SECONDS * 1e9) {
+        // One of the clocks stepped (a sleep, a time service on the master): start over from here
+        m_servoOffset = static_cast<double>(best->offset);
+    } else {
+        m_servoDrift  = std::clamp(m_servoDrift + SERVO_KI * error / elapsed, -MAX_DRIFT, MAX_DRIFT);
+        m_servoOffset = predicted + SERVO_KP * error;
+    }
+    m_servoAt = best->local;
+}
+
+} // namespace SP
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Frame-accurate playback across the machines of a video wall, without genlock
+// hardware. One node is the master: it broadcasts its playback clock (a media
+// time and the master's steady clock at which that time was on screen) and
+// answers timing pings. Every other node is a follower: it pings the master,
+// estimates the offset and drift between the two steady clocks from the
+// round trips, PTP style, and so knows at any local instant what media time
+// the master is showing. Application drives its frame selection from that
+// clock (as the audio clock drives it in audio-master sync) so each node
+// shows the matching frame on its next vsync; render-ahead, where on, keeps
+// a network hitch off the screen.
+//
+// The servo: of the last SAMPLE_WINDOW round trips the one with the shortest
+// delay is the least queued and its offset is the best measurement. Each new
+// best feeds a PI loop: the proportional term pulls the offset in, the
+// integral term learns the drift between the crystals, so between pings (and
+// across a few lost ones) the estimate runs on instead of holding still.
+//
+// Packets are this program's POD structs on x86-64 (both ends little-endian).
+// The network thread runs at the Render role: the timestamps are taken on it,
+// and time it spends descheduled reads as network delay. Start and Stop are
+// main-thread calls.
+class FrameSync {
+public:
+    static constexpr int    STATE_INTERVAL_MS = 20;     // Master's clock broadcast
+    static constexpr int    PING_INTERVAL_MS  = 200;    // Follower's round trips
+    static constexpr int    SAMPLE_WINDOW     = 8;
+    static constexpr int    MIN_SAMPLES       = 4;      // Round trips before a follower locks
+    static constexpr int    TIMEOUT_MS        = 1000;   // Master silent this long: unlocked
+    static constexpr double SERVO_KP          = 0.5;
+    static constexpr double SERVO_KI          = 0.1;
+    static constexpr double MAX_DRIFT         = 500e-6; // Crystals are within ±100 ppm; leave room
+    static constexpr double STEP_SECONDS      = 0.05;   // An offset error beyond this is a clock step: reset
+    static constexpr int    MAX_FOLLOWERS     = 64;
+
+    enum class Role { Off, Master, Follower };
+
+    // What a follower knows of the master at a local instant
+    struct Target {
+        double mediaTime = 0.0;
+        double rate      = 1.0;
+        double duration  = 0.0;  // Master's clip length, 0 for none
+        int64_t frame    = 0;
+        bool   playing   = false;
+    };
+
+    FrameSync() = default;
+    ~FrameSync();
+
+    FrameSync(const FrameSync&) = delete;
+    FrameSync& operator=(const FrameSync&) = delete;
+
+    // Binds UDP `port` on all interfaces; the master broadcasts to the same port.
+    // False with GetError() set when the port could not be bound.
+    bool Start(Role role, int port);
+    void Stop();
+    bool IsRunning() const { return m_thread.joinable(); }
+    Role GetRole() const { return m_role; }
+    const std::string& GetError() const { return m_error; }
+
+    // Master, once per tick: media time `mediaTime` was on screen at `shownAt`
+    void Publish(std::chrono::steady_clock::time_point shownAt, double mediaTime, double rate,
+                 double duration, int64_t frame, bool playing);
+
+    // Follower: the master's playback at local `now`. False until locked (or
+    // after the master went silent).
+    bool GetTarget(std::chrono::steady_clock::time_point now, Target& target) const;
+
+    // Status, for the panel
+    int    GetFollowers() const { return m_followers.load(std::memory_order_relaxed); }  // Master: seen in the last TIMEOUT_MS
+    double GetOffsetMs() const;   // Follower: master clock minus local clock
+    double GetDelayMs() const;    // Follower: best round trip in the window
+    double GetDriftPpm() const;
+    int64_t GetPackets() const { return m_packets.load(std::memory_order_relaxed); }
+
+private:
+    enum class PacketType : uint8_t { State, Ping, Pong };
+    struct Packet {
+        uint32_t   magic    = 0;
+        uint8_t    version  = 0;
+        PacketType type     = PacketType::State;
+        uint8_t    playing  = 0;
+        uint8_t    reserved = 0;
+        uint32_t   session  = 0;
+        uint32_t   sequence = 0;
+        int64_t    t1 = 0, t2 = 0, t3 = 0;  // Ping: t1 sent. Pong: t1 echoed, t2 received, t3 sent (master clock)
+        int64_t    shownNs   = 0;  // State: master clock at which mediaTime was on screen
+        double     mediaTime = 0.0;
+        double     rate      = 1.0;
+        double     duration  = 0.0;
+        int64_t    frame     = 0;
+    };
+    struct Sample {
+        int64_t local  = 0;  // Follower's clock at the reply
+        int64_t offset = 0;
+        int64_t delay  = 0;
+    };
+
+    void NetworkThread();
+    void Receive(const Packet& packet, uint32_t fromIp, uint16_t fromPort, int64_t receivedNs);
+    void Send(Packet& packet, uint32_t ip, uint16_t port);  // Network byte order
+    void AddSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+    int64_t MasterNs(int64_t localNs) const;  // m_mutex held
+
+    Role              m_role = Role::Off;
+    uintptr_t         m_socket = ~static_cast<uintptr_t>(0);  // SOCKET; INVALID_SOCKET when closed
+    bool              m_wsaStarted = false;
+    int               m_port = 0;
+    uint32_t          m_session = 0;  // Master's; a new one resets the followers
+    std::thread       m_thread;
+    std::atomic<bool> m_stop{false};
+    std::string       m_error;
+
+    std::atomic<int>     m_followers{0};
+    std::atomic<int64_t> m_packets{0};
+
+    uint32_t m_sequence = 0;  // Network thread only
+
+    // Master, network thread only: followers by address, with when each last pinged
+    std::vector<std::pair<uint64_t, int64_t>> m_seen;
+
+    mutable std::mutex m_mutex;  // Everything below
+    // Master: the clock Publish last gave
+    Packet   m_published;
+    bool     m_hasPublished = false;
+    // Follower: the master's last broadcast and the servo
+    Packet   m_state;
+    int64_t  m_stateReceived = 0;     // Local ns; 0 = none
+    uint32_t m_masterIp   = 0;        // Network byte order
+    uint16_t m_masterPort = 0;
+    Sample   m_samples[SAMPLE_WINDOW];
+    int      m_sampleCount = 0;
+    int64_t  m_servoAt = 0;           // Local ns of the last servo update; 0 = not started
+    double   m_servoOffset = 0.0;     // ns at m_servoAt
+    double   m_servoDrift = 0.0;
+    int64_t  m_bestDelay = 0;
+    int64_t  m_lastBest = 0;          // Local ns of the sample the servo last took
+};
+
+} // namespace SP
@@ -0,0 +1,190 @@
+#include "FrameWatchdog.h"
+#include "ThreadPriority.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+
+namespace SP {
+
+namespace {
+
+constexpr const char* LEVEL_NAMES[static_cast<int>(WatchdogLevel::Count)] = {
+    "Normal", "Low resolution", "Defaults", "Passthrough",
+};
+
+// Stages a stalled GPU surfaces in: the frame-latency wait, uploads that map a
+// busy resource, the draws and readbacks, and the presents
+bool GpuBoundStage(CpuStage stage) {
+    switch (stage) {
+    case CpuStage::LatencyWait:
+    case CpuStage::Upload:
+    case CpuStage::Render:
+    case CpuStage::UiDraw:
+    case CpuStage::Present:
+    case CpuStage::Background:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+const char* FrameWatchdog::LevelName(WatchdogLevel level) {
+    return LEVEL_NAMES[static_cast<int>(level)];
+}
+
+FrameWatchdog::~FrameWatchdog() {
+    Stop();
+}
+
+void FrameWatchdog::Start(const Settings& settings, const std::string& logPath, const CpuProfiler& profiler) {
+    Stop();
+    SetSettings(settings);
+    m_profiler  = &profiler;
+    m_logPath   = logPath;
+    m_startTime = Clock::now();
+    m_beatNs.store(0, std::memory_order_relaxed);  // A stall is timed from the first tick after this
+    m_stop = false;
+    m_thread = std::thread(&FrameWatchdog::WatchThread, this);
+}
+
+void FrameWatchdog::Stop() {
+    if (!m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+void FrameWatchdog::SetSettings(const Settings& settings) {
+    m_stallMs.store(std::max(settings.stallMs, MIN_STALL_MS), std::memory_order_relaxed);
+    m_gpuLimitMs.store(settings.gpuMs, std::memory_order_relaxed);
+}
+
+void FrameWatchdog::Beat(bool armed) {
+    m_armed.store(armed, std::memory_order_relaxed);
+    m_beatNs.store(NowNs(), std::memory_order_release);
+}
+
+void FrameWatchdog::ReportGpu(const GpuFrameTiming& latest) {
+    m_gpuMs.store(latest.totalMs, std::memory_order_relaxed);
+    m_gpuFrame.store(latest.frame, std::memory_order_release);
+}
+
+void FrameWatchdog::Reset() {
+    const int previous = m_level.exchange(static_cast<int>(WatchdogLevel::Normal), std::memory_order_acq_rel);
+    if (previous != static_cast<int>(WatchdogLevel::Normal)) Report(WatchdogLevel::Normal, "Reset");
+}
+
+std::vector<FrameWatchdog::Event> FrameWatchdog::GetEvents() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_events;
+}
+
+void FrameWatchdog::GetEvents(std::vector<Event>& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out.assign(m_events.begin(), m_events.end());  // Element-wise: the strings keep their buffers
+}
+
+void FrameWatchdog::WatchThread() {
+    TraceRecorder::SetThreadName("Frame watchdog");
+    // Must get to run while the main thread spins on a stalled GPU
+    ThreadPriority::Apply(ThreadRole::Render);
+
+    bool    inStall     = false;
+    int64_t stallBeat   = 0;
+    int64_t lastFrame   = -1;
+    int     strikes     = 0;
+    int64_t settleUntil = -1;
+    char text[160];
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_wake.wait_for(lock, std::chrono::milliseconds(POLL_MS), [this] { return m_stop; })) {
+        lock.unlock();
+
+        // Heartbeat: the tick that began at the last Beat is still running
+        const int64_t beat = m_beatNs.load(std::memory_order_acquire);
+        const double  ageMs = beat ? (NowNs() - beat) / 1e6 : 0.0;
+        if (inStall && beat != stallBeat) {
+            inStall = false;
+            snprintf(text, sizeof(text), "Main loop recovered after %.1f s", (beat - stallBeat) / 1e9);
+            Report(GetLevel(), text);
+        } else if (!inStall && beat && ageMs > m_stallMs.load(std::memory_order_relaxed)) {
+            inStall   = true;
+            stallBeat = beat;
+            m_stalls.fetch_add(1, std::memory_order_relaxed);
+            CpuStage stage = CpuStage::LatencyWait;
+            const bool inStage = m_profiler->GetActiveStage(stage);
+            snprintf(text, sizeof(text), "Main loop stalled %.0f ms in %s", ageMs,
+                     inStage ? CpuProfiler::StageName(stage) : "no stage");
+            if (!m_armed.load(std::memory_order_relaxed))
+                Report(GetLevel(), std::string(text) + " (export or benchmark: not stepped)");
+            else if (inStage && GpuBoundStage(stage))
+                Step(text);
+            else
+                Report(GetLevel(), text);
+        }
+
+        // GPU time of each newly resolved frame
+        const int64_t frame = m_gpuFrame.load(std::memory_order_acquire);
+        if (frame != lastFrame) {
+            lastFrame = frame;
+            const float ms    = m_gpuMs.load(std::memory_order_relaxed);
+            const float limit = m_gpuLimitMs.load(std::memory_order_relaxed);
+            strikes = ms > limit ? strikes + 1 : 0;
+            if (strikes >= GPU_STRIKES && frame >= settleUntil && m_armed.load(std::memory_order_relaxed)) {
+                snprintf(text, sizeof(text), "GPU frames over %.0f ms (last %.0f ms)", limit, ms);
+                Step(text);
+                strikes     = 0;
+                settleUntil = frame + SETTLE_FRAMES;
+            }
+        }
+
+        lock.lock();
+    }
+}
+
+void FrameWatchdog::Step(const std::string& cause) {
+    int level = m_level.load(std::memory_order_relaxed);
+    const int top = static_cast<int>(WatchdogLevel::Passthrough);
+    while (level < top && !m_level.compare_exchange_weak(level, level + 1, std::memory_order_acq_rel)) {}
+    const WatchdogLevel now = static_cast<WatchdogLevel>(std::min(level + 1, top));
+    Report(now, cause + (level < top ? std::string(": stepped to ") + LevelName(now) : ": already at passthrough"));
+}
+
+void FrameWatchdog::Report(WatchdogLevel level, const std::string& text) {
+    Event event;
+    event.time  = std::chrono::duration<double>(Clock::now() - m_startTime).count();
+    event.level = level;
+    event.text  = text;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_events.size() >= MAX_EVENTS) m_events.erase(m_events.begin());
+        m_events.push_back(event);
+    }
+
+    // The file is the report an operator finds the next morning; opened per line
+    // so a hang that ends in a TDR or a kill still leaves it complete
+    char line[256];
+    const std::time_t wall = std::time(nullptr);
+    std::tm local{};
+    localtime_s(&local, &wall);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(line, sizeof(line), "%s  [%s] %s\n", stamp, LevelName(level), text.c_str());
+    OutputDebugStringA(line);
+    if (m_logPath.empty()) return;
+    std::ofstream file(m_logPath, std::ios::app);
+    file << line;
+}
+
+} // namespace SP
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Common.h"
+#include "CpuProfiler.h"
+#include "GpuProfiler.h"
+#include <condition_variable>
+
+namespace SP {
+
+// How far the watchdog has stepped the active shader down, mildest first. Each
+// level keeps the ones before it (Defaults still renders at the lowest scale).
+enum class WatchdogLevel {
+    Normal,
+    LowResolution,  // Render scale pinned at DynamicResolution::MIN_SCALE
+    Defaults,       // Active preset's params back at their defaults, keyframes held
+    Passthrough,    // No shader
+    Count
+};
+
+// Keeps an unattended installation live when the active shader (a runaway loop
+// count, a param driven to an extreme) or the GPU behind it stalls the main loop.
+// Its own thread polls two signals every POLL_MS: the main loop's heartbeat
+// (Beat, once per tick) and the GPU time of each resolved frame (ReportGpu).
+// A tick that has run longer than Settings::stallMs inside a stage where GPU
+// work surfaces, or GPU_STRIKES resolved frames in a row over Settings::gpuMs,
+// raise the level one step. A hung main thread can't change anything, so the
+// thread only records the step and writes the report (the log file and the
+// event list) as the stall happens; Application applies the level when the
+// tick returns. Stalls in other stages (decode, file watching) are reported
+// without a step: a cheaper shader would not shorten them.
+//
+// The level only goes down through Reset (the operator, or another preset
+// picked). Start, Stop, Reset and SetSettings are main-thread calls.
+class FrameWatchdog {
+public:
+    static constexpr int POLL_MS       = 100;
+    static constexpr int GPU_STRIKES   = 3;   // Consecutive resolved frames over the GPU limit
+    static constexpr int SETTLE_FRAMES = 8;   // Resolved frames after a step before GPU time may step again
+    static constexpr int MAX_EVENTS    = 32;
+    static constexpr int MIN_STALL_MS  = 250;
+
+    struct Settings {
+        int   stallMs = 1000;  // Main-loop tick length counted as a stall
+        float gpuMs   = 200.0f;
+    };
+    struct Event {
+        double        time = 0.0;  // Seconds since Start
+        WatchdogLevel level = WatchdogLevel::Normal;  // After the event
+        std::string   text;
+    };
+
+    static const char* LevelName(WatchdogLevel level);
+
+    FrameWatchdog() = default;
+    ~FrameWatchdog();
+
+    FrameWatchdog(const FrameWatchdog&) = delete;
+    FrameWatchdog& operator=(const FrameWatchdog&) = delete;
+
+    // Reports are appended to `logPath` (empty = none). `profiler` names the
+    // stage a stall is in and must outlive the watchdog.
+    void Start(const Settings& settings, const std::string& logPath, const CpuProfiler& profiler);
+    void Stop();
+    bool IsRunning() const { return m_thread.joinable(); }
+    void SetSettings(const Settings& settings);
+
+    // Main thread, once per tick. Unarmed (export, benchmark, session replay:
+    // slow frames by design) stalls are still reported but never step.
+    void Beat(bool armed);
+    void ReportGpu(const GpuFrameTiming& latest);
+
+    WatchdogLevel GetLevel() const { return static_cast<WatchdogLevel>(m_level.load(std::memory_order_acquire)); }
+    void Reset();
+
+    int64_t GetStalls() const { return m_stalls.load(std::memory_order_relaxed); }
+    std::vector<Event> GetEvents() const;  // Oldest first
+    void GetEvents(std::vector<Event>& out) const;  // Same, into `out`'s storage
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void WatchThread();
+    void Step(const std::string& cause);  // Watchdog thread
+    void Report(WatchdogLevel level, const std::string& text);
+
+    std::atomic<int64_t> m_beatNs{0};  // Clock::time_since_epoch of the last Beat; 0 = none yet
+    std::atomic<bool>    m_armed{true};
+    std::atomic<int64_t> m_gpuFrame{-1};
+    std::atomic<float>   m_gpuMs{0.0f};
+    std::atomic<int>     m_stallMs{1000};
+    std::atomic<float>   m_gpuLimitMs{200.0f};
+    std::atomic<int>     m_level{static_cast<int>(WatchdogLevel::Normal)};
+    std::atomic<int64_t> m_stalls{0};
+
+    const CpuProfiler* m_profiler = nullptr;
+    std::string        m_logPath;
+    Clock::time_point  m_startTime;
+
+    std::thread             m_thread;
+    bool                    m_stop = false;  // Guarded by m_mutex
+    mutable std::mutex      m_mutex;         // Also guards m_events
+    std::condition_variable m_wake;
+    std::vector<Event>      m_events;
+};
+
+} // namespace SP
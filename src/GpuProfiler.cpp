@@ -0,0 +1,237 @@
+#include "GpuProfiler.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+
+namespace SP {
+
+namespace {
+
+constexpr const char* STAGE_NAMES[GPU_STAGE_COUNT] = {
+    "Upload", "Shader", "Compositor", "Display", "Post chains", "Output window", "Spout", "NDI", "Virtual camera",
+    "Readback", "ImGui",
+};
+
+float TicksToMs(UINT64 begin, UINT64 end, double frequency) {
+    if (end <= begin) return 0.0f;
+    return static_cast<float>(static_cast<double>(end - begin) * 1000.0 / frequency);
+}
+
+} // namespace
+
+const char* GpuProfiler::StageName(GpuStage stage) {
+    return STAGE_NAMES[static_cast<int>(stage)];
+}
+
+bool GpuProfiler::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+    Shutdown();
+    if (!device || !context) return false;
+    m_device  = device;
+    m_context = context;
+
+    D3D11_QUERY_DESC disjointDesc = {};
+    disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+    for (FrameQueries& queries : m_frames) {
+        if (FAILED(m_device->CreateQuery(&disjointDesc, &queries.disjoint)) ||
+            !CreateTimestamp(queries.begin) || !CreateTimestamp(queries.end)) {
+            Shutdown();
+            return false;
+        }
+    }
+    return true;
+}
+
+void GpuProfiler::Shutdown() {
+    for (FrameQueries& queries : m_frames) queries = FrameQueries{};
+    m_device  = nullptr;
+    m_context = nullptr;
+    m_inFrame = false;
+    m_current = 0;
+}
+
+bool GpuProfiler::CreateTimestamp(ComPtr<ID3D11Query>& query) {
+    if (query) return true;
+    D3D11_QUERY_DESC desc = {};
+    desc.Query = D3D11_QUERY_TIMESTAMP;
+    return SUCCEEDED(m_device->CreateQuery(&desc, &query));
+}
+
+void GpuProfiler::BeginFrame() {
+    if (!m_enabled || !m_context || m_inFrame) return;
+
+    // Oldest first, so the history stays in frame order
+    for (int i = 1; i <= FRAME_LATENCY; ++i) {
+        FrameQueries& queries = m_frames[(m_current + i) % FRAME_LATENCY];
+        if (queries.pending && !Resolve(queries)) break;
+    }
+
+    FrameQueries& queries = m_frames[m_current];
+    if (queries.pending) {
+        // Still not done FRAME_LATENCY frames on: reissuing drops its results
+        queries.pending = false;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_skipped;
+    }
+    queries.used  = 0;
+    queries.open  = -1;
+    queries.frame = m_frameCount;
+    queries.cpuBegin = std::chrono::steady_clock::now();
+    m_context->Begin(queries.disjoint.Get());
+    m_context->End(queries.begin.Get());
+    m_inFrame = true;
+}
+
+void GpuProfiler::EndFrame() {
+    if (!m_inFrame) return;
+    FrameQueries& queries = m_frames[m_current];
+    if (queries.open >= 0) m_context->End(queries.intervals[queries.open].end.Get());
+    queries.open = -1;
+    m_context->End(queries.end.Get());
+    m_context->End(queries.disjoint.Get());
+    queries.pending = true;
+    m_inFrame = false;
+    m_current = (m_current + 1) % FRAME_LATENCY;
+    ++m_frameCount;
+}
+
+void GpuProfiler::BeginStage(GpuStage stage) {
+    if (!m_inFrame) return;
+    FrameQueries& queries = m_frames[m_current];
+    if (queries.open >= 0 || queries.used >= MAX_INTERVALS) return;
+    Interval& interval = queries.intervals[queries.used];
+    if (!CreateTimestamp(interval.begin) || !CreateTimestamp(interval.end)) return;
+    interval.stage = stage;
+    m_context->End(interval.begin.Get());
+    queries.open = queries.used++;
+}
+
+void GpuProfiler::EndStage(GpuStage stage) {
+    if (!m_inFrame) return;
+    FrameQueries& queries = m_frames[m_current];
+    if (queries.open < 0 || queries.intervals[queries.open].stage != stage) return;
+    m_context->End(queries.intervals[queries.open].end.Get());
+    queries.open = -1;
+}
+
+bool GpuProfiler::Resolve(FrameQueries& queries) {
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint = {};
+    if (m_context->GetData(queries.disjoint.Get(), &disjoint, sizeof(disjoint),
+                           D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+        return false;
+    }
+    queries.pending = false;
+
+    // The timestamps were issued before the disjoint query ended, so they are done too
+    auto read = [&](ID3D11Query* query, UINT64& out) {
+        return m_context->GetData(query, &out, sizeof(out), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+    };
+    GpuFrameTiming timing;
+    timing.frame = queries.frame;
+    UINT64 begin = 0, end = 0;
+    bool valid = !disjoint.Disjoint && disjoint.Frequency > 0 &&
+                 read(queries.begin.Get(), begin) && read(queries.end.Get(), end);
+    const double frequency = static_cast<double>(disjoint.Frequency);
+    // On the trace's GPU track the frame starts where its first timestamp was issued:
+    // GPU clocks have no common origin with the CPU's, so this is the closest anchor
+    TraceRecorder& trace = TraceRecorder::Get();
+    auto cpuTime = [&](UINT64 ticks) {
+        const double ms = (ticks > begin) ? static_cast<double>(ticks - begin) * 1000.0 / frequency : 0.0;
+        return queries.cpuBegin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                      std::chrono::duration<double, std::milli>(ms));
+    };
+    for (int i = 0; valid && i < queries.used; ++i) {
+        UINT64 stageBegin = 0, stageEnd = 0;
+        valid = read(queries.intervals[i].begin.Get(), stageBegin) &&
+                read(queries.intervals[i].end.Get(), stageEnd);
+        if (!valid) break;
+        const GpuStage stage = queries.intervals[i].stage;
+        timing.ms[static_cast<int>(stage)] += TicksToMs(stageBegin, stageEnd, frequency);
+        trace.RecordGpu(StageName(stage), cpuTime(stageBegin), cpuTime(stageEnd));
+    }
+    if (!valid) {
+        // Clock changed mid-frame (power state) or a query was lost
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_skipped;
+        return true;
+    }
+    timing.totalMs = TicksToMs(begin, end, frequency);
+    for (int s = 0; s < GPU_STAGE_COUNT; ++s) trace.Plot(STAGE_NAMES[s], timing.ms[s]);
+    trace.Plot("GPU frame", timing.totalMs);
+    Record(timing, frequency);
+    return true;
+}
+
+void GpuProfiler::Record(const GpuFrameTiming& timing, double frequency) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_history[m_next] = timing;
+    m_next = (m_next + 1) % HISTORY_SIZE;
+    ++m_resolved;
+    m_frequency = frequency;
+}
+
+void GpuProfiler::Reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_next     = 0;
+    m_resolved = 0;
+    m_skipped  = 0;
+}
+
+bool GpuProfiler::GetLatest(GpuFrameTiming& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_resolved == 0) return false;
+    out = m_history[(m_next - 1 + HISTORY_SIZE) % HISTORY_SIZE];
+    return true;
+}
+
+void GpuProfiler::GetFramesSince(int64_t firstFrame, std::vector<GpuFrameTiming>& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const int size = static_cast<int>(std::min<int64_t>(m_resolved, HISTORY_SIZE));
+    for (int i = 0; i < size; ++i) {
+        const GpuFrameTiming& timing = m_history[(m_next - size + i + HISTORY_SIZE) % HISTORY_SIZE];
+        if (timing.frame >= firstFrame) out.push_back(timing);
+    }
+}
+
+GpuProfiler::Snapshot GpuProfiler::GetSnapshot() const {
+    Snapshot snapshot;
+    GetSnapshot(snapshot);
+    return snapshot;
+}
+
+void GpuProfiler::GetSnapshot(Snapshot& out, std::pmr::memory_resource* scratch) const {
+    out.stages = {};
+    out.total  = StageStats{};
+    out.totalMs.clear();
+    std::pmr::vector<GpuFrameTiming> frames(scratch);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out.frames    = m_resolved;
+        out.skipped   = m_skipped;
+        out.frequency = m_frequency;
+        const int size = static_cast<int>(std::min<int64_t>(m_resolved, HISTORY_SIZE));
+        frames.reserve(size);
+        for (int i = 0; i < size; ++i) {
+            frames.push_back(m_history[(m_next - size + i + HISTORY_SIZE) % HISTORY_SIZE]);
+        }
+    }
+    if (frames.empty()) return;
+
+    auto accumulate = [&](StageStats& stats, auto msOf) {
+        double sum = 0.0;
+        for (const GpuFrameTiming& frame : frames) {
+            const float ms = msOf(frame);
+            sum += ms;
+            stats.maxMs = std::max(stats.maxMs, ms);
+        }
+        stats.lastMs = msOf(frames.back());
+        stats.avgMs  = static_cast<float>(sum / frames.size());
+    };
+    for (int s = 0; s < GPU_STAGE_COUNT; ++s) {
+        accumulate(out.stages[s], [s](const GpuFrameTiming& frame) { return frame.ms[s]; });
+    }
+    accumulate(out.total, [](const GpuFrameTiming& frame) { return frame.totalMs; });
+
+    out.totalMs.reserve(frames.size());
+    for (const GpuFrameTiming& frame : frames) out.totalMs.push_back(frame.totalMs);
+}
+
+} // namespace SP
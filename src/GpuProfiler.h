@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Common.h"
+#include <array>
+#include <chrono>
+#include <memory_resource>
+
+namespace SP {
+
+// GPU work of one frame, in submission order. Upload is t0 and the extra inputs
+// (copies and YUV passes); Shader the user preset (every pass, kernel and the
+// frame-history push); Compositor the blend pass; Display the backbuffer draw of
+// EndFrame; OutputWindow, Spout, Ndi, VirtualCamera and Readback the outputs (Ndi
+// and VirtualCamera are their UYVY and NV12 conversions; Readback includes the GPU
+// YUV and NV12 conversions of recording); ImGui the UI draw.
+enum class GpuStage {
+    Upload, Shader, Compositor, Display, Post, OutputWindow, Spout, Ndi, VirtualCamera, Readback, ImGui, Count
+};
+constexpr int GPU_STAGE_COUNT = static_cast<int>(GpuStage::Count);
+
+// One resolved frame. A stage entered several times in a frame is summed; ms
+// is 0 for stages that did not run.
+struct GpuFrameTiming {
+    std::array<float, GPU_STAGE_COUNT> ms{};
+    float   totalMs = 0.0f;  // First to last timestamp of the frame
+    int64_t frame   = 0;     // BeginFrame count when it was recorded
+};
+
+// D3D11 timestamp profiler. Every frame gets a disjoint query and a timestamp pair
+// per stage interval; the results are read back FRAME_LATENCY frames later without
+// flushing, so measuring never stalls the pipeline. A frame whose queries are not
+// done when its slot comes round again is skipped rather than waited for.
+// Recorded on the render thread; GetSnapshot, GetLatest and GetFramesSince may be
+// called from any thread (the benchmark harness polls them).
+class GpuProfiler {
+public:
+    static constexpr int FRAME_LATENCY = 4;   // Frames in flight
+    static constexpr int MAX_INTERVALS = 32;  // Stage intervals per frame
+    static constexpr int HISTORY_SIZE  = 240;
+
+    struct StageStats {
+        float lastMs = 0.0f;
+        float avgMs  = 0.0f;
+        float maxMs  = 0.0f;
+    };
+    struct Snapshot {
+        std::array<StageStats, GPU_STAGE_COUNT> stages{};
+        StageStats total;
+        std::vector<float> totalMs;  // Oldest first
+        int64_t frames  = 0;         // Resolved since Reset
+        int64_t skipped = 0;         // Disjoint, or not done in time
+        double  frequency = 0.0;     // Timestamp ticks per second of the last frame
+    };
+
+    GpuProfiler() = default;
+    ~GpuProfiler() { Shutdown(); }
+
+    // Non-copyable
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    static const char* StageName(GpuStage stage);
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+    void Shutdown();
+
+    // Off: no queries are issued and the history stops
+    void SetEnabled(bool enabled) { m_enabled = enabled; }
+    bool IsEnabled() const { return m_enabled; }
+
+    // Bracket everything the frame submits. BeginFrame first resolves whatever
+    // earlier frames have finished.
+    void BeginFrame();
+    void EndFrame();
+
+    // Stage intervals must not nest (they would be counted twice). Outside
+    // BeginFrame/EndFrame, or past MAX_INTERVALS, they are ignored.
+    void BeginStage(GpuStage stage);
+    void EndStage(GpuStage stage);
+
+    // Brackets a stage for the lifetime of the scope
+    class Scope {
+    public:
+        Scope(GpuProfiler& profiler, GpuStage stage) : m_profiler(profiler), m_stage(stage) {
+            m_profiler.BeginStage(m_stage);
+        }
+        ~Scope() { m_profiler.EndStage(m_stage); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        GpuProfiler& m_profiler;
+        GpuStage     m_stage;
+    };
+
+    void Reset();  // Clears the history and counters; queries in flight still land
+    Snapshot GetSnapshot() const;
+    // Fills `out` reusing its vectors' storage; `scratch` backs the temporaries
+    void GetSnapshot(Snapshot& out, std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) const;
+    bool GetLatest(GpuFrameTiming& out) const;  // False until a frame has resolved
+    // Appends the resolved frames numbered `firstFrame` or later still in the
+    // history, oldest first. Poll at least every HISTORY_SIZE frames to see them all.
+    void GetFramesSince(int64_t firstFrame, std::vector<GpuFrameTiming>& out) const;
+    int64_t GetFrameCount() const { return m_frameCount; }  // Frame being recorded (render thread)
+
+private:
+    struct Interval {
+        GpuStage stage = GpuStage::Upload;
+        ComPtr<ID3D11Query> begin;
+        ComPtr<ID3D11Query> end;
+    };
+    struct FrameQueries {
+        ComPtr<ID3D11Query> disjoint;
+        ComPtr<ID3D11Query> begin;
+        ComPtr<ID3D11Query> end;
+        std::array<Interval, MAX_INTERVALS> intervals;
+        int     used    = 0;
+        int     open    = -1;  // Interval begun but not ended
+        bool    pending = false;
+        int64_t frame   = 0;
+        std::chrono::steady_clock::time_point cpuBegin;  // When the frame's first timestamp was issued
+    };
+    bool CreateTimestamp(ComPtr<ID3D11Query>& query);
+    bool Resolve(FrameQueries& queries);  // False while the GPU is still on it
+    void Record(const GpuFrameTiming& timing, double frequency);
+
+    ID3D11Device*        m_device  = nullptr;
+    ID3D11DeviceContext* m_context = nullptr;
+    bool    m_enabled    = true;
+    bool    m_inFrame    = false;
+    int     m_current    = 0;  // Slot of the frame being recorded
+    int64_t m_frameCount = 0;
+    std::array<FrameQueries, FRAME_LATENCY> m_frames;
+
+    mutable std::mutex m_mutex;  // Guards the history below
+    std::array<GpuFrameTiming, HISTORY_SIZE> m_history{};
+    int     m_next      = 0;
+    int64_t m_resolved  = 0;
+    int64_t m_skipped   = 0;
+    double  m_frequency = 0.0;
+};
+
+} // namespace SP
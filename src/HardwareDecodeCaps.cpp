@@ -0,0 +1,131 @@
+#include "HardwareDecodeCaps.h"
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace SP {
+
+namespace {
+
+// DXVA decoder profile GUIDs, spelled out so no SDK version or dxguid.lib is needed
+constexpr GUID PROFILE_H264_VLD_NOFGT  = {0x1b81be68, 0xa0c7, 0x11d3, {0xb9, 0x84, 0x00, 0xc0, 0x4f, 0x2e, 0x73, 0xc5}};
+constexpr GUID PROFILE_HEVC_VLD_MAIN   = {0x5b11d51b, 0x2f4c, 0x4452, {0xbc, 0xc3, 0x09, 0xf2, 0xa1, 0x16, 0x0c, 0xc0}};
+constexpr GUID PROFILE_HEVC_VLD_MAIN10 = {0x107af0e0, 0xef1a, 0x4d19, {0xab, 0xa8, 0x67, 0xa1, 0x63, 0x07, 0x3d, 0x13}};
+constexpr GUID PROFILE_VP9_VLD_PROFILE0       = {0x463707f8, 0xa1d0, 0x4585, {0x87, 0x6d, 0x83, 0xaa, 0x6d, 0x60, 0xb8, 0x9e}};
+constexpr GUID PROFILE_VP9_VLD_10BIT_PROFILE2 = {0xa4c749ef, 0x6ecf, 0x48aa, {0x84, 0x48, 0x50, 0xa7, 0xa1, 0x16, 0x5f, 0xf7}};
+constexpr GUID PROFILE_AV1_VLD_PROFILE0 = {0xb8be4ccb, 0xcf53, 0x46ba, {0x8d, 0x59, 0xd6, 0xb8, 0xa6, 0xda, 0x5d, 0x2a}};
+constexpr GUID PROFILE_MPEG2AND1_VLD    = {0x86695f12, 0x340e, 0x4f04, {0x9f, 0xd3, 0x92, 0x53, 0xdd, 0x32, 0x74, 0x60}};
+constexpr GUID PROFILE_VC1_D2010        = {0x1b81bea4, 0xa0c7, 0x11d3, {0xb9, 0x84, 0x00, 0xc0, 0x4f, 0x2e, 0x73, 0xc5}};
+
+struct ProfileDesc {
+    const char* label;
+    AVCodecID   codec;
+    int         bitDepth;
+    GUID        guid;
+    DXGI_FORMAT format;  // Surface format VideoDecoder::InitHardwareFrames accepts for it
+};
+
+// Only what the renderer can show from a D3D11VA surface: 4:2:0, NV12 or P010
+constexpr ProfileDesc PROFILES[] = {
+    { "H.264 High",     AV_CODEC_ID_H264,       8,  PROFILE_H264_VLD_NOFGT,         DXGI_FORMAT_NV12 },
+    { "HEVC Main",      AV_CODEC_ID_HEVC,       8,  PROFILE_HEVC_VLD_MAIN,          DXGI_FORMAT_NV12 },
+    { "HEVC Main10",    AV_CODEC_ID_HEVC,       10, PROFILE_HEVC_VLD_MAIN10,        DXGI_FORMAT_P010 },
+    { "VP9 Profile 0",  AV_CODEC_ID_VP9,        8,  PROFILE_VP9_VLD_PROFILE0,       DXGI_FORMAT_NV12 },
+    { "VP9 Profile 2",  AV_CODEC_ID_VP9,        10, PROFILE_VP9_VLD_10BIT_PROFILE2, DXGI_FORMAT_P010 },
+    { "AV1 Main",       AV_CODEC_ID_AV1,        8,  PROFILE_AV1_VLD_PROFILE0,       DXGI_FORMAT_NV12 },
+    { "AV1 Main 10-bit", AV_CODEC_ID_AV1,       10, PROFILE_AV1_VLD_PROFILE0,       DXGI_FORMAT_P010 },
+    { "MPEG-2",         AV_CODEC_ID_MPEG2VIDEO, 8,  PROFILE_MPEG2AND1_VLD,          DXGI_FORMAT_NV12 },
+    { "VC-1",           AV_CODEC_ID_VC1,        8,  PROFILE_VC1_D2010,              DXGI_FORMAT_NV12 },
+};
+
+// Frame sizes tried in order; the first one without a decoder config ends the climb
+constexpr int SIZE_LADDER[][2] = {
+    { 1280, 720 }, { 1920, 1088 }, { 2560, 1440 }, { 3840, 2160 }, { 4096, 2304 }, { 7680, 4320 }, { 8192, 4352 },
+};
+
+bool HasDecoderConfig(ID3D11VideoDevice* device, const GUID& guid, DXGI_FORMAT format, int width, int height) {
+    D3D11_VIDEO_DECODER_DESC desc = {};
+    desc.Guid         = guid;
+    desc.SampleWidth  = static_cast<UINT>(width);
+    desc.SampleHeight = static_cast<UINT>(height);
+    desc.OutputFormat = format;
+    UINT count = 0;
+    return SUCCEEDED(device->GetVideoDecoderConfigCount(&desc, &count)) && count > 0;
+}
+
+} // namespace
+
+void HardwareDecodeCaps::Probe(ID3D11Device* device) {
+    m_videoDevice.Reset();
+    m_profiles.clear();
+    if (!device || FAILED(device->QueryInterface(IID_PPV_ARGS(&m_videoDevice)))) return;
+
+    // Profiles the driver lists at all
+    std::vector<GUID> listed;
+    const UINT count = m_videoDevice->GetVideoDecoderProfileCount();
+    for (UINT i = 0; i < count; ++i) {
+        GUID guid = {};
+        if (SUCCEEDED(m_videoDevice->GetVideoDecoderProfile(i, &guid))) listed.push_back(guid);
+    }
+
+    for (const ProfileDesc& desc : PROFILES) {
+        Profile profile;
+        profile.label    = desc.label;
+        profile.codec    = desc.codec;
+        profile.bitDepth = desc.bitDepth;
+        BOOL formatOk = FALSE;
+        profile.supported = std::find(listed.begin(), listed.end(), desc.guid) != listed.end() &&
+                            SUCCEEDED(m_videoDevice->CheckVideoDecoderFormat(&desc.guid, desc.format, &formatOk)) &&
+                            formatOk;
+        if (profile.supported) {
+            for (const auto& size : SIZE_LADDER) {
+                if (!HasDecoderConfig(m_videoDevice.Get(), desc.guid, desc.format, size[0], size[1])) break;
+                profile.maxWidth  = size[0];
+                profile.maxHeight = size[1];
+            }
+            profile.supported = profile.maxWidth > 0;
+        }
+        m_profiles.push_back(profile);
+    }
+}
+
+bool HardwareDecodeCaps::Supports(const AVCodecParameters* params) const {
+    if (!m_videoDevice || !params) return true;
+    bool known = false;
+    for (const ProfileDesc& desc : PROFILES) known |= (desc.codec == params->codec_id);
+    if (!known) return true;
+
+    // Unknown format (not probed yet) reads as 8-bit 4:2:0, the common case
+    int bitDepth = 8;
+    if (const AVPixFmtDescriptor* fmt = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(params->format))) {
+        if (fmt->log2_chroma_w != 1 || fmt->log2_chroma_h != 1) return false;  // 4:2:2, 4:4:4, mono
+        bitDepth = fmt->comp[0].depth;
+    }
+    for (size_t i = 0; i < m_profiles.size(); ++i) {
+        const ProfileDesc& desc = PROFILES[i];
+        if (desc.codec != params->codec_id || desc.bitDepth != bitDepth) continue;
+        return m_profiles[i].supported &&
+               HasDecoderConfig(m_videoDevice.Get(), desc.guid, desc.format, params->width, params->height);
+    }
+    return false;  // A bit depth no profile covers (10-bit H.264, 12-bit HEVC)
+}
+
+std::vector<AVCodecID> HardwareDecodeCaps::GetCodecs() {
+    std::vector<AVCodecID> codecs;
+    for (const ProfileDesc& desc : PROFILES) {
+        if (std::find(codecs.begin(), codecs.end(), desc.codec) == codecs.end()) codecs.push_back(desc.codec);
+    }
+    return codecs;
+}
+
+const char* HardwareDecodeCaps::GetPolicyName(HwDecodePolicy policy) {
+    switch (policy) {
+    case HwDecodePolicy::Hardware: return "Hardware";
+    case HwDecodePolicy::Software: return "Software";
+    default:                       return "Auto";
+    }
+}
+
+} // namespace SP
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Common.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace SP {
+
+// What the GPU's D3D11VA decoder accepts, probed once at startup from
+// ID3D11VideoDevice: for each codec profile the renderer can display (4:2:0 in
+// NV12 or P010), whether the driver lists it, whether it takes the surface
+// format, and the largest of a ladder of frame sizes it creates a decoder for.
+// VideoDecoder asks Supports() under HwDecodePolicy::Auto before setting up
+// hardware decode, so streams the GPU can't take (AV1 on older cards, 4:2:2 or
+// 12-bit anything, 8K on a 4K decoder) open in threaded software decode at once
+// instead of failing inside the driver.
+class HardwareDecodeCaps {
+public:
+    struct Profile {
+        const char* label    = "";   // "HEVC Main10"
+        AVCodecID   codec    = AV_CODEC_ID_NONE;
+        int         bitDepth = 8;
+        bool        supported = false;  // Profile listed and surface format accepted
+        int         maxWidth  = 0;      // Largest tested size with a decoder config
+        int         maxHeight = 0;
+    };
+
+    HardwareDecodeCaps() = default;
+
+    // Driver queries only (no decoder is created); a few milliseconds
+    void Probe(ID3D11Device* device);
+    bool IsProbed() const { return m_videoDevice != nullptr; }
+
+    // Whether D3D11VA can decode this stream on the probed GPU, checked at its
+    // exact size. Codecs outside the table, and an unprobed instance, return
+    // true: FFmpeg's own hardware config check still decides those.
+    bool Supports(const AVCodecParameters* params) const;
+
+    const std::vector<Profile>& GetProfiles() const { return m_profiles; }
+    // Codecs with a profile in the table, in table order (AppConfig::hwDecodePolicy keys)
+    static std::vector<AVCodecID> GetCodecs();
+
+    static const char* GetPolicyName(HwDecodePolicy policy);
+
+private:
+    ComPtr<ID3D11VideoDevice> m_videoDevice;
+    std::vector<Profile> m_profiles;
+};
+
+} // namespace SP
@@ -0,0 +1,92 @@
+#include "HeapStats.h"
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace SP {
+
+namespace {
+
+// Plain thread_locals with constant initialisers: no TLS constructor runs
+// inside operator new
+thread_local int64_t t_allocations = 0;
+thread_local int64_t t_bytes       = 0;
+std::atomic<int64_t> g_allocations{0};
+std::atomic<int64_t> g_bytes{0};
+
+void Count(size_t bytes) {
+    ++t_allocations;
+    t_bytes += static_cast<int64_t>(bytes);
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+}
+
+void* Allocate(size_t bytes) noexcept {
+    Count(bytes);
+    return std::malloc(bytes ? bytes : 1);
+}
+
+void* AllocateAligned(size_t bytes, std::align_val_t alignment) noexcept {
+    Count(bytes);
+    return _aligned_malloc(bytes ? bytes : 1, static_cast<size_t>(alignment));
+}
+
+} // namespace
+
+HeapCounters GetThreadHeapCounters() {
+    return HeapCounters{t_allocations, t_bytes};
+}
+
+HeapCounters GetProcessHeapCounters() {
+    return HeapCounters{g_allocations.load(std::memory_order_relaxed), g_bytes.load(std::memory_order_relaxed)};
+}
+
+} // namespace SP
+
+// Replacement global allocation functions. The throwing forms loop on the
+// new-handler as the standard ones do.
+
+void* operator new(size_t bytes) {
+    while (true) {
+        if (void* p = SP::Allocate(bytes)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    while (true) {
+        if (void* p = SP::AllocateAligned(bytes, alignment)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](size_t bytes) { return operator new(bytes); }
+void* operator new[](size_t bytes, std::align_val_t alignment) { return operator new(bytes, alignment); }
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept { return SP::Allocate(bytes); }
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept { return SP::Allocate(bytes); }
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return SP::AllocateAligned(bytes, alignment);
+}
+void* operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return SP::AllocateAligned(bytes, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { _aligned_free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { _aligned_free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { _aligned_free(p); }
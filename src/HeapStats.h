@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SP {
+
+// Counts of operator new calls, for the Frame Timing panel. HeapStats.cpp
+// replaces the global operator new/delete (every form) with malloc-backed ones
+// that bump a per-thread and a process-wide counter; the cost is two relaxed
+// increments per allocation. Frees are not counted: a steady state that
+// allocates nothing frees nothing either.
+//
+// Only C++ allocations are seen. FFmpeg (av_malloc), ImGui (IM_ALLOC) and the
+// driver allocate with their own allocators, outside these counts.
+struct HeapCounters {
+    int64_t allocations = 0;
+    int64_t bytes       = 0;
+};
+
+HeapCounters GetThreadHeapCounters();   // Calling thread, since it started
+HeapCounters GetProcessHeapCounters();  // All threads, since the process started
+
+} // namespace SP
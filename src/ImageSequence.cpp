@@ -0,0 +1,297 @@
+#include "ImageSequence.h"
+#include "ThreadPriority.h"
+#include <algorithm>
+#include <cctype>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+namespace SP {
+
+namespace {
+
+// Still-image formats FFmpeg decodes one file per frame
+constexpr const char* IMAGE_EXTENSIONS[] = {
+    ".png", ".exr", ".tif", ".tiff", ".dpx", ".jpg", ".jpeg", ".bmp", ".tga", ".webp"
+};
+
+std::string ToLower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+// "shot_0042" -> prefix "shot_", number 42. False without trailing digits.
+bool SplitFrameNumber(const std::string& stem, std::string& prefix, int64_t& number) {
+    size_t digits = stem.size();
+    while (digits > 0 && std::isdigit(static_cast<unsigned char>(stem[digits - 1]))) --digits;
+    if (digits == stem.size() || stem.size() - digits > 12) return false;
+    prefix = stem.substr(0, digits);
+    number = std::stoll(stem.substr(digits));
+    return true;
+}
+
+} // namespace
+
+ImageSequence::~ImageSequence() {
+    Close();
+}
+
+std::vector<std::string> ImageSequence::FindFrames(const std::string& path) {
+    const std::filesystem::path file(path);
+    const std::string ext = ToLower(file.extension().string());
+    if (std::find(std::begin(IMAGE_EXTENSIONS), std::end(IMAGE_EXTENSIONS), ext) == std::end(IMAGE_EXTENSIONS)) {
+        return {};
+    }
+
+    std::string prefix;
+    int64_t number = 0;
+    if (!SplitFrameNumber(file.stem().string(), prefix, number)) return {};
+
+    // Siblings with the same prefix and extension, ordered by number (so
+    // unpadded names like f9, f10 sort correctly)
+    std::vector<std::pair<int64_t, std::string>> frames;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(file.parent_path(), ec)) {
+        if (!entry.is_regular_file(ec)) continue;
+        const std::filesystem::path& p = entry.path();
+        std::string otherPrefix;
+        if (ToLower(p.extension().string()) == ext &&
+            SplitFrameNumber(p.stem().string(), otherPrefix, number) && otherPrefix == prefix) {
+            frames.emplace_back(number, p.string());
+        }
+    }
+    if (frames.size() < 2) return {};
+
+    std::sort(frames.begin(), frames.end());
+    std::vector<std::string> files;
+    files.reserve(frames.size());
+    for (auto& frame : frames) files.push_back(std::move(frame.second));
+    return files;
+}
+
+bool ImageSequence::Open(std::vector<std::string> files, int width, int height, double fps, int cacheMB) {
+    Close();
+    if (files.empty() || width <= 0 || height <= 0 || fps <= 0.0) return false;
+
+    m_files  = std::move(files);
+    m_width  = width;
+    m_height = height;
+    m_fps    = fps;
+    m_slots.assign(m_files.size(), Slot{});
+    m_next   = 0;
+
+    const int workers = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) - 1, 2, MAX_WORKERS);
+    const int64_t frameBytes = static_cast<int64_t>(width) * height * 4;
+    const int64_t budget     = static_cast<int64_t>(std::max(cacheMB, 0)) * 1024 * 1024;
+    m_ramCached = budget > 0 && frameBytes * GetFrameCount() <= budget;
+    m_window    = m_ramCached ? GetFrameCount() : std::min<int64_t>(workers * LOOKAHEAD_PER_WORKER, GetFrameCount());
+
+    m_stopRequested = false;
+    for (int i = 0; i < workers; ++i) {
+        m_workers.emplace_back(&ImageSequence::WorkerThread, this);
+    }
+    return true;
+}
+
+void ImageSequence::Close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_workCv.notify_all();
+    m_readyCv.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+
+    m_slots.clear();
+    m_files.clear();
+    m_next      = 0;
+    m_window    = 0;
+    m_ramCached = false;
+    m_resident  = 0;
+    m_framePool.Trim();
+}
+
+int64_t ImageSequence::GetPosition() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_next;
+}
+
+bool ImageSequence::InWindow(int64_t index) const {
+    // Wraps past the end, so a loop's first frames are ready before it restarts
+    const int64_t count = GetFrameCount();
+    return (index - m_next % count + count) % count < m_window;
+}
+
+void ImageSequence::EvictOutsideWindow() {
+    if (m_ramCached) return;
+    for (int64_t i = 0; i < GetFrameCount(); ++i) {
+        Slot& slot = m_slots[i];
+        if ((slot.state == SlotState::Ready || slot.state == SlotState::Failed) && !InWindow(i)) {
+            if (slot.state == SlotState::Ready) --m_resident;
+            slot = Slot{};
+        }
+    }
+}
+
+bool ImageSequence::Next(VideoFrame& outFrame) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_next < GetFrameCount()) {
+        Slot& slot = m_slots[m_next];
+        m_readyCv.wait(lock, [&] {
+            return m_stopRequested.load() || slot.state == SlotState::Ready || slot.state == SlotState::Failed;
+        });
+        if (m_stopRequested.load()) return false;
+
+        const bool ready = (slot.state == SlotState::Ready);
+        if (ready) {
+            outFrame = slot.frame;  // Shares the block
+        }
+        ++m_next;
+        if (!m_ramCached) {
+            // Streaming: the consumer holds the only reference now
+            if (ready) --m_resident;
+            slot = Slot{};
+        }
+        m_workCv.notify_all();  // The window moved
+        if (ready) return true;
+    }
+    return false;
+}
+
+void ImageSequence::Seek(int64_t frame) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_files.empty()) return;
+        m_next = std::clamp<int64_t>(frame, 0, GetFrameCount());
+        EvictOutsideWindow();
+    }
+    m_workCv.notify_all();
+}
+
+void ImageSequence::WorkerThread() {
+    ThreadPriority::Apply(ThreadRole::Playback);
+    AVFrame*    frame  = av_frame_alloc();
+    AVPacket*   packet = av_packet_alloc();
+    SwsContext* sws    = nullptr;
+
+    while (frame && packet) {
+        int64_t index = -1;
+        {
+            // Nearest frame in the window that nobody has claimed
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workCv.wait(lock, [&] {
+                if (m_stopRequested.load()) return true;
+                const int64_t count = GetFrameCount();
+                for (int64_t i = 0; i < m_window; ++i) {
+                    const int64_t candidate = (m_next + i) % count;
+                    if (m_slots[candidate].state == SlotState::Empty) {
+                        index = candidate;
+                        return true;
+                    }
+                }
+                return false;
+            });
+            if (m_stopRequested.load()) break;
+            m_slots[index].state = SlotState::Decoding;
+        }
+
+        VideoFrame decoded;
+        const bool ok = DecodeFile(m_files[index], frame, packet) &&
+                        ConvertFrame(frame, sws, index, decoded);
+        av_frame_unref(frame);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Slot& slot = m_slots[index];
+            if (!m_ramCached && !InWindow(index)) {
+                slot = Slot{};  // Seeked away while decoding
+            } else if (ok) {
+                slot.frame = std::move(decoded);
+                slot.state = SlotState::Ready;
+                ++m_resident;
+            } else {
+                slot.state = SlotState::Failed;
+            }
+        }
+        m_readyCv.notify_all();
+    }
+
+    sws_freeContext(sws);
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+}
+
+bool ImageSequence::DecodeFile(const std::string& path, AVFrame* frame, AVPacket* packet) {
+    AVFormatContext* formatCtx = nullptr;
+    if (avformat_open_input(&formatCtx, path.c_str(), nullptr, nullptr) < 0) return false;
+
+    const AVCodec* codec = (formatCtx->nb_streams > 0)
+        ? avcodec_find_decoder(formatCtx->streams[0]->codecpar->codec_id) : nullptr;
+    AVCodecContext* codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+
+    bool got = false;
+    if (codecCtx && avcodec_parameters_to_context(codecCtx, formatCtx->streams[0]->codecpar) >= 0) {
+        codecCtx->thread_count = 1;  // Parallel across files instead
+        if (avcodec_open2(codecCtx, codec, nullptr) >= 0) {
+            while (!got && av_read_frame(formatCtx, packet) >= 0) {
+                if (avcodec_send_packet(codecCtx, packet) >= 0) {
+                    got = (avcodec_receive_frame(codecCtx, frame) == 0);
+                }
+                av_packet_unref(packet);
+            }
+            if (!got && avcodec_send_packet(codecCtx, nullptr) >= 0) {
+                got = (avcodec_receive_frame(codecCtx, frame) == 0);
+            }
+        }
+    }
+
+    avcodec_free_context(&codecCtx);
+    avformat_close_input(&formatCtx);
+    return got;
+}
+
+bool ImageSequence::ConvertFrame(AVFrame* frame, SwsContext*& sws, int64_t index, VideoFrame& outFrame) {
+    // 64 bytes of tail padding for sws_scale's SIMD overshoot, as in VideoDecoder
+    const int bufferSize = av_image_get_buffer_size(AV_PIX_FMT_RGBA, m_width, m_height, 1);
+    if (bufferSize <= 0) return false;
+    FrameBuffer block = m_framePool.Acquire(static_cast<size_t>(bufferSize) + 64);
+
+    uint8_t* dstData[4]   = { block.get(), nullptr, nullptr, nullptr };
+    int dstLinesize[4]    = { m_width * 4, 0, 0, 0 };
+    if (frame->format == AV_PIX_FMT_RGBA && frame->width == m_width && frame->height == m_height &&
+        frame->linesize[0] >= dstLinesize[0]) {
+        // 8-bit RGBA PNG/TIFF at the clip size: the rows are the cached frame already
+        av_image_copy_plane(dstData[0], dstLinesize[0], frame->data[0], frame->linesize[0],
+                            dstLinesize[0], m_height);
+    } else {
+        // Any other source format (16-bit, float EXR) to RGBA at the clip size; one
+        // file of another size is scaled to fit
+        sws = sws_getCachedContext(sws, frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                   m_width, m_height, AV_PIX_FMT_RGBA,
+                                   SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!sws || sws_scale(sws, frame->data, frame->linesize, 0, frame->height, dstData, dstLinesize) <= 0) {
+            return false;
+        }
+    }
+
+    outFrame.width       = m_width;
+    outFrame.height      = m_height;
+    outFrame.format      = AV_PIX_FMT_RGBA;
+    outFrame.layout      = FrameLayout::RGBA8;
+    outFrame.data[0]     = block.get();
+    outFrame.linesize[0] = dstLinesize[0];
+    outFrame.pts         = index;
+    outFrame.timestamp   = static_cast<double>(index) / m_fps;
+    outFrame.buffer      = std::move(block);
+    return true;
+}
+
+} // namespace SP
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Common.h"
+#include "FramePool.h"
+#include <condition_variable>
+
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+
+namespace SP {
+
+// Numbered still images (PNG, EXR, TIFF, DPX, ...) played as one clip. FFmpeg's
+// image2 demuxer opens and decodes one file at a time on one thread; here a pool
+// of workers each decodes whole files, up to a window of frames past the read
+// position, into FramePool RGBA blocks. Every frame is independent, so a seek
+// only moves the read position.
+//
+// RAM-cached mode: when the whole sequence fits the memory budget, decoded
+// frames are kept and the workers fill the entire sequence in the background,
+// so loops replay from memory.
+//
+// Next/Seek are called by VideoDecoder (under the decoder lock); the frame table
+// is shared with the workers under m_mutex.
+class ImageSequence {
+public:
+    ImageSequence() = default;
+    ~ImageSequence();
+
+    // Non-copyable
+    ImageSequence(const ImageSequence&) = delete;
+    ImageSequence& operator=(const ImageSequence&) = delete;
+
+    // The files of the sequence `path` belongs to, in frame-number order. Empty
+    // when `path` is not a numbered image file or has no siblings.
+    static std::vector<std::string> FindFrames(const std::string& path);
+
+    // Starts the workers; frames are converted to width x height RGBA and stamped
+    // at `fps`. `cacheMB` is the RAM-cached mode budget (0 = stream only).
+    bool Open(std::vector<std::string> files, int width, int height, double fps, int cacheMB);
+    void Close();
+
+    // The frame at the read position, waiting for its decode, then advances.
+    // Files that fail to decode are skipped. False past the last frame.
+    bool Next(VideoFrame& outFrame);
+    // Moves the read position; decoded frames outside the new window are dropped
+    // unless RAM-cached.
+    void Seek(int64_t frame);
+
+    int64_t GetPosition() const;  // Frame the next Next() returns
+    int64_t GetFrameCount() const { return static_cast<int64_t>(m_files.size()); }
+    bool    IsRamCached() const { return m_ramCached; }
+    int64_t GetResidentFrames() const { return m_resident.load(); }  // Decoded and held
+    int     GetWorkerCount() const { return static_cast<int>(m_workers.size()); }
+
+private:
+    // Frames decoded ahead per worker when streaming
+    static constexpr int LOOKAHEAD_PER_WORKER = 2;
+    static constexpr int MAX_WORKERS = 16;
+
+    enum class SlotState { Empty, Decoding, Ready, Failed };
+    struct Slot {
+        SlotState  state = SlotState::Empty;
+        VideoFrame frame;
+    };
+
+    void WorkerThread();
+    // Worker-owned frame/packet/scaler; nothing here touches shared state
+    static bool DecodeFile(const std::string& path, AVFrame* frame, AVPacket* packet);
+    bool ConvertFrame(AVFrame* frame, SwsContext*& sws, int64_t index, VideoFrame& outFrame);
+    bool InWindow(int64_t index) const;  // Caller holds m_mutex
+    void EvictOutsideWindow();           // Caller holds m_mutex
+
+    std::vector<std::string> m_files;
+    int    m_width  = 0;
+    int    m_height = 0;
+    double m_fps    = 0.0;
+    bool   m_ramCached = false;
+    int64_t m_window   = 0;  // Frames from the read position the workers keep decoded
+    FramePool m_framePool;
+
+    std::vector<std::thread> m_workers;
+    std::atomic<bool> m_stopRequested{false};
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;   // Window moved or a slot freed
+    std::condition_variable m_readyCv;  // A slot finished decoding
+
+    // Guarded by m_mutex
+    std::vector<Slot> m_slots;
+    int64_t m_next = 0;
+    std::atomic<int64_t> m_resident{0};
+};
+
+} // namespace SP
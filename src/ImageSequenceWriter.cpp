@@ -0,0 +1,232 @@
+#include "ImageSequenceWriter.h"
+#include "ThreadPriority.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+namespace SP {
+
+namespace {
+
+struct ImageFormat {
+    const char*   extension;
+    AVCodecID     codec;
+    AVPixelFormat pixelFormat;
+};
+
+// EXR is written as linear float (what compositors expect); PNG and TIFF keep
+// the rendered 8-bit RGBA as is
+constexpr ImageFormat IMAGE_FORMATS[] = {
+    { ".png",  AV_CODEC_ID_PNG,  AV_PIX_FMT_RGBA     },
+    { ".tif",  AV_CODEC_ID_TIFF, AV_PIX_FMT_RGBA     },
+    { ".tiff", AV_CODEC_ID_TIFF, AV_PIX_FMT_RGBA     },
+    { ".exr",  AV_CODEC_ID_EXR,  AV_PIX_FMT_GBRAPF32 },
+};
+
+const ImageFormat* FormatFor(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (const ImageFormat& format : IMAGE_FORMATS) {
+        if (ext == format.extension) return &format;
+    }
+    return nullptr;
+}
+
+// sRGB-encoded 8-bit value -> linear light
+struct SrgbToLinear {
+    float table[256];
+    SrgbToLinear() {
+        for (int i = 0; i < 256; ++i) {
+            const float c = i / 255.0f;
+            table[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+    }
+};
+
+} // namespace
+
+ImageSequenceWriter::~ImageSequenceWriter() {
+    Stop();
+    Join();
+}
+
+bool ImageSequenceWriter::IsImageSequencePath(const std::string& path) {
+    return FormatFor(path) != nullptr;
+}
+
+bool ImageSequenceWriter::Start(const std::string& path, int width, int height, bool blocking) {
+    Stop();
+    Join();
+    if (!FormatFor(path) || width <= 0 || height <= 0) return false;
+
+    const std::filesystem::path fsPath(path);
+    m_extension = fsPath.extension().string();
+    m_stem      = (fsPath.parent_path() / fsPath.stem()).string();
+    m_width     = width;
+    m_height    = height;
+    m_blocking  = blocking;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.clear();
+        m_nextIndex     = 0;
+        m_stopRequested = false;
+    }
+    m_inFlight = 0;
+    m_written  = 0;
+    m_dropped  = 0;
+    m_failed   = 0;
+
+    // Every core compresses: frames are independent and PNG/EXR run single-threaded
+    const int workers = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, MAX_WORKERS);
+    m_maxInFlight = workers * FRAMES_PER_WORKER;
+    for (int i = 0; i < workers; ++i) {
+        m_workers.emplace_back(&ImageSequenceWriter::WorkerThread, this);
+    }
+    return true;
+}
+
+void ImageSequenceWriter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_workCv.notify_all();
+    m_spaceCv.notify_all();
+}
+
+void ImageSequenceWriter::Join() {
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) worker.join();
+    }
+    m_workers.clear();
+}
+
+bool ImageSequenceWriter::Submit(FrameBuffer data, int width, int height) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_blocking) {
+        m_spaceCv.wait(lock, [this] { return m_inFlight.load() < m_maxInFlight || m_stopRequested; });
+    }
+    if (m_stopRequested || m_inFlight.load() >= m_maxInFlight) {
+        if (!m_stopRequested) m_dropped++;
+        return false;
+    }
+
+    Job job;
+    job.data   = std::move(data);
+    job.width  = width;
+    job.height = height;
+    job.index  = m_nextIndex++;
+    m_queue.push_back(std::move(job));
+    m_inFlight++;
+    lock.unlock();
+    m_workCv.notify_one();
+    return true;
+}
+
+std::string ImageSequenceWriter::FramePath(int64_t index) const {
+    char number[24];
+    std::snprintf(number, sizeof(number), "_%06lld", static_cast<long long>(index));
+    return m_stem + number + m_extension;
+}
+
+void ImageSequenceWriter::WorkerThread() {
+    ThreadPriority::Apply(ThreadRole::Background);
+    static const SrgbToLinear s_linear;
+    const ImageFormat* format = FormatFor(m_extension);
+    const AVCodec* codec = avcodec_find_encoder(format->codec);
+
+    // Worker-owned: encoder, frames, scaler for frames of another size
+    AVCodecContext* codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (codecCtx) {
+        codecCtx->width     = m_width;
+        codecCtx->height    = m_height;
+        codecCtx->pix_fmt   = format->pixelFormat;
+        codecCtx->time_base = {1, 25};
+        if (avcodec_open2(codecCtx, codec, nullptr) < 0) avcodec_free_context(&codecCtx);
+    }
+    AVFrame* frame = av_frame_alloc();
+    if (frame) {
+        frame->format = format->pixelFormat;
+        frame->width  = m_width;
+        frame->height = m_height;
+        if (av_frame_get_buffer(frame, 0) < 0) av_frame_free(&frame);
+    }
+    AVPacket* packet = av_packet_alloc();
+    SwsContext* sws = nullptr;
+    std::vector<uint8_t> scaled;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_workCv.wait(lock, [this] { return !m_queue.empty() || m_stopRequested; });
+        if (m_queue.empty()) break;  // Stopped and drained
+        Job job = std::move(m_queue.front());
+        m_queue.pop_front();
+        lock.unlock();
+
+        bool ok = codecCtx && frame && packet && av_frame_make_writable(frame) >= 0;
+
+        // RGBA at the sequence size; frames rendered at another size (proxy
+        // playback before the reopen) are scaled first
+        const uint8_t* rgba = job.data.get();
+        if (ok && (job.width != m_width || job.height != m_height)) {
+            sws = sws_getCachedContext(sws, job.width, job.height, AV_PIX_FMT_RGBA, m_width, m_height,
+                                       AV_PIX_FMT_RGBA, SWS_BILINEAR, nullptr, nullptr, nullptr);
+            scaled.resize(static_cast<size_t>(m_width) * m_height * 4);
+            const uint8_t* srcData[1] = { rgba };
+            const int srcStride[1] = { job.width * 4 };
+            uint8_t* dstData[1] = { scaled.data() };
+            const int dstStride[1] = { m_width * 4 };
+            ok = sws && sws_scale(sws, srcData, srcStride, 0, job.height, dstData, dstStride) > 0;
+            rgba = scaled.data();
+        }
+
+        if (ok && format->pixelFormat == AV_PIX_FMT_RGBA) {
+            av_image_copy_plane(frame->data[0], frame->linesize[0], rgba, m_width * 4, m_width * 4, m_height);
+        } else if (ok) {
+            // GBRAP float planes: G, B, R, A
+            for (int y = 0; y < m_height; ++y) {
+                const uint8_t* src = rgba + static_cast<size_t>(y) * m_width * 4;
+                auto* g = reinterpret_cast<float*>(frame->data[0] + static_cast<size_t>(y) * frame->linesize[0]);
+                auto* b = reinterpret_cast<float*>(frame->data[1] + static_cast<size_t>(y) * frame->linesize[1]);
+                auto* r = reinterpret_cast<float*>(frame->data[2] + static_cast<size_t>(y) * frame->linesize[2]);
+                auto* a = reinterpret_cast<float*>(frame->data[3] + static_cast<size_t>(y) * frame->linesize[3]);
+                for (int x = 0; x < m_width; ++x, src += 4) {
+                    r[x] = s_linear.table[src[0]];
+                    g[x] = s_linear.table[src[1]];
+                    b[x] = s_linear.table[src[2]];
+                    a[x] = src[3] / 255.0f;
+                }
+            }
+        }
+        job.data.reset();  // The readback block goes back to its pool
+
+        // One image per packet
+        ok = ok && avcodec_send_frame(codecCtx, frame) >= 0 && avcodec_receive_packet(codecCtx, packet) >= 0;
+        if (ok) {
+            std::ofstream file(FramePath(job.index), std::ios::binary | std::ios::trunc);
+            ok = file.write(reinterpret_cast<const char*>(packet->data), packet->size).good();
+            av_packet_unref(packet);
+        }
+        (ok ? m_written : m_failed)++;
+
+        lock.lock();
+        m_inFlight--;
+        m_spaceCv.notify_one();
+    }
+    lock.unlock();
+
+    sws_freeContext(sws);
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    avcodec_free_context(&codecCtx);
+}
+
+} // namespace SP
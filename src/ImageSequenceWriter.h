@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Common.h"
+#include "FramePool.h"
+#include <condition_variable>
+#include <deque>
+
+namespace SP {
+
+// Recording to numbered still images (PNG, TIFF, EXR), the output-side
+// counterpart of ImageSequence. Frames are independent, so a pool of workers
+// compresses different frames at once across all cores, each with its own
+// FFmpeg image encoder and scaler, and writes "<stem>_000000.<ext>", ...
+//
+// At most `maxInFlight` frames are queued or being compressed (their readback
+// blocks stay referenced until written). A full queue drops the new frame, or
+// blocks the caller when `blocking` (offline export), like VideoEncoder's own
+// queue policy.
+class ImageSequenceWriter {
+public:
+    ImageSequenceWriter() = default;
+    ~ImageSequenceWriter();
+
+    // Non-copyable
+    ImageSequenceWriter(const ImageSequenceWriter&) = delete;
+    ImageSequenceWriter& operator=(const ImageSequenceWriter&) = delete;
+
+    // True for .png, .tif, .tiff and .exr output paths
+    static bool IsImageSequencePath(const std::string& path);
+
+    // Starts the workers for RGBA frames, written at width x height
+    bool Start(const std::string& path, int width, int height, bool blocking);
+    // Lets the workers finish what is queued and exit; Join waits for them
+    void Stop();
+    void Join();
+
+    // RGBA, tightly packed; numbered in submission order. Thread-safe.
+    bool Submit(FrameBuffer data, int width, int height);
+
+    int64_t GetFramesWritten() const { return m_written.load(); }
+    int64_t GetFramesDropped() const { return m_dropped.load(); }
+    int64_t GetFramesFailed() const { return m_failed.load(); }
+    int     GetInFlight() const { return m_inFlight.load(); }
+    int     GetWorkerCount() const { return static_cast<int>(m_workers.size()); }
+
+private:
+    static constexpr int MAX_WORKERS = 32;
+    // In-flight frames per worker: one compressing, one waiting
+    static constexpr int FRAMES_PER_WORKER = 2;
+
+    struct Job {
+        FrameBuffer data;
+        int width  = 0;
+        int height = 0;
+        int64_t index = 0;
+    };
+
+    void WorkerThread();
+    std::string FramePath(int64_t index) const;
+
+    std::string m_stem;       // Path without extension
+    std::string m_extension;  // ".png", ".tif", ".exr"
+    int  m_width  = 0;
+    int  m_height = 0;
+    bool m_blocking = false;
+    int  m_maxInFlight = 0;
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_workCv;   // A job was queued, or stop
+    std::condition_variable m_spaceCv;  // A job finished
+    std::deque<Job> m_queue;
+    int64_t m_nextIndex = 0;
+    bool m_stopRequested = false;
+
+    std::atomic<int>     m_inFlight{0};  // Queued + compressing
+    std::atomic<int64_t> m_written{0};
+    std::atomic<int64_t> m_dropped{0};
+    std::atomic<int64_t> m_failed{0};
+};
+
+} // namespace SP
@@ -0,0 +1,213 @@
+#include "KeyframeStore.h"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace SP {
+
+namespace {
+
+constexpr uint32_t STORE_MAGIC   = 0x464B5053;  // "SPKF"
+constexpr uint32_t STORE_VERSION = 1;
+
+struct StoreHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t timelineCount;
+    uint32_t reserved;
+};
+
+// Followed by the preset filepath and param name, padded to 4, then the arrays
+struct TimelineRecord {
+    uint32_t presetLength;
+    uint32_t paramLength;
+    uint32_t keyCount;
+    uint8_t  valueCount;
+    uint8_t  enabled;
+    uint8_t  reserved[2];
+};
+
+constexpr size_t Padded(size_t size) { return (size + 3) & ~size_t(3); }
+
+// Components a param's values and keys use, as in config.json; 0 = not keyframed
+int ValueCount(const ShaderParam& param) {
+    switch (param.type) {
+        case ShaderParamType::AudioBand:
+        case ShaderParamType::Image:
+        case ShaderParamType::Lut:     return 0;
+        case ShaderParamType::Point2D: return 2;
+        case ShaderParamType::Color:   return 4;
+        default:                       return 1;
+    }
+}
+
+class Writer {
+public:
+    void Put(const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        m_data.insert(m_data.end(), bytes, bytes + size);
+    }
+    void Pad() { m_data.resize(Padded(m_data.size()), 0); }
+    const std::vector<char>& GetData() const { return m_data; }
+
+private:
+    std::vector<char> m_data;
+};
+
+class Reader {
+public:
+    Reader(const char* data, size_t size) : m_data(data), m_size(size) {}
+    const char* Take(size_t size) {
+        if (m_size - m_offset < size) return nullptr;
+        const char* at = m_data + m_offset;
+        m_offset = std::min(m_offset + Padded(size), m_size);
+        return at;
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+};
+
+// Read-only view of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER size = {};
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) || size.QuadPart == 0) return;
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping) m_view = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_view) m_size = static_cast<size_t>(size.QuadPart);
+    }
+    ~MappedFile() {
+        if (m_view) UnmapViewOfFile(m_view);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* GetData() const { return m_view; }
+    size_t GetSize() const { return m_size; }
+
+private:
+    HANDLE      m_file    = INVALID_HANDLE_VALUE;
+    HANDLE      m_mapping = nullptr;
+    const char* m_view    = nullptr;
+    size_t      m_size    = 0;
+};
+
+} // namespace
+
+std::vector<char> KeyframeStore::Serialize(const std::vector<ShaderPreset>& presets) {
+    Writer out;
+    StoreHeader header = {STORE_MAGIC, STORE_VERSION, 0, 0};
+    out.Put(&header, sizeof(header));
+
+    std::vector<float> column;
+    for (const ShaderPreset& preset : presets) {
+        for (const ShaderParam& param : preset.params) {
+            const int valueCount = ValueCount(param);
+            if (valueCount == 0 || !param.timeline || param.timeline->keyframes.empty()) continue;
+            const std::vector<Keyframe>& keys = param.timeline->keyframes;
+            const size_t n = keys.size();
+
+            TimelineRecord record = {};
+            record.presetLength = static_cast<uint32_t>(preset.filepath.size());
+            record.paramLength  = static_cast<uint32_t>(param.name.size());
+            record.keyCount     = static_cast<uint32_t>(n);
+            record.valueCount   = static_cast<uint8_t>(valueCount);
+            record.enabled      = param.timeline->enabled ? 1 : 0;
+            out.Put(&record, sizeof(record));
+            out.Put(preset.filepath.data(), preset.filepath.size());
+            out.Pad();
+            out.Put(param.name.data(), param.name.size());
+            out.Pad();
+
+            // One array per field
+            auto putColumn = [&](auto field) {
+                column.clear();
+                for (const Keyframe& kf : keys) field(kf);
+                out.Put(column.data(), column.size() * sizeof(float));
+            };
+            putColumn([&](const Keyframe& kf) { column.push_back(kf.time); });
+            putColumn([&](const Keyframe& kf) { column.insert(column.end(), kf.values, kf.values + valueCount); });
+            putColumn([&](const Keyframe& kf) { column.push_back(kf.handles.outX); });
+            putColumn([&](const Keyframe& kf) { column.push_back(kf.handles.outY); });
+            putColumn([&](const Keyframe& kf) { column.push_back(kf.handles.inX); });
+            putColumn([&](const Keyframe& kf) { column.push_back(kf.handles.inY); });
+            for (const Keyframe& kf : keys) {
+                const uint8_t mode = static_cast<uint8_t>(kf.mode);
+                out.Put(&mode, 1);
+            }
+            out.Pad();
+            ++header.timelineCount;
+        }
+    }
+
+    std::vector<char> data = out.GetData();
+    std::memcpy(data.data(), &header, sizeof(header));
+    return data;
+}
+
+bool KeyframeStore::Read(const std::filesystem::path& path, std::vector<ShaderPreset>& presets) {
+    MappedFile file(path);
+    if (!file.GetData()) return false;
+    Reader in(file.GetData(), file.GetSize());
+    StoreHeader header;
+    const char* at = in.Take(sizeof(header));
+    if (!at) return false;
+    std::memcpy(&header, at, sizeof(header));
+    if (header.magic != STORE_MAGIC || header.version != STORE_VERSION) return false;
+
+    std::unordered_map<std::string_view, ShaderPreset*> byPath;
+    for (ShaderPreset& preset : presets) byPath.emplace(preset.filepath, &preset);
+
+    for (uint32_t t = 0; t < header.timelineCount; ++t) {
+        TimelineRecord record;
+        if (!(at = in.Take(sizeof(record)))) break;
+        std::memcpy(&record, at, sizeof(record));
+        const size_t n = record.keyCount;
+        const int valueCount = std::min<int>(record.valueCount, 4);
+        const char* presetPath = in.Take(record.presetLength);
+        const char* paramName  = in.Take(record.paramLength);
+        const char* times      = in.Take(n * sizeof(float));
+        const char* values     = in.Take(n * record.valueCount * sizeof(float));
+        const char* outX       = in.Take(n * sizeof(float));
+        const char* outY       = in.Take(n * sizeof(float));
+        const char* inX        = in.Take(n * sizeof(float));
+        const char* inY        = in.Take(n * sizeof(float));
+        const char* modes      = in.Take(n);
+        if (!presetPath || !paramName || !times || !values || !outX || !outY || !inX || !inY || !modes) break;
+
+        auto it = byPath.find(std::string_view(presetPath, record.presetLength));
+        if (it == byPath.end()) continue;  // Preset no longer in the config
+
+        KeyframeTimeline tl;
+        tl.enabled = record.enabled != 0;
+        tl.keyframes.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            Keyframe& kf = tl.keyframes[i];
+            const size_t offset = i * sizeof(float);
+            std::memcpy(&kf.time, times + offset, sizeof(float));
+            std::memcpy(kf.values, values + i * record.valueCount * sizeof(float), valueCount * sizeof(float));
+            std::memcpy(&kf.handles.outX, outX + offset, sizeof(float));
+            std::memcpy(&kf.handles.outY, outY + offset, sizeof(float));
+            std::memcpy(&kf.handles.inX, inX + offset, sizeof(float));
+            std::memcpy(&kf.handles.inY, inY + offset, sizeof(float));
+            const uint8_t mode = static_cast<uint8_t>(modes[i]);
+            kf.mode = mode <= static_cast<uint8_t>(InterpolationMode::CubicBezier)
+                          ? static_cast<InterpolationMode>(mode) : InterpolationMode::Linear;
+        }
+        // Written sorted; a damaged file must not hand Evaluate unsorted keys
+        std::sort(tl.keyframes.begin(), tl.keyframes.end(),
+            [](const Keyframe& a, const Keyframe& b) { return a.time < b.time; });
+        it->second->savedKeyframes[std::string(paramName, record.paramLength)] = std::move(tl);
+    }
+    return true;
+}
+
+} // namespace SP
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Binary store for the keyframe timelines of the preset library, config.keys
+// next to config.json. config.json keeps what a person would edit; timelines
+// of thousands of keys are slow to parse and bulky as one JSON object per key.
+//
+// Layout: a header, then one record per timeline (preset filepath + param name,
+// enabled, value count, key count) followed by its keys as packed arrays:
+// time[n], values[n * valueCount], outX/outY/inX/inY[n] each, mode[n]. Every
+// array starts 4-byte aligned. Read maps the file and copies the arrays straight
+// into ShaderPreset::savedKeyframes; every length is checked against the file,
+// so a truncated or corrupt file loads the records before the damage.
+struct KeyframeStore {
+    // The file contents for the timelines of `presets`' params (those with keys)
+    static std::vector<char> Serialize(const std::vector<ShaderPreset>& presets);
+    // Into savedKeyframes of the presets matched by filepath, replacing any
+    // loaded from config.json. False when the file is missing or not a store.
+    static bool Read(const std::filesystem::path& path, std::vector<ShaderPreset>& presets);
+};
+
+} // namespace SP
@@ -4,25 +4,45 @@
 
 namespace SP {
 
+namespace {
+
+constexpr int   NEWTON_ITERATIONS  = 8;
+constexpr int   BISECT_ITERATIONS  = 16;
+constexpr float BEZIER_EPSILON     = 1e-6f;  // In x: well under a frame at any segment length
+constexpr float MIN_NEWTON_SLOPE   = 1e-6f;
+
+} // namespace
+
 // Cubic bezier evaluation: given control points (0,0), (cx1,cy1), (cx2,cy2), (1,1),
-// solve for Y at a given X using binary search on the parametric t.
+// solve for Y at a given X. x(t) and y(t) in polynomial form; Newton's method
+// finds t in a few steps, with bisection where the curve is too flat for it.
 static float EvalCubicBezier(float cx1, float cy1, float cx2, float cy2, float x) {
-    // Binary search for t where bezierX(t) ≈ x
+    const float cx = 3.0f * cx1;
+    const float bx = 3.0f * (cx2 - cx1) - cx;
+    const float ax = 1.0f - cx - bx;
+    const float cy = 3.0f * cy1;
+    const float by = 3.0f * (cy2 - cy1) - cy;
+    const float ay = 1.0f - cy - by;
+    auto sampleX = [&](float t) { return ((ax * t + bx) * t + cx) * t; };
+    auto sampleY = [&](float t) { return ((ay * t + by) * t + cy) * t; };
+
+    float t = x;
+    for (int i = 0; i < NEWTON_ITERATIONS; ++i) {
+        const float error = sampleX(t) - x;
+        if (std::abs(error) < BEZIER_EPSILON) return sampleY(t);
+        const float slope = (3.0f * ax * t + 2.0f * bx) * t + cx;
+        if (std::abs(slope) < MIN_NEWTON_SLOPE) break;
+        t -= error / slope;
+        if (t < 0.0f || t > 1.0f) break;
+    }
+
     float lo = 0.0f, hi = 1.0f;
-    for (int i = 0; i < 16; ++i) {
-        float t = (lo + hi) * 0.5f;
-        float omt = 1.0f - t;
-        float bx = 3.0f * omt * omt * t * cx1
-                  + 3.0f * omt * t * t * cx2
-                  + t * t * t;
-        if (bx < x) lo = t;
-        else         hi = t;
+    for (int i = 0; i < BISECT_ITERATIONS; ++i) {
+        t = (lo + hi) * 0.5f;
+        if (sampleX(t) < x) lo = t;
+        else                hi = t;
     }
-    float t = (lo + hi) * 0.5f;
-    float omt = 1.0f - t;
-    return 3.0f * omt * omt * t * cy1
-         + 3.0f * omt * t * t * cy2
-         + t * t * t;
+    return sampleY((lo + hi) * 0.5f);
 }
 
 static float Smoothstep(float t) {
@@ -42,13 +62,23 @@ bool KeyframeTimeline::Evaluate(float time, float out[4], int valueCount) const
         return true;
     }
 
-    // Binary search for segment
-    int lo = 0, hi = static_cast<int>(keyframes.size()) - 1;
-    while (lo < hi - 1) {
-        int mid = (lo + hi) / 2;
-        if (keyframes[mid].time <= time) lo = mid;
-        else                              hi = mid;
+    // The last segment, or the one after it during playback; otherwise binary search
+    const int last = static_cast<int>(keyframes.size()) - 1;
+    auto contains = [&](int segment) {
+        return segment >= 0 && segment < last &&
+               keyframes[segment].time <= time && time < keyframes[segment + 1].time;
+    };
+    int lo = cursor;
+    if (!contains(lo) && !contains(++lo)) {
+        lo = 0;
+        int hi = last;
+        while (lo < hi - 1) {
+            int mid = (lo + hi) / 2;
+            if (keyframes[mid].time <= time) lo = mid;
+            else                              hi = mid;
+        }
     }
+    cursor = lo;
 
     const Keyframe& a = keyframes[lo];
     const Keyframe& b = keyframes[lo + 1];
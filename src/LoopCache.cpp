@@ -0,0 +1,70 @@
+#include "LoopCache.h"
+#include <algorithm>
+
+namespace SP {
+
+void LoopCache::Reset(int64_t firstKey, int64_t count, int budgetMB) {
+    m_entries.clear();
+    m_firstKey    = firstKey;
+    m_count       = std::max<int64_t>(count, 0);
+    m_filled      = 0;
+    m_budgetBytes = static_cast<size_t>(std::max(budgetMB, 0)) * 1024 * 1024;
+    m_width       = 0;
+    m_height      = 0;
+    m_format      = DXGI_FORMAT_R8G8B8A8_UNORM;
+    m_pixelBytes  = 4;
+    m_overBudget  = false;
+}
+
+void LoopCache::Store(ID3D11Device* device, ID3D11DeviceContext* context, int64_t key,
+                      ID3D11Texture2D* source, int width, int height, DXGI_FORMAT format) {
+    if (m_overBudget || !source || width <= 0 || height <= 0) return;
+    const int64_t index = key - m_firstKey;
+    if (index < 0 || index >= m_count) return;
+
+    if (width != m_width || height != m_height || format != m_format) {
+        const int pixelBytes = (format == DXGI_FORMAT_R16G16B16A16_UNORM) ? 8 : 4;
+        const size_t frameBytes = static_cast<size_t>(width) * height * pixelBytes;
+        if (static_cast<size_t>(m_count) * frameBytes > m_budgetBytes) {
+            // Checked up front so a pass never half-fills VRAM it can't finish with
+            m_entries.clear();
+            m_filled     = 0;
+            m_overBudget = true;
+            return;
+        }
+        m_entries.assign(static_cast<size_t>(m_count), Entry{});
+        m_filled = 0;
+        m_width      = width;
+        m_height     = height;
+        m_format     = format;
+        m_pixelBytes = pixelBytes;
+    }
+
+    Entry& entry = m_entries[static_cast<size_t>(index)];
+    if (entry.texture) return;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = width;
+    desc.Height           = height;
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = m_format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, &entry.texture)) ||
+        FAILED(device->CreateShaderResourceView(entry.texture.Get(), nullptr, &entry.srv))) {
+        entry = Entry{};
+        return;
+    }
+    context->CopyResource(entry.texture.Get(), source);
+    ++m_filled;
+}
+
+ID3D11ShaderResourceView* LoopCache::Find(int64_t key) const {
+    const int64_t index = key - m_firstKey;
+    if (index < 0 || index >= static_cast<int64_t>(m_entries.size())) return nullptr;
+    return m_entries[static_cast<size_t>(index)].srv.Get();
+}
+
+} // namespace SP
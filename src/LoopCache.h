@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Every frame of the A/B loop region kept on the GPU, so once one pass has been
+// shown the loop replays from VRAM with no seek or decode at all. Unlike the
+// ScrubCache nothing is evicted: the region either fits the budget whole or is
+// not cached. Entries are copies of the t0 video texture in its own format, like
+// the scrub cache's, so shader edits still apply.
+//
+// Keys are frame numbers (Application::FrameKey). Render thread only.
+class LoopCache {
+public:
+    LoopCache() = default;
+
+    // Non-copyable
+    LoopCache(const LoopCache&) = delete;
+    LoopCache& operator=(const LoopCache&) = delete;
+
+    // Covers frames [firstKey, firstKey + count), dropping what was cached. The
+    // textures are allocated by the first Store, once the frame size is known.
+    void Reset(int64_t firstKey, int64_t count, int budgetMB);
+    void Clear() { Reset(0, 0, 0); }
+
+    // GPU-copies `source` (in `format`) when `key` is in the region and not cached
+    // yet. The first frame sizes the cache; a region over the budget is never
+    // cached, and a later size or format change clears it.
+    void Store(ID3D11Device* device, ID3D11DeviceContext* context, int64_t key,
+               ID3D11Texture2D* source, int width, int height, DXGI_FORMAT format);
+
+    // Null when `key` is outside the region or not cached yet. No stats: the
+    // replay asks every tick.
+    ID3D11ShaderResourceView* Find(int64_t key) const;
+
+    bool IsComplete() const { return m_count > 0 && m_filled == m_count; }
+    bool IsOverBudget() const { return m_overBudget; }
+    int64_t GetFilled() const { return m_filled; }
+    int64_t GetCount() const { return m_count; }
+    size_t  GetUsedBytes() const { return static_cast<size_t>(m_filled) * m_width * m_height * m_pixelBytes; }
+
+private:
+    struct Entry {
+        ComPtr<ID3D11Texture2D> texture;
+        ComPtr<ID3D11ShaderResourceView> srv;
+    };
+
+    std::vector<Entry> m_entries;  // One per frame of the region, allocated on first Store
+    int64_t m_firstKey = 0;
+    int64_t m_count    = 0;
+    int64_t m_filled   = 0;
+    size_t  m_budgetBytes = 0;
+    int     m_width  = 0;
+    int     m_height = 0;
+    DXGI_FORMAT m_format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    int     m_pixelBytes = 4;
+    bool    m_overBudget = false;
+};
+
+} // namespace SP
@@ -0,0 +1,306 @@
+#include "MediaIO.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace SP {
+
+namespace {
+
+int64_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+std::wstring ToWide(const std::string& utf8) {
+    const int len = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, nullptr, 0);
+    if (len <= 0) return {};
+    std::wstring wide(static_cast<size_t>(len), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, wide.data(), len);
+    wide.resize(static_cast<size_t>(len - 1));
+    return wide;
+}
+
+} // namespace
+
+MediaIO::~MediaIO() {
+    Close();
+}
+
+bool MediaIO::IsLocalPath(const std::string& path) {
+    // "C:\..." and "\\server\share\..." are files; "rtsp://", "pipe:" and the like are not
+    if (path.size() >= 2 && path[1] == ':') return true;
+    if (path.rfind("\\\\", 0) == 0 || path.rfind("//", 0) == 0) return true;
+    return path.find(':') == std::string::npos;
+}
+
+bool MediaIO::Open(const std::string& path, int readAheadMB, const std::atomic<bool>* cancel) {
+    Close();
+    m_cancel = cancel;
+
+    const std::wstring widePath = ToWide(path);
+    if (widePath.empty()) return false;
+
+    m_file = CreateFileW(widePath.c_str(), GENERIC_READ,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart <= 0) {
+        Close();
+        return false;
+    }
+    m_fileSize = size.QuadPart;
+
+    // Local disks are mapped: the page cache does the read-ahead and a read is a
+    // copy. Network and removable volumes can vanish mid-read, which would fault
+    // inside the view, so they go through ReadFile instead.
+    wchar_t volume[MAX_PATH] = {};
+    if (GetVolumePathNameW(widePath.c_str(), volume, MAX_PATH) &&
+        GetDriveTypeW(volume) == DRIVE_FIXED) {
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping) {
+            m_view = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (!m_view && m_mapping) {
+            CloseHandle(m_mapping);  // No address space for the view; read instead
+            m_mapping = nullptr;
+        }
+    }
+
+    if (!m_view && readAheadMB > 0) {
+        const int64_t windowBytes = static_cast<int64_t>(readAheadMB) * 1024 * 1024;
+        const size_t slots = static_cast<size_t>(std::max<int64_t>(windowBytes / BLOCK_SIZE, 2));
+        m_blocks.resize(slots);
+        for (auto& block : m_blocks) {
+            block.data.resize(static_cast<size_t>(BLOCK_SIZE));
+        }
+        m_stopRequested = false;
+        m_fetchThread = std::thread(&MediaIO::FetchThread, this);
+    }
+
+    uint8_t* buffer = static_cast<uint8_t*>(av_malloc(AVIO_BUFFER_SIZE));
+    if (buffer) {
+        m_avio = avio_alloc_context(buffer, AVIO_BUFFER_SIZE, 0, this, &MediaIO::ReadPacket,
+                                    nullptr, &MediaIO::Seek);
+    }
+    if (!m_avio) {
+        av_free(buffer);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MediaIO::Close() {
+    if (m_fetchThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopRequested = true;
+        }
+        m_fetchCv.notify_one();
+        m_readyCv.notify_all();
+        m_fetchThread.join();
+    }
+
+    if (m_avio) {
+        av_freep(&m_avio->buffer);
+        avio_context_free(&m_avio);
+    }
+    if (m_view) {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+
+    m_blocks.clear();
+    m_blocks.shrink_to_fit();
+    m_fileSize = 0;
+    m_pos      = 0;
+    m_cancel   = nullptr;
+    m_bytesRead    = 0;
+    m_bytesFetched = 0;
+    m_fetchNs      = 0;
+    m_stallNs      = 0;
+}
+
+double MediaIO::GetThroughputMBps() const {
+    const int64_t ns = m_fetchNs.load();
+    if (ns <= 0) return 0.0;
+    return static_cast<double>(m_bytesFetched.load()) / (1024.0 * 1024.0) / (ns / 1.0e9);
+}
+
+int MediaIO::ReadPacket(void* opaque, uint8_t* buf, int size) {
+    return static_cast<MediaIO*>(opaque)->Read(buf, size);
+}
+
+int64_t MediaIO::Seek(void* opaque, int64_t offset, int whence) {
+    MediaIO* self = static_cast<MediaIO*>(opaque);
+    whence &= ~AVSEEK_FORCE;
+    if (whence == AVSEEK_SIZE) return self->m_fileSize;
+
+    std::lock_guard<std::mutex> lock(self->m_mutex);
+    int64_t base;
+    switch (whence) {
+    case SEEK_SET: base = 0;                break;
+    case SEEK_CUR: base = self->m_pos;      break;
+    case SEEK_END: base = self->m_fileSize; break;
+    default:       return AVERROR(EINVAL);
+    }
+    if (base + offset < 0) return AVERROR(EINVAL);
+    self->m_pos = base + offset;
+    self->m_fetchCv.notify_one();  // Refill the window around the new position
+    return self->m_pos;
+}
+
+int MediaIO::Read(uint8_t* buf, int size) {
+    if (!m_view && m_blocks.empty()) return ReadDirect(buf, size);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_pos >= m_fileSize) return AVERROR_EOF;
+
+    if (m_view) {
+        const auto start = std::chrono::steady_clock::now();
+        const int n = static_cast<int>(std::min<int64_t>(size, m_fileSize - m_pos));
+        std::memcpy(buf, m_view + m_pos, static_cast<size_t>(n));  // Page faults land here
+        m_pos += n;
+        m_fetchNs      += ElapsedNs(start);
+        m_bytesFetched += n;
+        m_bytesRead    += n;
+        return n;
+    }
+
+    const int64_t index = m_pos / BLOCK_SIZE;
+    Block* block = FindBlock(index);
+    if (!block || !block->ready) {
+        // The demuxer outran the window (or jumped): wait for this block
+        const auto start = std::chrono::steady_clock::now();
+        m_fetchCv.notify_one();
+        while (!(block = FindBlock(index)) || !block->ready) {
+            if (m_stopRequested.load() || (m_cancel && m_cancel->load())) return AVERROR_EXIT;
+            m_readyCv.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        m_stallNs += ElapsedNs(start);
+    }
+
+    const size_t offset = static_cast<size_t>(m_pos - index * BLOCK_SIZE);
+    if (offset >= block->size) {
+        // The fetch failed; free the slot so the next read retries it
+        block->index = -1;
+        block->ready = false;
+        m_fetchCv.notify_one();
+        return AVERROR(EIO);
+    }
+    const int n = static_cast<int>(std::min<size_t>(static_cast<size_t>(size), block->size - offset));
+    std::memcpy(buf, block->data.data() + offset, static_cast<size_t>(n));
+    m_pos += n;
+    m_bytesRead += n;
+    if (m_pos / BLOCK_SIZE != index) {
+        m_fetchCv.notify_one();  // Window slid; the block just left is reusable
+    }
+    return n;
+}
+
+int MediaIO::ReadDirect(uint8_t* buf, int size) {
+    if (m_pos >= m_fileSize) return AVERROR_EOF;
+    const auto start = std::chrono::steady_clock::now();
+    DWORD got = 0;
+    if (!ReadAt(m_pos, buf, static_cast<DWORD>(size), got)) return AVERROR(EIO);
+    if (got == 0) return AVERROR_EOF;
+
+    const int64_t ns = ElapsedNs(start);
+    m_pos += got;
+    m_fetchNs      += ns;
+    m_stallNs      += ns;  // Every direct read is a wait
+    m_bytesFetched += got;
+    m_bytesRead    += got;
+    return static_cast<int>(got);
+}
+
+bool MediaIO::ReadAt(int64_t offset, uint8_t* buf, DWORD size, DWORD& bytesRead) {
+    // Positional read on a synchronous handle: no shared file pointer between threads
+    OVERLAPPED overlapped{};
+    overlapped.Offset     = static_cast<DWORD>(offset & 0xFFFFFFFF);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    bytesRead = 0;
+    if (ReadFile(m_file, buf, size, &bytesRead, &overlapped)) return true;
+    return GetLastError() == ERROR_HANDLE_EOF;
+}
+
+MediaIO::Block* MediaIO::FindBlock(int64_t index) {
+    for (auto& block : m_blocks) {
+        if (block.index == index) return &block;
+    }
+    return nullptr;
+}
+
+void MediaIO::FetchThread() {
+    const int64_t lastBlock = (m_fileSize - 1) / BLOCK_SIZE;
+    const int64_t window    = static_cast<int64_t>(m_blocks.size());
+
+    while (true) {
+        Block*  target = nullptr;
+        int64_t index  = -1;
+        {
+            // Next missing block in [read block, read block + window), nearest first
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_fetchCv.wait(lock, [&] {
+                if (m_stopRequested.load()) return true;
+                const int64_t first = m_pos / BLOCK_SIZE;
+                const int64_t last  = std::min(first + window - 1, lastBlock);
+                for (int64_t i = first; i <= last; ++i) {
+                    if (!FindBlock(i)) {
+                        index = i;
+                        return true;
+                    }
+                }
+                return false;
+            });
+            if (m_stopRequested.load()) break;
+
+            // A block is missing from a window as large as the slot count, so at
+            // least one slot lies outside it (or was never used)
+            const int64_t first = m_pos / BLOCK_SIZE;
+            for (auto& block : m_blocks) {
+                if (block.index < first || block.index >= first + window) {
+                    target = &block;
+                    break;
+                }
+            }
+            if (!target) continue;
+            target->index = index;
+            target->ready = false;
+            target->size  = 0;
+        }
+
+        // Read outside the lock; the slot is claimed (not ready), so nothing else touches it
+        const auto start = std::chrono::steady_clock::now();
+        const int64_t offset = index * BLOCK_SIZE;
+        const DWORD want = static_cast<DWORD>(std::min(BLOCK_SIZE, m_fileSize - offset));
+        DWORD got = 0;
+        const bool ok = ReadAt(offset, target->data.data(), want, got);
+        m_fetchNs      += ElapsedNs(start);
+        m_bytesFetched += got;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            target->ready = true;
+            target->size  = ok ? got : 0;
+        }
+        m_readyCv.notify_all();
+    }
+}
+
+} // namespace SP
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Common.h"
+#include <condition_variable>
+
+struct AVIOContext;
+
+namespace SP {
+
+// File I/O behind a custom AVIOContext, replacing FFmpeg's file protocol and its
+// 32 KB reads for VideoDecoder's demuxer.
+//
+// Files on local fixed drives are memory-mapped and reads are plain copies out of
+// the view. Everything else (SMB shares, removable and optical drives) gets a
+// read-ahead thread that keeps a window of BLOCK_SIZE blocks filled past the
+// read position, so the demuxer sees RAM latency while the thread issues
+// multi-MB sequential reads. A window of 0 reads straight from the file instead.
+//
+// The AVIO callbacks run on whichever thread is demuxing (the probe, then the
+// decode worker); stats are atomics and safe to read from the UI.
+class MediaIO {
+public:
+    MediaIO() = default;
+    ~MediaIO();
+
+    // Non-copyable
+    MediaIO(const MediaIO&) = delete;
+    MediaIO& operator=(const MediaIO&) = delete;
+
+    // Opens a UTF-8 path. `readAheadMB` sizes the window for non-mapped files.
+    // `cancel` (optional) aborts a read waiting on the read-ahead thread; it must
+    // outlive the reads or be cleared with SetCancelFlag first.
+    bool Open(const std::string& path, int readAheadMB, const std::atomic<bool>* cancel = nullptr);
+    void Close();
+    bool IsOpen() const { return m_file != INVALID_HANDLE_VALUE; }
+    void SetCancelFlag(const std::atomic<bool>* cancel) { m_cancel = cancel; }
+
+    // Assign to AVFormatContext::pb with AVFMT_FLAG_CUSTOM_IO set; stays owned here.
+    AVIOContext* GetContext() const { return m_avio; }
+
+    // Plain file paths only: URLs, devices and pipes go through FFmpeg's protocols
+    static bool IsLocalPath(const std::string& path);
+
+    // Stats
+    bool    IsMemoryMapped() const { return m_view != nullptr; }
+    bool    IsReadAhead() const { return m_fetchThread.joinable(); }
+    int64_t GetFileSize() const { return m_fileSize; }
+    int64_t GetBytesRead() const { return m_bytesRead.load(); }  // Handed to the demuxer
+    double  GetThroughputMBps() const;  // File -> memory while the fetch was busy
+    double  GetStallMs() const { return m_stallNs.load() / 1.0e6; }  // Demuxer waited on I/O
+
+private:
+    // 4 MB sequential reads: large enough to keep SMB and RAID pipelines full
+    static constexpr int64_t BLOCK_SIZE = 4 * 1024 * 1024;
+    // Buffer FFmpeg parses from; refilled from the view or the blocks in one copy
+    static constexpr int AVIO_BUFFER_SIZE = 256 * 1024;
+
+    struct Block {
+        int64_t index = -1;  // Block number in the file (-1 = free)
+        bool    ready = false;
+        size_t  size  = 0;   // Short for the last block
+        std::vector<uint8_t> data;
+    };
+
+    static int     ReadPacket(void* opaque, uint8_t* buf, int size);
+    static int64_t Seek(void* opaque, int64_t offset, int whence);
+    int  Read(uint8_t* buf, int size);
+    int  ReadDirect(uint8_t* buf, int size);        // No mapping, no read-ahead
+    bool ReadAt(int64_t offset, uint8_t* buf, DWORD size, DWORD& bytesRead);
+    void FetchThread();
+    Block* FindBlock(int64_t index);                // Caller holds m_mutex
+
+    HANDLE m_file    = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+    const uint8_t* m_view = nullptr;
+    int64_t m_fileSize = 0;
+    AVIOContext* m_avio = nullptr;
+    const std::atomic<bool>* m_cancel = nullptr;
+
+    // Demuxer read position, guarded by m_mutex (shared with the fetch thread)
+    int64_t m_pos = 0;
+    std::thread m_fetchThread;
+    std::atomic<bool> m_stopRequested{false};
+    std::mutex m_mutex;
+    std::condition_variable m_fetchCv;  // Read position moved or a block was consumed
+    std::condition_variable m_readyCv;  // A block finished loading
+    std::vector<Block> m_blocks;        // Window slots, reused as the window moves
+
+    std::atomic<int64_t> m_bytesRead{0};
+    std::atomic<int64_t> m_bytesFetched{0};
+    std::atomic<int64_t> m_fetchNs{0};
+    std::atomic<int64_t> m_stallNs{0};
+};
+
+} // namespace SP
@@ -0,0 +1,444 @@
+#include "MediaOverview.h"
+#include "D3D11Renderer.h"
+#include "TraceRecorder.h"
+#include "ThreadPriority.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswresample/swresample.h>
+#include <libswscale/swscale.h>
+}
+
+namespace SP {
+
+namespace {
+
+constexpr uint32_t CACHE_MAGIC   = 0x4F4D5053;  // "SPMO"
+constexpr uint32_t CACHE_VERSION = 1;
+
+constexpr size_t THUMB_BYTES = static_cast<size_t>(MediaOverview::THUMB_WIDTH) * MediaOverview::THUMB_HEIGHT * 4;
+// Packets read after a seek before a slot gives up on finding a keyframe
+constexpr int MAX_PACKETS_PER_THUMB = 512;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t  thumbWidth;
+    int32_t  thumbHeight;
+    int32_t  thumbCount;
+    int32_t  waveformBuckets;
+    int32_t  waveformFilled;
+    int32_t  reserved;
+    double   duration;
+};
+
+// Returns (and lazily creates) the overview_cache/ dir next to the exe.
+std::filesystem::path GetOverviewCacheDir() {
+    char exePath[MAX_PATH];
+    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+    auto dir = std::filesystem::path(exePath).parent_path() / "overview_cache";
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    return dir;
+}
+
+int8_t Quantize(float v) {
+    return static_cast<int8_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 127.0f));
+}
+
+} // namespace
+
+MediaOverview::~MediaOverview() {
+    Reset();
+}
+
+void MediaOverview::Build(const std::string& path) {
+    Reset();
+    m_thumbs.assign(THUMB_BYTES * THUMB_COUNT, 0);
+    m_waveform.assign(static_cast<size_t>(WAVEFORM_BUCKETS) * 2, 0);
+    m_building = true;
+    m_thread = std::thread(&MediaOverview::BuildThread, this, path);
+}
+
+void MediaOverview::Reset() {
+    if (m_thread.joinable()) {
+        m_cancel = true;
+        m_thread.join();
+    }
+    m_cancel    = false;
+    m_building  = false;
+    m_fromCache = false;
+    m_progress  = 0.0f;
+    m_duration.store(0.0, std::memory_order_relaxed);
+    for (std::atomic<bool>& ready : m_thumbReady) ready.store(false, std::memory_order_relaxed);
+    m_waveformFilled.store(0, std::memory_order_relaxed);
+    m_thumbs.clear();
+    m_thumbs.shrink_to_fit();
+    m_waveform.clear();
+    m_waveform.shrink_to_fit();
+    std::fill(m_uploaded.begin(), m_uploaded.end(), false);
+}
+
+int MediaOverview::NearestUploadedThumb(int slot) const {
+    if (m_uploaded.empty()) return -1;
+    for (int distance = 0; distance < THUMB_COUNT; ++distance) {
+        if (slot - distance >= 0 && m_uploaded[slot - distance]) return slot - distance;
+        if (slot + distance < THUMB_COUNT && m_uploaded[slot + distance]) return slot + distance;
+    }
+    return -1;
+}
+
+void MediaOverview::Upload(D3D11Renderer& renderer) {
+    if (m_thumbs.empty()) return;
+    if (!m_strip) {
+        D3D11_TEXTURE2D_DESC desc = {};
+        desc.Width            = THUMB_WIDTH * THUMB_COUNT;
+        desc.Height           = THUMB_HEIGHT;
+        desc.MipLevels        = 1;
+        desc.ArraySize        = 1;
+        desc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.Usage            = D3D11_USAGE_DEFAULT;
+        desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+        ID3D11Device* device = renderer.GetDevice();
+        if (!device || FAILED(device->CreateTexture2D(&desc, nullptr, &m_strip)) ||
+            FAILED(device->CreateShaderResourceView(m_strip.Get(), nullptr, &m_stripSRV))) {
+            ReleaseTexture();
+            return;
+        }
+        m_uploaded.assign(THUMB_COUNT, false);
+    }
+
+    for (int slot = 0; slot < THUMB_COUNT; ++slot) {
+        if (m_uploaded[slot] || !IsThumbReady(slot)) continue;
+        const UINT x = static_cast<UINT>(slot * THUMB_WIDTH);
+        const D3D11_BOX box = {x, 0, 0, x + THUMB_WIDTH, THUMB_HEIGHT, 1};
+        renderer.GetContext()->UpdateSubresource(m_strip.Get(), 0, &box, m_thumbs.data() + slot * THUMB_BYTES,
+                                                 THUMB_WIDTH * 4, 0);
+        m_uploaded[slot] = true;
+    }
+}
+
+void MediaOverview::ReleaseTexture() {
+    m_stripSRV.Reset();
+    m_strip.Reset();
+    m_uploaded.clear();
+}
+
+void MediaOverview::GetWaveform(int bucket, float& lo, float& hi) const {
+    lo = m_waveform[static_cast<size_t>(bucket) * 2] / 127.0f;
+    hi = m_waveform[static_cast<size_t>(bucket) * 2 + 1] / 127.0f;
+}
+
+size_t MediaOverview::GetCpuBytes() const {
+    return m_thumbs.capacity() + m_waveform.capacity();
+}
+
+size_t MediaOverview::GetGpuBytes() const {
+    return m_strip ? THUMB_BYTES * THUMB_COUNT : 0;
+}
+
+void MediaOverview::BuildThread(std::string path) {
+    TraceRecorder::SetThreadName("Media overview");
+    ThreadPriority::Apply(ThreadRole::Background);
+    const std::filesystem::path cachePath = GetCachePath(path);
+
+    if (!cachePath.empty() && LoadCache(cachePath)) {
+        m_fromCache = true;
+    } else {
+        // Stills first: a few keyframe decodes show far more than the first
+        // seconds of waveform would
+        const bool filmstrip = BuildFilmstrip(path);
+        const bool waveform  = BuildWaveform(path);
+        // A file without video or without audio caches the half it has
+        if ((filmstrip || waveform) && !m_cancel.load() && !cachePath.empty()) SaveCache(cachePath);
+    }
+
+    m_progress = 1.0f;
+    m_building = false;
+}
+
+AVFormatContext* MediaOverview::OpenInput(const std::string& path) {
+    AVFormatContext* fmt = avformat_alloc_context();
+    if (!fmt) return nullptr;
+    fmt->interrupt_callback.callback = [](void* opaque) -> int {
+        return static_cast<const std::atomic<bool>*>(opaque)->load() ? 1 : 0;
+    };
+    fmt->interrupt_callback.opaque = &m_cancel;
+    if (avformat_open_input(&fmt, path.c_str(), nullptr, nullptr) < 0) return nullptr;  // Freed fmt
+    if (avformat_find_stream_info(fmt, nullptr) < 0 || fmt->duration <= 0) {
+        avformat_close_input(&fmt);
+        return nullptr;  // Slots and buckets are fractions of the duration
+    }
+    m_duration.store(static_cast<double>(fmt->duration) / AV_TIME_BASE, std::memory_order_release);
+    return fmt;
+}
+
+bool MediaOverview::BuildFilmstrip(const std::string& path) {
+    AVFormatContext* fmt = OpenInput(path);
+    if (!fmt) return false;
+
+    AVCodecContext* codecCtx = nullptr;
+    SwsContext*     sws      = nullptr;
+    AVFrame*        frame    = nullptr;
+    AVPacket*       pkt      = nullptr;
+    auto cleanup = [&] {
+        sws_freeContext(sws);
+        avcodec_free_context(&codecCtx);
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        avformat_close_input(&fmt);
+    };
+
+    const int streamIdx = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (streamIdx < 0 || (fmt->streams[streamIdx]->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
+        cleanup();
+        return false;  // Audio only, or just cover art
+    }
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        if (static_cast<int>(i) != streamIdx) fmt->streams[i]->discard = AVDISCARD_ALL;
+    }
+    const AVStream* stream = fmt->streams[streamIdx];
+
+    // Keyframes only, no deblocking, and slice threads so a frame is not held
+    // back behind a frame-thread pipeline: a still costs one intra decode
+    const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!codecCtx || avcodec_parameters_to_context(codecCtx, stream->codecpar) < 0) {
+        cleanup();
+        return false;
+    }
+    codecCtx->skip_frame       = AVDISCARD_NONKEY;
+    codecCtx->skip_loop_filter = AVDISCARD_ALL;
+    codecCtx->thread_count     = 2;
+    codecCtx->thread_type      = FF_THREAD_SLICE;
+    frame = av_frame_alloc();
+    pkt   = av_packet_alloc();
+    if (avcodec_open2(codecCtx, codec, nullptr) < 0 || !frame || !pkt) {
+        cleanup();
+        return false;
+    }
+
+    const double  duration  = GetDuration();
+    const int64_t startTime = (stream->start_time != AV_NOPTS_VALUE) ? stream->start_time : 0;
+    std::vector<uint8_t> scaled(THUMB_BYTES + 64);  // Tail padding for sws_scale's SIMD overshoot
+    bool tried[THUMB_COUNT] = {};
+    int  attempts = 0;
+    bool any      = false;
+
+    // Every eighth slot, then the ones between them, and so on down to every slot
+    for (int stride = THUMB_COUNT / 8; stride >= 1 && !m_cancel.load(); stride /= 2) {
+        for (int slot = 0; slot < THUMB_COUNT && !m_cancel.load(); slot += stride) {
+            if (tried[slot]) continue;
+            tried[slot] = true;
+            m_progress = 0.5f * static_cast<float>(++attempts) / THUMB_COUNT;
+
+            const double seconds = (slot + 0.5) / THUMB_COUNT * duration;
+            const int64_t target = startTime + av_rescale_q(static_cast<int64_t>(seconds * AV_TIME_BASE),
+                                                            AV_TIME_BASE_Q, stream->time_base);
+            if (av_seek_frame(fmt, streamIdx, target, AVSEEK_FLAG_BACKWARD) < 0) continue;
+            avcodec_flush_buffers(codecCtx);
+
+            bool got = false;
+            for (int packets = 0; !got && packets < MAX_PACKETS_PER_THUMB && !m_cancel.load(); ++packets) {
+                if (av_read_frame(fmt, pkt) < 0) break;
+                if (pkt->stream_index == streamIdx && (pkt->flags & AV_PKT_FLAG_KEY) &&
+                    avcodec_send_packet(codecCtx, pkt) >= 0) {
+                    // Drain, so a decoder holding frames for reordering gives this one up now
+                    avcodec_send_packet(codecCtx, nullptr);
+                    got = avcodec_receive_frame(codecCtx, frame) == 0;
+                    avcodec_flush_buffers(codecCtx);  // Accepts packets again after the drain
+                }
+                av_packet_unref(pkt);
+            }
+            if (!got) continue;
+
+            sws = sws_getCachedContext(sws, frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                       THUMB_WIDTH, THUMB_HEIGHT, AV_PIX_FMT_RGBA,
+                                       SWS_AREA, nullptr, nullptr, nullptr);
+            uint8_t* dstData[4]   = { scaled.data(), nullptr, nullptr, nullptr };
+            int dstLinesize[4]    = { THUMB_WIDTH * 4, 0, 0, 0 };
+            const bool converted = sws && sws_scale(sws, frame->data, frame->linesize, 0, frame->height,
+                                                    dstData, dstLinesize) > 0;
+            av_frame_unref(frame);
+            if (!converted) continue;
+
+            std::memcpy(m_thumbs.data() + slot * THUMB_BYTES, scaled.data(), THUMB_BYTES);
+            m_thumbReady[slot].store(true, std::memory_order_release);
+            any = true;
+        }
+    }
+
+    cleanup();
+    return any && !m_cancel.load();
+}
+
+bool MediaOverview::BuildWaveform(const std::string& path) {
+    AVFormatContext* fmt = OpenInput(path);
+    if (!fmt) return false;
+
+    AVCodecContext* codecCtx = nullptr;
+    SwrContext*     swr      = nullptr;
+    AVFrame*        frame    = nullptr;
+    AVPacket*       pkt      = nullptr;
+    auto cleanup = [&] {
+        swr_free(&swr);
+        avcodec_free_context(&codecCtx);
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        avformat_close_input(&fmt);
+    };
+
+    const int streamIdx = av_find_best_stream(fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (streamIdx < 0) {
+        cleanup();
+        return false;  // No audio stream: no waveform
+    }
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        if (static_cast<int>(i) != streamIdx) fmt->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    const AVCodec* codec = avcodec_find_decoder(fmt->streams[streamIdx]->codecpar->codec_id);
+    codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!codecCtx ||
+        avcodec_parameters_to_context(codecCtx, fmt->streams[streamIdx]->codecpar) < 0 ||
+        avcodec_open2(codecCtx, codec, nullptr) < 0 || codecCtx->sample_rate <= 0) {
+        cleanup();
+        return false;
+    }
+
+    // Mono float at the source rate: the overview is one trace
+    AVChannelLayout monoLayout = AV_CHANNEL_LAYOUT_MONO;
+    if (swr_alloc_set_opts2(&swr,
+            &monoLayout,          AV_SAMPLE_FMT_FLT,    codecCtx->sample_rate,
+            &codecCtx->ch_layout, codecCtx->sample_fmt, codecCtx->sample_rate,
+            0, nullptr) < 0 || !swr || swr_init(swr) < 0) {
+        cleanup();
+        return false;
+    }
+    frame = av_frame_alloc();
+    pkt   = av_packet_alloc();
+    if (!frame || !pkt) {
+        cleanup();
+        return false;
+    }
+
+    const double bucketSamples = GetDuration() * codecCtx->sample_rate / WAVEFORM_BUCKETS;
+    int     bucket    = 0;
+    int64_t sample    = 0;
+    int64_t bucketEnd = std::max<int64_t>(1, std::llround(bucketSamples));
+    float   lo = 1.0f, hi = -1.0f;  // Empty until a sample lands
+    // Publishes the current bucket and starts the next
+    auto closeBucket = [&] {
+        m_waveform[static_cast<size_t>(bucket) * 2]     = (lo <= hi) ? Quantize(lo) : 0;
+        m_waveform[static_cast<size_t>(bucket) * 2 + 1] = (lo <= hi) ? Quantize(hi) : 0;
+        m_waveformFilled.store(++bucket, std::memory_order_release);
+        bucketEnd = std::llround((bucket + 1) * bucketSamples);
+        lo = 1.0f;
+        hi = -1.0f;
+        m_progress = 0.5f + 0.5f * static_cast<float>(bucket) / WAVEFORM_BUCKETS;
+    };
+
+    std::vector<float> converted;
+    // A null `packet` flushes the decoder
+    auto decode = [&](const AVPacket* packet) {
+        if (avcodec_send_packet(codecCtx, packet) < 0 && packet) return;
+        while (avcodec_receive_frame(codecCtx, frame) == 0) {
+            const int room = swr_get_out_samples(swr, frame->nb_samples);
+            converted.resize(static_cast<size_t>(std::max(room, 0)));
+            uint8_t* out = reinterpret_cast<uint8_t*>(converted.data());
+            const int got = swr_convert(swr, &out, room,
+                                        const_cast<const uint8_t**>(frame->extended_data), frame->nb_samples);
+            for (int i = 0; i < got; ++i, ++sample) {
+                // Audio running past the container duration piles into the last bucket
+                while (sample >= bucketEnd && bucket < WAVEFORM_BUCKETS - 1) closeBucket();
+                lo = std::min(lo, converted[i]);
+                hi = std::max(hi, converted[i]);
+            }
+            av_frame_unref(frame);
+        }
+    };
+
+    bool ok = true;
+    while (!m_cancel.load()) {
+        const int ret = av_read_frame(fmt, pkt);
+        if (ret == AVERROR_EOF) break;
+        if (ret < 0) { ok = false; break; }
+        if (pkt->stream_index == streamIdx) decode(pkt);
+        av_packet_unref(pkt);
+    }
+    if (ok && !m_cancel.load()) {
+        decode(nullptr);
+        while (bucket < WAVEFORM_BUCKETS) closeBucket();  // Audio shorter than the container: silence
+    }
+
+    cleanup();
+    return ok && !m_cancel.load();
+}
+
+std::filesystem::path MediaOverview::GetCachePath(const std::string& path) {
+    // Key on size + mtime as well as the path so a re-rendered file is rebuilt
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) return {};
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return {};
+
+    const int64_t stamp[2] = {
+        static_cast<int64_t>(size),
+        static_cast<int64_t>(mtime.time_since_epoch().count())
+    };
+    uint64_t hash = Fnv1a64(path.c_str(), path.size());
+    hash = Fnv1a64(reinterpret_cast<const char*>(stamp), sizeof(stamp), hash);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ovw", static_cast<unsigned long long>(hash));
+    return GetOverviewCacheDir() / name;
+}
+
+bool MediaOverview::LoadCache(const std::filesystem::path& cachePath) {
+    std::ifstream in(cachePath, std::ios::binary);
+    if (!in) return false;
+
+    CacheHeader header = {};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+        header.thumbWidth != THUMB_WIDTH || header.thumbHeight != THUMB_HEIGHT ||
+        header.thumbCount != THUMB_COUNT || header.waveformBuckets != WAVEFORM_BUCKETS ||
+        header.waveformFilled < 0 || header.waveformFilled > WAVEFORM_BUCKETS || !(header.duration > 0.0)) {
+        return false;
+    }
+    uint8_t ready[THUMB_COUNT];
+    in.read(reinterpret_cast<char*>(ready), sizeof(ready));
+    in.read(reinterpret_cast<char*>(m_thumbs.data()), static_cast<std::streamsize>(m_thumbs.size()));
+    in.read(reinterpret_cast<char*>(m_waveform.data()), static_cast<std::streamsize>(m_waveform.size()));
+    if (!in) return false;  // Build overwrites whatever was read
+
+    m_duration.store(header.duration, std::memory_order_release);
+    for (int slot = 0; slot < THUMB_COUNT; ++slot) {
+        if (ready[slot]) m_thumbReady[slot].store(true, std::memory_order_release);
+    }
+    m_waveformFilled.store(header.waveformFilled, std::memory_order_release);
+    return true;
+}
+
+void MediaOverview::SaveCache(const std::filesystem::path& cachePath) const {
+    std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+    if (!out) return;
+
+    const CacheHeader header = { CACHE_MAGIC, CACHE_VERSION, THUMB_WIDTH, THUMB_HEIGHT, THUMB_COUNT,
+                                 WAVEFORM_BUCKETS, GetWaveformFilled(), 0, GetDuration() };
+    uint8_t ready[THUMB_COUNT];
+    for (int slot = 0; slot < THUMB_COUNT; ++slot) ready[slot] = IsThumbReady(slot) ? 1 : 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(ready), sizeof(ready));
+    out.write(reinterpret_cast<const char*>(m_thumbs.data()), static_cast<std::streamsize>(m_thumbs.size()));
+    out.write(reinterpret_cast<const char*>(m_waveform.data()), static_cast<std::streamsize>(m_waveform.size()));
+}
+
+} // namespace SP
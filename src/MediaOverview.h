@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Common.h"
+
+struct AVFormatContext;
+
+namespace SP {
+
+class D3D11Renderer;
+
+// Whole-file overview for the transport bar: a filmstrip of THUMB_COUNT small
+// keyframe stills spread evenly over the file, and a min/max waveform of its
+// audio in WAVEFORM_BUCKETS columns. A worker thread builds both with its own
+// AVFormatContexts and decoders, so neither the playback decoder nor its seek
+// position is touched. Stills seek to the keyframe at or before each slot time
+// and decode only that frame (AVDISCARD_NONKEY), scaled straight down to
+// THUMB_WIDTH x THUMB_HEIGHT; the slots come in coarse to fine (every eighth,
+// then halving the stride), so a rough strip shows almost at once. The waveform
+// fills left to right behind it. The finished overview goes to overview_cache/
+// next to the exe, keyed by path + size + mtime.
+//
+// Slots and buckets are published one at a time (acquire/release), so the UI
+// draws whatever is ready while the rest builds.
+class MediaOverview {
+public:
+    static constexpr int THUMB_WIDTH      = 128;
+    static constexpr int THUMB_HEIGHT     = 72;
+    static constexpr int THUMB_COUNT      = 64;    // 2.4 MB of RGBA
+    static constexpr int WAVEFORM_BUCKETS = 1024;
+
+    MediaOverview() = default;
+    ~MediaOverview();
+
+    // Non-copyable
+    MediaOverview(const MediaOverview&) = delete;
+    MediaOverview& operator=(const MediaOverview&) = delete;
+
+    // Load from cache or start building for `path`. Cancels any build in progress.
+    void Build(const std::string& path);
+    // Cancel, join, and clear. Keeps the texture for the next file.
+    void Reset();
+
+    bool  IsBuilding() const { return m_building.load(); }
+    bool  IsFromCache() const { return m_fromCache.load(); }
+    float GetProgress() const { return m_progress.load(); }  // [0,1] while building
+    double GetDuration() const { return m_duration.load(std::memory_order_acquire); }  // 0 until known
+
+    // Filmstrip. Slot i shows the keyframe at or before (i + 0.5) / THUMB_COUNT
+    // of the duration.
+    bool IsThumbReady(int slot) const { return m_thumbReady[slot].load(std::memory_order_acquire); }
+    // Nearest slot to `slot` already in the texture; -1 when there is none
+    int  NearestUploadedThumb(int slot) const;
+    // Main thread, once a frame: copies newly ready slots into the texture
+    void Upload(D3D11Renderer& renderer);
+    // THUMB_COUNT slots side by side; only uploaded slots hold pixels
+    ID3D11ShaderResourceView* GetSRV() const { return m_stripSRV.Get(); }
+    void ReleaseTexture();
+
+    // Waveform: the first GetWaveformFilled() buckets are valid, each the
+    // downmixed sample range [lo, hi] in [-1, 1]
+    int  GetWaveformFilled() const { return m_waveformFilled.load(std::memory_order_acquire); }
+    void GetWaveform(int bucket, float& lo, float& hi) const;
+
+    size_t GetCpuBytes() const;  // Pixels and waveform
+    size_t GetGpuBytes() const;  // The strip texture
+
+private:
+    void BuildThread(std::string path);
+    bool BuildFilmstrip(const std::string& path);
+    bool BuildWaveform(const std::string& path);
+    AVFormatContext* OpenInput(const std::string& path);
+    static std::filesystem::path GetCachePath(const std::string& path);
+    bool LoadCache(const std::filesystem::path& cachePath);
+    void SaveCache(const std::filesystem::path& cachePath) const;
+
+    std::thread m_thread;
+    std::atomic<bool>   m_cancel{false};  // Also interrupts blocking FFmpeg I/O
+    std::atomic<bool>   m_building{false};
+    std::atomic<bool>   m_fromCache{false};
+    std::atomic<float>  m_progress{0.0f};
+    std::atomic<double> m_duration{0.0};
+
+    // Sized once in Build; the worker writes a slot or bucket, then publishes it
+    std::vector<uint8_t> m_thumbs;  // THUMB_COUNT x THUMB_HEIGHT x THUMB_WIDTH x RGBA
+    std::atomic<bool>    m_thumbReady[THUMB_COUNT];  // false-initialized (C++20)
+    std::vector<int8_t>  m_waveform;  // lo, hi per bucket, in 1/127
+    std::atomic<int>     m_waveformFilled{0};
+
+    // Main thread only
+    ComPtr<ID3D11Texture2D>          m_strip;
+    ComPtr<ID3D11ShaderResourceView> m_stripSRV;
+    std::vector<bool>                m_uploaded;
+};
+
+} // namespace SP
@@ -0,0 +1,135 @@
+#include "MediaProbe.h"
+#include <algorithm>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/dict.h>
+}
+
+namespace SP {
+
+namespace {
+
+// FFmpeg's own defaults (5 MB, 5 s) — the last attempt never probes less
+constexpr int64_t DEFAULT_PROBE_BYTES = 5'000'000;
+constexpr int64_t DEFAULT_ANALYZE_US  = 5'000'000;
+
+int InterruptCallback(void* opaque) {
+    return static_cast<const std::atomic<bool>*>(opaque)->load() ? 1 : 0;
+}
+
+} // namespace
+
+MediaProbe::~MediaProbe() {
+    Cancel();
+}
+
+void MediaProbe::Start(const std::string& path, int probeSizeKB, int analyzeDurationMs,
+                       int readAheadMB) {
+    Cancel();
+    m_path   = path;
+    m_cancel = false;
+    m_done   = false;
+    m_thread = std::thread(&MediaProbe::ProbeThread, this, probeSizeKB, analyzeDurationMs,
+                           readAheadMB);
+}
+
+void MediaProbe::Cancel() {
+    if (m_thread.joinable()) {
+        m_cancel = true;
+        m_thread.join();
+    }
+    if (m_result) {
+        avformat_close_input(&m_result);
+    }
+    m_io.reset();  // After the context that reads through it
+    m_done = false;
+}
+
+AVFormatContext* MediaProbe::Take(std::unique_ptr<MediaIO>& outIO) {
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    outIO = std::move(m_io);
+    if (outIO) {
+        outIO->SetCancelFlag(nullptr);  // Reads now belong to the decoder
+    }
+    AVFormatContext* result = m_result;
+    m_result = nullptr;
+    m_done   = false;
+    return result;
+}
+
+void MediaProbe::ProbeThread(int probeSizeKB, int analyzeDurationMs, int readAheadMB) {
+    // Opening the handle can itself block on a slow share, so it happens here too.
+    // If it fails the probe falls back to FFmpeg's own file protocol.
+    if (MediaIO::IsLocalPath(m_path)) {
+        m_io = std::make_unique<MediaIO>();
+        if (!m_io->Open(m_path, readAheadMB, &m_cancel)) {
+            m_io.reset();
+        }
+    }
+    m_result = ProbeFile(m_path, probeSizeKB, analyzeDurationMs, &m_cancel, m_io.get());
+    if (!m_result) {
+        m_io.reset();
+    }
+    m_done.store(true, std::memory_order_release);
+}
+
+AVFormatContext* MediaProbe::ProbeFile(const std::string& path, int probeSizeKB,
+                                       int analyzeDurationMs, const std::atomic<bool>* cancel,
+                                       MediaIO* io) {
+    int64_t probeBytes = probeSizeKB > 0 ? static_cast<int64_t>(probeSizeKB) * 1024 : DEFAULT_PROBE_BYTES;
+    int64_t analyzeUs  = analyzeDurationMs > 0 ? static_cast<int64_t>(analyzeDurationMs) * 1000 : DEFAULT_ANALYZE_US;
+
+    for (int attempt = 0; attempt < PROBE_ATTEMPTS; ++attempt) {
+        if (attempt == PROBE_ATTEMPTS - 1) {
+            probeBytes = std::max(probeBytes, DEFAULT_PROBE_BYTES);
+            analyzeUs  = std::max(analyzeUs, DEFAULT_ANALYZE_US);
+        }
+
+        AVFormatContext* ctx = avformat_alloc_context();
+        if (!ctx) return nullptr;
+        if (cancel) {
+            ctx->interrupt_callback.callback = InterruptCallback;
+            ctx->interrupt_callback.opaque   = const_cast<std::atomic<bool>*>(cancel);
+        }
+        if (io) {
+            // Each attempt re-reads the header; avformat_close_input leaves a custom pb open
+            avio_seek(io->GetContext(), 0, SEEK_SET);
+            ctx->pb     = io->GetContext();
+            ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+        }
+
+        AVDictionary* options = nullptr;
+        av_dict_set_int(&options, "probesize", probeBytes, 0);
+        av_dict_set_int(&options, "analyzeduration", analyzeUs, 0);
+        const int ret = avformat_open_input(&ctx, path.c_str(), nullptr, &options);
+        av_dict_free(&options);
+        if (ret < 0) {
+            return nullptr;  // Missing/unreadable file — more probing won't help
+        }
+
+        if (avformat_find_stream_info(ctx, nullptr) >= 0) {
+            const int video = av_find_best_stream(ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+            if (video < 0) {
+                avformat_close_input(&ctx);
+                return nullptr;  // No video stream at all
+            }
+            if (ctx->streams[video]->codecpar->width > 0) {
+                // Later reads belong to VideoDecoder; a later Cancel() must not abort them
+                ctx->interrupt_callback = AVIOInterruptCB{};
+                return ctx;
+            }
+        }
+        avformat_close_input(&ctx);
+        if (cancel && cancel->load()) return nullptr;
+
+        // Not enough data to know the stream yet — probe further
+        probeBytes *= 8;
+        analyzeUs  *= 8;
+    }
+    return nullptr;
+}
+
+} // namespace SP
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Common.h"
+#include "MediaIO.h"
+
+struct AVFormatContext;
+
+namespace SP {
+
+// Opens and probes a media file on a worker thread, so avformat_open_input and
+// avformat_find_stream_info (seconds on network shares and large MXF files) never
+// run on the UI thread. The probed AVFormatContext is then handed to
+// VideoDecoder::Open, which takes ownership.
+//
+// Probing is progressive: the first attempt uses the configured (small) probe
+// size and analyze duration for a fast start. If that leaves the video stream
+// without dimensions, it retries with 8x the budget, twice, before giving up.
+//
+// Plain files are read through a MediaIO (mapped or read-ahead) created on the
+// worker; it travels with the context so the decoder keeps reading through it.
+class MediaProbe {
+public:
+    MediaProbe() = default;
+    ~MediaProbe();
+
+    // Non-copyable
+    MediaProbe(const MediaProbe&) = delete;
+    MediaProbe& operator=(const MediaProbe&) = delete;
+
+    // Cancels any probe in progress and starts probing `path`. `readAheadMB` sizes
+    // the MediaIO window (AppConfig::ioReadAheadMB).
+    void Start(const std::string& path, int probeSizeKB, int analyzeDurationMs, int readAheadMB);
+    // Interrupts blocking I/O, joins, and frees an uncollected result.
+    void Cancel();
+
+    bool IsActive() const { return m_thread.joinable(); }  // Started, not yet taken
+    bool IsDone() const { return m_done.load(std::memory_order_acquire); }
+    const std::string& GetPath() const { return m_path; }
+
+    // Call once IsDone(). Joins the worker and returns the probed context (the
+    // caller owns it) or nullptr when the file could not be opened. `outIO`
+    // receives the context's custom I/O, if any, which must outlive the context.
+    AVFormatContext* Take(std::unique_ptr<MediaIO>& outIO);
+
+    // Synchronous probe, shared by the worker and VideoDecoder::Open. A size or
+    // duration of 0 means FFmpeg's default. `cancel` (optional) interrupts blocking
+    // I/O; `io` (optional) replaces FFmpeg's file protocol. Returns nullptr on
+    // failure, when no video stream was found, or when cancelled.
+    static AVFormatContext* ProbeFile(const std::string& path, int probeSizeKB,
+                                      int analyzeDurationMs,
+                                      const std::atomic<bool>* cancel = nullptr,
+                                      MediaIO* io = nullptr);
+
+private:
+    static constexpr int PROBE_ATTEMPTS = 3;
+
+    void ProbeThread(int probeSizeKB, int analyzeDurationMs, int readAheadMB);
+
+    std::string m_path;
+    std::thread m_thread;
+    std::atomic<bool> m_cancel{false};
+    std::atomic<bool> m_done{false};
+    AVFormatContext* m_result = nullptr;  // Published by m_done
+    std::unique_ptr<MediaIO> m_io;        // m_result's pb, when it has a custom one
+};
+
+} // namespace SP
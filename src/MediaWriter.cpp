@@ -0,0 +1,225 @@
+#include "MediaWriter.h"
+#include "TraceRecorder.h"
+#include "ThreadPriority.h"
+#include <algorithm>
+#include <chrono>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace SP {
+
+namespace {
+
+int64_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+std::wstring ToWide(const std::string& utf8) {
+    const int len = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, nullptr, 0);
+    if (len <= 0) return {};
+    std::wstring wide(static_cast<size_t>(len), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, wide.data(), len);
+    wide.resize(static_cast<size_t>(len - 1));
+    return wide;
+}
+
+void RaiseMax(std::atomic<int64_t>& value, int64_t candidate) {
+    int64_t current = value.load();
+    while (candidate > current && !value.compare_exchange_weak(current, candidate)) {}
+}
+
+} // namespace
+
+MediaWriter::~MediaWriter() {
+    Close();
+}
+
+bool MediaWriter::Open(const std::string& path, int bufferMB, bool writeThrough) {
+    Close();
+
+    const std::wstring widePath = ToWide(path);
+    if (widePath.empty()) return false;
+
+    m_file = CreateFileW(widePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                         FILE_ATTRIBUTE_NORMAL | (writeThrough ? FILE_FLAG_WRITE_THROUGH : 0), nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) return false;
+
+    if (bufferMB > 0) {
+        m_capacity = static_cast<size_t>(bufferMB) * 1024 * 1024;
+        m_stopRequested = false;
+        m_writeThread = std::thread(&MediaWriter::WriteThread, this);
+    }
+
+    // avio_alloc_context's write callback takes a const buffer from libavformat 61
+    uint8_t* buffer = static_cast<uint8_t*>(av_malloc(AVIO_BUFFER_SIZE));
+    if (buffer) {
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+        m_avio = avio_alloc_context(buffer, AVIO_BUFFER_SIZE, 1, this, nullptr,
+                                    &MediaWriter::WritePacket, &MediaWriter::Seek);
+#else
+        m_avio = avio_alloc_context(buffer, AVIO_BUFFER_SIZE, 1, this, nullptr,
+                                    [](void* opaque, uint8_t* buf, int size) { return WritePacket(opaque, buf, size); },
+                                    &MediaWriter::Seek);
+#endif
+    }
+    if (!m_avio) {
+        av_free(buffer);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool MediaWriter::Close() {
+    if (m_avio) avio_flush(m_avio);
+
+    if (m_writeThread.joinable()) {
+        // The thread drains the queue before it exits
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopRequested = true;
+        }
+        m_workCv.notify_one();
+        m_writeThread.join();
+    }
+
+    if (m_avio) {
+        av_freep(&m_avio->buffer);
+        avio_context_free(&m_avio);
+    }
+    const bool ok = !m_failed.load();
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+
+    m_queue.clear();
+    m_spare.clear();
+    m_capacity = 0;
+    m_pos      = 0;
+    m_size     = 0;
+    m_queuedBytes = 0;
+    m_peakQueuedBytes = 0;
+    m_failed   = false;
+    m_bytesWritten = 0;
+    m_maxWriteNs   = 0;
+    m_stallNs      = 0;
+    return ok;
+}
+
+double MediaWriter::GetBufferFill() const {
+    return m_capacity > 0 ? static_cast<double>(m_queuedBytes.load()) / m_capacity : 0.0;
+}
+
+double MediaWriter::GetPeakBufferFill() const {
+    return m_capacity > 0 ? static_cast<double>(m_peakQueuedBytes.load()) / m_capacity : 0.0;
+}
+
+int MediaWriter::WritePacket(void* opaque, const uint8_t* buf, int size) {
+    return static_cast<MediaWriter*>(opaque)->Write(buf, size);
+}
+
+int64_t MediaWriter::Seek(void* opaque, int64_t offset, int whence) {
+    MediaWriter* self = static_cast<MediaWriter*>(opaque);
+    whence &= ~AVSEEK_FORCE;
+
+    // Positions only: queued chunks keep the offsets they were written at
+    std::lock_guard<std::mutex> lock(self->m_mutex);
+    if (whence == AVSEEK_SIZE) return self->m_size;
+    int64_t base;
+    switch (whence) {
+    case SEEK_SET: base = 0;            break;
+    case SEEK_CUR: base = self->m_pos;  break;
+    case SEEK_END: base = self->m_size; break;
+    default:       return AVERROR(EINVAL);
+    }
+    if (base + offset < 0) return AVERROR(EINVAL);
+    self->m_pos = base + offset;
+    return self->m_pos;
+}
+
+int MediaWriter::Write(const uint8_t* buf, int size) {
+    if (size <= 0) return 0;
+    if (m_failed.load()) return AVERROR(EIO);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const int64_t offset = m_pos;
+    m_pos += size;
+    m_size = std::max(m_size, m_pos);
+
+    if (!m_writeThread.joinable()) {
+        lock.unlock();
+        return WriteAt(offset, buf, static_cast<size_t>(size)) ? size : AVERROR(EIO);
+    }
+
+    // Only a stall longer than the whole queue reaches the encoder
+    if (m_queuedBytes.load() + static_cast<size_t>(size) > m_capacity) {
+        const auto start = std::chrono::steady_clock::now();
+        m_spaceCv.wait(lock, [&] {
+            return m_queuedBytes.load() + static_cast<size_t>(size) <= m_capacity || m_queue.empty() ||
+                   m_failed.load();
+        });
+        m_stallNs += ElapsedNs(start);
+        if (m_failed.load()) return AVERROR(EIO);
+    }
+
+    Chunk chunk;
+    chunk.offset = offset;
+    if (!m_spare.empty()) {
+        chunk.data = std::move(m_spare.back());
+        m_spare.pop_back();
+    }
+    chunk.data.assign(buf, buf + size);
+    m_queue.push_back(std::move(chunk));
+    m_queuedBytes += static_cast<size_t>(size);
+    m_peakQueuedBytes = std::max(m_peakQueuedBytes.load(), m_queuedBytes.load());
+    lock.unlock();
+    m_workCv.notify_one();
+    return size;
+}
+
+bool MediaWriter::WriteAt(int64_t offset, const uint8_t* data, size_t size) {
+    const auto start = std::chrono::steady_clock::now();
+    OVERLAPPED position{};
+    position.Offset     = static_cast<DWORD>(offset & 0xFFFFFFFF);
+    position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD written = 0;
+    const bool ok = WriteFile(m_file, data, static_cast<DWORD>(size), &written, &position) && written == size;
+    RaiseMax(m_maxWriteNs, ElapsedNs(start));
+    if (ok) {
+        m_bytesWritten += static_cast<int64_t>(size);
+    } else {
+        m_failed = true;
+    }
+    return ok;
+}
+
+void MediaWriter::WriteThread() {
+    TraceRecorder::SetThreadName("File writer");
+    ThreadPriority::Apply(ThreadRole::Background);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_workCv.wait(lock, [this] { return !m_queue.empty() || m_stopRequested.load(); });
+        if (m_queue.empty()) break;  // Stop requested and drained
+
+        Chunk chunk = std::move(m_queue.front());
+        m_queue.pop_front();
+        lock.unlock();
+
+        // After a failure the rest is discarded; the muxer sees EIO on its next write
+        if (!m_failed.load()) {
+            SP_TRACE_SCOPE("Write");
+            WriteAt(chunk.offset, chunk.data.data(), chunk.data.size());
+        }
+
+        lock.lock();
+        m_queuedBytes -= chunk.data.size();
+        if (m_spare.size() < MAX_SPARE_CHUNKS) m_spare.push_back(std::move(chunk.data));
+        m_spaceCv.notify_one();
+    }
+}
+
+} // namespace SP
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Common.h"
+#include <condition_variable>
+#include <deque>
+
+struct AVIOContext;
+
+namespace SP {
+
+// File output behind a custom AVIOContext, replacing FFmpeg's file protocol for
+// VideoEncoder's muxer; the write-side counterpart of MediaIO.
+//
+// The muxer's writes are copied into a write-behind queue of up to `bufferMB` and
+// return at once; a writer thread puts them on disk. A short stall of the disk
+// (antivirus scan, NAS flush) then fills the queue instead of blocking the
+// encoder thread, and only a stall longer than the queue holds back-pressures it.
+// Chunks carry their file offset and are written positionally, so the muxer's
+// seeks (MP4 size patches, the moov atom) never wait for the queue to drain.
+//
+// The AVIO callbacks run on the encoder thread; stats are atomics and safe to read
+// from the UI.
+class MediaWriter {
+public:
+    MediaWriter() = default;
+    ~MediaWriter();
+
+    // Non-copyable
+    MediaWriter(const MediaWriter&) = delete;
+    MediaWriter& operator=(const MediaWriter&) = delete;
+
+    // Creates (truncates) a UTF-8 path. `bufferMB` = 0 writes synchronously on the
+    // muxer's thread. `writeThrough` skips the OS write cache (FILE_FLAG_WRITE_THROUGH),
+    // so the file is on the disk when Close returns.
+    bool Open(const std::string& path, int bufferMB, bool writeThrough);
+    // Flushes the AVIO buffer and the queue, then closes. False when any write failed.
+    bool Close();
+    bool IsOpen() const { return m_file != INVALID_HANDLE_VALUE; }
+
+    // Assign to AVFormatContext::pb with AVFMT_FLAG_CUSTOM_IO set; stays owned here.
+    AVIOContext* GetContext() const { return m_avio; }
+
+    // Stats
+    int64_t GetBytesWritten() const { return m_bytesWritten.load(); }  // On disk
+    double  GetBufferFill() const;      // Queued / capacity, 0..1
+    double  GetPeakBufferFill() const;  // Highest since Open
+    size_t  GetQueuedBytes() const { return m_queuedBytes.load(); }  // Written by the muxer, not yet on disk
+    double  GetMaxWriteMs() const { return m_maxWriteNs.load() / 1.0e6; }  // Slowest single write
+    double  GetStallMs() const { return m_stallNs.load() / 1.0e6; }  // Muxer waited for queue space
+
+private:
+    // Buffer FFmpeg writes into; each flush of it becomes one queued chunk
+    static constexpr int AVIO_BUFFER_SIZE = 1024 * 1024;
+    // Recycled chunk allocations kept between writes
+    static constexpr size_t MAX_SPARE_CHUNKS = 8;
+
+    struct Chunk {
+        int64_t offset = 0;
+        std::vector<uint8_t> data;
+    };
+
+    static int WritePacket(void* opaque, const uint8_t* buf, int size);
+    static int64_t Seek(void* opaque, int64_t offset, int whence);
+    int  Write(const uint8_t* buf, int size);
+    bool WriteAt(int64_t offset, const uint8_t* data, size_t size);  // Timed positional write
+    void WriteThread();
+
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    AVIOContext* m_avio = nullptr;
+
+    // Muxer position and the file's extent; the queue writes behind them
+    int64_t m_pos  = 0;
+    int64_t m_size = 0;
+
+    std::thread m_writeThread;
+    std::atomic<bool> m_stopRequested{false};
+    std::mutex m_mutex;
+    std::condition_variable m_workCv;   // A chunk was queued
+    std::condition_variable m_spaceCv;  // A chunk was written
+    std::deque<Chunk> m_queue;
+    std::vector<std::vector<uint8_t>> m_spare;
+    size_t m_capacity = 0;
+    std::atomic<size_t> m_queuedBytes{0};
+    std::atomic<size_t> m_peakQueuedBytes{0};
+    std::atomic<bool> m_failed{false};
+
+    std::atomic<int64_t> m_bytesWritten{0};
+    std::atomic<int64_t> m_maxWriteNs{0};
+    std::atomic<int64_t> m_stallNs{0};
+};
+
+} // namespace SP
@@ -0,0 +1,18 @@
+#include "MemoryUsage.h"
+#include <psapi.h>
+
+namespace SP {
+
+ProcessMemory QueryProcessMemory() {
+    ProcessMemory out;
+    PROCESS_MEMORY_COUNTERS_EX counters = {};
+    counters.cb = sizeof(counters);
+    if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+                             sizeof(counters))) {
+        out.privateBytes = counters.PrivateUsage;
+        out.workingSet   = counters.WorkingSetSize;
+    }
+    return out;
+}
+
+} // namespace SP
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// One subsystem's footprint, for the memory panel and the benchmark reports:
+// what it holds right now (queued frames, cached textures, ring buffers), not
+// its capacity. Collected by D3D11Renderer::GetMemoryUsage and
+// Application::GetMemoryUsage from counters each subsystem keeps itself.
+struct MemoryUsage {
+    const char* name     = "";
+    size_t      cpuBytes = 0;
+    size_t      gpuBytes = 0;
+};
+
+// The adapter's segment budgets and this process's usage of them
+// (IDXGIAdapter3::QueryVideoMemoryInfo); all zero where it isn't reported.
+// Local is VRAM on a discrete GPU; non-local is system memory the GPU maps.
+struct VideoMemoryInfo {
+    uint64_t localBudget    = 0;
+    uint64_t localUsage     = 0;
+    uint64_t nonLocalBudget = 0;
+    uint64_t nonLocalUsage  = 0;
+};
+
+// Committed private bytes and the working set of this process (GetProcessMemoryInfo)
+struct ProcessMemory {
+    size_t privateBytes = 0;
+    size_t workingSet   = 0;
+};
+ProcessMemory QueryProcessMemory();
+
+} // namespace SP
@@ -0,0 +1,201 @@
+#include "MetricsServer.h"
+#include "ThreadPriority.h"
+#include "TraceRecorder.h"
+#include <winsock2.h>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+namespace SP {
+
+namespace {
+
+// A request line and headers fit well within this; anything longer is cut off
+constexpr int REQUEST_MAX_BYTES = 4096;
+// A client that connects and says nothing is dropped after this long
+constexpr DWORD CLIENT_TIMEOUT_MS = 2000;
+
+struct MetricInfo {
+    const char* name;
+    const char* labels;  // Inside the braces, or "" for none
+    const char* type;
+    const char* help;
+};
+
+// Same order as MetricsServer::Gauge; entries sharing a name share HELP/TYPE lines
+constexpr MetricInfo GAUGES[] = {
+    {"shaderplayer_frame_time_ms", "quantile=\"0.5\"",  "gauge", "Main-loop tick time over the recent ticks"},
+    {"shaderplayer_frame_time_ms", "quantile=\"0.99\"", "gauge", ""},
+    {"shaderplayer_frame_time_ms", "quantile=\"1\"",    "gauge", ""},
+    {"shaderplayer_decode_ms",             "", "gauge", "Decode thread time per video frame, averaged"},
+    {"shaderplayer_gpu_ms",                "", "gauge", "GPU time of the last measured frame"},
+    {"shaderplayer_encoder_queue_depth",   "", "gauge", "Frames waiting in the recording encoder's queue"},
+    {"shaderplayer_vram_usage_bytes",      "", "gauge", "Local video memory used by the process"},
+    {"shaderplayer_vram_budget_bytes",     "", "gauge", "Local video memory budget the OS grants the process"},
+    {"shaderplayer_playing",               "", "gauge", "1 while playback is running"},
+    {"shaderplayer_watchdog_level",        "", "gauge", "Frame watchdog step: 0 normal, 1 low resolution, 2 defaults, 3 passthrough"},
+};
+static_assert(static_cast<int>(std::size(GAUGES)) == MetricsServer::GAUGE_COUNT, "one entry per Gauge");
+
+// Same order as MetricsServer::Counter
+constexpr MetricInfo COUNTERS[] = {
+    {"shaderplayer_frames_total",                 "", "counter", "Main-loop ticks"},
+    {"shaderplayer_late_drops_total",             "", "counter", "Frames due together with a newer one and never shown"},
+    {"shaderplayer_render_ahead_underruns_total", "", "counter", "Ticks due with no rendered-ahead frame ready"},
+    {"shaderplayer_encoder_dropped_frames_total", "", "counter", "Frames the recording and stream encoders dropped"},
+    {"shaderplayer_audio_underruns_total",        "", "counter", "Audio device callbacks the output ring ran dry in"},
+    {"shaderplayer_watchdog_stalls_total",        "", "counter", "Main-loop stalls the frame watchdog saw"},
+};
+static_assert(static_cast<int>(std::size(COUNTERS)) == MetricsServer::COUNTER_COUNT, "one entry per Counter");
+
+void AppendMetric(std::string& out, const MetricInfo& info, const MetricInfo* previous, const char* value) {
+    if (!previous || std::strcmp(previous->name, info.name) != 0) {
+        out += "# HELP "; out += info.name; out += ' '; out += info.help; out += '\n';
+        out += "# TYPE "; out += info.name; out += ' '; out += info.type; out += '\n';
+    }
+    out += info.name;
+    if (info.labels[0]) {
+        out += '{'; out += info.labels; out += '}';
+    }
+    out += ' '; out += value; out += '\n';
+}
+
+void SendAll(SOCKET s, const std::string& data) {
+    for (size_t sent = 0; sent < data.size();) {
+        const int n = send(s, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+        if (n == SOCKET_ERROR || n == 0) return;
+        sent += static_cast<size_t>(n);
+    }
+}
+
+} // namespace
+
+MetricsServer::~MetricsServer() {
+    Stop();
+}
+
+bool MetricsServer::Start(int port) {
+    Stop();
+    m_error.clear();
+    if (!m_wsaStarted) {
+        WSADATA wsa{};
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+            m_error = "Winsock unavailable";
+            return false;
+        }
+        m_wsaStarted = true;
+    }
+
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET) {
+        m_error = "Could not create a TCP socket";
+        return false;
+    }
+    // Another process may not take the port while this one listens on it
+    const BOOL exclusive = TRUE;
+    setsockopt(s, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, reinterpret_cast<const char*>(&exclusive), sizeof(exclusive));
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port        = htons(static_cast<u_short>(port));
+    if (bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR ||
+        listen(s, SOMAXCONN) == SOCKET_ERROR) {
+        closesocket(s);
+        m_error = "TCP port " + std::to_string(port) + " is in use";
+        return false;
+    }
+
+    m_socket = static_cast<uintptr_t>(s);
+    m_stop.store(false, std::memory_order_relaxed);
+    m_thread = std::thread(&MetricsServer::ServerThread, this);
+    return true;
+}
+
+void MetricsServer::Stop() {
+    if (m_thread.joinable()) {
+        m_stop.store(true, std::memory_order_relaxed);
+        closesocket(static_cast<SOCKET>(m_socket));  // Wakes the blocked accept
+        m_thread.join();
+        m_socket = static_cast<uintptr_t>(INVALID_SOCKET);
+    }
+    if (m_wsaStarted) {
+        WSACleanup();
+        m_wsaStarted = false;
+    }
+}
+
+void MetricsServer::ServerThread() {
+    TraceRecorder::SetThreadName("Metrics server");
+    ThreadPriority::Apply(ThreadRole::Background);
+    const SOCKET listener = static_cast<SOCKET>(m_socket);
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        const SOCKET client = accept(listener, nullptr, nullptr);
+        if (client == INVALID_SOCKET) {
+            if (m_stop.load(std::memory_order_relaxed)) break;  // Closed by Stop
+            continue;
+        }
+        Serve(static_cast<uintptr_t>(client));
+        closesocket(client);
+    }
+}
+
+void MetricsServer::Serve(uintptr_t clientSocket) {
+    const SOCKET client = static_cast<SOCKET>(clientSocket);
+    const DWORD timeout = CLIENT_TIMEOUT_MS;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+
+    // The request line is all that matters; headers are read past and ignored
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < REQUEST_MAX_BYTES) {
+        const int n = recv(client, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        request.append(buffer, static_cast<size_t>(n));
+    }
+    const size_t lineEnd = request.find("\r\n");
+    if (lineEnd == std::string::npos) return;
+    const std::string line = request.substr(0, lineEnd);
+
+    std::string status = "404 Not Found";
+    std::string type   = "text/plain; charset=utf-8";
+    std::string body   = "Not found. Metrics are at /metrics\n";
+    const bool get  = line.rfind("GET ", 0) == 0;
+    const bool head = line.rfind("HEAD ", 0) == 0;
+    if (!get && !head) {
+        status = "405 Method Not Allowed";
+        body   = "GET only\n";
+    } else {
+        const size_t pathStart = line.find(' ') + 1;
+        const std::string path = line.substr(pathStart, line.find(' ', pathStart) - pathStart);
+        if (path == "/metrics" || path.rfind("/metrics?", 0) == 0) {
+            status = "200 OK";
+            type   = "text/plain; version=0.0.4; charset=utf-8";
+            body   = Render();
+            m_scrapes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + type +
+                           "\r\nContent-Length: " + std::to_string(body.size()) +
+                           "\r\nCache-Control: no-store\r\nConnection: close\r\n\r\n";
+    if (get) response += body;
+    SendAll(client, response);
+}
+
+std::string MetricsServer::Render() const {
+    std::string out;
+    out.reserve(2048);
+    char value[32];
+    for (int i = 0; i < GAUGE_COUNT; ++i) {
+        snprintf(value, sizeof(value), "%.6g", m_gauges[i].load(std::memory_order_relaxed));
+        AppendMetric(out, GAUGES[i], i > 0 ? &GAUGES[i - 1] : nullptr, value);
+    }
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        snprintf(value, sizeof(value), "%lld", static_cast<long long>(m_counters[i].load(std::memory_order_relaxed)));
+        AppendMetric(out, COUNTERS[i], i > 0 ? &COUNTERS[i - 1] : nullptr, value);
+    }
+    return out;
+}
+
+} // namespace SP
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Common.h"
+#include <array>
+
+namespace SP {
+
+// Prometheus text exposition (format 0.0.4) on http://<host>:<port>/metrics, so
+// a fleet of unattended installations can be scraped and alerted on before a
+// visitor notices a stutter (AppConfig::metricsEnabled / metricsPort).
+//
+// The main thread copies its instrumentation counters in with Set about once a
+// second (Application::PublishMetrics); each value is an atomic, so the server
+// thread reads them with relaxed loads when a scrape arrives and never waits on
+// the render loop, a lock or the UI. The server answers one connection at a
+// time, GET only, and exposes nothing but these numbers. Start and Stop are
+// main-thread calls.
+class MetricsServer {
+public:
+    enum class Gauge {
+        FrameP50Ms, FrameP99Ms, FrameMaxMs,  // CpuProfiler history: main-loop tick time
+        DecodeMs,                            // Decode thread, per frame, averaged
+        GpuMs,                               // GpuProfiler: first to last timestamp of a frame
+        EncoderQueueDepth,                   // Frames behind the one the encoder took last
+        VramUsageBytes, VramBudgetBytes,     // Local segment (QueryVideoMemoryInfo)
+        Playing,                             // 1 while playing
+        WatchdogLevel,                       // FrameWatchdog step, 0 = normal
+        Count
+    };
+    enum class Counter {
+        Frames,                // Ticks recorded by the CpuProfiler
+        LateDrops,             // Frames due together with a newer one, never shown
+        RenderAheadUnderruns,  // Ticks due with no rendered frame ready
+        EncoderDrops,          // Frames the recording/stream encoders dropped
+        AudioUnderruns,        // AudioPlayer callbacks the ring ran dry in
+        WatchdogStalls,        // Main-loop stalls FrameWatchdog saw
+        Count
+    };
+    static constexpr int GAUGE_COUNT   = static_cast<int>(Gauge::Count);
+    static constexpr int COUNTER_COUNT = static_cast<int>(Counter::Count);
+
+    MetricsServer() = default;
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Listen on TCP `port` (all interfaces). False with GetError() set when the
+    // port could not be bound.
+    bool Start(int port);
+    void Stop();
+    bool IsRunning() const { return m_thread.joinable(); }
+    const std::string& GetError() const { return m_error; }
+    int64_t GetScrapes() const { return m_scrapes.load(std::memory_order_relaxed); }
+
+    // Any thread
+    void Set(Gauge gauge, double value) {
+        m_gauges[static_cast<int>(gauge)].store(value, std::memory_order_relaxed);
+    }
+    void Set(Counter counter, int64_t value) {
+        m_counters[static_cast<int>(counter)].store(value, std::memory_order_relaxed);
+    }
+
+private:
+    void ServerThread();
+    void Serve(uintptr_t client);
+    std::string Render() const;
+
+    std::array<std::atomic<double>, GAUGE_COUNT>    m_gauges{};
+    std::array<std::atomic<int64_t>, COUNTER_COUNT> m_counters{};
+    std::atomic<int64_t> m_scrapes{0};
+
+    uintptr_t         m_socket = ~static_cast<uintptr_t>(0);  // SOCKET; INVALID_SOCKET when closed
+    bool              m_wsaStarted = false;
+    std::thread       m_thread;
+    std::atomic<bool> m_stop{false};
+    std::string       m_error;
+};
+
+} // namespace SP
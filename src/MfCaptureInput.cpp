@@ -0,0 +1,303 @@
+#include "MfCaptureInput.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mfapi.h>
+
+namespace SP {
+
+namespace {
+
+constexpr DWORD VIDEO_STREAM = static_cast<DWORD>(MF_SOURCE_READER_FIRST_VIDEO_STREAM);
+
+std::string ToUtf8(const wchar_t* text) {
+    const int len = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    if (len <= 0) return {};
+    std::string out(len - 1, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, out.data(), len, nullptr, nullptr);
+    return out;
+}
+
+// The video capture device with this friendly name, activated
+ComPtr<IMFMediaSource> FindDevice(const std::string& name) {
+    ComPtr<IMFAttributes> attributes;
+    if (FAILED(MFCreateAttributes(&attributes, 1)) ||
+        FAILED(attributes->SetGUID(MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE, MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE_VIDCAP_GUID))) {
+        return nullptr;
+    }
+    IMFActivate** devices = nullptr;
+    UINT32 count = 0;
+    if (FAILED(MFEnumDeviceSources(attributes.Get(), &devices, &count))) return nullptr;
+
+    ComPtr<IMFMediaSource> source;
+    for (UINT32 i = 0; i < count; ++i) {
+        wchar_t* friendly = nullptr;
+        UINT32 length = 0;
+        if (!source && SUCCEEDED(devices[i]->GetAllocatedString(MF_DEVSOURCE_ATTRIBUTE_FRIENDLY_NAME, &friendly, &length))) {
+            if (ToUtf8(friendly) == name) devices[i]->ActivateObject(IID_PPV_ARGS(&source));
+            CoTaskMemFree(friendly);
+        }
+        devices[i]->Release();
+    }
+    CoTaskMemFree(devices);
+    return source;
+}
+
+// The native type matching a CaptureDevices mode: same FOURCC and size, and a
+// frame rate within 1% (dshow reports 10000000 / interval, MF a ratio)
+bool SelectNativeType(IMFSourceReader* reader, const CaptureMode& mode) {
+    ComPtr<IMFMediaType> type;
+    for (DWORD i = 0; SUCCEEDED(reader->GetNativeMediaType(VIDEO_STREAM, i, &type)); ++i, type.Reset()) {
+        GUID subtype = GUID_NULL;
+        UINT32 width = 0, height = 0, num = 0, den = 0;
+        if (FAILED(type->GetGUID(MF_MT_SUBTYPE, &subtype)) || subtype.Data1 != mode.fourcc ||
+            FAILED(MFGetAttributeSize(type.Get(), MF_MT_FRAME_SIZE, &width, &height)) ||
+            static_cast<int>(width) != mode.width || static_cast<int>(height) != mode.height ||
+            FAILED(MFGetAttributeRatio(type.Get(), MF_MT_FRAME_RATE, &num, &den)) || den == 0) {
+            continue;
+        }
+        const double fps = static_cast<double>(num) / den;
+        if (std::abs(fps - mode.GetFps()) <= mode.GetFps() * 0.01)
+            return SUCCEEDED(reader->SetCurrentMediaType(VIDEO_STREAM, nullptr, type.Get()));
+    }
+    return false;
+}
+
+} // namespace
+
+// Async reader callback. Holds only a pointer back, cleared by Detach, so a
+// read the reader completes after Close lands nowhere.
+class MfCaptureInput::ReaderCallback : public IMFSourceReaderCallback {
+public:
+    explicit ReaderCallback(MfCaptureInput* owner) : m_owner(owner) {}
+
+    void Detach() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_owner = nullptr;
+    }
+
+    STDMETHODIMP QueryInterface(REFIID riid, void** object) override {
+        if (!object) return E_POINTER;
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IMFSourceReaderCallback)) {
+            *object = static_cast<IMFSourceReaderCallback*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+    STDMETHODIMP_(ULONG) AddRef() override { return ++m_refs; }
+    STDMETHODIMP_(ULONG) Release() override {
+        const ULONG refs = --m_refs;
+        if (refs == 0) delete this;
+        return refs;
+    }
+
+    STDMETHODIMP OnReadSample(HRESULT status, DWORD, DWORD flags, LONGLONG, IMFSample* sample) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_owner) m_owner->OnSample(status, flags, sample);
+        return S_OK;
+    }
+    STDMETHODIMP OnFlush(DWORD) override { return S_OK; }
+    STDMETHODIMP OnEvent(DWORD, IMFMediaEvent*) override { return S_OK; }
+
+private:
+    std::atomic<ULONG> m_refs{1};
+    std::mutex         m_mutex;
+    MfCaptureInput*    m_owner;
+};
+
+MfCaptureInput::~MfCaptureInput() {
+    Close();
+}
+
+bool MfCaptureInput::Open(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& deviceName,
+                          const CaptureMode* mode) {
+    Close();
+    if (!device || !context || deviceName.empty()) return false;
+    if (FAILED(MFStartup(MF_VERSION, MFSTARTUP_LITE))) return false;
+    m_mfStarted = true;
+
+    // MF's transforms use the device from their own threads
+    ComPtr<ID3D10Multithread> multithread;
+    if (SUCCEEDED(device->QueryInterface(IID_PPV_ARGS(&multithread))))
+        multithread->SetMultithreadProtected(TRUE);
+
+    UINT resetToken = 0;
+    ComPtr<IMFAttributes> attributes;
+    m_source   = FindDevice(deviceName);
+    m_callback.Attach(new ReaderCallback(this));
+    if (!m_source || FAILED(MFCreateDXGIDeviceManager(&resetToken, &m_deviceManager)) ||
+        FAILED(m_deviceManager->ResetDevice(device, resetToken)) ||
+        FAILED(MFCreateAttributes(&attributes, 5)) ||
+        FAILED(attributes->SetUnknown(MF_SOURCE_READER_D3D_MANAGER, m_deviceManager.Get())) ||
+        FAILED(attributes->SetUnknown(MF_SOURCE_READER_ASYNC_CALLBACK, m_callback.Get())) ||
+        FAILED(attributes->SetUINT32(MF_READWRITE_ENABLE_HARDWARE_TRANSFORMS, TRUE)) ||
+        FAILED(attributes->SetUINT32(MF_SOURCE_READER_ENABLE_ADVANCED_VIDEO_PROCESSING, TRUE)) ||
+        FAILED(attributes->SetUINT32(MF_LOW_LATENCY, TRUE)) ||
+        FAILED(MFCreateSourceReaderFromMediaSource(m_source.Get(), attributes.Get(), &m_reader))) {
+        Close();
+        return false;
+    }
+
+    m_reader->SetStreamSelection(static_cast<DWORD>(MF_SOURCE_READER_ALL_STREAMS), FALSE);
+    m_reader->SetStreamSelection(VIDEO_STREAM, TRUE);
+    if (mode && mode->fourcc != 0) SelectNativeType(m_reader.Get(), *mode);
+
+    // ARGB32 out: MF's video processor converts on the GPU, at the native size
+    ComPtr<IMFMediaType> output, current;
+    UINT32 width = 0, height = 0, num = 0, den = 0;
+    if (FAILED(MFCreateMediaType(&output)) ||
+        FAILED(output->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video)) ||
+        FAILED(output->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_ARGB32)) ||
+        FAILED(m_reader->SetCurrentMediaType(VIDEO_STREAM, nullptr, output.Get())) ||
+        FAILED(m_reader->GetCurrentMediaType(VIDEO_STREAM, &current)) ||
+        FAILED(MFGetAttributeSize(current.Get(), MF_MT_FRAME_SIZE, &width, &height)) || width == 0 || height == 0) {
+        Close();
+        return false;
+    }
+    m_width  = static_cast<int>(width);
+    m_height = static_cast<int>(height);
+    m_fps    = SUCCEEDED(MFGetAttributeRatio(current.Get(), MF_MT_FRAME_RATE, &num, &den)) && den != 0
+             ? static_cast<double>(num) / den : 30.0;
+
+    m_device     = device;
+    m_context    = context;
+    m_deviceName = deviceName;
+    if (FAILED(m_reader->ReadSample(VIDEO_STREAM, 0, nullptr, nullptr, nullptr, nullptr))) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MfCaptureInput::Close() {
+    // Waits for an OnReadSample in progress; later ones are ignored
+    if (m_callback) static_cast<ReaderCallback*>(m_callback.Get())->Detach();
+    m_reader.Reset();
+    if (m_source) m_source->Shutdown();
+    m_source.Reset();
+    m_callback.Reset();
+    m_deviceManager.Reset();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_latest.Reset();
+    }
+    if (m_mfStarted) MFShutdown();
+    m_mfStarted = false;
+
+    m_uploadRing.Reset();
+    m_srv.Reset();
+    m_texture.Reset();
+    m_format  = DXGI_FORMAT_UNKNOWN;
+    m_device  = nullptr;
+    m_context = nullptr;
+    m_deviceName.clear();
+    m_width  = 0;
+    m_height = 0;
+    m_fps    = 0.0;
+    m_framesReceived = 0;
+    m_cpuFrames      = 0;
+    m_framesDropped  = 0;
+    m_failed         = false;
+}
+
+void MfCaptureInput::OnSample(HRESULT status, DWORD flags, IMFSample* sample) {
+    if (FAILED(status) || (flags & (MF_SOURCE_READERF_ERROR | MF_SOURCE_READERF_ENDOFSTREAM))) {
+        m_failed.store(true, std::memory_order_release);
+        return;
+    }
+    if (sample) {  // Null on a stream tick (gap)
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_latest) m_framesDropped.fetch_add(1, std::memory_order_relaxed);  // The render thread didn't take the last one
+        m_latest = sample;
+    }
+    if (FAILED(m_reader->ReadSample(VIDEO_STREAM, 0, nullptr, nullptr, nullptr, nullptr)))
+        m_failed.store(true, std::memory_order_release);
+}
+
+bool MfCaptureInput::Receive() {
+    if (!m_reader) return false;
+    ComPtr<IMFSample> sample;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sample = std::move(m_latest);
+    }
+    ComPtr<IMFMediaBuffer> buffer;
+    if (!sample || FAILED(sample->GetBufferByIndex(0, &buffer))) return false;
+
+    ComPtr<IMFDXGIBuffer> dxgiBuffer;
+    if (SUCCEEDED(buffer.As(&dxgiBuffer))) {
+        // A slice of MF's sample pool: copied out so the sample goes back at once
+        ComPtr<ID3D11Texture2D> source;
+        UINT subresource = 0;
+        if (FAILED(dxgiBuffer->GetResource(IID_PPV_ARGS(&source))) ||
+            FAILED(dxgiBuffer->GetSubresourceIndex(&subresource))) {
+            return false;
+        }
+        D3D11_TEXTURE2D_DESC desc = {};
+        source->GetDesc(&desc);
+        if (!EnsureTexture(m_width, m_height, desc.Format)) return false;
+        // Pool surfaces may be padded past the frame size
+        const D3D11_BOX box = { 0, 0, 0, std::min(desc.Width, static_cast<UINT>(m_width)),
+                                std::min(desc.Height, static_cast<UINT>(m_height)), 1 };
+        m_context->CopySubresourceRegion(m_texture.Get(), 0, 0, 0, 0, source.Get(), subresource, &box);
+    } else {
+        if (!UploadFromMemory(buffer.Get())) return false;
+        ++m_cpuFrames;
+    }
+    ++m_framesReceived;
+    return true;
+}
+
+bool MfCaptureInput::EnsureTexture(int width, int height, DXGI_FORMAT format) {
+    if (m_texture && m_format == format) return true;
+    m_srv.Reset();
+    m_texture.Reset();
+    m_format = DXGI_FORMAT_UNKNOWN;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = static_cast<UINT>(width);
+    desc.Height           = static_cast<UINT>(height);
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &m_texture)) ||
+        FAILED(m_device->CreateShaderResourceView(m_texture.Get(), nullptr, &m_srv))) {
+        m_srv.Reset();
+        m_texture.Reset();
+        return false;
+    }
+    m_format = format;
+    return true;
+}
+
+bool MfCaptureInput::UploadFromMemory(IMFMediaBuffer* buffer) {
+    // ARGB32 in memory is B8G8R8A8; IMF2DBuffer gives the top row and signed pitch
+    ComPtr<IMF2DBuffer> buffer2d;
+    if (FAILED(buffer->QueryInterface(IID_PPV_ARGS(&buffer2d)))) return false;
+    if (!EnsureTexture(m_width, m_height, DXGI_FORMAT_B8G8R8A8_UNORM)) return false;
+
+    BYTE* scan0 = nullptr;
+    LONG  pitch = 0;
+    if (FAILED(buffer2d->Lock2D(&scan0, &pitch))) return false;
+    const size_t rowBytes = static_cast<size_t>(m_width) * 4;
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    const bool mappedOk = static_cast<size_t>(std::abs(pitch)) >= rowBytes &&
+                          m_uploadRing.Map(m_device, m_context, m_width, m_height, DXGI_FORMAT_B8G8R8A8_UNORM, mapped);
+    if (mappedOk) {
+        // Bottom-up buffers have a negative pitch
+        for (int y = 0; y < m_height; ++y) {
+            memcpy(static_cast<uint8_t*>(mapped.pData) + static_cast<size_t>(y) * mapped.RowPitch,
+                   scan0 + static_cast<ptrdiff_t>(y) * pitch, rowBytes);
+        }
+        m_uploadRing.Commit(m_context, m_texture.Get());
+    }
+    buffer2d->Unlock2D();
+    return mappedOk;
+}
+
+} // namespace SP
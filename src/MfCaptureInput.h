@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Common.h"
+#include "TextureUploadRing.h"
+#include <mfidl.h>
+#include <mfreadwrite.h>
+
+namespace SP {
+
+// Webcam / capture card through Media Foundation instead of dshow + FFmpeg, as
+// the video source in place of VideoDecoder like SpoutInput and NdiInput. The
+// IMFSourceReader gets an IMFDXGIDeviceManager on the renderer's device, low
+// latency mode and hardware transforms, and is asked for ARGB32: MJPEG decode
+// (a hardware MFT where the GPU has one) and the YUV→RGB conversion run in MF's
+// D3D11 video processor, so samples arrive as textures. The reader runs in
+// async mode: each OnReadSample (on an MF work queue thread) keeps the newest
+// sample and asks for the next, so there is no thread of our own; Close
+// detaches the callback, waiting out a call in progress. Receive copies the sample's subresource into
+// our own shader-visible texture on the render thread, which returns the sample
+// to MF's pool, and D3D11Renderer::SetExternalVideo binds it at t0. A sample
+// without a DXGI buffer (no GPU path for the mode) is uploaded through a
+// TextureUploadRing instead and counted in GetCpuFrames.
+class MfCaptureInput {
+public:
+    MfCaptureInput() = default;
+    ~MfCaptureInput();
+
+    MfCaptureInput(const MfCaptureInput&) = delete;
+    MfCaptureInput& operator=(const MfCaptureInput&) = delete;
+
+    // `deviceName` is the friendly name CaptureDevices::Enumerate lists (MF and
+    // dshow share it). `mode` picks the native type with that size, rate and
+    // format; null or unmatched keeps the device's default.
+    bool Open(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& deviceName,
+              const CaptureMode* mode);
+    void Close();
+    bool IsOpen() const { return m_reader != nullptr; }
+
+    // Once per tick. True when a new frame was copied into GetSRV's texture
+    bool Receive();
+    const std::string& GetDeviceName() const { return m_deviceName; }
+
+    ID3D11ShaderResourceView* GetSRV() const { return m_srv.Get(); }
+    int GetWidth()  const { return m_width; }
+    int GetHeight() const { return m_height; }
+    double GetFps() const { return m_fps; }
+    int64_t GetFramesReceived() const { return m_framesReceived; }
+    int64_t GetFramesDropped()  const { return m_framesDropped.load(std::memory_order_relaxed); }
+    int64_t GetCpuFrames()      const { return m_cpuFrames; }
+    // Reading stopped on an error (device unplugged, taken by another app)
+    bool HasFailed() const { return m_failed.load(std::memory_order_acquire); }
+
+private:
+    class ReaderCallback;
+    friend class ReaderCallback;
+
+    // From ReaderCallback::OnReadSample; issues the next read unless closing
+    void OnSample(HRESULT status, DWORD flags, IMFSample* sample);
+    bool EnsureTexture(int width, int height, DXGI_FORMAT format);
+    bool UploadFromMemory(IMFMediaBuffer* buffer);
+
+    ID3D11Device*        m_device  = nullptr;
+    ID3D11DeviceContext* m_context = nullptr;
+    bool                 m_mfStarted = false;
+    std::string          m_deviceName;
+
+    ComPtr<IMFDXGIDeviceManager>    m_deviceManager;
+    ComPtr<IMFMediaSource>          m_source;
+    ComPtr<IMFSourceReader>         m_reader;
+    ComPtr<IMFSourceReaderCallback> m_callback;  // A ReaderCallback
+
+    // OnSample fills m_latest; Receive takes it
+    ComPtr<IMFSample>    m_latest;
+    std::atomic<bool>    m_failed{false};
+    std::atomic<int64_t> m_framesDropped{0};
+    std::mutex           m_mutex;
+
+    TextureUploadRing                m_uploadRing;
+    ComPtr<ID3D11Texture2D>          m_texture;
+    ComPtr<ID3D11ShaderResourceView> m_srv;
+    DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+    int     m_width  = 0;   // Of the reader's output type
+    int     m_height = 0;
+    double  m_fps    = 0.0;
+    int64_t m_framesReceived = 0;
+    int64_t m_cpuFrames      = 0;
+};
+
+} // namespace SP
@@ -0,0 +1,142 @@
+#include "ModulationMatrix.h"
+#include "ShaderManager.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace SP {
+
+namespace {
+
+constexpr const char* SOURCE_NAMES[] = {
+    "sine", "triangle", "saw", "square", "random",
+    "rms", "bass", "mid", "high", "beat", "centroid", "beatPhase", "barPhase",
+};
+static_assert(std::size(SOURCE_NAMES) == static_cast<size_t>(ModulationSource::Count));
+
+constexpr double TWO_PI = 6.283185307179586;
+// A longer step than this (a seek, a stall) restarts the followers at their source
+constexpr double MAX_FOLLOWER_STEP = 0.25;
+
+// Sample-and-hold value of an LFO cycle, in [0, 1)
+float HashCycle(int64_t cycle) {
+    uint64_t h = static_cast<uint64_t>(cycle) * 0x9E3779B97F4A7C15ull;
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 29;
+    return static_cast<float>(h >> 40) / static_cast<float>(1ull << 24);
+}
+
+} // namespace
+
+const char* ModulationMatrix::GetSourceName(ModulationSource source) {
+    const int index = static_cast<int>(source);
+    return (index >= 0 && index < static_cast<int>(ModulationSource::Count)) ? SOURCE_NAMES[index] : SOURCE_NAMES[0];
+}
+
+ModulationSource ModulationMatrix::ParseSourceName(const std::string& name) {
+    for (int i = 0; i < static_cast<int>(ModulationSource::Count); ++i) {
+        if (name == SOURCE_NAMES[i]) return static_cast<ModulationSource>(i);
+    }
+    return ModulationSource::Sine;
+}
+
+void ModulationMatrix::SetBase(const float base[16]) {
+    std::copy_n(base, 16, m_base);
+}
+
+void ModulationMatrix::Build(const ShaderPreset& preset) {
+    m_preset     = &preset;
+    m_params     = preset.params.data();
+    m_paramCount = preset.params.size();
+    m_revision   = preset.modulationRevision;
+    m_count      = 0;
+    m_followersPrimed = false;
+    ShaderManager::PackParamValues(preset, m_base);  // A preset switch doesn't go through SetBase
+
+    for (const Modulation& row : preset.modulations) {
+        if (!row.enabled || m_count == MAX_ROWS) continue;
+        auto param = std::find_if(preset.params.begin(), preset.params.end(),
+                                  [&](const ShaderParam& p) { return p.name == row.param; });
+        if (param == preset.params.end() || param->cbufferOffset < 0) continue;
+        const int components = param->type == ShaderParamType::Float   ? 1
+                             : param->type == ShaderParamType::Point2D ? 2
+                             : param->type == ShaderParamType::Color   ? 4 : 0;
+        if (row.component < 0 || row.component >= components) continue;  // Bool, Long, Event: not modulated
+        const int slot = param->cbufferOffset + row.component;
+        if (slot >= 16) continue;
+
+        const int i = m_count++;
+        m_source[i]  = row.source;
+        m_slot[i]    = slot;
+        m_rate[i]    = row.rate;
+        m_phase[i]   = row.phase;
+        m_curve[i]   = std::max(row.curve, 0.01f);
+        m_offset[i]  = row.min;
+        m_depth[i]   = row.max - row.min;
+        m_attack[i]  = std::max(row.attack, 0.0f);
+        m_release[i] = std::max(row.release, 0.0f);
+        const bool color = param->type == ShaderParamType::Color;
+        m_low[i]  = color ? 0.0f : std::min(param->min, param->max);
+        m_high[i] = color ? 1.0f : std::max(param->min, param->max);
+    }
+}
+
+bool ModulationMatrix::Apply(const ShaderPreset& preset, const AudioData& audio, double time, float out[16]) {
+    if (&preset != m_preset || preset.params.data() != m_params || preset.params.size() != m_paramCount ||
+        preset.modulationRevision != m_revision) {
+        Build(preset);
+    }
+    if (m_count == 0) {
+        // Once more after the last row goes, so the unmodulated values go back out
+        if (!m_applied) return false;
+        m_applied = false;
+        std::copy_n(m_base, 16, out);
+        return true;
+    }
+    m_applied = true;
+
+    // Followers step with playback time: they hold while paused
+    const double step = time - m_lastTime;
+    const bool snap = !m_followersPrimed || step < 0.0 || step > MAX_FOLLOWER_STEP;
+    m_lastTime        = time;
+    m_followersPrimed = true;
+
+    // In ModulationSource order from Rms
+    const float bands[] = { audio.rms, audio.bass, audio.mid, audio.high, audio.beat,
+                            audio.spectralCentroid, audio.beatPhase, audio.barPhase };
+
+    std::copy_n(m_base, 16, out);
+    for (int i = 0; i < m_count; ++i) {
+        float value;
+        if (m_source[i] < ModulationSource::Rms) {
+            const double cycle = time * m_rate[i] + m_phase[i];
+            const double x = cycle - std::floor(cycle);
+            switch (m_source[i]) {
+            case ModulationSource::Sine:     value = static_cast<float>(0.5 - 0.5 * std::cos(TWO_PI * x)); break;
+            case ModulationSource::Triangle: value = static_cast<float>(x < 0.5 ? 2.0 * x : 2.0 - 2.0 * x); break;
+            case ModulationSource::Saw:      value = static_cast<float>(x); break;
+            case ModulationSource::Square:   value = x < 0.5 ? 1.0f : 0.0f; break;
+            default:                         value = HashCycle(static_cast<int64_t>(std::floor(cycle))); break;
+            }
+        } else {
+            value = bands[static_cast<int>(m_source[i]) - static_cast<int>(ModulationSource::Rms)];
+        }
+
+        float& follower = m_follower[i];
+        const float seconds = value > follower ? m_attack[i] : m_release[i];
+        if (snap || seconds <= 0.0f) {
+            follower = value;
+        } else {
+            follower += (value - follower) * static_cast<float>(1.0 - std::exp(-step / seconds));
+        }
+
+        const float shaped = std::pow(std::clamp(follower, 0.0f, 1.0f), m_curve[i]);
+        out[m_slot[i]] += m_offset[i] + m_depth[i] * shaped;
+    }
+    // After every row, so several rows on one component add up before the clamp
+    for (int i = 0; i < m_count; ++i) out[m_slot[i]] = std::clamp(out[m_slot[i]], m_low[i], m_high[i]);
+    return true;
+}
+
+} // namespace SP
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// The modulation matrix: LFOs and audio bands driving param components on top
+// of their own values (ShaderPreset::modulations). The rows are compiled into
+// flat arrays of custom[] indices, ranges and follower state whenever they or
+// the preset's params change, so a frame is one pass over those arrays writing
+// the packed custom[16] block: no param lookups, no UI, and no upload of its
+// own, since custom[] rides in b0 with the clock that is uploaded every frame
+// anyway. LFOs run on playback time, so exports and batch jobs see the same
+// curves as playback.
+class ModulationMatrix {
+public:
+    static constexpr int MAX_ROWS = 32;
+
+    // Names for the UI and config.json, in ModulationSource order
+    static const char* GetSourceName(ModulationSource source);
+    static ModulationSource ParseSourceName(const std::string& name);  // Sine when unknown
+
+    // The preset's packed values (ShaderManager::PackParamValues), modulated by Apply
+    void SetBase(const float base[16]);
+    // custom[16] for `time`: the base with every enabled row added and clamped to
+    // its param's range. Rebuilds first when the preset's rows or params changed.
+    // False, leaving `out` alone, when no row applies (after one last call
+    // returning the base once the rows are gone).
+    bool Apply(const ShaderPreset& preset, const AudioData& audio, double time, float out[16]);
+    // Envelope followers restart at their source's value (seek, preset switch)
+    void Reset() { m_followersPrimed = false; }
+
+private:
+    void Build(const ShaderPreset& preset);
+
+    // What the arrays were built from. A re-parse replaces the params vector,
+    // so its buffer identifies the layout.
+    const ShaderPreset*  m_preset   = nullptr;
+    const ShaderParam*   m_params   = nullptr;
+    size_t               m_paramCount = 0;
+    int                  m_revision = -1;
+
+    float m_base[16] = {};
+
+    // One entry per enabled row that resolved to a custom[] slot
+    int              m_count = 0;
+    ModulationSource m_source[MAX_ROWS] = {};
+    int   m_slot[MAX_ROWS]    = {};
+    float m_rate[MAX_ROWS]    = {};
+    float m_phase[MAX_ROWS]   = {};
+    float m_curve[MAX_ROWS]   = {};
+    float m_offset[MAX_ROWS]  = {};  // Modulation::min
+    float m_depth[MAX_ROWS]   = {};  // max - min
+    float m_attack[MAX_ROWS]  = {};
+    float m_release[MAX_ROWS] = {};
+    float m_low[MAX_ROWS]     = {};  // The param's range
+    float m_high[MAX_ROWS]    = {};
+    float m_follower[MAX_ROWS] = {};  // Smoothed source value
+    bool   m_applied = false;  // The last Apply wrote `out`
+    bool   m_followersPrimed = false;
+    double m_lastTime = 0.0;
+};
+
+} // namespace SP
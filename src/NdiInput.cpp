@@ -0,0 +1,172 @@
+#include "NdiInput.h"
+
+#ifdef SHADERPLAYER_NDI
+#include "NdiRuntime.h"
+#endif
+
+namespace SP {
+
+#ifdef SHADERPLAYER_NDI
+
+namespace {
+
+constexpr uint32_t CAPTURE_TIMEOUT_MS = 100;  // Receive thread's wait, so Close never waits longer
+
+} // namespace
+
+NdiInput::~NdiInput() {
+    Close();
+    if (m_finder) LoadNdiRuntime()->find_destroy(static_cast<NDIlib_find_instance_t>(m_finder));
+}
+
+bool NdiInput::Open(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& sourceName) {
+    Close();
+    const NDIlib_v5* ndi = LoadNdiRuntime();
+    if (!ndi || !device || !context || sourceName.empty()) return false;
+
+    NDIlib_source_t source;
+    source.p_ndi_name = sourceName.c_str();
+    NDIlib_recv_create_v3_t desc;
+    desc.source_to_connect_to = source;
+    desc.color_format         = NDIlib_recv_color_format_RGBX_RGBA;  // Decoded straight to what t0 holds
+    desc.bandwidth            = NDIlib_recv_bandwidth_highest;
+    desc.allow_video_fields   = false;
+    desc.p_ndi_recv_name      = "ShaderPlayer";
+    m_receiver = ndi->recv_create_v3(&desc);
+    if (!m_receiver) return false;
+
+    m_device     = device;
+    m_context    = context;
+    m_sourceName = sourceName;
+    m_fresh      = false;
+    m_stop       = false;
+    m_thread     = std::thread(&NdiInput::ReceiveThread, this);
+    return true;
+}
+
+void NdiInput::Close() {
+    if (!m_receiver) return;
+    m_stop = true;
+    m_thread.join();
+    LoadNdiRuntime()->recv_destroy(static_cast<NDIlib_recv_instance_t>(m_receiver));
+    m_receiver = nullptr;
+
+    m_latest = Frame{};
+    m_upload = Frame{};
+    m_uploadRing.Reset();
+    m_srv.Reset();
+    m_texture.Reset();
+    m_device  = nullptr;
+    m_context = nullptr;
+    m_sourceName.clear();
+    m_width  = 0;
+    m_height = 0;
+    m_framesReceived = 0;
+    m_framesDropped  = 0;
+}
+
+void NdiInput::ReceiveThread() {
+    const NDIlib_v5* ndi = LoadNdiRuntime();
+    const auto receiver = static_cast<NDIlib_recv_instance_t>(m_receiver);
+    Frame frame;
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        NDIlib_video_frame_v2_t video;
+        if (ndi->recv_capture_v2(receiver, &video, nullptr, nullptr, CAPTURE_TIMEOUT_MS) != NDIlib_frame_type_video)
+            continue;  // Timeout, status change or metadata (audio is not requested)
+
+        // Copied out right away: NDI's frame must go back before the next capture
+        const size_t rowBytes = static_cast<size_t>(video.xres) * 4;
+        frame.rgba.resize(rowBytes * video.yres);
+        CopyRows(frame.rgba.data(), rowBytes, video.p_data, static_cast<size_t>(video.line_stride_in_bytes), rowBytes,
+                 video.yres);
+        frame.width  = video.xres;
+        frame.height = video.yres;
+        ndi->recv_free_video_v2(receiver, &video);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_fresh) m_framesDropped.fetch_add(1, std::memory_order_relaxed);  // The render thread didn't take the last one
+        std::swap(m_latest, frame);
+        m_fresh = true;
+    }
+}
+
+bool NdiInput::Receive() {
+    if (!m_receiver) return false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_fresh) return false;
+        std::swap(m_latest, m_upload);
+        m_fresh = false;
+    }
+
+    const Frame& frame = m_upload;
+    if (frame.width != m_width || frame.height != m_height || !m_texture) {
+        m_srv.Reset();
+        m_texture.Reset();
+        D3D11_TEXTURE2D_DESC desc = {};
+        desc.Width            = static_cast<UINT>(frame.width);
+        desc.Height           = static_cast<UINT>(frame.height);
+        desc.MipLevels        = 1;
+        desc.ArraySize        = 1;
+        desc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.Usage            = D3D11_USAGE_DEFAULT;
+        desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+        if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &m_texture)) ||
+            FAILED(m_device->CreateShaderResourceView(m_texture.Get(), nullptr, &m_srv))) {
+            m_srv.Reset();
+            m_texture.Reset();
+            m_width  = 0;
+            m_height = 0;
+            return false;
+        }
+        m_width  = frame.width;
+        m_height = frame.height;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (!m_uploadRing.Map(m_device, m_context, frame.width, frame.height, DXGI_FORMAT_R8G8B8A8_UNORM, mapped))
+        return false;
+    const size_t rowBytes = static_cast<size_t>(frame.width) * 4;
+    CopyRows(static_cast<uint8_t*>(mapped.pData), mapped.RowPitch, frame.rgba.data(), rowBytes, rowBytes, frame.height);
+    m_uploadRing.Commit(m_context, m_texture.Get());
+    ++m_framesReceived;
+    return true;
+}
+
+bool NdiInput::IsConnected() const {
+    return m_receiver &&
+           LoadNdiRuntime()->recv_get_no_connections(static_cast<NDIlib_recv_instance_t>(m_receiver)) > 0;
+}
+
+std::vector<std::string> NdiInput::ListSources() {
+    const NDIlib_v5* ndi = LoadNdiRuntime();
+    if (!ndi) return {};
+    if (!m_finder) {
+        NDIlib_find_create_t desc;
+        desc.show_local_sources = true;  // Other apps on this machine too
+        m_finder = ndi->find_create_v2(&desc);
+        if (!m_finder) return {};
+    }
+    uint32_t count = 0;
+    const NDIlib_source_t* sources =
+        ndi->find_get_current_sources(static_cast<NDIlib_find_instance_t>(m_finder), &count);
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (sources[i].p_ndi_name) names.emplace_back(sources[i].p_ndi_name);
+    }
+    return names;
+}
+
+#else  // No NDI SDK in this build
+
+NdiInput::~NdiInput() = default;
+bool NdiInput::Open(ID3D11Device*, ID3D11DeviceContext*, const std::string&) { return false; }
+void NdiInput::Close() {}
+bool NdiInput::Receive() { return false; }
+bool NdiInput::IsConnected() const { return false; }
+std::vector<std::string> NdiInput::ListSources() { return {}; }
+
+#endif
+
+} // namespace SP
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Common.h"
+#include "TextureUploadRing.h"
+
+namespace SP {
+
+// NDI receiver — a network source (another machine, a camera, NDI Tools' Screen
+// Capture) as the video source in place of VideoDecoder, like SpoutInput. A
+// receive thread captures frames decoded to RGBA by NDI and keeps only the
+// newest; Receive uploads it through a TextureUploadRing on the render thread,
+// and D3D11Renderer::SetExternalVideo binds the texture at t0. Without an NDI
+// build or runtime Open fails and ListSources is empty.
+class NdiInput {
+public:
+    NdiInput() = default;
+    ~NdiInput();
+
+    NdiInput(const NdiInput&) = delete;
+    NdiInput& operator=(const NdiInput&) = delete;
+
+    bool Open(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& sourceName);
+    void Close();
+    bool IsOpen() const { return m_receiver != nullptr; }
+
+    // Once per tick. True when a new frame was uploaded into GetSRV's texture
+    bool Receive();
+    bool IsConnected() const;  // The source is connected
+    const std::string& GetSourceName() const { return m_sourceName; }
+
+    ID3D11ShaderResourceView* GetSRV() const { return m_srv.Get(); }
+    int GetWidth()  const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int64_t GetFramesReceived() const { return m_framesReceived; }
+    int64_t GetFramesDropped()  const { return m_framesDropped.load(std::memory_order_relaxed); }
+
+    // Sources seen on the network so far. The first call starts discovery in
+    // the background, so it may return nothing; call again to refresh.
+    std::vector<std::string> ListSources();
+
+private:
+    struct Frame {
+        std::vector<uint8_t> rgba;  // width * 4 bytes per row
+        int width  = 0;
+        int height = 0;
+    };
+
+    void ReceiveThread();
+
+    ID3D11Device*        m_device  = nullptr;
+    ID3D11DeviceContext* m_context = nullptr;
+    void* m_finder   = nullptr;  // NDIlib_find_instance_t, kept for the next ListSources
+    void* m_receiver = nullptr;  // NDIlib_recv_instance_t
+    std::string m_sourceName;
+
+    // The receive thread fills m_latest (m_fresh = not yet uploaded); Receive swaps it out
+    Frame                m_latest;
+    Frame                m_upload;
+    bool                 m_fresh = false;
+    std::atomic<bool>    m_stop{false};
+    std::atomic<int64_t> m_framesDropped{0};
+    std::mutex           m_mutex;
+    std::thread          m_thread;
+
+    TextureUploadRing                m_uploadRing;
+    ComPtr<ID3D11Texture2D>          m_texture;
+    ComPtr<ID3D11ShaderResourceView> m_srv;
+    int     m_width  = 0;
+    int     m_height = 0;
+    int64_t m_framesReceived = 0;
+};
+
+} // namespace SP
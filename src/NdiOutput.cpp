@@ -0,0 +1,288 @@
+#include "NdiOutput.h"
+#include "D3D11Renderer.h"
+#include "PixelCopy.h"
+
+#ifdef SHADERPLAYER_NDI
+#include "NdiRuntime.h"
+#endif
+
+namespace SP {
+
+NdiOutput::~NdiOutput() {
+    Stop();
+}
+
+#ifdef SHADERPLAYER_NDI
+
+namespace {
+
+constexpr double STATS_SMOOTHING = 0.1;  // Weight of the newest frame in the averages
+
+double Smooth(double average, double sample) {
+    return average > 0.0 ? average + (sample - average) * STATS_SMOOTHING : sample;
+}
+
+} // namespace
+
+bool NdiOutput::IsAvailable() {
+    return LoadNdiRuntime() != nullptr;
+}
+
+bool NdiOutput::Start(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& name) {
+    Stop();
+    const NDIlib_v5* ndi = LoadNdiRuntime();
+    if (!ndi || !device || !context) return false;
+
+    NDIlib_send_create_t desc;
+    desc.p_ndi_name  = name.c_str();
+    desc.clock_video = false;  // Paced by the render loop, not by NDI
+    desc.clock_audio = false;
+    m_sender = ndi->send_create(&desc);
+    if (!m_sender) return false;
+
+    m_device  = device;
+    m_context = context;
+    m_name    = name;
+    m_sentGeneration = 0;
+    m_free.clear();
+    for (int i = SEND_BUFFERS - 1; i >= 0; --i) m_free.push_back(i);
+    m_ready = -1;
+    m_stop  = false;
+    m_thread = std::thread(&NdiOutput::SendThread, this);
+    return true;
+}
+
+void NdiOutput::Stop() {
+    if (!m_sender) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();  // Flushes NDI's hold on the last buffer before it exits
+    LoadNdiRuntime()->send_destroy(static_cast<NDIlib_send_instance_t>(m_sender));
+    m_sender = nullptr;
+
+    for (ReadbackSlot& slot : m_slots) slot = ReadbackSlot{};
+    for (SendBuffer& buffer : m_buffers) buffer = SendBuffer{};
+    m_convertRTV.Reset();
+    m_convert.Reset();
+    m_convertWidth  = 0;
+    m_convertHeight = 0;
+    m_oldest = 0;
+    m_queued = 0;
+    m_connections = 0;
+    m_device  = nullptr;
+    m_context = nullptr;
+}
+
+void NdiOutput::SendThread() {
+    const NDIlib_v5* ndi = LoadNdiRuntime();
+    const auto sender = static_cast<NDIlib_send_instance_t>(m_sender);
+    int held = -1;  // The buffer NDI still reads from
+    for (;;) {
+        int next;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || m_ready >= 0; });
+            if (m_stop) break;
+            next   = m_ready;
+            m_ready = -1;
+        }
+
+        const SendBuffer& buffer = m_buffers[next];
+        NDIlib_video_frame_v2_t frame;
+        frame.xres                 = buffer.width;
+        frame.yres                 = buffer.height;
+        frame.FourCC               = NDIlib_FourCC_type_UYVY;
+        frame.frame_rate_N         = buffer.frameRateN;
+        frame.frame_rate_D         = buffer.frameRateD;
+        frame.picture_aspect_ratio = 0.0f;  // Square pixels
+        frame.frame_format_type    = NDIlib_frame_format_type_progressive;
+        frame.timecode             = NDIlib_send_timecode_synthesize;
+        frame.p_data               = const_cast<uint8_t*>(buffer.data.data());
+        frame.line_stride_in_bytes = buffer.width * 2;
+
+        // Returns once NDI has taken `next`; the call also releases the previous buffer
+        const auto start = std::chrono::steady_clock::now();
+        ndi->send_send_video_async_v2(sender, &frame);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_avgSendMs.store(Smooth(m_avgSendMs.load(std::memory_order_relaxed), ms), std::memory_order_relaxed);
+        m_framesSent.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (held >= 0) m_free.push_back(held);
+        held = next;
+    }
+    ndi->send_send_video_async_v2(sender, nullptr);  // Waits until NDI lets go of `held`
+}
+
+bool NdiOutput::EnsureTargets(int width, int height) {
+    if (m_convert && m_convertWidth == width && m_convertHeight == height) return true;
+    m_convertRTV.Reset();
+    m_convert.Reset();
+    m_convertWidth  = 0;
+    m_convertHeight = 0;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = static_cast<UINT>(width / 2);
+    desc.Height           = static_cast<UINT>(height);
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_RENDER_TARGET;
+    if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &m_convert)) ||
+        FAILED(m_device->CreateRenderTargetView(m_convert.Get(), nullptr, &m_convertRTV))) {
+        m_convertRTV.Reset();
+        m_convert.Reset();
+        return false;
+    }
+    m_convertWidth  = width;
+    m_convertHeight = height;
+    return true;
+}
+
+bool NdiOutput::CollectReadback() {
+    if (m_queued == 0) return false;
+    ReadbackSlot& slot = m_slots[m_oldest];
+    if (m_context->GetData(slot.copied.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) return false;
+    m_oldest = (m_oldest + 1) % READBACK_SLOTS;
+    --m_queued;
+
+    int fill;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.empty()) {  // Cannot happen with SEND_BUFFERS; drop rather than wait
+            m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        fill = m_free.back();
+        m_free.pop_back();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    SendBuffer& buffer = m_buffers[fill];
+    const size_t rowBytes = static_cast<size_t>(slot.width) * 2;
+    buffer.data.resize(rowBytes * slot.height);
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    const bool ok = SUCCEEDED(m_context->Map(slot.staging.Get(), 0, D3D11_MAP_READ, 0, &mapped));
+    if (ok) {
+        CopyRows(buffer.data.data(), rowBytes, static_cast<const uint8_t*>(mapped.pData), mapped.RowPitch,
+                 rowBytes, slot.height);
+        m_context->Unmap(slot.staging.Get(), 0);
+        buffer.width      = slot.width;
+        buffer.height     = slot.height;
+        buffer.frameRateN = slot.frameRateN;
+        buffer.frameRateD = slot.frameRateD;
+        m_avgCopyMs = Smooth(m_avgCopyMs,
+                             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!ok) {
+            m_free.push_back(fill);
+            return true;
+        }
+        if (m_ready >= 0) {  // The send thread is behind: the newer frame wins
+            m_free.push_back(m_ready);
+            m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_ready = fill;
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+bool NdiOutput::SubmitFrame(D3D11Renderer& renderer, int frameRateN, int frameRateD,
+                            ID3D11ShaderResourceView* source, uint64_t generation) {
+    if (!m_sender) return false;
+
+    // Copies that landed, oldest first
+    while (CollectReadback()) {}
+
+    // Nobody watching: no conversion, readback or send
+    m_connections = LoadNdiRuntime()->send_get_no_connections(static_cast<NDIlib_send_instance_t>(m_sender), 0);
+    if (m_connections <= 0) {
+        m_sentGeneration = 0;  // A receiver that connects gets the current frame
+        return false;
+    }
+
+    if (!source) {
+        source     = renderer.GetDisplaySRV();
+        generation = renderer.GetDisplayGeneration();
+    }
+    if (!source || (generation == m_sentGeneration && source == m_sentSource)) return false;
+    if (m_queued == READBACK_SLOTS) {
+        m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;  // Tried again next tick with whatever is newest then
+    }
+
+    int width  = m_outputWidth  > 0 ? m_outputWidth  : renderer.GetDisplayWidth();
+    int height = m_outputHeight > 0 ? m_outputHeight : renderer.GetDisplayHeight();
+    width &= ~1;
+    if (width < 2 || height < 1 || !EnsureTargets(width, height)) return false;
+
+    const int index = (m_oldest + m_queued) % READBACK_SLOTS;
+    ReadbackSlot& slot = m_slots[index];
+    if (slot.width != width || slot.height != height || !slot.staging) {
+        slot = ReadbackSlot{};
+        D3D11_TEXTURE2D_DESC desc = {};
+        m_convert->GetDesc(&desc);
+        desc.Usage          = D3D11_USAGE_STAGING;
+        desc.BindFlags      = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        D3D11_QUERY_DESC queryDesc = {};
+        queryDesc.Query = D3D11_QUERY_EVENT;
+        if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &slot.staging)) ||
+            FAILED(m_device->CreateQuery(&queryDesc, &slot.copied))) {
+            slot = ReadbackSlot{};
+            return false;
+        }
+        slot.width  = width;
+        slot.height = height;
+    }
+
+    if (!renderer.ConvertToUyvy(source, m_convertRTV.Get(), width, height)) return true;
+    m_context->CopyResource(slot.staging.Get(), m_convert.Get());
+    m_context->End(slot.copied.Get());
+    slot.frameRateN = frameRateN;
+    slot.frameRateD = frameRateD;
+    ++m_queued;
+    m_sentGeneration = generation;
+    m_sentSource     = source;
+    m_lastWidth  = width;
+    m_lastHeight = height;
+    return true;
+}
+
+#else  // No NDI SDK in this build
+
+bool NdiOutput::IsAvailable() { return false; }
+bool NdiOutput::Start(ID3D11Device*, ID3D11DeviceContext*, const std::string&) { return false; }
+void NdiOutput::Stop() {}
+bool NdiOutput::SubmitFrame(D3D11Renderer&, int, int, ID3D11ShaderResourceView*, uint64_t) { return false; }
+
+#endif
+
+void NdiOutput::SetOutputSize(int width, int height) {
+    m_outputWidth  = std::max(width, 0);
+    m_outputHeight = std::max(height, 0);
+    m_sentGeneration = 0;
+}
+
+NdiSendStats NdiOutput::GetStats() const {
+    NdiSendStats stats;
+    stats.framesSent    = m_framesSent.load(std::memory_order_relaxed);
+    stats.framesDropped = m_framesDropped.load(std::memory_order_relaxed);
+    stats.connections   = m_connections;
+    stats.avgCopyMs     = m_avgCopyMs;
+    stats.avgSendMs     = m_avgSendMs.load(std::memory_order_relaxed);
+    stats.width         = m_lastWidth;
+    stats.height        = m_lastHeight;
+    return stats;
+}
+
+} // namespace SP
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Common.h"
+#include <chrono>
+#include <condition_variable>
+
+namespace SP {
+
+class D3D11Renderer;
+
+struct NdiSendStats {
+    int64_t framesSent    = 0;
+    int64_t framesDropped = 0;  // Readback ring full, or replaced before the send thread took it
+    int     connections   = 0;  // Receivers connected at the last SubmitFrame
+    double  avgCopyMs     = 0.0;  // Main thread: map + row copy of a landed readback
+    double  avgSendMs     = 0.0;  // Send thread: NDIlib_send_send_video_async_v2
+    int     width  = 0;
+    int     height = 0;
+};
+
+// NDI sender. The display texture is converted to UYVY 4:2:2 on the GPU
+// (D3D11Renderer::ConvertToUyvy, half the bytes of RGBA and NDI's native input)
+// and read back through a ring of staging textures, so the CPU maps a copy the
+// GPU finished a frame or two ago and never stalls. The bytes go to a send
+// thread that calls NDIlib_send_send_video_async_v2: NDI compresses and sends
+// while the next frame is prepared, holding our buffer until the following
+// call. Only frames the renderer drew are sent, and nothing is converted
+// while no receiver is connected. Without an NDI build or runtime Start fails.
+class NdiOutput {
+public:
+    NdiOutput() = default;
+    ~NdiOutput();
+
+    NdiOutput(const NdiOutput&) = delete;
+    NdiOutput& operator=(const NdiOutput&) = delete;
+
+    // Built with SHADERPLAYER_NDI and the runtime is installed
+    static bool IsAvailable();
+
+    bool Start(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& name);
+    void Stop();
+    bool IsRunning() const { return m_sender != nullptr; }
+    const std::string& GetName() const { return m_name; }
+
+    // 0x0 = the display size; otherwise scaled by the conversion draw. The width
+    // is rounded down to even (two pixels per UYVY texel).
+    void SetOutputSize(int width, int height);
+
+    // Call after D3D11Renderer::RenderToDisplay. Hands landed readbacks to the
+    // send thread, then converts and queues the display texture if the renderer
+    // drew since the last call. True when it drew (the caller restores the
+    // pipeline with BeginFrame). A post chain's result and its
+    // PostChain::generation replace the display texture.
+    bool SubmitFrame(D3D11Renderer& renderer, int frameRateN, int frameRateD,
+                     ID3D11ShaderResourceView* source = nullptr, uint64_t generation = 0);
+    // Receivers connected at the last SubmitFrame
+    int GetConnections() const { return m_connections; }
+    NdiSendStats GetStats() const;
+
+private:
+    static constexpr int READBACK_SLOTS = 3;
+    static constexpr int SEND_BUFFERS   = 4;  // Held by NDI, being submitted, queued, being filled
+
+    struct ReadbackSlot {
+        ComPtr<ID3D11Texture2D> staging;
+        ComPtr<ID3D11Query>     copied;
+        int width  = 0;
+        int height = 0;
+        int frameRateN = 0;
+        int frameRateD = 0;
+    };
+    struct SendBuffer {
+        std::vector<uint8_t> data;  // UYVY, width * 2 bytes per row
+        int width  = 0;
+        int height = 0;
+        int frameRateN = 0;
+        int frameRateD = 0;
+    };
+
+    bool EnsureTargets(int width, int height);
+    bool CollectReadback();  // Oldest queued copy to the send thread, if it landed
+    void SendThread();
+
+    ID3D11Device*        m_device  = nullptr;
+    ID3D11DeviceContext* m_context = nullptr;
+    void*                m_sender  = nullptr;  // NDIlib_send_instance_t
+    std::string          m_name;
+    int  m_outputWidth  = 0;
+    int  m_outputHeight = 0;
+    uint64_t m_sentGeneration = 0;
+    ID3D11ShaderResourceView* m_sentSource = nullptr;  // Compared only, never dereferenced
+
+    // GPU side: the conversion target and the readback ring (queue order from m_oldest)
+    ComPtr<ID3D11Texture2D>        m_convert;
+    ComPtr<ID3D11RenderTargetView> m_convertRTV;
+    int m_convertWidth  = 0;
+    int m_convertHeight = 0;
+    ReadbackSlot m_slots[READBACK_SLOTS];
+    int m_oldest = 0;
+    int m_queued = 0;
+
+    // Send thread: buffers move free → CollectReadback fills one → m_ready → NDI → free
+    SendBuffer              m_buffers[SEND_BUFFERS];
+    std::vector<int>        m_free;
+    int                     m_ready = -1;
+    bool                    m_stop  = false;
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_wake;
+    std::thread             m_thread;
+
+    std::atomic<int64_t> m_framesSent{0};
+    std::atomic<int64_t> m_framesDropped{0};
+    std::atomic<double>  m_avgSendMs{0.0};
+    double m_avgCopyMs   = 0.0;
+    int    m_connections = 0;
+    int    m_lastWidth   = 0;
+    int    m_lastHeight  = 0;
+};
+
+} // namespace SP
@@ -0,0 +1,39 @@
+#include "NdiRuntime.h"
+#include <mutex>
+
+namespace SP {
+
+namespace {
+
+std::once_flag   g_loadOnce;
+const NDIlib_v5* g_ndi = nullptr;
+
+void Load() {
+    HMODULE module = nullptr;
+    char folder[MAX_PATH] = {};
+    const DWORD length = GetEnvironmentVariableA(NDILIB_REDIST_FOLDER, folder, MAX_PATH);
+    if (length > 0 && length < MAX_PATH) {
+        const std::string path = std::string(folder) + "\\" + NDILIB_LIBRARY_NAME;
+        module = LoadLibraryA(path.c_str());
+    }
+    if (!module) module = LoadLibraryA(NDILIB_LIBRARY_NAME);
+    if (!module) return;
+
+    using LoadFn = const NDIlib_v5* (*)();
+    const auto load = reinterpret_cast<LoadFn>(GetProcAddress(module, "NDIlib_v5_load"));
+    const NDIlib_v5* ndi = load ? load() : nullptr;
+    if (!ndi || !ndi->initialize()) {  // initialize fails on CPUs without SSE4.2
+        FreeLibrary(module);
+        return;
+    }
+    g_ndi = ndi;
+}
+
+} // namespace
+
+const NDIlib_v5* LoadNdiRuntime() {
+    std::call_once(g_loadOnce, Load);
+    return g_ndi;
+}
+
+} // namespace SP
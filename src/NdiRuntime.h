@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Common.h"
+#include <Processing.NDI.Lib.h>  // NDI SDK (SHADERPLAYER_NDI builds only)
+
+namespace SP {
+
+// The NDI runtime, loaded on first use from the folder the NDI Tools/Runtime
+// installer names in NDILIB_REDIST_FOLDER (or next to the exe) and initialised
+// once. Null when it isn't installed or the CPU is unsupported; the app then runs
+// without NDI. Never unloaded: senders and receivers may outlive any one owner.
+const NDIlib_v5* LoadNdiRuntime();
+
+} // namespace SP
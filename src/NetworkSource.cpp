@@ -0,0 +1,321 @@
+#include "NetworkSource.h"
+#include "ThreadPriority.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/dict.h>
+}
+
+namespace SP {
+
+namespace {
+
+// Same probing budget as VideoDecoder::OpenCapture: one keyframe of a 1080p stream
+constexpr int64_t PROBE_BYTES = 256 * 1024;
+constexpr int64_t ANALYZE_US  = 500'000;
+
+// Blocking I/O is interrupted past these: a connect that hangs, a stream that stops
+constexpr auto CONNECT_TIMEOUT = std::chrono::seconds(10);
+constexpr auto STALL_TIMEOUT   = std::chrono::seconds(3);
+
+// Reconnect backoff doubles from MIN to MAX while connects keep failing
+constexpr auto RECONNECT_MIN = std::chrono::milliseconds(500);
+constexpr auto RECONNECT_MAX = std::chrono::milliseconds(8000);
+
+// Kernel receive buffer for UDP transports: a burst of 4K keyframe packets
+// mustn't overflow it before the demux thread reads
+constexpr int UDP_BUFFER_BYTES = 4 * 1024 * 1024;
+
+// Arrival jitter smoothing, as RFC 3550 does it
+constexpr double JITTER_SMOOTHING = 1.0 / 16.0;
+
+int64_t Ticks(std::chrono::steady_clock::time_point time) {
+    return time.time_since_epoch().count();
+}
+
+} // namespace
+
+NetworkSource::~NetworkSource() {
+    Stop();
+}
+
+void NetworkSource::Start(const std::string& url, int jitterMs, bool tcp) {
+    Stop();
+    m_url      = url;
+    m_jitterMs = std::max(jitterMs, 0);
+    m_tcp      = tcp;
+    m_stop     = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_params      = avcodec_parameters_alloc();
+        m_stats       = Stats{};
+        m_stats.state = State::Connecting;
+    }
+    m_thread = std::thread(&NetworkSource::DemuxThread, this);
+}
+
+void NetworkSource::Stop() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_waitMutex);
+            m_stop = true;
+        }
+        m_waitCv.notify_all();
+        m_thread.join();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ClearQueue();
+    avcodec_parameters_free(&m_params);
+    m_generation  = 0;
+    m_anchored    = false;
+    m_stats.state = State::Stopped;
+}
+
+bool NetworkSource::GetStreamInfo(AVCodecParameters* params, AVRational& timeBase, AVRational& frameRate,
+                                  uint64_t& generation) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    generation = m_generation.load(std::memory_order_relaxed);
+    if (generation == 0 || !m_params || avcodec_parameters_copy(params, m_params) < 0) return false;
+    timeBase  = m_timeBase;
+    frameRate = m_frameRate;
+    return true;
+}
+
+bool NetworkSource::PopPacket(AVPacket* packet, uint64_t& generation,
+                              std::chrono::steady_clock::time_point& arrival) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queue.empty()) return false;
+    Entry& entry = m_queue.front();
+
+    const double seconds = EntrySeconds(entry);
+    if (m_jitterMs > 0 && !std::isnan(seconds)) {
+        const auto delay = std::chrono::milliseconds(m_jitterMs);
+        auto anchor = [&](std::chrono::steady_clock::time_point time) {
+            m_anchored         = true;
+            m_anchorGeneration = entry.generation;
+            m_anchorSeconds    = seconds;
+            m_anchorTime       = time;
+        };
+        if (!m_anchored || m_anchorGeneration != entry.generation) anchor(entry.arrival + delay);
+
+        auto playout = m_anchorTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                          std::chrono::duration<double>(seconds - m_anchorSeconds));
+        if (entry.arrival > playout) {
+            // Later than the buffer covers: play it `jitterMs` from now on
+            ++m_stats.latePackets;
+            anchor(entry.arrival + delay);
+            playout = m_anchorTime;
+        } else if (playout - entry.arrival > delay * MAX_BUFFER_FACTOR) {
+            // A timestamp jump or a sender running fast: the schedule drifted ahead
+            anchor(entry.arrival + delay);
+            playout = m_anchorTime;
+        }
+        if (std::chrono::steady_clock::now() < playout) return false;
+    }
+
+    av_packet_unref(packet);
+    av_packet_move_ref(packet, entry.packet);
+    av_packet_free(&entry.packet);
+    generation = entry.generation;
+    arrival    = entry.arrival;
+    m_queue.pop_front();
+
+    m_stats.bufferPackets = static_cast<int>(m_queue.size());
+    m_stats.bufferMs = 0.0f;
+    if (!m_queue.empty()) {
+        const double span = EntrySeconds(m_queue.back()) - EntrySeconds(m_queue.front());
+        if (!std::isnan(span)) m_stats.bufferMs = static_cast<float>(std::max(span, 0.0) * 1000.0);
+    }
+    return true;
+}
+
+NetworkSource::Stats NetworkSource::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+const char* NetworkSource::GetStateName(State state) {
+    switch (state) {
+        case State::Connecting:   return "Connecting";
+        case State::Streaming:    return "Streaming";
+        case State::Reconnecting: return "Reconnecting";
+        default:                  return "Stopped";
+    }
+}
+
+void NetworkSource::DemuxThread() {
+    TraceRecorder::SetThreadName("Network demux");
+    ThreadPriority::Apply(ThreadRole::Playback);
+
+    std::chrono::milliseconds backoff = RECONNECT_MIN;
+    while (!m_stop) {
+        int streamIndex = -1;
+        AVFormatContext* fmt = Connect(streamIndex);
+        if (fmt) {
+            backoff = RECONNECT_MIN;
+            ReadPackets(fmt, streamIndex);
+            avformat_close_input(&fmt);
+        }
+        if (m_stop) break;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_generation.load(std::memory_order_relaxed) > 0) {
+                m_stats.state = State::Reconnecting;
+                ++m_stats.reconnects;
+            }
+        }
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        m_waitCv.wait_for(lock, backoff, [this] { return m_stop.load(); });
+        backoff = std::min<std::chrono::milliseconds>(backoff * 2, RECONNECT_MAX);
+    }
+}
+
+AVFormatContext* NetworkSource::Connect(int& streamIndex) {
+    AVFormatContext* fmt = avformat_alloc_context();
+    if (!fmt) return nullptr;
+    fmt->interrupt_callback.callback = InterruptCallback;
+    fmt->interrupt_callback.opaque   = this;
+
+    // No demuxer-side buffering: the jitter buffer below is the only delay
+    AVDictionary* opts = nullptr;
+    av_dict_set(&opts, "fflags", "nobuffer", 0);
+    av_dict_set_int(&opts, "probesize", PROBE_BYTES, 0);
+    av_dict_set_int(&opts, "analyzeduration", ANALYZE_US, 0);
+    av_dict_set(&opts, "rtsp_transport", m_tcp ? "tcp" : "udp", 0);
+    av_dict_set_int(&opts, "buffer_size", UDP_BUFFER_BYTES, 0);
+    if (m_url.rfind("srt://", 0) == 0) {
+        // SRT retransmits within its own latency window (microseconds)
+        av_dict_set_int(&opts, "latency", static_cast<int64_t>(m_jitterMs) * 1000, 0);
+    }
+
+    m_deadline = Ticks(std::chrono::steady_clock::now() + CONNECT_TIMEOUT);
+    int ret = avformat_open_input(&fmt, m_url.c_str(), nullptr, &opts);
+    av_dict_free(&opts);
+    if (ret >= 0) ret = avformat_find_stream_info(fmt, nullptr);
+    if (ret >= 0) {
+        streamIndex = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        ret = streamIndex;
+    }
+    if (ret < 0) {
+        char message[AV_ERROR_MAX_STRING_SIZE] = {};
+        av_strerror(ret, message, sizeof(message));
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.error = message;
+        avformat_close_input(&fmt);  // Freed by avformat_open_input when it failed
+        return nullptr;
+    }
+
+    // Audio and data streams are never read
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        if (static_cast<int>(i) != streamIndex) fmt->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    const AVStream* stream = fmt->streams[streamIndex];
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (avcodec_parameters_copy(m_params, stream->codecpar) < 0) {
+        avformat_close_input(&fmt);
+        return nullptr;
+    }
+    m_timeBase  = stream->time_base;
+    m_frameRate = stream->avg_frame_rate.den ? stream->avg_frame_rate : stream->r_frame_rate;
+    ClearQueue();  // Whatever the old connection left can't be decoded against the new one
+    m_anchored    = false;
+    m_lastSeconds = NAN;
+    m_stats.state = State::Streaming;
+    m_stats.error.clear();
+    m_generation.fetch_add(1, std::memory_order_release);
+    return fmt;
+}
+
+void NetworkSource::ReadPackets(AVFormatContext* fmt, int streamIndex) {
+    AVPacket* packet = av_packet_alloc();
+    if (!packet) return;
+    const uint64_t generation = m_generation.load(std::memory_order_acquire);
+
+    while (!m_stop) {
+        m_deadline = Ticks(std::chrono::steady_clock::now() + STALL_TIMEOUT);
+        const int ret = av_read_frame(fmt, packet);
+        if (ret == AVERROR(EAGAIN)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (ret < 0) {
+            char message[AV_ERROR_MAX_STRING_SIZE] = {};
+            av_strerror(ret, message, sizeof(message));
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.error = (ret == AVERROR_EOF) ? "Stream ended" : message;
+            break;
+        }
+        if (packet->stream_index != streamIndex) {
+            av_packet_unref(packet);
+            continue;
+        }
+
+        Entry entry;
+        entry.arrival    = std::chrono::steady_clock::now();
+        entry.generation = generation;
+        entry.packet     = av_packet_alloc();
+        if (!entry.packet) {
+            av_packet_unref(packet);
+            continue;
+        }
+        av_packet_move_ref(entry.packet, packet);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.packets;
+        if (entry.packet->flags & AV_PKT_FLAG_CORRUPT) ++m_stats.lostFrames;
+
+        // Loss: whole frame intervals missing between consecutive timestamps.
+        // Jitter: how far the arrival spacing strays from the timestamp spacing.
+        const double seconds = EntrySeconds(entry);
+        if (!std::isnan(seconds) && !std::isnan(m_lastSeconds)) {
+            const double step = seconds - m_lastSeconds;
+            const double frameSeconds = m_frameRate.num > 0 ? av_q2d(av_inv_q(m_frameRate)) : 0.0;
+            if (frameSeconds > 0.0 && step > 1.5 * frameSeconds && step < 10.0) {
+                m_stats.lostFrames += static_cast<int64_t>(std::lround(step / frameSeconds)) - 1;
+            }
+            const double arrivalStep = std::chrono::duration<double>(entry.arrival - m_lastArrival).count();
+            const double deviation   = std::abs(arrivalStep - step) * 1000.0;
+            m_stats.arrivalJitterMs += static_cast<float>((deviation - m_stats.arrivalJitterMs) * JITTER_SMOOTHING);
+        }
+        if (!std::isnan(seconds)) {
+            m_lastSeconds = seconds;
+            m_lastArrival = entry.arrival;
+        }
+
+        if (static_cast<int>(m_queue.size()) >= MAX_QUEUE_PACKETS) {
+            av_packet_free(&m_queue.front().packet);
+            m_queue.pop_front();
+            ++m_stats.overflows;
+        }
+        m_queue.push_back(entry);
+        m_stats.bufferPackets = static_cast<int>(m_queue.size());
+        const double span = EntrySeconds(m_queue.back()) - EntrySeconds(m_queue.front());
+        if (!std::isnan(span)) m_stats.bufferMs = static_cast<float>(std::max(span, 0.0) * 1000.0);
+    }
+    av_packet_free(&packet);
+}
+
+void NetworkSource::ClearQueue() {
+    for (Entry& entry : m_queue) av_packet_free(&entry.packet);
+    m_queue.clear();
+    m_stats.bufferPackets = 0;
+    m_stats.bufferMs      = 0.0f;
+}
+
+double NetworkSource::EntrySeconds(const Entry& entry) const {
+    // Decode order: dts rises monotonically where pts jumps around B-frames
+    const int64_t ts = (entry.packet->dts != AV_NOPTS_VALUE) ? entry.packet->dts : entry.packet->pts;
+    return (ts != AV_NOPTS_VALUE) ? static_cast<double>(ts) * av_q2d(m_timeBase) : NAN;
+}
+
+int NetworkSource::InterruptCallback(void* opaque) {
+    const NetworkSource* self = static_cast<const NetworkSource*>(opaque);
+    return (self->m_stop.load() || Ticks(std::chrono::steady_clock::now()) > self->m_deadline.load()) ? 1 : 0;
+}
+
+} // namespace SP
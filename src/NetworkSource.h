@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Common.h"
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+
+extern "C" {
+#include <libavutil/rational.h>
+}
+
+struct AVCodecParameters;
+struct AVFormatContext;
+struct AVPacket;
+
+namespace SP {
+
+// Live network input (rtsp://, srt://, udp://, rtmp://, http://) for
+// VideoDecoder::OpenNetwork. A demux thread owns the AVFormatContext: it
+// connects, reads video packets into a jitter buffer, and on an error, a stall
+// or the end of the stream closes the input and reconnects with backoff. The
+// decode thread never waits on the network. It takes packets with PopPacket
+// once their playout time has come and reopens its codec when the connection
+// (GetGeneration) changes.
+//
+// Playout: the first packet of a connection plays `jitterMs` after it arrived
+// and later packets follow at their timestamp distance, so arrival jitter up
+// to that delay never reaches the screen. A packet arriving after its playout
+// time (or a buffer grown past MAX_BUFFER_FACTOR x the delay, a sender clock
+// running fast) re-anchors the schedule. jitterMs 0 passes packets on at once.
+class NetworkSource {
+public:
+    enum class State { Stopped, Connecting, Streaming, Reconnecting };
+
+    // Safe to read from any thread (GetStats copies under the lock)
+    struct Stats {
+        State   state         = State::Stopped;
+        int     reconnects    = 0;
+        int64_t packets       = 0;   // Video packets received
+        int64_t lostFrames    = 0;   // Estimated from timestamp gaps and corrupt packets
+        int64_t latePackets   = 0;   // Arrived after their playout time (re-anchored)
+        int64_t overflows     = 0;   // Dropped: the buffer hit MAX_QUEUE_PACKETS
+        int     bufferPackets = 0;
+        float   bufferMs      = 0.0f;  // Timestamp span waiting in the buffer
+        float   arrivalJitterMs = 0.0f;  // Smoothed deviation of arrival from timestamps
+        std::string error;           // Last connect/read failure
+    };
+
+    static constexpr int    MAX_QUEUE_PACKETS = 2048;
+    static constexpr double MAX_BUFFER_FACTOR = 3.0;
+
+    NetworkSource() = default;
+    ~NetworkSource();
+
+    // Non-copyable
+    NetworkSource(const NetworkSource&) = delete;
+    NetworkSource& operator=(const NetworkSource&) = delete;
+
+    // Starts the demux thread. `tcp` picks RTSP's interleaved TCP transport over
+    // UDP; SRT gets `jitterMs` as its own latency window instead.
+    void Start(const std::string& url, int jitterMs, bool tcp);
+    // Interrupts any blocking I/O, joins, and drops the buffer
+    void Stop();
+
+    // Bumped on every successful (re)connect; 0 until the first
+    uint64_t GetGeneration() const { return m_generation.load(std::memory_order_acquire); }
+    // Video stream of the current connection. `params` must be allocated
+    // (avcodec_parameters_alloc); false before the first connect.
+    bool GetStreamInfo(AVCodecParameters* params, AVRational& timeBase, AVRational& frameRate,
+                       uint64_t& generation) const;
+    // Decode thread: moves the next packet whose playout time has come into
+    // `packet`, with the connection it came from and when it arrived. False when
+    // none is due yet.
+    bool PopPacket(AVPacket* packet, uint64_t& generation, std::chrono::steady_clock::time_point& arrival);
+
+    Stats GetStats() const;
+    const std::string& GetUrl() const { return m_url; }
+
+    static const char* GetStateName(State state);
+
+private:
+    struct Entry {
+        AVPacket* packet = nullptr;
+        std::chrono::steady_clock::time_point arrival;
+        uint64_t generation = 0;
+    };
+
+    void DemuxThread();
+    AVFormatContext* Connect(int& streamIndex);
+    void ReadPackets(AVFormatContext* fmt, int streamIndex);
+    void ClearQueue();
+    double EntrySeconds(const Entry& entry) const;  // Packet timestamp in seconds; NAN without one
+    static int InterruptCallback(void* opaque);
+
+    std::string m_url;
+    int  m_jitterMs = 0;
+    bool m_tcp      = false;
+
+    std::thread             m_thread;
+    std::atomic<bool>       m_stop{false};
+    std::atomic<int64_t>    m_deadline{0};  // steady_clock ticks; blocking I/O past it is interrupted
+    std::mutex              m_waitMutex;
+    std::condition_variable m_waitCv;       // Reconnect backoff, cut short by Stop
+    std::atomic<uint64_t>   m_generation{0};
+
+    // Guarded by m_mutex
+    mutable std::mutex m_mutex;
+    std::deque<Entry>  m_queue;
+    AVCodecParameters* m_params = nullptr;  // Of the current connection
+    AVRational m_timeBase{1, 1};
+    AVRational m_frameRate{0, 1};
+    Stats      m_stats;
+    // Playout schedule: packet at `anchorSeconds` plays at `anchorTime`
+    bool       m_anchored = false;
+    uint64_t   m_anchorGeneration = 0;
+    double     m_anchorSeconds = 0.0;
+    std::chrono::steady_clock::time_point m_anchorTime{};
+    // Demux thread only: loss and jitter estimation
+    double     m_lastSeconds = NAN;
+    std::chrono::steady_clock::time_point m_lastArrival{};
+};
+
+} // namespace SP
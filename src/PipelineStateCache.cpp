@@ -0,0 +1,91 @@
+#include "PipelineStateCache.h"
+
+namespace SP {
+
+template <typename T>
+bool PipelineStateCache::Update(Slot<T>& slot, T* value) {
+    if (slot.known && slot.value == value) {
+        ++m_skipped;
+        return false;
+    }
+    slot.value = value;
+    slot.known = true;
+    ++m_issued;
+    return true;
+}
+
+void PipelineStateCache::SetContext(ID3D11DeviceContext* context) {
+    m_context = context;
+    Invalidate();
+}
+
+void PipelineStateCache::Invalidate() {
+    m_inputLayout  = {};
+    m_vertexBuffer = {};
+    m_stride       = 0;
+    m_vertexShader = {};
+    m_pixelShader  = {};
+    m_rasterizer   = {};
+    m_blend        = {};
+    m_blendFactor  = 1.0f;
+    m_constantBuffers.fill({});
+    m_samplers.fill({});
+}
+
+void PipelineStateCache::SetInputAssembler(ID3D11InputLayout* layout, ID3D11Buffer* vertexBuffer, UINT stride) {
+    if (!m_context) return;
+    // Topology rides along with the layout: the renderer only draws triangle lists
+    if (Update(m_inputLayout, layout)) {
+        m_context->IASetInputLayout(layout);
+        m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
+    const bool strideChanged = m_stride != stride;
+    if (Update(m_vertexBuffer, vertexBuffer) || strideChanged) {
+        m_stride = stride;
+        UINT offset = 0;
+        m_context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+    }
+}
+
+void PipelineStateCache::SetVertexShader(ID3D11VertexShader* shader) {
+    if (m_context && Update(m_vertexShader, shader)) m_context->VSSetShader(shader, nullptr, 0);
+}
+
+void PipelineStateCache::SetPixelShader(ID3D11PixelShader* shader) {
+    if (m_context && Update(m_pixelShader, shader)) m_context->PSSetShader(shader, nullptr, 0);
+}
+
+void PipelineStateCache::SetPSConstantBuffer(UINT slot, ID3D11Buffer* buffer) {
+    if (!m_context) return;
+    if (slot >= MAX_CONSTANT_BUFFERS) {
+        m_context->PSSetConstantBuffers(slot, 1, &buffer);
+        return;
+    }
+    if (Update(m_constantBuffers[slot], buffer)) m_context->PSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void PipelineStateCache::SetPSSampler(UINT slot, ID3D11SamplerState* sampler) {
+    if (!m_context) return;
+    if (slot >= MAX_SAMPLERS) {
+        m_context->PSSetSamplers(slot, 1, &sampler);
+        return;
+    }
+    if (Update(m_samplers[slot], sampler)) m_context->PSSetSamplers(slot, 1, &sampler);
+}
+
+void PipelineStateCache::SetRasterizerState(ID3D11RasterizerState* state) {
+    if (m_context && Update(m_rasterizer, state)) m_context->RSSetState(state);
+}
+
+void PipelineStateCache::SetBlendState(ID3D11BlendState* state, float factor) {
+    if (!m_context) return;
+    // The factor rides along with the state, like the stride with the vertex buffer
+    const bool factorChanged = m_blendFactor != factor;
+    if (Update(m_blend, state) || factorChanged) {
+        m_blendFactor = factor;
+        const float factors[4] = { factor, factor, factor, factor };
+        m_context->OMSetBlendState(state, factors, 0xFFFFFFFF);
+    }
+}
+
+} // namespace SP
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Common.h"
+#include <array>
+
+namespace SP {
+
+// Shadow of the pipeline state the renderer binds for its fullscreen draws, so a
+// bind of what is already bound is skipped. BeginFrame runs twice a frame while
+// recording and every blit, conversion and pass sets the same IA/VS/sampler/
+// raster state again; each of those is a runtime call with validation.
+//
+// Only state nothing else changes behind the renderer's back is tracked. Shader
+// resources and render targets are not: the runtime unbinds an SRV whose
+// resource is bound as an output, so a cached SRV slot could be silently null.
+// ImGui's DX11 backend saves and restores everything it touches, so it leaves
+// the shadow valid; any other code that binds on the same context must call
+// Invalidate() afterwards. Render thread only.
+class PipelineStateCache {
+public:
+    static constexpr UINT MAX_CONSTANT_BUFFERS = 4;  // b0..b3
+    static constexpr UINT MAX_SAMPLERS         = 2;  // s0 (clamp), s1 (wrap)
+
+    PipelineStateCache() = default;
+
+    // Non-copyable
+    PipelineStateCache(const PipelineStateCache&) = delete;
+    PipelineStateCache& operator=(const PipelineStateCache&) = delete;
+
+    void SetContext(ID3D11DeviceContext* context);
+    // Forget everything: the next bind of each kind always reaches the runtime
+    void Invalidate();
+
+    // Input layout, triangle-list topology and vertex buffer 0 (offset 0)
+    void SetInputAssembler(ID3D11InputLayout* layout, ID3D11Buffer* vertexBuffer, UINT stride);
+    void SetVertexShader(ID3D11VertexShader* shader);
+    void SetPixelShader(ID3D11PixelShader* shader);
+    void SetPSConstantBuffer(UINT slot, ID3D11Buffer* buffer);
+    void SetPSSampler(UINT slot, ID3D11SamplerState* sampler);
+    void SetRasterizerState(ID3D11RasterizerState* state);
+    void SetBlendState(ID3D11BlendState* state, float factor = 1.0f);  // Factor on every channel, full sample mask
+
+    // Binds issued and skipped since the last ResetCounters (for profiling)
+    int64_t GetIssued() const { return m_issued; }
+    int64_t GetSkipped() const { return m_skipped; }
+    void ResetCounters() { m_issued = m_skipped = 0; }
+
+private:
+    // One bindable slot. Pointers are only compared, never dereferenced; what is
+    // tracked is owned by the renderer for as long as it can be bound.
+    template <typename T>
+    struct Slot {
+        T*   value = nullptr;
+        bool known = false;  // False after Invalidate, so a null bind isn't taken for a hit
+    };
+    // True when the bind has to reach the runtime; records the new value
+    template <typename T>
+    bool Update(Slot<T>& slot, T* value);
+
+    ID3D11DeviceContext* m_context = nullptr;
+
+    Slot<ID3D11InputLayout>     m_inputLayout;
+    Slot<ID3D11Buffer>          m_vertexBuffer;
+    UINT                        m_stride = 0;
+    Slot<ID3D11VertexShader>    m_vertexShader;
+    Slot<ID3D11PixelShader>     m_pixelShader;
+    Slot<ID3D11RasterizerState> m_rasterizer;
+    Slot<ID3D11BlendState>      m_blend;
+    float                       m_blendFactor = 1.0f;
+    std::array<Slot<ID3D11Buffer>, MAX_CONSTANT_BUFFERS> m_constantBuffers;
+    std::array<Slot<ID3D11SamplerState>, MAX_SAMPLERS>   m_samplers;
+
+    int64_t m_issued  = 0;
+    int64_t m_skipped = 0;
+};
+
+} // namespace SP
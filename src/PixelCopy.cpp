@@ -0,0 +1,326 @@
+#include "PixelCopy.h"
+#include <windows.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SP_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define SP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace SP {
+
+namespace {
+
+// Streaming stores only pay off once the copy would evict what the cache holds
+// anyway; when the size isn't reported, assume a typical desktop L3
+constexpr size_t DEFAULT_LAST_LEVEL_CACHE = 8 * 1024 * 1024;
+
+// BT.709 limited range from full-range 8-bit RGB, Q15. Each row sums to
+// 219/255 (luma) or 0 (chroma) of 32768.
+constexpr int16_t Y_R = 5983,  Y_G = 20127,  Y_B = 2032;
+constexpr int16_t U_R = -3298, U_G = -11094, U_B = 14392;
+constexpr int16_t V_R = 14392, V_G = -13073, V_B = -1319;
+constexpr int LUMA_BIAS   = (16 << 15) + (1 << 14);   // Offset plus rounding, Q15
+constexpr int CHROMA_BIAS = (128 << 17) + (1 << 16);  // Q15 of a 2x2 sum: Q17
+
+void Cpuid(int out[4], int leaf, int subleaf) {
+#if defined(_MSC_VER)
+    __cpuidex(out, leaf, subleaf);
+#else
+    unsigned a = 0, b = 0, c = 0, d = 0;
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+    out[0] = static_cast<int>(a); out[1] = static_cast<int>(b);
+    out[2] = static_cast<int>(c); out[3] = static_cast<int>(d);
+#endif
+}
+
+uint64_t XgetbvXcr0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo = 0, hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+}
+
+CpuFeatures DetectCpuFeatures() {
+    CpuFeatures features;
+    int info[4] = {};
+    Cpuid(info, 0, 0);
+    if (info[0] >= 7) {
+        Cpuid(info, 1, 0);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx     = (info[2] & (1 << 28)) != 0;
+        // The OS must save XMM and YMM state across context switches, or AVX faults
+        if (osxsave && avx && (XgetbvXcr0() & 0x6) == 0x6) {
+            Cpuid(info, 7, 0);
+            features.avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    }
+
+    DWORD length = 0;
+    GetLogicalProcessorInformation(nullptr, &length);
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> entries(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (!entries.empty() && GetLogicalProcessorInformation(entries.data(), &length)) {
+        int level = 0;
+        for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& entry : entries) {
+            if (entry.Relationship != RelationCache || entry.Cache.Type == CacheInstruction) continue;
+            if (entry.Cache.Level > level) {
+                level = entry.Cache.Level;
+                features.lastLevelCache = entry.Cache.Size;
+            }
+        }
+    }
+    return features;
+}
+
+// --- Scalar ---------------------------------------------------------------
+
+void CopyRowsScalar(uint8_t* dst, size_t dstPitch, const uint8_t* src, size_t srcPitch, size_t rowBytes, int rows) {
+    if (dstPitch == srcPitch) {
+        // Padding included; the last row stops at rowBytes so src is never over-read
+        std::memcpy(dst, src, dstPitch * static_cast<size_t>(rows - 1) + rowBytes);
+        return;
+    }
+    for (int y = 0; y < rows; ++y) {
+        std::memcpy(dst + y * dstPitch, src + y * srcPitch, rowBytes);
+    }
+}
+
+void SwizzleRowScalar(uint8_t* dst, const uint8_t* src, int begin, int width) {
+    for (int x = begin; x < width; ++x) {
+        uint32_t p;
+        std::memcpy(&p, src + x * 4, 4);
+        p = (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+        std::memcpy(dst + x * 4, &p, 4);
+    }
+}
+
+void SwizzleScalar(uint8_t* dst, size_t dstPitch, const uint8_t* src, size_t srcPitch, int width, int rows) {
+    for (int y = 0; y < rows; ++y) SwizzleRowScalar(dst + y * dstPitch, src + y * srcPitch, 0, width);
+}
+
+uint8_t ClampByte(int value) {
+    return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+// Columns [begin, width) of a row pair; `y1` null when the frame has an odd last
+// row (row1 then repeats row0). `v` null = NV12, `u` the interleaved plane.
+void YuvRowPairScalar(const uint8_t* row0, const uint8_t* row1, int begin, int width,
+                      uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v) {
+    for (int x = begin; x < width; x += 2) {
+        const int x1 = std::min(x + 1, width - 1);
+        const uint8_t* quad[4] = { row0 + x * 4, row0 + x1 * 4, row1 + x * 4, row1 + x1 * 4 };
+        int r = 0, g = 0, b = 0;
+        for (int i = 0; i < 4; ++i) {
+            const uint8_t* p = quad[i];
+            const uint8_t luma = ClampByte((p[0] * Y_R + p[1] * Y_G + p[2] * Y_B + LUMA_BIAS) >> 15);
+            if (i == 0) y0[x] = luma;
+            if (i == 1 && x1 != x) y0[x1] = luma;
+            if (i == 2 && y1) y1[x] = luma;
+            if (i == 3 && y1 && x1 != x) y1[x1] = luma;
+            r += p[0];
+            g += p[1];
+            b += p[2];
+        }
+        const uint8_t cb = ClampByte((r * U_R + g * U_G + b * U_B + CHROMA_BIAS) >> 17);
+        const uint8_t cr = ClampByte((r * V_R + g * V_G + b * V_B + CHROMA_BIAS) >> 17);
+        if (v) {
+            u[x / 2] = cb;
+            v[x / 2] = cr;
+        } else {
+            u[x]     = cb;
+            u[x + 1] = cr;
+        }
+    }
+}
+
+// --- AVX2 -----------------------------------------------------------------
+
+SP_TARGET_AVX2 void StreamBytes(uint8_t* dst, const uint8_t* src, size_t bytes) {
+    // Up to the first 32-byte boundary of dst normally, then aligned streaming stores
+    const size_t head = std::min(bytes, (32 - (reinterpret_cast<uintptr_t>(dst) & 31)) & 31);
+    std::memcpy(dst, src, head);
+    size_t i = head;
+    for (; i + 128 <= bytes; i += 128) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 32));
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 64));
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 96));
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i), a);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i + 32), b);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i + 64), c);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i + 96), d);
+    }
+    for (; i + 32 <= bytes; i += 32) {
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+    }
+    std::memcpy(dst + i, src + i, bytes - i);
+}
+
+SP_TARGET_AVX2 void CopyRowsAvx2(uint8_t* dst, size_t dstPitch, const uint8_t* src, size_t srcPitch, size_t rowBytes,
+                                 int rows) {
+    const size_t cache = GetCpuFeatures().lastLevelCache ? GetCpuFeatures().lastLevelCache : DEFAULT_LAST_LEVEL_CACHE;
+    if (rowBytes * static_cast<size_t>(rows) < cache) {
+        CopyRowsScalar(dst, dstPitch, src, srcPitch, rowBytes, rows);  // memcpy is as fast in cache
+        return;
+    }
+    if (dstPitch == srcPitch) {
+        StreamBytes(dst, src, dstPitch * static_cast<size_t>(rows - 1) + rowBytes);
+    } else {
+        for (int y = 0; y < rows; ++y) StreamBytes(dst + y * dstPitch, src + y * srcPitch, rowBytes);
+    }
+    _mm_sfence();  // Streaming stores are weakly ordered: visible before another thread reads the frame
+}
+
+SP_TARGET_AVX2 void SwizzleAvx2(uint8_t* dst, size_t dstPitch, const uint8_t* src, size_t srcPitch, int width,
+                                int rows) {
+    const __m256i order = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                           2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    for (int y = 0; y < rows; ++y) {
+        const uint8_t* s = src + y * srcPitch;
+        uint8_t* d = dst + y * dstPitch;
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + x * 4));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + x * 4), _mm256_shuffle_epi8(p, order));
+        }
+        SwizzleRowScalar(d, s, x, width);
+    }
+}
+
+// Luma of 8 pixels from their 16-bit RGBA: `lo` holds pixels 0,1 | 4,5, `hi` 2,3 | 6,7
+SP_TARGET_AVX2 void StoreLuma8(uint8_t* dst, __m256i lo, __m256i hi, __m256i coefficients, __m256i bias) {
+    __m256i luma = _mm256_hadd_epi32(_mm256_madd_epi16(lo, coefficients), _mm256_madd_epi16(hi, coefficients));
+    luma = _mm256_srai_epi32(_mm256_add_epi32(luma, bias), 15);  // 0-3 | 4-7
+    luma = _mm256_packus_epi16(_mm256_packs_epi32(luma, luma), luma);
+    const int first  = _mm256_cvtsi256_si32(luma);
+    const int second = _mm256_extract_epi32(luma, 4);
+    std::memcpy(dst, &first, 4);
+    std::memcpy(dst + 4, &second, 4);
+}
+
+// 8 columns at a time of a row pair; returns the columns done, the scalar
+// version finishes the rest
+SP_TARGET_AVX2 int YuvRowPairAvx2(const uint8_t* row0, const uint8_t* row1, int width,
+                                  uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v) {
+    const __m256i zero   = _mm256_setzero_si256();
+    const __m256i yCoef  = _mm256_setr_epi16(Y_R, Y_G, Y_B, 0, Y_R, Y_G, Y_B, 0, Y_R, Y_G, Y_B, 0, Y_R, Y_G, Y_B, 0);
+    const __m256i uCoef  = _mm256_setr_epi16(U_R, U_G, U_B, 0, U_R, U_G, U_B, 0, U_R, U_G, U_B, 0, U_R, U_G, U_B, 0);
+    const __m256i vCoef  = _mm256_setr_epi16(V_R, V_G, V_B, 0, V_R, V_G, V_B, 0, V_R, V_G, V_B, 0, V_R, V_G, V_B, 0);
+    const __m256i yBias  = _mm256_set1_epi32(LUMA_BIAS);
+    const __m256i cBias  = _mm256_set1_epi32(CHROMA_BIAS);
+    // From U0 U1 V0 V1 | U2 U3 V2 V3: interleaved pairs (NV12) or U then V (I420)
+    const __m256i chromaOrder = v ? _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7)
+                                  : _mm256_setr_epi32(0, 2, 1, 3, 4, 6, 5, 7);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i p0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + x * 4));
+        const __m256i p1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + x * 4));
+        const __m256i lo0 = _mm256_unpacklo_epi8(p0, zero);
+        const __m256i hi0 = _mm256_unpackhi_epi8(p0, zero);
+        const __m256i lo1 = _mm256_unpacklo_epi8(p1, zero);
+        const __m256i hi1 = _mm256_unpackhi_epi8(p1, zero);
+        StoreLuma8(y0 + x, lo0, hi0, yCoef, yBias);
+        if (y1) StoreLuma8(y1 + x, lo1, hi1, yCoef, yBias);
+
+        // 2x2 sums: rows added, then neighbouring pixels; one quad per 64 bits
+        __m256i lo = _mm256_add_epi16(lo0, lo1);
+        __m256i hi = _mm256_add_epi16(hi0, hi1);
+        lo = _mm256_add_epi16(lo, _mm256_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+        hi = _mm256_add_epi16(hi, _mm256_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+        const __m256i quads = _mm256_unpacklo_epi64(lo, hi);  // Quads 0, 1 | 2, 3
+
+        __m256i chroma = _mm256_hadd_epi32(_mm256_madd_epi16(quads, uCoef), _mm256_madd_epi16(quads, vCoef));
+        chroma = _mm256_srai_epi32(_mm256_add_epi32(chroma, cBias), 17);
+        chroma = _mm256_permutevar8x32_epi32(chroma, chromaOrder);
+        chroma = _mm256_packus_epi16(_mm256_packs_epi32(chroma, chroma), chroma);
+        const int first  = _mm256_cvtsi256_si32(chroma);
+        const int second = _mm256_extract_epi32(chroma, 4);
+        if (v) {
+            std::memcpy(u + x / 2, &first, 4);
+            std::memcpy(v + x / 2, &second, 4);
+        } else {
+            std::memcpy(u + x, &first, 4);
+            std::memcpy(u + x + 4, &second, 4);
+        }
+    }
+    return x;
+}
+
+// --- Dispatch -------------------------------------------------------------
+
+struct Dispatch {
+    const char* name;
+    void (*copyRows)(uint8_t*, size_t, const uint8_t*, size_t, size_t, int);
+    void (*swizzle)(uint8_t*, size_t, const uint8_t*, size_t, int, int);
+    int  (*yuvRowPair)(const uint8_t*, const uint8_t*, int, uint8_t*, uint8_t*, uint8_t*, uint8_t*);  // Null = none
+};
+
+constexpr Dispatch SCALAR_DISPATCH = { "Scalar", CopyRowsScalar, SwizzleScalar, nullptr };
+constexpr Dispatch AVX2_DISPATCH   = { "AVX2",   CopyRowsAvx2,   SwizzleAvx2,   YuvRowPairAvx2 };
+
+const Dispatch& GetDispatch() {
+    static const Dispatch& dispatch = GetCpuFeatures().avx2 ? AVX2_DISPATCH : SCALAR_DISPATCH;
+    return dispatch;
+}
+
+void RgbaToYuv420(const uint8_t* src, size_t srcPitch, int width, int height, uint8_t* y, size_t yPitch,
+                  uint8_t* u, size_t uPitch, uint8_t* v, size_t vPitch, int rowBegin, int rowEnd) {
+    const Dispatch& dispatch = GetDispatch();
+    rowBegin = std::max(rowBegin & ~1, 0);
+    rowEnd   = std::min(rowEnd, height);
+    for (int row = rowBegin; row < rowEnd; row += 2) {
+        const bool pair = row + 1 < height;
+        const uint8_t* row0 = src + row * srcPitch;
+        const uint8_t* row1 = pair ? row0 + srcPitch : row0;
+        uint8_t* y0 = y + row * yPitch;
+        uint8_t* y1 = pair ? y0 + yPitch : nullptr;
+        uint8_t* uRow = u + (row / 2) * uPitch;
+        uint8_t* vRow = v ? v + (row / 2) * vPitch : nullptr;
+        const int done = dispatch.yuvRowPair ? dispatch.yuvRowPair(row0, row1, width, y0, y1, uRow, vRow) : 0;
+        YuvRowPairScalar(row0, row1, done, width, y0, y1, uRow, vRow);
+    }
+}
+
+} // namespace
+
+const CpuFeatures& GetCpuFeatures() {
+    static const CpuFeatures features = DetectCpuFeatures();
+    return features;
+}
+
+const char* GetPixelCopyPath() {
+    return GetDispatch().name;
+}
+
+void CopyRows(uint8_t* dst, size_t dstPitch, const uint8_t* src, size_t srcPitch, size_t rowBytes, int rows) {
+    if (rows <= 0 || rowBytes == 0) return;
+    GetDispatch().copyRows(dst, dstPitch, src, srcPitch, rowBytes, rows);
+}
+
+void SwizzleRgbaBgra(uint8_t* dst, size_t dstPitch, const uint8_t* src, size_t srcPitch, int width, int rows) {
+    if (rows <= 0 || width <= 0) return;
+    GetDispatch().swizzle(dst, dstPitch, src, srcPitch, width, rows);
+}
+
+void RgbaToNv12(const uint8_t* src, size_t srcPitch, int width, int height,
+                uint8_t* y, size_t yPitch, uint8_t* uv, size_t uvPitch, int rowBegin, int rowEnd) {
+    RgbaToYuv420(src, srcPitch, width, height, y, yPitch, uv, uvPitch, nullptr, 0, rowBegin, rowEnd);
+}
+
+void RgbaToI420(const uint8_t* src, size_t srcPitch, int width, int height,
+                uint8_t* y, size_t yPitch, uint8_t* u, size_t uPitch, uint8_t* v, size_t vPitch,
+                int rowBegin, int rowEnd) {
+    RgbaToYuv420(src, srcPitch, width, height, y, yPitch, u, uPitch, v, vPitch, rowBegin, rowEnd);
+}
+
+} // namespace SP
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SP {
+
+// CPU row copies and 8-bit RGB conversions for the paths that still touch
+// pixels on the CPU: Map'd uploads and readbacks, packed RGB from the decoder,
+// and RGBA readbacks the encoder converts itself. On VMs and remote desktops
+// (WARP, no hardware decode or encode) these are most of the frame.
+//
+// Each has a scalar and an AVX2 version; the AVX2 ones are chosen once by
+// CPUID (and the OS saving YMM state) on first use. Both give identical bytes.
+// Copies of more than the last-level cache use non-temporal stores: the frame
+// isn't read again by this core before it is evicted anyway, and streaming it
+// past the cache keeps the decoder's and encoder's working sets in it.
+//
+// Pitches are in bytes and may differ from the row size. Nothing here
+// allocates or keeps state beyond the dispatch table.
+
+struct CpuFeatures {
+    bool   avx2 = false;
+    size_t lastLevelCache = 0;  // Bytes; 0 if unknown
+};
+const CpuFeatures& GetCpuFeatures();
+const char* GetPixelCopyPath();  // "AVX2" or "Scalar", for the panels
+
+// Row copy for Map'd uploads and readbacks: one memcpy when both pitches match
+void CopyRows(uint8_t* dst, size_t dstPitch, const uint8_t* src, size_t srcPitch, size_t rowBytes, int rows);
+
+// Swaps bytes 0 and 2 of each 4-byte pixel: RGBA <-> BGRA (and RGB0 <-> BGR0).
+// dst may not overlap src.
+void SwizzleRgbaBgra(uint8_t* dst, size_t dstPitch, const uint8_t* src, size_t srcPitch, int width, int rows);
+
+// Full-range RGBA to BT.709 limited-range 4:2:0, as swscale is set up in
+// VideoEncoder::EnsureScaler; chroma is the 2x2 average. Odd sizes repeat the
+// last column and row. `rowBegin`/`rowEnd` (even, in luma rows) convert a band,
+// so callers can split a frame across threads.
+void RgbaToNv12(const uint8_t* src, size_t srcPitch, int width, int height,
+                uint8_t* y, size_t yPitch, uint8_t* uv, size_t uvPitch, int rowBegin, int rowEnd);
+void RgbaToI420(const uint8_t* src, size_t srcPitch, int width, int height,
+                uint8_t* y, size_t yPitch, uint8_t* u, size_t uPitch, uint8_t* v, size_t vPitch,
+                int rowBegin, int rowEnd);
+
+} // namespace SP
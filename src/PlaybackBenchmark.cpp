@@ -0,0 +1,178 @@
+#include "PlaybackBenchmark.h"
+#include "BenchHistory.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/avutil.h>
+}
+
+namespace SP {
+
+namespace {
+
+std::string ResolvePath(const std::filesystem::path& base, const std::string& path) {
+    if (path.empty() || std::filesystem::path(path).is_absolute()) return path;
+    return (base / path).lexically_normal().string();
+}
+
+float Mean(const std::vector<float>& samples) {
+    if (samples.empty()) return 0.0f;
+    double sum = 0.0;
+    for (float v : samples) sum += v;
+    return static_cast<float>(sum / samples.size());
+}
+
+// Nearest rank; reorders `samples`
+float Percentile(std::vector<float>& samples, double fraction) {
+    if (samples.empty()) return 0.0f;
+    const size_t rank  = static_cast<size_t>(std::ceil(fraction * samples.size()));
+    const size_t index = std::clamp<size_t>(rank, 1, samples.size()) - 1;
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+std::string VersionString(unsigned version) {
+    return std::to_string(AV_VERSION_MAJOR(version)) + "." + std::to_string(AV_VERSION_MINOR(version)) + "." +
+           std::to_string(AV_VERSION_MICRO(version));
+}
+
+} // namespace
+
+bool PlaybackBenchmark::Load(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "Failed to open benchmark file: " + path;
+        return false;
+    }
+    try {
+        const nlohmann::json j = nlohmann::json::parse(file);
+        const std::filesystem::path base = std::filesystem::absolute(path).parent_path();
+        m_presetPath = ResolvePath(base, j.value("preset", std::string()));
+        m_reportPath = ResolvePath(base, j.value("report", std::string("playback_report.json")));
+        m_recordPath  = ResolvePath(base, j.value("record", std::string()));
+        m_recordCodec = j.value("recordCodec", m_recordCodec);
+        m_historyPath = ResolvePath(base, j.value("history", std::string()));
+        m_label       = j.value("label", std::string());
+        m_duration   = j.value("duration", m_duration);
+        m_warmup     = j.value("warmup", m_warmup);
+        m_clips.clear();
+        if (j.contains("clips")) {
+            for (const auto& clip : j.at("clips")) m_clips.push_back(ResolvePath(base, clip.get<std::string>()));
+        }
+    } catch (const std::exception& e) {
+        error = std::string("Invalid benchmark file: ") + e.what();
+        return false;
+    }
+    if (m_clips.empty() || m_duration <= 0.0) {
+        error = "Benchmark file needs \"clips\" and a positive \"duration\"";
+        return false;
+    }
+    m_warmup = std::max(m_warmup, 0.0);
+    return true;
+}
+
+void PlaybackBenchmark::BeginClip(const std::string& clip) {
+    ClipResult result;
+    result.clip = clip;
+    m_results.push_back(std::move(result));
+    m_frameMs.clear();
+    m_decodeMs.clear();
+    m_uploadCpuMs.clear();
+    m_uploadGpuMs.clear();
+    m_shaderGpuMs.clear();
+}
+
+void PlaybackBenchmark::AddTick(float frameMs, bool uploaded, float uploadCpuMs) {
+    m_frameMs.push_back(frameMs);
+    if (uploaded) {
+        ++m_results.back().framesShown;
+        m_uploadCpuMs.push_back(uploadCpuMs);
+    }
+}
+
+void PlaybackBenchmark::AddGpu(float uploadMs, float shaderMs) {
+    if (uploadMs > 0.0f) m_uploadGpuMs.push_back(uploadMs);
+    m_shaderGpuMs.push_back(shaderMs);
+}
+
+void PlaybackBenchmark::AddMemory(uint64_t privateBytes, uint64_t videoMemoryBytes) {
+    ClipResult& result = m_results.back();
+    result.peakPrivateMB     = std::max(result.peakPrivateMB, privateBytes / (1024.0 * 1024.0));
+    result.peakVideoMemoryMB = std::max(result.peakVideoMemoryMB, videoMemoryBytes / (1024.0 * 1024.0));
+}
+
+void PlaybackBenchmark::EndClip() {
+    ClipResult& result = m_results.back();
+    result.ok             = true;
+    result.ticks          = static_cast<int64_t>(m_frameMs.size());
+    result.avgFrameMs     = Mean(m_frameMs);
+    result.maxFrameMs     = m_frameMs.empty() ? 0.0f : *std::max_element(m_frameMs.begin(), m_frameMs.end());
+    result.p50FrameMs     = Percentile(m_frameMs, 0.50);
+    result.p95FrameMs     = Percentile(m_frameMs, 0.95);
+    result.p99FrameMs     = Percentile(m_frameMs, 0.99);
+    result.avgDecodeMs    = Mean(m_decodeMs);
+    result.p99DecodeMs    = Percentile(m_decodeMs, 0.99);
+    result.avgUploadCpuMs = Mean(m_uploadCpuMs);
+    result.avgUploadGpuMs = Mean(m_uploadGpuMs);
+    result.avgShaderGpuMs = Mean(m_shaderGpuMs);
+}
+
+void PlaybackBenchmark::FailClip(const std::string& clip, const std::string& error) {
+    if (m_results.empty() || m_results.back().clip != clip || m_results.back().ok) BeginClip(clip);
+    m_results.back().ok    = false;
+    m_results.back().error = error;
+}
+
+bool PlaybackBenchmark::AllSucceeded() const {
+    return m_results.size() == m_clips.size() &&
+           std::all_of(m_results.begin(), m_results.end(), [](const ClipResult& r) { return r.ok; });
+}
+
+bool PlaybackBenchmark::WriteReport(std::string& error) const {
+    nlohmann::json clips = nlohmann::json::array();
+    for (const ClipResult& r : m_results) {
+        nlohmann::json entry = {
+            {"clip", r.clip}, {"ok", r.ok}, {"codec", r.codec}, {"width", r.width}, {"height", r.height},
+            {"fps", r.fps}, {"seconds", r.seconds}, {"ticks", r.ticks}, {"framesShown", r.framesShown},
+            {"droppedFrames", r.lateDrops + r.discarded + r.underruns},
+            {"lateDrops", r.lateDrops}, {"discarded", r.discarded}, {"underruns", r.underruns},
+            {"avgFrameMs", r.avgFrameMs}, {"p50FrameMs", r.p50FrameMs}, {"p95FrameMs", r.p95FrameMs},
+            {"p99FrameMs", r.p99FrameMs}, {"maxFrameMs", r.maxFrameMs},
+            {"avgDecodeMs", r.avgDecodeMs}, {"p99DecodeMs", r.p99DecodeMs},
+            {"avgUploadCpuMs", r.avgUploadCpuMs}, {"avgUploadGpuMs", r.avgUploadGpuMs},
+            {"avgShaderGpuMs", r.avgShaderGpuMs},
+            {"peakPrivateMB", r.peakPrivateMB}, {"peakVideoMemoryMB", r.peakVideoMemoryMB}
+        };
+        if (r.recorded) {
+            entry["framesEncoded"] = r.framesEncoded;
+            entry["recordDropped"] = r.recordDropped;
+            entry["encodeFps"]     = r.encodeFps;
+            entry["avgEncodeMs"]   = r.avgEncodeMs;
+        }
+        if (!r.ok) entry["error"] = r.error;
+        clips.push_back(std::move(entry));
+    }
+    nlohmann::json report = {
+        {"preset", m_presetPath}, {"duration", m_duration}, {"warmup", m_warmup},
+        {"ffmpeg", av_version_info()},
+        {"libavcodec", VersionString(avcodec_version())}, {"libavformat", VersionString(avformat_version())},
+        {"clips", clips}
+    };
+    if (!m_recordPath.empty()) report["recordCodec"] = m_recordCodec;
+
+    std::ofstream file(m_reportPath, std::ios::trunc);
+    file << report.dump(2) << "\n";
+    if (!file) {
+        error = "Failed to write " + m_reportPath;
+        return false;
+    }
+    return m_historyPath.empty() ||
+           BenchHistory::Append(m_historyPath, "playback", m_label, BenchHistory::DescribeMachine(m_adapter), report, error);
+}
+
+} // namespace SP
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Reproducible playback run (ShaderPlayer --playback-bench <file>): every clip
+// of the file is played through one preset for a fixed time with vsync and the
+// frame cap off, then the app writes a report and exits. Application drives it
+// (StepPlaybackBenchmark); this class holds the settings and the samples.
+//
+// File: {"preset": "shaders/x.hlsl", "duration": 30, "warmup": 3,
+//        "clips": ["ref/1080p_h264.mp4", ...], "report": "playback_report.json",
+//        "record": "bench_take.mp4", "recordCodec": "libx264",
+//        "history": "bench_history.jsonl", "label": "..."}
+// Relative paths are relative to the file. "record" (optional) records every
+// clip's measured part to that file, overwritten per clip, to time the encoder
+// too. "history" (optional) appends the report to a BenchHistory store.
+class PlaybackBenchmark {
+public:
+    struct ClipResult {
+        std::string clip;
+        bool        ok = false;
+        std::string error;
+        std::string codec;
+        int    width = 0, height = 0;
+        double fps = 0.0;
+        double seconds = 0.0;        // Measured wall time
+        int64_t ticks = 0;           // Main-loop iterations measured
+        int64_t framesShown = 0;     // New source frames uploaded
+        int64_t lateDrops = 0;       // Decoded, superseded before shown
+        int64_t discarded = 0;       // Dropped before conversion to catch up
+        int64_t underruns = 0;       // A frame was due and the queue was empty
+        float avgFrameMs = 0.0f, p50FrameMs = 0.0f, p95FrameMs = 0.0f, p99FrameMs = 0.0f,
+              maxFrameMs = 0.0f;                                        // Tick times
+        float avgDecodeMs = 0.0f, p99DecodeMs = 0.0f;                   // Per decoded frame
+        float avgUploadCpuMs = 0.0f, avgUploadGpuMs = 0.0f;             // Ticks that uploaded
+        float avgShaderGpuMs = 0.0f;
+        double peakPrivateMB = 0.0;      // Process private bytes
+        double peakVideoMemoryMB = 0.0;  // Local video memory in use
+        // With "record": frames the encoder finished (and dropped) while measured,
+        // and the convert + encode time per frame
+        bool    recorded = false;
+        int64_t framesEncoded = 0;
+        int64_t recordDropped = 0;
+        double  encodeFps     = 0.0;
+        float   avgEncodeMs   = 0.0f;
+    };
+
+    // False with `error` set on a missing or malformed file
+    bool Load(const std::string& path, std::string& error);
+
+    const std::string& GetPresetPath() const { return m_presetPath; }
+    double GetDuration() const { return m_duration; }
+    double GetWarmup() const { return m_warmup; }
+    const std::vector<std::string>& GetClips() const { return m_clips; }
+    const std::string& GetRecordPath() const { return m_recordPath; }  // Empty = no recording
+    const std::string& GetRecordCodec() const { return m_recordCodec; }
+    void SetAdapter(const std::string& name) { m_adapter = name; }      // For the history's machine record
+
+    // Samples of the clip being measured; EndClip reduces them into its result
+    void BeginClip(const std::string& clip);
+    void AddTick(float frameMs, bool uploaded, float uploadCpuMs);
+    void AddDecode(float decodeMs) { m_decodeMs.push_back(decodeMs); }
+    void AddGpu(float uploadMs, float shaderMs);
+    void AddMemory(uint64_t privateBytes, uint64_t videoMemoryBytes);
+    ClipResult& Current() { return m_results.back(); }
+    void EndClip();
+    void FailClip(const std::string& clip, const std::string& error);
+
+    bool AllSucceeded() const;
+    // JSON at the file's "report" path, with the FFmpeg build it ran on; also
+    // appended to "history" when the file names one
+    bool WriteReport(std::string& error) const;
+
+private:
+    std::string m_presetPath;
+    std::string m_reportPath;
+    std::string m_recordPath;
+    std::string m_recordCodec = "libx264";
+    std::string m_historyPath;
+    std::string m_label;
+    std::string m_adapter;
+    double m_duration = 30.0;
+    double m_warmup   = 3.0;
+    std::vector<std::string> m_clips;
+
+    std::vector<ClipResult> m_results;
+    std::vector<float> m_frameMs;
+    std::vector<float> m_decodeMs;
+    std::vector<float> m_uploadCpuMs;
+    std::vector<float> m_uploadGpuMs;
+    std::vector<float> m_shaderGpuMs;
+};
+
+} // namespace SP
@@ -0,0 +1,67 @@
+#include "PlaybackChannel.h"
+
+namespace SP {
+
+PlaybackChannel::~PlaybackChannel() {
+    m_output.Close();  // Joins its present thread before the textures it copies go
+}
+
+void PlaybackChannel::Cue(const std::string& path, int threadCount, int proxyScale) {
+    m_deck.Cue(path, threadCount, proxyScale);
+    m_texture   = D3D11Renderer::InputTexture{};
+    m_submitted = nullptr;
+}
+
+void PlaybackChannel::Unload() {
+    m_deck.Unload();
+    m_texture   = D3D11Renderer::InputTexture{};
+    m_submitted = nullptr;
+}
+
+bool PlaybackChannel::Poll() {
+    return m_deck.Poll();
+}
+
+void PlaybackChannel::SetPlaying(bool playing) {
+    if (m_deck.IsReady() && m_deck.IsPlaying() != playing) m_deck.SetPlaying(playing);
+}
+
+bool PlaybackChannel::OpenOutput(ID3D11Device* device, ID3D11DeviceContext* context, const std::wstring& title,
+                                 std::function<void(bool entered)> onModalLoop) {
+    m_output.SetModalLoopCallback(std::move(onModalLoop));
+    if (!m_output.Open(device, context)) return false;
+    m_submitted = nullptr;  // A new window has seen nothing yet
+    SetWindowTextW(m_output.GetHwnd(), title.c_str());
+    return true;
+}
+
+void PlaybackChannel::Render(D3D11Renderer& renderer) {
+    if (!m_deck.IsReady()) return;
+    m_deck.Update();
+    const int width  = m_output.GetWidth();
+    const int height = m_output.GetHeight();
+    // Closed or minimized: the clock runs on, nothing is uploaded or drawn
+    if (!m_output.IsOpen() || width <= 0 || height <= 0) return;
+    if (!renderer.UploadFrameTexture(m_texture, m_deck.GetFrame()) || !m_texture.srv) return;
+
+    ID3D11ShaderResourceView* frame =
+        renderer.RunPostChain(m_chain, m_stages, m_texture.srv.Get(), width, height, m_texture.generation);
+    // The window keeps showing its last frame: only a new one (or a resize) is blitted
+    const uint64_t generation = frame == m_texture.srv.Get() ? m_texture.generation : m_chain.generation;
+    if (frame == m_submitted && generation == m_submittedGeneration && width == m_submittedWidth &&
+        height == m_submittedHeight)
+        return;
+    m_output.SubmitFrame(renderer, frame);
+    m_submitted           = frame;
+    m_submittedGeneration = generation;
+    m_submittedWidth      = width;
+    m_submittedHeight     = height;
+}
+
+void PlaybackChannel::Release(D3D11Renderer& renderer) {
+    renderer.ReleasePostChain(m_chain);
+    m_texture   = D3D11Renderer::InputTexture{};
+    m_submitted = nullptr;
+}
+
+} // namespace SP
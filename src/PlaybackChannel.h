@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Common.h"
+#include "Deck.h"
+#include "D3D11Renderer.h"
+#include "VideoOutputWindow.h"
+
+namespace SP {
+
+// One extra playback channel (AppConfig::channels) of a multi-projector install:
+// a clip on its own clock, one preset drawn over it and its own output window,
+// hosted by the process that runs the main player instead of a process per
+// projector. Everything heavy is shared with the main player: the D3D11 device
+// and its immediate context (one GPU queue, no cross-device copies), the shader
+// library and bytecode cache (the preset is ShaderManager::GetPostStage's), the
+// render-target pool behind the preset's targets, and the cores: the clip's
+// libavcodec gets a share of the threads, and demux and decode run on its own
+// DecodeWorker, so no channel decodes on the render thread.
+//
+// Render thread only, apart from the Deck's loader.
+class PlaybackChannel {
+public:
+    PlaybackChannel() = default;
+    ~PlaybackChannel();
+
+    // Non-copyable
+    PlaybackChannel(const PlaybackChannel&) = delete;
+    PlaybackChannel& operator=(const PlaybackChannel&) = delete;
+
+    // As Deck::Cue / Deck::Poll
+    void Cue(const std::string& path, int threadCount, int proxyScale);
+    void Unload();
+    bool Poll();
+    const Deck& GetDeck() const { return m_deck; }
+    void SetPlaying(bool playing);
+
+    // `title` names the window in the taskbar (one per projector)
+    bool OpenOutput(ID3D11Device* device, ID3D11DeviceContext* context, const std::wstring& title,
+                    std::function<void(bool entered)> onModalLoop);
+    void CloseOutput() { m_output.Close(); }
+    const VideoOutputWindow& GetOutput() const { return m_output; }
+
+    // The preset over the clip; empty = the clip as is
+    void SetStages(std::vector<D3D11Renderer::PostStage> stages) { m_stages = std::move(stages); }
+    const std::vector<D3D11Renderer::PostStage>& GetStages() const { return m_stages; }
+
+    // Advances the clip, uploads its frame when it changed and draws it through
+    // the preset at the window's size into the window's mailbox. After
+    // RenderToDisplay, as RunPostChain.
+    void Render(D3D11Renderer& renderer);
+    // The preset's targets back to the pool, the clip's texture dropped
+    void Release(D3D11Renderer& renderer);
+
+private:
+    Deck                                  m_deck;
+    D3D11Renderer::InputTexture           m_texture;
+    D3D11Renderer::PostChain              m_chain;
+    std::vector<D3D11Renderer::PostStage> m_stages;
+    VideoOutputWindow                     m_output;
+
+    // What the window was last given, so an unchanged frame isn't blitted again
+    ID3D11ShaderResourceView* m_submitted = nullptr;
+    uint64_t m_submittedGeneration = 0;
+    int      m_submittedWidth  = 0;
+    int      m_submittedHeight = 0;
+};
+
+} // namespace SP
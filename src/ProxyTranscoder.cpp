@@ -0,0 +1,174 @@
+#include "ProxyTranscoder.h"
+#include "VideoDecoder.h"
+#include "VideoEncoder.h"
+#include <algorithm>
+#include <cstring>
+
+namespace SP {
+
+namespace {
+
+// ProRes 422 Proxy: intra-only and cheap to decode, ~45 Mbit/s at 1080p
+constexpr int PROXY_SCALE          = 2;
+constexpr int PRORES_PROXY_PROFILE = 0;
+// A transcode that ends earlier than this before the source's duration hit a
+// decode error, not the end of the file
+constexpr double END_TOLERANCE_SECONDS = 1.0;
+
+std::filesystem::path GetProxyCacheDir(const std::string& cacheDir) {
+    std::filesystem::path dir;
+    if (cacheDir.empty()) {
+        char exePath[MAX_PATH];
+        GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+        dir = std::filesystem::path(exePath).parent_path() / "proxy_cache";
+    } else {
+        dir = cacheDir;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    return dir;
+}
+
+} // namespace
+
+ProxyTranscoder::~ProxyTranscoder() {
+    Cancel();
+}
+
+std::string ProxyTranscoder::GetProxyPath(const std::string& source, const std::string& cacheDir) {
+    // Same key as the seek index: a re-rendered file is transcoded again
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(source, ec);
+    if (ec) return {};
+    const auto mtime = std::filesystem::last_write_time(source, ec);
+    if (ec) return {};
+
+    const int64_t stamp[2] = {
+        static_cast<int64_t>(size),
+        static_cast<int64_t>(mtime.time_since_epoch().count())
+    };
+    uint64_t hash = Fnv1a64(source.c_str(), source.size());
+    hash = Fnv1a64(reinterpret_cast<const char*>(stamp), sizeof(stamp), hash);
+
+    // Readable stem for whoever cleans the cache out by hand
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "_%016llx.mov", static_cast<unsigned long long>(hash));
+    const std::string stem = std::filesystem::path(source).stem().string().substr(0, 64);
+    return (GetProxyCacheDir(cacheDir) / (stem + suffix)).string();
+}
+
+std::string ProxyTranscoder::FindProxy(const std::string& source, const std::string& cacheDir) {
+    std::string path = GetProxyPath(source, cacheDir);
+    std::error_code ec;
+    if (path.empty() || !std::filesystem::exists(path, ec)) return {};
+    return path;
+}
+
+void ProxyTranscoder::Start(const std::string& source, const std::string& cacheDir) {
+    Cancel();
+    const std::string target = GetProxyPath(source, cacheDir);
+    if (target.empty()) return;
+
+    m_source    = source;
+    m_cancel    = false;
+    m_done      = false;
+    m_succeeded = false;
+    m_progress  = 0.0f;
+    m_thread = std::thread(&ProxyTranscoder::TranscodeThread, this, target);
+}
+
+void ProxyTranscoder::Cancel() {
+    m_cancel = true;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_done = false;
+    m_source.clear();
+}
+
+bool ProxyTranscoder::Take() {
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_done = false;
+    return m_succeeded.load();
+}
+
+void ProxyTranscoder::TranscodeThread(std::string target) {
+    // Don't compete with playback for the CPU
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+    // Same extension, so the muxer is still picked from the name
+    const std::filesystem::path targetPath(target);
+    const std::string partial = (targetPath.parent_path() /
+                                 (targetPath.stem().string() + ".partial.mov")).string();
+
+    bool ok = Transcode(partial);
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(partial, target, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::filesystem::remove(partial, ec);
+    }
+
+    m_succeeded = ok;
+    m_done.store(true, std::memory_order_release);
+}
+
+bool ProxyTranscoder::Transcode(const std::string& partial) {
+    // Software decode straight to half-size RGBA, on half the cores
+    VideoDecoder decoder;
+    decoder.SetSeekIndexEnabled(false);
+    decoder.SetGpuYuvConversion(false);
+    decoder.SetProxyScale(PROXY_SCALE);
+    decoder.SetDecodeThreading(std::max(static_cast<int>(std::thread::hardware_concurrency()) / 2, 1), 0);
+    if (!decoder.Open(m_source)) return false;
+
+    RecordingSettings settings;
+    settings.outputPath     = partial;
+    settings.codec          = "prores_ks";
+    settings.proresProfile  = PRORES_PROXY_PROFILE;
+    settings.dropWhenBehind = false;
+    // 4:2:2 needs an even width; odd proxy frames are scaled by the encoder
+    settings.width  = std::max(decoder.GetWidth() & ~1, 2);
+    settings.height = std::max(decoder.GetHeight() & ~1, 2);
+
+    VideoEncoder encoder;
+    if (!encoder.StartRecording(settings, decoder.GetWidth(), decoder.GetHeight(), decoder.GetFPS())) {
+        return false;
+    }
+
+    const double duration = decoder.GetDuration();
+    double lastTime = 0.0;
+    int64_t frames  = 0;
+    VideoFrame frame;
+    while (!m_cancel.load() && decoder.DecodeNextFrame(frame)) {
+        if (frame.layout != FrameLayout::RGBA8 || !frame.data[0]) continue;
+
+        // Into an encoder block: tightly packed, with the two rows of tail
+        // padding swscale's read-ahead needs
+        const size_t rowBytes = static_cast<size_t>(frame.width) * 4;
+        FrameBuffer block = encoder.GetFramePool().Acquire(rowBytes * (static_cast<size_t>(frame.height) + 2));
+        for (int y = 0; y < frame.height; ++y) {
+            std::memcpy(block.get() + y * rowBytes, frame.data[0] + static_cast<size_t>(y) * frame.linesize[0], rowBytes);
+        }
+
+        const double timestamp = (frame.pts != AV_NOPTS_VALUE) ? frame.timestamp : -1.0;
+        if (!encoder.SubmitFrame(std::move(block), frame.width, frame.height, ReadbackLayout::RGBA8, timestamp)) break;
+        ++frames;
+        if (timestamp >= 0.0) lastTime = timestamp;
+        if (duration > 0.0) {
+            m_progress = static_cast<float>(std::clamp(lastTime / duration, 0.0, 1.0));
+        }
+    }
+
+    encoder.StopRecording();
+    encoder.WaitUntilFinished();  // Trailer written, file closed
+
+    if (m_cancel.load() || frames == 0) return false;
+    return duration <= 0.0 || lastTime >= duration - END_TOLERANCE_SECONDS;
+}
+
+} // namespace SP
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Background job that transcodes a long-GOP source into an intra-only edit proxy:
+// ProRes 422 Proxy at half size, video only, in the proxy cache. Every frame of
+// an intra-only file is a keyframe, so a seek decodes exactly one frame;
+// Application::OpenVideo plays and scrubs the proxy instead of the source once
+// it exists (audio is still read from the source).
+//
+// The worker decodes with its own software VideoDecoder (at proxy scale 2, so
+// frames arrive as half-size RGBA) and encodes through a VideoEncoder that
+// blocks instead of dropping frames. Frames keep their source timestamps, so the
+// proxy lines up with the source's audio. The file is written under a temporary
+// name and renamed once complete: a cancelled or failed job never leaves
+// something that looks like a finished proxy.
+class ProxyTranscoder {
+public:
+    ProxyTranscoder() = default;
+    ~ProxyTranscoder();
+
+    // Non-copyable
+    ProxyTranscoder(const ProxyTranscoder&) = delete;
+    ProxyTranscoder& operator=(const ProxyTranscoder&) = delete;
+
+    // Where the proxy of `source` goes in `cacheDir` (empty = proxy_cache/ next to
+    // the exe). Keyed on path + size + mtime, so a re-rendered source gets a new
+    // proxy. Empty when the source can't be stat'ed.
+    static std::string GetProxyPath(const std::string& source, const std::string& cacheDir);
+    // The finished proxy of `source`, or empty when there is none yet
+    static std::string FindProxy(const std::string& source, const std::string& cacheDir);
+
+    // Cancels any job in progress and starts transcoding `source`
+    void Start(const std::string& source, const std::string& cacheDir);
+    // Stops the job, joins, and removes its partial output
+    void Cancel();
+
+    bool  IsRunning() const { return m_thread.joinable() && !IsDone(); }
+    bool  IsDone() const { return m_done.load(std::memory_order_acquire); }
+    float GetProgress() const { return m_progress.load(); }  // [0,1] while running
+    const std::string& GetSourcePath() const { return m_source; }
+
+    // Call once IsDone(). Joins the worker; true when the proxy was written.
+    bool Take();
+
+private:
+    void TranscodeThread(std::string target);
+    bool Transcode(const std::string& partial);  // Writes `partial`; false = incomplete
+
+    std::string m_source;
+    std::thread m_thread;
+    std::atomic<bool>  m_cancel{false};
+    std::atomic<bool>  m_done{false};
+    std::atomic<bool>  m_succeeded{false};  // Published by m_done
+    std::atomic<float> m_progress{0.0f};
+};
+
+} // namespace SP
@@ -0,0 +1,118 @@
+#include "RecordingTelemetry.h"
+#include <algorithm>
+#include <cmath>
+
+namespace SP {
+
+namespace {
+
+constexpr float FIRST_BIN_MS = 0.25f;
+
+constexpr const char* STAGE_NAMES[RECORDING_STAGE_COUNT] = {
+    "Readback", "Queue", "Convert", "Encode", "Mux",
+};
+
+constexpr const char* BIN_LABELS[RecordingTelemetry::HISTOGRAM_BINS] = {
+    "<0.25", "<0.5", "<1", "<2", "<4", "<8", "<16", "<32", "<64", ">=64",
+};
+
+int BinFor(float ms) {
+    if (ms < FIRST_BIN_MS) return 0;
+    const int bin = 1 + static_cast<int>(std::floor(std::log2(ms / FIRST_BIN_MS)));
+    return std::min(bin, RecordingTelemetry::HISTOGRAM_BINS - 1);
+}
+
+} // namespace
+
+const char* RecordingTelemetry::StageName(RecordingStage stage) {
+    return STAGE_NAMES[static_cast<int>(stage)];
+}
+
+const char* RecordingTelemetry::BinLabel(int bin) {
+    return BIN_LABELS[std::clamp(bin, 0, HISTOGRAM_BINS - 1)];
+}
+
+void RecordingTelemetry::Reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_next  = 0;
+    m_count = 0;
+}
+
+bool RecordingTelemetry::OpenCsv(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_csv.is_open()) m_csv.close();
+    m_csv.open(path, std::ios::trunc);
+    if (!m_csv) return false;
+    m_csv << "frame";
+    for (const char* name : STAGE_NAMES) m_csv << ',' << name << "_ms";
+    m_csv << ",queue_depth\n";
+    return true;
+}
+
+void RecordingTelemetry::CloseCsv() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_csv.is_open()) m_csv.close();
+}
+
+void RecordingTelemetry::Record(const FrameTiming& timing) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_history[m_next] = timing;
+    m_next = (m_next + 1) % HISTORY_SIZE;
+    if (m_csv.is_open()) {
+        m_csv << m_count;
+        for (float ms : timing.ms) m_csv << ',' << ms;
+        m_csv << ',' << timing.queueDepth << '\n';
+    }
+    m_count++;
+}
+
+RecordingTelemetry::Snapshot RecordingTelemetry::GetSnapshot() const {
+    Snapshot snapshot;
+    GetSnapshot(snapshot);
+    return snapshot;
+}
+
+void RecordingTelemetry::GetSnapshot(Snapshot& out, std::pmr::memory_resource* scratch) const {
+    out.stages = {};
+    out.queueDepth.clear();
+    out.totalMs.clear();
+    std::pmr::vector<FrameTiming> frames(scratch);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out.frames = m_count;
+        const int size = static_cast<int>(std::min<int64_t>(m_count, HISTORY_SIZE));
+        frames.reserve(size);
+        for (int i = 0; i < size; ++i) {
+            frames.push_back(m_history[(m_next - size + i + HISTORY_SIZE) % HISTORY_SIZE]);
+        }
+    }
+    if (frames.empty()) return;
+
+    out.queueDepth.reserve(frames.size());
+    out.totalMs.reserve(frames.size());
+    for (const FrameTiming& frame : frames) {
+        float total = 0.0f;
+        for (float ms : frame.ms) total += ms;
+        out.queueDepth.push_back(static_cast<float>(frame.queueDepth));
+        out.totalMs.push_back(total);
+    }
+
+    std::pmr::vector<float> sorted(frames.size(), scratch);
+    for (int s = 0; s < RECORDING_STAGE_COUNT; ++s) {
+        StageStats& stats = out.stages[s];
+        double sum = 0.0;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const float ms = frames[i].ms[s];
+            sorted[i] = ms;
+            sum += ms;
+            stats.histogram[BinFor(ms)] += 1.0f;
+        }
+        std::sort(sorted.begin(), sorted.end());
+        stats.lastMs = frames.back().ms[s];
+        stats.avgMs  = static_cast<float>(sum / frames.size());
+        stats.p95Ms  = sorted[(sorted.size() - 1) * 95 / 100];
+        stats.maxMs  = sorted.back();
+    }
+}
+
+} // namespace SP
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Common.h"
+#include <array>
+#include <fstream>
+#include <memory_resource>
+
+namespace SP {
+
+// Stages a recorded frame passes through, in order. Readback is the CPU map and
+// copy in CollectReadback; Queue is the wait in the encoder's frame queue;
+// Convert is swscale into the codec frame; Encode is the codec itself and Mux
+// the packets' way into the muxer, write-behind queue or send queue.
+enum class RecordingStage { Readback, Queue, Convert, Encode, Mux, Count };
+constexpr int RECORDING_STAGE_COUNT = static_cast<int>(RecordingStage::Count);
+
+// One frame's trip through the recording pipeline
+struct FrameTiming {
+    std::array<float, RECORDING_STAGE_COUNT> ms{};
+    int queueDepth = 0;  // Frames queued behind it when the encoder took it
+};
+
+// Per-stage timings of the last HISTORY_SIZE frames of a VideoEncoder, so a drop
+// can be pinned on the stage that fell behind. Written by the encoder thread,
+// read by the UI (mutex; one sample per frame). Optionally appends every frame
+// to a CSV.
+class RecordingTelemetry {
+public:
+    static constexpr int HISTORY_SIZE = 300;
+    // Log2 buckets: < 0.25 ms, < 0.5, < 1, ... < 64, >= 64 ms
+    static constexpr int HISTOGRAM_BINS = 10;
+
+    struct StageStats {
+        float lastMs = 0.0f;
+        float avgMs  = 0.0f;
+        float p95Ms  = 0.0f;
+        float maxMs  = 0.0f;
+        std::array<float, HISTOGRAM_BINS> histogram{};  // Frame counts
+    };
+    struct Snapshot {
+        std::array<StageStats, RECORDING_STAGE_COUNT> stages{};
+        std::vector<float> queueDepth;  // Oldest first
+        std::vector<float> totalMs;     // Sum of the stages per frame, oldest first
+        int64_t frames = 0;             // Recorded since Reset
+    };
+
+    RecordingTelemetry() = default;
+    ~RecordingTelemetry() { CloseCsv(); }
+
+    // Non-copyable
+    RecordingTelemetry(const RecordingTelemetry&) = delete;
+    RecordingTelemetry& operator=(const RecordingTelemetry&) = delete;
+
+    static const char* StageName(RecordingStage stage);
+    static const char* BinLabel(int bin);
+
+    void Reset();
+    bool OpenCsv(const std::string& path);
+    void CloseCsv();
+
+    void Record(const FrameTiming& timing);
+    Snapshot GetSnapshot() const;
+    // Fills `out` reusing its vectors' storage; `scratch` backs the temporaries
+    void GetSnapshot(Snapshot& out, std::pmr::memory_resource* scratch = std::pmr::get_default_resource()) const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::array<FrameTiming, HISTORY_SIZE> m_history{};
+    int     m_next  = 0;  // Ring position of the next sample
+    int64_t m_count = 0;
+    std::ofstream m_csv;
+};
+
+} // namespace SP
@@ -0,0 +1,111 @@
+#include "RenderAheadQueue.h"
+#include <algorithm>
+
+namespace SP {
+
+void RenderAheadQueue::SetCapacity(int frames) {
+    frames = std::max(frames, 0);
+    if (frames == GetCapacity()) return;
+    m_slots.clear();
+    m_slots.resize(static_cast<size_t>(frames));
+    m_head = 0;
+    m_size = 0;
+}
+
+void RenderAheadQueue::Clear() {
+    // The textures stay for the next fill
+    for (Slot& slot : m_slots) slot.entry = Entry{};
+    m_head = 0;
+    m_size = 0;
+}
+
+bool RenderAheadQueue::Ensure(ID3D11Device* device, Texture& texture, int width, int height, DXGI_FORMAT format,
+                              bool shaderResource) {
+    if (texture.texture && texture.width == width && texture.height == height && texture.format == format)
+        return true;
+    texture = Texture{};
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = width;
+    desc.Height           = height;
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    // Outputs are only ever copied back into the display texture
+    desc.BindFlags        = shaderResource ? D3D11_BIND_SHADER_RESOURCE : 0;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, &texture.texture)) ||
+        (shaderResource && FAILED(device->CreateShaderResourceView(texture.texture.Get(), nullptr, &texture.srv)))) {
+        texture = Texture{};
+        return false;
+    }
+    texture.width  = width;
+    texture.height = height;
+    texture.format = format;
+    return true;
+}
+
+bool RenderAheadQueue::Push(ID3D11Device* device, ID3D11DeviceContext* context, double timestamp, bool loopStart,
+                            ID3D11Texture2D* source, int sourceWidth, int sourceHeight, DXGI_FORMAT sourceFormat,
+                            ID3D11Texture2D* output, int outputWidth, int outputHeight, DXGI_FORMAT outputFormat) {
+    if (IsFull() || !source || !output || sourceWidth <= 0 || sourceHeight <= 0 ||
+        outputWidth <= 0 || outputHeight <= 0) {
+        return false;
+    }
+    Slot& slot = SlotAt(m_size);
+    if (!Ensure(device, slot.source, sourceWidth, sourceHeight, sourceFormat, true) ||
+        !Ensure(device, slot.output, outputWidth, outputHeight, outputFormat, false)) {
+        return false;
+    }
+    context->CopyResource(slot.source.texture.Get(), source);
+    context->CopyResource(slot.output.texture.Get(), output);
+    slot.entry.timestamp = timestamp;
+    slot.entry.loopStart = loopStart;
+    slot.entry.stale     = false;
+    ++m_size;
+    return true;
+}
+
+bool RenderAheadQueue::Store(ID3D11Device* device, ID3D11DeviceContext* context, int index,
+                             ID3D11Texture2D* output, int width, int height, DXGI_FORMAT format) {
+    if (index < 0 || index >= m_size || !output) return false;
+    Slot& slot = SlotAt(index);
+    if (!Ensure(device, slot.output, width, height, format, false)) return false;
+    context->CopyResource(slot.output.texture.Get(), output);
+    slot.entry.stale = false;
+    return true;
+}
+
+void RenderAheadQueue::PopFront() {
+    if (m_size == 0) return;
+    SlotAt(0).entry = Entry{};
+    m_head = (m_head + 1) % static_cast<int>(m_slots.size());
+    --m_size;
+}
+
+void RenderAheadQueue::Invalidate() {
+    for (int i = 0; i < m_size; ++i) SlotAt(i).entry.stale = true;
+}
+
+ID3D11Texture2D* RenderAheadQueue::GetOutput(int index, int width, int height, DXGI_FORMAT format) const {
+    if (index < 0 || index >= m_size) return nullptr;
+    const Texture& output = SlotAt(index).output;
+    if (output.width != width || output.height != height || output.format != format) return nullptr;
+    return output.texture.Get();
+}
+
+size_t RenderAheadQueue::GetUsedBytes() const {
+    size_t bytes = 0;
+    for (const Slot& slot : m_slots) {
+        for (const Texture* texture : {&slot.source, &slot.output}) {
+            if (!texture->texture) continue;
+            const size_t pixelBytes = (texture->format == DXGI_FORMAT_R16G16B16A16_UNORM ||
+                                       texture->format == DXGI_FORMAT_R16G16B16A16_FLOAT) ? 8 : 4;
+            bytes += static_cast<size_t>(texture->width) * texture->height * pixelBytes;
+        }
+    }
+    return bytes;
+}
+
+} // namespace SP
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Finished frames of forward file playback rendered ahead of the playhead
+// (AppConfig::renderAheadFrames), so a slow frame or a shader compile stall is
+// absorbed by the frames already waiting instead of showing as a drop. Each
+// entry keeps the display texture RenderToDisplay drew for its time plus a copy
+// of the t0 video it drew from: a param or shader change marks entries stale
+// and they are drawn again from that copy, with no seek or decode.
+//
+// Entry 0 is the frame on screen; the rest wait for their time. Textures stay
+// allocated per slot and are reused as the ring turns. Render thread only.
+class RenderAheadQueue {
+public:
+    struct Entry {
+        double timestamp = 0.0;
+        bool   loopStart = false;  // First frame after the decode worker wrapped
+        bool   stale     = false;  // Drawn with values or a shader no longer current
+    };
+
+    RenderAheadQueue() = default;
+
+    // Non-copyable
+    RenderAheadQueue(const RenderAheadQueue&) = delete;
+    RenderAheadQueue& operator=(const RenderAheadQueue&) = delete;
+
+    // Slots for `frames` entries; a change drops everything queued. 0 frees all.
+    void SetCapacity(int frames);
+    void Clear();
+
+    // GPU-copies the t0 video (`source`) and the finished frame (`output`) into
+    // the next slot. False when full or a texture can't be created.
+    bool Push(ID3D11Device* device, ID3D11DeviceContext* context, double timestamp, bool loopStart,
+              ID3D11Texture2D* source, int sourceWidth, int sourceHeight, DXGI_FORMAT sourceFormat,
+              ID3D11Texture2D* output, int outputWidth, int outputHeight, DXGI_FORMAT outputFormat);
+    // Redrawn: `output` replaces entry `index`'s frame and clears its stale flag
+    bool Store(ID3D11Device* device, ID3D11DeviceContext* context, int index,
+               ID3D11Texture2D* output, int width, int height, DXGI_FORMAT format);
+    void PopFront();
+    // Every entry is drawn again before it is shown
+    void Invalidate();
+
+    int  GetSize() const { return m_size; }
+    int  GetCapacity() const { return static_cast<int>(m_slots.size()); }
+    bool IsEmpty() const { return m_size == 0; }
+    bool IsFull() const { return m_size == GetCapacity(); }
+    const Entry& At(int index) const { return SlotAt(index).entry; }
+
+    // Entry `index`'s t0 copy, bound by D3D11Renderer::ShowRenderAheadSource
+    ID3D11ShaderResourceView* GetSourceSRV(int index) const { return SlotAt(index).source.srv.Get(); }
+    // Entry `index`'s frame when it has `width` x `height` in `format`, else null
+    ID3D11Texture2D* GetOutput(int index, int width, int height, DXGI_FORMAT format) const;
+    size_t GetUsedBytes() const;
+
+private:
+    struct Texture {
+        ComPtr<ID3D11Texture2D>          texture;
+        ComPtr<ID3D11ShaderResourceView> srv;
+        int         width  = 0;
+        int         height = 0;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    };
+    struct Slot {
+        Entry   entry;
+        Texture source;
+        Texture output;
+    };
+
+    // Reallocates `texture` unless it already has this size and format
+    static bool Ensure(ID3D11Device* device, Texture& texture, int width, int height, DXGI_FORMAT format,
+                       bool shaderResource);
+    Slot&       SlotAt(int index)       { return m_slots[(m_head + index) % m_slots.size()]; }
+    const Slot& SlotAt(int index) const { return m_slots[(m_head + index) % m_slots.size()]; }
+
+    std::vector<Slot> m_slots;
+    int m_head = 0;
+    int m_size = 0;
+};
+
+} // namespace SP
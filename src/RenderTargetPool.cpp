@@ -0,0 +1,172 @@
+#include "RenderTargetPool.h"
+#include <algorithm>
+
+namespace SP {
+
+namespace {
+
+size_t BytesPerPixel(DXGI_FORMAT format) {
+    switch (format) {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM: return 8;
+    default:                             return 4;
+    }
+}
+
+size_t TargetBytes(const RenderTargetPool::Target& t) {
+    return static_cast<size_t>(t.width) * t.height * BytesPerPixel(t.format);
+}
+
+} // namespace
+
+void RenderTargetPool::BeginPlan() {
+    for (auto& entry : m_entries) {
+        entry->inUse   = false;
+        entry->planned = false;
+    }
+}
+
+const RenderTargetPool::Target* RenderTargetPool::Acquire(ID3D11Device* device, int width, int height,
+                                                          DXGI_FORMAT format) {
+    for (auto& entry : m_entries) {
+        const Target& t = entry->target;
+        if (!entry->inUse && t.width == width && t.height == height && t.format == format) {
+            entry->inUse   = true;
+            entry->planned = true;
+            return &entry->target;
+        }
+    }
+
+    auto entry = std::make_unique<Entry>();
+    if (!Take(device, width, height, format, D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE,
+              D3D11_USAGE_DEFAULT, entry->target)) {
+        return nullptr;
+    }
+
+    entry->inUse   = true;
+    entry->planned = true;
+    m_entries.push_back(std::move(entry));
+    return &m_entries.back()->target;
+}
+
+bool RenderTargetPool::Create(ID3D11Device* device, int width, int height, DXGI_FORMAT format, Target& t) {
+    return Create(device, width, height, format, D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE,
+                  D3D11_USAGE_DEFAULT, t);
+}
+
+bool RenderTargetPool::Create(ID3D11Device* device, int width, int height, DXGI_FORMAT format,
+                              UINT bindFlags, D3D11_USAGE usage, Target& t) {
+    t = Target{};
+    D3D11_TEXTURE2D_DESC texDesc = {};
+    texDesc.Width     = static_cast<UINT>(width);
+    texDesc.Height    = static_cast<UINT>(height);
+    texDesc.MipLevels = 1;
+    texDesc.ArraySize = 1;
+    texDesc.Format    = format;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.Usage     = usage;
+    texDesc.BindFlags = bindFlags;
+    texDesc.CPUAccessFlags = (usage == D3D11_USAGE_DYNAMIC) ? D3D11_CPU_ACCESS_WRITE : 0;
+    if (FAILED(device->CreateTexture2D(&texDesc, nullptr, &t.texture)) ||
+        ((bindFlags & D3D11_BIND_RENDER_TARGET) &&
+         FAILED(device->CreateRenderTargetView(t.texture.Get(), nullptr, &t.rtv))) ||
+        ((bindFlags & D3D11_BIND_SHADER_RESOURCE) &&
+         FAILED(device->CreateShaderResourceView(t.texture.Get(), nullptr, &t.srv)))) {
+        t = Target{};
+        return false;
+    }
+    t.width     = width;
+    t.height    = height;
+    t.format    = format;
+    t.bindFlags = bindFlags;
+    t.usage     = usage;
+    return true;
+}
+
+void RenderTargetPool::Release(const Target* target) {
+    for (auto& entry : m_entries) {
+        if (&entry->target == target) {
+            entry->inUse = false;
+            return;
+        }
+    }
+}
+
+void RenderTargetPool::EndPlan() {
+    for (auto& entry : m_entries) {
+        if (!entry->planned) Recycle(std::move(entry->target));
+    }
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                                   [](const std::unique_ptr<Entry>& entry) { return !entry->planned; }),
+                    m_entries.end());
+}
+
+void RenderTargetPool::Clear() {
+    for (auto& entry : m_entries) Recycle(std::move(entry->target));
+    m_entries.clear();
+}
+
+bool RenderTargetPool::Take(ID3D11Device* device, int width, int height, DXGI_FORMAT format,
+                            UINT bindFlags, D3D11_USAGE usage, Target& out) {
+    // Newest first: the size just left is the likeliest to come back
+    for (auto it = m_recycled.rbegin(); it != m_recycled.rend(); ++it) {
+        const Target& t = it->target;
+        if (t.width == width && t.height == height && t.format == format &&
+            t.bindFlags == bindFlags && t.usage == usage) {
+            out = std::move(it->target);
+            m_recycledBytes -= TargetBytes(out);
+            m_recycled.erase(std::next(it).base());
+            ++m_reuses;
+            return true;
+        }
+    }
+    return Create(device, width, height, format, bindFlags, usage, out);
+}
+
+void RenderTargetPool::Recycle(Target&& target) {
+    if (!target.texture) return;
+    m_recycledBytes += TargetBytes(target);
+    m_recycled.push_back({std::move(target), std::chrono::steady_clock::now()});
+    target = Target{};
+    EvictOverBudget();
+}
+
+void RenderTargetPool::Trim() {
+    const auto cutoff = std::chrono::steady_clock::now() -
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(RECYCLE_SECONDS));
+    size_t expired = 0;
+    while (expired < m_recycled.size() && m_recycled[expired].since < cutoff) {
+        m_recycledBytes -= TargetBytes(m_recycled[expired].target);
+        ++expired;
+    }
+    if (expired > 0) m_recycled.erase(m_recycled.begin(), m_recycled.begin() + static_cast<ptrdiff_t>(expired));
+}
+
+void RenderTargetPool::SetRecycleBudget(size_t bytes) {
+    m_recycleBudget = bytes;
+    EvictOverBudget();
+}
+
+void RenderTargetPool::EvictOverBudget() {
+    size_t evicted = 0;
+    while (m_recycledBytes > m_recycleBudget && evicted < m_recycled.size()) {
+        m_recycledBytes -= TargetBytes(m_recycled[evicted].target);
+        ++evicted;
+    }
+    if (evicted > 0) m_recycled.erase(m_recycled.begin(), m_recycled.begin() + static_cast<ptrdiff_t>(evicted));
+}
+
+void RenderTargetPool::ClearRecycled() {
+    m_recycled.clear();
+    m_recycledBytes = 0;
+}
+
+size_t RenderTargetPool::GetUsedBytes() const {
+    size_t bytes = 0;
+    for (const auto& entry : m_entries) bytes += TargetBytes(entry->target);
+    return bytes;
+}
+
+} // namespace SP
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Common.h"
+#include <chrono>
+
+namespace SP {
+
+// Intermediate render targets for multi-pass presets, shared between passes by
+// lifetime: a target whose last reader has run goes back to the pool and the
+// next pass of the same size and format draws into it. Render thread only.
+//
+// Targets are planned once per graph and size (BeginPlan, Acquire/Release in
+// pass order, EndPlan); EndPlan drops the ones the plan no longer needs. The
+// plan keeps its own references, so the views stay valid until it is replaced.
+//
+// Dropped targets are not freed but recycled, along with the renderer's
+// standalone textures whose size follows the content (display, video,
+// compositor source, scaled target): Take hands back a recycled texture of the
+// same size, format, bind flags and usage before creating one, so switching
+// between clips or resolutions already seen allocates nothing. Recycled
+// textures are freed oldest first over the budget, and by Trim once unused for
+// RECYCLE_SECONDS.
+class RenderTargetPool {
+public:
+    static constexpr double RECYCLE_SECONDS        = 30.0;
+    static constexpr size_t DEFAULT_RECYCLE_BUDGET = size_t{256} << 20;
+
+    struct Target {
+        ComPtr<ID3D11Texture2D>          texture;
+        ComPtr<ID3D11RenderTargetView>   rtv;  // Only with D3D11_BIND_RENDER_TARGET
+        ComPtr<ID3D11ShaderResourceView> srv;
+        int width  = 0;
+        int height = 0;
+        DXGI_FORMAT format    = DXGI_FORMAT_UNKNOWN;
+        UINT        bindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+        D3D11_USAGE usage     = D3D11_USAGE_DEFAULT;  // DYNAMIC: written by the CPU (Map)
+    };
+
+    RenderTargetPool() = default;
+
+    // Non-copyable
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    // A standalone target outside the pool (persistent pass buffers)
+    static bool Create(ID3D11Device* device, int width, int height, DXGI_FORMAT format, Target& out);
+    static bool Create(ID3D11Device* device, int width, int height, DXGI_FORMAT format,
+                       UINT bindFlags, D3D11_USAGE usage, Target& out);
+
+    void BeginPlan();
+    // A free target of this size and format, or a new one; nullptr on failure
+    const Target* Acquire(ID3D11Device* device, int width, int height, DXGI_FORMAT format);
+    void Release(const Target* target);
+    void EndPlan();
+    // Drop the plan; its targets are recycled
+    void Clear();
+
+    // Recycling (see above). Recycle takes a standalone target the caller is done
+    // with; Take fills `out` with a recycled or new one, false on failure.
+    bool Take(ID3D11Device* device, int width, int height, DXGI_FORMAT format,
+              UINT bindFlags, D3D11_USAGE usage, Target& out);
+    void Recycle(Target&& target);
+    void Trim();  // Frees what has sat unused for RECYCLE_SECONDS; cheap, call every frame
+    void SetRecycleBudget(size_t bytes);
+    void ClearRecycled();
+
+    // Stats
+    int    GetTargetCount() const { return static_cast<int>(m_entries.size()); }
+    size_t GetUsedBytes() const;
+    int    GetRecycledCount() const { return static_cast<int>(m_recycled.size()); }
+    size_t GetRecycledBytes() const { return m_recycledBytes; }
+    int64_t GetReuses() const { return m_reuses; }
+
+private:
+    struct Entry {
+        Target target;
+        bool inUse   = false;  // Acquired and not yet released in this plan
+        bool planned = false;  // Acquired at least once in this plan
+    };
+    struct Recycled {
+        Target target;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    void EvictOverBudget();
+
+    std::vector<std::unique_ptr<Entry>> m_entries;  // Stable addresses for Release
+    std::vector<Recycled> m_recycled;               // Oldest first
+    size_t  m_recycledBytes = 0;
+    size_t  m_recycleBudget = DEFAULT_RECYCLE_BUDGET;
+    int64_t m_reuses        = 0;
+};
+
+} // namespace SP
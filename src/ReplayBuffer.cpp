@@ -0,0 +1,151 @@
+#include "ReplayBuffer.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace SP {
+
+ReplayBuffer::~ReplayBuffer() {
+    if (m_saveThread.joinable()) m_saveThread.join();
+    Clear();
+    avcodec_parameters_free(&m_params);
+}
+
+void ReplayBuffer::Reset(const AVCodecParameters* params, AVRational timeBase, double maxSeconds, size_t maxBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (AVPacket* packet : m_packets) av_packet_free(&packet);
+    m_packets.clear();
+    m_bytes = 0;
+
+    // A running save works on its own copy, so this one can be replaced
+    avcodec_parameters_free(&m_params);
+    m_params = avcodec_parameters_alloc();
+    if (m_params) avcodec_parameters_copy(m_params, params);
+    m_timeBase   = timeBase;
+    m_maxSeconds = maxSeconds;
+    m_maxBytes   = maxBytes;
+}
+
+void ReplayBuffer::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (AVPacket* packet : m_packets) av_packet_free(&packet);
+    m_packets.clear();
+    m_bytes = 0;
+}
+
+void ReplayBuffer::Push(const AVPacket* packet) {
+    AVPacket* ref = av_packet_clone(packet);
+    if (!ref) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Until the first keyframe nothing is decodable
+    if (m_packets.empty() && !(ref->flags & AV_PKT_FLAG_KEY)) {
+        av_packet_free(&ref);
+        return;
+    }
+    m_packets.push_back(ref);
+    m_bytes += static_cast<size_t>(ref->size);
+    TrimLocked();
+}
+
+void ReplayBuffer::TrimLocked() {
+    auto overBudget = [this] {
+        const double span = (m_packets.back()->pts - m_packets.front()->pts) * av_q2d(m_timeBase);
+        return m_bytes > m_maxBytes || span > m_maxSeconds;
+    };
+    while (m_packets.size() > 1 && overBudget()) {
+        // Whole GOPs only, and only when another keyframe follows to start from
+        size_t next = 1;
+        while (next < m_packets.size() && !(m_packets[next]->flags & AV_PKT_FLAG_KEY)) ++next;
+        if (next == m_packets.size()) break;
+        for (size_t i = 0; i < next; ++i) {
+            m_bytes -= static_cast<size_t>(m_packets.front()->size);
+            av_packet_free(&m_packets.front());
+            m_packets.pop_front();
+        }
+    }
+}
+
+bool ReplayBuffer::Save(const std::string& path) {
+    if (m_saving.load()) return false;
+    if (m_saveThread.joinable()) m_saveThread.join();
+
+    // Snapshot under the lock: new references, so the ring keeps moving
+    std::vector<AVPacket*> packets;
+    AVCodecParameters* params = avcodec_parameters_alloc();
+    AVRational timeBase;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_packets.empty() || !m_params || !params) {
+            avcodec_parameters_free(&params);
+            return false;
+        }
+        packets.reserve(m_packets.size());
+        for (const AVPacket* packet : m_packets) {
+            if (AVPacket* ref = av_packet_clone(packet)) packets.push_back(ref);
+        }
+        avcodec_parameters_copy(params, m_params);
+        timeBase = m_timeBase;
+    }
+
+    m_saving = true;
+    m_saveThread = std::thread([this, path, packets = std::move(packets), params, timeBase]() mutable {
+        m_lastSaveOk = Mux(path, packets, params, timeBase);
+        for (AVPacket* packet : packets) av_packet_free(&packet);
+        avcodec_parameters_free(&params);
+        m_saving = false;
+    });
+    return true;
+}
+
+/*static*/ bool ReplayBuffer::Mux(const std::string& path, std::vector<AVPacket*>& packets, const AVCodecParameters* params,
+                       AVRational timeBase) {
+    AVFormatContext* formatCtx = nullptr;
+    if (avformat_alloc_output_context2(&formatCtx, nullptr, nullptr, path.c_str()) < 0 || !formatCtx) return false;
+
+    AVStream* stream = avformat_new_stream(formatCtx, nullptr);
+    bool ok = stream && avcodec_parameters_copy(stream->codecpar, params) >= 0;
+    if (ok) {
+        stream->codecpar->codec_tag = 0;  // Let the muxer pick its own tag
+        stream->time_base = timeBase;
+        ok = (formatCtx->oformat->flags & AVFMT_NOFILE) ||
+             avio_open(&formatCtx->pb, path.c_str(), AVIO_FLAG_WRITE) >= 0;
+    }
+    const bool opened = ok && !(formatCtx->oformat->flags & AVFMT_NOFILE);
+    ok = ok && avformat_write_header(formatCtx, nullptr) >= 0;
+
+    if (ok) {
+        // The file starts at 0 from the first (key)frame kept
+        const AVPacket* first = packets.front();
+        const int64_t origin = (first->dts != AV_NOPTS_VALUE) ? first->dts : first->pts;
+        for (AVPacket* packet : packets) {
+            if (packet->pts != AV_NOPTS_VALUE) packet->pts -= origin;
+            if (packet->dts != AV_NOPTS_VALUE) packet->dts -= origin;
+            av_packet_rescale_ts(packet, timeBase, stream->time_base);
+            packet->stream_index = stream->index;
+            if (av_interleaved_write_frame(formatCtx, packet) < 0) {
+                ok = false;
+                break;
+            }
+        }
+        if (av_write_trailer(formatCtx) < 0) ok = false;
+    }
+
+    if (opened) avio_closep(&formatCtx->pb);
+    avformat_free_context(formatCtx);
+    return ok;
+}
+
+double ReplayBuffer::GetBufferedSeconds() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_packets.empty()) return 0.0;
+    return (m_packets.back()->pts - m_packets.front()->pts) * av_q2d(m_timeBase);
+}
+
+size_t ReplayBuffer::GetBufferedBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+} // namespace SP
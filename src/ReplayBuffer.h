@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Common.h"
+#include <deque>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace SP {
+
+// Instant replay: the encoded packets of the last few seconds, kept in memory
+// instead of written to a file. Compressed H.264 at 20 Mbps is ~150 MB a minute
+// where raw UHD frames would be ~2 GB, and nothing touches the disk until a save.
+//
+// The ring always starts at a keyframe: trimming (by bytes and by duration)
+// drops whole GOPs from the front. The encoder thread pushes; Save snapshots the
+// packets (references, no data copy) and muxes them to a new file on its own
+// thread, so neither the render thread nor the encoder waits on the disk.
+class ReplayBuffer {
+public:
+    ReplayBuffer() = default;
+    ~ReplayBuffer();
+
+    // Non-copyable
+    ReplayBuffer(const ReplayBuffer&) = delete;
+    ReplayBuffer& operator=(const ReplayBuffer&) = delete;
+
+    // Empties the ring and takes the stream's parameters for later saves
+    // (`timeBase` is the packets' time base).
+    void Reset(const AVCodecParameters* params, AVRational timeBase, double maxSeconds, size_t maxBytes);
+    void Clear();
+
+    // Encoder thread. Takes a new reference to the packet's data.
+    void Push(const AVPacket* packet);
+
+    // Writes the ring as it is now to `path` (container from the extension) in the
+    // background. False when a save is still running or there is nothing yet.
+    bool Save(const std::string& path);
+    bool IsSaving() const { return m_saving.load(); }
+    bool LastSaveSucceeded() const { return m_lastSaveOk.load(); }  // Once !IsSaving()
+
+    double GetBufferedSeconds() const;
+    size_t GetBufferedBytes() const;
+
+private:
+    void TrimLocked();  // Caller holds m_mutex
+    static bool Mux(const std::string& path, std::vector<AVPacket*>& packets, const AVCodecParameters* params,
+             AVRational timeBase);
+
+    mutable std::mutex m_mutex;
+    std::deque<AVPacket*> m_packets;  // Front is a keyframe
+    size_t m_bytes = 0;
+    AVCodecParameters* m_params = nullptr;
+    AVRational m_timeBase{1, 1};
+    double m_maxSeconds = 0.0;
+    size_t m_maxBytes = 0;
+
+    std::thread m_saveThread;
+    std::atomic<bool> m_saving{false};
+    std::atomic<bool> m_lastSaveOk{false};
+};
+
+} // namespace SP
@@ -0,0 +1,90 @@
+#include "ScrubCache.h"
+#include <algorithm>
+
+namespace SP {
+
+void ScrubCache::SetBudgetMB(int megabytes) {
+    m_budgetBytes = static_cast<size_t>(std::max(megabytes, 0)) * 1024 * 1024;
+    if (m_budgetBytes == 0) {
+        Clear();
+    } else if (EntryBytes() > 0) {
+        EvictToCapacity(m_budgetBytes / EntryBytes());
+    }
+}
+
+void ScrubCache::Store(ID3D11Device* device, ID3D11DeviceContext* context, int64_t key,
+                       ID3D11Texture2D* source, int width, int height, DXGI_FORMAT format) {
+    if (m_budgetBytes == 0 || !source || width <= 0 || height <= 0) return;
+
+    if (width != m_width || height != m_height || format != m_format) {
+        Clear();
+        m_width      = width;
+        m_height     = height;
+        m_format     = format;
+        m_pixelBytes = (format == DXGI_FORMAT_R16G16B16A16_UNORM) ? 8 : 4;
+    }
+
+    // Already cached (e.g. re-decoded after a miss elsewhere) — just promote it
+    if (auto found = m_lookup.find(key); found != m_lookup.end()) {
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+        return;
+    }
+
+    const size_t capacity = m_budgetBytes / EntryBytes();
+    if (capacity == 0) return;  // One frame exceeds the budget
+
+    // Recycle the LRU entry's texture instead of allocating once full
+    Entry entry;
+    EvictToCapacity(capacity);
+    if (m_entries.size() >= capacity) {
+        entry = std::move(m_entries.back());
+        m_lookup.erase(entry.key);
+        m_entries.pop_back();
+    }
+
+    if (!entry.texture) {
+        D3D11_TEXTURE2D_DESC desc = {};
+        desc.Width            = width;
+        desc.Height           = height;
+        desc.MipLevels        = 1;
+        desc.ArraySize        = 1;
+        desc.Format           = m_format;
+        desc.SampleDesc.Count = 1;
+        desc.Usage            = D3D11_USAGE_DEFAULT;
+        desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+        if (FAILED(device->CreateTexture2D(&desc, nullptr, &entry.texture))) return;
+        if (FAILED(device->CreateShaderResourceView(entry.texture.Get(), nullptr, &entry.srv))) return;
+    }
+
+    context->CopyResource(entry.texture.Get(), source);
+    entry.key = key;
+    m_entries.push_front(std::move(entry));
+    m_lookup[key] = m_entries.begin();
+}
+
+ID3D11ShaderResourceView* ScrubCache::Find(int64_t key) {
+    auto found = m_lookup.find(key);
+    if (found == m_lookup.end()) {
+        ++m_misses;
+        return nullptr;
+    }
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    return found->second->srv.Get();
+}
+
+void ScrubCache::Clear() {
+    m_entries.clear();
+    m_lookup.clear();
+    m_width  = 0;
+    m_height = 0;
+}
+
+void ScrubCache::EvictToCapacity(size_t capacity) {
+    while (m_entries.size() > capacity) {
+        m_lookup.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+}
+
+} // namespace SP
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Common.h"
+#include <list>
+
+namespace SP {
+
+// LRU cache of decoded video frames kept on the GPU, so scrubbing back and forth
+// over recently shown frames (and short loops) skips seek + decode entirely.
+// Entries are copies of the renderer's t0 video texture (RGBA8, or RGBA16 for
+// high-bit-depth sources) — the shader input, not its output — so shader edits
+// still apply to cached frames.
+//
+// Keys are frame numbers (see Application::FrameKey). Render thread only.
+class ScrubCache {
+public:
+    ScrubCache() = default;
+
+    // Non-copyable
+    ScrubCache(const ScrubCache&) = delete;
+    ScrubCache& operator=(const ScrubCache&) = delete;
+
+    // VRAM budget; shrinking evicts immediately, 0 disables the cache.
+    void SetBudgetMB(int megabytes);
+    int  GetBudgetMB() const { return static_cast<int>(m_budgetBytes / (1024 * 1024)); }
+
+    // GPU-copies `source` (width × height in `format`) under `key`, recycling the
+    // least recently used entry's texture once the budget is full. A size or
+    // format change clears the cache.
+    void Store(ID3D11Device* device, ID3D11DeviceContext* context, int64_t key,
+               ID3D11Texture2D* source, int width, int height, DXGI_FORMAT format);
+
+    // Counts a hit or miss and promotes the entry. The view stays valid while the
+    // caller holds a reference, even if the entry is evicted meanwhile.
+    ID3D11ShaderResourceView* Find(int64_t key);
+
+    void Clear();
+
+    // Stats
+    int     GetEntryCount() const { return static_cast<int>(m_entries.size()); }
+    size_t  GetUsedBytes() const { return m_entries.size() * EntryBytes(); }
+    int64_t GetHits() const { return m_hits; }
+    int64_t GetMisses() const { return m_misses; }
+    void    ResetStats() { m_hits = 0; m_misses = 0; }
+
+private:
+    struct Entry {
+        int64_t key = 0;
+        ComPtr<ID3D11Texture2D> texture;
+        ComPtr<ID3D11ShaderResourceView> srv;
+    };
+
+    size_t EntryBytes() const { return static_cast<size_t>(m_width) * m_height * m_pixelBytes; }
+    void   EvictToCapacity(size_t capacity);
+
+    std::list<Entry> m_entries;  // Front = most recently used
+    std::unordered_map<int64_t, std::list<Entry>::iterator> m_lookup;
+    int     m_width  = 0;
+    int     m_height = 0;
+    DXGI_FORMAT m_format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    int     m_pixelBytes = 4;
+    size_t  m_budgetBytes = 0;
+    int64_t m_hits   = 0;
+    int64_t m_misses = 0;
+};
+
+} // namespace SP
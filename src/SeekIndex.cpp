@@ -0,0 +1,208 @@
+#include "SeekIndex.h"
+#include "ThreadPriority.h"
+#include <algorithm>
+#include <fstream>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace SP {
+
+namespace {
+
+constexpr uint32_t CACHE_MAGIC   = 0x49535053;  // "SPSI"
+constexpr uint32_t CACHE_VERSION = 1;
+
+// Returns (and lazily creates) the seek_cache/ dir next to the exe.
+std::filesystem::path GetSeekCacheDir() {
+    char exePath[MAX_PATH];
+    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+    auto dir = std::filesystem::path(exePath).parent_path() / "seek_cache";
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    return dir;
+}
+
+} // namespace
+
+SeekIndex::~SeekIndex() {
+    Reset();
+}
+
+void SeekIndex::Build(const std::string& path, int streamIndex) {
+    Reset();
+    m_building = true;
+    m_thread = std::thread(&SeekIndex::BuildThread, this, path, streamIndex);
+}
+
+void SeekIndex::Reset() {
+    if (m_thread.joinable()) {
+        m_cancel = true;
+        m_thread.join();
+    }
+    m_cancel    = false;
+    m_ready     = false;
+    m_building  = false;
+    m_fromCache = false;
+    m_progress  = 0.0f;
+    m_framePts.clear();
+    m_keyframePts.clear();
+}
+
+int64_t SeekIndex::GetFramePts(int64_t frameNumber) const {
+    if (m_framePts.empty()) return 0;
+    frameNumber = std::clamp<int64_t>(frameNumber, 0, GetFrameCount() - 1);
+    return m_framePts[static_cast<size_t>(frameNumber)];
+}
+
+int64_t SeekIndex::FrameAtOrBefore(int64_t pts) const {
+    auto it = std::upper_bound(m_framePts.begin(), m_framePts.end(), pts);
+    if (it == m_framePts.begin()) return 0;
+    return static_cast<int64_t>(std::distance(m_framePts.begin(), it)) - 1;
+}
+
+int64_t SeekIndex::KeyframeAtOrBefore(int64_t pts) const {
+    auto it = std::upper_bound(m_keyframePts.begin(), m_keyframePts.end(), pts);
+    if (it == m_keyframePts.begin()) {
+        return m_keyframePts.empty() ? pts : m_keyframePts.front();
+    }
+    return *std::prev(it);
+}
+
+void SeekIndex::BuildThread(std::string path, int streamIndex) {
+    ThreadPriority::Apply(ThreadRole::Background);
+    const std::filesystem::path cachePath = GetCachePath(path, streamIndex);
+
+    if (!cachePath.empty() && LoadCache(cachePath)) {
+        m_fromCache = true;
+    } else if (ScanFile(path, streamIndex)) {
+        if (!cachePath.empty()) SaveCache(cachePath);
+    } else {
+        m_framePts.clear();
+        m_keyframePts.clear();
+        m_building = false;
+        return;
+    }
+
+    m_progress = 1.0f;
+    m_ready.store(true, std::memory_order_release);
+    m_building = false;
+}
+
+bool SeekIndex::ScanFile(const std::string& path, int streamIndex) {
+    AVFormatContext* fmt = nullptr;
+    if (avformat_open_input(&fmt, path.c_str(), nullptr, nullptr) < 0) return false;
+    if (avformat_find_stream_info(fmt, nullptr) < 0 ||
+        streamIndex < 0 || streamIndex >= static_cast<int>(fmt->nb_streams)) {
+        avformat_close_input(&fmt);
+        return false;
+    }
+
+    // Only the video stream's packet headers matter; let the demuxer skip the rest
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        if (static_cast<int>(i) != streamIndex) fmt->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    const int64_t fileSize = fmt->pb ? avio_size(fmt->pb) : 0;
+    AVPacket* pkt = av_packet_alloc();
+    bool ok = (pkt != nullptr);
+
+    while (ok && !m_cancel.load()) {
+        const int ret = av_read_frame(fmt, pkt);
+        if (ret == AVERROR_EOF) break;
+        if (ret < 0) { ok = false; break; }
+
+        if (pkt->stream_index == streamIndex) {
+            // Containers without B-frame reordering info (AVI, raw ES) only carry DTS
+            const int64_t pts = (pkt->pts != AV_NOPTS_VALUE) ? pkt->pts : pkt->dts;
+            if (pts != AV_NOPTS_VALUE) {
+                m_framePts.push_back(pts);
+                if (pkt->flags & AV_PKT_FLAG_KEY) m_keyframePts.push_back(pts);
+            }
+            if (fileSize > 0 && pkt->pos >= 0) {
+                m_progress = static_cast<float>(static_cast<double>(pkt->pos) / fileSize);
+            }
+        }
+        av_packet_unref(pkt);
+    }
+
+    av_packet_free(&pkt);
+    avformat_close_input(&fmt);
+    if (!ok || m_cancel.load() || m_framePts.empty()) return false;
+
+    // Packets arrive in decode order; lookups need presentation order
+    std::sort(m_framePts.begin(), m_framePts.end());
+    std::sort(m_keyframePts.begin(), m_keyframePts.end());
+    m_framePts.erase(std::unique(m_framePts.begin(), m_framePts.end()), m_framePts.end());
+    m_keyframePts.erase(std::unique(m_keyframePts.begin(), m_keyframePts.end()), m_keyframePts.end());
+    return true;
+}
+
+std::filesystem::path SeekIndex::GetCachePath(const std::string& path, int streamIndex) {
+    // Key on size + mtime as well as the path so a re-rendered file is re-indexed
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) return {};
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return {};
+
+    const int64_t stamp[3] = {
+        static_cast<int64_t>(size),
+        static_cast<int64_t>(mtime.time_since_epoch().count()),
+        streamIndex
+    };
+    uint64_t hash = Fnv1a64(path.c_str(), path.size());
+    hash = Fnv1a64(reinterpret_cast<const char*>(stamp), sizeof(stamp), hash);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.idx", static_cast<unsigned long long>(hash));
+    return GetSeekCacheDir() / name;
+}
+
+bool SeekIndex::LoadCache(const std::filesystem::path& cachePath) {
+    std::ifstream in(cachePath, std::ios::binary);
+    if (!in) return false;
+
+    uint32_t magic = 0, version = 0;
+    uint64_t frameCount = 0, keyCount = 0;
+    in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&frameCount), sizeof(frameCount));
+    in.read(reinterpret_cast<char*>(&keyCount), sizeof(keyCount));
+    if (!in || magic != CACHE_MAGIC || version != CACHE_VERSION ||
+        frameCount == 0 || keyCount > frameCount) {
+        return false;
+    }
+
+    m_framePts.resize(static_cast<size_t>(frameCount));
+    m_keyframePts.resize(static_cast<size_t>(keyCount));
+    in.read(reinterpret_cast<char*>(m_framePts.data()),
+            static_cast<std::streamsize>(frameCount * sizeof(int64_t)));
+    in.read(reinterpret_cast<char*>(m_keyframePts.data()),
+            static_cast<std::streamsize>(keyCount * sizeof(int64_t)));
+    if (!in) {
+        m_framePts.clear();
+        m_keyframePts.clear();
+        return false;
+    }
+    return true;
+}
+
+void SeekIndex::SaveCache(const std::filesystem::path& cachePath) const {
+    std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+    if (!out) return;
+
+    const uint64_t frameCount = m_framePts.size();
+    const uint64_t keyCount   = m_keyframePts.size();
+    out.write(reinterpret_cast<const char*>(&CACHE_MAGIC), sizeof(CACHE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+    out.write(reinterpret_cast<const char*>(&frameCount), sizeof(frameCount));
+    out.write(reinterpret_cast<const char*>(&keyCount), sizeof(keyCount));
+    out.write(reinterpret_cast<const char*>(m_framePts.data()),
+              static_cast<std::streamsize>(frameCount * sizeof(int64_t)));
+    out.write(reinterpret_cast<const char*>(m_keyframePts.data()),
+              static_cast<std::streamsize>(keyCount * sizeof(int64_t)));
+}
+
+} // namespace SP
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Per-file table of every video frame's PTS and every keyframe's PTS, in stream
+// time_base units. Built by demuxing (not decoding) the file on a worker thread
+// with its own AVFormatContext, so it never contends with VideoDecoder; cached
+// in seek_cache/ next to the exe, keyed by path + size + mtime.
+//
+// The tables are written only by the worker and published with m_ready, so the
+// lookups below are lock-free and valid from any thread once IsReady() is true.
+class SeekIndex {
+public:
+    SeekIndex() = default;
+    ~SeekIndex();
+
+    // Non-copyable
+    SeekIndex(const SeekIndex&) = delete;
+    SeekIndex& operator=(const SeekIndex&) = delete;
+
+    // Load from cache or start building for `path`'s stream `streamIndex`.
+    // Cancels any build in progress.
+    void Build(const std::string& path, int streamIndex);
+    // Cancel, join, and clear.
+    void Reset();
+
+    bool  IsReady() const { return m_ready.load(std::memory_order_acquire); }
+    bool  IsBuilding() const { return m_building.load(); }
+    bool  IsFromCache() const { return m_fromCache.load(); }
+    float GetProgress() const { return m_progress.load(); }  // [0,1] while building
+
+    // Valid only when IsReady()
+    int64_t GetFrameCount() const { return static_cast<int64_t>(m_framePts.size()); }
+    int64_t GetKeyframeCount() const { return static_cast<int64_t>(m_keyframePts.size()); }
+    int64_t GetFramePts(int64_t frameNumber) const;     // Clamped to the valid range
+    int64_t FrameAtOrBefore(int64_t pts) const;         // Frame number showing at `pts`
+    int64_t KeyframeAtOrBefore(int64_t pts) const;      // PTS of the keyframe to seek to
+
+private:
+    void BuildThread(std::string path, int streamIndex);
+    bool ScanFile(const std::string& path, int streamIndex);
+    static std::filesystem::path GetCachePath(const std::string& path, int streamIndex);
+    bool LoadCache(const std::filesystem::path& cachePath);
+    void SaveCache(const std::filesystem::path& cachePath) const;
+
+    std::thread m_thread;
+    std::atomic<bool>  m_cancel{false};
+    std::atomic<bool>  m_ready{false};
+    std::atomic<bool>  m_building{false};
+    std::atomic<bool>  m_fromCache{false};
+    std::atomic<float> m_progress{0.0f};
+
+    std::vector<int64_t> m_framePts;     // Sorted presentation timestamps
+    std::vector<int64_t> m_keyframePts;  // Sorted keyframe presentation timestamps
+};
+
+} // namespace SP
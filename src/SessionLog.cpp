@@ -0,0 +1,136 @@
+#include "SessionLog.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace SP {
+
+namespace {
+
+constexpr const char* TYPE_NAMES[static_cast<int>(SessionEventType::Count)] = {
+    "open", "preset", "params", "keyframes", "seek", "playback", "rate", "audio"
+};
+
+constexpr int SESSION_VERSION = 1;
+
+// {"avgMs", "p99Ms", "maxMs"} of a sample; reorders it
+nlohmann::json Summarize(std::vector<float>& samples) {
+    if (samples.empty()) return {{"avgMs", 0.0f}, {"p99Ms", 0.0f}, {"maxMs", 0.0f}};
+    double sum = 0.0;
+    for (float v : samples) sum += v;
+    const float maxMs  = *std::max_element(samples.begin(), samples.end());
+    const size_t rank  = static_cast<size_t>(std::ceil(0.99 * samples.size()));
+    const size_t index = std::clamp<size_t>(rank, 1, samples.size()) - 1;
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return {{"avgMs", static_cast<float>(sum / samples.size())}, {"p99Ms", samples[index]}, {"maxMs", maxMs}};
+}
+
+} // namespace
+
+const char* SessionLog::TypeName(SessionEventType type) {
+    return TYPE_NAMES[static_cast<int>(type)];
+}
+
+void SessionLog::Clear() {
+    m_events.clear();
+    m_duration = 0.0;
+    m_tickRate = 60.0;
+    m_cpu.clear();
+    m_gpu.clear();
+}
+
+void SessionLog::Add(double time, SessionEventType type, nlohmann::json data) {
+    m_events.push_back({time, type, std::move(data)});
+}
+
+void SessionLog::Finish(double seconds, int64_t ticks) {
+    m_duration = seconds;
+    if (seconds > 0.0 && ticks > 0) m_tickRate = ticks / seconds;
+}
+
+bool SessionLog::Save(const std::string& path, std::string& error) const {
+    nlohmann::json events = nlohmann::json::array();
+    for (const SessionEvent& event : m_events) {
+        events.push_back({{"t", event.time}, {"type", TypeName(event.type)}, {"data", event.data}});
+    }
+    const nlohmann::json session = {
+        {"version", SESSION_VERSION}, {"duration", m_duration}, {"tickRate", m_tickRate}, {"events", events}
+    };
+    std::ofstream file(path, std::ios::trunc);
+    file << session.dump(1) << "\n";
+    if (!file) {
+        error = "Failed to write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool SessionLog::Load(const std::string& path, std::string& error) {
+    Clear();
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "Failed to open session: " + path;
+        return false;
+    }
+    try {
+        const nlohmann::json session = nlohmann::json::parse(file);
+        m_duration = session.value("duration", 0.0);
+        m_tickRate = session.value("tickRate", m_tickRate);
+        for (const auto& entry : session.at("events")) {
+            const std::string name = entry.at("type").get<std::string>();
+            const auto* found = std::find_if(std::begin(TYPE_NAMES), std::end(TYPE_NAMES),
+                                             [&](const char* typeName) { return name == typeName; });
+            if (found == std::end(TYPE_NAMES)) continue;  // From a newer build
+            Add(entry.at("t").get<double>(), static_cast<SessionEventType>(found - std::begin(TYPE_NAMES)),
+                entry.value("data", nlohmann::json::object()));
+        }
+    } catch (const std::exception& e) {
+        error = std::string("Invalid session file: ") + e.what();
+        return false;
+    }
+    if (m_tickRate <= 0.0) {
+        error = "Session file needs a positive \"tickRate\"";
+        return false;
+    }
+    std::stable_sort(m_events.begin(), m_events.end(),
+                     [](const SessionEvent& a, const SessionEvent& b) { return a.time < b.time; });
+    if (!m_events.empty()) m_duration = std::max(m_duration, m_events.back().time);
+    return true;
+}
+
+bool SessionLog::WriteReport(const std::string& path, double wallSeconds, int failedEvents, std::string& error) const {
+    std::vector<float> samples;
+    samples.reserve(std::max(m_cpu.size(), m_gpu.size()));
+
+    for (const CpuFrameTiming& timing : m_cpu) samples.push_back(timing.frameMs);
+    nlohmann::json cpu = {{"frame", Summarize(samples)}};
+    for (int stage = 0; stage < CPU_STAGE_COUNT; ++stage) {
+        samples.clear();
+        for (const CpuFrameTiming& timing : m_cpu) samples.push_back(timing.ms[stage]);
+        cpu[CpuProfiler::StageName(static_cast<CpuStage>(stage))] = Summarize(samples);
+    }
+
+    samples.clear();
+    for (const GpuFrameTiming& timing : m_gpu) samples.push_back(timing.totalMs);
+    nlohmann::json gpu = {{"frame", Summarize(samples)}};
+    for (int stage = 0; stage < GPU_STAGE_COUNT; ++stage) {
+        samples.clear();
+        for (const GpuFrameTiming& timing : m_gpu) samples.push_back(timing.ms[stage]);
+        gpu[GpuProfiler::StageName(static_cast<GpuStage>(stage))] = Summarize(samples);
+    }
+
+    const nlohmann::json report = {
+        {"sessionSeconds", m_duration}, {"tickRate", m_tickRate}, {"wallSeconds", wallSeconds},
+        {"ticks", m_cpu.size()}, {"gpuFrames", m_gpu.size()}, {"failedEvents", failedEvents},
+        {"cpu", cpu}, {"gpu", gpu}
+    };
+    std::ofstream file(path, std::ios::trunc);
+    file << report.dump(2) << "\n";
+    if (!file) {
+        error = "Failed to write " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace SP
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Common.h"
+#include "CpuProfiler.h"
+#include "GpuProfiler.h"
+#include <nlohmann/json.hpp>
+
+namespace SP {
+
+// What a session event changes. Its data, per type: Open {"path"}, Preset
+// {"filepath", "name"} (both empty = passthrough), Params {"paramValues",
+// "blendMode", "blendAmount"} and Keyframes {"keyframes"} (ConfigManager's
+// preset JSON), Seek {"time"}, Playback {"state": "playing"|"paused"|"stopped"},
+// Rate {"rate"}, Audio {"beatSensitivity", "beatDecay", "smoothing", "fftSize",
+// "multiResolution", "logSpectrum", "volume", "mute"}.
+enum class SessionEventType { Open, Preset, Params, Keyframes, Seek, Playback, Rate, Audio, Count };
+
+struct SessionEvent {
+    double time = 0.0;  // Seconds since recording started
+    SessionEventType type = SessionEventType::Open;
+    nlohmann::json data;
+};
+
+// A recorded session: the state when recording started (as events at time 0),
+// then every user action, timestamped. Application records it (Ctrl+R) and
+// replays it (ShaderPlayer --replay <file>) on a fixed clock that steps
+// 1/tickRate per tick, so two builds or GPUs draw the same frames with the same
+// inputs. The replay's CPU and GPU frame timings are kept here for its report.
+class SessionLog {
+public:
+    static const char* TypeName(SessionEventType type);
+
+    void Clear();
+    void Add(double time, SessionEventType type, nlohmann::json data);
+    // Length and tick count of the recording; the replay steps at their ratio
+    void Finish(double seconds, int64_t ticks);
+    bool Save(const std::string& path, std::string& error) const;
+    // False with `error` set on a missing or malformed file
+    bool Load(const std::string& path, std::string& error);
+
+    const std::vector<SessionEvent>& GetEvents() const { return m_events; }
+    double GetDuration() const { return m_duration; }
+    double GetTickRate() const { return m_tickRate; }
+
+    // Replay samples: ticks and resolved GPU frames while the fixed clock ran
+    void AddCpu(const CpuFrameTiming& timing) { m_cpu.push_back(timing); }
+    void AddGpu(const GpuFrameTiming& timing) { m_gpu.push_back(timing); }
+    // Mean / p99 / max of the frame and of every CPU and GPU stage
+    bool WriteReport(const std::string& path, double wallSeconds, int failedEvents, std::string& error) const;
+
+private:
+    std::vector<SessionEvent> m_events;
+    double m_duration = 0.0;
+    double m_tickRate = 60.0;
+
+    std::vector<CpuFrameTiming> m_cpu;
+    std::vector<GpuFrameTiming> m_gpu;
+};
+
+} // namespace SP
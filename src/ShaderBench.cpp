@@ -0,0 +1,288 @@
+#include "ShaderBench.h"
+#include "BenchHistory.h"
+#include "D3D11Renderer.h"
+#include "ShaderManager.h"
+#include "VideoDecoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+
+namespace SP {
+
+namespace {
+
+// BeginFrame's offscreen stand-in for the back buffer; nothing is drawn to it
+constexpr int HEADLESS_TARGET_SIZE = 64;
+// Frames submitted ahead of the GPU. Under GpuProfiler::FRAME_LATENCY, so every
+// frame's queries are done by the time its slot comes round again.
+constexpr int FRAMES_IN_FLIGHT = 2;
+// Uniform clock step: a 60 Hz playback
+constexpr double FRAME_TIME = 1.0 / 60.0;
+
+std::string Narrow(const wchar_t* text) {
+    const int size = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    if (size <= 1) return {};
+    std::string out(static_cast<size_t>(size - 1), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, out.data(), size, nullptr, nullptr);
+    return out;
+}
+
+void DescribeAdapter(ID3D11Device* device, std::string& outName, std::string& outDriver) {
+    ComPtr<IDXGIDevice>  dxgiDevice;
+    ComPtr<IDXGIAdapter> adapter;
+    if (FAILED(device->QueryInterface(IID_PPV_ARGS(&dxgiDevice))) || FAILED(dxgiDevice->GetAdapter(&adapter))) return;
+    DXGI_ADAPTER_DESC desc = {};
+    if (SUCCEEDED(adapter->GetDesc(&desc))) outName = Narrow(desc.Description);
+    LARGE_INTEGER umd = {};
+    if (SUCCEEDED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umd))) {
+        char version[32];
+        std::snprintf(version, sizeof(version), "%u.%u.%u.%u",
+                      HIWORD(umd.HighPart), LOWORD(umd.HighPart), HIWORD(umd.LowPart), LOWORD(umd.LowPart));
+        outDriver = version;
+    }
+}
+
+// Diagonal RGB gradient: every texel differs, so no shader gets a constant input
+VideoFrame MakeSyntheticFrame(int width, int height) {
+    auto pixels = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = pixels->data() + static_cast<size_t>(y) * width * 4;
+        for (int x = 0; x < width; ++x) {
+            row[x * 4 + 0] = static_cast<uint8_t>(x * 255 / std::max(width - 1, 1));
+            row[x * 4 + 1] = static_cast<uint8_t>(y * 255 / std::max(height - 1, 1));
+            row[x * 4 + 2] = static_cast<uint8_t>((x + y) & 0xFF);
+            row[x * 4 + 3] = 255;
+        }
+    }
+    VideoFrame frame;
+    frame.width       = width;
+    frame.height      = height;
+    frame.format      = AV_PIX_FMT_RGBA;
+    frame.pts         = 0;
+    frame.timestamp   = 0.0;
+    frame.layout      = FrameLayout::RGBA8;
+    frame.data[0]     = pixels->data();
+    frame.linesize[0] = width * 4;
+    frame.buffer      = std::move(pixels);
+    return frame;
+}
+
+// Nearest-rank percentile of an unsorted sample
+float Percentile(std::vector<float> samples, double fraction) {
+    if (samples.empty()) return 0.0f;
+    const size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+    const size_t index = std::clamp<size_t>(rank, 1, samples.size()) - 1;
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+} // namespace
+
+bool ShaderBench::Run(std::string& error) {
+    m_results.clear();
+
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(m_options.shaderDirectory, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".hlsl") files.push_back(entry.path().string());
+    }
+    if (files.empty()) {
+        error = "No .hlsl shaders in " + m_options.shaderDirectory;
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+
+    D3D11Renderer renderer;
+    renderer.SetPreferredAdapter(m_options.adapter);
+    if (!renderer.Initialize(nullptr, HEADLESS_TARGET_SIZE, HEADLESS_TARGET_SIZE)) {
+        error = "Failed to create a D3D11 device";
+        return false;
+    }
+    DescribeAdapter(renderer.GetDevice(), m_adapter, m_driverVersion);
+    const NoiseSettings noise;
+    renderer.UpdateNoiseTexture(noise.scale, noise.textureSize, noise.volumeSize);
+
+    ShaderManager shaders(renderer);
+    shaders.SetIncludeDirectory(m_options.shaderDirectory);
+    for (const std::string& file : files) {
+        ShaderPreset preset;
+        if (!shaders.LoadShaderMetadataFromFile(file, preset)) {
+            std::fprintf(stderr, "%s: %s\n", file.c_str(), preset.compileError.c_str());
+            continue;
+        }
+        shaders.AddPreset(preset);
+    }
+
+    VideoDecoder decoder;
+    if (!m_options.input.empty()) {
+        decoder.SetHardwareDevice(renderer.GetDevice());
+        decoder.SetGpuYuvConversion(true);
+        if (!decoder.Open(m_options.input)) {
+            error = "Failed to open " + m_options.input;
+            return false;
+        }
+    }
+
+    ID3D11DeviceContext* context = renderer.GetContext();
+    GpuProfiler& profiler = renderer.GetGpuProfiler();
+    ComPtr<ID3D11Query> fences[FRAMES_IN_FLIGHT];
+    D3D11_QUERY_DESC fenceDesc = {};
+    fenceDesc.Query = D3D11_QUERY_EVENT;
+    for (auto& fence : fences) {
+        if (FAILED(renderer.GetDevice()->CreateQuery(&fenceDesc, &fence))) {
+            error = "Failed to create a GPU fence";
+            return false;
+        }
+    }
+    int64_t submitted = 0;
+    // Waits for the frame FRAMES_IN_FLIGHT back, then ends this one's fence
+    auto throttle = [&] {
+        ID3D11Query* fence = fences[submitted % FRAMES_IN_FLIGHT].Get();
+        if (submitted >= FRAMES_IN_FLIGHT) {
+            BOOL done = FALSE;
+            while (context->GetData(fence, &done, sizeof(done), 0) == S_FALSE) std::this_thread::yield();
+        }
+        context->End(fence);
+        context->Flush();
+        ++submitted;
+    };
+
+    VideoFrame frame;
+    double time = 0.0;
+    // Next frame of the real input at the bench size, looping at the end
+    auto uploadInput = [&](const BenchResolution& resolution) {
+        if (!decoder.DecodeNextFrame(frame)) {
+            decoder.SeekToTime(0.0);
+            if (!decoder.DecodeNextFrame(frame)) return;
+        }
+        frame.outputWidth  = resolution.width;   // The GPU YUV pass scales; RGBA frames keep their size
+        frame.outputHeight = resolution.height;
+        renderer.UploadVideoFrame(frame);
+    };
+
+    float packed[16] = {};
+    for (const BenchResolution& resolution : m_options.resolutions) {
+        renderer.SetGenerativeResolution(resolution.width, resolution.height);
+        if (m_options.input.empty()) renderer.UploadVideoFrame(MakeSyntheticFrame(resolution.width, resolution.height));
+        else                         uploadInput(resolution);
+
+        for (int index = 0; index < shaders.GetPresetCount(); ++index) {
+            shaders.SetActivePreset(index);
+            ShaderPreset& preset = *shaders.GetActivePreset();
+
+            BenchResult result;
+            result.shader     = std::filesystem::path(preset.filepath).filename().string();
+            result.resolution = resolution.name;
+            result.ok         = preset.isValid;
+            result.error      = preset.compileError;
+            result.cost       = preset.cost;
+            if (!preset.isValid) {
+                m_results.push_back(std::move(result));
+                continue;
+            }
+            ShaderManager::PackParamValues(preset, packed);
+            renderer.SetCustomUniforms(packed, 16);
+            float extended[MAX_EXTENDED_PARAM_FLOATS];
+            renderer.SetExtendedParams(extended, ShaderManager::PackExtendedParams(preset, extended));
+            renderer.SetVideoBlend(preset.blendMode, preset.blendAmount);
+            renderer.SetAudioData(nullptr);
+
+            int64_t firstTimed = 0;
+            const int total = m_options.warmupFrames + m_options.frames;
+            for (int n = 0; n < total; ++n) {
+                if (n == m_options.warmupFrames) firstTimed = profiler.GetFrameCount();
+                profiler.BeginFrame();
+                if (!m_options.input.empty()) uploadInput(resolution);
+                renderer.SetShaderTime(static_cast<float>(time));
+                time += FRAME_TIME;
+                renderer.InvalidateDisplay();
+                renderer.BeginFrame();
+                renderer.RenderToDisplay();
+                profiler.EndFrame();
+                throttle();
+            }
+            // Empty frames until the timed ones have all resolved
+            for (int n = 0; n <= GpuProfiler::FRAME_LATENCY; ++n) {
+                profiler.BeginFrame();
+                profiler.EndFrame();
+                throttle();
+            }
+
+            std::vector<GpuFrameTiming> timings;
+            profiler.GetFramesSince(firstTimed, timings);
+            std::vector<float> samples;
+            for (const GpuFrameTiming& timing : timings) {
+                if (timing.frame >= firstTimed + m_options.frames) break;
+                samples.push_back(timing.ms[static_cast<size_t>(GpuStage::Shader)]);
+            }
+            double sum = 0.0;
+            for (float ms : samples) sum += ms;
+            result.width  = renderer.GetDisplayWidth();
+            result.height = renderer.GetDisplayHeight();
+            result.frames = static_cast<int>(samples.size());
+            result.meanMs = samples.empty() ? 0.0f : static_cast<float>(sum / samples.size());
+            result.p99Ms  = Percentile(samples, 0.99);
+            result.maxMs  = samples.empty() ? 0.0f : *std::max_element(samples.begin(), samples.end());
+            result.videoMemoryMB = renderer.QueryVideoMemory().localUsage / (1024.0 * 1024.0);
+            std::printf("%-32s %-6s %8.3f ms mean %8.3f ms p99 (%d frames)\n", result.shader.c_str(),
+                        result.resolution.c_str(), result.meanMs, result.p99Ms, result.frames);
+            std::fflush(stdout);
+            m_results.push_back(std::move(result));
+        }
+    }
+    return true;
+}
+
+nlohmann::json ShaderBench::MakeReport() const {
+    nlohmann::json results = nlohmann::json::array();
+    for (const BenchResult& r : m_results) {
+        nlohmann::json entry = {
+            {"shader", r.shader}, {"resolution", r.resolution}, {"width", r.width}, {"height", r.height},
+            {"ok", r.ok}, {"frames", r.frames}, {"meanMs", r.meanMs}, {"p99Ms", r.p99Ms}, {"maxMs", r.maxMs},
+            {"videoMemoryMB", r.videoMemoryMB},
+            {"instructions", r.cost.instructions}, {"textureSamples", r.cost.textureSamples},
+            {"flowControl", r.cost.flowControl}, {"tempRegisters", r.cost.tempRegisters}
+        };
+        if (!r.ok) entry["error"] = r.error;
+        results.push_back(std::move(entry));
+    }
+    return {
+        {"adapter", m_adapter}, {"driverVersion", m_driverVersion},
+        {"input", m_options.input.empty() ? std::string("synthetic") : m_options.input},
+        {"frames", m_options.frames}, {"warmupFrames", m_options.warmupFrames}, {"results", results}
+    };
+}
+
+bool ShaderBench::WriteJson(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    file << MakeReport().dump(2) << "\n";
+    return static_cast<bool>(file);
+}
+
+bool ShaderBench::AppendHistory(const std::string& path, std::string& error) const {
+    return BenchHistory::Append(path, "shader", m_options.label, BenchHistory::DescribeMachine(m_adapter),
+                                MakeReport(), error);
+}
+
+bool ShaderBench::WriteCsv(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    file << "shader,resolution,width,height,ok,frames,mean_ms,p99_ms,max_ms,video_memory_mb,instructions,texture_samples,"
+            "flow_control,temp_registers,adapter,driver\n";
+    for (const BenchResult& r : m_results) {
+        char times[128];
+        std::snprintf(times, sizeof(times), "%.4f,%.4f,%.4f,%.1f", r.meanMs, r.p99Ms, r.maxMs, r.videoMemoryMB);
+        file << '"' << r.shader << "\"," << r.resolution << ',' << r.width << ',' << r.height << ','
+             << (r.ok ? 1 : 0) << ',' << r.frames << ',' << times << ',' << r.cost.instructions << ','
+             << r.cost.textureSamples << ',' << r.cost.flowControl << ',' << r.cost.tempRegisters << ",\""
+             << m_adapter << "\"," << m_driverVersion << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+} // namespace SP
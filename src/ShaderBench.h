@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Common.h"
+#include <nlohmann/json.hpp>
+
+namespace SP {
+
+struct BenchResolution {
+    std::string name;  // "1080p", ...
+    int width  = 0;
+    int height = 0;
+};
+
+struct BenchOptions {
+    std::string shaderDirectory = "default_shaders";
+    std::string input;              // Video file looped as t0; empty = synthetic gradient
+    std::string adapter;            // D3D11Renderer::ListAdapters name; empty = high performance
+    std::vector<BenchResolution> resolutions = {
+        {"1080p", 1920, 1080}, {"1440p", 2560, 1440}, {"4K", 3840, 2160}};
+    int frames       = 300;         // Timed per shader and resolution
+    int warmupFrames = 30;          // Drawn first, not timed (compile, target allocation, clocks)
+    std::string jsonPath;           // Empty = not written
+    std::string csvPath;
+    std::string historyPath;        // BenchHistory store the run is appended to; empty = none
+    std::string label;              // Names the run in the history
+};
+
+// One shader at one resolution. Times are the GpuStage::Shader interval: every
+// pass, kernel and the frame-history push, without upload or display.
+struct BenchResult {
+    std::string shader;      // File name
+    std::string resolution;  // BenchResolution::name
+    int   width  = 0;        // Rendered size (a real input that can't be GPU-scaled keeps its own)
+    int   height = 0;
+    bool  ok     = false;
+    std::string error;       // Compile error when !ok
+    int   frames = 0;        // Timed frames that resolved
+    float meanMs = 0.0f;
+    float p99Ms  = 0.0f;
+    float maxMs  = 0.0f;
+    double videoMemoryMB = 0.0;  // Local video memory in use after the timed frames
+    ShaderCost cost;         // Static estimate, for reference
+};
+
+// Headless GPU benchmark behind ShaderPlayerBench. Loads every .hlsl preset of a
+// directory into one ShaderManager on a headless device (as ShaderPlayerCLI does),
+// then per resolution and preset draws warm-up plus timed frames with default
+// parameter values, timed by the renderer's GpuProfiler. Idle elision is defeated
+// (InvalidateDisplay) and at most two frames are in flight, so no frame's queries
+// are dropped. The report carries the adapter and driver version so runs can be
+// diffed across drivers.
+class ShaderBench {
+public:
+    explicit ShaderBench(BenchOptions options) : m_options(std::move(options)) {}
+
+    // Non-copyable
+    ShaderBench(const ShaderBench&) = delete;
+    ShaderBench& operator=(const ShaderBench&) = delete;
+
+    // False with `error` set when nothing could run (no device, no shaders, bad input)
+    bool Run(std::string& error);
+    const std::vector<BenchResult>& GetResults() const { return m_results; }
+
+    bool WriteJson(const std::string& path) const;
+    bool WriteCsv(const std::string& path) const;
+    bool AppendHistory(const std::string& path, std::string& error) const;
+
+private:
+    nlohmann::json MakeReport() const;
+
+    BenchOptions m_options;
+    std::vector<BenchResult> m_results;
+    std::string m_adapter;        // DXGI adapter description
+    std::string m_driverVersion;  // a.b.c.d of the user-mode driver
+};
+
+} // namespace SP
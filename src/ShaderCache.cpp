@@ -0,0 +1,309 @@
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace SP {
+
+namespace {
+
+constexpr uint32_t PACK_MAGIC   = 0x43535053;  // "SPSC"
+constexpr uint32_t PACK_VERSION = 1;
+
+struct PackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+// Followed by `size` bytes of bytecode, padded to 8
+struct PackRecord {
+    uint64_t key;
+    uint64_t checksum;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+// Shared tier: one file per blob, a SharedHeader then the bytecode
+constexpr uint32_t SHARED_MAGIC   = 0x42535053;  // "SPSB"
+constexpr uint32_t SHARED_VERSION = 1;
+
+struct SharedHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t checksum;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+constexpr size_t Padded(size_t size) { return (size + 7) & ~size_t(7); }
+
+uint64_t Checksum(const char* data, size_t size) { return Fnv1a64(data, size); }
+
+// The d3dcompiler DLL actually loaded, by its contents (a few MB, read once):
+// they change with every Windows or SDK update that ships a new compiler, and
+// are the same on every machine with that compiler wherever it is installed
+uint64_t CompilerIdentity() {
+    uint64_t hash = Fnv1a64(reinterpret_cast<const char*>(&PACK_VERSION), sizeof(PACK_VERSION));
+    const int headerVersion = D3D_COMPILER_VERSION;
+    hash = Fnv1a64(reinterpret_cast<const char*>(&headerVersion), sizeof(headerVersion), hash);
+
+    HMODULE module = GetModuleHandleW(D3DCOMPILER_DLL_W);
+    wchar_t path[MAX_PATH] = {};
+    if (!module || !GetModuleFileNameW(module, path, MAX_PATH)) return hash;
+    std::ifstream dll(path, std::ios::binary);
+    const std::vector<char> contents((std::istreambuf_iterator<char>(dll)), std::istreambuf_iterator<char>());
+    return Fnv1a64(contents.data(), contents.size(), hash);
+}
+
+std::filesystem::path SharedBlobPath(const std::filesystem::path& directory, uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.dxbc", static_cast<unsigned long long>(key));
+    return directory / name;
+}
+
+} // namespace
+
+void ShaderBytecodeCache::Open(const std::filesystem::path& packPath, const std::filesystem::path& sharedDirectory) {
+    Close();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_path = packPath;
+    m_compilerHash = CompilerIdentity();
+
+    // Checked once: an unreachable share would otherwise cost a network timeout per miss
+    std::error_code sharedError;
+    if (!sharedDirectory.empty() && std::filesystem::is_directory(sharedDirectory, sharedError)) {
+        m_sharedDirectory = sharedDirectory;
+    }
+
+    std::error_code ec;
+    if (!std::filesystem::exists(packPath, ec)) {
+        // First run with the pack: the one-file-per-blob cache it replaces goes
+        std::filesystem::create_directories(packPath.parent_path(), ec);
+        for (const auto& file : std::filesystem::directory_iterator(packPath.parent_path(), ec)) {
+            if (file.path().extension() == ".blob") std::filesystem::remove(file.path(), ec);
+        }
+        return;
+    }
+
+    m_file = CreateFileW(packPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize = {};
+    if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &fileSize) ||
+        fileSize.QuadPart < static_cast<LONGLONG>(sizeof(PackHeader))) {
+        Unmap();
+        return;
+    }
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping) m_view = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_view) {
+        Unmap();
+        return;
+    }
+
+    // Index the records; the pack is written most recently used first
+    const size_t size = static_cast<size_t>(fileSize.QuadPart);
+    PackHeader header;
+    std::memcpy(&header, m_view, sizeof(header));
+    if (header.magic != PACK_MAGIC || header.version != PACK_VERSION) {
+        Unmap();
+        m_dirty = true;  // Replace it on Close
+        return;
+    }
+    size_t offset = sizeof(PackHeader);
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        PackRecord record;
+        if (size - offset < sizeof(record)) break;
+        std::memcpy(&record, m_view + offset, sizeof(record));
+        offset += sizeof(record);
+        if (size - offset < record.size) break;
+
+        Entry& entry   = m_entries[record.key];
+        entry.mapped   = m_view + offset;
+        entry.size     = record.size;
+        entry.checksum = record.checksum;
+        entry.lastUse  = header.entryCount - i;
+        offset += std::min(Padded(record.size), size - offset);
+    }
+    m_useClock = header.entryCount;
+}
+
+void ShaderBytecodeCache::Close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_dirty && !m_path.empty()) WritePack();
+    Unmap();
+    m_path.clear();
+    m_sharedDirectory.clear();
+    m_entries.clear();
+    m_useClock = 0;
+    m_dirty    = false;
+}
+
+uint64_t ShaderBytecodeCache::MakeKey(const std::string& source, const char* target, UINT flags,
+                                      uint64_t includesHash) const {
+    uint64_t hash = Fnv1a64(source.data(), source.size(), m_compilerHash);
+    hash = Fnv1a64(target, std::strlen(target), hash);
+    hash = Fnv1a64(reinterpret_cast<const char*>(&flags), sizeof(flags), hash);
+    // Keys of sources without includes are unchanged
+    return includesHash ? Fnv1a64(reinterpret_cast<const char*>(&includesHash), sizeof(includesHash), hash) : hash;
+}
+
+bool ShaderBytecodeCache::Load(uint64_t key, std::vector<char>& outBytecode) {
+    std::filesystem::path shared;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            Entry& entry = it->second;
+            const char* data = entry.mapped ? entry.mapped : entry.owned.data();
+            if (Checksum(data, entry.size) == entry.checksum) {
+                outBytecode.assign(data, data + entry.size);
+                entry.lastUse = ++m_useClock;
+                return true;
+            }
+            m_entries.erase(it);
+            m_dirty = true;
+        }
+        shared = m_sharedDirectory;
+    }
+
+    // Second tier; kept in the pack so the next start doesn't go to the share
+    if (shared.empty() || !ReadShared(shared, key, outBytecode)) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Insert(key, outBytecode);
+    return true;
+}
+
+void ShaderBytecodeCache::Store(uint64_t key, const std::vector<char>& bytecode) {
+    std::filesystem::path shared;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_path.empty()) return;  // Not open
+        Insert(key, bytecode);
+        shared = m_sharedDirectory;
+    }
+    if (!shared.empty()) PublishShared(shared, key, bytecode);
+}
+
+void ShaderBytecodeCache::Insert(uint64_t key, const std::vector<char>& bytecode) {
+    Entry& entry   = m_entries[key];
+    entry.mapped   = nullptr;
+    entry.owned    = bytecode;
+    entry.size     = static_cast<uint32_t>(bytecode.size());
+    entry.checksum = Checksum(bytecode.data(), bytecode.size());
+    entry.lastUse  = ++m_useClock;
+    m_dirty = true;
+}
+
+size_t ShaderBytecodeCache::GetBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = 0;
+    for (const auto& [key, entry] : m_entries) bytes += entry.size;
+    return bytes;
+}
+
+/*static*/ bool ShaderBytecodeCache::ReadShared(const std::filesystem::path& directory, uint64_t key,
+                                                std::vector<char>& outBytecode) {
+    std::ifstream in(SharedBlobPath(directory, key), std::ios::binary);
+    SharedHeader header = {};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != SHARED_MAGIC ||
+        header.version != SHARED_VERSION || header.size > MAX_BYTES) {
+        return false;
+    }
+    std::vector<char> bytecode(header.size);
+    if (!in.read(bytecode.data(), header.size) || Checksum(bytecode.data(), bytecode.size()) != header.checksum) {
+        return false;
+    }
+    outBytecode = std::move(bytecode);
+    return true;
+}
+
+// Written under a name unique to this machine, process and thread, then renamed
+// without replacing: an existing blob is another machine's identical compile
+/*static*/ void ShaderBytecodeCache::PublishShared(const std::filesystem::path& directory, uint64_t key,
+                                                   const std::vector<char>& bytecode) {
+    const std::filesystem::path path = SharedBlobPath(directory, key);
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) return;
+
+    wchar_t computer[MAX_COMPUTERNAME_LENGTH + 1] = {};
+    DWORD computerLength = MAX_COMPUTERNAME_LENGTH + 1;
+    GetComputerNameW(computer, &computerLength);
+    std::filesystem::path tempPath = path;
+    tempPath += L".tmp_" + std::wstring(computer) + L"_" + std::to_wstring(GetCurrentProcessId()) + L"_" +
+                std::to_wstring(GetCurrentThreadId());
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        const SharedHeader header{SHARED_MAGIC, SHARED_VERSION, Checksum(bytecode.data(), bytecode.size()),
+                                  static_cast<uint32_t>(bytecode.size()), 0};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(bytecode.data(), static_cast<std::streamsize>(bytecode.size()));
+        if (!out) {
+            out.close();
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+    }
+    if (!MoveFileExW(tempPath.c_str(), path.c_str(), 0)) std::filesystem::remove(tempPath, ec);
+}
+
+void ShaderBytecodeCache::Unmap() {
+    if (m_view) UnmapViewOfFile(m_view);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+    m_view    = nullptr;
+    m_mapping = nullptr;
+    m_file    = INVALID_HANDLE_VALUE;
+}
+
+// Written aside (entries still point into the old mapping), then swapped in
+// once that is unmapped. Another instance holding the pack open makes the swap
+// fail; this session's additions are then lost, not the pack.
+void ShaderBytecodeCache::WritePack() {
+    std::vector<std::pair<uint64_t, const Entry*>> order;
+    order.reserve(m_entries.size());
+    for (const auto& [key, entry] : m_entries) order.emplace_back(key, &entry);
+    std::sort(order.begin(), order.end(),
+              [](const auto& a, const auto& b) { return a.second->lastUse > b.second->lastUse; });
+
+    uint64_t total = sizeof(PackHeader);
+    size_t kept = 0;
+    while (kept < order.size()) {
+        const uint64_t bytes = sizeof(PackRecord) + Padded(order[kept].second->size);
+        if (total + bytes > MAX_BYTES) break;  // Least recently used from here on
+        total += bytes;
+        ++kept;
+    }
+
+    std::filesystem::path tempPath = m_path;
+    tempPath += ".tmp" + std::to_string(GetCurrentProcessId());
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        const PackHeader header{PACK_MAGIC, PACK_VERSION, static_cast<uint32_t>(kept), 0};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        const char padding[8] = {};
+        for (size_t i = 0; i < kept; ++i) {
+            const Entry& entry = *order[i].second;
+            const PackRecord record{order[i].first, entry.checksum, entry.size, 0};
+            out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            out.write(entry.mapped ? entry.mapped : entry.owned.data(), entry.size);
+            out.write(padding, static_cast<std::streamsize>(Padded(entry.size) - entry.size));
+        }
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+    }
+    Unmap();
+    if (!MoveFileExW(tempPath.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+    }
+}
+
+} // namespace SP
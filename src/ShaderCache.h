@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Common.h"
+#include <unordered_map>
+#include <vector>
+
+namespace SP {
+
+// Compiled shader bytecode (DXBC) for every source the renderer has compiled,
+// in one pack file, shader_cache/shaders.pack next to the exe. Open maps the
+// pack once and indexes it in memory, so a warm start finds every shader without
+// touching the file system again. Keys hash the full source with the target, the
+// compile flags, the d3dcompiler DLL in use and the files the source includes
+// (ShaderIncludes::Hash), so a compiler update, a flag change or an edited
+// header misses instead of loading stale code. Each blob carries a checksum that
+// is checked on every load; a bad one is dropped and recompiled.
+//
+// New blobs stay in memory until Close, which rewrites the pack most recently
+// used first and stops at MAX_BYTES, evicting the least recently used. Load and
+// Store are thread-safe (background compiles run on the ShaderManager pool).
+//
+// An optional shared directory (a UNC path, or a WebDAV share mounted as one)
+// is a second tier behind the pack, for render nodes and venue PCs that would
+// otherwise each compile the same shaders. It holds one <key>.dxbc file per
+// blob. A local miss reads it from there and keeps it in the pack; a compile
+// publishes its blob there. Publishing writes a temporary file and renames it
+// into place without replacing, so readers never see a partial blob and the
+// first machine to finish wins. The compiler identity in the key comes from the
+// DLL's contents, not its path, so machines with the same compiler share keys.
+class ShaderBytecodeCache {
+public:
+    static constexpr uint64_t MAX_BYTES = 64ull * 1024 * 1024;
+
+    ShaderBytecodeCache() = default;
+    ~ShaderBytecodeCache() { Close(); }
+
+    // Non-copyable
+    ShaderBytecodeCache(const ShaderBytecodeCache&) = delete;
+    ShaderBytecodeCache& operator=(const ShaderBytecodeCache&) = delete;
+
+    // A missing or unreadable pack just starts empty. `sharedDirectory` empty,
+    // or not reachable at Open, leaves the shared tier off for the session.
+    void Open(const std::filesystem::path& packPath, const std::filesystem::path& sharedDirectory = {});
+    // Writes the pack back if anything was added or dropped, then unmaps it
+    void Close();
+
+    // includesHash: ShaderIncludes::Hash of what the source includes; 0 = nothing
+    uint64_t MakeKey(const std::string& source, const char* target, UINT flags, uint64_t includesHash = 0) const;
+    bool Load(uint64_t key, std::vector<char>& outBytecode);
+    void Store(uint64_t key, const std::vector<char>& bytecode);
+    // Bytecode indexed: the mapped pack's entries and those stored this session
+    size_t GetBytes() const;
+
+private:
+    struct Entry {
+        const char*       mapped = nullptr;  // Into the mapped pack, or null when `owned`
+        std::vector<char> owned;             // Stored this session
+        uint32_t size     = 0;
+        uint64_t checksum = 0;
+        uint64_t lastUse  = 0;
+    };
+
+    void Insert(uint64_t key, const std::vector<char>& bytecode);  // Under m_mutex
+    void Unmap();
+    void WritePack();
+    // Shared tier file I/O, outside m_mutex: it may be a slow network share
+    static bool ReadShared(const std::filesystem::path& directory, uint64_t key, std::vector<char>& outBytecode);
+    static void PublishShared(const std::filesystem::path& directory, uint64_t key, const std::vector<char>& bytecode);
+
+    mutable std::mutex m_mutex;
+    std::filesystem::path m_path;
+    std::filesystem::path m_sharedDirectory;  // Empty = no shared tier
+    HANDLE      m_file    = INVALID_HANDLE_VALUE;
+    HANDLE      m_mapping = nullptr;
+    const char* m_view    = nullptr;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    uint64_t m_compilerHash = 0;  // d3dcompiler identity, folded into every key
+    uint64_t m_useClock     = 0;
+    bool     m_dirty        = false;
+};
+
+} // namespace SP
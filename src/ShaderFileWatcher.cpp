@@ -0,0 +1,151 @@
+#include "ShaderFileWatcher.h"
+
+namespace SP {
+
+namespace {
+
+constexpr DWORD NOTIFY_FILTER = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+
+} // namespace
+
+bool ShaderFileWatcher::Watch(const std::filesystem::path& directory) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& watched : m_directories) {
+        if (watched->path == directory) return !watched->failed;
+    }
+    if (m_unwatchable.count(directory) || m_directories.size() >= MAX_DIRECTORIES) return false;
+
+    auto watched = std::make_unique<Directory>();
+    watched->path   = directory;
+    watched->handle = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                  OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    watched->overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (watched->handle == INVALID_HANDLE_VALUE || !watched->overlapped.hEvent || !Read(*watched)) {
+        if (watched->handle != INVALID_HANDLE_VALUE) CloseHandle(watched->handle);
+        if (watched->overlapped.hEvent) CloseHandle(watched->overlapped.hEvent);
+        m_unwatchable.insert(directory);
+        return false;
+    }
+
+    if (!m_wakeEvent) m_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    m_directories.push_back(std::move(watched));
+    if (!m_thread.joinable()) {
+        m_stop   = false;
+        m_thread = std::thread(&ShaderFileWatcher::WatchThread, this);
+    }
+    SetEvent(m_wakeEvent);  // Rebuild the wait with the new directory
+    return true;
+}
+
+bool ShaderFileWatcher::IsWatching(const std::filesystem::path& directory) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& watched : m_directories) {
+        if (watched->path == directory) return !watched->failed;
+    }
+    return false;
+}
+
+void ShaderFileWatcher::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        if (m_wakeEvent) SetEvent(m_wakeEvent);
+    }
+    if (m_thread.joinable()) m_thread.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& watched : m_directories) {
+        // The buffer must outlive the read: wait for the cancellation to land
+        if (!watched->failed) {
+            DWORD bytes = 0;
+            CancelIoEx(watched->handle, &watched->overlapped);
+            GetOverlappedResult(watched->handle, &watched->overlapped, &bytes, TRUE);
+        }
+        CloseHandle(watched->handle);
+        CloseHandle(watched->overlapped.hEvent);
+    }
+    m_directories.clear();
+    m_unwatchable.clear();
+    m_pending.clear();
+    if (m_wakeEvent) CloseHandle(m_wakeEvent);
+    m_wakeEvent = nullptr;
+}
+
+void ShaderFileWatcher::TakeChanges(std::vector<std::filesystem::path>& outFiles,
+                                    std::vector<std::filesystem::path>& outDirectories) {
+    outFiles.clear();
+    outDirectories.clear();
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (now - it->second.lastEvent < DEBOUNCE) {
+            ++it;
+            continue;
+        }
+        (it->second.directory ? outDirectories : outFiles).push_back(it->first);
+        it = m_pending.erase(it);
+    }
+}
+
+bool ShaderFileWatcher::Read(Directory& directory) {
+    ResetEvent(directory.overlapped.hEvent);
+    return ReadDirectoryChangesW(directory.handle, directory.buffer, sizeof(directory.buffer), FALSE,
+                                 NOTIFY_FILTER, nullptr, &directory.overlapped, nullptr) != FALSE;
+}
+
+void ShaderFileWatcher::WatchThread() {
+    std::vector<HANDLE>     handles;
+    std::vector<Directory*> directories;
+    for (;;) {
+        handles.assign(1, nullptr);
+        directories.clear();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stop) return;
+            handles[0] = m_wakeEvent;
+            for (const auto& watched : m_directories) {
+                if (watched->failed) continue;
+                handles.push_back(watched->overlapped.hEvent);
+                directories.push_back(watched.get());
+            }
+        }
+
+        const DWORD wait = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, INFINITE);
+        if (wait == WAIT_OBJECT_0) continue;  // New directory or Stop
+        const DWORD index = wait - WAIT_OBJECT_0 - 1;
+        if (index >= directories.size()) return;
+
+        Directory& directory = *directories[index];
+        DWORD bytes = 0;
+        const bool ok = GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, FALSE) != FALSE;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop) return;
+        Record(directory, ok ? bytes : 0);
+        if (!Read(directory)) {
+            // Gone (deleted, share dropped): the owner polls it from now on
+            directory.failed = true;
+        }
+    }
+}
+
+// With m_mutex held. 0 bytes: the buffer overflowed, or the read failed
+void ShaderFileWatcher::Record(Directory& directory, DWORD bytes) {
+    const auto now = std::chrono::steady_clock::now();
+    if (bytes == 0) {
+        m_pending[directory.path] = {now, true};
+        return;
+    }
+    const BYTE* entry = directory.buffer;
+    for (;;) {
+        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(entry);
+        if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME) {
+            const std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            m_pending[directory.path / name] = {now, false};
+        }
+        if (info->NextEntryOffset == 0) break;
+        entry += info->NextEntryOffset;
+    }
+}
+
+} // namespace SP
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Common.h"
+#include <chrono>
+#include <map>
+#include <set>
+
+namespace SP {
+
+// Change notifications for the shader library's directories, so hot reload
+// doesn't stat every preset every frame. One thread waits on overlapped
+// ReadDirectoryChangesW for all watched directories (not recursive) and records
+// each written or renamed-in file; TakeChanges hands the main thread those that
+// have been quiet for DEBOUNCE, so an editor's truncate-then-write save reloads
+// once. A notification buffer overflow reports the whole directory instead.
+//
+// Some volumes (FAT network shares, WebDAV) can't notify: Watch returns false,
+// and so does IsWatching for a directory whose watch later failed, and the
+// caller polls those itself.
+class ShaderFileWatcher {
+public:
+    static constexpr auto DEBOUNCE = std::chrono::milliseconds(150);
+    // One wait covers every directory and the wake event
+    static constexpr size_t MAX_DIRECTORIES = MAXIMUM_WAIT_OBJECTS - 1;
+
+    ShaderFileWatcher() = default;
+    ~ShaderFileWatcher() { Stop(); }
+
+    // Non-copyable
+    ShaderFileWatcher(const ShaderFileWatcher&) = delete;
+    ShaderFileWatcher& operator=(const ShaderFileWatcher&) = delete;
+
+    // Absolute directory path; watching one twice is a no-op that returns true
+    bool Watch(const std::filesystem::path& directory);
+    bool IsWatching(const std::filesystem::path& directory) const;
+    // Ends every watch and the thread; pending changes are dropped
+    void Stop();
+
+    // Main thread. Changed files (full paths) and overflowed directories, debounced
+    void TakeChanges(std::vector<std::filesystem::path>& outFiles,
+                     std::vector<std::filesystem::path>& outDirectories);
+
+private:
+    struct Directory {
+        std::filesystem::path path;
+        HANDLE     handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped = {};
+        bool       failed = false;  // Read could not be reissued; no longer in the wait
+        alignas(DWORD) BYTE buffer[16 * 1024];  // Network shares cap it at 64 KB
+    };
+    struct Pending {
+        std::chrono::steady_clock::time_point lastEvent;
+        bool directory = false;  // Overflow: anything in it may have changed
+    };
+
+    bool Read(Directory& directory);
+    void WatchThread();
+    void Record(Directory& directory, DWORD bytes);
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Directory>> m_directories;  // Addresses stay put for the thread
+    std::set<std::filesystem::path>         m_unwatchable;  // Watch failed; not retried
+    std::map<std::filesystem::path, Pending> m_pending;
+    HANDLE      m_wakeEvent = nullptr;  // A new directory, or Stop
+    std::thread m_thread;
+    bool        m_stop = false;
+};
+
+} // namespace SP
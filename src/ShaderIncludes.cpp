@@ -0,0 +1,135 @@
+#include "ShaderIncludes.h"
+#include <fstream>
+#include <sstream>
+
+namespace SP {
+
+namespace {
+
+// Names of the #include lines in `source`, in order
+std::vector<std::string> IncludeNames(const std::string& source) {
+    std::vector<std::string> names;
+    auto skipSpaces = [&](size_t i, size_t end) {
+        while (i < end && (source[i] == ' ' || source[i] == '\t')) ++i;
+        return i;
+    };
+    for (size_t line = 0; line < source.size();) {
+        size_t end = source.find('\n', line);
+        if (end == std::string::npos) end = source.size();
+
+        size_t i = skipSpaces(line, end);
+        if (i < end && source[i] == '#') {
+            i = skipSpaces(i + 1, end);
+            if (source.compare(i, 7, "include") == 0) {
+                i = skipSpaces(i + 7, end);
+                const char close = (i < end && source[i] == '<') ? '>' : '"';
+                if (i < end && (source[i] == '"' || source[i] == '<')) {
+                    const size_t nameEnd = source.find(close, i + 1);
+                    if (nameEnd != std::string::npos && nameEnd < end) names.push_back(source.substr(i + 1, nameEnd - i - 1));
+                }
+            }
+        }
+        line = end + 1;
+    }
+    return names;
+}
+
+// `name` next to the including file, then in the shader directory; empty when neither has it
+std::string ResolvePath(const std::string& name, const std::filesystem::path& parentDirectory,
+                        const std::filesystem::path& rootDirectory) {
+    for (const std::filesystem::path* base : {&parentDirectory, &rootDirectory}) {
+        if (base->empty()) continue;
+        std::error_code ec;
+        const std::filesystem::path candidate = std::filesystem::absolute(*base / name, ec).lexically_normal();
+        if (!ec && std::filesystem::is_regular_file(candidate, ec)) return candidate.string();
+    }
+    return {};
+}
+
+bool ReadFile(const std::string& path, std::string& out) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    out = buffer.str();
+    return true;
+}
+
+const ShaderIncludes::File* FindFile(const std::deque<ShaderIncludes::File>& files, const std::string& path) {
+    for (const ShaderIncludes::File& file : files) {
+        if (file.path == path) return &file;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+ShaderIncludes ShaderIncludes::Resolve(const std::string& source, const std::filesystem::path& sourceDirectory,
+                                       const std::filesystem::path& rootDirectory) {
+    ShaderIncludes includes;
+    includes.sourceDirectory = sourceDirectory;
+    includes.rootDirectory   = rootDirectory;
+
+    // Breadth first; a file included twice (or in a cycle) is read once
+    auto scan = [&](const std::string& text, const std::filesystem::path& directory) {
+        for (const std::string& name : IncludeNames(text)) {
+            const std::string path = ResolvePath(name, directory, rootDirectory);
+            if (path.empty() || FindFile(includes.files, path)) continue;  // Missing: the compile reports it
+            File file{path, {}};
+            if (ReadFile(path, file.content)) includes.files.push_back(std::move(file));
+        }
+    };
+    scan(source, sourceDirectory);
+    for (size_t i = 0; i < includes.files.size(); ++i) {
+        scan(includes.files[i].content, std::filesystem::path(includes.files[i].path).parent_path());
+    }
+    return includes;
+}
+
+uint64_t ShaderIncludes::Hash() const {
+    if (files.empty()) return 0;
+    uint64_t hash = Fnv1a64(nullptr, 0);
+    for (const File& file : files) {
+        hash = Fnv1a64(file.path.data(), file.path.size(), hash);
+        hash = Fnv1a64(file.content.data(), file.content.size(), hash);
+    }
+    return hash;
+}
+
+std::vector<std::string> ShaderIncludes::GetPaths() const {
+    std::vector<std::string> paths;
+    paths.reserve(files.size());
+    for (const File& file : files) paths.push_back(file.path);
+    return paths;
+}
+
+const ShaderIncludes::File* ShaderIncludeHandler::Find(const std::string& path) const {
+    const ShaderIncludes::File* file = FindFile(m_includes.files, path);
+    return file ? file : FindFile(m_untracked, path);
+}
+
+HRESULT ShaderIncludeHandler::Open(D3D_INCLUDE_TYPE, LPCSTR fileName, LPCVOID parentData,
+                                   LPCVOID* outData, UINT* outBytes) {
+    // Relative to the including file; the preset's directory for the source itself
+    std::filesystem::path directory = m_includes.sourceDirectory;
+    for (const auto* files : {&m_includes.files, &m_untracked}) {
+        for (const ShaderIncludes::File& file : *files) {
+            if (file.content.data() == parentData) directory = std::filesystem::path(file.path).parent_path();
+        }
+    }
+    const std::string path = ResolvePath(fileName, directory, m_includes.rootDirectory);
+    if (path.empty()) return E_FAIL;
+
+    const ShaderIncludes::File* file = Find(path);
+    if (!file) {
+        ShaderIncludes::File read{path, {}};
+        if (!ReadFile(path, read.content)) return E_FAIL;
+        m_untracked.push_back(std::move(read));
+        file = &m_untracked.back();
+    }
+    *outData  = file->content.data();
+    *outBytes = static_cast<UINT>(file->content.size());
+    return S_OK;
+}
+
+} // namespace SP
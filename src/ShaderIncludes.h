@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Common.h"
+#include <deque>
+
+namespace SP {
+
+// #include support for preset sources. Resolve reads a source's include graph
+// up front: every `#include "file"` or `#include <file>` line, recursively,
+// looked up next to the including file and then in the shader directory. Those
+// files are the snapshot a compile sees (ShaderIncludeHandler serves them to
+// D3DCompile) and are hashed into its bytecode cache key, so editing a shared
+// header misses the cache for exactly the shaders that include it.
+//
+// The scan is textual: an include inside #if 0 is still read (if it exists), and
+// one whose name is a macro isn't seen. The handler reads the latter from disk
+// when the compiler asks, and the result is then not cached (ReadUntracked).
+struct ShaderIncludes {
+    struct File {
+        std::string path;     // Absolute, normalised
+        std::string content;
+    };
+    std::deque<File> files;                 // Stable addresses: D3DCompile holds pointers into them
+    std::filesystem::path sourceDirectory;  // Of the preset file; the source's own includes start there
+    std::filesystem::path rootDirectory;    // Shader directory
+
+    static ShaderIncludes Resolve(const std::string& source, const std::filesystem::path& sourceDirectory,
+                                  const std::filesystem::path& rootDirectory);
+    // Over the paths and contents of every file; 0 when there are none
+    uint64_t Hash() const;
+    std::vector<std::string> GetPaths() const;
+};
+
+// ID3DInclude over a Resolve snapshot. One per compile (not thread-safe).
+class ShaderIncludeHandler : public ID3DInclude {
+public:
+    explicit ShaderIncludeHandler(const ShaderIncludes& includes) : m_includes(includes) {}
+
+    HRESULT __stdcall Open(D3D_INCLUDE_TYPE type, LPCSTR fileName, LPCVOID parentData,
+                           LPCVOID* outData, UINT* outBytes) override;
+    HRESULT __stdcall Close(LPCVOID) override { return S_OK; }
+
+    // Something outside the snapshot was included: the bytecode depends on a file the key doesn't
+    bool ReadUntracked() const { return !m_untracked.empty(); }
+
+private:
+    const ShaderIncludes::File* Find(const std::string& path) const;
+
+    const ShaderIncludes&             m_includes;
+    std::deque<ShaderIncludes::File> m_untracked;
+};
+
+} // namespace SP
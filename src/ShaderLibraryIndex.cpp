@@ -0,0 +1,315 @@
+#include "ShaderLibraryIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <unordered_set>
+
+namespace SP {
+
+namespace {
+
+constexpr uint32_t INDEX_MAGIC = 0x494C5053;  // "SPLI"
+// Bump whenever ParseISFParams or the layout below changes what an entry holds
+constexpr uint32_t INDEX_VERSION = 6;  // 3: binary instead of JSON, 4: VIDEO_MIPS, 5: pass formats, 6: DRAW
+
+// Appends fixed-size fields and length-prefixed strings/arrays
+class Writer {
+public:
+    template <typename T>
+    void Put(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+    }
+    void PutString(const std::string& text) {
+        Put(static_cast<uint32_t>(text.size()));
+        m_data.insert(m_data.end(), text.begin(), text.end());
+    }
+    const std::vector<char>& Data() const { return m_data; }
+
+private:
+    std::vector<char> m_data;
+};
+
+// Reads what Writer wrote; every read past the end fails and stays failed
+class Reader {
+public:
+    Reader(const char* data, size_t size) : m_data(data), m_size(size) {}
+
+    template <typename T>
+    bool Get(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (!Take(sizeof(T))) return false;
+        std::memcpy(&value, m_data + m_offset - sizeof(T), sizeof(T));
+        return true;
+    }
+    bool GetString(std::string& text) {
+        uint32_t length = 0;
+        if (!Get(length) || !Take(length)) return false;
+        text.assign(m_data + m_offset - length, length);
+        return true;
+    }
+    // An element count no bigger than the bytes left, so a corrupt one can't
+    // reserve gigabytes
+    bool GetCount(uint32_t& count) { return Get(count) && count <= m_size - m_offset; }
+    bool Ok() const { return m_ok; }
+
+private:
+    bool Take(size_t bytes) {
+        if (!m_ok || bytes > m_size - m_offset) return m_ok = false;
+        m_offset += bytes;
+        return true;
+    }
+
+    const char* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+    bool   m_ok     = true;
+};
+
+void WriteParam(Writer& w, const ShaderParam& p) {
+    w.PutString(p.name);
+    w.PutString(p.label);
+    w.Put(static_cast<int32_t>(p.type));
+    w.Put(p.defaultValues);
+    w.Put(p.min);
+    w.Put(p.max);
+    w.Put(p.step);
+    w.Put(static_cast<uint32_t>(p.longLabels.size()));
+    for (const std::string& label : p.longLabels) w.PutString(label);
+    w.Put(static_cast<uint32_t>(p.longValues.size()));
+    for (int value : p.longValues) w.Put(static_cast<int32_t>(value));
+    w.Put(static_cast<int32_t>(p.cbufferOffset));
+    w.PutString(p.audioBand);
+    w.Put(static_cast<int32_t>(p.inputIndex));
+    w.Put(static_cast<uint8_t>(p.specialize));
+}
+
+bool ReadParam(Reader& r, ShaderParam& p) {
+    int32_t type = 0, cbufferOffset = 0, inputIndex = 0;
+    uint8_t specialize = 0;
+    uint32_t count = 0;
+    r.GetString(p.name);
+    r.GetString(p.label);
+    r.Get(type);
+    r.Get(p.defaultValues);
+    r.Get(p.min);
+    r.Get(p.max);
+    r.Get(p.step);
+    if (!r.GetCount(count)) return false;
+    p.longLabels.resize(count);
+    for (std::string& label : p.longLabels) r.GetString(label);
+    if (!r.GetCount(count)) return false;
+    p.longValues.resize(count);
+    for (int& value : p.longValues) {
+        int32_t v = 0;
+        r.Get(v);
+        value = v;
+    }
+    r.Get(cbufferOffset);
+    r.GetString(p.audioBand);
+    r.Get(inputIndex);
+    r.Get(specialize);
+    p.type          = static_cast<ShaderParamType>(type);
+    p.cbufferOffset = cbufferOffset;
+    p.inputIndex    = inputIndex;
+    p.specialize    = specialize != 0;
+    std::copy(std::begin(p.defaultValues), std::end(p.defaultValues), p.values);
+    return r.Ok();
+}
+
+void WriteMetadata(Writer& w, const ShaderPreset& m) {
+    w.Put(static_cast<uint8_t>(m.isGenerative));
+    w.Put(static_cast<uint8_t>(m.isAudio));
+    w.Put(static_cast<uint32_t>(m.params.size()));
+    for (const ShaderParam& p : m.params) WriteParam(w, p);
+    w.Put(static_cast<uint32_t>(m.passes.size()));
+    for (const RenderPassDesc& pass : m.passes) {
+        w.PutString(pass.target);
+        w.Put(pass.widthScale);
+        w.Put(pass.heightScale);
+        w.Put(static_cast<int32_t>(pass.width));
+        w.Put(static_cast<int32_t>(pass.height));
+        w.Put(static_cast<int32_t>(pass.format));
+        w.Put(static_cast<uint8_t>(pass.persistent));
+        w.Put(static_cast<int32_t>(pass.steps));
+    }
+    w.Put(static_cast<int32_t>(m.frameHistory.frames));
+    w.Put(m.frameHistory.scale);
+    w.Put(static_cast<uint8_t>(m.videoMips));
+
+    const ComputeDesc& compute = m.compute;
+    w.Put(static_cast<uint8_t>(compute.enabled));
+    w.Put(static_cast<int32_t>(compute.threadsX));
+    w.Put(static_cast<int32_t>(compute.threadsY));
+    w.Put(static_cast<uint8_t>(compute.clearOutput));
+    w.Put(static_cast<int32_t>(compute.format));
+    w.Put(static_cast<uint32_t>(compute.buffers.size()));
+    for (const ComputeBufferDesc& buffer : compute.buffers) {
+        w.PutString(buffer.name);
+        w.Put(static_cast<int32_t>(buffer.stride));
+        w.Put(static_cast<int32_t>(buffer.count));
+        w.Put(static_cast<uint8_t>(buffer.persistent));
+    }
+    w.Put(static_cast<uint32_t>(compute.dispatches.size()));
+    for (const ComputeDispatch& d : compute.dispatches) {
+        for (int a = 0; a < 2; ++a) {
+            w.Put(static_cast<int32_t>(d.groups[a]));
+            w.Put(static_cast<int32_t>(d.sizeAxis[a]));
+            w.Put(d.sizeScale[a]);
+        }
+    }
+    w.Put(static_cast<int32_t>(compute.draw.buffer));
+    w.Put(compute.draw.size);
+    w.Put(static_cast<uint8_t>(compute.draw.additive));
+}
+
+bool ReadMetadata(Reader& r, ShaderPreset& m) {
+    uint8_t flag = 0;
+    int32_t value = 0;
+    uint32_t count = 0;
+    r.Get(flag); m.isGenerative = flag != 0;
+    r.Get(flag); m.isAudio = flag != 0;
+    if (!r.GetCount(count)) return false;
+    m.params.resize(count);
+    for (ShaderParam& p : m.params) {
+        if (!ReadParam(r, p)) return false;
+    }
+    if (!r.GetCount(count)) return false;
+    m.passes.resize(count);
+    for (RenderPassDesc& pass : m.passes) {
+        r.GetString(pass.target);
+        r.Get(pass.widthScale);
+        r.Get(pass.heightScale);
+        r.Get(value); pass.width  = value;
+        r.Get(value); pass.height = value;
+        r.Get(value); pass.format = static_cast<PassFormat>(value);
+        r.Get(flag);  pass.persistent = flag != 0;
+        r.Get(value); pass.steps  = value;
+    }
+    r.Get(value); m.frameHistory.frames = value;
+    r.Get(m.frameHistory.scale);
+    r.Get(flag);  m.videoMips = flag != 0;
+
+    ComputeDesc& compute = m.compute;
+    r.Get(flag);  compute.enabled  = flag != 0;
+    r.Get(value); compute.threadsX = value;
+    r.Get(value); compute.threadsY = value;
+    r.Get(flag);  compute.clearOutput = flag != 0;
+    r.Get(value); compute.format = static_cast<PassFormat>(value);
+    if (!r.GetCount(count)) return false;
+    compute.buffers.resize(count);
+    for (ComputeBufferDesc& buffer : compute.buffers) {
+        r.GetString(buffer.name);
+        r.Get(value); buffer.stride = value;
+        r.Get(value); buffer.count  = value;
+        r.Get(flag);  buffer.persistent = flag != 0;
+    }
+    if (!r.GetCount(count)) return false;
+    compute.dispatches.resize(count);
+    for (ComputeDispatch& d : compute.dispatches) {
+        for (int a = 0; a < 2; ++a) {
+            r.Get(value); d.groups[a]   = value;
+            r.Get(value); d.sizeAxis[a] = value;
+            r.Get(d.sizeScale[a]);
+        }
+    }
+    r.Get(value); compute.draw.buffer = value;
+    r.Get(compute.draw.size);
+    r.Get(flag);  compute.draw.additive = flag != 0;
+    return r.Ok();
+}
+
+} // namespace
+
+void ShaderLibraryIndex::Load(const std::filesystem::path& indexPath) {
+    m_path = indexPath;
+    m_entries.clear();
+    m_dirty = false;
+
+    // One read, then parsed from memory
+    std::ifstream file(indexPath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return;
+    std::vector<char> data(static_cast<size_t>(std::max<std::streamoff>(file.tellg(), 0)));
+    file.seekg(0);
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) return;
+
+    Reader r(data.data(), data.size());
+    uint32_t magic = 0, version = 0, count = 0;
+    r.Get(magic);
+    r.Get(version);
+    if (!r.Ok() || magic != INDEX_MAGIC || version != INDEX_VERSION || !r.GetCount(count)) {
+        m_dirty = true;  // Replaced on the next Save
+        return;
+    }
+    m_entries.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string filepath;
+        Entry entry;
+        r.GetString(filepath);
+        r.Get(entry.mtime);
+        r.Get(entry.size);
+        r.Get(entry.hash);
+        if (!ReadMetadata(r, entry.metadata)) {
+            m_entries.clear();
+            m_dirty = true;
+            return;
+        }
+        m_entries.emplace(std::move(filepath), std::move(entry));
+    }
+}
+
+void ShaderLibraryIndex::Save() {
+    if (!m_dirty || m_path.empty()) return;
+    Writer w;
+    w.Put(INDEX_MAGIC);
+    w.Put(INDEX_VERSION);
+    w.Put(static_cast<uint32_t>(m_entries.size()));
+    for (const auto& [filepath, entry] : m_entries) {
+        w.PutString(filepath);
+        w.Put(entry.mtime);
+        w.Put(entry.size);
+        w.Put(entry.hash);
+        WriteMetadata(w, entry.metadata);
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(m_path.parent_path(), ec);
+    std::ofstream file(m_path, std::ios::binary | std::ios::trunc);
+    file.write(w.Data().data(), static_cast<std::streamsize>(w.Data().size()));
+    if (file) m_dirty = false;
+}
+
+const ShaderLibraryIndex::Entry* ShaderLibraryIndex::Find(const std::string& filepath, int64_t mtime,
+                                                          uint64_t size, uint64_t hash) const {
+    auto it = m_entries.find(filepath);
+    if (it == m_entries.end()) return nullptr;
+    const Entry& entry = it->second;
+    return (entry.mtime == mtime && entry.size == size && entry.hash == hash) ? &entry : nullptr;
+}
+
+void ShaderLibraryIndex::Store(const std::string& filepath, Entry entry) {
+    entry.metadata.source.clear();
+    m_entries[filepath] = std::move(entry);
+    m_dirty = true;
+}
+
+void ShaderLibraryIndex::Prune(const std::filesystem::path& directory, const std::vector<std::string>& present) {
+    const std::unordered_set<std::string> kept(present.begin(), present.end());
+    const std::filesystem::path root = directory.lexically_normal();
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        // Anywhere under the scanned directory: its subfolders were listed too
+        const std::string relative =
+            std::filesystem::path(it->first).lexically_normal().lexically_relative(root).generic_string();
+        const bool under = !relative.empty() && relative.rfind("..", 0) != 0;
+        if (under && !kept.count(it->first)) {
+            it = m_entries.erase(it);
+            m_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace SP
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Common.h"
+#include <unordered_map>
+
+namespace SP {
+
+// Parsed ISF metadata of every shader file the library has loaded, persisted in
+// shader_cache/library.idx next to the exe so a start re-parses only the files
+// that changed. The file is a flat binary dump read in one go, so a library of
+// thousands of presets loads without a JSON parse. An entry matches when the file's size, modification time and
+// FNV-1a hash of its text are all the ones it was parsed from. Stores and
+// Prunes mark the index dirty; Save writes it back only then. Find may run on
+// several threads at once, but never concurrently with Store, Prune or Load.
+class ShaderLibraryIndex {
+public:
+    struct Entry {
+        int64_t  mtime = 0;  // file_time_type ticks
+        uint64_t size  = 0;
+        uint64_t hash  = 0;
+        // What ParseISFParams sets: params, isGenerative, isAudio, passes,
+        // frameHistory, videoMips, compute. No source.
+        ShaderPreset metadata;
+    };
+
+    // A missing, unreadable or older-version index just starts empty
+    void Load(const std::filesystem::path& indexPath);
+    void Save();
+
+    const Entry* Find(const std::string& filepath, int64_t mtime, uint64_t size, uint64_t hash) const;
+    void Store(const std::string& filepath, Entry entry);
+    // Drops entries under `directory` (subfolders included) whose file is no
+    // longer in `present`
+    void Prune(const std::filesystem::path& directory, const std::vector<std::string>& present);
+
+private:
+    std::filesystem::path m_path;
+    std::unordered_map<std::string, Entry> m_entries;
+    bool m_dirty = false;
+};
+
+} // namespace SP
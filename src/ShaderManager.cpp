@@ -1,17 +1,255 @@
 #include "ShaderManager.h"
+#include "ThreadPriority.h"
+#include "TraceRecorder.h"
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <sstream>
+#include <unordered_set>
 #include <nlohmann/json.hpp>
 
 namespace SP {
 
+namespace {
+
+// Background compile threads: one core is left to the UI and decode
+constexpr unsigned MAX_COMPILE_THREADS = 8;
+
+// Library reads and ISF parses, per batch
+constexpr unsigned MAX_SCAN_THREADS = 8;
+
+// Subfolder of `filepath` under the scanned `root`, '/'-separated; empty at the
+// top level and outside it
+std::string LibraryFolder(const std::string& filepath, const std::filesystem::path& root) {
+    const std::filesystem::path parent = std::filesystem::path(filepath).parent_path().lexically_normal();
+    const std::string folder = parent.lexically_relative(root.lexically_normal()).generic_string();
+    if (folder.empty() || folder == "." || folder.rfind("..", 0) == 0) return {};
+    return folder;
+}
+
+// Presets in directories that can't notify are checked by timestamp this often
+constexpr auto UNWATCHED_POLL_INTERVAL = std::chrono::seconds(2);
+
+// Weight of each new frame in a preset's measured GPU time (about a second at 60 Hz)
+constexpr float GPU_TIME_SMOOTHING = 0.05f;
+
+// What the renderer compiles for (ps_5_0 / cs_5_0), defined as SHADER_MODEL in
+// every preamble so shared code can gate newer features on it
+constexpr int RENDERER_SHADER_MODEL = 50;
+
+// ISF "SHADER_MODEL" ("6_0", "6.2", ...) as major * 10 + minor; the renderer's own when absent
+int RequestedShaderModel(const std::string& source) {
+    const auto start = source.find("/*{");
+    const auto end   = start == std::string::npos ? std::string::npos : source.find("}*/", start);
+    if (end == std::string::npos) return RENDERER_SHADER_MODEL;
+    const std::string block = "{" + source.substr(start + 3, end - start - 3) + "}";
+    if (block.find("SHADER_MODEL") == std::string::npos) return RENDERER_SHADER_MODEL;  // Most presets: no parse
+    try {
+        const std::string model = nlohmann::json::parse(block).value("SHADER_MODEL", std::string{});
+        int major = 0, minor = 0;
+        if (std::sscanf(model.c_str(), "%d%*[._]%d", &major, &minor) >= 1) return major * 10 + minor;
+    } catch (...) {
+    }
+    return RENDERER_SHADER_MODEL;
+}
+
+// Absolute, normalised and lower-cased, so a notified path matches the preset's
+// however either was spelled
+std::filesystem::path WatchPath(const std::filesystem::path& filepath) {
+    std::error_code ec;
+    const std::filesystem::path absolute = std::filesystem::absolute(filepath, ec);
+    std::wstring key = (ec ? filepath : absolute).lexically_normal().wstring();
+    CharLowerBuffW(key.data(), static_cast<DWORD>(key.size()));
+    return key;
+}
+
+// Values the user set survive a re-parse for params that keep their name
+void CarryParamValues(const std::vector<ShaderParam>& from, std::vector<ShaderParam>& to) {
+    for (ShaderParam& param : to) {
+        auto it = std::find_if(from.begin(), from.end(),
+                               [&](const ShaderParam& old) { return old.name == param.name; });
+        if (it != from.end()) std::copy(std::begin(it->values), std::end(it->values), param.values);
+    }
+}
+
+} // namespace
+
 ShaderManager::ShaderManager(D3D11Renderer& renderer)
     : m_renderer(renderer)
 {
 }
 
-ShaderManager::~ShaderManager() = default;
+ShaderManager::~ShaderManager() {
+    if (m_libraryThread.joinable()) m_libraryThread.join();
+    StopCompileWorkers();
+}
+
+void ShaderManager::CompilePresetAsync(int index) {
+    if (index < 0 || index >= static_cast<int>(m_presets.size())) return;
+    if (m_presets[index].isDeferred && m_compiledShaders[index].evicted) ++m_residencyReloads;
+    QueueCompile(index, m_presets[index], false);
+}
+
+void ShaderManager::RecompilePresetAsync(int index) {
+    if (index < 0 || index >= static_cast<int>(m_presets.size())) return;
+    // Parse into the job's copy: the live preset keeps the params and passes its
+    // current shader was built with until the new one lands
+    ShaderPreset job = m_presets[index];
+    job.params = ParseISFParams(job.source, &job.isGenerative, &job.isAudio,
+                                &job.passes, &job.frameHistory, &job.compute, &job.videoMips);
+    CarryParamValues(m_presets[index].params, job.params);
+    QueueCompile(index, std::move(job), true);
+}
+
+void ShaderManager::QueueCompile(int index, ShaderPreset job, bool reparsed) {
+    m_presets[index].isCompiling = true;
+    m_presets[index].isDeferred  = false;
+    {
+        std::lock_guard<std::mutex> lock(m_compileMutex);
+        // A superseded job still waiting is dropped; one already on a worker can't
+        // be stopped mid-D3DCompile, and its result is ignored when it lands
+        const uint64_t previous = m_compiledShaders[index].ticket;
+        if (previous != 0) {
+            m_compileJobs.erase(std::remove_if(m_compileJobs.begin(), m_compileJobs.end(),
+                                               [&](const CompileJob& queued) { return queued.ticket == previous; }),
+                                m_compileJobs.end());
+        }
+        const uint64_t ticket = m_nextTicket++;
+        m_compiledShaders[index].ticket = ticket;
+        m_compileJobs.push_back({ticket, std::move(job), reparsed, 0});
+        StartCompileWorkers();
+    }
+    m_compileCv.notify_one();
+}
+
+void ShaderManager::QueueVariant(int index, uint64_t key) {
+    CompiledShader& compiled = m_compiledShaders[index];
+    compiled.variantPending = key;
+    {
+        std::lock_guard<std::mutex> lock(m_compileMutex);
+        // Only the newest selection matters: a queued variant of an older one goes
+        const uint64_t previous = compiled.variantTicket;
+        if (previous != 0) {
+            m_compileJobs.erase(std::remove_if(m_compileJobs.begin(), m_compileJobs.end(),
+                                               [&](const CompileJob& queued) { return queued.ticket == previous; }),
+                                m_compileJobs.end());
+        }
+        compiled.variantTicket = m_nextTicket++;
+        // Ahead of library compiles: it is for the shader on screen
+        m_compileJobs.push_front({compiled.variantTicket, m_presets[index], false, key});
+        StartCompileWorkers();
+    }
+    m_compileCv.notify_one();
+}
+
+void ShaderManager::StartCompileWorkers() {
+    if (!m_compileThreads.empty()) return;
+    const unsigned cores = std::max(2u, std::thread::hardware_concurrency());
+    const unsigned count = std::min(MAX_COMPILE_THREADS, cores - 1);
+    for (unsigned i = 0; i < count; ++i) m_compileThreads.emplace_back(&ShaderManager::CompileWorker, this);
+}
+
+void ShaderManager::CompileWorker() {
+    ThreadPriority::Apply(ThreadRole::Background);
+    for (;;) {
+        CompileJob job;
+        {
+            std::unique_lock<std::mutex> lock(m_compileMutex);
+            m_compileCv.wait(lock, [this] { return m_stopCompiling || !m_compileJobs.empty(); });
+            if (m_stopCompiling) return;
+            job = std::move(m_compileJobs.front());
+            m_compileJobs.pop_front();
+            ++m_compilesInFlight;
+        }
+        CompileResult result{job.ticket, std::move(job.preset), {}, job.reparsed, job.variantKey};
+        Compile(result.preset, result.compiled, job.variantKey != 0);
+
+        std::lock_guard<std::mutex> lock(m_compileMutex);
+        m_compileResults.push_back(std::move(result));
+        --m_compilesInFlight;
+    }
+}
+
+void ShaderManager::StopCompileWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_compileMutex);
+        m_stopCompiling = true;
+        m_compileJobs.clear();
+    }
+    m_compileCv.notify_all();
+    for (std::thread& thread : m_compileThreads) thread.join();
+    m_compileThreads.clear();
+}
+
+bool ShaderManager::PollCompiles() {
+    std::vector<CompileResult> results;
+    {
+        std::lock_guard<std::mutex> lock(m_compileMutex);
+        if (m_compileResults.empty()) return false;
+        results.swap(m_compileResults);
+    }
+    bool applied = false;
+    for (CompileResult& result : results) {
+        // The preset may have been removed, or compiled again, since it was queued
+        auto it = std::find_if(m_compiledShaders.begin(), m_compiledShaders.end(), [&](const CompiledShader& compiled) {
+            return compiled.ticket == result.ticket || compiled.variantTicket == result.ticket;
+        });
+        if (it == m_compiledShaders.end()) continue;
+        const int index = static_cast<int>(it - m_compiledShaders.begin());
+        if (result.variantKey != 0) {
+            // A variant that fails keeps variantPending set: the generic shader stays
+            it->variantTicket = 0;
+            if (result.preset.isValid) {
+                if (it->variants.size() >= MAX_VARIANTS) it->variants.erase(it->variants.begin());
+                it->variants.push_back({result.variantKey, result.preset.isTimeVarying, result.preset.bindings,
+                                        std::move(result.compiled)});
+                it->variantPending = 0;
+                applied = true;
+            }
+            continue;
+        }
+        ShaderPreset& preset = m_presets[index];
+        preset.isCompiling  = false;
+        preset.isValid      = result.preset.isValid;
+        preset.compileError = std::move(result.preset.compileError);
+        // Also on failure: fixing the include it failed in must reload it
+        preset.includes     = std::move(result.preset.includes);
+        TrackIncludes(preset);
+        if (preset.isValid) {
+            preset.isTimeVarying = result.preset.isTimeVarying;
+            preset.bindings      = result.preset.bindings;
+            preset.cost          = result.preset.cost;
+            if (result.reparsed) {
+                // Values changed while it compiled win over those in the job's copy
+                CarryParamValues(preset.params, result.preset.params);
+                preset.params       = std::move(result.preset.params);
+                preset.isGenerative = result.preset.isGenerative;
+                preset.isAudio      = result.preset.isAudio;
+                preset.passes       = std::move(result.preset.passes);
+                preset.frameHistory = result.preset.frameHistory;
+                preset.videoMips    = result.preset.videoMips;
+                preset.compute      = std::move(result.preset.compute);
+            }
+            *it = std::move(result.compiled);  // Clears the ticket
+            it->lastUse = m_useClock;
+            m_prewarmPending = true;
+            if (index == m_activeIndex) SetActivePreset(index);
+        } else {
+            it->ticket = 0;  // Keep the last good shader
+        }
+        applied = true;
+    }
+    if (applied) UpdateSpecialization();
+    return applied;
+}
+
+int ShaderManager::GetPendingCompileCount() const {
+    std::lock_guard<std::mutex> lock(m_compileMutex);
+    return static_cast<int>(m_compileJobs.size() + m_compileResults.size()) + m_compilesInFlight;
+}
 
 bool ShaderManager::LoadShaderFromFile(const std::string& filepath, ShaderPreset& outPreset) {
     std::ifstream file(filepath);
@@ -47,10 +285,87 @@ bool ShaderManager::LoadShaderMetadataFromFile(const std::string& filepath, Shad
     outPreset.source   = buffer.str();
     outPreset.name     = std::filesystem::path(filepath).stem().string();
     // Parse ISF so default param values are available for the caller to override before AddPreset.
-    outPreset.params   = ParseISFParams(outPreset.source, &outPreset.isGenerative, &outPreset.isAudio);
+    outPreset.params   = ParseISFParams(outPreset.source, &outPreset.isGenerative, &outPreset.isAudio,
+                                        &outPreset.passes, &outPreset.frameHistory, &outPreset.compute,
+                                        &outPreset.videoMips);
     return true;
 }
 
+std::vector<ShaderPreset> ShaderManager::LoadMetadataFromFiles(const std::vector<std::string>& filepaths) {
+    LoadLibraryIndex();
+    struct Loaded {
+        ShaderPreset preset;
+        ShaderLibraryIndex::Entry entry;
+        bool indexed = false;
+    };
+    std::vector<Loaded> loaded(filepaths.size());
+
+    // Only Find touches the index until the workers are joined
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i; (i = next++) < filepaths.size();) {
+            const std::string& filepath = filepaths[i];
+            Loaded& out = loaded[i];
+            std::error_code timeError, sizeError;
+            const auto mtime = std::filesystem::last_write_time(filepath, timeError);
+            const auto size  = std::filesystem::file_size(filepath, sizeError);
+            std::ifstream file(filepath);
+            if (timeError || sizeError || !file.is_open()) continue;
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+
+            ShaderPreset& preset = out.preset;
+            preset.filepath = filepath;
+            preset.source   = buffer.str();
+            preset.name     = std::filesystem::path(filepath).stem().string();
+            out.entry.mtime = mtime.time_since_epoch().count();
+            out.entry.size  = size;
+            out.entry.hash  = Fnv1a64(preset.source.data(), preset.source.size());
+            if (const auto* cached = m_libraryIndex.Find(filepath, out.entry.mtime, out.entry.size, out.entry.hash)) {
+                const ShaderPreset& metadata = cached->metadata;
+                preset.params       = metadata.params;
+                preset.isGenerative = metadata.isGenerative;
+                preset.isAudio      = metadata.isAudio;
+                preset.passes       = metadata.passes;
+                preset.frameHistory = metadata.frameHistory;
+                preset.videoMips    = metadata.videoMips;
+                preset.compute      = metadata.compute;
+                out.indexed = true;
+            } else {
+                preset.params = ParseISFParams(preset.source, &preset.isGenerative, &preset.isAudio,
+                                               &preset.passes, &preset.frameHistory, &preset.compute,
+                                               &preset.videoMips);
+            }
+        }
+    };
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    const size_t threadCount = std::min<size_t>({filepaths.size(), hardware, MAX_SCAN_THREADS});
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; ++t) threads.emplace_back(work);
+    work();
+    for (std::thread& thread : threads) thread.join();
+
+    std::vector<ShaderPreset> presets;
+    presets.reserve(loaded.size());
+    for (Loaded& out : loaded) {
+        if (!out.preset.filepath.empty() && !out.indexed) {
+            out.entry.metadata = out.preset;
+            m_libraryIndex.Store(out.preset.filepath, std::move(out.entry));
+        }
+        presets.push_back(std::move(out.preset));
+    }
+    m_libraryIndex.Save();
+    return presets;
+}
+
+void ShaderManager::LoadLibraryIndex() {
+    if (m_libraryIndexLoaded) return;
+    m_libraryIndexLoaded = true;
+    char exePath[MAX_PATH];
+    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+    m_libraryIndex.Load(std::filesystem::path(exePath).parent_path() / "shader_cache" / "library.idx");
+}
+
 bool ShaderManager::LoadShaderFromSource(const std::string& name, const std::string& source, ShaderPreset& outPreset) {
     outPreset.name = name;
     outPreset.source = source;
@@ -65,7 +380,8 @@ bool ShaderManager::CompilePreset(ShaderPreset& preset) {
     for (const auto& p : preset.params)
         saved[p.name] = {p.values[0], p.values[1], p.values[2], p.values[3]};
 
-    preset.params = ParseISFParams(preset.source, &preset.isGenerative, &preset.isAudio);
+    preset.params = ParseISFParams(preset.source, &preset.isGenerative, &preset.isAudio, &preset.passes,
+                                   &preset.frameHistory, &preset.compute, &preset.videoMips);
 
     for (auto& p : preset.params) {
         auto it = saved.find(p.name);
@@ -73,31 +389,147 @@ bool ShaderManager::CompilePreset(ShaderPreset& preset) {
             std::copy(it->second.begin(), it->second.end(), p.values);
     }
 
-    std::string preamble = BuildDefinesPreamble(preset.params);
-    ComPtr<ID3D11PixelShader> shader;
-    std::string error;
+    int presetIndex = -1;
+    for (int i = 0; i < static_cast<int>(m_presets.size()); ++i) {
+        if (&m_presets[i] == &preset) { presetIndex = i; break; }
+    }
+    const bool stored = presetIndex >= 0 && presetIndex < static_cast<int>(m_compiledShaders.size());
+    if (stored) {
+        // Supersedes a pending background compile
+        m_compiledShaders[presetIndex].ticket = 0;
+        preset.isCompiling = false;
+    }
 
-    if (m_renderer.CompilePixelShader(preamble + preset.source, shader, error)) {
-        preset.isValid = true;
-        preset.compileError.clear();
+    CompiledShader compiled;
+    const bool ok = Compile(preset, compiled);
+    if (stored) TrackIncludes(preset);
+    if (!ok) return false;
+    if (stored) m_compiledShaders[presetIndex] = std::move(compiled);
+    return true;
+}
 
-        int presetIndex = -1;
-        for (int i = 0; i < static_cast<int>(m_presets.size()); ++i) {
-            if (&m_presets[i] == &preset) { presetIndex = i; break; }
+bool ShaderManager::Compile(ShaderPreset& preset, CompiledShader& out, bool specialize) {
+    const std::string preamble = BuildDefinesPreamble(preset.params, preset.passes, preset.frameHistory,
+                                                      preset.compute, specialize);
+    std::string error;
+    bool ok = true;
+    out = CompiledShader{};
+
+    // The #include graph, read once for every pass or kernel
+    std::optional<ShaderIncludes> includes;
+    if (preset.source.find("include") != std::string::npos) {
+        std::filesystem::path root;
+        {
+            std::lock_guard<std::mutex> lock(m_compileMutex);
+            root = m_includeDirectory;
         }
-        if (presetIndex >= 0 && presetIndex < static_cast<int>(m_compiledShaders.size()))
-            m_compiledShaders[presetIndex] = shader;
+        const std::filesystem::path sourceDirectory =
+            preset.filepath.empty() ? root : std::filesystem::path(preset.filepath).parent_path();
+        includes = ShaderIncludes::Resolve(preset.source, sourceDirectory, root);
+    }
+    const ShaderIncludes* included = includes ? &*includes : nullptr;
+    preset.includes = included ? included->GetPaths() : std::vector<std::string>{};
+
+    // SM6 (DXIL: wave intrinsics, 16-bit types) needs DXC and a D3D12 device
+    const int shaderModel = RequestedShaderModel(preset.source);
+    if (shaderModel > RENDERER_SHADER_MODEL) {
+        preset.isValid      = false;
+        preset.compileError = "SHADER_MODEL " + std::to_string(shaderModel / 10) + "." + std::to_string(shaderModel % 10) +
+                              " is not available: the D3D11 renderer compiles Shader Model 5.0. Guard SM6 code with "
+                              "#if SHADER_MODEL >= 60 and drop the key to keep a 5.0 fallback.";
+        return false;
+    }
 
-        return true;
+    if (preset.compute.enabled) {
+        // One kernel per dispatch, PASSINDEX a literal as for pixel passes.
+        // Persistent buffers carry state between frames, so those presets always redraw.
+        preset.isTimeVarying = std::any_of(preset.compute.buffers.begin(), preset.compute.buffers.end(),
+                                           [](const ComputeBufferDesc& buffer) { return buffer.persistent; });
+        preset.bindings = ShaderBindings{0, 0};
+        preset.cost     = ShaderCost{};
+        const size_t kernelCount = std::max<size_t>(1, preset.compute.dispatches.size());
+        for (size_t i = 0; i < kernelCount && ok; ++i) {
+            D3D11Renderer::ComputeKernel kernel;
+            if (i < preset.compute.dispatches.size()) kernel.dispatch = preset.compute.dispatches[i];
+            bool timeVarying = true;
+            ShaderBindings bindings;
+            ShaderCost cost;
+            ok = m_renderer.CompileComputeShader(preamble + "#define PASSINDEX " + std::to_string(i) + "\n" + preset.source,
+                                                 kernel.shader, error, &timeVarying, &bindings, &cost, included);
+            if (!ok) {
+                if (kernelCount > 1) error = "Dispatch " + std::to_string(i) + ": " + error;
+                break;
+            }
+            preset.isTimeVarying = preset.isTimeVarying || timeVarying;
+            preset.bindings |= bindings;
+            preset.cost += cost;
+            out.kernels.push_back(std::move(kernel));
+        }
+        if (ok && preset.compute.draw.buffer >= 0) {
+            ShaderBindings bindings;
+            ShaderCost cost;
+            ok = m_renderer.CompilePointDraw(preamble + "#define DRAW_STAGE 1\n" + preset.source, out.points, error,
+                                             &bindings, &cost, included);
+            if (ok) {
+                preset.bindings |= bindings;
+                preset.cost += cost;
+            } else {
+                error = "Point draw: " + error;
+            }
+        }
+        if (!ok) out = CompiledShader{};
+    } else if (preset.passes.empty()) {
+        std::string source = preamble + preset.source;
+        if (specialize) {
+            std::string fused = D3D11Renderer::BuildFusedBlendSource(source, preset.blendMode);
+            if (!fused.empty()) {
+                source.swap(fused);
+                out.fusedBlendMode = preset.blendMode;
+            }
+        }
+        ok = m_renderer.CompilePixelShader(source, out.shader, error, &preset.isTimeVarying, &preset.bindings,
+                                           &preset.cost, included);
+        out.canFuseBlend = ok && !specialize && D3D11Renderer::CanFuseBlend(preset.source);
     } else {
-        preset.isValid = false;
-        preset.compileError = error;
-        return false;
+        // One variant per pass with PASSINDEX a literal: each keeps only its own
+        // branches, and reflection shows which pass targets it samples
+        preset.isTimeVarying = false;
+        preset.bindings = ShaderBindings{0, 0};
+        preset.cost     = ShaderCost{};
+        for (size_t i = 0; i < preset.passes.size() && ok; ++i) {
+            D3D11Renderer::RenderGraphPass pass;
+            pass.desc = preset.passes[i];
+            bool timeVarying = true;
+            ShaderBindings bindings;
+            ShaderCost cost;
+            ok = m_renderer.CompilePixelShader(preamble + "#define PASSINDEX " + std::to_string(i) + "\n" + preset.source,
+                                               pass.shader, error, &timeVarying, &bindings, &cost, included);
+            if (!ok) {
+                error = "Pass " + std::to_string(i) + ": " + error;
+                break;
+            }
+            pass.reads = (bindings.textures >> FIRST_PASS_SLOT) & ((1u << MAX_RENDER_PASSES) - 1);
+            preset.bindings |= bindings;
+            // A persistent pass draws `steps` times a frame
+            for (int step = 0; step < (pass.desc.persistent ? pass.desc.steps : 1); ++step) preset.cost += cost;
+            // A simulation moves on every frame whether or not it reads `time`
+            preset.isTimeVarying = preset.isTimeVarying || timeVarying || pass.desc.persistent;
+            out.passes.push_back(std::move(pass));
+        }
+        if (ok) out.shader = out.passes.back().shader;
+        else    out = CompiledShader{};
     }
+
+    preset.isValid = ok;
+    preset.compileError = ok ? std::string{} : error;
+    return ok;
 }
 
 bool ShaderManager::RecompilePreset(int index) {
     if (index < 0 || index >= static_cast<int>(m_presets.size())) return false;
+    m_compiledShaders[index].ticket = 0;  // Supersedes a pending background compile
+    m_presets[index].isCompiling = false;
+    m_presets[index].isDeferred  = false;
 
     std::unordered_map<std::string, std::array<float, 4>> saved;
     for (const auto& p : m_presets[index].params)
@@ -105,7 +537,11 @@ bool ShaderManager::RecompilePreset(int index) {
 
     m_presets[index].params = ParseISFParams(m_presets[index].source,
                                               &m_presets[index].isGenerative,
-                                              &m_presets[index].isAudio);
+                                              &m_presets[index].isAudio,
+                                              &m_presets[index].passes,
+                                              &m_presets[index].frameHistory,
+                                              &m_presets[index].compute,
+                                              &m_presets[index].videoMips);
 
     for (auto& p : m_presets[index].params) {
         auto it = saved.find(p.name);
@@ -113,29 +549,24 @@ bool ShaderManager::RecompilePreset(int index) {
             std::copy(it->second.begin(), it->second.end(), p.values);
     }
 
-    std::string preamble = BuildDefinesPreamble(m_presets[index].params);
-    ComPtr<ID3D11PixelShader> shader;
-    std::string error;
-
-    if (m_renderer.CompilePixelShader(preamble + m_presets[index].source, shader, error)) {
-        m_presets[index].isValid = true;
-        m_presets[index].compileError.clear();
-        m_compiledShaders[index] = shader;
-        return true;
-    } else {
-        m_presets[index].isValid = false;
-        m_presets[index].compileError = error;
-        return false;
-    }
+    CompiledShader compiled;
+    const bool ok = Compile(m_presets[index], compiled);
+    TrackIncludes(m_presets[index]);
+    if (!ok) return false;
+    m_compiledShaders[index] = std::move(compiled);
+    m_prewarmPending = true;
+    return true;
 }
 
-int ShaderManager::AddPreset(const ShaderPreset& preset) {
+int ShaderManager::AddPreset(const ShaderPreset& preset, bool compileAsync) {
     m_presets.push_back(preset);
-    
+    m_presets.back().isCompiling = false;
+    m_presets.back().isDeferred  = false;
+
     // Compile the shader
-    ComPtr<ID3D11PixelShader> shader;
-    std::string error;
-    
+    CompiledShader compiled;
+    bool queue = false;
+
     if (m_presets.back().isValid || !m_presets.back().source.empty()) {
         // Only parse if params not already set. During startup, Application::Initialize
         // calls LoadShaderMetadataFromFile (which parses ISF without compiling) then
@@ -144,24 +575,27 @@ int ShaderManager::AddPreset(const ShaderPreset& preset) {
         if (m_presets.back().params.empty()) {
             m_presets.back().params = ParseISFParams(m_presets.back().source,
                                                       &m_presets.back().isGenerative,
-                                                      &m_presets.back().isAudio);
-        }
-        std::string preamble = BuildDefinesPreamble(m_presets.back().params);
-        if (m_renderer.CompilePixelShader(preamble + m_presets.back().source, shader, error)) {
-            m_presets.back().isValid = true;
-            m_presets.back().compileError.clear();
-        } else {
-            m_presets.back().isValid = false;
-            m_presets.back().compileError = error;
+                                                      &m_presets.back().isAudio,
+                                                      &m_presets.back().passes,
+                                                      &m_presets.back().frameHistory,
+                                                      &m_presets.back().compute,
+                                                      &m_presets.back().videoMips);
         }
+        if (!compileAsync)                              Compile(m_presets.back(), compiled);
+        else if (m_lazyCompile && preset.shortcutKey == 0) m_presets.back().isDeferred = true;
+        else                                            queue = true;
     }
-    
-    m_compiledShaders.push_back(shader);
+
+    m_compiledShaders.push_back(std::move(compiled));
+    if (queue) CompilePresetAsync(static_cast<int>(m_presets.size()) - 1);
+    m_prewarmPending = true;
 
     // Track file timestamp for hot reload
     if (!preset.filepath.empty() && std::filesystem::exists(preset.filepath)) {
         m_fileTimestamps[preset.filepath] = std::filesystem::last_write_time(preset.filepath);
+        WatchPresetFile(preset.filepath);
     }
+    TrackIncludes(m_presets.back());
 
     return static_cast<int>(m_presets.size()) - 1;
 }
@@ -190,23 +624,26 @@ void ShaderManager::UpdatePreset(int index, const ShaderPreset& preset) {
 
     std::string oldPath = m_presets[index].filepath;
     m_presets[index] = preset;
+    m_presets[index].isCompiling = false;
+    m_presets[index].isDeferred  = false;
+    m_compiledShaders[index].ticket = 0;  // Supersedes a pending background compile
 
     // Recompile
-    ComPtr<ID3D11PixelShader> shader;
-    std::string error;
+    CompiledShader compiled;
     
     m_presets[index].params = ParseISFParams(preset.source,
                                               &m_presets[index].isGenerative,
-                                              &m_presets[index].isAudio);
-    std::string preamble = BuildDefinesPreamble(m_presets[index].params);
-
-    if (m_renderer.CompilePixelShader(preamble + preset.source, shader, error)) {
-        m_presets[index].isValid = true;
-        m_presets[index].compileError.clear();
-        m_compiledShaders[index] = shader;
-    } else {
-        m_presets[index].isValid = false;
-        m_presets[index].compileError = error;
+                                              &m_presets[index].isAudio,
+                                              &m_presets[index].passes,
+                                              &m_presets[index].frameHistory,
+                                              &m_presets[index].compute,
+                                              &m_presets[index].videoMips);
+
+    if (Compile(m_presets[index], compiled)) {
+        m_compiledShaders[index] = std::move(compiled);
+        m_prewarmPending = true;
+        // Hot reload of the shader on screen: hand the renderer the new one
+        if (index == m_activeIndex) SetActivePreset(index);
     }
 
     // Update file tracking
@@ -215,7 +652,9 @@ void ShaderManager::UpdatePreset(int index, const ShaderPreset& preset) {
     }
     if (!preset.filepath.empty() && std::filesystem::exists(preset.filepath)) {
         m_fileTimestamps[preset.filepath] = std::filesystem::last_write_time(preset.filepath);
+        WatchPresetFile(preset.filepath);
     }
+    TrackIncludes(m_presets[index]);
 }
 
 ShaderPreset* ShaderManager::GetPreset(int index) {
@@ -227,11 +666,225 @@ void ShaderManager::SetActivePreset(int index) {
     if (index < 0 || index >= static_cast<int>(m_presets.size())) {
         m_activeIndex = -1;
         m_renderer.SetActivePixelShader(nullptr);
+        m_renderer.SetFrameHistory({});
+        m_renderer.SetVideoMips(false);
         return;
     }
 
     m_activeIndex = index;
-    m_renderer.SetActivePixelShader(m_compiledShaders[index].Get());
+    m_measureSince = m_renderer.GetGpuProfiler().GetFrameCount() + 1;  // Frames drawn from here on
+    if (m_presets[index].isDeferred) CompilePresetAsync(index);  // First use in library mode
+    // The neighbours are a next/previous away: compiled and then warmed ahead
+    PrefetchPreset(index - 1);
+    PrefetchPreset(index + 1);
+    m_prewarmPending = true;
+    CompiledShader& compiled = m_compiledShaders[index];
+    compiled.lastUse = m_useClock;
+    if (compiled.ticket != 0) {
+        // Still compiling: jump the queue. The renderer shows passthrough until
+        // PollCompiles lands the result and calls back in here.
+        std::lock_guard<std::mutex> lock(m_compileMutex);
+        auto job = std::find_if(m_compileJobs.begin(), m_compileJobs.end(),
+                                [&](const CompileJob& queued) { return queued.ticket == compiled.ticket; });
+        if (job != m_compileJobs.end() && job != m_compileJobs.begin()) {
+            CompileJob moved = std::move(*job);
+            m_compileJobs.erase(job);
+            m_compileJobs.push_front(std::move(moved));
+        }
+    }
+    ApplyToRenderer(compiled, m_presets[index], m_presets[index].isTimeVarying, m_presets[index].bindings, false);
+    compiled.appliedVariant = 0;
+    m_renderer.SetFrameHistory(m_presets[index].frameHistory);
+    m_renderer.SetVideoMips(m_presets[index].videoMips);
+}
+
+void ShaderManager::RecordGpuTime(const GpuFrameTiming& latest) {
+    if (m_activeIndex < 0 || latest.frame < m_measureSince || latest.frame <= m_lastMeasuredFrame) return;
+    m_lastMeasuredFrame = latest.frame;
+    const float ms = latest.ms[static_cast<size_t>(GpuStage::Shader)];
+    if (ms <= 0.0f) return;
+    float& measured = m_presets[m_activeIndex].measuredGpuMs;
+    measured = measured > 0.0f ? measured + (ms - measured) * GPU_TIME_SMOOTHING : ms;
+}
+
+void ShaderManager::PrefetchPreset(int index) {
+    if (index < 0 || index >= static_cast<int>(m_presets.size())) return;
+    m_prewarmPending = true;  // A new shortcut, or a new neighbour
+    if (m_presets[index].isDeferred) CompilePresetAsync(index);
+}
+
+bool ShaderManager::PrewarmNext() {
+    if (!m_prewarmPending) return false;
+    for (int i = 0; i < static_cast<int>(m_presets.size()); ++i) {
+        const bool wanted = m_presets[i].shortcutKey != 0 || (m_activeIndex >= 0 && std::abs(i - m_activeIndex) == 1);
+        CompiledShader& compiled = m_compiledShaders[i];
+        if (!wanted || i == m_activeIndex || compiled.prewarmed) continue;
+        if (!compiled.shader && compiled.kernels.empty()) continue;  // Not compiled (yet); its landing re-arms this
+
+        // In the format each draws into: the last pass (unless persistent) and a
+        // single shader into RGBA8 display-size targets
+        const ShaderPreset& preset = m_presets[i];
+        if (!compiled.kernels.empty()) {
+            for (const auto& kernel : compiled.kernels)
+                m_renderer.PrewarmComputeShader(kernel.shader.Get(), preset.compute.format);
+        } else if (compiled.passes.empty()) {
+            m_renderer.PrewarmPixelShader(compiled.shader.Get(), PassFormat::RGBA8);
+        } else {
+            for (size_t p = 0; p < compiled.passes.size(); ++p) {
+                const RenderPassDesc& desc = compiled.passes[p].desc;
+                const bool toDisplay = p + 1 == compiled.passes.size() && !desc.persistent;
+                m_renderer.PrewarmPixelShader(compiled.passes[p].shader.Get(), toDisplay ? PassFormat::RGBA8 : desc.format);
+            }
+        }
+        compiled.prewarmed = true;
+        return true;  // One preset a step
+    }
+    m_prewarmPending = false;
+    return false;
+}
+
+void ShaderManager::SetResidencyBudget(int maxShaders) {
+    m_residencyBudget = std::max(maxShaders, 0);
+}
+
+int ShaderManager::ShaderObjectCount(const CompiledShader& compiled) {
+    int count = static_cast<int>(compiled.kernels.size());
+    if (compiled.points.vertexShader) count += 2;
+    count += compiled.passes.empty() ? (compiled.shader ? 1 : 0) : static_cast<int>(compiled.passes.size());
+    for (const ShaderVariant& variant : compiled.variants) count += ShaderObjectCount(variant.compiled);
+    return count;
+}
+
+void ShaderManager::UpdateResidency() {
+    const uint64_t now = m_useClock++;
+    m_residentPresets = 0;
+    m_residentShaders = 0;
+    std::vector<std::pair<uint64_t, int>> candidates;  // (last use, index), evictable
+    for (int i = 0; i < static_cast<int>(m_compiledShaders.size()); ++i) {
+        const CompiledShader& compiled = m_compiledShaders[i];
+        const int count = ShaderObjectCount(compiled);
+        if (count == 0) continue;
+        ++m_residentPresets;
+        m_residentShaders += count;
+        const bool pinned = i == m_activeIndex || (m_activeIndex >= 0 && std::abs(i - m_activeIndex) == 1) ||
+                            m_presets[i].shortcutKey != 0 || compiled.lastUse >= now ||
+                            compiled.ticket != 0 || compiled.variantTicket != 0;
+        if (!pinned) candidates.push_back({compiled.lastUse, i});
+    }
+    if (m_residencyBudget == 0 || m_residentShaders <= m_residencyBudget) return;
+
+    // Least recently used first. The renderer drops its references when it next
+    // switches shader; a layer or post stage still holding one was pinned above.
+    std::sort(candidates.begin(), candidates.end());
+    for (const auto& [lastUse, i] : candidates) {
+        if (m_residentShaders <= m_residencyBudget) break;
+        m_residentShaders -= ShaderObjectCount(m_compiledShaders[i]);
+        --m_residentPresets;
+        m_compiledShaders[i] = CompiledShader{};
+        m_compiledShaders[i].evicted = true;
+        m_presets[i].isDeferred = true;
+        ++m_evictions;
+    }
+}
+
+ShaderManager::ResidencyStats ShaderManager::GetResidencyStats() const {
+    return { m_residentPresets, m_residentShaders, m_residencyBudget, m_evictions, m_residencyReloads };
+}
+
+void ShaderManager::ApplyToRenderer(const CompiledShader& compiled, const ShaderPreset& preset,
+                                    bool isTimeVarying, const ShaderBindings& bindings, bool keepState) {
+    if (!compiled.kernels.empty()) {
+        if (!keepState || !m_renderer.SwapComputeKernels(compiled.kernels, compiled.points, isTimeVarying))
+            m_renderer.SetActiveCompute(compiled.kernels, compiled.points, preset.compute, isTimeVarying);
+    } else if (compiled.passes.empty()) {
+        m_renderer.SetActivePixelShader(compiled.shader.Get(), isTimeVarying);
+        m_renderer.SetFusedBlendMode(compiled.fusedBlendMode);
+    } else if (!keepState || !m_renderer.SwapRenderGraphShaders(compiled.passes, isTimeVarying)) {
+        m_renderer.SetActiveRenderGraph(compiled.passes, isTimeVarying);
+    }
+    m_renderer.SetActiveBindings(bindings);
+}
+
+uint64_t ShaderManager::SpecializationKey(const ShaderPreset& preset, const CompiledShader& generic) {
+    uint64_t key = Fnv1a64(nullptr, 0);
+    const int blendMode = generic.canFuseBlend ? preset.blendMode : 0;
+    bool any = blendMode > 0;
+    if (any) key = Fnv1a64(reinterpret_cast<const char*>(&blendMode), sizeof(blendMode), key);
+    for (size_t i = 0; i < preset.params.size(); ++i) {
+        const ShaderParam& p = preset.params[i];
+        if (!p.specialize) continue;
+        const int32_t value[2] = {static_cast<int32_t>(i), static_cast<int32_t>(std::lround(p.values[0]))};
+        key = Fnv1a64(reinterpret_cast<const char*>(value), sizeof(value), key);
+        any = true;
+    }
+    return any ? (key | 1) : 0;  // Never 0, which means generic
+}
+
+void ShaderManager::UpdateSpecialization() {
+    if (m_activeIndex < 0 || m_activeIndex >= static_cast<int>(m_presets.size())) return;
+    CompiledShader& compiled = m_compiledShaders[m_activeIndex];
+    const ShaderPreset& preset = m_presets[m_activeIndex];
+    if (!compiled.shader && compiled.kernels.empty()) return;  // No generic shader to vary
+    const uint64_t key = SpecializationKey(preset, compiled);
+    if (key == compiled.appliedVariant) return;
+
+    auto variant = std::find_if(compiled.variants.begin(), compiled.variants.end(),
+                                [&](const ShaderVariant& v) { return v.key == key; });
+    if (variant != compiled.variants.end()) {
+        std::rotate(variant, variant + 1, compiled.variants.end());  // Most recently used last
+        const ShaderVariant& used = compiled.variants.back();
+        ApplyToRenderer(used.compiled, preset, used.isTimeVarying, used.bindings, true);
+        compiled.appliedVariant = key;
+        return;
+    }
+    // The baked values no longer match: the generic shader reads them from the cbuffer
+    if (compiled.appliedVariant != 0) {
+        ApplyToRenderer(compiled, preset, preset.isTimeVarying, preset.bindings, true);
+        compiled.appliedVariant = 0;
+    }
+    // Not while a new generic shader is pending: its landing drops the variants
+    if (key != 0 && key != compiled.variantPending && compiled.ticket == 0) QueueVariant(m_activeIndex, key);
+}
+
+bool ShaderManager::GetLayer(const std::string& name, D3D11Renderer::Layer& out) {
+    auto found = std::find_if(m_presets.begin(), m_presets.end(),
+                              [&](const ShaderPreset& preset) { return preset.name == name; });
+    if (found == m_presets.end()) return false;
+    const int index = static_cast<int>(found - m_presets.begin());
+    if (found->isDeferred) CompilePresetAsync(index);
+    CompiledShader& compiled = m_compiledShaders[index];
+    compiled.lastUse = m_useClock;
+    if (!found->isValid || !compiled.shader || !compiled.passes.empty() || !compiled.kernels.empty()) return false;
+
+    out.shader      = compiled.shader;  // Generic: the layer's values come from its cbuffer
+    out.bindings    = found->bindings;
+    out.timeVarying = found->isTimeVarying;
+    PackParamValues(*found, out.custom);
+    float extended[MAX_EXTENDED_PARAM_FLOATS];
+    out.params.assign(extended, extended + PackExtendedParams(*found, extended));
+    return true;
+}
+
+bool ShaderManager::GetPostStage(const std::string& name, D3D11Renderer::PostStage& out) {
+    auto found = std::find_if(m_presets.begin(), m_presets.end(),
+                              [&](const ShaderPreset& preset) { return preset.name == name; });
+    if (found == m_presets.end()) return false;
+    const int index = static_cast<int>(found - m_presets.begin());
+    if (found->isDeferred) CompilePresetAsync(index);
+    CompiledShader& compiled = m_compiledShaders[index];
+    compiled.lastUse = m_useClock;
+    if (!found->isValid || !compiled.passes.empty() || (!compiled.shader && compiled.kernels.empty())) return false;
+
+    out.shader      = compiled.kernels.empty() ? compiled.shader : nullptr;
+    out.kernels     = compiled.kernels;
+    out.points      = compiled.points;
+    out.compute     = found->compute;
+    out.bindings    = found->bindings;
+    out.timeVarying = found->isTimeVarying;
+    PackParamValues(*found, out.custom);
+    float extended[MAX_EXTENDED_PARAM_FLOATS];
+    out.params.assign(extended, extended + PackExtendedParams(*found, extended));
+    return true;
 }
 
 ShaderPreset* ShaderManager::GetActivePreset() {
@@ -245,73 +898,315 @@ ID3D11PixelShader* ShaderManager::GetActiveShader() {
     if (m_activeIndex < 0 || m_activeIndex >= static_cast<int>(m_compiledShaders.size())) {
         return m_renderer.GetPassthroughShader();
     }
-    return m_compiledShaders[m_activeIndex].Get();
+    return m_compiledShaders[m_activeIndex].shader.Get();
 }
 
 void ShaderManager::SetPassthrough() {
     m_activeIndex = -1;
     m_renderer.SetActivePixelShader(nullptr);
+    m_renderer.SetFrameHistory({});
+    m_renderer.SetVideoMips(false);
 }
 
 void ShaderManager::EnableFileWatching(bool enable) {
     m_fileWatchingEnabled = enable;
+    if (!enable) {
+        m_fileWatcher.Stop();
+        return;
+    }
+    for (const ShaderPreset& preset : m_presets) {
+        WatchPresetFile(preset.filepath);
+        for (const std::string& include : preset.includes) WatchPresetFile(include);
+    }
 }
 
-void ShaderManager::CheckForChanges() {
-    if (!m_fileWatchingEnabled) return;
+void ShaderManager::WatchPresetFile(const std::string& filepath) {
+    if (!m_fileWatchingEnabled || filepath.empty()) return;
+    m_fileWatcher.Watch(WatchPath(filepath).parent_path());  // Else polled by CheckForChanges
+}
 
-    for (int i = 0; i < static_cast<int>(m_presets.size()); ++i) {
-        const std::string& filepath = m_presets[i].filepath;
-        if (filepath.empty()) continue;
+void ShaderManager::TrackIncludes(const ShaderPreset& preset) {
+    for (const std::string& include : preset.includes) {
+        std::error_code ec;
+        const auto time = std::filesystem::last_write_time(include, ec);
+        // Shared headers keep the time of the first sighting until CheckForChanges moves it
+        if (!ec) m_fileTimestamps.emplace(include, time);
+        WatchPresetFile(include);
+    }
+}
 
-        if (!std::filesystem::exists(filepath)) continue;
+void ShaderManager::SetIncludeDirectory(const std::string& directory) {
+    std::error_code ec;
+    const std::filesystem::path absolute = std::filesystem::absolute(directory, ec);
+    std::lock_guard<std::mutex> lock(m_compileMutex);
+    m_includeDirectory = ec ? std::filesystem::path(directory) : absolute.lexically_normal();
+}
 
-        auto currentTime = std::filesystem::last_write_time(filepath);
+void ShaderManager::CheckForChanges() {
+    if (!m_fileWatchingEnabled) return;
+
+    // Usually nothing to do: the watcher thread has seen no writes
+    m_fileWatcher.TakeChanges(m_changedFiles, m_changedDirectories);
+    const auto now = std::chrono::steady_clock::now();
+    const bool poll = now - m_lastUnwatchedPoll >= UNWATCHED_POLL_INTERVAL;
+    if (poll) m_lastUnwatchedPoll = now;
+    if (m_changedFiles.empty() && m_changedDirectories.empty() && !poll) return;
+
+    auto listed = [](const std::vector<std::filesystem::path>& paths, const std::filesystem::path& path) {
+        return std::find(paths.begin(), paths.end(), path) != paths.end();
+    };
+    // Notified, in an overflowed directory, or in one that can't notify; and
+    // written since its last known time
+    auto written = [&](const std::string& filepath) {
+        const std::filesystem::path path = WatchPath(filepath);
+        const std::filesystem::path directory = path.parent_path();
+        if (!listed(m_changedFiles, path) && !listed(m_changedDirectories, directory) &&
+            !(poll && !m_fileWatcher.IsWatching(directory))) {
+            return false;
+        }
+        std::error_code ec;
+        const auto currentTime = std::filesystem::last_write_time(filepath, ec);
+        if (ec) return false;  // Deleted, or mid-replace: a later event brings it back
         auto it = m_fileTimestamps.find(filepath);
-        
-        if (it != m_fileTimestamps.end() && currentTime != it->second) {
-            // File changed, reload
-            ShaderPreset updated;
-            if (LoadShaderFromFile(filepath, updated)) {
-                // Preserve keybinding; note: param values reset to ISF defaults
-                // on hot-reload (UpdatePreset is a wholesale replace by design).
-                updated.shortcutKey = m_presets[i].shortcutKey;
-                updated.shortcutModifiers = m_presets[i].shortcutModifiers;
-                UpdatePreset(i, updated);
+        if (it == m_fileTimestamps.end() || currentTime == it->second) return false;
+        it->second = currentTime;
+        return true;
+    };
+    // Asked once per file: a shared header, or a preset another one includes,
+    // answers the same for every preset
+    std::unordered_map<std::string, bool> checked;
+    auto changed = [&](const std::string& filepath) {
+        auto [it, inserted] = checked.emplace(filepath, false);
+        if (inserted) it->second = written(filepath);
+        return it->second;
+    };
+
+    for (int i = 0; i < static_cast<int>(m_presets.size()); ++i) {
+        ShaderPreset& preset = m_presets[i];
+        bool reload = false;
+        for (const std::string& include : preset.includes) reload = changed(include) || reload;
+
+        // Reloaded like an editor compile: in the background, param values and
+        // keybinding kept, the last good shader running if the new source fails
+        if (!preset.filepath.empty() && changed(preset.filepath)) {
+            std::ifstream file(preset.filepath);
+            if (file.is_open()) {
+                std::stringstream buffer;
+                buffer << file.rdbuf();
+                preset.source = buffer.str();
+                reload = true;
+                if (preset.isDeferred) {
+                    // Not compiled yet: the new params are all there is to take
+                    std::vector<ShaderParam> params = ParseISFParams(preset.source, &preset.isGenerative,
+                                                                     &preset.isAudio, &preset.passes,
+                                                                     &preset.frameHistory, &preset.compute,
+                                                                     &preset.videoMips);
+                    CarryParamValues(preset.params, params);
+                    preset.params = std::move(params);
+                }
             }
-            m_fileTimestamps[filepath] = currentTime;
         }
+        // Every preset an edited header reaches compiles at once, on the pool;
+        // a deferred one reads the new header when it first compiles
+        if (reload && !preset.isDeferred) RecompilePresetAsync(i);
     }
 }
 
 void ShaderManager::ScanDirectory(const std::string& directory) {
+    FinishLibraryLoad(true);  // The index is the worker's until then
     if (!std::filesystem::exists(directory)) return;
 
-    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
-        if (!entry.is_regular_file()) continue;
+    // A rescan of a large library is mostly files already loaded: one lookup each
+    std::unordered_set<std::string> loaded;
+    loaded.reserve(m_presets.size());
+    for (const ShaderPreset& preset : m_presets) loaded.insert(preset.filepath);
+    const std::vector<std::string> present = ListShaderFiles(directory);
+    std::vector<std::string> added;
+    for (const std::string& filepath : present) {
+        if (!loaded.count(filepath)) added.push_back(filepath);
+    }
+
+    // Parsed (or taken from the index) in parallel, compiled once in the
+    // background, or on first use in library mode
+    LoadLibraryIndex();
+    m_libraryIndex.Prune(directory, present);
+    for (ShaderPreset& preset : LoadMetadataFromFiles(added)) {
+        if (preset.filepath.empty()) continue;
+        preset.folder = LibraryFolder(preset.filepath, directory);
+        AddPreset(preset, true);
+    }
+}
+
+/*static*/ std::vector<std::string> ShaderManager::ListShaderFiles(const std::string& directory) {
+    std::vector<std::string> files;
+    std::error_code ec;
+    std::filesystem::recursive_directory_iterator it(
+        directory, std::filesystem::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        const std::filesystem::directory_entry& entry = *it;
+        std::error_code typeError;
+        if (entry.is_directory(typeError)) {
+            // .git, .vscode and the like hold no presets
+            if (entry.path().filename().string().rfind('.', 0) == 0) it.disable_recursion_pending();
+            continue;
+        }
+        if (!entry.is_regular_file(typeError)) continue;
 
         std::string ext = entry.path().extension().string();
         // Convert to lowercase
         for (char& c : ext) c = static_cast<char>(std::tolower(c));
+        if (ext == ".hlsl" || ext == ".fx" || ext == ".ps") files.push_back(entry.path().string());
+    }
+    // Directory order is the filesystem's: sorted, so a folder's presets stay together
+    std::sort(files.begin(), files.end());
+    return files;
+}
 
-        if (ext == ".hlsl" || ext == ".fx" || ext == ".ps") {
-            // Check if already loaded
-            std::string filepath = entry.path().string();
-            bool alreadyLoaded = false;
-            for (const auto& preset : m_presets) {
-                if (preset.filepath == filepath) {
-                    alreadyLoaded = true;
-                    break;
-                }
+void ShaderManager::LoadLibraryAsync(std::vector<ShaderPreset> configPresets, std::string directory) {
+    FinishLibraryLoad(true);
+    m_libraryLoaded = false;
+    m_libraryThread = std::thread(&ShaderManager::LibraryLoadThread, this, std::move(configPresets),
+                                  std::move(directory));
+}
+
+void ShaderManager::LibraryLoadThread(std::vector<ShaderPreset> configPresets, std::string directory) {
+    TraceRecorder::SetThreadName("Library load");
+    // Touches the index and m_loadedLibrary only: presets are added on the main thread
+    std::vector<std::string> filepaths;
+    filepaths.reserve(configPresets.size());
+    for (const ShaderPreset& configPreset : configPresets) filepaths.push_back(configPreset.filepath);
+    std::vector<ShaderPreset> loaded = LoadMetadataFromFiles(filepaths);
+    for (size_t i = 0; i < loaded.size(); ++i) {
+        ShaderPreset& preset = loaded[i];
+        if (preset.filepath.empty()) continue;
+        preset.shortcutKey       = configPresets[i].shortcutKey;
+        preset.shortcutModifiers = configPresets[i].shortcutModifiers;
+        RestoreSavedValues(preset, configPresets[i]);
+        preset.folder = LibraryFolder(preset.filepath, directory);
+        m_loadedLibrary.push_back(std::move(preset));
+    }
+
+    // Then the directory's files the config doesn't list, its subfolders included
+    if (std::filesystem::exists(directory)) {
+        const std::unordered_set<std::string> listed(filepaths.begin(), filepaths.end());
+        const std::vector<std::string> present = ListShaderFiles(directory);
+        std::vector<std::string> added;
+        for (const std::string& filepath : present) {
+            if (!listed.count(filepath)) added.push_back(filepath);
+        }
+        m_libraryIndex.Prune(directory, present);
+        for (ShaderPreset& preset : LoadMetadataFromFiles(added)) {
+            if (preset.filepath.empty()) continue;
+            preset.folder = LibraryFolder(preset.filepath, directory);
+            m_loadedLibrary.push_back(std::move(preset));
+        }
+    }
+    m_libraryLoaded.store(true, std::memory_order_release);
+}
+
+bool ShaderManager::FinishLibraryLoad(bool wait) {
+    if (!m_libraryThread.joinable()) return false;
+    if (!wait && !m_libraryLoaded.load(std::memory_order_acquire)) return false;
+    m_libraryThread.join();
+    std::vector<ShaderPreset> loaded = std::move(m_loadedLibrary);
+    m_loadedLibrary.clear();
+    // Dropped in while the load ran
+    std::unordered_set<std::string> existing;
+    for (const ShaderPreset& preset : m_presets) existing.insert(preset.filepath);
+    for (const ShaderPreset& preset : loaded) {
+        if (existing.insert(preset.filepath).second) AddPreset(preset, true);
+    }
+    return true;
+}
+
+/*static*/ void ShaderManager::RestoreSavedValues(ShaderPreset& preset, const ShaderPreset& saved) {
+    for (auto& param : preset.params) {
+        auto it = saved.savedParamValues.find(param.name);
+        if (it != saved.savedParamValues.end()) {
+            const auto& vals = it->second;
+            for (int i = 0; i < 4 && i < static_cast<int>(vals.size()); ++i)
+                param.values[i] = vals[i];
+        }
+        auto kit = saved.savedKeyframes.find(param.name);
+        if (kit != saved.savedKeyframes.end()) {
+            param.timeline = kit->second;
+        }
+    }
+    if (!saved.modulations.empty()) {
+        preset.modulations = saved.modulations;
+        ++preset.modulationRevision;
+    }
+}
+
+/*static*/ void ShaderManager::PackParamValues(const ShaderPreset& preset, float out[16]) {
+    std::fill(out, out + 16, 0.0f);
+    for (const auto& p : preset.params) {
+        if (p.cbufferOffset < 0) continue;  // AudioBand lives in b1, Image is a texture
+        const int off = p.cbufferOffset;
+        switch (p.type) {
+        case ShaderParamType::Float:
+        case ShaderParamType::Bool:
+        case ShaderParamType::Long:
+        case ShaderParamType::Event:
+            if (off < 16)       out[off] = p.values[0];
+            break;
+        case ShaderParamType::Point2D:
+            if (off + 1 < 16) { out[off] = p.values[0]; out[off + 1] = p.values[1]; }
+            break;
+        case ShaderParamType::Color:
+            if (off + 3 < 16) {
+                out[off] = p.values[0]; out[off + 1] = p.values[1];
+                out[off + 2] = p.values[2]; out[off + 3] = p.values[3];
             }
+            break;
+        }
+    }
+}
 
-            if (!alreadyLoaded) {
-                ShaderPreset preset;
-                LoadShaderFromFile(filepath, preset);
-                AddPreset(preset);
+/*static*/ int ShaderManager::PackExtendedParams(const ShaderPreset& preset, float out[MAX_EXTENDED_PARAM_FLOATS]) {
+    int count = 0;
+    for (const auto& p : preset.params) {
+        if (p.cbufferOffset < CUSTOM_PARAM_FLOATS) continue;  // custom[], or no slot at all
+        const int off  = p.cbufferOffset - CUSTOM_PARAM_FLOATS;
+        const int size = p.type == ShaderParamType::Point2D ? 2 : p.type == ShaderParamType::Color ? 4 : 1;
+        if (off + size > MAX_EXTENDED_PARAM_FLOATS) continue;
+        for (; count < off; ++count) out[count] = 0.0f;  // Alignment gaps
+        std::copy_n(p.values, size, out + off);
+        count = off + size;
+    }
+    return count;
+}
+
+/*static*/ bool ShaderManager::EvaluateKeyframes(ShaderPreset& preset, double time) {
+    bool anyChanged = false;
+
+    for (auto& p : preset.params) {
+        if (!p.timeline || !p.timeline->enabled) continue;
+
+        int valueCount = 1;
+        if (p.type == ShaderParamType::Point2D) valueCount = 2;
+        else if (p.type == ShaderParamType::Color) valueCount = 4;
+
+        // For Bool/Long: step interpolation (snap to nearest keyframe, no lerp).
+        // Evaluate still returns lerped values; we snap afterwards.
+        float interpolated[4] = {};
+        if (p.timeline->Evaluate(static_cast<float>(time), interpolated, valueCount)) {
+            for (int i = 0; i < valueCount; ++i) {
+                float val = interpolated[i];
+                // Step types: snap to 0 or 1 (bool) or round to int (long)
+                if (p.type == ShaderParamType::Bool)
+                    val = (val >= 0.5f) ? 1.0f : 0.0f;
+                else if (p.type == ShaderParamType::Long)
+                    val = std::round(val);
+
+                if (p.values[i] != val) {
+                    p.values[i] = val;
+                    anyChanged = true;
+                }
             }
         }
     }
+    return anyChanged;
 }
 
 std::string ShaderManager::GetShaderTemplate() {
@@ -359,13 +1254,71 @@ float4 main(PS_INPUT input) : SV_TARGET {
 )";
 }
 
+namespace {
+
+// ISF pass size: "$WIDTH", "$WIDTH/2", "$HEIGHT*0.25" (of the render size) or pixels
+void ParsePassSize(const nlohmann::json& value, float& scale, int& pixels) {
+    if (value.is_number()) {
+        pixels = std::max(1, static_cast<int>(value.get<float>()));
+        return;
+    }
+    if (!value.is_string()) return;
+    std::string expr;
+    for (char c : value.get<std::string>()) {
+        if (c != ' ') expr += c;
+    }
+    if (expr.rfind("$WIDTH", 0) == 0) {
+        expr.erase(0, 6);
+    } else if (expr.rfind("$HEIGHT", 0) == 0) {
+        expr.erase(0, 7);
+    } else {
+        pixels = std::max(1, std::atoi(expr.c_str()));
+        return;
+    }
+    const float operand = expr.size() > 1 ? std::strtof(expr.c_str() + 1, nullptr) : 0.0f;
+    if (expr.empty())                          scale = 1.0f;
+    else if (expr[0] == '/' && operand > 0.0f) scale = 1.0f / operand;
+    else if (expr[0] == '*' && operand > 0.0f) scale = operand;
+}
+
+// ISF FORMAT of a pass target or compute output; unknown names keep `format`
+void ParsePassFormat(const std::string& name, PassFormat& format) {
+    if (name == "rgba8")         format = PassFormat::RGBA8;
+    else if (name == "rgba16f")  format = PassFormat::RGBA16F;
+    else if (name == "rgba32f")  format = PassFormat::RGBA32F;
+    else if (name == "rg11b10f") format = PassFormat::RG11B10F;
+    else if (name == "r32f")     format = PassFormat::R32F;
+}
+
+// Compute dispatch groups: a count, or "$WIDTH/16", "$HEIGHT" (of the render size)
+void ParseGroupCount(const nlohmann::json& value, int& groups, int& sizeAxis, float& sizeScale) {
+    if (value.is_string()) {
+        const std::string expr = value.get<std::string>();
+        if (expr.find("$WIDTH") != std::string::npos)       sizeAxis = 0;
+        else if (expr.find("$HEIGHT") != std::string::npos) sizeAxis = 1;
+    }
+    int fixed = 0;
+    ParsePassSize(value, sizeScale, fixed);
+    if (sizeAxis < 0) groups = fixed;
+}
+
+} // namespace
+
 std::vector<ShaderParam> ShaderManager::ParseISFParams(const std::string& source,
                                                          bool* outIsGenerative,
-                                                         bool* outIsAudio) {
+                                                         bool* outIsAudio,
+                                                         std::vector<RenderPassDesc>* outPasses,
+                                                         FrameHistoryDesc* outHistory,
+                                                         ComputeDesc* outCompute,
+                                                         bool* outVideoMips) {
     // Find the ISF block: /*{ ... }*/
     const std::string openTag  = "/*{";
     const std::string closeTag = "}*/";
 
+    if (outPasses) outPasses->clear();
+    if (outHistory) *outHistory = FrameHistoryDesc{};
+    if (outCompute) *outCompute = ComputeDesc{};
+    if (outVideoMips) *outVideoMips = false;
     auto startPos = source.find(openTag);
     if (startPos == std::string::npos) return {};
 
@@ -377,7 +1330,9 @@ std::vector<ShaderParam> ShaderManager::ParseISFParams(const std::string& source
                                                 endPos - startPos - openTag.size()) + "}";
 
     std::vector<ShaderParam> params;
-    int offset = 0;  // Current float index into custom[16]
+    int offset = 0;  // Current float index into custom[16], then spParams[]
+    int imageInputs = 0;  // Extra video inputs declared so far
+    int lutInputs   = 0;  // Colour LUTs declared so far
 
     try {
         nlohmann::json j = nlohmann::json::parse(jsonText);
@@ -386,6 +1341,94 @@ std::vector<ShaderParam> ShaderManager::ParseISFParams(const std::string& source
         if (outIsGenerative) *outIsGenerative = (shaderType == "generative");
         if (outIsAudio)      *outIsAudio      = (shaderType == "audio");
 
+        // Compute: THREADS, CLEAR, FORMAT, BUFFERS, DISPATCHES and DRAW
+        if (outCompute && shaderType == "compute") {
+            outCompute->enabled = true;
+            if (j.contains("THREADS") && j["THREADS"].is_array() && !j["THREADS"].empty()) {
+                const auto& threads = j["THREADS"];
+                outCompute->threadsX = std::clamp(threads[0].is_number() ? threads[0].get<int>() : 8, 1, 1024);
+                outCompute->threadsY = std::clamp(threads.size() > 1 && threads[1].is_number() ? threads[1].get<int>() : 1,
+                                                  1, 1024 / outCompute->threadsX);  // cs_5_0: 1024 threads per group
+            }
+            outCompute->clearOutput = j.value("CLEAR", true);
+            ParsePassFormat(j.value("FORMAT", std::string{}), outCompute->format);
+            if (j.contains("BUFFERS") && j["BUFFERS"].is_array()) {
+                for (const auto& entry : j["BUFFERS"]) {
+                    if (static_cast<int>(outCompute->buffers.size()) >= MAX_COMPUTE_BUFFERS) break;
+                    ComputeBufferDesc buffer;
+                    buffer.name   = entry.value("NAME", std::string{});
+                    buffer.stride = (std::clamp(entry.value("STRIDE", 4), 4, 2048) + 3) / 4 * 4;
+                    buffer.count  = std::clamp(entry.value("COUNT", 1), 1,
+                                               static_cast<int>(MAX_COMPUTE_BUFFER_BYTES / buffer.stride));
+                    buffer.persistent = entry.value("PERSISTENT", true);
+                    if (!buffer.name.empty()) outCompute->buffers.push_back(std::move(buffer));
+                }
+            }
+            if (j.contains("DISPATCHES") && j["DISPATCHES"].is_array()) {
+                for (const auto& entry : j["DISPATCHES"]) {
+                    if (static_cast<int>(outCompute->dispatches.size()) >= MAX_COMPUTE_DISPATCHES) break;
+                    ComputeDispatch dispatch;
+                    if (entry.contains("GROUPS") && entry["GROUPS"].is_array()) {
+                        for (size_t a = 0; a < 2 && a < entry["GROUPS"].size(); ++a) {
+                            ParseGroupCount(entry["GROUPS"][a], dispatch.groups[a], dispatch.sizeAxis[a],
+                                            dispatch.sizeScale[a]);
+                        }
+                    }
+                    outCompute->dispatches.push_back(dispatch);
+                }
+            }
+            // DRAW: { "BUFFER": name, "SIZE": pixels, "BLEND": "add" | "alpha" }
+            if (j.contains("DRAW") && j["DRAW"].is_object()) {
+                const auto& draw = j["DRAW"];
+                const std::string name = draw.value("BUFFER", std::string{});
+                for (size_t i = 0; i < outCompute->buffers.size(); ++i) {
+                    if (outCompute->buffers[i].name == name) outCompute->draw.buffer = static_cast<int>(i);
+                }
+                outCompute->draw.size     = std::clamp(draw.value("SIZE", 1.0f), 1.0f, MAX_POINT_SIZE);
+                outCompute->draw.additive = draw.value("BLEND", std::string("add")) != "alpha";
+            }
+        }
+
+        // PASSES: each entry's TARGET becomes a texture later passes can sample.
+        // A single entry is the same as none, unless it is PERSISTENT.
+        const auto isPersistent = [](const nlohmann::json& entry) {
+            return entry.value("PERSISTENT", false) && !entry.value("TARGET", std::string{}).empty();
+        };
+        if (outPasses && shaderType != "compute" && j.contains("PASSES") && j["PASSES"].is_array() &&
+            (j["PASSES"].size() > 1 || (j["PASSES"].size() == 1 && isPersistent(j["PASSES"][0])))) {
+            for (const auto& entry : j["PASSES"]) {
+                if (static_cast<int>(outPasses->size()) >= MAX_RENDER_PASSES) break;
+                RenderPassDesc pass;
+                pass.target = entry.value("TARGET", std::string{});
+                if (entry.contains("SCALE") && entry["SCALE"].is_number()) {
+                    pass.widthScale = pass.heightScale = std::max(entry["SCALE"].get<float>(), 0.01f);
+                }
+                if (entry.contains("WIDTH"))  ParsePassSize(entry["WIDTH"], pass.widthScale, pass.width);
+                if (entry.contains("HEIGHT")) ParsePassSize(entry["HEIGHT"], pass.heightScale, pass.height);
+                if (entry.value("FLOAT", false)) pass.format = PassFormat::RGBA32F;
+                ParsePassFormat(entry.value("FORMAT", std::string{}), pass.format);
+                pass.persistent = isPersistent(entry);
+                if (pass.persistent && entry.contains("STEPS") && entry["STEPS"].is_number()) {
+                    pass.steps = std::clamp(entry["STEPS"].get<int>(), 1, MAX_PASS_STEPS);
+                }
+                outPasses->push_back(std::move(pass));
+            }
+        }
+
+        // FRAME_HISTORY: a frame count, or { "FRAMES": n, "SCALE": s }
+        if (outHistory && j.contains("FRAME_HISTORY")) {
+            const auto& history = j["FRAME_HISTORY"];
+            if (history.is_number()) {
+                outHistory->frames = history.get<int>();
+            } else if (history.is_object()) {
+                outHistory->frames = history.value("FRAMES", 0);
+                outHistory->scale  = std::clamp(history.value("SCALE", 1.0f), 0.05f, 1.0f);
+            }
+            outHistory->frames = std::clamp(outHistory->frames, 0, MAX_HISTORY_FRAMES);
+        }
+        // VIDEO_MIPS: t0 gets a mip chain for SampleLevel at coarse levels
+        if (outVideoMips) *outVideoMips = j.value("VIDEO_MIPS", false);
+
         if (!j.contains("INPUTS") || !j["INPUTS"].is_array()) return {};
 
         for (const auto& input : j["INPUTS"]) {
@@ -409,8 +1452,29 @@ std::vector<ShaderParam> ShaderManager::ParseISFParams(const std::string& source
                 p.cbufferOffset = -1;
                 params.push_back(std::move(p));
                 continue;  // Skip cbuffer alignment/offset logic below.
+            } else if (typeStr == "image") {
+                // ISF's own main input is the video at t0; every other image is an
+                // extra video input bound at t4.. in declaration order.
+                if (p.name == "inputImage" || imageInputs >= MAX_VIDEO_INPUTS) continue;
+                p.type          = ShaderParamType::Image;
+                p.inputIndex    = imageInputs++;
+                p.cbufferOffset = -1;
+                params.push_back(std::move(p));
+                continue;
+            } else if (typeStr == "lut") {
+                // A .cube/.3dl colour LUT, bound at t20.. in declaration order
+                if (lutInputs >= MAX_LUTS) continue;
+                p.type          = ShaderParamType::Lut;
+                p.inputIndex    = lutInputs++;
+                p.cbufferOffset = -1;
+                params.push_back(std::move(p));
+                continue;
             } else continue;  // Unknown type; skip
 
+            // Opt-in: the value is compiled in as a literal (UpdateSpecialization)
+            p.specialize = (p.type == ShaderParamType::Bool || p.type == ShaderParamType::Long) &&
+                           input.value("SPECIALIZE", false);
+
             if (input.contains("MIN")  && input["MIN"].is_number())  p.min  = input["MIN"].get<float>();
             if (input.contains("MAX")  && input["MAX"].is_number())  p.max  = input["MAX"].get<float>();
             if (input.contains("STEP") && input["STEP"].is_number()) p.step = input["STEP"].get<float>();
@@ -455,7 +1519,7 @@ std::vector<ShaderParam> ShaderManager::ParseISFParams(const std::string& source
             if (p.type == ShaderParamType::Point2D) size = 2;
             else if (p.type == ShaderParamType::Color) size = 4;
 
-            if (offset + size > 16) {
+            if (offset + size > CUSTOM_PARAM_FLOATS + MAX_EXTENDED_PARAM_FLOATS) {
                 // Budget exhausted; remaining INPUTS are silently dropped.
                 // D3DCompile will report 'undeclared identifier' for any shader code
                 // that references a dropped param name.
@@ -467,18 +1531,88 @@ std::vector<ShaderParam> ShaderManager::ParseISFParams(const std::string& source
             params.push_back(std::move(p));
         }
     } catch (...) {
+        if (outPasses) outPasses->clear();
+        if (outHistory) *outHistory = FrameHistoryDesc{};
+        if (outCompute) *outCompute = ComputeDesc{};
+        if (outVideoMips) *outVideoMips = false;
         return {};
     }
 
     return params;
 }
 
-std::string ShaderManager::BuildDefinesPreamble(const std::vector<ShaderParam>& params) {
+std::string ShaderManager::BuildDefinesPreamble(const std::vector<ShaderParam>& params,
+                                                const std::vector<RenderPassDesc>& passes,
+                                                const FrameHistoryDesc& history,
+                                                const ComputeDesc& compute,
+                                                bool specialize) {
     static constexpr char comp[] = "xyzw";
-    std::string preamble;
+    std::string preamble = "#define SHADER_MODEL " + std::to_string(RENDERER_SHADER_MODEL) + "\n";
+
+    // Pass targets by name; Compile adds PASSINDEX per variant
+    if (!passes.empty()) {
+        preamble += "#define PASS_COUNT " + std::to_string(passes.size()) + "\n";
+        for (size_t i = 0; i < passes.size(); ++i) {
+            if (passes[i].target.empty()) continue;
+            preamble += "Texture2D " + passes[i].target + " : register(t" +
+                        std::to_string(FIRST_PASS_SLOT + static_cast<int>(i)) + ");\n";
+        }
+    }
+
+    // Compute kernels: group size, the frame they write and their buffers'
+    // element counts (the shader declares the buffers at u1.. in BUFFERS order)
+    if (compute.enabled) {
+        // DRAW_STAGE is defined when pointVS / pointPS are compiled, which can't
+        // declare UAVs: kernel-only declarations go inside #ifndef DRAW_STAGE
+        preamble += "#define THREADS_X " + std::to_string(compute.threadsX) + "\n"
+                    "#define THREADS_Y " + std::to_string(compute.threadsY) + "\n"
+                    "#ifndef DRAW_STAGE\n"
+                    "RWTexture2D<float4> outputTexture : register(u0);\n"
+                    "#endif\n";
+        for (const ComputeBufferDesc& buffer : compute.buffers) {
+            preamble += "#define " + buffer.name + "_COUNT " + std::to_string(buffer.count) + "\n";
+        }
+    }
+
+    // Point draw: the indirect args kernels may rewrite (instance count at byte
+    // 4), and PointPosition(uv, vertexId, resolution) placing a point or a
+    // corner of its quad; PointCorner gives the corner in -1..1 for round sprites
+    if (compute.enabled && compute.draw.buffer >= 0) {
+        preamble +=
+            "#define POINT_SIZE " + std::to_string(compute.draw.size) + "\n"
+            "#ifndef DRAW_STAGE\n"
+            "RWByteAddressBuffer drawArgs : register(u" + std::to_string(DRAW_ARGS_UAV) + ");\n"
+            "#endif\n"
+            "float2 PointCorner(uint vertexId) {\n"
+            "    static const float2 corners[6] = { float2(-1, -1), float2(-1, 1), float2(1, -1),\n"
+            "                                       float2(1, -1), float2(-1, 1), float2(1, 1) };\n"
+            "    return POINT_SIZE > 1.0 ? corners[vertexId % 6] : float2(0, 0);\n"
+            "}\n"
+            "float4 PointPosition(float2 uv, uint vertexId, float2 resolution) {\n"
+            "    float2 clip = float2(uv.x * 2.0 - 1.0, 1.0 - uv.y * 2.0);\n"
+            "    return float4(clip + PointCorner(vertexId) * POINT_SIZE / resolution, 0.0, 1.0);\n"
+            "}\n";
+    }
 
-    // If any AudioBand param is present, prepend the AudioConstants cbuffer declaration
-    // and the spectrum texture so the shader doesn't have to declare them manually.
+    // Frame history ring; HistorySlice(0) is the current frame, older ages
+    // clamp to the oldest frame kept so far
+    if (history.frames > 0) {
+        preamble +=
+            "Texture2DArray frameHistory : register(t" + std::to_string(FRAME_HISTORY_SLOT) + ");\n"
+            "cbuffer FrameHistoryConstants : register(b" + std::to_string(FRAME_HISTORY_CBUFFER) + ") {\n"
+            "    int historyNewest; int historyCount; int historyFrames; int historyPad;\n"
+            "};\n"
+            "int HistorySlice(int age) {\n"
+            "    age = clamp(age, 0, max(historyCount - 1, 0));\n"
+            "    return (historyNewest - age + historyFrames) % historyFrames;\n"
+            "}\n";
+    }
+
+    // If any AudioBand param is present, prepend the AudioConstants cbuffer declaration,
+    // the spectrum and waveform textures and the spectrogram ring so the shader
+    // doesn't have to declare them manually. SpectrogramV(age) is the row `age`
+    // spectra back, as a v coordinate; ages past the rows written so far clamp to
+    // the oldest.
     bool hasAudio = false;
     for (const auto& p : params) {
         if (p.type == ShaderParamType::AudioBand) { hasAudio = true; break; }
@@ -487,12 +1621,56 @@ std::string ShaderManager::BuildDefinesPreamble(const std::vector<ShaderParam>&
         preamble +=
             "cbuffer AudioConstants : register(b1) {\n"
             "    float audioRms; float audioBass; float audioMid; float audioHigh;\n"
-            "    float audioBeat; float audioSpectralCentroid; float audioPad0; float audioPad1;\n"
+            "    float audioBeat; float audioSpectralCentroid; int spectrogramNewest; int spectrogramCount;\n"
+            "    float4 audioLeft; float4 audioRight;  // rms, bass, mid, high per channel\n"
+            "    float audioStereoWidth; float audioBPM; float audioBeatPhase; float audioBarPhase;\n"
             "};\n"
-            "Texture2D spectrumTexture : register(t3);\n";
+            "Texture2D spectrumTexture : register(t3);\n"
+            "Texture2D spectrogramTexture : register(t" + std::to_string(SPECTROGRAM_SLOT) + ");\n"
+            "Texture2D waveformTexture : register(t" + std::to_string(WAVEFORM_SLOT) + ");\n"
+            "float SpectrogramV(int age) {\n"
+            "    age = clamp(age, 0, max(spectrogramCount - 1, 0));\n"
+            "    int row = (spectrogramNewest - age + " + std::to_string(SPECTROGRAM_ROWS) + ") % " +
+                std::to_string(SPECTROGRAM_ROWS) + ";\n"
+            "    return (row + 0.5) / " + std::to_string(SPECTROGRAM_ROWS) + ".0;\n"
+            "}\n";
     }
 
+    // Colour LUTs, and ApplyLut: one trilinear fetch at the lattice points'
+    // texel centres (the sampler must clamp, like s0)
+    if (std::any_of(params.begin(), params.end(), [](const ShaderParam& p) { return p.type == ShaderParamType::Lut; })) {
+        preamble +=
+            "float3 ApplyLut(Texture3D lut, SamplerState linearClamp, float3 rgb) {\n"
+            "    float3 size;\n"
+            "    lut.GetDimensions(size.x, size.y, size.z);\n"
+            "    return lut.SampleLevel(linearClamp, saturate(rgb) * ((size - 1.0) / size) + 0.5 / size, 0).rgb;\n"
+            "}\n";
+    }
+
+    // Params past custom[16]: their own cbuffer, sized to the last one
+    int extendedFloats = 0;
     for (const auto& p : params) {
+        if (p.cbufferOffset < CUSTOM_PARAM_FLOATS) continue;
+        const int size = p.type == ShaderParamType::Point2D ? 2 : p.type == ShaderParamType::Color ? 4 : 1;
+        extendedFloats = std::max(extendedFloats, p.cbufferOffset + size - CUSTOM_PARAM_FLOATS);
+    }
+    if (extendedFloats > 0) {
+        preamble += "cbuffer ExtendedParams : register(b" + std::to_string(PARAM_CBUFFER) + ") {\n"
+                    "    float4 spParams[" + std::to_string((extendedFloats + 3) / 4) + "];\n"
+                    "};\n";
+    }
+
+    for (const auto& p : params) {
+        if (p.type == ShaderParamType::Image) {
+            preamble += "Texture2D " + p.name + " : register(t" +
+                        std::to_string(FIRST_INPUT_SLOT + p.inputIndex) + ");\n";
+            continue;
+        }
+        if (p.type == ShaderParamType::Lut) {
+            preamble += "Texture3D " + p.name + " : register(t" +
+                        std::to_string(FIRST_LUT_SLOT + p.inputIndex) + ");\n";
+            continue;
+        }
         if (p.type == ShaderParamType::AudioBand) {
             // Map band name to the corresponding AudioConstants field.
             static const std::unordered_map<std::string, std::string> bandMap = {
@@ -502,6 +1680,14 @@ std::string ShaderManager::BuildDefinesPreamble(const std::vector<ShaderParam>&
                 {"high",     "audioHigh"},
                 {"beat",     "audioBeat"},
                 {"centroid", "audioSpectralCentroid"},
+                {"rmsLeft",   "audioLeft.x"},  {"rmsRight",  "audioRight.x"},
+                {"bassLeft",  "audioLeft.y"},  {"bassRight", "audioRight.y"},
+                {"midLeft",   "audioLeft.z"},  {"midRight",  "audioRight.z"},
+                {"highLeft",  "audioLeft.w"},  {"highRight", "audioRight.w"},
+                {"width",     "audioStereoWidth"},
+                {"bpm",       "audioBPM"},
+                {"beatPhase", "audioBeatPhase"},
+                {"barPhase",  "audioBarPhase"},
             };
             auto it = bandMap.find(p.audioBand);
             if (it != bandMap.end())
@@ -509,10 +1695,21 @@ std::string ShaderManager::BuildDefinesPreamble(const std::vector<ShaderParam>&
             continue;
         }
 
-        if (p.cbufferOffset < 0 || p.cbufferOffset >= 16) continue;
-        int idx  = p.cbufferOffset / 4;
-        int c    = p.cbufferOffset % 4;
-        std::string slot = "custom[" + std::to_string(idx) + "].";
+        if (p.cbufferOffset < 0) continue;
+        if (specialize && p.specialize) {
+            // Baked in: branches on it fold away. The cbuffer slot stays allocated.
+            const int value = static_cast<int>(std::lround(p.values[0]));
+            preamble += "#define " + p.name + " " +
+                        (p.type == ShaderParamType::Bool ? std::string(value != 0 ? "true" : "false")
+                                                         : "(" + std::to_string(value) + ")") + "\n";
+            continue;
+        }
+        const bool extended = p.cbufferOffset >= CUSTOM_PARAM_FLOATS;
+        const int  offset   = extended ? p.cbufferOffset - CUSTOM_PARAM_FLOATS : p.cbufferOffset;
+        int idx  = offset / 4;
+        int c    = offset % 4;
+        const std::string vec = (extended ? "spParams[" : "custom[") + std::to_string(idx) + "]";
+        std::string slot = vec + ".";
 
         switch (p.type) {
         case ShaderParamType::Float:
@@ -532,9 +1729,11 @@ std::string ShaderManager::BuildDefinesPreamble(const std::vector<ShaderParam>&
             break;
         case ShaderParamType::Color:
             // color is 4-aligned, so c==0 always
-            preamble += "#define " + p.name + " custom[" + std::to_string(idx) + "]\n";
+            preamble += "#define " + p.name + " " + vec + "\n";
             break;
         case ShaderParamType::AudioBand:
+        case ShaderParamType::Image:
+        case ShaderParamType::Lut:
             break;  // Already handled above.
         }
     }
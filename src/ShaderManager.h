@@ -2,6 +2,10 @@
 
 #include "Common.h"
 #include "D3D11Renderer.h"
+#include "ShaderFileWatcher.h"
+#include "ShaderLibraryIndex.h"
+#include <condition_variable>
+#include <deque>
 
 namespace SP {
 
@@ -17,54 +21,267 @@ public:
     // Shader operations
     bool LoadShaderFromFile(const std::string& filepath, ShaderPreset& outPreset);
     // Reads and parses ISF metadata but does NOT compile — use before AddPreset to avoid a double-compile.
-    bool LoadShaderMetadataFromFile(const std::string& filepath, ShaderPreset& outPreset);
+    static bool LoadShaderMetadataFromFile(const std::string& filepath, ShaderPreset& outPreset);
     bool LoadShaderFromSource(const std::string& name, const std::string& source, ShaderPreset& outPreset);
     bool CompilePreset(ShaderPreset& preset);
     // Compile a preset already stored at the given index and update m_compiledShaders[index].
     bool RecompilePreset(int index);
     
-    // Preset management
-    int AddPreset(const ShaderPreset& preset);
+    // Background compilation. D3DCompile and shader creation are free-threaded, so
+    // presets compile on a small worker pool while the UI runs; the preset shows
+    // isCompiling until PollCompiles applies the result. A failed compile keeps the
+    // preset's previous shader. A later compile of the same preset (either kind)
+    // supersedes a pending one, whose result is then dropped.
+    void CompilePresetAsync(int index);
+    // Editor compile: re-parses the preset's source like RecompilePreset, but the
+    // new params and passes only replace the live ones when the compile succeeds,
+    // so the current shader keeps running (and stays on failure)
+    void RecompilePresetAsync(int index);
+    // Applies finished background compiles. Main thread, once per frame; true when any landed.
+    bool PollCompiles();
+    int  GetPendingCompileCount() const;
+
+    // Preset management. compileAsync queues the compile (startup, directory scans)
+    // instead of blocking on it.
+    int AddPreset(const ShaderPreset& preset, bool compileAsync = false);
+    // Library mode: AddPreset(preset, true) leaves the preset uncompiled (isDeferred)
+    // until SetActivePreset first uses it. Presets with a shortcut key, one key
+    // press away, are still queued at once.
+    void SetLazyCompile(bool lazy) { m_lazyCompile = lazy; }
+    // A preset is now a key press away (a shortcut was bound): compiles it in the
+    // background if deferred, and has PrewarmNext look at it
+    void PrefetchPreset(int index);
     void RemovePreset(int index);
     void UpdatePreset(int index, const ShaderPreset& preset);
     ShaderPreset* GetPreset(int index);
     const std::vector<ShaderPreset>& GetPresets() const { return m_presets; }
     int GetPresetCount() const { return static_cast<int>(m_presets.size()); }
 
-    // Active shader
+    // Active shader. SetActivePreset applies the generic shader; UpdateSpecialization
+    // then swaps in the variant for the current SPECIALIZE values.
     void SetActivePreset(int index);
     int GetActivePresetIndex() const { return m_activeIndex; }
     ShaderPreset* GetActivePreset();
     ID3D11PixelShader* GetActiveShader();
+
+    // A compositor-stack layer for the named preset with its current values.
+    // Only single-pass pixel presets qualify; false while one is still compiling
+    // (a deferred one is queued) or when it is multi-pass, compute or invalid.
+    bool GetLayer(const std::string& name, D3D11Renderer::Layer& out);
+    // A post-chain stage (D3D11Renderer::RunPostChain) for the named preset with
+    // its current values: single-pass pixel and compute presets; false as for GetLayer.
+    bool GetPostStage(const std::string& name, D3D11Renderer::PostStage& out);
     
+    // Bool/Long params marked SPECIALIZE are baked into a variant as literals, so
+    // mode switches cost no per-pixel branch. Call after the active preset's values
+    // change: a cached variant is applied at once, a missing one is compiled in the
+    // background with the generic shader (cbuffer reads) drawing meanwhile.
+    // Persistent targets and compute buffers carry across the swap.
+    // A single-pass pixel preset with a video blend mode also gets the blend fused
+    // into its variant (D3D11Renderer::BuildFusedBlendSource), saving the
+    // compositor pass and its intermediate texture.
+    void UpdateSpecialization();
+
     // Set passthrough (no effect)
     void SetPassthrough();
     bool IsPassthrough() const { return m_activeIndex < 0; }
 
-    // Hot reload
+    // Prewarm (D3D11Renderer::PrewarmPixelShader): presets a key press away, those
+    // with a shortcut and the active one's library neighbours, get their shaders
+    // drawn once before they go live. Each call warms one such compiled preset
+    // not warmed yet; false when there was none. A BackgroundGpuWork task.
+    bool PrewarmNext();
+
+    // Residency: with more than `maxShaders` shader objects (passes, kernels and
+    // variants count one each) alive, the least recently used presets are released
+    // back to bytecode-only. Such a preset is deferred again: its next use creates
+    // it from the bytecode cache in the background, with no D3DCompile. The active
+    // preset and its neighbours, shortcut-bound presets, presets drawn as layers or
+    // post stages in the last frame and presets compiling stay resident. 0 = no limit.
+    // UpdateResidency once per frame, after the frame's GetLayer/GetPostStage calls.
+    void SetResidencyBudget(int maxShaders);
+    void UpdateResidency();
+    struct ResidencyStats {
+        int     residentPresets = 0;
+        int     residentShaders = 0;
+        int     budget          = 0;
+        int64_t evictions       = 0;  // Since startup
+        int64_t reloads         = 0;  // Evicted presets used again
+    };
+    ResidencyStats GetResidencyStats() const;
+
+    // Folds a resolved GPU frame's Shader stage into the active preset's
+    // measuredGpuMs (smoothed), once per frame and only for frames drawn since
+    // it became active. Call once per frame with GpuProfiler::GetLatest.
+    void RecordGpuTime(const GpuFrameTiming& latest);
+
+    // Hot reload. Preset directories are watched for changes (ShaderFileWatcher);
+    // CheckForChanges, once per frame, reloads the files written since and
+    // recompiles them in the background like RecompilePresetAsync. An edited
+    // #include file recompiles every preset whose last compile included it.
     void EnableFileWatching(bool enable);
     void CheckForChanges();
 
-    // Directory scanning
+    // Where #include lines look after the including file's own directory (the
+    // shader directory). Compiles queued from here on use it.
+    void SetIncludeDirectory(const std::string& directory);
+
+    // Directory scanning, subfolders included; each new preset's `folder` is its
+    // path under `directory`. Waits for a library load still running.
     void ScanDirectory(const std::string& directory);
 
+    // Startup: reads the files of `configPresets` (restoring their saved values
+    // and shortcuts) and then the shader files of `directory` they don't list, on
+    // a worker thread, so the window is up before the library has been read.
+    // FinishLibraryLoad adds them, in that order, as AddPreset(preset, true).
+    void LoadLibraryAsync(std::vector<ShaderPreset> configPresets, std::string directory);
+    // Main thread: adds the loaded library once the worker is done, or after
+    // waiting for it. True on the call that added it.
+    bool FinishLibraryLoad(bool wait);
+    bool IsLoadingLibrary() const { return m_libraryThread.joinable(); }
+
     // Get default shader template
     static std::string GetShaderTemplate();
 
+    // Param values and keyframe timelines saved by name (config.json or a batch
+    // job) onto a freshly parsed preset
+    static void RestoreSavedValues(ShaderPreset& preset, const ShaderPreset& saved);
+    // The b2 custom-uniform block for the preset's current values
+    static void PackParamValues(const ShaderPreset& preset, float out[16]);
+    // The spParams[] block (b5) of params past custom[16]; returns the floats used, 0 for most presets
+    static int PackExtendedParams(const ShaderPreset& preset, float out[MAX_EXTENDED_PARAM_FLOATS]);
+    // Moves keyframed params to their value at `time`. True when any changed.
+    static bool EvaluateKeyframes(ShaderPreset& preset, double time);
+
+    friend struct MicroBenchAccess;  // ShaderPlayerMicroBench times the private hot paths
+
 private:
+    struct ShaderVariant;
+    // A preset's shader; multi-pass presets have one per pass (the last also in `shader`)
+    struct CompiledShader {
+        ComPtr<ID3D11PixelShader> shader;
+        std::vector<D3D11Renderer::RenderGraphPass> passes;
+        std::vector<D3D11Renderer::ComputeKernel>   kernels;  // Compute presets only
+        D3D11Renderer::PointDraw                    points;   // Compute presets with a DRAW
+        uint64_t ticket = 0;  // Pending background compile; 0 = none
+
+        // Specialized variants of this (generic) shader, least recently used first.
+        // Replacing the generic shader drops them with it.
+        std::vector<ShaderVariant> variants;
+        uint64_t variantTicket  = 0;  // Pending variant compile
+        uint64_t variantPending = 0;  // Its key; stays set if it failed, so it isn't retried
+        uint64_t appliedVariant = 0;  // Key of the variant the renderer has; 0 = generic
+        int      fusedBlendMode = 0;      // Variants only: video blend compiled in
+        bool     canFuseBlend   = false;  // Generic single-pass shader with the template's main
+        bool     prewarmed      = false;  // Drawn once by PrewarmNext
+        uint64_t lastUse        = 0;      // m_useClock when last activated, drawn or compiled
+        bool     evicted        = false;  // Released by UpdateResidency; bytecode-only
+    };
+    struct ShaderVariant {
+        uint64_t       key;
+        bool           isTimeVarying;
+        ShaderBindings bindings;
+        CompiledShader compiled;
+    };
+    static constexpr size_t MAX_VARIANTS = 8;  // Per preset
+    static int ShaderObjectCount(const CompiledShader& compiled);
+    struct CompileJob {
+        uint64_t     ticket;
+        ShaderPreset preset;      // Copy: the original may be edited or removed meanwhile
+        bool         reparsed;    // Carries new params/passes to apply on success
+        uint64_t     variantKey;  // Specialized variant of the current shader; 0 = generic
+    };
+    struct CompileResult {
+        uint64_t       ticket;
+        ShaderPreset   preset;  // The job's copy, with isValid, compileError, isTimeVarying, bindings set
+        CompiledShader compiled;
+        bool           reparsed;
+        uint64_t       variantKey;
+    };
+    void QueueCompile(int index, ShaderPreset job, bool reparsed);
+    void QueueVariant(int index, uint64_t key);
+    // The variant the preset's current values and blend mode call for; 0 = generic
+    static uint64_t SpecializationKey(const ShaderPreset& preset, const CompiledShader& generic);
+    // Hands a compiled shader, and the registers it reads, to the renderer. keepState
+    // swaps the shaders of the graph or kernels already active (same layout)
+    // without resetting their state.
+    void ApplyToRenderer(const CompiledShader& compiled, const ShaderPreset& preset,
+                         bool isTimeVarying, const ShaderBindings& bindings, bool keepState);
+    void StartCompileWorkers();  // With m_compileMutex held; once
+    void CompileWorker();
+    void StopCompileWorkers();
+    // Preamble + source (per pass for PASSES, per dispatch for compute presets);
+    // sets isValid, compileError, isTimeVarying, bindings, includes. `specialize`
+    // bakes the current values of SPECIALIZE params in.
+    bool Compile(ShaderPreset& preset, CompiledShader& out, bool specialize = false);
+
     D3D11Renderer& m_renderer;
     std::vector<ShaderPreset> m_presets;
-    std::vector<ComPtr<ID3D11PixelShader>> m_compiledShaders;
+    std::vector<CompiledShader> m_compiledShaders;
     int m_activeIndex = -1;  // -1 = passthrough
+    bool m_prewarmPending = false;  // A preset may want warming; cleared when none does
+    int64_t m_measureSince      = 0;   // First GPU frame drawn with the active preset
+    int64_t m_lastMeasuredFrame = -1;
+
+    // Residency (SetResidencyBudget)
+    int      m_residencyBudget  = 0;
+    uint64_t m_useClock         = 1;     // Advanced by UpdateResidency
+    int      m_residentPresets  = 0;     // As of the last UpdateResidency
+    int      m_residentShaders  = 0;
+    int64_t  m_evictions        = 0;
+    int64_t  m_residencyReloads = 0;
+
+    // Compile pool, started on the first background compile
+    std::vector<std::thread>   m_compileThreads;
+    mutable std::mutex         m_compileMutex;
+    std::condition_variable    m_compileCv;
+    std::deque<CompileJob>     m_compileJobs;     // Front first; SetActivePreset moves its job there
+    std::vector<CompileResult> m_compileResults;
+    int      m_compilesInFlight = 0;              // Taken by a worker, result not yet posted
+    uint64_t m_nextTicket       = 1;
+    bool     m_stopCompiling    = false;
+    std::filesystem::path m_includeDirectory;     // Read by compiles under m_compileMutex
+
+    // Library mode and its metadata index (shader_cache/library.idx). While the
+    // startup load runs, only its thread touches the index.
+    void LoadLibraryIndex();
+    // Files read and parsed on a few threads, with files unchanged since the
+    // library index saw them taking its metadata instead of a parse. Same order
+    // as `filepaths`; a file that can't be read comes back with an empty filepath.
+    std::vector<ShaderPreset> LoadMetadataFromFiles(const std::vector<std::string>& filepaths);
+    // The shader files (.hlsl/.fx/.ps) in `directory` and its subfolders (not
+    // dot-folders), sorted by path
+    static std::vector<std::string> ListShaderFiles(const std::string& directory);
+    void LibraryLoadThread(std::vector<ShaderPreset> configPresets, std::string directory);
+    bool m_lazyCompile = false;
+    bool m_libraryIndexLoaded = false;
+    ShaderLibraryIndex m_libraryIndex;
+    std::thread m_libraryThread;
+    std::atomic<bool> m_libraryLoaded{false};  // Worker done; m_loadedLibrary is complete
+    std::vector<ShaderPreset> m_loadedLibrary;
 
     // File watching
+    void WatchPresetFile(const std::string& filepath);
+    void TrackIncludes(const ShaderPreset& preset);  // Timestamps and watches for its includes
     bool m_fileWatchingEnabled = false;
     std::unordered_map<std::string, std::filesystem::file_time_type> m_fileTimestamps;
+    ShaderFileWatcher m_fileWatcher;
+    std::vector<std::filesystem::path> m_changedFiles;        // TakeChanges output, reused
+    std::vector<std::filesystem::path> m_changedDirectories;
+    std::chrono::steady_clock::time_point m_lastUnwatchedPoll;
 
     static std::vector<ShaderParam> ParseISFParams(const std::string& source,
                                                     bool* outIsGenerative = nullptr,
-                                                    bool* outIsAudio      = nullptr);
-    static std::string BuildDefinesPreamble(const std::vector<ShaderParam>& params);
+                                                    bool* outIsAudio      = nullptr,
+                                                    std::vector<RenderPassDesc>* outPasses = nullptr,
+                                                    FrameHistoryDesc* outHistory = nullptr,
+                                                    ComputeDesc* outCompute = nullptr,
+                                                    bool* outVideoMips    = nullptr);
+    static std::string BuildDefinesPreamble(const std::vector<ShaderParam>& params,
+                                            const std::vector<RenderPassDesc>& passes,
+                                            const FrameHistoryDesc& history,
+                                            const ComputeDesc& compute,
+                                            bool specialize = false);
 };
 
 } // namespace SP
@@ -0,0 +1,107 @@
+#include "SpoutInput.h"
+
+#include "SpoutDX.h"     // from Spout2 SDK (spout_lib)
+#include "SpoutUtils.h"  // spoututils::DisableSpoutLog
+
+namespace SP {
+
+struct SpoutInput::Impl {
+    spoutDX receiver;
+};
+
+SpoutInput::~SpoutInput() {
+    Close();
+}
+
+bool SpoutInput::Open(ID3D11Device* device, const std::string& senderName) {
+    Close();
+    m_impl = new Impl();
+    spoututils::DisableSpoutLog();
+
+    if (!m_impl->receiver.OpenDirectX11(device)) {
+        delete m_impl;
+        m_impl = nullptr;
+        return false;
+    }
+    m_impl->receiver.SetReceiverName(senderName.empty() ? nullptr : senderName.c_str());
+    m_device = device;
+    return true;
+}
+
+void SpoutInput::Close() {
+    if (m_impl) {
+        m_impl->receiver.ReleaseReceiver();
+        m_impl->receiver.CloseDirectX11();
+        delete m_impl;
+        m_impl = nullptr;
+    }
+    m_srv.Reset();
+    m_texture.Reset();
+    m_device = nullptr;
+    m_width  = 0;
+    m_height = 0;
+    m_framesReceived = 0;
+}
+
+bool SpoutInput::Receive() {
+    if (!m_impl) return false;
+    spoutDX& receiver = m_impl->receiver;
+    // Copies the sender's shared texture into ours (same size and format) while
+    // holding the sender's access lock
+    if (!receiver.ReceiveTexture(m_texture.GetAddressOf())) return false;
+
+    if (receiver.IsUpdated()) {
+        // New sender, or it changed size or format: ours must match for the copy
+        m_srv.Reset();
+        m_texture.Reset();
+        D3D11_TEXTURE2D_DESC desc = {};
+        desc.Width            = receiver.GetSenderWidth();
+        desc.Height           = receiver.GetSenderHeight();
+        desc.MipLevels        = 1;
+        desc.ArraySize        = 1;
+        desc.Format           = receiver.GetSenderFormat();
+        desc.SampleDesc.Count = 1;
+        desc.Usage            = D3D11_USAGE_DEFAULT;
+        desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+        if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &m_texture)) ||
+            FAILED(m_device->CreateShaderResourceView(m_texture.Get(), nullptr, &m_srv))) {
+            m_srv.Reset();
+            m_texture.Reset();
+            m_width  = 0;
+            m_height = 0;
+            return false;
+        }
+        m_width  = static_cast<int>(desc.Width);
+        m_height = static_cast<int>(desc.Height);
+        return false;  // The copy lands from the next call
+    }
+
+    // Senders that don't count frames report every call as new
+    if (!m_texture || !receiver.IsFrameNew()) return false;
+    ++m_framesReceived;
+    return true;
+}
+
+bool SpoutInput::IsConnected() const {
+    return m_impl && m_impl->receiver.IsConnected();
+}
+
+std::string SpoutInput::GetConnectedName() const {
+    if (!IsConnected()) return {};
+    const char* name = m_impl->receiver.GetSenderName();
+    return name ? name : std::string{};
+}
+
+std::vector<std::string> SpoutInput::ListSenders() {
+    // Sender names live in shared memory; no device needed
+    spoutDX spout;
+    std::vector<std::string> names;
+    const int count = spout.GetSenderCount();
+    char name[256];
+    for (int i = 0; i < count; ++i) {
+        if (spout.GetSender(i, name, sizeof(name))) names.emplace_back(name);
+    }
+    return names;
+}
+
+} // namespace SP
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Spout2 receiver — takes another application's shared DX11 texture (Resolume,
+// TouchDesigner, Notch, ...) as the video source in place of VideoDecoder. Each
+// new sender frame is copied GPU-to-GPU into a texture of ours under Spout's
+// access lock, so the shader never samples a frame the sender is still writing
+// and nothing touches the CPU. D3D11Renderer::SetExternalVideo binds it at t0.
+// Uses pImpl so SpoutDX headers stay out of Application.h, like SpoutOutput.
+class SpoutInput {
+public:
+    SpoutInput() = default;
+    ~SpoutInput();
+
+    SpoutInput(const SpoutInput&) = delete;
+    SpoutInput& operator=(const SpoutInput&) = delete;
+
+    // Receives from `senderName`, or from the active sender when empty. Waits
+    // for the sender to appear if it isn't running yet.
+    bool Open(ID3D11Device* device, const std::string& senderName);
+    void Close();
+    bool IsOpen() const { return m_impl != nullptr; }
+
+    // Once per tick. True when a new frame was copied into GetSRV's texture; a
+    // sender size or format change recreates it (no frame that tick).
+    bool Receive();
+    bool IsConnected() const;  // A sender is connected
+    std::string GetConnectedName() const;
+
+    ID3D11ShaderResourceView* GetSRV() const { return m_srv.Get(); }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int64_t GetFramesReceived() const { return m_framesReceived; }
+
+    // Senders registered right now. Works without Open.
+    static std::vector<std::string> ListSenders();
+
+private:
+    struct Impl;
+    Impl* m_impl = nullptr;
+    ID3D11Device* m_device = nullptr;
+    ComPtr<ID3D11Texture2D>          m_texture;
+    ComPtr<ID3D11ShaderResourceView> m_srv;
+    int     m_width  = 0;
+    int     m_height = 0;
+    int64_t m_framesReceived = 0;
+};
+
+} // namespace SP
@@ -1,10 +1,17 @@
 #include "SpoutOutput.h"
+#include "D3D11Renderer.h"
 
 #include "SpoutDX.h"     // from Spout2 SDK (spout_lib)
 #include "SpoutUtils.h"  // spoututils::DisableSpoutLog
 
 namespace SP {
 
+namespace {
+
+constexpr double STATS_SMOOTHING = 0.1;  // Weight of the newest send in the averages
+
+} // namespace
+
 struct SpoutOutput::Impl {
     spoutDX sender;
 };
@@ -27,6 +34,7 @@ bool SpoutOutput::Initialize(ID3D11Device* device) {
     }
 
     m_impl->sender.SetSenderName(m_senderName.c_str());
+    m_device      = device;
     m_initialized = true;
     return true;
 }
@@ -38,12 +46,16 @@ void SpoutOutput::Shutdown() {
         delete m_impl;
         m_impl = nullptr;
     }
+    m_scaledRTV.Reset();
+    m_scaled.Reset();
+    m_device = nullptr;
     m_initialized = false;
     m_enabled = false;
 }
 
 void SpoutOutput::SetEnabled(bool enabled) {
     m_enabled = enabled;
+    m_sentGeneration = 0;  // A new registration needs a frame even when the image is idle
     // Release the Spout sender slot so it disappears from receiver lists
     // immediately when disabled, rather than appearing stale.
     if (!enabled && m_impl) {
@@ -68,14 +80,97 @@ std::string SpoutOutput::GetActiveSenderName() const {
 
 void SpoutOutput::SetSenderName(const std::string& name) {
     m_senderName = name;
+    m_sentGeneration = 0;
     if (m_impl && m_initialized)
         m_impl->sender.SetSenderName(m_senderName.c_str());
 }
 
-bool SpoutOutput::SendFrame(ID3D11Texture2D* texture) {
-    if (!m_initialized || !m_enabled || !m_impl || !texture)
+void SpoutOutput::SetOutputSize(int width, int height) {
+    m_outputWidth  = std::max(width, 0);
+    m_outputHeight = std::max(height, 0);
+    m_sentGeneration = 0;
+}
+
+void SpoutOutput::SetSendTap(bool tap) {
+    m_sendTap = tap;
+    m_sentGeneration = 0;
+}
+
+bool SpoutOutput::SendFrame(D3D11Renderer& renderer, ID3D11ShaderResourceView* source, uint64_t generation) {
+    if (!m_initialized || !m_enabled || !m_impl || !renderer.GetDisplayTexture())
+        return false;
+
+    // A tapped pass is redrawn with the display, so the display generation covers both
+    if (!source) {
+        source = m_sendTap ? renderer.GetTapSRV() : nullptr;
+        if (!source) source = renderer.GetDisplaySRV();
+        generation = renderer.GetDisplayGeneration();
+    }
+    if (generation == m_sentGeneration && source == m_sentSource) {
+        ++m_stats.framesSkipped;
         return false;
-    return m_impl->sender.SendTexture(texture);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    ComPtr<ID3D11Resource> resource;
+    source->GetResource(&resource);
+    D3D11_TEXTURE2D_DESC desc = {};
+    static_cast<ID3D11Texture2D*>(resource.Get())->GetDesc(&desc);
+    const int width  = m_outputWidth  > 0 ? m_outputWidth  : static_cast<int>(desc.Width);
+    const int height = m_outputHeight > 0 ? m_outputHeight : static_cast<int>(desc.Height);
+
+    // Receivers expect RGBA8: a 16-bit display texture goes through the blit too
+    ID3D11Texture2D* texture = static_cast<ID3D11Texture2D*>(resource.Get());
+    if (width != static_cast<int>(desc.Width) || height != static_cast<int>(desc.Height) ||
+        desc.Format != DXGI_FORMAT_R8G8B8A8_UNORM) {
+        D3D11_TEXTURE2D_DESC scaled = {};
+        if (m_scaled) m_scaled->GetDesc(&scaled);
+        if (static_cast<int>(scaled.Width) != width || static_cast<int>(scaled.Height) != height) {
+            m_scaledRTV.Reset();
+            m_scaled.Reset();
+            scaled = {};
+            scaled.Width            = static_cast<UINT>(width);
+            scaled.Height           = static_cast<UINT>(height);
+            scaled.MipLevels        = 1;
+            scaled.ArraySize        = 1;
+            scaled.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+            scaled.SampleDesc.Count = 1;
+            scaled.Usage            = D3D11_USAGE_DEFAULT;
+            scaled.BindFlags        = D3D11_BIND_RENDER_TARGET;
+            if (FAILED(m_device->CreateTexture2D(&scaled, nullptr, &m_scaled)) ||
+                FAILED(m_device->CreateRenderTargetView(m_scaled.Get(), nullptr, &m_scaledRTV))) {
+                m_scaled.Reset();
+                m_scaledRTV.Reset();
+                return false;
+            }
+        }
+        renderer.UpscaleTo(source, m_scaledRTV.Get(), width, height);
+        texture = m_scaled.Get();
+    } else if (m_scaled) {
+        m_scaledRTV.Reset();
+        m_scaled.Reset();
+    }
+
+    if (!m_impl->sender.SendTexture(texture))
+        return false;
+
+    const auto end = std::chrono::steady_clock::now();
+    const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    m_stats.avgSendMs = m_stats.framesSent > 0 ? m_stats.avgSendMs + (ms - m_stats.avgSendMs) * STATS_SMOOTHING : ms;
+    if (m_stats.framesSent > 0) {
+        const double interval = std::chrono::duration<double, std::milli>(end - m_lastSend).count();
+        m_stats.avgIntervalMs = m_stats.avgIntervalMs > 0.0
+                              ? m_stats.avgIntervalMs + (interval - m_stats.avgIntervalMs) * STATS_SMOOTHING
+                              : interval;
+    }
+    m_stats.lastSendMs = ms;
+    m_stats.width      = width;
+    m_stats.height     = height;
+    ++m_stats.framesSent;
+    m_lastSend       = end;
+    m_sentGeneration = generation;
+    m_sentSource     = source;
+    return true;
 }
 
 } // namespace SP
@@ -1,10 +1,25 @@
 #pragma once
 
-#include <d3d11.h>
-#include <string>
+#include "Common.h"
+#include <chrono>
 
 namespace SP {
 
+class D3D11Renderer;
+
+// What the last SendFrame calls cost. CPU time covers the optional downscale
+// draw and SendTexture (its shared-texture copy and frame-count update); the
+// GPU side is GpuStage::Spout.
+struct SpoutSendStats {
+    int64_t framesSent    = 0;
+    int64_t framesSkipped = 0;  // Ticks whose source had not changed since the last send
+    double  lastSendMs    = 0.0;
+    double  avgSendMs     = 0.0;
+    double  avgIntervalMs = 0.0;  // Between sends, i.e. the rate receivers see
+    int     width  = 0;           // Of the last frame sent
+    int     height = 0;
+};
+
 // Spout2 sender — shares the processed display texture with any Spout-aware
 // receiver on the same machine: Resolume, MadMapper, OBS (SpoutPlugin),
 // SpoutCam (virtual webcam), etc.
@@ -36,8 +51,19 @@ public:
     // to avoid collisions. Empty string when not yet active.
     std::string GetActiveSenderName() const;
 
-    // Call after D3D11Renderer::RenderToDisplay(). Returns false on failure.
-    bool SendFrame(ID3D11Texture2D* texture);
+    // Output size; 0x0 sends at the source's size. Another size is drawn into a
+    // texture of ours first (bilinear, on the GPU).
+    void SetOutputSize(int width, int height);
+    // Send the renderer's tapped pass (D3D11Renderer::SetTapPass) instead of the
+    // display texture while it has one
+    void SetSendTap(bool tap);
+
+    // Call after D3D11Renderer::RenderToDisplay(). Sends only when the renderer
+    // drew since the last send (GetDisplayGeneration) or the output changed, so
+    // receivers see new frames only. True when a frame was sent. A post chain's
+    // result and its PostChain::generation replace the display texture (or tap).
+    bool SendFrame(D3D11Renderer& renderer, ID3D11ShaderResourceView* source = nullptr, uint64_t generation = 0);
+    const SpoutSendStats& GetStats() const { return m_stats; }
 
 private:
     struct Impl;
@@ -45,6 +71,18 @@ private:
     bool        m_enabled     = false;
     bool        m_initialized = false;
     std::string m_senderName  = "ShaderPlayer";
+
+    ID3D11Device* m_device = nullptr;
+    int  m_outputWidth  = 0;
+    int  m_outputHeight = 0;
+    bool m_sendTap      = false;
+    // The generation last sent; 0 = send the next frame whatever it is
+    uint64_t m_sentGeneration = 0;
+    ID3D11ShaderResourceView* m_sentSource = nullptr;
+    ComPtr<ID3D11Texture2D>        m_scaled;  // Output-size copy
+    ComPtr<ID3D11RenderTargetView> m_scaledRTV;
+    SpoutSendStats m_stats;
+    std::chrono::steady_clock::time_point m_lastSend;
 };
 
 } // namespace SP
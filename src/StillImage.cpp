@@ -0,0 +1,170 @@
+#include "StillImage.h"
+#include "ThreadPriority.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cctype>
+#include <wincodec.h>
+
+namespace SP {
+
+namespace {
+
+// Extensions the built-in WIC codecs decode (WebP and HEIF need the Store codecs;
+// without them decoding fails and the FFmpeg path takes over)
+constexpr const char* STILL_EXTENSIONS[] = {
+    ".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff", ".gif", ".jxr", ".webp", ".heic"
+};
+
+// Larger stills are refused rather than blowing past the texture limit
+constexpr UINT MAX_SIZE = D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION;
+
+// 2x2 box filter; an odd edge repeats its last row/column
+void Downsample(const std::vector<uint8_t>& src, int srcWidth, int srcHeight,
+                std::vector<uint8_t>& dst, int dstWidth, int dstHeight) {
+    dst.resize(static_cast<size_t>(dstWidth) * dstHeight * 4);
+    for (int y = 0; y < dstHeight; ++y) {
+        const int y0 = std::min(y * 2, srcHeight - 1);
+        const int y1 = std::min(y * 2 + 1, srcHeight - 1);
+        const uint8_t* row0 = src.data() + static_cast<size_t>(y0) * srcWidth * 4;
+        const uint8_t* row1 = src.data() + static_cast<size_t>(y1) * srcWidth * 4;
+        uint8_t* out = dst.data() + static_cast<size_t>(y) * dstWidth * 4;
+        for (int x = 0; x < dstWidth; ++x) {
+            const int x0 = std::min(x * 2, srcWidth - 1) * 4;
+            const int x1 = std::min(x * 2 + 1, srcWidth - 1) * 4;
+            for (int c = 0; c < 4; ++c) {
+                out[x * 4 + c] = static_cast<uint8_t>(
+                    (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+            }
+        }
+    }
+}
+
+} // namespace
+
+StillImage::~StillImage() {
+    Close();
+}
+
+bool StillImage::IsStillImage(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return std::find(std::begin(STILL_EXTENSIONS), std::end(STILL_EXTENSIONS), ext) != std::end(STILL_EXTENSIONS);
+}
+
+void StillImage::Load(const std::string& path) {
+    Close();
+    m_path   = path;
+    m_failed = false;
+    m_done   = false;
+    m_thread = std::thread(&StillImage::DecodeThread, this, path);
+}
+
+void StillImage::Close() {
+    if (m_thread.joinable()) m_thread.join();
+    m_levels.clear();
+    m_srv.Reset();
+    m_texture.Reset();
+    m_path.clear();
+    m_done   = false;
+    m_failed = false;
+    m_width  = 0;
+    m_height = 0;
+    m_mipLevels = 0;
+    m_textureBytes = 0;
+}
+
+bool StillImage::Poll(ID3D11Device* device) {
+    if (m_srv || m_levels.empty() || !m_done.load(std::memory_order_acquire)) return false;
+    m_thread.join();
+
+    // Every level as initial data: immutable textures can't be written later
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = static_cast<UINT>(m_levels[0].width);
+    desc.Height           = static_cast<UINT>(m_levels[0].height);
+    desc.MipLevels        = static_cast<UINT>(m_levels.size());
+    desc.ArraySize        = 1;
+    desc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+    std::vector<D3D11_SUBRESOURCE_DATA> init(m_levels.size());
+    size_t bytes = 0;
+    for (size_t i = 0; i < m_levels.size(); ++i) {
+        init[i].pSysMem     = m_levels[i].pixels.data();
+        init[i].SysMemPitch = static_cast<UINT>(m_levels[i].width * 4);
+        bytes += m_levels[i].pixels.size();
+    }
+    const bool created = device &&
+        SUCCEEDED(device->CreateTexture2D(&desc, init.data(), &m_texture)) &&
+        SUCCEEDED(device->CreateShaderResourceView(m_texture.Get(), nullptr, &m_srv));
+    m_levels.clear();
+    m_levels.shrink_to_fit();
+    if (!created) {
+        m_srv.Reset();
+        m_texture.Reset();
+        m_failed = true;
+        return false;
+    }
+    m_width        = static_cast<int>(desc.Width);
+    m_height       = static_cast<int>(desc.Height);
+    m_mipLevels    = static_cast<int>(desc.MipLevels);
+    m_textureBytes = bytes;
+    return true;
+}
+
+void StillImage::DecodeThread(std::string path) {
+    TraceRecorder::SetThreadName("Still image decode");
+    ThreadPriority::Apply(ThreadRole::Playback);
+    const HRESULT coInit = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    auto decode = [&]() -> bool {
+        ComPtr<IWICImagingFactory> factory;
+        if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER,
+                                    IID_PPV_ARGS(&factory)))) return false;
+        const std::wstring widePath = std::filesystem::path(path).wstring();
+        ComPtr<IWICBitmapDecoder> decoder;
+        if (FAILED(factory->CreateDecoderFromFilename(widePath.c_str(), nullptr, GENERIC_READ,
+                                                      WICDecodeMetadataCacheOnDemand, &decoder))) return false;
+        // Animated GIF/WebP frames need compositing: FFmpeg's decoders do that
+        UINT frameCount = 0;
+        if (FAILED(decoder->GetFrameCount(&frameCount)) || frameCount != 1) return false;
+        ComPtr<IWICBitmapFrameDecode> frame;
+        if (FAILED(decoder->GetFrame(0, &frame))) return false;
+
+        ComPtr<IWICFormatConverter> converter;
+        if (FAILED(factory->CreateFormatConverter(&converter)) ||
+            FAILED(converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone,
+                                         nullptr, 0.0, WICBitmapPaletteTypeCustom))) return false;
+        UINT width = 0, height = 0;
+        if (FAILED(converter->GetSize(&width, &height)) || width == 0 || height == 0 ||
+            width > MAX_SIZE || height > MAX_SIZE) return false;
+
+        Level base;
+        base.width  = static_cast<int>(width);
+        base.height = static_cast<int>(height);
+        base.pixels.resize(static_cast<size_t>(width) * height * 4);
+        if (FAILED(converter->CopyPixels(nullptr, width * 4, static_cast<UINT>(base.pixels.size()),
+                                         base.pixels.data()))) return false;
+
+        m_levels.push_back(std::move(base));
+        while (m_levels.back().width > 1 || m_levels.back().height > 1) {
+            const Level& src = m_levels.back();
+            Level next;
+            next.width  = std::max(src.width / 2, 1);
+            next.height = std::max(src.height / 2, 1);
+            Downsample(src.pixels, src.width, src.height, next.pixels, next.width, next.height);
+            m_levels.push_back(std::move(next));
+        }
+        return true;
+    };
+
+    if (!decode()) {
+        m_levels.clear();
+        m_failed = true;
+    }
+    if (SUCCEEDED(coInit)) CoUninitialize();
+    m_done.store(true, std::memory_order_release);
+}
+
+} // namespace SP
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// A single still (PNG, JPEG, BMP, TIFF, ...) as the video input. A worker
+// thread decodes it with WIC to RGBA8 and builds the full mip chain on the CPU
+// (2x2 box filter); Poll then creates one IMMUTABLE texture from all levels and
+// drops the pixels. From there nothing is decoded or uploaded again: the SRV is
+// bound at t0 like Spout/NDI input (D3D11Renderer::SetExternalVideo), and the
+// shader's trilinear sampler uses the mips when the still is larger than the
+// output. Files WIC can't decode, and animated images (more than one frame),
+// report Failed and go through the FFmpeg path instead.
+class StillImage {
+public:
+    StillImage() = default;
+    ~StillImage();
+
+    // Non-copyable
+    StillImage(const StillImage&) = delete;
+    StillImage& operator=(const StillImage&) = delete;
+
+    // A still WIC reads, by extension (not a check of the contents)
+    static bool IsStillImage(const std::string& path);
+
+    // Starts decoding on the worker. Closes what was open.
+    void Load(const std::string& path);
+    // Joins the worker and releases the texture
+    void Close();
+
+    bool IsOpen() const { return !m_path.empty(); }
+    bool IsLoading() const { return IsOpen() && !m_done.load(std::memory_order_acquire); }
+    // Decoding finished without an image (unreadable, unsupported or animated)
+    bool HasFailed() const { return m_done.load(std::memory_order_acquire) && m_failed; }
+    const std::string& GetPath() const { return m_path; }
+
+    // Main thread, once a tick: true on the one call that created the texture
+    bool Poll(ID3D11Device* device);
+
+    ID3D11ShaderResourceView* GetSRV() const { return m_srv.Get(); }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int GetMipLevels() const { return m_mipLevels; }
+    size_t GetGpuBytes() const { return m_srv ? m_textureBytes : 0; }
+
+private:
+    struct Level {
+        int width  = 0;
+        int height = 0;
+        std::vector<uint8_t> pixels;  // RGBA8, tightly packed
+    };
+
+    void DecodeThread(std::string path);
+
+    std::string m_path;
+    std::thread m_thread;
+    std::atomic<bool> m_done{false};
+    bool m_failed = false;       // Written by the worker before m_done
+    std::vector<Level> m_levels; // Worker output; freed once uploaded
+
+    ComPtr<ID3D11Texture2D>          m_texture;
+    ComPtr<ID3D11ShaderResourceView> m_srv;
+    int    m_width  = 0;
+    int    m_height = 0;
+    int    m_mipLevels = 0;
+    size_t m_textureBytes = 0;
+};
+
+} // namespace SP
@@ -0,0 +1,83 @@
+#include "TextureUploadRing.h"
+
+namespace SP {
+
+bool TextureUploadRing::CreateSlots(ID3D11Device* device, int width, int height, DXGI_FORMAT format) {
+    Reset();
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = static_cast<UINT>(width);
+    desc.Height           = static_cast<UINT>(height);
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_STAGING;
+    desc.CPUAccessFlags   = D3D11_CPU_ACCESS_WRITE;
+
+    D3D11_QUERY_DESC queryDesc = {};
+    queryDesc.Query = D3D11_QUERY_EVENT;
+
+    for (Slot& slot : m_slots) {
+        if (FAILED(device->CreateTexture2D(&desc, nullptr, &slot.staging)) ||
+            FAILED(device->CreateQuery(&queryDesc, &slot.copied))) {
+            Reset();
+            return false;
+        }
+    }
+    m_width  = width;
+    m_height = height;
+    m_format = format;
+    return true;
+}
+
+bool TextureUploadRing::Map(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height,
+                            DXGI_FORMAT format, D3D11_MAPPED_SUBRESOURCE& out) {
+    if (m_mapped >= 0) return false;
+    if ((width != m_width || height != m_height || format != m_format || !m_slots[0].staging) &&
+        !CreateSlots(device, width, height, format)) {
+        return false;
+    }
+
+    // Oldest first: the first slot whose copy the GPU has finished
+    int slot = -1;
+    for (int i = 0; i < SLOTS && slot < 0; ++i) {
+        const int index = (m_next + i) % SLOTS;
+        Slot& s = m_slots[index];
+        if (!s.pending || context->GetData(s.copied.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK)
+            slot = index;
+    }
+    if (slot < 0) {
+        slot = m_next;  // All in flight: Map below waits for the oldest
+        ++m_stalls;
+    }
+
+    if (FAILED(context->Map(m_slots[slot].staging.Get(), 0, D3D11_MAP_WRITE, 0, &out))) return false;
+    m_slots[slot].pending = false;
+    m_mapped = slot;
+    return true;
+}
+
+void TextureUploadRing::Commit(ID3D11DeviceContext* context, ID3D11Resource* dest) {
+    if (m_mapped < 0) return;
+    Slot& slot = m_slots[m_mapped];
+    context->Unmap(slot.staging.Get(), 0);
+    if (dest) {
+        context->CopyResource(dest, slot.staging.Get());
+        context->End(slot.copied.Get());
+        slot.pending = true;
+    }
+    m_next   = (m_mapped + 1) % SLOTS;
+    m_mapped = -1;
+}
+
+void TextureUploadRing::Reset() {
+    for (Slot& slot : m_slots) slot = Slot{};
+    m_next   = 0;
+    m_mapped = -1;
+    m_width  = 0;
+    m_height = 0;
+    m_format = DXGI_FORMAT_UNKNOWN;
+}
+
+} // namespace SP
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Common.h"
+#include "PixelCopy.h"  // CopyRows into a mapped slot
+#include <array>
+
+namespace SP {
+
+// CPU → GPU texture uploads through a ring of STAGING textures. Mapping one
+// DYNAMIC texture with WRITE_DISCARD every frame makes the driver rename it or,
+// on some drivers, wait for the GPU to finish sampling the previous frame. Here
+// each upload writes a staging slot the GPU is done with (an event query per
+// slot says so) and CopyResource moves it into a DEFAULT texture, so the copy
+// is queued behind the previous frame's draws instead of blocking the CPU.
+// Render thread only.
+class TextureUploadRing {
+public:
+    static constexpr int SLOTS = 3;
+
+    TextureUploadRing() = default;
+
+    // Non-copyable
+    TextureUploadRing(const TextureUploadRing&) = delete;
+    TextureUploadRing& operator=(const TextureUploadRing&) = delete;
+
+    // Map a free slot for a `width` x `height` `format` texture; the slots are
+    // remade when those change. When every slot is still in flight, the oldest
+    // is mapped anyway and Map waits for the GPU (counted in GetStalls).
+    bool Map(ID3D11Device* device, ID3D11DeviceContext* context, int width, int height,
+             DXGI_FORMAT format, D3D11_MAPPED_SUBRESOURCE& out);
+    // Unmap the slot from Map and copy it into `dest` (same size and format)
+    void Commit(ID3D11DeviceContext* context, ID3D11Resource* dest);
+    void Reset();
+
+    int64_t GetStalls() const { return m_stalls; }
+
+private:
+    struct Slot {
+        ComPtr<ID3D11Texture2D> staging;
+        ComPtr<ID3D11Query>     copied;      // Signalled once the GPU has read the slot
+        bool                    pending = false;
+    };
+
+    bool CreateSlots(ID3D11Device* device, int width, int height, DXGI_FORMAT format);
+
+    std::array<Slot, SLOTS> m_slots;
+    int m_next   = 0;   // Oldest slot; the next one tried
+    int m_mapped = -1;  // Slot between Map and Commit
+    int m_width  = 0;
+    int m_height = 0;
+    DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+    int64_t m_stalls = 0;
+};
+
+} // namespace SP
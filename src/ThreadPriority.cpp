@@ -0,0 +1,46 @@
+#include "ThreadPriority.h"
+#include <avrt.h>
+
+namespace SP {
+
+namespace {
+
+std::atomic<bool> g_enabled{true};
+
+// Held per thread so its MMCSS registration is reverted when it exits
+struct MmcssRegistration {
+    HANDLE handle = nullptr;
+    ~MmcssRegistration() {
+        if (handle) AvRevertMmThreadCharacteristics(handle);
+    }
+};
+thread_local MmcssRegistration t_mmcss;
+
+} // namespace
+
+void ThreadPriority::SetEnabled(bool enabled) {
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool ThreadPriority::IsEnabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void ThreadPriority::Apply(ThreadRole role) {
+    if (!IsEnabled()) return;
+
+    const wchar_t* task = nullptr;
+    switch (role) {
+    case ThreadRole::ProAudio:   task = L"Pro Audio"; break;
+    case ThreadRole::Render:     task = L"Games";     break;
+    case ThreadRole::Playback:   task = L"Playback";  break;
+    case ThreadRole::Background:
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+        return;
+    }
+    if (t_mmcss.handle) return;  // One task per thread
+    DWORD taskIndex = 0;
+    t_mmcss.handle = AvSetMmThreadCharacteristicsW(task, &taskIndex);  // Null without the MMCSS service
+}
+
+} // namespace SP
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// How a thread is scheduled under load, set once at the top of the thread.
+// The time-critical threads join an MMCSS task, which the scheduler boosts over
+// normal-priority work; bulk work drops below normal so a recording or a batch
+// of compiles takes what the playback threads leave.
+enum class ThreadRole {
+    ProAudio,    // Audio callbacks: MMCSS "Pro Audio"
+    Render,      // Main/render loop and present threads: MMCSS "Games"
+    Playback,    // Video and audio decode feeding playback: MMCSS "Playback"
+    Background,  // Encoders, writers, shader compiles, pre-analysis: below normal
+};
+
+// Process-wide switch (AppConfig::threadPriorities). With it off every thread
+// keeps the default priority. Threads read it when they start, so a change
+// reaches a thread the next time it is started.
+class ThreadPriority {
+public:
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+
+    // Schedule the calling thread as `role`. An MMCSS registration is reverted
+    // when the thread exits.
+    static void Apply(ThreadRole role);
+};
+
+} // namespace SP
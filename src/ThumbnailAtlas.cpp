@@ -0,0 +1,271 @@
+#include "ThumbnailAtlas.h"
+#include "D3D11Renderer.h"
+#include "ShaderManager.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace SP {
+
+namespace {
+
+constexpr uint32_t CACHE_MAGIC   = 0x424D4854;  // "THMB"
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr size_t   ROW_BYTES     = ThumbnailAtlas::WIDTH * 4;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+};
+
+// shader_cache/thumbnails/ next to the exe
+std::filesystem::path GetThumbnailCacheDir() {
+    char exePath[MAX_PATH];
+    GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+    return std::filesystem::path(exePath).parent_path() / "shader_cache" / "thumbnails";
+}
+
+} // namespace
+
+ThumbnailAtlas::~ThumbnailAtlas() {
+    Shutdown();
+}
+
+bool ThumbnailAtlas::Initialize(D3D11Renderer& renderer) {
+    Shutdown();
+    ID3D11Device* device = renderer.GetDevice();
+    if (!device) return false;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = WIDTH * COLUMNS;
+    desc.Height           = HEIGHT * ROWS;
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, &m_atlas)) ||
+        FAILED(device->CreateShaderResourceView(m_atlas.Get(), nullptr, &m_atlasSRV))) {
+        Shutdown();
+        return false;
+    }
+
+    desc.Width     = WIDTH;
+    desc.Height    = HEIGHT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, &m_scratch)) ||
+        FAILED(device->CreateRenderTargetView(m_scratch.Get(), nullptr, &m_scratchRTV))) {
+        Shutdown();
+        return false;
+    }
+
+    // Without a staging slot a thumbnail is drawn but not kept on disk
+    desc.Usage          = D3D11_USAGE_STAGING;
+    desc.BindFlags      = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    D3D11_QUERY_DESC queryDesc = {D3D11_QUERY_EVENT, 0};
+    for (StagingSlot& slot : m_staging) {
+        if (FAILED(device->CreateTexture2D(&desc, nullptr, &slot.texture)) ||
+            FAILED(device->CreateQuery(&queryDesc, &slot.done))) {
+            slot = StagingSlot{};
+        }
+    }
+
+    m_cacheDir = GetThumbnailCacheDir();
+    std::error_code ec;
+    std::filesystem::create_directories(m_cacheDir, ec);
+    m_renderer = &renderer;
+    m_cellOwner.assign(COLUMNS * ROWS, std::string());
+    return true;
+}
+
+void ThumbnailAtlas::Shutdown() {
+    m_atlasSRV.Reset();
+    m_atlas.Reset();
+    m_scratchRTV.Reset();
+    m_scratch.Reset();
+    for (StagingSlot& slot : m_staging) slot = StagingSlot{};
+    m_entries.clear();
+    m_cellOwner.clear();
+    m_renderer = nullptr;
+}
+
+bool ThumbnailAtlas::Request(const std::string& preset, float uv0[2], float uv1[2]) {
+    Entry& entry = m_entries[preset];
+    entry.lastWanted = m_frame;
+    if (entry.state != CellState::Ready || entry.cell < 0) return false;
+    const float column = static_cast<float>(entry.cell % COLUMNS);
+    const float row    = static_cast<float>(entry.cell / COLUMNS);
+    uv0[0] = column / COLUMNS;
+    uv0[1] = row / ROWS;
+    uv1[0] = (column + 1.0f) / COLUMNS;
+    uv1[1] = (row + 1.0f) / ROWS;
+    return true;
+}
+
+bool ThumbnailAtlas::IsUnsupported(const std::string& preset) const {
+    auto it = m_entries.find(preset);
+    return it != m_entries.end() && it->second.state == CellState::Unsupported;
+}
+
+void ThumbnailAtlas::Update() {
+    ++m_frame;
+    m_frameWork = 0;
+    if (m_atlas) SaveFinished();
+}
+
+bool ThumbnailAtlas::Step(ShaderManager& shaders) {
+    if (!m_atlas || m_frameWork >= MAX_DRAWS_PER_FRAME) return false;
+    for (const ShaderPreset& preset : shaders.GetPresets()) {
+        auto it = m_entries.find(preset.name);
+        if (it == m_entries.end() || m_frame - it->second.lastWanted > REQUEST_FRAMES) continue;
+        Entry& entry = it->second;
+
+        // Re-keyed every frame it is shown, so an edit or a value change redraws it
+        const uint64_t key = MakeKey(preset);
+        if (entry.state != CellState::Pending && entry.key == key) continue;
+        if (entry.cell < 0) {
+            entry.cell = AcquireCell();
+            if (entry.cell < 0) return false;  // Every cell is on screen
+            m_cellOwner[entry.cell] = preset.name;
+        }
+
+        if (LoadCached(key, entry.cell)) {
+            entry.state = CellState::Ready;
+            entry.key   = key;
+            ++m_frameWork;
+            return true;
+        }
+
+        // One compile at a time for thumbnails; GetLayer queues a deferred preset
+        if (preset.isDeferred && shaders.GetPendingCompileCount() > 0) continue;
+        D3D11Renderer::Layer layer;
+        if (!shaders.GetLayer(preset.name, layer)) {
+            if (preset.isCompiling || preset.isDeferred) continue;  // Lands on a later frame
+            entry.state = CellState::Unsupported;
+            entry.key   = key;
+            m_cellOwner[entry.cell].clear();
+            entry.cell = -1;
+            continue;
+        }
+
+        m_renderer->DrawThumbnail(layer, TIME, m_scratchRTV.Get(), WIDTH, HEIGHT);
+        CopyToCell(m_scratch.Get(), entry.cell);
+        QueueSave(key);
+        entry.state = CellState::Ready;
+        entry.key   = key;
+        ++m_frameWork;
+        return true;
+    }
+    return false;
+}
+
+size_t ThumbnailAtlas::GetBytes() const {
+    if (!m_atlas) return 0;
+    size_t bytes = static_cast<size_t>(WIDTH) * HEIGHT * 4 * (COLUMNS * ROWS + 1);
+    for (const StagingSlot& slot : m_staging) {
+        if (slot.texture) bytes += static_cast<size_t>(WIDTH) * HEIGHT * 4;
+    }
+    return bytes;
+}
+
+uint64_t ThumbnailAtlas::MakeKey(const ShaderPreset& preset) {
+    uint64_t key = Fnv1a64(preset.source.data(), preset.source.size());
+    float custom[16];
+    ShaderManager::PackParamValues(preset, custom);
+    key = Fnv1a64(reinterpret_cast<const char*>(custom), sizeof(custom), key);
+    float extended[MAX_EXTENDED_PARAM_FLOATS];
+    const size_t count = ShaderManager::PackExtendedParams(preset, extended);
+    key = Fnv1a64(reinterpret_cast<const char*>(extended), count * sizeof(float), key);
+    const float time = TIME;
+    return Fnv1a64(reinterpret_cast<const char*>(&time), sizeof(time), key);
+}
+
+std::filesystem::path ThumbnailAtlas::CachePath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.thumb", static_cast<unsigned long long>(key));
+    return m_cacheDir / name;
+}
+
+bool ThumbnailAtlas::LoadCached(uint64_t key, int cell) {
+    std::ifstream in(CachePath(key), std::ios::binary);
+    if (!in) return false;
+    CacheHeader header = {};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+        header.width != WIDTH || header.height != HEIGHT) return false;
+    std::vector<char> pixels(ROW_BYTES * HEIGHT);
+    in.read(pixels.data(), static_cast<std::streamsize>(pixels.size()));
+    if (!in) return false;
+
+    const UINT x = static_cast<UINT>((cell % COLUMNS) * WIDTH);
+    const UINT y = static_cast<UINT>((cell / COLUMNS) * HEIGHT);
+    const D3D11_BOX box = {x, y, 0, x + WIDTH, y + HEIGHT, 1};
+    m_renderer->GetContext()->UpdateSubresource(m_atlas.Get(), 0, &box, pixels.data(),
+                                                static_cast<UINT>(ROW_BYTES), 0);
+    return true;
+}
+
+int ThumbnailAtlas::AcquireCell() {
+    int oldest = -1;
+    uint64_t oldestFrame = 0;
+    for (int cell = 0; cell < static_cast<int>(m_cellOwner.size()); ++cell) {
+        if (m_cellOwner[cell].empty()) return cell;
+        const Entry& owner = m_entries[m_cellOwner[cell]];
+        if (m_frame - owner.lastWanted <= REQUEST_FRAMES) continue;
+        if (oldest < 0 || owner.lastWanted < oldestFrame) {
+            oldest      = cell;
+            oldestFrame = owner.lastWanted;
+        }
+    }
+    if (oldest >= 0) {
+        Entry& owner = m_entries[m_cellOwner[oldest]];
+        owner.cell  = -1;
+        owner.state = CellState::Pending;
+        m_cellOwner[oldest].clear();
+    }
+    return oldest;
+}
+
+void ThumbnailAtlas::CopyToCell(ID3D11Texture2D* source, int cell) {
+    const UINT x = static_cast<UINT>((cell % COLUMNS) * WIDTH);
+    const UINT y = static_cast<UINT>((cell / COLUMNS) * HEIGHT);
+    m_renderer->GetContext()->CopySubresourceRegion(m_atlas.Get(), 0, x, y, 0, source, 0, nullptr);
+}
+
+void ThumbnailAtlas::QueueSave(uint64_t key) {
+    for (StagingSlot& slot : m_staging) {
+        if (!slot.texture || slot.key != 0) continue;
+        ID3D11DeviceContext* context = m_renderer->GetContext();
+        context->CopyResource(slot.texture.Get(), m_scratch.Get());
+        context->End(slot.done.Get());
+        slot.key = key;
+        return;
+    }
+    // All in flight: drawn again next session instead of loaded
+}
+
+void ThumbnailAtlas::SaveFinished() {
+    ID3D11DeviceContext* context = m_renderer->GetContext();
+    for (StagingSlot& slot : m_staging) {
+        if (slot.key == 0 || context->GetData(slot.done.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+            continue;
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (SUCCEEDED(context->Map(slot.texture.Get(), 0, D3D11_MAP_READ, 0, &mapped))) {
+            std::ofstream out(CachePath(slot.key), std::ios::binary | std::ios::trunc);
+            const CacheHeader header = {CACHE_MAGIC, CACHE_VERSION, WIDTH, HEIGHT};
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            for (int row = 0; row < HEIGHT; ++row) {
+                out.write(static_cast<const char*>(mapped.pData) + static_cast<size_t>(row) * mapped.RowPitch,
+                          static_cast<std::streamsize>(ROW_BYTES));
+            }
+            context->Unmap(slot.texture.Get(), 0);
+        }
+        slot.key = 0;
+    }
+}
+
+} // namespace SP
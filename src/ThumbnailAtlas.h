@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+class D3D11Renderer;
+class ShaderManager;
+
+// Shader library thumbnails: a still of each preset, WIDTH x HEIGHT, in a cell
+// of one RGBA8 atlas texture. The library asks for the rows it shows (Request);
+// Update then fills a few cells a frame within a time budget, from the disk
+// cache in shader_cache/thumbnails/ when it has the preset, else by drawing it
+// (D3D11Renderer::DrawThumbnail) over the current video at shader time TIME.
+// The cells are filled by Application's background GPU work, after Present.
+// Drawn cells go back to disk through a small ring of staging textures, read
+// once their copy has finished, so nothing waits on the GPU. A preset's key
+// hashes its source and packed values, so editing either draws it again.
+// Only single-pass pixel presets (what ShaderManager::GetLayer serves) are
+// drawn; render graphs and compute presets are marked unsupported. A deferred
+// preset is compiled for its thumbnail, one at a time, and residency releases
+// it again afterwards. Cells are recycled least recently requested first.
+class ThumbnailAtlas {
+public:
+    static constexpr int   WIDTH   = 160;
+    static constexpr int   HEIGHT  = 90;
+    static constexpr int   COLUMNS = 16;
+    static constexpr int   ROWS    = 16;    // 256 cells, 14.7 MB
+    static constexpr float TIME    = 2.0f;  // Shader time of the still
+
+    ThumbnailAtlas() = default;
+    ~ThumbnailAtlas();
+
+    // Non-copyable
+    ThumbnailAtlas(const ThumbnailAtlas&) = delete;
+    ThumbnailAtlas& operator=(const ThumbnailAtlas&) = delete;
+
+    bool Initialize(D3D11Renderer& renderer);
+    void Shutdown();
+
+    // UI: the library shows `preset` this frame. True with its cell's UVs when
+    // the thumbnail is ready; until then Update works on it.
+    bool Request(const std::string& preset, float uv0[2], float uv1[2]);
+    // Neither drawn nor cached: a render graph, compute or invalid preset
+    bool IsUnsupported(const std::string& preset) const;
+    ID3D11ShaderResourceView* GetSRV() const { return m_atlasSRV.Get(); }
+
+    // Once per frame: ages the requests and writes finished cells to disk
+    void Update();
+    // One cell: loads or draws the first shown preset that needs it. False when
+    // none does. A BackgroundGpuWork task, at most MAX_DRAWS_PER_FRAME a frame.
+    bool Step(ShaderManager& shaders);
+
+    size_t GetBytes() const;  // Atlas, scratch and staging textures
+
+private:
+    static constexpr int MAX_DRAWS_PER_FRAME = 4;
+    static constexpr int STAGING_SLOTS       = 4;
+    static constexpr int REQUEST_FRAMES      = 2;  // Requested this recently counts as shown
+
+    enum class CellState { Pending, Ready, Unsupported };
+    struct Entry {
+        CellState state      = CellState::Pending;
+        int       cell       = -1;
+        uint64_t  key        = 0;  // Of what the cell holds
+        uint64_t  lastWanted = 0;  // m_frame of the last Request
+    };
+    struct StagingSlot {
+        ComPtr<ID3D11Texture2D> texture;
+        ComPtr<ID3D11Query>     done;
+        uint64_t                key = 0;  // 0 = free
+    };
+
+    // FNV-1a of the preset's source and packed values; 0 when it is gone
+    static uint64_t MakeKey(const ShaderPreset& preset);
+    std::filesystem::path CachePath(uint64_t key) const;
+    bool LoadCached(uint64_t key, int cell);
+    int  AcquireCell();  // Free, else the least recently requested one not shown
+    void CopyToCell(ID3D11Texture2D* source, int cell);
+    void QueueSave(uint64_t key);
+    void SaveFinished();  // Writes staging slots whose copy has landed
+
+    D3D11Renderer* m_renderer = nullptr;
+    ComPtr<ID3D11Texture2D>          m_atlas;
+    ComPtr<ID3D11ShaderResourceView> m_atlasSRV;
+    ComPtr<ID3D11Texture2D>          m_scratch;  // Drawn here, then copied into a cell
+    ComPtr<ID3D11RenderTargetView>   m_scratchRTV;
+    StagingSlot m_staging[STAGING_SLOTS];
+    std::filesystem::path m_cacheDir;
+
+    std::unordered_map<std::string, Entry> m_entries;
+    std::vector<std::string> m_cellOwner;  // Preset name per cell; empty = free
+    uint64_t m_frame = 0;
+    int      m_frameWork = 0;  // Cells loaded or drawn since Update
+};
+
+} // namespace SP
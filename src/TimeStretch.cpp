@@ -0,0 +1,97 @@
+#include "TimeStretch.h"
+#include <algorithm>
+#include <cmath>
+
+namespace SP {
+
+void TimeStretch::Reset(int sampleRate) {
+    m_sampleRate = sampleRate;
+    const int rate = std::max(sampleRate, 8000);
+    m_hop    = std::max(static_cast<int>(rate * WINDOW_SECONDS) / 2, 64);
+    m_window = m_hop * 2;
+    m_search = static_cast<int>(rate * SEARCH_SECONDS);
+
+    // Periodic Hann: two windows at 50% overlap sum to exactly one
+    m_hann.resize(static_cast<size_t>(m_window));
+    for (int i = 0; i < m_window; ++i) {
+        m_hann[i] = 0.5f - 0.5f * std::cos(6.28318530718f * static_cast<float>(i) / static_cast<float>(m_window));
+    }
+    m_overlap.assign(static_cast<size_t>(m_hop) * AUDIO_CHANNELS, 0.0f);
+
+    m_input.clear();
+    m_inputBase = 0;
+    m_inputEnd  = 0;
+    m_nominal   = static_cast<double>(m_search);
+    m_natural   = -1;
+}
+
+int TimeStretch::GetPendingInput() const {
+    return static_cast<int>(std::max<int64_t>(m_inputEnd - static_cast<int64_t>(m_nominal), 0));
+}
+
+int TimeStretch::FindBestOffset(int64_t nominal) const {
+    if (m_natural < 0) return 0;
+
+    // Cross-correlate the candidate's overlap half with the natural continuation
+    // of the previous segment, over both channels. Every second frame is enough
+    // to find the peak.
+    const float* target = At(m_natural);
+    int   best      = 0;
+    float bestScore = -1e30f;
+    for (int offset = -m_search; offset <= m_search; offset += 2) {
+        const float* candidate = At(nominal + offset);
+        float score = 0.0f;
+        for (int i = 0; i < m_hop * AUDIO_CHANNELS; i += 2 * AUDIO_CHANNELS) {
+            for (int ch = 0; ch < AUDIO_CHANNELS; ++ch) score += candidate[i + ch] * target[i + ch];
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            best      = offset;
+        }
+    }
+    return best;
+}
+
+void TimeStretch::Process(const float* in, int count, std::vector<float>& out) {
+    if (m_window == 0 || count <= 0) return;
+    m_input.insert(m_input.end(), in, in + static_cast<size_t>(count) * AUDIO_CHANNELS);
+    m_inputEnd += count;
+
+    const double analysisHop = m_hop * m_rate;
+    while (true) {
+        const int64_t nominal = static_cast<int64_t>(m_nominal);
+        // The segment, its search range, and the natural continuation must all be buffered
+        const int64_t needEnd = std::max(nominal + m_search + m_window,
+                                         m_natural >= 0 ? m_natural + m_hop : 0);
+        if (needEnd > m_inputEnd) break;
+
+        const int64_t start = nominal + FindBestOffset(nominal);
+        const float* segment = At(start);
+
+        // First half overlap-adds onto the previous segment's tail and is final
+        const size_t base = out.size();
+        out.resize(base + static_cast<size_t>(m_hop) * AUDIO_CHANNELS);
+        for (int i = 0; i < m_hop * AUDIO_CHANNELS; ++i) {
+            out[base + i] = m_overlap[i] + segment[i] * m_hann[i / AUDIO_CHANNELS];
+        }
+        const float* tail = segment + static_cast<size_t>(m_hop) * AUDIO_CHANNELS;
+        for (int i = 0; i < m_hop * AUDIO_CHANNELS; ++i) {
+            m_overlap[i] = tail[i] * m_hann[m_hop + i / AUDIO_CHANNELS];
+        }
+
+        m_natural  = start + m_hop;
+        m_nominal += analysisHop;
+    }
+
+    // Drop input nothing will read again
+    const int64_t keepFrom = std::min<int64_t>(static_cast<int64_t>(m_nominal) - m_search,
+                                               m_natural >= 0 ? m_natural : m_inputBase);
+    if (keepFrom > m_inputBase) {
+        const int64_t drop = std::min<int64_t>(keepFrom - m_inputBase,
+                                               static_cast<int64_t>(m_input.size() / AUDIO_CHANNELS));
+        m_input.erase(m_input.begin(), m_input.begin() + drop * AUDIO_CHANNELS);
+        m_inputBase += drop;
+    }
+}
+
+} // namespace SP
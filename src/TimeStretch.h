@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Common.h"
+
+namespace SP {
+
+// Pitch-preserving time stretch for interleaved stereo float audio (WSOLA). Used
+// for variable speed playback: each output hop overlap-adds a window of input
+// taken from `rate` hops further along, nudged within a small search range to the
+// offset that best continues the previous window, so the waveform stays
+// phase-coherent. Both channels take the same offset, found on their sum, so the
+// stereo image holds. Positions and counts are in frames.
+//
+// Not thread-safe — main thread only, between AudioReader::Drain and
+// AudioPlayer::Submit.
+class TimeStretch {
+public:
+    TimeStretch() = default;
+
+    // Non-copyable
+    TimeStretch(const TimeStretch&) = delete;
+    TimeStretch& operator=(const TimeStretch&) = delete;
+
+    // Drops all buffered input and output. Call wherever the player is flushed.
+    void Reset(int sampleRate);
+    // Output duration = input duration / rate. Takes effect from the next hop.
+    void SetRate(double rate) { m_rate = rate; }
+    double GetRate() const { return m_rate; }
+    int GetSampleRate() const { return m_sampleRate; }  // As passed to Reset
+
+    // Appends the stretched output for `count` more input frames to `out`.
+    void Process(const float* in, int count, std::vector<float>& out);
+
+    // Input frames accepted but not yet represented in the output
+    int GetPendingInput() const;
+
+private:
+    // ~20 ms windows at 50% overlap, best offset searched within ~10 ms
+    static constexpr double WINDOW_SECONDS = 0.020;
+    static constexpr double SEARCH_SECONDS = 0.010;
+
+    int  FindBestOffset(int64_t nominal) const;  // Offsets relative to m_inputBase
+    const float* At(int64_t index) const { return m_input.data() + (index - m_inputBase) * AUDIO_CHANNELS; }
+
+    double m_rate = 1.0;
+    int    m_sampleRate = 0;
+    int    m_window = 0;   // Analysis/synthesis window length
+    int    m_hop    = 0;   // Output hop (m_window / 2)
+    int    m_search = 0;   // +/- search range in frames
+    std::vector<float> m_hann;
+    std::vector<float> m_overlap;  // Windowed second half of the last segment, interleaved
+
+    std::vector<float> m_input;    // Unconsumed interleaved input; starts at frame m_inputBase
+    int64_t m_inputBase = 0;
+    int64_t m_inputEnd  = 0;
+    double  m_nominal   = 0.0;     // Where the next segment would start without search
+    int64_t m_natural   = -1;      // Continuation of the previous segment (-1 = none yet)
+};
+
+} // namespace SP
@@ -0,0 +1,190 @@
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace SP {
+
+namespace {
+
+// Releases the thread's track when the thread exits, for the next one of its name
+struct ThreadTrack {
+    TraceRecorder::Track* track = nullptr;
+    ~ThreadTrack() {
+        if (track) track->retired.store(true, std::memory_order_release);
+    }
+};
+thread_local ThreadTrack t_track;
+
+// Names are literals in this codebase; escape anyway so a stray quote can't break the file
+void WriteJsonString(std::ofstream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        if (static_cast<unsigned char>(*c) >= 0x20) out << *c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+TraceRecorder& TraceRecorder::Get() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+TraceRecorder::TraceRecorder() : m_origin(Clock::now()) {
+    auto track = std::make_unique<Track>();
+    track->name   = "GPU";
+    track->id     = 0;
+    track->events = std::make_unique<Event[]>(RING_EVENTS);
+    m_gpuTrack = track.get();
+    m_tracks.push_back(std::move(track));
+}
+
+TraceRecorder::Track* TraceRecorder::AcquireTrack(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_tracksMutex);
+    for (auto& track : m_tracks) {
+        bool retired = true;
+        if (track->name == name && track.get() != m_gpuTrack &&
+            track->retired.compare_exchange_strong(retired, false)) {
+            return track.get();
+        }
+    }
+    auto track = std::make_unique<Track>();
+    track->name   = name;
+    track->id     = static_cast<int>(m_tracks.size());
+    track->events = std::make_unique<Event[]>(RING_EVENTS);
+    m_tracks.push_back(std::move(track));
+    return m_tracks.back().get();
+}
+
+TraceRecorder::Track* TraceRecorder::CurrentTrack() {
+    if (!t_track.track) {
+        // A thread that never named itself
+        std::string name = "Thread " + std::to_string(GetCurrentThreadId());
+        t_track.track = AcquireTrack(name);
+    }
+    return t_track.track;
+}
+
+void TraceRecorder::SetThreadName(const char* name) {
+    TraceRecorder& recorder = Get();
+    if (t_track.track) {
+        if (t_track.track->name == name) return;
+        t_track.track->retired.store(true, std::memory_order_release);
+    }
+    t_track.track = recorder.AcquireTrack(name);
+#ifdef SHADERPLAYER_TRACY
+    TracyCSetThreadName(name);
+#endif
+}
+
+void TraceRecorder::Write(Track& track, const char* name, Clock::time_point begin, Clock::time_point end) {
+    // Single writer per track: fill the slot, then publish it by bumping the count
+    const uint64_t index = track.written.load(std::memory_order_relaxed);
+    Event& event = track.events[index % RING_EVENTS];
+    event.name    = name;
+    event.beginUs = ToUs(begin);
+    event.endUs   = ToUs(end);
+    track.written.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::Record(const char* name, Clock::time_point begin, Clock::time_point end) {
+    if (!IsEnabled()) return;
+    Write(*CurrentTrack(), name, begin, end);
+}
+
+void TraceRecorder::RecordGpu(const char* name, Clock::time_point begin, Clock::time_point end) {
+    if (!IsEnabled()) return;
+    Write(*m_gpuTrack, name, begin, end);
+}
+
+void TraceRecorder::MarkFrame() {
+#ifdef SHADERPLAYER_TRACY
+    TracyCFrameMark;
+#endif
+}
+
+void TraceRecorder::Plot(const char* name, double value) {
+#ifdef SHADERPLAYER_TRACY
+    TracyCPlot(name, value);
+#else
+    (void)name;
+    (void)value;
+#endif
+}
+
+TraceRecorder::Scope::Scope(const char* name) : m_name(name), m_start(Clock::now()) {
+#ifdef SHADERPLAYER_TRACY
+    const uint64_t srcloc = ___tracy_alloc_srcloc_name(0, "", 0, "", 0, name, strlen(name), 0);
+    m_tracyZone = ___tracy_emit_zone_begin_alloc(srcloc, 1);
+#endif
+}
+
+TraceRecorder::Scope::~Scope() {
+#ifdef SHADERPLAYER_TRACY
+    TracyCZoneEnd(m_tracyZone);
+#endif
+    Get().Record(m_name, m_start, Clock::now());
+}
+
+bool TraceRecorder::WriteChromeTrace(const std::string& path, double seconds) {
+    struct TrackCopy {
+        std::string name;
+        int id = 0;
+        std::vector<Event> events;
+    };
+    std::vector<TrackCopy> copies;
+    {
+        std::lock_guard<std::mutex> lock(m_tracksMutex);
+        copies.reserve(m_tracks.size());
+        for (const auto& track : m_tracks) {
+            TrackCopy copy;
+            copy.name = track->name;
+            copy.id   = track->id;
+            const uint64_t end   = track->written.load(std::memory_order_acquire);
+            const uint64_t begin = end > RING_EVENTS ? end - RING_EVENTS : 0;
+            copy.events.reserve(static_cast<size_t>(end - begin));
+            for (uint64_t i = begin; i < end; ++i) copy.events.push_back(track->events[i % RING_EVENTS]);
+            // Whatever the writer lapped while we copied is torn: drop it
+            const uint64_t after = track->written.load(std::memory_order_acquire);
+            const uint64_t overwritten = after > begin + RING_EVENTS ? after - begin - RING_EVENTS : 0;
+            copy.events.erase(copy.events.begin(),
+                              copy.events.begin() + static_cast<ptrdiff_t>(std::min<uint64_t>(overwritten, copy.events.size())));
+            copies.push_back(std::move(copy));
+        }
+    }
+
+    const int64_t cutoffUs = ToUs(Clock::now()) - static_cast<int64_t>(seconds * 1e6);
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) return false;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&] {
+        if (!first) out << ",\n";
+        first = false;
+    };
+    for (const TrackCopy& track : copies) {
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track.id << ",\"args\":{\"name\":";
+        WriteJsonString(out, track.name.c_str());
+        out << "}}";
+        // GPU first, then threads in registration order (main thread is the first)
+        separator();
+        out << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track.id
+            << ",\"args\":{\"sort_index\":" << track.id << "}}";
+        for (const Event& event : track.events) {
+            if (!event.name || event.endUs < cutoffUs) continue;
+            separator();
+            out << "{\"name\":";
+            WriteJsonString(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << track.id << ",\"ts\":" << event.beginUs
+                << ",\"dur\":" << std::max<int64_t>(event.endUs - event.beginUs, 0) << '}';
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace SP
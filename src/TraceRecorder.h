@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Common.h"
+#include <chrono>
+#ifdef SHADERPLAYER_TRACY
+#include <tracy/TracyC.h>
+#endif
+
+namespace SP {
+
+// Timeline of named intervals on every instrumented thread plus a GPU track, kept
+// in per-thread rings so the last several seconds can be dumped as a Chrome
+// trace_event JSON (chrome://tracing, Perfetto) on demand. With SHADERPLAYER_TRACY
+// the same scopes are also streamed to a connected Tracy client.
+//
+// Each thread writes only its own ring, with no locks (the miniaudio callback is
+// one of them). A dump copies the rings while they keep running and drops any
+// event that was overwritten during the copy. A thread's ring outlives it and
+// is reused by the next thread that registers under the same name, so restarted
+// workers don't leak rings.
+//
+// Event names must be string literals (or otherwise live forever).
+class TraceRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int RING_EVENTS = 32768;  // Per thread
+
+    static TraceRecorder& Get();
+
+    // Names the calling thread's track; call once at the top of a thread
+    static void SetThreadName(const char* name);
+
+    void SetEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // An interval on the calling thread's track
+    void Record(const char* name, Clock::time_point begin, Clock::time_point end);
+    // An interval on the GPU track (render thread only), already in CPU time
+    void RecordGpu(const char* name, Clock::time_point begin, Clock::time_point end);
+    // Tracy frame boundary; the Chrome dump has no use for it
+    void MarkFrame();
+    // Tracy plot of a per-frame value (GPU stage times)
+    void Plot(const char* name, double value);
+
+    // The last `seconds` of every track, as Chrome trace_event JSON
+    bool WriteChromeTrace(const std::string& path, double seconds);
+
+    // Times the enclosing block; use SP_TRACE_SCOPE
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        float ElapsedMs() const {
+            return std::chrono::duration<float, std::milli>(Clock::now() - m_start).count();
+        }
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const char*       m_name;
+        Clock::time_point m_start;
+#ifdef SHADERPLAYER_TRACY
+        TracyCZoneCtx m_tracyZone{};
+#endif
+    };
+
+    struct Event {
+        const char* name = nullptr;
+        int64_t beginUs = 0;  // Since the recorder started
+        int64_t endUs   = 0;
+    };
+    struct Track {
+        std::string name;
+        int id = 0;
+        std::unique_ptr<Event[]> events;
+        std::atomic<uint64_t> written{0};  // Events ever written; the ring holds the last RING_EVENTS
+        std::atomic<bool>     retired{false};  // Its thread has exited
+    };
+
+private:
+    TraceRecorder();
+    Track* AcquireTrack(const std::string& name);
+    Track* CurrentTrack();
+    void Write(Track& track, const char* name, Clock::time_point begin, Clock::time_point end);
+    int64_t ToUs(Clock::time_point t) const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(t - m_origin).count();
+    }
+
+    Clock::time_point m_origin;
+    std::atomic<bool> m_enabled{true};
+    std::mutex m_tracksMutex;  // Track list; never taken while recording
+    std::vector<std::unique_ptr<Track>> m_tracks;
+    Track* m_gpuTrack = nullptr;
+};
+
+#define SP_TRACE_CONCAT_(a, b) a##b
+#define SP_TRACE_NAME_(line) SP_TRACE_CONCAT_(traceScope_, line)
+// Records the rest of the enclosing block as `name` on this thread's track
+#define SP_TRACE_SCOPE(name) ::SP::TraceRecorder::Scope SP_TRACE_NAME_(__LINE__)(name)
+
+} // namespace SP
@@ -1,17 +1,65 @@
 #include "UIManager.h"
 #include "Application.h"
+#include "CaptureDevices.h"
+#include "ThreadPriority.h"
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx11.h"
 #include <algorithm>
 #include <cmath>
-#include <dshow.h>
-#pragma comment(lib, "strmiids.lib")
+#include <map>
 
 // Forward declare message handler from imgui_impl_win32.cpp
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 namespace SP {
 
+namespace {
+
+// Recording panel codec list; the encoder name goes to RecordingSettings::codec
+struct RecordingCodec {
+    const char* label;
+    const char* encoder;
+};
+constexpr RecordingCodec RECORDING_CODECS[] = {
+    { "H.264 (MP4)",            "libx264"    },
+    { "ProRes (MOV)",           "prores_ks"  },
+    { "H.264 NVENC (MP4)",      "h264_nvenc" },
+    { "HEVC NVENC (MP4)",       "hevc_nvenc" },
+    { "H.264 Quick Sync (MP4)", "h264_qsv"   },
+    { "HEVC Quick Sync (MP4)",  "hevc_qsv"   },
+    { "H.264 AMF (MP4)",        "h264_amf"   },
+    { "HEVC AMF (MP4)",         "hevc_amf"   },
+    { "FFV1 lossless (MKV)",    "ffv1"       },
+    { "UtVideo lossless (MKV)", "utvideo"    },
+    { "H.264 RGB lossless (MKV)", "libx264rgb" },
+};
+
+// Size divisors of an extra (review copy) target
+constexpr int EXTRA_TARGET_DOWNSCALES[] = { 1, 2, 4 };
+
+// libx264 speed presets, fastest first
+constexpr const char* X264_PRESETS[] = {
+    "ultrafast", "superfast", "veryfast", "faster", "fast", "medium", "slow"
+};
+
+// Dropped share of a realtime take above which the preset steps faster
+constexpr double ADAPT_DROP_RATIO = 0.01;
+
+// Builds after an input event: hover, popups and clicks take ImGui a frame or
+// two to settle
+constexpr int INPUT_SETTLE_BUILDS = 3;
+
+// Tiles of a tiled still export while live tiling is off
+constexpr int DEFAULT_STILL_TILE_SIZE = 2048;
+
+bool IsUiInputMessage(UINT msg) {
+    return (msg >= WM_MOUSEFIRST && msg <= WM_MOUSELAST) || (msg >= WM_KEYFIRST && msg <= WM_KEYLAST) ||
+           msg == WM_MOUSELEAVE || msg == WM_SETFOCUS || msg == WM_KILLFOCUS || msg == WM_SIZE ||
+           msg == WM_INPUTLANGCHANGE;
+}
+
+} // namespace
+
 UIManager::UIManager(Application& app)
     : m_app(app)
 {
@@ -205,15 +253,39 @@ void UIManager::Shutdown() {
     ImGui::DestroyContext();
 }
 
+bool UIManager::NeedsRebuild(int idleRebuildHz) {
+    const auto now = std::chrono::steady_clock::now();
+    const bool rebuild =
+        idleRebuildHz <= 0 ||
+        m_settleBuilds > 0 ||
+        !m_notifications.empty() ||   // Counting down
+        ImGui::IsAnyItemActive() ||   // Drags, text input
+        m_app.GetPreviewSRV() != m_builtDisplaySRV ||  // The old draw data names a released view
+        std::chrono::duration<double>(now - m_lastBuildTime).count() >= 1.0 / idleRebuildHz;  // Meters, time readouts
+    if (rebuild) {
+        m_settleBuilds  = std::max(m_settleBuilds - 1, 0);
+        m_lastBuildTime = now;
+    }
+    return rebuild;
+}
+
 void UIManager::BeginFrame() {
+    m_app.GetWorkspaceManager().ApplyPendingLayout();
     ImGui_ImplDX11_NewFrame();
     ImGui_ImplWin32_NewFrame();
     ImGui::NewFrame();
+    m_frameBuilt      = true;
+    m_builtDisplaySRV = m_app.GetPreviewSRV();
 }
 
 void UIManager::EndFrame() {
-    ImGui::Render();
-    ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+    // Without a build the last frame's draw data is still valid: it lives until
+    // the next NewFrame
+    if (m_frameBuilt) {
+        ImGui::Render();
+        m_frameBuilt = false;
+    }
+    if (ImDrawData* drawData = ImGui::GetDrawData()) ImGui_ImplDX11_RenderDrawData(drawData);
 }
 
 void UIManager::Render() {
@@ -270,14 +342,62 @@ void UIManager::Render() {
         DrawNoisePanel();
     }
 
+    if (m_showDeckPanel) {
+        DrawDeckPanel();
+    }
+
+    if (m_showChannelsPanel) {
+        DrawChannelsPanel();
+    }
+
+    if (m_showCanvasPanel) {
+        DrawCanvasPanel();
+    }
+
+    if (m_showPlaylistPanel) {
+        DrawPlaylistPanel();
+    }
+
     if (m_showSpoutPanel) {
         DrawSpoutPanel();
     }
 
+    if (m_showNdiPanel) {
+        DrawNdiPanel();
+    }
+
+    if (m_showVirtualCameraPanel) {
+        DrawVirtualCameraPanel();
+    }
+
+    if (m_showControllersPanel) {
+        DrawControllersPanel();
+    }
+
+    if (m_showPostChainsPanel) {
+        DrawPostChainsPanel();
+    }
+
     if (m_showAudioPanel) {
         DrawAudioPanel();
     }
 
+    if (m_showDecoderPanel) {
+        DrawDecoderPanel();
+    }
+
+    if (m_showGpuProfiler) {
+        DrawGpuProfiler();
+    }
+
+    if (m_showFrameTiming) {
+        DrawFrameTiming();
+    }
+
+    if (m_showMemoryPanel) {
+        DrawMemoryPanel();
+    }
+
     DrawCaptureDialog();
 
     DrawNotifications();
@@ -376,11 +496,116 @@ void UIManager::DrawMenuBar() {
             ImGui::MenuItem("Shader Editor", "F1", &m_showEditor);
             ImGui::MenuItem("Shader Library", "F2", &m_showLibrary);
             ImGui::MenuItem("Transport Controls", "F3", &m_showTransport);
+            {
+                bool overview = m_app.GetConfig().timelineOverview;
+                if (ImGui::MenuItem("Timeline Overview", nullptr, &overview)) m_app.SetTimelineOverview(overview);
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Filmstrip and waveform above the seek bar, built in the\n"
+                                      "background from keyframes and cached per file.");
+            }
             ImGui::MenuItem("Recording Panel", "F4", &m_showRecording);
             ImGui::MenuItem("Keybindings", "F6", &m_showKeybindingsPanel);
             ImGui::MenuItem("Noise Generator", nullptr, &m_showNoisePanel);
+            ImGui::MenuItem("A/B Decks", nullptr, &m_showDeckPanel);
+            ImGui::MenuItem("Channels", nullptr, &m_showChannelsPanel);
+            ImGui::MenuItem("Canvas", nullptr, &m_showCanvasPanel);
+            ImGui::MenuItem("Playlist", nullptr, &m_showPlaylistPanel);
             ImGui::MenuItem("Spout Output", "F8", &m_showSpoutPanel);
+            ImGui::MenuItem("NDI", nullptr, &m_showNdiPanel);
+            ImGui::MenuItem("Virtual Camera", nullptr, &m_showVirtualCameraPanel);
+            ImGui::MenuItem("Controllers (OSC / MIDI)", nullptr, &m_showControllersPanel);
+            ImGui::MenuItem("Output Post Chains", nullptr, &m_showPostChainsPanel);
             ImGui::MenuItem("Audio Monitor", nullptr, &m_showAudioPanel);
+            ImGui::MenuItem("Video Decoder", nullptr, &m_showDecoderPanel);
+            ImGui::MenuItem("GPU Profiler", nullptr, &m_showGpuProfiler);
+            ImGui::MenuItem("Frame Timing", nullptr, &m_showFrameTiming);
+            ImGui::MenuItem("Memory", nullptr, &m_showMemoryPanel);
+            {
+                AppConfig& cfg = m_app.GetConfig();
+                if (ImGui::BeginMenu("GPU")) {
+                    if (m_adapters.empty()) m_adapters = D3D11Renderer::ListAdapters();
+                    auto choose = [&](const std::string& name) {
+                        if (cfg.gpuAdapter == name) return;
+                        cfg.gpuAdapter = name;
+                        m_app.SaveConfig();
+                        ShowNotification("GPU changes on the next start");
+                    };
+                    if (ImGui::MenuItem("Best Performance", nullptr, cfg.gpuAdapter.empty())) choose({});
+                    if (ImGui::IsItemHovered())
+                        ImGui::SetTooltip("The GPU Windows ranks highest for performance:\n"
+                                          "the discrete card on a hybrid laptop.");
+                    for (const AdapterInfo& adapter : m_adapters) {
+                        const std::string label = adapter.name + " (" +
+                                                  std::to_string(adapter.dedicatedBytes >> 20) + " MB)";
+                        if (ImGui::MenuItem(label.c_str(), nullptr, cfg.gpuAdapter == adapter.name))
+                            choose(adapter.name);
+                    }
+                    ImGui::Separator();
+                    const std::string& current = m_app.GetRenderer().GetAdapterName();
+                    ImGui::TextDisabled("In use: %s", current.empty() ? "system default" : current.c_str());
+                    ImGui::EndMenu();
+                } else {
+                    m_adapters.clear();  // Listed again on the next open, for hot-plugged GPUs
+                }
+                if (ImGui::MenuItem("Low-Latency Present", nullptr, &cfg.lowLatencyPresent)) {
+                    m_app.GetRenderer().SetMaximumFrameLatency(cfg.lowLatencyPresent ? 1 : 2);
+                    m_app.SaveConfig();
+                }
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Queue at most one frame: parameter and audio changes reach the screen\n"
+                                      "sooner, at the cost of less slack for uneven frame times.");
+                if (ImGui::MenuItem("VSync", nullptr, &cfg.vsync)) m_app.SaveConfig();
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip(m_app.GetRenderer().IsTearingSupported()
+                        ? "Off: present as soon as a frame is done. Tears on fixed-rate displays;\n"
+                          "G-Sync/FreeSync displays refresh at the frame rate instead."
+                        : "Off: present as soon as a frame is done (tearing is not supported\n"
+                          "here, so the compositor still syncs the main window).");
+                ImGui::SetNextItemWidth(120.0f);
+                if (ImGui::DragInt("Frame Rate Cap", &cfg.frameRateCap, 1.0f, 0, 1000,
+                                   cfg.frameRateCap > 0 ? "%d fps" : "Off")) {
+                    cfg.frameRateCap = std::clamp(cfg.frameRateCap, 0, 1000);
+                }
+                if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SaveConfig();
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Ticks per second of the whole loop (render, outputs, UI), independent of vsync.");
+                ImGui::SetNextItemWidth(120.0f);
+                if (ImGui::DragInt("Battery Cap", &cfg.batteryFrameRateCap, 1.0f, 0, 240,
+                                   cfg.batteryFrameRateCap > 0 ? "%d fps" : "Off")) {
+                    cfg.batteryFrameRateCap = std::clamp(cfg.batteryFrameRateCap, 0, 240);
+                }
+                if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SaveConfig();
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Tick cap while the machine runs on battery. Applies on top of\n"
+                                      "Frame Rate Cap: whichever is lower wins.");
+                ImGui::SetNextItemWidth(120.0f);
+                if (ImGui::DragInt("UI Refresh", &cfg.uiRefreshHz, 1.0f, 0, 240,
+                                   cfg.uiRefreshHz > 0 ? "%d Hz" : "Every frame")) {
+                    cfg.uiRefreshHz = std::clamp(cfg.uiRefreshHz, 0, 240);
+                }
+                if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SaveConfig();
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Redraw this window less often than the output window, Spout and\n"
+                                      "recording render. Without a cap, the output window's monitor sets the pace.");
+                ImGui::SetNextItemWidth(120.0f);
+                if (ImGui::DragInt("UI Idle Rebuild", &cfg.uiIdleRebuildHz, 1.0f, 0, 240,
+                                   cfg.uiIdleRebuildHz > 0 ? "%d Hz" : "Every redraw")) {
+                    cfg.uiIdleRebuildHz = std::clamp(cfg.uiIdleRebuildHz, 0, 240);
+                }
+                if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SaveConfig();
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Without input, rebuild the panels only this often and redraw the last\n"
+                                      "build in between (the video viewport still shows every frame).\n"
+                                      "Meters and time readouts update at this rate.");
+                if (ImGui::MenuItem("Thread Priorities", nullptr, &cfg.threadPriorities)) {
+                    ThreadPriority::SetEnabled(cfg.threadPriorities);
+                    m_app.SaveConfig();
+                }
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Schedule the audio, render and decode threads with MMCSS and run\n"
+                                      "recording and compiles below normal. Applies as threads start and\n"
+                                      "to the audio device the next time it opens.");
+            }
 
             ImGui::Separator();
             const bool outWinOpen = m_app.IsVideoOutputWindowOpen();
@@ -428,6 +653,33 @@ void UIManager::DrawMenuBar() {
             if (ImGui::MenuItem("Compile", "F5")) {
                 m_app.CompileCurrentShader(GetEditorContent());
             }
+            bool lazyCompile = m_app.GetConfig().lazyShaderCompile;
+            if (ImGui::MenuItem("Compile on First Use", nullptr, &lazyCompile)) {
+                m_app.GetConfig().lazyShaderCompile = lazyCompile;
+                m_app.GetShaderManager().SetLazyCompile(lazyCompile);
+                m_app.SaveConfig();
+            }
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Library mode: shaders compile when first selected (or in the\n"
+                                  "background if they have a keybinding) instead of all at startup.\n"
+                                  "Applies to shaders loaded from now on.");
+            int budget = m_app.GetConfig().residentShaderBudget;
+            ImGui::SetNextItemWidth(120.0f);
+            if (ImGui::InputInt("Resident Shaders", &budget, 16, 64)) {
+                m_app.GetConfig().residentShaderBudget = std::max(budget, 0);
+                m_app.GetShaderManager().SetResidencyBudget(m_app.GetConfig().residentShaderBudget);
+                m_app.SaveConfig();
+            }
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Shader objects kept alive (0 = no limit). Past it, the least recently\n"
+                                  "used shaders are released and recreated from the bytecode cache\n"
+                                  "on next use. The active shader, its neighbours and keybound\n"
+                                  "shaders always stay.");
+            if (ImGui::MenuItem("Library Thumbnails", nullptr, &m_app.GetConfig().libraryThumbnails))
+                m_app.SaveConfig();
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("A still of each shader in the library, drawn a few per frame in the\n"
+                                  "background and kept in shader_cache/thumbnails.");
             ImGui::Separator();
             if (ImGui::MenuItem("Reset to Passthrough", "Escape")) {
                 m_app.GetShaderManager().SetPassthrough();
@@ -438,17 +690,20 @@ void UIManager::DrawMenuBar() {
         if (ImGui::BeginMenu("Recording")) {
             if (!m_app.GetEncoder().IsRecording()) {
                 if (ImGui::MenuItem("Start Recording", "F9")) {
-                    RecordingSettings settings;
-                    settings.outputPath = m_recordingPath;
-                    settings.codec = (m_recordingCodec == 0) ? "libx264" : "prores_ks";
-                    settings.bitrate = m_recordingBitrate * 1000000;
-                    settings.proresProfile = m_proresProfile;
-                    m_app.StartRecording(settings);
+                    m_app.StartRecording(MakeRecordingSettings(), MakeExtraTargets());
                 }
             } else {
                 if (ImGui::MenuItem("Stop Recording", "F9")) {
                     m_app.StopRecording();
                 }
+                if (m_app.GetEncoder().IsReplayMode() && ImGui::MenuItem("Save Replay", "F11")) {
+                    m_app.SaveReplay();
+                }
+            }
+            ImGui::Separator();
+            if (ImGui::MenuItem(m_app.IsRecordingSession() ? "Stop Session Recording" : "Record Session", "Ctrl+R",
+                                false, !m_app.IsReplayingSession())) {
+                m_app.ToggleSessionRecording();
             }
             ImGui::Separator();
             ImGui::MenuItem("Recording Settings...", nullptr, &m_showRecording);
@@ -467,7 +722,7 @@ void UIManager::DrawVideoViewport() {
     auto& renderer  = m_app.GetRenderer();
     const ShaderPreset* active = m_app.GetShaderManager().GetActivePreset();
     const bool generativeActive = (active && active->isGenerative);
-    ID3D11ShaderResourceView* srv = renderer.GetDisplaySRV();
+    ID3D11ShaderResourceView* srv = m_app.GetPreviewSRV();  // The display texture, or the preview's post chain
 
     // Helper: draw srv letterboxed into available content area at the given logical dimensions.
     auto drawLetterboxed = [&](float srcW, float srcH) {
@@ -480,16 +735,20 @@ void UIManager::DrawVideoViewport() {
             origin.x + (avail.x - drawW) * 0.5f,
             origin.y + (avail.y - drawH) * 0.5f));
         ImGui::Image(reinterpret_cast<ImTextureID>(srv), ImVec2(drawW, drawH));
+        m_videoViewportSize = ImVec2(drawW, drawH);
     };
+    m_videoViewportSize = ImVec2(0.0f, 0.0f);
 
     if (decoder.IsOpen()) {
         const float videoW = static_cast<float>(decoder.GetWidth());
         const float videoH = static_cast<float>(decoder.GetHeight());
 
         // Info + optional blend control on the same line
-        ImGui::Text("%dx%d @ %.2f fps | %s",
+        ImGui::Text("%dx%d @ %.2f fps | %s%s%s",
             decoder.GetWidth(), decoder.GetHeight(),
-            decoder.GetFPS(), decoder.GetCodecName().c_str());
+            decoder.GetFPS(), decoder.GetCodecName().c_str(),
+            decoder.IsHardwareAccelerated() ? " (D3D11VA)" : "",
+            (decoder.GetProxyScale() > 1 && !decoder.IsLiveCapture()) ? " | proxy" : "");
 
         if (srv) drawLetterboxed(videoW, videoH);
 
@@ -545,7 +804,9 @@ void UIManager::DrawShaderEditor() {
             auto* preset = m_app.GetShaderManager().GetActivePreset();
             if (preset) {
                 ImGui::SameLine();
-                if (preset->isValid) {
+                if (preset->isCompiling) {
+                    ImGui::TextColored(ImVec4(0.8f, 0.7f, 0.2f, 1.0f), "Compiling...");
+                } else if (preset->isValid) {
                     ImGui::TextColored(ImVec4(0.2f, 0.8f, 0.2f, 1.0f), "OK");
                 } else {
                     ImGui::TextColored(ImVec4(0.8f, 0.2f, 0.2f, 1.0f), "Error");
@@ -602,6 +863,52 @@ void UIManager::DrawShaderParameters() {
         ImGui::Separator();
     }
 
+    // Multi-pass: how many intermediate targets the passes share after aliasing
+    if (!preset->passes.empty()) {
+        const RenderTargetPool& pool = m_app.GetRenderer().GetTargetPool();
+        ImGui::TextDisabled("%d passes | %d pooled targets, %.1f MB", static_cast<int>(preset->passes.size()),
+                            pool.GetTargetCount(), pool.GetUsedBytes() / (1024.0 * 1024.0));
+        const bool persistent = std::any_of(preset->passes.begin(), preset->passes.end(),
+                                            [](const RenderPassDesc& pass) { return pass.persistent; });
+        if (persistent) {
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Reset State")) m_app.GetRenderer().ResetPersistentTargets();
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Clear the persistent pass buffers; the simulation starts over.");
+        }
+        ImGui::Separator();
+    }
+
+    // Single-pass colour presets: bake the grade to a .cube for other tools or a "lut" input
+    if (preset->passes.empty() && !preset->compute.enabled) {
+        static int s_bakeSize = 1;  // 17, 33, 65
+        constexpr int BAKE_SIZES[] = { 17, 33, 65 };
+        ImGui::SetNextItemWidth(60.0f);
+        ImGui::Combo("##bakeSize", &s_bakeSize, "17\0" "33\0" "65\0");
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Bake LUT...")) m_app.BakeLutDialog(BAKE_SIZES[s_bakeSize]);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Run the shader over an identity lattice and save the result as a .cube.\n"
+                              "Only meaningful for per-pixel colour transforms.");
+        ImGui::Separator();
+    }
+
+    // Automation take: every param moved while it runs becomes keys at Stop
+    if (m_app.IsAutomationRecording()) {
+        ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.75f, 0.15f, 0.15f, 1.0f));
+        if (ImGui::SmallButton("Stop Automation")) m_app.StopAutomationRecording();
+        ImGui::PopStyleColor();
+        ImGui::SameLine();
+        ImGui::TextDisabled("%d param%s recording", m_app.GetAutomationLatchedCount(),
+                            m_app.GetAutomationLatchedCount() == 1 ? "" : "s");
+    } else if (ImGui::SmallButton("Record Automation")) {
+        m_app.StartAutomationRecording();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Move params while the video plays; each one you touch is recorded into\n"
+                          "its keyframe timeline, simplified to a few curve keys when you stop.");
+    ImGui::Separator();
+
     // Reset stale keyframe selection if param index is out of range
     if (m_selectedKeyframeParam >= static_cast<int>(preset->params.size())) {
         m_selectedKeyframeParam = -1;
@@ -621,8 +928,9 @@ void UIManager::DrawShaderParameters() {
         ImGui::PushID(&p);
 
         // Check if parameter is being driven by keyframes during playback
+        // Not while recording automation: moving it takes over from its keys
         bool kfDriven = p.timeline && p.timeline->enabled && !p.timeline->keyframes.empty()
-                        && m_app.GetPlaybackState() == PlaybackState::Playing;
+                        && m_app.GetPlaybackState() == PlaybackState::Playing && !m_app.IsAutomationRecording();
         if (kfDriven) {
             ImGui::PushStyleVar(ImGuiStyleVar_Alpha, ImGui::GetStyle().Alpha * 0.5f);
             ImGui::BeginDisabled();
@@ -720,6 +1028,22 @@ void UIManager::DrawShaderParameters() {
             else if (p.audioBand == "rms")      liveVal = ad.rms;
             else if (p.audioBand == "beat")     liveVal = ad.beat;
             else if (p.audioBand == "centroid") liveVal = ad.spectralCentroid;
+            else if (p.audioBand == "width")    liveVal = ad.stereoWidth;
+            else if (p.audioBand == "bpm")      liveVal = ad.bpm / 200.0f;  // Meter scale only
+            else if (p.audioBand == "beatPhase") liveVal = ad.beatPhase;
+            else if (p.audioBand == "barPhase") liveVal = ad.barPhase;
+            else {
+                // Per-channel bands: "<band>Left" / "<band>Right"
+                const bool right = p.audioBand.ends_with("Right");
+                const int  ch    = right ? 1 : 0;
+                const std::string band = p.audioBand.substr(0, p.audioBand.size() - (right ? 5 : 4));
+                if (right || p.audioBand.ends_with("Left")) {
+                    if      (band == "rms")  liveVal = ad.channelRms[ch];
+                    else if (band == "bass") liveVal = ad.channelBass[ch];
+                    else if (band == "mid")  liveVal = ad.channelMid[ch];
+                    else if (band == "high") liveVal = ad.channelHigh[ch];
+                }
+            }
             // Colour the bar: beat = orange, others = default
             if (p.audioBand == "beat" && liveVal > 0.1f)
                 ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(1.0f, 0.6f, 0.1f, 1.0f));
@@ -730,6 +1054,48 @@ void UIManager::DrawShaderParameters() {
             break;
         }
 
+        case ShaderParamType::Image: {
+            // Extra video input: the file bound to t(4 + inputIndex)
+            const VideoInput& input = m_app.GetVideoInput(p.inputIndex);
+            ImGui::Text("%s (t%d)", p.label.c_str(), FIRST_INPUT_SLOT + p.inputIndex);
+            if (ImGui::SmallButton("Open...")) m_app.OpenVideoInputDialog(p.inputIndex);
+            if (input.IsOpen()) {
+                ImGui::SameLine();
+                if (ImGui::SmallButton("Clear")) m_app.CloseVideoInput(p.inputIndex);
+            }
+            ImGui::SameLine();
+            if (input.IsOpen()) {
+                const VideoDecoder& inputDecoder = input.GetDecoder();
+                ImGui::TextDisabled("%s  %dx%d  %.2fs",
+                                    std::filesystem::path(input.GetPath()).filename().string().c_str(),
+                                    inputDecoder.GetWidth(), inputDecoder.GetHeight(),
+                                    input.GetFrame().timestamp);
+            } else {
+                ImGui::TextDisabled("(no input)");
+            }
+            break;
+        }
+
+        case ShaderParamType::Lut: {
+            // Colour LUT: the file bound to t(20 + inputIndex)
+            const int size = m_app.GetLutSize(p.inputIndex);
+            ImGui::Text("%s (t%d)", p.label.c_str(), FIRST_LUT_SLOT + p.inputIndex);
+            if (ImGui::SmallButton("Open...")) m_app.OpenLutDialog(p.inputIndex);
+            if (size > 0) {
+                ImGui::SameLine();
+                if (ImGui::SmallButton("Clear")) m_app.CloseLut(p.inputIndex);
+            }
+            ImGui::SameLine();
+            const auto& paths = m_app.GetConfig().lutFiles;
+            if (size > 0 && p.inputIndex < static_cast<int>(paths.size())) {
+                ImGui::TextDisabled("%s  %d^3", std::filesystem::path(paths[p.inputIndex]).filename().string().c_str(),
+                                    size);
+            } else {
+                ImGui::TextDisabled("(no LUT)");
+            }
+            break;
+        }
+
         } // switch
 
         if (kfDriven) {
@@ -737,8 +1103,9 @@ void UIManager::DrawShaderParameters() {
             ImGui::PopStyleVar();
         }
 
-        // --- Per-parameter reset button (skip Event and AudioBand) ---
-        if (p.type != ShaderParamType::Event && p.type != ShaderParamType::AudioBand) {
+        // --- Per-parameter reset button (skip Event, AudioBand, Image and Lut) ---
+        if (p.type != ShaderParamType::Event && p.type != ShaderParamType::AudioBand &&
+            p.type != ShaderParamType::Image && p.type != ShaderParamType::Lut) {
             ImGui::SameLine();
             bool atDefault = (memcmp(p.values, p.defaultValues, 4 * sizeof(float)) == 0);
             if (atDefault) ImGui::BeginDisabled();
@@ -751,8 +1118,40 @@ void UIManager::DrawShaderParameters() {
                 ImGui::SetTooltip("Reset to default");
         }
 
-        // --- Keyframe toggle (skip Event and AudioBand — both are non-user-driven) ---
-        if (p.type != ShaderParamType::Event && p.type != ShaderParamType::AudioBand) {
+        // --- Controller learn (OSC / MIDI): the next address that arrives drives this param ---
+        if (p.type == ShaderParamType::Float || p.type == ShaderParamType::Bool || p.type == ShaderParamType::Event ||
+            p.type == ShaderParamType::Point2D || p.type == ShaderParamType::Color) {
+            ImGui::SameLine();
+            const int components = p.type == ShaderParamType::Point2D ? 2 : p.type == ShaderParamType::Color ? 4 : 1;
+            bool learning = false;
+            for (int c = 0; c < components; ++c) learning |= m_app.IsLearningControl(p.name, c);
+            if (learning) ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.2f, 0.5f, 0.9f, 1.0f));
+            if (ImGui::SmallButton(learning ? "...##learn" : "L##learn")) {
+                if (learning)             m_app.CancelControlLearn();
+                else if (components == 1) m_app.LearnControl(p.name, 0);
+                else                      ImGui::OpenPopup("##learnComponent");
+            }
+            if (learning) ImGui::PopStyleColor();
+            if (ImGui::IsItemHovered()) {
+                int bound = 0;
+                for (const ControlMapping& m : m_app.GetConfig().controlMappings) {
+                    bound += (m.param == p.name && m.preset == preset->name) ? 1 : 0;
+                }
+                ImGui::SetTooltip("Learn: move a controller (OSC or MIDI) to bind it to this parameter.\n"
+                                  "%d binding(s). Edit them in the Controllers panel.", bound);
+            }
+            if (ImGui::BeginPopup("##learnComponent")) {
+                static const char* s_componentNames[] = { "x / r", "y / g", "b", "a" };
+                for (int c = 0; c < components; ++c) {
+                    if (ImGui::Selectable(s_componentNames[c])) m_app.LearnControl(p.name, c);
+                }
+                ImGui::EndPopup();
+            }
+        }
+
+        // --- Keyframe toggle (skip Event, AudioBand, Image and Lut — none hold a value) ---
+        if (p.type != ShaderParamType::Event && p.type != ShaderParamType::AudioBand &&
+            p.type != ShaderParamType::Image && p.type != ShaderParamType::Lut) {
             ImGui::SameLine();
             bool hasTimeline = p.timeline.has_value() && p.timeline->enabled;
             if (hasTimeline) ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.8f, 0.6f, 0.1f, 1.0f));
@@ -847,6 +1246,7 @@ void UIManager::DrawShaderParameters() {
             "Overlay\0Soft Light\0Difference\0Exclusion\0Darken\0Lighten\0\0";
 
         if (ImGui::Combo("Mode##vblend", &preset->blendMode, s_blendModeNames)) {
+            m_app.OnParamChanged();  // Fused-blend variant for the new mode
             m_app.SaveConfig();
         }
 
@@ -857,6 +1257,197 @@ void UIManager::DrawShaderParameters() {
         }
     }
 
+    // MODULATION — LFOs and audio bands added to param components each frame
+    {
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+        ImGui::TextDisabled("MODULATION");
+        ImGui::Spacing();
+
+        static const char* s_componentNames[] = { "x / r", "y / g", "b", "a" };
+
+        std::vector<Modulation>& rows = preset->modulations;
+        bool rowsChanged = false;
+        int  remove = -1;
+        for (int i = 0; i < static_cast<int>(rows.size()); ++i) {
+            Modulation& row = rows[i];
+            ImGui::PushID(i + 3000);
+            rowsChanged |= ImGui::Checkbox("##on", &row.enabled);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(110.0f);
+            const ShaderParam* target = nullptr;
+            if (ImGui::BeginCombo("##param", row.param.empty() ? "(choose)" : row.param.c_str())) {
+                for (const ShaderParam& p : preset->params) {
+                    if (p.cbufferOffset < 0 || (p.type != ShaderParamType::Float &&
+                        p.type != ShaderParamType::Point2D && p.type != ShaderParamType::Color)) continue;
+                    if (ImGui::Selectable(p.name.c_str(), p.name == row.param)) {
+                        row.param     = p.name;
+                        row.component = 0;
+                        row.min       = 0.0f;
+                        row.max       = p.type == ShaderParamType::Color ? 1.0f : p.max - p.min;
+                        rowsChanged   = true;
+                    }
+                }
+                ImGui::EndCombo();
+            }
+            for (const ShaderParam& p : preset->params) {
+                if (p.name == row.param) target = &p;
+            }
+            const int components = !target ? 0
+                                 : target->type == ShaderParamType::Point2D ? 2
+                                 : target->type == ShaderParamType::Color   ? 4 : 1;
+            if (components > 1) {
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(60.0f);
+                rowsChanged |= ImGui::Combo("##component", &row.component, s_componentNames, components);
+            }
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(90.0f);
+            int source = static_cast<int>(row.source);
+            if (ImGui::BeginCombo("##source", ModulationMatrix::GetSourceName(row.source))) {
+                for (int s = 0; s < static_cast<int>(ModulationSource::Count); ++s) {
+                    if (ImGui::Selectable(ModulationMatrix::GetSourceName(static_cast<ModulationSource>(s)), s == source)) {
+                        row.source  = static_cast<ModulationSource>(s);
+                        rowsChanged = true;
+                    }
+                }
+                ImGui::EndCombo();
+            }
+            ImGui::SameLine();
+            if (ImGui::SmallButton("X")) remove = i;
+
+            ImGui::Indent(16.0f);
+            if (row.source < ModulationSource::Rms) {
+                ImGui::SetNextItemWidth(100.0f);
+                rowsChanged |= ImGui::DragFloat("Rate (Hz)", &row.rate, 0.01f, 0.0f, 60.0f, "%.2f");
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(80.0f);
+                rowsChanged |= ImGui::DragFloat("Phase", &row.phase, 0.01f, 0.0f, 1.0f, "%.2f");
+            }
+            ImGui::SetNextItemWidth(100.0f);
+            rowsChanged |= ImGui::DragFloat("Min", &row.min, 0.01f, 0.0f, 0.0f, "%.3f");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(100.0f);
+            rowsChanged |= ImGui::DragFloat("Max", &row.max, 0.01f, 0.0f, 0.0f, "%.3f");
+            ImGui::SetNextItemWidth(80.0f);
+            rowsChanged |= ImGui::DragFloat("Curve", &row.curve, 0.01f, 0.1f, 8.0f, "%.2f");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(70.0f);
+            rowsChanged |= ImGui::DragFloat("Attack", &row.attack, 0.005f, 0.0f, 10.0f, "%.2fs");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(70.0f);
+            rowsChanged |= ImGui::DragFloat("Release", &row.release, 0.005f, 0.0f, 10.0f, "%.2fs");
+            ImGui::Unindent(16.0f);
+            ImGui::PopID();
+        }
+        if (remove >= 0) {
+            rows.erase(rows.begin() + remove);
+            rowsChanged = true;
+        }
+        if (static_cast<int>(rows.size()) < ModulationMatrix::MAX_ROWS && ImGui::SmallButton("+ Modulation")) {
+            rows.emplace_back();
+            rowsChanged = true;
+        }
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Add an LFO or an audio band to a parameter every frame, scaled from Min to Max\n"
+                              "on top of its own value and clamped to its range. Keyframes and the sliders\n"
+                              "still set the value underneath.");
+        if (rowsChanged) {
+            ++preset->modulationRevision;
+            m_app.SaveConfig();
+        }
+    }
+
+    // LAYERS — the compositor stack over this shader, bottom first
+    {
+        ImGui::Spacing();
+        ImGui::Separator();
+        ImGui::Spacing();
+        ImGui::TextDisabled("LAYERS");
+        const D3D11Renderer& renderer = m_app.GetRenderer();
+        if (renderer.GetLayerCount() > 0) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("%d drawn | %lld redraws, %lld cached", static_cast<int>(renderer.GetLayerCount()),
+                                static_cast<long long>(renderer.GetLayerRedraws()),
+                                static_cast<long long>(renderer.GetLayerCacheHits()));
+        }
+        ImGui::Spacing();
+
+        static const char* s_layerModeNames =
+            "Normal\0Add\0Multiply\0Screen\0Overlay\0Soft Light\0Difference\0Exclusion\0Darken\0Lighten\0\0";
+        static const char* s_inputNames = "Input 1\0Input 2\0Input 3\0Input 4\0\0";
+        static const char* s_maskNames  = "No mask\0Input 1 luma\0Input 2 luma\0Input 3 luma\0Input 4 luma\0\0";
+
+        std::vector<CompositeLayer>& layers = m_app.GetConfig().layers;
+        bool layersChanged = false;
+        int  remove = -1, moveUp = -1;
+        for (int i = 0; i < static_cast<int>(layers.size()); ++i) {
+            CompositeLayer& layer = layers[i];
+            ImGui::PushID(i + 2000);
+            layersChanged |= ImGui::Checkbox("##on", &layer.enabled);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(80.0f);
+            layersChanged |= ImGui::Combo("##source", &layer.source, "Preset\0Input\0\0");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(-1.0f);
+            if (layer.source == LAYER_SOURCE_PRESET) {
+                if (ImGui::BeginCombo("##preset", layer.preset.empty() ? "(choose)" : layer.preset.c_str())) {
+                    for (const ShaderPreset& candidate : m_app.GetShaderManager().GetPresets()) {
+                        // Single-pass pixel presets only; see ShaderManager::GetLayer
+                        if (!candidate.passes.empty() || candidate.compute.enabled) continue;
+                        if (ImGui::Selectable(candidate.name.c_str(), candidate.name == layer.preset)) {
+                            layer.preset  = candidate.name;
+                            layersChanged = true;
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+            } else {
+                layersChanged |= ImGui::Combo("##input", &layer.input, s_inputNames);
+            }
+
+            int mode = std::clamp(layer.blendMode, 1, MAX_BLEND_MODE) - 1;
+            ImGui::SetNextItemWidth(100.0f);
+            if (ImGui::Combo("##mode", &mode, s_layerModeNames)) {
+                layer.blendMode = mode + 1;
+                layersChanged   = true;
+            }
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(100.0f);
+            layersChanged |= ImGui::SliderFloat("##opacity", &layer.opacity, 0.0f, 1.0f, "%.2f");
+            ImGui::SameLine();
+            int mask = layer.mask + 1;
+            ImGui::SetNextItemWidth(110.0f);
+            if (ImGui::Combo("##mask", &mask, s_maskNames)) {
+                layer.mask    = mask - 1;
+                layersChanged = true;
+            }
+            ImGui::SameLine();
+            if (i > 0 && ImGui::ArrowButton("##up", ImGuiDir_Up)) moveUp = i;
+            ImGui::SameLine();
+            if (ImGui::SmallButton("X")) remove = i;
+            ImGui::PopID();
+        }
+        if (moveUp > 0) {
+            std::swap(layers[moveUp], layers[moveUp - 1]);
+            layersChanged = true;
+        }
+        if (remove >= 0) {
+            layers.erase(layers.begin() + remove);
+            layersChanged = true;
+        }
+        if (static_cast<int>(layers.size()) < MAX_LAYERS && ImGui::SmallButton("+ Layer")) {
+            layers.emplace_back();
+            layersChanged = true;
+        }
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Blend another single-pass preset or a video input over this shader.\n"
+                              "All layers are combined in one compositor pass; unchanged preset\n"
+                              "layers are not redrawn.");
+        if (layersChanged) m_app.SaveConfig();
+    }
+
     ImGui::End();
 }
 
@@ -1102,6 +1693,10 @@ void UIManager::DrawShaderLibrary() {
         if (ImGui::Button("Scan Folder")) {
             m_app.ScanFolderDialog();
         }
+        if (m_app.GetShaderManager().IsLoadingLibrary()) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("Loading library...");
+        }
 
         ImGui::Separator();
 
@@ -1138,6 +1733,21 @@ void UIManager::DrawShaderLibrary() {
 
         auto& manager = m_app.GetShaderManager();
         const int presetCount = manager.GetPresetCount();
+        if (const int pending = manager.GetPendingCompileCount(); pending > 0) {
+            ImGui::TextColored(ImVec4(0.8f, 0.7f, 0.2f, 1.0f), "Compiling %d shader%s...", pending, pending == 1 ? "" : "s");
+        }
+        {
+            const ShaderManager::ResidencyStats stats = manager.GetResidencyStats();
+            if (stats.budget > 0) {
+                ImGui::TextDisabled("Resident: %d presets, %d / %d shaders", stats.residentPresets,
+                                    stats.residentShaders, stats.budget);
+            } else {
+                ImGui::TextDisabled("Resident: %d presets, %d shaders", stats.residentPresets, stats.residentShaders);
+            }
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("%lld evicted to bytecode-only, %lld reloaded since startup",
+                                  static_cast<long long>(stats.evictions), static_cast<long long>(stats.reloads));
+        }
 
         // Count by category to decide which section headers to show.
         int audioCount = 0, generativeCount = 0, videoCount = 0;
@@ -1149,6 +1759,11 @@ void UIManager::DrawShaderLibrary() {
             else                      ++videoCount;
         }
 
+        // Thumbnails only for rows on screen: the atlas works on what was asked for
+        ThumbnailAtlas& thumbnails = m_app.GetThumbnails();
+        const bool showThumbnails = m_app.GetConfig().libraryThumbnails && thumbnails.GetSRV();
+        const ImVec2 thumbnailSize(48.0f, 48.0f * ThumbnailAtlas::HEIGHT / ThumbnailAtlas::WIDTH);
+
         // Draw a single preset row at index i.
         auto drawPreset = [&](int i) {
             auto* preset = manager.GetPreset(i);
@@ -1157,7 +1772,32 @@ void UIManager::DrawShaderLibrary() {
             ImGui::PushID(i);
             bool isActive = (manager.GetActivePresetIndex() == i);
 
-            if (preset->isValid) {
+            if (showThumbnails) {
+                float uv0[2], uv1[2];
+                if (ImGui::IsRectVisible(thumbnailSize) && thumbnails.Request(preset->name, uv0, uv1)) {
+                    const ImTextureID atlas = reinterpret_cast<ImTextureID>(thumbnails.GetSRV());
+                    ImGui::Image(atlas, thumbnailSize, ImVec2(uv0[0], uv0[1]), ImVec2(uv1[0], uv1[1]));
+                    if (ImGui::IsItemHovered()) {
+                        ImGui::BeginTooltip();
+                        ImGui::Image(atlas, ImVec2(ThumbnailAtlas::WIDTH * 2.0f, ThumbnailAtlas::HEIGHT * 2.0f),
+                                     ImVec2(uv0[0], uv0[1]), ImVec2(uv1[0], uv1[1]));
+                        ImGui::EndTooltip();
+                    }
+                } else {
+                    ImGui::Dummy(thumbnailSize);
+                    if (ImGui::IsItemHovered() && thumbnails.IsUnsupported(preset->name))
+                        ImGui::SetTooltip("No thumbnail: multi-pass, compute or failed to compile");
+                }
+                ImGui::SameLine();
+            }
+
+            if (preset->isCompiling) {
+                ImGui::TextColored(ImVec4(0.8f, 0.7f, 0.2f, 1.0f), "~");
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Compiling...");
+            } else if (preset->isDeferred) {
+                ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "-");
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Not resident: created on first use");
+            } else if (preset->isValid) {
                 ImGui::TextColored(ImVec4(0.2f, 0.8f, 0.2f, 1.0f), "*");
             } else {
                 ImGui::TextColored(ImVec4(0.8f, 0.2f, 0.2f, 1.0f), "!");
@@ -1184,8 +1824,33 @@ void UIManager::DrawShaderLibrary() {
                 ImGui::SetTooltip("Double-click to set keybinding");
             }
 
-            if (preset->shortcutKey != 0) {
-                std::string combo = "[" + m_app.GetComboName(preset->shortcutKey, preset->shortcutModifiers) + "]";
+            // Cost: measured GPU ms once it has been active, else the static instruction count
+            std::string combo;
+            if (preset->shortcutKey != 0)
+                combo = "[" + m_app.GetComboName(preset->shortcutKey, preset->shortcutModifiers) + "]";
+            const float comboW = combo.empty() ? 0.0f : ImGui::CalcTextSize(combo.c_str()).x + ImGui::GetStyle().ItemSpacing.x;
+            const ShaderCost& cost = preset->cost;
+            if (preset->isValid && (preset->measuredGpuMs > 0.0f || cost.instructions > 0)) {
+                char costText[32];
+                if (preset->measuredGpuMs > 0.0f) snprintf(costText, sizeof(costText), "%.2f ms", preset->measuredGpuMs);
+                else                              snprintf(costText, sizeof(costText), "~%u ins", cost.instructions);
+                float textW = ImGui::CalcTextSize(costText).x;
+                ImGui::SameLine(ImGui::GetContentRegionMax().x - comboW - textW - 4.0f);
+                ImGui::TextDisabled("%s", costText);
+                if (ImGui::IsItemHovered()) {
+                    ImGui::BeginTooltip();
+                    ImGui::Text("Instructions:   %u", cost.instructions);
+                    ImGui::Text("Texture reads:  %u", cost.textureSamples);
+                    ImGui::Text("Flow control:   %u", cost.flowControl);
+                    ImGui::Text("Temp registers: %u", cost.tempRegisters);
+                    if (preset->measuredGpuMs > 0.0f) ImGui::Text("Measured GPU:   %.2f ms", preset->measuredGpuMs);
+                    else                              ImGui::TextDisabled("Not measured yet: activate it to time it");
+                    ImGui::TextDisabled("Static counts are per pixel (per thread for compute), summed over passes;");
+                    ImGui::TextDisabled("a loop counts once. GPU time is at the current render size.");
+                    ImGui::EndTooltip();
+                }
+            }
+            if (!combo.empty()) {
                 float textW = ImGui::CalcTextSize(combo.c_str()).x;
                 ImGui::SameLine(ImGui::GetContentRegionMax().x - textW - 4.0f);
                 ImGui::TextDisabled("%s", combo.c_str());
@@ -1207,34 +1872,37 @@ void UIManager::DrawShaderLibrary() {
             ImGui::PopID();
         };
 
-        // AUDIO REACTIVE section
-        if (audioCount > 0) {
+        // One category: its top-level presets, then a collapsible node per
+        // subfolder of the shader directory, in path order
+        auto drawSection = [&](const char* title, auto&& inSection) {
             ImGui::Separator();
-            ImGui::TextDisabled("AUDIO REACTIVE");
+            ImGui::TextDisabled("%s", title);
+            std::map<std::string, std::vector<int>> folders;
             for (int i = 0; i < presetCount; ++i) {
                 const auto* p = manager.GetPreset(i);
-                if (p && p->isAudio) drawPreset(i);
+                if (!p || !inSection(*p)) continue;
+                if (p->folder.empty()) drawPreset(i);
+                else                   folders[p->folder].push_back(i);
             }
-        }
+            for (const auto& [folder, indices] : folders) {
+                ImGui::PushID(title);
+                const bool open = ImGui::TreeNode(folder.c_str(), "%s (%d)", folder.c_str(),
+                                                  static_cast<int>(indices.size()));
+                ImGui::PopID();
+                if (!open) continue;
+                for (int i : indices) drawPreset(i);
+                ImGui::TreePop();
+            }
+        };
 
-        // GENERATIVE section
+        if (audioCount > 0) {
+            drawSection("AUDIO REACTIVE", [](const ShaderPreset& p) { return p.isAudio; });
+        }
         if (generativeCount > 0) {
-            ImGui::Separator();
-            ImGui::TextDisabled("GENERATIVE");
-            for (int i = 0; i < presetCount; ++i) {
-                const auto* p = manager.GetPreset(i);
-                if (p && p->isGenerative) drawPreset(i);
-            }
+            drawSection("GENERATIVE", [](const ShaderPreset& p) { return p.isGenerative; });
         }
-
-        // VIDEO EFFECTS section
         if (videoCount > 0) {
-            ImGui::Separator();
-            ImGui::TextDisabled("VIDEO EFFECTS");
-            for (int i = 0; i < presetCount; ++i) {
-                const auto* p = manager.GetPreset(i);
-                if (p && !p->isGenerative && !p->isAudio) drawPreset(i);
-            }
+            drawSection("VIDEO EFFECTS", [](const ShaderPreset& p) { return !p.isGenerative && !p.isAudio; });
         }
 
         m_libraryHeight = ImGui::GetWindowHeight();
@@ -1259,7 +1927,49 @@ void UIManager::DrawTransportControls() {
         if (ImGui::Button(isPlaying ? "||" : ">", ImVec2(40, 30))) {
             m_app.TogglePlayback();
         }
-        
+
+        // Direction: forward -> reverse -> ping-pong (file playback only)
+        if (decoder.IsOpen() && !decoder.IsLiveCapture()) {
+            ImGui::SameLine();
+            const PlaybackDirection dir = m_app.GetPlaybackDirection();
+            const char* dirLabel = (dir == PlaybackDirection::Forward) ? "->##dir"
+                                 : (dir == PlaybackDirection::Reverse) ? "<-##dir" : "<->##dir";
+            if (ImGui::Button(dirLabel, ImVec2(40, 30))) {
+                m_app.SetPlaybackDirection(
+                    dir == PlaybackDirection::Forward ? PlaybackDirection::Reverse
+                  : dir == PlaybackDirection::Reverse ? PlaybackDirection::PingPong
+                                                      : PlaybackDirection::Forward);
+            }
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Playback direction: %s (click to cycle)",
+                    dir == PlaybackDirection::Forward ? "forward"
+                  : dir == PlaybackDirection::Reverse ? "reverse" : "ping-pong");
+
+            // Speed
+            static const double s_rates[] = { 0.25, 0.5, 0.75, 1.0, 1.5, 2.0, 4.0, 8.0 };
+            ImGui::SameLine();
+            char rateLabel[16];
+            snprintf(rateLabel, sizeof(rateLabel), "%gx", m_app.GetPlaybackRate());
+            ImGui::SetNextItemWidth(60.0f);
+            if (ImGui::BeginCombo("##rate", rateLabel)) {
+                for (double rate : s_rates) {
+                    char item[16];
+                    snprintf(item, sizeof(item), "%gx", rate);
+                    if (ImGui::Selectable(item, rate == m_app.GetPlaybackRate()))
+                        m_app.SetPlaybackRate(rate);
+                }
+                ImGui::Separator();
+                bool stretch = m_app.GetConfig().stretchAudio;
+                if (ImGui::Checkbox("Stretch audio", &stretch))
+                    m_app.SetStretchAudio(stretch);
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Keep audio at pitch away from 1x; off mutes it");
+                ImGui::EndCombo();
+            }
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Playback speed. 2x+ skips non-reference frames, 4x+ decodes keyframes only");
+        }
+
         ImGui::SameLine();
 
         // Timeline slider — replaced by a LIVE badge for capture sources
@@ -1273,17 +1983,49 @@ void UIManager::DrawTransportControls() {
             float s = t - static_cast<float>(m) * 60.0f;
             ImGui::Text("%02d:%05.2f", m, s);
             ImGui::SameLine();
+            const DecodeWorker& worker = m_app.GetDecodeWorker();
+            ImGui::TextDisabled("%.0f ms  %lld dropped", m_app.GetLiveLatencyMs(),
+                                static_cast<long long>(worker.GetLiveDrops()));
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Latency from reading a frame off the source to presenting it\n"
+                                  "(add the camera's and display's own delay for glass-to-glass).\n"
+                                  "Dropped = newer frame arrived before the old one was shown.");
+            if (const NetworkSource* network = decoder.GetNetworkSource()) {
+                const NetworkSource::Stats stats = network->GetStats();
+                ImGui::SameLine();
+                if (stats.state == NetworkSource::State::Streaming) {
+                    ImGui::TextDisabled("buf %.0f ms  lost %lld", stats.bufferMs,
+                                        static_cast<long long>(stats.lostFrames));
+                } else {
+                    ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.2f, 1.0f), "%s...",
+                                       NetworkSource::GetStateName(stats.state));
+                }
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("%s\nBuffer: %d packets, %.0f ms (target %d ms)\n"
+                                      "Arrival jitter: %.1f ms   Late: %lld   Overflows: %lld\n"
+                                      "Lost frames (est.): %lld   Reconnects: %d%s%s",
+                                      network->GetUrl().c_str(), stats.bufferPackets, stats.bufferMs,
+                                      m_app.GetConfig().networkJitterMs, stats.arrivalJitterMs,
+                                      static_cast<long long>(stats.latePackets),
+                                      static_cast<long long>(stats.overflows),
+                                      static_cast<long long>(stats.lostFrames), stats.reconnects,
+                                      stats.error.empty() ? "" : "\nLast error: ", stats.error.c_str());
+            }
+            ImGui::SameLine();
             if (ImGui::SmallButton("Stop##live")) {
                 m_app.CloseVideo();
             }
             if (ImGui::IsItemHovered()) ImGui::SetTooltip("Stop live capture");
         } else if (decoder.IsOpen()) {
-            float currentTime = static_cast<float>(decoder.GetCurrentTime());
+            // Playback time, not decoder.GetCurrentTime(): the decoder runs ahead on
+            // the DecodeWorker thread.
+            float currentTime = m_app.GetPlaybackTime();
             float duration    = static_cast<float>(decoder.GetDuration());
             double fps        = decoder.GetFPS();
             int64_t frameCount = decoder.GetFrameCount();
             bool& frameMode   = m_app.GetConfig().timeDisplayFrames;
 
+            if (m_app.GetConfig().timelineOverview) DrawTimelineOverview(400.0f, duration);
             ImGui::SetNextItemWidth(400);
             bool sliderMoved = false;
             if (frameMode && fps > 0.0 && frameCount > 0) {
@@ -1303,9 +2045,11 @@ void UIManager::DrawTransportControls() {
                     sliderMoved = true;
                 }
             }
+            // Keyframe previews while dragging; the exact frame once the mouse rests or lets go
+            if (ImGui::IsItemDeactivated()) m_app.EndScrub();
 
             if (sliderMoved) {
-                m_app.SeekTo(currentTime);
+                m_app.ScrubTo(currentTime);
 
                 // Route to selected keyframe when follow mode active or Shift held
                 bool shiftHeld = (GetKeyState(VK_SHIFT) & 0x8000) != 0;
@@ -1326,6 +2070,17 @@ void UIManager::DrawTransportControls() {
                 }
             }
 
+            // Loop region band over the slider
+            if (m_app.HasLoopRegion() && duration > 0.0f) {
+                const ImVec2 sliderMin = ImGui::GetItemRectMin();
+                const ImVec2 sliderMax = ImGui::GetItemRectMax();
+                const float sliderW = sliderMax.x - sliderMin.x;
+                const float x0 = sliderMin.x + static_cast<float>(m_app.GetLoopIn()) / duration * sliderW;
+                const float x1 = sliderMin.x + static_cast<float>(m_app.GetLoopOut()) / duration * sliderW;
+                ImGui::GetWindowDrawList()->AddRectFilled(ImVec2(x0, sliderMax.y - 3.0f), ImVec2(x1, sliderMax.y),
+                    m_app.IsLoopReplaying() ? IM_COL32(80, 200, 120, 220) : IM_COL32(80, 140, 230, 220));
+            }
+
             // Draw keyframe markers for the currently-selected parameter
             if (m_selectedKeyframeParam >= 0) {
                 ShaderPreset* activePreset = m_app.GetShaderManager().GetActivePreset();
@@ -1367,6 +2122,74 @@ void UIManager::DrawTransportControls() {
             }
             if (wasFrameMode) ImGui::PopStyleColor();
             if (ImGui::IsItemHovered()) ImGui::SetTooltip(wasFrameMode ? "Switch to seconds" : "Switch to frames");
+
+            // A/B loop region
+            ImGui::SameLine();
+            if (ImGui::SmallButton("[##loopin")) m_app.SetLoopIn();
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("Loop in at the playhead");
+            ImGui::SameLine();
+            if (ImGui::SmallButton("]##loopout")) m_app.SetLoopOut();
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("Loop out at the playhead");
+            if (m_app.HasLoopRegion()) {
+                ImGui::SameLine();
+                if (ImGui::SmallButton("x##loopclear")) m_app.ClearLoopRegion();
+                ImGui::SameLine();
+                const LoopCache& loopCache = m_app.GetRenderer().GetLoopCache();
+                if (m_app.IsLoopReplaying()) {
+                    ImGui::TextColored(ImVec4(0.3f, 1.0f, 0.5f, 1.0f), "VRAM");
+                } else if (loopCache.IsOverBudget() || loopCache.GetCount() == 0) {
+                    ImGui::TextDisabled("decode");
+                } else {
+                    ImGui::TextDisabled("%lld/%lld", static_cast<long long>(loopCache.GetFilled()),
+                                        static_cast<long long>(loopCache.GetCount()));
+                }
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Loop %.2f - %.2f s, %.0f MB cached.\n"
+                                      "Once every frame has been shown the loop replays from VRAM\n"
+                                      "with no decoding; over the loop cache budget it re-decodes.",
+                                      m_app.GetLoopIn(), m_app.GetLoopOut(),
+                                      static_cast<double>(loopCache.GetUsedBytes()) / (1024.0 * 1024.0));
+            }
+
+            // Sync mode toggle + drop counters
+            ImGui::SameLine();
+            const bool audioMaster = m_app.GetConfig().syncMode == SYNC_MODE_AUDIO_MASTER;
+            if (audioMaster) ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.3f, 0.5f, 0.9f, 1.0f));
+            if (ImGui::SmallButton(audioMaster ? "sync##syncmode" : "all##syncmode")) {
+                m_app.SetSyncMode(audioMaster ? SYNC_MODE_FRAME_PACED : SYNC_MODE_AUDIO_MASTER);
+            }
+            if (audioMaster) ImGui::PopStyleColor();
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip(audioMaster
+                    ? "Audio master: video follows the audio clock and drops frames to stay\n"
+                      "realtime. Click to show every frame instead."
+                    : "Frame paced: every frame is shown, slower than realtime if decode\n"
+                      "can't keep up. Click to follow the audio clock.");
+            if (audioMaster) {
+                const int64_t late      = m_app.GetLateDrops();
+                const int64_t discarded = decoder.GetDiscardedFrames();
+                if (late > 0 || discarded > 0 || decoder.IsSkippingNonReference()) {
+                    ImGui::SameLine();
+                    ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "drop %lld+%lld%s",
+                        static_cast<long long>(late), static_cast<long long>(discarded),
+                        decoder.IsSkippingNonReference() ? " nonref" : "");
+                    if (ImGui::IsItemHovered())
+                        ImGui::SetTooltip("%lld late (decoded, superseded before shown)\n"
+                                          "%lld discarded before conversion to catch up\n"
+                                          "Non-reference frame skipping: %s",
+                            static_cast<long long>(late), static_cast<long long>(discarded),
+                            decoder.IsSkippingNonReference() ? "on" : "off");
+                }
+            }
+            if (m_app.IsRenderingAhead()) {
+                const RenderAheadQueue& ahead = m_app.GetRenderer().GetRenderAhead();
+                ImGui::SameLine();
+                ImGui::TextDisabled("ahead %d/%d", ahead.GetSize(), ahead.GetCapacity());
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Finished frames waiting for their time (render-ahead)\n"
+                                      "Ticks a frame was due with none ready: %lld",
+                        static_cast<long long>(m_app.GetRenderAheadUnderruns()));
+            }
         } else {
             // No video — show generative controls or idle prompt
             const ShaderPreset* active = m_app.GetShaderManager().GetActivePreset();
@@ -1380,9 +2203,11 @@ void UIManager::DrawTransportControls() {
                     { "3840 x 2160",  3840, 2160 },
                     { "1080 x 1080",  1080, 1080 },
                     { "2048 x 2048",  2048, 2048 },
+                    { "7680 x 2160",  7680, 2160 },   // LED walls
+                    { "15360 x 1080", 15360, 1080 },
                     { "Custom",          0,    0 },
                 };
-                static constexpr int kNumPresets = 7;
+                static constexpr int kNumPresets = 9;
                 static constexpr int kCustomIdx  = kNumPresets - 1;
 
                 AppConfig& cfg = m_app.GetConfig();
@@ -1418,14 +2243,14 @@ void UIManager::DrawTransportControls() {
                 if (currentPreset == kCustomIdx) {
                     ImGui::SameLine();
                     ImGui::SetNextItemWidth(60.0f);
-                    if (ImGui::DragInt("##genW", &cfg.generativeWidth, 1.0f, 1, 7680, "%d")) {
+                    if (ImGui::DragInt("##genW", &cfg.generativeWidth, 1.0f, 1, D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION, "%d")) {
                         m_app.ApplyGenerativeResolution();
                     }
                     ImGui::SameLine();
                     ImGui::TextDisabled("x");
                     ImGui::SameLine();
                     ImGui::SetNextItemWidth(60.0f);
-                    if (ImGui::DragInt("##genH", &cfg.generativeHeight, 1.0f, 1, 4320, "%d")) {
+                    if (ImGui::DragInt("##genH", &cfg.generativeHeight, 1.0f, 1, D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION, "%d")) {
                         m_app.ApplyGenerativeResolution();
                     }
                 }
@@ -1458,12 +2283,7 @@ void UIManager::DrawTransportControls() {
             ImGui::Text("%lld", m_app.GetEncoder().GetFramesEncoded());
         } else {
             if (ImGui::Button("Rec##rec", ImVec2(50, 30))) {
-                RecordingSettings settings;
-                settings.outputPath = m_recordingPath;
-                settings.codec = (m_recordingCodec == 0) ? "libx264" : "prores_ks";
-                settings.bitrate = m_recordingBitrate * 1000000;
-                settings.proresProfile = m_proresProfile;
-                m_app.StartRecording(settings);
+                m_app.StartRecording(MakeRecordingSettings(), MakeExtraTargets());
             }
         }
 
@@ -1477,7 +2297,7 @@ void UIManager::DrawTransportControls() {
         }
 
         // Volume / mute — only shown when a video with audio is open
-        if (m_app.GetDecoder().HasAudio()) {
+        if (m_app.GetAudioReader().IsOpen()) {
             AppConfig& cfg = m_app.GetConfig();
 
             ImGui::SameLine();
@@ -1504,35 +2324,419 @@ void UIManager::DrawTransportControls() {
     ImGui::End();
 }
 
-void UIManager::DrawRecordingPanel() {
-    if (ImGui::Begin("Recording Settings", &m_showRecording)) {
-        ImGui::Text("Output Path");
-        float browseW = 80.0f;
-        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x - browseW - ImGui::GetStyle().ItemSpacing.x);
-        ImGui::InputText("##outputPath", m_recordingPath, sizeof(m_recordingPath));
-        ImGui::SameLine();
-        if (ImGui::Button("Browse...", ImVec2(browseW, 0))) {
-            m_app.OpenRecordingOutputDialog(m_recordingPath, sizeof(m_recordingPath));
-        }
-        
-        ImGui::Combo("Codec", &m_recordingCodec, "H.264 (MP4)\0ProRes (MOV)\0");
-        
-        if (m_recordingCodec == 0) {
-            ImGui::SliderInt("Bitrate (Mbps)", &m_recordingBitrate, 5, 100);
-        } else {
-            ImGui::Combo("ProRes Profile", &m_proresProfile, "Proxy\0LT\0422\0HQ\0");
+void UIManager::DrawTimelineOverview(float width, float duration) {
+    const MediaOverview& overview = m_app.GetMediaOverview();
+    const bool hasStrip = overview.GetSRV() && overview.NearestUploadedThumb(0) >= 0;
+    const int  filled   = overview.GetWaveformFilled();
+    if (duration <= 0.0f || (!hasStrip && filled == 0)) return;  // Nothing built yet
+
+    constexpr float STRIP_HEIGHT = 36.0f;
+    constexpr float WAVE_HEIGHT  = 18.0f;
+    const float height = (hasStrip ? STRIP_HEIGHT : 0.0f) + (filled > 0 ? WAVE_HEIGHT : 0.0f);
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton("##overview", ImVec2(width, height));
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + height), IM_COL32(16, 16, 16, 255));
+
+    // Each cell shows the nearest finished slot, so the strip sharpens as slots land
+    const ImTextureID strip = reinterpret_cast<ImTextureID>(overview.GetSRV());
+    auto slotAt = [](float fraction) {
+        return std::clamp(static_cast<int>(fraction * MediaOverview::THUMB_COUNT), 0, MediaOverview::THUMB_COUNT - 1);
+    };
+    float y = origin.y;
+    if (hasStrip) {
+        const float cellWidth = STRIP_HEIGHT * MediaOverview::THUMB_WIDTH / MediaOverview::THUMB_HEIGHT;
+        const int   cells     = std::max(1, static_cast<int>(width / cellWidth + 0.5f));
+        const float w         = width / static_cast<float>(cells);
+        for (int cell = 0; cell < cells; ++cell) {
+            const int slot = overview.NearestUploadedThumb(slotAt((cell + 0.5f) / static_cast<float>(cells)));
+            const float u0 = static_cast<float>(slot) / MediaOverview::THUMB_COUNT;
+            const float u1 = static_cast<float>(slot + 1) / MediaOverview::THUMB_COUNT;
+            drawList->AddImage(strip, ImVec2(origin.x + cell * w, y), ImVec2(origin.x + (cell + 1) * w, y + STRIP_HEIGHT),
+                               ImVec2(u0, 0.0f), ImVec2(u1, 1.0f));
+        }
+        y += STRIP_HEIGHT;
+    }
+
+    // One min/max line per pixel column, up to the buckets filled so far
+    if (filled > 0) {
+        const int   columns = std::max(1, static_cast<int>(width));
+        const float mid     = y + WAVE_HEIGHT * 0.5f;
+        const float half    = WAVE_HEIGHT * 0.5f - 1.0f;
+        for (int column = 0; column < columns; ++column) {
+            const int first = column * MediaOverview::WAVEFORM_BUCKETS / columns;
+            const int last  = std::min(std::max(first + 1, (column + 1) * MediaOverview::WAVEFORM_BUCKETS / columns),
+                                       filled);
+            if (first >= last) break;
+            float lo = 1.0f, hi = -1.0f;
+            for (int bucket = first; bucket < last; ++bucket) {
+                float bucketLo, bucketHi;
+                overview.GetWaveform(bucket, bucketLo, bucketHi);
+                lo = std::min(lo, bucketLo);
+                hi = std::max(hi, bucketHi);
+            }
+            const float x = origin.x + column + 0.5f;
+            drawList->AddLine(ImVec2(x, mid - hi * half), ImVec2(x, mid - lo * half + 1.0f), IM_COL32(90, 170, 230, 255));
+        }
+    }
+
+    const float playhead = origin.x + std::clamp(m_app.GetPlaybackTime() / duration, 0.0f, 1.0f) * width;
+    drawList->AddLine(ImVec2(playhead, origin.y), ImVec2(playhead, origin.y + height), IM_COL32(255, 255, 255, 220));
+
+    // Hover previews from the overview alone; click or drag scrubs the player
+    if (ImGui::IsItemDeactivated()) m_app.EndScrub();
+    if (ImGui::IsItemHovered() || ImGui::IsItemActive()) {
+        const float fraction = std::clamp((ImGui::GetIO().MousePos.x - origin.x) / width, 0.0f, 1.0f);
+        if (ImGui::IsItemActive()) m_app.ScrubTo(fraction * duration);
+        ImGui::BeginTooltip();
+        const int slot = hasStrip ? overview.NearestUploadedThumb(slotAt(fraction)) : -1;
+        if (slot >= 0) {
+            ImGui::Image(strip, ImVec2(MediaOverview::THUMB_WIDTH * 2.0f, MediaOverview::THUMB_HEIGHT * 2.0f),
+                         ImVec2(static_cast<float>(slot) / MediaOverview::THUMB_COUNT, 0.0f),
+                         ImVec2(static_cast<float>(slot + 1) / MediaOverview::THUMB_COUNT, 1.0f));
+        }
+        const float seconds = fraction * duration;
+        const int minutes = static_cast<int>(seconds / 60.0f);
+        ImGui::Text("%02d:%05.2f", minutes, seconds - minutes * 60.0f);
+        if (overview.IsBuilding()) ImGui::TextDisabled("Building overview %.0f%%", overview.GetProgress() * 100.0f);
+        ImGui::EndTooltip();
+    }
+}
+
+RecordingSettings UIManager::MakeRecordingSettings() const {
+    RecordingSettings settings;
+    settings.outputPath = m_recordingPath;
+    settings.codec = RECORDING_CODECS[std::clamp<int>(m_recordingCodec, 0, static_cast<int>(std::size(RECORDING_CODECS)) - 1)].encoder;
+    settings.bitrate = m_recordingBitrate * 1000000;
+    settings.proresProfile = m_proresProfile;
+    settings.preset = X264_PRESETS[std::clamp<int>(m_recordingPreset, 0, static_cast<int>(std::size(X264_PRESETS)) - 1)];
+    settings.encoderProfile = m_recordingProfile;
+    settings.adaptToLoad = m_adaptToLoad;
+    settings.dropWhenBehind = !m_recordingLossless;
+    settings.replaySeconds = m_instantReplay ? m_replaySeconds : 0;
+    settings.recordAudio = m_recordAudio;
+    settings.writeBufferMB = m_writeBufferMB;
+    settings.writeThrough = m_writeThrough;
+    settings.fragmented = m_fragmented;
+    settings.segmentSeconds = m_segmentSeconds;
+    settings.telemetryCsv = m_telemetryCsv;
+    return settings;
+}
+
+std::vector<RecordingSettings> UIManager::MakeExtraTargets() const {
+    if (!m_extraTarget) return {};
+    RecordingSettings target;
+    target.outputPath = m_extraTargetPath;
+    target.codec = RECORDING_CODECS[std::clamp<int>(m_extraTargetCodec, 0, static_cast<int>(std::size(RECORDING_CODECS)) - 1)].encoder;
+    target.bitrate = m_extraTargetBitrate * 1000000;
+    target.proresProfile = m_proresProfile;
+    target.recordAudio = m_recordAudio;
+    target.writeBufferMB = m_writeBufferMB;
+    target.writeThrough = m_writeThrough;
+    target.fragmented = m_fragmented;
+    target.segmentSeconds = m_segmentSeconds;
+    target.downscale = EXTRA_TARGET_DOWNSCALES[std::clamp<int>(m_extraTargetDownscale, 0, static_cast<int>(std::size(EXTRA_TARGET_DOWNSCALES)) - 1)];
+    return { target };
+}
+
+void UIManager::OnRecordingStopped(const RecordingSettings& settings, int64_t encoded, int64_t dropped) {
+    if (!m_adaptivePreset || !settings.dropWhenBehind || settings.codec != "libx264" ||
+        settings.encoderProfile != ENCODER_PROFILE_CUSTOM) {
+        return;
+    }
+    const int64_t submitted = encoded + dropped;
+    if (submitted <= 0 || static_cast<double>(dropped) / submitted <= ADAPT_DROP_RATIO) return;
+
+    // Only if the take used the panel's current preset and there is a faster one
+    const auto current = std::find(std::begin(X264_PRESETS), std::end(X264_PRESETS), settings.preset);
+    if (current == std::end(X264_PRESETS) || current == std::begin(X264_PRESETS) ||
+        current - std::begin(X264_PRESETS) != m_recordingPreset) {
+        return;
+    }
+    --m_recordingPreset;
+    ShowNotification("Dropped " + std::to_string(dropped) + " frames; next recording uses preset \"" +
+                     X264_PRESETS[m_recordingPreset] + "\"", 5.0f);
+}
+
+void UIManager::OnEncoderCalibrated(const EncoderCalibration& calibration) {
+    m_encoderCalibration = calibration;
+    if (calibration.fps[calibration.recommended] <= 0.0) {
+        ShowNotification("Encoder calibration failed: libx264 did not open");
+        return;
+    }
+    m_recordingProfile = calibration.recommended;
+    char message[128];
+    snprintf(message, sizeof(message), "Recording profile: %s (%.0f fps at %dx%d)",
+             VideoEncoder::ProfileName(calibration.recommended), calibration.fps[calibration.recommended],
+             calibration.width, calibration.height);
+    ShowNotification(message, 5.0f);
+}
+
+void UIManager::DrawRecordingTelemetry(const RecordingTelemetry& telemetry) {
+    RecordingTelemetry::Snapshot& snapshot = m_telemetrySnapshot;
+    telemetry.GetSnapshot(snapshot, &m_app.GetFrameArena());
+    if (snapshot.totalMs.empty()) {
+        ImGui::TextDisabled("No frames yet");
+        return;
+    }
+
+    if (ImGui::BeginTable("##telemetry", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                                                ImGuiTableFlags_SizingStretchSame)) {
+        ImGui::TableSetupColumn("Stage (ms)");
+        ImGui::TableSetupColumn("Last");
+        ImGui::TableSetupColumn("Avg");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < RECORDING_STAGE_COUNT; ++i) {
+            const RecordingTelemetry::StageStats& stats = snapshot.stages[i];
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(RecordingTelemetry::StageName(static_cast<RecordingStage>(i)));
+            ImGui::TableSetColumnIndex(1); ImGui::Text("%.2f", stats.lastMs);
+            ImGui::TableSetColumnIndex(2); ImGui::Text("%.2f", stats.avgMs);
+            ImGui::TableSetColumnIndex(3); ImGui::Text("%.2f", stats.p95Ms);
+            ImGui::TableSetColumnIndex(4); ImGui::Text("%.2f", stats.maxMs);
+        }
+        ImGui::EndTable();
+    }
+
+    // Last RecordingTelemetry::HISTORY_SIZE frames, oldest on the left
+    const int count = static_cast<int>(snapshot.totalMs.size());
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), "Total %.2f ms", snapshot.totalMs.back());
+    ImGui::PlotLines("##telemetryTotal", snapshot.totalMs.data(), count, 0, overlay, 0.0f, FLT_MAX, ImVec2(-1, 50));
+    snprintf(overlay, sizeof(overlay), "Queue depth %.0f", snapshot.queueDepth.back());
+    ImGui::PlotLines("##telemetryQueue", snapshot.queueDepth.data(), count, 0, overlay, 0.0f, FLT_MAX, ImVec2(-1, 40));
+
+    const char* stageNames[RECORDING_STAGE_COUNT];
+    for (int i = 0; i < RECORDING_STAGE_COUNT; ++i) {
+        stageNames[i] = RecordingTelemetry::StageName(static_cast<RecordingStage>(i));
+    }
+    ImGui::SetNextItemWidth(120);
+    ImGui::Combo("Histogram", &m_telemetryStage, stageNames, RECORDING_STAGE_COUNT);
+    const int stage = std::clamp(m_telemetryStage, 0, RECORDING_STAGE_COUNT - 1);
+    snprintf(overlay, sizeof(overlay), "%s ms  %s ... %s", stageNames[stage],
+             RecordingTelemetry::BinLabel(0), RecordingTelemetry::BinLabel(RecordingTelemetry::HISTOGRAM_BINS - 1));
+    ImGui::PlotHistogram("##telemetryHistogram", snapshot.stages[stage].histogram.data(),
+                         RecordingTelemetry::HISTOGRAM_BINS, 0, overlay, 0.0f, FLT_MAX, ImVec2(-1, 60));
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Frames per bucket, doubling from 0.25 ms to 64 ms and over.");
+}
+
+void UIManager::DrawRecordingPanel() {
+    if (ImGui::Begin("Recording Settings", &m_showRecording)) {
+        ImGui::Text("Output Path");
+        float browseW = 80.0f;
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x - browseW - ImGui::GetStyle().ItemSpacing.x);
+        ImGui::InputText("##outputPath", m_recordingPath, sizeof(m_recordingPath));
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("A file, or a stream URL: srt://host:port, rtmp://server/app/key\n"
+                              "or udp://host:port (low-latency CBR, MPEG-TS or FLV).\n"
+                              "A .png/.tif/.exr path writes an image sequence (name_000000.png, ...)\n"
+                              "compressed on all cores; the codec is not used.");
+        ImGui::SameLine();
+        if (ImGui::Button("Browse...", ImVec2(browseW, 0))) {
+            m_app.OpenRecordingOutputDialog(m_recordingPath, sizeof(m_recordingPath));
+        }
+        
+        const char* codecLabels[std::size(RECORDING_CODECS)];
+        for (size_t i = 0; i < std::size(RECORDING_CODECS); ++i) codecLabels[i] = RECORDING_CODECS[i].label;
+        ImGui::Combo("Codec", &m_recordingCodec, codecLabels, static_cast<int>(std::size(RECORDING_CODECS)));
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("NVENC / Quick Sync / AMF encode on the GPU from the rendered\n"
+                              "texture, with no readback. They need an FFmpeg build with\n"
+                              "them and a matching GPU.");
+
+        const std::string encoder = RECORDING_CODECS[m_recordingCodec].encoder;
+        if (encoder == "prores_ks") {
+            ImGui::Combo("ProRes Profile", &m_proresProfile, "Proxy\0LT\0422\0HQ\0");
+        } else if (VideoEncoder::IsLosslessCodec(encoder)) {
+            ImGui::TextDisabled("Lossless RGB, threads and slices from %u cores",
+                                std::max(std::thread::hardware_concurrency(), 1u));
+        } else {
+            ImGui::SliderInt("Bitrate (Mbps)", &m_recordingBitrate, 5, 100);
+        }
+        if (encoder == "libx264") {
+            const char* profileLabels[ENCODER_PROFILE_COUNT];
+            for (int i = 0; i < ENCODER_PROFILE_COUNT; ++i) profileLabels[i] = VideoEncoder::ProfileName(i);
+            ImGui::Combo("Profile", &m_recordingProfile, profileLabels, ENCODER_PROFILE_COUNT);
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Realtime: preset faster, zerolatency, each frame sliced across
+"
+                                  "the cores. Quality: medium with lookahead and B-frames.
+"
+                                  "Archive: slow with a longer lookahead and GOP, for export.
+"
+                                  "Custom: the preset below, no B-frames.");
+            ImGui::SameLine();
+            ImGui::BeginDisabled(m_app.IsCalibratingEncoder() || m_app.GetEncoder().IsRecording());
+            if (ImGui::Button(m_app.IsCalibratingEncoder() ? "Calibrating...###calibrate" : "Calibrate###calibrate")) {
+                m_app.StartEncoderCalibration(MakeRecordingSettings());
+            }
+            ImGui::EndDisabled();
+            if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+                ImGui::SetTooltip("Encodes test frames at the recording size with each profile
+"
+                                  "for a second and picks the best that keeps up.");
+            if (m_encoderCalibration.width > 0) {
+                ImGui::TextDisabled("%dx%d: Realtime %.0f, Quality %.0f, Archive %.0f fps",
+                                    m_encoderCalibration.width, m_encoderCalibration.height,
+                                    m_encoderCalibration.fps[ENCODER_PROFILE_REALTIME],
+                                    m_encoderCalibration.fps[ENCODER_PROFILE_QUALITY],
+                                    m_encoderCalibration.fps[ENCODER_PROFILE_ARCHIVE]);
+            }
+            if (m_recordingProfile == ENCODER_PROFILE_CUSTOM) {
+                ImGui::Combo("Preset", &m_recordingPreset, X264_PRESETS, static_cast<int>(std::size(X264_PRESETS)));
+            }
+        }
+
+        int mode = m_recordingLossless ? 1 : 0;
+        if (ImGui::Combo("Mode", &mode, "Realtime (drop frames)\0Lossless (wait for encoder)\0")) {
+            m_recordingLossless = (mode == 1);
+        }
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Realtime drops frames when the encoder falls behind, so\n"
+                              "playback never stalls. Lossless makes the renderer wait\n"
+                              "for queue space: every rendered frame is encoded, and\n"
+                              "the app runs at encode speed.");
+        if (!m_recordingLossless && encoder == "libx264" && m_recordingProfile == ENCODER_PROFILE_CUSTOM) {
+            ImGui::Checkbox("Adapt speed", &m_adaptivePreset);
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("After a take that dropped frames, switch to the next\nfaster preset for the next recording.");
+        }
+        if (!m_recordingLossless && VideoEncoder::CanAdaptToLoad(encoder)) {
+            if (encoder == "libx264" && m_recordingProfile == ENCODER_PROFILE_CUSTOM) ImGui::SameLine();
+            ImGui::Checkbox("Adapt bitrate under load", &m_adaptToLoad);
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("While the encoder falls behind (queue filling, or encoding\n"
+                                  "taking most of a frame), lower the bitrate during the take,\n"
+                                  "down to 40%%, and raise it again once there is headroom.\n"
+                                  "Costs quality for a while instead of dropping frames.");
+        }
+
+        ImGui::Checkbox("Also record a second target", &m_extraTarget);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("e.g. a ProRes master plus an H.264 review copy in one pass.\n"
+                              "Both encode the same frames from one readback, each on\n"
+                              "its own thread.");
+        if (m_extraTarget) {
+            ImGui::Indent();
+            ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x - browseW - ImGui::GetStyle().ItemSpacing.x);
+            ImGui::InputText("##extraPath", m_extraTargetPath, sizeof(m_extraTargetPath));
+            ImGui::SameLine();
+            if (ImGui::Button("Browse...##extra", ImVec2(browseW, 0))) {
+                m_app.OpenRecordingOutputDialog(m_extraTargetPath, sizeof(m_extraTargetPath));
+            }
+            ImGui::Combo("Codec##extra", &m_extraTargetCodec, codecLabels, static_cast<int>(std::size(RECORDING_CODECS)));
+            const std::string extraEncoder = RECORDING_CODECS[m_extraTargetCodec].encoder;
+            if (extraEncoder != "prores_ks" && !VideoEncoder::IsLosslessCodec(extraEncoder)) {
+                ImGui::SliderInt("Bitrate (Mbps)##extra", &m_extraTargetBitrate, 1, 100);
+            }
+            ImGui::Combo("Size##extra", &m_extraTargetDownscale, "Full\0Half\0Quarter\0");
+            ImGui::Unindent();
+        }
+
+        ImGui::Checkbox("Fragmented", &m_fragmented);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("MP4/MOV written in fragments: the file plays up to the last\n"
+                              "second even after a crash, memory stays flat on long takes,\n"
+                              "and stopping needs no index rewrite.");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100);
+        ImGui::InputInt("Split every (s)", &m_segmentSeconds, 60, 600);
+        m_segmentSeconds = std::max(m_segmentSeconds, 0);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("0 = one file. Otherwise rolling files name_000, name_001, ...\n"
+                              "each starting on a keyframe.");
+
+        ImGui::SliderInt("Write buffer (MB)", &m_writeBufferMB, 0, 1024);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Encoded data queues here and a writer thread puts it on disk,\n"
+                              "so a short disk or network stall doesn't drop frames.\n"
+                              "0 writes synchronously from the encoder thread.");
+        ImGui::SameLine();
+        ImGui::Checkbox("Write-through", &m_writeThrough);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Bypass the OS write cache: the file is on the disk as soon as\n"
+                              "the recording ends, at the cost of slower writes.");
+        ImGui::SameLine();
+        ImGui::Checkbox("Telemetry CSV", &m_telemetryCsv);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Writes every frame's readback, queue, convert, encode and mux\n"
+                              "times to name_telemetry.csv next to the output.");
+
+        ImGui::Checkbox("Record audio", &m_recordAudio);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Adds the played audio as a track (AAC, or PCM with ProRes),\n"
+                              "so the file needs no remux. Not in offline export.");
+
+        ImGui::Checkbox("Instant replay", &m_instantReplay);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Recording keeps only the last seconds, encoded, in memory;\n"
+                              "nothing is written until F11 saves them next to the output\n"
+                              "path. Needs a container that can be written after the fact\n"
+                              "(mp4, mov, mkv).");
+        if (m_instantReplay) {
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(120);
+            ImGui::SliderInt("Seconds##replay", &m_replaySeconds, 5, 300);
         }
 
         ImGui::Separator();
 
         if (!m_app.GetEncoder().IsRecording()) {
             if (ImGui::Button("Start Recording", ImVec2(-1, 40))) {
-                RecordingSettings settings;
-                settings.outputPath = m_recordingPath;
-                settings.codec = (m_recordingCodec == 0) ? "libx264" : "prores_ks";
-                settings.bitrate = m_recordingBitrate * 1000000;
-                settings.proresProfile = m_proresProfile;
-                m_app.StartRecording(settings);
+                m_app.StartRecording(MakeRecordingSettings(), MakeExtraTargets());
+            }
+
+            const bool video = m_app.GetDecoder().IsOpen();
+            if (!video) {
+                ImGui::InputFloat("Export Length (s)", &m_exportSeconds, 10.0f, 60.0f, "%.1f");
+                m_exportSeconds = std::max(m_exportSeconds, 0.1f);
+            }
+            ImGui::SetNextItemWidth(120);
+            ImGui::SliderInt("Sub-frames", &m_exportSubframes, 1, D3D11Renderer::MAX_TEMPORAL_SAMPLES);
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Temporal supersampling: render the shader this many times per exported\n"
+                                  "frame at jittered times and sub-pixel offsets, averaged. Motion blur and\n"
+                                  "anti-aliasing at one float target of memory; export takes as much longer.");
+            if (m_exportSubframes > 1) {
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(120);
+                ImGui::SliderFloat("Shutter", &m_exportShutter, 0.0f, 1.0f, "%.2f");
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Share of the frame interval the sub-frames span\n"
+                                      "(0.5 = 180 degrees, 0 = anti-aliasing only)");
+            }
+            if (ImGui::Button("Export (offline)", ImVec2(-1, 30))) {
+                m_app.StartExport(MakeRecordingSettings(), m_exportSeconds, MakeExtraTargets(), m_exportSubframes,
+                                  m_exportShutter);
+            }
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip(video ? "Render every frame of the video from the start, as fast as\n"
+                                          "the GPU and encoder allow. No frames are dropped."
+                                        : "Render the shader for the given length at exact 1/fps steps,\n"
+                                          "as fast as the GPU and encoder allow.");
+        } else if (m_app.IsExporting()) {
+            const int64_t frame = m_app.GetExportFrame();
+            const int64_t total = m_app.GetExportTotalFrames();
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "%lld / %lld", static_cast<long long>(frame),
+                          static_cast<long long>(total));
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Exporting...");
+            ImGui::ProgressBar(total > 0 ? std::min(static_cast<float>(frame) / total, 1.0f) : 0.0f,
+                               ImVec2(-1, 0), overlay);
+            const double eta = m_app.GetExportEta();
+            if (eta >= 0.0) {
+                ImGui::Text("%.2fx realtime | ETA %d:%02d", m_app.GetExportSpeed(),
+                            static_cast<int>(eta) / 60, static_cast<int>(eta) % 60);
+            } else {
+                ImGui::TextDisabled("Estimating...");
+            }
+            ImGui::Text("Encoding FPS: %.1f", m_app.GetEncoder().GetEncodingFPS());
+            if (ImGui::Button("Cancel Export", ImVec2(-1, 40))) {
+                m_app.CancelExport();
             }
         } else {
             ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Recording in progress...");
@@ -1540,6 +2744,58 @@ void UIManager::DrawRecordingPanel() {
                 m_app.GetEncoder().GetFramesEncoded(),
                 m_app.GetEncoder().GetFramesDropped());
             ImGui::Text("Encoding FPS: %.1f", m_app.GetEncoder().GetEncodingFPS());
+            const double loadScale = m_app.GetEncoder().GetLoadBitrateScale();
+            if (loadScale < 1.0) {
+                ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Bitrate %.0f%%: encoder behind", loadScale * 100.0);
+            }
+            ImGui::TextDisabled(m_app.GetEncoder().HasAudioTrack() ? "Audio: recorded" : "Audio: none");
+            if (m_app.GetEncoder().IsStreaming()) {
+                if (m_app.GetEncoder().IsStreamConnected()) {
+                    ImGui::Text("Stream: send queue %.0f%% | %lld packets dropped",
+                                m_app.GetEncoder().GetSendQueueFill() * 100.0,
+                                static_cast<long long>(m_app.GetEncoder().GetPacketsDropped()));
+                } else {
+                    ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.2f, 1.0f), "Stream: connection lost");
+                }
+            }
+            if (m_app.GetEncoder().IsImageSequence()) {
+                const ImageSequenceWriter& sequence = m_app.GetEncoder().GetImageSequence();
+                ImGui::Text("Images: %d workers, %d in flight | %lld failed", sequence.GetWorkerCount(),
+                            sequence.GetInFlight(), static_cast<long long>(sequence.GetFramesFailed()));
+            }
+            const MediaWriter& writer = m_app.GetEncoder().GetWriter();
+            if (writer.IsOpen()) {
+                ImGui::Text("Disk: queue %.0f%% (peak %.0f%%) | slowest write %.0f ms | stalled %.0f ms",
+                            writer.GetBufferFill() * 100.0, writer.GetPeakBufferFill() * 100.0,
+                            writer.GetMaxWriteMs(), writer.GetStallMs());
+            }
+            for (const auto& target : m_app.GetExtraEncoders()) {
+                ImGui::Text("+ target: %lld | Dropped: %lld | %.1f fps", target->GetFramesEncoded(),
+                            target->GetFramesDropped(), target->GetEncodingFPS());
+            }
+            if (m_app.GetEncoder().IsReplayMode()) {
+                const ReplayBuffer& replay = m_app.GetEncoder().GetReplayBuffer();
+                ImGui::Text("Replay: %.1f s buffered, %.0f MB", replay.GetBufferedSeconds(),
+                            replay.GetBufferedBytes() / (1024.0 * 1024.0));
+                ImGui::BeginDisabled(replay.IsSaving());
+                if (ImGui::Button(replay.IsSaving() ? "Saving...##replay" : "Save Replay (F11)", ImVec2(-1, 30))) {
+                    m_app.SaveReplay();
+                }
+                ImGui::EndDisabled();
+            }
+            const ReadbackLayout readbackLayout = m_app.GetRenderer().GetReadbackLayout();
+            if (m_app.GetEncoder().IsHardwareEncoding()) {
+                ImGui::TextDisabled("Readback: none (GPU encoder reads the rendered surface)");
+            } else {
+                ImGui::Text("Readback: %s, %d frame(s) latency, %d in flight",
+                    readbackLayout == ReadbackLayout::YUV420P   ? "GPU YUV 4:2:0" :
+                    readbackLayout == ReadbackLayout::YUV422P10 ? "GPU YUV 4:2:2 10-bit" : "RGBA",
+                    m_app.GetRenderer().GetReadbackLatency(),
+                    m_app.GetRenderer().GetPendingReadbacks());
+            }
+            if (!m_app.GetEncoder().IsImageSequence() && ImGui::CollapsingHeader("Pipeline telemetry")) {
+                DrawRecordingTelemetry(m_app.GetEncoder().GetTelemetry());
+            }
             
             if (ImGui::Button("Stop Recording", ImVec2(-1, 40))) {
                 m_app.StopRecording();
@@ -1567,7 +2823,9 @@ void UIManager::DrawNotifications() {
         ImGui::SetNextWindowBgAlpha(alpha * 0.8f);
         
         ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 4.0f);
-        ImGui::Begin(("##notif" + std::to_string(yOffset)).c_str(), nullptr,
+        char windowId[32];
+        snprintf(windowId, sizeof(windowId), "##notif%d", static_cast<int>(yOffset));
+        ImGui::Begin(windowId, nullptr,
             ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | 
             ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoFocusOnAppearing);
         
@@ -1712,6 +2970,7 @@ void UIManager::DrawKeybindingModal() {
                 } else {
                     preset->shortcutKey       = triggerKey;
                     preset->shortcutModifiers = mods;
+                    m_app.GetShaderManager().PrefetchPreset(m_keybindingPresetIndex);  // One key away now
                 }
                 m_keybindingConflictMsg.clear();
                 m_showKeybindingModal = false;
@@ -1739,7 +2998,6 @@ void UIManager::DrawNewShaderModal() {
                 ShaderPreset preset;
                 preset.name = m_newShaderName;
                 preset.source = ShaderManager::GetShaderTemplate();
-                m_app.GetShaderManager().LoadShaderFromSource(preset.name, preset.source, preset);
                 int idx = m_app.GetShaderManager().AddPreset(preset);
                 m_app.GetShaderManager().SetActivePreset(idx);
                 ResetKeyframeSelection();
@@ -1842,6 +3100,7 @@ void UIManager::DrawKeybindingsPanel() {
 }
 
 bool UIManager::HandleMessage(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    if (IsUiInputMessage(msg)) m_settleBuilds = INPUT_SETTLE_BUILDS;
     return ImGui_ImplWin32_WndProcHandler(hwnd, msg, wParam, lParam);
 }
 
@@ -1905,7 +3164,9 @@ void UIManager::DrawManageWorkspacesModal() {
                     ImGuiSelectableFlags_SpanAllColumns);
 
                 if (i > 0) {
-                    if (ImGui::BeginPopupContextItem(("##wsctx" + std::to_string(i)).c_str())) {
+                    char popupId[32];
+                    snprintf(popupId, sizeof(popupId), "##wsctx%d", i);
+                    if (ImGui::BeginPopupContextItem(popupId)) {
                         if (ImGui::MenuItem("Set Keybinding...")) {
                             m_workspaceKeybindingIndex = i;
                             m_workspaceKeybindingConflictMsg.clear();
@@ -2073,8 +3334,9 @@ void UIManager::DrawNoisePanel() {
         return;
     }
 
-    ImGui::TextDisabled("Generates a tiling noise texture bound globally as t1/s1.");
-    ImGui::TextDisabled("R channel = Perlin,  G channel = Voronoi.");
+    ImGui::TextDisabled("Generates a tiling, mip-mapped noise texture bound globally as t1/s1.");
+    ImGui::TextDisabled("R = Perlin,  G = Voronoi,  B/A = fBm of each.");
+    ImGui::TextDisabled("Optional 3D volume at t%d: R = Perlin, G = fBm.", NOISE_VOLUME_SLOT);
     ImGui::Separator();
     ImGui::Spacing();
 
@@ -2083,7 +3345,8 @@ void UIManager::DrawNoisePanel() {
 
     changed |= ImGui::SliderFloat("Scale", &ns.scale, 1.0f, 32.0f, "%.1f");
     if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
-        ImGui::SetTooltip("Frequency of noise in the texture (higher = more repetitions).");
+        ImGui::SetTooltip("Frequency of noise in the texture (higher = more repetitions).\n"
+                          "Rounded to whole cells so the texture tiles.");
 
     const char* sizeLabels[] = { "256", "512", "1024" };
     const int   sizeLUT[]    = { 256, 512, 1024 };
@@ -2094,6 +3357,18 @@ void UIManager::DrawNoisePanel() {
         changed = true;
     }
 
+    const char* volumeLabels[] = { "Off", "32", "64", "128" };
+    const int   volumeLUT[]    = { 0, 32, 64, 128 };
+    int volumeIdx = 2; // default 64
+    for (int i = 0; i < 4; ++i) { if (volumeLUT[i] == ns.volumeSize) { volumeIdx = i; break; } }
+    if (ImGui::Combo("Volume Size", &volumeIdx, volumeLabels, 4)) {
+        ns.volumeSize = volumeLUT[volumeIdx];
+        changed = true;
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("3D noise for animating through time: sample noiseVolume at\n"
+                          "float3(uv, time * speed). Tiles on all three axes.");
+
     ImGui::Spacing();
     if (ImGui::Button("Regenerate", ImVec2(-1, 0)) || changed) {
         m_app.RegenerateNoise();
@@ -2102,8 +3377,304 @@ void UIManager::DrawNoisePanel() {
     ImGui::End();
 }
 
+void UIManager::DrawDeckPanel() {
+    ImGui::SetNextWindowSize(ImVec2(340, 260), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("A/B Decks", &m_showDeckPanel)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::TextDisabled("Deck A: the main video and shader.");
+    ImGui::TextDisabled("Deck B: a clip cued in the background, with its own preset.");
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    AppConfig& cfg = m_app.GetConfig();
+    Deck& deck = m_app.GetDeck();
+
+    if (ImGui::Button("Cue...")) m_app.CueDeckDialog();
+    ImGui::SameLine();
+    ImGui::BeginDisabled(deck.GetPath().empty());
+    if (ImGui::Button("Unload")) {
+        m_app.UnloadDeck();
+        m_app.SaveConfig();
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    if (deck.IsLoading()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "Loading...");
+    } else if (deck.IsReady()) {
+        ImGui::TextColored(ImVec4(0.3f, 1.0f, 0.3f, 1.0f), "Ready");
+        ImGui::SameLine();
+        ImGui::TextDisabled("%dx%d  %.1fs", deck.GetFrame().width, deck.GetFrame().height, deck.GetTime());
+    } else {
+        ImGui::TextDisabled("Empty");
+    }
+    if (!deck.GetPath().empty())
+        ImGui::TextDisabled("%s", std::filesystem::path(deck.GetPath()).filename().string().c_str());
+
+    bool changed = false;
+    ImGui::SetNextItemWidth(-80.0f);
+    if (ImGui::BeginCombo("Preset", cfg.deckPreset.empty() ? "(passthrough)" : cfg.deckPreset.c_str())) {
+        if (ImGui::Selectable("(passthrough)", cfg.deckPreset.empty())) {
+            cfg.deckPreset.clear();
+            changed = true;
+        }
+        for (const ShaderPreset& candidate : m_app.GetShaderManager().GetPresets()) {
+            // Single-pass pixel presets only, as for layers
+            if (!candidate.passes.empty() || candidate.compute.enabled) continue;
+            if (ImGui::Selectable(candidate.name.c_str(), candidate.name == cfg.deckPreset)) {
+                cfg.deckPreset = candidate.name;
+                changed = true;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SetNextItemWidth(-80.0f);
+    changed |= ImGui::Combo("Transition", &cfg.deckTransition, "Fade\0Wipe\0\0");
+    if (changed) m_app.SaveConfig();
+
+    ImGui::Spacing();
+    ImGui::BeginDisabled(!deck.IsReady());
+    if (ImGui::Button(deck.IsPlaying() ? "Pause" : "Play")) deck.SetPlaying(!deck.IsPlaying());
+    ImGui::SameLine();
+    if (ImGui::Button("Rewind")) deck.Rewind();
+    ImGui::EndDisabled();
+
+    ImGui::Spacing();
+    float fader = m_app.GetCrossfader();
+    if (ImGui::Button("A")) m_app.SetCrossfader(0.0f);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x - ImGui::GetFrameHeight() - ImGui::GetStyle().ItemSpacing.x);
+    if (ImGui::SliderFloat("##crossfader", &fader, 0.0f, 1.0f, "%.2f")) m_app.SetCrossfader(fader);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Crossfader: A at the left, B at the right.\n"
+                          "Deck B starts from its cue point when the fader leaves A;\n"
+                          "its preset is compiled and drawn while cued, so the move is cheap.");
+    ImGui::SameLine();
+    if (ImGui::Button("B")) m_app.SetCrossfader(1.0f);
+
+    ImGui::End();
+}
+
+void UIManager::DrawChannelsPanel() {
+    ImGui::SetNextWindowSize(ImVec2(360, 300), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Channels", &m_showChannelsPanel)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::TextDisabled("Extra clips, each through its own preset into its own output window.");
+    ImGui::TextDisabled("Channel 1 is the main player; the others follow its play and pause.");
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    AppConfig& cfg = m_app.GetConfig();
+    int remove = -1;
+    for (int i = 0; i < m_app.GetChannelCount(); ++i) {
+        ImGui::PushID(i + 4000);
+        const PlaybackChannel& channel = m_app.GetChannel(i);
+        const Deck& deck = channel.GetDeck();
+        ImGui::Text("Channel %d", i + 2);
+        ImGui::SameLine();
+        if (deck.IsLoading()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "Loading...");
+        } else if (deck.IsReady()) {
+            ImGui::TextColored(ImVec4(0.3f, 1.0f, 0.3f, 1.0f), "Ready");
+            ImGui::SameLine();
+            ImGui::TextDisabled("%dx%d  %.1fs", deck.GetFrame().width, deck.GetFrame().height, deck.GetTime());
+        } else {
+            ImGui::TextDisabled("Empty");
+        }
+
+        if (ImGui::Button("Cue...")) m_app.CueChannelDialog(i);
+        ImGui::SameLine();
+        ImGui::BeginDisabled(deck.GetPath().empty());
+        if (ImGui::Button("Unload")) {
+            m_app.UnloadChannel(i);
+            m_app.SaveConfig();
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        bool output = cfg.channels[i].output;
+        if (ImGui::Checkbox("Output", &output)) m_app.SetChannelOutput(i, output);
+        ImGui::SameLine();
+        if (ImGui::Button("Remove")) remove = i;
+        if (!deck.GetPath().empty())
+            ImGui::TextDisabled("%s", std::filesystem::path(deck.GetPath()).filename().string().c_str());
+
+        const std::string& preset = cfg.channels[i].preset;
+        ImGui::SetNextItemWidth(-80.0f);
+        if (ImGui::BeginCombo("Preset", preset.empty() ? "(passthrough)" : preset.c_str())) {
+            if (ImGui::Selectable("(passthrough)", preset.empty())) m_app.SetChannelPreset(i, "");
+            for (const ShaderPreset& candidate : m_app.GetShaderManager().GetPresets()) {
+                // Single-pass pixel or compute presets, as post-chain stages
+                if (!candidate.passes.empty()) continue;
+                if (ImGui::Selectable(candidate.name.c_str(), candidate.name == preset))
+                    m_app.SetChannelPreset(i, candidate.name);
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::Separator();
+        ImGui::PopID();
+    }
+    if (remove >= 0) m_app.RemoveChannel(remove);
+
+    ImGui::BeginDisabled(m_app.GetChannelCount() >= MAX_CHANNELS);
+    if (ImGui::Button("Add Channel")) m_app.AddChannel();
+    ImGui::EndDisabled();
+
+    // Across machines: one master per wall, the other nodes follow its clock
+    ImGui::Spacing();
+    if (ImGui::CollapsingHeader("Frame Sync")) {
+        const FrameSync& sync = m_app.GetFrameSync();
+        int role = cfg.frameSyncRole;
+        ImGui::SetNextItemWidth(120.0f);
+        if (ImGui::Combo("##frameSyncRole", &role, "Off\0Master\0Follower\0\0")) m_app.SetFrameSync(role, cfg.frameSyncPort);
+        ImGui::SameLine();
+        int port = cfg.frameSyncPort;
+        ImGui::SetNextItemWidth(100.0f);
+        if (ImGui::InputInt("UDP port##frameSync", &port, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue))
+            m_app.SetFrameSync(cfg.frameSyncRole, port);
+
+        if (sync.GetRole() == FrameSync::Role::Master) {
+            ImGui::TextDisabled("Broadcasting the clock; %d follower%s", sync.GetFollowers(),
+                                sync.GetFollowers() == 1 ? "" : "s");
+        } else if (sync.GetRole() == FrameSync::Role::Follower) {
+            FrameSync::Target target;
+            const bool heard = sync.GetTarget(std::chrono::steady_clock::now(), target);
+            if (m_app.IsFrameSyncLocked()) {
+                ImGui::TextColored(ImVec4(0.3f, 1.0f, 0.3f, 1.0f), "Locked");
+            } else if (heard) {
+                ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "Catching up");
+            } else {
+                ImGui::TextDisabled("Waiting for the master");
+            }
+            if (heard) {
+                ImGui::SameLine();
+                ImGui::TextDisabled("frame %lld", static_cast<long long>(target.frame));
+                ImGui::TextDisabled("Offset %.3f ms  delay %.3f ms  drift %+.1f ppm", sync.GetOffsetMs(),
+                                    sync.GetDelayMs(), sync.GetDriftPpm());
+                const double duration = m_app.GetDecoder().IsOpen() ? m_app.GetDecoder().GetDuration() : 0.0;
+                if (std::abs(target.duration - duration) > 0.01)
+                    ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "The master's clip is %.2f s long, this one %.2f s",
+                                       target.duration, duration);
+            }
+        }
+        ImGui::TextDisabled("Open the same clip on every node; followers take the master's play, pause,");
+        ImGui::TextDisabled("rate and position. Render-ahead on the followers absorbs network jitter.");
+    }
+
+    ImGui::End();
+}
+
+void UIManager::DrawCanvasPanel() {
+    ImGui::SetNextWindowSize(ImVec2(380, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Canvas", &m_showCanvasPanel)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::TextDisabled("One render spread over several output windows (projectors):");
+    ImGui::TextDisabled("each shows its region of the frame, edge-blended and warped.");
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    AppConfig& cfg = m_app.GetConfig();
+    bool enabled = cfg.canvasEnabled;
+    if (ImGui::Checkbox("Canvas outputs", &enabled)) m_app.SetCanvasEnabled(enabled);
+
+    ImGui::SetNextItemWidth(80.0f);
+    ImGui::SliderInt("Outputs", &m_canvasLayoutCount, 1, MAX_CANVAS_OUTPUTS);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100.0f);
+    ImGui::SliderFloat("Overlap", &m_canvasLayoutOverlap, 0.0f, 0.25f, "%.2f");
+    ImGui::SameLine();
+    if (ImGui::Button("Lay out")) m_app.SetCanvasLayout(m_canvasLayoutCount, m_canvasLayoutOverlap);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Side by side across the canvas, each pair of neighbours sharing\n"
+                          "the overlap (a fraction of the canvas width) as an edge blend.\n"
+                          "Warps and gamma are kept.");
+
+    bool changed = false;
+    for (int i = 0; i < static_cast<int>(cfg.canvasOutputs.size()); ++i) {
+        ImGui::PushID(i + 5000);
+        CanvasRegion& region = cfg.canvasOutputs[i];
+        const bool open = m_app.IsCanvasOutputOpen(i);
+        char label[32];
+        snprintf(label, sizeof(label), "Output %d%s", i + 1, open ? "" : " (closed)");
+        if (ImGui::CollapsingHeader(label)) {
+            changed |= ImGui::DragFloat4("Region", &region.x, 0.001f, 0.0f, 1.0f, "%.3f");
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("x, y, width, height in the canvas");
+            changed |= ImGui::DragFloat4("Blend", &region.blendLeft, 0.001f, 0.0f, 0.5f, "%.3f");
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("Left, right, top, bottom blend widths, fractions of the region");
+            changed |= ImGui::SliderFloat("Gamma", &region.blendGamma, 1.0f, 3.0f, "%.2f");
+            static const char* CORNER_NAMES[4] = {"Top left", "Top right", "Bottom left", "Bottom right"};
+            for (int corner = 0; corner < 4; ++corner)
+                changed |= ImGui::DragFloat2(CORNER_NAMES[corner], &region.corners[corner * 2], 0.001f, -0.5f, 1.5f, "%.3f");
+            if (ImGui::Button("Reset warp")) {
+                region.corners = CanvasRegion{}.corners;
+                changed = true;
+            }
+        }
+        ImGui::PopID();
+    }
+    if (changed) m_app.SaveConfig();
+
+    ImGui::End();
+}
+
+void UIManager::DrawPlaylistPanel() {
+    ImGui::SetNextWindowSize(ImVec2(360, 280), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Playlist", &m_showPlaylistPanel)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::TextDisabled("Double-click an entry to play from it. Each clip's end opens the next;");
+    ImGui::TextDisabled("a single clip, or a file opened elsewhere, loops.");
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    std::vector<std::string>& playlist = m_app.GetConfig().playlist;
+    const int playing = m_app.GetPlaylistIndex();
+    int moveUp = -1, remove = -1;
+    for (int i = 0; i < static_cast<int>(playlist.size()); ++i) {
+        ImGui::PushID(i + 3000);
+        const std::string name = std::filesystem::path(playlist[i]).filename().string();
+        if (ImGui::SmallButton("^") && i > 0) moveUp = i;
+        ImGui::SameLine();
+        if (ImGui::SmallButton("X")) remove = i;
+        ImGui::SameLine();
+        if (ImGui::Selectable(name.c_str(), i == playing, ImGuiSelectableFlags_AllowDoubleClick) &&
+            ImGui::IsMouseDoubleClicked(0)) {
+            m_app.PlayPlaylistItem(i);
+        }
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", playlist[i].c_str());
+        ImGui::PopID();
+    }
+    if (playlist.empty()) ImGui::TextDisabled("(empty)");
+
+    // Edits apply after the loop. The clip playing keeps playing; removed, it loops.
+    if (moveUp > 0 || remove >= 0) {
+        if (moveUp > 0) std::swap(playlist[moveUp], playlist[moveUp - 1]);
+        if (remove >= 0) playlist.erase(playlist.begin() + remove);
+        m_app.PlaylistEdited();
+        m_app.SaveConfig();
+    }
+
+    ImGui::Spacing();
+    if (ImGui::Button("Add...")) m_app.AddToPlaylistDialog();
+    ImGui::SameLine();
+    ImGui::BeginDisabled(playlist.empty());
+    if (ImGui::Button("Play")) m_app.PlayPlaylistItem(playing >= 0 ? playing : 0);
+    ImGui::EndDisabled();
+
+    ImGui::End();
+}
+
 void UIManager::DrawSpoutPanel() {
-    ImGui::SetNextWindowSize(ImVec2(340, 180), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(340, 400), ImGuiCond_FirstUseEver);
     if (!ImGui::Begin("Spout Output", &m_showSpoutPanel)) {
         ImGui::End();
         return;
@@ -2140,6 +3711,47 @@ void UIManager::DrawSpoutPanel() {
         m_app.SetSpoutSenderName(nameBuf);
     ImGui::TextDisabled("Sender name (Enter to apply)");
 
+    // What is sent, and at what size
+    const D3D11Renderer& renderer = m_app.GetRenderer();
+    const int passCount = renderer.GetRenderGraphPassCount();
+    char label[128];
+    auto passLabel = [&](int pass) -> const char* {
+        if (pass < 0) return "Output";
+        const std::string* target = pass < passCount - 1 ? &renderer.GetRenderGraphPass(pass).target : nullptr;
+        if (target && !target->empty()) snprintf(label, sizeof(label), "Pass %d (%s)", pass, target->c_str());
+        else snprintf(label, sizeof(label), "Pass %d", pass);
+        return label;
+    };
+    ImGui::SetNextItemWidth(160.0f);
+    if (ImGui::BeginCombo("Source##spout", passLabel(cfg.spoutPass))) {
+        if (ImGui::Selectable("Output", cfg.spoutPass < 0)) m_app.SetSpoutPass(-1);
+        for (int pass = 0; pass < passCount - 1; ++pass) {
+            if (ImGui::Selectable(passLabel(pass), pass == cfg.spoutPass)) m_app.SetSpoutPass(pass);
+        }
+        ImGui::EndCombo();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("A render-graph pass of the active preset; presets without it send the output.");
+
+    int size[2] = { cfg.spoutWidth, cfg.spoutHeight };
+    ImGui::SetNextItemWidth(160.0f);
+    ImGui::InputInt2("Size##spout", size);
+    if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SetSpoutOutputSize(size[0], size[1]);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Native##spoutSize")) m_app.SetSpoutOutputSize(0, 0);
+    ImGui::TextDisabled(cfg.spoutWidth > 0 ? "Scaled on the GPU before sending" : "0 x 0 = source size");
+
+    // Send timing: frames go out only when the renderer drew a new one
+    const SpoutSendStats& stats = m_app.GetSpoutStats();
+    if (stats.framesSent > 0) {
+        ImGui::Text("Sent %lld, unchanged %lld  |  %dx%d", static_cast<long long>(stats.framesSent),
+                    static_cast<long long>(stats.framesSkipped), stats.width, stats.height);
+        ImGui::Text("Send %.3f ms (avg %.3f)  |  %.1f fps", stats.lastSendMs, stats.avgSendMs,
+                    stats.avgIntervalMs > 0.0 ? 1000.0 / stats.avgIntervalMs : 0.0);
+        if (GpuFrameTiming gpu; renderer.GetGpuProfiler().GetLatest(gpu))
+            ImGui::TextDisabled("GPU %.3f ms", gpu.ms[static_cast<size_t>(GpuStage::Spout)]);
+    }
+
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Spacing();
@@ -2148,32 +3760,413 @@ void UIManager::DrawSpoutPanel() {
     if (ImGui::Button("Get SpoutCam (virtual webcam)..."))
         ShellExecuteA(nullptr, "open", "https://github.com/leadedge/SpoutCam/releases/latest", nullptr, nullptr, SW_SHOWNORMAL);
 
+    // Receive: another application's output as the video source
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+    ImGui::Text("Receive");
+    const SpoutInput& input = m_app.GetSpoutInput();
+    if (m_spoutSenderIdx >= static_cast<int>(m_spoutSenders.size())) m_spoutSenderIdx = -1;
+    ImGui::SetNextItemWidth(-70.0f);
+    if (ImGui::BeginCombo("##spoutSender", m_spoutSenderIdx < 0 ? "(active sender)"
+                                                                : m_spoutSenders[m_spoutSenderIdx].c_str())) {
+        if (ImGui::Selectable("(active sender)", m_spoutSenderIdx < 0)) m_spoutSenderIdx = -1;
+        for (int i = 0; i < static_cast<int>(m_spoutSenders.size()); ++i) {
+            if (ImGui::Selectable(m_spoutSenders[i].c_str(), i == m_spoutSenderIdx)) m_spoutSenderIdx = i;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Refresh##spoutSenders") || (m_spoutSenders.empty() && ImGui::IsWindowAppearing()))
+        m_spoutSenders = SpoutInput::ListSenders();
+
+    if (input.IsOpen()) {
+        if (ImGui::Button("Disconnect")) m_app.CloseSpoutInput();
+        ImGui::SameLine();
+        if (input.IsConnected()) {
+            ImGui::TextColored(ImVec4(0.3f, 1.0f, 0.3f, 1.0f), "\"%s\" %dx%d", input.GetConnectedName().c_str(),
+                               input.GetWidth(), input.GetHeight());
+        } else {
+            ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "Waiting for sender...");
+        }
+    } else if (ImGui::Button("Use as video source")) {
+        m_app.OpenSpoutInput(m_spoutSenderIdx < 0 ? std::string{} : m_spoutSenders[m_spoutSenderIdx]);
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Replaces the open video: the sender's frames are copied on the GPU into t0.\n"
+                          "Receiving this app's own sender makes a feedback loop.");
+
     ImGui::End();
 }
 
-void UIManager::DrawAudioPanel() {
-    ImGui::SetNextWindowSize(ImVec2(360, 340), ImGuiCond_FirstUseEver);
-    if (!ImGui::Begin("Audio Monitor", &m_showAudioPanel)) {
+void UIManager::DrawNdiPanel() {
+    ImGui::SetNextWindowSize(ImVec2(340, 320), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("NDI", &m_showNdiPanel)) {
         ImGui::End();
         return;
     }
-
-    const bool hasAudio = m_app.GetDecoder().HasAudio();
-    if (!hasAudio) {
-        ImGui::TextDisabled("No audio stream in current video.");
+    if (!m_app.IsNdiAvailable()) {
+        ImGui::TextWrapped("NDI is unavailable: this build has no NDI support (SHADERPLAYER_NDI) "
+                           "or the NDI runtime is not installed.");
         ImGui::End();
         return;
     }
 
-    const AudioData& ad = m_app.GetAudioData();
+    AppConfig& cfg = m_app.GetConfig();
+    bool enabled = m_app.IsNdiRunning();
+    if (ImGui::Checkbox("Send via NDI", &enabled))
+        m_app.SetNdiEnabled(enabled);
 
-    // Band meters
-    ImGui::TextDisabled("LEVELS");
+    const NdiSendStats stats = m_app.GetNdiStats();
+    ImGui::SameLine();
+    if (!m_app.IsNdiRunning()) {
+        ImGui::TextDisabled("Off");
+    } else if (stats.connections > 0) {
+        ImGui::TextColored(ImVec4(0.3f, 1.0f, 0.3f, 1.0f), "%d receiver%s", stats.connections,
+                           stats.connections == 1 ? "" : "s");
+    } else {
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "No receivers (idle)");
+    }
+
+    char nameBuf[128] = {};
+    strncpy_s(nameBuf, cfg.ndiSenderName.c_str(), sizeof(nameBuf) - 1);
+    ImGui::SetNextItemWidth(-1.0f);
+    if (ImGui::InputText("##ndiName", nameBuf, sizeof(nameBuf), ImGuiInputTextFlags_EnterReturnsTrue))
+        m_app.SetNdiSenderName(nameBuf);
+    ImGui::TextDisabled("Source name (Enter to apply)");
+
+    int size[2] = { cfg.ndiWidth, cfg.ndiHeight };
+    ImGui::SetNextItemWidth(160.0f);
+    ImGui::InputInt2("Size##ndi", size);
+    if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SetNdiOutputSize(size[0], size[1]);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Native##ndiSize")) m_app.SetNdiOutputSize(0, 0);
+
+    if (stats.framesSent > 0) {
+        ImGui::Text("Sent %lld, dropped %lld  |  %dx%d UYVY", static_cast<long long>(stats.framesSent),
+                    static_cast<long long>(stats.framesDropped), stats.width, stats.height);
+        ImGui::Text("Copy %.3f ms  |  Send %.3f ms", stats.avgCopyMs, stats.avgSendMs);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Copy: mapping the GPU readback (render thread).\n"
+                              "Send: handing the frame to NDI (send thread).");
+    }
+
+    // Receive: a network source as the video
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+    ImGui::Text("Receive");
+    const NdiInput& input = m_app.GetNdiInput();
+    if (m_ndiSourceIdx >= static_cast<int>(m_ndiSources.size())) m_ndiSourceIdx = -1;
+    ImGui::SetNextItemWidth(-70.0f);
+    if (ImGui::BeginCombo("##ndiSource", m_ndiSourceIdx < 0 ? "(choose a source)"
+                                                            : m_ndiSources[m_ndiSourceIdx].c_str())) {
+        for (int i = 0; i < static_cast<int>(m_ndiSources.size()); ++i) {
+            if (ImGui::Selectable(m_ndiSources[i].c_str(), i == m_ndiSourceIdx)) m_ndiSourceIdx = i;
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Refresh##ndiSources") || (m_ndiSources.empty() && ImGui::IsWindowAppearing()))
+        m_ndiSources = m_app.ListNdiSources();
+
+    if (input.IsOpen()) {
+        if (ImGui::Button("Disconnect##ndi")) m_app.CloseNdiInput();
+        ImGui::SameLine();
+        if (input.IsConnected() && input.GetWidth() > 0) {
+            ImGui::TextColored(ImVec4(0.3f, 1.0f, 0.3f, 1.0f), "%dx%d, %lld frames", input.GetWidth(),
+                               input.GetHeight(), static_cast<long long>(input.GetFramesReceived()));
+        } else {
+            ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "Connecting...");
+        }
+    } else {
+        ImGui::BeginDisabled(m_ndiSourceIdx < 0);
+        if (ImGui::Button("Use as video source##ndi")) m_app.OpenNdiInput(m_ndiSources[m_ndiSourceIdx]);
+        ImGui::EndDisabled();
+    }
+
+    ImGui::End();
+}
+
+void UIManager::DrawVirtualCameraPanel() {
+    ImGui::SetNextWindowSize(ImVec2(340, 220), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Virtual Camera", &m_showVirtualCameraPanel)) {
+        ImGui::End();
+        return;
+    }
+    if (!m_app.IsVirtualCameraAvailable()) {
+        ImGui::TextWrapped("The virtual camera needs Windows 11 (MFCreateVirtualCamera).");
+        ImGui::End();
+        return;
+    }
+
+    AppConfig& cfg = m_app.GetConfig();
+    bool enabled = m_app.IsVirtualCameraRunning();
+    if (ImGui::Checkbox("Show as a camera", &enabled))
+        m_app.SetVirtualCameraEnabled(enabled);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Needs ShaderPlayerVCam.dll registered once:\n"
+                          "regsvr32 ShaderPlayerVCam.dll (as administrator).");
+
+    const VirtualCameraStats stats = m_app.GetVirtualCameraStats();
+    ImGui::SameLine();
+    if (!m_app.IsVirtualCameraRunning()) {
+        ImGui::TextDisabled("Off");
+    } else if (stats.streaming) {
+        ImGui::TextColored(ImVec4(0.3f, 1.0f, 0.3f, 1.0f), "In use %dx%d", stats.width, stats.height);
+    } else {
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "No client (idle)");
+    }
+
+    char nameBuf[128] = {};
+    strncpy_s(nameBuf, cfg.virtualCameraName.c_str(), sizeof(nameBuf) - 1);
+    ImGui::SetNextItemWidth(-1.0f);
+    if (ImGui::InputText("##vcamName", nameBuf, sizeof(nameBuf), ImGuiInputTextFlags_EnterReturnsTrue))
+        m_app.SetVirtualCameraName(nameBuf);
+    ImGui::TextDisabled("Camera name (Enter to apply)");
+    ImGui::TextDisabled("The size and rate are the ones the client picks.");
+
+    if (stats.framesWritten > 0) {
+        ImGui::Text("Frames %lld, dropped %lld  |  NV12", static_cast<long long>(stats.framesWritten),
+                    static_cast<long long>(stats.framesDropped));
+        ImGui::Text("Copy %.3f ms", stats.avgCopyMs);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Mapping the GPU readback and copying it into the shared frame slot (render thread).");
+    }
+
+    ImGui::End();
+}
+
+void UIManager::DrawControllersPanel() {
+    ImGui::SetNextWindowSize(ImVec2(460, 320), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Controllers", &m_showControllersPanel)) {
+        ImGui::End();
+        return;
+    }
+
+    AppConfig& cfg = m_app.GetConfig();
+    const ControlInput& input = m_app.GetControlInput();
+
+    bool osc = input.IsOscRunning();
+    if (ImGui::Checkbox("OSC", &osc)) m_app.SetOscInput(osc, cfg.oscPort);
+    ImGui::SameLine();
+    int port = cfg.oscPort;
+    ImGui::SetNextItemWidth(100.0f);
+    if (ImGui::InputInt("UDP port", &port, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue))
+        m_app.SetOscInput(input.IsOscRunning(), port);
+
+    ImGui::SetNextItemWidth(-1.0f);
+    if (ImGui::BeginCombo("##midi", cfg.midiDevice.empty() ? "No MIDI input" : cfg.midiDevice.c_str())) {
+        if (ImGui::IsWindowAppearing()) m_midiDevices = ControlInput::ListMidiDevices();  // Once per opening
+        if (ImGui::Selectable("No MIDI input", cfg.midiDevice.empty())) m_app.SetMidiInput("");
+        for (const std::string& name : m_midiDevices) {
+            if (ImGui::Selectable(name.c_str(), name == cfg.midiDevice)) m_app.SetMidiInput(name);
+        }
+        ImGui::EndCombo();
+    }
+
+    const std::string& last = m_app.GetLastControlAddress();
+    ImGui::TextDisabled("Last received: %s", last.empty() ? "(nothing yet)" : last.c_str());
+    if (input.GetDroppedEvents() > 0) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%lld dropped",
+                           static_cast<long long>(input.GetDroppedEvents()));
+    }
+    ImGui::TextDisabled("Bind with the L button next to a shader parameter.");
+    ImGui::Separator();
+
+    // Bindings: values arrive as 0..1 and are scaled to Min..Max
+    bool changed = false;
+    int  remove  = -1;
+    if (ImGui::BeginTable("##mappings", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+        ImGui::TableSetupColumn("Address");
+        ImGui::TableSetupColumn("Target");
+        ImGui::TableSetupColumn("Min");
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, 20.0f);
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < static_cast<int>(cfg.controlMappings.size()); ++i) {
+            ControlMapping& m = cfg.controlMappings[i];
+            ImGui::PushID(i);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(m.address.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%s / %s[%d]", m.preset.empty() ? "(active)" : m.preset.c_str(), m.param.c_str(), m.component);
+            ImGui::TableNextColumn();
+            ImGui::SetNextItemWidth(-1.0f);
+            changed |= ImGui::DragFloat("##min", &m.min, 0.01f);
+            ImGui::TableNextColumn();
+            ImGui::SetNextItemWidth(-1.0f);
+            changed |= ImGui::DragFloat("##max", &m.max, 0.01f);
+            ImGui::TableNextColumn();
+            if (ImGui::SmallButton("X")) remove = i;
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    if (remove >= 0) {
+        cfg.controlMappings.erase(cfg.controlMappings.begin() + remove);
+        changed = true;
+    }
+    if (changed) m_app.SaveConfig();
+
+    ImGui::End();
+}
+
+void UIManager::DrawPostChainsPanel() {
+    ImGui::SetNextWindowSize(ImVec2(360, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Output Post Chains", &m_showPostChainsPanel)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::TextDisabled("Presets drawn over the finished frame for one output only,");
+    ImGui::TextDisabled("at its size: scopes on the monitor, not on the projector.");
+    ImGui::Separator();
+
+    static const char* const s_outputNames[POST_OUTPUT_COUNT] = {
+        "Preview", "Output window", "Spout", "NDI", "Recording", "Virtual camera" };
+    std::vector<std::vector<std::string>>& chains = m_app.GetConfig().postChains;
+    bool changed = false;
+    for (int output = 0; output < POST_OUTPUT_COUNT; ++output) {
+        std::vector<std::string>& chain = chains[output];
+        ImGui::PushID(output + 4000);
+        char header[64];
+        if (chain.empty()) snprintf(header, sizeof(header), "%s###post", s_outputNames[output]);
+        else snprintf(header, sizeof(header), "%s (%d)###post", s_outputNames[output], static_cast<int>(chain.size()));
+        if (ImGui::CollapsingHeader(header, ImGuiTreeNodeFlags_DefaultOpen)) {
+            int moveUp = -1, remove = -1;
+            for (int i = 0; i < static_cast<int>(chain.size()); ++i) {
+                ImGui::PushID(i);
+                if (ImGui::SmallButton("^") && i > 0) moveUp = i;
+                ImGui::SameLine();
+                if (ImGui::SmallButton("X")) remove = i;
+                ImGui::SameLine();
+                ImGui::TextUnformatted(chain[i].c_str());
+                ImGui::PopID();
+            }
+            if (moveUp > 0) std::swap(chain[moveUp], chain[moveUp - 1]);
+            if (remove >= 0) chain.erase(chain.begin() + remove);
+            changed |= moveUp > 0 || remove >= 0;
+
+            if (static_cast<int>(chain.size()) < MAX_POST_STAGES) {
+                ImGui::SetNextItemWidth(-1.0f);
+                if (ImGui::BeginCombo("##add", "+ Stage")) {
+                    for (const ShaderPreset& candidate : m_app.GetShaderManager().GetPresets()) {
+                        // Single-pass pixel and compute presets; graphs need their own targets
+                        if (!candidate.passes.empty()) continue;
+                        if (ImGui::Selectable(candidate.name.c_str())) {
+                            chain.push_back(candidate.name);
+                            changed = true;
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+            }
+        }
+        ImGui::PopID();
+    }
+    if (changed) m_app.SaveConfig();
+
+    ImGui::Spacing();
+    ImGui::TextDisabled("Stages use their presets' current values; multi-pass presets are not offered.");
+    if (GpuFrameTiming gpu; m_app.GetRenderer().GetGpuProfiler().GetLatest(gpu))
+        ImGui::TextDisabled("GPU %.3f ms", gpu.ms[static_cast<size_t>(GpuStage::Post)]);
+
+    ImGui::End();
+}
+
+void UIManager::DrawAudioPanel() {
+    ImGui::SetNextWindowSize(ImVec2(360, 340), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Audio Monitor", &m_showAudioPanel)) {
+        ImGui::End();
+        return;
+    }
+
+    // Input: the file's audio, or a live device with or without a video
+    AudioCapture& capture = m_app.GetAudioCapture();
+    const AppConfig& cfg  = m_app.GetConfig();
+    static const char* s_inputNames[] = { "Video file", "Line-in / microphone", "Loopback (output device)" };
+    int input = std::clamp(cfg.audioInput, AUDIO_INPUT_FILE, AUDIO_INPUT_LOOPBACK);
+    if (ImGui::Combo("Input", &input, s_inputNames, IM_ARRAYSIZE(s_inputNames)) && input != cfg.audioInput)
+        m_app.SetAudioInput(input, "");
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Loopback analyses what an output device plays, e.g. a DJ mixer's feed\n"
+                          "through the sound card. Live inputs are analysed, not played.");
+    if (cfg.audioInput != AUDIO_INPUT_FILE) {
+        const std::string& device = cfg.audioInputDevice;
+        if (ImGui::BeginCombo("Device", device.empty() ? "Default" : device.c_str())) {
+            if (ImGui::IsWindowAppearing()) capture.RefreshDevices();  // Once per opening
+            if (ImGui::Selectable("Default", device.empty()))
+                m_app.SetAudioInput(cfg.audioInput, "");
+            for (const std::string& name : capture.GetDevices(cfg.audioInput)) {
+                if (ImGui::Selectable(name.c_str(), name == device))
+                    m_app.SetAudioInput(cfg.audioInput, name);
+            }
+            ImGui::EndCombo();
+        }
+        if (!capture.IsRunning()) {
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Retry")) m_app.SetAudioInput(cfg.audioInput, device);
+            if (!capture.GetError().empty())
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", capture.GetError().c_str());
+        } else {
+            ImGui::TextDisabled("%d Hz", capture.GetSampleRate());
+        }
+    }
+
+    // Output: low-latency mode and the device buffer it was actually given
+    bool lowLatency = cfg.audioLowLatency;
+    if (ImGui::Checkbox("Low-latency output", &lowLatency))
+        m_app.SetAudioLowLatency(lowLatency);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Exclusive-mode WASAPI with small periods (shared mode if the device is\n"
+                          "busy) and a 150 ms queue instead of 2 s. Main-thread stalls longer\n"
+                          "than the queue are heard as dropouts.");
+    const AudioPlayer& player = m_app.GetAudioPlayer();
+    if (player.IsInitialized() && player.GetDeviceSampleRate() > 0) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s, %.1f ms", player.IsExclusive() ? "exclusive" : "shared",
+                            1000.0 * player.GetDeviceLatencySamples() / player.GetDeviceSampleRate());
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Device buffer as negotiated; A/V sync and the analysis clock allow for it.");
+    }
+    ImGui::Separator();
+
+    const bool hasAudio = m_app.GetAudioReader().IsOpen() || capture.IsRunning();
+    if (!hasAudio) {
+        ImGui::TextDisabled(cfg.audioInput == AUDIO_INPUT_FILE ? "No audio stream in current video."
+                                                               : "Audio input is not running.");
+        ImGui::End();
+        return;
+    }
+
+    const AudioData& ad = m_app.GetAudioData();
+
+    // Band meters
+    ImGui::TextDisabled("LEVELS");
     ImGui::ProgressBar(ad.rms,  ImVec2(-1, 0), "RMS");
     ImGui::ProgressBar(ad.bass, ImVec2(-1, 0), "Bass");
     ImGui::ProgressBar(ad.mid,  ImVec2(-1, 0), "Mid");
     ImGui::ProgressBar(ad.high, ImVec2(-1, 0), "High");
 
+    // Per channel, left and right side by side
+    ImGui::Spacing();
+    ImGui::TextDisabled("STEREO");
+    const float half = (ImGui::GetContentRegionAvail().x - ImGui::GetStyle().ItemSpacing.x) * 0.5f;
+    const float* channelBands[] = { ad.channelRms, ad.channelBass, ad.channelMid, ad.channelHigh };
+    const char*  bandNames[]    = { "RMS", "Bass", "Mid", "High" };
+    for (int b = 0; b < 4; ++b) {
+        char label[16];
+        snprintf(label, sizeof(label), "L %s", bandNames[b]);
+        ImGui::ProgressBar(channelBands[b][0], ImVec2(half, 0), label);
+        ImGui::SameLine();
+        snprintf(label, sizeof(label), "R %s", bandNames[b]);
+        ImGui::ProgressBar(channelBands[b][1], ImVec2(half, 0), label);
+    }
+    ImGui::ProgressBar(ad.stereoWidth, ImVec2(-1, 0), "Width");
+
     // Beat indicator
     ImGui::Spacing();
     ImGui::TextDisabled("BEAT");
@@ -2182,6 +4175,16 @@ void UIManager::DrawAudioPanel() {
     ImGui::ProgressBar(ad.beat, ImVec2(-1, 0), "Beat");
     if (ad.beat > 0.1f)
         ImGui::PopStyleColor();
+    if (ad.bpm > 0.0f) {
+        char tempo[32];
+        snprintf(tempo, sizeof(tempo), "%.1f BPM", ad.bpm);
+        ImGui::ProgressBar(ad.beatPhase, ImVec2(half, 0), tempo);
+        ImGui::SameLine();
+        snprintf(tempo, sizeof(tempo), "Bar %d", static_cast<int>(ad.barPhase * 4.0f) + 1);
+        ImGui::ProgressBar(ad.barPhase, ImVec2(half, 0), tempo);
+    } else {
+        ImGui::TextDisabled("No tempo yet");
+    }
 
     // Mini spectrum
     ImGui::Spacing();
@@ -2218,55 +4221,782 @@ void UIManager::DrawAudioPanel() {
     changed |= ImGui::SliderFloat("Smoothing", &as.smoothing, 0.0f, 0.95f, "%.2f");
     if (ImGui::IsItemHovered())
         ImGui::SetTooltip("0 = no smoothing (raw), 0.95 = very slow response.");
+    static const int s_fftSizes[] = { 1024, 2048, 4096, 8192 };
+    char fftLabel[16];
+    snprintf(fftLabel, sizeof(fftLabel), "%d", as.fftSize);
+    if (ImGui::BeginCombo("FFT Size", fftLabel)) {
+        for (int size : s_fftSizes) {
+            char item[16];
+            snprintf(item, sizeof(item), "%d", size);
+            if (ImGui::Selectable(item, size == as.fftSize)) {
+                as.fftSize = size;
+                changed = true;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Longer = finer bass resolution, slower response.");
+    changed |= ImGui::Checkbox("Multi-resolution", &as.multiResolution);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Highs (above 4 kHz) from a window a quarter as long, so they respond faster.");
+    ImGui::SameLine();
+    changed |= ImGui::Checkbox("Log spectrum", &as.logSpectrum);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Spectrum bins log-spaced 20 Hz-20 kHz instead of linear.");
     if (changed)
         m_app.UpdateAudioSettings();
 
+    bool preAnalysis = m_app.GetConfig().audioPreAnalysis;
+    if (ImGui::Checkbox("Pre-analyse track", &preAnalysis))
+        m_app.SetAudioPreAnalysis(preAnalysis);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Analyse the whole track in the background on open, so seeks and exports\n"
+                          "get exact values at once. Cached per file and DSP settings.");
+    const AudioTimeline& timeline = m_app.GetAudioTimeline();
+    if (timeline.IsBuilding()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("analysing %.0f%%", timeline.GetProgress() * 100.0f);
+    } else if (timeline.IsReady()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled(timeline.IsFromCache() ? "cached" : "ready");
+    }
+
     ImGui::End();
 }
 
-// Enumerate DirectShow video capture devices (webcams, capture cards, virtual cameras).
-static std::vector<std::string> EnumerateCaptureDevices() {
-    std::vector<std::string> devices;
-
-    ICreateDevEnum* devEnum = nullptr;
-    if (FAILED(CoCreateInstance(CLSID_SystemDeviceEnum, nullptr, CLSCTX_INPROC_SERVER,
-                                IID_ICreateDevEnum, reinterpret_cast<void**>(&devEnum))))
-        return devices;
-
-    IEnumMoniker* enumMon = nullptr;
-    HRESULT hr = devEnum->CreateClassEnumerator(CLSID_VideoInputDeviceCategory, &enumMon, 0);
-    devEnum->Release();
-    if (hr != S_OK || !enumMon)
-        return devices;
-
-    IMoniker* moniker = nullptr;
-    while (enumMon->Next(1, &moniker, nullptr) == S_OK) {
-        IPropertyBag* propBag = nullptr;
-        if (SUCCEEDED(moniker->BindToStorage(nullptr, nullptr, IID_IPropertyBag,
-                                             reinterpret_cast<void**>(&propBag)))) {
-            VARIANT var;
-            VariantInit(&var);
-            if (SUCCEEDED(propBag->Read(L"FriendlyName", &var, nullptr)) && var.vt == VT_BSTR) {
-                int len = WideCharToMultiByte(CP_UTF8, 0, var.bstrVal, -1, nullptr, 0, nullptr, nullptr);
-                if (len > 0) {
-                    std::string name(len - 1, '\0');
-                    WideCharToMultiByte(CP_UTF8, 0, var.bstrVal, -1, name.data(), len, nullptr, nullptr);
-                    devices.push_back(std::move(name));
+void UIManager::ShowCaptureDialog() {
+    m_captureDevices = CaptureDevices::Enumerate();
+    m_selectedCaptureIdx = 0;
+    m_captureModesFor    = -1;  // Device indices may have shifted
+    m_showCaptureDialog = true;
+}
+
+void UIManager::DrawDecoderPanel() {
+    ImGui::SetNextWindowSize(ImVec2(360, 470), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Video Decoder", &m_showDecoderPanel)) {
+        ImGui::End();
+        return;
+    }
+
+    auto& decoder = m_app.GetDecoder();
+    AppConfig& cfg = m_app.GetConfig();
+
+    bool hwDecode = cfg.hardwareDecode;
+    if (ImGui::Checkbox("Hardware decode (D3D11VA)", &hwDecode)) {
+        m_app.SetHardwareDecode(hwDecode);
+        m_app.SaveConfig();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Decode on the GPU and sample the decoded surface directly.\n"
+                          "Falls back to software for unsupported codecs/profiles.");
+
+    // What the startup probe found, and the per-codec choice (applies on reopen)
+    const HardwareDecodeCaps& caps = m_app.GetHardwareDecodeCaps();
+    if (ImGui::CollapsingHeader("Hardware decode per codec") &&
+        ImGui::BeginTable("##hwcodecs", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+        static const char* kPolicies[] = { "Auto", "Hardware", "Software" };
+        ImGui::TableSetupColumn("Codec");
+        ImGui::TableSetupColumn("Policy");
+        ImGui::TableSetupColumn("GPU support");
+        ImGui::TableHeadersRow();
+        for (const AVCodecID codec : HardwareDecodeCaps::GetCodecs()) {
+            const std::string name = avcodec_get_name(codec);
+            ImGui::PushID(name.c_str());
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(name.c_str());
+            ImGui::TableNextColumn();
+            const auto it = cfg.hwDecodePolicy.find(name);
+            int policy = (it != cfg.hwDecodePolicy.end()) ? std::clamp(it->second, 0, 2) : 0;
+            ImGui::SetNextItemWidth(-FLT_MIN);
+            if (ImGui::Combo("##policy", &policy, kPolicies, IM_ARRAYSIZE(kPolicies))) {
+                m_app.SetHwDecodePolicy(name, static_cast<HwDecodePolicy>(policy));
+                m_app.SaveConfig();
+            }
+            ImGui::TableNextColumn();
+            if (!caps.IsProbed()) {
+                ImGui::TextDisabled("not probed");
+            }
+            for (const HardwareDecodeCaps::Profile& profile : caps.GetProfiles()) {
+                if (profile.codec != codec) continue;
+                if (profile.supported) {
+                    ImGui::Text("%d-bit up to %dx%d", profile.bitDepth, profile.maxWidth, profile.maxHeight);
+                } else {
+                    ImGui::TextDisabled("%d-bit: no", profile.bitDepth);
                 }
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", profile.label);
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+        ImGui::TextDisabled("Auto: D3D11VA where the GPU takes the profile and size.\n"
+                            "4:2:2/4:4:4 and other codecs decode in software.");
+    }
+
+    bool gpuYuv = cfg.gpuYuvConversion;
+    if (ImGui::Checkbox("GPU YUV conversion", &gpuYuv)) {
+        m_app.SetGpuYuvConversion(gpuYuv);
+        m_app.SaveConfig();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Software decode: upload native 4:2:0/4:2:2/4:4:4 planes and convert to RGB\n"
+                          "in a shader (BT.601/709/2020 from stream metadata) instead of\n"
+                          "sws_scale to RGBA on the CPU.");
+
+    bool videoProcessor = cfg.videoProcessorConversion;
+    ImGui::BeginDisabled(!m_app.GetRenderer().IsVideoProcessorAvailable());
+    if (ImGui::Checkbox("Video processor conversion", &videoProcessor)) {
+        m_app.SetVideoProcessorConversion(videoProcessor);
+        m_app.SaveConfig();
+    }
+    ImGui::EndDisabled();
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+        ImGui::SetTooltip("Hardware decode: convert and scale NV12/P010 surfaces on the GPU's\n"
+                          "fixed-function video engine instead of a shader pass, leaving the\n"
+                          "shader cores to the effect. Falls back to the shader per frame.");
+    if (cfg.videoProcessorConversion && decoder.IsHardwareAccelerated()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled(m_app.GetRenderer().IsVideoProcessorActive() ? "(active)" : "(shader fallback)");
+    }
+
+    bool highBitDepth = cfg.highBitDepth;
+    if (ImGui::Checkbox("High bit depth", &highBitDepth)) {
+        m_app.SetHighBitDepth(highBitDepth);
+        m_app.SaveConfig();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("10/12-bit sources (HEVC Main10, ProRes, P010 surfaces) convert into a\n"
+                          "16-bit video texture, and the display and working targets follow, so\n"
+                          "gradients don't band and 10-bit recordings keep their precision.\n"
+                          "Twice the bandwidth of RGBA8 while such a file plays.");
+    if (cfg.highBitDepth && m_app.GetRenderer().GetDisplayFormat() == DXGI_FORMAT_R16G16B16A16_UNORM) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(16-bit)");
+    }
+
+    // Threading applies on open, so the file is reopened — only on release of the slider
+    static const char* kThreadTypes[] = { "Auto (frame + slice)", "Frame", "Slice" };
+    int threadType = std::clamp(cfg.decodeThreadType, 0, 2);
+    ImGui::SetNextItemWidth(180.0f);
+    if (ImGui::Combo("Threading", &threadType, kThreadTypes, IM_ARRAYSIZE(kThreadTypes))) {
+        m_app.SetDecodeThreading(cfg.decodeThreadCount, threadType);
+        m_app.SaveConfig();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Frame threading scales long-GOP codecs (H.264/HEVC) at a few frames\n"
+                          "of latency; slice threading suits intra codecs (ProRes, DNxHR).");
+    int threadCount = cfg.decodeThreadCount;
+    ImGui::SetNextItemWidth(180.0f);
+    ImGui::SliderInt("Threads", &threadCount, 0, 64, threadCount == 0 ? "Auto" : "%d");
+    cfg.decodeThreadCount = threadCount;
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        m_app.SetDecodeThreading(cfg.decodeThreadCount, cfg.decodeThreadType);
+        m_app.SaveConfig();
+    }
+
+    // Proxy playback applies on open, so the file is reopened
+    static const char* kProxyScales[] = { "Off (full size)", "Half", "Quarter" };
+    int proxyIdx = (cfg.proxyScale >= 4) ? 2 : (cfg.proxyScale >= 2) ? 1 : 0;
+    ImGui::SetNextItemWidth(180.0f);
+    if (ImGui::Combo("Proxy", &proxyIdx, kProxyScales, IM_ARRAYSIZE(kProxyScales))) {
+        m_app.SetProxyScale(1 << proxyIdx);
+        m_app.SaveConfig();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Decode and run the shader at reduced size for heavy sources\n"
+                          "(6K/8K). Codecs with lowres support (MJPEG, JPEG 2000) decode\n"
+                          "small; others are downscaled on conversion. Recording switches\n"
+                          "back to full size.");
+    if (decoder.IsOpen() && decoder.GetProxyScale() > 1 && !decoder.IsLiveCapture()) {
+        ImGui::TextDisabled("Proxy %dx%d of %dx%d%s", decoder.GetWidth(), decoder.GetHeight(),
+                            decoder.GetSourceWidth(), decoder.GetSourceHeight(),
+                            decoder.GetLowresLevel() > 0 ? " (lowres decode)" : "");
+    }
+
+    bool editProxies = cfg.editProxies;
+    if (ImGui::Checkbox("Edit proxies", &editProxies)) {
+        m_app.SetEditProxies(editProxies);
+        m_app.SaveConfig();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Transcode long-GOP files (H.264/HEVC) to intra-only ProRes Proxy\n"
+                          "at half size in the background, then play and scrub that instead.\n"
+                          "Recording still reads the original.");
+    const ProxyTranscoder& transcoder = m_app.GetProxyTranscoder();
+    if (transcoder.IsRunning()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("building %.0f%%", transcoder.GetProgress() * 100.0f);
+    } else if (m_app.IsUsingEditProxy()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("playing proxy");
+    }
+
+    // Image sequences also apply on open
+    float sequenceFps = static_cast<float>(cfg.imageSequenceFps);
+    ImGui::SetNextItemWidth(180.0f);
+    ImGui::DragFloat("Sequence fps", &sequenceFps, 0.1f, 1.0f, 240.0f, "%.3f");
+    cfg.imageSequenceFps = sequenceFps;
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        m_app.SetImageSequenceOptions(cfg.imageSequenceFps, cfg.imageSequenceCacheMB);
+        m_app.SaveConfig();
+    }
+    int sequenceCacheMB = cfg.imageSequenceCacheMB;
+    ImGui::SetNextItemWidth(180.0f);
+    ImGui::SliderInt("Sequence RAM cache (MB)", &sequenceCacheMB, 0, 32768, sequenceCacheMB == 0 ? "Off" : "%d");
+    cfg.imageSequenceCacheMB = sequenceCacheMB;
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        m_app.SetImageSequenceOptions(cfg.imageSequenceFps, cfg.imageSequenceCacheMB);
+        m_app.SaveConfig();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Opening one numbered still (frame_0001.exr) plays the whole\n"
+                          "sequence, decoded in parallel. Sequences that fit this budget\n"
+                          "stay decoded in RAM, so loops replay without touching the disk.");
+    if (const ImageSequence* sequence = decoder.GetImageSequence()) {
+        ImGui::TextDisabled("Sequence: %lld frames, %d workers, %lld decoded%s",
+                            static_cast<long long>(sequence->GetFrameCount()), sequence->GetWorkerCount(),
+                            static_cast<long long>(sequence->GetResidentFrames()),
+                            sequence->IsRamCached() ? " (RAM-cached)" : "");
+    }
+
+    int cacheMB = cfg.scrubCacheMB;
+    ImGui::SetNextItemWidth(180.0f);
+    ImGui::SliderInt("Scrub cache (MB)", &cacheMB, 0, 8192, cacheMB == 0 ? "Off" : "%d");
+    cfg.scrubCacheMB = cacheMB;
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        m_app.SetScrubCacheBudget(cfg.scrubCacheMB);
+        m_app.SaveConfig();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("VRAM for recently shown frames. Seeking to a cached frame\n"
+                          "skips seek + decode entirely (scrubbing, short loops).");
+
+    int loopMB = cfg.loopCacheMB;
+    ImGui::SetNextItemWidth(180.0f);
+    ImGui::SliderInt("Loop cache (MB)", &loopMB, 0, 16384, loopMB == 0 ? "Off" : "%d");
+    cfg.loopCacheMB = loopMB;
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        m_app.SetLoopCacheBudget(cfg.loopCacheMB);
+        m_app.SaveConfig();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("VRAM for the whole A/B loop region (transport [ ]). A region\n"
+                          "that fits replays from VRAM after its first pass, with no decoding.");
+
+    int aheadFrames = cfg.renderAheadFrames;
+    ImGui::SetNextItemWidth(180.0f);
+    ImGui::SliderInt("Render-ahead (frames)", &aheadFrames, 0, 8, aheadFrames == 0 ? "Off" : "%d");
+    if (aheadFrames != cfg.renderAheadFrames) m_app.SetRenderAheadFrames(aheadFrames);
+    if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SaveConfig();
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Forward file playback renders this many frames ahead of the\n"
+                          "playhead and shows each at its time, so a slow frame or a shader\n"
+                          "compile doesn't drop (kiosk loops, playout). Param changes\n"
+                          "redraw the queued frames. VRAM per frame: the video plus the output.");
+
+    // Probe budget applies to the next open; no reopen needed
+    ImGui::SetNextItemWidth(180.0f);
+    ImGui::SliderInt("Probe size (KB)", &cfg.probeSizeKB, 32, 16384);
+    if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SaveConfig();
+    ImGui::SetNextItemWidth(180.0f);
+    ImGui::SliderInt("Analyze (ms)", &cfg.analyzeDurationMs, 100, 10000);
+    if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SaveConfig();
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("How much of a file is read to identify its streams before the\n"
+                          "first frame. Smaller opens faster; too small is retried larger.");
+    ImGui::SetNextItemWidth(180.0f);
+    ImGui::SliderInt("Read-ahead (MB)", &cfg.ioReadAheadMB, 0, 256, cfg.ioReadAheadMB == 0 ? "Off" : "%d");
+    if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SaveConfig();
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Window read ahead of the demuxer in 4 MB blocks for files on\n"
+                          "network shares and removable drives. Local disks are memory-\n"
+                          "mapped instead. Applies to the next open.");
+
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    if (decoder.IsOpen()) {
+        ImGui::Text("Codec:  %s", decoder.GetCodecName().c_str());
+        ImGui::Text("Path:   ");
+        ImGui::SameLine(0.0f, 0.0f);
+        if (decoder.IsHardwareAccelerated())
+            ImGui::TextColored(ImVec4(0.3f, 1.0f, 0.3f, 1.0f), "D3D11VA (zero-copy)");
+        else if (decoder.IsGpuYuvFrame())
+            ImGui::TextDisabled("Software + GPU YUV");
+        else if (decoder.IsPassthroughFrame())
+            ImGui::TextDisabled("Software (packed RGB, no sws_scale)");
+        else
+            ImGui::TextDisabled("Software (sws_scale RGBA)");
+        const VideoDecoder::HwStatus hwStatus = decoder.GetHardwareStatus();
+        if (cfg.hardwareDecode && hwStatus != VideoDecoder::HwStatus::Hardware &&
+            hwStatus != VideoDecoder::HwStatus::Software) {
+            const ImVec4 color = (hwStatus == VideoDecoder::HwStatus::FellBack)
+                ? ImVec4(1.0f, 0.7f, 0.2f, 1.0f) : ImVec4(0.6f, 0.6f, 0.6f, 1.0f);
+            ImGui::TextColored(color, "        %s", VideoDecoder::GetHardwareStatusName(hwStatus));
+            if (hwStatus == VideoDecoder::HwStatus::FellBack && ImGui::IsItemHovered()) {
+                char error[AV_ERROR_MAX_STRING_SIZE] = {};
+                av_make_error_string(error, sizeof(error), decoder.GetHardwareFallbackError());
+                ImGui::SetTooltip("%s", error);
+            }
+        }
+        ImGui::Text("Threads: %d (%s)", decoder.GetActiveThreadCount(), decoder.GetActiveThreadTypeName());
+
+        if (const MediaIO* io = decoder.GetIO()) {
+            const char* mode = io->IsMemoryMapped() ? "mapped" : io->IsReadAhead() ? "read-ahead" : "direct";
+            ImGui::Text("I/O:    %s, %.0f MB/s, stalled %.0f ms", mode, io->GetThroughputMBps(), io->GetStallMs());
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("%.1f / %.1f MB read. MB/s is file-to-memory speed while\n"
+                                  "reading; stalled = time the demuxer waited on the file.",
+                                  static_cast<double>(io->GetBytesRead()) / (1024.0 * 1024.0),
+                                  static_cast<double>(io->GetFileSize()) / (1024.0 * 1024.0));
+        } else {
+            ImGui::TextDisabled("I/O:    FFmpeg protocol");
+        }
+
+        const SeekIndex& index = decoder.GetSeekIndex();
+        if (decoder.IsIntraOnly()) {
+            ImGui::TextDisabled("Seek:   intra-only (every frame is a keyframe)");
+        } else if (index.IsReady()) {
+            ImGui::Text("Seek:   %lld frames, %lld keyframes%s",
+                static_cast<long long>(index.GetFrameCount()),
+                static_cast<long long>(index.GetKeyframeCount()),
+                index.IsFromCache() ? " (cached)" : "");
+        } else if (index.IsBuilding()) {
+            ImGui::Text("Seek:   indexing %.0f%%", index.GetProgress() * 100.0f);
+        } else {
+            ImGui::TextDisabled("Seek:   no index (demuxer seek)");
+        }
+
+        const ScrubCache& cache = m_app.GetRenderer().GetScrubCache();
+        const int64_t lookups = cache.GetHits() + cache.GetMisses();
+        ImGui::Text("Cache:  %d frames, %.0f / %d MB",
+            cache.GetEntryCount(),
+            static_cast<double>(cache.GetUsedBytes()) / (1024.0 * 1024.0),
+            cache.GetBudgetMB());
+        ImGui::Text("        %lld hits, %lld misses (%.0f%% hit)",
+            static_cast<long long>(cache.GetHits()),
+            static_cast<long long>(cache.GetMisses()),
+            lookups > 0 ? 100.0 * static_cast<double>(cache.GetHits()) / static_cast<double>(lookups) : 0.0);
+        const ShaderPreset* active = m_app.GetShaderManager().GetActivePreset();
+        ImGui::Text("Redraw: %s, %lld idle frames skipped",
+            (active && active->isTimeVarying) ? "every frame" : "on change",
+            static_cast<long long>(m_app.GetRenderer().GetSkippedRedraws()));
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Shaders that don't read time or audio are only redrawn when\n"
+                              "the video frame, a parameter or an input changes.");
+
+        // Decoder-bound when the average decode time exceeds the frame interval
+        const float avgMs    = decoder.GetAverageDecodeMs();
+        const float budgetMs = decoder.GetFPS() > 0.0 ? static_cast<float>(1000.0 / decoder.GetFPS()) : 0.0f;
+        const ImVec4 decodeColor = (budgetMs > 0.0f && avgMs > budgetMs)
+            ? ImVec4(1.0f, 0.4f, 0.3f, 1.0f) : ImGui::GetStyleColorVec4(ImGuiCol_Text);
+        ImGui::TextColored(decodeColor, "Decode: %.2f ms/frame (last %.2f, budget %.2f)",
+                           avgMs, decoder.GetLastDecodeMs(), budgetMs);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Wall time per decoded frame (demux + decode + conversion).\n"
+                              "Red = the decoder cannot keep up with the source frame rate.");
+
+        const DecodeWorker& worker = m_app.GetDecodeWorker();
+        if (worker.IsRunning()) {
+            ImGui::Spacing();
+            const int depth = worker.GetQueueDepth();
+            const int cap   = worker.GetQueueCapacity();
+            char depthLabel[32];
+            snprintf(depthLabel, sizeof(depthLabel), "%d / %d", depth, cap);
+            ImGui::Text("Queue:  ");
+            ImGui::SameLine(0.0f, 0.0f);
+            ImGui::ProgressBar(static_cast<float>(depth) / static_cast<float>(cap), ImVec2(-1, 0), depthLabel);
+            if (worker.IsLive()) {
+                ImGui::Text("Decoded: %lld   Dropped: %lld   Latency: %.0f ms",
+                    static_cast<long long>(worker.GetFramesDecoded()),
+                    static_cast<long long>(worker.GetLiveDrops()),
+                    m_app.GetLiveLatencyMs());
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Live mailbox: only the newest frame is kept. Dropped = replaced\n"
+                                      "before it was shown. Latency = packet read to present.");
+            } else {
+                ImGui::Text("Decoded: %lld   Underruns: %lld",
+                    static_cast<long long>(worker.GetFramesDecoded()),
+                    static_cast<long long>(worker.GetUnderruns()));
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Underrun = a frame was due but the decode queue was empty.");
+                const Application::CadenceStats& cadence = m_app.GetCadenceStats();
+                ImGui::Text("Cadence: %lld / %lld / %lld / %lld   Error: %.1f ms (max %.1f)",
+                    static_cast<long long>(cadence.held[0]), static_cast<long long>(cadence.held[1]),
+                    static_cast<long long>(cadence.held[2]), static_cast<long long>(cadence.held[3]),
+                    cadence.meanErrorMs, cadence.maxErrorMs);
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("Frames on screen for 1 / 2 / 3 / 4+ ticks. A steady pattern (all 1s at\n"
+                                      "matching rates, 2s and 3s for 24 fps at 60 Hz) is smooth playback.\n"
+                                      "Error = how far from its due time each frame was selected.");
             }
-            VariantClear(&var);
-            propBag->Release();
         }
-        moniker->Release();
+    } else if (m_app.IsOpeningVideo()) {
+        ImGui::Text("Opening %s...", std::filesystem::path(m_app.GetOpeningPath()).filename().string().c_str());
+    } else {
+        ImGui::TextDisabled("No video loaded");
     }
-    enumMon->Release();
-    return devices;
+
+    ImGui::End();
 }
 
-void UIManager::ShowCaptureDialog() {
-    m_captureDevices = EnumerateCaptureDevices();
-    m_selectedCaptureIdx = 0;
-    m_showCaptureDialog = true;
+void UIManager::DrawGpuProfiler() {
+    // Overlay in the top-right corner of the main viewport until the user moves it
+    const ImGuiViewport* viewport = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + viewport->WorkSize.x - 10, viewport->WorkPos.y + 30),
+                            ImGuiCond_FirstUseEver, ImVec2(1.0f, 0.0f));
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    if (!ImGui::Begin("GPU Profiler", &m_showGpuProfiler,
+                      ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing)) {
+        ImGui::End();
+        return;
+    }
+
+    GpuProfiler& profiler = m_app.GetRenderer().GetGpuProfiler();
+    bool enabled = profiler.IsEnabled();
+    if (ImGui::Checkbox("Record", &enabled)) profiler.SetEnabled(enabled);
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) profiler.Reset();
+
+    // Driven by the Shader stage above, so it holds still while Record is off
+    AppConfig& cfg = m_app.GetConfig();
+    ImGui::Checkbox("Dynamic resolution", &cfg.dynamicResolution);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Render the shader at a lower resolution when its GPU time is over the target,\n"
+                          "upscaled with the Upscaler below. Recording and export always render full size.");
+    ImGui::Checkbox("Preview at viewport size", &cfg.previewAtViewportSize);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("With no recording, output window or Spout, render the shader at the size\n"
+                          "the Video viewport shows it. Shaders in pixel coordinates see a smaller grid.");
+    if (cfg.dynamicResolution) {
+        const float scale = m_app.GetRenderer().GetRenderScale();
+        ImGui::SameLine();
+        ImGui::TextDisabled("%d%%", static_cast<int>(scale * 100.0f + 0.5f));
+        ImGui::SetNextItemWidth(140.0f);
+        ImGui::SliderFloat("Target (ms)", &cfg.dynamicResolutionTargetMs, 2.0f, 33.0f, "%.1f");
+        ImGui::SetNextItemWidth(140.0f);
+        ImGui::SliderFloat("Min scale", &cfg.dynamicResolutionMinScale, DynamicResolution::MIN_SCALE, 1.0f, "%.2f");
+    }
+    ImGui::SetNextItemWidth(140.0f);
+    ImGui::Combo("Upscaler", &cfg.upscaleFilter, "Bicubic\0Lanczos\0Edge-adaptive\0\0");
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Filter of every upscale: a reduced-resolution render, the viewport preview,\n"
+                          "recordings and output windows larger than the render. Edge-adaptive keeps\n"
+                          "edges crisp (FSR1-style) and costs two passes; Lanczos is sharper than bicubic.");
+    if (cfg.upscaleFilter == UPSCALE_EDGE_ADAPTIVE) {
+        ImGui::SetNextItemWidth(140.0f);
+        ImGui::SliderFloat("Sharpness", &cfg.upscaleSharpness, 0.0f, 1.0f, "%.2f");
+    }
+
+    // Tiled rendering: live tiles for heavy canvases, and stills past the texture limit
+    ImGui::SetNextItemWidth(140.0f);
+    ImGui::InputInt("Tile size", &cfg.renderTileSize, 256, 1024);
+    cfg.renderTileSize = cfg.renderTileSize > 0 ? std::clamp(cfg.renderTileSize, D3D11Renderer::MIN_TILE_SIZE,
+                                                             D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION) : 0;
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Draw the shader in scissored tiles of this size, each submitted on its own,\n"
+                          "so a heavy shader on a large canvas doesn't stall the GPU. 0 = off.");
+    if (cfg.renderTileSize > 0) {
+        ImGui::SetNextItemWidth(140.0f);
+        ImGui::InputInt("Tiles per frame", &cfg.renderTilesPerFrame);
+        cfg.renderTilesPerFrame = std::max(cfg.renderTilesPerFrame, 0);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Spread a single-pass shader's tiles over several frames; the output updates\n"
+                              "once all are drawn. 0 = every tile every frame. Not while recording.");
+        const D3D11Renderer& renderer = m_app.GetRenderer();
+        ImGui::SameLine();
+        if (renderer.GetSweepProgress() > 0) {
+            ImGui::TextDisabled("%d / %d", renderer.GetSweepProgress(), renderer.GetTileCount());
+        } else {
+            ImGui::TextDisabled("%d tiles", renderer.GetTileCount());
+        }
+    }
+    static int s_stillWidth  = 30720;
+    static int s_stillHeight = 4320;
+    ImGui::SetNextItemWidth(140.0f);
+    ImGui::DragInt("##stillW", &s_stillWidth, 16.0f, 1, D3D11Renderer::MAX_CANVAS_SIZE, "W %d");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(140.0f);
+    ImGui::DragInt("##stillH", &s_stillHeight, 16.0f, 1, D3D11Renderer::MAX_CANVAS_SIZE, "H %d");
+    ImGui::SameLine();
+    if (m_app.IsExportingTiles()) {
+        ImGui::ProgressBar(m_app.GetTiledExportProgress(), ImVec2(120.0f, 0.0f));
+    } else if (ImGui::Button("Export tiled still...")) {
+        m_app.ExportTiledStillDialog(s_stillWidth, s_stillHeight,
+                                     cfg.renderTileSize > 0 ? cfg.renderTileSize : DEFAULT_STILL_TILE_SIZE);
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Render the active shader at this size one tile per frame and write the tiles\n"
+                          "as images, with a _tiles.json of their positions. Single-pass shaders only.");
+
+    // Textures released by a resize, kept for the next one of the same size
+    const RenderTargetPool& pool = m_app.GetRenderer().GetTargetPool();
+    ImGui::TextDisabled("Recycled targets: %d, %.1f MB | %lld reused", pool.GetRecycledCount(),
+                        pool.GetRecycledBytes() / (1024.0 * 1024.0), static_cast<long long>(pool.GetReuses()));
+
+    // Thumbnails, prewarm and LUT bakes, in the slack after Present
+    const BackgroundGpuWork& background = m_app.GetBackgroundWork();
+    ImGui::SetNextItemWidth(140.0f);
+    ImGui::SliderFloat("Background (ms)", &cfg.backgroundGpuBudgetMs, 0.25f, 8.0f, "%.2f");
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("GPU time a frame may give thumbnails, shader prewarm and LUT bakes after it is\n"
+                          "presented. Skipped while the last frames left less than this to spare.");
+    ImGui::SameLine();
+    ImGui::TextDisabled("%.2f ms | %lld deferred", background.GetLastFrameGpuMs(),
+                        static_cast<long long>(background.GetDeferredFrames()));
+    for (const BackgroundGpuWork::TaskStats& task : background.GetTasks()) {
+        if (task.steps == 0) continue;
+        ImGui::TextDisabled("  %s: %lld steps, %.3f ms avg", task.name, static_cast<long long>(task.steps),
+                            task.avgGpuMs);
+    }
+
+    GpuProfiler::Snapshot& snapshot = m_gpuSnapshot;
+    profiler.GetSnapshot(snapshot, &m_app.GetFrameArena());
+    if (snapshot.totalMs.empty()) {
+        ImGui::TextDisabled("No frames yet");
+        ImGui::End();
+        return;
+    }
+
+    if (ImGui::BeginTable("##gpuStages", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                                                ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Stage (ms)", ImGuiTableColumnFlags_WidthFixed, 110.0f);
+        ImGui::TableSetupColumn("Last", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+        ImGui::TableSetupColumn("Avg", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+        ImGui::TableSetupColumn("Max", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+        ImGui::TableHeadersRow();
+        auto row = [](const char* name, const GpuProfiler::StageStats& stats) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0); ImGui::TextUnformatted(name);
+            ImGui::TableSetColumnIndex(1); ImGui::Text("%.2f", stats.lastMs);
+            ImGui::TableSetColumnIndex(2); ImGui::Text("%.2f", stats.avgMs);
+            ImGui::TableSetColumnIndex(3); ImGui::Text("%.2f", stats.maxMs);
+        };
+        for (int i = 0; i < GPU_STAGE_COUNT; ++i) {
+            // Stages that never ran in the window (no compositor, no output window...) stay hidden
+            if (snapshot.stages[i].maxMs <= 0.0f) continue;
+            row(GpuProfiler::StageName(static_cast<GpuStage>(i)), snapshot.stages[i]);
+        }
+        row("Frame", snapshot.total);
+        ImGui::EndTable();
+    }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Frame = first to last GPU timestamp of the tick, gaps included.\n"
+                          "Read back %d frames late; averages over the last %d frames.",
+                          GpuProfiler::FRAME_LATENCY, GpuProfiler::HISTORY_SIZE);
+
+    // Last GpuProfiler::HISTORY_SIZE frames, oldest on the left
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), "GPU %.2f ms", snapshot.totalMs.back());
+    ImGui::PlotLines("##gpuTotal", snapshot.totalMs.data(), static_cast<int>(snapshot.totalMs.size()), 0,
+                     overlay, 0.0f, FLT_MAX, ImVec2(280, 60));
+    if (snapshot.skipped > 0) {
+        ImGui::TextDisabled("Skipped %lld frames (disjoint or late)", static_cast<long long>(snapshot.skipped));
+    }
+
+    ImGui::End();
+}
+
+void UIManager::DrawFrameTiming() {
+    ImGui::SetNextWindowSize(ImVec2(380, 560), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Frame Timing", &m_showFrameTiming)) {
+        ImGui::End();
+        return;
+    }
+
+    // Prometheus endpoint: the numbers below, for a scraper
+    {
+        AppConfig& cfg = m_app.GetConfig();
+        const MetricsServer& metrics = m_app.GetMetricsServer();
+        bool serve = metrics.IsRunning();
+        if (ImGui::Checkbox("Metrics", &serve)) m_app.SetMetricsServer(serve, cfg.metricsPort);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Serve Prometheus metrics on http://<this machine>:%d/metrics", cfg.metricsPort);
+        ImGui::SameLine();
+        int port = cfg.metricsPort;
+        ImGui::SetNextItemWidth(100.0f);
+        if (ImGui::InputInt("TCP port", &port, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue))
+            m_app.SetMetricsServer(metrics.IsRunning(), port);
+        if (metrics.IsRunning()) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("%lld scrapes", static_cast<long long>(metrics.GetScrapes()));
+        }
+    }
+
+    // Frame-stall watchdog: the step it took, its settings and what it reported
+    if (ImGui::CollapsingHeader("Watchdog")) {
+        AppConfig& cfg = m_app.GetConfig();
+        const FrameWatchdog& watchdog = m_app.GetWatchdog();
+        bool enabled = watchdog.IsRunning();
+        if (ImGui::Checkbox("Step down on stalls", &enabled)) m_app.SetWatchdog(enabled);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Render at a quarter scale, then reset the shader's params, then switch to\n"
+                              "passthrough while the loop or the GPU stalls. Reports go to watchdog.log.");
+        ImGui::SetNextItemWidth(120.0f);
+        if (ImGui::InputInt("Stall (ms)", &cfg.watchdogStallMs, 100, 500, ImGuiInputTextFlags_EnterReturnsTrue))
+            m_app.ApplyWatchdogSettings();
+        ImGui::SetNextItemWidth(120.0f);
+        if (ImGui::InputFloat("GPU limit (ms)", &cfg.watchdogGpuMs, 10.0f, 50.0f, "%.0f",
+                              ImGuiInputTextFlags_EnterReturnsTrue))
+            m_app.ApplyWatchdogSettings();
+
+        const WatchdogLevel level = m_app.GetWatchdogLevel();
+        ImGui::Text("Level: %s", FrameWatchdog::LevelName(level));
+        ImGui::SameLine();
+        ImGui::TextDisabled("(%lld stalls)", static_cast<long long>(watchdog.GetStalls()));
+        if (level != WatchdogLevel::Normal) {
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Restore")) m_app.ResetWatchdog();
+        }
+        watchdog.GetEvents(m_watchdogEvents);
+        for (auto it = m_watchdogEvents.rbegin(); it != m_watchdogEvents.rend(); ++it)
+            ImGui::TextDisabled("%8.1f s  %s", it->time, it->text.c_str());
+    }
+
+    CpuProfiler& profiler = m_app.GetCpuProfiler();
+    CpuProfiler::Snapshot& snapshot = m_cpuSnapshot;
+    profiler.GetSnapshot(snapshot, &m_app.GetFrameArena());
+    if (ImGui::Button("Reset")) profiler.Reset();
+    if (snapshot.frameMs.empty()) {
+        ImGui::TextDisabled("No frames yet");
+        ImGui::End();
+        return;
+    }
+    ImGui::SameLine();
+    ImGui::Text("p50 %.2f   p99 %.2f   max %.2f ms", snapshot.p50Ms, snapshot.p99Ms, snapshot.maxMs);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Wall time per main-loop tick over the last %d ticks.", CpuProfiler::HISTORY_SIZE);
+
+    if (ImGui::BeginTable("##cpuStages", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                                                ImGuiTableFlags_SizingStretchSame)) {
+        ImGui::TableSetupColumn("Stage (ms)");
+        ImGui::TableSetupColumn("Last");
+        ImGui::TableSetupColumn("Avg");
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < CPU_STAGE_COUNT; ++i) {
+            const CpuProfiler::StageStats& stats = snapshot.stages[i];
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(CpuProfiler::StageName(static_cast<CpuStage>(i)));
+            ImGui::TableSetColumnIndex(1); ImGui::Text("%.2f", stats.lastMs);
+            ImGui::TableSetColumnIndex(2); ImGui::Text("%.2f", stats.avgMs);
+            ImGui::TableSetColumnIndex(3); ImGui::Text("%.2f", stats.maxMs);
+        }
+        ImGui::EndTable();
+    }
+    // Demux, decode and ConvertFrame run on the decode thread, off this loop
+    if (m_app.GetDecoder().IsOpen())
+        ImGui::TextDisabled("Decode thread: %.2f ms/frame", m_app.GetDecoder().GetAverageDecodeMs());
+
+    // operator new calls (HeapStats): the main thread's per tick, and every thread's per second
+    const auto now = std::chrono::steady_clock::now();
+    const double sampleSeconds = std::chrono::duration<double>(now - m_heapSampleTime).count();
+    if (sampleSeconds >= 1.0) {
+        const HeapCounters heap = GetProcessHeapCounters();
+        if (m_heapSampleTime != std::chrono::steady_clock::time_point{})
+            m_heapRate = (heap.allocations - m_heapSample.allocations) / sampleSeconds;
+        m_heapSample     = heap;
+        m_heapSampleTime = now;
+    }
+    const CpuProfiler::AllocationStats& allocations = snapshot.allocations;
+    ImGui::Text("Allocations/tick: %lld (%lld B)   avg %.1f   max %lld", static_cast<long long>(allocations.last),
+                static_cast<long long>(allocations.lastBytes), allocations.avg, static_cast<long long>(allocations.max));
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("operator new calls on the main thread per tick. Steady-state playback should\n"
+                          "make none; FFmpeg, ImGui and the driver allocate outside these counts.");
+    const FrameArena& arena = m_app.GetFrameArena();
+    ImGui::TextDisabled("All threads: %.0f allocs/s | Frame arena: %.1f KB peak of %.1f KB", m_heapRate,
+                        arena.GetHighWaterBytes() / 1024.0, arena.GetCapacityBytes() / 1024.0);
+
+    // Last CpuProfiler::HISTORY_SIZE ticks, oldest on the left
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), "Frame %.2f ms", snapshot.frameMs.back());
+    ImGui::PlotLines("##cpuFrame", snapshot.frameMs.data(), static_cast<int>(snapshot.frameMs.size()), 0,
+                     overlay, 0.0f, FLT_MAX, ImVec2(-1, 60));
+    ImGui::PlotHistogram("##cpuHistogram", snapshot.histogram.data(), CpuProfiler::HISTOGRAM_BINS, 0,
+                         "Frame time, 1 ms buckets", 0.0f, FLT_MAX, ImVec2(-1, 60));
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Ticks per 1 ms bucket, 0 ms to %d ms and over.", CpuProfiler::HISTOGRAM_BINS - 1);
+
+    ImGui::SeparatorText("Hitches");
+    if (snapshot.hitches.empty()) {
+        ImGui::TextDisabled("None");
+    } else if (ImGui::BeginTable("##cpuHitches", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                                                        ImGuiTableFlags_ScrollY, ImVec2(0, 140))) {
+        ImGui::TableSetupColumn("At (s)");
+        ImGui::TableSetupColumn("Frame ms");
+        ImGui::TableSetupColumn("Typical");
+        ImGui::TableSetupColumn("Worst stage");
+        ImGui::TableHeadersRow();
+        for (const CpuHitch& hitch : snapshot.hitches) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0); ImGui::Text("%.1f", hitch.time);
+            ImGui::TableSetColumnIndex(1); ImGui::Text("%.1f", hitch.frameMs);
+            ImGui::TableSetColumnIndex(2); ImGui::Text("%.1f", hitch.baselineMs);
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%s %.1f", CpuProfiler::StageName(hitch.worstStage), hitch.worstMs);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void UIManager::DrawMemoryPanel() {
+    ImGui::SetNextWindowSize(ImVec2(380, 440), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Memory", &m_showMemoryPanel)) {
+        ImGui::End();
+        return;
+    }
+    auto mb = [](uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+    const ProcessMemory process = QueryProcessMemory();
+    ImGui::Text("Process: %.0f MB private, %.0f MB working set", mb(process.privateBytes), mb(process.workingSet));
+    const VideoMemoryInfo video = m_app.GetRenderer().QueryVideoMemory();
+    if (video.localBudget > 0) {
+        const float fill = static_cast<float>(static_cast<double>(video.localUsage) / video.localBudget);
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "VRAM %.0f / %.0f MB", mb(video.localUsage), mb(video.localBudget));
+        ImGui::ProgressBar(std::min(fill, 1.0f), ImVec2(-1, 0), overlay);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Local video memory this process uses against the budget the OS grants it.\n"
+                              "Shared (non-local): %.0f / %.0f MB", mb(video.nonLocalUsage), mb(video.nonLocalBudget));
+    } else {
+        ImGui::TextDisabled("Video memory budget not reported by this adapter");
+    }
+    if (m_app.IsUnderMemoryPressure())
+        ImGui::TextColored(ImVec4(0.9f, 0.6f, 0.2f, 1.0f), "Over budget: scrub and loop caches shrunk");
+
+    m_memoryUsage.clear();
+    m_app.GetMemoryUsage(m_memoryUsage);
+    if (ImGui::BeginTable("##memory", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                                             ImGuiTableFlags_SizingStretchProp)) {
+        ImGui::TableSetupColumn("Subsystem", ImGuiTableColumnFlags_WidthStretch, 2.0f);
+        ImGui::TableSetupColumn("CPU MB");
+        ImGui::TableSetupColumn("GPU MB");
+        ImGui::TableHeadersRow();
+        uint64_t cpu = 0, gpu = 0;
+        for (const MemoryUsage& usage : m_memoryUsage) {
+            cpu += usage.cpuBytes;
+            gpu += usage.gpuBytes;
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0); ImGui::TextUnformatted(usage.name);
+            ImGui::TableSetColumnIndex(1);
+            if (usage.cpuBytes) ImGui::Text("%.1f", mb(usage.cpuBytes)); else ImGui::TextDisabled("-");
+            ImGui::TableSetColumnIndex(2);
+            if (usage.gpuBytes) ImGui::Text("%.1f", mb(usage.gpuBytes)); else ImGui::TextDisabled("-");
+        }
+        ImGui::TableNextRow();
+        ImGui::TableSetColumnIndex(0); ImGui::TextUnformatted("Total");
+        ImGui::TableSetColumnIndex(1); ImGui::Text("%.1f", mb(cpu));
+        ImGui::TableSetColumnIndex(2); ImGui::Text("%.1f", mb(gpu));
+        ImGui::EndTable();
+    }
+    ImGui::TextDisabled("Counted by each subsystem; textures and buffers outside these are not listed.");
+
+    ImGui::End();
 }
 
 void UIManager::DrawCaptureDialog() {
@@ -2307,10 +5037,49 @@ void UIManager::DrawCaptureDialog() {
             ImGui::EndListBox();
         }
 
+        // Modes are read from the driver once per selected device
+        if (m_captureModesFor != m_selectedCaptureIdx &&
+            m_selectedCaptureIdx < static_cast<int>(m_captureDevices.size())) {
+            m_captureModes        = CaptureDevices::EnumerateModes(m_captureDevices[m_selectedCaptureIdx]);
+            m_captureModesFor     = m_selectedCaptureIdx;
+            m_selectedCaptureMode = -1;
+        }
+
+        const CaptureMode* best = CaptureDevices::PickBest(m_captureModes);
+        const std::string autoLabel = best ? "Auto (" + best->label + ")" : std::string("Auto (device default)");
+        const char* preview = (m_selectedCaptureMode >= 0 && m_selectedCaptureMode < static_cast<int>(m_captureModes.size()))
+                            ? m_captureModes[m_selectedCaptureMode].label.c_str() : autoLabel.c_str();
+        ImGui::SetNextItemWidth(-1);
+        if (ImGui::BeginCombo("##captureMode", preview)) {
+            if (ImGui::Selectable(autoLabel.c_str(), m_selectedCaptureMode < 0))
+                m_selectedCaptureMode = -1;
+            for (int i = 0; i < static_cast<int>(m_captureModes.size()); ++i) {
+                ImGui::PushID(i);
+                if (ImGui::Selectable(m_captureModes[i].label.c_str(), m_selectedCaptureMode == i))
+                    m_selectedCaptureMode = i;
+                ImGui::PopID();
+            }
+            ImGui::EndCombo();
+        }
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Mode the device is opened in. NV12, YUY2, UYVY and I420 are\n"
+                              "uploaded as-is and converted on the GPU; MJPEG is decoded first.");
+
+        AppConfig& cfg = m_app.GetConfig();
+        if (ImGui::Checkbox("Media Foundation (GPU frames)", &cfg.mediaFoundationCapture))
+            m_app.SaveConfig();
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Capture through Media Foundation: frames arrive as D3D11 textures,\n"
+                              "converted (and MJPEG decoded, where the GPU can) by its video processor.\n"
+                              "Falls back to DirectShow when the device won't open.");
+
         ImGui::Spacing();
         if (ImGui::Button("Open Device", ImVec2(120, 0))) {
             if (m_selectedCaptureIdx < static_cast<int>(m_captureDevices.size())) {
-                m_app.OpenCapture(m_captureDevices[m_selectedCaptureIdx], true);
+                const CaptureMode* mode = (m_selectedCaptureMode >= 0 &&
+                                           m_selectedCaptureMode < static_cast<int>(m_captureModes.size()))
+                                        ? &m_captureModes[m_selectedCaptureMode] : nullptr;
+                m_app.OpenCapture(m_captureDevices[m_selectedCaptureIdx], true, mode);
                 m_showCaptureDialog = false;
                 s_wasOpen = false;
                 ImGui::CloseCurrentPopup();
@@ -2320,7 +5089,7 @@ void UIManager::DrawCaptureDialog() {
 
     // ── Stream URL section ───────────────────────────────────────────────────
     ImGui::Spacing();
-    ImGui::SeparatorText("Stream URL (RTSP / RTMP / HTTP)");
+    ImGui::SeparatorText("Stream URL (RTSP / SRT / RTMP / HTTP)");
     ImGui::Spacing();
 
     ImGui::SetNextItemWidth(-1);
@@ -2328,9 +5097,28 @@ void UIManager::DrawCaptureDialog() {
                      ImGuiInputTextFlags_None);
     if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
         ImGui::SetTooltip("e.g.  rtsp://192.168.1.100:554/stream\n"
+                          "      srt://192.168.1.100:9000\n"
                           "      rtmp://live.example.com/app/key\n"
                           "      http://cam.local/video.mjpg");
 
+    AppConfig& cfg = m_app.GetConfig();
+    ImGui::SetNextItemWidth(200);
+    if (ImGui::SliderInt("Jitter buffer (ms)", &cfg.networkJitterMs, 0, 2000))
+        cfg.networkJitterMs = std::max(cfg.networkJitterMs, 0);
+    if (ImGui::IsItemDeactivatedAfterEdit()) m_app.SaveConfig();
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Playout delay that absorbs uneven packet arrival.\n"
+                          "0 shows packets as they arrive (lowest latency, may stutter).\n"
+                          "For SRT this is also its retransmission window.");
+    int transport = cfg.networkTcp ? 1 : 0;
+    ImGui::SameLine();
+    if (ImGui::RadioButton("UDP", &transport, 0)) { cfg.networkTcp = false; m_app.SaveConfig(); }
+    ImGui::SameLine();
+    if (ImGui::RadioButton("TCP", &transport, 1)) { cfg.networkTcp = true;  m_app.SaveConfig(); }
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("RTSP transport. TCP gets through firewalls and never loses\n"
+                          "packets, at the cost of stalls when the link is congested.");
+
     ImGui::Spacing();
     bool urlEmpty = (m_captureUrlBuf[0] == '\0');
     if (urlEmpty) ImGui::BeginDisabled();
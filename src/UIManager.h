@@ -1,8 +1,14 @@
 #pragma once
 
 #include "Common.h"
+#include "CpuProfiler.h"
+#include "FrameWatchdog.h"
+#include "GpuProfiler.h"
+#include "MemoryUsage.h"
+#include "RecordingTelemetry.h"
 #include "imgui.h"
 #include "TextEditor.h"
+#include <chrono>
 
 namespace SP {
 
@@ -21,7 +27,12 @@ public:
     bool Initialize(HWND hwnd, ID3D11Device* device, ID3D11DeviceContext* context);
     void Shutdown();
 
-    // Frame rendering
+    // Frame rendering. NeedsRebuild decides whether this draw builds the UI
+    // (BeginFrame + Render) or EndFrame only draws the last built frame again,
+    // whose viewport then shows the newest display texture. It rebuilds after
+    // input, while something animates, and otherwise `idleRebuildHz` times a
+    // second (0 = every draw).
+    bool NeedsRebuild(int idleRebuildHz);
     void BeginFrame();
     void EndFrame();
     void Render();
@@ -32,6 +43,9 @@ public:
     // UI state
     bool WantsCaptureMouse() const;
     bool WantsCaptureKeyboard() const;
+    // On-screen size of the display texture in the Video viewport at the last
+    // build, in pixels; 0 when nothing was drawn there
+    ImVec2 GetVideoViewportSize() const { return m_videoViewportSize; }
 
     // Shader editor
     void SetEditorContent(const std::string& content);
@@ -44,6 +58,12 @@ public:
     // Live capture / stream dialog
     void ShowCaptureDialog();
 
+    // A realtime libx264 take that dropped frames steps the panel's preset one
+    // faster for the next one (when "Adapt speed" is on)
+    void OnRecordingStopped(const RecordingSettings& settings, int64_t encoded, int64_t dropped);
+    // Shows the measured fps and switches the panel to the recommended profile
+    void OnEncoderCalibrated(const EncoderCalibration& calibration);
+
     void ToggleEditor()           { m_showEditor           = !m_showEditor; }
     void ToggleLibrary()          { m_showLibrary          = !m_showLibrary; }
     void ToggleTransport()        { m_showTransport        = !m_showTransport; }
@@ -75,7 +95,11 @@ private:
     void DrawShaderEditor();
     void DrawShaderLibrary();
     void DrawTransportControls();
+    void DrawTimelineOverview(float width, float duration);  // Filmstrip + waveform; click or drag seeks
     void DrawRecordingPanel();
+    void DrawRecordingTelemetry(const RecordingTelemetry& telemetry);  // Stage table, plots, histogram
+    RecordingSettings MakeRecordingSettings() const;  // From the recording panel's fields
+    std::vector<RecordingSettings> MakeExtraTargets() const;  // The panel's second target, if enabled
     void DrawNotifications();
     void DrawKeybindingModal();
     void DrawNewShaderModal();
@@ -86,9 +110,21 @@ private:
     void DrawKeyframeDetail(ShaderParam& param, KeyframeTimeline& timeline,
                             int keyframeIndex, bool& anyChanged);
     void DrawNoisePanel();
+    void DrawDeckPanel();
+    void DrawChannelsPanel();
+    void DrawCanvasPanel();
+    void DrawPlaylistPanel();
     void DrawCaptureDialog();
     void DrawSpoutPanel();
+    void DrawNdiPanel();
+    void DrawVirtualCameraPanel();
+    void DrawControllersPanel();
+    void DrawPostChainsPanel();
     void DrawAudioPanel();
+    void DrawDecoderPanel();
+    void DrawGpuProfiler();  // Per-stage GPU ms overlay and frame-time graph
+    void DrawFrameTiming();  // Main-loop stages, frame-time percentiles, histogram, hitch log
+    void DrawMemoryPanel();  // Per-subsystem CPU/GPU bytes, process and video memory budgets
 
     Application& m_app;
     
@@ -127,12 +163,51 @@ private:
         float timeRemaining;
     };
     std::vector<Notification> m_notifications;
+
+    // Profiler panels: filled in place every build, so they reuse their storage
+    CpuProfiler::Snapshot        m_cpuSnapshot;
+    GpuProfiler::Snapshot        m_gpuSnapshot;
+    RecordingTelemetry::Snapshot m_telemetrySnapshot;
+    std::vector<FrameWatchdog::Event> m_watchdogEvents;
+    HeapCounters m_heapSample;  // Process-wide, for the allocation rate
+    std::chrono::steady_clock::time_point m_heapSampleTime{};
+    double m_heapRate = 0.0;    // Allocations per second, all threads
+
+    // UI rebuild policy (NeedsRebuild)
+    int  m_settleBuilds = 0;     // Builds still owed after the last input
+    bool m_frameBuilt   = false; // BeginFrame ran since the last EndFrame
+    ID3D11ShaderResourceView* m_builtDisplaySRV = nullptr;  // Referenced by the last draw data
+    ImVec2 m_videoViewportSize{0.0f, 0.0f};
+    std::chrono::steady_clock::time_point m_lastBuildTime{};
     
     // Recording UI state
     char m_recordingPath[512] = "output.mp4";
-    int m_recordingCodec = 0;  // 0 = H.264, 1 = ProRes
+    int m_recordingCodec = 0;  // Index into RECORDING_CODECS (UIManager.cpp); 0 = H.264, 1 = ProRes
     int m_recordingBitrate = 20;  // Mbps
     int m_proresProfile = 2;
+    int m_recordingPreset = 5;  // Index into X264_PRESETS (UIManager.cpp); 5 = medium
+    int m_recordingProfile = ENCODER_PROFILE_CUSTOM;  // Custom = m_recordingPreset
+    EncoderCalibration m_encoderCalibration;  // Last run; width 0 = none yet
+    bool m_recordingLossless = false;  // Wait for the encoder instead of dropping frames
+    bool m_adaptivePreset = true;
+    bool m_adaptToLoad = true;  // RecordingSettings::adaptToLoad
+    float m_exportSeconds = 60.0f;  // Length of a generative offline export
+    int   m_exportSubframes = 1;    // Temporal supersampling of an offline export (1 = off)
+    float m_exportShutter   = 0.5f; // Of a frame interval (0.5 = 180 degrees)
+    bool m_recordAudio = true;
+    int m_writeBufferMB = 128;  // Write-behind queue (RecordingSettings::writeBufferMB)
+    bool m_writeThrough = false;
+    bool m_fragmented = false;
+    int m_segmentSeconds = 0;  // 0 = one file
+    bool m_telemetryCsv = false;  // Per-frame stage timings next to the output
+    int m_telemetryStage = static_cast<int>(RecordingStage::Encode);  // Stage shown in the histogram
+    bool m_instantReplay = false;  // Record into the in-memory ring; F11 saves it
+    int m_replaySeconds = 30;
+    bool m_extraTarget = false;  // Second target (e.g. review copy) encoded from the same frames
+    char m_extraTargetPath[512] = "review.mp4";
+    int m_extraTargetCodec = 0;  // Index into RECORDING_CODECS
+    int m_extraTargetBitrate = 8;  // Mbps
+    int m_extraTargetDownscale = 1;  // Index into EXTRA_TARGET_DOWNSCALES (UIManager.cpp); 1 = half
     
     // New shader modal
     char m_newShaderName[256] = "";
@@ -145,17 +220,53 @@ private:
 
     // Noise generator panel
     bool m_showNoisePanel = false;
+    bool m_showDeckPanel = false;
+    bool m_showChannelsPanel = false;
+    bool m_showCanvasPanel = false;
+    int   m_canvasLayoutCount   = 2;
+    float m_canvasLayoutOverlap = 0.1f;
+    bool m_showPlaylistPanel = false;
 
     // Spout output panel
     bool m_showSpoutPanel = false;
 
+    // NDI panel
+    bool m_showNdiPanel = false;
+    std::vector<std::string> m_ndiSources;  // Refreshed on demand
+    int m_ndiSourceIdx = -1;
+
+    // Virtual camera panel
+    bool m_showVirtualCameraPanel = false;
+
+    // Controllers panel (OSC / MIDI input and bindings)
+    bool m_showControllersPanel = false;
+    std::vector<std::string> m_midiDevices;  // Refreshed when the device list opens
+
+    // Per-output post chains panel
+    bool m_showPostChainsPanel = false;
+
     // Audio monitor panel
     bool m_showAudioPanel = false;
 
+    // Video decoder panel (decode path + stats)
+    bool m_showDecoderPanel = false;
+
+    // GPU profiler overlay and CPU frame timing HUD
+    bool m_showGpuProfiler = false;
+    bool m_showFrameTiming = false;
+    bool m_showMemoryPanel = false;
+    std::vector<MemoryUsage> m_memoryUsage;  // Refilled each draw
+    std::vector<AdapterInfo> m_adapters;     // While View > GPU is open
+
     // Capture / stream dialog
     bool m_showCaptureDialog = false;
     std::vector<std::string> m_captureDevices;
+    std::vector<std::string> m_spoutSenders;  // Spout panel's receive list, refreshed on demand
+    int m_spoutSenderIdx = -1;                // -1 = active sender
     int m_selectedCaptureIdx = 0;
+    std::vector<CaptureMode> m_captureModes;  // Of m_selectedCaptureIdx, largest first
+    int m_captureModesFor    = -1;            // Device index m_captureModes was read for
+    int m_selectedCaptureMode = -1;           // -1 = Auto (CaptureDevices::PickBest)
     char m_captureUrlBuf[512] = "";
 
     // Keyframe editing state
@@ -1,16 +1,115 @@
 #include "VideoDecoder.h"
+#include "MediaProbe.h"
+#include "PixelCopy.h"
+#include "TraceRecorder.h"
+#include <d3d10.h>
 #include <stdexcept>
 #include <cstring>
+#include <algorithm>
+#include <cmath>
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
 
 namespace SP {
 
+namespace {
+
+// Live capture probing: enough for one keyframe of a 1080p stream
+constexpr int64_t CAPTURE_PROBE_BYTES = 256 * 1024;
+constexpr int64_t CAPTURE_ANALYZE_US  = 500'000;
+
+// MJPEG capture above 1080p60 can't be decoded on one core within a frame
+// interval; frame threads add a frame of latency each, so keep it to two
+constexpr int64_t CAPTURE_MJPEG_THREADED_RATE = 1920LL * 1080 * 60;
+constexpr int     CAPTURE_MJPEG_THREADS       = 2;
+
+// Shared by every decoder (main video, extra inputs, proxy jobs), so a generation
+// never repeats even across reopens
+std::atomic<uint64_t> g_nextFrameGeneration{1};
+
+} // namespace
+
+// Native layouts the renderer can convert on the GPU; RGBA8 = needs sws_scale
+// (including the YUVA formats of ProRes 4444, whose alpha the pass would drop).
+static FrameLayout ToFrameLayout(AVPixelFormat format) {
+    switch (format) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+        return FrameLayout::YUV420P;
+    case AV_PIX_FMT_YUV422P:
+    case AV_PIX_FMT_YUVJ422P:
+        return FrameLayout::YUV422P;
+    case AV_PIX_FMT_YUV444P:
+    case AV_PIX_FMT_YUVJ444P:
+        return FrameLayout::YUV444P;
+    case AV_PIX_FMT_YUYV422:
+        return FrameLayout::YUYV422;
+    case AV_PIX_FMT_UYVY422:
+        return FrameLayout::UYVY422;
+    case AV_PIX_FMT_YUV420P10LE:
+        return FrameLayout::YUV420P10;
+    case AV_PIX_FMT_YUV422P10LE:
+        return FrameLayout::YUV422P10;
+    case AV_PIX_FMT_YUV444P10LE:
+        return FrameLayout::YUV444P10;
+    case AV_PIX_FMT_YUV420P12LE:
+        return FrameLayout::YUV420P12;
+    case AV_PIX_FMT_YUV422P12LE:
+        return FrameLayout::YUV422P12;
+    case AV_PIX_FMT_YUV444P12LE:
+        return FrameLayout::YUV444P12;
+    case AV_PIX_FMT_NV12:
+        return FrameLayout::NV12;
+    case AV_PIX_FMT_P010LE:
+        return FrameLayout::P010;
+    default:
+        return FrameLayout::RGBA8;
+    }
+}
+
+// Packed RGB formats with a DXGI twin, uploaded without conversion: PNG, QTRLE,
+// raw and screen captures. ARGB/ABGR/RGB24 have none and still need sws_scale.
+static bool ToPackedLayout(AVPixelFormat format, FrameLayout& layout) {
+    switch (format) {
+    case AV_PIX_FMT_RGBA:     layout = FrameLayout::RGBA8;  return true;
+    case AV_PIX_FMT_BGRA:     layout = FrameLayout::BGRA8;  return true;
+    case AV_PIX_FMT_BGR0:     layout = FrameLayout::BGRX8;  return true;
+    case AV_PIX_FMT_RGBA64LE: layout = FrameLayout::RGBA16; return true;
+    default:                  return false;
+    }
+}
+
+// Map FFmpeg colour metadata to the renderer's conversion matrix. Unspecified
+// streams follow the usual convention: HD and above is BT.709, SD is BT.601.
+static ColorMatrix ToColorMatrix(AVColorSpace colorSpace, int height) {
+    switch (colorSpace) {
+    case AVCOL_SPC_BT709:
+        return ColorMatrix::BT709;
+    case AVCOL_SPC_BT470BG:
+    case AVCOL_SPC_SMPTE170M:
+    case AVCOL_SPC_FCC:
+        return ColorMatrix::BT601;
+    case AVCOL_SPC_BT2020_NCL:
+    case AVCOL_SPC_BT2020_CL:
+        return ColorMatrix::BT2020;
+    default:
+        return (height >= 720) ? ColorMatrix::BT709 : ColorMatrix::BT601;
+    }
+}
+
+// Proxy dimension at 1/scale, rounded up like lowres decoding does
+static int ProxySize(int size, int scale) {
+    return (scale > 1) ? (size + scale - 1) / scale : size;
+}
+
 VideoDecoder::VideoDecoder() {
     m_frame      = av_frame_alloc();
-    m_hwFrame    = av_frame_alloc();
-    m_audioFrame = av_frame_alloc();
+    m_swFrame    = av_frame_alloc();
     m_packet     = av_packet_alloc();
 
-    if (!m_frame || !m_hwFrame || !m_audioFrame || !m_packet) {
+    if (!m_frame || !m_swFrame || !m_packet) {
         throw std::runtime_error("Failed to allocate FFmpeg structures");
     }
 }
@@ -18,22 +117,18 @@ VideoDecoder::VideoDecoder() {
 VideoDecoder::~VideoDecoder() {
     Close();
     av_frame_free(&m_frame);
-    av_frame_free(&m_hwFrame);
-    av_frame_free(&m_audioFrame);
+    av_frame_free(&m_swFrame);
     av_packet_free(&m_packet);
 }
 
-bool VideoDecoder::Open(const std::string& filepath) {
+bool VideoDecoder::Open(const std::string& filepath, AVFormatContext* probed,
+                        std::unique_ptr<MediaIO> io) {
     Close();
+    m_io = std::move(io);
 
-    // Open input file
-    if (avformat_open_input(&m_formatCtx, filepath.c_str(), nullptr, nullptr) < 0) {
-        return false;
-    }
-
-    // Find stream info
-    if (avformat_find_stream_info(m_formatCtx, nullptr) < 0) {
-        Close();
+    // Open input file and find stream info (already done off-thread when probed)
+    m_formatCtx = probed ? probed : MediaProbe::ProbeFile(filepath, 0, 0);
+    if (!m_formatCtx) {
         return false;
     }
 
@@ -46,6 +141,7 @@ bool VideoDecoder::Open(const std::string& filepath) {
 
     AVStream* videoStream = m_formatCtx->streams[m_videoStreamIdx];
     AVCodecParameters* codecParams = videoStream->codecpar;
+    m_timeBase = videoStream->time_base;
 
     // Find decoder
     const AVCodec* codec = avcodec_find_decoder(codecParams->codec_id);
@@ -67,18 +163,37 @@ bool VideoDecoder::Open(const std::string& filepath) {
         return false;
     }
 
-    // Try hardware acceleration for H.264
-    // (Skip for now, software decode is more reliable cross-system)
-    
+    // Proxy: decoders with reduced-resolution support (MJPEG, JPEG 2000, ...)
+    // decode straight at 1/2^lowres size; whatever factor is left is scaled on
+    // output. lowres is software-only, so a codec using it skips D3D11VA.
+    m_sourceWidth  = codecParams->width;
+    m_sourceHeight = codecParams->height;
+    if (m_proxyScale > 1) {
+        int lowres = 0;
+        while ((2 << lowres) <= m_proxyScale && lowres < codec->max_lowres) ++lowres;
+        m_codecCtx->lowres = lowres;
+        m_proxyResidual = m_proxyScale >> lowres;
+    }
+
+    // D3D11VA on the renderer's device when one has been shared. Non-fatal: if the
+    // codec has no D3D11VA config or surface setup fails, get_format picks software.
+    if (m_sharedDevice && m_codecCtx->lowres == 0 && WantsHardware(codecParams)) {
+        InitHardwareDecoder(m_sharedDevice.Get());
+    }
+
+    ApplyThreading();
+
     // Open codec
     if (avcodec_open2(m_codecCtx, codec, nullptr) < 0) {
         Close();
         return false;
     }
+    m_activeThreadCount = m_codecCtx->thread_count;
+    m_activeThreadType  = m_codecCtx->active_thread_type;
 
-    // Store video properties
-    m_width = m_codecCtx->width;
-    m_height = m_codecCtx->height;
+    // Store video properties (frames come out at proxy size)
+    m_width  = ProxySize(m_sourceWidth, m_proxyScale);
+    m_height = ProxySize(m_sourceHeight, m_proxyScale);
     m_pixelFormat = m_codecCtx->pix_fmt;
     m_codecName = codec->name;
 
@@ -101,61 +216,87 @@ bool VideoDecoder::Open(const std::string& filepath) {
     // Estimate frame count
     m_frameCount = static_cast<int64_t>(m_duration * m_fps);
 
-    // Allocate conversion buffer for RGBA output.
-    // align=1 gives the exact minimum size with no row padding. sws_scale's SIMD
-    // routines (SSE/AVX) can overshoot by up to one full SIMD vector on the last row,
-    // corrupting the CRT heap guard. 64 bytes of tail padding absorbs that overshoot.
-    int bufferSize = av_image_get_buffer_size(m_outputFormat, m_width, m_height, 1);
-    m_conversionBuffer.resize(bufferSize + 64);
+    // Audio is read by AudioReader on its own demuxer; skip everything but video here
+    for (unsigned i = 0; i < m_formatCtx->nb_streams; ++i) {
+        if (static_cast<int>(i) != m_videoStreamIdx)
+            m_formatCtx->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    // Intra-only codecs (ProRes, DNxHR, MJPEG) can seek straight to any frame;
+    // everything else gets a keyframe/PTS index built in the background.
+    const AVCodecDescriptor* desc = avcodec_descriptor_get(codecParams->codec_id);
+    m_intraOnly = desc && (desc->props & AV_CODEC_PROP_INTRA_ONLY);
+
+    // A numbered still image plays its whole sequence: the pool decodes the
+    // files, this context only supplied the frame size. Every frame is a keyframe.
+    std::vector<std::string> sequenceFiles = ImageSequence::FindFrames(filepath);
+    if (!sequenceFiles.empty()) {
+        m_sequence = std::make_unique<ImageSequence>();
+        if (!m_sequence->Open(std::move(sequenceFiles), m_width, m_height, m_sequenceFps, m_sequenceCacheMB)) {
+            Close();
+            return false;
+        }
+        m_fps        = m_sequenceFps;
+        m_frameCount = m_sequence->GetFrameCount();
+        m_duration   = static_cast<double>(m_frameCount) / m_fps;
+        m_intraOnly  = true;
+        m_lastLayout = FrameLayout::RGBA8;
+        return true;
+    }
 
-    // Open audio stream (non-fatal — many videos have no audio).
-    OpenAudioStream();
+    if (!m_intraOnly && m_seekIndexEnabled) {
+        m_seekIndex.Build(filepath, m_videoStreamIdx);
+    }
 
     return true;
 }
 
+void VideoDecoder::SetImageSequenceOptions(double fps, int cacheMB) {
+    m_sequenceFps     = (fps > 0.0) ? fps : 24.0;
+    m_sequenceCacheMB = std::max(cacheMB, 0);
+}
+
 void VideoDecoder::Close() {
-    CloseAudioStream();
+    m_network.reset();   // Joins its demux thread
+    m_networkGeneration = 0;
+    m_sequence.reset();  // Joins its workers
+    m_seekIndex.Reset();
+    m_intraOnly = false;
     FlushDecoder();
-    
-    if (m_swsCtx) {
-        sws_freeContext(m_swsCtx);
-        m_swsCtx = nullptr;
-    }
-    
-    if (m_hwDeviceCtx) {
-        av_buffer_unref(&m_hwDeviceCtx);
-        m_hwDeviceCtx = nullptr;
-    }
-    
-    if (m_codecCtx) {
-        avcodec_free_context(&m_codecCtx);
-        m_codecCtx = nullptr;
-    }
+    FreeCodec();
     
     if (m_formatCtx) {
         avformat_close_input(&m_formatCtx);
         m_formatCtx = nullptr;
     }
+    m_io.reset();
 
     m_videoStreamIdx  = -1;
-    m_audioStreamIdx  = -1;
-    m_audioSampleRate = 0;
-    m_audioChannels   = 0;
+    m_timeBase        = AVRational{1, 1};
     m_width = 0;
     m_height = 0;
+    m_sourceWidth   = 0;
+    m_sourceHeight  = 0;
+    m_proxyResidual = 1;
     m_fps = 0.0;
     m_duration = 0.0;
     m_frameCount = 0;
     m_currentTime = 0.0;
     m_pixelFormat = AV_PIX_FMT_NONE;
     m_codecName.clear();
-    m_conversionBuffer.clear();
-    m_audioPending.clear();
+    m_activeThreadCount = 1;
+    m_activeThreadType  = 0;
+    m_lastDecodeMs = 0.0f;
+    m_avgDecodeMs  = 0.0f;
+    m_skipNonRef      = false;
+    m_keyframesOnly   = false;
+    m_framesDiscarded = 0;
+    m_framePool.Trim();
     m_isLiveCapture = false;
+    m_hwStatus      = HwStatus::Software;
 }
 
-bool VideoDecoder::OpenCapture(const std::string& deviceOrUrl, bool isDshow) {
+bool VideoDecoder::OpenCapture(const std::string& deviceOrUrl, bool isDshow, const CaptureMode* mode) {
     Close();
 
     const AVInputFormat* fmt = nullptr;
@@ -167,21 +308,45 @@ bool VideoDecoder::OpenCapture(const std::string& deviceOrUrl, bool isDshow) {
         url = "video=" + deviceOrUrl;
     }
 
-    // Request a common default; fall back to whatever the device offers.
-    AVDictionary* opts = nullptr;
-    av_dict_set(&opts, "video_size", "1280x720", 0);
-    av_dict_set(&opts, "framerate", "30", 0);
-
-    if (avformat_open_input(&m_formatCtx, url.c_str(), fmt, &opts) < 0) {
-        av_dict_free(&opts);
-        if (avformat_open_input(&m_formatCtx, url.c_str(), fmt, nullptr) < 0)
-            return false;
-    } else {
+    // Low latency: no demuxer-side buffering and a small probe, so the first frame
+    // arrives quickly and nothing queues behind later ones.
+    auto lowLatencyOptions = [] {
+        AVDictionary* opts = nullptr;
+        av_dict_set(&opts, "fflags", "nobuffer", 0);
+        av_dict_set_int(&opts, "probesize", CAPTURE_PROBE_BYTES, 0);
+        av_dict_set_int(&opts, "analyzeduration", CAPTURE_ANALYZE_US, 0);
+        return opts;
+    };
+    auto tryOpen = [&](AVDictionary* opts) {
+        const int ret = avformat_open_input(&m_formatCtx, url.c_str(), fmt, &opts);
         av_dict_free(&opts);
+        return ret >= 0;
+    };
+
+    // The requested mode, in its native format (the GPU converts NV12, YUY2, UYVY
+    // and I420; MJPEG decodes to planar YUV); then a common default; then
+    // whatever the device offers.
+    bool opened = false;
+    if (isDshow && mode && mode->width > 0) {
+        AVDictionary* opts = lowLatencyOptions();
+        av_dict_set(&opts, "video_size", (std::to_string(mode->width) + "x" + std::to_string(mode->height)).c_str(), 0);
+        if (mode->rateNum > 0)
+            av_dict_set(&opts, "framerate", (std::to_string(mode->rateNum) + "/" + std::to_string(mode->rateDen)).c_str(), 0);
+        if (!mode->pixelFormat.empty()) av_dict_set(&opts, "pixel_format", mode->pixelFormat.c_str(), 0);
+        if (!mode->codec.empty())       av_dict_set(&opts, "vcodec", mode->codec.c_str(), 0);
+        opened = tryOpen(opts);
     }
+    if (!opened) {
+        AVDictionary* opts = lowLatencyOptions();
+        av_dict_set(&opts, "video_size", "1280x720", 0);
+        av_dict_set(&opts, "framerate", "30", 0);
+        opened = tryOpen(opts);
+    }
+    if (!opened && !tryOpen(lowLatencyOptions())) return false;
 
     // Non-blocking: av_read_frame returns AVERROR(EAGAIN) instead of blocking when
-    // the device has no new frame yet. Keeps the render loop responsive.
+    // the device has no new frame yet, so the capture thread can always be stopped
+    // (dshow waits without checking the interrupt callback).
     m_formatCtx->flags |= AVFMT_FLAG_NONBLOCK;
 
     if (avformat_find_stream_info(m_formatCtx, nullptr) < 0) { Close(); return false; }
@@ -191,6 +356,7 @@ bool VideoDecoder::OpenCapture(const std::string& deviceOrUrl, bool isDshow) {
 
     AVStream* videoStream = m_formatCtx->streams[m_videoStreamIdx];
     AVCodecParameters* codecParams = videoStream->codecpar;
+    m_timeBase = videoStream->time_base;
 
     const AVCodec* codec = avcodec_find_decoder(codecParams->codec_id);
     if (!codec) { Close(); return false; }
@@ -199,60 +365,207 @@ bool VideoDecoder::OpenCapture(const std::string& deviceOrUrl, bool isDshow) {
     if (!m_codecCtx) { Close(); return false; }
 
     if (avcodec_parameters_to_context(m_codecCtx, codecParams) < 0) { Close(); return false; }
+    // Capture stays on libavcodec's single-thread default: frame threading would
+    // add a frame of latency per thread to a live source. The exception is MJPEG
+    // past 1080p60 (D3D11VA has no MJPEG profile), which one core can't keep up
+    // with; two frame threads cost one frame of latency instead of dropping half.
+    const double captureFps = av_q2d(videoStream->avg_frame_rate);
+    const bool threadedMjpeg = codecParams->codec_id == AV_CODEC_ID_MJPEG &&
+                               (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) &&
+                               static_cast<double>(codecParams->width) * codecParams->height * captureFps >
+                                   static_cast<double>(CAPTURE_MJPEG_THREADED_RATE);
+    if (threadedMjpeg) {
+        m_codecCtx->thread_count = CAPTURE_MJPEG_THREADS;
+        m_codecCtx->thread_type  = FF_THREAD_FRAME;
+    } else {
+        m_codecCtx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    }
     if (avcodec_open2(m_codecCtx, codec, nullptr) < 0) { Close(); return false; }
+    m_activeThreadCount = m_codecCtx->thread_count;
+    m_activeThreadType  = m_codecCtx->active_thread_type;
 
     m_width       = m_codecCtx->width;
     m_height      = m_codecCtx->height;
+    m_sourceWidth  = m_width;  // Captures never use proxy sizes
+    m_sourceHeight = m_height;
     m_pixelFormat = m_codecCtx->pix_fmt;
     m_codecName   = codec->name;
     m_fps         = (videoStream->avg_frame_rate.den != 0) ? av_q2d(videoStream->avg_frame_rate) : 30.0;
     m_duration    = 0.0;
     m_frameCount  = 0;
 
-    int bufferSize = av_image_get_buffer_size(m_outputFormat, m_width, m_height, 1);
-    m_conversionBuffer.resize(bufferSize + 64);
+    m_isLiveCapture = true;
+    return true;
+}
+
+void VideoDecoder::FreeCodec() {
+    if (m_swsCtx) {
+        sws_freeContext(m_swsCtx);
+        m_swsCtx = nullptr;
+    }
+    
+    if (m_hwDeviceCtx) {
+        av_buffer_unref(&m_hwDeviceCtx);
+        m_hwDeviceCtx = nullptr;
+    }
+    m_hwActive = false;
+    
+    if (m_codecCtx) {
+        avcodec_free_context(&m_codecCtx);
+        m_codecCtx = nullptr;
+    }
+}
 
+bool VideoDecoder::OpenNetwork(const std::string& url, int jitterMs, bool tcp) {
+    Close();
+    if (url.empty()) return false;
+    m_network = std::make_unique<NetworkSource>();
+    m_network->Start(url, jitterMs, tcp);
+    m_fps       = 30.0;  // Until the stream says
+    m_codecName = "connecting";
     m_isLiveCapture = true;
     return true;
 }
 
-void VideoDecoder::FlushVideoQueue() {
-    while (!m_videoPktQueue.empty()) {
-        av_packet_free(&m_videoPktQueue.front());
-        m_videoPktQueue.pop();
+bool VideoDecoder::OpenNetworkCodec() {
+    AVCodecParameters* params = avcodec_parameters_alloc();
+    if (!params) return false;
+    AVRational frameRate{0, 1};
+    uint64_t generation = 0;
+    if (!m_network->GetStreamInfo(params, m_timeBase, frameRate, generation)) {
+        avcodec_parameters_free(&params);
+        return false;
     }
+
+    // A reconnect to the same stream keeps the codec (and its hardware surfaces)
+    const bool sameStream = m_codecCtx && m_codecCtx->codec_id == params->codec_id &&
+                            m_sourceWidth == params->width && m_sourceHeight == params->height;
+    if (sameStream) {
+        avcodec_flush_buffers(m_codecCtx);
+    } else {
+        FreeCodec();
+        const AVCodec* codec = avcodec_find_decoder(params->codec_id);
+        m_codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+        if (!m_codecCtx || avcodec_parameters_to_context(m_codecCtx, params) < 0) {
+            FreeCodec();
+            avcodec_parameters_free(&params);
+            return false;
+        }
+        // Same as a capture: single-threaded, low delay. Hardware decode like a file.
+        if (m_sharedDevice && WantsHardware(params)) InitHardwareDecoder(m_sharedDevice.Get());
+        m_codecCtx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        if (avcodec_open2(m_codecCtx, codec, nullptr) < 0) {
+            FreeCodec();
+            avcodec_parameters_free(&params);
+            return false;
+        }
+        m_width        = m_codecCtx->width;
+        m_height       = m_codecCtx->height;
+        m_sourceWidth  = m_width;
+        m_sourceHeight = m_height;
+        m_pixelFormat  = m_codecCtx->pix_fmt;
+        m_codecName    = codec->name;
+    }
+    if (frameRate.num > 0 && frameRate.den > 0) m_fps = av_q2d(frameRate);
+    avcodec_parameters_free(&params);
+
+    m_networkGeneration = generation;
+    m_keyframeGate = true;  // A new connection starts decoding at a keyframe
+    return true;
+}
+
+void VideoDecoder::SetProxyScale(int scale) {
+    m_proxyScale = (scale >= 4) ? 4 : (scale >= 2) ? 2 : 1;
+}
+
+void VideoDecoder::SetDecodeThreading(int threadCount, int threadType) {
+    m_threadCount = std::max(threadCount, 0);
+    m_threadType  = std::clamp(threadType, 0, 2);
+}
+
+void VideoDecoder::ApplyThreading() {
+    // libavcodec defaults to a single thread; 0 lets it pick one per core.
+    // Frame threading scales best for long-GOP codecs (HEVC, H.264) at the cost
+    // of a few frames of latency; intra codecs like ProRes/DNxHR slice-thread.
+    m_codecCtx->thread_count = m_threadCount;
+    switch (m_threadType) {
+        case 1:  m_codecCtx->thread_type = FF_THREAD_FRAME; break;
+        case 2:  m_codecCtx->thread_type = FF_THREAD_SLICE; break;
+        default: m_codecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE; break;
+    }
+}
+
+const char* VideoDecoder::GetActiveThreadTypeName() const {
+    if (m_activeThreadType & FF_THREAD_FRAME) return "frame";
+    if (m_activeThreadType & FF_THREAD_SLICE) return "slice";
+    return "none";
+}
+
+void VideoDecoder::RecordDecodeTime(std::chrono::steady_clock::time_point start) {
+    const float ms = std::chrono::duration<float, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    m_lastDecodeMs = ms;
+    // Exponential average over roughly the last 30 frames; seeded by the first frame
+    const float avg = m_avgDecodeMs;
+    m_avgDecodeMs = (avg == 0.0f) ? ms : avg + (ms - avg) / 30.0f;
 }
 
 void VideoDecoder::FlushDecoder() {
-    FlushVideoQueue();
     if (m_codecCtx)
         avcodec_flush_buffers(m_codecCtx);
-    if (m_audioCtx)
-        avcodec_flush_buffers(m_audioCtx);
     av_frame_unref(m_frame);
-    av_frame_unref(m_hwFrame);
-    av_frame_unref(m_audioFrame);
+    av_frame_unref(m_swFrame);
     av_packet_unref(m_packet);
-    m_audioPending.clear();
-    m_audioEOFReached = false;
+    m_seekTargetPts = AV_NOPTS_VALUE;
+    m_catchingUp    = false;
+    m_keyframeGate  = false;  // Every seek lands on a keyframe
+    m_cancelSeek.store(false, std::memory_order_relaxed);
 }
 
 bool VideoDecoder::DecodeNextFrame(VideoFrame& outFrame) {
     if (!IsOpen()) return false;
+    const auto decodeStart = std::chrono::steady_clock::now();
+    m_wouldBlock = false;
+    m_seekCancelled = false;
+
+    if (m_sequence) {
+        if (!m_sequence->Next(outFrame)) return false;
+        outFrame.generation = g_nextFrameGeneration.fetch_add(1, std::memory_order_relaxed);
+        m_currentTime = outFrame.timestamp;
+        RecordDecodeTime(decodeStart);  // Mostly the wait for the pool
+        return true;
+    }
 
     while (true) {
-        // Try to receive a decoded frame
-        int ret = avcodec_receive_frame(m_codecCtx, m_frame);
+        // Try to receive a decoded frame (a network stream has no codec until it connects)
+        int ret = m_codecCtx ? avcodec_receive_frame(m_codecCtx, m_frame) : AVERROR(EAGAIN);
         
         if (ret == 0) {
+            // Exact seek: drop frames before the target without converting them
+            if (m_seekTargetPts != AV_NOPTS_VALUE) {
+                const int64_t pts = m_frame->best_effort_timestamp;
+                if (pts != AV_NOPTS_VALUE && pts < m_seekTargetPts) {
+                    if (m_catchingUp) ++m_framesDiscarded;
+                    av_frame_unref(m_frame);
+                    if (m_cancelSeek.load(std::memory_order_relaxed)) {
+                        m_seekCancelled = true;
+                        return false;
+                    }
+                    continue;
+                }
+                m_seekTargetPts = AV_NOPTS_VALUE;
+                m_catchingUp    = false;
+            }
+
             // Got a frame, convert and return
             if (ConvertFrame(m_frame, outFrame)) {
+                outFrame.generation = g_nextFrameGeneration.fetch_add(1, std::memory_order_relaxed);
                 // Update current time
-                AVStream* stream = m_formatCtx->streams[m_videoStreamIdx];
                 if (m_frame->pts != AV_NOPTS_VALUE) {
-                    m_currentTime = static_cast<double>(m_frame->pts) * av_q2d(stream->time_base);
+                    m_currentTime = static_cast<double>(m_frame->pts) * av_q2d(m_timeBase);
                 }
                 av_frame_unref(m_frame);
+                RecordDecodeTime(decodeStart);
                 return true;
             }
             av_frame_unref(m_frame);
@@ -264,39 +577,66 @@ bool VideoDecoder::DecodeNextFrame(VideoFrame& outFrame) {
         } else if (ret == AVERROR_EOF) {
             return false;  // End of stream
         } else {
+            if (m_hwActive && FallBackToSoftware(ret)) continue;
+            m_wouldBlock = (m_network != nullptr);  // A network stream outlives bad data
             return false;  // Error
         }
 
-        // Prefer queued video packets (populated by ReadAudioAhead) to avoid
-        // re-reading from the container. Falls through to av_read_frame if the
-        // queue is empty, which also decodes any interleaved audio packets.
+        // Feed the next video packet. Other streams are discarded at the demuxer,
+        // but skip anything that still arrives.
         while (true) {
-            if (!m_videoPktQueue.empty()) {
-                AVPacket* queued = m_videoPktQueue.front();
-                m_videoPktQueue.pop();
-                ret = avcodec_send_packet(m_codecCtx, queued);
-                av_packet_free(&queued);
-                if (ret < 0 && ret != AVERROR(EAGAIN)) return false;
-                break;
+            if (m_network) {
+                // Jitter buffer: nothing due yet reads as a non-blocking EAGAIN
+                uint64_t generation = 0;
+                std::chrono::steady_clock::time_point arrival;
+                if (!m_network->PopPacket(m_packet, generation, arrival)) {
+                    m_wouldBlock = true;
+                    return false;
+                }
+                if (generation != m_networkGeneration && !OpenNetworkCodec()) {
+                    av_packet_unref(m_packet);
+                    continue;
+                }
+                m_lastPacketTime = arrival;  // Latency includes the jitter buffer
+                ret = 0;
+            } else {
+                ret = av_read_frame(m_formatCtx, m_packet);
             }
-
-            ret = av_read_frame(m_formatCtx, m_packet);
             if (ret < 0) {
                 if (ret == AVERROR_EOF) {
                     avcodec_send_packet(m_codecCtx, nullptr);
                     break;
                 }
+                m_wouldBlock = (ret == AVERROR(EAGAIN));
                 return false;
             }
 
-            if (m_packet->stream_index == m_videoStreamIdx) {
+            if (m_network || m_packet->stream_index == m_videoStreamIdx) {
+                if (m_isLiveCapture && !m_network) m_lastPacketTime = std::chrono::steady_clock::now();
+                // Keyframes only: drop the rest before the codec. After switching back,
+                // keep dropping until the next keyframe, since the frames in between
+                // reference pictures that were never decoded.
+                const bool keyframesOnly = m_keyframesOnly;
+                if (keyframesOnly) m_keyframeGate = true;
+                if (m_keyframeGate) {
+                    if (!(m_packet->flags & AV_PKT_FLAG_KEY)) {
+                        av_packet_unref(m_packet);
+                        continue;
+                    }
+                    m_keyframeGate = keyframesOnly;
+                }
+                // Applied here, on the decoding thread, so the flags can flip mid-playback
+                const AVDiscard skip = keyframesOnly ? AVDISCARD_NONKEY
+                                     : m_skipNonRef  ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+                if (m_codecCtx->skip_frame != skip) m_codecCtx->skip_frame = skip;
                 ret = avcodec_send_packet(m_codecCtx, m_packet);
                 av_packet_unref(m_packet);
-                if (ret < 0 && ret != AVERROR(EAGAIN)) return false;
+                if (ret < 0 && ret != AVERROR(EAGAIN)) {
+                    if (m_hwActive && FallBackToSoftware(ret)) break;
+                    m_wouldBlock = (m_network != nullptr);
+                    return false;
+                }
                 break;
-            } else if (m_packet->stream_index == m_audioStreamIdx && m_audioCtx) {
-                DecodeAudioPacket();
-                continue;
             }
             av_packet_unref(m_packet);
         }
@@ -304,22 +644,94 @@ bool VideoDecoder::DecodeNextFrame(VideoFrame& outFrame) {
 }
 
 bool VideoDecoder::ConvertFrame(AVFrame* frame, VideoFrame& outFrame) {
-    AVFrame* srcFrame = frame;
-    
-    // Handle hardware frames
+    SP_TRACE_SCOPE("ConvertFrame");
+    outFrame.pts = frame->pts;
+    if (frame->pts != AV_NOPTS_VALUE) {
+        outFrame.timestamp = static_cast<double>(frame->pts) * av_q2d(m_timeBase);
+    }
+    outFrame.colorMatrix = ToColorMatrix(frame->colorspace, frame->height);
+    outFrame.fullRange   = (frame->color_range == AVCOL_RANGE_JPEG ||
+                            frame->format == AV_PIX_FMT_YUVJ420P ||
+                            frame->format == AV_PIX_FMT_YUVJ422P ||
+                            frame->format == AV_PIX_FMT_YUVJ444P);
+
+    // Hardware frames stay on the GPU — the renderer samples the surface directly —
+    // unless they must outlive the surface pool, in which case they are downloaded
+    // and continue as an NV12/P010 software frame.
     if (frame->format == AV_PIX_FMT_D3D11) {
-        if (av_hwframe_transfer_data(m_hwFrame, frame, 0) < 0) {
-            return false;
+        if (!m_downloadHw) {
+            return WrapHardwareFrame(frame, outFrame);
         }
-        srcFrame = m_hwFrame;
+        av_frame_unref(m_swFrame);
+        if (av_hwframe_transfer_data(m_swFrame, frame, 0) < 0) return false;
+        av_frame_copy_props(m_swFrame, frame);
+        frame = m_swFrame;
     }
 
-    // Initialize or reinitialize swscale context
-    AVPixelFormat srcFormat = static_cast<AVPixelFormat>(srcFrame->format);
-    
+    // Software frame. Drop whatever the slot held first (a previous hardware
+    // surface or pool block) so a pool block can be reused immediately.
+    outFrame.hwTexture    = nullptr;
+    outFrame.hwArraySlice = 0;
+    outFrame.buffer.reset();
+
+    AVPixelFormat srcFormat = static_cast<AVPixelFormat>(frame->format);
+
+    // Native YUV planes go to the GPU as-is (1.5 bytes/pixel at 8-bit 4:2:0 instead
+    // of 4; 10/12-bit ProRes and HEVC skip the costly high-bit sws_scale path).
+    // In proxy mode the conversion pass also downscales them, which is cheaper than
+    // a scaling sws_scale; other formats are scaled to proxy size by sws_scale below.
+    // Packed RGB that is already at the output size is handed over the same way:
+    // one copy into the upload ring instead of sws_scale plus that copy.
+    if (m_gpuYuv) {
+        const FrameLayout layout = ToFrameLayout(srcFormat);
+        if (layout != FrameLayout::RGBA8 && WrapSoftwareFrame(frame, layout, outFrame)) {
+            m_lastLayout      = layout;
+            m_lastPassthrough = false;
+            return true;
+        }
+        FrameLayout packed;
+        if (ToPackedLayout(srcFormat, packed) && frame->width == m_width && frame->height == m_height &&
+            WrapSoftwareFrame(frame, packed, outFrame)) {
+            m_lastLayout      = packed;
+            m_lastPassthrough = true;
+            return true;
+        }
+    }
+    m_lastLayout      = FrameLayout::RGBA8;
+    m_lastPassthrough = false;
+
+    // 8-bit RGBA or BGRA at the output size (GPU YUV off): a copy or a byte
+    // swizzle into the block, which is all sws_scale would do, in one pass
+    const bool rgba = srcFormat == AV_PIX_FMT_RGBA;
+    if ((rgba || srcFormat == AV_PIX_FMT_BGRA) && m_outputFormat == AV_PIX_FMT_RGBA &&
+        frame->width == m_width && frame->height == m_height && frame->linesize[0] > 0) {
+        const size_t rowBytes = static_cast<size_t>(m_width) * 4;
+        FrameBuffer block = m_framePool.Acquire(rowBytes * m_height);
+        if (rgba) {
+            CopyRows(block.get(), rowBytes, frame->data[0], static_cast<size_t>(frame->linesize[0]), rowBytes, m_height);
+        } else {
+            SwizzleRgbaBgra(block.get(), rowBytes, frame->data[0], static_cast<size_t>(frame->linesize[0]), m_width,
+                            m_height);
+        }
+        outFrame.width  = m_width;
+        outFrame.height = m_height;
+        outFrame.format = m_outputFormat;
+        outFrame.layout = FrameLayout::RGBA8;
+        outFrame.outputWidth  = 0;
+        outFrame.outputHeight = 0;
+        outFrame.data[0] = block.get();
+        outFrame.data[1] = outFrame.data[2] = outFrame.data[3] = nullptr;
+        outFrame.linesize[0] = static_cast<int>(rowBytes);
+        outFrame.linesize[1] = outFrame.linesize[2] = outFrame.linesize[3] = 0;
+        outFrame.buffer = std::move(block);
+        m_lastPassthrough = true;
+        return true;
+    }
+
+    // Initialize or reinitialize swscale context    
     m_swsCtx = sws_getCachedContext(
         m_swsCtx,
-        srcFrame->width, srcFrame->height, srcFormat,
+        frame->width, frame->height, srcFormat,
         m_width, m_height, m_outputFormat,
         SWS_BILINEAR, nullptr, nullptr, nullptr
     );
@@ -328,15 +740,22 @@ bool VideoDecoder::ConvertFrame(AVFrame* frame, VideoFrame& outFrame) {
         return false;
     }
 
-    // Set up destination pointers
-    uint8_t* dstData[4] = { m_conversionBuffer.data(), nullptr, nullptr, nullptr };
+    // sws_scale writes straight into a pooled block that the VideoFrame then owns.
+    // align=1 gives the exact minimum size with no row padding. sws_scale's SIMD
+    // routines (SSE/AVX) can overshoot by up to one full SIMD vector on the last row,
+    // corrupting the CRT heap guard. 64 bytes of tail padding absorbs that overshoot.
+    const int bufferSize = av_image_get_buffer_size(m_outputFormat, m_width, m_height, 1);
+    if (bufferSize <= 0) return false;
+    FrameBuffer block = m_framePool.Acquire(static_cast<size_t>(bufferSize) + 64);
+
+    uint8_t* dstData[4] = { block.get(), nullptr, nullptr, nullptr };
     int dstLinesize[4] = { m_width * 4, 0, 0, 0 };  // RGBA = 4 bytes per pixel
 
     // Convert
     int result = sws_scale(
         m_swsCtx,
-        srcFrame->data, srcFrame->linesize,
-        0, srcFrame->height,
+        frame->data, frame->linesize,
+        0, frame->height,
         dstData, dstLinesize
     );
 
@@ -344,32 +763,100 @@ bool VideoDecoder::ConvertFrame(AVFrame* frame, VideoFrame& outFrame) {
         return false;
     }
 
-    // Copy to output frame
     outFrame.width = m_width;
     outFrame.height = m_height;
     outFrame.format = m_outputFormat;
-    outFrame.pts = srcFrame->pts;
-    
-    AVStream* stream = m_formatCtx->streams[m_videoStreamIdx];
-    if (srcFrame->pts != AV_NOPTS_VALUE) {
-        outFrame.timestamp = static_cast<double>(srcFrame->pts) * av_q2d(stream->time_base);
-    }
+    outFrame.layout = FrameLayout::RGBA8;
+    outFrame.outputWidth  = 0;  // Already at proxy size
+    outFrame.outputHeight = 0;
 
-    outFrame.data[0].assign(m_conversionBuffer.begin(), m_conversionBuffer.end());
+    outFrame.data[0] = block.get();
+    outFrame.data[1] = outFrame.data[2] = outFrame.data[3] = nullptr;
     outFrame.linesize[0] = dstLinesize[0];
     outFrame.linesize[1] = 0;
     outFrame.linesize[2] = 0;
     outFrame.linesize[3] = 0;
+    outFrame.buffer = std::move(block);
+
+    return true;
+}
+
+// Takes a reference on the AVFrame's buffers (decoder pool or hardware surface);
+// they are recycled when the last VideoFrame sharing the returned handle goes away.
+static std::shared_ptr<void> ShareFrame(AVFrame* frame) {
+    AVFrame* ref = av_frame_clone(frame);
+    if (!ref) return nullptr;
+    return std::shared_ptr<void>(ref, [](void* p) {
+        AVFrame* f = static_cast<AVFrame*>(p);
+        av_frame_free(&f);
+    });
+}
+
+bool VideoDecoder::WrapSoftwareFrame(AVFrame* frame, FrameLayout layout, VideoFrame& outFrame) {
+    const int planeCount = (IsPackedLayout(layout) || layout == FrameLayout::YUYV422 ||
+                            layout == FrameLayout::UYVY422) ? 1
+                         : (layout == FrameLayout::NV12 || layout == FrameLayout::P010) ? 2 : 3;
 
-    if (srcFrame == m_hwFrame) {
-        av_frame_unref(m_hwFrame);
+    // Bottom-up (negative stride) frames are left to sws_scale
+    for (int i = 0; i < planeCount; ++i) {
+        if (!frame->data[i] || frame->linesize[i] <= 0) return false;
     }
 
+    // Native planes are uploaded straight from the decoder's own buffers
+    std::shared_ptr<void> ref = ShareFrame(frame);
+    if (!ref) return false;
+    const AVFrame* shared = static_cast<const AVFrame*>(ref.get());
+
+    for (int i = 0; i < 4; ++i) {
+        outFrame.data[i]     = (i < planeCount) ? shared->data[i]     : nullptr;
+        outFrame.linesize[i] = (i < planeCount) ? shared->linesize[i] : 0;
+    }
+    outFrame.buffer = std::move(ref);
+
+    outFrame.width  = frame->width;
+    outFrame.height = frame->height;
+    outFrame.format = frame->format;
+    outFrame.layout = layout;
+    SetProxyOutputSize(frame, outFrame);
+    return true;
+}
+
+bool VideoDecoder::WrapHardwareFrame(AVFrame* frame, VideoFrame& outFrame) {
+    // D3D11 frames carry the pool's texture array in data[0] and the slice index in
+    // data[1]. Sharing the frame keeps the surface out of the decoder's pool until
+    // the last VideoFrame holding it is released.
+    std::shared_ptr<void> ref = ShareFrame(frame);
+    if (!ref) return false;
+    const AVFrame* shared = static_cast<const AVFrame*>(ref.get());
+
+    outFrame.hwTexture    = reinterpret_cast<ID3D11Texture2D*>(shared->data[0]);
+    outFrame.hwArraySlice = static_cast<int>(reinterpret_cast<intptr_t>(shared->data[1]));
+    outFrame.buffer       = std::move(ref);
+
+    outFrame.width  = frame->width;
+    outFrame.height = frame->height;
+    outFrame.format = AV_PIX_FMT_D3D11;
+    outFrame.layout = FrameLayout::NV12;
+    if (frame->hw_frames_ctx) {
+        const auto* frames = reinterpret_cast<const AVHWFramesContext*>(frame->hw_frames_ctx->data);
+        if (frames->sw_format == AV_PIX_FMT_P010) outFrame.layout = FrameLayout::P010;
+    }
+    for (int i = 0; i < 4; ++i) {
+        outFrame.data[i]     = nullptr;
+        outFrame.linesize[i] = 0;
+    }
+    SetProxyOutputSize(frame, outFrame);
     return true;
 }
 
+void VideoDecoder::SetProxyOutputSize(const AVFrame* frame, VideoFrame& outFrame) const {
+    outFrame.outputWidth  = (m_proxyResidual > 1) ? ProxySize(frame->width, m_proxyResidual)  : 0;
+    outFrame.outputHeight = (m_proxyResidual > 1) ? ProxySize(frame->height, m_proxyResidual) : 0;
+}
+
 bool VideoDecoder::SeekToTime(double seconds) {
-    if (!IsOpen()) return false;
+    if (!m_formatCtx) return false;  // Also a network stream
+    if (m_sequence) return SeekToFrame(FrameNumberAt(seconds));
 
     AVStream* stream = m_formatCtx->streams[m_videoStreamIdx];
     int64_t timestamp = static_cast<int64_t>(seconds / av_q2d(stream->time_base));
@@ -384,142 +871,268 @@ bool VideoDecoder::SeekToTime(double seconds) {
     return true;
 }
 
+bool VideoDecoder::SeekToTimeExact(double seconds) {
+    if (!m_formatCtx) return false;
+    if (m_sequence) return SeekToFrame(FrameNumberAt(seconds));
+
+    AVStream* stream = m_formatCtx->streams[m_videoStreamIdx];
+    const double tb = av_q2d(stream->time_base);
+    int64_t target = static_cast<int64_t>(seconds / tb);
+
+    if (m_seekIndex.IsReady()) {
+        target = m_seekIndex.GetFramePts(m_seekIndex.FrameAtOrBefore(target));
+        return SeekToPts(target, m_seekIndex.KeyframeAtOrBefore(target));
+    }
+    // No index (intra-only or still building): tolerate half a frame of rounding
+    // so the frame that is on screen at `seconds` isn't skipped.
+    if (m_fps > 0.0) target -= static_cast<int64_t>(0.5 / (m_fps * tb));
+    return SeekToPts(target, target);
+}
+
+void VideoDecoder::DiscardUntil(double seconds) {
+    if (!m_formatCtx) return;
+    if (m_sequence) {
+        // No decode dependency between frames: skip straight to the target
+        const int64_t position = m_sequence->GetPosition();
+        const int64_t target   = FrameNumberAt(seconds);
+        if (target > position) {
+            m_sequence->Seek(target);
+            m_framesDiscarded += target - position;
+        }
+        return;
+    }
+    const double tb = av_q2d(m_formatCtx->streams[m_videoStreamIdx]->time_base);
+    const int64_t target = static_cast<int64_t>(seconds / tb);
+    // Never shorten an exact seek's discard that is still running
+    if (m_seekTargetPts == AV_NOPTS_VALUE || target > m_seekTargetPts) {
+        m_seekTargetPts = target;
+        m_catchingUp    = true;
+    }
+}
+
+int64_t VideoDecoder::FrameNumberAt(double seconds) const {
+    if (!IsOpen()) return 0;
+    if (m_seekIndex.IsReady()) {
+        const double tb = av_q2d(m_formatCtx->streams[m_videoStreamIdx]->time_base);
+        return m_seekIndex.FrameAtOrBefore(static_cast<int64_t>(seconds / tb));
+    }
+    return static_cast<int64_t>(std::floor(seconds * m_fps + 1e-3));
+}
+
+int64_t VideoDecoder::GetKeyframeBefore(int64_t frameNumber) const {
+    if (m_intraOnly) return frameNumber;
+    if (!m_seekIndex.IsReady()) return -1;
+    const int64_t keyPts = m_seekIndex.KeyframeAtOrBefore(m_seekIndex.GetFramePts(frameNumber));
+    return m_seekIndex.FrameAtOrBefore(keyPts);
+}
+
+int64_t VideoDecoder::GetTotalFrames() const {
+    return m_seekIndex.IsReady() ? m_seekIndex.GetFrameCount() : m_frameCount;
+}
+
+double VideoDecoder::SnapToFrameTime(double seconds) const {
+    if (!m_formatCtx) return seconds;
+    const double tb = av_q2d(m_formatCtx->streams[m_videoStreamIdx]->time_base);
+    if (m_seekIndex.IsReady()) {
+        const int64_t target = static_cast<int64_t>(seconds / tb);
+        return static_cast<double>(m_seekIndex.GetFramePts(m_seekIndex.FrameAtOrBefore(target))) * tb;
+    }
+    if (m_fps <= 0.0) return seconds;
+    return std::floor(seconds * m_fps + 1e-3) / m_fps;
+}
+
 bool VideoDecoder::SeekToFrame(int64_t frameNumber) {
+    if (!IsOpen()) return false;
+    if (m_sequence) {
+        m_sequence->Seek(frameNumber);
+        m_currentTime = static_cast<double>(m_sequence->GetPosition()) / m_fps;
+        return true;
+    }
+    if (m_seekIndex.IsReady()) {
+        const int64_t target = m_seekIndex.GetFramePts(frameNumber);
+        return SeekToPts(target, m_seekIndex.KeyframeAtOrBefore(target));
+    }
     if (m_fps <= 0) return false;
     double seconds = static_cast<double>(frameNumber) / m_fps;
-    return SeekToTime(seconds);
+    return SeekToTimeExact(seconds);
 }
 
-int VideoDecoder::DrainAudioSamples(float* buf, int maxFloats) {
-    int available = static_cast<int>(m_audioPending.size());
-    int toCopy = std::min(available, maxFloats);
-    if (toCopy > 0) {
-        std::copy(m_audioPending.begin(), m_audioPending.begin() + toCopy, buf);
-        m_audioPending.erase(m_audioPending.begin(), m_audioPending.begin() + toCopy);
+bool VideoDecoder::SeekToPts(int64_t targetPts, int64_t keyframePts) {
+    // BACKWARD lands on the keyframe at or before keyframePts; DecodeNextFrame
+    // then decodes forward, discarding unconverted frames until targetPts.
+    if (av_seek_frame(m_formatCtx, m_videoStreamIdx, keyframePts, AVSEEK_FLAG_BACKWARD) < 0) {
+        return false;
     }
-    return toCopy;
-}
 
-void VideoDecoder::OpenAudioStream() {
-    if (!m_formatCtx) return;
+    FlushDecoder();
+    m_seekTargetPts = targetPts;  // Clears any catch-up discard (FlushDecoder)
+    m_currentTime = static_cast<double>(targetPts) * av_q2d(m_formatCtx->streams[m_videoStreamIdx]->time_base);
+    return true;
+}
 
-    int idx = av_find_best_stream(m_formatCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
-    if (idx < 0) return;  // No audio stream — silent video.
+bool VideoDecoder::InitHardwareDecoder(ID3D11Device* device) {
+    if (!device || !m_codecCtx) return false;
+
+    // Only codecs with a D3D11VA device-context config can use the shared device.
+    bool supported = false;
+    for (int i = 0;; ++i) {
+        const AVCodecHWConfig* config = avcodec_get_hw_config(m_codecCtx->codec, i);
+        if (!config) break;
+        if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) &&
+            config->device_type == AV_HWDEVICE_TYPE_D3D11VA) {
+            supported = true;
+            break;
+        }
+    }
+    if (!supported) return false;
 
-    const AVCodec* codec = avcodec_find_decoder(m_formatCtx->streams[idx]->codecpar->codec_id);
-    if (!codec) return;
+    // Wrap the renderer's device instead of letting FFmpeg create its own, so decoded
+    // surfaces live on the same device and can be bound as SRVs without a copy.
+    AVBufferRef* hwDeviceCtx = av_hwdevice_ctx_alloc(AV_HWDEVICE_TYPE_D3D11VA);
+    if (!hwDeviceCtx) return false;
 
-    m_audioCtx = avcodec_alloc_context3(codec);
-    if (!m_audioCtx) return;
+    AVHWDeviceContext* deviceCtx = reinterpret_cast<AVHWDeviceContext*>(hwDeviceCtx->data);
+    AVD3D11VADeviceContext* d3d11Ctx = static_cast<AVD3D11VADeviceContext*>(deviceCtx->hwctx);
+    device->AddRef();  // Released by FFmpeg when the device context is freed
+    d3d11Ctx->device = device;
 
-    if (avcodec_parameters_to_context(m_audioCtx, m_formatCtx->streams[idx]->codecpar) < 0) {
-        avcodec_free_context(&m_audioCtx);
-        return;
+    if (av_hwdevice_ctx_init(hwDeviceCtx) < 0) {
+        av_buffer_unref(&hwDeviceCtx);
+        return false;
     }
 
-    if (avcodec_open2(m_audioCtx, codec, nullptr) < 0) {
-        avcodec_free_context(&m_audioCtx);
-        return;
+    // The decoder drives the immediate context through ID3D11VideoContext under
+    // FFmpeg's own lock; the renderer uses it without that lock. Multithread
+    // protection serialises the two at the driver level.
+    ComPtr<ID3D10Multithread> multithread;
+    if (SUCCEEDED(device->QueryInterface(IID_PPV_ARGS(&multithread)))) {
+        multithread->SetMultithreadProtected(TRUE);
     }
 
-    m_audioStreamIdx  = idx;
-    m_audioSampleRate = m_audioCtx->sample_rate;
-    m_audioChannels   = m_audioCtx->ch_layout.nb_channels;
+    m_hwDeviceCtx = hwDeviceCtx;
+    m_codecCtx->hw_device_ctx = av_buffer_ref(m_hwDeviceCtx);
+    m_codecCtx->opaque        = this;
+    m_codecCtx->get_format    = &VideoDecoder::GetHardwareFormat;
+    return true;
+}
 
-    // Set up swresample: decode native format/layout → mono planar float.
-    // This handles all source channel counts (stereo, 5.1, etc.) via downmix.
-    AVChannelLayout monoLayout = AV_CHANNEL_LAYOUT_MONO;
-    if (swr_alloc_set_opts2(&m_swrCtx,
-            &monoLayout,              AV_SAMPLE_FMT_FLTP, m_audioSampleRate,
-            &m_audioCtx->ch_layout,   m_audioCtx->sample_fmt, m_audioSampleRate,
-            0, nullptr) < 0 || !m_swrCtx || swr_init(m_swrCtx) < 0) {
-        swr_free(&m_swrCtx);
-        avcodec_free_context(&m_audioCtx);
-        m_audioStreamIdx = -1;
+bool VideoDecoder::WantsHardware(const AVCodecParameters* params) {
+    const auto it = m_hwPolicy.find(avcodec_get_name(params->codec_id));
+    const HwDecodePolicy policy = (it != m_hwPolicy.end()) ? it->second : HwDecodePolicy::Auto;
+    if (policy == HwDecodePolicy::Software) {
+        m_hwStatus = HwStatus::Policy;
+        return false;
     }
+    if (policy == HwDecodePolicy::Auto && m_hwCaps && !m_hwCaps->Supports(params)) {
+        m_hwStatus = HwStatus::Unsupported;
+        return false;
+    }
+    m_hwStatus = HwStatus::Software;  // Until get_format picks D3D11
+    return true;
 }
 
-void VideoDecoder::CloseAudioStream() {
-    if (m_swrCtx) {
-        swr_free(&m_swrCtx);
+bool VideoDecoder::FallBackToSoftware(int error) {
+    // Same stream, fresh context: parameters from the failed one, no hw_device_ctx.
+    // Frames already handed out keep their own references to the old surfaces.
+    AVCodecParameters* params = avcodec_parameters_alloc();
+    const AVCodec* codec = m_codecCtx->codec;
+    if (!params || avcodec_parameters_from_context(params, m_codecCtx) < 0) {
+        avcodec_parameters_free(&params);
+        return false;
     }
-    if (m_audioCtx) {
-        avcodec_free_context(&m_audioCtx);
+    FreeCodec();
+    m_codecCtx = avcodec_alloc_context3(codec);
+    bool opened = m_codecCtx && avcodec_parameters_to_context(m_codecCtx, params) >= 0;
+    avcodec_parameters_free(&params);
+    if (opened) {
+        if (m_isLiveCapture) m_codecCtx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        else                 ApplyThreading();
+        opened = avcodec_open2(m_codecCtx, codec, nullptr) >= 0;
+    }
+    if (!opened) {
+        FreeCodec();
+        return false;
     }
-    m_audioStreamIdx  = -1;
-    m_audioSampleRate = 0;
-    m_audioChannels   = 0;
-    m_audioPending.clear();
+    m_activeThreadCount = m_codecCtx->thread_count;
+    m_activeThreadType  = m_codecCtx->active_thread_type;
+    m_pixelFormat       = m_codecCtx->pix_fmt;
+    m_hwStatus          = HwStatus::FellBack;
+    m_hwFallbackError   = error;
+    ++m_hwFallbacks;
+
+    // The packets already sent are gone: files restart at the keyframe before the
+    // next frame, live streams at their next keyframe
+    if (m_formatCtx && !m_isLiveCapture) {
+        const double next = m_currentTime + (m_fps > 0.0 ? 1.0 / m_fps : 0.0);
+        SeekToTimeExact(next);
+    } else {
+        m_keyframeGate = true;
+    }
+    return true;
 }
 
-void VideoDecoder::DecodeAudioPacket() {
-    // m_packet is already filled with an audio packet.
-    if (avcodec_send_packet(m_audioCtx, m_packet) < 0) {
-        av_packet_unref(m_packet);
-        return;
+const char* VideoDecoder::GetHardwareStatusName(HwStatus status) {
+    switch (status) {
+    case HwStatus::Hardware:    return "D3D11VA";
+    case HwStatus::Policy:      return "software by policy";
+    case HwStatus::Unsupported: return "GPU lacks this profile/size";
+    case HwStatus::FellBack:    return "fell back after a hardware error";
+    default:                    return "software";
     }
-    av_packet_unref(m_packet);
+}
 
-    // Drain all decoded frames.
-    while (avcodec_receive_frame(m_audioCtx, m_audioFrame) == 0) {
-        // Convert to mono float via SWR.
-        // Output is planar float (AV_SAMPLE_FMT_FLTP), channel 0 = mono mix.
-        int outSamples = swr_get_out_samples(m_swrCtx, m_audioFrame->nb_samples);
-        if (outSamples <= 0) {
-            av_frame_unref(m_audioFrame);
-            continue;
-        }
-        // Allocate temporary output buffer.
-        std::vector<float> tmp(outSamples);
-        uint8_t* outBuf = reinterpret_cast<uint8_t*>(tmp.data());
-        int converted = swr_convert(m_swrCtx, &outBuf, outSamples,
-                                    const_cast<const uint8_t**>(m_audioFrame->data),
-                                    m_audioFrame->nb_samples);
-        // SWR outputs mono (AV_CHANNEL_LAYOUT_MONO), so tmp holds the mono plane.
-        if (converted > 0)
-            m_audioPending.insert(m_audioPending.end(), tmp.begin(), tmp.begin() + converted);
-        av_frame_unref(m_audioFrame);
-    }
-}
-
-void VideoDecoder::ReadAudioAhead(int targetSamples) {
-    if (!IsOpen() || m_audioStreamIdx < 0 || !m_audioCtx) return;
-
-    m_audioEOFReached = false;
-    while (static_cast<int>(m_audioPending.size()) < targetSamples) {
-        int ret = av_read_frame(m_formatCtx, m_packet);
-        if (ret < 0) {
-            if (ret == AVERROR_EOF)
-                m_audioEOFReached = true;
-            break;
+AVPixelFormat VideoDecoder::GetHardwareFormat(AVCodecContext* ctx, const AVPixelFormat* formats) {
+    VideoDecoder* self = static_cast<VideoDecoder*>(ctx->opaque);
+
+    for (const AVPixelFormat* p = formats; *p != AV_PIX_FMT_NONE; ++p) {
+        if (*p == AV_PIX_FMT_D3D11 && self->InitHardwareFrames(ctx)) {
+            self->m_hwActive = true;
+            return AV_PIX_FMT_D3D11;
         }
+    }
 
-        if (m_packet->stream_index == m_audioStreamIdx) {
-            DecodeAudioPacket();  // decodes + unrefs m_packet
-        } else if (m_packet->stream_index == m_videoStreamIdx) {
-            // Queue the video packet for DecodeNextFrame to consume later.
-            m_videoPktQueue.push(av_packet_clone(m_packet));
-            av_packet_unref(m_packet);
-        } else {
-            av_packet_unref(m_packet);
+    // No usable hardware format (unsupported profile or surface format):
+    // fall back to the first software format the decoder offers.
+    self->m_hwActive = false;
+    for (const AVPixelFormat* p = formats; *p != AV_PIX_FMT_NONE; ++p) {
+        const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(*p);
+        if (desc && !(desc->flags & AV_PIX_FMT_FLAG_HWACCEL)) {
+            return *p;
         }
     }
+    return AV_PIX_FMT_NONE;
 }
 
-bool VideoDecoder::InitHardwareDecoder(ID3D11Device* device) {
-    // Create hardware device context for D3D11VA
-    AVBufferRef* hwDeviceCtx = nullptr;
-    
-    if (av_hwdevice_ctx_create(&hwDeviceCtx, AV_HWDEVICE_TYPE_D3D11VA, nullptr, nullptr, 0) < 0) {
+bool VideoDecoder::InitHardwareFrames(AVCodecContext* ctx) {
+    AVBufferRef* framesRef = nullptr;
+    if (avcodec_get_hw_frames_parameters(ctx, ctx->hw_device_ctx, AV_PIX_FMT_D3D11, &framesRef) < 0) {
         return false;
     }
 
-    // If we have an existing D3D11 device, we could set it here
-    // For now, let FFmpeg create its own device
+    AVHWFramesContext* frames = reinterpret_cast<AVHWFramesContext*>(framesRef->data);
 
-    m_hwDeviceCtx = hwDeviceCtx;
-    m_codecCtx->hw_device_ctx = av_buffer_ref(m_hwDeviceCtx);
-    
+    // The renderer's conversion shader handles 8-bit NV12 and 10-bit P010 only.
+    if (frames->sw_format != AV_PIX_FMT_NV12 && frames->sw_format != AV_PIX_FMT_P010) {
+        av_buffer_unref(&framesRef);
+        return false;
+    }
+
+    // Decode targets only by default — the surfaces must also be sampleable.
+    AVD3D11VAFramesContext* d3d11Frames = static_cast<AVD3D11VAFramesContext*>(frames->hwctx);
+    d3d11Frames->BindFlags |= D3D11_BIND_SHADER_RESOURCE;
+
+    // The default pool covers the decoder's reference frames only. Frames held by
+    // the application (current frame, anything queued ahead) need extra surfaces,
+    // otherwise the decoder stalls waiting for one to be released.
+    frames->initial_pool_size += MAX_FRAME_QUEUE_SIZE + 2;
+
+    if (av_hwframe_ctx_init(framesRef) < 0) {
+        av_buffer_unref(&framesRef);
+        return false;
+    }
+
+    av_buffer_unref(&ctx->hw_frames_ctx);
+    ctx->hw_frames_ctx = framesRef;
     return true;
 }
 
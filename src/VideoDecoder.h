@@ -1,6 +1,13 @@
 #pragma once
 
 #include "Common.h"
+#include "FramePool.h"
+#include "HardwareDecodeCaps.h"
+#include "ImageSequence.h"
+#include "MediaIO.h"
+#include "NetworkSource.h"
+#include "SeekIndex.h"
+#include <chrono>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -10,7 +17,6 @@ extern "C" {
 #include <libavutil/hwcontext.h>
 #include <libavutil/hwcontext_d3d11va.h>
 #include <libswscale/swscale.h>
-#include <libswresample/swresample.h>
 }
 
 namespace SP {
@@ -25,22 +31,95 @@ public:
     VideoDecoder& operator=(const VideoDecoder&) = delete;
 
     // File operations
-    bool Open(const std::string& filepath);
+    // `probed` is a context from MediaProbe and `io` its custom I/O (ownership of
+    // both passes to the decoder, even on failure); nullptr probes synchronously
+    // with FFmpeg's defaults and its own file protocol.
+    bool Open(const std::string& filepath, AVFormatContext* probed = nullptr,
+              std::unique_ptr<MediaIO> io = nullptr);
     void Close();
-    bool IsOpen() const { return m_formatCtx != nullptr; }
+    bool IsOpen() const { return m_formatCtx != nullptr || m_network != nullptr; }
 
-    // Live capture: dshow webcam (isDshow=true) or any URL (isDshow=false, e.g. rtsp://)
-    bool OpenCapture(const std::string& deviceOrUrl, bool isDshow = true);
+    // Live capture: dshow webcam (isDshow=true) or any URL (isDshow=false, e.g. rtsp://).
+    // `mode` (dshow only) asks for that size, rate and native format, falling back
+    // to 1280x720@30 and then to the device's default.
+    bool OpenCapture(const std::string& deviceOrUrl, bool isDshow = true, const CaptureMode* mode = nullptr);
+    // Live network stream (NetworkSource): returns at once; the demux thread
+    // connects, buffers `jitterMs` and reconnects on its own. The codec opens,
+    // D3D11VA when a device is shared, with the first packet of each connection.
+    // `tcp` = RTSP over TCP instead of UDP. Width, height and fps are 0/30 until then.
+    bool OpenNetwork(const std::string& url, int jitterMs, bool tcp);
+    const NetworkSource* GetNetworkSource() const { return m_network.get(); }
     bool IsLiveCapture() const { return m_isLiveCapture; }
+    // Live capture: the last DecodeNextFrame returned false only because the
+    // non-blocking demuxer had no packet yet (as opposed to end of stream / error).
+    bool WouldBlock() const { return m_wouldBlock; }
+    // Live capture: when the packet behind the last decoded frame was read
+    std::chrono::steady_clock::time_point GetLastPacketTime() const { return m_lastPacketTime; }
 
     // Decoding
     bool DecodeNextFrame(VideoFrame& outFrame);
+    // Fast seek: the next DecodeNextFrame returns the keyframe at or before `seconds`.
     bool SeekToTime(double seconds);
+    // Exact seek: the next DecodeNextFrame returns the frame on screen at `seconds`
+    // (or frame `frameNumber`). Jumps to the preceding keyframe — from the seek
+    // index once built — and decodes forward, discarding frames without conversion.
+    bool SeekToTimeExact(double seconds);
     bool SeekToFrame(int64_t frameNumber);
+    // Realtime catch-up, no seek: decoded frames before `seconds` are dropped
+    // without conversion. Needs the decoder lock like any other decoder call.
+    void DiscardUntil(double seconds);
+    bool IsCatchingUp() const { return m_catchingUp; }
+    // Any thread: abandon the discard towards a seek target that DecodeNextFrame
+    // is running, so the next seek gets the decoder lock without waiting out a
+    // superseded one. That call returns false with WasSeekCancelled set; the next
+    // seek clears the request.
+    void CancelSeek() { m_cancelSeek.store(true, std::memory_order_relaxed); }
+    bool WasSeekCancelled() const { return m_seekCancelled; }
+    // Skip decoding non-reference frames (AVDISCARD_NONREF) to decode faster than
+    // realtime. Safe to toggle while decoding; applies from the next packet.
+    void SetSkipNonReference(bool skip) { m_skipNonRef = skip; }
+    bool IsSkippingNonReference() const { return m_skipNonRef; }
+    // Decode keyframes only (fast forward): other packets are dropped before the
+    // codec sees them. Safe to toggle while decoding; after turning it off, decoding
+    // resumes at the next keyframe.
+    void SetKeyframesOnly(bool enabled) { m_keyframesOnly = enabled; }
+    bool IsKeyframesOnly() const { return m_keyframesOnly; }
+    int64_t GetDiscardedFrames() const { return m_framesDiscarded.load(); }  // By DiscardUntil
+    // Timestamp of the frame on screen at `seconds` (exact once the seek index is
+    // ready, otherwise snapped to the nominal frame grid).
+    double SnapToFrameTime(double seconds) const;
 
-    // Video properties
+    // Frame numbering (exact once the seek index is ready, otherwise the nominal
+    // fps grid). GetKeyframeBefore returns -1 when keyframe positions are unknown.
+    int64_t FrameNumberAt(double seconds) const;
+    int64_t GetKeyframeBefore(int64_t frameNumber) const;
+    int64_t GetTotalFrames() const;
+
+    // Background keyframe/PTS index (not built for intra-only codecs)
+    const SeekIndex& GetSeekIndex() const { return m_seekIndex; }
+    // Off for jobs that only read front to back (proxy transcodes). Applies on Open().
+    void SetSeekIndexEnabled(bool enabled) { m_seekIndexEnabled = enabled; }
+    bool IsIntraOnly() const { return m_intraOnly; }
+
+    // Proxy playback: frames come out at 1/scale size (1, 2 or 4), decoded at
+    // reduced resolution where the codec supports lowres and downscaled during
+    // conversion otherwise. Takes effect on the next Open(); files only.
+    void SetProxyScale(int scale);
+    int  GetProxyScale() const { return m_proxyScale; }
+    int  GetLowresLevel() const { return m_codecCtx ? m_codecCtx->lowres : 0; }
+
+    // Image sequences: opening one numbered still (frame_0001.png) plays all of
+    // its siblings at `fps` through an ImageSequence worker pool; `cacheMB` is the
+    // RAM-cached budget. Takes effect on the next Open().
+    void SetImageSequenceOptions(double fps, int cacheMB);
+    const ImageSequence* GetImageSequence() const { return m_sequence.get(); }
+
+    // Video properties. Width/height are the output (proxy) size, source
+    // width/height the stream's own.
     int GetWidth() const { return m_width; }
     int GetHeight() const { return m_height; }
+    int GetSourceWidth() const { return m_sourceWidth; }
+    int GetSourceHeight() const { return m_sourceHeight; }
     double GetFPS() const { return m_fps; }
     double GetDuration() const { return m_duration; }
     int64_t GetFrameCount() const { return m_frameCount; }
@@ -48,49 +127,105 @@ public:
     AVPixelFormat GetPixelFormat() const { return m_pixelFormat; }
     std::string GetCodecName() const { return m_codecName; }
 
-    // Audio stream (optional — not all videos have audio)
-    bool HasAudio() const { return m_audioStreamIdx >= 0; }
-    int  GetAudioSampleRate() const { return m_audioSampleRate; }
-    int  GetAudioChannels()   const { return m_audioChannels; }
 
-    // Drain accumulated decoded audio samples (mono float, interleaved if channels>1
-    // but we always emit mono after SWR conversion). Returns number of floats written.
-    int DrainAudioSamples(float* buf, int maxFloats);
+    // Hardware acceleration. SetHardwareDevice shares the renderer's device with
+    // D3D11VA so decoded surfaces can be sampled directly; nullptr = software only.
+    // Takes effect on the next Open().
+    void SetHardwareDevice(ID3D11Device* device) { m_sharedDevice = device; }
+    bool IsHardwareAccelerated() const { return m_hwActive; }
+    // Startup probe results and the per-codec policy (AppConfig::hwDecodePolicy by
+    // codec name). Auto with caps set tries D3D11VA only where they say the stream
+    // fits; without caps get_format decides as before. Take effect on the next Open().
+    void SetHardwareDecodeCaps(const HardwareDecodeCaps* caps) { m_hwCaps = caps; }
+    void SetHardwareDecodePolicy(std::unordered_map<std::string, HwDecodePolicy> policy) { m_hwPolicy = std::move(policy); }
+    // Why the open stream decodes where it does. FellBack: a decode error on the
+    // hardware path reopened the codec in threaded software decode and playback
+    // went on from the next frame (files) or keyframe (live).
+    enum class HwStatus { Software, Hardware, Policy, Unsupported, FellBack };
+    HwStatus GetHardwareStatus() const { return m_hwActive ? HwStatus::Hardware : m_hwStatus.load(); }
+    static const char* GetHardwareStatusName(HwStatus status);
+    // Mid-stream fallbacks since construction (never reset, so a watcher misses none)
+    // and the AVERROR behind the last one
+    int GetHardwareFallbacks() const { return m_hwFallbacks; }
+    int GetHardwareFallbackError() const { return m_hwFallbackError; }
 
-    // Read ahead for audio: call av_read_frame in a loop, decode audio packets
-    // eagerly, queue video packets for later consumption by DecodeNextFrame.
-    // Stops when m_audioPending.size() >= targetSamples or EOF.
-    void ReadAudioAhead(int targetSamples);
+    // Software frames in supported YUV formats are emitted as native planes for
+    // the renderer's GPU conversion pass instead of sws_scale'd RGBA, and packed
+    // RGBA/BGRA/BGR0/RGBA64 frames at the output size as the decoder's own buffer
+    // (the renderer uploads them in a matching texture format). Safe to toggle
+    // while decoding; applies from the next frame.
+    void SetGpuYuvConversion(bool enabled) { m_gpuYuv = enabled; }
+    bool IsGpuYuvFrame() const { return !IsPackedLayout(m_lastLayout); }
+    bool IsPassthroughFrame() const { return m_lastPassthrough; }  // Packed RGB, no sws_scale
 
-    // True if the last ReadAudioAhead call hit AVERROR_EOF before filling the
-    // requested samples. Cleared by FlushDecoder (SeekToTime / Close).
-    bool AudioEOFReached() const { return m_audioEOFReached; }
+    // Copy D3D11VA frames to system memory instead of referencing the decoder's
+    // surface. Needed when frames are held longer than the pool allows (reverse
+    // playback keeps whole GOPs). Safe to toggle while decoding.
+    void SetDownloadHardwareFrames(bool enabled) { m_downloadHw = enabled; }
+    ID3D11Device* GetD3D11Device() const;
 
+    // Read-ahead / mapped file I/O of the open file (nullptr for captures, URLs,
+    // and files FFmpeg reads itself). Stats are safe to read from the UI.
+    const MediaIO* GetIO() const { return m_io.get(); }
 
-    // Hardware acceleration
-    bool IsHardwareAccelerated() const { return m_hwDeviceCtx != nullptr; }
-    ID3D11Device* GetD3D11Device() const;
+    // libavcodec threading (AppConfig::decodeThreadCount/Type semantics: count 0 =
+    // auto, type 0 = frame+slice, 1 = frame, 2 = slice). Takes effect on the next
+    // Open(). The getters report what the codec actually enabled.
+    void SetDecodeThreading(int threadCount, int threadType);
+    int  GetActiveThreadCount() const { return m_activeThreadCount; }
+    const char* GetActiveThreadTypeName() const;
+
+    // Wall time per decoded frame (demux + decode + conversion), in milliseconds.
+    // Updated on whichever thread decodes; safe to read from the UI.
+    float GetLastDecodeMs() const { return m_lastDecodeMs; }
+    float GetAverageDecodeMs() const { return m_avgDecodeMs; }
+
+    friend struct MicroBenchAccess;  // ShaderPlayerMicroBench times the private hot paths
 
 private:
     bool InitHardwareDecoder(ID3D11Device* device);
+    static AVPixelFormat GetHardwareFormat(AVCodecContext* ctx, const AVPixelFormat* formats);
+    bool InitHardwareFrames(AVCodecContext* ctx);
+    bool WantsHardware(const AVCodecParameters* params);  // Policy and caps; records m_hwStatus
+    bool FallBackToSoftware(int error);  // Decode thread: reopen the codec without D3D11VA
     bool ConvertFrame(AVFrame* frame, VideoFrame& outFrame);
+    bool WrapHardwareFrame(AVFrame* frame, VideoFrame& outFrame);
+    bool WrapSoftwareFrame(AVFrame* frame, FrameLayout layout, VideoFrame& outFrame);
+    void SetProxyOutputSize(const AVFrame* frame, VideoFrame& outFrame) const;
     void FlushDecoder();
-    void OpenAudioStream();   // Called from Open(); non-fatal if no audio stream
-    void CloseAudioStream();
-    void DecodeAudioPacket(); // Sends m_packet to audio codec, drains frames into m_audioPending
-    void FlushVideoQueue();   // Free all queued video packets
+    void ApplyThreading();    // Before avcodec_open2
+    bool SeekToPts(int64_t targetPts, int64_t keyframePts);
+    void RecordDecodeTime(std::chrono::steady_clock::time_point start);
+    bool OpenNetworkCodec();  // Decode thread: for the connection behind GetGeneration
+    void FreeCodec();
 
     AVFormatContext* m_formatCtx = nullptr;
+    std::unique_ptr<MediaIO> m_io;  // m_formatCtx->pb; closed after the context
+    std::unique_ptr<NetworkSource> m_network;  // Replaces m_formatCtx for OpenNetwork
+    uint64_t m_networkGeneration = 0;          // Connection the codec was opened for
+    AVRational m_timeBase{1, 1};               // Of the video stream
     AVCodecContext* m_codecCtx = nullptr;
     AVBufferRef* m_hwDeviceCtx = nullptr;
+    ComPtr<ID3D11Device> m_sharedDevice;
+    std::atomic<bool> m_hwActive{false};  // get_format picked AV_PIX_FMT_D3D11 (set on the decode thread)
+    const HardwareDecodeCaps* m_hwCaps = nullptr;
+    std::unordered_map<std::string, HwDecodePolicy> m_hwPolicy;
+    std::atomic<HwStatus> m_hwStatus{HwStatus::Software};  // While not m_hwActive
+    std::atomic<int> m_hwFallbacks{0};
+    std::atomic<int> m_hwFallbackError{0};
     SwsContext* m_swsCtx = nullptr;
     AVFrame* m_frame = nullptr;
-    AVFrame* m_hwFrame = nullptr;
+    AVFrame* m_swFrame = nullptr;  // System-memory copy of a hardware frame (m_downloadHw)
     AVPacket* m_packet = nullptr;
+    std::atomic<bool> m_downloadHw{false};
 
     int m_videoStreamIdx = -1;
     int m_width = 0;
     int m_height = 0;
+    int m_sourceWidth = 0;
+    int m_sourceHeight = 0;
+    int m_proxyScale = 1;
+    int m_proxyResidual = 1;  // Proxy factor left after lowres, applied on output
     double m_fps = 0.0;
     double m_duration = 0.0;
     int64_t m_frameCount = 0;
@@ -98,25 +233,43 @@ private:
     AVPixelFormat m_pixelFormat = AV_PIX_FMT_NONE;
     std::string m_codecName;
     bool m_isLiveCapture = false;
+    bool m_wouldBlock = false;
+    std::chrono::steady_clock::time_point m_lastPacketTime{};
+
+    // Decoder threading + per-frame timing
+    int m_threadCount = 0;
+    int m_threadType  = 0;
+    int m_activeThreadCount = 1;
+    int m_activeThreadType  = 0;  // FF_THREAD_* bits chosen by the codec
+    std::atomic<float> m_lastDecodeMs{0.0f};
+    std::atomic<float> m_avgDecodeMs{0.0f};
+
+    // Exact seeking
+    SeekIndex m_seekIndex;
+    bool      m_intraOnly = false;
+    bool      m_seekIndexEnabled = true;
+    int64_t   m_seekTargetPts = AV_NOPTS_VALUE;  // Discard decoded frames before this
+    std::atomic<bool> m_cancelSeek{false};       // CancelSeek, cleared by FlushDecoder
+    bool      m_seekCancelled = false;           // The last DecodeNextFrame stopped for it
+
+    // Image sequence playback (replaces the codec path while set)
+    std::unique_ptr<ImageSequence> m_sequence;
+    double m_sequenceFps     = 24.0;
+    int    m_sequenceCacheMB = 4096;
+
+    // Realtime catch-up (audio-master sync) and fast-forward decode skipping
+    std::atomic<bool>    m_catchingUp{false};  // m_seekTargetPts came from DiscardUntil
+    std::atomic<bool>    m_skipNonRef{false};
+    std::atomic<bool>    m_keyframesOnly{false};  // Variable-speed fast forward
+    bool                 m_keyframeGate = false;  // Decode thread: drop packets until a keyframe
+    std::atomic<int64_t> m_framesDiscarded{0};
 
     // For YUV to RGB conversion
     AVPixelFormat m_outputFormat = AV_PIX_FMT_RGBA;
-    std::vector<uint8_t> m_conversionBuffer;
-
-    // Audio stream (optional)
-    int              m_audioStreamIdx  = -1;
-    int              m_audioSampleRate = 0;
-    int              m_audioChannels   = 0;
-    AVCodecContext*  m_audioCtx        = nullptr;
-    SwrContext*      m_swrCtx          = nullptr;
-    AVFrame*         m_audioFrame      = nullptr;
-    std::vector<float> m_audioPending; // accumulated mono-float samples awaiting drain
-
-    // Video packet queue — populated by ReadAudioAhead(), consumed by DecodeNextFrame().
-    // Entries are av_packet_clone()'d; caller must av_packet_free() on pop.
-    std::queue<AVPacket*> m_videoPktQueue;
-
-    bool m_audioEOFReached = false;
+    std::atomic<bool> m_gpuYuv{true};
+    std::atomic<FrameLayout> m_lastLayout{FrameLayout::RGBA8};  // Layout of the last software frame
+    std::atomic<bool> m_lastPassthrough{false};  // It was packed RGB wrapped or copied without sws_scale
+    FramePool m_framePool;  // RGBA output blocks, owned by the VideoFrames they fill
 };
 
 } // namespace SP
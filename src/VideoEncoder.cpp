@@ -1,8 +1,264 @@
 #include "VideoEncoder.h"
+#include "PixelCopy.h"
+#include "TraceRecorder.h"
+#include "ThreadPriority.h"
+#include <d3d10.h>
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+#include <libavutil/hwcontext_d3d11va.h>
+}
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <future>
 #include <stdexcept>
 
 namespace SP {
 
+namespace {
+
+// FFmpeg encoders fed with D3D11 NV12 surfaces
+constexpr const char* HARDWARE_CODECS[] = {
+    "h264_nvenc", "hevc_nvenc", "h264_qsv", "hevc_qsv", "h264_amf", "hevc_amf"
+};
+
+// Encoder surfaces: frames queued for the encoder thread plus those the GPU
+// encoder holds in flight
+constexpr int HW_SURFACE_POOL_SIZE = 24;
+
+// The codec's own threads share the cores; half of them (up to this) slice the
+// swscale conversion
+constexpr int MAX_SCALER_THREADS = 8;
+
+// libx264 tuning per ENCODER_PROFILE_*
+struct X264Profile {
+    const char* name;
+    const char* preset;     // Null = RecordingSettings::preset
+    const char* tune;
+    int    bFrames;
+    int    lookahead;       // rc-lookahead in frames; -1 = the preset's
+    bool   slicedThreads;   // Each frame split across the cores instead of a frame per thread
+    double gopSeconds;
+};
+constexpr X264Profile X264_PROFILES[] = {
+    { "Custom",   nullptr,  "film",        0, -1, false, 1.0 },
+    { "Realtime", "faster", "zerolatency", 0,  0, true,  1.0 },
+    { "Quality",  "medium", "film",        3, 40, false, 2.0 },
+    { "Archive",  "slow",   "film",        4, 60, false, 4.0 },
+};
+static_assert(static_cast<int>(std::size(X264_PROFILES)) == ENCODER_PROFILE_COUNT, "one entry per profile");
+
+// Load control: bitrate steps as shares of RecordingSettings::bitrate. Down a
+// step when the queue is half full or the smoothed encoder-thread time per
+// frame passes LOAD_BUSY_HIGH of the frame interval, at most every
+// LOAD_STEP_DOWN_SECONDS so a step shows its effect first; back up one after
+// LOAD_STEP_UP_SECONDS of an empty queue and time under LOAD_BUSY_LOW.
+constexpr const char* LOAD_ADAPTIVE_CODECS[] = { "libx264", "h264_nvenc", "hevc_nvenc", "h264_qsv", "hevc_qsv" };
+constexpr double LOAD_BITRATE_STEPS[]   = { 1.0, 0.75, 0.55, 0.4 };
+constexpr int    LOAD_QUEUE_HIGH        = ENCODER_QUEUE_SIZE / 2;
+constexpr double LOAD_BUSY_HIGH         = 0.9;
+constexpr double LOAD_BUSY_LOW          = 0.6;
+constexpr double LOAD_SMOOTHING         = 0.1;  // EMA weight of the newest frame
+constexpr double LOAD_STEP_DOWN_SECONDS = 0.5;
+constexpr double LOAD_STEP_UP_SECONDS   = 5.0;
+
+// Converted frames the codec may hold at once (B-frames, lookahead) before a
+// conversion falls back to copying a held frame away
+constexpr int MAX_CODEC_FRAMES = 16;
+
+// Calibration: encode time per profile and its frame cap; distinct synthetic
+// frames cycled (more than x264's reference frames, so motion search never
+// finds an exact copy); the margin over the target fps a recommended profile
+// needs, for the render and readback sharing the cores during a take
+constexpr double CALIBRATION_SECONDS       = 1.0;
+constexpr int    CALIBRATION_MAX_FRAMES    = 240;
+constexpr int    CALIBRATION_SOURCE_FRAMES = 8;
+constexpr double CALIBRATION_HEADROOM      = 1.25;
+constexpr double CALIBRATION_DEFAULT_FPS   = 60.0;
+
+// Lossless intermediate encoders, fed RGB so a take is bit-exact to the render
+constexpr const char* LOSSLESS_CODECS[] = { "ffv1", "utvideo", "libx264rgb" };
+
+// FFV1 slice counts it accepts at level 3; the first at or above the core count is used
+constexpr int FFV1_SLICE_COUNTS[] = { 4, 6, 9, 12, 16, 24 };
+
+// Fragmented MP4/MOV: shortest fragment, so all-intra codecs (ProRes) don't get
+// a fragment per frame
+constexpr int64_t MIN_FRAGMENT_US = 1000000;
+
+// Streaming: send queue, in seconds of the target bitrate, before packets drop
+constexpr double STREAM_QUEUE_SECONDS = 1.0;
+constexpr size_t MIN_STREAM_QUEUE_BYTES = 256 * 1024;
+
+// Audio track: AAC bitrate (stereo), and samples per PCM frame (PCM has no frame size)
+constexpr int64_t AUDIO_BITRATE = 192000;
+constexpr int PCM_FRAME_SIZE = 1024;
+
+// AVBuffer over a FramePool block, so an AVFrame can point at it without a copy.
+// It holds its own reference; the block returns to the pool once the codec
+// releases the frame.
+AVBufferRef* WrapBlock(const FrameBuffer& block, size_t size) {
+    auto* holder = new FrameBuffer(block);
+    AVBufferRef* ref = av_buffer_create(
+        block.get(), size,
+        [](void* opaque, uint8_t*) { delete static_cast<FrameBuffer*>(opaque); },
+        holder, AV_BUFFER_FLAG_READONLY);
+    if (!ref) delete holder;
+    return ref;
+}
+
+float MsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+AVPixelFormat PixelFormatFor(ReadbackLayout layout) {
+    switch (layout) {
+    case ReadbackLayout::YUV420P:   return AV_PIX_FMT_YUV420P;
+    case ReadbackLayout::YUV422P10: return AV_PIX_FMT_YUV422P10LE;
+    default:                        return AV_PIX_FMT_RGBA;
+    }
+}
+
+// Calibration frame `index`: blocky noise drifting diagonally over a gradient.
+// Flat or still frames would encode far faster than rendered ones.
+void FillCalibrationFrame(AVFrame* frame, int index) {
+    auto hash = [](uint32_t x, uint32_t y) {
+        uint32_t n = x * 0x9E3779B1u ^ y * 0x85EBCA77u;
+        n ^= n >> 15;
+        n *= 0x2C1B3C6Du;
+        return n ^ (n >> 12);
+    };
+    const int shift = index * 6;
+    const int span  = std::max(frame->width + frame->height, 1);
+    for (int y = 0; y < frame->height; ++y) {
+        uint8_t* row = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0];
+        for (int x = 0; x < frame->width; ++x) {
+            const int gradient = (x + y) * 160 / span;
+            const int noise    = static_cast<int>(hash((x + shift) >> 2, (y + shift / 2) >> 2) & 63);
+            row[x] = static_cast<uint8_t>(16 + gradient + noise);
+        }
+    }
+    for (int plane = 1; plane <= 2; ++plane) {
+        for (int y = 0; y < frame->height / 2; ++y) {
+            uint8_t* row = frame->data[plane] + static_cast<ptrdiff_t>(y) * frame->linesize[plane];
+            for (int x = 0; x < frame->width / 2; ++x) {
+                row[x] = static_cast<uint8_t>(96 + (hash((x + shift) >> 3, (y + plane * 7919) >> 3) & 63));
+            }
+        }
+    }
+}
+
+} // namespace
+
+const char* VideoEncoder::ProfileName(int profile) {
+    return X264_PROFILES[std::clamp(profile, 0, ENCODER_PROFILE_COUNT - 1)].name;
+}
+
+EncoderCalibration VideoEncoder::CalibrateProfiles(int width, int height, double targetFps,
+                                                   const std::atomic<bool>* cancel) {
+    EncoderCalibration result;
+    result.width  = width & ~1;
+    result.height = height & ~1;
+    const double fps = targetFps > 0.0 ? targetFps : CALIBRATION_DEFAULT_FPS;
+    const AVCodec* codec = avcodec_find_encoder_by_name("libx264");
+    if (!codec || result.width <= 0 || result.height <= 0) return result;
+    auto cancelled = [cancel] { return cancel && cancel->load(std::memory_order_relaxed); };
+
+    // Never written after this, so a frame the codec still holds is never changed
+    std::vector<AVFrame*> sources;
+    for (int i = 0; i < CALIBRATION_SOURCE_FRAMES; ++i) {
+        AVFrame* frame = av_frame_alloc();
+        if (!frame) break;
+        frame->format = AV_PIX_FMT_YUV420P;
+        frame->width  = result.width;
+        frame->height = result.height;
+        if (av_frame_get_buffer(frame, 0) < 0) {
+            av_frame_free(&frame);
+            break;
+        }
+        FillCalibrationFrame(frame, i);
+        sources.push_back(frame);
+    }
+    AVPacket* packet = av_packet_alloc();
+
+    for (int profile = ENCODER_PROFILE_REALTIME; profile < ENCODER_PROFILE_COUNT && packet &&
+                                                 sources.size() == CALIBRATION_SOURCE_FRAMES && !cancelled();
+         ++profile) {
+        // Set up as InitEncoder sets up a take's codec, through the same profile code
+        VideoEncoder probe;
+        probe.m_width    = result.width;
+        probe.m_height   = result.height;
+        probe.m_fps      = fps;
+        probe.m_codecCtx = avcodec_alloc_context3(codec);
+        if (!probe.m_codecCtx) break;
+        AVCodecContext* ctx = probe.m_codecCtx;
+        ctx->width     = result.width;
+        ctx->height    = result.height;
+        ctx->time_base = AVRational{1, static_cast<int>(fps * 1000)};
+        ctx->framerate = AVRational{static_cast<int>(fps * 1000), 1000};
+        ctx->pix_fmt   = AV_PIX_FMT_YUV420P;
+        RecordingSettings settings;
+        settings.encoderProfile = profile;
+        ctx->bit_rate = settings.bitrate;
+        probe.ApplyX264Profile(settings);
+        if (avcodec_open2(ctx, codec, nullptr) < 0) {
+            avcodec_free_context(&probe.m_codecCtx);
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        int frames = 0;
+        bool ok = true;
+        while (ok && frames < CALIBRATION_MAX_FRAMES && !cancelled() &&
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < CALIBRATION_SECONDS) {
+            AVFrame* frame = sources[frames % CALIBRATION_SOURCE_FRAMES];
+            frame->pts = static_cast<int64_t>(frames) * 1000;
+            ok = avcodec_send_frame(ctx, frame) >= 0;
+            while (ok && avcodec_receive_packet(ctx, packet) >= 0) av_packet_unref(packet);
+            ++frames;
+        }
+        // What lookahead and B-frames held back is part of the cost
+        avcodec_send_frame(ctx, nullptr);
+        while (avcodec_receive_packet(ctx, packet) >= 0) av_packet_unref(packet);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (ok && frames > 0 && seconds > 0.0 && !cancelled()) result.fps[profile] = frames / seconds;
+        avcodec_free_context(&probe.m_codecCtx);
+    }
+
+    av_packet_free(&packet);
+    for (AVFrame*& frame : sources) av_frame_free(&frame);
+
+    // The best quality that keeps up; Realtime is the fastest there is
+    for (int profile = ENCODER_PROFILE_COUNT - 1; profile > ENCODER_PROFILE_REALTIME; --profile) {
+        if (result.fps[profile] >= fps * CALIBRATION_HEADROOM) {
+            result.recommended = profile;
+            break;
+        }
+    }
+    return result;
+}
+
+const char* VideoEncoder::StreamFormatFor(const std::string& url) {
+    if (url.rfind("rtmp://", 0) == 0 || url.rfind("rtmps://", 0) == 0) return "flv";
+    if (url.rfind("srt://", 0) == 0 || url.rfind("udp://", 0) == 0 || url.rfind("rtp://", 0) == 0) return "mpegts";
+    return nullptr;
+}
+
+bool VideoEncoder::IsLosslessCodec(const std::string& codec) {
+    return std::find(std::begin(LOSSLESS_CODECS), std::end(LOSSLESS_CODECS), codec) != std::end(LOSSLESS_CODECS);
+}
+
+bool VideoEncoder::CanAdaptToLoad(const std::string& codec) {
+    return std::find(std::begin(LOAD_ADAPTIVE_CODECS), std::end(LOAD_ADAPTIVE_CODECS), codec) !=
+           std::end(LOAD_ADAPTIVE_CODECS);
+}
+
+bool VideoEncoder::IsHardwareCodec(const std::string& codec) {
+    return std::find(std::begin(HARDWARE_CODECS), std::end(HARDWARE_CODECS), codec) != std::end(HARDWARE_CODECS);
+}
+
 VideoEncoder::VideoEncoder() {
     m_packet = av_packet_alloc();
     if (!m_packet) {
@@ -16,12 +272,15 @@ VideoEncoder::~VideoEncoder() {
         m_recording = false;
         m_stopRequested = true;
         m_queueCV.notify_all();
+        m_spaceCV.notify_all();
     }
     // Join before freeing m_packet: the encoder thread uses m_packet in
     // EncodeFrame/FlushEncoder, so we must not free it until the thread exits.
     if (m_encoderThread.joinable()) {
         m_encoderThread.join();
     }
+    m_sequence.Stop();
+    m_sequence.Join();
     av_packet_free(&m_packet);
 }
 
@@ -36,19 +295,50 @@ bool VideoEncoder::StartRecording(const RecordingSettings& settings, int sourceW
     if (m_encoderThread.joinable()) {
         m_encoderThread.join();
     }
+    m_sequence.Join();
 
     // Use source dimensions/fps if not specified
-    int width = settings.width > 0 ? settings.width : sourceWidth;
-    int height = settings.height > 0 ? settings.height : sourceHeight;
+    // (a downscaled size rounded down to even for 4:2:0)
+    const int downscale = std::max(settings.downscale, 1);
+    int width = settings.width > 0 ? settings.width : (sourceWidth / downscale) & ~1;
+    int height = settings.height > 0 ? settings.height : (sourceHeight / downscale) & ~1;
     double fps = settings.fps > 0 ? static_cast<double>(settings.fps) : sourceFPS;
 
+    // Image sequences bypass the codec: RGBA frames go straight to the writer's
+    // workers, one still per frame
+    m_sequenceMode = ImageSequenceWriter::IsImageSequencePath(settings.outputPath);
+    if (m_sequenceMode) {
+        if (!m_sequence.Start(settings.outputPath, width, height, !settings.dropWhenBehind)) {
+            return false;
+        }
+        m_width = width;
+        m_height = height;
+        m_fps = fps;
+        m_inputLayout = ReadbackLayout::RGBA8;
+        m_hardwareEncoding = false;
+        m_replayMode = false;
+        m_streaming = false;
+        m_recording = true;
+        m_startTime = std::chrono::steady_clock::now();
+        return true;
+    }
+
     if (!InitEncoder(settings, width, height, fps)) {
         return false;
     }
 
+    // Stage timings, and the per-frame CSV next to a local output file
+    m_telemetry.Reset();
+    if (settings.telemetryCsv && !m_streaming && MediaIO::IsLocalPath(settings.outputPath)) {
+        const std::filesystem::path outputPath(settings.outputPath);
+        m_telemetry.OpenCsv((outputPath.parent_path() / outputPath.stem()).string() + "_telemetry.csv");
+    }
+
     m_framesEncoded = 0;
     m_framesDropped = 0;
     m_frameIndex = 0;
+    m_lastPts = -1;
+    m_dropWhenBehind = settings.dropWhenBehind;
     m_stopRequested = false;
     m_recording = true;
     m_startTime = std::chrono::steady_clock::now();
@@ -66,8 +356,20 @@ void VideoEncoder::StopRecording() {
     // handles flush, file close, and resource free — so this call returns
     // immediately and does not block the main thread.
     m_recording = false;
+    if (m_sequenceMode) {
+        m_sequence.Stop();
+        return;
+    }
     m_stopRequested = true;
     m_queueCV.notify_all();
+    m_spaceCV.notify_all();
+}
+
+void VideoEncoder::WaitUntilFinished() {
+    if (!m_recording.load() && m_encoderThread.joinable()) {
+        m_encoderThread.join();
+    }
+    if (!m_recording.load()) m_sequence.Join();
 }
 
 bool VideoEncoder::InitEncoder(const RecordingSettings& settings, int width, int height, double fps) {
@@ -82,24 +384,40 @@ bool VideoEncoder::InitEncoder(const RecordingSettings& settings, int width, int
         ext = settings.outputPath.substr(dotPos + 1);
     }
 
-    const AVOutputFormat* outputFormat = av_guess_format(nullptr, settings.outputPath.c_str(), nullptr);
+    // Rolling segments: "take_000.mp4", "take_001.mp4", ... cut at the first
+    // keyframe past each settings.segmentSeconds
+    // Network streams (SRT/RTMP/UDP) are one endless, unseekable output
+    const char* streamFormat = StreamFormatFor(settings.outputPath);
+    m_streaming      = (streamFormat != nullptr) && settings.replaySeconds <= 0;
+    m_outputPath     = settings.outputPath;
+    m_segmentSeconds = (settings.replaySeconds > 0 || m_streaming) ? 0.0 : std::max(settings.segmentSeconds, 0);
+    m_segmentIndex   = 0;
+    m_segmentOrigin  = 0;
+    const std::string path = SegmentPath(0);
+
+    const AVOutputFormat* outputFormat = streamFormat ? av_guess_format(streamFormat, nullptr, nullptr)
+                                                      : av_guess_format(nullptr, path.c_str(), nullptr);
     if (!outputFormat) {
         return false;
     }
 
     // Allocate format context
-    int ret = avformat_alloc_output_context2(&m_formatCtx, outputFormat, nullptr, settings.outputPath.c_str());
+    int ret = avformat_alloc_output_context2(&m_formatCtx, outputFormat, nullptr, path.c_str());
     if (ret < 0 || !m_formatCtx) {
         return false;
     }
 
-    // Find encoder
+    // Find encoder. Hardware encoders are looked up by name; they are only present
+    // when FFmpeg was built with them, and fail to open without a matching GPU.
+    m_hardwareEncoding = IsHardwareCodec(settings.codec);
     AVCodecID codecId = AV_CODEC_ID_H264;
     if (settings.codec == "prores_ks" || settings.codec == "prores") {
         codecId = AV_CODEC_ID_PRORES;
     }
 
-    const AVCodec* codec = avcodec_find_encoder(codecId);
+    const bool lossless = IsLosslessCodec(settings.codec);
+    const AVCodec* codec = (m_hardwareEncoding || lossless) ? avcodec_find_encoder_by_name(settings.codec.c_str())
+                                                            : avcodec_find_encoder(codecId);
     if (!codec) {
         avformat_free_context(m_formatCtx);
         m_formatCtx = nullptr;
@@ -129,20 +447,69 @@ bool VideoEncoder::InitEncoder(const RecordingSettings& settings, int width, int
     m_codecCtx->time_base = AVRational{1, static_cast<int>(fps * 1000)};
     m_codecCtx->framerate = AVRational{static_cast<int>(fps * 1000), 1000};
     
-    if (codecId == AV_CODEC_ID_PRORES) {
+    // BT.709 limited range, matching both the renderer's GPU conversion and swscale
+    // (configured below), so players don't have to guess
+    m_codecCtx->colorspace      = AVCOL_SPC_BT709;
+    m_codecCtx->color_primaries = AVCOL_PRI_BT709;
+    m_codecCtx->color_trc       = AVCOL_TRC_BT709;
+    m_codecCtx->color_range     = AVCOL_RANGE_MPEG;
+
+    if (m_hardwareEncoding) {
+        if (!InitHardwareFrames(width, height)) {
+            avcodec_free_context(&m_codecCtx);
+            avformat_free_context(m_formatCtx);
+            m_formatCtx = nullptr;
+            return false;
+        }
+        m_codecCtx->pix_fmt       = AV_PIX_FMT_D3D11;
+        m_codecCtx->hw_frames_ctx = av_buffer_ref(m_hwFramesCtx);
+        m_codecCtx->bit_rate      = settings.bitrate;
+        m_codecCtx->gop_size      = static_cast<int>(fps);  // One keyframe per second
+        m_codecCtx->max_b_frames  = 0;  // Low latency; every surface goes back to the pool sooner
+        m_inputLayout = ReadbackLayout::RGBA8;  // Unused: frames never leave the GPU
+    } else if (lossless) {
+        // RGB in, RGB out: swscale only reorders (or splits into planes) the RGBA
+        // readback, in slices. All cores encode; these codecs are cheap per pixel
+        // and memory-bound, so at 4K they keep up where x264 medium can't.
+        const int cores = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        m_inputLayout = ReadbackLayout::RGBA8;
+        m_codecCtx->thread_count = cores;
+        if (settings.codec == "ffv1") {
+            // Intra-only level 3 with per-slice CRCs: slices encode in parallel and
+            // a damaged slice doesn't take the frame with it
+            const int* slices = std::find_if(std::begin(FFV1_SLICE_COUNTS), std::end(FFV1_SLICE_COUNTS),
+                                             [cores](int n) { return n >= cores; });
+            m_codecCtx->pix_fmt  = AV_PIX_FMT_0RGB32;
+            m_codecCtx->gop_size = 1;
+            m_codecCtx->level    = 3;
+            av_opt_set_int(m_codecCtx->priv_data, "slices",
+                           (slices != std::end(FFV1_SLICE_COUNTS)) ? *slices : FFV1_SLICE_COUNTS[std::size(FFV1_SLICE_COUNTS) - 1], 0);
+            av_opt_set_int(m_codecCtx->priv_data, "slicecrc", 1, 0);
+            av_opt_set_int(m_codecCtx->priv_data, "context", 0, 0);
+        } else if (settings.codec == "utvideo") {
+            m_codecCtx->pix_fmt = AV_PIX_FMT_GBRP;
+        } else {
+            // libx264rgb -qp 0 -preset ultrafast: lossless, and the fastest x264 has
+            m_codecCtx->pix_fmt      = AV_PIX_FMT_BGR0;
+            m_codecCtx->gop_size     = static_cast<int>(fps);
+            m_codecCtx->max_b_frames = 0;
+            av_opt_set(m_codecCtx->priv_data, "preset", "ultrafast", 0);
+            av_opt_set_int(m_codecCtx->priv_data, "qp", 0, 0);
+        }
+    } else if (codecId == AV_CODEC_ID_PRORES) {
         m_codecCtx->pix_fmt = AV_PIX_FMT_YUV422P10LE;
+        m_inputLayout = ReadbackLayout::YUV422P10;
         av_opt_set_int(m_codecCtx->priv_data, "profile", settings.proresProfile, 0);
     } else {
         m_codecCtx->pix_fmt = AV_PIX_FMT_YUV420P;
+        m_inputLayout = ReadbackLayout::YUV420P;
         m_codecCtx->bit_rate = settings.bitrate;
         m_codecCtx->gop_size = static_cast<int>(fps);  // One keyframe per second
-        m_codecCtx->max_b_frames = 0;  // No B-frames: each frame is self-contained, sws_scale destination is never cloned
+        m_codecCtx->max_b_frames = 0;
         
-        if (settings.codec == "libx264") {
-            av_opt_set(m_codecCtx->priv_data, "preset", settings.preset.c_str(), 0);
-            av_opt_set(m_codecCtx->priv_data, "tune", "film", 0);
-        }
+        if (settings.codec == "libx264") ApplyX264Profile(settings);
     }
+    if (m_streaming) ApplyStreamingOptions(settings);
 
     // Global header flag
     if (m_formatCtx->oformat->flags & AVFMT_GLOBALHEADER) {
@@ -152,6 +519,7 @@ bool VideoEncoder::InitEncoder(const RecordingSettings& settings, int width, int
     // Open codec
     ret = avcodec_open2(m_codecCtx, codec, nullptr);
     if (ret < 0) {
+        ReleaseHardwareFrames();
         avcodec_free_context(&m_codecCtx);
         avformat_free_context(m_formatCtx);
         m_formatCtx = nullptr;
@@ -159,28 +527,45 @@ bool VideoEncoder::InitEncoder(const RecordingSettings& settings, int width, int
         return false;
     }
 
+    // Realtime takes start at the full bitrate
+    m_loadControl       = settings.adaptToLoad && settings.dropWhenBehind && CanAdaptToLoad(settings.codec) &&
+                          m_codecCtx->bit_rate > 0;
+    m_baseBitrate       = m_codecCtx->bit_rate;
+    m_loadLevel         = 0;
+    m_loadBusyMs        = 0.0;
+    m_loadChanged       = std::chrono::steady_clock::now();
+    m_loadHeadroomSince = {};
+    m_loadScale         = 1.0;
+
     // Copy codec params to stream
     avcodec_parameters_from_context(m_videoStream->codecpar, m_codecCtx);
     m_videoStream->time_base = m_codecCtx->time_base;
 
-    // Open output file
-    if (!(m_formatCtx->oformat->flags & AVFMT_NOFILE)) {
-        ret = avio_open(&m_formatCtx->pb, settings.outputPath.c_str(), AVIO_FLAG_WRITE);
-        if (ret < 0) {
-            avcodec_free_context(&m_codecCtx);
-            avformat_free_context(m_formatCtx);
-            m_formatCtx = nullptr;
-            m_codecCtx = nullptr;
-            return false;
-        }
+    // Instant replay: the format context only chose the codec flags above; nothing
+    // is written until SaveReplay muxes the ring into a file of its own
+    m_replayMode = settings.replaySeconds > 0;
+    if (m_replayMode) {
+        m_replay.Reset(m_videoStream->codecpar, m_videoStream->time_base, settings.replaySeconds,
+                       static_cast<size_t>(std::max(settings.replayBudgetMB, 1)) * 1024 * 1024);
+    } else {
+        m_replay.Clear();
+    }
+
+    // Audio track next to the video; without it (no encoder) the take is video only
+    if (!m_replayMode && settings.recordAudio && m_audioInputRate > 0) {
+        InitAudio(settings);
     }
 
-    // Write header
-    ret = avformat_write_header(m_formatCtx, nullptr);
+    // Open output file and write header
+    m_writeBufferMB = settings.writeBufferMB;
+    m_writeThrough  = settings.writeThrough;
+    m_fragmented    = settings.fragmented;
+    ret = m_replayMode ? 0 : OpenOutput(path);
+    if (ret >= 0 && m_streaming) StartSender(settings.bitrate);
     if (ret < 0) {
-        if (!(m_formatCtx->oformat->flags & AVFMT_NOFILE)) {
-            avio_closep(&m_formatCtx->pb);
-        }
+        CloseOutput();
+        ReleaseAudio();
+        ReleaseHardwareFrames();
         avcodec_free_context(&m_codecCtx);
         avformat_free_context(m_formatCtx);
         m_formatCtx = nullptr;
@@ -188,50 +573,259 @@ bool VideoEncoder::InitEncoder(const RecordingSettings& settings, int width, int
         return false;
     }
 
-    // Destination (encoder) frame
-    m_frame = av_frame_alloc();
-    if (!m_frame) return false;
-    m_frame->format = m_codecCtx->pix_fmt;
-    m_frame->width  = width;
-    m_frame->height = height;
-    if (av_frame_get_buffer(m_frame, 0) < 0) return false;
+    // Hardware frames come from the surface pool; no CPU frame or scaler
+    if (m_hardwareEncoding) return true;
 
-    // Source (RGBA) frame — FFmpeg allocates this with AV_INPUT_BUFFER_PADDING_SIZE
-    // extra bytes per plane, guaranteeing swscale's SIMD/chroma read-ahead can't
-    // stray into an unmapped page regardless of dimension alignment.
-    m_srcFrame = av_frame_alloc();
-    if (!m_srcFrame) return false;
-    m_srcFrame->format = AV_PIX_FMT_RGBA;
-    m_srcFrame->width  = width;
-    m_srcFrame->height = height;
-    if (av_frame_get_buffer(m_srcFrame, 32) < 0) return false;
+    // The first destination (encoder) frame; the pool grows while the codec holds them
+    m_codecFrameNext = 0;
+    if (!AcquireCodecFrame()) return false;
 
-    // Create swscale context for RGBA -> YUV conversion
-    m_swsCtx = sws_getContext(
-        width, height, AV_PIX_FMT_RGBA,
-        width, height, m_codecCtx->pix_fmt,
-        SWS_BILINEAR, nullptr, nullptr, nullptr
-    );
+    // swscale is only needed for RGBA frames or frames of another size; its
+    // context is created on the first one
+    m_swsSrcWidth  = 0;
+    m_swsSrcHeight = 0;
+    m_swsSrcFormat = AV_PIX_FMT_NONE;
+    return true;
+}
+
+void VideoEncoder::ApplyX264Profile(const RecordingSettings& settings) {
+    const X264Profile& profile = X264_PROFILES[std::clamp(settings.encoderProfile, 0, ENCODER_PROFILE_COUNT - 1)];
+    void* priv = m_codecCtx->priv_data;
+    av_opt_set(priv, "preset", profile.preset ? profile.preset : settings.preset.c_str(), 0);
+    // Streams stay low latency whatever the profile (ApplyStreamingOptions)
+    av_opt_set(priv, "tune", m_streaming ? "zerolatency" : profile.tune, 0);
+    m_codecCtx->gop_size     = std::max(static_cast<int>(std::lround(m_fps * profile.gopSeconds)), 1);
+    m_codecCtx->max_b_frames = profile.bFrames;
+    if (profile.lookahead >= 0 && !m_streaming) av_opt_set_int(priv, "rc-lookahead", profile.lookahead, 0);
 
-    return m_swsCtx != nullptr;
+    // Sliced threads return each frame as soon as it is encoded; x264's default
+    // frame threads are faster overall but keep a frame in flight per thread
+    if (profile.slicedThreads) {
+        m_codecCtx->thread_type  = FF_THREAD_SLICE;
+        m_codecCtx->thread_count = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    }
 }
 
-bool VideoEncoder::SubmitFrame(const std::vector<uint8_t>& rgbaData, int width, int height) {
-    if (!m_recording.load()) return false;
+AVFrame* VideoEncoder::AcquireCodecFrame() {
+    const size_t count = m_codecFrames.size();
+    for (size_t i = 0; i < count; ++i) {
+        const size_t index = (m_codecFrameNext + i) % count;
+        if (av_frame_is_writable(m_codecFrames[index])) {
+            m_codecFrameNext = (index + 1) % count;
+            return m_codecFrames[index];
+        }
+    }
+    if (count < MAX_CODEC_FRAMES) {
+        AVFrame* frame = av_frame_alloc();
+        if (!frame) return nullptr;
+        frame->format = m_codecCtx->pix_fmt;
+        frame->width  = m_width;
+        frame->height = m_height;
+        if (av_frame_get_buffer(frame, 0) < 0) {
+            av_frame_free(&frame);
+            return nullptr;
+        }
+        m_codecFrames.push_back(frame);
+        m_codecFrameNext = 0;  // Oldest first next time
+        return frame;
+    }
+    // All held: the next one gets buffers of its own, the codec keeps the old ones
+    AVFrame* frame = m_codecFrames[m_codecFrameNext];
+    m_codecFrameNext = (m_codecFrameNext + 1) % count;
+    return av_frame_make_writable(frame) >= 0 ? frame : nullptr;
+}
 
-    std::unique_lock<std::mutex> lock(m_queueMutex);
+void VideoEncoder::ReleaseCodecFrames() {
+    for (AVFrame*& frame : m_codecFrames) av_frame_free(&frame);
+    m_codecFrames.clear();
+    m_codecFrameNext = 0;
+}
 
-    // Drop frames if queue is full
-    if (m_frameQueue.size() >= ENCODER_QUEUE_SIZE) {
-        m_framesDropped++;
+bool VideoEncoder::InitHardwareFrames(int width, int height) {
+    if (!m_sharedDevice) return false;
+
+    // Wrap the renderer's device, as VideoDecoder::InitHardwareDecoder does, so the
+    // renderer can draw into the encoder's surfaces directly
+    AVBufferRef* deviceRef = av_hwdevice_ctx_alloc(AV_HWDEVICE_TYPE_D3D11VA);
+    if (!deviceRef) return false;
+    AVHWDeviceContext* deviceCtx = reinterpret_cast<AVHWDeviceContext*>(deviceRef->data);
+    AVD3D11VADeviceContext* d3d11Ctx = static_cast<AVD3D11VADeviceContext*>(deviceCtx->hwctx);
+    m_sharedDevice->AddRef();  // Released by FFmpeg when the device context is freed
+    d3d11Ctx->device = m_sharedDevice.Get();
+    if (av_hwdevice_ctx_init(deviceRef) < 0) {
+        av_buffer_unref(&deviceRef);
         return false;
     }
 
+    // The encoder thread may use the immediate context (QSV/AMF surface mapping)
+    // while the renderer draws; multithread protection serialises the two.
+    ComPtr<ID3D10Multithread> multithread;
+    if (SUCCEEDED(m_sharedDevice->QueryInterface(IID_PPV_ARGS(&multithread)))) {
+        multithread->SetMultithreadProtected(TRUE);
+    }
+
+    AVBufferRef* framesRef = av_hwframe_ctx_alloc(deviceRef);
+    if (!framesRef) {
+        av_buffer_unref(&deviceRef);
+        return false;
+    }
+    AVHWFramesContext* frames = reinterpret_cast<AVHWFramesContext*>(framesRef->data);
+    frames->format            = AV_PIX_FMT_D3D11;
+    frames->sw_format         = AV_PIX_FMT_NV12;
+    frames->width             = width;
+    frames->height            = height;
+    frames->initial_pool_size = HW_SURFACE_POOL_SIZE;
+    // Render targets: the renderer's RGB→NV12 pass writes them
+    AVD3D11VAFramesContext* d3d11Frames = static_cast<AVD3D11VAFramesContext*>(frames->hwctx);
+    d3d11Frames->BindFlags |= D3D11_BIND_RENDER_TARGET;
+    if (av_hwframe_ctx_init(framesRef) < 0) {
+        av_buffer_unref(&framesRef);
+        av_buffer_unref(&deviceRef);
+        return false;
+    }
+
+    m_hwDeviceCtx = deviceRef;
+    m_hwFramesCtx = framesRef;
+    return true;
+}
+
+void VideoEncoder::ReleaseHardwareFrames() {
+    av_buffer_unref(&m_hwFramesCtx);
+    av_buffer_unref(&m_hwDeviceCtx);
+}
+
+bool VideoEncoder::EnsureScaler(int width, int height, AVPixelFormat format) {
+    if (m_swsCtx && m_swsSrcWidth == width && m_swsSrcHeight == height && m_swsSrcFormat == format) {
+        return true;
+    }
+    sws_freeContext(m_swsCtx);
+    m_swsCtx = sws_alloc_context();
+    if (!m_swsCtx) return false;
+
+    // Sliced across threads by sws_scale_frame; swscale's own pool, so nothing
+    // here has to split the frame
+    const int threads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) / 2, 1, MAX_SCALER_THREADS);
+    av_opt_set_int(m_swsCtx, "srcw", width, 0);
+    av_opt_set_int(m_swsCtx, "srch", height, 0);
+    av_opt_set_pixel_fmt(m_swsCtx, "src_format", format, 0);
+    av_opt_set_int(m_swsCtx, "dstw", m_width, 0);
+    av_opt_set_int(m_swsCtx, "dsth", m_height, 0);
+    av_opt_set_pixel_fmt(m_swsCtx, "dst_format", m_codecCtx->pix_fmt, 0);
+    av_opt_set_int(m_swsCtx, "sws_flags", SWS_BILINEAR, 0);
+    av_opt_set_int(m_swsCtx, "threads", threads, 0);
+    if (sws_init_context(m_swsCtx, nullptr, nullptr) < 0) {
+        sws_freeContext(m_swsCtx);
+        m_swsCtx = nullptr;
+        return false;
+    }
+
+    // BT.709 limited range out (swscale defaults to BT.601), as tagged on the stream
+    const int* coefficients = sws_getCoefficients(SWS_CS_ITU709);
+    sws_setColorspaceDetails(m_swsCtx, coefficients, format == AV_PIX_FMT_RGBA ? 1 : 0,
+                             coefficients, 0, 0, 1 << 16, 1 << 16);
+    m_swsSrcWidth  = width;
+    m_swsSrcHeight = height;
+    m_swsSrcFormat = format;
+    return true;
+}
+
+bool VideoEncoder::ConvertRgbaFrame(const AVFrame* src, AVFrame* frame) {
+    // libx264rgb's BGR0 and FFV1's 0RGB32 are the same bytes on little-endian
+    const AVPixelFormat format = m_codecCtx->pix_fmt;
+    if (src->format != AV_PIX_FMT_RGBA || src->width != m_width || src->height != m_height ||
+        (format != AV_PIX_FMT_YUV420P && format != AV_PIX_FMT_NV12 && format != AV_PIX_FMT_BGR0)) {
+        return false;
+    }
+
+    const uint8_t* rgba  = src->data[0];
+    const size_t   pitch = static_cast<size_t>(src->linesize[0]);
+    auto convert = [&](int begin, int end) {
+        if (format == AV_PIX_FMT_BGR0) {
+            SwizzleRgbaBgra(frame->data[0] + static_cast<size_t>(begin) * frame->linesize[0], frame->linesize[0],
+                            rgba + begin * pitch, pitch, m_width, end - begin);
+        } else if (format == AV_PIX_FMT_NV12) {
+            RgbaToNv12(rgba, pitch, m_width, m_height, frame->data[0], frame->linesize[0],
+                       frame->data[1], frame->linesize[1], begin, end);
+        } else {
+            RgbaToI420(rgba, pitch, m_width, m_height, frame->data[0], frame->linesize[0],
+                       frame->data[1], frame->linesize[1], frame->data[2], frame->linesize[2], begin, end);
+        }
+    };
+
+    // Even-height bands, as many as swscale would slice into; the first on this thread
+    const int threads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) / 2, 1, MAX_SCALER_THREADS);
+    const int band = ((m_height + threads - 1) / threads + 1) & ~1;
+    std::vector<std::future<void>> bands;
+    for (int begin = band; begin < m_height; begin += band) {
+        bands.push_back(std::async(std::launch::async, convert, begin, std::min(begin + band, m_height)));
+    }
+    convert(0, std::min(band, m_height));
+    for (std::future<void>& f : bands) f.wait();
+    return true;
+}
+
+bool VideoEncoder::SubmitFrame(FrameBuffer data, int width, int height, ReadbackLayout layout, double timestamp,
+                               float readbackMs) {
+    if (!m_recording.load()) return false;
+    if (m_sequenceMode) return m_sequence.Submit(std::move(data), width, height);
+
     QueuedFrame qf;
-    qf.data = rgbaData;
+    qf.data = std::move(data);
     qf.width = width;
     qf.height = height;
-    m_frameQueue.push(std::move(qf));
+    qf.layout = layout;
+    qf.timestamp = timestamp;
+    qf.readbackMs = readbackMs;
+    return Enqueue(std::move(qf));
+}
+
+bool VideoEncoder::SubmitHardwareFrame(const std::function<bool(ID3D11Texture2D*, int)>& render, double timestamp) {
+    if (!m_recording.load() || !m_hwFramesCtx) return false;
+
+    AVFrame* frame = av_frame_alloc();
+    if (!frame || av_hwframe_get_buffer(m_hwFramesCtx, frame, 0) < 0) {
+        av_frame_free(&frame);
+        m_framesDropped++;  // Every surface is queued or in the encoder
+        return false;
+    }
+
+    // D3D11 frames: data[0] = texture array, data[1] = slice index
+    auto* texture = reinterpret_cast<ID3D11Texture2D*>(frame->data[0]);
+    const int slice = static_cast<int>(reinterpret_cast<intptr_t>(frame->data[1]));
+    if (!render(texture, slice)) {
+        av_frame_free(&frame);
+        m_framesDropped++;
+        return false;
+    }
+
+    QueuedFrame qf;
+    qf.width = m_width;
+    qf.height = m_height;
+    qf.layout = ReadbackLayout::RGBA8;
+    qf.timestamp = timestamp;
+    qf.hwFrame = frame;
+    return Enqueue(std::move(qf));
+}
+
+bool VideoEncoder::Enqueue(QueuedFrame qf) {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+
+    // Realtime capture drops frames when the queue is full; offline jobs wait
+    if (!m_dropWhenBehind) {
+        SP_TRACE_SCOPE("Encoder queue wait");
+        m_spaceCV.wait(lock, [this] {
+            return m_queueCount < ENCODER_QUEUE_SIZE || !m_recording.load();
+        });
+    }
+    if (!m_recording.load() || m_queueCount >= ENCODER_QUEUE_SIZE) {
+        if (m_recording.load()) m_framesDropped++;
+        av_frame_free(&qf.hwFrame);
+        return false;
+    }
+
+    qf.queuedAt = std::chrono::steady_clock::now();
+    m_frameQueue[(m_queueHead + m_queueCount) % ENCODER_QUEUE_SIZE] = std::move(qf);
+    ++m_queueCount;
 
     lock.unlock();
     m_queueCV.notify_one();
@@ -240,64 +834,109 @@ bool VideoEncoder::SubmitFrame(const std::vector<uint8_t>& rgbaData, int width,
 }
 
 void VideoEncoder::EncoderThread() {
+    TraceRecorder::SetThreadName("Encoder");
+    ThreadPriority::Apply(ThreadRole::Background);
     while (true) {
         QueuedFrame qf;
+        FrameTiming timing;
 
         {
             std::unique_lock<std::mutex> lock(m_queueMutex);
             m_queueCV.wait(lock, [this] {
-                return !m_frameQueue.empty() || m_stopRequested.load();
+                return m_queueCount > 0 || m_stopRequested.load();
             });
 
-            if (m_stopRequested.load() && m_frameQueue.empty()) {
+            if (m_stopRequested.load() && m_queueCount == 0) {
                 break;
             }
 
-            if (!m_frameQueue.empty()) {
-                qf = std::move(m_frameQueue.front());
-                m_frameQueue.pop();
+            if (m_queueCount > 0) {
+                qf = std::move(m_frameQueue[m_queueHead]);
+                m_frameQueue[m_queueHead].hwFrame = nullptr;  // Owned by qf now
+                m_queueHead = (m_queueHead + 1) % ENCODER_QUEUE_SIZE;
+                --m_queueCount;
+                timing.queueDepth = m_queueCount;
             } else {
                 continue;
             }
         }
+        m_spaceCV.notify_one();
+        SP_TRACE_SCOPE("Encode frame");
+        timing.ms[static_cast<int>(RecordingStage::Readback)] = qf.readbackMs;
+        timing.ms[static_cast<int>(RecordingStage::Queue)]    = MsSince(qf.queuedAt);
 
-        // Copy pixel data into the FFmpeg-managed source frame row by row.
-        // m_srcFrame was allocated with av_frame_get_buffer which adds
-        // AV_INPUT_BUFFER_PADDING_SIZE (64 bytes) beyond the last row, so
-        // swscale's chroma read-ahead and SIMD overshoot can't reach an
-        // unmapped page — regardless of width/height alignment.
-        const int srcRowBytes = qf.width * 4;
-        for (int y = 0; y < qf.height; ++y) {
-            memcpy(m_srcFrame->data[0] + y * m_srcFrame->linesize[0],
-                   qf.data.data() + y * srcRowBytes,
-                   srcRowBytes);
+        if (qf.hwFrame) {
+            // Already NV12 in the encoder's own surface
+            qf.hwFrame->pts = NextPts(qf.timestamp);
+            if (TimedEncodeFrame(qf.hwFrame, timing)) {
+                m_framesEncoded++;
+            }
+            av_frame_free(&qf.hwFrame);
+            EncodeAudio(false);
+            continue;
         }
 
-        sws_scale(
-            m_swsCtx,
-            m_srcFrame->data, m_srcFrame->linesize,
-            0, qf.height,
-            m_frame->data, m_frame->linesize
-        );
+        const auto convertStart = std::chrono::steady_clock::now();
 
-        // time_base = {1, fps*1000}, so one frame = 1000 time_base units
-        m_frame->pts = static_cast<int64_t>(m_frameIndex++) * 1000LL;
+        // Read straight from the readback block. Its tail padding (see
+        // CollectReadback) keeps swscale's chroma read-ahead and SIMD
+        // overshoot in committed memory regardless of width/height alignment.
+        // The block wrapped as an AVFrame, not copied; the codec or swscale
+        // takes its own reference.
+        const AVPixelFormat srcFormat = PixelFormatFor(qf.layout);
+        const int size = av_image_get_buffer_size(srcFormat, qf.width, qf.height, 1);
+        AVFrame* src = av_frame_alloc();
+        if (!src || size <= 0 || !(src->buf[0] = WrapBlock(qf.data, static_cast<size_t>(size))) ||
+            av_image_fill_arrays(src->data, src->linesize, qf.data.get(), srcFormat, qf.width, qf.height, 1) < 0) {
+            av_frame_free(&src);
+            continue;
+        }
+        src->format = srcFormat;
+        src->width  = qf.width;
+        src->height = qf.height;
 
-        if (EncodeFrame(m_frame)) {
+        if (srcFormat == m_codecCtx->pix_fmt && qf.width == m_width && qf.height == m_height) {
+            // Converted on the GPU: the block already is the codec's frame
+            src->pts = NextPts(qf.timestamp);
+            timing.ms[static_cast<int>(RecordingStage::Convert)] = MsSince(convertStart);
+            if (TimedEncodeFrame(src, timing)) {
+                m_framesEncoded++;
+            }
+            av_frame_free(&src);
+            EncodeAudio(false);
+            continue;
+        }
+
+        // RGBA, or frames rendered at another size (e.g. the last proxy frames
+        // before the source reopens at full size), scaled to the encoder's in
+        // slices across the scaler's threads, into a frame the codec doesn't hold.
+        // RGBA at the encoder's size skips swscale for PixelCopy's conversions.
+        AVFrame* frame = AcquireCodecFrame();
+        const bool scaled = frame &&
+                            (ConvertRgbaFrame(src, frame) ||
+                             (EnsureScaler(qf.width, qf.height, srcFormat) && sws_scale_frame(m_swsCtx, frame, src) >= 0));
+        av_frame_free(&src);
+        if (!scaled) continue;
+
+        frame->pts = NextPts(qf.timestamp);
+        timing.ms[static_cast<int>(RecordingStage::Convert)] = MsSince(convertStart);
+
+        if (TimedEncodeFrame(frame, timing)) {
             m_framesEncoded++;
         }
+        EncodeAudio(false);
     }
 
     // Queue drained. Flush buffered frames out of the codec, write the file
     // trailer, and free all FFmpeg resources. This runs on the encoder thread
     // so the main thread is never blocked by these operations.
     FlushEncoder();
+    EncodeAudio(true);
+    StopSender();  // Sends what is queued; the muxer is the encoder thread's again
 
     if (m_formatCtx) {
-        av_write_trailer(m_formatCtx);
-        if (!(m_formatCtx->oformat->flags & AVFMT_NOFILE)) {
-            avio_closep(&m_formatCtx->pb);
-        }
+        if (!m_replayMode) av_write_trailer(m_formatCtx);
+        CloseOutput();
         avformat_free_context(m_formatCtx);
         m_formatCtx = nullptr;
     }
@@ -305,48 +944,251 @@ void VideoEncoder::EncoderThread() {
         avcodec_free_context(&m_codecCtx);
         m_codecCtx = nullptr;
     }
+    ReleaseAudio();
     if (m_swsCtx) {
         sws_freeContext(m_swsCtx);
         m_swsCtx = nullptr;
     }
-    if (m_frame) {
-        av_frame_free(&m_frame);
-        m_frame = nullptr;
-    }
-    if (m_srcFrame) {
-        av_frame_free(&m_srcFrame);
-        m_srcFrame = nullptr;
-    }
+    ReleaseCodecFrames();
+    ReleaseHardwareFrames();
     m_videoStream = nullptr;
+    m_telemetry.CloseCsv();
     // Reset stop flag last, after all work is done. StartRecording() joins this
     // thread before touching any shared state, so the reset is safe.
     m_stopRequested = false;
 }
 
+int64_t VideoEncoder::NextPts(double timestamp) {
+    // time_base = {1, fps*1000}, so one frame = 1000 time_base units. Source
+    // timestamps are kept strictly increasing for the muxer.
+    int64_t pts = static_cast<int64_t>(m_frameIndex++) * 1000LL;
+    if (timestamp >= 0.0) {
+        pts = std::max(std::llround(timestamp * m_fps * 1000.0), m_lastPts + 1);
+    }
+    m_lastPts = pts;
+    return pts;
+}
+
 bool VideoEncoder::EncodeFrame(AVFrame* frame) {
-    int ret = avcodec_send_frame(m_codecCtx, frame);
+    return Encode(m_codecCtx, frame);
+}
+
+bool VideoEncoder::TimedEncodeFrame(AVFrame* frame, FrameTiming& timing) {
+    // WritePacket adds its own time to m_muxMs; the rest is the codec's
+    m_muxMs = 0.0f;
+    const auto start = std::chrono::steady_clock::now();
+    const bool ok = EncodeFrame(frame);
+    const float elapsed = MsSince(start);
+    timing.ms[static_cast<int>(RecordingStage::Encode)] = std::max(elapsed - m_muxMs, 0.0f);
+    timing.ms[static_cast<int>(RecordingStage::Mux)]    = m_muxMs;
+    m_telemetry.Record(timing);
+    AdaptToLoad(timing);
+    return ok;
+}
+
+void VideoEncoder::AdaptToLoad(const FrameTiming& timing) {
+    if (!m_loadControl) return;
+    const float busyMs = timing.ms[static_cast<int>(RecordingStage::Convert)] +
+                         timing.ms[static_cast<int>(RecordingStage::Encode)] +
+                         timing.ms[static_cast<int>(RecordingStage::Mux)];
+    m_loadBusyMs += LOAD_SMOOTHING * (busyMs - m_loadBusyMs);
+    const double intervalMs = 1000.0 / m_fps;
+    const auto now = std::chrono::steady_clock::now();
+
+    const bool behind   = timing.queueDepth >= LOAD_QUEUE_HIGH || m_loadBusyMs > intervalMs * LOAD_BUSY_HIGH;
+    const bool headroom = timing.queueDepth == 0 && m_loadBusyMs < intervalMs * LOAD_BUSY_LOW;
+    if (!headroom) {
+        m_loadHeadroomSince = {};
+    } else if (m_loadHeadroomSince == std::chrono::steady_clock::time_point{}) {
+        m_loadHeadroomSince = now;
+    }
+
+    if (behind && m_loadLevel + 1 < static_cast<int>(std::size(LOAD_BITRATE_STEPS)) &&
+        std::chrono::duration<double>(now - m_loadChanged).count() >= LOAD_STEP_DOWN_SECONDS) {
+        SetLoadLevel(m_loadLevel + 1, now);
+    } else if (headroom && m_loadLevel > 0 &&
+               std::chrono::duration<double>(now - m_loadHeadroomSince).count() >= LOAD_STEP_UP_SECONDS) {
+        SetLoadLevel(m_loadLevel - 1, now);
+        m_loadHeadroomSince = now;  // Each step up waits out its own interval
+    }
+}
+
+void VideoEncoder::SetLoadLevel(int level, std::chrono::steady_clock::time_point now) {
+    m_loadLevel   = level;
+    m_loadChanged = now;
+    const double scale = LOAD_BITRATE_STEPS[level];
+    const int64_t bitrate = std::llround(static_cast<double>(m_baseBitrate) * scale);
+    // libx264, NVENC and Quick Sync compare these with their current rate control
+    // on the next frame and reconfigure; no keyframe, the stream carries on
+    m_codecCtx->bit_rate = bitrate;
+    if (m_codecCtx->rc_max_rate > 0) {
+        // Streaming CBR: the VBV follows, as ApplyStreamingOptions set it
+        m_codecCtx->rc_min_rate    = bitrate;
+        m_codecCtx->rc_max_rate    = bitrate;
+        m_codecCtx->rc_buffer_size = static_cast<int>(bitrate / 2);
+    }
+    m_loadScale.store(scale, std::memory_order_relaxed);
+}
+
+bool VideoEncoder::Encode(AVCodecContext* codecCtx, AVFrame* frame) {
+    int ret = avcodec_send_frame(codecCtx, frame);
     if (ret < 0) return false;
 
     while (ret >= 0) {
-        ret = avcodec_receive_packet(m_codecCtx, m_packet);
+        ret = avcodec_receive_packet(codecCtx, m_packet);
         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
             break;
         }
         if (ret < 0) return false;
 
-        // Rescale timestamps
-        av_packet_rescale_ts(m_packet, m_codecCtx->time_base, m_videoStream->time_base);
-        m_packet->stream_index = m_videoStream->index;
-
-        ret = av_interleaved_write_frame(m_formatCtx, m_packet);
-        av_packet_unref(m_packet);
-        
-        if (ret < 0) return false;
+        if (!WritePacket(m_packet, codecCtx)) return false;
     }
 
     return true;
 }
 
+bool VideoEncoder::WritePacket(AVPacket* packet, AVCodecContext* codecCtx) {
+    const auto start = std::chrono::steady_clock::now();
+    const bool ok = MuxPacket(packet, codecCtx);
+    m_muxMs += MsSince(start);
+    return ok;
+}
+
+bool VideoEncoder::MuxPacket(AVPacket* packet, AVCodecContext* codecCtx) {
+    const bool video = (codecCtx == m_codecCtx);
+    if (!m_replayMode && m_segmentSeconds > 0.0 && video && (packet->flags & AV_PKT_FLAG_KEY) &&
+        (packet->pts - m_segmentOrigin) * av_q2d(codecCtx->time_base) >= m_segmentSeconds) {
+        // Segments start on a keyframe, so each file plays on its own
+        if (!StartNextSegment(packet->pts)) {
+            av_packet_unref(packet);
+            return false;
+        }
+    }
+    AVStream* stream = video ? m_videoStream : m_audioStream;
+    if (!stream || (!m_replayMode && !m_formatCtx)) {
+        av_packet_unref(packet);
+        return false;
+    }
+
+    // Each segment starts at 0; audio encoded before the cut belongs to the last one
+    if (m_segmentOrigin != 0) {
+        const int64_t origin = av_rescale_q(m_segmentOrigin, m_codecCtx->time_base, codecCtx->time_base);
+        if (packet->pts != AV_NOPTS_VALUE && packet->pts < origin) {
+            av_packet_unref(packet);
+            return true;
+        }
+        if (packet->pts != AV_NOPTS_VALUE) packet->pts -= origin;
+        if (packet->dts != AV_NOPTS_VALUE) packet->dts -= origin;
+    }
+
+    // Rescale timestamps
+    av_packet_rescale_ts(packet, codecCtx->time_base, stream->time_base);
+    packet->stream_index = stream->index;
+
+    int ret = 0;
+    if (m_replayMode) {
+        m_replay.Push(packet);
+    } else if (m_sendThread.joinable()) {
+        QueueSend(packet, video);
+    } else {
+        ret = av_interleaved_write_frame(m_formatCtx, packet);
+    }
+    av_packet_unref(packet);
+    return ret >= 0;
+}
+
+void VideoEncoder::ApplyStreamingOptions(const RecordingSettings& settings) {
+    // Constant bitrate with a half-second VBV: the link sees a steady rate and a
+    // viewer joining mid-stream waits at most one GOP
+    m_codecCtx->rc_min_rate    = settings.bitrate;
+    m_codecCtx->rc_max_rate    = settings.bitrate;
+    m_codecCtx->rc_buffer_size = settings.bitrate / 2;
+    m_codecCtx->max_b_frames   = 0;
+
+    void* priv = m_codecCtx->priv_data;
+    if (settings.codec == "libx264") {
+        av_opt_set(priv, "x264-params", "nal-hrd=cbr:force-cfr=1", 0);
+    } else if (settings.codec == "h264_nvenc" || settings.codec == "hevc_nvenc") {
+        av_opt_set(priv, "rc", "cbr", 0);
+        av_opt_set(priv, "tune", "ull", 0);
+        av_opt_set_int(priv, "zerolatency", 1, 0);
+        av_opt_set_int(priv, "delay", 0, 0);
+    } else if (settings.codec == "h264_amf" || settings.codec == "hevc_amf") {
+        av_opt_set(priv, "rc", "cbr", 0);
+        av_opt_set(priv, "usage", "ultralowlatency", 0);
+    } else if (settings.codec == "h264_qsv" || settings.codec == "hevc_qsv") {
+        av_opt_set_int(priv, "async_depth", 1, 0);  // CBR follows from maxrate == bitrate
+    }
+}
+
+void VideoEncoder::StartSender(int bitrate) {
+    m_sendMaxBytes = std::max(static_cast<size_t>(bitrate / 8 * STREAM_QUEUE_SECONDS), MIN_STREAM_QUEUE_BYTES);
+    m_sendQueuedBytes = 0;
+    m_sendSkipping = false;
+    m_sendStop = false;
+    m_sendFailed = false;
+    m_packetsDropped = 0;
+    m_formatCtx->flush_packets = 1;  // Each packet leaves as soon as it is muxed
+    m_sendThread = std::thread(&VideoEncoder::SendThread, this);
+}
+
+void VideoEncoder::StopSender() {
+    if (!m_sendThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        m_sendStop = true;
+    }
+    m_sendCV.notify_one();
+    m_sendThread.join();
+}
+
+void VideoEncoder::QueueSend(const AVPacket* packet, bool video) {
+    std::unique_lock<std::mutex> lock(m_sendMutex);
+    const size_t size = static_cast<size_t>(packet->size);
+    const bool fits = m_sendQueuedBytes + size <= m_sendMaxBytes;
+
+    // Congestion: the queue is full, so video is dropped until a keyframe fits
+    // again. Every picture sent still decodes; the far end sees a freeze, not
+    // corruption. Audio is only dropped when it doesn't fit.
+    if (video) {
+        if (!fits) m_sendSkipping = true;
+        else if (m_sendSkipping && (packet->flags & AV_PKT_FLAG_KEY)) m_sendSkipping = false;
+    }
+    if (m_sendFailed.load() || !fits || (video && m_sendSkipping)) {
+        m_packetsDropped++;
+        return;
+    }
+
+    AVPacket* ref = av_packet_clone(packet);
+    if (!ref) return;
+    m_sendQueue.push_back(ref);
+    m_sendQueuedBytes += size;
+    lock.unlock();
+    m_sendCV.notify_one();
+}
+
+void VideoEncoder::SendThread() {
+    TraceRecorder::SetThreadName("Stream sender");
+    ThreadPriority::Apply(ThreadRole::Background);
+    std::unique_lock<std::mutex> lock(m_sendMutex);
+    while (true) {
+        m_sendCV.wait(lock, [this] { return !m_sendQueue.empty() || m_sendStop; });
+        if (m_sendQueue.empty()) break;  // Stop requested and sent
+
+        AVPacket* packet = m_sendQueue.front();
+        m_sendQueue.pop_front();
+        m_sendQueuedBytes -= static_cast<size_t>(packet->size);
+        lock.unlock();
+
+        // A lost connection ends the stream; the take keeps running and drops
+        if (!m_sendFailed.load() && av_interleaved_write_frame(m_formatCtx, packet) < 0) {
+            m_sendFailed = true;
+        }
+        av_packet_free(&packet);
+        lock.lock();
+    }
+}
+
 void VideoEncoder::FlushEncoder() {
     if (!m_codecCtx) return;
 
@@ -358,13 +1200,202 @@ void VideoEncoder::FlushEncoder() {
         int ret = avcodec_receive_packet(m_codecCtx, m_packet);
         if (ret == AVERROR_EOF || ret < 0) break;
 
-        av_packet_rescale_ts(m_packet, m_codecCtx->time_base, m_videoStream->time_base);
-        m_packet->stream_index = m_videoStream->index;
-        av_interleaved_write_frame(m_formatCtx, m_packet);
-        av_packet_unref(m_packet);
+        WritePacket(m_packet, m_codecCtx);
     }
 }
 
+std::string VideoEncoder::SegmentPath(int index) const {
+    if (m_segmentSeconds <= 0.0) return m_outputPath;
+    // "take.mp4" -> "take_000.mp4", "take_001.mp4", ...
+    std::filesystem::path path(m_outputPath);
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "_%03d", index);
+    path.replace_filename(path.stem().string() + suffix + path.extension().string());
+    return path.string();
+}
+
+int VideoEncoder::OpenOutput(const std::string& path) {
+    int ret = 0;
+    if (!(m_formatCtx->oformat->flags & AVFMT_NOFILE)) {
+        // Plain files through the write-behind queue, so a disk stall doesn't stall
+        // encoding; URLs through FFmpeg's protocols
+        if (MediaIO::IsLocalPath(path)) {
+            ret = m_writer.Open(path, m_writeBufferMB, m_writeThrough) ? 0 : AVERROR(EIO);
+            if (ret >= 0) {
+                m_formatCtx->pb = m_writer.GetContext();
+                m_formatCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+            }
+        } else {
+            ret = avio_open(&m_formatCtx->pb, path.c_str(), AVIO_FLAG_WRITE);
+        }
+        if (ret < 0) return ret;
+    }
+
+    // Fragmented MP4/MOV: an empty moov up front and a moof per keyframe (at least
+    // MIN_FRAGMENT_US apart), so the file plays up to the last fragment after a
+    // crash, the muxer keeps no index for the whole take, and the trailer is tiny
+    AVDictionary* options = nullptr;
+    const char* muxer = m_formatCtx->oformat->name;
+    if (m_fragmented && (std::strcmp(muxer, "mp4") == 0 || std::strcmp(muxer, "mov") == 0)) {
+        av_dict_set(&options, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+        av_dict_set_int(&options, "min_frag_duration", MIN_FRAGMENT_US, 0);
+    }
+    if (m_streaming && std::strcmp(muxer, "flv") == 0) {
+        av_dict_set(&options, "flvflags", "no_duration_filesize", 0);  // No seek back at the end
+    }
+    ret = avformat_write_header(m_formatCtx, &options);
+    av_dict_free(&options);
+    if (ret < 0) CloseOutput();
+    return ret;
+}
+
+bool VideoEncoder::StartNextSegment(int64_t originPts) {
+    av_write_trailer(m_formatCtx);
+    CloseOutput();
+    avformat_free_context(m_formatCtx);
+    m_formatCtx   = nullptr;
+    m_videoStream = nullptr;
+    m_audioStream = nullptr;
+
+    // Same streams, same codecs: only the container starts over
+    const std::string path = SegmentPath(++m_segmentIndex);
+    bool ok = avformat_alloc_output_context2(&m_formatCtx, nullptr, nullptr, path.c_str()) >= 0 && m_formatCtx;
+    if (ok) {
+        m_videoStream = avformat_new_stream(m_formatCtx, nullptr);
+        ok = m_videoStream && avcodec_parameters_from_context(m_videoStream->codecpar, m_codecCtx) >= 0;
+    }
+    if (ok) {
+        m_videoStream->time_base = m_codecCtx->time_base;
+        if (m_audioCodecCtx) {
+            m_audioStream = avformat_new_stream(m_formatCtx, nullptr);
+            ok = m_audioStream && avcodec_parameters_from_context(m_audioStream->codecpar, m_audioCodecCtx) >= 0;
+            if (ok) m_audioStream->time_base = m_audioCodecCtx->time_base;
+        }
+    }
+    ok = ok && OpenOutput(path) >= 0;
+    if (!ok) {
+        // The take ends here; the finished segments stay playable
+        avformat_free_context(m_formatCtx);
+        m_formatCtx   = nullptr;
+        m_videoStream = nullptr;
+        m_audioStream = nullptr;
+        return false;
+    }
+    m_segmentOrigin = originPts;
+    return true;
+}
+
+void VideoEncoder::CloseOutput() {
+    if (m_writer.IsOpen()) {
+        m_formatCtx->pb = nullptr;  // AVFMT_FLAG_CUSTOM_IO: the context is the writer's
+        m_writer.Close();
+    } else if (m_formatCtx->pb) {
+        avio_closep(&m_formatCtx->pb);
+    }
+}
+
+bool VideoEncoder::InitAudio(const RecordingSettings& settings) {
+    // ProRes masters and lossless intermediates carry PCM, like camera files;
+    // everything else AAC
+    const bool pcm = (settings.codec == "prores_ks") || IsLosslessCodec(settings.codec);
+    const AVCodec* codec = avcodec_find_encoder(pcm ? AV_CODEC_ID_PCM_S16LE : AV_CODEC_ID_AAC);
+    if (!codec) return false;
+
+    m_audioCodecCtx = avcodec_alloc_context3(codec);
+    if (!m_audioCodecCtx) return false;
+    m_audioCodecCtx->sample_fmt  = pcm ? AV_SAMPLE_FMT_S16 : AV_SAMPLE_FMT_FLTP;
+    m_audioCodecCtx->sample_rate = m_audioInputRate;
+    m_audioCodecCtx->time_base   = {1, m_audioInputRate};
+    av_channel_layout_default(&m_audioCodecCtx->ch_layout, AUDIO_CHANNELS);
+    if (!pcm) m_audioCodecCtx->bit_rate = AUDIO_BITRATE;
+    if (m_formatCtx->oformat->flags & AVFMT_GLOBALHEADER) {
+        m_audioCodecCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+    if (avcodec_open2(m_audioCodecCtx, codec, nullptr) < 0) {
+        ReleaseAudio();
+        return false;
+    }
+
+    // PCM is packed like the input; AAC's planar float is split per channel in EncodeAudio
+    m_audioFrame = av_frame_alloc();
+    if (!m_audioFrame) {
+        ReleaseAudio();
+        return false;
+    }
+    m_audioFrame->format      = m_audioCodecCtx->sample_fmt;
+    m_audioFrame->sample_rate = m_audioInputRate;
+    m_audioFrame->nb_samples  = (m_audioCodecCtx->frame_size > 0) ? m_audioCodecCtx->frame_size : PCM_FRAME_SIZE;
+    av_channel_layout_copy(&m_audioFrame->ch_layout, &m_audioCodecCtx->ch_layout);
+    if (av_frame_get_buffer(m_audioFrame, 0) < 0 || !(m_audioStream = avformat_new_stream(m_formatCtx, nullptr))) {
+        ReleaseAudio();
+        return false;
+    }
+    avcodec_parameters_from_context(m_audioStream->codecpar, m_audioCodecCtx);
+    m_audioStream->time_base = m_audioCodecCtx->time_base;
+
+    m_audioPts = std::llround(std::max(m_audioInputDelay, 0.0) * m_audioInputRate);
+    {
+        std::lock_guard<std::mutex> lock(m_audioMutex);
+        m_audioPending.clear();
+    }
+    m_audioWork.clear();
+    m_audioTrack = true;
+    return true;
+}
+
+void VideoEncoder::SubmitAudio(const float* frames, int count) {
+    if (!m_audioTrack.load() || !m_recording.load() || count <= 0) return;
+    std::lock_guard<std::mutex> lock(m_audioMutex);
+    m_audioPending.insert(m_audioPending.end(), frames, frames + static_cast<size_t>(count) * AUDIO_CHANNELS);
+}
+
+void VideoEncoder::EncodeAudio(bool flush) {
+    if (!m_audioCodecCtx || !m_audioStream) return;
+    {
+        std::lock_guard<std::mutex> lock(m_audioMutex);
+        m_audioWork.insert(m_audioWork.end(), m_audioPending.begin(), m_audioPending.end());
+        m_audioPending.clear();
+    }
+
+    // Counts in frames; m_audioWork is interleaved
+    const size_t frameSize = static_cast<size_t>(m_audioFrame->nb_samples);
+    const size_t frames    = m_audioWork.size() / AUDIO_CHANNELS;
+    size_t offset = 0;
+    while (frames - offset >= frameSize || (flush && offset < frames)) {
+        if (av_frame_make_writable(m_audioFrame) < 0) break;
+        // The last frame of a take is padded with silence
+        const size_t count = std::min(frameSize, frames - offset);
+        const float* src = m_audioWork.data() + offset * AUDIO_CHANNELS;
+        if (m_audioCodecCtx->sample_fmt == AV_SAMPLE_FMT_S16) {
+            auto* dst = reinterpret_cast<int16_t*>(m_audioFrame->data[0]);
+            for (size_t i = 0; i < count * AUDIO_CHANNELS; ++i) {
+                dst[i] = static_cast<int16_t>(std::lrintf(std::clamp(src[i], -1.0f, 1.0f) * 32767.0f));
+            }
+            std::fill(dst + count * AUDIO_CHANNELS, dst + frameSize * AUDIO_CHANNELS, int16_t{0});
+        } else {
+            for (int ch = 0; ch < AUDIO_CHANNELS; ++ch) {
+                auto* dst = reinterpret_cast<float*>(m_audioFrame->data[ch]);
+                for (size_t i = 0; i < count; ++i) dst[i] = src[i * AUDIO_CHANNELS + ch];
+                std::fill(dst + count, dst + frameSize, 0.0f);
+            }
+        }
+        m_audioFrame->pts = m_audioPts;
+        m_audioPts += static_cast<int64_t>(frameSize);
+        Encode(m_audioCodecCtx, m_audioFrame);
+        offset += count;
+    }
+    m_audioWork.erase(m_audioWork.begin(), m_audioWork.begin() + static_cast<std::ptrdiff_t>(offset * AUDIO_CHANNELS));
+
+    if (flush) Encode(m_audioCodecCtx, nullptr);
+}
+
+void VideoEncoder::ReleaseAudio() {
+    m_audioTrack = false;
+    avcodec_free_context(&m_audioCodecCtx);
+    av_frame_free(&m_audioFrame);
+    m_audioStream = nullptr;  // Owned by m_formatCtx
+}
+
 double VideoEncoder::GetEncodingFPS() const {
     if (!m_recording.load()) return 0.0;
     
@@ -372,7 +1403,12 @@ double VideoEncoder::GetEncodingFPS() const {
     double elapsed = std::chrono::duration<double>(now - m_startTime).count();
     
     if (elapsed <= 0.0) return 0.0;
-    return static_cast<double>(m_framesEncoded.load()) / elapsed;
+    return static_cast<double>(GetFramesEncoded()) / elapsed;
+}
+
+size_t VideoEncoder::GetPendingAudioBytes() const {
+    std::lock_guard<std::mutex> lock(m_audioMutex);
+    return m_audioPending.size() * sizeof(float);
 }
 
 } // namespace SP
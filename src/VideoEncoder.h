@@ -1,6 +1,14 @@
 #pragma once
 
 #include "Common.h"
+#include "FramePool.h"
+#include "ImageSequenceWriter.h"
+#include "MediaIO.h"
+#include "MediaWriter.h"
+#include "RecordingTelemetry.h"
+#include "ReplayBuffer.h"
+#include <condition_variable>
+#include <deque>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -22,43 +30,245 @@ public:
     VideoEncoder(const VideoEncoder&) = delete;
     VideoEncoder& operator=(const VideoEncoder&) = delete;
 
+    // Device for the hardware encoders (h264_nvenc, hevc_nvenc, *_qsv, *_amf). Their
+    // input surfaces are NV12 textures on it, filled by the renderer on the GPU.
+    void SetHardwareDevice(ID3D11Device* device) { m_sharedDevice = device; }
+    static bool IsHardwareCodec(const std::string& codec);
+    // ffv1, utvideo, libx264rgb (-qp 0): RGB, all cores; use .mkv
+    static bool IsLosslessCodec(const std::string& codec);
+    // Muxer for a network output URL: rtmp(s):// -> flv, srt:// / udp:// / rtp:// ->
+    // mpegts; null for files
+    static const char* StreamFormatFor(const std::string& url);
+
+    // Codecs that take a new bitrate mid-stream (libx264, NVENC, Quick Sync), so
+    // RecordingSettings::adaptToLoad can act on them
+    static bool CanAdaptToLoad(const std::string& codec);
+    // libx264 profile names for ENCODER_PROFILE_*: "Custom", "Realtime", ...
+    static const char* ProfileName(int profile);
+    // Encodes synthetic frames at `width`x`height` with each profile for about a
+    // second and recommends the highest-quality one that keeps up
+    // with `targetFps` (Realtime when none does). Blocking, a few seconds; run it
+    // off the main thread, and not during a take, which it would slow down.
+    // `cancel` ends it early, with the profiles not yet measured at 0.
+    static EncoderCalibration CalibrateProfiles(int width, int height, double targetFps,
+                                                const std::atomic<bool>* cancel = nullptr);
+
+    // Audio track: set before StartRecording to the rate of the stereo frames
+    // SubmitAudio will get (0 = video only, the default). `delaySeconds` puts the
+    // first submitted frame that far into the take, e.g. behind the audio the
+    // player already held when recording started. Not used in instant replay.
+    void SetAudioInput(int sampleRate, double delaySeconds = 0.0) {
+        m_audioInputRate  = sampleRate;
+        m_audioInputDelay = delaySeconds;
+    }
+    // `count` interleaved AUDIO_CHANNELS frames. Thread-safe. Encoded to AAC
+    // (PCM for ProRes) on the encoder thread and interleaved with the video by the muxer.
+    void SubmitAudio(const float* frames, int count);
+    bool HasAudioTrack() const { return m_audioTrack.load(); }
+
     // Recording control
     bool StartRecording(const RecordingSettings& settings, int sourceWidth, int sourceHeight, double sourceFPS);
     void StopRecording();
     bool IsRecording() const { return m_recording.load(); }
+    // Joins a stopped recording's encoder thread, i.e. until the file is complete
+    void WaitUntilFinished();
 
-    // Frame submission (thread-safe)
-    bool SubmitFrame(const std::vector<uint8_t>& rgbaData, int width, int height);
+    // Frame submission (thread-safe). `data` is tightly packed in `layout` with at
+    // least two RGBA rows of tail padding for swscale's read-ahead; it is queued
+    // by reference and goes back to its pool once encoded. `timestamp` (seconds,
+    // optional) stamps the frame with the source's time instead of frame count.
+    // A full queue drops the frame, or blocks when RecordingSettings::dropWhenBehind
+    // is off. `readbackMs` is what the readback took, for the telemetry.
+    bool SubmitFrame(FrameBuffer data, int width, int height,
+                     ReadbackLayout layout = ReadbackLayout::RGBA8, double timestamp = -1.0,
+                     float readbackMs = 0.0f);
+    FramePool& GetFramePool() { return m_framePool; }
+    const FramePool& GetFramePool() const { return m_framePool; }
+    // The codec's own pixel format as a readback layout. Frames submitted in it at
+    // the recording size are copied into the codec frame without swscale.
+    ReadbackLayout GetInputLayout() const { return m_inputLayout; }
+    // The recording size (RecordingSettings::width/height or the source's), once started
+    int GetWidth()  const { return m_width; }
+    int GetHeight() const { return m_height; }
+
+    // Hardware encoding (IsHardwareEncoding): takes a free surface from the encoder's
+    // pool and hands `render` its texture array and slice to draw the frame into,
+    // then queues it like SubmitFrame. No surface free (the GPU encoder is behind)
+    // counts as a dropped frame.
+    bool IsHardwareEncoding() const { return m_hardwareEncoding; }
+    bool SubmitHardwareFrame(const std::function<bool(ID3D11Texture2D*, int)>& render, double timestamp = -1.0);
     
+    // Instant replay (RecordingSettings::replaySeconds > 0): packets go to an
+    // in-memory ring, GOP-aligned, instead of the output file. SaveReplay muxes
+    // what the ring holds to `path` on a background thread. The ring is kept
+    // after StopRecording until the next recording starts.
+    bool IsReplayMode() const { return m_replayMode; }
+    bool SaveReplay(const std::string& path) { return m_replay.Save(path); }
+    const ReplayBuffer& GetReplayBuffer() const { return m_replay; }
+
+    // Image sequence (outputPath ends in .png/.tif/.tiff/.exr): RGBA frames are
+    // compressed to numbered stills by a pool of workers, no codec or muxer
+    bool IsImageSequence() const { return m_sequenceMode; }
+    const ImageSequenceWriter& GetImageSequence() const { return m_sequence; }
+
+    // Output file I/O (write-behind queue fill, slowest write, muxer stalls)
+    const MediaWriter& GetWriter() const { return m_writer; }
+
+    // Streaming (outputPath is an SRT/RTMP/UDP URL): zerolatency CBR encoding and a
+    // send thread behind a queue of ~1 s of bitrate. A congested link drops video
+    // up to the next keyframe instead of stalling the encoder.
+    bool    IsStreaming() const { return m_streaming; }
+    bool    IsStreamConnected() const { return m_streaming && !m_sendFailed.load(); }
+    int64_t GetPacketsDropped() const { return m_packetsDropped.load(); }
+    double  GetSendQueueFill() const {
+        return m_sendMaxBytes > 0 ? static_cast<double>(m_sendQueuedBytes.load()) / m_sendMaxBytes : 0.0;
+    }
+    size_t  GetSendQueuedBytes() const { return m_sendQueuedBytes.load(); }
+    // Submitted audio not yet encoded
+    size_t  GetPendingAudioBytes() const;
+
     // Statistics
-    int64_t GetFramesEncoded() const { return m_framesEncoded.load(); }
-    int64_t GetFramesDropped() const { return m_framesDropped.load(); }
+    int64_t GetFramesEncoded() const {
+        return m_sequenceMode ? m_sequence.GetFramesWritten() : m_framesEncoded.load();
+    }
+    int64_t GetFramesDropped() const {
+        return m_sequenceMode ? m_sequence.GetFramesDropped() : m_framesDropped.load();
+    }
     double GetEncodingFPS() const;
+    // Load control: the share of RecordingSettings::bitrate the codec runs at.
+    // Below 1 while the queue filled or encoding took most of a frame interval.
+    double GetLoadBitrateScale() const { return m_loadScale.load(std::memory_order_relaxed); }
+    // Per-stage timings of the recent frames (readback, queue, convert, encode, mux)
+    const RecordingTelemetry& GetTelemetry() const { return m_telemetry; }
+
+    friend struct MicroBenchAccess;  // ShaderPlayerMicroBench times the private hot paths
 
 private:
     void EncoderThread();
     bool InitEncoder(const RecordingSettings& settings, int width, int height, double fps);
+    bool EnsureScaler(int width, int height, AVPixelFormat format);  // m_swsCtx from this source
+    // An RGBA frame at the encoder's size into `frame` with PixelCopy's AVX2 paths
+    // (YUV 4:2:0, or a swizzle for BGR0), in row bands across the scaler's thread
+    // count. False for anything else, which swscale converts.
+    bool ConvertRgbaFrame(const AVFrame* src, AVFrame* frame);
+    void ApplyX264Profile(const RecordingSettings& settings);  // Preset, tune, threads, GOP, B-frames
+    // A frame of m_codecFrames the codec no longer references, for swscale to write
+    AVFrame* AcquireCodecFrame();
+    void ReleaseCodecFrames();
+    bool InitHardwareFrames(int width, int height);  // m_hwDeviceCtx + m_hwFramesCtx on m_sharedDevice
+    void ReleaseHardwareFrames();
+    int64_t NextPts(double timestamp);  // Frame count, or the source time when given
     bool EncodeFrame(AVFrame* frame);
+    bool TimedEncodeFrame(AVFrame* frame, FrameTiming& timing);  // EncodeFrame + telemetry sample + AdaptToLoad
+    void AdaptToLoad(const FrameTiming& timing);
+    void SetLoadLevel(int level, std::chrono::steady_clock::time_point now);  // Bitrate of LOAD_BITRATE_STEPS[level]
+    bool Encode(AVCodecContext* codecCtx, AVFrame* frame);  // frame = null flushes
+    // To codecCtx's stream in the current file or segment, or the replay ring; unrefs it.
+    // WritePacket times MuxPacket into m_muxMs.
+    bool WritePacket(AVPacket* packet, AVCodecContext* codecCtx);
+    bool MuxPacket(AVPacket* packet, AVCodecContext* codecCtx);
     void FlushEncoder();
+    std::string SegmentPath(int index) const;  // m_outputPath itself when not segmenting
+    int  OpenOutput(const std::string& path);   // m_formatCtx's file + header; AVERROR on failure
+    bool StartNextSegment(int64_t originPts);   // Trailer, then a new file from video pts `originPts`
+    void CloseOutput();  // m_writer or the avio_open'd file; replay mode has neither
+    void ApplyStreamingOptions(const RecordingSettings& settings);  // CBR + low-latency codec options
+    void StartSender(int bitrate);
+    void StopSender();
+    void QueueSend(const AVPacket* packet, bool video);  // Drop policy; clones the packet
+    void SendThread();
+    bool InitAudio(const RecordingSettings& settings);  // m_audioCodecCtx/Stream/Frame
+    void EncodeAudio(bool flush);  // Whole frames of m_audioPending; flush = the rest, padded
+    void ReleaseAudio();
 
     // FFmpeg encoding context
     AVFormatContext* m_formatCtx = nullptr;
     AVCodecContext* m_codecCtx = nullptr;
     AVStream* m_videoStream = nullptr;
     SwsContext* m_swsCtx = nullptr;
-    AVFrame* m_frame = nullptr;
-    AVFrame* m_srcFrame = nullptr;  // Source RGBA frame; FFmpeg-allocated so sws_scale has safe padding
+    // Source of m_swsCtx; it is rebuilt (with BT.709 coefficients) when a frame differs
+    int m_swsSrcWidth  = 0;
+    int m_swsSrcHeight = 0;
+    AVPixelFormat m_swsSrcFormat = AV_PIX_FMT_NONE;
+    // Codec input frames swscale converts into. With B-frames or lookahead the
+    // codec may keep a reference to a frame after avcodec_send_frame; the next
+    // conversion takes a frame it let go of, so none is rewritten while held.
+    std::vector<AVFrame*> m_codecFrames;
+    size_t m_codecFrameNext = 0;  // Where AcquireCodecFrame starts looking
     AVPacket* m_packet = nullptr;
 
+    // Hardware encoding: D3D11VA device wrapping m_sharedDevice, and the NV12
+    // render-target surface pool the encoder reads
+    ComPtr<ID3D11Device> m_sharedDevice;
+    AVBufferRef* m_hwDeviceCtx = nullptr;
+    AVBufferRef* m_hwFramesCtx = nullptr;
+    bool m_hardwareEncoding = false;  // Current/last recording; set before the thread starts
+
+    MediaWriter m_writer;  // Output file behind the muxer (plain paths)
+    int m_writeBufferMB = 0;
+    bool m_writeThrough = false;
+    bool m_fragmented = false;  // movflags=frag_keyframe+empty_moov (mp4/mov)
+
+    // Streaming: packets go through m_sendQueue to SendThread, which owns the
+    // muxer until StopSender
+    bool m_streaming = false;  // Current/last recording
+    std::thread m_sendThread;
+    std::mutex m_sendMutex;
+    std::condition_variable m_sendCV;
+    std::deque<AVPacket*> m_sendQueue;
+    std::atomic<size_t> m_sendQueuedBytes{0};
+    size_t m_sendMaxBytes = 0;
+    bool m_sendSkipping = false;  // Congested: video waits for the next keyframe
+    bool m_sendStop = false;
+    std::atomic<bool> m_sendFailed{false};
+    std::atomic<int64_t> m_packetsDropped{0};
+
+    // Rolling segments (RecordingSettings::segmentSeconds)
+    std::string m_outputPath;
+    double m_segmentSeconds = 0.0;  // 0 = one file
+    int m_segmentIndex = 0;
+    int64_t m_segmentOrigin = 0;    // First video pts of the current segment (codec time base)
+
+    bool m_replayMode = false;  // Current/last recording; no file is opened
+    ReplayBuffer m_replay;
+
+    // Audio track
+    int m_audioInputRate = 0;
+    double m_audioInputDelay = 0.0;
+    AVCodecContext* m_audioCodecCtx = nullptr;
+    AVStream* m_audioStream = nullptr;
+    AVFrame* m_audioFrame = nullptr;  // One codec frame (frame_size samples)
+    int64_t m_audioPts = 0;  // In samples
+    std::atomic<bool> m_audioTrack{false};
+    std::vector<float> m_audioPending;  // Submitted, not yet encoded (interleaved)
+    std::vector<float> m_audioWork;     // Encoder thread: taken from m_audioPending
+    mutable std::mutex m_audioMutex;
+
     // Frame queue
     struct QueuedFrame {
-        std::vector<uint8_t> data;
+        FrameBuffer data;
         int width;
         int height;
+        ReadbackLayout layout;
+        double timestamp;
+        AVFrame* hwFrame = nullptr;  // Hardware surface instead of data; freed once sent
+        float readbackMs = 0.0f;
+        std::chrono::steady_clock::time_point queuedAt;
     };
-    std::queue<QueuedFrame> m_frameQueue;
+    bool Enqueue(QueuedFrame qf);  // Drop/block policy of SubmitFrame
+    // Fixed ring (std::queue's deque allocates a block per few frames as it
+    // moves); a popped slot is moved from, so it holds no pixels
+    std::array<QueuedFrame, ENCODER_QUEUE_SIZE> m_frameQueue{};
+    int m_queueHead  = 0;
+    int m_queueCount = 0;
     std::mutex m_queueMutex;
     std::condition_variable m_queueCV;
+    std::condition_variable m_spaceCV;  // Queue went below ENCODER_QUEUE_SIZE (!m_dropWhenBehind)
+    bool m_dropWhenBehind = true;
+    FramePool m_framePool;  // Readback blocks, recycled once encoded
+
+    ImageSequenceWriter m_sequence;
+    bool m_sequenceMode = false;
 
     // Encoder thread
     std::thread m_encoderThread;
@@ -69,12 +279,25 @@ private:
     std::atomic<int64_t> m_framesEncoded{0};
     std::atomic<int64_t> m_framesDropped{0};
     std::chrono::steady_clock::time_point m_startTime;
+    RecordingTelemetry m_telemetry;
+    float m_muxMs = 0.0f;  // WritePacket time during the current frame (encoder thread)
+
+    // Load control (encoder thread, apart from m_loadScale)
+    bool    m_loadControl = false;  // Current recording adapts its bitrate
+    int64_t m_baseBitrate = 0;
+    int     m_loadLevel = 0;        // Index into LOAD_BITRATE_STEPS (VideoEncoder.cpp)
+    double  m_loadBusyMs = 0.0;     // Smoothed convert + encode + mux time per frame
+    std::chrono::steady_clock::time_point m_loadChanged;        // Last step
+    std::chrono::steady_clock::time_point m_loadHeadroomSince;  // Epoch = no headroom now
+    std::atomic<double> m_loadScale{1.0};
 
     // Settings
     int m_width = 0;
     int m_height = 0;
     double m_fps = 0.0;
+    ReadbackLayout m_inputLayout = ReadbackLayout::RGBA8;
     int64_t m_frameIndex = 0;
+    int64_t m_lastPts = -1;
 };
 
 } // namespace SP
@@ -0,0 +1,85 @@
+#include "VideoInput.h"
+#include <algorithm>
+#include <cmath>
+
+namespace SP {
+
+namespace {
+
+// Further ahead than this, seeking beats decoding through the gap
+constexpr double MAX_CATCH_UP_SECONDS = 1.0;
+// Timestamp rounding between the master's frame grid and the input's
+constexpr double FRAME_EPSILON = 1e-3;
+
+} // namespace
+
+VideoInput::~VideoInput() {
+    Close();
+}
+
+bool VideoInput::Open(const std::string& path, int threadCount, int proxyScale) {
+    Close();
+
+    // RGBA out, no D3D11VA: the renderer's YUV pass writes the main video texture only
+    m_decoder.SetGpuYuvConversion(false);
+    m_decoder.SetDecodeThreading(std::max(threadCount, 1), 0);
+    m_decoder.SetProxyScale(proxyScale);
+    if (!m_decoder.Open(path)) return false;
+
+    m_path = path;
+    m_decoder.DecodeNextFrame(m_frame);
+    m_worker.ResetStats();
+    m_worker.Start();
+    return true;
+}
+
+void VideoInput::Close() {
+    m_worker.Stop();
+    m_decoder.Close();
+    m_frame = VideoFrame{};
+    m_path.clear();
+    m_lastTarget = 0.0;
+    m_seeks = 0;
+}
+
+double VideoInput::LocalTime(double masterTime) const {
+    const double duration = m_decoder.GetDuration();
+    masterTime = std::max(masterTime, 0.0);
+    return (duration > 0.0) ? std::fmod(masterTime, duration) : masterTime;
+}
+
+bool VideoInput::Sync(double masterTime) {
+    if (!IsOpen()) return false;
+    const double target = LocalTime(masterTime);
+
+    // The master went back (seek, loop, or this clip wrapped) or jumped ahead:
+    // resync with an exact seek. Compared with the last target rather than the
+    // frame, so a clip whose first frame starts late doesn't seek every tick.
+    const bool wentBack = target < m_lastTarget - FRAME_EPSILON;
+    m_lastTarget = target;
+    if (wentBack || target > m_frame.timestamp + MAX_CATCH_UP_SECONDS) {
+        SeekTo(target);
+        return true;
+    }
+
+    // Pop everything due; frames passed over in the same tick are never shown
+    bool changed = false;
+    double next = 0.0;
+    while (m_worker.PeekNextTimestamp(next) && next <= target + FRAME_EPSILON) {
+        if (!m_worker.PopFrame(m_frame)) break;
+        changed = true;
+    }
+    return changed;
+}
+
+void VideoInput::SeekTo(double seconds) {
+    {
+        auto lock = m_worker.LockDecoder();
+        m_decoder.SeekToTimeExact(seconds);
+        m_worker.DiscardQueued();
+        m_decoder.DecodeNextFrame(m_frame);
+    }
+    ++m_seeks;
+}
+
+} // namespace SP
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Common.h"
+#include "VideoDecoder.h"
+#include "DecodeWorker.h"
+
+namespace SP {
+
+// An extra video source for compositing shaders (ISF "image" INPUTS, t4..t7). Each
+// input has its own VideoDecoder and DecodeWorker ring, and is slaved to the main
+// playback clock: Sync pops whatever is due at the master time (looping inputs
+// shorter than the master) and seeks when the master jumped.
+//
+// Frames are software-decoded to RGBA, so the renderer uploads them with a plain
+// Map; the GPU YUV pass and D3D11VA stay with the main video. Render thread only.
+class VideoInput {
+public:
+    VideoInput() = default;
+    ~VideoInput();
+
+    // Non-copyable
+    VideoInput(const VideoInput&) = delete;
+    VideoInput& operator=(const VideoInput&) = delete;
+
+    // Synchronous open at `proxyScale`; libavcodec gets `threadCount` threads so
+    // several inputs share the cores instead of each claiming all of them.
+    bool Open(const std::string& path, int threadCount, int proxyScale);
+    void Close();
+    bool IsOpen() const { return m_decoder.IsOpen(); }
+    const std::string& GetPath() const { return m_path; }
+
+    // Brings the frame on screen up to `masterTime`. True when it changed.
+    bool Sync(double masterTime);
+    const VideoFrame& GetFrame() const { return m_frame; }
+
+    const VideoDecoder& GetDecoder() const { return m_decoder; }
+    const DecodeWorker& GetDecodeWorker() const { return m_worker; }
+    int64_t GetSeeks() const { return m_seeks; }  // Resyncs after master jumps / loops
+
+private:
+    double LocalTime(double masterTime) const;  // Master time wrapped into this clip
+    void SeekTo(double seconds);
+
+    std::string  m_path;
+    VideoDecoder m_decoder;
+    DecodeWorker m_worker{m_decoder};  // Must follow m_decoder (init + destroy order)
+    VideoFrame   m_frame;
+    double       m_lastTarget = 0.0;  // Clip time of the previous Sync
+    int64_t      m_seeks = 0;
+};
+
+} // namespace SP
@@ -1,28 +1,166 @@
 #include "VideoOutputWindow.h"
 #include "D3D11Renderer.h"
+#include "TraceRecorder.h"
+#include "ThreadPriority.h"
+#include <d3d10.h>
+#include <algorithm>
+#include <utility>
 
 namespace SP {
 
+namespace {
+
+// Waits time out this often, so resizes and Close are noticed without a new frame
+constexpr DWORD PRESENT_WAIT_MS = 100;
+
+} // namespace
+
 bool VideoOutputWindow::Open(ID3D11Device* device, ID3D11DeviceContext* context) {
     if (m_hwnd) return true;
     m_device  = device;
     m_context = context;
-    return CreateWindowAndSwapChain(1280, 720);
+
+    // The present thread issues copies and presents on the shared immediate context
+    ComPtr<ID3D10Multithread> multithread;
+    if (SUCCEEDED(m_device->QueryInterface(IID_PPV_ARGS(&multithread)))) {
+        multithread->SetMultithreadProtected(TRUE);
+    }
+    if (!CreateWindowAndSwapChain(1280, 720)) return false;
+    StartPresentThread();
+    return true;
 }
 
 void VideoOutputWindow::Close() {
     if (m_hwnd) {
         DestroyWindow(m_hwnd);
-        // WM_DESTROY clears m_hwnd, m_swapChain, m_rtv
+        // WM_DESTROY stops the present thread and clears m_hwnd, m_swapChain and the mailbox
     }
     m_device  = nullptr;
     m_context = nullptr;
 }
 
-void VideoOutputWindow::BlitAndPresent(D3D11Renderer& renderer) {
-    if (!m_hwnd || !m_rtv) return;
-    renderer.BlitDisplayTo(m_rtv.Get(), m_width, m_height);
-    m_swapChain->Present(0, 0);
+void VideoOutputWindow::SubmitFrame(D3D11Renderer& renderer, ID3D11ShaderResourceView* source) {
+    if (!m_hwnd || !m_presentThread.joinable() || !renderer.GetDisplayTexture()) return;
+    const int width  = m_width.load(std::memory_order_relaxed);
+    const int height = m_height.load(std::memory_order_relaxed);
+    if (width <= 0 || height <= 0) return;  // Minimized
+
+    // The write slot belongs to this thread until it is handed over below
+    MailboxTexture& slot = m_slots[m_writeSlot];
+    if ((slot.width != width || slot.height != height) && !CreateMailboxTexture(slot, width, height)) return;
+    if (m_region) {
+        renderer.BlitRegionTo(source ? source : renderer.GetDisplaySRV(), slot.rtv.Get(), width, height, *m_region);
+    } else if (source) {
+        renderer.UpscaleTo(source, slot.rtv.Get(), width, height);
+    } else {
+        renderer.BlitDisplayTo(slot.rtv.Get(), width, height);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(m_writeSlot, m_readySlot);
+        if (m_readyFresh) m_dropped.fetch_add(1, std::memory_order_relaxed);
+        m_readyFresh = true;
+    }
+    m_frameReady.notify_one();
+}
+
+bool VideoOutputWindow::CreateMailboxTexture(MailboxTexture& slot, int width, int height) {
+    slot = MailboxTexture{};
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = static_cast<UINT>(width);
+    desc.Height           = static_cast<UINT>(height);
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = DXGI_FORMAT_R8G8B8A8_UNORM;  // Matches the back buffer for CopyResource
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_RENDER_TARGET;
+    if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &slot.texture)) ||
+        FAILED(m_device->CreateRenderTargetView(slot.texture.Get(), nullptr, &slot.rtv))) {
+        slot = MailboxTexture{};
+        return false;
+    }
+    slot.width  = width;
+    slot.height = height;
+    return true;
+}
+
+void VideoOutputWindow::StartPresentThread() {
+    m_stop        = false;
+    m_readyFresh  = false;
+    m_writeSlot   = 0;
+    m_readySlot   = 1;
+    m_presentSlot = 2;
+    m_presentThread = std::thread(&VideoOutputWindow::PresentThread, this);
+}
+
+void VideoOutputWindow::StopPresentThread() {
+    if (!m_presentThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_frameReady.notify_all();
+    // DXGI may send this window messages from inside Present: keep dispatching
+    // them while waiting, or the two threads deadlock
+    HANDLE thread = m_presentThread.native_handle();
+    while (MsgWaitForMultipleObjects(1, &thread, FALSE, INFINITE, QS_SENDMESSAGE) == WAIT_OBJECT_0 + 1) {
+        MSG msg;
+        PeekMessageW(&msg, nullptr, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+    }
+    m_presentThread.join();
+}
+
+void VideoOutputWindow::PresentThread() {
+    TraceRecorder::SetThreadName("Output present");
+    ThreadPriority::Apply(ThreadRole::Render);
+    DXGI_SWAP_CHAIN_DESC1 desc = {};
+    m_swapChain->GetDesc1(&desc);
+    int bufferWidth  = static_cast<int>(desc.Width);
+    int bufferHeight = static_cast<int>(desc.Height);
+    bool presentedSinceWait = true;  // The waitable object starts signalled
+
+    for (;;) {
+        // At most one frame queued on the output's monitor: the frame taken next
+        // is the newest one when the display can accept it
+        if (m_frameLatencyWaitable && presentedSinceWait) {
+            WaitForSingleObjectEx(m_frameLatencyWaitable, PRESENT_WAIT_MS, TRUE);
+            presentedSinceWait = false;
+        }
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_frameReady.wait_for(lock, std::chrono::milliseconds(PRESENT_WAIT_MS),
+                                  [this] { return m_readyFresh || m_stop; });
+            if (m_stop) return;
+            if (!m_readyFresh) continue;
+            std::swap(m_readySlot, m_presentSlot);
+            m_readyFresh = false;
+        }
+
+        const int width  = m_width.load(std::memory_order_relaxed);
+        const int height = m_height.load(std::memory_order_relaxed);
+        if (width > 0 && height > 0 && (width != bufferWidth || height != bufferHeight)) {
+            // No back buffer reference is held between presents, so this can resize
+            if (SUCCEEDED(m_swapChain->ResizeBuffers(0, static_cast<UINT>(width), static_cast<UINT>(height),
+                                                     DXGI_FORMAT_UNKNOWN, desc.Flags))) {
+                bufferWidth  = width;
+                bufferHeight = height;
+            }
+        }
+
+        // Frames drawn for the old size are dropped; the next one will match
+        const MailboxTexture& slot = m_slots[m_presentSlot];
+        if (!slot.texture || slot.width != bufferWidth || slot.height != bufferHeight) continue;
+        SP_TRACE_SCOPE("Output present");
+        ComPtr<ID3D11Texture2D> backBuffer;
+        if (FAILED(m_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer)))) continue;
+        m_context->CopyResource(backBuffer.Get(), slot.texture.Get());
+        backBuffer.Reset();
+        m_swapChain->Present(1, 0);
+        presentedSinceWait = true;
+        m_presented.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
 bool VideoOutputWindow::CreateWindowAndSwapChain(int width, int height) {
@@ -66,6 +204,13 @@ bool VideoOutputWindow::CreateWindowAndSwapChain(int width, int height) {
         return false;
     }
 
+    // The back buffer is the client area (not the requested outer size), so the
+    // mailbox frames match it from the first one
+    RECT client = {};
+    GetClientRect(m_hwnd, &client);
+    width  = std::max(1, static_cast<int>(client.right - client.left));
+    height = std::max(1, static_cast<int>(client.bottom - client.top));
+
     DXGI_SWAP_CHAIN_DESC1 desc = {};
     desc.Width       = static_cast<UINT>(width);
     desc.Height      = static_cast<UINT>(height);
@@ -74,40 +219,34 @@ bool VideoOutputWindow::CreateWindowAndSwapChain(int width, int height) {
     desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
     desc.BufferCount = 2;
     desc.SwapEffect  = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    desc.Flags       = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
 
-    if (FAILED(factory->CreateSwapChainForHwnd(
-            m_device, m_hwnd, &desc, nullptr, nullptr, &m_swapChain))) {
+    HRESULT hr = factory->CreateSwapChainForHwnd(m_device, m_hwnd, &desc, nullptr, nullptr, &m_swapChain);
+    if (FAILED(hr)) {
+        // Pre-8.1: Present(1) blocks on the present thread instead
+        desc.Flags = 0;
+        hr = factory->CreateSwapChainForHwnd(m_device, m_hwnd, &desc, nullptr, nullptr, &m_swapChain);
+    }
+    if (FAILED(hr)) {
         DestroyWindow(m_hwnd);
         m_hwnd = nullptr;
         return false;
     }
+    ComPtr<IDXGISwapChain2> swapChain2;
+    if (desc.Flags && SUCCEEDED(m_swapChain.As(&swapChain2))) {
+        swapChain2->SetMaximumFrameLatency(1);
+        m_frameLatencyWaitable = swapChain2->GetFrameLatencyWaitableObject();
+    }
 
     // Prevent DXGI from hijacking Alt+Enter on this window
     factory->MakeWindowAssociation(m_hwnd, DXGI_MWA_NO_ALT_ENTER);
 
     m_width  = width;
     m_height = height;
-    RebuildRTV();
     ShowWindow(m_hwnd, SW_SHOW);
     return true;
 }
 
-void VideoOutputWindow::RebuildRTV() {
-    m_rtv.Reset();
-    ComPtr<ID3D11Texture2D> backBuffer;
-    if (FAILED(m_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer)))) return;
-    m_device->CreateRenderTargetView(backBuffer.Get(), nullptr, &m_rtv);
-}
-
-void VideoOutputWindow::ResizeSwapChain(int width, int height) {
-    m_rtv.Reset();
-    m_swapChain->ResizeBuffers(0, static_cast<UINT>(width), static_cast<UINT>(height),
-                               DXGI_FORMAT_UNKNOWN, 0);
-    m_width  = width;
-    m_height = height;
-    RebuildRTV();
-}
-
 LRESULT CALLBACK VideoOutputWindow::StaticWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     VideoOutputWindow* self = nullptr;
     if (msg == WM_NCCREATE) {
@@ -124,14 +263,30 @@ LRESULT CALLBACK VideoOutputWindow::StaticWndProc(HWND hwnd, UINT msg, WPARAM wP
 LRESULT VideoOutputWindow::HandleMsg(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     switch (msg) {
     case WM_SIZE: {
+        // The present thread resizes the swap chain; frames are drawn at the new size
         const int w = LOWORD(lParam);
         const int h = HIWORD(lParam);
-        if (m_swapChain && w > 0 && h > 0)
-            ResizeSwapChain(w, h);
+        if (w > 0 && h > 0) {
+            m_width  = w;
+            m_height = h;
+        }
         return 0;
     }
+    case WM_ENTERSIZEMOVE:
+    case WM_ENTERMENULOOP:
+        if (m_onModalLoop) m_onModalLoop(true);
+        return 0;
+    case WM_EXITSIZEMOVE:
+    case WM_EXITMENULOOP:
+        if (m_onModalLoop) m_onModalLoop(false);
+        return 0;
     case WM_DESTROY:
-        m_rtv.Reset();
+        StopPresentThread();
+        for (MailboxTexture& slot : m_slots) slot = MailboxTexture{};
+        if (m_frameLatencyWaitable) {
+            CloseHandle(m_frameLatencyWaitable);
+            m_frameLatencyWaitable = nullptr;
+        }
         m_swapChain.Reset();
         m_hwnd = nullptr;
         return 0;
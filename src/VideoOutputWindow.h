@@ -1,19 +1,30 @@
 #pragma once
 
 #include "Common.h"
+#include <condition_variable>
 
 namespace SP {
 
 class D3D11Renderer;
 
 // A standalone Win32 window backed by its own IDXGISwapChain on the same D3D11
-// device as the main renderer.  Each frame, BlitAndPresent() copies the already-
-// processed display texture into this window's back buffer and presents it.
-// The window appears as a separate entry in the taskbar / window switcher, so
-// screen-sharing software (Discord, Zoom, Teams) can capture it directly via
-// "Share a Window" without any virtual camera driver.
+// device as the main renderer.  Each frame, SubmitFrame() draws the already-
+// processed display texture, scaled to the window, into a mailbox texture; a
+// present thread copies the newest one into the back buffer and presents it
+// vsynced to the window's own monitor, so main-loop hitches (UI, dialogs, shader
+// compiles) never reach the output. The window appears as a separate entry in
+// the taskbar / window switcher, so screen-sharing software (Discord, Zoom,
+// Teams) can capture it directly via "Share a Window" without any virtual
+// camera driver.
+//
+// The present thread shares the immediate context, so the device is put in
+// multithread-protected mode and the thread only issues stateless calls
+// (CopyResource, ResizeBuffers, Present): no pipeline state the renderer relies
+// on is touched behind its back.
 class VideoOutputWindow {
 public:
+    static constexpr int MAILBOX_SIZE = 3;  // Writing, newest finished, presenting
+
     VideoOutputWindow() = default;
     ~VideoOutputWindow() { Close(); }
 
@@ -23,25 +34,75 @@ public:
     bool Open(ID3D11Device* device, ID3D11DeviceContext* context);
     void Close();
     bool IsOpen() const { return m_hwnd != nullptr; }
+    HWND GetHwnd() const { return m_hwnd; }
+
+    // Called with true when a drag, resize or system menu of this window starts
+    // its modal loop on the render thread, and with false when it ends
+    void SetModalLoopCallback(std::function<void(bool entered)> callback) { m_onModalLoop = std::move(callback); }
 
-    // Call after D3D11Renderer::RenderToDisplay() each frame.
-    void BlitAndPresent(D3D11Renderer& renderer);
+    // Call after D3D11Renderer::RenderToDisplay() each frame. Render thread only.
+    // `source` replaces the display texture (this output's post chain).
+    void SubmitFrame(D3D11Renderer& renderer, ID3D11ShaderResourceView* source = nullptr);
+    // One window of a canvas spread over several (AppConfig::canvasOutputs):
+    // SubmitFrame draws only `region` of the frame, blended and warped
+    // (D3D11Renderer::BlitRegionTo). Null = the whole frame. Render thread only.
+    void SetRegion(const CanvasRegion* region) { m_region = region ? std::optional<CanvasRegion>(*region) : std::nullopt; }
+    // Client size, what SubmitFrame draws at (0 while minimized)
+    int GetWidth()  const { return m_width.load(std::memory_order_relaxed); }
+    int GetHeight() const { return m_height.load(std::memory_order_relaxed); }
+
+    // Frames shown by the present thread, and submitted frames replaced by a newer
+    // one before it got to them
+    int64_t GetPresentedFrames() const { return m_presented.load(std::memory_order_relaxed); }
+    int64_t GetDroppedFrames() const { return m_dropped.load(std::memory_order_relaxed); }
 
 private:
+    struct MailboxTexture {
+        ComPtr<ID3D11Texture2D>        texture;
+        ComPtr<ID3D11RenderTargetView> rtv;
+        int width  = 0;
+        int height = 0;
+    };
+
     bool CreateWindowAndSwapChain(int width, int height);
-    void RebuildRTV();
-    void ResizeSwapChain(int width, int height);
+    bool CreateMailboxTexture(MailboxTexture& slot, int width, int height);
+    void StartPresentThread();
+    void StopPresentThread();
+    void PresentThread();
 
     static LRESULT CALLBACK StaticWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
     LRESULT HandleMsg(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
     HWND                          m_hwnd      = nullptr;
+    std::function<void(bool)>     m_onModalLoop;
+    std::optional<CanvasRegion>   m_region;
     ComPtr<IDXGISwapChain1>       m_swapChain;
-    ComPtr<ID3D11RenderTargetView> m_rtv;
+    HANDLE                        m_frameLatencyWaitable = nullptr;
     ID3D11Device*                 m_device    = nullptr;
     ID3D11DeviceContext*          m_context   = nullptr;
-    int                           m_width     = 0;
-    int                           m_height    = 0;
+
+    // Client size from WM_SIZE (main thread); the present thread resizes the
+    // swap chain to it and the render thread draws mailbox frames at it
+    std::atomic<int>              m_width{0};
+    std::atomic<int>              m_height{0};
+
+    // Triple-buffered mailbox. The slots change hands under m_mutex: the render
+    // thread fills m_slots[m_writeSlot], swaps it with the ready slot and marks it
+    // fresh; the present thread swaps the fresh ready slot with the one it shows.
+    // Every copy goes through the one immediate context, so the GPU sees them in
+    // submission order and no fence is needed.
+    std::mutex                    m_mutex;
+    std::condition_variable       m_frameReady;
+    MailboxTexture                m_slots[MAILBOX_SIZE];
+    int                           m_writeSlot   = 0;
+    int                           m_readySlot   = 1;
+    int                           m_presentSlot = 2;
+    bool                          m_readyFresh  = false;
+    bool                          m_stop        = false;
+    std::thread                   m_presentThread;
+
+    std::atomic<int64_t>          m_presented{0};
+    std::atomic<int64_t>          m_dropped{0};
 };
 
 } // namespace SP
@@ -0,0 +1,158 @@
+#include "VideoProcessorConverter.h"
+
+namespace SP {
+
+bool VideoProcessorConverter::Initialize(ID3D11Device* device, ID3D11DeviceContext* context) {
+    Shutdown();
+    if (!device || !context) return false;
+    if (FAILED(device->QueryInterface(IID_PPV_ARGS(&m_videoDevice))) ||
+        FAILED(context->QueryInterface(IID_PPV_ARGS(&m_videoContext)))) {
+        Shutdown();
+        return false;
+    }
+    m_videoContext.As(&m_videoContext1);
+    m_device = device;
+    return true;
+}
+
+void VideoProcessorConverter::Shutdown() {
+    m_outputView.Reset();
+    m_outputTexture.Reset();
+    m_inputViews.clear();
+    m_inputSurface.Reset();
+    m_processor.Reset();
+    m_enumerator.Reset();
+    m_inputWidth = m_inputHeight = m_outputWidth = m_outputHeight = 0;
+    m_inputFormat = DXGI_FORMAT_UNKNOWN;
+    m_videoContext1.Reset();
+    m_videoContext.Reset();
+    m_videoDevice.Reset();
+    m_device.Reset();
+}
+
+bool VideoProcessorConverter::EnsureProcessor(UINT inputWidth, UINT inputHeight, DXGI_FORMAT inputFormat,
+                                              UINT outputWidth, UINT outputHeight) {
+    if (m_processor && m_inputWidth == inputWidth && m_inputHeight == inputHeight &&
+        m_inputFormat == inputFormat && m_outputWidth == outputWidth && m_outputHeight == outputHeight) {
+        return true;
+    }
+    // Views belong to the enumerator they were made with
+    m_processor.Reset();
+    m_enumerator.Reset();
+    m_inputViews.clear();
+    m_inputSurface.Reset();
+    m_outputView.Reset();
+    m_outputTexture.Reset();
+    m_inputWidth = m_inputHeight = m_outputWidth = m_outputHeight = 0;
+
+    D3D11_VIDEO_PROCESSOR_CONTENT_DESC content = {};
+    content.InputFrameFormat = D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE;
+    content.InputWidth       = inputWidth;
+    content.InputHeight      = inputHeight;
+    content.OutputWidth      = outputWidth;
+    content.OutputHeight     = outputHeight;
+    content.Usage            = D3D11_VIDEO_USAGE_PLAYBACK_NORMAL;
+    if (FAILED(m_videoDevice->CreateVideoProcessorEnumerator(&content, &m_enumerator))) return false;
+
+    UINT inputSupport = 0, outputSupport = 0;
+    if (FAILED(m_enumerator->CheckVideoProcessorFormat(inputFormat, &inputSupport)) ||
+        !(inputSupport & D3D11_VIDEO_PROCESSOR_FORMAT_SUPPORT_INPUT) ||
+        FAILED(m_enumerator->CheckVideoProcessorFormat(DXGI_FORMAT_R8G8B8A8_UNORM, &outputSupport)) ||
+        !(outputSupport & D3D11_VIDEO_PROCESSOR_FORMAT_SUPPORT_OUTPUT) ||
+        FAILED(m_videoDevice->CreateVideoProcessor(m_enumerator.Get(), 0, &m_processor))) {
+        m_processor.Reset();
+        m_enumerator.Reset();
+        return false;
+    }
+
+    // Plain conversion and scaling: no denoise, edge enhancement or other driver
+    // "improvements", so the output matches the shader pass
+    m_videoContext->VideoProcessorSetStreamAutoProcessingMode(m_processor.Get(), 0, FALSE);
+    m_videoContext->VideoProcessorSetStreamFrameFormat(m_processor.Get(), 0, D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE);
+    const RECT outputRect = { 0, 0, static_cast<LONG>(outputWidth), static_cast<LONG>(outputHeight) };
+    m_videoContext->VideoProcessorSetStreamDestRect(m_processor.Get(), 0, TRUE, &outputRect);
+    m_videoContext->VideoProcessorSetOutputTargetRect(m_processor.Get(), TRUE, &outputRect);
+
+    m_inputWidth   = inputWidth;
+    m_inputHeight  = inputHeight;
+    m_inputFormat  = inputFormat;
+    m_outputWidth  = outputWidth;
+    m_outputHeight = outputHeight;
+    return true;
+}
+
+void VideoProcessorConverter::SetColorSpaces(ColorMatrix matrix, bool fullRange) {
+    if (m_videoContext1) {
+        DXGI_COLOR_SPACE_TYPE input;
+        switch (matrix) {
+        case ColorMatrix::BT601:  input = fullRange ? DXGI_COLOR_SPACE_YCBCR_FULL_G22_NONE_P709_X601
+                                                    : DXGI_COLOR_SPACE_YCBCR_STUDIO_G22_LEFT_P601;   break;
+        case ColorMatrix::BT2020: input = fullRange ? DXGI_COLOR_SPACE_YCBCR_FULL_G22_LEFT_P2020
+                                                    : DXGI_COLOR_SPACE_YCBCR_STUDIO_G22_LEFT_P2020;  break;
+        default:                  input = fullRange ? DXGI_COLOR_SPACE_YCBCR_FULL_G22_LEFT_P709
+                                                    : DXGI_COLOR_SPACE_YCBCR_STUDIO_G22_LEFT_P709;   break;
+        }
+        m_videoContext1->VideoProcessorSetStreamColorSpace1(m_processor.Get(), 0, input);
+        m_videoContext1->VideoProcessorSetOutputColorSpace1(m_processor.Get(), DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709);
+        return;
+    }
+    // Legacy colour spaces have no BT.2020; Convert rejects it before this
+    D3D11_VIDEO_PROCESSOR_COLOR_SPACE input = {};
+    input.YCbCr_Matrix  = (matrix == ColorMatrix::BT601) ? 0 : 1;
+    input.Nominal_Range = fullRange ? D3D11_VIDEO_PROCESSOR_NOMINAL_RANGE_0_255 : D3D11_VIDEO_PROCESSOR_NOMINAL_RANGE_16_235;
+    m_videoContext->VideoProcessorSetStreamColorSpace(m_processor.Get(), 0, &input);
+    D3D11_VIDEO_PROCESSOR_COLOR_SPACE output = {};
+    output.RGB_Range = 0;  // Full range
+    m_videoContext->VideoProcessorSetOutputColorSpace(m_processor.Get(), &output);
+}
+
+bool VideoProcessorConverter::Convert(ID3D11Texture2D* surface, int arraySlice, int sourceWidth, int sourceHeight,
+                                      ColorMatrix matrix, bool fullRange, ID3D11Texture2D* output) {
+    if (!m_videoContext || !surface || !output || sourceWidth <= 0 || sourceHeight <= 0) return false;
+    if (matrix == ColorMatrix::BT2020 && !m_videoContext1) return false;
+
+    D3D11_TEXTURE2D_DESC srcDesc = {}, dstDesc = {};
+    surface->GetDesc(&srcDesc);
+    output->GetDesc(&dstDesc);
+    if (srcDesc.Format != DXGI_FORMAT_NV12 && srcDesc.Format != DXGI_FORMAT_P010) return false;
+    if (arraySlice < 0 || arraySlice >= static_cast<int>(srcDesc.ArraySize)) return false;
+    if (!EnsureProcessor(srcDesc.Width, srcDesc.Height, srcDesc.Format, dstDesc.Width, dstDesc.Height)) return false;
+
+    // The decoder allocates one texture array per surface pool: views are cached per slice
+    if (m_inputSurface.Get() != surface) {
+        m_inputSurface = surface;
+        m_inputViews.clear();
+        m_inputViews.resize(srcDesc.ArraySize);
+    }
+    ComPtr<ID3D11VideoProcessorInputView>& inputView = m_inputViews[arraySlice];
+    if (!inputView) {
+        D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC desc = {};
+        desc.ViewDimension            = D3D11_VPIV_DIMENSION_TEXTURE2D;
+        desc.Texture2D.ArraySlice     = static_cast<UINT>(arraySlice);
+        if (FAILED(m_videoDevice->CreateVideoProcessorInputView(surface, m_enumerator.Get(), &desc, &inputView))) {
+            return false;
+        }
+    }
+    if (m_outputTexture.Get() != output) {
+        m_outputView.Reset();
+        D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC desc = {};
+        desc.ViewDimension = D3D11_VPOV_DIMENSION_TEXTURE2D;
+        if (FAILED(m_videoDevice->CreateVideoProcessorOutputView(output, m_enumerator.Get(), &desc, &m_outputView))) {
+            m_outputTexture.Reset();
+            return false;
+        }
+        m_outputTexture = output;
+    }
+
+    SetColorSpaces(matrix, fullRange);
+    // Surfaces are padded to the codec's alignment (e.g. 1088 rows): crop to the picture
+    const RECT sourceRect = { 0, 0, sourceWidth, sourceHeight };
+    m_videoContext->VideoProcessorSetStreamSourceRect(m_processor.Get(), 0, TRUE, &sourceRect);
+
+    D3D11_VIDEO_PROCESSOR_STREAM stream = {};
+    stream.Enable        = TRUE;
+    stream.pInputSurface = inputView.Get();
+    return SUCCEEDED(m_videoContext->VideoProcessorBlt(m_processor.Get(), m_outputView.Get(), 0, 1, &stream));
+}
+
+} // namespace SP
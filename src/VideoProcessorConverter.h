@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Common.h"
+#include <d3d11_1.h>
+#include <vector>
+
+namespace SP {
+
+// Converts and scales D3D11VA decoder surfaces (NV12 / P010) to RGBA8 with the
+// GPU's fixed-function video processor (ID3D11VideoProcessor) instead of the YUV
+// shader pass, leaving the shader cores to the user effect. Colour matrix and
+// range come from the stream; BT.2020 needs ID3D11VideoContext1 (Windows 10).
+// Convert returns false whenever the driver can't do a frame, so the caller
+// falls back to the shader pass. Render thread only.
+class VideoProcessorConverter {
+public:
+    VideoProcessorConverter() = default;
+    ~VideoProcessorConverter() { Shutdown(); }
+
+    // Non-copyable
+    VideoProcessorConverter(const VideoProcessorConverter&) = delete;
+    VideoProcessorConverter& operator=(const VideoProcessorConverter&) = delete;
+
+    // False when the device has no video interface (WARP, some remote sessions)
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+    void Shutdown();
+    bool IsAvailable() const { return m_videoContext != nullptr; }
+
+    // Slice `arraySlice` of `surface`, cropped to sourceWidth x sourceHeight (the
+    // decoder pads to its alignment), into all of `output` (RGBA8, render target)
+    bool Convert(ID3D11Texture2D* surface, int arraySlice, int sourceWidth, int sourceHeight,
+                 ColorMatrix matrix, bool fullRange, ID3D11Texture2D* output);
+
+private:
+    // The processor is built for one input/output size pair and input format
+    bool EnsureProcessor(UINT inputWidth, UINT inputHeight, DXGI_FORMAT inputFormat,
+                         UINT outputWidth, UINT outputHeight);
+    void SetColorSpaces(ColorMatrix matrix, bool fullRange);
+
+    ComPtr<ID3D11Device>                   m_device;
+    ComPtr<ID3D11VideoDevice>              m_videoDevice;
+    ComPtr<ID3D11VideoContext>             m_videoContext;
+    ComPtr<ID3D11VideoContext1>            m_videoContext1;  // Null before Windows 10: no BT.2020
+    ComPtr<ID3D11VideoProcessorEnumerator> m_enumerator;
+    ComPtr<ID3D11VideoProcessor>           m_processor;
+    UINT        m_inputWidth   = 0;
+    UINT        m_inputHeight  = 0;
+    DXGI_FORMAT m_inputFormat  = DXGI_FORMAT_UNKNOWN;
+    UINT        m_outputWidth  = 0;
+    UINT        m_outputHeight = 0;
+
+    // Input views per slice of the decoder's surface array, dropped with the pool
+    ComPtr<ID3D11Texture2D> m_inputSurface;  // Held so a new pool can't reuse its address
+    std::vector<ComPtr<ID3D11VideoProcessorInputView>> m_inputViews;
+    ComPtr<ID3D11Texture2D>                  m_outputTexture;
+    ComPtr<ID3D11VideoProcessorOutputView>   m_outputView;
+};
+
+} // namespace SP
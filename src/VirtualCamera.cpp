@@ -0,0 +1,266 @@
+#include "VirtualCamera.h"
+#include "D3D11Renderer.h"
+#include "PixelCopy.h"
+#include <mfapi.h>
+
+namespace SP {
+
+namespace {
+
+constexpr double STATS_SMOOTHING = 0.1;  // Weight of the newest frame in the average
+constexpr auto   OPEN_RETRY      = std::chrono::seconds(1);
+
+double Smooth(double average, double sample) {
+    return average > 0.0 ? average + (sample - average) * STATS_SMOOTHING : sample;
+}
+
+// Resolved at run time: importing them would keep ShaderPlayer from starting
+// on Windows 10, where mfsensorgroup.dll lacks them
+struct VirtualCameraApi {
+    decltype(&MFCreateVirtualCamera)            create      = nullptr;
+    decltype(&MFIsVirtualCameraTypeSupported)   isSupported = nullptr;
+};
+
+const VirtualCameraApi* LoadVirtualCameraApi() {
+    static const VirtualCameraApi* s_api = []() -> const VirtualCameraApi* {
+        HMODULE module = LoadLibraryExW(L"mfsensorgroup.dll", nullptr, LOAD_LIBRARY_SEARCH_SYSTEM32);
+        if (!module) return nullptr;
+        static VirtualCameraApi api;
+        api.create      = reinterpret_cast<decltype(api.create)>(GetProcAddress(module, "MFCreateVirtualCamera"));
+        api.isSupported = reinterpret_cast<decltype(api.isSupported)>(
+            GetProcAddress(module, "MFIsVirtualCameraTypeSupported"));
+        return api.create && api.isSupported ? &api : nullptr;
+    }();
+    return s_api;
+}
+
+} // namespace
+
+VirtualCamera::~VirtualCamera() {
+    Stop();
+}
+
+bool VirtualCamera::IsAvailable() {
+    const VirtualCameraApi* api = LoadVirtualCameraApi();
+    BOOL supported = FALSE;
+    return api && SUCCEEDED(api->isSupported(MFVirtualCameraType_SoftwareCameraSource, &supported)) && supported;
+}
+
+bool VirtualCamera::Start(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& name) {
+    Stop();
+    if (!device || !context || !IsAvailable()) return false;
+    if (FAILED(MFStartup(MF_VERSION, MFSTARTUP_LITE))) return false;
+    m_mfStarted = true;
+
+    // Session lifetime: the camera goes away with this process, even on a crash
+    const std::wstring friendlyName(name.begin(), name.end());
+    ComPtr<IMFVirtualCamera> camera;
+    if (FAILED(LoadVirtualCameraApi()->create(MFVirtualCameraType_SoftwareCameraSource,
+                                              MFVirtualCameraLifetime_Session, MFVirtualCameraAccess_CurrentUser,
+                                              friendlyName.c_str(), VIRTUAL_CAMERA_SOURCE_CLSID, nullptr, 0,
+                                              &camera)) ||
+        FAILED(camera->Start(nullptr))) {  // Fails when the source's COM class is not registered
+        if (camera) camera->Shutdown();
+        Stop();
+        return false;
+    }
+    m_camera  = std::move(camera);
+    m_device  = device;
+    m_context = context;
+    m_sentGeneration = 0;
+    m_nextOpen = {};
+    return true;
+}
+
+void VirtualCamera::Stop() {
+    if (m_camera) {
+        m_camera->Stop();
+        m_camera->Shutdown();
+        m_camera.Reset();
+    }
+    if (m_mfStarted) {
+        MFShutdown();
+        m_mfStarted = false;
+    }
+    CloseSlot();
+
+    for (ReadbackSlot& slot : m_slots) slot = ReadbackSlot{};
+    m_chromaRTV.Reset();
+    m_lumaRTV.Reset();
+    m_convert.Reset();
+    m_convertWidth  = 0;
+    m_convertHeight = 0;
+    m_oldest = 0;
+    m_queued = 0;
+    m_streaming = false;
+    m_device  = nullptr;
+    m_context = nullptr;
+}
+
+bool VirtualCamera::OpenSlot() {
+    const auto now = std::chrono::steady_clock::now();
+    if (now < m_nextOpen) return false;
+    m_nextOpen = now + OPEN_RETRY;
+
+    // The source creates the mapping once a client opens the camera
+    m_mapping = OpenFileMappingW(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, VIRTUAL_CAMERA_MAPPING_NAME);
+    if (!m_mapping) return false;
+    m_slot = static_cast<VirtualCameraSlot*>(
+        MapViewOfFile(m_mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, sizeof(VirtualCameraSlot)));
+    if (!m_slot || m_slot->magic != VIRTUAL_CAMERA_MAGIC || m_slot->version != VIRTUAL_CAMERA_VERSION) {
+        CloseSlot();  // Another build's source
+        return false;
+    }
+    return true;
+}
+
+void VirtualCamera::CloseSlot() {
+    if (m_slot) UnmapViewOfFile(m_slot);
+    if (m_mapping) CloseHandle(m_mapping);
+    m_slot    = nullptr;
+    m_mapping = nullptr;
+}
+
+bool VirtualCamera::EnsureTargets(int width, int height) {
+    if (m_convert && m_convertWidth == width && m_convertHeight == height) return true;
+    m_chromaRTV.Reset();
+    m_lumaRTV.Reset();
+    m_convert.Reset();
+    m_convertWidth  = 0;
+    m_convertHeight = 0;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width            = static_cast<UINT>(width);
+    desc.Height           = static_cast<UINT>(height);
+    desc.MipLevels        = 1;
+    desc.ArraySize        = 1;
+    desc.Format           = DXGI_FORMAT_NV12;
+    desc.SampleDesc.Count = 1;
+    desc.Usage            = D3D11_USAGE_DEFAULT;
+    desc.BindFlags        = D3D11_BIND_RENDER_TARGET;
+    D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+    rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+    rtvDesc.Format        = DXGI_FORMAT_R8_UNORM;
+    if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &m_convert)) ||
+        FAILED(m_device->CreateRenderTargetView(m_convert.Get(), &rtvDesc, &m_lumaRTV))) {
+        m_lumaRTV.Reset();
+        m_convert.Reset();
+        return false;
+    }
+    rtvDesc.Format = DXGI_FORMAT_R8G8_UNORM;
+    if (FAILED(m_device->CreateRenderTargetView(m_convert.Get(), &rtvDesc, &m_chromaRTV))) {
+        m_lumaRTV.Reset();
+        m_convert.Reset();
+        return false;
+    }
+    m_convertWidth  = width;
+    m_convertHeight = height;
+    return true;
+}
+
+bool VirtualCamera::CollectReadback() {
+    if (m_queued == 0) return false;
+    ReadbackSlot& slot = m_slots[m_oldest];
+    if (m_context->GetData(slot.copied.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) return false;
+    m_oldest = (m_oldest + 1) % READBACK_SLOTS;
+    --m_queued;
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(m_context->Map(slot.staging.Get(), 0, D3D11_MAP_READ, 0, &mapped))) return true;
+    const auto start = std::chrono::steady_clock::now();
+
+    // The buffer the source is not reading; odd sequence while it is written
+    const uint32_t index = 1 - m_slot->latest.load(std::memory_order_relaxed);
+    VirtualCameraFrame& frame = m_slot->frames[index];
+    const uint64_t sequence = frame.sequence.load(std::memory_order_relaxed);
+    frame.sequence.store(sequence | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Mapped NV12: the CbCr rows follow the luma rows at RowPitch * height
+    const size_t rowBytes = static_cast<size_t>(slot.width);
+    const auto* source = static_cast<const uint8_t*>(mapped.pData);
+    CopyRows(frame.data, rowBytes, source, mapped.RowPitch, rowBytes, slot.height);
+    CopyRows(frame.data + rowBytes * slot.height, rowBytes, source + static_cast<size_t>(mapped.RowPitch) * slot.height,
+             mapped.RowPitch, rowBytes, slot.height / 2);
+    m_context->Unmap(slot.staging.Get(), 0);
+    frame.width  = static_cast<uint32_t>(slot.width);
+    frame.height = static_cast<uint32_t>(slot.height);
+
+    frame.sequence.store((sequence | 1) + 1, std::memory_order_release);
+    m_slot->latest.store(index, std::memory_order_release);
+    ++m_framesWritten;
+    m_avgCopyMs = Smooth(m_avgCopyMs,
+                         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return true;
+}
+
+bool VirtualCamera::SubmitFrame(D3D11Renderer& renderer, ID3D11ShaderResourceView* source, uint64_t generation) {
+    if (!m_camera || (!m_slot && !OpenSlot())) return false;
+
+    // Copies that landed, oldest first
+    while (CollectReadback()) {}
+
+    // Nobody watching: no conversion or readback
+    m_streaming    = m_slot->streaming.load(std::memory_order_acquire) != 0;
+    m_streamWidth  = static_cast<int>(std::min(m_slot->width.load(std::memory_order_relaxed), VIRTUAL_CAMERA_MAX_WIDTH));
+    m_streamHeight = static_cast<int>(std::min(m_slot->height.load(std::memory_order_relaxed), VIRTUAL_CAMERA_MAX_HEIGHT));
+    if (!m_streaming) {
+        m_sentGeneration = 0;  // A client that starts gets the current frame
+        return false;
+    }
+
+    if (!source) {
+        source     = renderer.GetDisplaySRV();
+        generation = renderer.GetDisplayGeneration();
+    }
+    if (!source || (generation == m_sentGeneration && source == m_sentSource)) return false;
+    if (m_queued == READBACK_SLOTS) {
+        ++m_framesDropped;
+        return false;  // Tried again next tick with whatever is newest then
+    }
+
+    const int width  = m_streamWidth & ~1;  // NV12 chroma is 2x2
+    const int height = m_streamHeight & ~1;
+    if (width < 2 || height < 2 || !EnsureTargets(width, height)) return false;
+
+    const int index = (m_oldest + m_queued) % READBACK_SLOTS;
+    ReadbackSlot& slot = m_slots[index];
+    if (slot.width != width || slot.height != height || !slot.staging) {
+        slot = ReadbackSlot{};
+        D3D11_TEXTURE2D_DESC desc = {};
+        m_convert->GetDesc(&desc);
+        desc.Usage          = D3D11_USAGE_STAGING;
+        desc.BindFlags      = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        D3D11_QUERY_DESC queryDesc = {};
+        queryDesc.Query = D3D11_QUERY_EVENT;
+        if (FAILED(m_device->CreateTexture2D(&desc, nullptr, &slot.staging)) ||
+            FAILED(m_device->CreateQuery(&queryDesc, &slot.copied))) {
+            slot = ReadbackSlot{};
+            return false;
+        }
+        slot.width  = width;
+        slot.height = height;
+    }
+
+    if (!renderer.ConvertToNv12(source, m_lumaRTV.Get(), m_chromaRTV.Get(), width, height)) return true;
+    m_context->CopyResource(slot.staging.Get(), m_convert.Get());
+    m_context->End(slot.copied.Get());
+    ++m_queued;
+    m_sentGeneration = generation;
+    m_sentSource     = source;
+    return true;
+}
+
+VirtualCameraStats VirtualCamera::GetStats() const {
+    VirtualCameraStats stats;
+    stats.framesWritten = m_framesWritten;
+    stats.framesDropped = m_framesDropped;
+    stats.streaming     = m_streaming;
+    stats.avgCopyMs     = m_avgCopyMs;
+    stats.width         = m_streamWidth;
+    stats.height        = m_streamHeight;
+    return stats;
+}
+
+} // namespace SP
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Common.h"
+#include "VirtualCameraSlot.h"
+#include <chrono>
+#include <mfidl.h>
+#include <mfvirtualcamera.h>
+
+namespace SP {
+
+class D3D11Renderer;
+
+struct VirtualCameraStats {
+    int64_t framesWritten = 0;
+    int64_t framesDropped = 0;  // Readback ring full
+    bool    streaming     = false;  // A camera client has the stream started
+    double  avgCopyMs     = 0.0;    // Map + copy of a landed readback into the frame slot
+    int     width  = 0;             // The size the client picked
+    int     height = 0;
+};
+
+// Windows 11 virtual camera: ShaderPlayer appears as a camera device in any app
+// (Teams, OBS, the Camera app) without a second program. MFCreateVirtualCamera
+// registers a session-lifetime camera whose media source is our COM class in
+// ShaderPlayerVCam.dll, which the Camera Frame Server service loads when a
+// client opens the device. Frames cross over through the shared-memory slot of
+// VirtualCameraSlot.h: the display texture is converted to NV12 at the size the
+// client picked (D3D11Renderer::ConvertToNv12), read back through a ring of
+// staging textures like NdiOutput, and copied once into the slot; the source
+// copies the newest frame into each sample. Only frames the renderer drew are
+// converted, and nothing at all while no client is streaming.
+class VirtualCamera {
+public:
+    VirtualCamera() = default;
+    ~VirtualCamera();
+
+    VirtualCamera(const VirtualCamera&) = delete;
+    VirtualCamera& operator=(const VirtualCamera&) = delete;
+
+    // MFCreateVirtualCamera exists (Windows 11) and supports software sources
+    static bool IsAvailable();
+
+    // Fails without Windows 11 or when ShaderPlayerVCam.dll is not registered
+    bool Start(ID3D11Device* device, ID3D11DeviceContext* context, const std::string& name);
+    void Stop();
+    bool IsRunning() const { return m_camera != nullptr; }
+    // A client had the stream started at the last SubmitFrame
+    bool IsStreaming() const { return m_streaming; }
+    int  GetStreamWidth()  const { return m_streamWidth; }
+    int  GetStreamHeight() const { return m_streamHeight; }
+
+    // Call after D3D11Renderer::RenderToDisplay. Copies landed readbacks into
+    // the frame slot, then converts and queues the display texture if the
+    // renderer drew since the last call. True when it drew (the caller restores
+    // the pipeline with BeginFrame). A post chain's result and its
+    // PostChain::generation replace the display texture.
+    bool SubmitFrame(D3D11Renderer& renderer, ID3D11ShaderResourceView* source = nullptr, uint64_t generation = 0);
+    VirtualCameraStats GetStats() const;
+
+private:
+    static constexpr int READBACK_SLOTS = 3;
+
+    struct ReadbackSlot {
+        ComPtr<ID3D11Texture2D> staging;
+        ComPtr<ID3D11Query>     copied;
+        int width  = 0;
+        int height = 0;
+    };
+
+    bool OpenSlot();  // The source's mapping, retried at most once a second
+    void CloseSlot();
+    bool EnsureTargets(int width, int height);
+    bool CollectReadback();  // Oldest queued copy into the frame slot, if it landed
+
+    ID3D11Device*            m_device  = nullptr;
+    ID3D11DeviceContext*     m_context = nullptr;
+    ComPtr<IMFVirtualCamera> m_camera;
+    bool                     m_mfStarted = false;
+
+    HANDLE             m_mapping = nullptr;
+    VirtualCameraSlot* m_slot    = nullptr;
+    std::chrono::steady_clock::time_point m_nextOpen{};
+
+    // GPU side: the NV12 conversion target with its plane views, and the
+    // readback ring (queue order from m_oldest)
+    ComPtr<ID3D11Texture2D>        m_convert;
+    ComPtr<ID3D11RenderTargetView> m_lumaRTV;
+    ComPtr<ID3D11RenderTargetView> m_chromaRTV;
+    int m_convertWidth  = 0;
+    int m_convertHeight = 0;
+    ReadbackSlot m_slots[READBACK_SLOTS];
+    int m_oldest = 0;
+    int m_queued = 0;
+
+    uint64_t m_sentGeneration = 0;
+    ID3D11ShaderResourceView* m_sentSource = nullptr;  // Compared only, never dereferenced
+    bool    m_streaming     = false;
+    int     m_streamWidth   = 0;
+    int     m_streamHeight  = 0;
+    int64_t m_framesWritten = 0;
+    int64_t m_framesDropped = 0;
+    double  m_avgCopyMs     = 0.0;
+};
+
+} // namespace SP
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace SP {
+
+// The shared-memory frame slot between ShaderPlayer (VirtualCamera, the writer)
+// and the camera source DLL (VirtualCameraSource.cpp, loaded by the Windows
+// Camera Frame Server service). The source creates the mapping when a client
+// starts the camera, in the Global namespace with a DACL interactive users can
+// write (a service cannot see a session's Local objects, and a standard user
+// may not create Global ones); ShaderPlayer opens it and writes NV12 frames.
+//
+// The source publishes the format the client picked (width, height, rate) and
+// `streaming` while it runs, so ShaderPlayer converts at exactly that size and
+// nothing at all while no client is reading. Frames alternate between two
+// buffers, each under a sequence lock (odd while being written): the reader
+// copies the one `latest` names and retries if its sequence moved, so a torn
+// frame is never delivered and the writer never waits.
+constexpr wchar_t VIRTUAL_CAMERA_MAPPING_NAME[] = L"Global\\ShaderPlayerVirtualCamera";
+// COM class of the source (ShaderPlayerVCam.dll, registered with regsvr32)
+constexpr wchar_t VIRTUAL_CAMERA_SOURCE_CLSID[] = L"{7B4C3E1A-5D2F-4A8B-9C6E-1F0D3A2B5C48}";
+constexpr uint32_t VIRTUAL_CAMERA_MAGIC   = 0x4D435053;  // "SPCM"
+constexpr uint32_t VIRTUAL_CAMERA_VERSION = 1;
+constexpr uint32_t VIRTUAL_CAMERA_MAX_WIDTH  = 3840;
+constexpr uint32_t VIRTUAL_CAMERA_MAX_HEIGHT = 2160;
+constexpr size_t   VIRTUAL_CAMERA_FRAME_BYTES =
+    static_cast<size_t>(VIRTUAL_CAMERA_MAX_WIDTH) * VIRTUAL_CAMERA_MAX_HEIGHT * 3 / 2;  // NV12
+
+struct VirtualCameraFrame {
+    std::atomic<uint64_t> sequence;  // Even = stable, odd = being written, 0 = never written
+    uint32_t width;                  // Of the data below; planes are tightly packed (stride = width)
+    uint32_t height;
+    uint8_t  data[VIRTUAL_CAMERA_FRAME_BYTES];  // Y plane, then interleaved CbCr at half height
+};
+
+struct VirtualCameraSlot {
+    uint32_t magic;
+    uint32_t version;
+    // Written by the camera source
+    std::atomic<uint32_t> streaming;  // A client has the stream started
+    std::atomic<uint32_t> width;      // The media type the client picked
+    std::atomic<uint32_t> height;
+    std::atomic<uint32_t> frameRateN;
+    std::atomic<uint32_t> frameRateD;
+    // Written by ShaderPlayer
+    std::atomic<uint32_t> latest;     // Index of the newest complete frame
+    VirtualCameraFrame    frames[2];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "the slot's atomics are shared between processes");
+
+// Bytes of a tightly packed NV12 frame
+inline size_t Nv12FrameBytes(uint32_t width, uint32_t height) {
+    return static_cast<size_t>(width) * height + static_cast<size_t>(width) * ((height + 1) / 2);
+}
+
+} // namespace SP
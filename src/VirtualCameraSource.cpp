@@ -0,0 +1,678 @@
+// ShaderPlayerVCam.dll — the media source of ShaderPlayer's virtual camera.
+// MFCreateVirtualCamera (VirtualCamera.cpp) registers a camera whose source is
+// this COM class; the Windows Camera Frame Server service loads the DLL when a
+// client opens the camera and activates it through IMFActivate. The source has
+// one NV12 stream. It creates the shared-memory frame slot (VirtualCameraSlot.h),
+// publishes the media type the client picked, and copies ShaderPlayer's newest
+// frame into each sample; black while ShaderPlayer has written none.
+// Register with `regsvr32 ShaderPlayerVCam.dll` (as administrator).
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <sddl.h>
+#include <wrl/implements.h>
+#include <wrl/module.h>
+#include <mfapi.h>
+#include <mfidl.h>
+#include <mferror.h>
+#include <ks.h>
+#include <ksproxy.h>
+#include <ksmedia.h>
+
+#include "VirtualCameraSlot.h"
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <string>
+
+using Microsoft::WRL::ChainInterfaces;
+using Microsoft::WRL::ClassicCom;
+using Microsoft::WRL::ComPtr;
+using Microsoft::WRL::Module;
+using Microsoft::WRL::InProc;
+using Microsoft::WRL::RuntimeClass;
+using Microsoft::WRL::RuntimeClassFlags;
+
+namespace SP {
+
+namespace {
+
+HMODULE g_module = nullptr;
+
+// The formats offered to clients; the first is the default. ShaderPlayer
+// renders at whichever is picked, so any size costs the same copy per pixel.
+struct StreamFormat {
+    UINT32 width;
+    UINT32 height;
+    UINT32 frameRateN;
+    UINT32 frameRateD;
+};
+constexpr StreamFormat STREAM_FORMATS[] = {
+    { 1920, 1080, 30, 1 },
+    { 1280,  720, 30, 1 },
+    { 1920, 1080, 60, 1 },
+    { 1280,  720, 60, 1 },
+    { 3840, 2160, 30, 1 },
+    {  640,  360, 30, 1 },
+};
+constexpr int SEQUENCE_RETRIES = 3;  // Torn reads in a row before the previous frame is repeated
+// Frame Server runs as LocalService; ShaderPlayer as the interactive user
+constexpr wchar_t SLOT_SDDL[] = L"D:P(A;;GA;;;SY)(A;;GA;;;LS)(A;;GA;;;BA)(A;;GRGW;;;IU)";
+
+HRESULT KsNotFound() { return HRESULT_FROM_WIN32(ERROR_SET_NOT_FOUND); }
+
+// The source's end of VirtualCameraSlot: creates the mapping, publishes the
+// stream format and reads frames under their sequence locks
+class FrameSlot {
+public:
+    ~FrameSlot() { Close(); }
+
+    bool Open() {
+        if (m_slot) return true;
+        PSECURITY_DESCRIPTOR descriptor = nullptr;
+        if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(SLOT_SDDL, SDDL_REVISION_1, &descriptor, nullptr))
+            return false;
+        SECURITY_ATTRIBUTES attributes = { sizeof(attributes), descriptor, FALSE };
+        const ULONGLONG size = sizeof(VirtualCameraSlot);
+        m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, &attributes, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                                       static_cast<DWORD>(size), VIRTUAL_CAMERA_MAPPING_NAME);
+        const bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+        LocalFree(descriptor);
+        if (!m_mapping) return false;
+        m_slot = static_cast<VirtualCameraSlot*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(VirtualCameraSlot)));
+        if (!m_slot) {
+            Close();
+            return false;
+        }
+        if (!existed) {  // Fresh pages are zero: no frame yet, buffer 0 latest
+            m_slot->magic   = VIRTUAL_CAMERA_MAGIC;
+            m_slot->version = VIRTUAL_CAMERA_VERSION;
+        } else if (m_slot->magic != VIRTUAL_CAMERA_MAGIC || m_slot->version != VIRTUAL_CAMERA_VERSION) {
+            Close();  // Kept open by another build of ShaderPlayer
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+        if (m_slot) {
+            m_slot->streaming.store(0, std::memory_order_release);
+            UnmapViewOfFile(m_slot);
+        }
+        if (m_mapping) CloseHandle(m_mapping);
+        m_slot    = nullptr;
+        m_mapping = nullptr;
+    }
+
+    void Publish(const StreamFormat& format, bool streaming) {
+        if (!m_slot) return;
+        m_slot->width.store(format.width, std::memory_order_relaxed);
+        m_slot->height.store(format.height, std::memory_order_relaxed);
+        m_slot->frameRateN.store(format.frameRateN, std::memory_order_relaxed);
+        m_slot->frameRateD.store(format.frameRateD, std::memory_order_relaxed);
+        m_slot->streaming.store(streaming ? 1 : 0, std::memory_order_release);
+    }
+
+    // The newest frame into `dest` when it has this size; false = none (yet)
+    bool Read(uint8_t* dest, UINT32 width, UINT32 height) const {
+        if (!m_slot) return false;
+        for (int attempt = 0; attempt < SEQUENCE_RETRIES; ++attempt) {
+            const VirtualCameraFrame& frame = m_slot->frames[m_slot->latest.load(std::memory_order_acquire) & 1];
+            const uint64_t before = frame.sequence.load(std::memory_order_acquire);
+            if (before == 0 || (before & 1)) continue;
+            if (frame.width != width || frame.height != height) return false;  // Still converting at the old size
+            std::memcpy(dest, frame.data, Nv12FrameBytes(width, height));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (frame.sequence.load(std::memory_order_relaxed) == before) return true;
+        }
+        return false;
+    }
+
+private:
+    HANDLE             m_mapping = nullptr;
+    VirtualCameraSlot* m_slot    = nullptr;
+};
+
+HRESULT CreateMediaType(const StreamFormat& format, IMFMediaType** outType) {
+    ComPtr<IMFMediaType> type;
+    HRESULT hr = MFCreateMediaType(&type);
+    if (SUCCEEDED(hr)) hr = type->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+    if (SUCCEEDED(hr)) hr = type->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_NV12);
+    if (SUCCEEDED(hr)) hr = MFSetAttributeSize(type.Get(), MF_MT_FRAME_SIZE, format.width, format.height);
+    if (SUCCEEDED(hr)) hr = MFSetAttributeRatio(type.Get(), MF_MT_FRAME_RATE, format.frameRateN, format.frameRateD);
+    if (SUCCEEDED(hr)) hr = MFSetAttributeRatio(type.Get(), MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
+    if (SUCCEEDED(hr)) hr = type->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
+    if (SUCCEEDED(hr)) hr = type->SetUINT32(MF_MT_ALL_SAMPLES_INDEPENDENT, TRUE);
+    if (SUCCEEDED(hr)) hr = type->SetUINT32(MF_MT_FIXED_SIZE_SAMPLES, TRUE);
+    if (SUCCEEDED(hr)) hr = type->SetUINT32(MF_MT_DEFAULT_STRIDE, format.width);
+    if (SUCCEEDED(hr))
+        hr = type->SetUINT32(MF_MT_SAMPLE_SIZE, static_cast<UINT32>(Nv12FrameBytes(format.width, format.height)));
+    // What D3D11Renderer::ConvertToNv12 writes: BT.709, limited range
+    if (SUCCEEDED(hr)) hr = type->SetUINT32(MF_MT_YUV_MATRIX, MFVideoTransferMatrix_BT709);
+    if (SUCCEEDED(hr)) hr = type->SetUINT32(MF_MT_VIDEO_PRIMARIES, MFVideoPrimaries_BT709);
+    if (SUCCEEDED(hr)) hr = type->SetUINT32(MF_MT_VIDEO_NOMINAL_RANGE, MFNominalRange_16_235);
+    if (SUCCEEDED(hr)) *outType = type.Detach();
+    return hr;
+}
+
+// The attributes Frame Server needs on a camera stream (also on its descriptor)
+HRESULT SetStreamAttributes(IMFAttributes* attributes) {
+    HRESULT hr = attributes->SetGUID(MF_DEVICESTREAM_STREAM_CATEGORY, PINNAME_VIDEO_CAPTURE);
+    if (SUCCEEDED(hr)) hr = attributes->SetUINT32(MF_DEVICESTREAM_STREAM_ID, 0);
+    if (SUCCEEDED(hr)) hr = attributes->SetUINT32(MF_DEVICESTREAM_FRAMESERVER_SHARED, 1);
+    if (SUCCEEDED(hr)) hr = attributes->SetUINT32(MF_DEVICESTREAM_ATTRIBUTE_FRAMESOURCE_TYPES, MFFrameSourceTypes_Color);
+    return hr;
+}
+
+class MediaSource;
+
+class MediaStream : public RuntimeClass<RuntimeClassFlags<ClassicCom>,
+                                        ChainInterfaces<IMFMediaStream2, IMFMediaStream, IMFMediaEventGenerator>,
+                                        IKsControl> {
+public:
+    HRESULT RuntimeClassInitialize(MediaSource* parent, FrameSlot* slot);
+
+    // From MediaSource, under its lock
+    HRESULT Start(IMFStreamDescriptor* descriptor);
+    HRESULT Stop();
+    void Shutdown();
+    IMFAttributes* GetAttributes() const { return m_attributes.Get(); }
+    IMFStreamDescriptor* GetDescriptor() const { return m_descriptor.Get(); }
+
+    // IMFMediaEventGenerator
+    STDMETHODIMP GetEvent(DWORD flags, IMFMediaEvent** event) override;
+    STDMETHODIMP BeginGetEvent(IMFAsyncCallback* callback, IUnknown* state) override;
+    STDMETHODIMP EndGetEvent(IMFAsyncResult* result, IMFMediaEvent** event) override;
+    STDMETHODIMP QueueEvent(MediaEventType type, REFGUID extendedType, HRESULT status,
+                            const PROPVARIANT* value) override;
+    // IMFMediaStream
+    STDMETHODIMP GetMediaSource(IMFMediaSource** source) override;
+    STDMETHODIMP GetStreamDescriptor(IMFStreamDescriptor** descriptor) override;
+    STDMETHODIMP RequestSample(IUnknown* token) override;
+    // IMFMediaStream2
+    STDMETHODIMP SetStreamState(MF_STREAM_STATE state) override;
+    STDMETHODIMP GetStreamState(MF_STREAM_STATE* state) override;
+    // IKsControl: no properties, methods or events
+    STDMETHODIMP KsProperty(PKSPROPERTY, ULONG, LPVOID, ULONG, ULONG*) override { return KsNotFound(); }
+    STDMETHODIMP KsMethod(PKSMETHOD, ULONG, LPVOID, ULONG, ULONG*) override { return KsNotFound(); }
+    STDMETHODIMP KsEvent(PKSEVENT, ULONG, LPVOID, ULONG, ULONG*) override { return KsNotFound(); }
+
+private:
+    std::mutex                   m_mutex;
+    MediaSource*                 m_parent = nullptr;  // Null after Shutdown
+    FrameSlot*                   m_slot   = nullptr;  // Owned by the parent
+    ComPtr<IMFMediaEventQueue>   m_queue;
+    ComPtr<IMFStreamDescriptor>  m_descriptor;
+    ComPtr<IMFAttributes>        m_attributes;
+    MF_STREAM_STATE              m_state  = MF_STREAM_STATE_STOPPED;
+    StreamFormat                 m_format = STREAM_FORMATS[0];
+};
+
+class MediaSource : public RuntimeClass<RuntimeClassFlags<ClassicCom>,
+                                        ChainInterfaces<IMFMediaSourceEx, IMFMediaSource, IMFMediaEventGenerator>,
+                                        IMFGetService, IKsControl> {
+public:
+    HRESULT RuntimeClassInitialize();
+    ~MediaSource() { Shutdown(); }
+
+    // IMFMediaEventGenerator
+    STDMETHODIMP GetEvent(DWORD flags, IMFMediaEvent** event) override;
+    STDMETHODIMP BeginGetEvent(IMFAsyncCallback* callback, IUnknown* state) override;
+    STDMETHODIMP EndGetEvent(IMFAsyncResult* result, IMFMediaEvent** event) override;
+    STDMETHODIMP QueueEvent(MediaEventType type, REFGUID extendedType, HRESULT status,
+                            const PROPVARIANT* value) override;
+    // IMFMediaSource
+    STDMETHODIMP GetCharacteristics(DWORD* characteristics) override;
+    STDMETHODIMP CreatePresentationDescriptor(IMFPresentationDescriptor** descriptor) override;
+    STDMETHODIMP Start(IMFPresentationDescriptor* descriptor, const GUID* timeFormat,
+                       const PROPVARIANT* startPosition) override;
+    STDMETHODIMP Stop() override;
+    STDMETHODIMP Pause() override { return MF_E_INVALID_STATE_TRANSITION; }  // Live
+    STDMETHODIMP Shutdown() override;
+    // IMFMediaSourceEx
+    STDMETHODIMP GetSourceAttributes(IMFAttributes** attributes) override;
+    STDMETHODIMP GetStreamAttributes(DWORD streamId, IMFAttributes** attributes) override;
+    STDMETHODIMP SetD3DManager(IUnknown*) override { return S_OK; }  // Samples are system memory
+    // IMFGetService
+    STDMETHODIMP GetService(REFGUID, REFIID, LPVOID*) override { return MF_E_UNSUPPORTED_SERVICE; }
+    // IKsControl: no properties, methods or events
+    STDMETHODIMP KsProperty(PKSPROPERTY, ULONG, LPVOID, ULONG, ULONG*) override { return KsNotFound(); }
+    STDMETHODIMP KsMethod(PKSMETHOD, ULONG, LPVOID, ULONG, ULONG*) override { return KsNotFound(); }
+    STDMETHODIMP KsEvent(PKSEVENT, ULONG, LPVOID, ULONG, ULONG*) override { return KsNotFound(); }
+
+private:
+    std::mutex                        m_mutex;
+    bool                              m_shutdown = false;
+    bool                              m_started  = false;  // MENewStream was sent
+    FrameSlot                         m_slot;
+    ComPtr<IMFMediaEventQueue>        m_queue;
+    ComPtr<IMFAttributes>             m_attributes;
+    ComPtr<IMFPresentationDescriptor> m_descriptor;
+    ComPtr<MediaStream>               m_stream;
+};
+
+// ---- MediaStream ----
+
+HRESULT MediaStream::RuntimeClassInitialize(MediaSource* parent, FrameSlot* slot) {
+    m_parent = parent;
+    m_slot   = slot;
+    HRESULT hr = MFCreateEventQueue(&m_queue);
+    if (FAILED(hr)) return hr;
+
+    IMFMediaType* types[std::size(STREAM_FORMATS)] = {};
+    for (size_t i = 0; i < std::size(STREAM_FORMATS) && SUCCEEDED(hr); ++i)
+        hr = CreateMediaType(STREAM_FORMATS[i], &types[i]);
+    if (SUCCEEDED(hr)) hr = MFCreateStreamDescriptor(0, static_cast<DWORD>(std::size(types)), types, &m_descriptor);
+    ComPtr<IMFMediaTypeHandler> handler;
+    if (SUCCEEDED(hr)) hr = m_descriptor->GetMediaTypeHandler(&handler);
+    if (SUCCEEDED(hr)) hr = handler->SetCurrentMediaType(types[0]);
+    for (IMFMediaType* type : types) {
+        if (type) type->Release();
+    }
+    if (SUCCEEDED(hr)) hr = SetStreamAttributes(m_descriptor.Get());
+    if (SUCCEEDED(hr)) hr = MFCreateAttributes(&m_attributes, 4);
+    if (SUCCEEDED(hr)) hr = SetStreamAttributes(m_attributes.Get());
+    return hr;
+}
+
+HRESULT MediaStream::Start(IMFStreamDescriptor* descriptor) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return MF_E_SHUTDOWN;
+
+    // The type the client set on the descriptor it passed to Start
+    ComPtr<IMFMediaTypeHandler> handler;
+    ComPtr<IMFMediaType> type;
+    HRESULT hr = descriptor->GetMediaTypeHandler(&handler);
+    if (SUCCEEDED(hr)) hr = handler->GetCurrentMediaType(&type);
+    if (SUCCEEDED(hr)) hr = MFGetAttributeSize(type.Get(), MF_MT_FRAME_SIZE, &m_format.width, &m_format.height);
+    if (SUCCEEDED(hr))
+        hr = MFGetAttributeRatio(type.Get(), MF_MT_FRAME_RATE, &m_format.frameRateN, &m_format.frameRateD);
+    if (FAILED(hr)) return hr;
+    if (m_format.width > VIRTUAL_CAMERA_MAX_WIDTH || m_format.height > VIRTUAL_CAMERA_MAX_HEIGHT ||
+        m_format.frameRateN == 0 || m_format.frameRateD == 0)
+        return MF_E_INVALIDMEDIATYPE;
+
+    m_state = MF_STREAM_STATE_RUNNING;
+    m_slot->Publish(m_format, true);
+    PROPVARIANT time;
+    PropVariantInit(&time);
+    time.vt          = VT_I8;
+    time.hVal.QuadPart = MFGetSystemTime();
+    return m_queue->QueueEventParamVar(MEStreamStarted, GUID_NULL, S_OK, &time);
+}
+
+HRESULT MediaStream::Stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return MF_E_SHUTDOWN;
+    m_state = MF_STREAM_STATE_STOPPED;
+    m_slot->Publish(m_format, false);  // ShaderPlayer stops converting
+    return m_queue->QueueEventParamVar(MEStreamStopped, GUID_NULL, S_OK, nullptr);
+}
+
+void MediaStream::Shutdown() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return;
+    m_queue->Shutdown();
+    m_parent = nullptr;
+    m_slot   = nullptr;
+    m_state  = MF_STREAM_STATE_STOPPED;
+}
+
+STDMETHODIMP MediaStream::GetEvent(DWORD flags, IMFMediaEvent** event) {
+    // Not under the lock: a blocking GetEvent must not hold up RequestSample
+    ComPtr<IMFMediaEventQueue> queue;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_parent) return MF_E_SHUTDOWN;
+        queue = m_queue;
+    }
+    return queue->GetEvent(flags, event);
+}
+
+STDMETHODIMP MediaStream::BeginGetEvent(IMFAsyncCallback* callback, IUnknown* state) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return MF_E_SHUTDOWN;
+    return m_queue->BeginGetEvent(callback, state);
+}
+
+STDMETHODIMP MediaStream::EndGetEvent(IMFAsyncResult* result, IMFMediaEvent** event) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return MF_E_SHUTDOWN;
+    return m_queue->EndGetEvent(result, event);
+}
+
+STDMETHODIMP MediaStream::QueueEvent(MediaEventType type, REFGUID extendedType, HRESULT status,
+                                     const PROPVARIANT* value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return MF_E_SHUTDOWN;
+    return m_queue->QueueEventParamVar(type, extendedType, status, value);
+}
+
+STDMETHODIMP MediaStream::GetMediaSource(IMFMediaSource** source) {
+    if (!source) return E_POINTER;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return MF_E_SHUTDOWN;
+    return m_parent->QueryInterface(IID_PPV_ARGS(source));
+}
+
+STDMETHODIMP MediaStream::GetStreamDescriptor(IMFStreamDescriptor** descriptor) {
+    if (!descriptor) return E_POINTER;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return MF_E_SHUTDOWN;
+    return m_descriptor.CopyTo(descriptor);
+}
+
+STDMETHODIMP MediaStream::RequestSample(IUnknown* token) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return MF_E_SHUTDOWN;
+    if (m_state != MF_STREAM_STATE_RUNNING) return MF_E_INVALIDREQUEST;
+
+    // The one copy on this side: slot → sample. The slot is overwritten by the
+    // next frame while the client still holds this one.
+    const DWORD bytes = static_cast<DWORD>(Nv12FrameBytes(m_format.width, m_format.height));
+    ComPtr<IMFMediaBuffer> buffer;
+    HRESULT hr = MFCreateMemoryBuffer(bytes, &buffer);
+    BYTE* data = nullptr;
+    if (SUCCEEDED(hr)) hr = buffer->Lock(&data, nullptr, nullptr);
+    if (FAILED(hr)) return hr;
+    if (!m_slot->Read(data, m_format.width, m_format.height)) {
+        const size_t lumaBytes = static_cast<size_t>(m_format.width) * m_format.height;
+        std::memset(data, 16, lumaBytes);  // Black, limited range
+        std::memset(data + lumaBytes, 128, bytes - lumaBytes);
+    }
+    buffer->Unlock();
+    buffer->SetCurrentLength(bytes);
+
+    ComPtr<IMFSample> sample;
+    hr = MFCreateSample(&sample);
+    if (SUCCEEDED(hr)) hr = sample->AddBuffer(buffer.Get());
+    if (SUCCEEDED(hr)) hr = sample->SetSampleTime(MFGetSystemTime());
+    if (SUCCEEDED(hr))
+        hr = sample->SetSampleDuration(10'000'000LL * m_format.frameRateD / m_format.frameRateN);
+    if (SUCCEEDED(hr) && token) hr = sample->SetUnknown(MFSampleExtension_Token, token);
+    if (SUCCEEDED(hr)) hr = m_queue->QueueEventParamUnk(MEMediaSample, GUID_NULL, S_OK, sample.Get());
+    return hr;
+}
+
+STDMETHODIMP MediaStream::SetStreamState(MF_STREAM_STATE state) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return MF_E_SHUTDOWN;
+    if (state == m_state) return S_OK;
+    m_state = state;
+    m_slot->Publish(m_format, state == MF_STREAM_STATE_RUNNING);
+    return S_OK;
+}
+
+STDMETHODIMP MediaStream::GetStreamState(MF_STREAM_STATE* state) {
+    if (!state) return E_POINTER;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_parent) return MF_E_SHUTDOWN;
+    *state = m_state;
+    return S_OK;
+}
+
+// ---- MediaSource ----
+
+HRESULT MediaSource::RuntimeClassInitialize() {
+    HRESULT hr = MFCreateEventQueue(&m_queue);
+    if (SUCCEEDED(hr)) hr = MFCreateAttributes(&m_attributes, 1);
+    if (SUCCEEDED(hr)) hr = Microsoft::WRL::MakeAndInitialize<MediaStream>(&m_stream, this, &m_slot);
+    IMFStreamDescriptor* streams[] = { m_stream ? m_stream->GetDescriptor() : nullptr };
+    if (SUCCEEDED(hr)) hr = MFCreatePresentationDescriptor(1, streams, &m_descriptor);
+    if (SUCCEEDED(hr)) hr = m_descriptor->SelectStream(0);
+    // Without the slot the camera still works, showing black
+    m_slot.Open();
+    return hr;
+}
+
+STDMETHODIMP MediaSource::GetEvent(DWORD flags, IMFMediaEvent** event) {
+    ComPtr<IMFMediaEventQueue> queue;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_shutdown) return MF_E_SHUTDOWN;
+        queue = m_queue;
+    }
+    return queue->GetEvent(flags, event);
+}
+
+STDMETHODIMP MediaSource::BeginGetEvent(IMFAsyncCallback* callback, IUnknown* state) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return MF_E_SHUTDOWN;
+    return m_queue->BeginGetEvent(callback, state);
+}
+
+STDMETHODIMP MediaSource::EndGetEvent(IMFAsyncResult* result, IMFMediaEvent** event) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return MF_E_SHUTDOWN;
+    return m_queue->EndGetEvent(result, event);
+}
+
+STDMETHODIMP MediaSource::QueueEvent(MediaEventType type, REFGUID extendedType, HRESULT status,
+                                     const PROPVARIANT* value) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return MF_E_SHUTDOWN;
+    return m_queue->QueueEventParamVar(type, extendedType, status, value);
+}
+
+STDMETHODIMP MediaSource::GetCharacteristics(DWORD* characteristics) {
+    if (!characteristics) return E_POINTER;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return MF_E_SHUTDOWN;
+    *characteristics = MFMEDIASOURCE_IS_LIVE;
+    return S_OK;
+}
+
+STDMETHODIMP MediaSource::CreatePresentationDescriptor(IMFPresentationDescriptor** descriptor) {
+    if (!descriptor) return E_POINTER;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return MF_E_SHUTDOWN;
+    return m_descriptor->Clone(descriptor);
+}
+
+STDMETHODIMP MediaSource::Start(IMFPresentationDescriptor* descriptor, const GUID* timeFormat,
+                                const PROPVARIANT*) {
+    if (!descriptor) return E_POINTER;
+    if (timeFormat && *timeFormat != GUID_NULL) return MF_E_UNSUPPORTED_TIME_FORMAT;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return MF_E_SHUTDOWN;
+
+    BOOL selected = FALSE;
+    ComPtr<IMFStreamDescriptor> stream;
+    HRESULT hr = descriptor->GetStreamDescriptorByIndex(0, &selected, &stream);
+    if (FAILED(hr)) return hr;
+    if (!selected) return MF_E_INVALIDREQUEST;
+    m_slot.Open();  // Again, in case ShaderPlayer's old mapping was still held last time
+
+    hr = m_queue->QueueEventParamUnk(m_started ? MEUpdatedStream : MENewStream, GUID_NULL, S_OK,
+                                     static_cast<IMFMediaStream*>(m_stream.Get()));
+    if (SUCCEEDED(hr)) hr = m_stream->Start(stream.Get());
+    if (FAILED(hr)) return hr;
+    m_started = true;
+
+    PROPVARIANT time;
+    PropVariantInit(&time);
+    time.vt            = VT_I8;
+    time.hVal.QuadPart = MFGetSystemTime();
+    return m_queue->QueueEventParamVar(MESourceStarted, GUID_NULL, S_OK, &time);
+}
+
+STDMETHODIMP MediaSource::Stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return MF_E_SHUTDOWN;
+    HRESULT hr = m_stream->Stop();
+    if (SUCCEEDED(hr)) hr = m_queue->QueueEventParamVar(MESourceStopped, GUID_NULL, S_OK, nullptr);
+    return hr;
+}
+
+STDMETHODIMP MediaSource::Shutdown() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return S_OK;
+    m_shutdown = true;
+    if (m_stream) m_stream->Shutdown();
+    if (m_queue) m_queue->Shutdown();
+    m_slot.Close();
+    return S_OK;
+}
+
+STDMETHODIMP MediaSource::GetSourceAttributes(IMFAttributes** attributes) {
+    if (!attributes) return E_POINTER;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return MF_E_SHUTDOWN;
+    return m_attributes.CopyTo(attributes);
+}
+
+STDMETHODIMP MediaSource::GetStreamAttributes(DWORD streamId, IMFAttributes** attributes) {
+    if (!attributes) return E_POINTER;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shutdown) return MF_E_SHUTDOWN;
+    if (streamId != 0) return MF_E_INVALIDSTREAMNUMBER;
+    IMFAttributes* stream = m_stream->GetAttributes();
+    stream->AddRef();
+    *attributes = stream;
+    return S_OK;
+}
+
+} // namespace
+
+// ---- Activator: the COM class Frame Server creates ----
+
+// IMFActivate is an IMFAttributes; those calls go to m_attributes
+class __declspec(uuid("7B4C3E1A-5D2F-4A8B-9C6E-1F0D3A2B5C48")) VirtualCameraActivator
+    : public RuntimeClass<RuntimeClassFlags<ClassicCom>, ChainInterfaces<IMFActivate, IMFAttributes>> {
+public:
+    HRESULT RuntimeClassInitialize() { return MFCreateAttributes(&m_attributes, 1); }
+
+    STDMETHODIMP ActivateObject(REFIID riid, void** object) override {
+        if (!object) return E_POINTER;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_source) {
+            HRESULT hr = Microsoft::WRL::MakeAndInitialize<MediaSource>(&m_source);
+            if (FAILED(hr)) return hr;
+        }
+        return m_source->QueryInterface(riid, object);
+    }
+    STDMETHODIMP ShutdownObject() override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_source) m_source->Shutdown();
+        m_source.Reset();
+        return S_OK;
+    }
+    STDMETHODIMP DetachObject() override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_source.Reset();
+        return S_OK;
+    }
+
+    // IMFAttributes
+    STDMETHODIMP GetItem(REFGUID key, PROPVARIANT* value) override { return m_attributes->GetItem(key, value); }
+    STDMETHODIMP GetItemType(REFGUID key, MF_ATTRIBUTE_TYPE* type) override { return m_attributes->GetItemType(key, type); }
+    STDMETHODIMP CompareItem(REFGUID key, REFPROPVARIANT value, BOOL* result) override {
+        return m_attributes->CompareItem(key, value, result);
+    }
+    STDMETHODIMP Compare(IMFAttributes* other, MF_ATTRIBUTES_MATCH_TYPE type, BOOL* result) override {
+        return m_attributes->Compare(other, type, result);
+    }
+    STDMETHODIMP GetUINT32(REFGUID key, UINT32* value) override { return m_attributes->GetUINT32(key, value); }
+    STDMETHODIMP GetUINT64(REFGUID key, UINT64* value) override { return m_attributes->GetUINT64(key, value); }
+    STDMETHODIMP GetDouble(REFGUID key, double* value) override { return m_attributes->GetDouble(key, value); }
+    STDMETHODIMP GetGUID(REFGUID key, GUID* value) override { return m_attributes->GetGUID(key, value); }
+    STDMETHODIMP GetStringLength(REFGUID key, UINT32* length) override {
+        return m_attributes->GetStringLength(key, length);
+    }
+    STDMETHODIMP GetString(REFGUID key, LPWSTR value, UINT32 size, UINT32* length) override {
+        return m_attributes->GetString(key, value, size, length);
+    }
+    STDMETHODIMP GetAllocatedString(REFGUID key, LPWSTR* value, UINT32* length) override {
+        return m_attributes->GetAllocatedString(key, value, length);
+    }
+    STDMETHODIMP GetBlobSize(REFGUID key, UINT32* size) override { return m_attributes->GetBlobSize(key, size); }
+    STDMETHODIMP GetBlob(REFGUID key, UINT8* buffer, UINT32 size, UINT32* written) override {
+        return m_attributes->GetBlob(key, buffer, size, written);
+    }
+    STDMETHODIMP GetAllocatedBlob(REFGUID key, UINT8** buffer, UINT32* size) override {
+        return m_attributes->GetAllocatedBlob(key, buffer, size);
+    }
+    STDMETHODIMP GetUnknown(REFGUID key, REFIID riid, LPVOID* object) override {
+        return m_attributes->GetUnknown(key, riid, object);
+    }
+    STDMETHODIMP SetItem(REFGUID key, REFPROPVARIANT value) override { return m_attributes->SetItem(key, value); }
+    STDMETHODIMP DeleteItem(REFGUID key) override { return m_attributes->DeleteItem(key); }
+    STDMETHODIMP DeleteAllItems() override { return m_attributes->DeleteAllItems(); }
+    STDMETHODIMP SetUINT32(REFGUID key, UINT32 value) override { return m_attributes->SetUINT32(key, value); }
+    STDMETHODIMP SetUINT64(REFGUID key, UINT64 value) override { return m_attributes->SetUINT64(key, value); }
+    STDMETHODIMP SetDouble(REFGUID key, double value) override { return m_attributes->SetDouble(key, value); }
+    STDMETHODIMP SetGUID(REFGUID key, REFGUID value) override { return m_attributes->SetGUID(key, value); }
+    STDMETHODIMP SetString(REFGUID key, LPCWSTR value) override { return m_attributes->SetString(key, value); }
+    STDMETHODIMP SetBlob(REFGUID key, const UINT8* buffer, UINT32 size) override {
+        return m_attributes->SetBlob(key, buffer, size);
+    }
+    STDMETHODIMP SetUnknown(REFGUID key, IUnknown* object) override { return m_attributes->SetUnknown(key, object); }
+    STDMETHODIMP LockStore() override { return m_attributes->LockStore(); }
+    STDMETHODIMP UnlockStore() override { return m_attributes->UnlockStore(); }
+    STDMETHODIMP GetCount(UINT32* count) override { return m_attributes->GetCount(count); }
+    STDMETHODIMP GetItemByIndex(UINT32 index, GUID* key, PROPVARIANT* value) override {
+        return m_attributes->GetItemByIndex(index, key, value);
+    }
+    STDMETHODIMP CopyAllItems(IMFAttributes* dest) override { return m_attributes->CopyAllItems(dest); }
+
+private:
+    std::mutex            m_mutex;
+    ComPtr<IMFAttributes> m_attributes;
+    ComPtr<MediaSource>   m_source;
+};
+
+CoCreatableClass(VirtualCameraActivator);
+
+} // namespace SP
+
+// ---- DLL exports (ShaderPlayerVCam.def) ----
+
+namespace {
+
+std::wstring ClsidKey() {
+    return std::wstring(L"Software\\Classes\\CLSID\\") + SP::VIRTUAL_CAMERA_SOURCE_CLSID;
+}
+
+} // namespace
+
+BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID) {
+    if (reason == DLL_PROCESS_ATTACH) {
+        SP::g_module = instance;
+        DisableThreadLibraryCalls(instance);
+    }
+    return TRUE;
+}
+
+STDAPI DllGetClassObject(REFCLSID clsid, REFIID riid, LPVOID* object) {
+    return Module<InProc>::GetModule().GetClassObject(clsid, riid, object);
+}
+
+STDAPI DllCanUnloadNow() {
+    return Module<InProc>::GetModule().Terminate() ? S_OK : S_FALSE;
+}
+
+// HKLM: Frame Server runs as LocalService and does not see the user's classes
+STDAPI DllRegisterServer() {
+    wchar_t path[MAX_PATH];
+    const DWORD length = GetModuleFileNameW(SP::g_module, path, MAX_PATH);
+    if (length == 0 || length == MAX_PATH) return HRESULT_FROM_WIN32(GetLastError());
+
+    const std::wstring key = ClsidKey() + L"\\InprocServer32";
+    const wchar_t threading[] = L"Both";
+    LSTATUS status = RegSetKeyValueW(HKEY_LOCAL_MACHINE, key.c_str(), nullptr, REG_SZ, path,
+                                     (length + 1) * sizeof(wchar_t));
+    if (status == ERROR_SUCCESS)
+        status = RegSetKeyValueW(HKEY_LOCAL_MACHINE, key.c_str(), L"ThreadingModel", REG_SZ, threading,
+                                 sizeof(threading));
+    return HRESULT_FROM_WIN32(status);
+}
+
+STDAPI DllUnregisterServer() {
+    const LSTATUS status = RegDeleteTreeW(HKEY_LOCAL_MACHINE, ClsidKey().c_str());
+    return status == ERROR_SUCCESS || status == ERROR_FILE_NOT_FOUND ? S_OK : HRESULT_FROM_WIN32(status);
+}
@@ -58,6 +58,7 @@ WorkspaceManager::WorkspaceManager() {
     defaultPreset.name = "Default";
     defaultPreset.filepath = "";  // no file
     m_presets.push_back(std::move(defaultPreset));
+    m_layouts.emplace_back(kDefaultLayoutIni);
 }
 
 bool WorkspaceManager::Initialize(const std::string& layoutsDirectory) {
@@ -79,8 +80,11 @@ bool WorkspaceManager::Initialize(const std::string& layoutsDirectory) {
 
 void WorkspaceManager::ScanDirectory() {
     // Keep index 0 (Default); clear user presets (indices 1+)
-    if (m_presets.size() > 1)
+    if (m_presets.size() > 1) {
         m_presets.erase(m_presets.begin() + 1, m_presets.end());
+        m_layouts.erase(m_layouts.begin() + 1, m_layouts.end());
+    }
+    m_pendingLayout = -1;
 
     if (!std::filesystem::exists(m_layoutsDir)) return;
 
@@ -93,6 +97,7 @@ void WorkspaceManager::ScanDirectory() {
         if (ParsePresetFile(entry.path().string(), preset, imguiBlock)) {
             preset.filepath = entry.path().string();
             m_presets.push_back(std::move(preset));
+            m_layouts.push_back(std::move(imguiBlock));
         }
     }
 }
@@ -150,11 +155,13 @@ int WorkspaceManager::SavePreset(const std::string& name,
     for (int i = 1; i < static_cast<int>(m_presets.size()); ++i) {
         if (m_presets[i].filepath == preset.filepath) {
             m_presets[i] = preset;
+            m_layouts[i] = std::move(imguiBlob);
             return i;
         }
     }
 
     m_presets.push_back(preset);
+    m_layouts.push_back(std::move(imguiBlob));
     return static_cast<int>(m_presets.size()) - 1;
 }
 
@@ -174,24 +181,24 @@ bool WorkspaceManager::LoadPreset(int index,
     showRecording = preset.showRecording;
     showKeybindingsPanel = preset.showKeybindingsPanel;
 
-    if (index == 0) {
-        // Built-in Default
-        ImGui::LoadIniSettingsFromMemory(kDefaultLayoutIni);
-        return true;
-    }
-
-    WorkspacePreset dummy;
-    std::string imguiBlock;
-    if (!ParsePresetFile(preset.filepath, dummy, imguiBlock)) return false;
-
-    ImGui::LoadIniSettingsFromMemory(imguiBlock.c_str(), imguiBlock.size());
+    m_pendingLayout = index;
     return true;
 }
 
+void WorkspaceManager::ApplyPendingLayout() {
+    if (m_pendingLayout < 0) return;
+    const std::string& layout = m_layouts[m_pendingLayout];
+    ImGui::LoadIniSettingsFromMemory(layout.c_str(), layout.size());
+    m_pendingLayout = -1;
+}
+
 void WorkspaceManager::DeletePreset(int index) {
     if (index <= 0 || index >= static_cast<int>(m_presets.size())) return;
     std::filesystem::remove(m_presets[index].filepath);
     m_presets.erase(m_presets.begin() + index);
+    m_layouts.erase(m_layouts.begin() + index);
+    if (m_pendingLayout == index) m_pendingLayout = -1;
+    else if (m_pendingLayout > index) --m_pendingLayout;
 }
 
 bool WorkspaceManager::SetKeybinding(int index, int vkCode, int modifiers) {
@@ -200,11 +207,7 @@ bool WorkspaceManager::SetKeybinding(int index, int vkCode, int modifiers) {
     WorkspacePreset& preset = m_presets[index];
     preset.shortcutKey = vkCode;
     preset.shortcutModifiers = modifiers;
-
-    WorkspacePreset dummy;
-    std::string imguiBlock;
-    if (!ParsePresetFile(preset.filepath, dummy, imguiBlock)) return false;
-    return WritePresetFile(preset, imguiBlock);
+    return WritePresetFile(preset, m_layouts[index]);
 }
 
 bool WorkspaceManager::ParsePresetFile(const std::string& filepath,
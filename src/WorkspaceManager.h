@@ -17,6 +17,7 @@ public:
     bool Initialize(const std::string& layoutsDirectory);
 
     // Scan the layouts directory and populate m_presets (index 0 is always Default).
+    // Each file is read and parsed here once; its ImGui blob stays in memory.
     void ScanDirectory();
 
     // Capture current ImGui layout + visibility state and write to a new .ini file.
@@ -25,12 +26,16 @@ public:
                    bool showEditor, bool showLibrary, bool showTransport,
                    bool showRecording, bool showKeybindingsPanel);
 
-    // Load preset by index: apply ImGui layout and return visibility flags.
-    // Index 0 loads the hardcoded Default layout.
+    // Load preset by index: return visibility flags and queue its ImGui layout
+    // for ApplyPendingLayout. Index 0 is the hardcoded Default layout. No file I/O.
     bool LoadPreset(int index,
                     bool& showEditor, bool& showLibrary, bool& showTransport,
                     bool& showRecording, bool& showKeybindingsPanel);
 
+    // Apply the layout LoadPreset queued from its cached blob. Call between UI
+    // frames (before ImGui::NewFrame): docking only takes new settings there.
+    void ApplyPendingLayout();
+
     // Delete preset file and remove from vector. No-op for index 0 (Default).
     void DeletePreset(int index);
 
@@ -57,6 +62,8 @@ private:
 
     std::string m_layoutsDir;
     std::vector<WorkspacePreset> m_presets;  // index 0 is always Default
+    std::vector<std::string> m_layouts;      // ImGui ini blob per preset, parallel to m_presets
+    int m_pendingLayout = -1;                // Queued by LoadPreset; -1 = none
 };
 
 } // namespace SP
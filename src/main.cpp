@@ -1,5 +1,7 @@
 #include "Application.h"
 #include <objbase.h>
+#include <shellapi.h>
+#include <cstdio>
 
 // Global pointer used by the crash handler. Set just before Run() and cleared
 // immediately after — narrow window where a crash actually needs this.
@@ -26,6 +28,26 @@ static LONG WINAPI OnUnhandledException(EXCEPTION_POINTERS*) {
     return EXCEPTION_CONTINUE_SEARCH;
 }
 
+// Value of `--name <value>` on the command line, empty when absent
+static std::string CommandLineOption(const wchar_t* name) {
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv) return {};
+    std::string value;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (wcscmp(argv[i], name) == 0) {
+            const int size = WideCharToMultiByte(CP_UTF8, 0, argv[i + 1], -1, nullptr, 0, nullptr, nullptr);
+            if (size > 1) {
+                value.resize(static_cast<size_t>(size - 1));
+                WideCharToMultiByte(CP_UTF8, 0, argv[i + 1], -1, value.data(), size, nullptr, nullptr);
+            }
+            break;
+        }
+    }
+    LocalFree(argv);
+    return value;
+}
+
 int WINAPI WinMain(
     _In_ HINSTANCE hInstance,
     _In_opt_ HINSTANCE hPrevInstance,
@@ -41,17 +63,31 @@ int WINAPI WinMain(
     // COM is required for IFileOpenDialog (folder/file pickers)
     CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
 
+    // --playback-bench <file>: unattended run, exit code 0 = every clip passed
+    const std::string playbackBench = CommandLineOption(L"--playback-bench");
+    // --replay <session.json>: recorded session on a fixed clock, then a timing report
+    const std::string replay = CommandLineOption(L"--replay");
+
     SP::Application app;
 
     int result = 1;
     if (app.Initialize(hInstance, nCmdShow)) {
-        g_appForCrashCleanup = &app;
-        SetUnhandledExceptionFilter(OnUnhandledException);
+        std::string error;
+        if (!playbackBench.empty() && !app.StartPlaybackBenchmark(playbackBench, error)) {
+            std::fprintf(stderr, "Playback benchmark: %s\n", error.c_str());
+            result = 2;
+        } else if (!replay.empty() && !app.StartSessionReplay(replay, error)) {
+            std::fprintf(stderr, "Session replay: %s\n", error.c_str());
+            result = 2;
+        } else {
+            g_appForCrashCleanup = &app;
+            SetUnhandledExceptionFilter(OnUnhandledException);
 
-        result = app.Run();
+            result = app.Run();
 
-        SetUnhandledExceptionFilter(nullptr);
-        g_appForCrashCleanup = nullptr;
+            SetUnhandledExceptionFilter(nullptr);
+            g_appForCrashCleanup = nullptr;
+        }
     }
 
     CoUninitialize();
@@ -0,0 +1,114 @@
+#include "ShaderBench.h"
+#include "D3D11Renderer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ShaderPlayerBench: headless GPU timing of a shader directory at several
+// resolutions, for diffing across driver versions and catching regressions in
+// the shader pack. See ShaderBench.h.
+//
+//   ShaderPlayerBench [shaderDir] [--input video] [--frames N] [--warmup N]
+//                     [--res 1080p,1440p,4K,WxH] [--json out.json] [--csv out.csv]
+//                     [--history runs.jsonl] [--label text] [--adapter name] [--list-adapters]
+
+namespace {
+
+int Usage() {
+    std::fprintf(stderr,
+                 "Usage: ShaderPlayerBench [shaderDir] [--input video] [--frames N] [--warmup N]\n"
+                 "                         [--res 1080p,1440p,4K,WxH] [--json out.json] [--csv out.csv]\n"
+                 "                         [--history runs.jsonl] [--label text] [--adapter name] [--list-adapters]\n");
+    return 2;
+}
+
+// "1080p", "1440p", "4K" or "WxH"
+bool ParseResolution(const std::string& text, SP::BenchResolution& out) {
+    if (text == "1080p") { out = {"1080p", 1920, 1080}; return true; }
+    if (text == "1440p") { out = {"1440p", 2560, 1440}; return true; }
+    if (text == "4K" || text == "4k" || text == "2160p") { out = {"4K", 3840, 2160}; return true; }
+    int w = 0, h = 0;
+    if (std::sscanf(text.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) return false;
+    out = {text, w, h};
+    return true;
+}
+
+bool ParseResolutions(const char* list, std::vector<SP::BenchResolution>& out) {
+    out.clear();
+    std::string text(list);
+    for (size_t start = 0; start <= text.size();) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) end = text.size();
+        SP::BenchResolution resolution;
+        if (!ParseResolution(text.substr(start, end - start), resolution)) return false;
+        out.push_back(resolution);
+        start = end + 1;
+    }
+    return !out.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SP::BenchOptions options;
+    bool directorySet = false;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--input") == 0 && hasValue) {
+            options.input = argv[++i];
+        } else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            options.frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) {
+            options.warmupFrames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--res") == 0 && hasValue) {
+            if (!ParseResolutions(argv[++i], options.resolutions)) return Usage();
+        } else if (std::strcmp(argv[i], "--json") == 0 && hasValue) {
+            options.jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--csv") == 0 && hasValue) {
+            options.csvPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--history") == 0 && hasValue) {
+            options.historyPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--label") == 0 && hasValue) {
+            options.label = argv[++i];
+        } else if (std::strcmp(argv[i], "--adapter") == 0 && hasValue) {
+            options.adapter = argv[++i];
+        } else if (std::strcmp(argv[i], "--list-adapters") == 0) {
+            for (const SP::AdapterInfo& adapter : SP::D3D11Renderer::ListAdapters())
+                std::printf("%s (%llu MB)\n", adapter.name.c_str(),
+                            static_cast<unsigned long long>(adapter.dedicatedBytes >> 20));
+            return 0;
+        } else if (!directorySet && argv[i][0] != '-') {
+            options.shaderDirectory = argv[i];
+            directorySet = true;
+        } else {
+            return Usage();
+        }
+    }
+    if (options.frames <= 0 || options.warmupFrames < 0) return Usage();
+
+    SP::ShaderBench bench(options);
+    std::string error;
+    if (!bench.Run(error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    if (!options.jsonPath.empty() && !bench.WriteJson(options.jsonPath)) {
+        std::fprintf(stderr, "Failed to write %s\n", options.jsonPath.c_str());
+        return 2;
+    }
+    if (!options.csvPath.empty() && !bench.WriteCsv(options.csvPath)) {
+        std::fprintf(stderr, "Failed to write %s\n", options.csvPath.c_str());
+        return 2;
+    }
+    if (!options.historyPath.empty() && !bench.AppendHistory(options.historyPath, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    int failed = 0;
+    for (const SP::BenchResult& result : bench.GetResults()) {
+        if (!result.ok) ++failed;
+    }
+    std::printf("%zu result(s), %d failed to compile\n", bench.GetResults().size(), failed);
+    return (failed > 0) ? 1 : 0;
+}
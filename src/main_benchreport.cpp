@@ -0,0 +1,128 @@
+#include "BenchHistory.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+// ShaderPlayerBenchReport: compares a run of a benchmark history (ShaderPlayerBench
+// --history, or "history" in a --playback-bench file) with a baseline run and
+// flags regressions. See BenchHistory.h.
+//
+//   ShaderPlayerBenchReport runs.jsonl [--run sel] [--baseline sel] [--threshold 5]
+//                           [--markdown out.md] [--list]
+//
+// A selector is an index (negative counts from the newest, -1) or a run's label.
+// The default run is the newest, the default baseline the run of the same kind
+// before it on the same machine. Exit code 1 when anything regressed.
+
+namespace {
+
+constexpr double DEFAULT_THRESHOLD_PERCENT = 5.0;
+
+int Usage() {
+    std::fprintf(stderr,
+                 "Usage: ShaderPlayerBenchReport runs.jsonl [--run sel] [--baseline sel] [--threshold 5]\n"
+                 "                               [--markdown out.md] [--list]\n");
+    return 2;
+}
+
+std::string Describe(const SP::BenchHistory::Run& run) {
+    std::string text = run.kind + " run of " + run.time;
+    if (!run.label.empty()) text += " \"" + run.label + "\"";
+    text += ", build " + run.build.value("commit", std::string("?")) + " (" + run.build.value("config", std::string("?")) +
+            "), " + run.machine.value("computer", std::string("?")) + ", " + run.machine.value("gpu", std::string("?")) +
+            " driver " + run.machine.value("driver", std::string("?"));
+    return text;
+}
+
+const char* Verdict(const SP::BenchHistory::Delta& delta) {
+    return delta.regression ? "REGRESSION" : delta.improvement ? "improved" : "";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string historyPath, runSelector = "-1", baselineSelector, markdownPath;
+    double threshold = DEFAULT_THRESHOLD_PERCENT;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--run") == 0 && hasValue) {
+            runSelector = argv[++i];
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue) {
+            baselineSelector = argv[++i];
+        } else if (std::strcmp(argv[i], "--threshold") == 0 && hasValue) {
+            threshold = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--markdown") == 0 && hasValue) {
+            markdownPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else if (historyPath.empty() && argv[i][0] != '-') {
+            historyPath = argv[i];
+        } else {
+            return Usage();
+        }
+    }
+    if (historyPath.empty() || threshold < 0.0) return Usage();
+
+    SP::BenchHistory history;
+    std::string error;
+    if (!history.Load(historyPath, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    const auto& runs = history.GetRuns();
+    if (list) {
+        for (size_t i = 0; i < runs.size(); ++i) std::printf("%3zu  %s\n", i, Describe(runs[i]).c_str());
+        return 0;
+    }
+
+    const int run = history.Find(runSelector);
+    if (run < 0) {
+        std::fprintf(stderr, "No run \"%s\" in %s\n", runSelector.c_str(), historyPath.c_str());
+        return 2;
+    }
+    const int baseline = baselineSelector.empty() ? history.FindBaseline(run) : history.Find(baselineSelector);
+    if (baseline < 0 || baseline == run) {
+        std::fprintf(stderr, "No baseline for run %d; pick one with --baseline\n", run);
+        return 2;
+    }
+    if (runs[baseline].kind != runs[run].kind) {
+        std::fprintf(stderr, "Run %d is a %s run and baseline %d a %s run\n", run, runs[run].kind.c_str(), baseline,
+                     runs[baseline].kind.c_str());
+        return 2;
+    }
+
+    const std::vector<SP::BenchHistory::Delta> deltas = SP::BenchHistory::Compare(runs[baseline], runs[run], threshold);
+    int regressions = 0, improvements = 0;
+    std::printf("Run      %d: %s\nBaseline %d: %s\n\n", run, Describe(runs[run]).c_str(), baseline,
+                Describe(runs[baseline]).c_str());
+    for (const SP::BenchHistory::Delta& delta : deltas) {
+        std::printf("%-56s %10.3f %10.3f %+8.1f%%  %s\n", delta.key.c_str(), delta.baseline, delta.current,
+                    delta.percent, Verdict(delta));
+        if (delta.regression) ++regressions;
+        if (delta.improvement) ++improvements;
+    }
+    std::printf("\n%zu compared, %d regressed and %d improved by more than %.1f%% (positive = worse)\n", deltas.size(),
+                regressions, improvements, threshold);
+
+    if (!markdownPath.empty()) {
+        std::ofstream file(markdownPath, std::ios::trunc);
+        file << "# Benchmark comparison\n\n"
+             << "- Run " << run << ": " << Describe(runs[run]) << "\n"
+             << "- Baseline " << baseline << ": " << Describe(runs[baseline]) << "\n"
+             << "- Threshold: " << threshold << "% (positive = worse)\n\n"
+             << "| Metric | Baseline | Run | Change | |\n|---|---:|---:|---:|---|\n";
+        for (const SP::BenchHistory::Delta& delta : deltas) {
+            char row[160];
+            std::snprintf(row, sizeof(row), " | %.3f | %.3f | %+.1f%% | %s |\n", delta.baseline, delta.current,
+                          delta.percent, delta.regression ? "**regression**" : Verdict(delta));
+            file << "| " << delta.key << row;
+        }
+        if (!file) {
+            std::fprintf(stderr, "Failed to write %s\n", markdownPath.c_str());
+            return 2;
+        }
+    }
+    return regressions > 0 ? 1 : 0;
+}
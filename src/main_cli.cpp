@@ -0,0 +1,72 @@
+#include "BatchRenderer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ShaderPlayerCLI: headless batch rendering for render nodes without an
+// interactive session. See BatchRenderer.h for the job file.
+//
+//   ShaderPlayerCLI <jobs.json> [--jobs N] [--chunk K | --join] [--shared-cache dir]
+//   ShaderPlayerCLI --precompile <shaderDir>
+//
+// --chunk K renders only segment K of each chunked job (a render node's share);
+// --join joins the segments once every node is done. --shared-cache names a
+// directory of compiled shaders shared by the nodes. --precompile is the build
+// step that fills shader_cache/ next to the exe with the default shaders.
+
+namespace {
+
+// Jobs at once when neither --jobs nor the file says; consumer GPUs cap the
+// number of concurrent hardware encoder sessions
+constexpr int DEFAULT_CONCURRENCY = 2;
+
+int Usage() {
+    std::fprintf(stderr, "Usage: ShaderPlayerCLI <jobs.json> [--jobs N] [--chunk K | --join] [--shared-cache dir]\n"
+                         "       ShaderPlayerCLI --precompile <shaderDir>\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 3 && std::strcmp(argv[1], "--precompile") == 0) {
+        return (SP::BatchRenderer::Precompile(argv[2]) > 0) ? 1 : 0;
+    }
+
+    const char* jobFile = nullptr;
+    int concurrency = 0;
+    int chunk = 0;
+    bool joinOnly = false;
+    const char* sharedCache = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if ((std::strcmp(argv[i], "--jobs") == 0 || std::strcmp(argv[i], "-j") == 0) && i + 1 < argc) {
+            concurrency = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+            chunk = std::atoi(argv[++i]);
+            if (chunk <= 0) return Usage();
+        } else if (std::strcmp(argv[i], "--join") == 0) {
+            joinOnly = true;
+        } else if (std::strcmp(argv[i], "--shared-cache") == 0 && i + 1 < argc) {
+            sharedCache = argv[++i];
+        } else if (!jobFile && argv[i][0] != '-') {
+            jobFile = argv[i];
+        } else {
+            return Usage();
+        }
+    }
+    if (!jobFile || (chunk > 0 && joinOnly)) return Usage();
+
+    SP::BatchRenderer batch;
+    if (sharedCache) batch.SetSharedShaderCache(sharedCache);
+    std::string error;
+    if (!batch.LoadJobs(jobFile, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    if (concurrency <= 0) concurrency = batch.GetConcurrency();
+    if (concurrency <= 0) concurrency = DEFAULT_CONCURRENCY;
+
+    const int failed = batch.Run(concurrency, chunk, joinOnly);
+    std::printf("%zu job(s), %d failed\n", batch.GetJobCount(), failed);
+    return (failed > 0) ? 1 : 0;
+}
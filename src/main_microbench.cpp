@@ -0,0 +1,307 @@
+#include "AudioAnalyzer.h"
+#include "D3D11Renderer.h"
+#include "PixelCopy.h"
+#include "ShaderManager.h"
+#include "VideoDecoder.h"
+#include "VideoEncoder.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+// ShaderPlayerMicroBench: CPU cost of the hot-path pieces in isolation (Google
+// Benchmark; build with -DSHADERPLAYER_MICROBENCH=ON). Takes the usual
+// --benchmark_filter / --benchmark_format=json / --benchmark_out flags.
+
+namespace SP {
+
+// Friend of the classes whose hot paths are private: sets up just the state
+// those paths read, without opening a file or starting a recording
+struct MicroBenchAccess {
+    // ConvertFrame reads the stream's time base, the output size and format
+    static void PrepareDecoder(VideoDecoder& decoder, AVFormatContext* format, int width, int height, bool gpuYuv) {
+        decoder.m_formatCtx      = format;
+        decoder.m_videoStreamIdx = 0;
+        decoder.m_width          = width;
+        decoder.m_height         = height;
+        decoder.m_outputFormat   = AV_PIX_FMT_RGBA;
+        decoder.m_gpuYuv         = gpuYuv;
+    }
+    static void ReleaseDecoder(VideoDecoder& decoder) {
+        decoder.m_formatCtx      = nullptr;  // The caller's; Close must not free it
+        decoder.m_videoStreamIdx = -1;
+    }
+    static bool ConvertFrame(VideoDecoder& decoder, AVFrame* frame, VideoFrame& out) {
+        return decoder.ConvertFrame(frame, out);
+    }
+
+    // The encoder thread's conversion: ConvertRgbaFrame, else EnsureScaler then
+    // sws_scale_frame, into a codec frame. `swscaleOnly` times swscale alone.
+    static bool PrepareEncoder(VideoEncoder& encoder, int width, int height, AVPixelFormat codecFormat) {
+        encoder.m_width    = width;
+        encoder.m_height   = height;
+        encoder.m_codecCtx = avcodec_alloc_context3(nullptr);
+        if (!encoder.m_codecCtx) return false;
+        encoder.m_codecCtx->pix_fmt = codecFormat;
+        return encoder.AcquireCodecFrame() != nullptr;
+    }
+    static bool ConvertForEncoder(VideoEncoder& encoder, const AVFrame* source, bool swscaleOnly) {
+        AVFrame* frame = encoder.AcquireCodecFrame();
+        return frame && ((!swscaleOnly && encoder.ConvertRgbaFrame(source, frame)) ||
+                         (encoder.EnsureScaler(source->width, source->height, static_cast<AVPixelFormat>(source->format)) &&
+                          sws_scale_frame(encoder.m_swsCtx, frame, source) >= 0));
+    }
+    static void ReleaseEncoder(VideoEncoder& encoder) {
+        sws_freeContext(encoder.m_swsCtx);
+        encoder.m_swsCtx = nullptr;
+        encoder.ReleaseCodecFrames();
+        avcodec_free_context(&encoder.m_codecCtx);
+    }
+
+    static void RunFFT(AudioAnalyzer& analyzer) { analyzer.RunFFT(); }
+
+    static std::vector<ShaderParam> ParseISFParams(const std::string& source, std::vector<RenderPassDesc>& passes,
+                                                   FrameHistoryDesc& history, ComputeDesc& compute) {
+        return ShaderManager::ParseISFParams(source, nullptr, nullptr, &passes, &history, &compute);
+    }
+    static std::string BuildDefinesPreamble(const std::vector<ShaderParam>& params,
+                                            const std::vector<RenderPassDesc>& passes,
+                                            const FrameHistoryDesc& history, const ComputeDesc& compute) {
+        return ShaderManager::BuildDefinesPreamble(params, passes, history, compute);
+    }
+};
+
+} // namespace SP
+
+namespace {
+
+using SP::MicroBenchAccess;
+
+// Source formats ConvertFrame sees from common files: H.264/HEVC 8-bit, HEVC
+// 10-bit, hardware-downloaded NV12, ProRes 422
+constexpr AVPixelFormat DECODE_FORMATS[] = {
+    AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P10LE, AV_PIX_FMT_NV12, AV_PIX_FMT_YUV422P10LE,
+};
+
+// 16:9 at the given height
+int WidthFor(int height) { return (height * 16 / 9 + 1) & ~1; }
+
+AVFrame* MakeFrame(AVPixelFormat format, int width, int height) {
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) return nullptr;
+    frame->format = format;
+    frame->width  = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    if (format == AV_PIX_FMT_RGBA) {
+        for (int y = 0; y < height; ++y) std::memset(frame->data[0] + y * frame->linesize[0], 0x80, width * 4);
+    } else {
+        ptrdiff_t linesizes[4];
+        for (int i = 0; i < 4; ++i) linesizes[i] = frame->linesize[i];
+        av_image_fill_black(frame->data, linesizes, format, AVCOL_RANGE_MPEG, width, height);
+    }
+    frame->pts = 0;
+    return frame;
+}
+
+// Args: DECODE_FORMATS index, height, GPU YUV (native planes wrapped instead of sws_scale'd to RGBA)
+void BM_ConvertFrame(benchmark::State& state) {
+    const AVPixelFormat format = DECODE_FORMATS[state.range(0)];
+    const int height = static_cast<int>(state.range(1));
+    const int width  = WidthFor(height);
+    const bool gpuYuv = state.range(2) != 0;
+
+    AVFormatContext* container = avformat_alloc_context();
+    AVStream* stream = container ? avformat_new_stream(container, nullptr) : nullptr;
+    AVFrame* frame = MakeFrame(format, width, height);
+    if (!stream || !frame) {
+        state.SkipWithError("FFmpeg allocation failed");
+    } else {
+        stream->time_base = {1, 60};
+        SP::VideoDecoder decoder;
+        MicroBenchAccess::PrepareDecoder(decoder, container, width, height, gpuYuv);
+        SP::VideoFrame out;
+        for (auto _ : state) {
+            if (!MicroBenchAccess::ConvertFrame(decoder, frame, out)) {
+                state.SkipWithError("ConvertFrame failed");
+                break;
+            }
+            ++frame->pts;
+        }
+        out = SP::VideoFrame{};  // Back to the pool before the decoder goes
+        MicroBenchAccess::ReleaseDecoder(decoder);
+    }
+    state.SetLabel(std::string(av_get_pix_fmt_name(format)) + (gpuYuv ? " gpu-yuv" : " sws-rgba"));
+    state.SetItemsProcessed(state.iterations());
+    av_frame_free(&frame);
+    avformat_free_context(container);
+}
+BENCHMARK(BM_ConvertFrame)
+    ->ArgsProduct({{0, 1, 2, 3}, {720, 1080, 2160}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Arg: interleaved stereo frames per call (a decoder audio packet is ~1024)
+void BM_AudioFeedSamples(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    std::vector<float> samples(static_cast<size_t>(count) * 2);
+    for (size_t i = 0; i < samples.size(); ++i) samples[i] = std::sin(static_cast<float>(i) * 0.05f);
+    SP::AudioAnalyzer analyzer;
+    for (auto _ : state) {
+        analyzer.FeedSamples(samples.data(), count, 2, 48000);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_AudioFeedSamples)->Arg(256)->Arg(1024)->Arg(4096);
+
+void BM_AudioRunFFT(benchmark::State& state) {
+    std::vector<float> samples(4096);
+    for (size_t i = 0; i < samples.size(); ++i) samples[i] = std::sin(static_cast<float>(i) * 0.05f);
+    SP::AudioAnalyzer analyzer;
+    analyzer.FeedSamples(samples.data(), static_cast<int>(samples.size()), 1, 48000);  // Ring full, plan made
+    for (auto _ : state) {
+        MicroBenchAccess::RunFFT(analyzer);
+    }
+}
+BENCHMARK(BM_AudioRunFFT);
+
+// Arg: keyframes, spread over 10 minutes; every interpolation mode
+void BM_KeyframeEvaluate(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    SP::KeyframeTimeline timeline;
+    timeline.enabled = true;
+    for (int i = 0; i < count; ++i) {
+        SP::Keyframe keyframe;
+        keyframe.time = 600.0f * i / count;
+        keyframe.values[0] = static_cast<float>(i % 7);
+        keyframe.mode = static_cast<SP::InterpolationMode>(i % 3);
+        timeline.keyframes.push_back(keyframe);
+    }
+    float out[4] = {};
+    float time = 0.0f;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(timeline.Evaluate(time, out, 4));
+        time += 1.0f / 60.0f;
+        if (time > 600.0f) time = 0.0f;
+    }
+}
+BENCHMARK(BM_KeyframeEvaluate)->RangeMultiplier(8)->Range(8, 32768);
+
+// Arg: noise texture size. Generation plus upload on a headless device.
+void BM_UpdateNoiseTexture(benchmark::State& state) {
+    SP::D3D11Renderer renderer;
+    if (!renderer.Initialize(nullptr, 64, 64)) {
+        state.SkipWithError("Failed to create a D3D11 device");
+        return;
+    }
+    const int size = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        renderer.UpdateNoiseTexture(1.0f, size);
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_UpdateNoiseTexture)->Arg(256)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+// The largest preset in default_shaders/ (run from the repo or install root), else
+// the new-shader template, which has no ISF block
+const std::string& IsfSource() {
+    static const std::string source = [] {
+        std::string largest = SP::ShaderManager::GetShaderTemplate();
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator("default_shaders", ec)) {
+            if (entry.path().extension() != ".hlsl") continue;
+            std::ifstream file(entry.path());
+            std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            if (text.size() > largest.size()) largest.swap(text);
+        }
+        return largest;
+    }();
+    return source;
+}
+
+void BM_ParseISFParams(benchmark::State& state) {
+    const std::string& source = IsfSource();
+    std::vector<SP::RenderPassDesc> passes;
+    SP::FrameHistoryDesc history;
+    SP::ComputeDesc compute;
+    for (auto _ : state) {
+        passes.clear();
+        benchmark::DoNotOptimize(MicroBenchAccess::ParseISFParams(source, passes, history, compute));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(source.size()));
+}
+BENCHMARK(BM_ParseISFParams);
+
+void BM_BuildDefinesPreamble(benchmark::State& state) {
+    std::vector<SP::RenderPassDesc> passes;
+    SP::FrameHistoryDesc history;
+    SP::ComputeDesc compute;
+    const auto params = MicroBenchAccess::ParseISFParams(IsfSource(), passes, history, compute);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MicroBenchAccess::BuildDefinesPreamble(params, passes, history, compute));
+    }
+}
+BENCHMARK(BM_BuildDefinesPreamble);
+
+// Args: codec format (0 = YUV420P for H.264/HEVC, 1 = YUV422P10 for ProRes), height,
+// swscale only (1 = skip PixelCopy's conversion). RGBA readback in, as the CPU
+// fallback path converts it.
+void BM_EncoderConvert(benchmark::State& state) {
+    const AVPixelFormat codecFormat = state.range(0) == 0 ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_YUV422P10LE;
+    const int height = static_cast<int>(state.range(1));
+    const bool swscaleOnly = state.range(2) != 0;
+    const int width  = WidthFor(height);
+    AVFrame* source = MakeFrame(AV_PIX_FMT_RGBA, width, height);
+    SP::VideoEncoder encoder;
+    if (!source || !MicroBenchAccess::PrepareEncoder(encoder, width, height, codecFormat)) {
+        state.SkipWithError("FFmpeg allocation failed");
+    } else {
+        for (auto _ : state) {
+            if (!MicroBenchAccess::ConvertForEncoder(encoder, source, swscaleOnly)) {
+                state.SkipWithError("Conversion failed");
+                break;
+            }
+        }
+    }
+    MicroBenchAccess::ReleaseEncoder(encoder);
+    av_frame_free(&source);
+    state.SetLabel(std::string(av_get_pix_fmt_name(codecFormat)) + (swscaleOnly ? " swscale" : " pixelcopy"));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EncoderConvert)->ArgsProduct({{0, 1}, {1080, 2160}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// Args: operation (0 = CopyRows with mismatched pitches, 1 = RGBA/BGRA swizzle), height.
+// 1080p RGBA fits a large L3 and copies through it; 2160p is past it and streams.
+void BM_PixelCopy(benchmark::State& state) {
+    const bool swizzle = state.range(0) != 0;
+    const int height = static_cast<int>(state.range(1));
+    const int width  = WidthFor(height);
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    const size_t pitch    = (rowBytes + 255) & ~size_t(255);  // A mapped texture's row pitch
+    std::vector<uint8_t> src(pitch * height, 0x5A);
+    std::vector<uint8_t> dst(rowBytes * height);
+    for (auto _ : state) {
+        if (swizzle) {
+            SwizzleRgbaBgra(dst.data(), rowBytes, src.data(), pitch, width, height);
+        } else {
+            CopyRows(dst.data(), rowBytes, src.data(), pitch, rowBytes, height);
+        }
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetLabel(std::string(swizzle ? "swizzle " : "copy ") + GetPixelCopyPath());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(rowBytes) * height);
+}
+BENCHMARK(BM_PixelCopy)->ArgsProduct({{0, 1}, {1080, 2160}})->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();